@@ -15,8 +15,15 @@
 #include "base/ast_internal/ast_impl.h"
 
 #include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/functional/overload.h"
+#include "absl/types/variant.h"
 
 namespace cel::ast_internal {
 namespace {
@@ -26,14 +33,130 @@ const Type& DynSingleton() {
   return *singleton;
 }
 
+Expr CopyExpr(const Expr& expr);
+
+ListExprElement CopyListElement(const ListExprElement& element) {
+  ListExprElement copy;
+  copy.set_expr(CopyExpr(element.expr()));
+  copy.set_optional(element.optional());
+  return copy;
+}
+
+StructExprField CopyStructField(const StructExprField& field) {
+  StructExprField copy;
+  copy.set_id(field.id());
+  copy.set_name(field.name());
+  copy.set_value(CopyExpr(field.value()));
+  copy.set_optional(field.optional());
+  return copy;
+}
+
+MapExprEntry CopyMapEntry(const MapExprEntry& entry) {
+  MapExprEntry copy;
+  copy.set_id(entry.id());
+  copy.set_key(CopyExpr(entry.key()));
+  copy.set_value(CopyExpr(entry.value()));
+  copy.set_optional(entry.optional());
+  return copy;
+}
+
+// Copies `expr` recursively, like MacroExprFactory::Copy but keeping the ids.
+Expr CopyExpr(const Expr& expr) {
+  Expr copy;
+  copy.set_id(expr.id());
+  absl::visit(
+      absl::Overload(
+          [](const UnspecifiedExpr&) {},
+          [&copy](const Constant& const_expr) {
+            copy.set_const_expr(const_expr);
+          },
+          [&copy](const IdentExpr& ident_expr) {
+            copy.mutable_ident_expr().set_name(ident_expr.name());
+          },
+          [&copy](const SelectExpr& select_expr) {
+            auto& select = copy.mutable_select_expr();
+            select.set_operand(CopyExpr(select_expr.operand()));
+            select.set_field(select_expr.field());
+            select.set_test_only(select_expr.test_only());
+          },
+          [&copy](const CallExpr& call_expr) {
+            auto& call = copy.mutable_call_expr();
+            call.set_function(call_expr.function());
+            if (call_expr.has_target()) {
+              call.set_target(CopyExpr(call_expr.target()));
+            }
+            for (const auto& arg : call_expr.args()) {
+              call.mutable_args().push_back(CopyExpr(arg));
+            }
+          },
+          [&copy](const ListExpr& list_expr) {
+            auto& list = copy.mutable_list_expr();
+            for (const auto& element : list_expr.elements()) {
+              list.mutable_elements().push_back(CopyListElement(element));
+            }
+          },
+          [&copy](const StructExpr& struct_expr) {
+            auto& struct_copy = copy.mutable_struct_expr();
+            struct_copy.set_name(struct_expr.name());
+            for (const auto& field : struct_expr.fields()) {
+              struct_copy.mutable_fields().push_back(CopyStructField(field));
+            }
+          },
+          [&copy](const MapExpr& map_expr) {
+            auto& map = copy.mutable_map_expr();
+            for (const auto& entry : map_expr.entries()) {
+              map.mutable_entries().push_back(CopyMapEntry(entry));
+            }
+          },
+          [&copy](const ComprehensionExpr& comprehension_expr) {
+            auto& comprehension = copy.mutable_comprehension_expr();
+            comprehension.set_iter_var(comprehension_expr.iter_var());
+            comprehension.set_iter_range(
+                CopyExpr(comprehension_expr.iter_range()));
+            comprehension.set_accu_var(comprehension_expr.accu_var());
+            comprehension.set_accu_init(
+                CopyExpr(comprehension_expr.accu_init()));
+            comprehension.set_loop_condition(
+                CopyExpr(comprehension_expr.loop_condition()));
+            comprehension.set_loop_step(
+                CopyExpr(comprehension_expr.loop_step()));
+            comprehension.set_result(CopyExpr(comprehension_expr.result()));
+          }),
+      expr.kind());
+  return copy;
+}
+
 }  // namespace
 
 const Type& AstImpl::GetType(int64_t expr_id) const {
-  auto iter = type_map_.find(expr_id);
-  if (iter == type_map_.end()) {
+  const Type* type = FindType(expr_id);
+  if (type == nullptr) {
     return DynSingleton();
   }
-  return iter->second;
+  return *type;
+}
+
+const Type* AstImpl::FindType(int64_t expr_id) const {
+  if (lazy_types_ == nullptr) {
+    auto iter = type_map_.find(expr_id);
+    return iter == type_map_.end() ? nullptr : &iter->second;
+  }
+  absl::MutexLock lock(&lazy_types_->mutex);
+  auto [iter, inserted] = lazy_types_->converted.try_emplace(expr_id);
+  if (inserted) {
+    iter->second = lazy_types_->source->FindType(expr_id);
+  }
+  return iter->second.has_value() ? &*iter->second : nullptr;
+}
+
+const absl::flat_hash_map<int64_t, Type>& AstImpl::type_map() const {
+  if (lazy_types_ == nullptr) {
+    return type_map_;
+  }
+  absl::call_once(lazy_types_->all_once, [this]() {
+    lazy_types_->all = lazy_types_->source->ConvertAll();
+  });
+  return lazy_types_->all;
 }
 
 const Type& AstImpl::GetReturnType() const { return GetType(root_expr().id()); }
@@ -46,4 +169,24 @@ const Reference* AstImpl::GetReference(int64_t expr_id) const {
   return &iter->second;
 }
 
+std::unique_ptr<AstImpl> AstImpl::DeepCopy() const {
+  absl::flat_hash_map<int64_t, Expr> macro_calls;
+  macro_calls.reserve(source_info_.macro_calls().size());
+  for (const auto& [id, call] : source_info_.macro_calls()) {
+    macro_calls.insert({id, CopyExpr(call)});
+  }
+  SourceInfo source_info(source_info_.syntax_version(),
+                         source_info_.location(), source_info_.line_offsets(),
+                         source_info_.positions(), std::move(macro_calls),
+                         source_info_.extensions());
+  source_info.set_compact_positions(source_info_.compact_positions());
+  auto copy =
+      std::make_unique<AstImpl>(CopyExpr(root_expr_), std::move(source_info));
+  copy->reference_map_ = reference_map_;
+  copy->type_map_ = type_map();
+  copy->expr_version_ = expr_version_;
+  copy->is_checked_ = is_checked_;
+  return copy;
+}
+
 }  // namespace cel::ast_internal
@@ -16,17 +16,37 @@
 #define THIRD_PARTY_CEL_CPP_BASE_AST_INTERNAL_AST_IMPL_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "base/ast.h"
 #include "base/ast_internal/expr.h"
 #include "internal/casts.h"
 
 namespace cel::ast_internal {
 
+// Source of the types of a checked expression which converts them on demand,
+// for ASTs created from a representation where converting every type up front
+// costs more than the planner's lookups of a few of them.
+class LazyTypeMap {
+ public:
+  virtual ~LazyTypeMap() = default;
+
+  // Returns the type of `expr_id`, or `absl::nullopt` if it has none.
+  virtual absl::optional<Type> FindType(int64_t expr_id) const = 0;
+
+  // Returns every type.
+  virtual absl::flat_hash_map<int64_t, Type> ConvertAll() const = 0;
+};
+
 // Runtime implementation of a CEL abstract syntax tree.
 // CEL users should not use this directly.
 // If AST inspection is needed, prefer to use an existing tool or traverse the
@@ -75,6 +95,14 @@ class AstImpl : public Ast {
         expr_version_(std::move(expr.mutable_expr_version())),
         is_checked_(true) {}
 
+  // Creates a checked AST whose types are converted from `lazy_types` when
+  // first looked up, instead of being taken from the `type_map()` of `expr`.
+  AstImpl(CheckedExpr expr, std::unique_ptr<LazyTypeMap> lazy_types)
+      : AstImpl(std::move(expr)) {
+    lazy_types_ = std::make_unique<LazyTypes>();
+    lazy_types_->source = std::move(lazy_types);
+  }
+
   // Implement public Ast APIs.
   bool IsChecked() const override { return is_checked_; }
 
@@ -86,6 +114,8 @@ class AstImpl : public Ast {
   SourceInfo& source_info() { return source_info_; }
 
   const Type& GetType(int64_t expr_id) const;
+  // Returns the checked type of `expr_id`, or nullptr if it has none.
+  const Type* FindType(int64_t expr_id) const;
   const Type& GetReturnType() const;
   const Reference* GetReference(int64_t expr_id) const;
 
@@ -97,19 +127,36 @@ class AstImpl : public Ast {
     return reference_map_;
   }
 
-  const absl::flat_hash_map<int64_t, Type>& type_map() const {
-    return type_map_;
-  }
+  // Converts every lazily converted type, prefer `FindType()` to look up a
+  // few of them.
+  const absl::flat_hash_map<int64_t, Type>& type_map() const;
 
   absl::string_view expr_version() const { return expr_version_; }
 
+  // Returns a copy of the AST with the same expression ids, e.g. for planning
+  // it again after planning consumed the original.
+  std::unique_ptr<AstImpl> DeepCopy() const;
+
  private:
+  struct LazyTypes {
+    std::unique_ptr<LazyTypeMap> source;
+    absl::Mutex mutex;
+    // Node based, so that references to the types stay valid while more are
+    // converted.
+    absl::node_hash_map<int64_t, absl::optional<Type>> converted
+        ABSL_GUARDED_BY(mutex);
+    absl::once_flag all_once;
+    absl::flat_hash_map<int64_t, Type> all;
+  };
+
   Expr root_expr_;
   SourceInfo source_info_;
   absl::flat_hash_map<int64_t, Reference> reference_map_;
   absl::flat_hash_map<int64_t, Type> type_map_;
   std::string expr_version_;
   bool is_checked_;
+  // Set when the types are converted on demand, `type_map_` is empty then.
+  std::unique_ptr<LazyTypes> lazy_types_;
 };
 
 }  // namespace cel::ast_internal
@@ -14,8 +14,12 @@
 
 #include "base/ast_internal/ast_impl.h"
 
+#include <cstdint>
+#include <memory>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
 #include "base/ast.h"
 #include "base/ast_internal/expr.h"
 #include "internal/testing.h"
@@ -128,6 +132,62 @@ TEST(AstImpl, CheckedExprCtor) {
   EXPECT_EQ(ast_impl.source_info().syntax_version(), "1.0");
 }
 
+// Converts types from a map, counting the conversions.
+class CountingTypeMap final : public LazyTypeMap {
+ public:
+  explicit CountingTypeMap(absl::flat_hash_map<int64_t, Type> types,
+                           int& conversions)
+      : types_(std::move(types)), conversions_(conversions) {}
+
+  absl::optional<Type> FindType(int64_t expr_id) const override {
+    ++conversions_;
+    auto it = types_.find(expr_id);
+    if (it == types_.end()) {
+      return absl::nullopt;
+    }
+    return it->second;
+  }
+
+  absl::flat_hash_map<int64_t, Type> ConvertAll() const override {
+    conversions_ += types_.size();
+    return types_;
+  }
+
+ private:
+  absl::flat_hash_map<int64_t, Type> types_;
+  int& conversions_;
+};
+
+TEST(AstImpl, CheckedExprLazyTypes) {
+  CheckedExpr expr;
+  expr.mutable_expr().mutable_ident_expr().set_name("int_value");
+  expr.mutable_expr().set_id(1);
+  int conversions = 0;
+  AstImpl ast_impl(std::move(expr),
+                   std::make_unique<CountingTypeMap>(
+                       absl::flat_hash_map<int64_t, Type>{
+                           {1, Type(PrimitiveType::kInt64)},
+                           {2, Type(PrimitiveType::kBool)}},
+                       conversions));
+
+  ASSERT_TRUE(ast_impl.IsChecked());
+  EXPECT_EQ(conversions, 0);
+  EXPECT_EQ(ast_impl.GetReturnType(), Type(PrimitiveType::kInt64));
+  EXPECT_EQ(ast_impl.GetType(1), Type(PrimitiveType::kInt64));
+  EXPECT_EQ(ast_impl.FindType(3), nullptr);
+  EXPECT_EQ(ast_impl.GetType(3), Type(DynamicType()));
+  // Each id is converted at most once.
+  EXPECT_EQ(conversions, 2);
+
+  EXPECT_EQ(ast_impl.type_map().size(), 2);
+  EXPECT_EQ(ast_impl.type_map().at(2), Type(PrimitiveType::kBool));
+  EXPECT_EQ(conversions, 4);
+
+  std::unique_ptr<AstImpl> copy = ast_impl.DeepCopy();
+  EXPECT_EQ(copy->GetType(2), Type(PrimitiveType::kBool));
+  EXPECT_EQ(conversions, 4);
+}
+
 TEST(AstImpl, CheckedExprDeepCopy) {
   CheckedExpr expr;
   auto& root = expr.mutable_expr();
@@ -165,5 +225,41 @@ TEST(AstImpl, CheckedExprDeepCopy) {
   EXPECT_EQ(ast_impl.source_info().syntax_version(), "1.0");
 }
 
+TEST(AstImpl, DeepCopy) {
+  CheckedExpr expr;
+  auto& root = expr.mutable_expr();
+  root.set_id(3);
+  root.mutable_call_expr().set_function("_&&_");
+  auto& lhs = root.mutable_call_expr().add_args();
+  lhs.set_id(1);
+  lhs.mutable_select_expr().set_field("enabled");
+  auto& operand = lhs.mutable_select_expr().mutable_operand();
+  operand.set_id(4);
+  operand.mutable_ident_expr().set_name("config");
+  auto& rhs = root.mutable_call_expr().add_args();
+  rhs.set_id(2);
+  rhs.mutable_const_expr().set_bool_value(true);
+  Reference ref;
+  ref.set_name("com.config");
+  expr.mutable_reference_map()[4] = std::move(ref);
+  expr.mutable_type_map()[3] = Type(PrimitiveType::kBool);
+  expr.mutable_source_info().set_syntax_version("1.0");
+  expr.mutable_source_info().mutable_positions()[3] = 15;
+
+  AstImpl ast_impl(std::move(expr));
+  std::unique_ptr<AstImpl> copy = ast_impl.DeepCopy();
+
+  ASSERT_TRUE(copy->IsChecked());
+  EXPECT_EQ(copy->root_expr(), ast_impl.root_expr());
+  EXPECT_EQ(copy->source_info(), ast_impl.source_info());
+  EXPECT_EQ(copy->GetReturnType(), Type(PrimitiveType::kBool));
+  ASSERT_NE(copy->GetReference(4), nullptr);
+  EXPECT_EQ(copy->GetReference(4)->name(), "com.config");
+
+  // The copy doesn't share nodes with the original.
+  copy->root_expr().mutable_call_expr().mutable_args()[1].set_id(5);
+  EXPECT_EQ(ast_impl.root_expr().call_expr().args()[1].id(), 2);
+}
+
 }  // namespace
 }  // namespace cel::ast_internal
@@ -14,10 +14,12 @@
 
 #include "base/ast_internal/expr.h"
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "absl/base/no_destructor.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/functional/overload.h"
 #include "absl/types/variant.h"
 
@@ -131,4 +133,35 @@ FunctionType& FunctionType::operator=(const FunctionType& other) {
   return *this;
 }
 
+namespace {
+
+// Returns every position of `source_info`, compacted or not.
+absl::flat_hash_map<int64_t, int32_t> AllPositions(
+    const SourceInfo& source_info) {
+  absl::flat_hash_map<int64_t, int32_t> positions =
+      source_info.compact_positions().ToMap();
+  for (const auto& [id, offset] : source_info.positions()) {
+    positions.insert_or_assign(id, offset);
+  }
+  return positions;
+}
+
+}  // namespace
+
+void SourceInfo::CompactPositions() {
+  if (positions_.empty()) {
+    return;
+  }
+  compact_positions_ = SourcePositionTable::FromMap(
+      compact_positions_.empty() ? positions_ : AllPositions(*this));
+  absl::flat_hash_map<int64_t, int32_t>().swap(positions_);
+}
+
+bool SourceInfo::PositionsEqual(const SourceInfo& other) const {
+  if (compact_positions_.empty() && other.compact_positions_.empty()) {
+    return positions_ == other.positions_;
+  }
+  return AllPositions(*this) == AllPositions(other);
+}
+
 }  // namespace cel::ast_internal
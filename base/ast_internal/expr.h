@@ -27,6 +27,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
+#include "base/ast_internal/source_positions.h"
 #include "common/ast.h"
 #include "common/constant.h"
 #include "common/expr.h"
@@ -212,6 +213,29 @@ class SourceInfo {
     return positions_;
   }
 
+  // Positions moved out of `positions()` by `CompactPositions()`.
+  const SourcePositionTable& compact_positions() const {
+    return compact_positions_;
+  }
+
+  void set_compact_positions(SourcePositionTable compact_positions) {
+    compact_positions_ = std::move(compact_positions);
+  }
+
+  // Returns the code point offset of the parse node `id`, whether it is in
+  // `positions()` or `compact_positions()`.
+  absl::optional<int32_t> GetPosition(int64_t id) const {
+    if (auto it = positions_.find(id); it != positions_.end()) {
+      return it->second;
+    }
+    return compact_positions_.Find(id);
+  }
+
+  // Moves the entries of `positions()` into `compact_positions()`, which uses
+  // a small fraction of the memory. Positions are usually only read to report
+  // errors, so ASTs kept around for a long time should be compacted.
+  void CompactPositions();
+
   const absl::flat_hash_map<int64_t, Expr>& macro_calls() const {
     return macro_calls_;
   }
@@ -224,8 +248,7 @@ class SourceInfo {
     return syntax_version_ == other.syntax_version_ &&
            location_ == other.location_ &&
            line_offsets_ == other.line_offsets_ &&
-           positions_ == other.positions_ &&
-           macro_calls_ == other.macro_calls_ &&
+           PositionsEqual(other) && macro_calls_ == other.macro_calls_ &&
            extensions_ == other.extensions_;
   }
 
@@ -236,6 +259,8 @@ class SourceInfo {
   std::vector<Extension>& mutable_extensions() { return extensions_; }
 
  private:
+  bool PositionsEqual(const SourceInfo& other) const;
+
   // The syntax version of the source, e.g. `cel1`.
   std::string syntax_version_;
 
@@ -260,6 +285,9 @@ class SourceInfo {
   // within source.
   absl::flat_hash_map<int64_t, int32_t> positions_;
 
+  // Positions in a compact form, for ids not in `positions_`.
+  SourcePositionTable compact_positions_;
+
   // A map from the parse node id where a macro replacement was made to the
   // call `Expr` that resulted in a macro expansion.
   //
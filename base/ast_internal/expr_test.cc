@@ -47,6 +47,34 @@ TEST(AstTest, ParsedExpr) {
       testing::UnorderedElementsAre(testing::Pair(1, 1), testing::Pair(2, 2)));
 }
 
+TEST(AstTest, CompactPositions) {
+  SourceInfo source_info;
+  source_info.set_positions({{1, 4}, {2, 0}, {3, 8}});
+  SourceInfo expanded;
+  expanded.set_positions(source_info.positions());
+
+  source_info.CompactPositions();
+  EXPECT_THAT(source_info.positions(), testing::IsEmpty());
+  EXPECT_EQ(source_info.compact_positions().size(), 3);
+  EXPECT_EQ(source_info.GetPosition(1), 4);
+  EXPECT_EQ(source_info.GetPosition(2), 0);
+  EXPECT_EQ(source_info.GetPosition(3), 8);
+  EXPECT_EQ(source_info.GetPosition(4), absl::nullopt);
+  EXPECT_EQ(source_info, expanded);
+
+  source_info.mutable_positions().insert({4, 12});
+  source_info.mutable_positions().insert_or_assign(1, 5);
+  EXPECT_EQ(source_info.GetPosition(1), 5);
+  EXPECT_EQ(source_info.GetPosition(4), 12);
+  EXPECT_NE(source_info, expanded);
+
+  source_info.CompactPositions();
+  EXPECT_THAT(source_info.positions(), testing::IsEmpty());
+  EXPECT_EQ(source_info.compact_positions().size(), 4);
+  EXPECT_EQ(source_info.GetPosition(1), 5);
+  EXPECT_EQ(source_info.GetPosition(4), 12);
+}
+
 TEST(AstTest, ListTypeMutableConstruction) {
   ListType type;
   type.mutable_elem_type() = Type(PrimitiveType::kBool);
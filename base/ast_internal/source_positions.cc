@@ -0,0 +1,151 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/ast_internal/source_positions.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_check.h"
+#include "absl/types/optional.h"
+
+namespace cel::ast_internal {
+
+namespace {
+
+void AppendVarint(uint64_t value, std::string& data) {
+  while (value >= 0x80) {
+    data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data.push_back(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(const char*& data) {
+  uint64_t value = 0;
+  int shift = 0;
+  uint8_t byte;
+  do {
+    byte = static_cast<uint8_t>(*data++);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}  // namespace
+
+SourcePositionTable SourcePositionTable::FromMap(
+    const absl::flat_hash_map<int64_t, int32_t>& positions) {
+  std::vector<std::pair<int64_t, int32_t>> sorted(positions.begin(),
+                                                  positions.end());
+  std::sort(sorted.begin(), sorted.end());
+  SourcePositionTable table;
+  for (const auto& [id, offset] : sorted) {
+    table.Append(id, offset);
+  }
+  table.ShrinkToFit();
+  return table;
+}
+
+void SourcePositionTable::Append(int64_t id, int32_t offset) {
+  if (size_ % kBlockSize == 0) {
+    blocks_.push_back(
+        Block{id, offset, static_cast<uint32_t>(data_.size())});
+  } else {
+    ABSL_DCHECK_GT(id, last_id_);
+    AppendVarint(static_cast<uint64_t>(id - last_id_), data_);
+    AppendVarint(ZigZagEncode(static_cast<int64_t>(offset) - last_offset_),
+                 data_);
+  }
+  last_id_ = id;
+  last_offset_ = offset;
+  ++size_;
+}
+
+absl::optional<int32_t> SourcePositionTable::Find(int64_t id) const {
+  auto block = std::upper_bound(
+      blocks_.begin(), blocks_.end(), id,
+      [](int64_t id, const Block& block) { return id < block.id; });
+  if (block == blocks_.begin()) {
+    return absl::nullopt;
+  }
+  --block;
+  int64_t entry_id = block->id;
+  int64_t offset = block->offset;
+  if (entry_id == id) {
+    return static_cast<int32_t>(offset);
+  }
+  size_t index = static_cast<size_t>(block - blocks_.begin());
+  size_t count = std::min(kBlockSize, size_ - index * kBlockSize);
+  const char* data = data_.data() + block->data_offset;
+  for (size_t i = 1; i < count; ++i) {
+    entry_id += static_cast<int64_t>(ReadVarint(data));
+    offset += ZigZagDecode(ReadVarint(data));
+    if (entry_id >= id) {
+      if (entry_id == id) {
+        return static_cast<int32_t>(offset);
+      }
+      break;
+    }
+  }
+  return absl::nullopt;
+}
+
+void SourcePositionTable::ForEach(
+    absl::FunctionRef<void(int64_t, int32_t)> callback) const {
+  const char* data = data_.data();
+  for (size_t index = 0; index < blocks_.size(); ++index) {
+    const Block& block = blocks_[index];
+    int64_t id = block.id;
+    int64_t offset = block.offset;
+    callback(id, static_cast<int32_t>(offset));
+    size_t count = std::min(kBlockSize, size_ - index * kBlockSize);
+    for (size_t i = 1; i < count; ++i) {
+      id += static_cast<int64_t>(ReadVarint(data));
+      offset += ZigZagDecode(ReadVarint(data));
+      callback(id, static_cast<int32_t>(offset));
+    }
+  }
+}
+
+absl::flat_hash_map<int64_t, int32_t> SourcePositionTable::ToMap() const {
+  absl::flat_hash_map<int64_t, int32_t> positions;
+  positions.reserve(size_);
+  ForEach([&positions](int64_t id, int32_t offset) {
+    positions.insert({id, offset});
+  });
+  return positions;
+}
+
+void SourcePositionTable::ShrinkToFit() {
+  data_.shrink_to_fit();
+  blocks_.shrink_to_fit();
+}
+
+}  // namespace cel::ast_internal
@@ -0,0 +1,106 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Compact storage for the source positions of a parsed expression.
+// CEL users should not directly depend on the definitions here.
+#ifndef THIRD_PARTY_CEL_CPP_BASE_AST_INTERNAL_SOURCE_POSITIONS_H_
+#define THIRD_PARTY_CEL_CPP_BASE_AST_INTERNAL_SOURCE_POSITIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/types/optional.h"
+
+namespace cel::ast_internal {
+
+// `SourcePositionTable` maps parse node ids to code point offsets like
+// `SourceInfo::positions()`, using a few bytes per node instead of a hash map
+// entry. Entries are sorted by id and delta-encoded as varints, with the
+// absolute id and offset of every `kBlockSize`-th entry kept aside so that
+// lookups binary search the blocks and decode at most one of them.
+//
+// The table is immutable once built, so it may be read concurrently.
+class SourcePositionTable final {
+ public:
+  static constexpr size_t kBlockSize = 16;
+
+  // Builds a table holding the same entries as `positions`.
+  static SourcePositionTable FromMap(
+      const absl::flat_hash_map<int64_t, int32_t>& positions);
+
+  SourcePositionTable() = default;
+  SourcePositionTable(const SourcePositionTable&) = default;
+  SourcePositionTable(SourcePositionTable&&) = default;
+  SourcePositionTable& operator=(const SourcePositionTable&) = default;
+  SourcePositionTable& operator=(SourcePositionTable&&) = default;
+
+  // Appends an entry. `id` must be greater than the id of every entry
+  // appended before it.
+  void Append(int64_t id, int32_t offset);
+
+  // Returns the offset of `id`, or `absl::nullopt` if it has no entry.
+  absl::optional<int32_t> Find(int64_t id) const;
+
+  // Calls `callback` for every entry, in order of increasing id.
+  void ForEach(absl::FunctionRef<void(int64_t, int32_t)> callback) const;
+
+  // Returns the entries as a map, e.g. to convert back to `SourceInfo`.
+  absl::flat_hash_map<int64_t, int32_t> ToMap() const;
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  // Releases the capacity left over from appending.
+  void ShrinkToFit();
+
+  bool operator==(const SourcePositionTable& other) const {
+    return size_ == other.size_ && data_ == other.data_ &&
+           blocks_ == other.blocks_;
+  }
+
+  bool operator!=(const SourcePositionTable& other) const {
+    return !operator==(other);
+  }
+
+ private:
+  // The first entry of a block, which is not repeated in `data_`.
+  struct Block {
+    int64_t id;
+    int32_t offset;
+    // Where the encoding of the block's second entry starts in `data_`.
+    uint32_t data_offset;
+
+    bool operator==(const Block& other) const {
+      return id == other.id && offset == other.offset &&
+             data_offset == other.data_offset;
+    }
+  };
+
+  // Varint encoded pairs of id delta and zig-zag encoded offset delta, from
+  // the previous entry of the same block.
+  std::string data_;
+  std::vector<Block> blocks_;
+  size_t size_ = 0;
+  int64_t last_id_ = 0;
+  int32_t last_offset_ = 0;
+};
+
+}  // namespace cel::ast_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_BASE_AST_INTERNAL_SOURCE_POSITIONS_H_
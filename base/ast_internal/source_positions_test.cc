@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/ast_internal/source_positions.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "internal/testing.h"
+
+namespace cel::ast_internal {
+namespace {
+
+using testing::ElementsAreArray;
+using testing::Pair;
+using testing::UnorderedElementsAre;
+
+TEST(SourcePositionTable, Empty) {
+  SourcePositionTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.Find(1), absl::nullopt);
+  EXPECT_THAT(table.ToMap(), testing::IsEmpty());
+}
+
+TEST(SourcePositionTable, Find) {
+  SourcePositionTable table = SourcePositionTable::FromMap(
+      {{3, 10}, {1, 0}, {2, 4}, {7, 2}, {100000, 1 << 20}});
+  EXPECT_EQ(table.size(), 5);
+  EXPECT_EQ(table.Find(0), absl::nullopt);
+  EXPECT_EQ(table.Find(1), 0);
+  EXPECT_EQ(table.Find(2), 4);
+  EXPECT_EQ(table.Find(3), 10);
+  EXPECT_EQ(table.Find(4), absl::nullopt);
+  EXPECT_EQ(table.Find(7), 2);
+  EXPECT_EQ(table.Find(100000), 1 << 20);
+  EXPECT_EQ(table.Find(100001), absl::nullopt);
+}
+
+TEST(SourcePositionTable, SpansBlocks) {
+  absl::flat_hash_map<int64_t, int32_t> positions;
+  std::vector<std::pair<int64_t, int32_t>> entries;
+  for (int64_t id = 1; id <= 10 * SourcePositionTable::kBlockSize + 3;
+       ++id) {
+    // Offsets are not monotonic in ids, e.g. for the operands of a call.
+    int32_t offset = static_cast<int32_t>((id * 37) % 101);
+    positions.insert({id * 2, offset});
+    entries.push_back({id * 2, offset});
+  }
+  SourcePositionTable table = SourcePositionTable::FromMap(positions);
+  EXPECT_EQ(table.size(), entries.size());
+  for (const auto& [id, offset] : entries) {
+    EXPECT_EQ(table.Find(id), offset) << id;
+    EXPECT_EQ(table.Find(id + 1), absl::nullopt) << id + 1;
+  }
+  std::vector<std::pair<int64_t, int32_t>> visited;
+  table.ForEach([&visited](int64_t id, int32_t offset) {
+    visited.push_back({id, offset});
+  });
+  EXPECT_THAT(visited, ElementsAreArray(entries));
+  EXPECT_EQ(table.ToMap(), positions);
+}
+
+TEST(SourcePositionTable, Append) {
+  SourcePositionTable table;
+  table.Append(1, 5);
+  table.Append(4, 1);
+  EXPECT_THAT(table.ToMap(), UnorderedElementsAre(Pair(1, 5), Pair(4, 1)));
+  EXPECT_EQ(table, SourcePositionTable::FromMap({{4, 1}, {1, 5}}));
+  EXPECT_NE(table, SourcePositionTable::FromMap({{4, 2}, {1, 5}}));
+}
+
+}  // namespace
+}  // namespace cel::ast_internal
@@ -161,6 +161,9 @@ class AttributeQualifierPattern final {
 
   bool IsWildcard() const { return !value_.has_value(); }
 
+  // The qualifier matched by this pattern, unless it is a wildcard.
+  const std::optional<AttributeQualifier>& value() const { return value_; }
+
   bool IsMatch(const AttributeQualifier& qualifier) const {
     if (IsWildcard()) return true;
     return value_.value() == qualifier;
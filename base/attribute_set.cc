@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/attribute_set.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "absl/base/no_destructor.h"
+#include "absl/types/span.h"
+#include "base/attribute.h"
+#include "internal/copy_on_write.h"
+
+namespace cel {
+
+internal::CopyOnWrite<typename AttributeSet::Container> AttributeSet::Empty() {
+  static const absl::NoDestructor<internal::CopyOnWrite<Container>> empty;
+  return *empty;
+}
+
+AttributeSet::AttributeSet(absl::Span<const Attribute> attributes)
+    : attributes_(Empty()) {
+  if (attributes.empty()) {
+    return;
+  }
+  Container& container = attributes_.mutable_get();
+  container.assign(attributes.begin(), attributes.end());
+  std::sort(container.begin(), container.end());
+  container.erase(std::unique(container.begin(), container.end()),
+                  container.end());
+}
+
+void AttributeSet::Add(const Attribute& attribute) {
+  const Container& container = attributes_.get();
+  auto it = std::lower_bound(container.begin(), container.end(), attribute);
+  if (it != container.end() && *it == attribute) {
+    return;
+  }
+  auto offset = std::distance(container.begin(), it);
+  Container& mutable_container = attributes_.mutable_get();
+  mutable_container.insert(mutable_container.begin() + offset, attribute);
+}
+
+void AttributeSet::Add(const AttributeSet& other) {
+  const Container& container = attributes_.get();
+  const Container& other_container = other.attributes_.get();
+  if (&container == &other_container || other_container.empty()) {
+    return;
+  }
+  if (container.empty()) {
+    attributes_ = other.attributes_;
+    return;
+  }
+  if (std::includes(container.begin(), container.end(),
+                    other_container.begin(), other_container.end())) {
+    return;
+  }
+  if (std::includes(other_container.begin(), other_container.end(),
+                    container.begin(), container.end())) {
+    attributes_ = other.attributes_;
+    return;
+  }
+  Container merged;
+  merged.reserve(container.size() + other_container.size());
+  std::set_union(container.begin(), container.end(), other_container.begin(),
+                 other_container.end(), std::back_inserter(merged));
+  attributes_.mutable_get() = std::move(merged);
+}
+
+}  // namespace cel
@@ -17,9 +17,9 @@
 
 #include <vector>
 
-#include "absl/container/btree_set.h"
 #include "absl/types/span.h"
 #include "base/attribute.h"
+#include "internal/copy_on_write.h"
 
 namespace google::api::expr::runtime {
 class AttributeUtility;
@@ -34,9 +34,13 @@ class UnknownSet;
 
 // AttributeSet is a container for CEL attributes that are identified as
 // unknown during expression evaluation.
+//
+// The attributes are kept sorted in a copy-on-write vector, so copies share
+// the same storage and merging a set with an empty set, itself or one of its
+// subsets does not allocate.
 class AttributeSet final {
  private:
-  using Container = absl::btree_set<Attribute>;
+  using Container = std::vector<Attribute>;
 
  public:
   using value_type = typename Container::value_type;
@@ -44,39 +48,43 @@ class AttributeSet final {
   using iterator = typename Container::const_iterator;
   using const_iterator = typename Container::const_iterator;
 
-  AttributeSet() = default;
+  AttributeSet() : attributes_(Empty()) {}
   AttributeSet(const AttributeSet&) = default;
-  AttributeSet(AttributeSet&&) = default;
   AttributeSet& operator=(const AttributeSet&) = default;
-  AttributeSet& operator=(AttributeSet&&) = default;
 
-  explicit AttributeSet(absl::Span<const Attribute> attributes) {
-    for (const auto& attr : attributes) {
-      Add(attr);
-    }
+  // Moves leave `other` valid, holding the previous contents of this set.
+  AttributeSet(AttributeSet&& other) noexcept : attributes_(Empty()) {
+    attributes_.swap(other.attributes_);
+  }
+
+  AttributeSet& operator=(AttributeSet&& other) noexcept {
+    attributes_.swap(other.attributes_);
+    return *this;
   }
 
+  explicit AttributeSet(absl::Span<const Attribute> attributes);
+
   AttributeSet(const AttributeSet& set1, const AttributeSet& set2)
       : attributes_(set1.attributes_) {
-    for (const auto& attr : set2.attributes_) {
-      Add(attr);
-    }
+    Add(set2);
   }
 
-  iterator begin() const { return attributes_.begin(); }
+  iterator begin() const { return attributes_.get().begin(); }
 
-  const_iterator cbegin() const { return attributes_.cbegin(); }
+  const_iterator cbegin() const { return attributes_.get().cbegin(); }
 
-  iterator end() const { return attributes_.end(); }
+  iterator end() const { return attributes_.get().end(); }
 
-  const_iterator cend() const { return attributes_.cend(); }
+  const_iterator cend() const { return attributes_.get().cend(); }
 
-  size_type size() const { return attributes_.size(); }
+  size_type size() const { return attributes_.get().size(); }
 
-  bool empty() const { return attributes_.empty(); }
+  bool empty() const { return attributes_.get().empty(); }
 
   bool operator==(const AttributeSet& other) const {
-    return this == &other || attributes_ == other.attributes_;
+    return this == &other ||
+           &attributes_.get() == &other.attributes_.get() ||
+           attributes_.get() == other.attributes_.get();
   }
 
   bool operator!=(const AttributeSet& other) const {
@@ -93,16 +101,14 @@ class AttributeSet final {
   friend class UnknownValue;
   friend class base_internal::UnknownSet;
 
-  void Add(const Attribute& attribute) { attributes_.insert(attribute); }
+  static internal::CopyOnWrite<Container> Empty();
 
-  void Add(const AttributeSet& other) {
-    for (const auto& attribute : other) {
-      Add(attribute);
-    }
-  }
+  void Add(const Attribute& attribute);
+
+  void Add(const AttributeSet& other);
 
-  // Attribute container.
-  Container attributes_;
+  // Sorted, unique attributes.
+  internal::CopyOnWrite<Container> attributes_;
 };
 
 }  // namespace cel
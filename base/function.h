@@ -15,7 +15,10 @@
 #ifndef THIRD_PARTY_CEL_CPP_BASE_FUNCTION_H_
 #define THIRD_PARTY_CEL_CPP_BASE_FUNCTION_H_
 
+#include <memory>
+
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "common/value.h"
 #include "common/value_manager.h"
@@ -58,6 +61,22 @@ class Function {
   // follows CEL's logical short-circuiting behavior.
   virtual absl::StatusOr<Value> Invoke(const InvokeContext& context,
                                        absl::Span<const Value> args) const = 0;
+
+  // Optionally returns an implementation specialized for a call whose
+  // arguments are partially known when the program is planned, such as one
+  // with a pattern that is parsed once instead of on every call. Returns
+  // nullptr if the function has no specialization for the call.
+  //
+  // `constant_args` has an entry for each argument, set for those with a
+  // constant value. The specialization is still invoked with all of the
+  // arguments, and must behave the same as this function.
+  //
+  // Only consulted if function specialization is enabled for the runtime.
+  virtual absl::StatusOr<std::unique_ptr<Function>> Specialize(
+      ValueManager& value_factory,
+      absl::Span<const absl::optional<Value>> constant_args) const {
+    return nullptr;
+  }
 };
 
 // Legacy type, aliased to the actual type.
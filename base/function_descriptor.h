@@ -30,9 +30,10 @@ namespace cel {
 class FunctionDescriptor final {
  public:
   FunctionDescriptor(absl::string_view name, bool receiver_style,
-                     std::vector<Kind> types, bool is_strict = true)
+                     std::vector<Kind> types, bool is_strict = true,
+                     bool is_pure = false)
       : impl_(std::make_shared<Impl>(name, receiver_style, std::move(types),
-                                     is_strict)) {}
+                                     is_strict, is_pure)) {}
 
   // Function name.
   const std::string& name() const { return impl_->name; }
@@ -50,6 +51,13 @@ class FunctionDescriptor final {
   // receive error or unknown values as arguments.
   bool is_strict() const { return impl_->is_strict; }
 
+  // if true, the function is pure: its result only depends on its arguments,
+  // so the runtime may reuse the result of an earlier call with equal
+  // arguments instead of calling it again (see
+  // cel::extensions::EnableFunctionMemoization). Defaults to false. Does not
+  // affect matching descriptors.
+  bool is_pure() const { return impl_->is_pure; }
+
   // Helper for matching a descriptor. This tests that the shape is the same --
   // |other| accepts the same number and types of arguments and is the same call
   // style).
@@ -65,16 +73,18 @@ class FunctionDescriptor final {
  private:
   struct Impl final {
     Impl(absl::string_view name, bool receiver_style, std::vector<Kind> types,
-         bool is_strict)
+         bool is_strict, bool is_pure)
         : name(name),
           types(std::move(types)),
           receiver_style(receiver_style),
-          is_strict(is_strict) {}
+          is_strict(is_strict),
+          is_pure(is_pure) {}
 
     std::string name;
     std::vector<Kind> types;
     bool receiver_style;
     bool is_strict;
+    bool is_pure;
   };
 
   std::shared_ptr<const Impl> impl_;
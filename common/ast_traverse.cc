@@ -14,13 +14,16 @@
 
 #include "common/ast_traverse.h"
 
+#include <cstdint>
 #include <stack>
+#include <vector>
 
 #include "absl/log/absl_log.h"
 #include "absl/types/variant.h"
 #include "common/ast_visitor.h"
 #include "common/constant.h"
 #include "common/expr.h"
+#include "common/flat_ast.h"
 
 namespace cel {
 
@@ -316,8 +319,87 @@ void PushDependencies(const StackRecord& record, std::stack<StackRecord>& stack,
   absl::visit(PushDepsVisitor{stack, options}, record.record_variant);
 }
 
+struct FlatAstFrame {
+  int32_t index;
+  int32_t next_child;
+};
+
+void PreVisitFlatAstNode(const Expr& expr, AstVisitor& visitor) {
+  PreVisit(StackRecord(&expr), &visitor);
+}
+
+void PostVisitFlatAstNode(const Expr& expr, AstVisitor& visitor) {
+  PostVisit(StackRecord(&expr), &visitor);
+}
+
+// Called before visiting the child at `child_index` of `parent`.
+void PreVisitFlatAstChild(const Expr& parent, int32_t child_index,
+                          AstVisitor& visitor,
+                          const TraversalOptions& options) {
+  if (parent.has_comprehension_expr() && options.use_comprehension_callbacks) {
+    visitor.PreVisitComprehensionSubexpression(
+        parent, parent.comprehension_expr(),
+        static_cast<ComprehensionArg>(child_index));
+  }
+}
+
+// Called after visiting the child at `child_index` of `parent`.
+void PostVisitFlatAstChild(const Expr& parent, int32_t child_index,
+                           AstVisitor& visitor,
+                           const TraversalOptions& options) {
+  if (parent.has_call_expr()) {
+    if (parent.call_expr().has_target()) {
+      if (child_index == 0) {
+        visitor.PostVisitTarget(parent);
+        return;
+      }
+      --child_index;
+    }
+    visitor.PostVisitArg(parent, child_index);
+  } else if (parent.has_comprehension_expr()) {
+    if (options.use_comprehension_callbacks) {
+      visitor.PostVisitComprehensionSubexpression(
+          parent, parent.comprehension_expr(),
+          static_cast<ComprehensionArg>(child_index));
+    } else {
+      visitor.PostVisitArg(parent, child_index);
+    }
+  }
+}
+
 }  // namespace
 
+void AstTraverse(const FlatAst& ast, AstVisitor& visitor,
+                 TraversalOptions options) {
+  if (ast.empty()) {
+    return;
+  }
+  std::vector<FlatAstFrame> stack;
+  stack.push_back({0, 0});
+  PreVisitFlatAstNode(*ast.node(0).expr, visitor);
+
+  while (!stack.empty()) {
+    FlatAstFrame& frame = stack.back();
+    const FlatAst::Node& node = ast.node(frame.index);
+    if (frame.next_child < node.children_size) {
+      int32_t child = ast.children(frame.index)[frame.next_child];
+      PreVisitFlatAstChild(*node.expr, frame.next_child, visitor, options);
+      // `frame` is invalidated by the push.
+      stack.push_back({child, 0});
+      PreVisitFlatAstNode(*ast.node(child).expr, visitor);
+      continue;
+    }
+    PostVisitFlatAstNode(*node.expr, visitor);
+    stack.pop_back();
+    if (!stack.empty()) {
+      FlatAstFrame& parent = stack.back();
+      PostVisitFlatAstChild(*ast.node(parent.index).expr, parent.next_child,
+                            visitor, options);
+      ++parent.next_child;
+    }
+  }
+}
+
 void AstTraverse(const Expr& expr, AstVisitor& visitor,
                  TraversalOptions options) {
   std::stack<StackRecord> stack;
@@ -17,6 +17,7 @@
 
 #include "common/ast_visitor.h"
 #include "common/expr.h"
+#include "common/flat_ast.h"
 
 namespace cel {
 
@@ -58,6 +59,11 @@ struct TraversalOptions {
 void AstTraverse(const Expr& expr, AstVisitor& visitor,
                  TraversalOptions options = TraversalOptions());
 
+// Traverses the expression indexed by `ast`, with the same callbacks and
+// order as above.
+void AstTraverse(const FlatAst& ast, AstVisitor& visitor,
+                 TraversalOptions options = TraversalOptions());
+
 }  // namespace cel
 
 #endif  // THIRD_PARTY_CEL_CPP_COMMON_AST_TRAVERSE_NATIVE_H_
@@ -0,0 +1,121 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/flat_ast.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/expr.h"
+
+namespace cel {
+
+namespace {
+
+struct PendingNode {
+  const Expr* expr;
+  int32_t parent;
+};
+
+// Pushes the children of `expr` in reverse traversal order, so that they are
+// popped in order.
+void PushChildren(const Expr& expr, int32_t index,
+                  std::vector<PendingNode>& stack) {
+  if (expr.has_select_expr()) {
+    if (expr.select_expr().has_operand()) {
+      stack.push_back({&expr.select_expr().operand(), index});
+    }
+  } else if (expr.has_call_expr()) {
+    const auto& call = expr.call_expr();
+    for (auto it = call.args().rbegin(); it != call.args().rend(); ++it) {
+      stack.push_back({&*it, index});
+    }
+    if (call.has_target()) {
+      stack.push_back({&call.target(), index});
+    }
+  } else if (expr.has_list_expr()) {
+    const auto& elements = expr.list_expr().elements();
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+      stack.push_back({&it->expr(), index});
+    }
+  } else if (expr.has_struct_expr()) {
+    const auto& fields = expr.struct_expr().fields();
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+      if (it->has_value()) {
+        stack.push_back({&it->value(), index});
+      }
+    }
+  } else if (expr.has_map_expr()) {
+    const auto& entries = expr.map_expr().entries();
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+      if (it->has_value()) {
+        stack.push_back({&it->value(), index});
+      }
+      if (it->has_key()) {
+        stack.push_back({&it->key(), index});
+      }
+    }
+  } else if (expr.has_comprehension_expr()) {
+    const auto& comprehension = expr.comprehension_expr();
+    stack.push_back({&comprehension.result(), index});
+    stack.push_back({&comprehension.loop_step(), index});
+    stack.push_back({&comprehension.loop_condition(), index});
+    stack.push_back({&comprehension.accu_init(), index});
+    stack.push_back({&comprehension.iter_range(), index});
+  }
+}
+
+}  // namespace
+
+FlatAst FlatAst::Build(const Expr& root) {
+  FlatAst ast;
+  std::vector<PendingNode> stack;
+  stack.push_back({&root, kNoParent});
+  while (!stack.empty()) {
+    PendingNode pending = stack.back();
+    stack.pop_back();
+    int32_t index = static_cast<int32_t>(ast.nodes_.size());
+    ast.nodes_.push_back(Node{pending.expr, pending.parent,
+                              /*child_index=*/0, /*subtree_size=*/1,
+                              /*children_begin=*/0, /*children_size=*/0});
+    if (pending.parent != kNoParent) {
+      Node& parent = ast.nodes_[pending.parent];
+      ast.nodes_.back().child_index = parent.children_size++;
+    }
+    PushChildren(*pending.expr, index, stack);
+  }
+
+  // Parents precede their descendants, so a reverse pass accumulates the
+  // subtree sizes bottom up.
+  for (int32_t i = static_cast<int32_t>(ast.nodes_.size()) - 1; i > 0; --i) {
+    ast.nodes_[ast.nodes_[i].parent].subtree_size += ast.nodes_[i].subtree_size;
+  }
+
+  // The first child of a node follows it, and each sibling follows the
+  // subtree of the previous one.
+  ast.children_.reserve(ast.nodes_.empty() ? 0 : ast.nodes_.size() - 1);
+  for (int32_t i = 0; i < static_cast<int32_t>(ast.nodes_.size()); ++i) {
+    Node& node = ast.nodes_[i];
+    node.children_begin = static_cast<int32_t>(ast.children_.size());
+    int32_t child = i + 1;
+    for (int32_t n = 0; n < node.children_size; ++n) {
+      ast.children_.push_back(child);
+      child += ast.nodes_[child].subtree_size;
+    }
+  }
+  return ast;
+}
+
+}  // namespace cel
@@ -0,0 +1,89 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_FLAT_AST_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_FLAT_AST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "common/expr.h"
+
+namespace cel {
+
+// FlatAst is a compact index over an expression tree. The nodes are stored
+// contiguously in preorder and refer to their parent and children by int32
+// index, so traversals touch two vectors instead of chasing the pointers of
+// the tree.
+//
+// Children are in traversal order:
+//   - the operand of a select
+//   - the receiver of a call, if present, followed by the arguments
+//   - list elements
+//   - struct field values
+//   - map keys and values, alternating per entry
+//   - comprehension range, accu_init, condition, step and result
+//
+// The index refers to the nodes of the tree it was built from, which must
+// outlive it and must not be mutated.
+class FlatAst final {
+ public:
+  static constexpr int32_t kNoParent = -1;
+
+  struct Node {
+    const Expr* expr;
+    int32_t parent;
+    // The position of the node in the children of its parent.
+    int32_t child_index;
+    // The number of nodes in the subtree rooted at this node, including
+    // itself. The subtree occupies [index, index + subtree_size).
+    int32_t subtree_size;
+    int32_t children_begin;
+    int32_t children_size;
+  };
+
+  static FlatAst Build(const Expr& root);
+
+  FlatAst() = default;
+
+  FlatAst(const FlatAst&) = delete;
+  FlatAst& operator=(const FlatAst&) = delete;
+  FlatAst(FlatAst&&) = default;
+  FlatAst& operator=(FlatAst&&) = default;
+
+  // The nodes in preorder. The root, if any, is at index 0.
+  absl::Span<const Node> nodes() const { return nodes_; }
+
+  const Node& node(int32_t index) const { return nodes_[index]; }
+
+  size_t size() const { return nodes_.size(); }
+
+  bool empty() const { return nodes_.empty(); }
+
+  absl::Span<const int32_t> children(int32_t index) const {
+    const Node& node = nodes_[index];
+    return absl::MakeConstSpan(children_)
+        .subspan(node.children_begin, node.children_size);
+  }
+
+ private:
+  std::vector<Node> nodes_;
+  std::vector<int32_t> children_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_FLAT_AST_H_
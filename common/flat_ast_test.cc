@@ -0,0 +1,166 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/flat_ast.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/ast.h"
+#include "common/ast_traverse.h"
+#include "common/ast_visitor.h"
+#include "common/constant.h"
+#include "common/expr.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+
+namespace cel {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::google::api::expr::parser::ParseAst;
+using testing::ElementsAre;
+
+// Records the callbacks of a traversal.
+class RecordingVisitor final : public AstVisitor {
+ public:
+  void PreVisitExpr(const Expr& expr) override { Record("PreExpr", expr); }
+  void PostVisitExpr(const Expr& expr) override { Record("PostExpr", expr); }
+  void PostVisitConst(const Expr& expr, const Constant&) override {
+    Record("Const", expr);
+  }
+  void PostVisitIdent(const Expr& expr, const IdentExpr&) override {
+    Record("Ident", expr);
+  }
+  void PreVisitSelect(const Expr& expr, const SelectExpr&) override {
+    Record("PreSelect", expr);
+  }
+  void PostVisitSelect(const Expr& expr, const SelectExpr&) override {
+    Record("PostSelect", expr);
+  }
+  void PreVisitCall(const Expr& expr, const CallExpr&) override {
+    Record("PreCall", expr);
+  }
+  void PostVisitCall(const Expr& expr, const CallExpr&) override {
+    Record("PostCall", expr);
+  }
+  void PostVisitTarget(const Expr& expr) override { Record("Target", expr); }
+  void PreVisitComprehension(const Expr& expr,
+                             const ComprehensionExpr&) override {
+    Record("PreComprehension", expr);
+  }
+  void PreVisitComprehensionSubexpression(const Expr& expr,
+                                          const ComprehensionExpr&,
+                                          ComprehensionArg arg) override {
+    Record(absl::StrCat("PreSubexpression", arg), expr);
+  }
+  void PostVisitComprehensionSubexpression(const Expr& expr,
+                                           const ComprehensionExpr&,
+                                           ComprehensionArg arg) override {
+    Record(absl::StrCat("PostSubexpression", arg), expr);
+  }
+  void PostVisitComprehension(const Expr& expr,
+                              const ComprehensionExpr&) override {
+    Record("PostComprehension", expr);
+  }
+  void PostVisitArg(const Expr& expr, int arg_num) override {
+    Record(absl::StrCat("Arg", arg_num), expr);
+  }
+  void PostVisitList(const Expr& expr, const ListExpr&) override {
+    Record("List", expr);
+  }
+  void PostVisitStruct(const Expr& expr, const StructExpr&) override {
+    Record("Struct", expr);
+  }
+  void PostVisitMap(const Expr& expr, const MapExpr&) override {
+    Record("Map", expr);
+  }
+
+  const std::vector<std::string>& events() const { return events_; }
+
+ private:
+  void Record(absl::string_view event, const Expr& expr) {
+    events_.push_back(absl::StrCat(event, "@", expr.id()));
+  }
+
+  std::vector<std::string> events_;
+};
+
+const Expr& RootExpr(const Ast& ast) {
+  return AstImpl::CastFromPublicAst(ast).root_expr();
+}
+
+TEST(FlatAst, Layout) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Ast> ast, ParseAst("a.f(b, [c])"));
+  FlatAst flat = FlatAst::Build(RootExpr(*ast));
+
+  // call(a, b, list(c))
+  ASSERT_EQ(flat.size(), 5);
+  EXPECT_TRUE(flat.node(0).expr->has_call_expr());
+  EXPECT_EQ(flat.node(0).parent, FlatAst::kNoParent);
+  EXPECT_EQ(flat.node(0).subtree_size, 5);
+  EXPECT_THAT(flat.children(0), ElementsAre(1, 2, 3));
+
+  EXPECT_EQ(flat.node(1).expr->ident_expr().name(), "a");
+  EXPECT_EQ(flat.node(2).expr->ident_expr().name(), "b");
+  EXPECT_EQ(flat.node(2).child_index, 1);
+  EXPECT_TRUE(flat.node(3).expr->has_list_expr());
+  EXPECT_EQ(flat.node(3).subtree_size, 2);
+  EXPECT_THAT(flat.children(3), ElementsAre(4));
+  EXPECT_EQ(flat.node(4).parent, 3);
+  EXPECT_TRUE(flat.children(4).empty());
+}
+
+TEST(FlatAst, Empty) {
+  FlatAst flat;
+  RecordingVisitor visitor;
+  AstTraverse(flat, visitor);
+  EXPECT_TRUE(visitor.events().empty());
+}
+
+TEST(FlatAst, TraversalMatchesTree) {
+  for (absl::string_view expression : {
+           "1",
+           "a.b.c",
+           "has(a.b)",
+           "f(1, a) + b.g(c)",
+           "[1, [2, 3], {'a': b}]",
+           "{1: 2, 'x': [y]}",
+           "Msg{field: 1, other: a.b}",
+           "[1, 2].exists(x, x > a) && [3].map(y, [y].all(z, z == y))",
+           "a ? b : c || d && e",
+       }) {
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<Ast> ast, ParseAst(expression));
+    FlatAst flat = FlatAst::Build(RootExpr(*ast));
+    for (bool use_comprehension_callbacks : {false, true}) {
+      TraversalOptions options;
+      options.use_comprehension_callbacks = use_comprehension_callbacks;
+
+      RecordingVisitor expected;
+      AstTraverse(RootExpr(*ast), expected, options);
+      RecordingVisitor actual;
+      AstTraverse(flat, actual, options);
+
+      EXPECT_EQ(actual.events(), expected.events()) << expression;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace cel
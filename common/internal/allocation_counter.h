@@ -0,0 +1,47 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// IWYU pragma: private
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/base/nullability.h"
+#include "absl/base/optimization.h"
+
+namespace cel::common_internal {
+
+// Returns the counter of the innermost allocation accounting scope active on
+// the calling thread, or `nullptr` if there is none.
+inline absl::Nullable<uint64_t*>& ThreadAllocationCounter() {
+  static thread_local uint64_t* counter = nullptr;
+  return counter;
+}
+
+// Adds `size` to the counter of the innermost allocation accounting scope of
+// the calling thread, if any. Called by the memory managers for every
+// allocation they make.
+inline void CountAllocation(size_t size) {
+  if (uint64_t* counter = ThreadAllocationCounter();
+      ABSL_PREDICT_FALSE(counter != nullptr)) {
+    *counter += size;
+  }
+}
+
+}  // namespace cel::common_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
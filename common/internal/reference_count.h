@@ -21,7 +21,9 @@
 #define THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_REFERENCE_COUNT_H_
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -29,6 +31,8 @@
 #include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
 #include "absl/log/absl_check.h"
+#include "common/internal/allocation_counter.h"
+#include "common/internal/small_object_allocator.h"
 
 namespace cel::common_internal {
 
@@ -113,12 +117,56 @@ bool IsExpiredRef(const ReferenceCount& refcount);
 ABSL_MUST_USE_RESULT
 bool IsExpiredRef(absl::Nullable<const ReferenceCount*> refcount);
 
+void PromoteToAtomicRef(const ReferenceCount& refcount);
+
+void PromoteToAtomicRef(absl::Nullable<const ReferenceCount*> refcount);
+
+void MakeImmortalRef(const ReferenceCount& refcount);
+
+void DeleteImmortalRef(const ReferenceCount& refcount);
+
+ABSL_MUST_USE_RESULT
+bool IsImmortalRef(const ReferenceCount& refcount);
+
+ABSL_MUST_USE_RESULT
+bool IsImmortalRef(absl::Nullable<const ReferenceCount*> refcount);
+
+// Returns the number of `ScopedNonAtomicReferenceCounts` active on the calling
+// thread.
+inline int& NonAtomicReferenceCountDepth() {
+  thread_local int depth = 0;
+  return depth;
+}
+
+// While an instance is alive, reference counts created on the calling thread
+// are adjusted with plain loads and stores instead of atomic read-modify-write
+// operations. This is for evaluations whose values never leave the thread:
+// such a reference count must only be used by the thread which created it,
+// unless it is first passed to `PromoteToAtomicRef` by that thread and then
+// published to the other thread with the usual synchronization.
+//
+// Must be destroyed on the thread which created it.
+class ScopedNonAtomicReferenceCounts final {
+ public:
+  ScopedNonAtomicReferenceCounts() { ++NonAtomicReferenceCountDepth(); }
+
+  ~ScopedNonAtomicReferenceCounts() { --NonAtomicReferenceCountDepth(); }
+
+  ScopedNonAtomicReferenceCounts(const ScopedNonAtomicReferenceCounts&) =
+      delete;
+  ScopedNonAtomicReferenceCounts& operator=(
+      const ScopedNonAtomicReferenceCounts&) = delete;
+};
+
 // `ReferenceCount` is similar to the control block used by `std::shared_ptr`.
 // It is not meant to be interacted with directly in most cases, instead
 // `cel::Shared` should be used.
 class ReferenceCount {
  public:
-  ReferenceCount() = default;
+  ReferenceCount()
+      : weak_refcount_(NonAtomicReferenceCountDepth() == 0
+                           ? 1
+                           : 1 | kNonAtomicFlag) {}
 
   ReferenceCount(const ReferenceCount&) = delete;
   ReferenceCount(ReferenceCount&&) = delete;
@@ -135,15 +183,45 @@ class ReferenceCount {
   friend void WeakUnref(const ReferenceCount& refcount);
   friend bool IsUniqueRef(const ReferenceCount& refcount);
   friend bool IsExpiredRef(const ReferenceCount& refcount);
+  friend void PromoteToAtomicRef(const ReferenceCount& refcount);
+  friend void MakeImmortalRef(const ReferenceCount& refcount);
+  friend void DeleteImmortalRef(const ReferenceCount& refcount);
+  friend bool IsImmortalRef(const ReferenceCount& refcount);
+
+  // How the counts are adjusted is kept in the high bits of the weak count,
+  // so that it costs no space. With neither flag set the counts are atomic.
+  //
+  // The counts are adjusted with plain loads and stores. Only the creating
+  // thread ever sees this flag, see `ScopedNonAtomicReferenceCounts`.
+  static constexpr int32_t kNonAtomicFlag = int32_t{1} << 30;
+  // The counts are no longer adjusted, see `MakeImmortalRef`.
+  static constexpr int32_t kImmortalFlag = int32_t{1} << 29;
+  static constexpr int32_t kFlags = kNonAtomicFlag | kImmortalFlag;
+  static constexpr int32_t kWeakCountMask = kImmortalFlag - 1;
 
   virtual void Finalize() noexcept = 0;
 
   virtual void Delete() noexcept = 0;
 
+  // The flags are only ever changed before the reference count is shared, or
+  // by the only thread using it, so a relaxed load suffices.
+  int32_t flags() const {
+    return weak_refcount_.load(std::memory_order_relaxed) & kFlags;
+  }
+
   mutable std::atomic<int32_t> strong_refcount_ = 1;
-  mutable std::atomic<int32_t> weak_refcount_ = 1;
+  mutable std::atomic<int32_t> weak_refcount_;
 };
 
+// Adds `delta` to `count` with a plain load and store, returning the previous
+// value. Only for counts which are not atomic.
+ABSL_ATTRIBUTE_ALWAYS_INLINE inline int32_t AddToNonAtomicRefCount(
+    std::atomic<int32_t>& count, int32_t delta) {
+  const auto previous = count.load(std::memory_order_relaxed);
+  count.store(previous + delta, std::memory_order_relaxed);
+  return previous;
+}
+
 // `ReferenceCounted` is a base class for classes which should be reference
 // counted. It provides default implementations for `Finalize()` and `Delete()`.
 class ReferenceCounted : public ReferenceCount {
@@ -170,6 +248,27 @@ class InlinedReferenceCount final : public ReferenceCounted {
     return reinterpret_cast<const T*>(&value_[0]);
   }
 
+  // Small reference counted values are served from size class freelists, as
+  // they are created and destroyed at a high rate.
+  static void* operator new(size_t size) {
+    CountAllocation(size);
+    return SmallObjectAllocate(size);
+  }
+
+  static void* operator new(size_t size, std::align_val_t alignment) {
+    CountAllocation(size);
+    return ::operator new(size, alignment);
+  }
+
+  static void operator delete(void* pointer, size_t size) noexcept {
+    SmallObjectDeallocate(pointer, size);
+  }
+
+  static void operator delete(void* pointer, size_t,
+                              std::align_val_t alignment) noexcept {
+    ::operator delete(pointer, alignment);
+  }
+
  private:
   void Finalize() noexcept override { value()->~T(); }
 
@@ -196,8 +295,17 @@ std::pair<absl::Nonnull<T*>, absl::Nonnull<ReferenceCount*>> MakeReferenceCount(
 }
 
 inline void StrongRef(const ReferenceCount& refcount) {
-  const auto count =
-      refcount.strong_refcount_.fetch_add(1, std::memory_order_relaxed);
+  const auto flags = refcount.flags();
+  if (ABSL_PREDICT_TRUE(flags == 0)) {
+    const auto count =
+        refcount.strong_refcount_.fetch_add(1, std::memory_order_relaxed);
+    ABSL_DCHECK_GT(count, 0);
+    return;
+  }
+  if (flags & ReferenceCount::kImmortalFlag) {
+    return;
+  }
+  const auto count = AddToNonAtomicRefCount(refcount.strong_refcount_, 1);
   ABSL_DCHECK_GT(count, 0);
 }
 
@@ -208,8 +316,15 @@ inline void StrongRef(absl::Nullable<const ReferenceCount*> refcount) {
 }
 
 inline void StrongUnref(const ReferenceCount& refcount) {
-  const auto count =
-      refcount.strong_refcount_.fetch_sub(1, std::memory_order_acq_rel);
+  const auto flags = refcount.flags();
+  int32_t count;
+  if (ABSL_PREDICT_TRUE(flags == 0)) {
+    count = refcount.strong_refcount_.fetch_sub(1, std::memory_order_acq_rel);
+  } else if (flags & ReferenceCount::kImmortalFlag) {
+    return;
+  } else {
+    count = AddToNonAtomicRefCount(refcount.strong_refcount_, -1);
+  }
   ABSL_DCHECK_GT(count, 0);
   if (ABSL_PREDICT_FALSE(count == 1)) {
     const_cast<ReferenceCount&>(refcount).Finalize();
@@ -224,7 +339,19 @@ inline void StrongUnref(absl::Nullable<const ReferenceCount*> refcount) {
 }
 
 inline bool StrengthenRef(const ReferenceCount& refcount) {
+  const auto flags = refcount.flags();
+  if (ABSL_PREDICT_FALSE(flags & ReferenceCount::kImmortalFlag)) {
+    return true;
+  }
   auto count = refcount.strong_refcount_.load(std::memory_order_relaxed);
+  if (flags & ReferenceCount::kNonAtomicFlag) {
+    ABSL_DCHECK_GE(count, 0);
+    if (count == 0) {
+      return false;
+    }
+    refcount.strong_refcount_.store(count + 1, std::memory_order_relaxed);
+    return true;
+  }
   while (true) {
     ABSL_DCHECK_GE(count, 0);
     if (count == 0) {
@@ -243,9 +370,16 @@ inline bool StrengthenRef(absl::Nullable<const ReferenceCount*> refcount) {
 }
 
 inline void WeakRef(const ReferenceCount& refcount) {
-  const auto count =
-      refcount.weak_refcount_.fetch_add(1, std::memory_order_relaxed);
-  ABSL_DCHECK_GT(count, 0);
+  const auto flags = refcount.flags();
+  int32_t count;
+  if (ABSL_PREDICT_TRUE(flags == 0)) {
+    count = refcount.weak_refcount_.fetch_add(1, std::memory_order_relaxed);
+  } else if (flags & ReferenceCount::kImmortalFlag) {
+    return;
+  } else {
+    count = AddToNonAtomicRefCount(refcount.weak_refcount_, 1);
+  }
+  ABSL_DCHECK_GT(count & ReferenceCount::kWeakCountMask, 0);
 }
 
 inline void WeakRef(absl::Nullable<const ReferenceCount*> refcount) {
@@ -255,8 +389,16 @@ inline void WeakRef(absl::Nullable<const ReferenceCount*> refcount) {
 }
 
 inline void WeakUnref(const ReferenceCount& refcount) {
-  const auto count =
-      refcount.weak_refcount_.fetch_sub(1, std::memory_order_acq_rel);
+  const auto flags = refcount.flags();
+  int32_t count;
+  if (ABSL_PREDICT_TRUE(flags == 0)) {
+    count = refcount.weak_refcount_.fetch_sub(1, std::memory_order_acq_rel);
+  } else if (flags & ReferenceCount::kImmortalFlag) {
+    return;
+  } else {
+    count = AddToNonAtomicRefCount(refcount.weak_refcount_, -1);
+  }
+  count &= ReferenceCount::kWeakCountMask;
   ABSL_DCHECK_GT(count, 0);
   if (ABSL_PREDICT_FALSE(count == 1)) {
     const_cast<ReferenceCount&>(refcount).Delete();
@@ -270,6 +412,9 @@ inline void WeakUnref(absl::Nullable<const ReferenceCount*> refcount) {
 }
 
 inline bool IsUniqueRef(const ReferenceCount& refcount) {
+  if (IsImmortalRef(refcount)) {
+    return false;
+  }
   const auto count = refcount.strong_refcount_.load(std::memory_order_acquire);
   ABSL_DCHECK_GT(count, 0);
   return count == 1;
@@ -280,6 +425,9 @@ inline bool IsUniqueRef(absl::Nullable<const ReferenceCount*> refcount) {
 }
 
 inline bool IsExpiredRef(const ReferenceCount& refcount) {
+  if (IsImmortalRef(refcount)) {
+    return false;
+  }
   const auto count = refcount.strong_refcount_.load(std::memory_order_acquire);
   ABSL_DCHECK_GE(count, 0);
   return count == 0;
@@ -289,6 +437,98 @@ inline bool IsExpiredRef(absl::Nullable<const ReferenceCount*> refcount) {
   return refcount != nullptr ? IsExpiredRef(*refcount) : false;
 }
 
+// Makes the counts of `refcount` atomic from now on, so that it can be shared
+// with other threads. Must be called by the thread which created `refcount`,
+// before it is shared.
+inline void PromoteToAtomicRef(const ReferenceCount& refcount) {
+  if (refcount.flags() & ReferenceCount::kNonAtomicFlag) {
+    // Only the calling thread uses `refcount`, so a plain store suffices.
+    refcount.weak_refcount_.store(
+        refcount.weak_refcount_.load(std::memory_order_relaxed) &
+            ~ReferenceCount::kNonAtomicFlag,
+        std::memory_order_relaxed);
+  }
+}
+
+inline void PromoteToAtomicRef(
+    absl::Nullable<const ReferenceCount*> refcount) {
+  if (refcount != nullptr) {
+    PromoteToAtomicRef(*refcount);
+  }
+}
+
+// Makes `refcount` immortal: its counts are no longer adjusted, so taking and
+// releasing references to it is as cheap as copying a pointer and no longer
+// writes to memory shared by the threads holding them. Releasing references
+// never deletes it, instead the caller takes over its ownership and must call
+// `DeleteImmortalRef` once no reference to it is used anymore, regardless of
+// whether they were taken before or after this call. `ImmortalRef` does so
+// when it is destroyed.
+//
+// Must be called before `refcount` is shared with other threads, or while
+// they are synchronized with the caller.
+inline void MakeImmortalRef(const ReferenceCount& refcount) {
+  refcount.weak_refcount_.fetch_or(ReferenceCount::kImmortalFlag,
+                                   std::memory_order_relaxed);
+}
+
+// Destroys and deallocates `refcount`, which must have been made immortal by
+// `MakeImmortalRef`.
+inline void DeleteImmortalRef(const ReferenceCount& refcount) {
+  ABSL_DCHECK(IsImmortalRef(refcount));
+  auto& mutable_refcount = const_cast<ReferenceCount&>(refcount);
+  mutable_refcount.Finalize();
+  mutable_refcount.Delete();
+}
+
+inline bool IsImmortalRef(const ReferenceCount& refcount) {
+  return (refcount.flags() & ReferenceCount::kImmortalFlag) != 0;
+}
+
+inline bool IsImmortalRef(absl::Nullable<const ReferenceCount*> refcount) {
+  return refcount != nullptr ? IsImmortalRef(*refcount) : false;
+}
+
+// `ImmortalRef` owns a reference count made immortal by `MakeImmortalRef`,
+// deleting it when destroyed. References to it must not be used past that
+// point, including the references held by values copied while it was owned.
+class ImmortalRef final {
+ public:
+  ImmortalRef() = default;
+
+  // Makes `refcount` immortal and takes over its ownership.
+  explicit ImmortalRef(const ReferenceCount& refcount) : refcount_(&refcount) {
+    MakeImmortalRef(refcount);
+  }
+
+  ImmortalRef(const ImmortalRef&) = delete;
+  ImmortalRef& operator=(const ImmortalRef&) = delete;
+
+  ImmortalRef(ImmortalRef&& other) noexcept
+      : refcount_(std::exchange(other.refcount_, nullptr)) {}
+
+  ImmortalRef& operator=(ImmortalRef&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      refcount_ = std::exchange(other.refcount_, nullptr);
+    }
+    return *this;
+  }
+
+  ~ImmortalRef() { Reset(); }
+
+  absl::Nullable<const ReferenceCount*> get() const { return refcount_; }
+
+ private:
+  void Reset() {
+    if (refcount_ != nullptr) {
+      DeleteImmortalRef(*std::exchange(refcount_, nullptr));
+    }
+  }
+
+  absl::Nullable<const ReferenceCount*> refcount_ = nullptr;
+};
+
 }  // namespace cel::common_internal
 
 #endif  // THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_REFERENCE_COUNT_H_
@@ -14,7 +14,10 @@
 
 #include "common/internal/reference_count.h"
 
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
 #include <tuple>
+#include <utility>
 
 #include "internal/testing.h"
 
@@ -36,6 +39,11 @@ class Subobject : public Object, public virtual ReferenceCountFromThis {
   using Object::Object;
 };
 
+TEST(ReferenceCount, Size) {
+  // How the counts are adjusted is kept in spare bits of the weak count.
+  EXPECT_EQ(sizeof(ReferenceCount), sizeof(void*) + 2 * sizeof(int32_t));
+}
+
 TEST(ReferenceCount, Strong) {
   bool destructed = false;
   Object* object;
@@ -74,5 +82,82 @@ TEST(ReferenceCount, Weak) {
   WeakUnref(refcount);
 }
 
+TEST(ReferenceCount, NonAtomic) {
+  bool destructed = false;
+  Object* object;
+  ReferenceCount* refcount;
+  {
+    ScopedNonAtomicReferenceCounts scope;
+    std::tie(object, refcount) = MakeReferenceCount<Subobject>(destructed);
+  }
+  StrongRef(refcount);
+  EXPECT_FALSE(IsUniqueRef(refcount));
+  StrongUnref(refcount);
+  EXPECT_TRUE(IsUniqueRef(refcount));
+  WeakRef(refcount);
+  StrongUnref(refcount);
+  EXPECT_TRUE(destructed);
+  EXPECT_TRUE(IsExpiredRef(refcount));
+  EXPECT_FALSE(StrengthenRef(refcount));
+  WeakUnref(refcount);
+}
+
+TEST(ReferenceCount, PromoteToAtomic) {
+  bool destructed = false;
+  Object* object;
+  ReferenceCount* refcount;
+  {
+    ScopedNonAtomicReferenceCounts scope;
+    std::tie(object, refcount) = MakeReferenceCount<Subobject>(destructed);
+    PromoteToAtomicRef(refcount);
+  }
+  std::thread thread([refcount]() {
+    for (int i = 0; i < 1000; ++i) {
+      StrongRef(refcount);
+      StrongUnref(refcount);
+    }
+  });
+  for (int i = 0; i < 1000; ++i) {
+    StrongRef(refcount);
+    StrongUnref(refcount);
+  }
+  thread.join();
+  EXPECT_TRUE(IsUniqueRef(refcount));
+  StrongUnref(refcount);
+  EXPECT_TRUE(destructed);
+}
+
+TEST(ReferenceCount, Immortal) {
+  bool destructed = false;
+  Object* object;
+  ReferenceCount* refcount;
+  std::tie(object, refcount) = MakeReferenceCount<Subobject>(destructed);
+  StrongRef(refcount);
+  {
+    ImmortalRef owner(*refcount);
+    EXPECT_TRUE(IsImmortalRef(refcount));
+    EXPECT_FALSE(IsUniqueRef(refcount));
+    EXPECT_FALSE(IsExpiredRef(refcount));
+    std::thread thread([refcount]() {
+      for (int i = 0; i < 1000; ++i) {
+        StrongRef(refcount);
+        StrongUnref(refcount);
+      }
+    });
+    // Releasing more references than were taken doesn't delete it.
+    StrongUnref(refcount);
+    StrongUnref(refcount);
+    WeakRef(refcount);
+    EXPECT_TRUE(StrengthenRef(refcount));
+    thread.join();
+    EXPECT_FALSE(destructed);
+    ImmortalRef moved(std::move(owner));
+    EXPECT_EQ(owner.get(), nullptr);  // NOLINT(bugprone-use-after-move)
+    EXPECT_EQ(moved.get(), refcount);
+    EXPECT_FALSE(destructed);
+  }
+  EXPECT_TRUE(destructed);
+}
+
 }  // namespace
 }  // namespace cel::common_internal
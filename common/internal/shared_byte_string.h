@@ -15,17 +15,19 @@
 #ifndef THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_SHARED_BYTE_STRING_H_
 #define THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_SHARED_BYTE_STRING_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <type_traits>
 #include <utility>
 
 #include "absl/base/attributes.h"
-#include "absl/base/casts.h"
 #include "absl/base/macros.h"
 #include "absl/base/optimization.h"
 #include "absl/functional/overload.h"
+#include "absl/hash/hash.h"
 #include "absl/log/absl_check.h"
 #include "absl/meta/type_traits.h"
 #include "absl/strings/cord.h"
@@ -59,13 +61,29 @@ inline constexpr uintptr_t kByteStringReferenceCountPooledBit = uintptr_t{1}
 struct ABSL_ATTRIBUTE_PACKED SharedByteStringHeader final {
   // True if the content is `absl::Cord`.
   bool is_cord : 1;
+  // True if the content is known to consist solely of 7-bit ASCII, in which
+  // case the number of code points is the number of bytes. False means
+  // unknown, not that the content contains non-ASCII.
+  bool is_ascii : 1;
+  // True if the content was deduplicated by `StringInternPool`, in which case
+  // its hash is stored immediately before the data. Never set when `is_cord`
+  // is `true`.
+  bool is_interned : 1;
+  // True if the content is stored directly in `SharedByteString`, rather than
+  // referenced. Never set when `is_cord` or `is_interned` is `true`, and never
+  // set for `SharedByteStringView`.
+  bool is_inline : 1;
   // Only used when `is_cord` is `false`.
-  size_t size : sizeof(size_t) * 8 - 1;
+  size_t size : sizeof(size_t) * 8 - 4;
 
   SharedByteStringHeader(bool is_cord, size_t size)
-      : is_cord(is_cord), size(size) {
-    // Ensure size does not occupy the most significant bit.
-    ABSL_DCHECK_GE(absl::bit_cast<std::make_signed_t<size_t>>(size), 0);
+      : is_cord(is_cord),
+        is_ascii(false),
+        is_interned(false),
+        is_inline(false),
+        size(size) {
+    // Ensure size does not occupy the four most significant bits.
+    ABSL_DCHECK_EQ(size >> (sizeof(size_t) * 8 - 4), 0);
   }
 };
 
@@ -75,13 +93,57 @@ struct ABSL_ATTRIBUTE_PACKED SharedByteStringHeader final {
 
 static_assert(sizeof(SharedByteStringHeader) == sizeof(size_t));
 
+// The number of bytes `SharedByteString` can store inline, without allocating
+// or referencing storage owned by something else. This is the space otherwise
+// taken by the data pointer and reference count.
+inline constexpr size_t kSharedByteStringInlineCapacity =
+    sizeof(const char*) + sizeof(uintptr_t);
+
+// Returns the hash stored in front of the data of an interned string.
+inline size_t InternedStringHash(const char* data) {
+  size_t hash;
+  std::memcpy(&hash, data - sizeof(size_t), sizeof(size_t));
+  return hash;
+}
+
+// Compares the contents of two flat strings, short-circuiting when they share
+// storage or when both are interned and their hashes differ.
+inline bool FlatByteStringEquals(SharedByteStringHeader lhs_header,
+                                 const char* lhs_data,
+                                 SharedByteStringHeader rhs_header,
+                                 const char* rhs_data) {
+  if (lhs_header.size != rhs_header.size) {
+    return false;
+  }
+  if (lhs_data == rhs_data) {
+    return true;
+  }
+  if (lhs_header.is_interned && rhs_header.is_interned &&
+      InternedStringHash(lhs_data) != InternedStringHash(rhs_data)) {
+    return false;
+  }
+  return absl::string_view(lhs_data, lhs_header.size) ==
+         absl::string_view(rhs_data, rhs_header.size);
+}
+
 class SharedByteString;
+class StringInternPool;
 class ABSL_ATTRIBUTE_TRIVIAL_ABI SharedByteStringView;
 
 // `SharedByteString` is a compact wrapper around either an `absl::Cord` or
-// `absl::string_view` with `const ReferenceCount*`.
+// `absl::string_view` with `const ReferenceCount*`. Contents of at most
+// `kSharedByteStringInlineCapacity` bytes may instead be stored inline.
 class SharedByteString final {
  public:
+  // Returns a `SharedByteString` holding a copy of `string`. The copy is
+  // stored inline if it fits, and in an `absl::Cord` otherwise.
+  static SharedByteString Copy(absl::string_view string) {
+    if (string.size() <= kSharedByteStringInlineCapacity) {
+      return SharedByteString(InlineTag{}, string);
+    }
+    return SharedByteString(absl::Cord(string));
+  }
+
   SharedByteString() noexcept : SharedByteString(absl::string_view()) {}
 
   explicit SharedByteString(absl::string_view string_view) noexcept
@@ -92,7 +154,10 @@ class SharedByteString final {
       : SharedByteString(absl::string_view(string)) {}
 
   explicit SharedByteString(std::string&& string)
-      : SharedByteString(absl::Cord(std::move(string))) {}
+      : SharedByteString(
+            string.size() <= kSharedByteStringInlineCapacity
+                ? SharedByteString(InlineTag{}, string)
+                : SharedByteString(absl::Cord(std::move(string)))) {}
 
   // Constructs a `SharedByteString` whose contents are `string_view` owned by
   // `refcount`. If `refcount` is not nullptr, a strong reference is taken.
@@ -116,6 +181,9 @@ class SharedByteString final {
       : header_(other.header_) {
     if (header_.is_cord) {
       ::new (static_cast<void*>(cord_ptr())) absl::Cord(*other.cord_ptr());
+    } else if (header_.is_inline) {
+      std::memcpy(content_.inline_data, other.content_.inline_data,
+                  kSharedByteStringInlineCapacity);
     } else {
       content_.string.data = other.content_.string.data;
       content_.string.refcount = other.content_.string.refcount;
@@ -130,11 +198,18 @@ class SharedByteString final {
       ::new (static_cast<void*>(cord_ptr()))
           absl::Cord(std::move(*other.cord_ptr()));
     } else {
-      content_.string.data = other.content_.string.data;
-      content_.string.refcount = other.content_.string.refcount;
+      if (header_.is_inline) {
+        std::memcpy(content_.inline_data, other.content_.inline_data,
+                    kSharedByteStringInlineCapacity);
+      } else {
+        content_.string.data = other.content_.string.data;
+        content_.string.refcount = other.content_.string.refcount;
+      }
       other.content_.string.data = "";
       other.content_.string.refcount = 0;
       other.header_.size = 0;
+      other.header_.is_interned = false;
+      other.header_.is_inline = false;
     }
   }
 
@@ -178,8 +253,7 @@ class SharedByteString final {
     if (header_.is_cord) {
       return std::forward<Visitor>(visitor)(*cord_ptr());
     } else {
-      return std::forward<Visitor>(visitor)(
-          absl::string_view(content_.string.data, header_.size));
+      return std::forward<Visitor>(visitor)(flat_string());
     }
   }
 
@@ -237,7 +311,7 @@ class SharedByteString final {
 
   absl::string_view AsStringView() const {
     ABSL_DCHECK(!header_.is_cord);
-    return absl::string_view(content_.string.data, header_.size);
+    return flat_string();
   }
 
   absl::Cord ToCord() const {
@@ -259,10 +333,20 @@ class SharedByteString final {
     if (byte_string.header_.is_cord) {
       return H::combine(std::move(state), *byte_string.cord_ptr());
     } else {
-      return H::combine(std::move(state),
-                        absl::string_view(byte_string.content_.string.data,
-                                          byte_string.header_.size));
+      return H::combine(std::move(state), byte_string.flat_string());
+    }
+  }
+
+  // Returns `absl::HashOf` of the contents, which is the same for flat and
+  // cord contents. Interned strings return the hash computed when they were
+  // interned instead of hashing the contents again.
+  size_t ContentHash() const {
+    if (header_.is_interned) {
+      return InternedStringHash(content_.string.data);
     }
+    return Visit([](const auto& alternative) -> size_t {
+      return absl::HashOf(alternative);
+    });
   }
 
   friend bool operator==(const SharedByteString& lhs,
@@ -271,16 +355,14 @@ class SharedByteString final {
       if (rhs.header_.is_cord) {
         return *lhs.cord_ptr() == *rhs.cord_ptr();
       } else {
-        return *lhs.cord_ptr() ==
-               absl::string_view(rhs.content_.string.data, rhs.header_.size);
+        return *lhs.cord_ptr() == rhs.flat_string();
       }
     } else {
       if (rhs.header_.is_cord) {
-        return absl::string_view(lhs.content_.string.data, lhs.header_.size) ==
-               *rhs.cord_ptr();
+        return lhs.flat_string() == *rhs.cord_ptr();
       } else {
-        return absl::string_view(lhs.content_.string.data, lhs.header_.size) ==
-               absl::string_view(rhs.content_.string.data, rhs.header_.size);
+        return FlatByteStringEquals(lhs.header_, lhs.flat_string().data(),
+                                    rhs.header_, rhs.flat_string().data());
       }
     }
   }
@@ -291,27 +373,96 @@ class SharedByteString final {
       if (rhs.header_.is_cord) {
         return *lhs.cord_ptr() < *rhs.cord_ptr();
       } else {
-        return *lhs.cord_ptr() <
-               absl::string_view(rhs.content_.string.data, rhs.header_.size);
+        return *lhs.cord_ptr() < rhs.flat_string();
       }
     } else {
       if (rhs.header_.is_cord) {
-        return absl::string_view(lhs.content_.string.data, lhs.header_.size) <
-               *rhs.cord_ptr();
+        return lhs.flat_string() < *rhs.cord_ptr();
       } else {
-        return absl::string_view(lhs.content_.string.data, lhs.header_.size) <
-               absl::string_view(rhs.content_.string.data, rhs.header_.size);
+        return lhs.flat_string() < rhs.flat_string();
       }
     }
   }
 
   bool IsPooledString() const {
-    return !header_.is_cord &&
+    return !header_.is_cord && !header_.is_inline &&
            (content_.string.refcount & kByteStringReferenceCountPooledBit) != 0;
   }
 
+  // Returns true if the contents are stored inline, see `Copy`.
+  bool IsInline() const { return header_.is_inline; }
+
+  // Returns true if the contents are known to be entirely 7-bit ASCII. False
+  // does not imply that the contents contain non-ASCII.
+  bool IsAscii() const { return header_.is_ascii; }
+
+  // Records that the contents are entirely 7-bit ASCII. The flag is carried
+  // along by copies and views, so callers must be certain it holds.
+  void SetAscii() noexcept { header_.is_ascii = true; }
+
+  // Returns true if the contents were deduplicated by `StringInternPool`.
+  // Interned strings with the same pool share storage, so comparing them
+  // usually only compares pointers.
+  bool IsInterned() const { return header_.is_interned; }
+
+  // Returns the bytes in `[pos, pos + n)`, clamping `n` to the bytes
+  // available. The result shares storage with this byte string instead of
+  // copying it, taking a strong reference if the storage is reference counted.
+  // Results small enough to be stored inline are copied instead when sharing
+  // would need a cord or a reference count.
+  SharedByteString Substring(size_t pos,
+                             size_t n = absl::string_view::npos) const {
+    if (header_.is_cord) {
+      ABSL_DCHECK_LE(pos, cord_ptr()->size());
+      SharedByteString result(cord_ptr()->Subcord(pos, n));
+      if (result.cord_ptr()->size() <= kSharedByteStringInlineCapacity) {
+        std::string scratch;
+        result = Copy(result.ToString(scratch));
+      }
+      result.header_.is_ascii = header_.is_ascii;
+      return result;
+    }
+    const size_t size = header_.size;
+    ABSL_DCHECK_LE(pos, size);
+    n = std::min(n, size - pos);
+    if (header_.is_inline ||
+        (n <= kSharedByteStringInlineCapacity && IsReferenceCountedString())) {
+      SharedByteString result(InlineTag{}, flat_string().substr(pos, n));
+      result.header_.is_ascii = header_.is_ascii;
+      return result;
+    }
+    SharedByteString result(*this);
+    result.header_.is_interned = false;
+    result.content_.string.data += pos;
+    result.header_.size = n;
+    return result;
+  }
+
  private:
   friend class SharedByteStringView;
+  friend class StringInternPool;
+
+  struct InlineTag {};
+  struct InternedTag {};
+
+  // Constructs a string storing a copy of `string_view` inline.
+  SharedByteString(InlineTag, absl::string_view string_view) noexcept
+      : header_(false, string_view.size()) {
+    ABSL_DCHECK_LE(string_view.size(), kSharedByteStringInlineCapacity);
+    header_.is_inline = true;
+    if (!string_view.empty()) {
+      std::memcpy(content_.inline_data, string_view.data(),
+                  string_view.size());
+    }
+  }
+
+  // Constructs an interned string owned by `refcount`, whose hash is stored
+  // immediately before `string_view`, taking a strong reference.
+  SharedByteString(InternedTag, const ReferenceCount* refcount,
+                   absl::string_view string_view) noexcept
+      : SharedByteString(refcount, string_view) {
+    header_.is_interned = true;
+  }
 
   static void SwapMixed(SharedByteString& cord,
                         SharedByteString& string) noexcept {
@@ -326,7 +477,7 @@ class SharedByteString final {
 
   bool IsManagedString() const {
     ABSL_ASSERT(!header_.is_cord);
-    return content_.string.refcount != 0;
+    return !header_.is_inline && content_.string.refcount != 0;
   }
 
   bool IsReferenceCountedString() const {
@@ -339,6 +490,13 @@ class SharedByteString final {
     return reinterpret_cast<const ReferenceCount*>(content_.string.refcount);
   }
 
+  absl::string_view flat_string() const noexcept {
+    ABSL_ASSERT(!header_.is_cord);
+    return absl::string_view(
+        header_.is_inline ? content_.inline_data : content_.string.data,
+        header_.size);
+  }
+
   absl::Cord* cord_ptr() noexcept {
     return reinterpret_cast<absl::Cord*>(&content_.cord[0]);
   }
@@ -353,6 +511,7 @@ class SharedByteString final {
       const char* data;
       uintptr_t refcount;
     } string;
+    char inline_data[kSharedByteStringInlineCapacity];
     alignas(absl::Cord) char cord[sizeof(absl::Cord)];
   } content_;
 };
@@ -396,6 +555,12 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI SharedByteStringView final {
       : header_(other.header_) {
     if (header_.is_cord) {
       content_.cord = other.cord_ptr();
+    } else if (header_.is_inline) {
+      // Views do not store contents inline, they reference the contents of
+      // `other` instead.
+      header_.is_inline = false;
+      content_.string.data = other.content_.inline_data;
+      content_.string.refcount = 0;
     } else {
       content_.string.data = other.content_.string.data;
       content_.string.refcount = other.content_.string.refcount;
@@ -486,6 +651,16 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI SharedByteStringView final {
     }
   }
 
+  // See `SharedByteString::ContentHash`.
+  size_t ContentHash() const {
+    if (header_.is_interned) {
+      return InternedStringHash(content_.string.data);
+    }
+    return Visit([](const auto& alternative) -> size_t {
+      return absl::HashOf(alternative);
+    });
+  }
+
   friend bool operator==(SharedByteStringView lhs, SharedByteStringView rhs) {
     if (lhs.header_.is_cord) {
       if (rhs.header_.is_cord) {
@@ -499,8 +674,8 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI SharedByteStringView final {
         return absl::string_view(lhs.content_.string.data, lhs.header_.size) ==
                *rhs.content_.cord;
       } else {
-        return absl::string_view(lhs.content_.string.data, lhs.header_.size) ==
-               absl::string_view(rhs.content_.string.data, rhs.header_.size);
+        return FlatByteStringEquals(lhs.header_, lhs.content_.string.data,
+                                    rhs.header_, rhs.content_.string.data);
       }
     }
   }
@@ -529,6 +704,12 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI SharedByteStringView final {
            (content_.string.refcount & kByteStringReferenceCountPooledBit) != 0;
   }
 
+  // See `SharedByteString::IsAscii`.
+  bool IsAscii() const { return header_.is_ascii; }
+
+  // See `SharedByteString::IsInterned`.
+  bool IsInterned() const { return header_.is_interned; }
+
  private:
   friend class SharedByteString;
 
@@ -568,8 +749,19 @@ inline SharedByteString::SharedByteString(SharedByteStringView other) noexcept
   } else {
     if (other.content_.string.refcount == 0) {
       // Unfortunately since we cannot guarantee lifetimes when using arenas or
-      // without a reference count, we are forced to transform this into a cord.
+      // without a reference count, we are forced to copy the contents, either
+      // inline when they fit or into a cord.
+      if (other.header_.size <= kSharedByteStringInlineCapacity) {
+        header_.is_interned = false;
+        header_.is_inline = true;
+        if (other.header_.size != 0) {
+          std::memcpy(content_.inline_data, other.content_.string.data,
+                      other.header_.size);
+        }
+        return;
+      }
       header_.is_cord = true;
+      header_.is_interned = false;
       header_.size = 0;
       ::new (static_cast<void*>(cord_ptr())) absl::Cord(
           absl::string_view(other.content_.string.data, other.header_.size));
@@ -361,5 +361,100 @@ TEST(SharedByteStringView, SharedByteString) {
   EXPECT_THAT(SharedByteString(byte_string3).ToString(), Eq("baz"));
 }
 
+TEST(SharedByteString, Ascii) {
+  SharedByteString byte_string1(absl::string_view("foo"));
+  SharedByteString byte_string2(absl::Cord("bar"));
+  EXPECT_FALSE(byte_string1.IsAscii());
+  EXPECT_FALSE(byte_string2.IsAscii());
+  byte_string1.SetAscii();
+  byte_string2.SetAscii();
+  EXPECT_TRUE(byte_string1.IsAscii());
+  EXPECT_TRUE(byte_string2.IsAscii());
+  EXPECT_TRUE(SharedByteString(byte_string1).IsAscii());
+  EXPECT_TRUE(SharedByteStringView(byte_string2).IsAscii());
+  EXPECT_FALSE(
+      SharedByteString(SharedByteStringView(absl::string_view("baz")))
+          .IsAscii());
+  // The flag does not participate in equality.
+  EXPECT_EQ(byte_string1, SharedByteString(absl::string_view("foo")));
+  using std::swap;
+  swap(byte_string1, byte_string2);
+  EXPECT_EQ(byte_string1.ToString(), "bar");
+  EXPECT_TRUE(byte_string1.IsAscii());
+}
+
+TEST(SharedByteString, Substring) {
+  auto* const owner = new OwningObject("foo,bar,baz,0123456789abcdefghij");
+  {
+    SharedByteString byte_string(owner, owner->owned_string());
+    SharedByteString substring = byte_string.Substring(12, 20);
+    EXPECT_EQ(substring.ToString(), "0123456789abcdefghij");
+    EXPECT_FALSE(substring.IsInline());
+    EXPECT_EQ(substring.AsStringView().data(),
+              owner->owned_string().data() + 12);
+    // Small substrings are copied inline rather than referencing `owner`.
+    substring = byte_string.Substring(4, 3);
+    EXPECT_EQ(substring.ToString(), "bar");
+    EXPECT_TRUE(substring.IsInline());
+    EXPECT_EQ(byte_string.Substring(8, 3).ToString(), "baz");
+    EXPECT_EQ(byte_string.Substring(22, 100).ToString(), "abcdefghij");
+    EXPECT_EQ(byte_string.Substring(32).ToString(), "");
+  }
+  StrongUnref(owner);
+
+  SharedByteString cord(absl::Cord("foo,bar,baz"));
+  cord.SetAscii();
+  SharedByteString substring = cord.Substring(4, 3);
+  EXPECT_EQ(substring.ToString(), "bar");
+  EXPECT_TRUE(substring.IsAscii());
+  EXPECT_EQ(cord.Substring(8).ToString(), "baz");
+}
+
+TEST(SharedByteString, Inline) {
+  SharedByteString byte_string = SharedByteString::Copy("foo");
+  EXPECT_TRUE(byte_string.IsInline());
+  EXPECT_FALSE(byte_string.IsPooledString());
+  EXPECT_EQ(byte_string.ToString(), "foo");
+  EXPECT_EQ(byte_string.ToCord(), "foo");
+  EXPECT_EQ(byte_string, SharedByteString(absl::Cord("foo")));
+  EXPECT_EQ(absl::HashOf(byte_string), absl::HashOf(absl::string_view("foo")));
+
+  std::string large(kSharedByteStringInlineCapacity + 1, 'a');
+  EXPECT_FALSE(SharedByteString::Copy(large).IsInline());
+  EXPECT_TRUE(SharedByteString(std::string("bar")).IsInline());
+  EXPECT_FALSE(SharedByteString(std::string(large)).IsInline());
+
+  SharedByteString copy(byte_string);
+  EXPECT_TRUE(copy.IsInline());
+  EXPECT_EQ(copy.ToString(), "foo");
+  EXPECT_NE(copy.AsStringView().data(), byte_string.AsStringView().data());
+  SharedByteString moved(std::move(copy));
+  EXPECT_EQ(moved.ToString(), "foo");
+
+  SharedByteString other(absl::Cord("bar"));
+  swap(moved, other);
+  EXPECT_EQ(moved.ToString(), "bar");
+  EXPECT_EQ(other.ToString(), "foo");
+  EXPECT_TRUE(other.IsInline());
+
+  EXPECT_EQ(byte_string.Substring(1).ToString(), "oo");
+  EXPECT_TRUE(byte_string.Substring(1).IsInline());
+}
+
+TEST(SharedByteString, InlineView) {
+  SharedByteString byte_string = SharedByteString::Copy("foo");
+  SharedByteStringView view(byte_string);
+  EXPECT_EQ(view.ToString(), "foo");
+  EXPECT_EQ(view.AsStringView().data(), byte_string.AsStringView().data());
+  EXPECT_EQ(view, SharedByteStringView(absl::string_view("foo")));
+
+  // Converting an unowned view copies small contents inline.
+  SharedByteString copy(view);
+  EXPECT_TRUE(copy.IsInline());
+  EXPECT_EQ(copy.ToString(), "foo");
+  SharedByteString unowned(SharedByteStringView(absl::string_view("bar")));
+  EXPECT_TRUE(unowned.IsInline());
+}
+
 }  // namespace
 }  // namespace cel::common_internal
@@ -0,0 +1,213 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/internal/small_object_allocator.h"
+
+#include <cstddef>
+#include <new>
+
+#include "absl/base/attributes.h"
+#include "absl/base/config.h"
+#include "absl/base/no_destructor.h"
+#include "absl/base/nullability.h"
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace cel::common_internal {
+
+namespace {
+
+constexpr size_t kSizeClassGranularity = 16;
+constexpr size_t kSizeClassCount = kSmallObjectMaxSize / kSizeClassGranularity;
+// The number of blocks moved between a magazine and the shared freelist at a
+// time. A magazine holds up to two batches.
+constexpr size_t kBatchSize = 32;
+constexpr size_t kMagazineCapacity = 2 * kBatchSize;
+// The number of blocks the shared freelist keeps per size class, beyond which
+// blocks are returned to `::operator delete`.
+constexpr size_t kSharedCapacity = 64 * kBatchSize;
+
+static_assert(kSmallObjectMaxSize % kSizeClassGranularity == 0);
+static_assert(kSmallObjectMaxAlignment >= alignof(void*));
+
+size_t SizeClass(size_t size) {
+  return (size + kSizeClassGranularity - 1) / kSizeClassGranularity - 1;
+}
+
+size_t SizeClassBytes(size_t size_class) {
+  return (size_class + 1) * kSizeClassGranularity;
+}
+
+// Freed blocks form intrusive singly linked lists.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeList {
+  FreeBlock* head = nullptr;
+  size_t size = 0;
+
+  void Push(absl::Nonnull<FreeBlock*> block) {
+    block->next = head;
+    head = block;
+    ++size;
+  }
+
+  absl::Nonnull<FreeBlock*> Pop() {
+    FreeBlock* block = head;
+    head = block->next;
+    --size;
+    return block;
+  }
+
+  // Moves up to `count` blocks from the front of this list to `other`.
+  void MoveTo(FreeList& other, size_t count) {
+    while (count-- > 0 && head != nullptr) {
+      other.Push(Pop());
+    }
+  }
+};
+
+void FreeAll(FreeList& list, size_t size_class) {
+  while (list.head != nullptr) {
+#if defined(__cpp_sized_deallocation) && __cpp_sized_deallocation >= 201309L
+    ::operator delete(list.Pop(), SizeClassBytes(size_class));
+#else
+    ::operator delete(list.Pop());
+#endif
+  }
+}
+
+class SharedFreeLists final {
+ public:
+  // Moves a batch of blocks of `size_class` to `magazine`.
+  void Refill(size_t size_class, FreeList& magazine) {
+    absl::MutexLock lock(&mutex_);
+    lists_[size_class].MoveTo(magazine, kBatchSize);
+  }
+
+  // Takes the blocks of `magazine` beyond `keep`, freeing those which do not
+  // fit.
+  void Drain(size_t size_class, FreeList& magazine, size_t keep) {
+    FreeList overflow;
+    {
+      absl::MutexLock lock(&mutex_);
+      FreeList& list = lists_[size_class];
+      size_t count = magazine.size - keep;
+      size_t accepted =
+          list.size < kSharedCapacity ? kSharedCapacity - list.size : 0;
+      magazine.MoveTo(list, count < accepted ? count : accepted);
+      if (magazine.size > keep) {
+        magazine.MoveTo(overflow, magazine.size - keep);
+      }
+    }
+    FreeAll(overflow, size_class);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  FreeList lists_[kSizeClassCount] ABSL_GUARDED_BY(mutex_);
+};
+
+SharedFreeLists& GetSharedFreeLists() {
+  static absl::NoDestructor<SharedFreeLists> instance;
+  return *instance;
+}
+
+class Magazines final {
+ public:
+  ~Magazines();
+
+  absl::Nonnull<void*> Allocate(size_t size_class) {
+    FreeList& magazine = magazines_[size_class];
+    if (magazine.head == nullptr) {
+      GetSharedFreeLists().Refill(size_class, magazine);
+      if (magazine.head == nullptr) {
+        return ::operator new(SizeClassBytes(size_class));
+      }
+    }
+    return magazine.Pop();
+  }
+
+  void Deallocate(absl::Nonnull<void*> pointer, size_t size_class) {
+    FreeList& magazine = magazines_[size_class];
+    magazine.Push(static_cast<FreeBlock*>(pointer));
+    if (magazine.size > kMagazineCapacity) {
+      GetSharedFreeLists().Drain(size_class, magazine, kBatchSize);
+    }
+  }
+
+ private:
+  FreeList magazines_[kSizeClassCount];
+};
+
+// Trivially destructible, so that it can be read while the magazines of an
+// exiting thread are being destroyed.
+ABSL_CONST_INIT thread_local bool magazines_destroyed = false;
+
+Magazines::~Magazines() {
+  magazines_destroyed = true;
+  for (size_t size_class = 0; size_class < kSizeClassCount; ++size_class) {
+    GetSharedFreeLists().Drain(size_class, magazines_[size_class], 0);
+  }
+}
+
+absl::Nullable<Magazines*> GetMagazines() {
+#ifdef ABSL_HAVE_ADDRESS_SANITIZER
+  return nullptr;
+#else
+  if (ABSL_PREDICT_FALSE(magazines_destroyed)) {
+    return nullptr;
+  }
+  thread_local Magazines magazines;
+  return &magazines;
+#endif
+}
+
+}  // namespace
+
+absl::Nonnull<void*> SmallObjectAllocate(size_t size) {
+  if (size == 0 || size > kSmallObjectMaxSize) {
+    return ::operator new(size);
+  }
+  size_t size_class = SizeClass(size);
+  if (Magazines* magazines = GetMagazines(); magazines != nullptr) {
+    return magazines->Allocate(size_class);
+  }
+  return ::operator new(SizeClassBytes(size_class));
+}
+
+void SmallObjectDeallocate(absl::Nonnull<void*> pointer, size_t size) noexcept {
+  if (size == 0 || size > kSmallObjectMaxSize) {
+#if defined(__cpp_sized_deallocation) && __cpp_sized_deallocation >= 201309L
+    ::operator delete(pointer, size);
+#else
+    ::operator delete(pointer);
+#endif
+    return;
+  }
+  size_t size_class = SizeClass(size);
+  if (Magazines* magazines = GetMagazines(); magazines != nullptr) {
+    magazines->Deallocate(pointer, size_class);
+    return;
+  }
+#if defined(__cpp_sized_deallocation) && __cpp_sized_deallocation >= 201309L
+  ::operator delete(pointer, SizeClassBytes(size_class));
+#else
+  ::operator delete(pointer);
+#endif
+}
+
+}  // namespace cel::common_internal
@@ -0,0 +1,46 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_SMALL_OBJECT_ALLOCATOR_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_SMALL_OBJECT_ALLOCATOR_H_
+
+#include <cstddef>
+
+#include "absl/base/nullability.h"
+
+namespace cel::common_internal {
+
+// The largest size and alignment served from the size class freelists. Larger
+// requests go to `::operator new`.
+inline constexpr size_t kSmallObjectMaxSize = 256;
+inline constexpr size_t kSmallObjectMaxAlignment =
+    __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+// Allocates `size` bytes aligned to `__STDCPP_DEFAULT_NEW_ALIGNMENT__`, for
+// reference counted objects which are created and destroyed at a high rate.
+//
+// Freed blocks are cached in per-thread magazines of fixed size classes, which
+// exchange batches with a shared freelist when they run empty or full. Blocks
+// may be freed on a different thread than the one which allocated them.
+//
+// The caches are disabled under AddressSanitizer, so that use-after-free of
+// reference counted objects is still reported.
+absl::Nonnull<void*> SmallObjectAllocate(size_t size);
+
+// Frees a block returned by `SmallObjectAllocate(size)`.
+void SmallObjectDeallocate(absl::Nonnull<void*> pointer, size_t size) noexcept;
+
+}  // namespace cel::common_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_SMALL_OBJECT_ALLOCATOR_H_
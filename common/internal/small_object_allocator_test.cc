@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/internal/small_object_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/config.h"
+#include "internal/testing.h"
+
+namespace cel::common_internal {
+namespace {
+
+using testing::NotNull;
+
+TEST(SmallObjectAllocator, Alignment) {
+  for (size_t size : {1, 8, 16, 17, 100, 256, 257, 4096}) {
+    void* pointer = SmallObjectAllocate(size);
+    ASSERT_THAT(pointer, NotNull());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(pointer) % kSmallObjectMaxAlignment,
+              0)
+        << size;
+    std::memset(pointer, 0xff, size);
+    SmallObjectDeallocate(pointer, size);
+  }
+}
+
+#ifndef ABSL_HAVE_ADDRESS_SANITIZER
+TEST(SmallObjectAllocator, ReusesFreedBlocks) {
+  void* pointer = SmallObjectAllocate(40);
+  SmallObjectDeallocate(pointer, 40);
+  // Sizes in the same class share blocks.
+  void* reused = SmallObjectAllocate(48);
+  EXPECT_EQ(reused, pointer);
+  SmallObjectDeallocate(reused, 48);
+}
+#endif
+
+TEST(SmallObjectAllocator, FreesAcrossThreads) {
+  constexpr int kBlocks = 1000;
+  std::vector<void*> blocks;
+  std::thread producer([&blocks]() {
+    for (int i = 0; i < kBlocks; ++i) {
+      void* pointer = SmallObjectAllocate(64);
+      std::memset(pointer, i & 0xff, 64);
+      blocks.push_back(pointer);
+    }
+  });
+  producer.join();
+
+  std::thread consumer([&blocks]() {
+    for (void* pointer : blocks) {
+      SmallObjectDeallocate(pointer, 64);
+    }
+  });
+  consumer.join();
+
+  // The blocks drained from the exited threads are usable again.
+  std::vector<void*> reallocated;
+  for (int i = 0; i < kBlocks; ++i) {
+    reallocated.push_back(SmallObjectAllocate(64));
+    std::memset(reallocated.back(), 0, 64);
+  }
+  for (void* pointer : reallocated) {
+    SmallObjectDeallocate(pointer, 64);
+  }
+}
+
+}  // namespace
+}  // namespace cel::common_internal
@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/internal/string_intern_pool.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "common/internal/reference_count.h"
+#include "common/internal/shared_byte_string.h"
+
+namespace cel::common_internal {
+
+// Owns the interned bytes. Each string is stored in its own buffer,
+// immediately after its hash, so that its address is stable.
+class StringInternPool::Storage final : public ReferenceCounted {
+ public:
+  absl::string_view Intern(absl::string_view string) {
+    if (auto it = strings_.find(string); it != strings_.end()) {
+      return *it;
+    }
+    const size_t hash = absl::HashOf(string);
+    auto buffer = std::make_unique<char[]>(sizeof(size_t) + string.size());
+    std::memcpy(buffer.get(), &hash, sizeof(size_t));
+    char* data = buffer.get() + sizeof(size_t);
+    if (!string.empty()) {
+      std::memcpy(data, string.data(), string.size());
+    }
+    buffers_.push_back(std::move(buffer));
+    return *strings_.insert(absl::string_view(data, string.size())).first;
+  }
+
+  size_t size() const { return strings_.size(); }
+
+ private:
+  absl::flat_hash_set<absl::string_view> strings_;
+  std::vector<std::unique_ptr<char[]>> buffers_;
+};
+
+StringInternPool::StringInternPool() : storage_(new Storage()) {}
+
+StringInternPool::StringInternPool(ThreadSafe)
+    : storage_(new Storage()), mutex_(std::make_unique<absl::Mutex>()) {}
+
+StringInternPool::~StringInternPool() { StrongUnref(*storage_); }
+
+SharedByteString StringInternPool::Intern(absl::string_view string) {
+  if (mutex_ != nullptr) {
+    absl::MutexLock lock(mutex_.get());
+    return SharedByteString(SharedByteString::InternedTag{}, storage_,
+                            storage_->Intern(string));
+  }
+  return SharedByteString(SharedByteString::InternedTag{}, storage_,
+                          storage_->Intern(string));
+}
+
+size_t StringInternPool::size() const {
+  if (mutex_ != nullptr) {
+    absl::MutexLock lock(mutex_.get());
+    return storage_->size();
+  }
+  return storage_->size();
+}
+
+ImmortalRef StringInternPool::MakeImmortal() {
+  ABSL_DCHECK(mutex_ == nullptr);
+  ABSL_DCHECK(!IsImmortalRef(*storage_));
+  return ImmortalRef(*storage_);
+}
+
+}  // namespace cel::common_internal
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_STRING_INTERN_POOL_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_STRING_INTERN_POOL_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "absl/base/nullability.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "common/internal/reference_count.h"
+#include "common/internal/shared_byte_string.h"
+
+namespace cel::common_internal {
+
+// `StringInternPool` deduplicates the strings of a program while it is
+// planned, so that every occurrence of a string constant shares one copy of
+// its bytes along with their hash. Equal strings interned by the same pool
+// compare equal by pointer, and hashing them reads the stored hash.
+//
+// The storage is reference counted: the returned strings keep it alive, so
+// they may outlive the pool. Interning is not thread-safe unless the pool is
+// created with `ThreadSafe`, the returned strings are.
+class StringInternPool final {
+ public:
+  // Tag for pools shared by concurrent callers, such as the planning calls of
+  // every program of a runtime.
+  struct ThreadSafe {};
+
+  StringInternPool();
+  explicit StringInternPool(ThreadSafe);
+
+  StringInternPool(const StringInternPool&) = delete;
+  StringInternPool& operator=(const StringInternPool&) = delete;
+
+  ~StringInternPool();
+
+  // Returns the interned copy of `string`, copying it into the pool if this is
+  // its first occurrence.
+  SharedByteString Intern(absl::string_view string);
+
+  // Number of distinct strings interned.
+  size_t size() const;
+
+  // Makes the storage of the interned strings immortal (see
+  // `MakeImmortalRef`), so that copying them no longer adjusts a reference
+  // count shared by every string of the pool. The storage is then deleted by
+  // the returned owner, and the strings must not be used once it is gone.
+  //
+  // Not supported by thread-safe pools.
+  ImmortalRef MakeImmortal();
+
+ private:
+  class Storage;
+
+  absl::Nonnull<Storage*> storage_;
+  // Only set for thread-safe pools.
+  std::unique_ptr<absl::Mutex> mutex_;
+};
+
+}  // namespace cel::common_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_INTERNAL_STRING_INTERN_POOL_H_
@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/internal/string_intern_pool.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/internal/reference_count.h"
+#include "common/internal/shared_byte_string.h"
+#include "internal/testing.h"
+
+namespace cel::common_internal {
+namespace {
+
+TEST(StringInternPool, Deduplicates) {
+  StringInternPool pool;
+  SharedByteString foo1 = pool.Intern("foo");
+  SharedByteString foo2 = pool.Intern(std::string("foo"));
+  SharedByteString bar = pool.Intern("bar");
+  EXPECT_EQ(pool.size(), 2);
+  EXPECT_TRUE(foo1.IsInterned());
+  EXPECT_EQ(foo1.AsStringView().data(), foo2.AsStringView().data());
+  EXPECT_EQ(foo1, foo2);
+  EXPECT_NE(foo1, bar);
+  EXPECT_EQ(foo1.ToString(), "foo");
+  EXPECT_EQ(pool.Intern("").ToString(), "");
+}
+
+TEST(StringInternPool, ComparesWithUninterned) {
+  StringInternPool pool;
+  SharedByteString foo = pool.Intern("foo");
+  EXPECT_EQ(foo, SharedByteString(absl::string_view("foo")));
+  EXPECT_EQ(foo, SharedByteString(absl::Cord("foo")));
+  EXPECT_NE(foo, SharedByteString(absl::string_view("fob")));
+  EXPECT_EQ(SharedByteStringView(foo),
+            SharedByteStringView(absl::string_view("foo")));
+}
+
+TEST(StringInternPool, ComparesAcrossPools) {
+  StringInternPool pool1;
+  StringInternPool pool2;
+  EXPECT_EQ(pool1.Intern("foo"), pool2.Intern("foo"));
+  EXPECT_NE(pool1.Intern("foo"), pool2.Intern("bar"));
+}
+
+TEST(StringInternPool, ContentHash) {
+  StringInternPool pool;
+  SharedByteString foo = pool.Intern("foo");
+  EXPECT_EQ(foo.ContentHash(),
+            SharedByteString(absl::string_view("foo")).ContentHash());
+  EXPECT_EQ(foo.ContentHash(),
+            SharedByteString(absl::Cord("foo")).ContentHash());
+  EXPECT_EQ(SharedByteStringView(foo).ContentHash(), foo.ContentHash());
+  EXPECT_EQ(absl::HashOf(foo), absl::HashOf(absl::string_view("foo")));
+}
+
+TEST(StringInternPool, Substring) {
+  StringInternPool pool;
+  SharedByteString substring = pool.Intern("foobar").Substring(3);
+  EXPECT_FALSE(substring.IsInterned());
+  EXPECT_EQ(substring, pool.Intern("bar"));
+  EXPECT_EQ(substring.ContentHash(),
+            SharedByteString(absl::string_view("bar")).ContentHash());
+}
+
+TEST(StringInternPool, MoveClearsInterned) {
+  StringInternPool pool;
+  SharedByteString foo = pool.Intern("foo");
+  SharedByteString moved(std::move(foo));
+  EXPECT_TRUE(moved.IsInterned());
+  EXPECT_FALSE(foo.IsInterned());  // NOLINT(bugprone-use-after-move)
+}
+
+TEST(StringInternPool, StringsOutlivePool) {
+  SharedByteString foo;
+  {
+    auto pool = std::make_unique<StringInternPool>();
+    foo = pool->Intern("foo");
+  }
+  EXPECT_EQ(foo.ToString(), "foo");
+  EXPECT_EQ(foo.ContentHash(),
+            SharedByteString(absl::string_view("foo")).ContentHash());
+}
+
+TEST(StringInternPool, MakeImmortal) {
+  // Declared before the strings, which must not be used once it is gone.
+  ImmortalRef owner;
+  SharedByteString foo;
+  {
+    auto pool = std::make_unique<StringInternPool>();
+    foo = pool->Intern("foo");
+    owner = pool->MakeImmortal();
+    EXPECT_TRUE(IsImmortalRef(owner.get()));
+    SharedByteString copy = foo;
+    EXPECT_EQ(copy, pool->Intern("foo"));
+  }
+  EXPECT_EQ(foo.ToString(), "foo");
+  SharedByteString copy = foo;
+  EXPECT_EQ(copy, foo);
+}
+
+TEST(StringInternPool, ThreadSafe) {
+  StringInternPool pool{StringInternPool::ThreadSafe{}};
+  std::vector<std::thread> threads;
+  std::vector<std::vector<SharedByteString>> interned(4);
+  for (auto& strings : interned) {
+    threads.emplace_back([&pool, &strings]() {
+      for (int i = 0; i < 100; ++i) {
+        strings.push_back(pool.Intern(absl::StrCat("string", i % 10)));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(pool.size(), 10);
+  for (const auto& strings : interned) {
+    ASSERT_EQ(strings.size(), 100);
+    EXPECT_TRUE(strings[0].IsInterned());
+    EXPECT_EQ(strings[42].ToString(), "string2");
+  }
+}
+
+}  // namespace
+}  // namespace cel::common_internal
@@ -0,0 +1,835 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/json_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/overload.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "absl/types/variant.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "internal/status_macros.h"
+#include "internal/utf8.h"
+
+namespace cel {
+
+namespace {
+
+// Recursive descent parser which reports what it encounters to a handler, in
+// the style of SAX, rather than building a document itself. A handler
+// provides:
+//
+//   absl::Status Null();
+//   absl::Status Bool(bool value);
+//   absl::Status Number(double value);
+//   absl::Status String(std::string value);
+//   absl::Status BeginObject();
+//   absl::Status Key(std::string key);
+//   absl::Status EndObject();
+//   absl::Status BeginArray();
+//   absl::Status EndArray();
+//
+//   // Whether the array or object starting at `depth` should be validated
+//   // and passed to `Deferred` as text, instead of being reported piecewise.
+//   bool Defer(int depth) const;
+//   absl::Status Deferred(bool object, absl::string_view text, size_t size,
+//                         int depth);
+class JsonParser final {
+ public:
+  JsonParser(absl::string_view text, int max_depth)
+      : text_(text), max_depth_(max_depth) {}
+
+  template <typename Handler>
+  absl::Status Parse(Handler& handler) {
+    CEL_RETURN_IF_ERROR(ParseValue(handler, 0));
+    SkipWhitespace();
+    if (pos_ != text_.size()) {
+      return Error("unexpected trailing characters");
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  // Counts the direct members of a single deferred array or object.
+  class MemberCounter final {
+   public:
+    absl::Status Null() { return Count(); }
+    absl::Status Bool(bool) { return Count(); }
+    absl::Status Number(double) { return Count(); }
+    absl::Status String(std::string) { return Count(); }
+    absl::Status BeginObject() { return Begin(); }
+    absl::Status Key(std::string) { return absl::OkStatus(); }
+    absl::Status EndObject() { return End(); }
+    absl::Status BeginArray() { return Begin(); }
+    absl::Status EndArray() { return End(); }
+
+    bool Defer(int) const { return false; }
+
+    absl::Status Deferred(bool, absl::string_view, size_t, int) {
+      return absl::InternalError("unexpected deferred JSON value");
+    }
+
+    size_t size() const { return size_; }
+
+   private:
+    absl::Status Count() {
+      if (depth_ == 1) {
+        ++size_;
+      }
+      return absl::OkStatus();
+    }
+
+    absl::Status Begin() {
+      CEL_RETURN_IF_ERROR(Count());
+      ++depth_;
+      return absl::OkStatus();
+    }
+
+    absl::Status End() {
+      --depth_;
+      return absl::OkStatus();
+    }
+
+    int depth_ = 0;
+    size_t size_ = 0;
+  };
+
+  template <typename Handler>
+  absl::Status ParseValue(Handler& handler, int depth) {
+    SkipWhitespace();
+    if (pos_ == text_.size()) {
+      return Error("unexpected end of input");
+    }
+    switch (text_[pos_]) {
+      case 'n':
+        CEL_RETURN_IF_ERROR(ParseLiteral("null"));
+        return handler.Null();
+      case 't':
+        CEL_RETURN_IF_ERROR(ParseLiteral("true"));
+        return handler.Bool(true);
+      case 'f':
+        CEL_RETURN_IF_ERROR(ParseLiteral("false"));
+        return handler.Bool(false);
+      case '"': {
+        std::string value;
+        CEL_RETURN_IF_ERROR(ParseString(value));
+        return handler.String(std::move(value));
+      }
+      case '{':
+      case '[':
+        return ParseContainer(handler, depth);
+      default: {
+        double value;
+        CEL_RETURN_IF_ERROR(ParseNumber(value));
+        return handler.Number(value);
+      }
+    }
+  }
+
+  template <typename Handler>
+  absl::Status ParseContainer(Handler& handler, int depth) {
+    if (depth >= max_depth_) {
+      return Error("exceeds the maximum nesting depth");
+    }
+    const bool object = text_[pos_] == '{';
+    if (handler.Defer(depth)) {
+      const size_t begin = pos_;
+      MemberCounter counter;
+      CEL_RETURN_IF_ERROR(object ? ParseObject(counter, depth)
+                                 : ParseArray(counter, depth));
+      return handler.Deferred(object, text_.substr(begin, pos_ - begin),
+                              counter.size(), depth);
+    }
+    return object ? ParseObject(handler, depth) : ParseArray(handler, depth);
+  }
+
+  template <typename Handler>
+  absl::Status ParseObject(Handler& handler, int depth) {
+    ++pos_;
+    CEL_RETURN_IF_ERROR(handler.BeginObject());
+    SkipWhitespace();
+    if (Consume('}')) {
+      return handler.EndObject();
+    }
+    while (true) {
+      SkipWhitespace();
+      if (pos_ == text_.size() || text_[pos_] != '"') {
+        return Error("expected object key");
+      }
+      std::string key;
+      CEL_RETURN_IF_ERROR(ParseString(key));
+      CEL_RETURN_IF_ERROR(handler.Key(std::move(key)));
+      SkipWhitespace();
+      if (!Consume(':')) {
+        return Error("expected ':'");
+      }
+      CEL_RETURN_IF_ERROR(ParseValue(handler, depth + 1));
+      SkipWhitespace();
+      if (Consume(',')) {
+        continue;
+      }
+      if (Consume('}')) {
+        return handler.EndObject();
+      }
+      return Error("expected ',' or '}'");
+    }
+  }
+
+  template <typename Handler>
+  absl::Status ParseArray(Handler& handler, int depth) {
+    ++pos_;
+    CEL_RETURN_IF_ERROR(handler.BeginArray());
+    SkipWhitespace();
+    if (Consume(']')) {
+      return handler.EndArray();
+    }
+    while (true) {
+      CEL_RETURN_IF_ERROR(ParseValue(handler, depth + 1));
+      SkipWhitespace();
+      if (Consume(',')) {
+        continue;
+      }
+      if (Consume(']')) {
+        return handler.EndArray();
+      }
+      return Error("expected ',' or ']'");
+    }
+  }
+
+  absl::Status ParseLiteral(absl::string_view literal) {
+    if (text_.substr(pos_, literal.size()) != literal) {
+      return Error("invalid literal");
+    }
+    pos_ += literal.size();
+    return absl::OkStatus();
+  }
+
+  absl::Status ParseString(std::string& out) {
+    ++pos_;
+    while (true) {
+      // Copy runs of characters which need no special handling at once.
+      const size_t begin = pos_;
+      while (pos_ < text_.size() && text_[pos_] != '"' &&
+             text_[pos_] != '\\' &&
+             static_cast<unsigned char>(text_[pos_]) >= 0x20) {
+        ++pos_;
+      }
+      out.append(text_.data() + begin, pos_ - begin);
+      if (pos_ == text_.size()) {
+        return Error("unterminated string");
+      }
+      if (text_[pos_] == '"') {
+        ++pos_;
+        break;
+      }
+      if (text_[pos_] != '\\') {
+        return Error("unescaped control character in string");
+      }
+      ++pos_;
+      if (pos_ == text_.size()) {
+        return Error("unterminated string");
+      }
+      switch (text_[pos_++]) {
+        case '"':
+          out.push_back('"');
+          break;
+        case '\\':
+          out.push_back('\\');
+          break;
+        case '/':
+          out.push_back('/');
+          break;
+        case 'b':
+          out.push_back('\b');
+          break;
+        case 'f':
+          out.push_back('\f');
+          break;
+        case 'n':
+          out.push_back('\n');
+          break;
+        case 'r':
+          out.push_back('\r');
+          break;
+        case 't':
+          out.push_back('\t');
+          break;
+        case 'u': {
+          char32_t code_point;
+          CEL_RETURN_IF_ERROR(ParseHex4(code_point));
+          if (code_point >= 0xd800 && code_point <= 0xdbff) {
+            if (text_.substr(pos_, 2) != "\\u") {
+              return Error("unpaired surrogate in string");
+            }
+            pos_ += 2;
+            char32_t low;
+            CEL_RETURN_IF_ERROR(ParseHex4(low));
+            if (low < 0xdc00 || low > 0xdfff) {
+              return Error("unpaired surrogate in string");
+            }
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) +
+                         (low - 0xdc00);
+          } else if (code_point >= 0xdc00 && code_point <= 0xdfff) {
+            return Error("unpaired surrogate in string");
+          }
+          internal::Utf8Encode(out, code_point);
+          break;
+        }
+        default:
+          return Error("invalid escape sequence in string");
+      }
+    }
+    if (!internal::Utf8IsValid(out)) {
+      return Error("invalid UTF-8 in string");
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status ParseHex4(char32_t& out) {
+    if (text_.size() - pos_ < 4) {
+      return Error("invalid unicode escape sequence in string");
+    }
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = text_[pos_++];
+      if (!absl::ascii_isxdigit(static_cast<unsigned char>(c))) {
+        return Error("invalid unicode escape sequence in string");
+      }
+      out = (out << 4) |
+            static_cast<char32_t>(absl::ascii_isdigit(c)
+                                      ? c - '0'
+                                      : absl::ascii_tolower(c) - 'a' + 10);
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status ParseNumber(double& out) {
+    const size_t begin = pos_;
+    Consume('-');
+    if (Consume('0')) {
+      // Leading zeros are not allowed.
+    } else if (!ConsumeDigits()) {
+      pos_ = begin;
+      return Error("invalid value");
+    }
+    if (Consume('.') && !ConsumeDigits()) {
+      return Error("expected digit after decimal point");
+    }
+    if (Consume('e') || Consume('E')) {
+      if (!Consume('+')) {
+        Consume('-');
+      }
+      if (!ConsumeDigits()) {
+        return Error("expected digit in exponent");
+      }
+    }
+    if (!absl::SimpleAtod(text_.substr(begin, pos_ - begin), &out)) {
+      pos_ = begin;
+      return Error("invalid number");
+    }
+    return absl::OkStatus();
+  }
+
+  bool ConsumeDigits() {
+    const size_t begin = pos_;
+    while (pos_ < text_.size() && absl::ascii_isdigit(text_[pos_])) {
+      ++pos_;
+    }
+    return pos_ != begin;
+  }
+
+  bool Consume(char c) {
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  absl::Status Error(absl::string_view message) const {
+    return absl::InvalidArgumentError(
+        absl::StrCat("invalid JSON at offset ", pos_, ": ", message));
+  }
+
+  const absl::string_view text_;
+  const int max_depth_;
+  size_t pos_ = 0;
+};
+
+absl::Status DuplicateJsonKeyError(absl::string_view key) {
+  return absl::AlreadyExistsError(
+      absl::StrCat("duplicate key in JSON object: ", key));
+}
+
+// Handler which builds a `Json`.
+class JsonHandler final {
+ public:
+  absl::Status Null() { return Emit(kJsonNull); }
+  absl::Status Bool(bool value) { return Emit(JsonBool{value}); }
+  absl::Status Number(double value) { return Emit(JsonNumber{value}); }
+  absl::Status String(std::string value) {
+    return Emit(JsonString(std::move(value)));
+  }
+
+  absl::Status BeginObject() {
+    frames_.emplace_back().object = true;
+    return absl::OkStatus();
+  }
+
+  absl::Status Key(std::string key) {
+    frames_.back().key = std::move(key);
+    return absl::OkStatus();
+  }
+
+  absl::Status EndObject() {
+    Json json = std::move(frames_.back().object_builder).Build();
+    frames_.pop_back();
+    return Emit(std::move(json));
+  }
+
+  absl::Status BeginArray() {
+    frames_.emplace_back();
+    return absl::OkStatus();
+  }
+
+  absl::Status EndArray() {
+    Json json = std::move(frames_.back().array_builder).Build();
+    frames_.pop_back();
+    return Emit(std::move(json));
+  }
+
+  bool Defer(int) const { return false; }
+
+  absl::Status Deferred(bool, absl::string_view, size_t, int) {
+    return absl::InternalError("unexpected deferred JSON value");
+  }
+
+  Json Result() && { return std::move(result_); }
+
+ private:
+  struct Frame {
+    bool object = false;
+    JsonObjectBuilder object_builder;
+    JsonArrayBuilder array_builder;
+    std::string key;
+  };
+
+  absl::Status Emit(Json json) {
+    if (frames_.empty()) {
+      result_ = std::move(json);
+      return absl::OkStatus();
+    }
+    Frame& frame = frames_.back();
+    if (!frame.object) {
+      frame.array_builder.push_back(std::move(json));
+      return absl::OkStatus();
+    }
+    if (!frame.object_builder
+             .insert(std::make_pair(JsonString(frame.key), std::move(json)))
+             .second) {
+      return DuplicateJsonKeyError(frame.key);
+    }
+    return absl::OkStatus();
+  }
+
+  std::vector<Frame> frames_;
+  Json result_;
+};
+
+void AppendJsonDebugString(const Json& json, std::string& out) {
+  absl::visit(
+      absl::Overload(
+          [&out](JsonNull) { out.append(NullValueView().DebugString()); },
+          [&out](JsonBool value) {
+            out.append(BoolValueView(value).DebugString());
+          },
+          [&out](JsonNumber value) {
+            out.append(DoubleValueView(value).DebugString());
+          },
+          [&out](const JsonString& value) {
+            out.append(StringValueView(value).DebugString());
+          },
+          [&out](const JsonArray& value) {
+            out.push_back('[');
+            for (auto element = value.begin(); element != value.end();
+                 ++element) {
+              if (element != value.begin()) {
+                out.append(", ");
+              }
+              AppendJsonDebugString(*element, out);
+            }
+            out.push_back(']');
+          },
+          [&out](const JsonObject& value) {
+            // Sort the keys, as the other map implementations do.
+            std::vector<const JsonObject::value_type*> entries;
+            entries.reserve(value.size());
+            for (const auto& entry : value) {
+              entries.push_back(&entry);
+            }
+            std::sort(entries.begin(), entries.end(),
+                      [](const auto* lhs, const auto* rhs) {
+                        return lhs->first < rhs->first;
+                      });
+            out.push_back('{');
+            for (const auto* entry : entries) {
+              if (entry != entries.front()) {
+                out.append(", ");
+              }
+              out.append(StringValueView(entry->first).DebugString());
+              out.append(": ");
+              AppendJsonDebugString(entry->second, out);
+            }
+            out.push_back('}');
+          }),
+      json);
+}
+
+absl::StatusOr<Value> ParseDeferredJson(ValueManager& value_manager,
+                                        Shared<const std::string> buffer,
+                                        absl::string_view text, int max_depth);
+
+// State shared by the deferred list and map implementations. `text` points
+// into `buffer` and has already been validated.
+class DeferredJson final {
+ public:
+  DeferredJson(Shared<const std::string> buffer, absl::string_view text,
+               size_t size, int max_depth)
+      : buffer_(std::move(buffer)),
+        text_(text),
+        size_(size),
+        max_depth_(max_depth) {}
+
+  size_t size() const { return size_; }
+
+  std::string DebugString() const {
+    auto json = ToJson();
+    if (!json.ok()) {
+      return std::string(text_);
+    }
+    std::string out;
+    AppendJsonDebugString(*json, out);
+    return out;
+  }
+
+  absl::StatusOr<Json> ToJson() const {
+    JsonParseOptions options;
+    options.max_depth = max_depth_;
+    return ParseJson(text_, options);
+  }
+
+  // Returns the value, parsing the text on the first call. Members which are
+  // themselves arrays or objects are deferred in turn.
+  absl::StatusOr<Value> Get(ValueManager& value_manager) const {
+    absl::MutexLock lock(&mutex_);
+    if (!value_.has_value()) {
+      CEL_ASSIGN_OR_RETURN(
+          value_, ParseDeferredJson(value_manager, buffer_, text_, max_depth_));
+    }
+    return *value_;
+  }
+
+ private:
+  const Shared<const std::string> buffer_;
+  const absl::string_view text_;
+  const size_t size_;
+  const int max_depth_;
+  mutable absl::Mutex mutex_;
+  mutable absl::optional<Value> value_ ABSL_GUARDED_BY(mutex_);
+};
+
+class DeferredJsonListValue final : public ParsedListValueInterface {
+ public:
+  DeferredJsonListValue(Shared<const std::string> buffer,
+                        absl::string_view text, size_t size, int max_depth)
+      : deferred_(std::move(buffer), text, size, max_depth) {}
+
+  std::string DebugString() const override { return deferred_.DebugString(); }
+
+  bool IsEmpty() const override { return deferred_.size() == 0; }
+
+  size_t Size() const override { return deferred_.size(); }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter&) const override {
+    CEL_ASSIGN_OR_RETURN(auto json, deferred_.ToJson());
+    return absl::get<JsonArray>(std::move(json));
+  }
+
+ private:
+  Type GetTypeImpl(TypeManager& type_manager) const override {
+    return ListType(type_manager.GetDynListType());
+  }
+
+  absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
+                                    Value& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto value, deferred_.Get(value_manager));
+    CEL_ASSIGN_OR_RETURN(auto element,
+                         Cast<ListValue>(value).Get(value_manager, index));
+    scratch = std::move(element);
+    return scratch;
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<DeferredJsonListValue>();
+  }
+
+  const DeferredJson deferred_;
+};
+
+class DeferredJsonMapValue final : public ParsedMapValueInterface {
+ public:
+  DeferredJsonMapValue(Shared<const std::string> buffer,
+                       absl::string_view text, size_t size, int max_depth)
+      : deferred_(std::move(buffer), text, size, max_depth) {}
+
+  std::string DebugString() const override { return deferred_.DebugString(); }
+
+  bool IsEmpty() const override { return deferred_.size() == 0; }
+
+  size_t Size() const override { return deferred_.size(); }
+
+  absl::StatusOr<ListValueView> ListKeys(ValueManager& value_manager,
+                                         ListValue& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto value, deferred_.Get(value_manager));
+    CEL_ASSIGN_OR_RETURN(auto keys,
+                         Cast<MapValue>(value).ListKeys(value_manager));
+    scratch = std::move(keys);
+    return scratch;
+  }
+
+  absl::StatusOr<absl::Nonnull<ValueIteratorPtr>> NewIterator(
+      ValueManager& value_manager) const override {
+    CEL_ASSIGN_OR_RETURN(auto value, deferred_.Get(value_manager));
+    return Cast<MapValue>(value).NewIterator(value_manager);
+  }
+
+  absl::StatusOr<JsonObject> ConvertToJsonObject(
+      AnyToJsonConverter&) const override {
+    CEL_ASSIGN_OR_RETURN(auto json, deferred_.ToJson());
+    return absl::get<JsonObject>(std::move(json));
+  }
+
+ private:
+  absl::StatusOr<absl::optional<ValueView>> FindImpl(
+      ValueManager& value_manager, ValueView key,
+      Value& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto value, deferred_.Get(value_manager));
+    CEL_ASSIGN_OR_RETURN(auto entry,
+                         Cast<MapValue>(value).Find(value_manager, key));
+    if (!entry.second) {
+      return absl::nullopt;
+    }
+    scratch = std::move(entry.first);
+    return scratch;
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> FindStringImpl(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto value, deferred_.Get(value_manager));
+    Value entry_scratch;
+    CEL_ASSIGN_OR_RETURN(auto entry,
+                         Cast<MapValue>(value).FindByString(
+                             value_manager, key, hash, entry_scratch));
+    if (!entry.second) {
+      return absl::nullopt;
+    }
+    scratch = Value(entry.first);
+    return scratch;
+  }
+
+  absl::StatusOr<bool> HasImpl(ValueManager& value_manager,
+                               ValueView key) const override {
+    CEL_ASSIGN_OR_RETURN(auto value, deferred_.Get(value_manager));
+    CEL_ASSIGN_OR_RETURN(auto entry,
+                         Cast<MapValue>(value).Find(value_manager, key));
+    return entry.second;
+  }
+
+  Type GetTypeImpl(TypeManager& type_manager) const override {
+    return MapType(type_manager.GetStringDynMapType());
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<DeferredJsonMapValue>();
+  }
+
+  const DeferredJson deferred_;
+};
+
+// Handler which builds a `Value` using the builders of a `ValueManager`. If
+// `buffer` is not empty, nested arrays and objects are deferred.
+class ValueHandler final {
+ public:
+  ValueHandler(ValueManager& value_manager, Shared<const std::string> buffer,
+               int max_depth)
+      : value_manager_(value_manager),
+        buffer_(std::move(buffer)),
+        max_depth_(max_depth) {}
+
+  absl::Status Null() { return Emit(NullValue()); }
+  absl::Status Bool(bool value) { return Emit(BoolValue(value)); }
+  absl::Status Number(double value) { return Emit(DoubleValue(value)); }
+  absl::Status String(std::string value) {
+    // The parser has already validated the string.
+    return Emit(value_manager_.CreateUncheckedStringValue(std::move(value)));
+  }
+
+  absl::Status BeginObject() {
+    CEL_ASSIGN_OR_RETURN(auto builder,
+                         value_manager_.NewMapValueBuilder(
+                             value_manager_.GetStringDynMapType()));
+    frames_.emplace_back().map = std::move(builder);
+    return absl::OkStatus();
+  }
+
+  absl::Status Key(std::string key) {
+    frames_.back().key =
+        value_manager_.CreateUncheckedStringValue(std::move(key));
+    return absl::OkStatus();
+  }
+
+  absl::Status EndObject() {
+    Value value = std::move(*frames_.back().map).Build();
+    frames_.pop_back();
+    return Emit(std::move(value));
+  }
+
+  absl::Status BeginArray() {
+    CEL_ASSIGN_OR_RETURN(
+        auto builder,
+        value_manager_.NewListValueBuilder(value_manager_.GetDynListType()));
+    frames_.emplace_back().list = std::move(builder);
+    return absl::OkStatus();
+  }
+
+  absl::Status EndArray() {
+    Value value = std::move(*frames_.back().list).Build();
+    frames_.pop_back();
+    return Emit(std::move(value));
+  }
+
+  // The outermost array or object is always built, so that its members can
+  // be accessed without another pass over the text.
+  bool Defer(int depth) const { return buffer_ && depth > 0; }
+
+  absl::Status Deferred(bool object, absl::string_view text, size_t size,
+                        int depth) {
+    auto memory_manager = value_manager_.GetMemoryManager();
+    if (object) {
+      return Emit(ParsedMapValue(
+          memory_manager.MakeShared<DeferredJsonMapValue>(
+              buffer_, text, size, max_depth_ - depth)));
+    }
+    return Emit(ParsedListValue(
+        memory_manager.MakeShared<DeferredJsonListValue>(
+            buffer_, text, size, max_depth_ - depth)));
+  }
+
+  Value Result() && { return std::move(result_); }
+
+ private:
+  struct Frame {
+    Unique<MapValueBuilder> map;
+    Unique<ListValueBuilder> list;
+    Value key;
+  };
+
+  absl::Status Emit(Value value) {
+    if (frames_.empty()) {
+      result_ = std::move(value);
+      return absl::OkStatus();
+    }
+    Frame& frame = frames_.back();
+    if (frame.map) {
+      return frame.map->Put(std::move(frame.key), std::move(value));
+    }
+    return frame.list->Add(std::move(value));
+  }
+
+  ValueManager& value_manager_;
+  const Shared<const std::string> buffer_;
+  const int max_depth_;
+  std::vector<Frame> frames_;
+  Value result_;
+};
+
+absl::StatusOr<Value> ParseDeferredJson(ValueManager& value_manager,
+                                        Shared<const std::string> buffer,
+                                        absl::string_view text,
+                                        int max_depth) {
+  JsonParser parser(text, max_depth);
+  ValueHandler handler(value_manager, std::move(buffer), max_depth);
+  CEL_RETURN_IF_ERROR(parser.Parse(handler));
+  return std::move(handler).Result();
+}
+
+}  // namespace
+
+absl::StatusOr<Json> ParseJson(absl::string_view text,
+                               const JsonParseOptions& options) {
+  JsonParser parser(text, options.max_depth);
+  JsonHandler handler;
+  CEL_RETURN_IF_ERROR(parser.Parse(handler));
+  return std::move(handler).Result();
+}
+
+absl::StatusOr<Value> ParseJsonToValue(ValueManager& value_manager,
+                                       absl::string_view text,
+                                       const JsonParseOptions& options) {
+  if (!options.lazy) {
+    JsonParser parser(text, options.max_depth);
+    ValueHandler handler(value_manager, Shared<const std::string>(),
+                         options.max_depth);
+    CEL_RETURN_IF_ERROR(parser.Parse(handler));
+    return std::move(handler).Result();
+  }
+  // Deferred values refer to the text, so it must live as long as they do.
+  auto buffer =
+      value_manager.GetMemoryManager().MakeShared<const std::string>(text);
+  absl::string_view buffered_text = *buffer;
+  return ParseDeferredJson(value_manager, std::move(buffer), buffered_text,
+                           options.max_depth);
+}
+
+}  // namespace cel
@@ -0,0 +1,64 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Parsing of JSON text (RFC 8259) directly into `cel::Json` or `cel::Value`,
+// without going through `google.protobuf.Struct`.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_JSON_PARSER_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_JSON_PARSER_H_
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/json.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel {
+
+struct JsonParseOptions {
+  // Maximum nesting depth of arrays and objects. Deeper input is rejected.
+  int max_depth = 100;
+
+  // If true, nested arrays and objects are validated up front but only
+  // converted to values when they are first accessed. The text is copied once
+  // and shared by all of the deferred values.
+  //
+  // Duplicate keys in a deferred object are reported by the first operation
+  // which accesses it, rather than by `ParseJsonToValue`. Deferred values must
+  // be accessed with a `ValueManager` using the same memory manager as the one
+  // they were parsed with.
+  bool lazy = false;
+};
+
+// Parses `text` as a single JSON value. Numbers are represented as `double`,
+// as with `google.protobuf.Value`.
+//
+// Duplicate object keys are reported as `absl::StatusCode::kAlreadyExists`,
+// other malformed input as `absl::StatusCode::kInvalidArgument`.
+absl::StatusOr<Json> ParseJson(absl::string_view text,
+                               const JsonParseOptions& options = {});
+
+// Parses `text` as a single JSON value, producing the same `cel::Value` as
+// `ValueFactory::CreateValueFromJson` would for the equivalent `Json`: objects
+// are `map(string, dyn)`, arrays are `list(dyn)` and numbers are `double`.
+//
+// Values are built with the list and map builders of `value_manager`, so they
+// are allocated with its memory manager.
+absl::StatusOr<Value> ParseJsonToValue(ValueManager& value_manager,
+                                       absl::string_view text,
+                                       const JsonParseOptions& options = {});
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_JSON_PARSER_H_
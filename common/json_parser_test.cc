@@ -0,0 +1,194 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/json_parser.h"
+
+#include <string>
+#include <tuple>
+
+#include "absl/status/status.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using ::cel::test::BoolValueIs;
+using ::cel::test::DoubleValueIs;
+using ::cel::test::StringValueIs;
+using testing::_;
+using testing::Eq;
+using testing::HasSubstr;
+using testing::Pair;
+using testing::VariantWith;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+
+TEST(ParseJson, Scalars) {
+  EXPECT_THAT(ParseJson("null"),
+              IsOkAndHolds(VariantWith<JsonNull>(kJsonNull)));
+  EXPECT_THAT(ParseJson(" true "), IsOkAndHolds(VariantWith<JsonBool>(true)));
+  EXPECT_THAT(ParseJson("false"), IsOkAndHolds(VariantWith<JsonBool>(false)));
+  EXPECT_THAT(ParseJson("-1.5e2"),
+              IsOkAndHolds(VariantWith<JsonNumber>(-150.0)));
+  EXPECT_THAT(ParseJson("0"), IsOkAndHolds(VariantWith<JsonNumber>(0.0)));
+  EXPECT_THAT(ParseJson(R"json("a\"b\\c\n\u00e9\ud83d\ude00")json"),
+              IsOkAndHolds(VariantWith<JsonString>(
+                  JsonString("a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80"))));
+}
+
+TEST(ParseJson, Containers) {
+  ASSERT_OK_AND_ASSIGN(
+      auto json, ParseJson(R"json({"a": [1, {"b": null}], "c": {}})json"));
+  EXPECT_EQ(json,
+            Json(MakeJsonObject(
+                {{JsonString("a"),
+                  MakeJsonArray({Json(1.0), Json(MakeJsonObject(
+                                                {{JsonString("b"),
+                                                  kJsonNull}}))})},
+                 {JsonString("c"), JsonObject()}})));
+}
+
+TEST(ParseJson, Errors) {
+  for (const char* text :
+       {"", "nul", "01", "1.", "1e", "-", "+1", "[1,]", "{\"a\" 1}", "{1: 2}",
+        "[1 2]", "\"\\x\"", "\"\\ud800\"", "\"\x01\"", "\"\xff\"", "\"abc",
+        "1 2"}) {
+    EXPECT_THAT(ParseJson(text), StatusIs(absl::StatusCode::kInvalidArgument))
+        << text;
+  }
+  EXPECT_THAT(ParseJson("{\"a\": 1, \"a\": 2}"),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  EXPECT_THAT(ParseJson("[1, }"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("offset 4")));
+}
+
+TEST(ParseJson, MaxDepth) {
+  JsonParseOptions options;
+  options.max_depth = 2;
+  EXPECT_OK(ParseJson("[[1]]", options));
+  EXPECT_THAT(ParseJson("[[[1]]]", options),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("maximum nesting depth")));
+}
+
+class ParseJsonToValueTest
+    : public common_internal::ThreadCompatibleValueTest<bool> {
+ protected:
+  JsonParseOptions options() {
+    JsonParseOptions options;
+    options.lazy = std::get<1>(GetParam());
+    return options;
+  }
+};
+
+TEST_P(ParseJsonToValueTest, Scalars) {
+  EXPECT_THAT(ParseJsonToValue(value_manager(), "true", options()),
+              IsOkAndHolds(BoolValueIs(true)));
+  EXPECT_THAT(ParseJsonToValue(value_manager(), "2.5", options()),
+              IsOkAndHolds(DoubleValueIs(2.5)));
+  EXPECT_THAT(ParseJsonToValue(value_manager(), "\"foo\"", options()),
+              IsOkAndHolds(StringValueIs("foo")));
+  ASSERT_OK_AND_ASSIGN(auto value,
+                       ParseJsonToValue(value_manager(), "null", options()));
+  EXPECT_TRUE(InstanceOf<NullValue>(value));
+}
+
+TEST_P(ParseJsonToValueTest, Object) {
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      ParseJsonToValue(value_manager(),
+                       R"json({"name": "foo", "nested": {"list": [1, true]},
+                               "empty": []})json",
+                       options()));
+  ASSERT_TRUE(InstanceOf<MapValue>(value));
+  auto map = Cast<MapValue>(value);
+  EXPECT_THAT(map.Size(), IsOkAndHolds(Eq(3)));
+  EXPECT_THAT(map.Find(value_manager(), StringValue("name")),
+              IsOkAndHolds(Pair(StringValueIs("foo"), true)));
+
+  ASSERT_OK_AND_ASSIGN(auto nested,
+                       map.Get(value_manager(), StringValue("nested")));
+  ASSERT_TRUE(InstanceOf<MapValue>(nested));
+  EXPECT_THAT(Cast<MapValue>(nested).Size(), IsOkAndHolds(Eq(1)));
+  Value scratch;
+  EXPECT_THAT(Cast<MapValue>(nested).FindByString(value_manager(), "list",
+                                                  scratch),
+              IsOkAndHolds(Pair(_, true)));
+  EXPECT_THAT(Cast<MapValue>(nested).FindByString(value_manager(), "name",
+                                                  scratch),
+              IsOkAndHolds(Pair(_, false)));
+  ASSERT_OK_AND_ASSIGN(auto list, Cast<MapValue>(nested).Get(
+                                      value_manager(), StringValue("list")));
+  ASSERT_TRUE(InstanceOf<ListValue>(list));
+  EXPECT_THAT(Cast<ListValue>(list).Size(), IsOkAndHolds(Eq(2)));
+  EXPECT_THAT(Cast<ListValue>(list).Get(value_manager(), 0),
+              IsOkAndHolds(DoubleValueIs(1)));
+  EXPECT_THAT(Cast<ListValue>(list).Get(value_manager(), 1),
+              IsOkAndHolds(BoolValueIs(true)));
+
+  ASSERT_OK_AND_ASSIGN(auto empty,
+                       map.Get(value_manager(), StringValue("empty")));
+  ASSERT_TRUE(InstanceOf<ListValue>(empty));
+  EXPECT_THAT(Cast<ListValue>(empty).IsEmpty(), IsOkAndHolds(true));
+}
+
+TEST_P(ParseJsonToValueTest, ConvertToJson) {
+  constexpr const char* kText = R"json({"a": {"b": [1, "c", null]}})json";
+  ASSERT_OK_AND_ASSIGN(auto expected, ParseJson(kText));
+  ASSERT_OK_AND_ASSIGN(auto value,
+                       ParseJsonToValue(value_manager(), kText, options()));
+  EXPECT_THAT(value.ConvertToJson(value_manager()),
+              IsOkAndHolds(Eq(expected)));
+  EXPECT_EQ(value.DebugString(), "{\"a\": {\"b\": [1.0, \"c\", null]}}");
+}
+
+TEST_P(ParseJsonToValueTest, Errors) {
+  EXPECT_THAT(ParseJsonToValue(value_manager(), "{\"a\": [1, 2}", options()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      ParseJsonToValue(value_manager(), "{\"a\": 1, \"a\": 2}", options()),
+      StatusIs(absl::StatusCode::kAlreadyExists));
+}
+
+TEST_P(ParseJsonToValueTest, NestedDuplicateKey) {
+  constexpr const char* kText = R"json({"a": {"b": 1, "b": 2}})json";
+  if (!options().lazy) {
+    EXPECT_THAT(ParseJsonToValue(value_manager(), kText, options()),
+                StatusIs(absl::StatusCode::kAlreadyExists));
+    return;
+  }
+  // Deferred objects are only checked for duplicates when accessed.
+  ASSERT_OK_AND_ASSIGN(auto value,
+                       ParseJsonToValue(value_manager(), kText, options()));
+  ASSERT_OK_AND_ASSIGN(auto nested, Cast<MapValue>(value).Get(
+                                        value_manager(), StringValue("a")));
+  EXPECT_THAT(Cast<MapValue>(nested).Find(value_manager(), StringValue("b")),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ParseJsonToValueTest, ParseJsonToValueTest,
+    ::testing::Combine(::testing::Values(MemoryManagement::kReferenceCounting,
+                                         MemoryManagement::kPooling),
+                       ::testing::Bool()),
+    ParseJsonToValueTest::ToString);
+
+}  // namespace
+}  // namespace cel
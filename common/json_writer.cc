@@ -0,0 +1,282 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/json_writer.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/functional/overload.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/variant.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "internal/status_macros.h"
+
+namespace cel {
+
+namespace {
+
+// Rough lower bounds on the serialized size of a list element or map entry,
+// used to reserve space before writing a container.
+constexpr size_t kMinListElementSize = 2;
+constexpr size_t kMinMapEntrySize = 6;
+
+void AppendEscaped(absl::string_view value, std::string& out) {
+  size_t begin = 0;
+  for (size_t i = 0; i < value.size(); ++i) {
+    const auto c = static_cast<unsigned char>(value[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out.append(value.data() + begin, i - begin);
+    begin = i + 1;
+    switch (c) {
+      case '"':
+        out.append("\\\"");
+        break;
+      case '\\':
+        out.append("\\\\");
+        break;
+      case '\b':
+        out.append("\\b");
+        break;
+      case '\f':
+        out.append("\\f");
+        break;
+      case '\n':
+        out.append("\\n");
+        break;
+      case '\r':
+        out.append("\\r");
+        break;
+      case '\t':
+        out.append("\\t");
+        break;
+      default:
+        absl::StrAppendFormat(&out, "\\u%04x", c);
+        break;
+    }
+  }
+  out.append(value.data() + begin, value.size() - begin);
+}
+
+void AppendString(absl::string_view value, std::string& out) {
+  out.push_back('"');
+  AppendEscaped(value, out);
+  out.push_back('"');
+}
+
+void AppendString(const absl::Cord& value, std::string& out) {
+  out.push_back('"');
+  for (absl::string_view chunk : value.Chunks()) {
+    AppendEscaped(chunk, out);
+  }
+  out.push_back('"');
+}
+
+void AppendNumber(double value, std::string& out) {
+  if (std::isnan(value)) {
+    out.append("\"NaN\"");
+    return;
+  }
+  if (std::isinf(value)) {
+    out.append(value > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+    return;
+  }
+  // Use the shortest of the two precisions which round trips.
+  char buffer[32];
+  int length = absl::SNPrintF(buffer, sizeof(buffer), "%.15g", value);
+  double parsed;
+  if (!absl::SimpleAtod(absl::string_view(buffer, length), &parsed) ||
+      parsed != value) {
+    length = absl::SNPrintF(buffer, sizeof(buffer), "%.17g", value);
+  }
+  out.append(buffer, length);
+}
+
+class ValueJsonWriter final {
+ public:
+  ValueJsonWriter(ValueManager& value_manager, std::string& out)
+      : value_manager_(value_manager), out_(out) {}
+
+  absl::Status Write(ValueView value) {
+    switch (value.kind()) {
+      case ValueKind::kNull:
+        out_.append("null");
+        return absl::OkStatus();
+      case ValueKind::kBool:
+        out_.append(Cast<BoolValueView>(value).NativeValue() ? "true"
+                                                              : "false");
+        return absl::OkStatus();
+      case ValueKind::kInt: {
+        // Matches `JsonInt`.
+        const int64_t int_value = Cast<IntValueView>(value).NativeValue();
+        if (int_value < kJsonMinInt || int_value > kJsonMaxInt) {
+          absl::StrAppend(&out_, "\"", int_value, "\"");
+        } else {
+          absl::StrAppend(&out_, int_value);
+        }
+        return absl::OkStatus();
+      }
+      case ValueKind::kUint: {
+        // Matches `JsonUint`.
+        const uint64_t uint_value = Cast<UintValueView>(value).NativeValue();
+        if (uint_value > kJsonMaxUint) {
+          absl::StrAppend(&out_, "\"", uint_value, "\"");
+        } else {
+          absl::StrAppend(&out_, uint_value);
+        }
+        return absl::OkStatus();
+      }
+      case ValueKind::kDouble:
+        AppendNumber(Cast<DoubleValueView>(value).NativeValue(), out_);
+        return absl::OkStatus();
+      case ValueKind::kString:
+        Cast<StringValueView>(value).NativeValue(
+            [this](const auto& string_value) {
+              AppendString(string_value, out_);
+            });
+        return absl::OkStatus();
+      case ValueKind::kList:
+        return WriteList(Cast<ListValueView>(value));
+      case ValueKind::kMap:
+        return WriteMap(Cast<MapValueView>(value));
+      default: {
+        // Bytes, durations, timestamps and structs. Their conversions have no
+        // intermediate containers worth avoiding, or are specific to the type.
+        CEL_ASSIGN_OR_RETURN(auto json, value.ConvertToJson(value_manager_));
+        JsonToString(json, out_);
+        return absl::OkStatus();
+      }
+    }
+  }
+
+ private:
+  absl::Status WriteList(ListValueView list) {
+    CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+    out_.reserve(out_.size() + 2 + size * kMinListElementSize);
+    out_.push_back('[');
+    bool first = true;
+    CEL_RETURN_IF_ERROR(list.ForEach(
+        value_manager_, [&](ValueView element) -> absl::StatusOr<bool> {
+          if (!first) {
+            out_.push_back(',');
+          }
+          first = false;
+          CEL_RETURN_IF_ERROR(Write(element));
+          return true;
+        }));
+    out_.push_back(']');
+    return absl::OkStatus();
+  }
+
+  absl::Status WriteMap(MapValueView map) {
+    CEL_ASSIGN_OR_RETURN(auto size, map.Size());
+    out_.reserve(out_.size() + 2 + size * kMinMapEntrySize);
+    out_.push_back('{');
+    bool first = true;
+    CEL_RETURN_IF_ERROR(map.ForEach(
+        value_manager_,
+        [&](ValueView key, ValueView entry) -> absl::StatusOr<bool> {
+          auto string_key = As<StringValueView>(key);
+          if (!string_key.has_value()) {
+            // Matches `MapValue::ConvertToJsonObject`.
+            return TypeConversionError(
+                       absl::StrCat("map<", key.GetTypeName(), ", ?>"),
+                       "google.protobuf.Struct")
+                .NativeValue();
+          }
+          if (!first) {
+            out_.push_back(',');
+          }
+          first = false;
+          string_key->NativeValue([this](const auto& string_value) {
+            AppendString(string_value, out_);
+          });
+          out_.push_back(':');
+          CEL_RETURN_IF_ERROR(Write(entry));
+          return true;
+        }));
+    out_.push_back('}');
+    return absl::OkStatus();
+  }
+
+  ValueManager& value_manager_;
+  std::string& out_;
+};
+
+}  // namespace
+
+void JsonToString(const Json& json, std::string& out) {
+  absl::visit(absl::Overload(
+                  [&out](JsonNull) { out.append("null"); },
+                  [&out](JsonBool value) {
+                    out.append(value ? "true" : "false");
+                  },
+                  [&out](JsonNumber value) { AppendNumber(value, out); },
+                  [&out](const JsonString& value) { AppendString(value, out); },
+                  [&out](const JsonArray& value) {
+                    out.push_back('[');
+                    for (auto element = value.begin(); element != value.end();
+                         ++element) {
+                      if (element != value.begin()) {
+                        out.push_back(',');
+                      }
+                      JsonToString(*element, out);
+                    }
+                    out.push_back(']');
+                  },
+                  [&out](const JsonObject& value) {
+                    out.push_back('{');
+                    for (auto entry = value.begin(); entry != value.end();
+                         ++entry) {
+                      if (entry != value.begin()) {
+                        out.push_back(',');
+                      }
+                      AppendString(entry->first, out);
+                      out.push_back(':');
+                      JsonToString(entry->second, out);
+                    }
+                    out.push_back('}');
+                  }),
+              json);
+}
+
+absl::Status ConvertToJsonString(ValueManager& value_manager, ValueView value,
+                                 std::string& out) {
+  return ValueJsonWriter(value_manager, out).Write(value);
+}
+
+absl::Status ConvertToJsonString(ValueManager& value_manager, ValueView value,
+                                 absl::Cord& out) {
+  std::string buffer;
+  CEL_RETURN_IF_ERROR(ConvertToJsonString(value_manager, value, buffer));
+  out.Append(std::move(buffer));
+  return absl::OkStatus();
+}
+
+}  // namespace cel
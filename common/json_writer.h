@@ -0,0 +1,49 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Serialization of `cel::Json` and `cel::Value` to compact JSON text.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_JSON_WRITER_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_JSON_WRITER_H_
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/cord.h"
+#include "common/json.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel {
+
+// Serializes `json`, appending it to `out`. Numbers which are not finite are
+// written as the strings "NaN", "Infinity" and "-Infinity", as in the proto3
+// JSON mapping.
+void JsonToString(const Json& json, std::string& out);
+
+// Serializes `value`, appending it to `out`. The output is the same as
+// serializing the result of `value.ConvertToJson(value_manager)`, but lists
+// and maps are written while they are walked instead of first being converted
+// to `JsonArray` and `JsonObject`.
+//
+// Struct values are converted with `ConvertToJson`, as their JSON mapping is
+// specific to the type. On error, the contents of `out` are unspecified.
+absl::Status ConvertToJsonString(ValueManager& value_manager, ValueView value,
+                                 std::string& out);
+absl::Status ConvertToJsonString(ValueManager& value_manager, ValueView value,
+                                 absl::Cord& out);
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_JSON_WRITER_H_
@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/json_writer.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/time/time.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/json_parser.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using testing::Eq;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+
+std::string JsonToString(const Json& json) {
+  std::string out;
+  JsonToString(json, out);
+  return out;
+}
+
+TEST(JsonToString, Scalars) {
+  EXPECT_EQ(JsonToString(kJsonNull), "null");
+  EXPECT_EQ(JsonToString(true), "true");
+  EXPECT_EQ(JsonToString(1.0), "1");
+  EXPECT_EQ(JsonToString(0.1), "0.1");
+  EXPECT_EQ(JsonToString(1.0 / 3), "0.33333333333333331");
+  EXPECT_EQ(JsonToString(std::numeric_limits<double>::quiet_NaN()), "\"NaN\"");
+  EXPECT_EQ(JsonToString(-std::numeric_limits<double>::infinity()),
+            "\"-Infinity\"");
+  EXPECT_EQ(JsonToString(JsonString("a\"b\\c\n\x01\xc3\xa9")),
+            "\"a\\\"b\\\\c\\n\\u0001\xc3\xa9\"");
+}
+
+TEST(JsonToString, Containers) {
+  EXPECT_EQ(JsonToString(MakeJsonArray({Json(1.0), Json(JsonString("a"))})),
+            "[1,\"a\"]");
+  EXPECT_EQ(JsonToString(MakeJsonObject({{JsonString("a"), JsonArray()}})),
+            "{\"a\":[]}");
+}
+
+class ConvertToJsonStringTest
+    : public common_internal::ThreadCompatibleValueTest<> {
+ protected:
+  absl::StatusOr<std::string> ToString(ValueView value) {
+    std::string out;
+    CEL_RETURN_IF_ERROR(ConvertToJsonString(value_manager(), value, out));
+    return out;
+  }
+
+  // Checks that the output round trips to the same `Json` as
+  // `ConvertToJson`.
+  void ExpectMatchesConvertToJson(ValueView value) {
+    ASSERT_OK_AND_ASSIGN(auto expected, value.ConvertToJson(value_manager()));
+    ASSERT_OK_AND_ASSIGN(auto text, ToString(value));
+    EXPECT_THAT(ParseJson(text), IsOkAndHolds(Eq(expected))) << text;
+  }
+};
+
+TEST_P(ConvertToJsonStringTest, Scalars) {
+  EXPECT_THAT(ToString(NullValueView()), IsOkAndHolds("null"));
+  EXPECT_THAT(ToString(BoolValueView(false)), IsOkAndHolds("false"));
+  EXPECT_THAT(ToString(IntValueView(-3)), IsOkAndHolds("-3"));
+  EXPECT_THAT(ToString(IntValueView(std::numeric_limits<int64_t>::max())),
+              IsOkAndHolds("\"9223372036854775807\""));
+  EXPECT_THAT(ToString(UintValueView(3)), IsOkAndHolds("3"));
+  EXPECT_THAT(ToString(DoubleValueView(2.5)), IsOkAndHolds("2.5"));
+  EXPECT_THAT(ToString(StringValueView("foo")), IsOkAndHolds("\"foo\""));
+  EXPECT_THAT(ToString(StringValueView(absl::Cord("b\"ar"))),
+              IsOkAndHolds("\"b\\\"ar\""));
+  EXPECT_THAT(ToString(BytesValueView("abc")), IsOkAndHolds("\"YWJj\""));
+  EXPECT_THAT(ToString(DurationValueView(absl::Seconds(1))),
+              IsOkAndHolds("\"1s\""));
+}
+
+TEST_P(ConvertToJsonStringTest, Containers) {
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      ParseJsonToValue(value_manager(),
+                       R"json({"a": [1, 2.5, "x", null, {"b": true}],
+                               "c": {}, "d": []})json"));
+  ExpectMatchesConvertToJson(value);
+  ASSERT_OK_AND_ASSIGN(auto list, Cast<MapValue>(value).Get(
+                                      value_manager(), StringValue("a")));
+  EXPECT_THAT(ToString(list),
+              IsOkAndHolds("[1,2.5,\"x\",null,{\"b\":true}]"));
+}
+
+TEST_P(ConvertToJsonStringTest, NonStringMapKey) {
+  ASSERT_OK_AND_ASSIGN(auto builder, value_manager().NewMapValueBuilder(
+                                         value_manager().GetDynDynMapType()));
+  ASSERT_OK(builder->Put(IntValue(1), IntValue(2)));
+  auto map = std::move(*builder).Build();
+  EXPECT_THAT(ToString(map), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_P(ConvertToJsonStringTest, Cord) {
+  absl::Cord out("prefix");
+  ASSERT_OK(ConvertToJsonString(value_manager(), IntValueView(1), out));
+  EXPECT_EQ(out, "prefix1");
+}
+
+TEST_P(ConvertToJsonStringTest, Error) {
+  EXPECT_THAT(ToString(ErrorValue(absl::CancelledError())),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ConvertToJsonStringTest, ConvertToJsonStringTest,
+    ::testing::Values(MemoryManagement::kReferenceCounting,
+                      MemoryManagement::kPooling));
+
+}  // namespace
+}  // namespace cel
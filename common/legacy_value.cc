@@ -14,7 +14,6 @@
 
 #include "common/legacy_value.h"
 
-#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -28,7 +27,6 @@
 #include "absl/base/optimization.h"
 #include "absl/functional/overload.h"
 #include "absl/log/absl_check.h"
-#include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
@@ -40,6 +38,7 @@
 #include "base/attribute.h"
 #include "base/internal/message_wrapper.h"
 #include "common/casting.h"
+#include "common/internal/allocation_counter.h"
 #include "common/internal/arena_string.h"
 #include "common/json.h"
 #include "common/kind.h"
@@ -279,142 +278,6 @@ absl::StatusOr<JsonObject> MessageWrapperToJsonObject(
   return std::move(builder).Build();
 }
 
-class CelListImpl final : public CelList {
- public:
-  CelListImpl() : CelListImpl(nullptr, 0) {}
-
-  CelListImpl(const CelValue* elements, size_t elements_size)
-      : elements_(elements), elements_size_(elements_size) {}
-
-  CelValue operator[](int index) const override {
-    ABSL_DCHECK_LT(index, size());
-    return elements_[index];
-  }
-
-  int size() const override { return static_cast<int>(elements_size_); }
-
-  bool empty() const override { return elements_size_ == 0; }
-
- private:
-  const CelValue* const elements_;
-  const size_t elements_size_;
-};
-
-class CelMapImpl final : public CelMap, public CelList {
- public:
-  using Entry = std::pair<CelValue, CelValue>;
-
-  // We sort in the following partitions in order: [bool, int, uint, string].
-  // Among the partitions the values are sorted as if by `<`.
-  static bool LessKey(const CelValue& lhs, const CelValue& rhs) {
-    if (lhs.IsBool()) {
-      if (rhs.IsBool()) {
-        return lhs.BoolOrDie() < rhs.BoolOrDie();
-      }
-      return true;
-    }
-    if (lhs.IsInt64()) {
-      if (rhs.IsInt64()) {
-        return lhs.Int64OrDie() < rhs.Int64OrDie();
-      }
-      return !rhs.IsBool();
-    }
-    if (lhs.IsUint64()) {
-      if (rhs.IsUint64()) {
-        return lhs.Uint64OrDie() < rhs.Uint64OrDie();
-      }
-      return !(rhs.IsBool() || rhs.IsInt64());
-    }
-    if (lhs.IsString()) {
-      if (rhs.IsString()) {
-        return lhs.StringOrDie().value() < rhs.StringOrDie().value();
-      }
-      return !(rhs.IsBool() || rhs.IsInt64() || rhs.IsUint64());
-    }
-    ABSL_DLOG(FATAL) << "invalid map key";
-    return false;
-  }
-
-  static bool EqualKey(const CelValue& lhs, const CelValue& rhs) {
-    if (lhs.IsBool() && rhs.IsBool()) {
-      return lhs.BoolOrDie() == rhs.BoolOrDie();
-    }
-    if (lhs.IsInt64() && rhs.IsInt64()) {
-      return lhs.Int64OrDie() == rhs.Int64OrDie();
-    }
-    if (lhs.IsUint64() && rhs.IsUint64()) {
-      return lhs.Uint64OrDie() == rhs.Uint64OrDie();
-    }
-    if (lhs.IsString() && rhs.IsString()) {
-      return lhs.StringOrDie().value() == rhs.StringOrDie().value();
-    }
-    return false;
-  }
-
-  struct KeyCompare {
-    using is_transparent = void;
-
-    bool operator()(const CelValue& lhs, const CelValue& rhs) const {
-      return LessKey(lhs, rhs);
-    }
-
-    bool operator()(const Entry& lhs, const Entry& rhs) const {
-      return (*this)(lhs.first, rhs.first);
-    }
-
-    bool operator()(const CelValue& lhs, const Entry& rhs) const {
-      return (*this)(lhs, rhs.first);
-    }
-
-    bool operator()(const Entry& lhs, const CelValue& rhs) const {
-      return (*this)(lhs.first, rhs);
-    }
-  };
-
-  CelMapImpl() : CelMapImpl(nullptr, 0) {}
-
-  CelMapImpl(const Entry* entries, size_t entries_size)
-      : entries_(entries), entries_size_(entries_size) {}
-
-  absl::optional<CelValue> operator[](CelValue key) const override {
-    if (key.IsError() || key.IsUnknownSet()) {
-      return key;
-    }
-    auto it = std::lower_bound(begin(), end(), key, KeyCompare{});
-    if (it == end() || !EqualKey(it->first, key)) {
-      return absl::nullopt;
-    }
-    return it->second;
-  }
-
-  CelValue operator[](int index) const override {
-    if (index >= size()) {
-      return CelValue::CreateNull();
-    }
-    return entries_[index].first;
-  }
-
-  absl::StatusOr<bool> Has(const CelValue& key) const override {
-    CEL_RETURN_IF_ERROR(CelValue::CheckMapKeyType(key));
-    auto it = std::lower_bound(begin(), end(), key, KeyCompare{});
-    return it != end() && EqualKey(it->first, key);
-  }
-
-  int size() const override { return entries_size_; }
-
-  bool empty() const override { return entries_size_ == 0; }
-
-  const Entry* begin() const { return entries_; }
-
-  const Entry* end() const { return entries_ + entries_size_; }
-
-  absl::StatusOr<const CelList*> ListKeys() const override { return this; }
-
- private:
-  const Entry* const entries_;
-  const size_t entries_size_;
-};
-
 class CelListValue final : public ContainerBackedListImpl {
  public:
   CelListValue(ListType type, std::vector<CelValue> elements)
@@ -455,6 +318,10 @@ class CelListValueBuilder final : public ListValueBuilder {
     if (elements_.empty()) {
       return ListValue(value_factory_.CreateZeroListValue(type_));
     }
+    // The elements live on the heap rather than the arena, so they are counted
+    // against the allocation budget here.
+    common_internal::CountAllocation(sizeof(CelListValue) +
+                                     elements_.capacity() * sizeof(CelValue));
     return common_internal::LegacyListValue{reinterpret_cast<uintptr_t>(
         static_cast<CelList*>(google::protobuf::Arena::Create<CelListValue>(
             arena_, std::move(type_), std::move(elements_))))};
@@ -500,11 +367,19 @@ class CelMapValueBuilder final : public MapValueBuilder {
     return builder_->Add(legacy_key, legacy_value);
   }
 
+  void Reserve(size_t capacity) override { builder_->Reserve(capacity); }
+
   bool IsEmpty() const override { return builder_->size() == 0; }
 
   size_t Size() const override { return static_cast<size_t>(builder_->size()); }
 
   MapValue Build() && override {
+    // Each entry is held by the hash map and the key list of the builder, both
+    // on the heap rather than the arena.
+    common_internal::CountAllocation(
+        sizeof(CelMapValue) +
+        static_cast<size_t>(builder_->size()) *
+            (sizeof(std::pair<CelValue, CelValue>) + sizeof(CelValue)));
     return common_internal::LegacyMapValue{
         reinterpret_cast<uintptr_t>(static_cast<CelMap*>(builder_))};
   }
@@ -514,6 +389,137 @@ class CelMapValueBuilder final : public MapValueBuilder {
   CelMapValue* builder_;
 };
 
+CelValue CreateLegacyErrorValue(google::protobuf::Arena* arena,
+                                absl::Status status) {
+  return CelValue::CreateError(
+      google::protobuf::Arena::Create<absl::Status>(arena, std::move(status)));
+}
+
+// Views a non-legacy `ListValue` in place as a `CelList`, converting elements
+// as they are accessed rather than materializing the whole list.
+class ModernCelList final : public CelList {
+ public:
+  ModernCelList(google::protobuf::Arena* arena, ListValue list_value,
+                size_t size)
+      : arena_(arena), list_value_(std::move(list_value)), size_(size) {}
+
+  CelValue operator[](int index) const override { return Get(arena_, index); }
+
+  CelValue Get(google::protobuf::Arena* arena, int index) const override {
+    common_internal::LegacyTypeReflector value_provider;
+    common_internal::LegacyValueManager value_manager(
+        extensions::ProtoMemoryManagerRef(arena), value_provider);
+    Value scratch;
+    auto element =
+        list_value_.Get(value_manager, static_cast<size_t>(index), scratch);
+    if (!element.ok()) {
+      return CreateLegacyErrorValue(arena, std::move(element).status());
+    }
+    auto legacy_element = LegacyValue(arena, *element);
+    if (!legacy_element.ok()) {
+      return CreateLegacyErrorValue(arena, std::move(legacy_element).status());
+    }
+    return *legacy_element;
+  }
+
+  int size() const override { return static_cast<int>(size_); }
+
+  bool empty() const override { return size_ == 0; }
+
+  const ListValue& list_value() const { return list_value_; }
+
+ private:
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<ModernCelList>();
+  }
+
+  google::protobuf::Arena* const arena_;
+  const ListValue list_value_;
+  const size_t size_;
+};
+
+// Views a non-legacy `MapValue` in place as a `CelMap`, converting keys and
+// values as they are accessed rather than materializing the whole map.
+class ModernCelMap final : public CelMap {
+ public:
+  ModernCelMap(google::protobuf::Arena* arena, MapValue map_value, size_t size)
+      : arena_(arena), map_value_(std::move(map_value)), size_(size) {}
+
+  absl::optional<CelValue> operator[](CelValue key) const override {
+    return Get(arena_, key);
+  }
+
+  absl::optional<CelValue> Get(google::protobuf::Arena* arena,
+                               CelValue key) const override {
+    common_internal::LegacyTypeReflector value_provider;
+    common_internal::LegacyValueManager value_manager(
+        extensions::ProtoMemoryManagerRef(arena), value_provider);
+    Value key_scratch;
+    auto modern_key = ModernValue(arena, key, key_scratch);
+    if (!modern_key.ok()) {
+      return CreateLegacyErrorValue(arena, std::move(modern_key).status());
+    }
+    Value scratch;
+    auto entry = map_value_.Find(value_manager, *modern_key, scratch);
+    if (!entry.ok()) {
+      return CreateLegacyErrorValue(arena, std::move(entry).status());
+    }
+    if (!entry->second) {
+      return absl::nullopt;
+    }
+    auto legacy_value = LegacyValue(arena, entry->first);
+    if (!legacy_value.ok()) {
+      return CreateLegacyErrorValue(arena, std::move(legacy_value).status());
+    }
+    return *legacy_value;
+  }
+
+  absl::StatusOr<bool> Has(const CelValue& key) const override {
+    common_internal::LegacyTypeReflector value_provider;
+    common_internal::LegacyValueManager value_manager(
+        extensions::ProtoMemoryManagerRef(arena_), value_provider);
+    Value key_scratch;
+    CEL_ASSIGN_OR_RETURN(auto modern_key,
+                         ModernValue(arena_, key, key_scratch));
+    Value scratch;
+    CEL_ASSIGN_OR_RETURN(auto has,
+                         map_value_.Has(value_manager, modern_key, scratch));
+    if (auto error = As<ErrorValueView>(has); error.has_value()) {
+      return error->NativeValue();
+    }
+    return Cast<BoolValueView>(has).NativeValue();
+  }
+
+  int size() const override { return static_cast<int>(size_); }
+
+  bool empty() const override { return size_ == 0; }
+
+  absl::StatusOr<const CelList*> ListKeys() const override {
+    return ListKeys(arena_);
+  }
+
+  absl::StatusOr<const CelList*> ListKeys(
+      google::protobuf::Arena* arena) const override {
+    common_internal::LegacyTypeReflector value_provider;
+    common_internal::LegacyValueManager value_manager(
+        extensions::ProtoMemoryManagerRef(arena), value_provider);
+    CEL_ASSIGN_OR_RETURN(ListValue keys, map_value_.ListKeys(value_manager));
+    return google::protobuf::Arena::Create<ModernCelList>(arena, arena,
+                                                std::move(keys), size_);
+  }
+
+  const MapValue& map_value() const { return map_value_; }
+
+ private:
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<ModernCelMap>();
+  }
+
+  google::protobuf::Arena* const arena_;
+  const MapValue map_value_;
+  const size_t size_;
+};
+
 }  // namespace
 
 extern "C" CEL_ATTRIBUTE_USED CEL_ATTRIBUTE_DEFAULT_VISIBILITY ListType
@@ -1121,12 +1127,26 @@ absl::StatusOr<ValueView> ModernValue(
       return DurationValueView{legacy_value.DurationOrDie()};
     case CelValue::Type::kTimestamp:
       return TimestampValueView{legacy_value.TimestampOrDie()};
-    case CelValue::Type::kList:
+    case CelValue::Type::kList: {
+      const CelList* cel_list = legacy_value.ListOrDie();
+      if (NativeTypeId::Of(*cel_list) == NativeTypeId::For<ModernCelList>()) {
+        return ListValueView{
+            cel::internal::down_cast<const ModernCelList*>(cel_list)
+                ->list_value()};
+      }
       return ListValueView{common_internal::LegacyListValueView{
-          reinterpret_cast<uintptr_t>(legacy_value.ListOrDie())}};
-    case CelValue::Type::kMap:
+          reinterpret_cast<uintptr_t>(cel_list)}};
+    }
+    case CelValue::Type::kMap: {
+      const CelMap* cel_map = legacy_value.MapOrDie();
+      if (NativeTypeId::Of(*cel_map) == NativeTypeId::For<ModernCelMap>()) {
+        return MapValueView{
+            cel::internal::down_cast<const ModernCelMap*>(cel_map)
+                ->map_value()};
+      }
       return MapValueView{common_internal::LegacyMapValueView{
-          reinterpret_cast<uintptr_t>(legacy_value.MapOrDie())}};
+          reinterpret_cast<uintptr_t>(cel_map)}};
+    }
     case CelValue::Type::kUnknownSet:
       return UnknownValueView{*legacy_value.UnknownSetOrDie()};
     case CelValue::Type::kCelType: {
@@ -1264,31 +1284,15 @@ absl::StatusOr<google::api::expr::runtime::CelValue> LegacyValue(
         return CelValue::CreateList(
             AsCelList(legacy_list_value->NativeValue()));
       }
-      // We have a non-legacy `ListValueView`. We are going to have to
-      // materialize it in its entirety to `CelList`.
+      // We have a non-legacy `ListValue`, which is viewed in place.
       auto list_value = Cast<ListValueView>(modern_value);
       CEL_ASSIGN_OR_RETURN(auto list_value_size, list_value.Size());
       if (list_value_size == 0) {
         return CelValue::CreateList();
       }
-      auto* elements = static_cast<CelValue*>(arena->AllocateAligned(
-          sizeof(CelValue) * list_value_size, alignof(CelValue)));
-      common_internal::LegacyTypeReflector value_provider;
-      common_internal::LegacyValueManager value_manager(
-          extensions::ProtoMemoryManagerRef(arena), value_provider);
-      CEL_RETURN_IF_ERROR(list_value.ForEach(
-          value_manager,
-          [arena, elements](size_t index,
-                            ValueView element) -> absl::StatusOr<bool> {
-            CEL_ASSIGN_OR_RETURN(elements[index], LegacyValue(arena, element));
-            return true;
-          }));
-      // We don't bother registering CelListImpl's destructor, it doesn't own
-      // anything and is not trivially destructible simply due to having a
-      // virtual destructor.
-      return CelValue::CreateList(::new (
-          arena->AllocateAligned(sizeof(CelListImpl), alignof(CelListImpl)))
-                                      CelListImpl(elements, list_value_size));
+      return CelValue::CreateList(
+          google::protobuf::Arena::Create<ModernCelList>(
+              arena, arena, ListValue(list_value), list_value_size));
     }
     case ValueKind::kMap: {
       if (auto legacy_map_value =
@@ -1296,34 +1300,14 @@ absl::StatusOr<google::api::expr::runtime::CelValue> LegacyValue(
           legacy_map_value.has_value()) {
         return CelValue::CreateMap(AsCelMap(legacy_map_value->NativeValue()));
       }
-      // We have a non-legacy `MapValueView`. We are going to have to
-      // materialize it in its entirety to `CelMap`.
+      // We have a non-legacy `MapValue`, which is viewed in place.
       auto map_value = Cast<MapValueView>(modern_value);
       CEL_ASSIGN_OR_RETURN(auto map_value_size, map_value.Size());
       if (map_value_size == 0) {
         return CelValue::CreateMap();
       }
-      auto* entries = static_cast<CelMapImpl::Entry*>(
-          arena->AllocateAligned(sizeof(CelMapImpl::Entry) * map_value_size,
-                                 alignof(CelMapImpl::Entry)));
-      size_t entry_count = 0;
-      common_internal::LegacyTypeReflector value_provider;
-      common_internal::LegacyValueManager value_manager(
-          extensions::ProtoMemoryManagerRef(arena), value_provider);
-      CEL_RETURN_IF_ERROR(map_value.ForEach(
-          value_manager,
-          [arena, entries, &entry_count](
-              ValueView key, ValueView value) -> absl::StatusOr<bool> {
-            auto* entry = ::new (static_cast<void*>(entries + entry_count++))
-                CelMapImpl::Entry{};
-            CEL_ASSIGN_OR_RETURN(entry->first, LegacyValue(arena, key));
-            CEL_ASSIGN_OR_RETURN(entry->second, LegacyValue(arena, value));
-            return true;
-          }));
-      std::sort(entries, entries + map_value_size, CelMapImpl::KeyCompare{});
-      return CelValue::CreateMap(::new (
-          arena->AllocateAligned(sizeof(CelMapImpl), alignof(CelMapImpl)))
-                                     CelMapImpl(entries, map_value_size));
+      return CelValue::CreateMap(google::protobuf::Arena::Create<ModernCelMap>(
+          arena, arena, MapValue(map_value), map_value_size));
     }
     case ValueKind::kUnknown:
       return CelValue::CreateUnknownSet(google::protobuf::Arena::Create<Unknown>(
@@ -1376,12 +1360,24 @@ absl::StatusOr<Value> FromLegacyValue(google::protobuf::Arena* arena,
       return DurationValue(legacy_value.DurationOrDie());
     case CelValue::Type::kTimestamp:
       return TimestampValue(legacy_value.TimestampOrDie());
-    case CelValue::Type::kList:
+    case CelValue::Type::kList: {
+      const CelList* cel_list = legacy_value.ListOrDie();
+      if (NativeTypeId::Of(*cel_list) == NativeTypeId::For<ModernCelList>()) {
+        return cel::internal::down_cast<const ModernCelList*>(cel_list)
+            ->list_value();
+      }
       return ListValue{common_internal::LegacyListValue{
-          reinterpret_cast<uintptr_t>(legacy_value.ListOrDie())}};
-    case CelValue::Type::kMap:
+          reinterpret_cast<uintptr_t>(cel_list)}};
+    }
+    case CelValue::Type::kMap: {
+      const CelMap* cel_map = legacy_value.MapOrDie();
+      if (NativeTypeId::Of(*cel_map) == NativeTypeId::For<ModernCelMap>()) {
+        return cel::internal::down_cast<const ModernCelMap*>(cel_map)
+            ->map_value();
+      }
       return MapValue{common_internal::LegacyMapValue{
-          reinterpret_cast<uintptr_t>(legacy_value.MapOrDie())}};
+          reinterpret_cast<uintptr_t>(cel_map)}};
+    }
     case CelValue::Type::kUnknownSet:
       return UnknownValue{*legacy_value.UnknownSetOrDie()};
     case CelValue::Type::kCelType:
@@ -1471,65 +1467,29 @@ absl::StatusOr<google::api::expr::runtime::CelValue> ToLegacyValue(
         return CelValue::CreateList(
             AsCelList(legacy_list_value->NativeValue()));
       }
-      // We have a non-legacy `ListValueView`. We are going to have to
-      // materialize it in its entirety to `CelList`.
+      // We have a non-legacy `ListValue`, which is viewed in place.
       auto list_value = Cast<ListValue>(value);
       CEL_ASSIGN_OR_RETURN(auto list_value_size, list_value.Size());
       if (list_value_size == 0) {
         return CelValue::CreateList();
       }
-      auto* elements = static_cast<CelValue*>(arena->AllocateAligned(
-          sizeof(CelValue) * list_value_size, alignof(CelValue)));
-      common_internal::LegacyTypeReflector value_provider;
-      common_internal::LegacyValueManager value_manager(
-          extensions::ProtoMemoryManagerRef(arena), value_provider);
-      CEL_RETURN_IF_ERROR(list_value.ForEach(
-          value_manager,
-          [arena, elements](size_t index,
-                            ValueView element) -> absl::StatusOr<bool> {
-            CEL_ASSIGN_OR_RETURN(elements[index], LegacyValue(arena, element));
-            return true;
-          }));
-      // We don't bother registering CelListImpl's destructor, it doesn't own
-      // anything and is not trivially destructible simply due to having a
-      // virtual destructor.
-      return CelValue::CreateList(::new (
-          arena->AllocateAligned(sizeof(CelListImpl), alignof(CelListImpl)))
-                                      CelListImpl(elements, list_value_size));
+      return CelValue::CreateList(
+          google::protobuf::Arena::Create<ModernCelList>(
+              arena, arena, ListValue(list_value), list_value_size));
     }
     case ValueKind::kMap: {
       if (auto legacy_map_value = As<common_internal::LegacyMapValue>(value);
           legacy_map_value.has_value()) {
         return CelValue::CreateMap(AsCelMap(legacy_map_value->NativeValue()));
       }
-      // We have a non-legacy `MapValueView`. We are going to have to
-      // materialize it in its entirety to `CelMap`.
+      // We have a non-legacy `MapValue`, which is viewed in place.
       auto map_value = Cast<MapValue>(value);
       CEL_ASSIGN_OR_RETURN(auto map_value_size, map_value.Size());
       if (map_value_size == 0) {
         return CelValue::CreateMap();
       }
-      auto* entries = static_cast<CelMapImpl::Entry*>(
-          arena->AllocateAligned(sizeof(CelMapImpl::Entry) * map_value_size,
-                                 alignof(CelMapImpl::Entry)));
-      size_t entry_count = 0;
-      common_internal::LegacyTypeReflector value_provider;
-      common_internal::LegacyValueManager value_manager(
-          extensions::ProtoMemoryManagerRef(arena), value_provider);
-      CEL_RETURN_IF_ERROR(map_value.ForEach(
-          value_manager,
-          [arena, entries, &entry_count](
-              ValueView key, ValueView value) -> absl::StatusOr<bool> {
-            auto* entry = ::new (static_cast<void*>(entries + entry_count++))
-                CelMapImpl::Entry{};
-            CEL_ASSIGN_OR_RETURN(entry->first, LegacyValue(arena, key));
-            CEL_ASSIGN_OR_RETURN(entry->second, LegacyValue(arena, value));
-            return true;
-          }));
-      std::sort(entries, entries + map_value_size, CelMapImpl::KeyCompare{});
-      return CelValue::CreateMap(::new (
-          arena->AllocateAligned(sizeof(CelMapImpl), alignof(CelMapImpl)))
-                                     CelMapImpl(entries, map_value_size));
+      return CelValue::CreateMap(google::protobuf::Arena::Create<ModernCelMap>(
+          arena, arena, MapValue(map_value), map_value_size));
     }
     case ValueKind::kUnknown:
       return CelValue::CreateUnknownSet(google::protobuf::Arena::Create<Unknown>(
@@ -0,0 +1,113 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/legacy_value.h"
+
+#include <utility>
+
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/memory.h"
+#include "common/type.h"
+#include "common/type_reflector.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/public/cel_value.h"
+#include "internal/testing.h"
+#include "google/protobuf/arena.h"
+
+namespace cel {
+namespace {
+
+using ::cel::interop_internal::FromLegacyValue;
+using ::cel::interop_internal::ToLegacyValue;
+using ::google::api::expr::runtime::CelList;
+using ::google::api::expr::runtime::CelValue;
+using cel::internal::IsOkAndHolds;
+
+class LegacyValueTest : public testing::Test {
+ public:
+  LegacyValueTest()
+      : value_manager_(NewThreadCompatibleValueManager(
+            MemoryManagerRef::ReferenceCounting(),
+            NewThreadCompatibleTypeReflector(
+                MemoryManagerRef::ReferenceCounting()))) {}
+
+ protected:
+  ValueManager& value_manager() { return *value_manager_; }
+
+  google::protobuf::Arena arena_;
+  Shared<ValueManager> value_manager_;
+};
+
+TEST_F(LegacyValueTest, ListValueViewedInPlace) {
+  ASSERT_OK_AND_ASSIGN(auto builder,
+                       value_manager().NewListValueBuilder(
+                           value_manager().CreateListType(IntTypeView())));
+  ASSERT_OK(builder->Add(IntValue(1)));
+  ASSERT_OK(builder->Add(IntValue(2)));
+  ASSERT_OK(builder->Add(IntValue(3)));
+  Value list_value = std::move(*builder).Build();
+
+  ASSERT_OK_AND_ASSIGN(CelValue legacy_value,
+                       ToLegacyValue(&arena_, list_value));
+  ASSERT_TRUE(legacy_value.IsList());
+  const CelList& cel_list = *legacy_value.ListOrDie();
+  EXPECT_EQ(cel_list.size(), 3);
+  EXPECT_EQ(cel_list[1].Int64OrDie(), 2);
+  EXPECT_EQ(cel_list.Get(&arena_, 2).Int64OrDie(), 3);
+
+  // Converting back yields the original list rather than a legacy wrapper.
+  ASSERT_OK_AND_ASSIGN(Value modern_value,
+                       FromLegacyValue(&arena_, legacy_value));
+  ASSERT_TRUE(InstanceOf<ListValue>(modern_value));
+  EXPECT_FALSE(As<common_internal::LegacyListValue>(
+                   Cast<ListValue>(modern_value))
+                   .has_value());
+  EXPECT_EQ(modern_value.DebugString(), "[1, 2, 3]");
+}
+
+TEST_F(LegacyValueTest, MapValueViewedInPlace) {
+  ASSERT_OK_AND_ASSIGN(
+      auto builder,
+      value_manager().NewMapValueBuilder(
+          value_manager().CreateMapType(StringTypeView(), IntTypeView())));
+  ASSERT_OK(builder->Put(StringValue("a"), IntValue(1)));
+  ASSERT_OK(builder->Put(StringValue("b"), IntValue(2)));
+  Value map_value = std::move(*builder).Build();
+
+  ASSERT_OK_AND_ASSIGN(CelValue legacy_value,
+                       ToLegacyValue(&arena_, map_value));
+  ASSERT_TRUE(legacy_value.IsMap());
+  const auto& cel_map = *legacy_value.MapOrDie();
+  EXPECT_EQ(cel_map.size(), 2);
+  absl::optional<CelValue> entry = cel_map[CelValue::CreateStringView("b")];
+  ASSERT_TRUE(entry.has_value());
+  EXPECT_EQ(entry->Int64OrDie(), 2);
+  EXPECT_FALSE(cel_map[CelValue::CreateStringView("c")].has_value());
+  EXPECT_THAT(cel_map.Has(CelValue::CreateStringView("a")),
+              IsOkAndHolds(true));
+  ASSERT_OK_AND_ASSIGN(const CelList* keys, cel_map.ListKeys(&arena_));
+  EXPECT_EQ(keys->size(), 2);
+
+  ASSERT_OK_AND_ASSIGN(Value modern_value,
+                       FromLegacyValue(&arena_, legacy_value));
+  ASSERT_TRUE(InstanceOf<MapValue>(modern_value));
+  EXPECT_FALSE(
+      As<common_internal::LegacyMapValue>(Cast<MapValue>(modern_value))
+          .has_value());
+}
+
+}  // namespace
+}  // namespace cel
@@ -26,6 +26,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "common/casting.h"
+#include "common/internal/allocation_counter.h"
 #include "common/json.h"
 #include "common/memory.h"
 #include "common/native_type.h"
@@ -42,6 +43,13 @@ namespace cel {
 
 namespace {
 
+// The elements of a list are allocated by its vector rather than the memory
+// manager, so they are counted against any allocation budget when it is built.
+template <typename T>
+void CountElementAllocation(const std::vector<T>& elements) {
+  common_internal::CountAllocation(elements.capacity() * sizeof(T));
+}
+
 template <typename T>
 class TypedListValue final : public ParsedListValueInterface {
  public:
@@ -163,6 +171,7 @@ class ListValueBuilderImpl final : public ListValueBuilder {
   void Reserve(size_t capacity) override { elements_.reserve(capacity); }
 
   ListValue Build() && override {
+    CountElementAllocation(elements_);
     return ParsedListValue(
         memory_manager_.template MakeShared<TypedListValue<T>>(
             std::move(type_), std::move(elements_)));
@@ -200,6 +209,7 @@ class ListValueBuilderImpl<Value> final : public ListValueBuilder {
   void Reserve(size_t capacity) override { elements_.reserve(capacity); }
 
   ListValue Build() && override {
+    CountElementAllocation(elements_);
     return ParsedListValue(memory_manager_.MakeShared<TypedListValue<Value>>(
         std::move(type_), std::move(elements_)));
   }
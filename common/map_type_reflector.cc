@@ -23,7 +23,6 @@
 #include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
 #include "absl/container/flat_hash_map.h"
-#include "absl/hash/hash.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -33,6 +32,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "common/casting.h"
+#include "common/internal/allocation_counter.h"
 #include "common/json.h"
 #include "common/memory.h"
 #include "common/native_type.h"
@@ -60,13 +60,23 @@ using ValueFlatHashMapFor =
 template <typename T>
 struct MapValueKeyJson;
 
+// The entries of a map are allocated by its hash map rather than the memory
+// manager, so they are counted against any allocation budget when it is built.
+template <typename Map>
+void CountEntryAllocation(const Map& entries) {
+  common_internal::CountAllocation(entries.capacity() *
+                                   sizeof(typename Map::value_type));
+}
+
+// Every map hashes its keys with `MapKeyHash`, so that a hash passed to
+// `FindHashed` applies regardless of the key type of the map.
 template <typename T>
 struct MapValueKeyHash {
   // Used to enable heterogeneous operations in supporting containers.
   using is_transparent = void;
 
   size_t operator()(typename T::view_alternative_type value) const {
-    return absl::HashOf(value);
+    return MapKeyHash(value);
   }
 };
 
@@ -94,21 +104,7 @@ struct MapValueKeyHash<Value> {
   // Used to enable heterogeneous operations in supporting containers.
   using is_transparent = void;
 
-  size_t operator()(ValueView value) const {
-    switch (value.kind()) {
-      case ValueKind::kBool:
-        return absl::HashOf(ValueKind::kBool, Cast<BoolValueView>(value));
-      case ValueKind::kInt:
-        return absl::HashOf(ValueKind::kInt, Cast<IntValueView>(value));
-      case ValueKind::kUint:
-        return absl::HashOf(ValueKind::kUint, Cast<UintValueView>(value));
-      case ValueKind::kString:
-        return absl::HashOf(ValueKind::kString, Cast<StringValueView>(value));
-      default:
-        ABSL_DLOG(FATAL) << "Invalid map key value: " << value;
-        return 0;
-    }
-  }
+  size_t operator()(ValueView value) const { return MapKeyHash(value); }
 };
 
 template <>
@@ -424,6 +420,16 @@ class TypedMapValue final : public ParsedMapValueInterface {
     return absl::nullopt;
   }
 
+  absl::StatusOr<absl::optional<ValueView>> FindHashedImpl(
+      ValueManager&, ValueView key, size_t hash, Value&) const override {
+    if (auto entry =
+            entries_.find(Cast<typename K::view_alternative_type>(key), hash);
+        entry != entries_.end()) {
+      return ValueView{entry->second};
+    }
+    return absl::nullopt;
+  }
+
   absl::StatusOr<bool> HasImpl(ValueManager&, ValueView key) const override {
     if (auto entry =
             entries_.find(Cast<typename K::view_alternative_type>(key));
@@ -489,6 +495,7 @@ class MapValueBuilderImpl final : public MapValueBuilder {
   void Reserve(size_t capacity) override { entries_.reserve(capacity); }
 
   MapValue Build() && override {
+    CountEntryAllocation(entries_);
     return ParsedMapValue(memory_manager_.MakeShared<TypedMapValue<K, V>>(
         std::move(type_), std::move(entries_)));
   }
@@ -535,6 +542,7 @@ class MapValueBuilderImpl<Value, V> final : public MapValueBuilder {
   void Reserve(size_t capacity) override { entries_.reserve(capacity); }
 
   MapValue Build() && override {
+    CountEntryAllocation(entries_);
     return ParsedMapValue(memory_manager_.MakeShared<TypedMapValue<Value, V>>(
         std::move(type_), std::move(entries_)));
   }
@@ -582,6 +590,7 @@ class MapValueBuilderImpl<K, Value> final : public MapValueBuilder {
   void Reserve(size_t capacity) override { entries_.reserve(capacity); }
 
   MapValue Build() && override {
+    CountEntryAllocation(entries_);
     return ParsedMapValue(memory_manager_.MakeShared<TypedMapValue<K, Value>>(
         std::move(type_), std::move(entries_)));
   }
@@ -620,6 +629,7 @@ class MapValueBuilderImpl<Value, Value> final : public MapValueBuilder {
   void Reserve(size_t capacity) override { entries_.reserve(capacity); }
 
   MapValue Build() && override {
+    CountEntryAllocation(entries_);
     return ParsedMapValue(
         memory_manager_.MakeShared<TypedMapValue<Value, Value>>(
             std::move(type_), std::move(entries_)));
@@ -33,6 +33,7 @@
 #include "absl/log/absl_log.h"
 #include "absl/log/die_if_null.h"
 #include "absl/numeric/bits.h"
+#include "common/internal/allocation_counter.h"
 #include "common/native_type.h"
 #include "internal/align.h"
 #include "internal/new.h"
@@ -317,6 +318,7 @@ absl::Nonnull<void*> ReferenceCountingMemoryManager::Allocate(
   if (size == 0) {
     return nullptr;
   }
+  common_internal::CountAllocation(size);
   if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
     return ::operator new(size);
   }
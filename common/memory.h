@@ -16,6 +16,7 @@
 #define THIRD_PARTY_CEL_CPP_COMMON_MEMORY_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <type_traits>
@@ -30,6 +31,7 @@
 #include "absl/meta/type_traits.h"
 #include "absl/numeric/bits.h"
 #include "common/casting.h"
+#include "common/internal/allocation_counter.h"
 #include "common/internal/reference_count.h"
 #include "common/native_type.h"
 #include "internal/exceptions.h"
@@ -555,6 +557,7 @@ class ReferenceCountingMemoryManager final {
   template <typename T, typename... Args>
   static ABSL_MUST_USE_RESULT Unique<T> MakeUnique(Args&&... args) {
     using U = std::remove_const_t<T>;
+    common_internal::CountAllocation(sizeof(U));
     return Unique<T>(static_cast<T*>(new U(std::forward<Args>(args)...)),
                      MemoryManagement::kReferenceCounting);
   }
@@ -627,6 +630,7 @@ class PoolingMemoryManager {
     if (size == 0) {
       return nullptr;
     }
+    common_internal::CountAllocation(size);
     return AllocateImpl(size, alignment);
   }
 
@@ -1268,6 +1272,43 @@ struct CastTraits<To, From,
                                                   absl::remove_cvref_t<From>>>>
     : CompositionCastTraits<To, From> {};
 
+// `MemoryAccountingScope` counts the bytes allocated by memory managers on the
+// calling thread while it is alive, whether pooled or reference counted. It
+// lets callers bound or report the memory used by a unit of work, such as an
+// evaluation, without wrapping the memory manager it uses.
+//
+// Scopes may be nested, the bytes counted by an inner scope are added to the
+// enclosing scope when it is destroyed. Scopes must be destroyed on the thread
+// which created them, in the reverse order of their creation.
+class MemoryAccountingScope final {
+ public:
+  MemoryAccountingScope()
+      : enclosing_(common_internal::ThreadAllocationCounter()) {
+    common_internal::ThreadAllocationCounter() = &bytes_allocated_;
+  }
+
+  MemoryAccountingScope(const MemoryAccountingScope&) = delete;
+  MemoryAccountingScope(MemoryAccountingScope&&) = delete;
+  MemoryAccountingScope& operator=(const MemoryAccountingScope&) = delete;
+  MemoryAccountingScope& operator=(MemoryAccountingScope&&) = delete;
+
+  ~MemoryAccountingScope() {
+    ABSL_DCHECK_EQ(common_internal::ThreadAllocationCounter(),
+                   &bytes_allocated_);
+    common_internal::ThreadAllocationCounter() = enclosing_;
+    if (enclosing_ != nullptr) {
+      *enclosing_ += bytes_allocated_;
+    }
+  }
+
+  // Returns the number of bytes allocated since this scope was created.
+  uint64_t bytes_allocated() const { return bytes_allocated_; }
+
+ private:
+  absl::Nullable<uint64_t*> const enclosing_;
+  uint64_t bytes_allocated_ = 0;
+};
+
 namespace common_internal {
 
 template <typename T>
@@ -220,6 +220,23 @@ TEST_P(MemoryManagerTest, AllocateAndDeallocateOveraligned) {
   EXPECT_THAT(memory_manager().Deallocate(ptr, kSize, kAlignment), IsTrue());
 }
 
+TEST_P(MemoryManagerTest, MemoryAccountingScope) {
+  constexpr size_t kAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+  MemoryAccountingScope outer;
+  void* outer_ptr = memory_manager().Allocate(64, kAlignment);
+  void* inner_ptr;
+  {
+    MemoryAccountingScope inner;
+    inner_ptr = memory_manager().Allocate(128, kAlignment);
+    EXPECT_EQ(inner.bytes_allocated(), 128);
+    EXPECT_EQ(outer.bytes_allocated(), 64);
+  }
+  EXPECT_EQ(outer.bytes_allocated(), 192);
+  memory_manager().Deallocate(inner_ptr, 128, kAlignment);
+  memory_manager().Deallocate(outer_ptr, 64, kAlignment);
+  EXPECT_EQ(outer.bytes_allocated(), 192);
+}
+
 class Object {
  public:
   Object() : deleted_(nullptr) {}
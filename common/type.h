@@ -856,8 +856,10 @@ inline const Type& ListType::element() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
   return data_->element;
 }
 
+// Types which share their data, such as those interned by a type factory,
+// compare equal without comparing their parameters.
 inline bool operator==(const ListType& lhs, const ListType& rhs) {
-  return &lhs == &rhs || lhs.element() == rhs.element();
+  return &lhs.element() == &rhs.element() || lhs.element() == rhs.element();
 }
 
 template <typename H>
@@ -878,7 +880,7 @@ inline absl::Span<const Type> ListTypeView::parameters() const {
 inline const Type& ListTypeView::element() const { return data_->element; }
 
 inline bool operator==(ListTypeView lhs, ListTypeView rhs) {
-  return lhs.element() == rhs.element();
+  return &lhs.element() == &rhs.element() || lhs.element() == rhs.element();
 }
 
 template <typename H>
@@ -908,7 +910,8 @@ inline const Type& MapType::value() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
 }
 
 inline bool operator==(const MapType& lhs, const MapType& rhs) {
-  return &lhs == &rhs || (lhs.key() == rhs.key() && lhs.value() == rhs.value());
+  return &lhs.key() == &rhs.key() ||
+         (lhs.key() == rhs.key() && lhs.value() == rhs.value());
 }
 
 template <typename H>
@@ -933,7 +936,8 @@ inline const Type& MapTypeView::value() const {
 }
 
 inline bool operator==(MapTypeView lhs, MapTypeView rhs) {
-  return lhs.key() == rhs.key() && lhs.value() == rhs.value();
+  return &lhs.key() == &rhs.key() ||
+         (lhs.key() == rhs.key() && lhs.value() == rhs.value());
 }
 
 template <typename H>
@@ -17,8 +17,11 @@
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <tuple>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "common/memory.h"
 #include "common/type.h"
@@ -143,6 +146,63 @@ TEST_P(TypeFactoryTest, MapType) {
             ProcessLocalTypeCache::Get()->GetStringDynMapType());
 }
 
+TEST_P(TypeFactoryTest, JsonContainerTypesAreCached) {
+  auto string_dyn_map_type = type_factory().GetStringDynMapType();
+  auto dyn_list_type = type_factory().GetDynListType();
+  EXPECT_TRUE(ProcessLocalTypeCache::Get()
+                  ->FindListType(string_dyn_map_type)
+                  .has_value());
+  EXPECT_TRUE(
+      ProcessLocalTypeCache::Get()->FindListType(dyn_list_type).has_value());
+  EXPECT_TRUE(ProcessLocalTypeCache::Get()
+                  ->FindMapType(StringTypeView(), string_dyn_map_type)
+                  .has_value());
+  EXPECT_TRUE(ProcessLocalTypeCache::Get()
+                  ->FindMapType(StringTypeView(), dyn_list_type)
+                  .has_value());
+  EXPECT_THAT(type_factory().CreateListType(string_dyn_map_type),
+              Eq(ListType(*ProcessLocalTypeCache::Get()->FindListType(
+                  string_dyn_map_type))));
+}
+
+TEST_P(TypeFactoryTest, ManyTypes) {
+  // Enough types to grow the tables of the type manager a few times.
+  std::vector<ListType> list_types;
+  for (int i = 0; i < 200; ++i) {
+    list_types.push_back(type_factory().CreateListType(
+        type_factory().CreateStructType(absl::StrCat("test.Struct", i))));
+  }
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_THAT(type_factory().CreateListType(type_factory().CreateStructType(
+                    absl::StrCat("test.Struct", i))),
+                Eq(list_types[i]));
+  }
+}
+
+TEST_P(TypeFactoryTest, ConcurrentCreate) {
+  if (thread_safety() != ThreadSafety::kSafe) {
+    GTEST_SKIP() << "type manager is not thread safe";
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([this]() {
+      for (int i = 0; i < 100; ++i) {
+        auto struct_type =
+            type_factory().CreateStructType(absl::StrCat("test.Struct", i));
+        auto map_type =
+            type_factory().CreateMapType(StringType(), struct_type);
+        EXPECT_EQ(map_type.value(), struct_type);
+        EXPECT_THAT(type_factory().CreateOpaqueType("test.Opaque", {map_type}),
+                    Eq(type_factory().CreateOpaqueType("test.Opaque",
+                                                       {map_type})));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST_P(TypeFactoryTest, MapTypeInvalidKeyType) {
   EXPECT_DEBUG_DEATH(type_factory().CreateMapType(DoubleType(), BytesType()),
                      _);
@@ -81,8 +81,10 @@ class StructType final {
 
 inline void swap(StructType& lhs, StructType& rhs) noexcept { lhs.swap(rhs); }
 
+// Struct types interned by a type factory share their name, so this is
+// usually decided by comparing the name's address.
 inline bool operator==(const StructType& lhs, const StructType& rhs) {
-  return lhs.name() == rhs.name();
+  return lhs.name().data() == rhs.name().data() || lhs.name() == rhs.name();
 }
 
 inline bool operator!=(const StructType& lhs, const StructType& rhs) {
@@ -153,7 +155,7 @@ inline void swap(StructTypeView& lhs, StructTypeView& rhs) noexcept {
 }
 
 inline bool operator==(StructTypeView lhs, StructTypeView rhs) {
-  return lhs.name() == rhs.name();
+  return lhs.name().data() == rhs.name().data() || lhs.name() == rhs.name();
 }
 
 inline bool operator!=(StructTypeView lhs, StructTypeView rhs) {
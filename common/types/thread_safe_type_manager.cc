@@ -17,7 +17,6 @@
 #include <utility>
 
 #include "absl/strings/string_view.h"
-#include "absl/synchronization/mutex.h"
 #include "common/sized_input_view.h"
 #include "common/type.h"
 #include "common/types/type_cache.h"
@@ -25,44 +24,24 @@
 namespace cel::common_internal {
 
 ListType ThreadSafeTypeManager::CreateListTypeImpl(TypeView element) {
-  {
-    absl::ReaderMutexLock lock(&list_types_mutex_);
-    if (auto list_type = list_types_.find(element);
-        list_type != list_types_.end()) {
-      return list_type->second;
-    }
-  }
-  ListType list_type(GetMemoryManager(), Type(element));
-  absl::WriterMutexLock lock(&list_types_mutex_);
-  return list_types_.insert({list_type.element(), list_type}).first->second;
+  return list_types_.FindOrInsert(
+      element, [&]() { return ListType(GetMemoryManager(), Type(element)); },
+      [](const ListType& list_type) { return list_type.element(); });
 }
 
 MapType ThreadSafeTypeManager::CreateMapTypeImpl(TypeView key, TypeView value) {
-  {
-    absl::ReaderMutexLock lock(&map_types_mutex_);
-    if (auto map_type = map_types_.find(std::make_pair(key, value));
-        map_type != map_types_.end()) {
-      return map_type->second;
-    }
-  }
-  MapType map_type(GetMemoryManager(), Type(key), Type(value));
-  absl::WriterMutexLock lock(&map_types_mutex_);
-  return map_types_
-      .insert({std::make_pair(map_type.key(), map_type.value()), map_type})
-      .first->second;
+  return map_types_.FindOrInsert(
+      std::make_pair(key, value),
+      [&]() { return MapType(GetMemoryManager(), Type(key), Type(value)); },
+      [](const MapType& map_type) {
+        return std::make_pair(map_type.key(), map_type.value());
+      });
 }
 
 StructType ThreadSafeTypeManager::CreateStructTypeImpl(absl::string_view name) {
-  {
-    absl::ReaderMutexLock lock(&struct_types_mutex_);
-    if (auto struct_type = struct_types_.find(name);
-        struct_type != struct_types_.end()) {
-      return struct_type->second;
-    }
-  }
-  StructType struct_type(GetMemoryManager(), name);
-  absl::WriterMutexLock lock(&struct_types_mutex_);
-  return struct_types_.insert({struct_type.name(), struct_type}).first->second;
+  return struct_types_.FindOrInsert(
+      name, [&]() { return StructType(GetMemoryManager(), name); },
+      [](const StructType& struct_type) { return struct_type.name(); });
 }
 
 OpaqueType ThreadSafeTypeManager::CreateOpaqueTypeImpl(
@@ -72,21 +51,13 @@ OpaqueType ThreadSafeTypeManager::CreateOpaqueTypeImpl(
       opaque_type.has_value()) {
     return OpaqueType(*opaque_type);
   }
-  {
-    absl::ReaderMutexLock lock(&opaque_types_mutex_);
-    if (auto opaque_type = opaque_types_.find(
-            OpaqueTypeKeyView{.name = name, .parameters = parameters});
-        opaque_type != opaque_types_.end()) {
-      return opaque_type->second;
-    }
-  }
-  OpaqueType opaque_type(GetMemoryManager(), name, parameters);
-  absl::WriterMutexLock lock(&opaque_types_mutex_);
-  return opaque_types_
-      .insert({OpaqueTypeKey{.name = opaque_type.name(),
-                             .parameters = opaque_type.parameters()},
-               opaque_type})
-      .first->second;
+  return opaque_types_.FindOrInsert(
+      OpaqueTypeKeyView{.name = name, .parameters = parameters},
+      [&]() { return OpaqueType(GetMemoryManager(), name, parameters); },
+      [](const OpaqueType& opaque_type) {
+        return OpaqueTypeKey{.name = opaque_type.name(),
+                             .parameters = opaque_type.parameters()};
+      });
 }
 
 }  // namespace cel::common_internal
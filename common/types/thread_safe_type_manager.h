@@ -17,20 +17,24 @@
 #ifndef THIRD_PARTY_CEL_CPP_COMMON_TYPES_THREAD_SAFE_TYPE_MANAGER_H_
 #define THIRD_PARTY_CEL_CPP_COMMON_TYPES_THREAD_SAFE_TYPE_MANAGER_H_
 
+#include <cstddef>
+#include <functional>
 #include <utility>
 
-#include "absl/base/thread_annotations.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/string_view.h"
-#include "absl/synchronization/mutex.h"
 #include "common/memory.h"
 #include "common/sized_input_view.h"
 #include "common/type.h"
 #include "common/type_introspector.h"
 #include "common/type_manager.h"
 #include "common/types/type_cache.h"
+#include "internal/intern_table.h"
 
 namespace cel::common_internal {
 
+// Type manager which may be shared between threads. Interned types are found
+// without taking locks, see internal::InternTable.
 class ThreadSafeTypeManager : public virtual TypeManager {
  public:
   explicit ThreadSafeTypeManager(MemoryManagerRef memory_manager,
@@ -40,6 +44,13 @@ class ThreadSafeTypeManager : public virtual TypeManager {
 
   MemoryManagerRef GetMemoryManager() const final { return memory_manager_; }
 
+  // Number of times a mutex was taken to intern a type, summed over the type
+  // kinds. Lookups of types interned before take no locks.
+  size_t lock_count() const {
+    return list_types_.lock_count() + map_types_.lock_count() +
+           struct_types_.lock_count() + opaque_types_.lock_count();
+  }
+
  protected:
   TypeIntrospector& GetTypeIntrospector() const final {
     return *type_introspector_;
@@ -57,14 +68,19 @@ class ThreadSafeTypeManager : public virtual TypeManager {
 
   MemoryManagerRef memory_manager_;
   Shared<TypeIntrospector> type_introspector_;
-  absl::Mutex list_types_mutex_;
-  ListTypeCacheMap list_types_ ABSL_GUARDED_BY(list_types_mutex_);
-  absl::Mutex map_types_mutex_;
-  MapTypeCacheMap map_types_ ABSL_GUARDED_BY(map_types_mutex_);
-  absl::Mutex struct_types_mutex_;
-  StructTypeCacheMap struct_types_ ABSL_GUARDED_BY(struct_types_mutex_);
-  absl::Mutex opaque_types_mutex_;
-  OpaqueTypeCacheMap opaque_types_ ABSL_GUARDED_BY(opaque_types_mutex_);
+  internal::InternTable<TypeView, ListType, absl::Hash<TypeView>,
+                        std::equal_to<>>
+      list_types_;
+  internal::InternTable<std::pair<TypeView, TypeView>, MapType,
+                        absl::Hash<std::pair<TypeView, TypeView>>,
+                        std::equal_to<>>
+      map_types_;
+  internal::InternTable<absl::string_view, StructType,
+                        absl::Hash<absl::string_view>, std::equal_to<>>
+      struct_types_;
+  internal::InternTable<OpaqueTypeKey, OpaqueType, OpaqueTypeKeyHash,
+                        OpaqueTypeKeyEqualTo>
+      opaque_types_;
 };
 
 }  // namespace cel::common_internal
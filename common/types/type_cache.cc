@@ -102,6 +102,7 @@ ProcessLocalTypeCache::ProcessLocalTypeCache() {
                 IntType, IntWrapperType, NullType, StringType,
                 StringWrapperType, TimestampType, TypeType, UintType,
                 UintWrapperType, UnknownType>(MemoryManagerRef::Unmanaged());
+  PopulateJsonContainerTypes(MemoryManagerRef::Unmanaged());
   dyn_list_type_ = FindListType(DynTypeView());
   ABSL_DCHECK(dyn_list_type_.has_value());
   dyn_dyn_map_type_ = FindMapType(DynTypeView(), DynTypeView());
@@ -148,6 +149,21 @@ void ProcessLocalTypeCache::PopulateOptionalTypes(
   }
 }
 
+void ProcessLocalTypeCache::PopulateJsonContainerTypes(
+    MemoryManagerRef memory_manager) {
+  // Nested containers of decoded JSON and protobuf structs, so that they are
+  // shared rather than created by each type manager.
+  ListTypeView dyn_list_type = *FindListType(DynTypeView());
+  MapTypeView string_dyn_map_type =
+      *FindMapType(StringTypeView(), DynTypeView());
+  InsertListType(ListType(memory_manager, ListType(dyn_list_type)));
+  InsertListType(ListType(memory_manager, MapType(string_dyn_map_type)));
+  InsertMapType(
+      MapType(memory_manager, StringType(), ListType(dyn_list_type)));
+  InsertMapType(
+      MapType(memory_manager, StringType(), MapType(string_dyn_map_type)));
+}
+
 template <typename T, typename... Ts>
 void ProcessLocalTypeCache::DoPopulateListTypes(
     MemoryManagerRef memory_manager) {
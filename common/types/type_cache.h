@@ -162,6 +162,8 @@ class ProcessLocalTypeCache final {
   template <typename... Ts>
   void PopulateOptionalTypes(MemoryManagerRef memory_manager);
 
+  void PopulateJsonContainerTypes(MemoryManagerRef memory_manager);
+
   template <typename T, typename... Ts>
   void DoPopulateListTypes(MemoryManagerRef memory_manager);
 
@@ -15,6 +15,7 @@
 #include "common/value.h"
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <ostream>
@@ -23,6 +24,7 @@
 #include <utility>
 
 #include "absl/base/nullability.h"
+#include "absl/hash/hash.h"
 #include "absl/log/absl_check.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/status.h"
@@ -32,9 +34,11 @@
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "common/any.h"
+#include "common/casting.h"
 #include "common/json.h"
 #include "common/type.h"
 #include "common/value_kind.h"
+#include "common/value_manager.h"
 #include "common/values/values.h"
 #include "internal/status_macros.h"
 #include "runtime/runtime_options.h"
@@ -933,6 +937,34 @@ absl::StatusOr<std::pair<Value, bool>> MapValue::Find(
   return std::pair{Value{result.first}, result.second};
 }
 
+absl::StatusOr<std::pair<ValueView, bool>> MapValue::FindHashed(
+    ValueManager& value_manager, ValueView key, size_t hash,
+    Value& scratch) const {
+  return absl::visit(
+      [&value_manager, key, hash, &scratch](const auto& alternative)
+          -> absl::StatusOr<std::pair<ValueView, bool>> {
+        return alternative.FindHashed(value_manager, key, hash, scratch);
+      },
+      variant_);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>> MapValue::FindByString(
+    ValueManager& value_manager, absl::string_view key, size_t hash,
+    Value& scratch) const {
+  return absl::visit(
+      [&value_manager, key, hash, &scratch](const auto& alternative)
+          -> absl::StatusOr<std::pair<ValueView, bool>> {
+        return alternative.FindByString(value_manager, key, hash, scratch);
+      },
+      variant_);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>> MapValue::FindByString(
+    ValueManager& value_manager, absl::string_view key, Value& scratch) const {
+  return FindByString(value_manager, key, MapKeyHash(StringValueView(key)),
+                      scratch);
+}
+
 absl::StatusOr<ValueView> MapValue::Has(ValueManager& value_manager,
                                         ValueView key, Value& scratch) const {
   return absl::visit(
@@ -1032,6 +1064,34 @@ absl::StatusOr<std::pair<Value, bool>> MapValueView::Find(
   return std::pair{Value{result.first}, result.second};
 }
 
+absl::StatusOr<std::pair<ValueView, bool>> MapValueView::FindHashed(
+    ValueManager& value_manager, ValueView key, size_t hash,
+    Value& scratch) const {
+  return absl::visit(
+      [&value_manager, key, hash, &scratch](
+          auto alternative) -> absl::StatusOr<std::pair<ValueView, bool>> {
+        return alternative.FindHashed(value_manager, key, hash, scratch);
+      },
+      variant_);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>> MapValueView::FindByString(
+    ValueManager& value_manager, absl::string_view key, size_t hash,
+    Value& scratch) const {
+  return absl::visit(
+      [&value_manager, key, hash, &scratch](
+          auto alternative) -> absl::StatusOr<std::pair<ValueView, bool>> {
+        return alternative.FindByString(value_manager, key, hash, scratch);
+      },
+      variant_);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>> MapValueView::FindByString(
+    ValueManager& value_manager, absl::string_view key, Value& scratch) const {
+  return FindByString(value_manager, key, MapKeyHash(StringValueView(key)),
+                      scratch);
+}
+
 absl::StatusOr<ValueView> MapValueView::Has(ValueManager& value_manager,
                                             ValueView key,
                                             Value& scratch) const {
@@ -1336,4 +1396,148 @@ absl::StatusOr<std::pair<Value, int>> StructValueView::Qualify(
   return std::pair{Value{result.first}, result.second};
 }
 
+namespace {
+
+// Every comparison involving a double is made in double precision, so all
+// numbers hash as the double they convert to. This also covers `-0.0 == 0.0`.
+size_t NumberHash(double value) {
+  return absl::HashOf(ValueKind::kDouble, value == 0.0 ? 0.0 : value);
+}
+
+// Zero marks hashes which were not computed yet in the caches of parsed lists
+// and maps, so container hashes are never zero.
+size_t NonZeroHash(size_t hash) { return hash == 0 ? 1 : hash; }
+
+absl::StatusOr<size_t> ListValueHash(ValueManager& value_manager,
+                                     ListValueView list) {
+  CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+  size_t hash = absl::HashOf(ValueKind::kList, size);
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        CEL_ASSIGN_OR_RETURN(auto element_hash,
+                             ValueHash(value_manager, element));
+        hash = absl::HashOf(hash, element_hash);
+        return true;
+      }));
+  return NonZeroHash(hash);
+}
+
+// Entries are combined by addition, since equal maps may iterate in different
+// orders.
+absl::StatusOr<size_t> MapValueHash(ValueManager& value_manager,
+                                    MapValueView map) {
+  CEL_ASSIGN_OR_RETURN(auto size, map.Size());
+  size_t entries_hash = 0;
+  CEL_RETURN_IF_ERROR(map.ForEach(
+      value_manager,
+      [&](ValueView key, ValueView value) -> absl::StatusOr<bool> {
+        CEL_ASSIGN_OR_RETURN(auto key_hash, ValueHash(value_manager, key));
+        CEL_ASSIGN_OR_RETURN(auto value_hash, ValueHash(value_manager, value));
+        entries_hash += absl::HashOf(key_hash, value_hash);
+        return true;
+      }));
+  return NonZeroHash(absl::HashOf(ValueKind::kMap, size, entries_hash));
+}
+
+absl::StatusOr<size_t> StructValueHash(ValueManager& value_manager,
+                                       StructValueView struct_value) {
+  size_t fields_hash = 0;
+  CEL_RETURN_IF_ERROR(struct_value.ForEachField(
+      value_manager,
+      [&](absl::string_view name, ValueView value) -> absl::StatusOr<bool> {
+        CEL_ASSIGN_OR_RETURN(auto value_hash, ValueHash(value_manager, value));
+        fields_hash += absl::HashOf(name, value_hash);
+        return true;
+      }));
+  return absl::HashOf(ValueKind::kStruct, struct_value.GetTypeName(),
+                      fields_hash);
+}
+
+}  // namespace
+
+namespace common_internal {
+
+size_t ValueShallowHash(ValueView value) {
+  switch (value.kind()) {
+    case ValueKind::kBool:
+      return absl::HashOf(ValueKind::kBool,
+                          Cast<BoolValueView>(value).NativeValue());
+    case ValueKind::kInt:
+      return NumberHash(
+          static_cast<double>(Cast<IntValueView>(value).NativeValue()));
+    case ValueKind::kUint:
+      return NumberHash(
+          static_cast<double>(Cast<UintValueView>(value).NativeValue()));
+    case ValueKind::kDouble:
+      return NumberHash(Cast<DoubleValueView>(value).NativeValue());
+    case ValueKind::kString:
+      return absl::HashOf(
+          ValueKind::kString,
+          AsSharedByteStringView(Cast<StringValueView>(value)).ContentHash());
+    case ValueKind::kBytes:
+      return absl::HashOf(
+          ValueKind::kBytes,
+          AsSharedByteStringView(Cast<BytesValueView>(value)).ContentHash());
+    case ValueKind::kDuration:
+      return absl::HashOf(ValueKind::kDuration,
+                          Cast<DurationValueView>(value).NativeValue());
+    case ValueKind::kTimestamp:
+      return absl::HashOf(ValueKind::kTimestamp,
+                          Cast<TimestampValueView>(value).NativeValue());
+    case ValueKind::kType:
+      return absl::HashOf(ValueKind::kType, Cast<TypeValueView>(value).name());
+    case ValueKind::kList:
+      return absl::HashOf(ValueKind::kList,
+                          Cast<ListValueView>(value).Size().value_or(0));
+    case ValueKind::kMap:
+      return absl::HashOf(ValueKind::kMap,
+                          Cast<MapValueView>(value).Size().value_or(0));
+    case ValueKind::kStruct:
+    case ValueKind::kOpaque:
+      return absl::HashOf(value.kind(), value.GetTypeName());
+    default:
+      return absl::HashOf(value.kind());
+  }
+}
+
+}  // namespace common_internal
+
+absl::StatusOr<size_t> ValueHash(ValueManager& value_manager,
+                                 ValueView value) {
+  switch (value.kind()) {
+    case ValueKind::kList: {
+      auto parsed = As<ParsedListValueView>(value);
+      if (!parsed) {
+        return ListValueHash(value_manager, Cast<ListValueView>(value));
+      }
+      const auto& interface = **parsed;
+      if (size_t hash = interface.hash_.load(std::memory_order_relaxed);
+          hash != 0) {
+        return hash;
+      }
+      CEL_ASSIGN_OR_RETURN(auto hash, ListValueHash(value_manager, *parsed));
+      interface.hash_.store(hash, std::memory_order_relaxed);
+      return hash;
+    }
+    case ValueKind::kMap: {
+      auto parsed = As<ParsedMapValueView>(value);
+      if (!parsed) {
+        return MapValueHash(value_manager, Cast<MapValueView>(value));
+      }
+      const auto& interface = **parsed;
+      if (size_t hash = interface.hash_.load(std::memory_order_relaxed);
+          hash != 0) {
+        return hash;
+      }
+      CEL_ASSIGN_OR_RETURN(auto hash, MapValueHash(value_manager, *parsed));
+      interface.hash_.store(hash, std::memory_order_relaxed);
+      return hash;
+    }
+    case ValueKind::kStruct:
+      return StructValueHash(value_manager, Cast<StructValueView>(value));
+    default:
+      return common_internal::ValueShallowHash(value);
+  }
+}
+
 }  // namespace cel
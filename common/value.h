@@ -744,6 +744,31 @@ class ValueView final {
 
 inline void swap(ValueView& lhs, ValueView& rhs) noexcept { lhs.swap(rhs); }
 
+namespace common_internal {
+size_t ValueShallowHash(ValueView value);
+}  // namespace common_internal
+
+// `absl::Hash` support for values, consistent with heterogeneous equality:
+// values which are equal according to `==` have the same hash, including
+// numbers of different kinds (`1 == 1u == 1.0`). Elements of lists and maps
+// and fields of structs can only be accessed through a `ValueManager`, so they
+// do not contribute to this hash. Use `ValueHash` to hash those too.
+template <typename H>
+H AbslHashValue(H state, ValueView value) {
+  return H::combine(std::move(state), common_internal::ValueShallowHash(value));
+}
+
+template <typename H>
+H AbslHashValue(H state, const Value& value) {
+  return H::combine(std::move(state), common_internal::ValueShallowHash(value));
+}
+
+// Returns a hash of `value` which is consistent with heterogeneous equality,
+// like `absl::Hash`, but which also covers the elements of lists and maps and
+// the fields of structs. Lists and maps created by this library are
+// immutable, so their hashes are computed once and then cached.
+absl::StatusOr<size_t> ValueHash(ValueManager& value_manager, ValueView value);
+
 template <>
 struct NativeTypeTraits<ValueView> final {
   static NativeTypeId Id(ValueView value) {
@@ -1030,6 +1055,18 @@ inline absl::StatusOr<std::pair<ValueView, bool>> ParsedMapValue::Find(
   return interface_->Find(value_manager, key, scratch);
 }
 
+inline absl::StatusOr<std::pair<ValueView, bool>> ParsedMapValue::FindHashed(
+    ValueManager& value_manager, ValueView key, size_t hash,
+    Value& scratch) const {
+  return interface_->FindHashed(value_manager, key, hash, scratch);
+}
+
+inline absl::StatusOr<std::pair<ValueView, bool>> ParsedMapValue::FindByString(
+    ValueManager& value_manager, absl::string_view key, size_t hash,
+    Value& scratch) const {
+  return interface_->FindByString(value_manager, key, hash, scratch);
+}
+
 inline absl::StatusOr<ValueView> ParsedMapValue::Has(
     ValueManager& value_manager, ValueView key, Value& scratch) const {
   return interface_->Has(value_manager, key, scratch);
@@ -1065,6 +1102,19 @@ inline absl::StatusOr<std::pair<ValueView, bool>> ParsedMapValueView::Find(
   return interface_->Find(value_manager, key, scratch);
 }
 
+inline absl::StatusOr<std::pair<ValueView, bool>>
+ParsedMapValueView::FindHashed(ValueManager& value_manager, ValueView key,
+                               size_t hash, Value& scratch) const {
+  return interface_->FindHashed(value_manager, key, hash, scratch);
+}
+
+inline absl::StatusOr<std::pair<ValueView, bool>>
+ParsedMapValueView::FindByString(ValueManager& value_manager,
+                                 absl::string_view key, size_t hash,
+                                 Value& scratch) const {
+  return interface_->FindByString(value_manager, key, hash, scratch);
+}
+
 inline absl::StatusOr<ValueView> ParsedMapValueView::Has(
     ValueManager& value_manager, ValueView key, Value& scratch) const {
   return interface_->Has(value_manager, key, scratch);
@@ -36,6 +36,7 @@
 #include "common/casting.h"
 #include "common/internal/arena_string.h"
 #include "common/internal/reference_count.h"
+#include "common/internal/shared_byte_string.h"
 #include "common/json.h"
 #include "common/memory.h"
 #include "common/native_type.h"
@@ -262,6 +263,15 @@ class JsonMapValue final : public ParsedMapValueInterface {
         }));
   }
 
+  absl::StatusOr<absl::optional<ValueView>> FindStringImpl(
+      ValueManager& value_manager, absl::string_view key, size_t,
+      Value& scratch) const override {
+    if (auto entry = object_.find(key); entry != object_.end()) {
+      return JsonToValue(entry->second, value_manager, scratch);
+    }
+    return absl::nullopt;
+  }
+
   // Called by `Has` after performing various argument checks.
   absl::StatusOr<bool> HasImpl(ValueManager&, ValueView key) const override {
     return Cast<StringValueView>(key).NativeValue(absl::Overload(
@@ -397,6 +407,11 @@ static void StringDestructor(void* string) {
 }
 
 absl::StatusOr<BytesValue> ValueFactory::CreateBytesValue(std::string value) {
+  if (value.size() <= common_internal::kSharedByteStringInlineCapacity) {
+    // Small values are stored inline, which needs neither the arena nor a
+    // reference count.
+    return BytesValue{common_internal::SharedByteString::Copy(value)};
+  }
   auto memory_manager = GetMemoryManager();
   switch (memory_manager.memory_management()) {
     case MemoryManagement::kPooling: {
@@ -417,6 +432,9 @@ absl::StatusOr<BytesValue> ValueFactory::CreateBytesValue(std::string value) {
 }
 
 StringValue ValueFactory::CreateUncheckedStringValue(std::string value) {
+  if (value.size() <= common_internal::kSharedByteStringInlineCapacity) {
+    return StringValue{common_internal::SharedByteString::Copy(value)};
+  }
   auto memory_manager = GetMemoryManager();
   switch (memory_manager.memory_management()) {
     case MemoryManagement::kPooling: {
@@ -442,7 +460,12 @@ absl::StatusOr<StringValue> ValueFactory::CreateStringValue(std::string value) {
     return absl::InvalidArgumentError(
         "Illegal byte sequence in UTF-8 encoded string");
   }
-  return CreateUncheckedStringValue(std::move(value));
+  const bool is_ascii = count == value.size();
+  StringValue result = CreateUncheckedStringValue(std::move(value));
+  if (is_ascii) {
+    common_internal::MarkAsciiStringValue(result);
+  }
+  return result;
 }
 
 absl::StatusOr<StringValue> ValueFactory::CreateStringValue(absl::Cord value) {
@@ -451,7 +474,12 @@ absl::StatusOr<StringValue> ValueFactory::CreateStringValue(absl::Cord value) {
     return absl::InvalidArgumentError(
         "Illegal byte sequence in UTF-8 encoded string");
   }
-  return StringValue(std::move(value));
+  const bool is_ascii = count == value.size();
+  StringValue result(std::move(value));
+  if (is_ascii) {
+    common_internal::MarkAsciiStringValue(result);
+  }
+  return result;
 }
 
 absl::StatusOr<DurationValue> ValueFactory::CreateDurationValue(
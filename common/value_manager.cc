@@ -24,8 +24,10 @@
 #include "common/json.h"
 #include "common/memory.h"
 #include "common/type_reflector.h"
+#include "common/value.h"
 #include "common/values/thread_compatible_value_manager.h"
 #include "common/values/thread_safe_value_manager.h"
+#include "common/values/value_cache.h"
 #include "internal/status_macros.h"
 
 namespace cel {
@@ -43,6 +45,16 @@ Shared<ValueManager> NewThreadSafeValueManager(
       memory_manager, std::move(type_reflector));
 }
 
+TypeValue ValueManager::GetTypeValue(ValueView value) {
+  if (auto type_value =
+          common_internal::ProcessLocalValueCache::Get()->GetTypeValue(
+              value.kind());
+      type_value.has_value()) {
+    return TypeValue(*type_value);
+  }
+  return CreateTypeValue(value.GetType(*this));
+}
+
 absl::StatusOr<Json> ValueManager::ConvertToJson(absl::string_view type_url,
                                                  const absl::Cord& value) {
   CEL_ASSIGN_OR_RETURN(auto deserialized_value,
@@ -70,6 +70,11 @@ class ValueManager : public virtual ValueFactory,
     return GetTypeReflector().FindValue(*this, name);
   }
 
+  // Returns the type of `value`, as CEL's `type(value)`. The types of
+  // primitive values are process-wide constants, so this doesn't allocate or
+  // dispatch on the value for them.
+  TypeValue GetTypeValue(ValueView value);
+
   // See `TypeReflector::DeserializeValue`.
   absl::StatusOr<absl::optional<Value>> DeserializeValue(
       absl::string_view type_url, const absl::Cord& value) {
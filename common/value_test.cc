@@ -15,14 +15,23 @@
 #include "common/value.h"
 
 #include <sstream>
+#include <utility>
 
+#include "absl/hash/hash.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "common/memory.h"
 #include "common/native_type.h"
+#include "common/value_testing.h"
+#include "internal/status_macros.h"
 #include "internal/testing.h"
 
 namespace cel {
 namespace {
 
 using testing::_;
+using testing::Ne;
+using cel::internal::IsOkAndHolds;
 
 TEST(Value, KindDebugDeath) {
   Value value;
@@ -76,5 +85,97 @@ TEST(ValueView, NativeValueIdDebugDeath) {
   EXPECT_DEBUG_DEATH(static_cast<void>(NativeTypeId::Of(value)), _);
 }
 
+TEST(Value, HashFollowsHeterogeneousEquality) {
+  EXPECT_EQ(absl::HashOf(Value(IntValue(1))),
+            absl::HashOf(Value(UintValue(1))));
+  EXPECT_EQ(absl::HashOf(Value(IntValue(1))),
+            absl::HashOf(Value(DoubleValue(1.0))));
+  EXPECT_EQ(absl::HashOf(ValueView(IntValueView(-2))),
+            absl::HashOf(Value(DoubleValue(-2.0))));
+  EXPECT_EQ(absl::HashOf(Value(DoubleValue(0.0))),
+            absl::HashOf(Value(DoubleValue(-0.0))));
+  EXPECT_EQ(absl::HashOf(Value(StringValue("foo"))),
+            absl::HashOf(Value(StringValue(absl::Cord("foo")))));
+  EXPECT_NE(absl::HashOf(Value(IntValue(1))), absl::HashOf(Value(IntValue(2))));
+  EXPECT_NE(absl::HashOf(Value(IntValue(1))),
+            absl::HashOf(Value(BoolValue(true))));
+  EXPECT_NE(absl::HashOf(Value(StringValue("foo"))),
+            absl::HashOf(Value(BytesValue("foo"))));
+}
+
+class ValueHashTest : public common_internal::ThreadCompatibleValueTest<> {
+ public:
+  template <typename... Args>
+  absl::StatusOr<ListValue> NewListValue(Args&&... args) {
+    CEL_ASSIGN_OR_RETURN(auto builder, value_manager().NewListValueBuilder(
+                                           type_factory().GetDynListType()));
+    (static_cast<void>(builder->Add(std::forward<Args>(args))), ...);
+    return std::move(*builder).Build();
+  }
+
+  template <typename... Args>
+  absl::StatusOr<MapValue> NewMapValue(Args&&... args) {
+    CEL_ASSIGN_OR_RETURN(auto builder, value_manager().NewMapValueBuilder(
+                                           type_factory().GetDynDynMapType()));
+    (static_cast<void>(builder->Put(std::forward<Args>(args).first,
+                                    std::forward<Args>(args).second)),
+     ...);
+    return std::move(*builder).Build();
+  }
+
+  absl::StatusOr<size_t> Hash(ValueView value) {
+    return ValueHash(value_manager(), value);
+  }
+};
+
+TEST_P(ValueHashTest, Primitives) {
+  ASSERT_OK_AND_ASSIGN(auto hash, Hash(IntValueView(1)));
+  EXPECT_THAT(Hash(DoubleValueView(1.0)), IsOkAndHolds(hash));
+  EXPECT_THAT(Hash(UintValueView(1)), IsOkAndHolds(hash));
+  EXPECT_THAT(Hash(IntValueView(2)), IsOkAndHolds(Ne(hash)));
+  ASSERT_OK_AND_ASSIGN(hash, Hash(StringValueView("foo")));
+  EXPECT_THAT(Hash(StringValue(absl::Cord("foo"))), IsOkAndHolds(hash));
+}
+
+TEST_P(ValueHashTest, NestedLists) {
+  ASSERT_OK_AND_ASSIGN(auto inner_int, NewListValue(IntValue(2)));
+  ASSERT_OK_AND_ASSIGN(auto inner_double, NewListValue(DoubleValue(2.0)));
+  ASSERT_OK_AND_ASSIGN(auto list_int,
+                       NewListValue(UintValue(1), std::move(inner_int)));
+  ASSERT_OK_AND_ASSIGN(auto list_double,
+                       NewListValue(DoubleValue(1.0), std::move(inner_double)));
+  ASSERT_OK_AND_ASSIGN(auto reversed,
+                       NewListValue(NewListValue(IntValue(2)).value(),
+                                    IntValue(1)));
+
+  ASSERT_OK_AND_ASSIGN(auto hash, Hash(list_int));
+  EXPECT_THAT(Hash(list_double), IsOkAndHolds(hash));
+  EXPECT_THAT(Hash(reversed), IsOkAndHolds(Ne(hash)));
+  // The second call is answered from the cache.
+  EXPECT_THAT(Hash(list_int), IsOkAndHolds(hash));
+}
+
+TEST_P(ValueHashTest, MapsIgnoreIterationOrder) {
+  ASSERT_OK_AND_ASSIGN(
+      auto map, NewMapValue(std::pair{IntValue(1), StringValue("a")},
+                            std::pair{IntValue(2), DoubleValue(3.0)}));
+  ASSERT_OK_AND_ASSIGN(
+      auto other, NewMapValue(std::pair{UintValue(2), IntValue(3)},
+                              std::pair{UintValue(1), StringValue("a")}));
+  ASSERT_OK_AND_ASSIGN(
+      auto different, NewMapValue(std::pair{IntValue(1), StringValue("a")},
+                                  std::pair{IntValue(2), IntValue(4)}));
+
+  ASSERT_OK_AND_ASSIGN(auto hash, Hash(map));
+  EXPECT_THAT(Hash(other), IsOkAndHolds(hash));
+  EXPECT_THAT(Hash(different), IsOkAndHolds(Ne(hash)));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ValueHashTest, ValueHashTest,
+    ::testing::Combine(::testing::Values(MemoryManagement::kPooling,
+                                         MemoryManagement::kReferenceCounting)),
+    ValueHashTest::ToString);
+
 }  // namespace
 }  // namespace cel
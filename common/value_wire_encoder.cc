@@ -0,0 +1,418 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/value_wire_encoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/any.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "internal/proto_wire.h"
+#include "internal/serialize.h"
+#include "internal/status_macros.h"
+#include "internal/time.h"
+
+namespace cel {
+
+namespace {
+
+using ::cel::internal::Fixed64Encode;
+using ::cel::internal::MakeProtoWireTag;
+using ::cel::internal::ProtoWireType;
+using ::cel::internal::VarintEncode;
+using ::cel::internal::VarintSize;
+
+inline constexpr uint32_t kValueNullValueFieldTag =
+    MakeProtoWireTag(1, ProtoWireType::kVarint);
+inline constexpr uint32_t kValueNumberValueFieldTag =
+    MakeProtoWireTag(2, ProtoWireType::kFixed64);
+inline constexpr uint32_t kValueStringValueFieldTag =
+    MakeProtoWireTag(3, ProtoWireType::kLengthDelimited);
+inline constexpr uint32_t kValueBoolValueFieldTag =
+    MakeProtoWireTag(4, ProtoWireType::kVarint);
+inline constexpr uint32_t kValueStructValueFieldTag =
+    MakeProtoWireTag(5, ProtoWireType::kLengthDelimited);
+inline constexpr uint32_t kValueListValueFieldTag =
+    MakeProtoWireTag(6, ProtoWireType::kLengthDelimited);
+
+inline constexpr uint32_t kListValueValuesFieldTag =
+    MakeProtoWireTag(1, ProtoWireType::kLengthDelimited);
+
+inline constexpr uint32_t kStructFieldsFieldTag =
+    MakeProtoWireTag(1, ProtoWireType::kLengthDelimited);
+inline constexpr uint32_t kStructFieldsEntryKeyFieldTag =
+    MakeProtoWireTag(1, ProtoWireType::kLengthDelimited);
+inline constexpr uint32_t kStructFieldsEntryValueFieldTag =
+    MakeProtoWireTag(2, ProtoWireType::kLengthDelimited);
+
+size_t LengthDelimitedSize(uint32_t tag, size_t size) {
+  return VarintSize(tag) + VarintSize(size) + size;
+}
+
+void WriteLengthDelimitedPrefix(uint32_t tag, size_t size,
+                                absl::Cord& serialized_value) {
+  VarintEncode(tag, serialized_value);
+  VarintEncode(static_cast<uint64_t>(size), serialized_value);
+}
+
+template <typename T>
+size_t StringSize(const T& value) {
+  return value.NativeValue([](const auto& native) { return native.size(); });
+}
+
+size_t Base64EscapedSize(size_t size) { return (size + 2) / 3 * 4; }
+
+// The JSON string form of values which are represented as
+// `google.protobuf.Value.string_value`, other than strings and bytes, or
+// `absl::nullopt` for values represented some other way.
+absl::StatusOr<absl::optional<std::string>> FormattedString(ValueView value) {
+  switch (value.kind()) {
+    case ValueKind::kInt: {
+      int64_t native = Cast<IntValueView>(value).NativeValue();
+      if (native < kJsonMinInt || native > kJsonMaxInt) {
+        return absl::StrCat(native);
+      }
+      return absl::nullopt;
+    }
+    case ValueKind::kUint: {
+      uint64_t native = Cast<UintValueView>(value).NativeValue();
+      if (native > kJsonMaxUint) {
+        return absl::StrCat(native);
+      }
+      return absl::nullopt;
+    }
+    case ValueKind::kDuration:
+      return internal::EncodeDurationToJson(
+          Cast<DurationValueView>(value).NativeValue());
+    case ValueKind::kTimestamp:
+      return internal::EncodeTimestampToJson(
+          Cast<TimestampValueView>(value).NativeValue());
+    default:
+      return absl::nullopt;
+  }
+}
+
+double NumberValue(ValueView value) {
+  switch (value.kind()) {
+    case ValueKind::kInt:
+      return static_cast<double>(Cast<IntValueView>(value).NativeValue());
+    case ValueKind::kUint:
+      return static_cast<double>(Cast<UintValueView>(value).NativeValue());
+    default:
+      return Cast<DoubleValueView>(value).NativeValue();
+  }
+}
+
+// Two pass encoder. `Size*` methods record the lengths of every list and map
+// in the order they are visited, and the conversions of values without a
+// dedicated encoding, which the `Write*` methods then consume in the same
+// order. Iteration over lists and maps is deterministic, so both passes visit
+// values identically.
+class JsonWireEncoder final {
+ public:
+  explicit JsonWireEncoder(ValueManager& value_manager)
+      : value_manager_(value_manager) {}
+
+  absl::StatusOr<size_t> SizeValue(ValueView value) {
+    switch (value.kind()) {
+      case ValueKind::kNull:
+        return VarintSize(kValueNullValueFieldTag) + VarintSize(0);
+      case ValueKind::kBool:
+        return VarintSize(kValueBoolValueFieldTag) + VarintSize(true);
+      case ValueKind::kDouble:
+        return VarintSize(kValueNumberValueFieldTag) + 8;
+      case ValueKind::kString:
+        return LengthDelimitedSize(kValueStringValueFieldTag,
+                                   StringSize(Cast<StringValueView>(value)));
+      case ValueKind::kBytes:
+        return LengthDelimitedSize(
+            kValueStringValueFieldTag,
+            Base64EscapedSize(StringSize(Cast<BytesValueView>(value))));
+      case ValueKind::kInt:
+      case ValueKind::kUint:
+      case ValueKind::kDuration:
+      case ValueKind::kTimestamp: {
+        CEL_ASSIGN_OR_RETURN(auto formatted, FormattedString(value));
+        if (formatted.has_value()) {
+          return LengthDelimitedSize(kValueStringValueFieldTag,
+                                     formatted->size());
+        }
+        return VarintSize(kValueNumberValueFieldTag) + 8;
+      }
+      case ValueKind::kList: {
+        CEL_ASSIGN_OR_RETURN(auto size,
+                             SizeListValue(Cast<ListValueView>(value)));
+        return LengthDelimitedSize(kValueListValueFieldTag, size);
+      }
+      case ValueKind::kMap: {
+        CEL_ASSIGN_OR_RETURN(auto size, SizeStruct(Cast<MapValueView>(value)));
+        return LengthDelimitedSize(kValueStructValueFieldTag, size);
+      }
+      default: {
+        CEL_ASSIGN_OR_RETURN(auto json, value.ConvertToJson(value_manager_));
+        size_t size = internal::SerializedValueSize(json);
+        fallbacks_.push_back(std::move(json));
+        return size;
+      }
+    }
+  }
+
+  absl::StatusOr<size_t> SizeListValue(ListValueView value) {
+    size_t index = sizes_.size();
+    sizes_.push_back(0);
+    size_t size = 0;
+    CEL_RETURN_IF_ERROR(value.ForEach(
+        value_manager_,
+        [this, &size](ValueView element) -> absl::StatusOr<bool> {
+          CEL_ASSIGN_OR_RETURN(auto element_size, SizeValue(element));
+          size += LengthDelimitedSize(kListValueValuesFieldTag, element_size);
+          return true;
+        }));
+    sizes_[index] = size;
+    return size;
+  }
+
+  absl::StatusOr<size_t> SizeStruct(MapValueView value) {
+    size_t index = sizes_.size();
+    sizes_.push_back(0);
+    size_t size = 0;
+    CEL_RETURN_IF_ERROR(value.ForEach(
+        value_manager_,
+        [this, &size](ValueView key, ValueView entry) -> absl::StatusOr<bool> {
+          auto string_key = As<StringValueView>(key);
+          if (!string_key.has_value()) {
+            return TypeConversionError(
+                       absl::StrCat("map<", key.GetTypeName(), ", ?>"),
+                       "google.protobuf.Struct")
+                .NativeValue();
+          }
+          CEL_ASSIGN_OR_RETURN(auto entry_size, SizeValue(entry));
+          size += LengthDelimitedSize(
+              kStructFieldsFieldTag,
+              LengthDelimitedSize(kStructFieldsEntryKeyFieldTag,
+                                  StringSize(*string_key)) +
+                  LengthDelimitedSize(kStructFieldsEntryValueFieldTag,
+                                      entry_size));
+          return true;
+        }));
+    sizes_[index] = size;
+    return size;
+  }
+
+  absl::Status WriteValue(ValueView value, absl::Cord& serialized_value) {
+    switch (value.kind()) {
+      case ValueKind::kNull:
+        VarintEncode(kValueNullValueFieldTag, serialized_value);
+        VarintEncode(uint64_t{0}, serialized_value);
+        return absl::OkStatus();
+      case ValueKind::kBool:
+        VarintEncode(kValueBoolValueFieldTag, serialized_value);
+        VarintEncode(Cast<BoolValueView>(value).NativeValue(),
+                     serialized_value);
+        return absl::OkStatus();
+      case ValueKind::kDouble:
+        VarintEncode(kValueNumberValueFieldTag, serialized_value);
+        Fixed64Encode(NumberValue(value), serialized_value);
+        return absl::OkStatus();
+      case ValueKind::kString: {
+        auto string_value = Cast<StringValueView>(value);
+        WriteLengthDelimitedPrefix(kValueStringValueFieldTag,
+                                   StringSize(string_value), serialized_value);
+        string_value.NativeValue([&serialized_value](const auto& native) {
+          serialized_value.Append(native);
+        });
+        return absl::OkStatus();
+      }
+      case ValueKind::kBytes: {
+        std::string scratch;
+        std::string escaped;
+        absl::Base64Escape(Cast<BytesValueView>(value).NativeString(scratch),
+                           &escaped);
+        WriteLengthDelimitedPrefix(kValueStringValueFieldTag, escaped.size(),
+                                   serialized_value);
+        serialized_value.Append(std::move(escaped));
+        return absl::OkStatus();
+      }
+      case ValueKind::kInt:
+      case ValueKind::kUint:
+      case ValueKind::kDuration:
+      case ValueKind::kTimestamp: {
+        CEL_ASSIGN_OR_RETURN(auto formatted, FormattedString(value));
+        if (formatted.has_value()) {
+          WriteLengthDelimitedPrefix(kValueStringValueFieldTag,
+                                     formatted->size(), serialized_value);
+          serialized_value.Append(*std::move(formatted));
+          return absl::OkStatus();
+        }
+        VarintEncode(kValueNumberValueFieldTag, serialized_value);
+        Fixed64Encode(NumberValue(value), serialized_value);
+        return absl::OkStatus();
+      }
+      case ValueKind::kList:
+        WriteLengthDelimitedPrefix(kValueListValueFieldTag, sizes_[next_size_],
+                                   serialized_value);
+        return WriteListValue(Cast<ListValueView>(value), serialized_value);
+      case ValueKind::kMap:
+        WriteLengthDelimitedPrefix(kValueStructValueFieldTag,
+                                   sizes_[next_size_], serialized_value);
+        return WriteStruct(Cast<MapValueView>(value), serialized_value);
+      default:
+        return JsonToAnyValue(fallbacks_[next_fallback_++], serialized_value);
+    }
+  }
+
+  absl::Status WriteListValue(ListValueView value,
+                              absl::Cord& serialized_value) {
+    ++next_size_;
+    return value.ForEach(
+        value_manager_,
+        [this, &serialized_value](ValueView element) -> absl::StatusOr<bool> {
+          CEL_ASSIGN_OR_RETURN(auto element_size, RecordedValueSize(element));
+          WriteLengthDelimitedPrefix(kListValueValuesFieldTag, element_size,
+                                     serialized_value);
+          CEL_RETURN_IF_ERROR(WriteValue(element, serialized_value));
+          return true;
+        });
+  }
+
+  absl::Status WriteStruct(MapValueView value, absl::Cord& serialized_value) {
+    ++next_size_;
+    return value.ForEach(
+        value_manager_,
+        [this, &serialized_value](ValueView key,
+                                  ValueView entry) -> absl::StatusOr<bool> {
+          auto string_key = Cast<StringValueView>(key);
+          size_t key_size = StringSize(string_key);
+          CEL_ASSIGN_OR_RETURN(auto entry_size, RecordedValueSize(entry));
+          WriteLengthDelimitedPrefix(
+              kStructFieldsFieldTag,
+              LengthDelimitedSize(kStructFieldsEntryKeyFieldTag, key_size) +
+                  LengthDelimitedSize(kStructFieldsEntryValueFieldTag,
+                                      entry_size),
+              serialized_value);
+          WriteLengthDelimitedPrefix(kStructFieldsEntryKeyFieldTag, key_size,
+                                     serialized_value);
+          string_key.NativeValue([&serialized_value](const auto& native) {
+            serialized_value.Append(native);
+          });
+          WriteLengthDelimitedPrefix(kStructFieldsEntryValueFieldTag,
+                                     entry_size, serialized_value);
+          CEL_RETURN_IF_ERROR(WriteValue(entry, serialized_value));
+          return true;
+        });
+  }
+
+ private:
+  // The size of `value` as `google.protobuf.Value`, using the lengths
+  // recorded by the first pass for the value about to be written.
+  absl::StatusOr<size_t> RecordedValueSize(ValueView value) {
+    switch (value.kind()) {
+      case ValueKind::kList:
+        return LengthDelimitedSize(kValueListValueFieldTag, sizes_[next_size_]);
+      case ValueKind::kMap:
+        return LengthDelimitedSize(kValueStructValueFieldTag,
+                                   sizes_[next_size_]);
+      case ValueKind::kNull:
+      case ValueKind::kBool:
+      case ValueKind::kDouble:
+      case ValueKind::kString:
+      case ValueKind::kBytes:
+      case ValueKind::kInt:
+      case ValueKind::kUint:
+      case ValueKind::kDuration:
+      case ValueKind::kTimestamp:
+        return SizeValue(value);
+      default:
+        return internal::SerializedValueSize(fallbacks_[next_fallback_]);
+    }
+  }
+
+  ValueManager& value_manager_;
+  std::vector<size_t> sizes_;
+  size_t next_size_ = 0;
+  std::vector<Json> fallbacks_;
+  size_t next_fallback_ = 0;
+};
+
+}  // namespace
+
+absl::Status SerializeValueAsJsonValue(ValueManager& value_manager,
+                                       ValueView value,
+                                       absl::Cord& serialized_value) {
+  JsonWireEncoder encoder(value_manager);
+  CEL_ASSIGN_OR_RETURN(auto size, encoder.SizeValue(value));
+  size_t original_size = serialized_value.size();
+  CEL_RETURN_IF_ERROR(encoder.WriteValue(value, serialized_value));
+  ABSL_DCHECK_EQ(serialized_value.size() - original_size, size);
+  return absl::OkStatus();
+}
+
+absl::Status SerializeListValueAsJsonListValue(ValueManager& value_manager,
+                                               ListValueView value,
+                                               absl::Cord& serialized_value) {
+  JsonWireEncoder encoder(value_manager);
+  CEL_ASSIGN_OR_RETURN(auto size, encoder.SizeListValue(value));
+  size_t original_size = serialized_value.size();
+  CEL_RETURN_IF_ERROR(encoder.WriteListValue(value, serialized_value));
+  ABSL_DCHECK_EQ(serialized_value.size() - original_size, size);
+  return absl::OkStatus();
+}
+
+absl::Status SerializeMapValueAsJsonStruct(ValueManager& value_manager,
+                                           MapValueView value,
+                                           absl::Cord& serialized_value) {
+  JsonWireEncoder encoder(value_manager);
+  CEL_ASSIGN_OR_RETURN(auto size, encoder.SizeStruct(value));
+  size_t original_size = serialized_value.size();
+  CEL_RETURN_IF_ERROR(encoder.WriteStruct(value, serialized_value));
+  ABSL_DCHECK_EQ(serialized_value.size() - original_size, size);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Any> PackValueAsAny(ValueManager& value_manager,
+                                   ValueView value, absl::string_view prefix) {
+  absl::Cord serialized_value;
+  switch (value.kind()) {
+    case ValueKind::kList:
+      CEL_RETURN_IF_ERROR(SerializeListValueAsJsonListValue(
+          value_manager, Cast<ListValueView>(value), serialized_value));
+      return MakeAny(MakeTypeUrlWithPrefix(prefix, "google.protobuf.ListValue"),
+                     std::move(serialized_value));
+    case ValueKind::kMap:
+      CEL_RETURN_IF_ERROR(SerializeMapValueAsJsonStruct(
+          value_manager, Cast<MapValueView>(value), serialized_value));
+      return MakeAny(MakeTypeUrlWithPrefix(prefix, "google.protobuf.Struct"),
+                     std::move(serialized_value));
+    default:
+      return value.ConvertToAny(value_manager, prefix);
+  }
+}
+
+}  // namespace cel
@@ -0,0 +1,60 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_VALUE_WIRE_ENCODER_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_VALUE_WIRE_ENCODER_H_
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "common/any.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel {
+
+// Serializes values directly in the wire format of `google.protobuf.Value`,
+// `google.protobuf.ListValue` and `google.protobuf.Struct`, following the same
+// rules as `Value::ConvertToJson`. Unlike `ConvertToJson` followed by
+// `JsonToAnyValue`, lists and maps are walked in place: a first pass computes
+// the length of every nested message, so that the second pass can emit the
+// length prefixes and payloads straight into `serialized_value` without
+// building intermediate `Json` trees or per-message `absl::Cord`s.
+//
+// Elements without a dedicated encoding, such as messages, still go through
+// `ConvertToJson`. The serialized bytes are appended to `serialized_value`.
+
+absl::Status SerializeValueAsJsonValue(ValueManager& value_manager,
+                                       ValueView value,
+                                       absl::Cord& serialized_value);
+
+absl::Status SerializeListValueAsJsonListValue(ValueManager& value_manager,
+                                               ListValueView value,
+                                               absl::Cord& serialized_value);
+
+absl::Status SerializeMapValueAsJsonStruct(ValueManager& value_manager,
+                                           MapValueView value,
+                                           absl::Cord& serialized_value);
+
+// Packs `value` as `google.protobuf.Any`. Lists and maps are packed as
+// `google.protobuf.ListValue` and `google.protobuf.Struct` using the encoders
+// above, everything else as by `Value::ConvertToAny`.
+absl::StatusOr<Any> PackValueAsAny(
+    ValueManager& value_manager, ValueView value,
+    absl::string_view prefix = kTypeGoogleApisComPrefix);
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_VALUE_WIRE_ENCODER_H_
@@ -0,0 +1,163 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/value_wire_encoder.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/time/time.h"
+#include "common/any.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "internal/serialize.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using testing::Eq;
+using testing::HasSubstr;
+using cel::internal::StatusIs;
+
+class ValueWireEncoderTest
+    : public common_internal::ThreadCompatibleValueTest<> {
+ public:
+  // Serializes `value` through `ConvertToJson`, which the encoder must match.
+  absl::Cord SerializeThroughJson(ValueView value) {
+    absl::Cord serialized_value;
+    auto json = value.ConvertToJson(value_manager());
+    ABSL_CHECK_OK(json.status());
+    ABSL_CHECK_OK(internal::SerializeValue(*json, serialized_value));
+    return serialized_value;
+  }
+
+  absl::Cord SerializeDirectly(ValueView value) {
+    absl::Cord serialized_value;
+    ABSL_CHECK_OK(
+        SerializeValueAsJsonValue(value_manager(), value, serialized_value));
+    return serialized_value;
+  }
+
+  ListValue NewDynList(std::initializer_list<Value> elements) {
+    auto builder =
+        value_manager().NewListValueBuilder(value_manager().GetDynListType());
+    ABSL_CHECK_OK(builder.status());
+    for (const auto& element : elements) {
+      ABSL_CHECK_OK((*builder)->Add(element));
+    }
+    return std::move(**builder).Build();
+  }
+
+  MapValue NewDynMap(Value key, Value value) {
+    auto builder =
+        value_manager().NewMapValueBuilder(value_manager().GetDynDynMapType());
+    ABSL_CHECK_OK(builder.status());
+    ABSL_CHECK_OK((*builder)->Put(std::move(key), std::move(value)));
+    return std::move(**builder).Build();
+  }
+};
+
+TEST_P(ValueWireEncoderTest, Scalars) {
+  for (const Value& value :
+       {Value(NullValue()), Value(BoolValue(true)), Value(BoolValue(false)),
+        Value(IntValue(-1)),
+        Value(IntValue(std::numeric_limits<int64_t>::max())),
+        Value(UintValue(std::numeric_limits<uint64_t>::max())),
+        Value(DoubleValue(0.5)), Value(StringValue("foo")),
+        Value(BytesValue("bytes")), Value(DurationValue(absl::Seconds(3))),
+        Value(TimestampValue(absl::UnixEpoch() + absl::Seconds(1)))}) {
+    EXPECT_THAT(SerializeDirectly(value), Eq(SerializeThroughJson(value)))
+        << value.DebugString();
+  }
+}
+
+TEST_P(ValueWireEncoderTest, NestedListsAndMaps) {
+  Value value = NewDynList(
+      {IntValue(1), NewDynList({}),
+       NewDynMap(StringValue("inner"),
+                 NewDynList({StringValue("a"), BytesValue("b"),
+                             NewDynMap(StringValue("x"), NullValue())})),
+       NewDynList({DoubleValue(2.5), NewDynList({BoolValue(true)})})});
+  EXPECT_THAT(SerializeDirectly(value), Eq(SerializeThroughJson(value)));
+}
+
+TEST_P(ValueWireEncoderTest, ListValue) {
+  ListValue value = NewDynList({IntValue(1), NewDynList({StringValue("a")})});
+  absl::Cord serialized_value;
+  ASSERT_OK(SerializeListValueAsJsonListValue(value_manager(), value,
+                                              serialized_value));
+  absl::Cord expected;
+  ASSERT_OK_AND_ASSIGN(auto json, value.ConvertToJsonArray(value_manager()));
+  ASSERT_OK(internal::SerializeListValue(json, expected));
+  EXPECT_THAT(serialized_value, Eq(expected));
+}
+
+TEST_P(ValueWireEncoderTest, Struct) {
+  MapValue value =
+      NewDynMap(StringValue("key"), NewDynList({UintValue(2), NullValue()}));
+  absl::Cord serialized_value;
+  ASSERT_OK(
+      SerializeMapValueAsJsonStruct(value_manager(), value, serialized_value));
+  absl::Cord expected;
+  ASSERT_OK_AND_ASSIGN(auto json, value.ConvertToJsonObject(value_manager()));
+  ASSERT_OK(internal::SerializeStruct(json, expected));
+  EXPECT_THAT(serialized_value, Eq(expected));
+}
+
+TEST_P(ValueWireEncoderTest, NonStringMapKey) {
+  ListValue value = NewDynList({NewDynMap(IntValue(1), BoolValue(true))});
+  absl::Cord serialized_value;
+  EXPECT_THAT(
+      SerializeValueAsJsonValue(value_manager(), value, serialized_value),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("google.protobuf.Struct")));
+}
+
+TEST_P(ValueWireEncoderTest, Unsupported) {
+  ListValue value = NewDynList({TypeValue(IntType())});
+  absl::Cord serialized_value;
+  EXPECT_THAT(
+      SerializeValueAsJsonValue(value_manager(), value, serialized_value),
+      StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_P(ValueWireEncoderTest, PackValueAsAny) {
+  ListValue list = NewDynList({IntValue(1)});
+  ASSERT_OK_AND_ASSIGN(auto any, PackValueAsAny(value_manager(), list));
+  EXPECT_EQ(any.type_url(), "type.googleapis.com/google.protobuf.ListValue");
+
+  MapValue map = NewDynMap(StringValue("key"), IntValue(1));
+  ASSERT_OK_AND_ASSIGN(any, PackValueAsAny(value_manager(), map));
+  EXPECT_EQ(any.type_url(), "type.googleapis.com/google.protobuf.Struct");
+
+  ASSERT_OK_AND_ASSIGN(any, PackValueAsAny(value_manager(), IntValue(1)));
+  EXPECT_EQ(any.type_url(), "type.googleapis.com/google.protobuf.Int64Value");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ValueWireEncoderTest, ValueWireEncoderTest,
+    ::testing::Values(MemoryManagement::kPooling,
+                      MemoryManagement::kReferenceCounting));
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,314 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/values/contiguous_list_value.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/internal/allocation_counter.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "internal/status_macros.h"
+
+namespace cel {
+
+namespace common_internal {
+
+namespace {
+
+IntValueView ElementView(const int64_t& element) {
+  return IntValueView(element);
+}
+
+DoubleValueView ElementView(const double& element) {
+  return DoubleValueView(element);
+}
+
+StringValueView ElementView(const StringValue& element) {
+  return StringValueView(element);
+}
+
+// Returns `other` if it has the list's own element type, in which case the
+// caller compares natively. Other values, such as a uint looked up in an int
+// list, fall back to `Value` equality.
+absl::optional<int64_t> NativeOperand(ValueView other, const int64_t*) {
+  if (auto value = As<IntValueView>(other); value) {
+    return value->NativeValue();
+  }
+  return absl::nullopt;
+}
+
+absl::optional<double> NativeOperand(ValueView other, const double*) {
+  if (auto value = As<DoubleValueView>(other); value) {
+    return value->NativeValue();
+  }
+  return absl::nullopt;
+}
+
+absl::optional<StringValueView> NativeOperand(ValueView other,
+                                              const StringValue*) {
+  return As<StringValueView>(other);
+}
+
+}  // namespace
+
+template <typename T, typename E>
+std::string ContiguousListValue<T, E>::DebugString() const {
+  return absl::StrCat(
+      "[",
+      absl::StrJoin(elements_, ", ",
+                    [](std::string* out, const E& element) {
+                      absl::StrAppend(out, ElementView(element).DebugString());
+                    }),
+      "]");
+}
+
+template <typename T, typename E>
+absl::StatusOr<JsonArray> ContiguousListValue<T, E>::ConvertToJsonArray(
+    AnyToJsonConverter& converter) const {
+  JsonArrayBuilder builder;
+  builder.reserve(Size());
+  for (const auto& element : elements_) {
+    CEL_ASSIGN_OR_RETURN(auto json_element,
+                         ElementView(element).ConvertToJson(converter));
+    builder.push_back(std::move(json_element));
+  }
+  return std::move(builder).Build();
+}
+
+template <typename T, typename E>
+absl::Status ContiguousListValue<T, E>::ForEach(
+    ValueManager& value_manager, ForEachCallback callback) const {
+  for (const auto& element : elements_) {
+    CEL_ASSIGN_OR_RETURN(auto ok, callback(ElementView(element)));
+    if (!ok) {
+      break;
+    }
+  }
+  return absl::OkStatus();
+}
+
+template <typename T, typename E>
+absl::Status ContiguousListValue<T, E>::ForEach(
+    ValueManager& value_manager, ForEachWithIndexCallback callback) const {
+  for (size_t i = 0; i < elements_.size(); ++i) {
+    CEL_ASSIGN_OR_RETURN(auto ok, callback(i, ElementView(elements_[i])));
+    if (!ok) {
+      break;
+    }
+  }
+  return absl::OkStatus();
+}
+
+template <typename T, typename E>
+absl::StatusOr<ValueView> ContiguousListValue<T, E>::Contains(
+    ValueManager& value_manager, ValueView other,
+    Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const {
+  if (auto operand = NativeOperand(other, static_cast<const E*>(nullptr));
+      operand) {
+    bool found;
+    if constexpr (std::is_same_v<E, StringValue>) {
+      found = std::any_of(elements_.begin(), elements_.end(),
+                          [operand](const StringValue& element) {
+                            return element.Equals(*operand);
+                          });
+    } else {
+      // NaN never compares equal, which matches `DoubleValue` equality.
+      found = std::find(elements_.begin(), elements_.end(), *operand) !=
+              elements_.end();
+    }
+    return BoolValueView{found};
+  }
+  for (const auto& element : elements_) {
+    CEL_ASSIGN_OR_RETURN(
+        auto result, ElementView(element).Equal(value_manager, other, scratch));
+    if (auto bool_result = As<BoolValueView>(result);
+        bool_result.has_value() && bool_result->NativeValue()) {
+      return *bool_result;
+    }
+  }
+  return BoolValueView{false};
+}
+
+template <typename T, typename E>
+absl::StatusOr<ValueView> ContiguousListValue<T, E>::GetImpl(
+    ValueManager&, size_t index, Value&) const {
+  return ElementView(elements_[index]);
+}
+
+template class ContiguousListValue<IntValue, int64_t>;
+template class ContiguousListValue<DoubleValue, double>;
+template class ContiguousListValue<StringValue, StringValue>;
+
+namespace {
+
+class ContiguousListValueBuilder final : public ListValueBuilder {
+ public:
+  explicit ContiguousListValueBuilder(ValueManager& value_manager)
+      : value_manager_(value_manager) {}
+
+  ContiguousListValueBuilder(const ContiguousListValueBuilder&) = delete;
+  ContiguousListValueBuilder(ContiguousListValueBuilder&&) = delete;
+  ContiguousListValueBuilder& operator=(const ContiguousListValueBuilder&) =
+      delete;
+  ContiguousListValueBuilder& operator=(ContiguousListValueBuilder&&) = delete;
+
+  absl::Status Add(Value value) override {
+    if (auto error_value = As<ErrorValue>(value); error_value) {
+      return error_value->NativeValue();
+    }
+    const Storage storage = StorageFor(value);
+    if (storage_ == Storage::kNone && storage != Storage::kGeneric) {
+      storage_ = storage;
+    }
+    if (storage_ != Storage::kGeneric && storage_ != storage) {
+      CEL_RETURN_IF_ERROR(Materialize());
+    }
+    if (storage_ == Storage::kGeneric) {
+      return generic_->Add(std::move(value));
+    }
+    switch (storage_) {
+      case Storage::kInt:
+        ints_.reserve(capacity_);
+        ints_.push_back(Cast<IntValue>(value).NativeValue());
+        break;
+      case Storage::kDouble:
+        doubles_.reserve(capacity_);
+        doubles_.push_back(Cast<DoubleValue>(value).NativeValue());
+        break;
+      default:
+        strings_.reserve(capacity_);
+        strings_.push_back(Cast<StringValue>(std::move(value)));
+        break;
+    }
+    ++size_;
+    return absl::OkStatus();
+  }
+
+  bool IsEmpty() const override { return Size() == 0; }
+
+  size_t Size() const override {
+    return storage_ == Storage::kGeneric ? generic_->Size() : size_;
+  }
+
+  void Reserve(size_t capacity) override {
+    if (storage_ == Storage::kGeneric) {
+      generic_->Reserve(capacity);
+      return;
+    }
+    // The storage is only known after the first element, so `Add` reserves.
+    capacity_ = std::max(capacity_, capacity);
+  }
+
+  ListValue Build() && override {
+    auto memory_manager = value_manager_.GetMemoryManager();
+    // The elements are allocated by the vectors rather than the memory manager,
+    // so they are counted against any allocation budget here.
+    common_internal::CountAllocation(ints_.capacity() * sizeof(int64_t) +
+                                     doubles_.capacity() * sizeof(double) +
+                                     strings_.capacity() * sizeof(StringValue));
+    switch (storage_) {
+      case Storage::kInt:
+        return ParsedListValue(memory_manager.MakeShared<IntListValue>(
+            ListType(value_manager_.GetDynListType()), std::move(ints_)));
+      case Storage::kDouble:
+        return ParsedListValue(memory_manager.MakeShared<DoubleListValue>(
+            ListType(value_manager_.GetDynListType()), std::move(doubles_)));
+      case Storage::kString:
+        return ParsedListValue(memory_manager.MakeShared<StringListValue>(
+            ListType(value_manager_.GetDynListType()), std::move(strings_)));
+      case Storage::kGeneric:
+        return std::move(*generic_).Build();
+      case Storage::kNone:
+        break;
+    }
+    return ListValue();
+  }
+
+ private:
+  enum class Storage { kNone, kInt, kDouble, kString, kGeneric };
+
+  static Storage StorageFor(const Value& value) {
+    switch (value.kind()) {
+      case ValueKind::kInt:
+        return Storage::kInt;
+      case ValueKind::kDouble:
+        return Storage::kDouble;
+      case ValueKind::kString:
+        return Storage::kString;
+      default:
+        return Storage::kGeneric;
+    }
+  }
+
+  // Moves the elements added so far into a generic builder, which then takes
+  // every further element.
+  absl::Status Materialize() {
+    CEL_ASSIGN_OR_RETURN(generic_, value_manager_.NewListValueBuilder(
+                                       value_manager_.GetDynListType()));
+    generic_->Reserve(std::max(capacity_, size_ + 1));
+    for (int64_t element : ints_) {
+      CEL_RETURN_IF_ERROR(generic_->Add(IntValue(element)));
+    }
+    for (double element : doubles_) {
+      CEL_RETURN_IF_ERROR(generic_->Add(DoubleValue(element)));
+    }
+    for (auto& element : strings_) {
+      CEL_RETURN_IF_ERROR(generic_->Add(std::move(element)));
+    }
+    ints_ = {};
+    doubles_ = {};
+    strings_ = {};
+    storage_ = Storage::kGeneric;
+    return absl::OkStatus();
+  }
+
+  ValueManager& value_manager_;
+  // Where the elements added so far are stored. `kNone` until the first one.
+  Storage storage_ = Storage::kNone;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  std::vector<int64_t> ints_;
+  std::vector<double> doubles_;
+  std::vector<StringValue> strings_;
+  Unique<ListValueBuilder> generic_;
+};
+
+}  // namespace
+
+}  // namespace common_internal
+
+absl::StatusOr<Unique<ListValueBuilder>> NewContiguousListValueBuilder(
+    ValueManager& value_manager) {
+  auto memory_manager = value_manager.GetMemoryManager();
+  return memory_manager
+      .MakeUnique<common_internal::ContiguousListValueBuilder>(value_manager);
+}
+
+}  // namespace cel
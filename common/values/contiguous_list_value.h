@@ -0,0 +1,151 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// `IntListValue`, `DoubleListValue` and `StringListValue` are
+// `ParsedListValueInterface` implementations which store homogeneous elements
+// as contiguous native arrays, so that consumers such as `math.greatest` can
+// run tight loops over them instead of dispatching on each `Value`.
+
+#ifndef THIRD_PARTY_CEL_CPP_COMMON_VALUES_CONTIGUOUS_LIST_VALUE_H_
+#define THIRD_PARTY_CEL_CPP_COMMON_VALUES_CONTIGUOUS_LIST_VALUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "internal/casts.h"
+
+namespace cel {
+
+class ValueManager;
+
+namespace common_internal {
+
+// Shared implementation of the contiguous list values. `T` is the value type
+// of the elements, `E` their storage type.
+template <typename T, typename E>
+class ContiguousListValue : public ParsedListValueInterface {
+ public:
+  using element_type = E;
+
+  ContiguousListValue(ListType type, std::vector<E>&& elements)
+      : type_(std::move(type)), elements_(std::move(elements)) {}
+
+  std::string DebugString() const override;
+
+  bool IsEmpty() const override { return elements_.empty(); }
+
+  size_t Size() const override { return elements_.size(); }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter& converter) const override;
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachCallback callback) const override;
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachWithIndexCallback callback) const override;
+
+  absl::StatusOr<ValueView> Contains(
+      ValueManager& value_manager, ValueView other,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const override;
+
+  absl::Span<const E> elements() const { return elements_; }
+
+ protected:
+  Type GetTypeImpl(TypeManager&) const override { return type_; }
+
+ private:
+  absl::StatusOr<ValueView> GetImpl(ValueManager&, size_t index,
+                                    Value&) const override;
+
+  const ListType type_;
+  const std::vector<E> elements_;
+};
+
+extern template class ContiguousListValue<IntValue, int64_t>;
+extern template class ContiguousListValue<DoubleValue, double>;
+extern template class ContiguousListValue<StringValue, StringValue>;
+
+}  // namespace common_internal
+
+class IntListValue final
+    : public common_internal::ContiguousListValue<IntValue, int64_t> {
+ public:
+  using ContiguousListValue::ContiguousListValue;
+
+ private:
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<IntListValue>();
+  }
+};
+
+class DoubleListValue final
+    : public common_internal::ContiguousListValue<DoubleValue, double> {
+ public:
+  using ContiguousListValue::ContiguousListValue;
+
+ private:
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<DoubleListValue>();
+  }
+};
+
+class StringListValue final
+    : public common_internal::ContiguousListValue<StringValue, StringValue> {
+ public:
+  using ContiguousListValue::ContiguousListValue;
+
+ private:
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<StringListValue>();
+  }
+};
+
+// Returns the elements of `value` if it is backed by `T`, one of the contiguous
+// list values above, otherwise `absl::nullopt`. The span is valid for as long
+// as `value` is.
+template <typename T>
+absl::optional<absl::Span<const typename T::element_type>> AsContiguousList(
+    ListValueView value) {
+  if (NativeTypeId::Of(value) != NativeTypeId::For<T>()) {
+    return absl::nullopt;
+  }
+  return cel::internal::down_cast<const T&>(*Cast<ParsedListValueView>(value))
+      .elements();
+}
+
+// Returns a builder for `list(dyn)` which stores its elements in one of the
+// contiguous list values above while every element added is an int, a double
+// or a string of the same kind. Any other element moves the elements built so
+// far into `value_manager.NewListValueBuilder`, which builds the result.
+absl::StatusOr<Unique<ListValueBuilder>> NewContiguousListValueBuilder(
+    ValueManager& value_manager);
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_COMMON_VALUES_CONTIGUOUS_LIST_VALUE_H_
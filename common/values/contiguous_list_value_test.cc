@@ -0,0 +1,151 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/values/contiguous_list_value.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using testing::ElementsAre;
+using testing::Optional;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+
+class ContiguousListValueTest
+    : public common_internal::ThreadCompatibleValueTest<> {
+ public:
+  absl::StatusOr<ListValue> NewListValue(std::vector<Value> elements) {
+    CEL_ASSIGN_OR_RETURN(auto builder,
+                         NewContiguousListValueBuilder(value_manager()));
+    builder->Reserve(elements.size());
+    for (auto& element : elements) {
+      CEL_RETURN_IF_ERROR(builder->Add(std::move(element)));
+    }
+    return std::move(*builder).Build();
+  }
+
+  bool Contains(const ListValue& list, ValueView other) {
+    auto contained = list.Contains(value_manager(), other);
+    return contained.ok() && InstanceOf<BoolValue>(*contained) &&
+           Cast<BoolValue>(*contained).NativeValue();
+  }
+};
+
+TEST_P(ContiguousListValueTest, Ints) {
+  ASSERT_OK_AND_ASSIGN(auto list,
+                       NewListValue({IntValue(1), IntValue(2), IntValue(3)}));
+  EXPECT_THAT(AsContiguousList<IntListValue>(list),
+              Optional(ElementsAre(1, 2, 3)));
+  EXPECT_EQ(AsContiguousList<DoubleListValue>(list), absl::nullopt);
+  EXPECT_EQ(list.DebugString(), "[1, 2, 3]");
+  EXPECT_EQ(list.GetType(type_manager()), value_manager().GetDynListType());
+  EXPECT_THAT(list.Size(), IsOkAndHolds(3));
+  Value scratch;
+  ASSERT_OK_AND_ASSIGN(auto element, list.Get(value_manager(), 1, scratch));
+  ASSERT_TRUE(InstanceOf<IntValueView>(element));
+  EXPECT_EQ(Cast<IntValueView>(element).NativeValue(), 2);
+  EXPECT_THAT(list.ConvertToJson(value_manager()),
+              IsOkAndHolds(Json(MakeJsonArray({1.0, 2.0, 3.0}))));
+
+  EXPECT_TRUE(Contains(list, IntValueView(3)));
+  EXPECT_FALSE(Contains(list, IntValueView(4)));
+  // Other numeric kinds still use heterogeneous equality.
+  EXPECT_TRUE(Contains(list, UintValueView(2)));
+  EXPECT_TRUE(Contains(list, DoubleValueView(2.0)));
+  EXPECT_FALSE(Contains(list, StringValueView("1")));
+}
+
+TEST_P(ContiguousListValueTest, Doubles) {
+  ASSERT_OK_AND_ASSIGN(
+      auto list,
+      NewListValue({DoubleValue(1.5), DoubleValue(-0.0),
+                    DoubleValue(std::numeric_limits<double>::quiet_NaN())}));
+  ASSERT_TRUE(AsContiguousList<DoubleListValue>(list).has_value());
+  EXPECT_THAT(AsContiguousList<DoubleListValue>(list)->size(), 3);
+  EXPECT_TRUE(Contains(list, DoubleValueView(1.5)));
+  EXPECT_TRUE(Contains(list, DoubleValueView(0.0)));
+  EXPECT_TRUE(Contains(list, IntValueView(0)));
+  EXPECT_FALSE(Contains(
+      list, DoubleValueView(std::numeric_limits<double>::quiet_NaN())));
+}
+
+TEST_P(ContiguousListValueTest, Strings) {
+  ASSERT_OK_AND_ASSIGN(auto list,
+                       NewListValue({StringValue("a"), StringValue("bc")}));
+  EXPECT_THAT(AsContiguousList<StringListValue>(list),
+              Optional(ElementsAre(StringValue("a"), StringValue("bc"))));
+  EXPECT_EQ(list.DebugString(), "[\"a\", \"bc\"]");
+  EXPECT_TRUE(Contains(list, StringValueView("bc")));
+  EXPECT_FALSE(Contains(list, StringValueView("b")));
+  EXPECT_FALSE(Contains(list, IntValueView(1)));
+}
+
+TEST_P(ContiguousListValueTest, MixedKindsFallBack) {
+  ASSERT_OK_AND_ASSIGN(
+      auto list, NewListValue({IntValue(1), IntValue(2), StringValue("a")}));
+  EXPECT_EQ(AsContiguousList<IntListValue>(list), absl::nullopt);
+  EXPECT_EQ(AsContiguousList<StringListValue>(list), absl::nullopt);
+  EXPECT_THAT(list.Size(), IsOkAndHolds(3));
+  EXPECT_EQ(list.DebugString(), "[1, 2, \"a\"]");
+  EXPECT_TRUE(Contains(list, IntValueView(2)));
+  EXPECT_TRUE(Contains(list, StringValueView("a")));
+}
+
+TEST_P(ContiguousListValueTest, OtherKindsFallBack) {
+  ASSERT_OK_AND_ASSIGN(auto list,
+                       NewListValue({BoolValue(true), BoolValue(false)}));
+  EXPECT_EQ(AsContiguousList<IntListValue>(list), absl::nullopt);
+  EXPECT_EQ(AsContiguousList<DoubleListValue>(list), absl::nullopt);
+  EXPECT_EQ(AsContiguousList<StringListValue>(list), absl::nullopt);
+  EXPECT_EQ(list.DebugString(), "[true, false]");
+}
+
+TEST_P(ContiguousListValueTest, Empty) {
+  ASSERT_OK_AND_ASSIGN(auto list, NewListValue({}));
+  EXPECT_THAT(list.IsEmpty(), IsOkAndHolds(true));
+  EXPECT_EQ(list.DebugString(), "[]");
+}
+
+TEST_P(ContiguousListValueTest, AddError) {
+  ASSERT_OK_AND_ASSIGN(auto builder,
+                       NewContiguousListValueBuilder(value_manager()));
+  ASSERT_OK(builder->Add(IntValue(1)));
+  EXPECT_THAT(builder->Add(ErrorValue(absl::InternalError("test"))),
+              StatusIs(absl::StatusCode::kInternal, "test"));
+  EXPECT_EQ(builder->Size(), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ContiguousListValueTest, ContiguousListValueTest,
+    ::testing::Combine(::testing::Values(MemoryManagement::kPooling,
+                                         MemoryManagement::kReferenceCounting)),
+    ContiguousListValueTest::ToString);
+
+}  // namespace
+}  // namespace cel
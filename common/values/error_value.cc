@@ -77,7 +77,9 @@ bool IsNoSuchKey(ErrorValueView value) {
                           "Key not found in map");
 }
 
-std::string ErrorValue::DebugString() const { return ErrorDebugString(value_); }
+std::string ErrorValue::DebugString() const {
+  return ErrorDebugString(status());
+}
 
 absl::StatusOr<size_t> ErrorValue::GetSerializedSize(
     AnyToJsonConverter&) const {
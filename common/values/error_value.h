@@ -25,6 +25,7 @@
 #include <utility>
 
 #include "absl/base/attributes.h"
+#include "absl/base/call_once.h"
 #include "absl/base/nullability.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
@@ -33,6 +34,7 @@
 #include "absl/strings/string_view.h"
 #include "common/any.h"
 #include "common/json.h"
+#include "common/memory.h"
 #include "common/type.h"
 #include "common/value_kind.h"
 
@@ -45,6 +47,30 @@ class ErrorValue;
 class ErrorValueView;
 class TypeManager;
 
+// `LazyError` is an error whose `absl::Status` is only created when it is
+// first inspected. Errors which are usually discarded, such as those pruned by
+// `||` or `&&`, may use it to store their details compactly and skip
+// formatting a message nobody reads.
+class LazyError {
+ public:
+  virtual ~LazyError() = default;
+
+  // Returns the status of the error, creating it on first use. Thread-safe.
+  const absl::Status& status() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    absl::call_once(once_, [this]() {
+      status_ = Format();
+      ABSL_DCHECK(!status_.ok()) << "LazyError requires a non-OK absl::Status";
+    });
+    return status_;
+  }
+
+ private:
+  virtual absl::Status Format() const = 0;
+
+  mutable absl::once_flag once_;
+  mutable absl::Status status_;
+};
+
 // `ErrorValue` represents values of the `ErrorType`.
 class ABSL_ATTRIBUTE_TRIVIAL_ABI ErrorValue final {
  public:
@@ -57,6 +83,13 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI ErrorValue final {
     ABSL_DCHECK(!value_.ok()) << "ErrorValue requires a non-OK absl::Status";
   }
 
+  // Creates an error whose status is created from `error` when it is first
+  // inspected, see `LazyError`. Taking a view of it creates the status.
+  explicit ErrorValue(Shared<const LazyError> error) noexcept
+      : lazy_(std::move(error)) {
+    ABSL_DCHECK(lazy_) << "ErrorValue requires a LazyError";
+  }
+
   explicit ErrorValue(ErrorValueView value) noexcept;
 
   // By default, this creates an UNKNOWN error. You should always create a more
@@ -66,10 +99,12 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI ErrorValue final {
 
   ErrorValue& operator=(const ErrorValue&) = default;
 
-  ErrorValue(ErrorValue&& other) noexcept : value_(std::move(other.value_)) {}
+  ErrorValue(ErrorValue&& other) noexcept
+      : value_(std::move(other.value_)), lazy_(std::move(other.lazy_)) {}
 
   ErrorValue& operator=(ErrorValue&& other) noexcept {
     value_ = std::move(other.value_);
+    lazy_ = std::move(other.lazy_);
     return *this;
   }
 
@@ -114,12 +149,12 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI ErrorValue final {
 
   bool IsZeroValue() const { return false; }
 
-  absl::Status NativeValue() const& {
-    ABSL_DCHECK(!value_.ok()) << "use of moved-from ErrorValue";
-    return value_;
-  }
+  absl::Status NativeValue() const& { return status(); }
 
   absl::Status NativeValue() && {
+    if (lazy_) {
+      return lazy_->status();
+    }
     ABSL_DCHECK(!value_.ok()) << "use of moved-from ErrorValue";
     return std::move(value_);
   }
@@ -127,12 +162,23 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI ErrorValue final {
   void swap(ErrorValue& other) noexcept {
     using std::swap;
     swap(value_, other.value_);
+    swap(lazy_, other.lazy_);
   }
 
  private:
   friend class ErrorValueView;
 
+  const absl::Status& status() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    if (lazy_) {
+      return lazy_->status();
+    }
+    ABSL_DCHECK(!value_.ok()) << "use of moved-from ErrorValue";
+    return value_;
+  }
+
+  // OK if `lazy_` is set.
   absl::Status value_;
+  Shared<const LazyError> lazy_;
 };
 
 ErrorValue NoSuchFieldError(absl::string_view field);
@@ -168,9 +214,7 @@ class ErrorValueView final {
 
   // NOLINTNEXTLINE(google-explicit-constructor)
   ErrorValueView(const ErrorValue& value ABSL_ATTRIBUTE_LIFETIME_BOUND) noexcept
-      : value_(std::addressof(value.value_)) {
-    ABSL_DCHECK(!value_->ok()) << "use of moved-from ErrorValue";
-  }
+      : value_(std::addressof(value.status())) {}
 
   // By default, this creates an UNKNOWN error. You should always create a more
   // specific error value.
@@ -45,6 +45,36 @@ TEST_P(ErrorValueTest, OkStatus) {
   EXPECT_DEBUG_DEATH(static_cast<void>(ErrorValue(absl::OkStatus())), _);
 }
 
+class CountingLazyError final : public LazyError {
+ public:
+  explicit CountingLazyError(int& formats) : formats_(formats) {}
+
+ private:
+  absl::Status Format() const override {
+    ++formats_;
+    return absl::NotFoundError("lazy");
+  }
+
+  int& formats_;
+};
+
+TEST_P(ErrorValueTest, Lazy) {
+  int formats = 0;
+  ErrorValue value(
+      memory_manager().MakeShared<const CountingLazyError>(formats));
+  ErrorValue copy = value;
+  Value wrapped(std::move(copy));
+  EXPECT_TRUE(InstanceOf<ErrorValue>(wrapped));
+  EXPECT_EQ(formats, 0);
+
+  EXPECT_THAT(value.NativeValue(), StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(Cast<ErrorValue>(wrapped).NativeValue(),
+              StatusIs(absl::StatusCode::kNotFound, "lazy"));
+  EXPECT_THAT(ErrorValueView(value).NativeValue(),
+              StatusIs(absl::StatusCode::kNotFound, "lazy"));
+  EXPECT_EQ(formats, 1);
+}
+
 TEST_P(ErrorValueTest, Kind) {
   EXPECT_EQ(ErrorValue(absl::CancelledError()).kind(), ErrorValue::kKind);
   EXPECT_EQ(Value(ErrorValue(absl::CancelledError())).kind(),
@@ -261,6 +261,18 @@ absl::StatusOr<std::pair<ValueView, bool>> LegacyMapValue::Find(
   return (*legacy_map_value_vtable.find)(impl_, value_manager, key, scratch);
 }
 
+absl::StatusOr<std::pair<ValueView, bool>> LegacyMapValue::FindHashed(
+    ValueManager& value_manager, ValueView key, size_t,
+    Value& scratch) const {
+  return Find(value_manager, key, scratch);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>> LegacyMapValue::FindByString(
+    ValueManager& value_manager, absl::string_view key, size_t,
+    Value& scratch) const {
+  return Find(value_manager, StringValueView(key), scratch);
+}
+
 absl::StatusOr<ValueView> LegacyMapValue::Has(ValueManager& value_manager,
                                               ValueView key,
                                               Value& scratch) const {
@@ -366,6 +378,18 @@ absl::StatusOr<std::pair<ValueView, bool>> LegacyMapValueView::Find(
   return (*legacy_map_value_vtable.find)(impl_, value_manager, key, scratch);
 }
 
+absl::StatusOr<std::pair<ValueView, bool>> LegacyMapValueView::FindHashed(
+    ValueManager& value_manager, ValueView key, size_t,
+    Value& scratch) const {
+  return Find(value_manager, key, scratch);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>> LegacyMapValueView::FindByString(
+    ValueManager& value_manager, absl::string_view key, size_t,
+    Value& scratch) const {
+  return Find(value_manager, StringValueView(key), scratch);
+}
+
 absl::StatusOr<ValueView> LegacyMapValueView::Has(ValueManager& value_manager,
                                                   ValueView key,
                                                   Value& scratch) const {
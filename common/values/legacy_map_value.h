@@ -124,6 +124,15 @@ class LegacyMapValue final {
       ValueManager& value_manager, ValueView key,
       Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
 
+  // Legacy maps hash keys themselves, so `hash` is ignored.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
                                 Value& scratch
                                     ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
@@ -246,6 +255,15 @@ class LegacyMapValueView final {
       ValueManager& value_manager, ValueView key,
       Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
 
+  // Legacy maps hash keys themselves, so `hash` is ignored.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
                                 Value& scratch
                                     ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
@@ -183,6 +183,23 @@ class MapValue final {
   absl::StatusOr<std::pair<Value, bool>> Find(ValueManager& value_manager,
                                               ValueView key) const;
 
+  // Same as `Find`, given `hash` which must be `MapKeyHash(key)`. Maps keyed
+  // by `MapKeyHash` use it instead of hashing `key` again, which pays off
+  // when the key is known ahead of time.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  // Same as `Find` for the string key `key`, without creating a `StringValue`
+  // for it. Maps keyed by strings, such as JSON objects, look up `key`
+  // directly. `hash` must be `MapKeyHash` of `key` as a string value.
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   // See the corresponding member function of `MapValueInterface` for
   // documentation.
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
@@ -451,6 +468,23 @@ class MapValueView final {
   absl::StatusOr<std::pair<Value, bool>> Find(ValueManager& value_manager,
                                               ValueView key) const;
 
+  // Same as `Find`, given `hash` which must be `MapKeyHash(key)`. Maps keyed
+  // by `MapKeyHash` use it instead of hashing `key` again, which pays off
+  // when the key is known ahead of time.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  // Same as `Find` for the string key `key`, without creating a `StringValue`
+  // for it. Maps keyed by strings, such as JSON objects, look up `key`
+  // directly. `hash` must be `MapKeyHash` of `key` as a string value.
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   // See the corresponding member function of `MapValueInterface` for
   // documentation.
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
@@ -12,15 +12,38 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstddef>
 #include <string>
 
+#include "absl/hash/hash.h"
+#include "absl/log/absl_log.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "common/any.h"
+#include "common/casting.h"
 #include "common/value.h"
+#include "common/value_kind.h"
 
 namespace cel {
 
+size_t MapKeyHash(ValueView key) {
+  switch (key.kind()) {
+    case ValueKind::kBool:
+      return absl::HashOf(ValueKind::kBool, Cast<BoolValueView>(key));
+    case ValueKind::kInt:
+      return absl::HashOf(ValueKind::kInt, Cast<IntValueView>(key));
+    case ValueKind::kUint:
+      return absl::HashOf(ValueKind::kUint, Cast<UintValueView>(key));
+    case ValueKind::kString:
+      return absl::HashOf(
+          ValueKind::kString,
+          common_internal::AsSharedByteStringView(Cast<StringValueView>(key))
+              .ContentHash());
+    default:
+      ABSL_DLOG(FATAL) << "Invalid map key value: " << key;
+      return 0;
+  }
+}
 
 absl::StatusOr<std::string> MapValueInterface::GetTypeUrl(
     absl::string_view prefix) const {
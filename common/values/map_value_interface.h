@@ -18,6 +18,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_COMMON_VALUES_MAP_VALUE_INTERFACE_H_
 #define THIRD_PARTY_CEL_CPP_COMMON_VALUES_MAP_VALUE_INTERFACE_H_
 
+#include <cstddef>
 #include <string>
 
 #include "absl/functional/function_ref.h"
@@ -36,6 +37,11 @@ class ValueView;
 class MapValue;
 class MapValueView;
 
+// Returns the hash of `key` as a map key, for `MapValue::FindHashed`. Keys
+// which compare equal as map keys have the same hash, and interned string
+// keys return their cached hash. `key` must be a bool, int, uint or string.
+size_t MapKeyHash(ValueView key);
+
 class MapValueInterface : public ValueInterface {
  public:
   using alternative_type = MapValue;
@@ -64,6 +70,11 @@ class MapValueInterface : public ValueInterface {
   using ForEachCallback =
       absl::FunctionRef<absl::StatusOr<bool>(ValueView, ValueView)>;
 
+  // Implementations may also offer `FindHashed`, which behaves like `Find`
+  // given `MapKeyHash(key)`, so that lookups with keys known ahead of time,
+  // such as constants, can skip hashing them. Implementations keyed by
+  // another hash ignore it.
+
  protected:
   Type GetTypeImpl(TypeManager& type_manager) const override {
     return Type(type_manager.GetDynDynMapType());
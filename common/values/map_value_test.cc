@@ -215,6 +215,52 @@ TEST_P(MapValueTest, Find) {
   ASSERT_FALSE(ok);
 }
 
+TEST_P(MapValueTest, FindHashed) {
+  Value scratch;
+  ASSERT_OK_AND_ASSIGN(
+      auto map_value,
+      NewJsonMapValue(std::pair{StringValue("foo"), IntValue(1)},
+                      std::pair{StringValue("bar"), IntValue(2)}));
+  ValueView value;
+  bool ok;
+  StringValue key("bar");
+  ASSERT_OK_AND_ASSIGN(std::tie(value, ok),
+                       map_value.FindHashed(value_manager(), key,
+                                            MapKeyHash(key), scratch));
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(InstanceOf<IntValueView>(value));
+  ASSERT_EQ(Cast<IntValueView>(value).NativeValue(), 2);
+  StringValue missing("baz");
+  ASSERT_OK_AND_ASSIGN(std::tie(value, ok),
+                       map_value.FindHashed(value_manager(), missing,
+                                            MapKeyHash(missing), scratch));
+  ASSERT_FALSE(ok);
+}
+
+TEST_P(MapValueTest, FindByString) {
+  Value scratch;
+  ASSERT_OK_AND_ASSIGN(
+      auto map_value,
+      NewJsonMapValue(std::pair{StringValue("foo"), IntValue(1)},
+                      std::pair{StringValue("bar"), IntValue(2)}));
+  ValueView value;
+  bool ok;
+  ASSERT_OK_AND_ASSIGN(std::tie(value, ok),
+                       map_value.FindByString(value_manager(), "bar", scratch));
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(InstanceOf<IntValueView>(value));
+  ASSERT_EQ(Cast<IntValueView>(value).NativeValue(), 2);
+  ASSERT_OK_AND_ASSIGN(std::tie(value, ok),
+                       map_value.FindByString(value_manager(), "baz", scratch));
+  ASSERT_FALSE(ok);
+}
+
+TEST(MapKeyHash, MatchesAcrossRepresentations) {
+  EXPECT_EQ(MapKeyHash(StringValueView("foo")),
+            MapKeyHash(StringValueView(absl::Cord("foo"))));
+  EXPECT_NE(MapKeyHash(IntValueView(1)), MapKeyHash(UintValueView(1)));
+}
+
 TEST_P(MapValueTest, Has) {
   Value scratch;
   ASSERT_OK_AND_ASSIGN(
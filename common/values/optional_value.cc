@@ -15,6 +15,7 @@
 #include <string>
 #include <utility>
 
+#include "absl/base/no_destructor.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -56,6 +57,29 @@ struct NativeTypeTraits<FullOptionalValue> {
   }
 };
 
+namespace {
+
+// Optionals of the values which can be enumerated, shared by every memory
+// manager so that wrapping them doesn't allocate.
+struct SharedOptionalValues {
+  static OptionalValue Make(cel::Value value) {
+    return OptionalValue(
+        MemoryManagerRef::Unmanaged().MakeShared<FullOptionalValue>(
+            std::move(value)));
+  }
+
+  OptionalValue null_value = Make(NullValue());
+  OptionalValue false_value = Make(BoolValue(false));
+  OptionalValue true_value = Make(BoolValue(true));
+};
+
+const SharedOptionalValues& GetSharedOptionalValues() {
+  static const absl::NoDestructor<SharedOptionalValues> values;
+  return *values;
+}
+
+}  // namespace
+
 std::string OptionalValueInterface::DebugString() const {
   if (HasValue()) {
     cel::Value scratch;
@@ -68,6 +92,16 @@ OptionalValue OptionalValue::Of(MemoryManagerRef memory_manager,
                                 cel::Value value) {
   ABSL_DCHECK(value.kind() != ValueKind::kError &&
               value.kind() != ValueKind::kUnknown);
+  switch (value.kind()) {
+    case ValueKind::kNull:
+      return GetSharedOptionalValues().null_value;
+    case ValueKind::kBool:
+      return Cast<BoolValue>(value).NativeValue()
+                 ? GetSharedOptionalValues().true_value
+                 : GetSharedOptionalValues().false_value;
+    default:
+      break;
+  }
   return OptionalValue(
       memory_manager.MakeShared<FullOptionalValue>(std::move(value)));
 }
@@ -151,6 +151,19 @@ TEST_P(OptionalValueTest, Value) {
   EXPECT_EQ(Cast<IntValueView>(element), IntValue());
 }
 
+TEST_P(OptionalValueTest, SharesOptionalsOfEnumerableValues) {
+  EXPECT_EQ(&*OptionalOf(BoolValue(true)), &*OptionalOf(BoolValue(true)));
+  EXPECT_EQ(&*OptionalOf(BoolValue(false)), &*OptionalOf(BoolValue(false)));
+  EXPECT_EQ(&*OptionalOf(NullValue()), &*OptionalOf(NullValue()));
+  EXPECT_NE(&*OptionalOf(BoolValue(true)), &*OptionalOf(BoolValue(false)));
+
+  Value scratch;
+  auto value = OptionalOf(BoolValue(true));
+  EXPECT_TRUE(value.HasValue());
+  EXPECT_EQ(Cast<BoolValueView>(value.Value(scratch)), BoolValue(true));
+  EXPECT_EQ(OptionalOf(NullValue()).DebugString(), "optional(null)");
+}
+
 INSTANTIATE_TEST_SUITE_P(
     OptionalValueTest, OptionalValueTest,
     ::testing::Values(MemoryManagement::kPooling,
@@ -24,6 +24,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_COMMON_VALUES_PARSED_LIST_VALUE_H_
 #define THIRD_PARTY_CEL_CPP_COMMON_VALUES_PARSED_LIST_VALUE_H_
 
+#include <atomic>
 #include <cstddef>
 #include <ostream>
 #include <string>
@@ -108,6 +109,13 @@ class ParsedListValueInterface : public ListValueInterface {
   virtual absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager,
                                             size_t index,
                                             Value& scratch) const = 0;
+
+ private:
+  friend absl::StatusOr<size_t> ValueHash(ValueManager& value_manager,
+                                          ValueView value);
+
+  // Cached `ValueHash` of this list, or zero if it was not computed yet.
+  mutable std::atomic<size_t> hash_{0};
 };
 
 class ParsedListValue {
@@ -103,6 +103,60 @@ absl::StatusOr<std::pair<ValueView, bool>> ParsedMapValueInterface::Find(
   return std::pair{NullValueView{}, false};
 }
 
+absl::StatusOr<std::pair<ValueView, bool>> ParsedMapValueInterface::FindHashed(
+    ValueManager& value_manager, ValueView key, size_t hash,
+    Value& scratch) const {
+  switch (key.kind()) {
+    case ValueKind::kError:
+      ABSL_FALLTHROUGH_INTENDED;
+    case ValueKind::kUnknown:
+      scratch = Value(key);
+      return std::pair{scratch, false};
+    case ValueKind::kBool:
+      ABSL_FALLTHROUGH_INTENDED;
+    case ValueKind::kInt:
+      ABSL_FALLTHROUGH_INTENDED;
+    case ValueKind::kUint:
+      ABSL_FALLTHROUGH_INTENDED;
+    case ValueKind::kString:
+      break;
+    default:
+      return InvalidMapKeyTypeError(key.kind());
+  }
+  CEL_ASSIGN_OR_RETURN(auto value,
+                       FindHashedImpl(value_manager, key, hash, scratch));
+  if (value.has_value()) {
+    return std::pair{*value, true};
+  }
+  return std::pair{NullValueView{}, false};
+}
+
+absl::StatusOr<absl::optional<ValueView>>
+ParsedMapValueInterface::FindHashedImpl(ValueManager& value_manager,
+                                        ValueView key, size_t,
+                                        Value& scratch) const {
+  return FindImpl(value_manager, key, scratch);
+}
+
+absl::StatusOr<std::pair<ValueView, bool>>
+ParsedMapValueInterface::FindByString(ValueManager& value_manager,
+                                      absl::string_view key, size_t hash,
+                                      Value& scratch) const {
+  CEL_ASSIGN_OR_RETURN(auto value,
+                       FindStringImpl(value_manager, key, hash, scratch));
+  if (value.has_value()) {
+    return std::pair{*value, true};
+  }
+  return std::pair{NullValueView{}, false};
+}
+
+absl::StatusOr<absl::optional<ValueView>>
+ParsedMapValueInterface::FindStringImpl(ValueManager& value_manager,
+                                        absl::string_view key, size_t hash,
+                                        Value& scratch) const {
+  return FindHashedImpl(value_manager, StringValueView(key), hash, scratch);
+}
+
 absl::StatusOr<ValueView> ParsedMapValueInterface::Has(
     ValueManager& value_manager, ValueView key, Value& scratch) const {
   switch (key.kind()) {
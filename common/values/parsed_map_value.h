@@ -24,6 +24,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_COMMON_VALUES_PARSED_MAP_VALUE_H_
 #define THIRD_PARTY_CEL_CPP_COMMON_VALUES_PARSED_MAP_VALUE_H_
 
+#include <atomic>
 #include <cstddef>
 #include <ostream>
 #include <string>
@@ -103,6 +104,17 @@ class ParsedMapValueInterface : public MapValueInterface {
       ValueManager& value_manager, ValueView key,
       Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
 
+  // Same as `Find`, given `hash` which must be `MapKeyHash(key)`.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  // Same as `FindHashed` for the string key `key`, without creating a
+  // `StringValue` for it.
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   // Checks whether the given key is present in the map.
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
                                 Value& scratch
@@ -131,9 +143,29 @@ class ParsedMapValueInterface : public MapValueInterface {
       ValueManager& value_manager, ValueView key,
       Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const = 0;
 
+  // Called by `FindHashed` after performing various argument checks. The
+  // default implementation ignores `hash` and calls `FindImpl`.
+  virtual absl::StatusOr<absl::optional<ValueView>> FindHashedImpl(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  // Called by `FindByString`. The default implementation calls
+  // `FindHashedImpl` with a view of `key`. Maps keyed by strings, such as
+  // JSON objects, may look up `key` directly.
+  virtual absl::StatusOr<absl::optional<ValueView>> FindStringImpl(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   // Called by `Has` after performing various argument checks.
   virtual absl::StatusOr<bool> HasImpl(ValueManager& value_manager,
                                        ValueView key) const = 0;
+
+ private:
+  friend absl::StatusOr<size_t> ValueHash(ValueManager& value_manager,
+                                          ValueView value);
+
+  // Cached `ValueHash` of this map, or zero if it was not computed yet.
+  mutable std::atomic<size_t> hash_{0};
 };
 
 class ParsedMapValue {
@@ -228,6 +260,18 @@ class ParsedMapValue {
       ValueManager& value_manager, ValueView key,
       Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
 
+  // See the corresponding member function of `MapValueInterface` for
+  // documentation.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  // See the corresponding member function of `MapValueInterface` for
+  // documentation.
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   // See the corresponding member function of `MapValueInterface` for
   // documentation.
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
@@ -431,6 +475,18 @@ class ParsedMapValueView {
       ValueManager& value_manager, ValueView key,
       Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
 
+  // See the corresponding member function of `MapValueInterface` for
+  // documentation.
+  absl::StatusOr<std::pair<ValueView, bool>> FindHashed(
+      ValueManager& value_manager, ValueView key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
+  // See the corresponding member function of `MapValueInterface` for
+  // documentation.
+  absl::StatusOr<std::pair<ValueView, bool>> FindByString(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const;
+
   // See the corresponding member function of `MapValueInterface` for
   // documentation.
   absl::StatusOr<ValueView> Has(ValueManager& value_manager, ValueView key,
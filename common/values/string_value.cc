@@ -105,7 +105,10 @@ absl::StatusOr<ValueView> StringValue::Equal(ValueManager&, ValueView other,
 }
 
 size_t StringValue::Size() const {
-  return NativeValue([](const auto& alternative) -> size_t {
+  return NativeValue([this](const auto& alternative) -> size_t {
+    if (value_.IsAscii()) {
+      return alternative.size();
+    }
     return internal::Utf8CodePointCount(alternative);
   });
 }
@@ -128,8 +131,8 @@ bool StringValue::Equals(const absl::Cord& string) const {
 }
 
 bool StringValue::Equals(StringValueView string) const {
-  return string.NativeValue(
-      [this](const auto& alternative) -> bool { return Equals(alternative); });
+  // Short-circuits on shared storage, such as interned constants.
+  return common_internal::SharedByteStringView(value_) == string.value_;
 }
 
 namespace {
@@ -224,7 +227,10 @@ absl::StatusOr<ValueView> StringValueView::Equal(ValueManager&, ValueView other,
 }
 
 size_t StringValueView::Size() const {
-  return NativeValue([](const auto& alternative) -> size_t {
+  return NativeValue([this](const auto& alternative) -> size_t {
+    if (value_.IsAscii()) {
+      return alternative.size();
+    }
     return internal::Utf8CodePointCount(alternative);
   });
 }
@@ -247,8 +253,7 @@ bool StringValueView::Equals(const absl::Cord& string) const {
 }
 
 bool StringValueView::Equals(StringValueView string) const {
-  return string.NativeValue(
-      [this](const auto& alternative) -> bool { return Equals(alternative); });
+  return value_ == string.value_;
 }
 
 int StringValueView::Compare(absl::string_view string) const {
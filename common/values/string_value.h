@@ -180,6 +180,7 @@ class StringValue final {
   friend class StringValueView;
   friend const common_internal::SharedByteString&
   common_internal::AsSharedByteString(const StringValue& value);
+  friend void common_internal::MarkAsciiStringValue(StringValue& value);
 
   common_internal::SharedByteString value_;
 };
@@ -408,7 +409,11 @@ inline StringValue StringValue::Concat(ValueManager&, StringValueView lhs,
   absl::Cord result;
   result.Append(lhs.ToCord());
   result.Append(rhs.ToCord());
-  return StringValue(std::move(result));
+  StringValue value(std::move(result));
+  if (lhs.value_.IsAscii() && rhs.value_.IsAscii()) {
+    value.value_.SetAscii();
+  }
+  return value;
 }
 
 namespace common_internal {
@@ -421,6 +426,13 @@ inline SharedByteStringView AsSharedByteStringView(StringValueView value) {
   return value.value_;
 }
 
+// Records that `value` is entirely 7-bit ASCII, allowing `Size()` and
+// code point based indexing to use byte offsets. Only call this when the
+// contents are known to be ASCII, e.g. after validating them.
+inline void MarkAsciiStringValue(StringValue& value) {
+  value.value_.SetAscii();
+}
+
 }  // namespace common_internal
 
 }  // namespace cel
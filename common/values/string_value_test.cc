@@ -133,6 +133,31 @@ TEST_P(StringValueTest, LessThan) {
   EXPECT_LT(absl::Cord("bar"), StringValue("foo"));
 }
 
+TEST_P(StringValueTest, Size) {
+  ASSERT_OK_AND_ASSIGN(auto ascii, value_manager().CreateStringValue("foo"));
+  EXPECT_TRUE(common_internal::AsSharedByteString(ascii).IsAscii());
+  EXPECT_EQ(ascii.Size(), 3);
+  EXPECT_EQ(StringValueView(ascii).Size(), 3);
+
+  ASSERT_OK_AND_ASSIGN(auto unicode,
+                       value_manager().CreateStringValue("f\xc3\xb6o"));
+  EXPECT_FALSE(common_internal::AsSharedByteString(unicode).IsAscii());
+  EXPECT_EQ(unicode.Size(), 3);
+
+  ASSERT_OK_AND_ASSIGN(
+      auto cord,
+      value_manager().CreateStringValue(absl::MakeFragmentedCord({"f", "o"})));
+  EXPECT_TRUE(common_internal::AsSharedByteString(cord).IsAscii());
+  EXPECT_EQ(cord.Size(), 2);
+
+  auto concat = StringValue::Concat(value_manager(), ascii, cord);
+  EXPECT_TRUE(common_internal::AsSharedByteString(concat).IsAscii());
+  EXPECT_EQ(concat.Size(), 5);
+  concat = StringValue::Concat(value_manager(), ascii, unicode);
+  EXPECT_FALSE(common_internal::AsSharedByteString(concat).IsAscii());
+  EXPECT_EQ(concat.Size(), 6);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     StringValueTest, StringValueTest,
     ::testing::Combine(::testing::Values(MemoryManagement::kPooling,
@@ -19,6 +19,7 @@
 
 #include <utility>
 
+#include "common/internal/reference_count.h"
 #include "common/memory.h"
 #include "common/type.h"
 #include "common/type_reflector.h"
@@ -39,6 +40,11 @@ class ThreadCompatibleValueManager : public ThreadCompatibleTypeManager,
 
   using ThreadCompatibleTypeManager::GetMemoryManager;
 
+  // Evaluations whose values stay on one thread can hold this scope while
+  // using the manager, so that the reference counts of the values created
+  // meanwhile are not atomic. See `ScopedNonAtomicReferenceCounts`.
+  using NonAtomicReferenceCountScope = ScopedNonAtomicReferenceCounts;
+
  protected:
   TypeReflector& GetTypeReflector() const final { return *type_reflector_; }
 
@@ -104,6 +104,34 @@ TEST_P(TypeValueTest, As) {
   EXPECT_THAT(As<TypeValue>(Value(TypeValue(AnyType()))), Ne(absl::nullopt));
 }
 
+TEST_P(TypeValueTest, GetTypeValue) {
+  EXPECT_EQ(value_manager().GetTypeValue(IntValueView(1)).NativeValue(),
+            IntTypeView());
+  EXPECT_EQ(value_manager().GetTypeValue(StringValueView("foo")).NativeValue(),
+            StringTypeView());
+  EXPECT_EQ(value_manager().GetTypeValue(TypeValueView(IntTypeView()))
+                .NativeValue(),
+            TypeTypeView());
+  EXPECT_EQ(
+      value_manager().GetTypeValue(value_manager().GetZeroDynListValue())
+          .NativeValue(),
+      TypeView(value_manager().GetDynListType()));
+}
+
+TEST_P(TypeValueTest, InternedTypesEqual) {
+  ListType list_type = type_factory().CreateListType(IntTypeView());
+  EXPECT_EQ(TypeValue(list_type).NativeValue(),
+            TypeValue(type_factory().CreateListType(IntTypeView()))
+                .NativeValue());
+  EXPECT_NE(TypeValue(list_type).NativeValue(),
+            TypeValueView(type_factory().GetDynListType()).NativeValue());
+  StructType struct_type = type_factory().CreateStructType("test.Message");
+  EXPECT_EQ(struct_type, type_factory().CreateStructType("test.Message"));
+  EXPECT_EQ(struct_type,
+            StructType(MemoryManagerRef::ReferenceCounting(), "test.Message"));
+  EXPECT_NE(struct_type, type_factory().CreateStructType("test.Other"));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     TypeValueTest, TypeValueTest,
     ::testing::Combine(::testing::Values(MemoryManagement::kPooling,
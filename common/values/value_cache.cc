@@ -14,6 +14,7 @@
 
 #include "common/values/value_cache.h"
 
+#include <cstddef>
 #include <utility>
 
 #include "absl/base/no_destructor.h"
@@ -24,6 +25,7 @@
 #include "common/type.h"
 #include "common/types/type_cache.h"
 #include "common/value.h"
+#include "common/value_kind.h"
 
 namespace cel::common_internal {
 
@@ -93,6 +95,15 @@ OptionalValueView ProcessLocalValueCache::GetEmptyDynOptionalValue() const {
   return *dyn_optional_value_;
 }
 
+absl::optional<TypeValueView> ProcessLocalValueCache::GetTypeValue(
+    ValueKind kind) const {
+  const auto index = static_cast<size_t>(kind);
+  if (index >= type_values_.size() || !type_values_[index].has_value()) {
+    return absl::nullopt;
+  }
+  return TypeValueView(*type_values_[index]);
+}
+
 ProcessLocalValueCache::ProcessLocalValueCache()
     : default_error_value_(absl::UnknownError("unknown error")) {
   MemoryManagerRef memory_manager = MemoryManagerRef::Unmanaged();
@@ -144,6 +155,19 @@ ProcessLocalValueCache::ProcessLocalValueCache()
   dyn_optional_value_ =
       GetEmptyOptionalValue(ProcessLocalTypeCache::Get()->GetDynOptionalType());
   ABSL_DCHECK(dyn_optional_value_.has_value());
+  const auto set_type_value = [this](ValueKind kind, Type type) {
+    type_values_[static_cast<size_t>(kind)] = TypeValue(std::move(type));
+  };
+  set_type_value(ValueKind::kNull, NullType());
+  set_type_value(ValueKind::kBool, BoolType());
+  set_type_value(ValueKind::kInt, IntType());
+  set_type_value(ValueKind::kUint, UintType());
+  set_type_value(ValueKind::kDouble, DoubleType());
+  set_type_value(ValueKind::kString, StringType());
+  set_type_value(ValueKind::kBytes, BytesType());
+  set_type_value(ValueKind::kDuration, DurationType());
+  set_type_value(ValueKind::kTimestamp, TimestampType());
+  set_type_value(ValueKind::kType, TypeType());
 }
 
 }  // namespace cel::common_internal
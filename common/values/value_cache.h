@@ -17,6 +17,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_COMMON_VALUES_VALUE_CACHE_H_
 #define THIRD_PARTY_CEL_CPP_COMMON_VALUES_VALUE_CACHE_H_
 
+#include <array>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -36,6 +37,7 @@
 #include "common/types/optional_type.h"
 #include "common/types/type_cache.h"
 #include "common/value.h"
+#include "common/value_kind.h"
 
 namespace cel {
 
@@ -68,6 +70,10 @@ class ProcessLocalValueCache final {
 
   OptionalValueView GetEmptyDynOptionalValue() const;
 
+  // Returns the type of values of `kind` if it doesn't depend on the value,
+  // as for the primitive types.
+  absl::optional<TypeValueView> GetTypeValue(ValueKind kind) const;
+
  private:
   friend class absl::NoDestructor<ProcessLocalValueCache>;
 
@@ -81,6 +87,10 @@ class ProcessLocalValueCache final {
   absl::optional<ParsedMapValueView> dyn_dyn_map_value_;
   absl::optional<ParsedMapValueView> string_dyn_map_value_;
   absl::optional<OptionalValueView> dyn_optional_value_;
+  // Indexed by `ValueKind`.
+  std::array<absl::optional<TypeValue>,
+             static_cast<size_t>(ValueKind::kOpaque) + 1>
+      type_values_;
 };
 
 class EmptyListValue final : public ParsedListValueInterface {
@@ -539,6 +539,7 @@ SharedByteStringView AsSharedByteStringView(BytesValueView value);
 
 const SharedByteString& AsSharedByteString(const StringValue& value);
 SharedByteStringView AsSharedByteStringView(StringValueView value);
+void MarkAsciiStringValue(StringValue& value);
 
 }  // namespace common_internal
 
@@ -0,0 +1,202 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/branch_profile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "common/ast_rewrite.h"
+#include "common/ast_traverse.h"
+#include "common/ast_visitor_base.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/instrumentation.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::AstRewriterBase;
+using ::cel::AstVisitorBase;
+using ::cel::CallExpr;
+using ::cel::Expr;
+using ::cel::SelectExpr;
+using ::cel::ast_internal::AstImpl;
+
+// Returns the value deciding the result of `call` on its own if it is a
+// logical operator.
+absl::optional<bool> DecisiveValue(const CallExpr& call) {
+  if (call.has_target() || call.args().size() != 2) {
+    return absl::nullopt;
+  }
+  if (call.function() == cel::builtin::kAnd) {
+    return false;
+  }
+  if (call.function() == cel::builtin::kOr) {
+    return true;
+  }
+  return absl::nullopt;
+}
+
+class OperatorCollector : public AstVisitorBase {
+ public:
+  struct Operator {
+    int64_t id;
+    int64_t operand_ids[2];
+    bool decisive_value;
+  };
+
+  void PreVisitExpr(const Expr&) override {}
+
+  void PostVisitExpr(const Expr&) override {}
+
+  void PreVisitSelect(const Expr&, const SelectExpr&) override {}
+
+  void PostVisitCall(const Expr& expr, const CallExpr& call) override {
+    if (absl::optional<bool> decisive = DecisiveValue(call);
+        decisive.has_value()) {
+      operators_.push_back(Operator{
+          expr.id(), {call.args()[0].id(), call.args()[1].id()}, *decisive});
+    }
+  }
+
+  const std::vector<Operator>& operators() const { return operators_; }
+
+ private:
+  std::vector<Operator> operators_;
+};
+
+class BranchReorderingRewriter : public AstRewriterBase {
+ public:
+  BranchReorderingRewriter(const BranchProfile& profile,
+                           int64_t min_evaluations)
+      : profile_(profile), min_evaluations_(min_evaluations) {}
+
+  bool PostVisitRewrite(Expr& expr) override {
+    if (!expr.has_call_expr() ||
+        !DecisiveValue(expr.call_expr()).has_value()) {
+      return false;
+    }
+    absl::optional<BranchProfile::OperandCounts> first =
+        profile_.GetOperandCounts(expr.id(), 0);
+    absl::optional<BranchProfile::OperandCounts> second =
+        profile_.GetOperandCounts(expr.id(), 1);
+    if (!first.has_value() || !second.has_value() ||
+        first->evaluations == 0 || second->evaluations < min_evaluations_) {
+      return false;
+    }
+    // Compare the rates at which the operands decided the result.
+    if (static_cast<double>(second->decisive) * first->evaluations <=
+        static_cast<double>(first->decisive) * second->evaluations) {
+      return false;
+    }
+    auto& args = expr.mutable_call_expr().mutable_args();
+    std::swap(args[0], args[1]);
+    return true;
+  }
+
+ private:
+  const BranchProfile& profile_;
+  int64_t min_evaluations_;
+};
+
+class BranchReorderingTransform : public AstTransform {
+ public:
+  BranchReorderingTransform(std::shared_ptr<const BranchProfile> profile,
+                            int64_t min_evaluations)
+      : profile_(std::move(profile)), min_evaluations_(min_evaluations) {}
+
+  absl::Status UpdateAst(PlannerContext&, AstImpl& ast) const override {
+    BranchReorderingRewriter rewriter(*profile_, min_evaluations_);
+    cel::AstRewrite(ast.root_expr(), rewriter);
+    return absl::OkStatus();
+  }
+
+ private:
+  std::shared_ptr<const BranchProfile> profile_;
+  int64_t min_evaluations_;
+};
+
+}  // namespace
+
+BranchProfile::BranchProfile(const AstImpl& ast) {
+  OperatorCollector collector;
+  cel::AstTraverse(ast.root_expr(), collector);
+  counters_ = std::make_unique<Counters[]>(2 * collector.operators().size());
+  size_t index = 0;
+  for (const auto& op : collector.operators()) {
+    operators_.insert({op.id, index});
+    for (int64_t operand_id : op.operand_ids) {
+      operands_.insert({operand_id, index});
+      counters_[index].decisive_value = op.decisive_value;
+      ++index;
+    }
+  }
+}
+
+void BranchProfile::Record(int64_t expr_id, const cel::Value& value) {
+  auto it = operands_.find(expr_id);
+  if (it == operands_.end()) {
+    return;
+  }
+  Counters& counters = counters_[it->second];
+  counters.evaluations.fetch_add(1, std::memory_order_relaxed);
+  if (value->Is<cel::BoolValue>() &&
+      value.As<cel::BoolValue>().NativeValue() == counters.decisive_value) {
+    counters.decisive.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+absl::optional<BranchProfile::OperandCounts> BranchProfile::GetOperandCounts(
+    int64_t expr_id, size_t index) const {
+  auto it = operators_.find(expr_id);
+  if (it == operators_.end() || index > 1) {
+    return absl::nullopt;
+  }
+  const Counters& counters = counters_[it->second + index];
+  OperandCounts counts;
+  counts.evaluations = counters.evaluations.load(std::memory_order_relaxed);
+  counts.decisive = counters.decisive.load(std::memory_order_relaxed);
+  return counts;
+}
+
+ProgramOptimizerFactory CreateBranchProfilingExtension(
+    std::shared_ptr<BranchProfile> profile) {
+  return CreateInstrumentationExtension(
+      [profile = std::move(profile)](const AstImpl&) -> Instrumentation {
+        return [profile](int64_t expr_id,
+                         const cel::Value& value) -> absl::Status {
+          profile->Record(expr_id, value);
+          return absl::OkStatus();
+        };
+      });
+}
+
+std::unique_ptr<AstTransform> CreateBranchReorderingTransform(
+    std::shared_ptr<const BranchProfile> profile, int64_t min_evaluations) {
+  return std::make_unique<BranchReorderingTransform>(std::move(profile),
+                                                     min_evaluations);
+}
+
+}  // namespace google::api::expr::runtime
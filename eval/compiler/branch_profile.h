@@ -0,0 +1,98 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_BRANCH_PROFILE_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_BRANCH_PROFILE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// The outcomes of the operands of the logical operators (`&&` and `||`) of
+// one expression, recorded by evaluations of a profiling plan of the
+// expression (see CreateBranchProfilingExtension).
+//
+// Thread safe.
+class BranchProfile {
+ public:
+  struct OperandCounts {
+    // The number of times the operand was evaluated.
+    int64_t evaluations = 0;
+    // The number of those evaluations which decided the result of the
+    // operator on their own, i.e. with `false` for `&&` or `true` for `||`.
+    int64_t decisive = 0;
+  };
+
+  // Creates an empty profile for the logical operators of `ast`, which are
+  // identified by expression id.
+  explicit BranchProfile(const cel::ast_internal::AstImpl& ast);
+
+  BranchProfile(const BranchProfile&) = delete;
+  BranchProfile& operator=(const BranchProfile&) = delete;
+
+  // Records `value` as a result of the subexpression `expr_id`. Results of
+  // subexpressions which aren't operands of a logical operator are ignored.
+  void Record(int64_t expr_id, const cel::Value& value);
+
+  // Returns the counts of the operand `index` (0 or 1) of the logical operator
+  // `expr_id`, or `absl::nullopt` if it isn't a logical operator of the
+  // profiled expression.
+  absl::optional<OperandCounts> GetOperandCounts(int64_t expr_id,
+                                                 size_t index) const;
+
+ private:
+  struct Counters {
+    std::atomic<int64_t> evaluations{0};
+    std::atomic<int64_t> decisive{0};
+    bool decisive_value = false;
+  };
+
+  // Index of the counters of the first operand of each operator.
+  absl::flat_hash_map<int64_t, size_t> operators_;
+  // Index of the counters of each operand.
+  absl::flat_hash_map<int64_t, size_t> operands_;
+  std::unique_ptr<Counters[]> counters_;
+};
+
+// Create a new extension for the FlatExprBuilder recording the outcomes of
+// the logical operators of the planned expression in `profile`, which must
+// have been created for the same AST.
+ProgramOptimizerFactory CreateBranchProfilingExtension(
+    std::shared_ptr<BranchProfile> profile);
+
+// Create an AST transform swapping the operands of the logical operators whose
+// second operand decided the result more often than the first in `profile`,
+// so that re-plans of the profiled expression short-circuit sooner. Operators
+// whose second operand was evaluated less than `min_evaluations` times are
+// left as is.
+//
+// The operators are commutative: reordering the operands only changes which
+// error is returned when both are errors, and which operands are evaluated,
+// so the operands are expected not to fail the evaluation (e.g. with an
+// exhausted budget or a function returning a non-ok status).
+std::unique_ptr<AstTransform> CreateBranchReorderingTransform(
+    std::shared_ptr<const BranchProfile> profile, int64_t min_evaluations);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_BRANCH_PROFILE_H_
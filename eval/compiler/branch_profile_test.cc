@@ -0,0 +1,187 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/branch_profile.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/compiler/instrumentation.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::Value;
+using ::cel::ast_internal::AstImpl;
+using ::google::api::expr::parser::Parse;
+using testing::AllOf;
+using testing::Contains;
+using testing::Eq;
+using testing::Field;
+using testing::Not;
+using testing::Optional;
+
+class BranchProfileTest : public ::testing::Test {
+ public:
+  BranchProfileTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {}
+
+  void SetUp() override {
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  absl::StatusOr<std::unique_ptr<AstImpl>> ParseAst(absl::string_view expr) {
+    CEL_ASSIGN_OR_RETURN(auto parsed_expr, Parse(expr));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(parsed_expr));
+    return std::unique_ptr<AstImpl>(
+        AstImpl::CastFromPublicAst(ast.release()));
+  }
+
+  absl::StatusOr<Value> Evaluate(const FlatExpression& plan, bool a, bool b) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("a", BoolValue(a));
+    activation.InsertOrAssignValue("b", BoolValue(b));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_F(BranchProfileTest, RecordsOperandOutcomes) {
+  ASSERT_OK_AND_ASSIGN(auto ast, ParseAst("a && b"));
+  const int64_t and_id = ast->root_expr().id();
+  auto profile = std::make_shared<BranchProfile>(*ast);
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateBranchProfilingExpressionImpl(
+                           std::move(ast), /*issues=*/nullptr, profile));
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate(plan, true, false));
+  EXPECT_FALSE(result.As<BoolValue>().NativeValue());
+  ASSERT_OK(Evaluate(plan, true, true));
+  ASSERT_OK(Evaluate(plan, false, true));
+
+  EXPECT_THAT(
+      profile->GetOperandCounts(and_id, 0),
+      Optional(AllOf(Field(&BranchProfile::OperandCounts::evaluations, Eq(3)),
+                     Field(&BranchProfile::OperandCounts::decisive, Eq(1)))));
+  EXPECT_THAT(
+      profile->GetOperandCounts(and_id, 1),
+      Optional(AllOf(Field(&BranchProfile::OperandCounts::evaluations, Eq(2)),
+                     Field(&BranchProfile::OperandCounts::decisive, Eq(1)))));
+  EXPECT_EQ(profile->GetOperandCounts(and_id + 100, 0), absl::nullopt);
+}
+
+TEST_F(BranchProfileTest, ReordersOperandsDecidingMoreOften) {
+  ASSERT_OK_AND_ASSIGN(auto ast, ParseAst("a || b"));
+  const int64_t a_id = ast->root_expr().call_expr().args()[0].id();
+  const int64_t b_id = ast->root_expr().call_expr().args()[1].id();
+  std::unique_ptr<AstImpl> copy = ast->DeepCopy();
+  auto profile = std::make_shared<BranchProfile>(*ast);
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  ASSERT_OK_AND_ASSIGN(auto profiling_plan,
+                       builder.CreateBranchProfilingExpressionImpl(
+                           std::move(ast), /*issues=*/nullptr, profile));
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_OK(Evaluate(profiling_plan, false, true));
+  }
+
+  std::vector<int64_t> evaluated;
+  builder.AddProgramOptimizer(CreateInstrumentationExtension(
+      [&evaluated](const AstImpl&) -> Instrumentation {
+        return [&evaluated](int64_t expr_id, const Value&) {
+          evaluated.push_back(expr_id);
+          return absl::OkStatus();
+        };
+      }));
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateProfileGuidedExpressionImpl(
+                           std::move(copy), /*issues=*/nullptr, profile,
+                           /*min_evaluations=*/5));
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate(plan, false, true));
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+  EXPECT_THAT(evaluated, Contains(b_id));
+  EXPECT_THAT(evaluated, Not(Contains(a_id)));
+
+  evaluated.clear();
+  ASSERT_OK_AND_ASSIGN(result, Evaluate(plan, true, false));
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+  EXPECT_THAT(evaluated, Contains(a_id));
+}
+
+TEST_F(BranchProfileTest, KeepsOrderWithoutEnoughEvaluations) {
+  ASSERT_OK_AND_ASSIGN(auto ast, ParseAst("a && b"));
+  const int64_t a_id = ast->root_expr().call_expr().args()[0].id();
+  const int64_t b_id = ast->root_expr().call_expr().args()[1].id();
+  std::unique_ptr<AstImpl> copy = ast->DeepCopy();
+  auto profile = std::make_shared<BranchProfile>(*ast);
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  ASSERT_OK_AND_ASSIGN(auto profiling_plan,
+                       builder.CreateBranchProfilingExpressionImpl(
+                           std::move(ast), /*issues=*/nullptr, profile));
+  ASSERT_OK(Evaluate(profiling_plan, true, false));
+
+  std::vector<int64_t> evaluated;
+  builder.AddProgramOptimizer(CreateInstrumentationExtension(
+      [&evaluated](const AstImpl&) -> Instrumentation {
+        return [&evaluated](int64_t expr_id, const Value&) {
+          evaluated.push_back(expr_id);
+          return absl::OkStatus();
+        };
+      }));
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateProfileGuidedExpressionImpl(
+                           std::move(copy), /*issues=*/nullptr, profile,
+                           /*min_evaluations=*/5));
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate(plan, false, false));
+  EXPECT_FALSE(result.As<BoolValue>().NativeValue());
+  EXPECT_THAT(evaluated, Not(Contains(b_id)));
+  EXPECT_THAT(evaluated, Contains(a_id));
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -29,10 +29,13 @@
 #include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/native_type.h"
 #include "eval/compiler/constant_folding.h"
 #include "eval/compiler/regex_precompilation_optimization.h"
 #include "eval/eval/cel_expression_flat_impl.h"
+#include "eval/eval/trace_step.h"
 #include "eval/public/activation.h"
 #include "eval/public/builtin_func_registrar.h"
 #include "eval/public/cel_expression.h"
@@ -338,6 +341,87 @@ INSTANTIATE_TEST_SUITE_P(
       return info.param.test_name;
     });
 
+TEST(CelExpressionBuilderFlatImplTest, RecursiveTracingPlansTracedCopy) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, Parse("(1 + 2) * 3"));
+  cel::RuntimeOptions options;
+  options.max_recursion_depth = -1;
+  options.enable_recursive_tracing = true;
+  CelExpressionBuilderFlatImpl builder(options);
+  ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<CelExpression> plan,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+  const auto* recursive_plan =
+      dynamic_cast<const CelExpressionRecursiveImpl*>(plan.get());
+  ASSERT_THAT(recursive_plan, NotNull());
+  // Untraced evaluations run steps without trace decorators.
+  EXPECT_NE(recursive_plan->root()->GetNativeTypeId(),
+            cel::NativeTypeId::For<TraceStep>());
+  EXPECT_THAT(recursive_plan->flat_expression().traced_expression(),
+              NotNull());
+
+  Activation activation;
+  google::protobuf::Arena arena;
+  ASSERT_OK_AND_ASSIGN(CelValue result, plan->Evaluate(activation, &arena));
+  EXPECT_THAT(result, test::IsCelInt64(9));
+
+  std::vector<int64_t> traced_ids;
+  auto cb = [&](int64_t id, const CelValue& value, google::protobuf::Arena* arena) {
+    traced_ids.push_back(id);
+    return absl::OkStatus();
+  };
+  ASSERT_OK_AND_ASSIGN(result, plan->Trace(activation, &arena, cb));
+  EXPECT_THAT(result, test::IsCelInt64(9));
+  // Three constants and two calls.
+  EXPECT_EQ(traced_ids.size(), 5);
+}
+
+TEST(CelExpressionBuilderFlatImplTest, AdaptiveRecursivePlanning) {
+  std::string deep = "1";
+  for (int i = 1; i < 64; ++i) {
+    absl::StrAppend(&deep, " + 1");
+  }
+  std::string wide = "[1";
+  for (int i = 1; i < 100; ++i) {
+    absl::StrAppend(&wide, ", 1");
+  }
+  absl::StrAppend(&wide, "].size()");
+
+  struct TestCase {
+    std::string expr;
+    int64_t result;
+    bool recursive;
+  };
+  for (const TestCase& test_case : {TestCase{"(1 + 2) * 3", 9, true},
+                                    TestCase{deep, 64, false},
+                                    TestCase{wide, 100, false}}) {
+    ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, Parse(test_case.expr));
+    for (bool adaptive : {false, true}) {
+      cel::RuntimeOptions options;
+      options.max_recursion_depth = -1;
+      options.enable_adaptive_recursive_planning = adaptive;
+      CelExpressionBuilderFlatImpl builder(options);
+      ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+
+      ASSERT_OK_AND_ASSIGN(
+          std::unique_ptr<CelExpression> plan,
+          builder.CreateExpression(&parsed_expr.expr(),
+                                   &parsed_expr.source_info()));
+      EXPECT_EQ(
+          dynamic_cast<const CelExpressionRecursiveImpl*>(plan.get()) !=
+              nullptr,
+          !adaptive || test_case.recursive)
+          << test_case.expr;
+
+      Activation activation;
+      google::protobuf::Arena arena;
+      ASSERT_OK_AND_ASSIGN(CelValue result, plan->Evaluate(activation, &arena));
+      EXPECT_THAT(result, test::IsCelInt64(test_case.result));
+    }
+  }
+}
+
 TEST(CelExpressionBuilderFlatImplTest, ParsedExprWithWarnings) {
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, Parse("1 + 2"));
   cel::RuntimeOptions options;
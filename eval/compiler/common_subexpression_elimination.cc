@@ -0,0 +1,310 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/common_subexpression_elimination.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "common/ast_rewrite.h"
+#include "common/ast_traverse.h"
+#include "common/ast_visitor_base.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "runtime/runtime_options.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+
+// Matches the iter_var used for cel.bind, which the planner recognizes as a
+// lazily initialized local variable.
+constexpr absl::string_view kUnusedIterVar = "#unused";
+
+// Prefix for the synthetic variables. '@' is not valid in a CEL identifier so
+// these can't collide with user variables.
+constexpr absl::string_view kIndexVarPrefix = "@index";
+
+// Collects the names of all comprehension variables and the max expr id.
+class ScopeCollector : public cel::AstVisitorBase {
+ public:
+  void PreVisitExpr(const Expr& expr) override {
+    max_id_ = std::max(max_id_, expr.id());
+  }
+
+  void PostVisitExpr(const Expr&) override {}
+
+  void PreVisitSelect(const Expr&, const cel::ast_internal::Select&) override {}
+
+  void PreVisitComprehension(
+      const Expr&, const cel::ast_internal::Comprehension& comp) override {
+    names_.insert(comp.iter_var());
+    names_.insert(comp.accu_var());
+  }
+
+  const absl::flat_hash_set<std::string>& names() const { return names_; }
+  int64_t max_id() const { return max_id_; }
+
+ private:
+  absl::flat_hash_set<std::string> names_;
+  int64_t max_id_ = 0;
+};
+
+absl::optional<std::string> ConstantKey(const Expr& expr) {
+  if (!expr.has_const_expr()) {
+    return absl::nullopt;
+  }
+  const auto& constant = expr.const_expr();
+  if (constant.has_string_value()) {
+    return absl::StrCat("\"", absl::CHexEscape(constant.string_value()), "\"");
+  }
+  if (constant.has_int64_value()) {
+    return absl::StrCat(constant.int64_value());
+  }
+  if (constant.has_uint64_value()) {
+    return absl::StrCat(constant.uint64_value(), "u");
+  }
+  if (constant.has_bool_value()) {
+    return constant.bool_value() ? "true" : "false";
+  }
+  return absl::nullopt;
+}
+
+// Computes a structural key for attribute-like subexpressions and counts
+// occurrences of each.
+//
+// Keys are only assigned to expressions built from variable references, field
+// selections, presence tests and index operations with a constant key. These
+// are pure and (when not tracking attributes) only depend on the activation.
+class CandidateCollector : public cel::AstVisitorBase {
+ public:
+  CandidateCollector(const absl::flat_hash_set<std::string>& local_names,
+                     const Resolver& resolver)
+      : local_names_(local_names), resolver_(resolver) {}
+
+  void PreVisitExpr(const Expr&) override {}
+
+  void PostVisitExpr(const Expr&) override {}
+
+  void PreVisitSelect(const Expr&, const cel::ast_internal::Select&) override {}
+
+  void PostVisitIdent(const Expr& expr,
+                      const cel::ast_internal::Ident& ident) override {
+    if (local_names_.contains(ident.name()) ||
+        resolver_.FindConstant(ident.name(), expr.id()).has_value()) {
+      return;
+    }
+    keys_[&expr] = ident.name();
+    qualified_names_[&expr] = ident.name();
+  }
+
+  void PostVisitSelect(const Expr& expr,
+                       const cel::ast_internal::Select& select) override {
+    auto operand_key = keys_.find(&select.operand());
+    if (operand_key == keys_.end()) {
+      return;
+    }
+    if (auto name = qualified_names_.find(&select.operand());
+        name != qualified_names_.end() && !select.test_only()) {
+      // The select may be part of a qualified name for an enum or type
+      // rather than a field access (e.g. `google.protobuf.NullValue`).
+      std::string qualified_name = absl::StrCat(name->second, ".",
+                                                select.field());
+      if (resolver_.FindConstant(qualified_name, expr.id()).has_value()) {
+        Poison(select.operand());
+        return;
+      }
+      qualified_names_[&expr] = std::move(qualified_name);
+    }
+    std::string key =
+        select.test_only()
+            ? absl::StrCat("has(", operand_key->second, "/", select.field(),
+                           ")")
+            : absl::StrCat(operand_key->second, "/", select.field());
+    ++counts_[key];
+    keys_[&expr] = std::move(key);
+  }
+
+  void PostVisitCall(const Expr& expr,
+                     const cel::ast_internal::Call& call) override {
+    if (call.function() != cel::builtin::kIndex || call.has_target() ||
+        call.args().size() != 2) {
+      return;
+    }
+    auto operand_key = keys_.find(&call.args()[0]);
+    if (operand_key == keys_.end()) {
+      return;
+    }
+    absl::optional<std::string> constant_key = ConstantKey(call.args()[1]);
+    if (!constant_key.has_value()) {
+      return;
+    }
+    std::string key =
+        absl::StrCat(operand_key->second, "[", *constant_key, "]");
+    ++counts_[key];
+    keys_[&expr] = std::move(key);
+  }
+
+  // Returns the key for expr if it is shared with another subexpression.
+  absl::optional<absl::string_view> SharedKey(const Expr& expr) const {
+    auto key = keys_.find(&expr);
+    if (key == keys_.end()) {
+      return absl::nullopt;
+    }
+    auto count = counts_.find(key->second);
+    if (count == counts_.end() || count->second < 2 ||
+        poisoned_.contains(key->second)) {
+      return absl::nullopt;
+    }
+    return key->second;
+  }
+
+ private:
+  // Mark the keys for a select chain and all of its prefixes as ineligible.
+  void Poison(const Expr& expr) {
+    const Expr* current = &expr;
+    while (current != nullptr) {
+      auto key = keys_.find(current);
+      if (key != keys_.end()) {
+        poisoned_.insert(key->second);
+      }
+      current = current->has_select_expr() ? &current->select_expr().operand()
+                                           : nullptr;
+    }
+  }
+
+  const absl::flat_hash_set<std::string>& local_names_;
+  const Resolver& resolver_;
+  absl::flat_hash_map<const Expr*, std::string> keys_;
+  absl::flat_hash_map<const Expr*, std::string> qualified_names_;
+  absl::flat_hash_map<std::string, int> counts_;
+  absl::flat_hash_set<std::string> poisoned_;
+};
+
+struct Binding {
+  std::string name;
+  Expr init;
+};
+
+// Replaces shared subexpressions with references to synthetic variables,
+// moving the first occurrence of each into the list of bindings.
+class SharedSubexpressionRewriter : public cel::AstRewriterBase {
+ public:
+  SharedSubexpressionRewriter(const CandidateCollector& candidates,
+                              int64_t& next_id)
+      : candidates_(candidates), next_id_(next_id) {}
+
+  bool PreVisitRewrite(Expr& expr) override {
+    absl::optional<absl::string_view> key = candidates_.SharedKey(expr);
+    if (!key.has_value()) {
+      return false;
+    }
+    auto [it, inserted] = binding_index_.try_emplace(*key, bindings_.size());
+    if (inserted) {
+      bindings_.push_back(
+          {absl::StrCat(kIndexVarPrefix, bindings_.size()), std::move(expr)});
+    }
+    expr = Expr();
+    expr.set_id(next_id_++);
+    expr.mutable_ident_expr().set_name(bindings_[it->second].name);
+    return true;
+  }
+
+  std::vector<Binding>& bindings() { return bindings_; }
+
+ private:
+  const CandidateCollector& candidates_;
+  int64_t& next_id_;
+  absl::flat_hash_map<std::string, size_t> binding_index_;
+  std::vector<Binding> bindings_;
+};
+
+// Wraps body in the comprehension that cel.bind(name, init, body) expands to.
+Expr MakeBind(Binding binding, Expr body, int64_t& next_id) {
+  Expr out;
+  out.set_id(next_id++);
+  auto& comprehension = out.mutable_comprehension_expr();
+  comprehension.set_iter_var(kUnusedIterVar);
+  comprehension.mutable_iter_range().set_id(next_id++);
+  comprehension.mutable_iter_range().mutable_list_expr();
+  comprehension.set_accu_var(binding.name);
+  comprehension.set_accu_init(std::move(binding.init));
+  comprehension.mutable_loop_condition().set_id(next_id++);
+  comprehension.mutable_loop_condition().mutable_const_expr().set_bool_value(
+      false);
+  comprehension.mutable_loop_step().set_id(next_id++);
+  comprehension.mutable_loop_step().mutable_ident_expr().set_name(
+      binding.name);
+  comprehension.set_result(std::move(body));
+  return out;
+}
+
+class CommonSubexpressionElimination : public AstTransform {
+ public:
+  absl::Status UpdateAst(PlannerContext& context,
+                         AstImpl& ast) const override {
+    const cel::RuntimeOptions& options = context.options();
+    if (!options.enable_comprehension ||
+        options.unknown_processing !=
+            cel::UnknownProcessingOptions::kDisabled ||
+        options.enable_missing_attribute_errors) {
+      return absl::OkStatus();
+    }
+
+    ScopeCollector scope;
+    cel::AstTraverse(ast.root_expr(), scope);
+
+    CandidateCollector candidates(scope.names(), context.resolver());
+    cel::AstTraverse(ast.root_expr(), candidates);
+
+    int64_t next_id = scope.max_id() + 1;
+    SharedSubexpressionRewriter rewriter(candidates, next_id);
+    if (!cel::AstRewrite(ast.root_expr(), rewriter)) {
+      return absl::OkStatus();
+    }
+
+    Expr body = std::move(ast.root_expr());
+    std::vector<Binding>& bindings = rewriter.bindings();
+    for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+      body = MakeBind(std::move(*it), std::move(body), next_id);
+    }
+    ast.root_expr() = std::move(body);
+    return absl::OkStatus();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<AstTransform> NewCommonSubexpressionEliminationExtension() {
+  return std::make_unique<CommonSubexpressionElimination>();
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,42 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMMON_SUBEXPRESSION_ELIMINATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMMON_SUBEXPRESSION_ELIMINATION_H_
+
+#include <memory>
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Returns an AST transform that deduplicates repeated attribute accesses.
+//
+// Field selections, presence tests and constant-key index operations rooted
+// at a variable (e.g. `request.auth.claims["group"]`) that appear more than
+// once are replaced with a reference to a synthetic variable. The expression
+// is then wrapped in `cel.bind` style comprehensions so the planner evaluates
+// each shared subexpression lazily, at most once per evaluation, and caches
+// the result in a comprehension slot.
+//
+// The transform is skipped if unknown processing or missing attribute errors
+// are enabled since those depend on the attribute path of each access, or if
+// comprehensions are disabled.
+//
+// Should be added after the reference resolver.
+std::unique_ptr<AstTransform> NewCommonSubexpressionEliminationExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMMON_SUBEXPRESSION_ELIMINATION_H_
@@ -0,0 +1,197 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/common_subexpression_elimination.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/instrumentation.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/internal/issue_collector.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_issue.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::IntValue;
+using ::cel::RuntimeIssue;
+using ::cel::ast_internal::AstImpl;
+using ::cel::runtime_internal::IssueCollector;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::Eq;
+
+class CommonSubexpressionEliminationTest : public testing::Test {
+ public:
+  CommonSubexpressionEliminationTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)),
+        resolver_("", function_registry_, type_registry_,
+                  managed_value_factory_.get(),
+                  type_registry_.resolveable_enums()),
+        issue_collector_(RuntimeIssue::Severity::kError) {}
+
+  void SetUp() override {
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  absl::Status ApplyTransform(AstImpl& ast) {
+    PlannerContext context(resolver_, options_, managed_value_factory_.get(),
+                           issue_collector_, program_builder_);
+    return NewCommonSubexpressionEliminationExtension()->UpdateAst(context,
+                                                                   ast);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+  Resolver resolver_;
+  IssueCollector issue_collector_;
+  ProgramBuilder program_builder_;
+};
+
+TEST_F(CommonSubexpressionEliminationTest, BindsRepeatedSelect) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                       Parse("a.b.c == 1 || (has(a.b.c) && a.b.c == 2)"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  const auto& root = ast_impl.root_expr();
+  ASSERT_TRUE(root.has_comprehension_expr());
+  const auto& bind = root.comprehension_expr();
+  EXPECT_THAT(bind.iter_var(), Eq("#unused"));
+  EXPECT_THAT(bind.accu_var(), Eq("@index0"));
+  ASSERT_TRUE(bind.accu_init().has_select_expr());
+  EXPECT_THAT(bind.accu_init().select_expr().field(), Eq("c"));
+  // The original expression is the result of the bind.
+  ASSERT_TRUE(bind.result().has_call_expr());
+  const auto& lhs = bind.result().call_expr().args()[0];
+  ASSERT_TRUE(lhs.call_expr().args()[0].has_ident_expr());
+  EXPECT_THAT(lhs.call_expr().args()[0].ident_expr().name(), Eq("@index0"));
+}
+
+TEST_F(CommonSubexpressionEliminationTest, SkipsUniqueSubexpressions) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("a.b == 1 || a.c == 2"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  EXPECT_TRUE(ast_impl.root_expr().has_call_expr());
+}
+
+TEST_F(CommonSubexpressionEliminationTest, SkipsComprehensionVariables) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                       Parse("[{'b': 1}].exists(a, a.b == 1) && a.b == 1"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  EXPECT_TRUE(ast_impl.root_expr().has_call_expr());
+}
+
+TEST_F(CommonSubexpressionEliminationTest, SkipsWhenTrackingAttributes) {
+  options_.unknown_processing = cel::UnknownProcessingOptions::kAttributeOnly;
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("a.b == 1 || a.b == 2"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  EXPECT_TRUE(ast_impl.root_expr().has_call_expr());
+}
+
+TEST_F(CommonSubexpressionEliminationTest, EvaluatesSharedSubexpressionOnce) {
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  builder.AddAstTransform(NewCommonSubexpressionEliminationExtension());
+
+  std::vector<int64_t> expr_ids;
+  Instrumentation expr_id_recorder =
+      [&expr_ids](int64_t expr_id, const cel::Value&) -> absl::Status {
+    expr_ids.push_back(expr_id);
+    return absl::OkStatus();
+  };
+  builder.AddProgramOptimizer(CreateInstrumentationExtension(
+      [=](const cel::ast_internal::AstImpl&) -> Instrumentation {
+        return expr_id_recorder;
+      }));
+
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("a['b'] == 1 || a['b'] == 3"));
+  const auto& call = expr.expr().call_expr();
+  int64_t lhs_index_id = call.args(0).call_expr().args(0).id();
+  int64_t rhs_index_id = call.args(1).call_expr().args(0).id();
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateExpressionImpl(std::move(ast),
+                                                    /*issues=*/nullptr));
+
+  cel::ValueManager& value_manager = managed_value_factory_.get();
+  ASSERT_OK_AND_ASSIGN(auto map_builder, value_manager.NewMapValueBuilder(
+                                             value_manager.GetDynDynMapType()));
+  ASSERT_OK(map_builder->Put(value_manager.CreateUncheckedStringValue("b"),
+                             IntValue(3)));
+  cel::Activation activation;
+  activation.InsertOrAssignValue("a", std::move(*map_builder).Build());
+
+  auto state = plan.MakeEvaluatorState(value_manager);
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      plan.EvaluateWithCallback(activation, EvaluationListener(), state));
+
+  ASSERT_TRUE(value->Is<BoolValue>());
+  EXPECT_TRUE(value->As<BoolValue>().NativeValue());
+  // Without the transform, each index operation would be evaluated.
+  EXPECT_EQ(absl::c_count(expr_ids, lhs_index_id) +
+                absl::c_count(expr_ids, rhs_index_id),
+            1);
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,236 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/comparison_jump_fusion.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "base/kind.h"
+#include "common/native_type.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/compiler_constant_step.h"
+#include "eval/eval/comparison_jump_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/jump_step.h"
+#include "internal/status_macros.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+
+absl::optional<ComparisonOp> GetComparisonOp(const Expr& expr) {
+  if (!expr.has_call_expr() || expr.call_expr().has_target() ||
+      expr.call_expr().args().size() != 2) {
+    return absl::nullopt;
+  }
+  absl::string_view function = expr.call_expr().function();
+  if (function == cel::builtin::kEqual) {
+    return ComparisonOp::kEqual;
+  }
+  if (function == cel::builtin::kInequal) {
+    return ComparisonOp::kNotEqual;
+  }
+  if (function == cel::builtin::kLess) {
+    return ComparisonOp::kLess;
+  }
+  if (function == cel::builtin::kLessOrEqual) {
+    return ComparisonOp::kLessOrEqual;
+  }
+  if (function == cel::builtin::kGreater) {
+    return ComparisonOp::kGreater;
+  }
+  if (function == cel::builtin::kGreaterOrEqual) {
+    return ComparisonOp::kGreaterOrEqual;
+  }
+  return absl::nullopt;
+}
+
+// Returns the operand kinds for which exactly one strict, eagerly bound
+// overload of the comparison would be selected at runtime, so it is safe to
+// evaluate inline.
+ComparisonKinds FindInlineKinds(const Resolver& resolver, const Expr& expr,
+                                ComparisonOp op) {
+  ComparisonKinds kinds;
+  absl::string_view function = expr.call_expr().function();
+  if (!resolver
+           .FindLazyOverloads(function, /*receiver_style=*/false,
+                              ArgumentsMatcher(2), expr.id())
+           .empty()) {
+    return kinds;
+  }
+  auto overloads = resolver.FindOverloads(function, /*receiver_style=*/false,
+                                          ArgumentsMatcher(2), expr.id());
+  bool is_equality =
+      op == ComparisonOp::kEqual || op == ComparisonOp::kNotEqual;
+
+  for (cel::Kind kind : {cel::Kind::kBool, cel::Kind::kInt, cel::Kind::kUint,
+                         cel::Kind::kDouble, cel::Kind::kString}) {
+    int matches = 0;
+    bool inlinable = false;
+    for (const auto& overload : overloads) {
+      const auto& types = overload.descriptor.types();
+      if (types.size() != 2 ||
+          (types[0] != kind && types[0] != cel::Kind::kAny) ||
+          (types[1] != kind && types[1] != cel::Kind::kAny)) {
+        continue;
+      }
+      ++matches;
+      // Heterogeneous equality is a single overload for all kinds.
+      inlinable = overload.descriptor.is_strict() &&
+                  ((types[0] == kind && types[1] == kind) ||
+                   (is_equality && types[0] == cel::Kind::kAny &&
+                    types[1] == cel::Kind::kAny));
+    }
+    if (matches == 1 && inlinable) {
+      kinds.Add(kind);
+    }
+  }
+  return kinds;
+}
+
+class ComparisonJumpFusion : public ProgramOptimizer {
+ public:
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (!node.has_call_expr() || node.call_expr().has_target()) {
+      return absl::OkStatus();
+    }
+    const auto& call_expr = node.call_expr();
+    bool is_ternary = call_expr.function() == cel::builtin::kTernary &&
+                      call_expr.args().size() == 3;
+    bool is_logical = (call_expr.function() == cel::builtin::kAnd ||
+                       call_expr.function() == cel::builtin::kOr) &&
+                      call_expr.args().size() == 2;
+    if (!is_ternary && !is_logical) {
+      return absl::OkStatus();
+    }
+
+    const Expr& condition = call_expr.args()[0];
+    absl::optional<ComparisonOp> op = GetComparisonOp(condition);
+    if (!op.has_value()) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened() ||
+        subexpression->IsRecursive()) {
+      return absl::OkStatus();
+    }
+
+    ComparisonKinds kinds =
+        FindInlineKinds(context.resolver(), condition, *op);
+    if (kinds.empty()) {
+      return absl::OkStatus();
+    }
+
+    // The comparison must still be planned as the operands followed by a
+    // single step for the call, rather than e.g. folded to a constant.
+    size_t condition_size = context.GetSubplan(condition).size();
+    if (condition_size < 3) {
+      return absl::OkStatus();
+    }
+    ExecutionPathView plan = context.GetSubplan(node);
+    size_t jumps_size = is_ternary ? 2 : 1;
+    if (plan.size() < condition_size + jumps_size) {
+      return absl::OkStatus();
+    }
+    const ExpressionStep& comparison = *plan[condition_size - 1];
+    if (comparison.id() != condition.id() ||
+        comparison.GetNativeTypeId() ==
+            cel::NativeTypeId::For<CompilerConstantStep>()) {
+      return absl::OkStatus();
+    }
+
+    // Offsets are adjusted for the removed steps between the fused step and
+    // the targets, which are all after the condition.
+    auto make_fused = [&](auto factory) -> absl::StatusOr<ExecutionPath> {
+      CEL_ASSIGN_OR_RETURN(ExecutionPath path, context.ExtractSubplan(node));
+      ExecutionPath fused_path;
+      fused_path.reserve(path.size() - jumps_size);
+      std::move(path.begin(), path.begin() + (condition_size - 1),
+                std::back_inserter(fused_path));
+      fused_path.push_back(factory(std::move(path[condition_size - 1])));
+      std::move(path.begin() + (condition_size + jumps_size), path.end(),
+                std::back_inserter(fused_path));
+      return fused_path;
+    };
+
+    if (is_ternary) {
+      absl::optional<int> error_offset =
+          GetBoolCheckJumpStepOffset(*plan[condition_size]);
+      absl::optional<CondJumpStepParams> false_jump =
+          GetCondJumpStepParams(*plan[condition_size + 1]);
+      if (!error_offset.has_value() || !false_jump.has_value() ||
+          false_jump->jump_condition || false_jump->leave_on_stack) {
+        return absl::OkStatus();
+      }
+      CEL_ASSIGN_OR_RETURN(
+          ExecutionPath path,
+          make_fused([&](std::unique_ptr<const ExpressionStep> step) {
+            return CreateTernaryComparisonJumpStep(
+                *op, kinds, std::move(step), *error_offset - 1,
+                false_jump->jump_offset, condition.id());
+          }));
+      return context.ReplaceSubplan(node, std::move(path));
+    }
+
+    bool jump_condition = call_expr.function() == cel::builtin::kOr;
+    absl::optional<CondJumpStepParams> jump =
+        GetCondJumpStepParams(*plan[condition_size]);
+    if (!jump.has_value() || jump->jump_condition != jump_condition ||
+        !jump->leave_on_stack) {
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(
+        ExecutionPath path,
+        make_fused([&](std::unique_ptr<const ExpressionStep> step) {
+          return CreateShortCircuitComparisonJumpStep(
+              *op, kinds, std::move(step), jump_condition, jump->jump_offset,
+              condition.id());
+        }));
+    return context.ReplaceSubplan(node, std::move(path));
+  }
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateComparisonJumpFusionExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    if (!context.options().short_circuiting) {
+      return nullptr;
+    }
+    return std::make_unique<ComparisonJumpFusion>();
+  };
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,38 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMPARISON_JUMP_FUSION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMPARISON_JUMP_FUSION_H_
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that fuses a comparison
+// (`==`, `!=`, `<`, `<=`, `>`, `>=`) with the conditional jumps that follow it
+// when it is the condition of a ternary or the first operand of a
+// short-circuiting `&&` or `||`.
+//
+// The fused step compares bool, int, uint, double and string operands of the
+// same kind inline when the registered overloads for that kind are strict
+// and unambiguous, and assumes they are the standard implementations. Other
+// operands are handled by the original comparison step.
+//
+// Only applies to the stack machine (non-recursive) plans with
+// short-circuiting enabled.
+ProgramOptimizerFactory CreateComparisonJumpFusionExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMPARISON_JUMP_FUSION_H_
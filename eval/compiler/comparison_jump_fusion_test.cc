@@ -0,0 +1,226 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/comparison_jump_fusion.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::ErrorValue;
+using ::cel::IntValue;
+using ::cel::StringValue;
+using ::cel::Value;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::ElementsAreArray;
+using testing::Lt;
+
+class ComparisonJumpFusionTest : public testing::TestWithParam<bool> {
+ public:
+  ComparisonJumpFusionTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {
+    options_.enable_heterogeneous_equality = GetParam();
+  }
+
+ protected:
+  absl::StatusOr<FlatExpression> Plan(absl::string_view expression,
+                                      bool fuse) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    if (fuse) {
+      builder.AddProgramOptimizer(CreateComparisonJumpFusionExtension());
+    }
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(expr));
+    return builder.CreateExpressionImpl(std::move(ast), /*issues=*/nullptr);
+  }
+
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 const cel::Activation& activation,
+                                 bool fuse = true,
+                                 EvaluationListener listener = {}) {
+    CEL_ASSIGN_OR_RETURN(auto plan, Plan(expression, fuse));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, std::move(listener), state);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_P(ComparisonJumpFusionTest, FusesComparisonAndJumps) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  for (absl::string_view expression :
+       {"x > 10 ? 1 : 2", "x == 1 && y", "x < 1 || y"}) {
+    ASSERT_OK_AND_ASSIGN(auto unfused, Plan(expression, /*fuse=*/false));
+    ASSERT_OK_AND_ASSIGN(auto fused, Plan(expression, /*fuse=*/true));
+    EXPECT_THAT(fused.path().size(), Lt(unfused.path().size())) << expression;
+  }
+}
+
+TEST_P(ComparisonJumpFusionTest, Ternary) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  struct TestCase {
+    Value x;
+    absl::string_view expected;
+  };
+  const TestCase kCases[] = {
+      {IntValue(11), "big"},
+      {IntValue(10), "small"},
+  };
+  for (const TestCase& test_case : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("x", test_case.x);
+    ASSERT_OK_AND_ASSIGN(
+        Value result, Evaluate("x > 10 ? 'big' : 'small'", activation));
+    ASSERT_TRUE(result.Is<StringValue>()) << result.DebugString();
+    EXPECT_EQ(result.As<StringValue>().ToString(), test_case.expected);
+  }
+
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", StringValue("b"));
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("x >= 'a' ? 1 : 2", activation));
+  ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 1);
+}
+
+TEST_P(ComparisonJumpFusionTest, ShortCircuit) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  struct TestCase {
+    absl::string_view expression;
+    Value x;
+    bool expected;
+  };
+  const TestCase kCases[] = {
+      {"x == 'a' && y", StringValue("a"), true},
+      {"x == 'a' && y", StringValue("b"), false},
+      {"x < 1.5 || !y", DoubleValue(1.0), true},
+      {"x < 1.5 || !y", DoubleValue(2.0), false},
+      {"x != 1 && y", IntValue(1), false},
+  };
+  for (const TestCase& test_case : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("x", test_case.x);
+    activation.InsertOrAssignValue("y", BoolValue(true));
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         Evaluate(test_case.expression, activation));
+    ASSERT_TRUE(result.Is<BoolValue>())
+        << test_case.expression << " " << result.DebugString();
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), test_case.expected)
+        << test_case.expression;
+  }
+}
+
+TEST_P(ComparisonJumpFusionTest, MixedKindsUseComparisonStep) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", DoubleValue(1.0));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("x == 1 ? 'a' : 'b'", activation));
+
+  if (options_.enable_heterogeneous_equality) {
+    ASSERT_TRUE(result.Is<StringValue>()) << result.DebugString();
+    EXPECT_EQ(result.As<StringValue>().ToString(), "a");
+  } else {
+    EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  }
+}
+
+TEST_P(ComparisonJumpFusionTest, ErrorsPropagate) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  cel::Activation activation;
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x > 10 ? 1 : 2", activation));
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x > 10 && false", activation));
+  EXPECT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+}
+
+TEST_P(ComparisonJumpFusionTest, ListenerSeesSameValues) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(3));
+
+  auto trace = [&](bool fuse) -> absl::StatusOr<std::vector<int64_t>> {
+    std::vector<int64_t> ids;
+    CEL_RETURN_IF_ERROR(
+        Evaluate("x > 2 ? x < 5 && x != 4 : false", activation, fuse,
+                 [&ids](int64_t id, const Value&, cel::ValueManager&) {
+                   ids.push_back(id);
+                   return absl::OkStatus();
+                 })
+            .status());
+    return ids;
+  };
+
+  ASSERT_OK_AND_ASSIGN(std::vector<int64_t> expected, trace(false));
+  ASSERT_OK_AND_ASSIGN(std::vector<int64_t> actual, trace(true));
+  EXPECT_THAT(actual, ElementsAreArray(expected));
+}
+
+TEST_P(ComparisonJumpFusionTest, SkippedWithoutShortCircuiting) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  options_.short_circuiting = false;
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(11));
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x > 10 ? 1 : 2", activation));
+
+  ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(ComparisonJumpFusionTest, ComparisonJumpFusionTest,
+                         testing::Bool());
+
+}  // namespace
+}  // namespace google::api::expr::runtime
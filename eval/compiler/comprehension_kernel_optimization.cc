@@ -0,0 +1,306 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/comprehension_kernel_optimization.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "base/kind.h"
+#include "common/expr.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/comprehension_kernel.h"
+#include "eval/eval/comprehension_step.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/internal/convert_constant.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Comprehension;
+using ::cel::ast_internal::Expr;
+
+using Kind = ComprehensionKernel::Kind;
+using Op = ComprehensionKernel::Op;
+
+struct KernelOp {
+  absl::string_view function;
+  Op op;
+  // The op to apply if the literal is the left operand, if any.
+  absl::optional<Op> flipped;
+};
+
+constexpr KernelOp kComparisons[] = {
+    {cel::builtin::kEqual, Op::kEqual, Op::kEqual},
+    {cel::builtin::kInequal, Op::kNotEqual, Op::kNotEqual},
+    {cel::builtin::kLess, Op::kLess, Op::kGreater},
+    {cel::builtin::kLessOrEqual, Op::kLessOrEqual, Op::kGreaterOrEqual},
+    {cel::builtin::kGreater, Op::kGreater, Op::kLess},
+    {cel::builtin::kGreaterOrEqual, Op::kGreaterOrEqual, Op::kLessOrEqual},
+};
+
+constexpr KernelOp kArithmetic[] = {
+    {cel::builtin::kAdd, Op::kAdd, Op::kAdd},
+    {cel::builtin::kSubtract, Op::kSubtract, absl::nullopt},
+    {cel::builtin::kMultiply, Op::kMultiply, Op::kMultiply},
+};
+
+bool IsIdent(const Expr& expr, absl::string_view name) {
+  return expr.has_ident_expr() && expr.ident_expr().name() == name;
+}
+
+// Returns the arguments of a global call to `function` with `arity`
+// arguments, or nullptr.
+const std::vector<Expr>* CallArgs(const Expr& expr, absl::string_view function,
+                                  size_t arity) {
+  if (!expr.has_call_expr() || expr.call_expr().has_target() ||
+      expr.call_expr().function() != function ||
+      expr.call_expr().args().size() != arity) {
+    return nullptr;
+  }
+  return &expr.call_expr().args();
+}
+
+bool IsBoolLiteral(const Expr& expr, bool value) {
+  return expr.has_const_expr() && expr.const_expr().has_bool_value() &&
+         expr.const_expr().bool_value() == value;
+}
+
+bool IsEmptyList(const Expr& expr) {
+  return expr.has_list_expr() && expr.list_expr().elements().empty();
+}
+
+// Returns the element of a single element list, or nullptr.
+const Expr* SingleElement(const Expr& expr) {
+  if (!expr.has_list_expr() || expr.list_expr().elements().size() != 1 ||
+      expr.list_expr().elements()[0].optional()) {
+    return nullptr;
+  }
+  return &expr.list_expr().elements()[0].expr();
+}
+
+// Matches the standard overload resolution of the planner: lazy overloads
+// shadow the eager ones, and may differ per activation.
+bool HasSingleStrictOverload(const Resolver& resolver,
+                             absl::string_view function, cel::Kind kind,
+                             int64_t expr_id) {
+  std::vector<cel::Kind> types = {kind, kind};
+  if (!resolver
+           .FindLazyOverloads(function, /*receiver_style=*/false, types,
+                              expr_id)
+           .empty()) {
+    return false;
+  }
+  std::vector<cel::FunctionOverloadReference> overloads =
+      resolver.FindOverloads(function, /*receiver_style=*/false, types,
+                             expr_id);
+  return overloads.size() == 1 && overloads[0].descriptor.is_strict();
+}
+
+// Matches `iter_var op literal` or `literal op iter_var` for one of `ops`,
+// setting the op and constant of `kernel`.
+bool MatchOperation(const Expr& expr, absl::string_view iter_var,
+                    absl::Span<const KernelOp> ops, const Resolver& resolver,
+                    cel::ValueManager& value_factory,
+                    ComprehensionKernel& kernel) {
+  for (const KernelOp& op : ops) {
+    const std::vector<Expr>* args = CallArgs(expr, op.function, 2);
+    if (args == nullptr) {
+      continue;
+    }
+    const Expr* literal = nullptr;
+    if (IsIdent((*args)[0], iter_var) && (*args)[1].has_const_expr()) {
+      kernel.op = op.op;
+      literal = &(*args)[1];
+    } else if (op.flipped.has_value() && (*args)[0].has_const_expr() &&
+               IsIdent((*args)[1], iter_var)) {
+      kernel.op = *op.flipped;
+      literal = &(*args)[0];
+    } else {
+      return false;
+    }
+
+    absl::StatusOr<cel::Value> constant =
+        cel::runtime_internal::ConvertConstant(literal->const_expr(),
+                                               value_factory);
+    if (!constant.ok()) {
+      return false;
+    }
+    switch (constant->kind()) {
+      case cel::ValueKind::kBool:
+      case cel::ValueKind::kString:
+        if (kernel.kind == Kind::kMap) {
+          return false;
+        }
+        break;
+      case cel::ValueKind::kInt:
+      case cel::ValueKind::kUint:
+      case cel::ValueKind::kDouble:
+        break;
+      default:
+        return false;
+    }
+    if (!HasSingleStrictOverload(resolver, op.function,
+                                 cel::ValueKindToKind(constant->kind()),
+                                 expr.id())) {
+      return false;
+    }
+    kernel.constant = *std::move(constant);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::optional<ComprehensionKernel> MatchComprehensionKernel(
+    const Comprehension& comprehension, const Resolver& resolver,
+    cel::ValueManager& value_factory) {
+  const std::string& accu_var = comprehension.accu_var();
+  const std::string& iter_var = comprehension.iter_var();
+  if (accu_var != cel::kAccumulatorVariableName || iter_var == accu_var ||
+      !IsIdent(comprehension.result(), accu_var)) {
+    return absl::nullopt;
+  }
+  const Expr& init = comprehension.accu_init();
+  const Expr& condition = comprehension.loop_condition();
+  const Expr& step = comprehension.loop_step();
+
+  ComprehensionKernel kernel;
+  const Expr* operation = nullptr;
+  absl::Span<const KernelOp> ops = kComparisons;
+  if (IsBoolLiteral(init, false)) {
+    // exists: loops while @not_strictly_false(!__result__).
+    kernel.kind = Kind::kExists;
+    const std::vector<Expr>* condition_args =
+        CallArgs(condition, cel::builtin::kNotStrictlyFalse, 1);
+    const std::vector<Expr>* not_args =
+        condition_args == nullptr
+            ? nullptr
+            : CallArgs((*condition_args)[0], cel::builtin::kNot, 1);
+    const std::vector<Expr>* step_args =
+        CallArgs(step, cel::builtin::kOr, 2);
+    if (not_args == nullptr || !IsIdent((*not_args)[0], accu_var) ||
+        step_args == nullptr || !IsIdent((*step_args)[0], accu_var)) {
+      return absl::nullopt;
+    }
+    operation = &(*step_args)[1];
+  } else if (IsBoolLiteral(init, true)) {
+    kernel.kind = Kind::kAll;
+    const std::vector<Expr>* condition_args =
+        CallArgs(condition, cel::builtin::kNotStrictlyFalse, 1);
+    const std::vector<Expr>* step_args =
+        CallArgs(step, cel::builtin::kAnd, 2);
+    if (condition_args == nullptr || !IsIdent((*condition_args)[0], accu_var) ||
+        step_args == nullptr || !IsIdent((*step_args)[0], accu_var)) {
+      return absl::nullopt;
+    }
+    operation = &(*step_args)[1];
+  } else if (IsEmptyList(init) && IsBoolLiteral(condition, true)) {
+    if (const std::vector<Expr>* ternary_args =
+            CallArgs(step, cel::builtin::kTernary, 3);
+        ternary_args != nullptr) {
+      // filter: pred ? __result__ + [x] : __result__
+      kernel.kind = Kind::kFilter;
+      const std::vector<Expr>* append_args =
+          CallArgs((*ternary_args)[1], cel::builtin::kAdd, 2);
+      if (append_args == nullptr || !IsIdent((*append_args)[0], accu_var) ||
+          !IsIdent((*ternary_args)[2], accu_var)) {
+        return absl::nullopt;
+      }
+      const Expr* element = SingleElement((*append_args)[1]);
+      if (element == nullptr || !IsIdent(*element, iter_var)) {
+        return absl::nullopt;
+      }
+      operation = &(*ternary_args)[0];
+    } else {
+      // map: __result__ + [f(x)]
+      kernel.kind = Kind::kMap;
+      const std::vector<Expr>* append_args =
+          CallArgs(step, cel::builtin::kAdd, 2);
+      if (append_args == nullptr || !IsIdent((*append_args)[0], accu_var)) {
+        return absl::nullopt;
+      }
+      operation = SingleElement((*append_args)[1]);
+      ops = kArithmetic;
+    }
+  }
+  if (operation == nullptr ||
+      !MatchOperation(*operation, iter_var, ops, resolver, value_factory,
+                      kernel)) {
+    return absl::nullopt;
+  }
+  return kernel;
+}
+
+namespace {
+
+class ComprehensionKernelOptimization : public ProgramOptimizer {
+ public:
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (!node.has_comprehension_expr()) {
+      return absl::OkStatus();
+    }
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || !subexpression->IsRecursive()) {
+      return absl::OkStatus();
+    }
+    absl::optional<ComprehensionKernel> kernel =
+        MatchComprehensionKernel(node.comprehension_expr(), context.resolver(),
+                                 context.value_factory());
+    if (!kernel.has_value()) {
+      return absl::OkStatus();
+    }
+
+    auto program = subexpression->ExtractRecursiveProgram();
+    // Does nothing if the comprehension was already replaced, e.g. folded.
+    SetComprehensionKernel(*program.step, *std::move(kernel));
+    subexpression->set_recursive_program(std::move(program.step),
+                                         program.depth);
+    return absl::OkStatus();
+  }
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateComprehensionKernelExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<ComprehensionKernelOptimization>();
+  };
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,50 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMPREHENSION_KERNEL_OPTIMIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMPREHENSION_KERNEL_OPTIMIZATION_H_
+
+#include "absl/types/optional.h"
+#include "base/ast_internal/expr.h"
+#include "common/value_manager.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/comprehension_kernel.h"
+
+namespace google::api::expr::runtime {
+
+// Returns the kernel equivalent to `comprehension` if it was expanded from an
+// `exists`, `all`, `filter` or `map` macro comparing or combining the
+// iteration variable with a literal, e.g. `list.filter(x, x < 10)`.
+//
+// The comparison or arithmetic function must have a single strict overload
+// for the kind of the literal (or one for any kinds, like heterogeneous
+// equality), which is assumed to be the standard one.
+absl::optional<ComprehensionKernel> MatchComprehensionKernel(
+    const cel::ast_internal::Comprehension& comprehension,
+    const Resolver& resolver, cel::ValueManager& value_factory);
+
+// Create a new extension for the FlatExprBuilder that evaluates comprehensions
+// matched by MatchComprehensionKernel as a loop over the elements of the
+// range, when they are a list of the kind of the literal.
+//
+// Only applies to recursively planned comprehensions (see
+// `RuntimeOptions::max_recursion_depth`). The generic loop is used whenever
+// the elements are of another kind, the computation results in an error, or
+// evaluation is observed by a listener or tracks unknowns.
+ProgramOptimizerFactory CreateComprehensionKernelExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_COMPREHENSION_KERNEL_OPTIMIZATION_H_
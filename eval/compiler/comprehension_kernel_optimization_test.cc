@@ -0,0 +1,248 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/comprehension_kernel_optimization.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/values/legacy_value_manager.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/comprehension_kernel.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ErrorValue;
+using ::cel::Value;
+using ::cel::ast_internal::AstImpl;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::HasSubstr;
+using cel::internal::StatusIs;
+
+using Kind = ComprehensionKernel::Kind;
+using Op = ComprehensionKernel::Op;
+
+class ComprehensionKernelTest : public testing::Test {
+ public:
+  ComprehensionKernelTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {
+    options_.max_recursion_depth = -1;
+  }
+
+  void SetUp() override {
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 bool optimize = true) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    if (optimize) {
+      builder.AddProgramOptimizer(CreateComprehensionKernelExtension());
+    }
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(expr));
+    CEL_ASSIGN_OR_RETURN(auto plan,
+                         builder.CreateExpressionImpl(std::move(ast),
+                                                      /*issues=*/nullptr));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    cel::Activation activation;
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  absl::StatusOr<absl::optional<ComprehensionKernel>> Match(
+      absl::string_view expression) {
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(expr));
+    const auto& root = AstImpl::CastFromPublicAst(*ast).root_expr();
+    if (!root.has_comprehension_expr()) {
+      return absl::InvalidArgumentError("not a comprehension");
+    }
+    cel::common_internal::LegacyValueManager value_factory(
+        cel::MemoryManagerRef::ReferenceCounting(),
+        type_registry_.GetComposedTypeProvider());
+    Resolver resolver("", function_registry_, type_registry_, value_factory,
+                      type_registry_.resolveable_enums());
+    return MatchComprehensionKernel(root.comprehension_expr(), resolver,
+                                    value_factory);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_F(ComprehensionKernelTest, MatchesMacros) {
+  ASSERT_OK_AND_ASSIGN(auto kernel, Match("[1, 2].exists(x, x == 2)"));
+  ASSERT_TRUE(kernel.has_value());
+  EXPECT_EQ(kernel->kind, Kind::kExists);
+  EXPECT_EQ(kernel->op, Op::kEqual);
+
+  ASSERT_OK_AND_ASSIGN(kernel, Match("[1, 2].all(x, 0u < x)"));
+  ASSERT_TRUE(kernel.has_value());
+  EXPECT_EQ(kernel->kind, Kind::kAll);
+  EXPECT_EQ(kernel->op, Op::kGreater);
+
+  ASSERT_OK_AND_ASSIGN(kernel, Match("['a'].filter(x, x != 'b')"));
+  ASSERT_TRUE(kernel.has_value());
+  EXPECT_EQ(kernel->kind, Kind::kFilter);
+  EXPECT_EQ(kernel->op, Op::kNotEqual);
+
+  ASSERT_OK_AND_ASSIGN(kernel, Match("[1.0].map(x, x * 2.0)"));
+  ASSERT_TRUE(kernel.has_value());
+  EXPECT_EQ(kernel->kind, Kind::kMap);
+  EXPECT_EQ(kernel->op, Op::kMultiply);
+}
+
+TEST_F(ComprehensionKernelTest, DoesNotMatchOtherLoops) {
+  for (absl::string_view expression :
+       {"[1, 2].exists_one(x, x == 2)", "[1, 2].exists(x, x == x)",
+        "[1, 2].all(x, x > 1 && x < 3)", "[1, 2].map(x, 1 - x)",
+        "['a'].map(x, x + 'b')", "[1, 2].map(x, x > 1, x * 2)",
+        "[1, 2].filter(x, x in [1])"}) {
+    ASSERT_OK_AND_ASSIGN(auto kernel, Match(expression));
+    EXPECT_FALSE(kernel.has_value()) << expression;
+  }
+}
+
+TEST_F(ComprehensionKernelTest, SameResultsAsLoop) {
+  for (absl::string_view expression : {
+           "[1, 2, 3].exists(x, x == 2)",
+           "[1, 2, 3].exists(x, x > 3)",
+           "[].exists(x, x > 3)",
+           "[1u, 2u, 3u].all(x, x >= 1u)",
+           "[1.5, 2.5].all(x, 2.0 > x)",
+           "[true, false].exists(x, x == false)",
+           "['a', 'b', 'c'].filter(x, x >= 'b')",
+           "[1, 2, 3, 4].filter(x, x != 3)",
+           "[1, 2, 3].map(x, x * 2)",
+           "[1u, 2u].map(x, x + 1u)",
+           "[1.0, 2.0].map(x, x - 0.5)",
+           "[1, 2.0, 3u].exists(x, x == 3)",
+           "[1, 'a'].all(x, x < 2)",
+           "[1, 2].map(x, x - 3)",
+           "[9223372036854775807].map(x, x + 1)",
+           "{1: 'a', 2: 'b'}.exists(x, x == 2)",
+       }) {
+    ASSERT_OK_AND_ASSIGN(Value expected,
+                         Evaluate(expression, /*optimize=*/false));
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(expression));
+    EXPECT_EQ(result.DebugString(), expected.DebugString()) << expression;
+  }
+}
+
+TEST_F(ComprehensionKernelTest, FallsBackOnOverflow) {
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("[1, 9223372036854775807].map(x, x + 1)"));
+
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kOutOfRange, HasSubstr("overflow")));
+}
+
+TEST_F(ComprehensionKernelTest, CountsIterations) {
+  options_.comprehension_max_iterations = 4;
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("[1, 2, 3, 4, 5].exists(x, x == 2)"));
+  EXPECT_EQ(result.DebugString(), "true");
+
+  for (bool optimize : {false, true}) {
+    EXPECT_THAT(Evaluate("[1, 2, 3, 4, 5].exists(x, x == 3)", optimize),
+                StatusIs(absl::StatusCode::kInternal,
+                         HasSubstr("Iteration budget exceeded")));
+    EXPECT_THAT(Evaluate("[1, 2, 3, 4, 5].map(x, x + 1)", optimize),
+                StatusIs(absl::StatusCode::kInternal,
+                         HasSubstr("Iteration budget exceeded")));
+  }
+}
+
+TEST_F(ComprehensionKernelTest, SplitsAcrossTaskRunner) {
+  const absl::string_view kExpressions[] = {
+      "[1, 2, 3, 4, 5, 6, 7].exists(x, x == 6)",
+      "[1, 2, 3, 4, 5, 6, 7].all(x, x < 7)",
+      "[1, 2, 3, 4, 5, 6, 7].filter(x, x > 2 && x < 6)",
+      "[1, 2, 3, 4, 5, 6, 7].filter(x, x != 4)",
+      "[1, 2, 3, 4, 5, 6, 7].map(x, x * 3)",
+      "[1, 2, 3, 4, 5, 6, 7].exists(x, x == 2) || [1].all(x, x > 0)",
+      "[1, 2, 3, 4, 5, 6, 'a'].map(x, x + 1)",
+      "[1, 2, 3, 4, 5, 'a', 7].exists(x, x == 3)",
+  };
+  absl::flat_hash_map<absl::string_view, std::string> expected;
+  for (absl::string_view expression : kExpressions) {
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(expression));
+    expected[expression] = result.DebugString();
+  }
+
+  std::atomic<int> tasks_run = 0;
+  options_.parallel_comprehension_chunk_size = 2;
+  options_.comprehension_task_runner =
+      [&](absl::Span<const std::function<void()>> tasks) {
+        std::vector<std::thread> threads;
+        for (const auto& task : tasks) {
+          threads.emplace_back([&task, &tasks_run]() {
+            task();
+            ++tasks_run;
+          });
+        }
+        for (auto& thread : threads) {
+          thread.join();
+        }
+      };
+
+  for (absl::string_view expression : kExpressions) {
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(expression));
+    EXPECT_EQ(result.DebugString(), expected[expression]) << expression;
+  }
+  EXPECT_GT(tasks_run, 0);
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
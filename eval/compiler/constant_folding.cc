@@ -32,11 +32,15 @@
 #include "common/value_manager.h"
 #include "eval/compiler/flat_expr_builder_extensions.h"
 #include "eval/compiler/resolver.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/compiler_constant_step.h"
 #include "eval/eval/const_value_step.h"
+#include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "internal/status_macros.h"
 #include "runtime/activation.h"
 #include "runtime/internal/convert_constant.h"
+#include "runtime/internal/frozen_map_value.h"
 
 namespace cel::runtime_internal {
 
@@ -55,17 +59,24 @@ using ::cel::builtin::kAnd;
 using ::cel::builtin::kOr;
 using ::cel::builtin::kTernary;
 using ::cel::runtime_internal::ConvertConstant;
+using ::cel::runtime_internal::FreezeMapValue;
+using ::google::api::expr::runtime::AttributeTrail;
 using ::google::api::expr::runtime::CreateConstValueDirectStep;
 using ::google::api::expr::runtime::CreateConstValueStep;
+using ::google::api::expr::runtime::DirectCompilerConstantStep;
+using ::google::api::expr::runtime::DirectExpressionStep;
 using ::google::api::expr::runtime::EvaluationListener;
 using ::google::api::expr::runtime::ExecutionFrame;
+using ::google::api::expr::runtime::ExecutionFrameBase;
 using ::google::api::expr::runtime::ExecutionPath;
 using ::google::api::expr::runtime::ExecutionPathView;
 using ::google::api::expr::runtime::FlatExpressionEvaluatorState;
 using ::google::api::expr::runtime::PlannerContext;
+using ::google::api::expr::runtime::ProgramBuilder;
 using ::google::api::expr::runtime::ProgramOptimizer;
 using ::google::api::expr::runtime::ProgramOptimizerFactory;
 using ::google::api::expr::runtime::Resolver;
+using ::google::api::expr::runtime::TryDowncastDirectStep;
 
 class ConstantFoldingExtension : public ProgramOptimizer {
  public:
@@ -85,6 +96,13 @@ class ConstantFoldingExtension : public ProgramOptimizer {
     kConditional,
     kNonConst,
   };
+
+  // Replaces a ternary with a constant condition by the selected branch.
+  //
+  // Only applies to recursive plans: the stack machine plans ternaries with
+  // jumps that would need to be rewritten.
+  absl::Status MaybePruneTernary(PlannerContext& context, const Expr& node);
+
   // Most constant folding evaluations are simple
   // binary operators.
   static constexpr size_t kDefaultStackLimit = 4;
@@ -111,7 +129,10 @@ absl::Status ConstantFoldingExtension::OnPreVisit(PlannerContext& context,
       return IsConst::kNonConst;
     }
     IsConst operator()(const CreateStruct& create_struct) {
-      return IsConst::kNonConst;
+      // Messages are immutable once built, so a message whose fields are all
+      // constant is built once in the constant memory and shared by every
+      // evaluation.
+      return IsConst::kConditional;
     }
     IsConst operator()(const cel::MapExpr& map_expr) {
       // Not yet supported but should be possible in the future.
@@ -139,10 +160,12 @@ absl::Status ConstantFoldingExtension::OnPreVisit(PlannerContext& context,
     }
 
     IsConst operator()(const Call& call) {
-      // Short Circuiting operators not yet supported.
+      // Short Circuiting operators are only supported for recursive plans.
+      // The stack machine plans them with jumps that can't be evaluated in
+      // isolation.
       if (call.function() == kAnd || call.function() == kOr ||
           call.function() == kTernary) {
-        return IsConst::kNonConst;
+        return recursive ? IsConst::kConditional : IsConst::kNonConst;
       }
 
       int arg_len = call.args().size() + (call.has_target() ? 1 : 0);
@@ -159,10 +182,13 @@ absl::Status ConstantFoldingExtension::OnPreVisit(PlannerContext& context,
     }
 
     const Resolver& resolver;
+    bool recursive;
   };
 
-  IsConst is_const =
-      absl::visit(IsConstVisitor{context.resolver()}, node.kind());
+  IsConst is_const = absl::visit(
+      IsConstVisitor{context.resolver(),
+                     context.options().max_recursion_depth != 0},
+      node.kind());
   is_const_.push_back(is_const);
 
   return absl::OkStatus();
@@ -182,19 +208,41 @@ absl::Status ConstantFoldingExtension::OnPostVisit(PlannerContext& context,
     if (!is_const_.empty()) {
       is_const_.back() = IsConst::kNonConst;
     }
-    return absl::OkStatus();
-  }
-  ExecutionPathView subplan = context.GetSubplan(node);
-  if (subplan.empty()) {
-    // This subexpression is already optimized out or suppressed.
-    return absl::OkStatus();
+    return MaybePruneTernary(context, node);
   }
+
+  ProgramBuilder::Subexpression* subexpression =
+      context.program_builder().GetSubexpression(&node);
   // copy string to managed handle if backed by the original program.
   Value value;
   if (node.has_const_expr()) {
     CEL_ASSIGN_OR_RETURN(
-        value, ConvertConstant(node.const_expr(), state_.value_factory()));
+        value, ConvertConstant(node.const_expr(), state_.value_factory(),
+                               context.string_pool()));
+  } else if (subexpression != nullptr && subexpression->IsRecursive()) {
+    // Evaluate the direct step in place. Unlike GetSubplan, this doesn't
+    // flatten the subexpression, so the recursive plan is preserved if the
+    // node can't be folded.
+    const DirectExpressionStep* step =
+        subexpression->recursive_program().step.get();
+    if (step == nullptr) {
+      return absl::OkStatus();
+    }
+    state_.Reset();
+    ExecutionFrameBase frame(empty_, EvaluationListener(), context.options(),
+                             state_.value_factory(),
+                             state_.comprehension_slots());
+    AttributeTrail trail;
+    absl::Status status = step->Evaluate(frame, value, trail);
+    if (!status.ok() || value->Is<UnknownValue>()) {
+      return absl::OkStatus();
+    }
   } else {
+    ExecutionPathView subplan = context.GetSubplan(node);
+    if (subplan.empty()) {
+      // This subexpression is already optimized out or suppressed.
+      return absl::OkStatus();
+    }
     ExecutionFrame frame(subplan, empty_, context.options(), state_);
     state_.Reset();
     // Update stack size to accommodate sub expression.
@@ -215,6 +263,21 @@ absl::Status ConstantFoldingExtension::OnPostVisit(PlannerContext& context,
     }
   }
 
+  // Folded strings are interned like the string literals, which also copies
+  // them out of the memory used for the evaluation.
+  if (auto* string_pool = context.string_pool();
+      string_pool != nullptr && value->Is<StringValue>()) {
+    value = StringValue(
+        string_pool->Intern(value->As<StringValue>().ToString()));
+  }
+
+  // Folded maps are typically lookup tables, so they are frozen into a
+  // perfect hash table which finds a key with a single probe.
+  if (value->Is<MapValue>()) {
+    CEL_ASSIGN_OR_RETURN(value, FreezeMapValue(state_.value_factory(),
+                                               value->As<MapValue>()));
+  }
+
   // If recursive planning enabled (recursion limit unbounded or at least 1),
   // use a recursive (direct) step for the folded constant.
   //
@@ -235,6 +298,38 @@ absl::Status ConstantFoldingExtension::OnPostVisit(PlannerContext& context,
   return context.ReplaceSubplan(node, std::move(new_plan));
 }
 
+absl::Status ConstantFoldingExtension::MaybePruneTernary(
+    PlannerContext& context, const Expr& node) {
+  if (context.options().max_recursion_depth == 0 || !node.has_call_expr() ||
+      node.call_expr().function() != kTernary) {
+    return absl::OkStatus();
+  }
+  ProgramBuilder::Subexpression* subexpression =
+      context.program_builder().GetSubexpression(&node);
+  if (subexpression == nullptr || !subexpression->IsRecursive()) {
+    return absl::OkStatus();
+  }
+  auto deps = subexpression->recursive_program().step->GetDependencies();
+  if (!deps.has_value() || deps->size() != 3) {
+    return absl::OkStatus();
+  }
+  const auto* condition =
+      TryDowncastDirectStep<DirectCompilerConstantStep>((*deps)[0]);
+  if (condition == nullptr || !condition->value()->Is<BoolValue>()) {
+    return absl::OkStatus();
+  }
+  size_t branch = condition->value()->As<BoolValue>().NativeValue() ? 1 : 2;
+
+  auto program = subexpression->ExtractRecursiveProgram();
+  auto extracted = program.step->ExtractDependencies();
+  if (!extracted.has_value() || extracted->size() != 3) {
+    return absl::InternalError(
+        "ConstantFoldingExtension: unexpected ternary dependencies.");
+  }
+  return context.ReplaceSubplan(node, std::move((*extracted)[branch]),
+                                program.depth);
+}
+
 }  // namespace
 
 ProgramOptimizerFactory CreateConstantFoldingOptimizer(
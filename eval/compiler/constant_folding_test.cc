@@ -25,6 +25,7 @@
 #include "base/ast_internal/ast_impl.h"
 #include "base/ast_internal/expr.h"
 #include "common/memory.h"
+#include "common/native_type.h"
 #include "common/type_factory.h"
 #include "common/type_manager.h"
 #include "common/value.h"
@@ -32,6 +33,7 @@
 #include "common/values/legacy_value_manager.h"
 #include "eval/compiler/flat_expr_builder_extensions.h"
 #include "eval/compiler/resolver.h"
+#include "eval/eval/compiler_constant_step.h"
 #include "eval/eval/const_value_step.h"
 #include "eval/eval/create_list_step.h"
 #include "eval/eval/create_map_step.h"
@@ -42,6 +44,7 @@
 #include "internal/testing.h"
 #include "parser/parser.h"
 #include "runtime/function_registry.h"
+#include "runtime/internal/frozen_map_value.h"
 #include "runtime/internal/issue_collector.h"
 #include "runtime/runtime_issue.h"
 #include "runtime/runtime_options.h"
@@ -56,9 +59,11 @@ using ::cel::RuntimeIssue;
 using ::cel::ast_internal::AstImpl;
 using ::cel::ast_internal::Expr;
 using ::cel::extensions::ProtoMemoryManagerRef;
+using ::cel::runtime_internal::IsFrozenMapValue;
 using ::cel::runtime_internal::IssueCollector;
 using ::google::api::expr::v1alpha1::ParsedExpr;
 using ::google::api::expr::parser::Parse;
+using ::google::api::expr::runtime::CompilerConstantStep;
 using ::google::api::expr::runtime::CreateConstValueStep;
 using ::google::api::expr::runtime::CreateCreateListStep;
 using ::google::api::expr::runtime::CreateCreateStructStepForMap;
@@ -398,7 +403,13 @@ TEST_F(UpdatedConstantFoldingTest, CreatesMap) {
   // Assert
   // Single constant value for the map.
   ExecutionPath path = std::move(program_builder).FlattenMain();
-  EXPECT_THAT(path, SizeIs(1));
+  ASSERT_THAT(path, SizeIs(1));
+  ASSERT_EQ(path[0]->GetNativeTypeId(),
+            cel::NativeTypeId::For<CompilerConstantStep>());
+  const cel::Value& folded =
+      static_cast<const CompilerConstantStep&>(*path[0]).value();
+  ASSERT_TRUE(folded->Is<cel::MapValue>());
+  EXPECT_TRUE(IsFrozenMapValue(folded->As<cel::MapValue>()));
 }
 
 TEST_F(UpdatedConstantFoldingTest, CreatesInvalidMap) {
@@ -0,0 +1,193 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/constant_list_membership_optimization.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/list_membership_step.h"
+#include "internal/status_macros.h"
+#include "runtime/internal/primitive_value_set.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Constant;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+using ::cel::runtime_internal::PrimitiveValueSet;
+
+using ReferenceMap = absl::flat_hash_map<int64_t, Reference>;
+
+constexpr char kInListOverload[] = "in_list";
+
+bool IsListMembership(const Expr& expr, const ReferenceMap& reference_map) {
+  if (!expr.has_call_expr()) {
+    return false;
+  }
+  const auto& call_expr = expr.call_expr();
+  if (call_expr.function() != cel::builtin::kIn || call_expr.has_target() ||
+      call_expr.args().size() != 2) {
+    return false;
+  }
+
+  // If parse-only, assume this is the builtin overload. The plan is only
+  // changed if the second arg is a list literal.
+  if (reference_map.empty()) {
+    return true;
+  }
+
+  auto reference = reference_map.find(expr.id());
+  return reference != reference_map.end() &&
+         reference->second.overload_id().size() == 1 &&
+         reference->second.overload_id().front() == kInListOverload;
+}
+
+bool InsertConstant(const Constant& constant, PrimitiveValueSet& set) {
+  if (constant.has_bool_value()) {
+    set.InsertBool(constant.bool_value());
+  } else if (constant.has_int_value()) {
+    set.InsertInt(constant.int_value());
+  } else if (constant.has_uint_value()) {
+    set.InsertUint(constant.uint_value());
+  } else if (constant.has_double_value()) {
+    set.InsertDouble(constant.double_value());
+  } else if (constant.has_string_value()) {
+    set.InsertString(constant.string_value());
+  } else if (constant.has_bytes_value()) {
+    set.InsertBytes(constant.bytes_value());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns the membership set for a list literal of primitive constants or
+// nullptr if the list has any other elements.
+std::shared_ptr<const PrimitiveValueSet> BuildMembershipSet(
+    const Expr& list_expr) {
+  if (!list_expr.has_list_expr()) {
+    return nullptr;
+  }
+  auto set = std::make_shared<PrimitiveValueSet>();
+  for (const auto& element : list_expr.list_expr().elements()) {
+    if (element.optional() || !element.has_expr() ||
+        !element.expr().has_const_expr() ||
+        !InsertConstant(element.expr().const_expr(), *set)) {
+      return nullptr;
+    }
+  }
+  return set;
+}
+
+class ConstantListMembershipOptimization : public ProgramOptimizer {
+ public:
+  explicit ConstantListMembershipOptimization(const ReferenceMap& reference_map)
+      : reference_map_(reference_map) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (!IsListMembership(node, reference_map_)) {
+      return absl::OkStatus();
+    }
+
+    const Expr& element_expr = node.call_expr().args()[0];
+    std::shared_ptr<const PrimitiveValueSet> set =
+        BuildMembershipSet(node.call_expr().args()[1]);
+    if (set == nullptr) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    if (subexpression->IsRecursive()) {
+      return RewriteRecursivePlan(subexpression, node, std::move(set));
+    }
+    return RewriteStackMachinePlan(context, node, element_expr,
+                                   std::move(set));
+  }
+
+ private:
+  absl::Status RewriteRecursivePlan(
+      absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
+      const Expr& call, std::shared_ptr<const PrimitiveValueSet> set) {
+    auto program = subexpression->ExtractRecursiveProgram();
+    auto deps = program.step->ExtractDependencies();
+    if (!deps.has_value() || deps->size() != 2) {
+      // Possibly already const-folded, put the plan back.
+      subexpression->set_recursive_program(std::move(program.step),
+                                           program.depth);
+      return absl::OkStatus();
+    }
+    subexpression->set_recursive_program(
+        CreateDirectConstantListMembershipStep(
+            call.id(), std::move(deps->at(0)), std::move(set)),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+  absl::Status RewriteStackMachinePlan(
+      PlannerContext& context, const Expr& call, const Expr& element,
+      std::shared_ptr<const PrimitiveValueSet> set) {
+    if (context.GetSubplan(element).empty()) {
+      // This subexpression was already optimized, nothing to do.
+      return absl::OkStatus();
+    }
+
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan,
+                         context.ExtractSubplan(element));
+    CEL_ASSIGN_OR_RETURN(new_plan.emplace_back(),
+                         CreateConstantListMembershipStep(std::move(set),
+                                                          call.id()));
+
+    return context.ReplaceSubplan(call, std::move(new_plan));
+  }
+
+  const ReferenceMap& reference_map_;
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateConstantListMembershipExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    if (!context.options().enable_heterogeneous_equality) {
+      return nullptr;
+    }
+    return std::make_unique<ConstantListMembershipOptimization>(
+        ast.reference_map());
+  };
+}
+
+}  // namespace google::api::expr::runtime
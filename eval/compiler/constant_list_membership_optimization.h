@@ -0,0 +1,32 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_CONSTANT_LIST_MEMBERSHIP_OPTIMIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_CONSTANT_LIST_MEMBERSHIP_OPTIMIZATION_H_
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that replaces `x in [...]`
+// with a hashed lookup when the list is a literal of primitive constants
+// (bool, int, uint, double, string or bytes).
+//
+// Only applies when heterogeneous equality is enabled, since the typed `@in`
+// overloads have different error behavior for mismatched element types.
+ProgramOptimizerFactory CreateConstantListMembershipExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_CONSTANT_LIST_MEMBERSHIP_OPTIMIZATION_H_
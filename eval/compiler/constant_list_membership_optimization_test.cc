@@ -0,0 +1,185 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/constant_list_membership_optimization.h"
+
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/attribute.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::ErrorValue;
+using ::cel::IntValue;
+using ::cel::StringValue;
+using ::cel::UintValue;
+using ::cel::UnknownValue;
+using ::cel::Value;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+class ConstantListMembershipTest : public testing::TestWithParam<bool> {
+ public:
+  ConstantListMembershipTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {}
+
+  void SetUp() override {
+    if (GetParam()) {
+      options_.max_recursion_depth = -1;
+    }
+  }
+
+ protected:
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 const cel::Activation& activation) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    builder.AddProgramOptimizer(CreateConstantListMembershipExtension());
+
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(expr));
+    CEL_ASSIGN_OR_RETURN(auto plan,
+                         builder.CreateExpressionImpl(std::move(ast),
+                                                      /*issues=*/nullptr));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_P(ConstantListMembershipTest, HeterogeneousMembership) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  constexpr absl::string_view kExpr = "x in [1, 2u, 3.5, 'foo', b'bar', true]";
+  struct TestCase {
+    Value x;
+    bool expected;
+  };
+  const TestCase kCases[] = {
+      {IntValue(1), true},           {UintValue(1), true},
+      {DoubleValue(1.0), true},      {IntValue(2), true},
+      {DoubleValue(3.5), true},      {StringValue("foo"), true},
+      {BoolValue(true), true},       {IntValue(3), false},
+      {StringValue("bar"), false},   {BoolValue(false), false},
+      {DoubleValue(2.5), false},
+  };
+
+  for (const TestCase& test_case : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("x", test_case.x);
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(kExpr, activation));
+    ASSERT_TRUE(result.Is<BoolValue>()) << test_case.x.DebugString();
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), test_case.expected)
+        << test_case.x.DebugString();
+  }
+}
+
+TEST_P(ConstantListMembershipTest, ReplacesFunctionCall) {
+  // No `@in` overloads are registered so evaluation would fail if the call
+  // were not replaced.
+  options_.fail_on_warnings = false;
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x in [1, 2, 3]", activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(ConstantListMembershipTest, SkipsNonConstantElements) {
+  options_.fail_on_warnings = false;
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+  activation.InsertOrAssignValue("y", IntValue(2));
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x in [1, y]", activation));
+
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+}
+
+TEST_P(ConstantListMembershipTest, ErrorsPropagate) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  cel::Activation activation;
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x in [1, 2, 3]", activation));
+
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+}
+
+TEST_P(ConstantListMembershipTest, PartiallyUnknownOperand) {
+  options_.unknown_processing = cel::UnknownProcessingOptions::kAttributeOnly;
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+  activation.InsertOrAssignValue("y", IntValue(2));
+  activation.SetUnknownPatterns({cel::AttributePattern(
+      "x", {cel::AttributeQualifierPattern::OfString("y")})});
+
+  // As for the @in function, the operand is unknown if a field of it is.
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x in [1, 2, 3]", activation));
+  EXPECT_TRUE(result.Is<UnknownValue>()) << result.DebugString();
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("!(x in [1, 2, 3])", activation));
+  EXPECT_TRUE(result.Is<UnknownValue>()) << result.DebugString();
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("!(y in [1, 2, 3])", activation));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_FALSE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(ConstantListMembershipTest, DisabledWithoutHeterogeneousEquality) {
+  options_.enable_heterogeneous_equality = false;
+  options_.fail_on_warnings = false;
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x in [1, 2, 3]", activation));
+
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+}
+
+INSTANTIATE_TEST_SUITE_P(ConstantListMembershipTest,
+                         ConstantListMembershipTest, testing::Bool());
+
+}  // namespace
+}  // namespace google::api::expr::runtime
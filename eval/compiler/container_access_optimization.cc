@@ -0,0 +1,291 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/container_access_optimization.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "base/kind.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/container_access_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/internal/convert_constant.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Constant;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+
+using ReferenceMap = absl::flat_hash_map<int64_t, Reference>;
+
+constexpr char kOptionalIndexFunction[] = "_[?_]";
+
+// Overload ids from the standard declarations used by the type checker.
+constexpr absl::string_view kOptionalIndexOverloads[] = {
+    "map_optindex_optional_value",
+    "optional_map_optindex_optional_value",
+    "list_optindex_optional_int",
+    "optional_list_optindex_optional_int",
+};
+constexpr char kInMapOverload[] = "in_map";
+
+// Strict signatures of the standard overloads the steps evaluate inline.
+constexpr cel::Kind kOptionalIndexSignatures[][2] = {
+    {cel::Kind::kMap, cel::Kind::kAny},
+    {cel::Kind::kList, cel::Kind::kInt},
+    {cel::Kind::kOpaque, cel::Kind::kAny},
+};
+constexpr cel::Kind kMapMembershipSignatures[][2] = {
+    {cel::Kind::kBool, cel::Kind::kMap},
+    {cel::Kind::kInt, cel::Kind::kMap},
+    {cel::Kind::kUint, cel::Kind::kMap},
+    {cel::Kind::kString, cel::Kind::kMap},
+};
+
+enum class AccessKind { kOptionalIndex, kMapMembership };
+
+bool IsKnownOverloadId(absl::string_view overload_id, AccessKind kind) {
+  if (kind == AccessKind::kMapMembership) {
+    return overload_id == kInMapOverload;
+  }
+  for (absl::string_view known : kOptionalIndexOverloads) {
+    if (overload_id == known) {
+      return true;
+    }
+  }
+  return false;
+}
+
+absl::optional<AccessKind> FindAccessKind(const Expr& expr,
+                                          const ReferenceMap& reference_map) {
+  if (!expr.has_call_expr()) {
+    return absl::nullopt;
+  }
+  const auto& call_expr = expr.call_expr();
+  if (call_expr.has_target() || call_expr.args().size() != 2) {
+    return absl::nullopt;
+  }
+  AccessKind kind;
+  if (call_expr.function() == kOptionalIndexFunction) {
+    kind = AccessKind::kOptionalIndex;
+  } else if (call_expr.function() == cel::builtin::kIn) {
+    kind = AccessKind::kMapMembership;
+  } else {
+    return absl::nullopt;
+  }
+
+  if (reference_map.empty()) {
+    // If parse-only, assume `_[?_]` is the builtin function, whose containers
+    // are almost always indexed inline. `@in` is mostly applied to lists, so
+    // it is only rewritten if checked as a map membership test.
+    if (kind == AccessKind::kOptionalIndex) {
+      return kind;
+    }
+    return absl::nullopt;
+  }
+  auto reference = reference_map.find(expr.id());
+  if (reference == reference_map.end() ||
+      reference->second.overload_id().empty()) {
+    return absl::nullopt;
+  }
+  for (const auto& overload_id : reference->second.overload_id()) {
+    if (!IsKnownOverloadId(overload_id, kind)) {
+      return absl::nullopt;
+    }
+  }
+  return kind;
+}
+
+bool HasStandardOverloads(
+    absl::Span<const cel::FunctionOverloadReference> overloads,
+    absl::Span<const cel::Kind[2]> signatures) {
+  for (const auto& signature : signatures) {
+    bool found = false;
+    for (const auto& overload : overloads) {
+      const auto& types = overload.descriptor.types();
+      if (overload.descriptor.is_strict() && types.size() == 2 &&
+          types[0] == signature[0] && types[1] == signature[1]) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class ContainerAccessOptimization : public ProgramOptimizer {
+ public:
+  explicit ContainerAccessOptimization(const ReferenceMap& reference_map)
+      : reference_map_(reference_map) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    absl::optional<AccessKind> kind = FindAccessKind(node, reference_map_);
+    if (!kind.has_value()) {
+      return absl::OkStatus();
+    }
+
+    // Match the function resolution of the planner. Lazy overloads shadow the
+    // eager ones, and may differ per activation.
+    const Resolver& resolver = context.resolver();
+    absl::string_view function = node.call_expr().function();
+    if (!resolver
+             .FindLazyOverloads(function, /*receiver_style=*/false,
+                                ArgumentsMatcher(2), node.id())
+             .empty()) {
+      return absl::OkStatus();
+    }
+    std::vector<cel::FunctionOverloadReference> overloads =
+        resolver.FindOverloads(function, /*receiver_style=*/false,
+                               ArgumentsMatcher(2), node.id());
+    absl::Span<const cel::Kind[2]> signatures =
+        *kind == AccessKind::kOptionalIndex
+            ? absl::MakeConstSpan(kOptionalIndexSignatures)
+            : absl::MakeConstSpan(kMapMembershipSignatures);
+    if (!HasStandardOverloads(overloads, signatures)) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    const Expr& key = node.call_expr().args()
+                          [*kind == AccessKind::kOptionalIndex ? 1 : 0];
+    absl::optional<size_t> key_hash = ConstantKeyHash(context, key);
+    if (subexpression->IsRecursive()) {
+      return RewriteRecursivePlan(subexpression, node, *kind,
+                                  std::move(overloads), key_hash);
+    }
+    return RewriteStackMachinePlan(context, node, *kind, std::move(overloads),
+                                   key_hash);
+  }
+
+ private:
+  static absl::optional<size_t> ConstantKeyHash(PlannerContext& context,
+                                                const Expr& key) {
+    if (!key.has_const_expr()) {
+      return absl::nullopt;
+    }
+    const Constant& constant = key.const_expr();
+    if (!constant.has_bool_value() && !constant.has_int64_value() &&
+        !constant.has_uint64_value() && !constant.has_string_value()) {
+      return absl::nullopt;
+    }
+    absl::StatusOr<cel::Value> value = cel::runtime_internal::ConvertConstant(
+        constant, context.value_factory(), context.string_pool());
+    if (!value.ok()) {
+      return absl::nullopt;
+    }
+    return cel::MapKeyHash(*value);
+  }
+
+  absl::Status RewriteRecursivePlan(
+      absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
+      const Expr& call, AccessKind kind,
+      std::vector<cel::FunctionOverloadReference> overloads,
+      absl::optional<size_t> key_hash) {
+    auto program = subexpression->ExtractRecursiveProgram();
+    auto deps = program.step->ExtractDependencies();
+    if (!deps.has_value() || deps->size() != 2) {
+      // Possibly already const-folded, put the plan back.
+      subexpression->set_recursive_program(std::move(program.step),
+                                           program.depth);
+      return absl::OkStatus();
+    }
+    subexpression->set_recursive_program(
+        kind == AccessKind::kOptionalIndex
+            ? CreateDirectOptionalContainerAccessStep(
+                  call.id(), std::move(deps->at(0)), std::move(deps->at(1)),
+                  std::move(overloads), key_hash)
+            : CreateDirectMapMembershipStep(
+                  call.id(), std::move(deps->at(0)), std::move(deps->at(1)),
+                  std::move(overloads), key_hash),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+  absl::Status RewriteStackMachinePlan(
+      PlannerContext& context, const Expr& call, AccessKind kind,
+      std::vector<cel::FunctionOverloadReference> overloads,
+      absl::optional<size_t> key_hash) {
+    const Expr& lhs = call.call_expr().args()[0];
+    const Expr& rhs = call.call_expr().args()[1];
+    if (context.GetSubplan(lhs).empty() || context.GetSubplan(rhs).empty()) {
+      // This subexpression was already optimized, nothing to do.
+      return absl::OkStatus();
+    }
+
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan, context.ExtractSubplan(lhs));
+    CEL_ASSIGN_OR_RETURN(ExecutionPath rhs_plan, context.ExtractSubplan(rhs));
+    std::move(rhs_plan.begin(), rhs_plan.end(), std::back_inserter(new_plan));
+    if (kind == AccessKind::kOptionalIndex) {
+      CEL_ASSIGN_OR_RETURN(
+          new_plan.emplace_back(),
+          CreateOptionalContainerAccessStep(call.call_expr(), call.id(),
+                                            std::move(overloads), key_hash));
+    } else {
+      CEL_ASSIGN_OR_RETURN(
+          new_plan.emplace_back(),
+          CreateMapMembershipStep(call.call_expr(), call.id(),
+                                  std::move(overloads), key_hash));
+    }
+
+    return context.ReplaceSubplan(call, std::move(new_plan));
+  }
+
+  const ReferenceMap& reference_map_;
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateContainerAccessExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<ContainerAccessOptimization>(ast.reference_map());
+  };
+}
+
+}  // namespace google::api::expr::runtime
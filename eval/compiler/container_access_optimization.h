@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_CONTAINER_ACCESS_OPTIMIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_CONTAINER_ACCESS_OPTIMIZATION_H_
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that evaluates the optional
+// index operator `container[?key]` and `key in map` in a single step, which
+// indexes maps, lists and optionals or tests map keys inline instead of
+// dispatching the call through the function registry. Constant keys are
+// hashed once, when planning.
+//
+// Applies to checked expressions if the type checker resolved the call to one
+// of the standard `_[?_]` overloads or to `in_map`, and to `_[?_]` in
+// parse-only expressions. The call is left alone if the registered
+// overloads don't include the strict, eagerly bound standard signatures, but
+// the extension otherwise assumes the registered implementations are the
+// standard ones.
+//
+// Arguments that are errors, unknowns or of an unexpected kind are handled by
+// the generic function dispatch, so results are unchanged.
+ProgramOptimizerFactory CreateContainerAccessExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_CONTAINER_ACCESS_OPTIMIZATION_H_
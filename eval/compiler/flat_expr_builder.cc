@@ -47,16 +47,24 @@
 #include "base/ast_internal/ast_impl.h"
 #include "base/ast_internal/expr.h"
 #include "base/builtins.h"
+#include "base/function_descriptor.h"
+#include "base/kind.h"
 #include "common/ast.h"
 #include "common/ast_traverse.h"
 #include "common/ast_visitor.h"
+#include "common/flat_ast.h"
+#include "common/internal/string_intern_pool.h"
 #include "common/memory.h"
 #include "common/type.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "common/values/legacy_value_manager.h"
+#include "eval/compiler/common_subexpression_elimination.h"
 #include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/incremental_evaluation.h"
+#include "eval/compiler/peephole_optimizer.h"
 #include "eval/compiler/resolver.h"
+#include "eval/compiler/rule_set.h"
 #include "eval/eval/comprehension_step.h"
 #include "eval/eval/const_value_step.h"
 #include "eval/eval/container_access_step.h"
@@ -71,15 +79,19 @@
 #include "eval/eval/lazy_init_step.h"
 #include "eval/eval/logic_step.h"
 #include "eval/eval/optional_or_step.h"
+#include "eval/eval/rule_set_step.h"
 #include "eval/eval/select_step.h"
 #include "eval/eval/shadowable_value_step.h"
+#include "eval/eval/step_arena.h"
 #include "eval/eval/ternary_step.h"
 #include "eval/eval/trace_step.h"
 #include "internal/status_macros.h"
 #include "runtime/internal/convert_constant.h"
 #include "runtime/internal/issue_collector.h"
+#include "runtime/program_references.h"
 #include "runtime/runtime_issue.h"
 #include "runtime/runtime_options.h"
+#include "runtime/variable_layout.h"
 
 namespace google::api::expr::runtime {
 
@@ -97,6 +109,16 @@ using ::cel::runtime_internal::IssueCollector;
 
 constexpr absl::string_view kOptionalOrFn = "or";
 constexpr absl::string_view kOptionalOrValueFn = "orValue";
+constexpr absl::string_view kOptionalSelectFn = "_?._";
+
+// Limits of recursive planning with
+// `RuntimeOptions::enable_adaptive_recursive_planning`.
+//
+// Subexpressions deeper than this are planned as stack machine steps.
+constexpr int kAdaptiveMaxRecursionDepth = 32;
+// Nodes with more operands than this (e.g. list and map literals, calls) are
+// planned as stack machine steps.
+constexpr size_t kAdaptiveMaxRecursiveOperands = 64;
 
 // Forward declare to resolve circular dependency for short_circuiting visitors.
 class FlatExprVisitor;
@@ -291,6 +313,212 @@ bool IsOptimizableListAppend(
          call_expr->args()[0].ident_expr().name() == accu_var;
 }
 
+// Returns whether `expr` may reference the variable `name`, taking into
+// account shadowing by nested comprehensions.
+bool ReferencesVariable(const cel::ast_internal::Expr& expr,
+                        absl::string_view name) {
+  if (expr.has_ident_expr()) {
+    return expr.ident_expr().name() == name;
+  }
+  if (expr.has_select_expr()) {
+    return ReferencesVariable(expr.select_expr().operand(), name);
+  }
+  if (expr.has_call_expr()) {
+    const auto& call = expr.call_expr();
+    if (call.has_target() && ReferencesVariable(call.target(), name)) {
+      return true;
+    }
+    for (const auto& arg : call.args()) {
+      if (ReferencesVariable(arg, name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (expr.has_list_expr()) {
+    for (const auto& element : expr.list_expr().elements()) {
+      if (ReferencesVariable(element.expr(), name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (expr.has_struct_expr()) {
+    for (const auto& field : expr.struct_expr().fields()) {
+      if (ReferencesVariable(field.value(), name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (expr.has_map_expr()) {
+    for (const auto& entry : expr.map_expr().entries()) {
+      if (ReferencesVariable(entry.key(), name) ||
+          ReferencesVariable(entry.value(), name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (expr.has_comprehension_expr()) {
+    const auto& comprehension = expr.comprehension_expr();
+    if (ReferencesVariable(comprehension.iter_range(), name) ||
+        ReferencesVariable(comprehension.accu_init(), name)) {
+      return true;
+    }
+    if (comprehension.iter_var() == name || comprehension.accu_var() == name) {
+      return false;
+    }
+    return ReferencesVariable(comprehension.loop_condition(), name) ||
+           ReferencesVariable(comprehension.loop_step(), name) ||
+           ReferencesVariable(comprehension.result(), name);
+  }
+  return false;
+}
+
+// Returns whether `expr` is `accu_var + [elements]`, where the elements don't
+// reference the accumulator.
+bool IsAppendToAccumulator(const cel::ast_internal::Expr& expr,
+                           absl::string_view accu_var) {
+  if (!expr.has_call_expr()) {
+    return false;
+  }
+  const auto& call = expr.call_expr();
+  if (call.has_target() || call.function() != cel::builtin::kAdd ||
+      call.args().size() != 2 || !call.args()[0].has_ident_expr() ||
+      call.args()[0].ident_expr().name() != accu_var ||
+      !call.args()[1].has_list_expr()) {
+    return false;
+  }
+  for (const auto& element : call.args()[1].list_expr().elements()) {
+    if (element.optional() || ReferencesVariable(element.expr(), accu_var)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether the accumulator of this comprehension is exclusively used
+// as in the standard map/filter macros, so it can't be observed before the
+// comprehension completes:
+//   accu_init: []
+//   loop_step: accu_var + [elem] or filter ? accu_var + [elem] : accu_var
+//   result: accu_var
+//
+// Unlike IsOptimizableListAppend, this is safe for any AST.
+bool IsVerifiedListAppend(
+    const cel::ast_internal::Comprehension* comprehension) {
+  absl::string_view accu_var = comprehension->accu_var();
+  if (accu_var.empty() || comprehension->iter_var() == accu_var ||
+      !comprehension->result().has_ident_expr() ||
+      comprehension->result().ident_expr().name() != accu_var ||
+      !comprehension->accu_init().has_list_expr() ||
+      !comprehension->accu_init().list_expr().elements().empty() ||
+      ReferencesVariable(comprehension->loop_condition(), accu_var)) {
+    return false;
+  }
+  const auto& loop_step = comprehension->loop_step();
+  if (IsAppendToAccumulator(loop_step, accu_var)) {
+    return true;
+  }
+  if (!loop_step.has_call_expr()) {
+    return false;
+  }
+  const auto& call = loop_step.call_expr();
+  return call.function() == cel::builtin::kTernary && !call.has_target() &&
+         call.args().size() == 3 &&
+         !ReferencesVariable(call.args()[0], accu_var) &&
+         IsAppendToAccumulator(call.args()[1], accu_var) &&
+         call.args()[2].has_ident_expr() &&
+         call.args()[2].ident_expr().name() == accu_var;
+}
+
+// Returns the descriptor of the only overload of `function` matching `types`,
+// or nullptr if there are several or any lazy ones.
+const cel::FunctionDescriptor* FindSingleEagerOverload(
+    const Resolver& resolver, absl::string_view function,
+    const std::vector<cel::Kind>& types, int64_t expr_id) {
+  if (!resolver
+           .FindLazyOverloads(function, /*receiver_style=*/false, types,
+                              expr_id)
+           .empty()) {
+    return nullptr;
+  }
+  std::vector<cel::FunctionOverloadReference> overloads =
+      resolver.FindOverloads(function, /*receiver_style=*/false, types,
+                             expr_id);
+  if (overloads.size() != 1) {
+    return nullptr;
+  }
+  return &overloads[0].descriptor;
+}
+
+// Returns whether `function` has the single given overload.
+bool HasOnlyOverload(const Resolver& resolver, absl::string_view function,
+                     const std::vector<cel::Kind>& types, bool strict,
+                     int64_t expr_id) {
+  const cel::FunctionDescriptor* descriptor = FindSingleEagerOverload(
+      resolver, function, ArgumentsMatcher(types.size()), expr_id);
+  return descriptor != nullptr && descriptor->is_strict() == strict &&
+         descriptor->types() == types;
+}
+
+bool IsIdentOf(const cel::ast_internal::Expr& expr, absl::string_view name) {
+  return expr.has_ident_expr() && expr.ident_expr().name() == name;
+}
+
+// Returns the arguments of a global call to `function` with `arity`
+// arguments, or nullptr.
+const std::vector<cel::ast_internal::Expr>* GlobalCallArgs(
+    const cel::ast_internal::Expr& expr, absl::string_view function,
+    size_t arity) {
+  if (!expr.has_call_expr() || expr.call_expr().has_target() ||
+      expr.call_expr().function() != function ||
+      expr.call_expr().args().size() != arity) {
+    return nullptr;
+  }
+  return &expr.call_expr().args();
+}
+
+// Returns the shortcut the direct comprehension step may take when this
+// comprehension has the shape of the standard all() or exists() macros:
+//   all:    loop_condition: @not_strictly_false(accu_var)
+//   exists: loop_condition: @not_strictly_false(!accu_var)
+//
+// The functions involved must resolve to the standard overloads, so this is
+// safe for any AST.
+//
+// exists_one() has no shortcut: after a second match its result is false
+// unless the predicate fails for a later element, which turns it into an
+// error, so every element must be visited.
+ComprehensionShortcut MatchComprehensionShortcut(
+    const cel::ast_internal::Comprehension& comprehension,
+    const Resolver& resolver) {
+  absl::string_view accu_var = comprehension.accu_var();
+  if (accu_var.empty() || comprehension.iter_var() == accu_var) {
+    return ComprehensionShortcut::kNone;
+  }
+  const auto& condition = comprehension.loop_condition();
+  const auto* args =
+      GlobalCallArgs(condition, cel::builtin::kNotStrictlyFalse, 1);
+  if (args == nullptr ||
+      !HasOnlyOverload(resolver, cel::builtin::kNotStrictlyFalse,
+                       {cel::Kind::kAny}, /*strict=*/false, condition.id())) {
+    return ComprehensionShortcut::kNone;
+  }
+  const auto& operand = (*args)[0];
+  if (IsIdentOf(operand, accu_var)) {
+    return ComprehensionShortcut::kAll;
+  }
+  const auto* not_args = GlobalCallArgs(operand, cel::builtin::kNot, 1);
+  if (not_args != nullptr && IsIdentOf((*not_args)[0], accu_var) &&
+      HasOnlyOverload(resolver, cel::builtin::kNot, {cel::Kind::kBool},
+                      /*strict=*/true, operand.id())) {
+    return ComprehensionShortcut::kExists;
+  }
+  return ComprehensionShortcut::kNone;
+}
+
 bool IsBind(const cel::ast_internal::Comprehension* comprehension) {
   static constexpr absl::string_view kUnusedIterVar = "#unused";
 
@@ -301,6 +529,88 @@ bool IsBind(const cel::ast_internal::Comprehension* comprehension) {
          comprehension->iter_range().list_expr().elements().empty();
 }
 
+bool ContainsComprehension(const cel::ast_internal::Expr& expr) {
+  std::vector<const cel::ast_internal::Expr*> stack = {&expr};
+  while (!stack.empty()) {
+    const cel::ast_internal::Expr* current = stack.back();
+    stack.pop_back();
+    if (current->has_comprehension_expr()) {
+      return true;
+    }
+    if (current->has_select_expr()) {
+      stack.push_back(&current->select_expr().operand());
+    } else if (current->has_call_expr()) {
+      const auto& call = current->call_expr();
+      if (call.has_target()) {
+        stack.push_back(&call.target());
+      }
+      for (const auto& arg : call.args()) {
+        stack.push_back(&arg);
+      }
+    } else if (current->has_list_expr()) {
+      for (const auto& element : current->list_expr().elements()) {
+        stack.push_back(&element.expr());
+      }
+    } else if (current->has_struct_expr()) {
+      for (const auto& field : current->struct_expr().fields()) {
+        stack.push_back(&field.value());
+      }
+    } else if (current->has_map_expr()) {
+      for (const auto& entry : current->map_expr().entries()) {
+        stack.push_back(&entry.key());
+        stack.push_back(&entry.value());
+      }
+    }
+  }
+  return false;
+}
+
+// Returns the names of the identifiers referenced by `expr`, including those
+// bound by the comprehensions within it.
+absl::flat_hash_set<absl::string_view> ReferencedIdentNames(
+    const cel::ast_internal::Expr& expr) {
+  absl::flat_hash_set<absl::string_view> names;
+  std::vector<const cel::ast_internal::Expr*> stack = {&expr};
+  while (!stack.empty()) {
+    const cel::ast_internal::Expr* current = stack.back();
+    stack.pop_back();
+    if (current->has_ident_expr()) {
+      names.insert(current->ident_expr().name());
+    } else if (current->has_select_expr()) {
+      stack.push_back(&current->select_expr().operand());
+    } else if (current->has_call_expr()) {
+      const auto& call = current->call_expr();
+      if (call.has_target()) {
+        stack.push_back(&call.target());
+      }
+      for (const auto& arg : call.args()) {
+        stack.push_back(&arg);
+      }
+    } else if (current->has_list_expr()) {
+      for (const auto& element : current->list_expr().elements()) {
+        stack.push_back(&element.expr());
+      }
+    } else if (current->has_struct_expr()) {
+      for (const auto& field : current->struct_expr().fields()) {
+        stack.push_back(&field.value());
+      }
+    } else if (current->has_map_expr()) {
+      for (const auto& entry : current->map_expr().entries()) {
+        stack.push_back(&entry.key());
+        stack.push_back(&entry.value());
+      }
+    } else if (current->has_comprehension_expr()) {
+      const auto& comprehension = current->comprehension_expr();
+      stack.push_back(&comprehension.iter_range());
+      stack.push_back(&comprehension.accu_init());
+      stack.push_back(&comprehension.loop_condition());
+      stack.push_back(&comprehension.loop_step());
+      stack.push_back(&comprehension.result());
+    }
+  }
+  return names;
+}
+
 // Visitor for Comprehension expressions.
 class ComprehensionVisitor {
  public:
@@ -330,6 +640,10 @@ class ComprehensionVisitor {
 
   void MarkAccuInitExtracted() { accu_init_extracted_ = true; }
 
+  // Marks the slot of a trivial comprehension as cleared by an enclosing
+  // comprehension instead.
+  void MarkHoisted() { hoisted_ = true; }
+
  private:
   void PostVisitArgTrivial(cel::ComprehensionArg arg_num,
                            const cel::ast_internal::Expr* comprehension_expr);
@@ -346,6 +660,7 @@ class ComprehensionVisitor {
   bool short_circuiting_;
   bool is_trivial_;
   bool accu_init_extracted_;
+  bool hoisted_ = false;
   size_t iter_slot_;
   size_t accu_slot_;
 };
@@ -390,8 +705,11 @@ class FlatExprVisitor : public cel::AstVisitor {
       std::vector<std::unique_ptr<ProgramOptimizer>> program_optimizers,
       const absl::flat_hash_map<int64_t, cel::ast_internal::Reference>&
           reference_map,
-      ValueManager& value_factory, IssueCollector& issue_collector,
+      const cel::ast_internal::AstImpl& ast, ValueManager& value_factory,
+      IssueCollector& issue_collector,
       ProgramBuilder& program_builder, PlannerContext& extension_context,
+      cel::VariableLayout& variable_layout, cel::ProgramReferences& references,
+      cel::common_internal::StringInternPool& string_pool,
       bool enable_optional_types)
       : resolver_(resolver),
         value_factory_(value_factory),
@@ -403,6 +721,10 @@ class FlatExprVisitor : public cel::AstVisitor {
         issue_collector_(issue_collector),
         program_builder_(program_builder),
         extension_context_(extension_context),
+        variable_layout_(variable_layout),
+        references_(references),
+        string_pool_(string_pool),
+        ast_(ast),
         enable_optional_types_(enable_optional_types) {}
 
   void PreVisitExpr(const cel::ast_internal::Expr& expr) override {
@@ -471,7 +793,7 @@ class FlatExprVisitor : public cel::AstVisitor {
     }
 
     absl::StatusOr<cel::Value> converted_value =
-        ConvertConstant(const_expr, value_factory_);
+        ConvertConstant(const_expr, value_factory_, &string_pool_);
 
     if (!converted_value.ok()) {
       SetProgressStatusError(converted_value.status());
@@ -489,6 +811,26 @@ class FlatExprVisitor : public cel::AstVisitor {
         CreateConstValueStep(std::move(converted_value).value(), expr.id()));
   }
 
+  // Returns the map key hash of `key` if it is a constant of a map key type,
+  // so that index operations with it need not hash it on every evaluation.
+  absl::optional<size_t> ConstantMapKeyHash(
+      const cel::ast_internal::Expr& key) {
+    if (!key.has_const_expr()) {
+      return absl::nullopt;
+    }
+    const cel::ast_internal::Constant& constant = key.const_expr();
+    if (!constant.has_bool_value() && !constant.has_int64_value() &&
+        !constant.has_uint64_value() && !constant.has_string_value()) {
+      return absl::nullopt;
+    }
+    absl::StatusOr<cel::Value> value =
+        ConvertConstant(constant, value_factory_, &string_pool_);
+    if (!value.ok()) {
+      return absl::nullopt;
+    }
+    return cel::MapKeyHash(*value);
+  }
+
   struct SlotLookupResult {
     int slot;
     int subexpression;
@@ -573,6 +915,20 @@ class FlatExprVisitor : public cel::AstVisitor {
       select_root_id = expr.id();
     }
 
+    if (const_value && options_.enable_closed_activation_schema) {
+      // No variable can shadow the constant, so it need not be looked up in
+      // the activation first.
+      if (options_.max_recursion_depth != 0) {
+        SetRecursiveStep(CreateConstValueDirectStep(
+                             std::move(const_value).value(), select_root_id),
+                         1);
+        return;
+      }
+      AddStep(CreateConstValueStep(std::move(const_value).value(),
+                                   select_root_id));
+      return;
+    }
+
     if (const_value) {
       if (options_.max_recursion_depth != 0) {
         SetRecursiveStep(CreateDirectShadowableValueStep(
@@ -619,10 +975,19 @@ class FlatExprVisitor : public cel::AstVisitor {
       }
       return;
     }
+    // Otherwise this is a free variable, assign it a slot so that it can be
+    // bound by index.
+    size_t variable_slot = variable_layout_.AddVariable(ident_expr.name());
     if (options_.max_recursion_depth != 0) {
-      SetRecursiveStep(CreateDirectIdentStep(ident_expr.name(), expr.id()), 1);
+      SetRecursiveStep(
+          CreateDirectIdentStep(ident_expr.name(), expr.id(),
+                                attribute_tracking_enabled(), &variable_layout_,
+                                variable_slot),
+          1);
     } else {
-      AddStep(CreateIdentStep(ident_expr, expr.id()));
+      AddStep(CreateIdentStep(ident_expr, expr.id(),
+                              attribute_tracking_enabled(), &variable_layout_,
+                              variable_slot));
     }
   }
 
@@ -691,21 +1056,86 @@ class FlatExprVisitor : public cel::AstVisitor {
             "unexpected number of dependencies for select operation."));
         return;
       }
-      StringValue field =
-          value_factory_.CreateUncheckedStringValue(select_expr.field());
+      StringValue field(string_pool_.Intern(select_expr.field()));
 
       SetRecursiveStep(
           CreateDirectSelectStep(std::move(deps[0]), std::move(field),
                                  select_expr.test_only(), expr.id(),
                                  options_.enable_empty_wrapper_null_unboxing,
-                                 enable_optional_types_),
+                                 SelectMayReadOptional(select_expr),
+                                 ResolveTypedSelectField(select_expr)),
           *depth + 1);
       return;
     }
 
-    AddStep(CreateSelectStep(select_expr, expr.id(),
-                             options_.enable_empty_wrapper_null_unboxing,
-                             value_factory_, enable_optional_types_));
+    AddStep(CreateSelectStep(
+        select_expr, expr.id(), options_.enable_empty_wrapper_null_unboxing,
+        StringValue(string_pool_.Intern(select_expr.field())),
+        SelectMayReadOptional(select_expr), attribute_tracking_enabled(),
+        ResolveTypedSelectField(select_expr)));
+  }
+
+  // Returns the checked type of the operand of `select_expr`, if any.
+  const cel::ast_internal::Type* CheckedOperandType(
+      const cel::ast_internal::Select& select_expr) const {
+    if (!select_expr.has_operand()) {
+      return nullptr;
+    }
+    return ast_.FindType(select_expr.operand().id());
+  }
+
+  // Returns the kind of the keys of `container` if it was checked as a map
+  // keyed by a primitive type.
+  absl::optional<cel::ValueKind> CheckedMapKeyKind(
+      const cel::ast_internal::Expr& container) const {
+    const cel::ast_internal::Type* type = ast_.FindType(container.id());
+    if (type == nullptr || !type->has_map_type() ||
+        !type->map_type().has_key_type() ||
+        !type->map_type().key_type().has_primitive()) {
+      return absl::nullopt;
+    }
+    switch (type->map_type().key_type().primitive()) {
+      case cel::ast_internal::PrimitiveType::kBool:
+        return cel::ValueKind::kBool;
+      case cel::ast_internal::PrimitiveType::kInt64:
+        return cel::ValueKind::kInt64;
+      case cel::ast_internal::PrimitiveType::kUint64:
+        return cel::ValueKind::kUint64;
+      case cel::ast_internal::PrimitiveType::kString:
+        return cel::ValueKind::kString;
+      default:
+        return absl::nullopt;
+    }
+  }
+
+  // Whether the operand of `select_expr` may be an optional value. Operands
+  // checked as messages or maps never are, so the select step needn't test
+  // for one.
+  bool SelectMayReadOptional(
+      const cel::ast_internal::Select& select_expr) const {
+    if (!enable_optional_types_) {
+      return false;
+    }
+    const cel::ast_internal::Type* type = CheckedOperandType(select_expr);
+    return type == nullptr ||
+           !(type->has_message_type() || type->has_map_type());
+  }
+
+  // Resolves the field selected by `select_expr` when its operand was checked
+  // as a message type known to the type provider.
+  absl::optional<TypedSelectField> ResolveTypedSelectField(
+      const cel::ast_internal::Select& select_expr) {
+    const cel::ast_internal::Type* type = CheckedOperandType(select_expr);
+    if (type == nullptr || !type->has_message_type()) {
+      return absl::nullopt;
+    }
+    const std::string& message_type = type->message_type().type();
+    auto field = value_factory_.FindStructTypeFieldByName(message_type,
+                                                          select_expr.field());
+    if (!field.ok() || !field->has_value() || (*field)->number <= 0) {
+      return absl::nullopt;
+    }
+    return TypedSelectField{message_type, (*field)->number};
   }
 
   // Call node handler group.
@@ -761,11 +1191,32 @@ class FlatExprVisitor : public cel::AstVisitor {
       // one or more of the dependencies isn't eligible.
       return depth;
     }
-    if (options_.max_recursion_depth < 0 ||
-        *depth < options_.max_recursion_depth) {
-      return depth;
+    if (!IsWithinRecursionDepth(*depth)) {
+      return absl::nullopt;
     }
-    return absl::nullopt;
+    if (options_.enable_adaptive_recursive_planning &&
+        program_builder_.current()->elements().size() >
+            kAdaptiveMaxRecursiveOperands) {
+      // Wide nodes gain little from recursion: evaluating their operands in a
+      // single pass over the stack machine program costs about the same.
+      return absl::nullopt;
+    }
+    return depth;
+  }
+
+  // Returns whether a node whose deepest operand is `depth` steps deep may be
+  // planned recursively.
+  //
+  // With adaptive planning, deep subexpressions (e.g. long chains of logical
+  // operators) use the stack machine, which needs no stack space per level,
+  // even if `max_recursion_depth` allows more.
+  bool IsWithinRecursionDepth(int depth) const {
+    int max_depth = options_.max_recursion_depth;
+    if (options_.enable_adaptive_recursive_planning &&
+        (max_depth < 0 || max_depth > kAdaptiveMaxRecursionDepth)) {
+      max_depth = kAdaptiveMaxRecursionDepth;
+    }
+    return max_depth < 0 || depth < max_depth;
   }
 
   std::vector<std::unique_ptr<DirectExpressionStep>>
@@ -810,8 +1261,7 @@ class FlatExprVisitor : public cel::AstVisitor {
     }
     max_depth = std::max(max_depth, right_plan->recursive_program().depth);
 
-    if (options_.max_recursion_depth >= 0 &&
-        max_depth >= options_.max_recursion_depth) {
+    if (!IsWithinRecursionDepth(max_depth)) {
       return;
     }
 
@@ -849,8 +1299,7 @@ class FlatExprVisitor : public cel::AstVisitor {
     }
     max_depth = std::max(max_depth, right_plan->recursive_program().depth);
 
-    if (options_.max_recursion_depth >= 0 &&
-        max_depth >= options_.max_recursion_depth) {
+    if (!IsWithinRecursionDepth(max_depth)) {
       return;
     }
 
@@ -896,8 +1345,13 @@ class FlatExprVisitor : public cel::AstVisitor {
     }
     max_depth = std::max(max_depth, right_plan->recursive_program().depth);
 
-    if (options_.max_recursion_depth >= 0 &&
-        max_depth >= options_.max_recursion_depth) {
+    if (!IsWithinRecursionDepth(max_depth)) {
+      return;
+    }
+
+    if (is_or_value && options_.short_circuiting &&
+        MaybeFuseOptionalSelectOrValue(expr, left_plan, right_plan,
+                                       max_depth)) {
       return;
     }
 
@@ -908,9 +1362,77 @@ class FlatExprVisitor : public cel::AstVisitor {
                      max_depth + 1);
   }
 
+  // Plans `operand.?field1...?fieldN.orValue(alternative)` as a single step
+  // which walks the select chain without materializing the intermediate
+  // optionals. Returns false, leaving the plans untouched, if `expr` isn't
+  // such a chain of recursively planned `_?._` calls.
+  bool MaybeFuseOptionalSelectOrValue(
+      const cel::ast_internal::Expr* expr,
+      ProgramBuilder::Subexpression* left_plan,
+      ProgramBuilder::Subexpression* right_plan, int max_depth) {
+    // Outermost select first.
+    std::vector<const cel::ast_internal::Expr*> selects;
+    for (const cel::ast_internal::Expr* node = &expr->call_expr().target();
+         node->has_call_expr() &&
+         node->call_expr().function() == kOptionalSelectFn &&
+         !node->call_expr().has_target() &&
+         node->call_expr().args().size() == 2 &&
+         node->call_expr().args()[1].has_const_expr() &&
+         node->call_expr().args()[1].const_expr().has_string_value();
+         node = &node->call_expr().args()[0]) {
+      selects.push_back(node);
+    }
+    if (selects.empty()) {
+      return false;
+    }
+    if (!resolver_
+             .FindLazyOverloads(kOptionalSelectFn, /*receiver_style=*/false,
+                                ArgumentsMatcher(2), selects.back()->id())
+             .empty()) {
+      return false;
+    }
+    auto overloads =
+        resolver_.FindOverloads(kOptionalSelectFn, /*receiver_style=*/false,
+                                ArgumentsMatcher(2), selects.back()->id());
+    if (overloads.empty()) {
+      return false;
+    }
+
+    // Check that each select was planned as a call, which other optimizations
+    // may have replaced, before taking the steps apart.
+    const DirectExpressionStep* step =
+        left_plan->recursive_program().step.get();
+    for (const cel::ast_internal::Expr* select : selects) {
+      if (step == nullptr || step->expr_id() != select->id()) {
+        return false;
+      }
+      auto dependencies = step->GetDependencies();
+      if (!dependencies.has_value() || dependencies->size() != 2) {
+        return false;
+      }
+      step = dependencies->front();
+    }
+
+    std::unique_ptr<DirectExpressionStep> operand =
+        left_plan->ExtractRecursiveProgram().step;
+    std::vector<std::string> fields(selects.size());
+    for (size_t i = 0; i < selects.size(); ++i) {
+      fields[selects.size() - 1 - i] =
+          selects[i]->call_expr().args()[1].const_expr().string_value();
+      operand = std::move(operand->ExtractDependencies()->front());
+    }
+    SetRecursiveStep(CreateDirectOptionalSelectOrValueStep(
+                         expr->id(), std::move(operand), std::move(fields),
+                         std::move(overloads),
+                         right_plan->ExtractRecursiveProgram().step),
+                     max_depth + 1);
+    return true;
+  }
+
   void MaybeMakeBindRecursive(
       const cel::ast_internal::Expr* expr,
-      const cel::ast_internal::Comprehension* comprehension, size_t accu_slot) {
+      const cel::ast_internal::Comprehension* comprehension, size_t accu_slot,
+      bool hoisted) {
     if (options_.max_recursion_depth == 0) {
       return;
     }
@@ -924,12 +1446,16 @@ class FlatExprVisitor : public cel::AstVisitor {
 
     int result_depth = result_plan->recursive_program().depth;
 
-    if (options_.max_recursion_depth > 0 &&
-        result_depth >= options_.max_recursion_depth) {
+    if (!IsWithinRecursionDepth(result_depth)) {
       return;
     }
 
     auto program = result_plan->ExtractRecursiveProgram();
+    if (hoisted) {
+      // The slot is cleared by the enclosing comprehension.
+      SetRecursiveStep(std::move(program.step), result_depth);
+      return;
+    }
     SetRecursiveStep(
         CreateDirectBindStep(accu_slot, std::move(program.step), expr->id()),
         result_depth + 1);
@@ -985,18 +1511,35 @@ class FlatExprVisitor : public cel::AstVisitor {
     max_depth = std::max(max_depth, condition_plan->recursive_program().depth);
     max_depth = std::max(max_depth, result_plan->recursive_program().depth);
 
+    // Loops are evaluated recursively as long as `max_recursion_depth`
+    // allows, even beyond the depth of adaptive planning: their steps run for
+    // every iteration, where recursion saves the most.
     if (options_.max_recursion_depth > 0 &&
         max_depth >= options_.max_recursion_depth) {
       return;
     }
 
+    // Nested loops count iterations too. Besides those in the loop itself,
+    // they may run when a variable of an enclosing cel.bind() is referenced
+    // for the first time.
+    bool count_iterations_in_bulk =
+        !ContainsComprehension(comprehension->loop_step()) &&
+        !ContainsComprehension(comprehension->loop_condition());
+    for (const ComprehensionStackRecord& record : comprehension_stack_) {
+      if (record.comprehension != comprehension && record.is_optimizable_bind &&
+          ContainsComprehension(record.comprehension->accu_init())) {
+        count_iterations_in_bulk = false;
+      }
+    }
+
     auto step = CreateDirectComprehensionStep(
         iter_slot, accu_slot, range_plan->ExtractRecursiveProgram().step,
         accu_plan->ExtractRecursiveProgram().step,
         loop_plan->ExtractRecursiveProgram().step,
         condition_plan->ExtractRecursiveProgram().step,
         result_plan->ExtractRecursiveProgram().step, options_.short_circuiting,
-        expr->id());
+        expr->id(), count_iterations_in_bulk,
+        MatchComprehensionShortcut(*comprehension, resolver_));
 
     SetRecursiveStep(std::move(step), max_depth + 1);
   }
@@ -1030,8 +1573,27 @@ class FlatExprVisitor : public cel::AstVisitor {
       return;
     }
 
+    // Special case for the root of a combined rule set.
+    if (call_expr.function() == kRuleSetFunction) {
+      auto depth = RecursionEligible();
+      if (depth.has_value()) {
+        SetRecursiveStep(
+            CreateDirectRuleSetStep(ExtractRecursiveDependencies(), expr.id()),
+            *depth + 1);
+        return;
+      }
+      AddStep(CreateRuleSetStep(call_expr.args().size(), expr.id()));
+      return;
+    }
+
     // Special case for "_[_]".
     if (call_expr.function() == cel::builtin::kIndex) {
+      absl::optional<size_t> key_hash;
+      absl::optional<cel::ValueKind> map_key_kind;
+      if (call_expr.args().size() == 2) {
+        key_hash = ConstantMapKeyHash(call_expr.args()[1]);
+        map_key_kind = CheckedMapKeyKind(call_expr.args()[0]);
+      }
       auto depth = RecursionEligible();
       if (depth.has_value()) {
         auto args = ExtractRecursiveDependencies();
@@ -1039,14 +1601,16 @@ class FlatExprVisitor : public cel::AstVisitor {
           SetProgressStatusError(absl::InvalidArgumentError(
               "unexpected number of args for builtin index operator"));
         }
-        SetRecursiveStep(CreateDirectContainerAccessStep(
-                             std::move(args[0]), std::move(args[1]),
-                             enable_optional_types_, expr.id()),
-                         *depth + 1);
+        SetRecursiveStep(
+            CreateDirectContainerAccessStep(
+                std::move(args[0]), std::move(args[1]), enable_optional_types_,
+                expr.id(), key_hash, map_key_kind),
+            *depth + 1);
         return;
       }
-      AddStep(CreateContainerAccessStep(call_expr, expr.id(),
-                                        enable_optional_types_));
+      AddStep(CreateContainerAccessStep(
+          call_expr, expr.id(), enable_optional_types_,
+          attribute_tracking_enabled(), key_hash, map_key_kind));
       return;
     }
 
@@ -1133,17 +1697,39 @@ class FlatExprVisitor : public cel::AstVisitor {
       // If no bind init subexpression, account normally.
     }
 
+    int hoist_target = -1;
+    if (is_bind && options_.enable_bind_hoisting) {
+      hoist_target = FindBindHoistingTarget(comprehension);
+    }
+    if (hoist_target >= 0) {
+      // The slot stays in use until the target comprehension is done, so the
+      // slots reserved since it was entered can't be released before then.
+      ComprehensionStackRecord& target = comprehension_stack_[hoist_target];
+      for (size_t i = hoist_target + 1; i < comprehension_stack_.size(); ++i) {
+        target.slot_count += comprehension_stack_[i].slot_count;
+        comprehension_stack_[i].slot_count = 0;
+      }
+      target.slot_count += slot_count;
+      slot_count = 0;
+      target.hoisted_slots.push_back(accu_slot);
+    }
+
     comprehension_stack_.push_back(
         {&expr, &comprehension, iter_slot, accu_slot, slot_count,
          /*subexpression=*/-1,
          IsOptimizableListAppend(&comprehension,
-                                 options_.enable_comprehension_list_append),
+                                 options_.enable_comprehension_list_append) ||
+             (IsVerifiedListAppend(&comprehension) &&
+              ListAppendAvailable(expr.id())),
          is_bind,
          /*.iter_var_in_scope=*/false,
          /*.accu_var_in_scope=*/false,
          /*.in_accu_init=*/false,
          std::make_unique<ComprehensionVisitor>(
              this, options_.short_circuiting, is_bind, iter_slot, accu_slot)});
+    if (hoist_target >= 0) {
+      comprehension_stack_.back().visitor->MarkHoisted();
+    }
     comprehension_stack_.back().visitor->PreVisit(&expr);
   }
 
@@ -1163,6 +1749,10 @@ class FlatExprVisitor : public cel::AstVisitor {
 
     record.visitor->PostVisit(&expr);
 
+    if (!record.hoisted_slots.empty()) {
+      ClearHoistedSlots(expr, std::move(record.hoisted_slots));
+    }
+
     index_manager_.ReleaseSlots(record.slot_count);
     comprehension_stack_.pop_back();
   }
@@ -1308,7 +1898,9 @@ class FlatExprVisitor : public cel::AstVisitor {
     std::string resolved_name =
         std::move(status_or_resolved_fields.value().first);
     std::vector<std::string> fields =
-        std::move(status_or_resolved_fields.value().second);
+        std::move(status_or_resolved_fields.value().second.names);
+    std::vector<int64_t> field_numbers =
+        std::move(status_or_resolved_fields.value().second.numbers);
 
     auto depth = RecursionEligible();
     if (depth.has_value()) {
@@ -1320,14 +1912,16 @@ class FlatExprVisitor : public cel::AstVisitor {
       }
       auto step = CreateDirectCreateStructStep(
           std::move(resolved_name), std::move(fields), std::move(deps),
-          MakeOptionalIndicesSet(struct_expr), expr.id());
+          MakeOptionalIndicesSet(struct_expr), expr.id(),
+          std::move(field_numbers));
       SetRecursiveStep(std::move(step), *depth + 1);
       return;
     }
 
-    AddStep(CreateCreateStructStep(std::move(resolved_name), std::move(fields),
-                                   MakeOptionalIndicesSet(struct_expr),
-                                   expr.id()));
+    AddStep(CreateCreateStructStep(
+        std::move(resolved_name), std::move(fields),
+        MakeOptionalIndicesSet(struct_expr), expr.id(),
+        std::move(field_numbers)));
   }
 
   void PostVisitMap(const cel::ast_internal::Expr& expr,
@@ -1379,6 +1973,10 @@ class FlatExprVisitor : public cel::AstVisitor {
     auto lazy_overloads = resolver_.FindLazyOverloads(
         function, call_expr->has_target(), arguments_matcher, expr->id());
     if (!lazy_overloads.empty()) {
+      for (const auto& overload : lazy_overloads) {
+        references_.functions.insert(overload.descriptor.name());
+        references_.context_functions.insert(overload.descriptor.name());
+      }
       auto depth = RecursionEligible();
       if (depth.has_value()) {
         auto args = program_builder_.current()->ExtractRecursiveDependencies();
@@ -1396,7 +1994,11 @@ class FlatExprVisitor : public cel::AstVisitor {
     // Second, search for eagerly defined function overloads.
     auto overloads = resolver_.FindOverloads(function, receiver_style,
                                              arguments_matcher, expr->id());
+    for (const auto& overload : overloads) {
+      references_.functions.insert(overload.descriptor.name());
+    }
     if (overloads.empty()) {
+      references_.functions.insert(std::string(function));
       // Create a warning that the overload could not be found. Depending on the
       // builder_warnings configuration, this could result in termination of the
       // CelExpression creation or an inspectable warning for use within runtime
@@ -1513,12 +2115,98 @@ class FlatExprVisitor : public cel::AstVisitor {
     bool accu_var_in_scope;
     bool in_accu_init;
     std::unique_ptr<ComprehensionVisitor> visitor;
+    // Slots of the binds hoisted out of this comprehension's loop, cleared
+    // once it is done.
+    std::vector<size_t> hoisted_slots = {};
   };
 
+  // Returns the index in the comprehension stack of the outermost loop which
+  // the bind `comprehension`, about to be visited, can be hoisted out of, or -1
+  // if it can't be hoisted out of any.
+  //
+  // A bind can be hoisted out of the loops whose variables its initializer
+  // doesn't reference, up to the initializer of an enclosing bind, which is
+  // evaluated lazily.
+  int FindBindHoistingTarget(
+      const cel::ast_internal::Comprehension& comprehension) const {
+    absl::flat_hash_set<absl::string_view> names =
+        ReferencedIdentNames(comprehension.accu_init());
+    int target = -1;
+    for (int i = static_cast<int>(comprehension_stack_.size()) - 1; i >= 0;
+         --i) {
+      const ComprehensionStackRecord& record = comprehension_stack_[i];
+      if (record.in_accu_init && record.is_optimizable_bind) {
+        break;
+      }
+      if ((record.iter_var_in_scope &&
+           names.contains(record.comprehension->iter_var())) ||
+          (record.accu_var_in_scope &&
+           names.contains(record.comprehension->accu_var()))) {
+        break;
+      }
+      if (!record.is_optimizable_bind && record.iter_var_in_scope) {
+        target = i;
+      }
+    }
+    return target;
+  }
+
+  // Clears the slots of the binds hoisted out of the loop of `expr` once it
+  // is evaluated.
+  void ClearHoistedSlots(const cel::ast_internal::Expr& expr,
+                         std::vector<size_t> slots) {
+    auto* subexpression = program_builder_.current();
+    if (subexpression == nullptr) {
+      SetProgressStatusError(
+          absl::InternalError("comprehension has no subexpression"));
+      return;
+    }
+    if (subexpression->IsRecursive()) {
+      auto program = subexpression->ExtractRecursiveProgram();
+      SetRecursiveStep(CreateDirectClearSlotsStep(std::move(slots),
+                                                  std::move(program.step),
+                                                  expr.id()),
+                       program.depth + 1);
+      return;
+    }
+    for (size_t slot : slots) {
+      AddStep(CreateClearSlotStep(slot, expr.id()));
+    }
+  }
+
+  // Whether the accumulator of a verified map/filter comprehension may be
+  // appended to in place: the runtime list append function is registered and
+  // list concatenation, which it replaces, is an eagerly bound function.
+  bool ListAppendAvailable(int64_t expr_id) const {
+    if (!resolver_
+             .FindLazyOverloads(cel::builtin::kAdd, /*receiver_style=*/false,
+                                {cel::Kind::kList, cel::Kind::kList}, expr_id)
+             .empty()) {
+      return false;
+    }
+    return !resolver_
+                .FindOverloads(cel::builtin::kAdd, /*receiver_style=*/false,
+                               {cel::Kind::kList, cel::Kind::kList}, expr_id)
+                .empty() &&
+           !resolver_
+                .FindOverloads(cel::builtin::kRuntimeListAppend,
+                               /*receiver_style=*/false,
+                               {cel::Kind::kOpaque, cel::Kind::kList}, expr_id)
+                .empty();
+  }
+
   bool PlanningSuppressed() const {
     return resume_from_suppressed_branch_ != nullptr;
   }
 
+  // Whether steps need to maintain attribute trails for unknown or missing
+  // attribute checks.
+  bool attribute_tracking_enabled() const {
+    return options_.unknown_processing !=
+               cel::UnknownProcessingOptions::kDisabled ||
+           options_.enable_missing_attribute_errors;
+  }
+
   absl::Status MaybeExtractSubexpression(const cel::ast_internal::Expr* expr,
                                          ComprehensionStackRecord& record) {
     if (!record.is_optimizable_bind) {
@@ -1537,9 +2225,17 @@ class FlatExprVisitor : public cel::AstVisitor {
     return absl::OkStatus();
   }
 
-  // Resolve the name of the message type being created and the names of set
-  // fields.
-  absl::StatusOr<std::pair<std::string, std::vector<std::string>>>
+  // Names and numbers of the fields set by a CreateStruct expression.
+  struct ResolvedStructFields {
+    std::vector<std::string> names;
+    // Zero for extensions and fields without a known number, which are set by
+    // name.
+    std::vector<int64_t> numbers;
+  };
+
+  // Resolve the name of the message type being created and the names and
+  // numbers of set fields.
+  absl::StatusOr<std::pair<std::string, ResolvedStructFields>>
   ResolveCreateStructFields(
       const cel::ast_internal::CreateStruct& create_struct_expr,
       int64_t expr_id) {
@@ -1555,8 +2251,9 @@ class FlatExprVisitor : public cel::AstVisitor {
 
     std::string resolved_name = std::move(type).value().first;
 
-    std::vector<std::string> fields;
-    fields.reserve(create_struct_expr.fields().size());
+    ResolvedStructFields fields;
+    fields.names.reserve(create_struct_expr.fields().size());
+    fields.numbers.reserve(create_struct_expr.fields().size());
     for (const auto& entry : create_struct_expr.fields()) {
       if (entry.name().empty()) {
         return absl::InvalidArgumentError("Struct field missing name");
@@ -1572,7 +2269,12 @@ class FlatExprVisitor : public cel::AstVisitor {
             absl::StrCat("Invalid message creation: field '", entry.name(),
                          "' not found in '", resolved_name, "'"));
       }
-      fields.push_back(entry.name());
+      fields.names.push_back(entry.name());
+      // Extensions are named by their qualified name and can't be set by
+      // number.
+      fields.numbers.push_back(absl::StrContains(entry.name(), '.')
+                                   ? 0
+                                   : std::max<int64_t>(field->number, 0));
     }
 
     return std::make_pair(std::move(resolved_name), std::move(fields));
@@ -1582,6 +2284,7 @@ class FlatExprVisitor : public cel::AstVisitor {
   ValueManager& value_factory_;
   absl::Status progress_status_;
 
+
   std::stack<
       std::pair<const cel::ast_internal::Expr*, std::unique_ptr<CondVisitor>>>
       cond_visitor_stack_;
@@ -1609,6 +2312,14 @@ class FlatExprVisitor : public cel::AstVisitor {
   ProgramBuilder& program_builder_;
   PlannerContext extension_context_;
   IndexManager index_manager_;
+  cel::VariableLayout& variable_layout_;
+  cel::ProgramReferences& references_;
+  // Deduplicates the string constants and field names of the program, so that
+  // comparisons and map lookups with them can short-circuit.
+  cel::common_internal::StringInternPool& string_pool_;
+  // Checked types of the expressions, empty for parsed-only ASTs.
+  // Only used to look up the checked types of expressions.
+  const cel::ast_internal::AstImpl& ast_;
 
   bool enable_optional_types_;
 };
@@ -1889,7 +2600,9 @@ void ComprehensionVisitor::PostVisitArgTrivial(
       break;
     }
     case cel::RESULT: {
-      visitor_->AddStep(CreateClearSlotStep(accu_slot_, expr->id()));
+      if (!hoisted_) {
+        visitor_->AddStep(CreateClearSlotStep(accu_slot_, expr->id()));
+      }
       break;
     }
   }
@@ -1898,7 +2611,7 @@ void ComprehensionVisitor::PostVisitArgTrivial(
 void ComprehensionVisitor::PostVisit(const cel::ast_internal::Expr* expr) {
   if (is_trivial_) {
     visitor_->MaybeMakeBindRecursive(expr, &expr->comprehension_expr(),
-                                     accu_slot_);
+                                     accu_slot_, hoisted_);
     return;
   }
   visitor_->MaybeMakeComprehensionRecursive(expr, &expr->comprehension_expr(),
@@ -1907,15 +2620,25 @@ void ComprehensionVisitor::PostVisit(const cel::ast_internal::Expr* expr) {
 
 // Flattens the expression table into the end of the mainline expression vector
 // and returns an index to the individual sub expressions.
-std::vector<ExecutionPathView> FlattenExpressionTable(
-    ProgramBuilder& program_builder, ExecutionPath& main) {
+//
+// The peephole optimizers are applied to each subexpression before it is
+// added, since jumps never cross subexpressions.
+absl::StatusOr<std::vector<ExecutionPathView>> FlattenExpressionTable(
+    ProgramBuilder& program_builder, PlannerContext& context,
+    absl::Span<const std::unique_ptr<PeepholeOptimizer>> peephole_optimizers,
+    ExecutionPath& main) {
   std::vector<std::pair<size_t, size_t>> ranges;
-  main = program_builder.FlattenMain();
+  CEL_ASSIGN_OR_RETURN(main,
+                       ApplyPeepholeOptimizers(context, peephole_optimizers,
+                                               program_builder.FlattenMain()));
   ranges.push_back(std::make_pair(0, main.size()));
 
   std::vector<ExecutionPath> subexpressions =
       program_builder.FlattenSubexpressions();
   for (auto& subexpression : subexpressions) {
+    CEL_ASSIGN_OR_RETURN(subexpression,
+                         ApplyPeepholeOptimizers(context, peephole_optimizers,
+                                                 std::move(subexpression)));
     ranges.push_back(std::make_pair(main.size(), subexpression.size()));
     absl::c_move(subexpression, std::back_inserter(main));
   }
@@ -1931,8 +2654,88 @@ std::vector<ExecutionPathView> FlattenExpressionTable(
 
 }  // namespace
 
+std::shared_ptr<const ContainerNames> FlatExprBuilder::ComputeContainerNames()
+    const {
+  return ::google::api::expr::runtime::ComputeContainerNames(
+      container_, type_registry_.resolveable_enums());
+}
+
 absl::StatusOr<FlatExpression> FlatExprBuilder::CreateExpressionImpl(
     std::unique_ptr<Ast> ast, std::vector<RuntimeIssue>* issues) const {
+  return CreateExpressionImpl(std::move(ast), issues, ComputeContainerNames());
+}
+
+absl::StatusOr<FlatExpression> FlatExprBuilder::CreateExpressionImpl(
+    std::unique_ptr<Ast> ast, std::vector<RuntimeIssue>* issues,
+    std::shared_ptr<const ContainerNames> container_names) const {
+  return CreateExpressionWithExtensions(std::move(ast), issues,
+                                        std::move(container_names),
+                                        PlanningExtensions());
+}
+
+absl::StatusOr<FlatExpression> FlatExprBuilder::CreateRuleSetExpressionImpl(
+    std::vector<std::unique_ptr<Ast>> rules,
+    std::vector<RuntimeIssue>* issues) const {
+  CEL_ASSIGN_OR_RETURN(std::unique_ptr<Ast> ast,
+                       CombineRuleSet(std::move(rules)));
+  std::unique_ptr<AstTransform> cse =
+      NewCommonSubexpressionEliminationExtension();
+  PlanningExtensions extensions;
+  extensions.transform = cse.get();
+  return CreateExpressionWithExtensions(std::move(ast), issues,
+                                        ComputeContainerNames(), extensions);
+}
+
+absl::StatusOr<FlatExpression> FlatExprBuilder::CreateIncrementalExpressionImpl(
+    std::unique_ptr<Ast> ast, std::vector<RuntimeIssue>* issues,
+    std::shared_ptr<IncrementalDependencies> dependencies) const {
+  ProgramOptimizerFactory optimizer =
+      CreateIncrementalEvaluationExtension(std::move(dependencies));
+  PlanningExtensions extensions;
+  extensions.optimizer = &optimizer;
+  extensions.force_recursive = true;
+  return CreateExpressionWithExtensions(std::move(ast), issues,
+                                        ComputeContainerNames(), extensions);
+}
+
+absl::StatusOr<FlatExpression>
+FlatExprBuilder::CreateBranchProfilingExpressionImpl(
+    std::unique_ptr<Ast> ast, std::vector<RuntimeIssue>* issues,
+    std::shared_ptr<BranchProfile> profile) const {
+  ProgramOptimizerFactory optimizer =
+      CreateBranchProfilingExtension(std::move(profile));
+  PlanningExtensions extensions;
+  extensions.optimizer = &optimizer;
+  return CreateExpressionWithExtensions(std::move(ast), issues,
+                                        ComputeContainerNames(), extensions);
+}
+
+absl::StatusOr<FlatExpression>
+FlatExprBuilder::CreateProfileGuidedExpressionImpl(
+    std::unique_ptr<Ast> ast, std::vector<RuntimeIssue>* issues,
+    std::shared_ptr<const BranchProfile> profile,
+    int64_t min_evaluations) const {
+  std::unique_ptr<AstTransform> transform =
+      CreateBranchReorderingTransform(std::move(profile), min_evaluations);
+  PlanningExtensions extensions;
+  extensions.transform = transform.get();
+  return CreateExpressionWithExtensions(std::move(ast), issues,
+                                        ComputeContainerNames(), extensions);
+}
+
+std::unique_ptr<cel::common_internal::StringInternPool>
+FlatExprBuilder::MakeSharedStringPool(const cel::RuntimeOptions& options) {
+  if (!options.enable_shared_constant_pool) {
+    return nullptr;
+  }
+  return std::make_unique<cel::common_internal::StringInternPool>(
+      cel::common_internal::StringInternPool::ThreadSafe{});
+}
+
+absl::StatusOr<FlatExpression> FlatExprBuilder::CreateExpressionWithExtensions(
+    std::unique_ptr<Ast> ast, std::vector<RuntimeIssue>* issues,
+    std::shared_ptr<const ContainerNames> container_names,
+    const PlanningExtensions& extensions) const {
   // These objects are expected to remain scoped to one build call -- references
   // to them shouldn't be persisted in any part of the result expression.
   cel::common_internal::LegacyValueManager value_factory(
@@ -1943,14 +2746,10 @@ absl::StatusOr<FlatExpression> FlatExprBuilder::CreateExpressionImpl(
                                             ? RuntimeIssue::Severity::kWarning
                                             : RuntimeIssue::Severity::kError;
   IssueCollector issue_collector(max_severity);
-  Resolver resolver(container_, function_registry_, type_registry_,
-                    value_factory, type_registry_.resolveable_enums(),
+  Resolver resolver(std::move(container_names), function_registry_,
+                    type_registry_, value_factory,
                     options_.enable_qualified_type_identifiers);
 
-  ProgramBuilder program_builder;
-  PlannerContext extension_context(resolver, options_, value_factory,
-                                   issue_collector, program_builder);
-
   auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
 
   if (absl::StartsWith(container_, ".") || absl::EndsWith(container_, ".")) {
@@ -1958,10 +2757,76 @@ absl::StatusOr<FlatExpression> FlatExprBuilder::CreateExpressionImpl(
         absl::StrCat("Invalid expression container: '", container_, "'"));
   }
 
-  for (const std::unique_ptr<AstTransform>& transform : ast_transforms_) {
-    CEL_RETURN_IF_ERROR(transform->UpdateAst(extension_context, ast_impl));
+  {
+    ProgramBuilder program_builder;
+    PlannerContext extension_context(resolver, options_, value_factory,
+                                     issue_collector, program_builder);
+    for (const std::unique_ptr<AstTransform>& transform : ast_transforms_) {
+      CEL_RETURN_IF_ERROR(transform->UpdateAst(extension_context, ast_impl));
+    }
+    if (extensions.transform != nullptr) {
+      CEL_RETURN_IF_ERROR(
+          extensions.transform->UpdateAst(extension_context, ast_impl));
+    }
+  }
+
+  // The program used for plain evaluations is planned without trace steps,
+  // so that it doesn't test for a listener after every recursive step.
+  cel::RuntimeOptions untraced_options = options_;
+  untraced_options.enable_recursive_tracing = false;
+  if (extensions.force_recursive) {
+    untraced_options.max_recursion_depth = -1;
+    untraced_options.enable_adaptive_recursive_planning = false;
+  }
+  CEL_ASSIGN_OR_RETURN(
+      FlatExpression expression,
+      PlanExpression(ast_impl, untraced_options, resolver, value_factory,
+                     issue_collector, extensions.optimizer));
+
+  if (issues != nullptr) {
+    (*issues) = issue_collector.ExtractIssues();
+  }
+
+  // Recursive programs only report to evaluation listeners if traced, so a
+  // traced copy of the program is planned for evaluations with a listener.
+  // Only the planning is paid for when no listener is used.
+  if (options_.enable_recursive_tracing && options_.max_recursion_depth != 0 &&
+      !extensions.force_recursive) {
+    // Issues were reported for the untraced program already.
+    IssueCollector traced_issue_collector(max_severity);
+    CEL_ASSIGN_OR_RETURN(FlatExpression traced_expression,
+                         PlanExpression(ast_impl, options_, resolver,
+                                        value_factory, traced_issue_collector,
+                                        extensions.optimizer));
+    expression.set_traced_expression(
+        std::make_unique<FlatExpression>(std::move(traced_expression)));
   }
 
+  return expression;
+}
+
+absl::StatusOr<FlatExpression> FlatExprBuilder::PlanExpression(
+    AstImpl& ast_impl, const cel::RuntimeOptions& options,
+    const Resolver& resolver, cel::ValueManager& value_factory,
+    IssueCollector& issue_collector,
+    const ProgramOptimizerFactory* final_optimizer) const {
+  // The steps are allocated contiguously in the order they are planned.
+  // Declared first so that the arena outlives the steps dropped during
+  // planning.
+  auto step_arena = std::make_unique<StepArena>();
+  StepArena::Scope step_arena_scope(*step_arena);
+
+  // Shared with the other programs of the builder if configured.
+  cel::common_internal::StringInternPool program_string_pool;
+  cel::common_internal::StringInternPool& string_pool =
+      shared_string_pool_ != nullptr ? *shared_string_pool_
+                                     : program_string_pool;
+
+  ProgramBuilder program_builder;
+  PlannerContext extension_context(resolver, options, value_factory,
+                                   issue_collector, program_builder);
+  extension_context.set_string_pool(&string_pool);
+
   std::vector<std::unique_ptr<ProgramOptimizer>> optimizers;
   for (const ProgramOptimizerFactory& optimizer_factory : program_optimizers_) {
     CEL_ASSIGN_OR_RETURN(auto optimizer,
@@ -1970,31 +2835,55 @@ absl::StatusOr<FlatExpression> FlatExprBuilder::CreateExpressionImpl(
       optimizers.push_back(std::move(optimizer));
     }
   }
+  if (final_optimizer != nullptr) {
+    CEL_ASSIGN_OR_RETURN(auto optimizer,
+                         (*final_optimizer)(extension_context, ast_impl));
+    if (optimizer != nullptr) {
+      optimizers.push_back(std::move(optimizer));
+    }
+  }
+
+  // Owned by the planned expression, the ident steps refer to it.
+  auto variable_layout = std::make_shared<cel::VariableLayout>();
+  auto references = std::make_shared<cel::ProgramReferences>();
 
-  FlatExprVisitor visitor(resolver, options_, std::move(optimizers),
-                          ast_impl.reference_map(), value_factory,
+  FlatExprVisitor visitor(resolver, options, std::move(optimizers),
+                          ast_impl.reference_map(), ast_impl, value_factory,
                           issue_collector, program_builder, extension_context,
+                          *variable_layout, *references, string_pool,
                           enable_optional_types_);
 
   cel::TraversalOptions opts;
   opts.use_comprehension_callbacks = true;
-  AstTraverse(ast_impl.root_expr(), visitor, opts);
+  AstTraverse(cel::FlatAst::Build(ast_impl.root_expr()), visitor, opts);
 
   if (!visitor.progress_status().ok()) {
     return visitor.progress_status();
   }
 
-  if (issues != nullptr) {
-    (*issues) = issue_collector.ExtractIssues();
+  references->variables.insert(variable_layout->names().begin(),
+                               variable_layout->names().end());
+  for (const auto& [expr_id, reference] : ast_impl.reference_map()) {
+    references->overload_ids.insert(reference.overload_id().begin(),
+                                    reference.overload_id().end());
   }
 
   ExecutionPath execution_path;
-  std::vector<ExecutionPathView> subexpressions =
-      FlattenExpressionTable(program_builder, execution_path);
-
-  return FlatExpression(std::move(execution_path), std::move(subexpressions),
-                        visitor.slot_count(),
-                        type_registry_.GetComposedTypeProvider(), options_);
+  CEL_ASSIGN_OR_RETURN(
+      std::vector<ExecutionPathView> subexpressions,
+      FlattenExpressionTable(program_builder, extension_context,
+                             peephole_optimizers_, execution_path));
+
+  FlatExpression expression(
+      std::move(execution_path), std::move(subexpressions),
+      visitor.slot_count(), type_registry_.GetComposedTypeProvider(), options,
+      std::move(variable_layout), std::move(references));
+  // The strings of a shared pool are used by other programs too.
+  if (options.enable_immortal_constants && shared_string_pool_ == nullptr) {
+    expression.set_immortal_constants(program_string_pool.MakeImmortal());
+  }
+  expression.set_step_arena(std::move(step_arena));
+  return std::move(expression);
 }
 
 }  // namespace google::api::expr::runtime
@@ -17,6 +17,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FLAT_EXPR_BUILDER_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FLAT_EXPR_BUILDER_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,10 +25,17 @@
 
 #include "absl/status/statusor.h"
 #include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/internal/string_intern_pool.h"
+#include "eval/compiler/branch_profile.h"
 #include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/peephole_optimizer.h"
+#include "eval/compiler/resolver.h"
 #include "eval/eval/evaluator_core.h"
+#include "eval/eval/incremental_step.h"
 #include "eval/public/cel_type_registry.h"
 #include "runtime/function_registry.h"
+#include "runtime/internal/issue_collector.h"
 #include "runtime/runtime_issue.h"
 #include "runtime/runtime_options.h"
 #include "runtime/type_registry.h"
@@ -44,7 +52,8 @@ class FlatExprBuilder {
       : options_(options),
         container_(options.container),
         function_registry_(function_registry),
-        type_registry_(type_registry.InternalGetModernRegistry()) {}
+        type_registry_(type_registry.InternalGetModernRegistry()),
+        shared_string_pool_(MakeSharedStringPool(options)) {}
 
   FlatExprBuilder(const cel::FunctionRegistry& function_registry,
                   const cel::TypeRegistry& type_registry,
@@ -52,7 +61,8 @@ class FlatExprBuilder {
       : options_(options),
         container_(options.container),
         function_registry_(function_registry),
-        type_registry_(type_registry) {}
+        type_registry_(type_registry),
+        shared_string_pool_(MakeSharedStringPool(options)) {}
 
   // Create a flat expr builder with defaulted options.
   FlatExprBuilder(const cel::FunctionRegistry& function_registry,
@@ -69,6 +79,10 @@ class FlatExprBuilder {
     program_optimizers_.push_back(std::move(optimizer));
   }
 
+  void AddPeepholeOptimizer(std::unique_ptr<PeepholeOptimizer> optimizer) {
+    peephole_optimizers_.push_back(std::move(optimizer));
+  }
+
   void set_container(std::string container) {
     container_ = std::move(container);
   }
@@ -79,6 +93,54 @@ class FlatExprBuilder {
       std::unique_ptr<cel::Ast> ast,
       std::vector<cel::RuntimeIssue>* issues) const;
 
+  // Same as above, resolving names with `container_names` as computed by
+  // ComputeContainerNames, so that they are computed once for all the
+  // expressions built in a batch.
+  absl::StatusOr<FlatExpression> CreateExpressionImpl(
+      std::unique_ptr<cel::Ast> ast, std::vector<cel::RuntimeIssue>* issues,
+      std::shared_ptr<const ContainerNames> container_names) const;
+
+  // Plans `rules` as one expression evaluating to their results, collected
+  // with a rule set step (see eval/eval/rule_set_step.h).
+  //
+  // Attribute accesses shared by the rules are only evaluated once per
+  // evaluation, by applying common subexpression elimination to the combined
+  // rules after the transforms of the builder.
+  absl::StatusOr<FlatExpression> CreateRuleSetExpressionImpl(
+      std::vector<std::unique_ptr<cel::Ast>> rules,
+      std::vector<cel::RuntimeIssue>* issues) const;
+
+  // Plans `ast` as an expression caching the results of its subexpressions
+  // between incremental evaluations (see
+  // eval/compiler/incremental_evaluation.h). The dependencies of the cached
+  // subexpressions are added to `dependencies`.
+  //
+  // The expression is planned recursively, without trace steps, whatever the
+  // options of the builder.
+  absl::StatusOr<FlatExpression> CreateIncrementalExpressionImpl(
+      std::unique_ptr<cel::Ast> ast, std::vector<cel::RuntimeIssue>* issues,
+      std::shared_ptr<IncrementalDependencies> dependencies) const;
+
+  // Plans `ast` instrumented to record the outcomes of its logical operators
+  // in `profile`, which must have been created for `ast` (see
+  // eval/compiler/branch_profile.h).
+  absl::StatusOr<FlatExpression> CreateBranchProfilingExpressionImpl(
+      std::unique_ptr<cel::Ast> ast, std::vector<cel::RuntimeIssue>* issues,
+      std::shared_ptr<BranchProfile> profile) const;
+
+  // Plans `ast`, a copy of an AST profiled in `profile`, with the operands of
+  // its logical operators reordered to short-circuit sooner for the profiled
+  // evaluations.
+  absl::StatusOr<FlatExpression> CreateProfileGuidedExpressionImpl(
+      std::unique_ptr<cel::Ast> ast, std::vector<cel::RuntimeIssue>* issues,
+      std::shared_ptr<const BranchProfile> profile,
+      int64_t min_evaluations) const;
+
+  // Computes the names resolvable within the container of the builder. The
+  // result is immutable and may be shared across threads, but it does not
+  // reflect types registered or container changes made after the call.
+  std::shared_ptr<const ContainerNames> ComputeContainerNames() const;
+
   const cel::RuntimeOptions& options() const { return options_; }
 
   // Called by `cel::extensions::EnableOptionalTypes` to indicate that special
@@ -86,6 +148,34 @@ class FlatExprBuilder {
   void enable_optional_types() { enable_optional_types_ = true; }
 
  private:
+  // Extensions specific to a kind of expression, applied after those of the
+  // builder.
+  struct PlanningExtensions {
+    const AstTransform* transform = nullptr;
+    const ProgramOptimizerFactory* optimizer = nullptr;
+    // If set, the expression is planned recursively and without a traced
+    // copy.
+    bool force_recursive = false;
+  };
+
+  // Implements CreateExpressionImpl, applying `extensions`.
+  absl::StatusOr<FlatExpression> CreateExpressionWithExtensions(
+      std::unique_ptr<cel::Ast> ast, std::vector<cel::RuntimeIssue>* issues,
+      std::shared_ptr<const ContainerNames> container_names,
+      const PlanningExtensions& extensions) const;
+
+  // Plans the already transformed `ast_impl` with `options`, which may differ
+  // from the options of the builder in whether recursive programs are traced.
+  // `final_optimizer` runs after the optimizers of the builder if not null.
+  absl::StatusOr<FlatExpression> PlanExpression(
+      cel::ast_internal::AstImpl& ast_impl, const cel::RuntimeOptions& options,
+      const Resolver& resolver, cel::ValueManager& value_factory,
+      cel::runtime_internal::IssueCollector& issue_collector,
+      const ProgramOptimizerFactory* final_optimizer) const;
+
+  static std::unique_ptr<cel::common_internal::StringInternPool>
+  MakeSharedStringPool(const cel::RuntimeOptions& options);
+
   cel::RuntimeOptions options_;
   std::string container_;
   bool enable_optional_types_ = false;
@@ -95,6 +185,10 @@ class FlatExprBuilder {
   const cel::TypeRegistry& type_registry_;
   std::vector<std::unique_ptr<AstTransform>> ast_transforms_;
   std::vector<ProgramOptimizerFactory> program_optimizers_;
+  std::vector<std::unique_ptr<PeepholeOptimizer>> peephole_optimizers_;
+  // Interns the string constants of every program planned by the builder, if
+  // enabled by `RuntimeOptions::enable_shared_constant_pool`.
+  std::unique_ptr<cel::common_internal::StringInternPool> shared_string_pool_;
 };
 
 }  // namespace google::api::expr::runtime
@@ -20,6 +20,7 @@
 #include "google/protobuf/field_mask.pb.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "eval/compiler/cel_expression_builder_flat_impl.h"
 #include "eval/compiler/comprehension_vulnerability_check.h"
 #include "eval/compiler/flat_expr_builder.h"
@@ -103,6 +104,39 @@ TEST_P(CelExpressionBuilderFlatImplComprehensionsTest, MapComp) {
               test::EqualsCelValue(CelValue::CreateInt64(4)));
 }
 
+TEST_P(CelExpressionBuilderFlatImplComprehensionsTest,
+       MapFilterAppendInPlaceByDefault) {
+  cel::RuntimeOptions options = GetRuntimeOptions();
+  options.enable_comprehension_list_append = false;
+  CelExpressionBuilderFlatImpl builder(options);
+  ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+
+  ASSERT_OK_AND_ASSIGN(
+      auto parsed_expr,
+      parser::Parse("[1, 2, 3].map(x, x * 2).filter(x, x > 2) == [4, 6]"));
+  ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+  Activation activation;
+  google::protobuf::Arena arena;
+  ASSERT_OK_AND_ASSIGN(CelValue result, cel_expr->Evaluate(activation, &arena));
+  EXPECT_THAT(result, test::IsCelBool(true));
+
+  // The accumulator is observed by the loop step, so it must not be mutated.
+  ASSERT_OK_AND_ASSIGN(parsed_expr,
+                       parser::Parse("[1, 2].map(x, __result__)"));
+  ASSERT_OK_AND_ASSIGN(cel_expr,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+  ASSERT_OK_AND_ASSIGN(result, cel_expr->Evaluate(activation, &arena));
+  ASSERT_TRUE(result.IsList());
+  ASSERT_THAT(*result.ListOrDie(), testing::SizeIs(2));
+  ASSERT_TRUE((*result.ListOrDie())[0].IsList());
+  EXPECT_THAT(*(*result.ListOrDie())[0].ListOrDie(), testing::SizeIs(0));
+  ASSERT_TRUE((*result.ListOrDie())[1].IsList());
+  EXPECT_THAT(*(*result.ListOrDie())[1].ListOrDie(), testing::SizeIs(1));
+}
+
 TEST_P(CelExpressionBuilderFlatImplComprehensionsTest, ExistsOneTrue) {
   cel::RuntimeOptions options = GetRuntimeOptions();
   CelExpressionBuilderFlatImpl builder(options);
@@ -137,6 +171,135 @@ TEST_P(CelExpressionBuilderFlatImplComprehensionsTest, ExistsOneFalse) {
   EXPECT_THAT(result, test::IsCelBool(false));
 }
 
+TEST_P(CelExpressionBuilderFlatImplComprehensionsTest,
+       ExistsOneErrorAfterSecondMatch) {
+  cel::RuntimeOptions options = GetRuntimeOptions();
+  CelExpressionBuilderFlatImpl builder(options);
+  ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+
+  ASSERT_OK_AND_ASSIGN(auto parsed_expr,
+                       parser::Parse("[1, 1, 0].exists_one(x, 1 / x == 1)"));
+  ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+  Activation activation;
+  google::protobuf::Arena arena;
+  ASSERT_OK_AND_ASSIGN(CelValue result, cel_expr->Evaluate(activation, &arena));
+  // The error of the last element is the result, even though the result was
+  // already known not to be true.
+  EXPECT_THAT(result, test::IsCelError(StatusIs(
+                          absl::StatusCode::kInvalidArgument,
+                          HasSubstr("divide by zero"))));
+
+  // Errors until the second match are preserved.
+  ASSERT_OK_AND_ASSIGN(parsed_expr,
+                       parser::Parse("[0, 1, 1].exists_one(x, 1 / x == 1)"));
+  ASSERT_OK_AND_ASSIGN(cel_expr,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+  ASSERT_OK_AND_ASSIGN(result, cel_expr->Evaluate(activation, &arena));
+  EXPECT_THAT(result, test::IsCelError(StatusIs(
+                          absl::StatusCode::kInvalidArgument,
+                          HasSubstr("divide by zero"))));
+}
+
+TEST_P(CelExpressionBuilderFlatImplComprehensionsTest,
+       ExistsOneVisitsAllElementsWithoutShortCircuiting) {
+  cel::RuntimeOptions options = GetRuntimeOptions();
+  options.short_circuiting = false;
+  CelExpressionBuilderFlatImpl builder(options);
+  ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+
+  ASSERT_OK_AND_ASSIGN(auto parsed_expr,
+                       parser::Parse("[1, 1, 0].exists_one(x, 1 / x == 1)"));
+  ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+  Activation activation;
+  google::protobuf::Arena arena;
+  ASSERT_OK_AND_ASSIGN(CelValue result, cel_expr->Evaluate(activation, &arena));
+  EXPECT_THAT(result, test::IsCelError(StatusIs(
+                          absl::StatusCode::kInvalidArgument,
+                          HasSubstr("divide by zero"))));
+}
+
+TEST_P(CelExpressionBuilderFlatImplComprehensionsTest,
+       ExistsOneMatchesStackMachinePlan) {
+  for (absl::string_view expr : {
+           "[1, 1, 0].exists_one(x, 1 / x == 1)",
+           "[1, 0, 1].exists_one(x, 1 / x == 1)",
+           "[0, 1, 1].exists_one(x, 1 / x == 1)",
+           "[1, 2, 1].exists_one(x, 1 / x == 1)",
+           "[1, 1, 1].exists_one(x, x == 1)",
+           "[2, 1, 2].exists_one(x, x == 1)",
+           "[1, 1, 'a'].exists_one(x, x > 0)",
+       }) {
+    ASSERT_OK_AND_ASSIGN(auto parsed_expr, parser::Parse(expr));
+    std::vector<CelValue> results;
+    google::protobuf::Arena arena;
+    for (int max_recursion_depth : {0, -1}) {
+      cel::RuntimeOptions options = GetRuntimeOptions();
+      options.max_recursion_depth = max_recursion_depth;
+      CelExpressionBuilderFlatImpl builder(options);
+      ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+      ASSERT_OK_AND_ASSIGN(
+          auto cel_expr, builder.CreateExpression(&parsed_expr.expr(),
+                                                  &parsed_expr.source_info()));
+      Activation activation;
+      ASSERT_OK_AND_ASSIGN(CelValue result,
+                           cel_expr->Evaluate(activation, &arena));
+      results.push_back(result);
+    }
+    if (results[0].IsError()) {
+      EXPECT_THAT(results[1], test::IsCelError(*results[0].ErrorOrDie()))
+          << expr;
+    } else {
+      EXPECT_THAT(results[1], test::EqualsCelValue(results[0])) << expr;
+    }
+  }
+}
+
+TEST_P(CelExpressionBuilderFlatImplComprehensionsTest,
+       AllExistsErrorSemantics) {
+  for (bool short_circuiting : {true, false}) {
+    cel::RuntimeOptions options = GetRuntimeOptions();
+    options.short_circuiting = short_circuiting;
+    CelExpressionBuilderFlatImpl builder(options);
+    ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+    Activation activation;
+    google::protobuf::Arena arena;
+
+    struct Case {
+      absl::string_view expr;
+      absl::optional<bool> result;
+    };
+    for (const Case& test_case : std::vector<Case>{
+             {"[0, 1].exists(x, 1 / x == 1)", true},
+             {"[1, 0].exists(x, 1 / x == 1)", true},
+             {"[0, 2].exists(x, 1 / x == 1)", absl::nullopt},
+             {"[0, 2].all(x, 1 / x == 1)", false},
+             {"[2, 0].all(x, 1 / x == 1)", false},
+             {"[0, 1].all(x, 1 / x == 1)", absl::nullopt},
+         }) {
+      ASSERT_OK_AND_ASSIGN(auto parsed_expr, parser::Parse(test_case.expr));
+      ASSERT_OK_AND_ASSIGN(
+          auto cel_expr, builder.CreateExpression(&parsed_expr.expr(),
+                                                  &parsed_expr.source_info()));
+      ASSERT_OK_AND_ASSIGN(CelValue result,
+                           cel_expr->Evaluate(activation, &arena));
+      if (test_case.result.has_value()) {
+        EXPECT_THAT(result, test::IsCelBool(*test_case.result))
+            << test_case.expr;
+      } else {
+        EXPECT_THAT(result, test::IsCelError(StatusIs(
+                                absl::StatusCode::kInvalidArgument,
+                                HasSubstr("divide by zero"))))
+            << test_case.expr;
+      }
+    }
+  }
+}
+
 TEST_P(CelExpressionBuilderFlatImplComprehensionsTest, ListCompWithUnknowns) {
   cel::RuntimeOptions options = GetRuntimeOptions();
   options.unknown_processing = UnknownProcessingOptions::kAttributeAndFunction;
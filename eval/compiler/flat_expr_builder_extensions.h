@@ -38,6 +38,7 @@
 #include "base/ast.h"
 #include "base/ast_internal/ast_impl.h"
 #include "base/ast_internal/expr.h"
+#include "common/internal/string_intern_pool.h"
 #include "common/native_type.h"
 #include "common/value.h"
 #include "common/value_manager.h"
@@ -380,12 +381,25 @@ class PlannerContext {
     return issue_collector_;
   }
 
+  // The pool the string constants of the program are interned in, so that
+  // extensions creating constants can share them. May be null.
+  absl::Nullable<cel::common_internal::StringInternPool*> string_pool() const {
+    return string_pool_;
+  }
+
+  void set_string_pool(
+      absl::Nullable<cel::common_internal::StringInternPool*> string_pool) {
+    string_pool_ = string_pool;
+  }
+
  private:
   const Resolver& resolver_;
   cel::ValueManager& value_factory_;
   const cel::RuntimeOptions& options_;
   cel::runtime_internal::IssueCollector& issue_collector_;
   ProgramBuilder& program_builder_;
+  absl::Nullable<cel::common_internal::StringInternPool*> string_pool_ =
+      nullptr;
 };
 
 // Interface for Ast Transforms.
@@ -21,6 +21,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -32,6 +33,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -50,6 +52,7 @@
 #include "eval/public/cel_function_registry.h"
 #include "eval/public/cel_options.h"
 #include "eval/public/cel_value.h"
+#include "eval/public/containers/container_backed_list_impl.h"
 #include "eval/public/containers/container_backed_map_impl.h"
 #include "eval/public/portable_cel_function_adapter.h"
 #include "eval/public/structs/cel_proto_descriptor_pool_builder.h"
@@ -1378,6 +1381,78 @@ TEST(FlatExprBuilderTest, ComprehensionBudget) {
                        HasSubstr("Iteration budget exceeded")));
 }
 
+TEST(FlatExprBuilderTest, MemoryBudget) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
+                       parser::Parse("[1, 2, 3].map(x, [x, x, x])"));
+
+  for (int max_recursion_depth : {0, -1}) {
+    cel::RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    options.max_evaluation_bytes = 64;
+    CelExpressionBuilderFlatImpl builder(options);
+    ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+    ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                         builder.CreateExpression(&parsed_expr.expr(),
+                                                  &parsed_expr.source_info()));
+
+    Activation activation;
+    google::protobuf::Arena arena;
+    EXPECT_THAT(cel_expr->Evaluate(activation, &arena).status(),
+                StatusIs(absl::StatusCode::kResourceExhausted,
+                         HasSubstr("Memory budget exceeded")));
+
+    options.max_evaluation_bytes = 1 << 20;
+    CelExpressionBuilderFlatImpl relaxed_builder(options);
+    ASSERT_OK(RegisterBuiltinFunctions(relaxed_builder.GetRegistry()));
+    ASSERT_OK_AND_ASSIGN(
+        cel_expr, relaxed_builder.CreateExpression(&parsed_expr.expr(),
+                                                   &parsed_expr.source_info()));
+    ASSERT_OK_AND_ASSIGN(CelValue result,
+                         cel_expr->Evaluate(activation, &arena));
+    ASSERT_TRUE(result.IsList());
+    EXPECT_EQ(result.ListOrDie()->size(), 3);
+  }
+}
+
+TEST(FlatExprBuilderTest, MemoryBudgetListConcatenation) {
+  // Past kMaxConcatListParts operands the concatenation is flattened into new
+  // lists, whose elements have to count against the budget.
+  std::vector<CelValue> elements(100, CelValue::CreateInt64(1));
+  ContainerBackedListImpl list(elements);
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr parsed_expr,
+      parser::Parse(absl::StrJoin(std::vector<std::string>(40, "l"), " + ")));
+
+  for (int max_recursion_depth : {0, -1}) {
+    cel::RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    options.max_evaluation_bytes = 4096;
+    CelExpressionBuilderFlatImpl builder(options);
+    ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+    ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                         builder.CreateExpression(&parsed_expr.expr(),
+                                                  &parsed_expr.source_info()));
+
+    Activation activation;
+    activation.InsertValue("l", CelValue::CreateList(&list));
+    google::protobuf::Arena arena;
+    EXPECT_THAT(cel_expr->Evaluate(activation, &arena).status(),
+                StatusIs(absl::StatusCode::kResourceExhausted,
+                         HasSubstr("Memory budget exceeded")));
+
+    options.max_evaluation_bytes = 1 << 24;
+    CelExpressionBuilderFlatImpl relaxed_builder(options);
+    ASSERT_OK(RegisterBuiltinFunctions(relaxed_builder.GetRegistry()));
+    ASSERT_OK_AND_ASSIGN(
+        cel_expr, relaxed_builder.CreateExpression(&parsed_expr.expr(),
+                                                   &parsed_expr.source_info()));
+    ASSERT_OK_AND_ASSIGN(CelValue result,
+                         cel_expr->Evaluate(activation, &arena));
+    ASSERT_TRUE(result.IsList());
+    EXPECT_EQ(result.ListOrDie()->size(), 4000);
+  }
+}
+
 TEST(FlatExprBuilderTest, SimpleEnumTest) {
   TestMessage message;
   Expr expr;
@@ -1430,6 +1505,38 @@ TEST(FlatExprBuilderTest, SimpleEnumIdentTest) {
   EXPECT_THAT(result.Int64OrDie(), Eq(TestMessage::TEST_ENUM_1));
 }
 
+TEST(FlatExprBuilderTest, ClosedActivationSchemaEnum) {
+  constexpr char kEnumName[] =
+      "google.api.expr.runtime.TestMessage.TestEnum.TEST_ENUM_1";
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(kEnumName));
+  google::protobuf::Arena arena;
+  Activation activation;
+  activation.InsertValue(kEnumName, CelValue::CreateInt64(42));
+
+  for (int max_recursion_depth : {0, -1}) {
+    cel::RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    CelExpressionBuilderFlatImpl builder(options);
+    builder.GetTypeRegistry()->Register(TestMessage::TestEnum_descriptor());
+    ASSERT_OK_AND_ASSIGN(auto shadowable,
+                         builder.CreateExpression(&parsed_expr.expr(),
+                                                  &parsed_expr.source_info()));
+    ASSERT_OK_AND_ASSIGN(CelValue result,
+                         shadowable->Evaluate(activation, &arena));
+    EXPECT_THAT(result, test::IsCelInt64(42));
+
+    options.enable_closed_activation_schema = true;
+    CelExpressionBuilderFlatImpl closed_builder(options);
+    closed_builder.GetTypeRegistry()->Register(
+        TestMessage::TestEnum_descriptor());
+    ASSERT_OK_AND_ASSIGN(
+        auto constant, closed_builder.CreateExpression(
+                           &parsed_expr.expr(), &parsed_expr.source_info()));
+    ASSERT_OK_AND_ASSIGN(result, constant->Evaluate(activation, &arena));
+    EXPECT_THAT(result, test::IsCelInt64(TestMessage::TEST_ENUM_1));
+  }
+}
+
 TEST(FlatExprBuilderTest, ContainerStringFormat) {
   Expr expr;
   SourceInfo source_info;
@@ -2053,6 +2160,56 @@ TEST(FlatExprBuilderTest, HeterogeneousEqualityDisabled) {
                                         HasSubstr("Invalid map key type"))));
 }
 
+TEST(FlatExprBuilderTest, ImmortalConstants) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
+                       parser::Parse("{'foo': 'bar', 'baz': 'foo'}['foo']"));
+  cel::RuntimeOptions options;
+  options.enable_immortal_constants = true;
+  CelExpressionBuilderFlatImpl builder(options);
+  ASSERT_OK_AND_ASSIGN(auto expression,
+                       builder.CreateExpression(&parsed_expr.expr(),
+                                                &parsed_expr.source_info()));
+
+  auto evaluate = [&expression]() {
+    for (int i = 0; i < 100; ++i) {
+      Activation activation;
+      google::protobuf::Arena arena;
+      ASSERT_OK_AND_ASSIGN(CelValue result,
+                           expression->Evaluate(activation, &arena));
+      EXPECT_THAT(result, test::IsCelString("bar"));
+    }
+  };
+  std::thread thread(evaluate);
+  evaluate();
+  thread.join();
+}
+
+TEST(FlatExprBuilderTest, SharedConstantPool) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
+                       parser::Parse("{'foo': 'bar', 'baz': 'foo'}['foo']"));
+  cel::RuntimeOptions options;
+  options.enable_shared_constant_pool = true;
+  options.enable_immortal_constants = true;
+  CelExpressionBuilderFlatImpl builder(options);
+
+  // Programs are planned concurrently, and outlive each other.
+  auto plan_and_evaluate = [&]() {
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_OK_AND_ASSIGN(
+          auto expression, builder.CreateExpression(
+                               &parsed_expr.expr(), &parsed_expr.source_info()));
+      Activation activation;
+      google::protobuf::Arena arena;
+      ASSERT_OK_AND_ASSIGN(CelValue result,
+                           expression->Evaluate(activation, &arena));
+      EXPECT_THAT(result, test::IsCelString("bar"));
+    }
+  };
+  std::thread thread(plan_and_evaluate);
+  plan_and_evaluate();
+  thread.join();
+}
+
 TEST(FlatExprBuilderTest, CustomDescriptorPoolForCreateStruct) {
   ASSERT_OK_AND_ASSIGN(
       ParsedExpr parsed_expr,
@@ -2337,6 +2494,16 @@ INSTANTIATE_TEST_SUITE_P(
         {"create_struct", "{'abc': 'def', 'def': 'efg', 'efg': 'hij'}",
          Truly([](const CelValue& v) { return v.IsMap(); })},
         {"field_selection", "{'abc': 123}.abc == 123", test::IsCelBool(true)},
+        {"const_message",
+         "google.api.expr.runtime.TestMessage{string_value: 'abc'}",
+         test::IsCelMessage(_)},
+        {"const_message_field_selection",
+         "google.api.expr.runtime.TestMessage{int64_value: 3}.int64_value == 3",
+         test::IsCelBool(true)},
+        {"mixed_const_message",
+         "google.api.expr.runtime.TestMessage{int64_value: id}.int64_value",
+         test::IsCelInt64(4),
+         {{"id", 4}}},
         {"type_coverage",
          // coverage for constant literals, type() is used to make the list
          // homogenous.
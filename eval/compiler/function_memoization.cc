@@ -0,0 +1,111 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/function_memoization.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/kind.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/function_memoizer.h"
+#include "eval/eval/function_step.h"
+#include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Call;
+using ::cel::ast_internal::Expr;
+
+class FunctionMemoizationOptimization : public ProgramOptimizer {
+ public:
+  explicit FunctionMemoizationOptimization(
+      std::shared_ptr<const FunctionMemoizer> memoizer)
+      : memoizer_(std::move(memoizer)) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (!node.has_call_expr()) {
+      return absl::OkStatus();
+    }
+    const Call& call = node.call_expr();
+    size_t num_args = call.args().size() + (call.has_target() ? 1 : 0);
+    std::vector<cel::FunctionOverloadReference> overloads =
+        context.resolver().FindOverloads(
+            call.function(), call.has_target(),
+            std::vector<cel::Kind>(num_args, cel::Kind::kAny), node.id());
+    if (absl::c_none_of(overloads,
+                        [](const cel::FunctionOverloadReference& overload) {
+                          return overload.descriptor.is_pure();
+                        })) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    if (subexpression->IsRecursive()) {
+      auto program = subexpression->ExtractRecursiveProgram();
+      subexpression->set_recursive_program(
+          MemoizeDirectFunctionStep(std::move(program.step), memoizer_),
+          program.depth);
+      return absl::OkStatus();
+    }
+
+    ExecutionPathView plan = context.GetSubplan(node);
+    if (plan.empty() || plan.back()->id() != node.id()) {
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan, context.ExtractSubplan(node));
+    new_plan.back() =
+        MemoizeFunctionStep(std::move(new_plan.back()), memoizer_);
+    return context.ReplaceSubplan(node, std::move(new_plan));
+  }
+
+ private:
+  std::shared_ptr<const FunctionMemoizer> memoizer_;
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateFunctionMemoizationExtension(
+    size_t cache_capacity, std::shared_ptr<FunctionMemoizationStats> stats) {
+  return [cache_capacity, stats = std::move(stats)](
+             PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<FunctionMemoizationOptimization>(
+        std::make_shared<const FunctionMemoizer>(cache_capacity, stats));
+  };
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FUNCTION_MEMOIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FUNCTION_MEMOIZATION_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/function_memoizer.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that memoizes calls to pure
+// functions (see cel::FunctionDescriptor::is_pure).
+//
+// Each planned program gets its own FunctionMemoizer, caching up to
+// `cache_capacity` results between evaluations. Hits and misses are counted
+// in `stats`, if set, which may be shared between programs.
+//
+// Calls are only memoized if they resolve to eagerly bound overloads. If
+// function specialization is enabled, it should be added first.
+ProgramOptimizerFactory CreateFunctionMemoizationExtension(
+    size_t cache_capacity,
+    std::shared_ptr<FunctionMemoizationStats> stats = nullptr);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FUNCTION_MEMOIZATION_H_
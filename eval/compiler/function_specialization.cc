@@ -0,0 +1,227 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/function_specialization.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/function.h"
+#include "base/kind.h"
+#include "common/native_type.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/compiler_constant_step.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/function_step.h"
+#include "internal/casts.h"
+#include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::NativeTypeId;
+using ::cel::Value;
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Call;
+using ::cel::ast_internal::Expr;
+using ::cel::internal::down_cast;
+
+// The arguments of a call, including its target.
+std::vector<const Expr*> CallArguments(const Call& call) {
+  std::vector<const Expr*> args;
+  args.reserve(call.args().size() + (call.has_target() ? 1 : 0));
+  if (call.has_target()) {
+    args.push_back(&call.target());
+  }
+  for (const Expr& arg : call.args()) {
+    args.push_back(&arg);
+  }
+  return args;
+}
+
+class FunctionSpecializationOptimization : public ProgramOptimizer {
+ public:
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (!node.has_call_expr()) {
+      return absl::OkStatus();
+    }
+    const Call& call = node.call_expr();
+    std::vector<const Expr*> args = CallArguments(call);
+    if (args.empty()) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    std::vector<absl::optional<Value>> constant_args =
+        GetConstantArguments(context, *subexpression, args);
+    bool has_constant = false;
+    std::vector<cel::Kind> kinds;
+    kinds.reserve(constant_args.size());
+    for (const auto& constant : constant_args) {
+      has_constant |= constant.has_value();
+      kinds.push_back(constant.has_value()
+                          ? cel::ValueKindToKind(constant->kind())
+                          : cel::Kind::kAny);
+    }
+    if (!has_constant) {
+      return absl::OkStatus();
+    }
+
+    // Lazy overloads are resolved at evaluation time, and shadow the eager
+    // ones.
+    const Resolver& resolver = context.resolver();
+    if (!resolver
+             .FindLazyOverloads(call.function(), call.has_target(),
+                                std::vector<cel::Kind>(args.size(),
+                                                       cel::Kind::kAny),
+                                node.id())
+             .empty()) {
+      return absl::OkStatus();
+    }
+    std::vector<cel::FunctionOverloadReference> overloads =
+        resolver.FindOverloads(call.function(), call.has_target(), kinds,
+                               node.id());
+    if (overloads.size() != 1) {
+      return absl::OkStatus();
+    }
+    const cel::FunctionOverloadReference& overload = overloads.front();
+    CEL_ASSIGN_OR_RETURN(std::unique_ptr<cel::Function> specialized,
+                         overload.implementation.Specialize(
+                             context.value_factory(), constant_args));
+    if (specialized == nullptr) {
+      return absl::OkStatus();
+    }
+
+    if (subexpression->IsRecursive()) {
+      return RewriteRecursivePlan(*subexpression, node, args.size(),
+                                  overload.descriptor, std::move(specialized));
+    }
+    return RewriteStackMachinePlan(context, node, overload.descriptor,
+                                   std::move(specialized));
+  }
+
+ private:
+  static std::vector<absl::optional<Value>> GetConstantArguments(
+      PlannerContext& context, ProgramBuilder::Subexpression& subexpression,
+      absl::Span<const Expr* const> args) {
+    std::vector<absl::optional<Value>> constant_args(args.size());
+    if (subexpression.IsRecursive()) {
+      auto deps = subexpression.recursive_program().step->GetDependencies();
+      if (!deps.has_value() || deps->size() != args.size()) {
+        return constant_args;
+      }
+      for (size_t i = 0; i < args.size(); ++i) {
+        const auto* constant =
+            TryDowncastDirectStep<DirectCompilerConstantStep>((*deps)[i]);
+        if (constant != nullptr) {
+          constant_args[i] = constant->value();
+        }
+      }
+      return constant_args;
+    }
+    for (size_t i = 0; i < args.size(); ++i) {
+      ExecutionPathView plan = context.GetSubplan(*args[i]);
+      if (plan.size() == 1 && plan[0]->GetNativeTypeId() ==
+                                  NativeTypeId::For<CompilerConstantStep>()) {
+        constant_args[i] =
+            down_cast<const CompilerConstantStep*>(plan[0].get())->value();
+      }
+    }
+    return constant_args;
+  }
+
+  static absl::Status RewriteRecursivePlan(
+      ProgramBuilder::Subexpression& subexpression, const Expr& node,
+      size_t num_args, const cel::FunctionDescriptor& descriptor,
+      std::unique_ptr<cel::Function> specialized) {
+    auto program = subexpression.ExtractRecursiveProgram();
+    if (program.step->expr_id() != node.id() ||
+        TryDowncastDirectStep<DirectCompilerConstantStep>(program.step.get()) !=
+            nullptr) {
+      // Possibly already modified, put the plan back.
+      subexpression.set_recursive_program(std::move(program.step),
+                                          program.depth);
+      return absl::OkStatus();
+    }
+    auto deps = program.step->ExtractDependencies();
+    if (!deps.has_value() || deps->size() != num_args) {
+      if (deps.has_value()) {
+        return absl::InternalError(
+            "unexpected dependencies extracted from function step");
+      }
+      subexpression.set_recursive_program(std::move(program.step),
+                                          program.depth);
+      return absl::OkStatus();
+    }
+    subexpression.set_recursive_program(
+        CreateDirectFunctionStep(node.id(), node.call_expr(), *std::move(deps),
+                                 descriptor, std::move(specialized)),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+  static absl::Status RewriteStackMachinePlan(
+      PlannerContext& context, const Expr& node,
+      const cel::FunctionDescriptor& descriptor,
+      std::unique_ptr<cel::Function> specialized) {
+    ExecutionPathView plan = context.GetSubplan(node);
+    if (plan.empty() || plan.back()->id() != node.id() ||
+        plan.back()->GetNativeTypeId() ==
+            NativeTypeId::For<CompilerConstantStep>()) {
+      // Already modified, nothing to do.
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan, context.ExtractSubplan(node));
+    new_plan.pop_back();
+    CEL_ASSIGN_OR_RETURN(new_plan.emplace_back(),
+                         CreateFunctionStep(node.call_expr(), node.id(),
+                                            descriptor,
+                                            std::move(specialized)));
+    return context.ReplaceSubplan(node, std::move(new_plan));
+  }
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateFunctionSpecializationExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<FunctionSpecializationOptimization>();
+  };
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,34 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FUNCTION_SPECIALIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FUNCTION_SPECIALIZATION_H_
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that specializes calls with
+// constant arguments.
+//
+// For each call with at least one constant argument (a literal, or a
+// subexpression folded into a constant) which resolves to a single eagerly
+// bound overload, the overload's cel::Function::Specialize is invoked with
+// the constant arguments. If it returns a specialization, the function step
+// of the call is replaced with one invoking the specialization instead.
+ProgramOptimizerFactory CreateFunctionSpecializationExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_FUNCTION_SPECIALIZATION_H_
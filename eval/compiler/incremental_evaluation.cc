@@ -0,0 +1,210 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/incremental_evaluation.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/incremental_step.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+
+// Computes the attribute paths the subexpressions of an AST depend on.
+class DependencyAnalysis {
+ public:
+  // Returns the dependencies of the subexpressions worth caching, by id.
+  static absl::flat_hash_map<int64_t, std::vector<std::string>> Run(
+      const Expr& root) {
+    DependencyAnalysis analysis;
+    analysis.Analyze(root, /*is_select_operand=*/false);
+    return std::move(analysis.cached_);
+  }
+
+ private:
+  struct Result {
+    // The path read by a variable followed by field selections.
+    absl::optional<std::string> path;
+    // The paths read by the subexpression.
+    absl::flat_hash_set<std::string> paths;
+    // The comprehension variables of enclosing comprehensions referenced by
+    // the subexpression.
+    absl::flat_hash_set<std::string> locals;
+  };
+
+  void Merge(Result child, Result& result) {
+    if (child.path.has_value()) {
+      result.paths.insert(*std::move(child.path));
+    }
+    result.paths.merge(child.paths);
+    result.locals.merge(child.locals);
+  }
+
+  void MergeChild(const Expr& expr, Result& result) {
+    Merge(Analyze(expr, /*is_select_operand=*/false), result);
+  }
+
+  // Merges the result of a subexpression of a comprehension in which `vars`
+  // are bound.
+  void MergeScoped(const Expr& expr, const std::vector<std::string>& vars,
+                   Result& result) {
+    scope_.insert(scope_.end(), vars.begin(), vars.end());
+    Result child = Analyze(expr, /*is_select_operand=*/false);
+    scope_.resize(scope_.size() - vars.size());
+    for (const std::string& var : vars) {
+      child.locals.erase(var);
+    }
+    Merge(std::move(child), result);
+  }
+
+  bool IsLocal(const std::string& name) const {
+    return std::find(scope_.begin(), scope_.end(), name) != scope_.end();
+  }
+
+  Result Analyze(const Expr& expr, bool is_select_operand) {
+    Result result;
+    if (expr.has_const_expr()) {
+      return result;
+    }
+    if (expr.has_ident_expr()) {
+      const std::string& name = expr.ident_expr().name();
+      if (IsLocal(name)) {
+        result.locals.insert(name);
+      } else {
+        result.path = name;
+      }
+      return result;
+    }
+    if (expr.has_select_expr()) {
+      const auto& select = expr.select_expr();
+      Result operand = Analyze(select.operand(), /*is_select_operand=*/true);
+      if (operand.path.has_value()) {
+        result.path = absl::StrCat(*operand.path, ".", select.field());
+      } else {
+        Merge(std::move(operand), result);
+      }
+    } else if (expr.has_call_expr()) {
+      const auto& call = expr.call_expr();
+      if (call.has_target()) {
+        MergeChild(call.target(), result);
+      }
+      for (const Expr& arg : call.args()) {
+        MergeChild(arg, result);
+      }
+    } else if (expr.has_list_expr()) {
+      for (const auto& element : expr.list_expr().elements()) {
+        MergeChild(element.expr(), result);
+      }
+    } else if (expr.has_struct_expr()) {
+      for (const auto& field : expr.struct_expr().fields()) {
+        MergeChild(field.value(), result);
+      }
+    } else if (expr.has_map_expr()) {
+      for (const auto& entry : expr.map_expr().entries()) {
+        MergeChild(entry.key(), result);
+        MergeChild(entry.value(), result);
+      }
+    } else if (expr.has_comprehension_expr()) {
+      const auto& comprehension = expr.comprehension_expr();
+      MergeChild(comprehension.iter_range(), result);
+      MergeChild(comprehension.accu_init(), result);
+      std::vector<std::string> vars = {comprehension.iter_var(),
+                                       comprehension.accu_var()};
+      MergeScoped(comprehension.loop_condition(), vars, result);
+      MergeScoped(comprehension.loop_step(), vars, result);
+      MergeScoped(comprehension.result(), vars, result);
+    }
+
+    // Selections within a chain are only cached as part of the whole chain.
+    if (!is_select_operand && result.locals.empty()) {
+      std::vector<std::string> paths(result.paths.begin(),
+                                     result.paths.end());
+      if (result.path.has_value()) {
+        paths.push_back(*result.path);
+      }
+      std::sort(paths.begin(), paths.end());
+      cached_[expr.id()] = std::move(paths);
+    }
+    return result;
+  }
+
+  // The comprehension variables in scope, innermost last.
+  std::vector<std::string> scope_;
+  absl::flat_hash_map<int64_t, std::vector<std::string>> cached_;
+};
+
+class IncrementalEvaluationOptimization : public ProgramOptimizer {
+ public:
+  IncrementalEvaluationOptimization(
+      std::shared_ptr<IncrementalDependencies> dependencies,
+      absl::flat_hash_map<int64_t, std::vector<std::string>> cached)
+      : dependencies_(std::move(dependencies)), cached_(std::move(cached)) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    auto it = cached_.find(node.id());
+    if (it == cached_.end()) {
+      return absl::OkStatus();
+    }
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || !subexpression->IsRecursive()) {
+      return absl::OkStatus();
+    }
+    auto program = subexpression->ExtractRecursiveProgram();
+    size_t slot = dependencies_->Add(std::move(it->second));
+    subexpression->set_recursive_program(
+        CreateDirectIncrementalStep(slot, std::move(program.step), node.id()),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+ private:
+  std::shared_ptr<IncrementalDependencies> dependencies_;
+  absl::flat_hash_map<int64_t, std::vector<std::string>> cached_;
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateIncrementalEvaluationExtension(
+    std::shared_ptr<IncrementalDependencies> dependencies) {
+  return [dependencies = std::move(dependencies)](
+             PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<IncrementalEvaluationOptimization>(
+        dependencies, DependencyAnalysis::Run(ast.root_expr()));
+  };
+}
+
+}  // namespace google::api::expr::runtime
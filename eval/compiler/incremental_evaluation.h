@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_INCREMENTAL_EVALUATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_INCREMENTAL_EVALUATION_H_
+
+#include <memory>
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/incremental_step.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that caches the results of
+// subexpressions between incremental evaluations (see
+// FlatExpression::EvaluateIncrementally).
+//
+// Every subexpression other than constants, variables and the operands of
+// field selections is cached, unless it refers to a comprehension variable,
+// whose value differs between iterations. Subexpressions within a
+// comprehension which don't are evaluated once. The attribute paths each
+// cached subexpression depends on are added to `dependencies`, which tells
+// the results made stale by changes to the variables.
+//
+// Only recursively planned subexpressions are cached. Functions are assumed
+// to be deterministic.
+ProgramOptimizerFactory CreateIncrementalEvaluationExtension(
+    std::shared_ptr<IncrementalDependencies> dependencies);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_INCREMENTAL_EVALUATION_H_
@@ -0,0 +1,192 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/logical_operand_reordering.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "common/ast_rewrite.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+
+// Assumed iteration count for comprehensions.
+constexpr int64_t kComprehensionIterations = 10;
+
+int64_t FunctionCost(const std::string& function,
+                     const FunctionCostTable& function_costs) {
+  auto it = function_costs.find(function);
+  if (it == function_costs.end()) {
+    return kDefaultFunctionCost;
+  }
+  return it->second;
+}
+
+// Computes costs bottom up, memoized by node.
+class CostEstimator {
+ public:
+  explicit CostEstimator(const FunctionCostTable& function_costs)
+      : function_costs_(function_costs) {}
+
+  int64_t Cost(const Expr& expr) {
+    if (auto it = costs_.find(&expr); it != costs_.end()) {
+      return it->second;
+    }
+    int64_t cost = Compute(expr);
+    costs_[&expr] = cost;
+    return cost;
+  }
+
+  // Drop the memoized cost for expr. Used when nodes are swapped in place.
+  void Forget(const Expr& expr) { costs_.erase(&expr); }
+
+ private:
+  int64_t Compute(const Expr& expr) {
+    if (expr.has_const_expr()) {
+      return 0;
+    }
+    if (expr.has_ident_expr()) {
+      return 1;
+    }
+    if (expr.has_select_expr()) {
+      return 1 + Cost(expr.select_expr().operand());
+    }
+    if (expr.has_call_expr()) {
+      const auto& call = expr.call_expr();
+      int64_t cost = FunctionCost(call.function(), function_costs_);
+      if (call.has_target()) {
+        cost += Cost(call.target());
+      }
+      for (const auto& arg : call.args()) {
+        cost += Cost(arg);
+      }
+      return cost;
+    }
+    if (expr.has_list_expr()) {
+      int64_t cost = 1;
+      for (const auto& element : expr.list_expr().elements()) {
+        cost += Cost(element.expr());
+      }
+      return cost;
+    }
+    if (expr.has_struct_expr()) {
+      int64_t cost = 1;
+      for (const auto& field : expr.struct_expr().fields()) {
+        cost += Cost(field.value());
+      }
+      return cost;
+    }
+    if (expr.has_map_expr()) {
+      int64_t cost = 1;
+      for (const auto& entry : expr.map_expr().entries()) {
+        cost += Cost(entry.key()) + Cost(entry.value());
+      }
+      return cost;
+    }
+    if (expr.has_comprehension_expr()) {
+      const auto& comprehension = expr.comprehension_expr();
+      return Cost(comprehension.iter_range()) +
+             Cost(comprehension.accu_init()) +
+             kComprehensionIterations *
+                 (Cost(comprehension.loop_condition()) +
+                  Cost(comprehension.loop_step())) +
+             Cost(comprehension.result());
+    }
+    return 0;
+  }
+
+  const FunctionCostTable& function_costs_;
+  absl::flat_hash_map<const Expr*, int64_t> costs_;
+};
+
+class LogicalOperandRewriter : public cel::AstRewriterBase {
+ public:
+  explicit LogicalOperandRewriter(const FunctionCostTable& function_costs)
+      : estimator_(function_costs) {}
+
+  bool PostVisitRewrite(Expr& expr) override {
+    if (!expr.has_call_expr()) {
+      return false;
+    }
+    auto& call = expr.mutable_call_expr();
+    if ((call.function() != cel::builtin::kAnd &&
+         call.function() != cel::builtin::kOr) ||
+        call.has_target() || call.args().size() != 2) {
+      return false;
+    }
+    auto& args = call.mutable_args();
+    if (estimator_.Cost(args[1]) >= estimator_.Cost(args[0])) {
+      return false;
+    }
+    estimator_.Forget(args[0]);
+    estimator_.Forget(args[1]);
+    std::swap(args[0], args[1]);
+    return true;
+  }
+
+ private:
+  CostEstimator estimator_;
+};
+
+class LogicalOperandReordering : public AstTransform {
+ public:
+  explicit LogicalOperandReordering(FunctionCostTable function_costs)
+      : function_costs_(std::move(function_costs)) {}
+
+  absl::Status UpdateAst(PlannerContext& context,
+                         AstImpl& ast) const override {
+    LogicalOperandRewriter rewriter(function_costs_);
+    cel::AstRewrite(ast.root_expr(), rewriter);
+    return absl::OkStatus();
+  }
+
+ private:
+  FunctionCostTable function_costs_;
+};
+
+}  // namespace
+
+FunctionCostTable DefaultFunctionCostTable() {
+  return {
+      {cel::builtin::kRegexMatch, 25},
+      {cel::builtin::kStringContains, 5},
+      {cel::builtin::kStringStartsWith, 2},
+      {cel::builtin::kStringEndsWith, 2},
+      {cel::builtin::kIn, 5},
+  };
+}
+
+int64_t EstimateCost(const Expr& expr,
+                     const FunctionCostTable& function_costs) {
+  return CostEstimator(function_costs).Cost(expr);
+}
+
+std::unique_ptr<AstTransform> NewLogicalOperandReorderingExtension(
+    FunctionCostTable function_costs) {
+  return std::make_unique<LogicalOperandReordering>(std::move(function_costs));
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,57 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_LOGICAL_OPERAND_REORDERING_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_LOGICAL_OPERAND_REORDERING_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "base/ast_internal/expr.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Relative cost of calling a function by name, excluding the cost of
+// evaluating its arguments. Functions not in the table cost
+// `kDefaultFunctionCost`.
+using FunctionCostTable = absl::flat_hash_map<std::string, int64_t>;
+
+inline constexpr int64_t kDefaultFunctionCost = 1;
+
+// Returns the cost table used by default: string scans and regex matching
+// are weighted above simple operators.
+FunctionCostTable DefaultFunctionCostTable();
+
+// Returns a static estimate of the cost of evaluating expr.
+//
+// Comprehensions are assumed to iterate a small, fixed number of times since
+// the range size isn't generally known at plan time.
+int64_t EstimateCost(const cel::ast_internal::Expr& expr,
+                     const FunctionCostTable& function_costs);
+
+// Returns an AST transform that swaps the operands of `&&` and `||` calls so
+// the operand with the lower estimated cost is evaluated first.
+//
+// CEL's logical operators are commutative (errors and unknowns are absorbed
+// or merged the same way regardless of operand order), so this only changes
+// which error is reported when both operands are errors.
+std::unique_ptr<AstTransform> NewLogicalOperandReorderingExtension(
+    FunctionCostTable function_costs = DefaultFunctionCostTable());
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_LOGICAL_OPERAND_REORDERING_H_
@@ -0,0 +1,183 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/logical_operand_reordering.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/internal/issue_collector.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_issue.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::RuntimeIssue;
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+using ::cel::runtime_internal::IssueCollector;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::Eq;
+
+class LogicalOperandReorderingTest : public testing::Test {
+ public:
+  LogicalOperandReorderingTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)),
+        resolver_("", function_registry_, type_registry_,
+                  managed_value_factory_.get(),
+                  type_registry_.resolveable_enums()),
+        issue_collector_(RuntimeIssue::Severity::kError) {}
+
+  void SetUp() override {
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  absl::Status ApplyTransform(AstImpl& ast,
+                              FunctionCostTable costs =
+                                  DefaultFunctionCostTable()) {
+    PlannerContext context(resolver_, options_, managed_value_factory_.get(),
+                           issue_collector_, program_builder_);
+    return NewLogicalOperandReorderingExtension(std::move(costs))
+        ->UpdateAst(context, ast);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+  Resolver resolver_;
+  IssueCollector issue_collector_;
+  ProgramBuilder program_builder_;
+};
+
+const std::string& FunctionOf(const Expr& expr) {
+  return expr.call_expr().function();
+}
+
+TEST_F(LogicalOperandReorderingTest, CheapOperandFirst) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                       Parse("a.matches('^foo.*bar$') && b == 1"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  const auto& args = ast_impl.root_expr().call_expr().args();
+  EXPECT_THAT(FunctionOf(args[0]), Eq("_==_"));
+  EXPECT_THAT(FunctionOf(args[1]), Eq("matches"));
+}
+
+TEST_F(LogicalOperandReorderingTest, StableForEqualCost) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("a == 1 || b < 2"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  const auto& args = ast_impl.root_expr().call_expr().args();
+  EXPECT_THAT(FunctionOf(args[0]), Eq("_==_"));
+  EXPECT_THAT(FunctionOf(args[1]), Eq("_<_"));
+}
+
+TEST_F(LogicalOperandReorderingTest, ComprehensionAfterComparison) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                       Parse("[1, 2, 3].exists(x, x > 2) || b == 1"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl));
+
+  const auto& args = ast_impl.root_expr().call_expr().args();
+  EXPECT_THAT(FunctionOf(args[0]), Eq("_==_"));
+  EXPECT_TRUE(args[1].has_comprehension_expr());
+}
+
+TEST_F(LogicalOperandReorderingTest, CustomCostTable) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("f(a) && g(a)"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  ASSERT_OK(ApplyTransform(ast_impl, {{"f", 100}}));
+
+  const auto& args = ast_impl.root_expr().call_expr().args();
+  EXPECT_THAT(FunctionOf(args[0]), Eq("g"));
+  EXPECT_THAT(FunctionOf(args[1]), Eq("f"));
+}
+
+TEST_F(LogicalOperandReorderingTest, EstimateCost) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("a.b + 1"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  auto& ast_impl = AstImpl::CastFromPublicAst(*ast);
+
+  // ident(1) + select(1) + const(0) + call(1)
+  EXPECT_EQ(EstimateCost(ast_impl.root_expr(), DefaultFunctionCostTable()), 3);
+}
+
+TEST_F(LogicalOperandReorderingTest, ErrorAbsorbedAfterReordering) {
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  builder.AddAstTransform(NewLogicalOperandReorderingExtension());
+
+  // The matches call is an error (no binding for 'a'), but the cheaper false
+  // operand still determines the result.
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("a.matches('foo') && 1 == 2"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateExpressionImpl(std::move(ast),
+                                                    /*issues=*/nullptr));
+
+  auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+  cel::Activation activation;
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      plan.EvaluateWithCallback(activation, EvaluationListener(), state));
+
+  ASSERT_TRUE(value->Is<BoolValue>());
+  EXPECT_FALSE(value->As<BoolValue>().NativeValue());
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,198 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/numeric_comparison_optimization.h"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/compiler/typed_arithmetic_optimization.h"
+#include "eval/eval/arithmetic_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+
+using ReferenceMap = absl::flat_hash_map<int64_t, Reference>;
+
+struct ComparisonFunction {
+  absl::string_view function;
+  NumericComparisonOp op;
+};
+
+constexpr ComparisonFunction kComparisonFunctions[] = {
+    {cel::builtin::kEqual, NumericComparisonOp::kEqual},
+    {cel::builtin::kInequal, NumericComparisonOp::kNotEqual},
+    {cel::builtin::kLess, NumericComparisonOp::kLess},
+    {cel::builtin::kLessOrEqual, NumericComparisonOp::kLessOrEqual},
+    {cel::builtin::kGreater, NumericComparisonOp::kGreater},
+    {cel::builtin::kGreaterOrEqual, NumericComparisonOp::kGreaterOrEqual},
+};
+
+struct NumericComparisonCall {
+  NumericComparisonOp op;
+  std::vector<cel::FunctionOverloadReference> overloads;
+};
+
+absl::optional<NumericComparisonOp> FindComparisonOp(const Expr& expr) {
+  if (!expr.has_call_expr()) {
+    return absl::nullopt;
+  }
+  const auto& call_expr = expr.call_expr();
+  if (call_expr.has_target() || call_expr.args().size() != 2) {
+    return absl::nullopt;
+  }
+  for (const ComparisonFunction& function : kComparisonFunctions) {
+    if (function.function == call_expr.function()) {
+      return function.op;
+    }
+  }
+  return absl::nullopt;
+}
+
+absl::optional<NumericComparisonCall> ResolveNumericComparisonCall(
+    const Expr& expr, const ReferenceMap& reference_map,
+    const Resolver& resolver) {
+  absl::optional<NumericComparisonOp> op = FindComparisonOp(expr);
+  if (!op.has_value()) {
+    return absl::nullopt;
+  }
+  // Leave calls with a known operand kind to the typed arithmetic extension.
+  if (ResolveTypedArithmeticCall(expr, reference_map, resolver).has_value()) {
+    return absl::nullopt;
+  }
+
+  const std::string& function = expr.call_expr().function();
+  // Match the function resolution of the planner. Lazy overloads shadow the
+  // eager ones, and may differ per activation.
+  if (!resolver
+           .FindLazyOverloads(function, /*receiver_style=*/false,
+                              ArgumentsMatcher(2), expr.id())
+           .empty()) {
+    return absl::nullopt;
+  }
+  std::vector<cel::FunctionOverloadReference> overloads =
+      resolver.FindOverloads(function, /*receiver_style=*/false,
+                             ArgumentsMatcher(2), expr.id());
+  if (overloads.empty()) {
+    return absl::nullopt;
+  }
+  return NumericComparisonCall{*op, std::move(overloads)};
+}
+
+class NumericComparisonOptimization : public ProgramOptimizer {
+ public:
+  explicit NumericComparisonOptimization(const ReferenceMap& reference_map)
+      : reference_map_(reference_map) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    absl::optional<NumericComparisonCall> comparison =
+        ResolveNumericComparisonCall(node, reference_map_, context.resolver());
+    if (!comparison.has_value()) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    if (subexpression->IsRecursive()) {
+      return RewriteRecursivePlan(subexpression, node, *std::move(comparison));
+    }
+    return RewriteStackMachinePlan(context, node, *std::move(comparison));
+  }
+
+ private:
+  absl::Status RewriteRecursivePlan(
+      absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
+      const Expr& call, NumericComparisonCall comparison) {
+    auto program = subexpression->ExtractRecursiveProgram();
+    auto deps = program.step->ExtractDependencies();
+    if (!deps.has_value() || deps->size() != 2) {
+      // Possibly already const-folded, put the plan back.
+      subexpression->set_recursive_program(std::move(program.step),
+                                           program.depth);
+      return absl::OkStatus();
+    }
+    subexpression->set_recursive_program(
+        CreateDirectNumericComparisonStep(
+            call.id(), call.call_expr(), comparison.op, std::move(deps->at(0)),
+            std::move(deps->at(1)), std::move(comparison.overloads)),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+  absl::Status RewriteStackMachinePlan(PlannerContext& context,
+                                       const Expr& call,
+                                       NumericComparisonCall comparison) {
+    const Expr& lhs = call.call_expr().args()[0];
+    const Expr& rhs = call.call_expr().args()[1];
+    if (context.GetSubplan(lhs).empty() || context.GetSubplan(rhs).empty()) {
+      // This subexpression was already optimized, nothing to do.
+      return absl::OkStatus();
+    }
+
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan, context.ExtractSubplan(lhs));
+    CEL_ASSIGN_OR_RETURN(ExecutionPath rhs_plan, context.ExtractSubplan(rhs));
+    std::move(rhs_plan.begin(), rhs_plan.end(), std::back_inserter(new_plan));
+    CEL_ASSIGN_OR_RETURN(
+        new_plan.emplace_back(),
+        CreateNumericComparisonStep(call.call_expr(), call.id(), comparison.op,
+                                    std::move(comparison.overloads)));
+
+    return context.ReplaceSubplan(call, std::move(new_plan));
+  }
+
+  const ReferenceMap& reference_map_;
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateNumericComparisonExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<NumericComparisonOptimization>(
+        ast.reference_map());
+  };
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_NUMERIC_COMPARISON_OPTIMIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_NUMERIC_COMPARISON_OPTIMIZATION_H_
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that evaluates equality and
+// ordering calls (`==`, `!=`, `<`, `<=`, `>`, `>=`) with a single step that
+// compares int, uint and double operands inline, in every combination the
+// registered overloads accept, instead of resolving the overload for the
+// argument kinds on each call.
+//
+// Applies to calls whose operand kinds aren't known when planning: in
+// parsed-only expressions, or in checked expressions if the type checker
+// didn't resolve the call to a single overload (for example with `dyn`
+// operands). Calls resolved to one overload are left to
+// `CreateTypedArithmeticExtension`.
+//
+// Assumes the registered implementations for numeric operands are the
+// standard ones. Arguments that are errors, unknowns or not numbers are
+// handled by the generic function dispatch.
+ProgramOptimizerFactory CreateNumericComparisonExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_NUMERIC_COMPARISON_OPTIMIZATION_H_
@@ -0,0 +1,187 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/peephole_optimizations.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/native_type.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/peephole_optimizer.h"
+#include "eval/eval/compiler_constant_step.h"
+#include "eval/eval/const_value_step.h"
+#include "eval/eval/create_list_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/jump_step.h"
+#include "internal/casts.h"
+#include "internal/status_macros.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::ErrorValue;
+using ::cel::UnknownValue;
+
+bool IsUnconditionalJump(const PeepholeProgram& program, size_t index) {
+  return index < program.size() &&
+         GetJumpStepOffset(program.step(index)).has_value();
+}
+
+class JumpThreadingOptimizer : public PeepholeOptimizer {
+ public:
+  absl::Status Optimize(PlannerContext& context,
+                        PeepholeProgram& program) const override {
+    for (size_t i = 0; i < program.size(); ++i) {
+      for (size_t n = 0; n < program.jump_targets(i).size(); ++n) {
+        size_t target = program.jump_targets(i)[n];
+        // Bounded in case of a cycle of jumps.
+        for (size_t hops = 0;
+             hops < program.size() && IsUnconditionalJump(program, target) &&
+             target != i;
+             ++hops) {
+          target = program.jump_targets(target)[0];
+        }
+        if (target != program.jump_targets(i)[n]) {
+          CEL_RETURN_IF_ERROR(program.SetJumpTarget(i, n, target));
+        }
+      }
+    }
+
+    size_t i = 0;
+    while (i < program.size()) {
+      if (IsUnconditionalJump(program, i) &&
+          program.jump_targets(i)[0] == i + 1) {
+        CEL_RETURN_IF_ERROR(program.Remove(i, 1));
+        // A jump over the removed step now lands on the following one.
+        if (i > 0) {
+          --i;
+        }
+        continue;
+      }
+      ++i;
+    }
+    return absl::OkStatus();
+  }
+};
+
+class ConstantListOptimizer : public PeepholeOptimizer {
+ public:
+  absl::Status Optimize(PlannerContext& context,
+                        PeepholeProgram& program) const override {
+    const cel::NativeTypeId kConstant =
+        cel::NativeTypeId::For<CompilerConstantStep>();
+    for (size_t i = 0; i < program.size(); ++i) {
+      absl::optional<int> list_size = GetCreateListStepSize(program.step(i));
+      if (!list_size.has_value() || *list_size < 0 ||
+          static_cast<size_t>(*list_size) > i) {
+        continue;
+      }
+      size_t start = i - *list_size;
+      std::vector<cel::NativeTypeId> pattern(*list_size, kConstant);
+      if (!program.Matches(start, pattern)) {
+        continue;
+      }
+      bool foldable = true;
+      for (size_t j = start; j <= i && foldable; ++j) {
+        // Jumping past some of the elements would change the list.
+        foldable = j == start || !program.IsJumpTarget(j);
+        if (foldable && j < i) {
+          const cel::Value& value =
+              cel::internal::down_cast<const CompilerConstantStep&>(
+                  program.step(j))
+                  .value();
+          foldable = !cel::InstanceOf<ErrorValue>(value) &&
+                     !cel::InstanceOf<UnknownValue>(value);
+        }
+      }
+      if (!foldable) {
+        continue;
+      }
+
+      cel::ValueManager& value_factory = context.value_factory();
+      CEL_ASSIGN_OR_RETURN(auto builder,
+                           value_factory.NewListValueBuilder(
+                               value_factory.GetDynListType()));
+      builder->Reserve(*list_size);
+      for (size_t j = start; j < i; ++j) {
+        CEL_RETURN_IF_ERROR(builder->Add(
+            cel::internal::down_cast<const CompilerConstantStep&>(
+                program.step(j))
+                .value()));
+      }
+      CEL_ASSIGN_OR_RETURN(
+          auto step, CreateConstValueStep(std::move(*builder).Build(),
+                                          program.step(i).id(),
+                                          program.step(i).comes_from_ast()));
+      ExecutionPath replacement;
+      replacement.push_back(std::move(step));
+      CEL_RETURN_IF_ERROR(
+          program.Replace(start, i - start + 1, std::move(replacement)));
+      i = start;
+    }
+    return absl::OkStatus();
+  }
+};
+
+class DeadStepEliminationOptimizer : public PeepholeOptimizer {
+ public:
+  absl::Status Optimize(PlannerContext& context,
+                        PeepholeProgram& program) const override {
+    for (size_t i = 0; i < program.size(); ++i) {
+      if (!IsUnconditionalJump(program, i)) {
+        continue;
+      }
+      size_t end = i + 1;
+      while (end < program.size() && !program.IsJumpTarget(end)) {
+        ++end;
+      }
+      if (end > i + 1) {
+        CEL_RETURN_IF_ERROR(program.Remove(i + 1, end - (i + 1)));
+      }
+    }
+    return absl::OkStatus();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<PeepholeOptimizer> CreateJumpThreadingOptimizer() {
+  return std::make_unique<JumpThreadingOptimizer>();
+}
+
+std::unique_ptr<PeepholeOptimizer> CreateConstantListOptimizer() {
+  return std::make_unique<ConstantListOptimizer>();
+}
+
+std::unique_ptr<PeepholeOptimizer> CreateDeadStepEliminationOptimizer() {
+  return std::make_unique<DeadStepEliminationOptimizer>();
+}
+
+std::vector<std::unique_ptr<PeepholeOptimizer>> CreatePeepholeOptimizations() {
+  std::vector<std::unique_ptr<PeepholeOptimizer>> optimizers;
+  optimizers.push_back(CreateDeadStepEliminationOptimizer());
+  optimizers.push_back(CreateJumpThreadingOptimizer());
+  optimizers.push_back(CreateConstantListOptimizer());
+  return optimizers;
+}
+
+}  // namespace google::api::expr::runtime
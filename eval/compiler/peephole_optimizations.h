@@ -0,0 +1,47 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PEEPHOLE_OPTIMIZATIONS_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PEEPHOLE_OPTIMIZATIONS_H_
+
+#include <memory>
+#include <vector>
+
+#include "eval/compiler/peephole_optimizer.h"
+
+namespace google::api::expr::runtime {
+
+// Retargets jumps landing on an unconditional jump to its final target, and
+// removes unconditional jumps to the following step.
+std::unique_ptr<PeepholeOptimizer> CreateJumpThreadingOptimizer();
+
+// Replaces constants immediately followed by the creation of a list of them
+// with a single constant list.
+//
+// Like constant folding, this changes the values reported to an evaluation
+// listener: only the list is reported, not its elements.
+std::unique_ptr<PeepholeOptimizer> CreateConstantListOptimizer();
+
+// Removes steps which follow an unconditional jump and are not the target of
+// any jump, so can never be evaluated.
+std::unique_ptr<PeepholeOptimizer> CreateDeadStepEliminationOptimizer();
+
+// Returns the optimizers above, in the order they should be applied: dead
+// steps are removed first so the jump preceding them may become a jump to the
+// following step.
+std::vector<std::unique_ptr<PeepholeOptimizer>> CreatePeepholeOptimizations();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PEEPHOLE_OPTIMIZATIONS_H_
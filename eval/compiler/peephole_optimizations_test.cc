@@ -0,0 +1,247 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/peephole_optimizations.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/values/legacy_value_manager.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/peephole_optimizer.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/const_value_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/jump_step.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/internal/issue_collector.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_issue.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::IntValue;
+using ::cel::ListValue;
+using ::cel::RuntimeIssue;
+using ::cel::Value;
+using ::cel::runtime_internal::IssueCollector;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::Lt;
+using testing::Optional;
+using cel::internal::IsOkAndHolds;
+
+class PeepholeOptimizationsTest : public testing::Test {
+ public:
+  PeepholeOptimizationsTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {}
+
+  void SetUp() override {
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  absl::StatusOr<FlatExpression> Plan(absl::string_view expression,
+                                      bool optimize) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    if (optimize) {
+      for (auto& optimizer : CreatePeepholeOptimizations()) {
+        builder.AddPeepholeOptimizer(std::move(optimizer));
+      }
+    }
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(expr));
+    return builder.CreateExpressionImpl(std::move(ast), /*issues=*/nullptr);
+  }
+
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 const cel::Activation& activation,
+                                 bool optimize = true) {
+    CEL_ASSIGN_OR_RETURN(auto plan, Plan(expression, optimize));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_F(PeepholeOptimizationsTest, NestedTernaries) {
+  for (bool a : {false, true}) {
+    for (bool b : {false, true}) {
+      cel::Activation activation;
+      activation.InsertOrAssignValue("a", BoolValue(a));
+      activation.InsertOrAssignValue("b", BoolValue(b));
+      ASSERT_OK_AND_ASSIGN(
+          Value result, Evaluate("a ? (b ? 1 : 2) : (b ? 3 : 4)", activation));
+      ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+      EXPECT_EQ(result.As<IntValue>().NativeValue(),
+                a ? (b ? 1 : 2) : (b ? 3 : 4));
+    }
+  }
+}
+
+TEST_F(PeepholeOptimizationsTest, FoldsConstantLists) {
+  ASSERT_OK_AND_ASSIGN(auto unoptimized,
+                       Plan("[1, 2, [3, 4]]", /*optimize=*/false));
+  ASSERT_OK_AND_ASSIGN(auto optimized,
+                       Plan("[1, 2, [3, 4]]", /*optimize=*/true));
+  EXPECT_EQ(optimized.path().size(), 1);
+  EXPECT_THAT(optimized.path().size(), Lt(unoptimized.path().size()));
+
+  cel::Activation activation;
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("[1, 2, [3, 4]]", activation));
+  ASSERT_TRUE(result.Is<ListValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ListValue>().Size(), IsOkAndHolds(3));
+}
+
+TEST_F(PeepholeOptimizationsTest, KeepsListsWithVariables) {
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(3));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("[1, x][1] + [2][0]", activation));
+
+  ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 5);
+}
+
+TEST_F(PeepholeOptimizationsTest, Comprehensions) {
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("[1, 2, 3].filter(i, i > x ? true : i < x) == [1, 3]",
+               activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_F(PeepholeOptimizationsTest, ShortCircuiting) {
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("(x > 1 || y) && (x < 1 || x in [1, 2])",
+                                activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+class PeepholeStepTest : public testing::Test {
+ public:
+  PeepholeStepTest()
+      : value_factory_(cel::MemoryManagerRef::ReferenceCounting(),
+                       type_registry_.GetComposedTypeProvider()),
+        resolver_("", function_registry_, type_registry_, value_factory_,
+                  type_registry_.resolveable_enums()),
+        issue_collector_(RuntimeIssue::Severity::kError),
+        context_(resolver_, options_, value_factory_, issue_collector_,
+                 program_builder_) {}
+
+ protected:
+  cel::TypeRegistry type_registry_;
+  cel::FunctionRegistry function_registry_;
+  cel::RuntimeOptions options_;
+  cel::common_internal::LegacyValueManager value_factory_;
+  Resolver resolver_;
+  IssueCollector issue_collector_;
+  ProgramBuilder program_builder_;
+  PlannerContext context_;
+};
+
+// Builds:
+//   0: jump -> 3
+//   1: const 1
+//   2: jump -> 0
+//   3: jump -> 4
+//   4: const 4
+absl::StatusOr<PeepholeProgram> MakeProgram() {
+  ExecutionPath path;
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(), CreateJumpStep(2, -1));
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(),
+                       CreateConstValueStep(IntValue(1), 1));
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(), CreateJumpStep(-3, -1));
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(), CreateJumpStep(0, -1));
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(),
+                       CreateConstValueStep(IntValue(4), 4));
+  return PeepholeProgram::Create(std::move(path));
+}
+
+TEST_F(PeepholeStepTest, DeadStepElimination) {
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program, MakeProgram());
+
+  ASSERT_OK(CreateDeadStepEliminationOptimizer()->Optimize(context_, program));
+
+  ExecutionPath path = std::move(program).Release();
+  ASSERT_EQ(path.size(), 3);
+  EXPECT_THAT(GetJumpStepOffset(*path[0]), Optional(0));
+  EXPECT_THAT(GetJumpStepOffset(*path[1]), Optional(0));
+}
+
+TEST_F(PeepholeStepTest, JumpThreading) {
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program, MakeProgram());
+
+  ASSERT_OK(CreateJumpThreadingOptimizer()->Optimize(context_, program));
+
+  // Jumps landing on the last jump are threaded to the final constant, then
+  // the jumps to the following step are removed.
+  ExecutionPath path = std::move(program).Release();
+  ASSERT_EQ(path.size(), 3);
+  EXPECT_THAT(GetJumpStepOffset(*path[0]), Optional(1));
+}
+
+TEST_F(PeepholeStepTest, AllOptimizations) {
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program, MakeProgram());
+
+  for (const auto& optimizer : CreatePeepholeOptimizations()) {
+    ASSERT_OK(optimizer->Optimize(context_, program));
+  }
+
+  ExecutionPath path = std::move(program).Release();
+  ASSERT_EQ(path.size(), 1);
+  EXPECT_FALSE(GetJumpStepOffset(*path[0]).has_value());
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,199 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/peephole_optimizer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "common/native_type.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/status_macros.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+// Converts the relative jump offsets of the step at `index` to absolute
+// targets in a program of `size` steps.
+absl::StatusOr<std::vector<size_t>> GetJumpTargets(const ExpressionStep& step,
+                                                   size_t index, size_t size) {
+  std::vector<int> offsets = step.GetJumpOffsets();
+  std::vector<size_t> targets;
+  targets.reserve(offsets.size());
+  for (int offset : offsets) {
+    int64_t target = static_cast<int64_t>(index) + 1 + offset;
+    if (target < 0 || target > static_cast<int64_t>(size)) {
+      return absl::InternalError(
+          absl::StrCat("jump out of range: position: ", index,
+                       ", offset: ", offset, ", range: ", size));
+    }
+    targets.push_back(static_cast<size_t>(target));
+  }
+  return targets;
+}
+
+}  // namespace
+
+absl::StatusOr<PeepholeProgram> PeepholeProgram::Create(ExecutionPath path) {
+  PeepholeProgram program;
+  program.steps_.reserve(path.size());
+  program.targets_.reserve(path.size());
+  for (size_t i = 0; i < path.size(); ++i) {
+    CEL_ASSIGN_OR_RETURN(std::vector<size_t> targets,
+                         GetJumpTargets(*path[i], i, path.size()));
+    program.targets_.push_back(std::move(targets));
+    program.steps_.push_back(std::unique_ptr<ExpressionStep>(
+        const_cast<ExpressionStep*>(path[i].release())));
+  }
+  program.UpdateIncoming();
+  return program;
+}
+
+bool PeepholeProgram::Matches(
+    size_t index, absl::Span<const cel::NativeTypeId> pattern) const {
+  if (index > steps_.size() || steps_.size() - index < pattern.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != cel::NativeTypeId() &&
+        steps_[index + i]->GetNativeTypeId() != pattern[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::Status PeepholeProgram::SetJumpTarget(size_t index, size_t n,
+                                            size_t target) {
+  if (index >= steps_.size() || n >= targets_[index].size() ||
+      target > steps_.size()) {
+    return absl::InvalidArgumentError("jump target out of range");
+  }
+  --incoming_[targets_[index][n]];
+  targets_[index][n] = target;
+  ++incoming_[target];
+  return absl::OkStatus();
+}
+
+absl::Status PeepholeProgram::Replace(size_t index, size_t count,
+                                      ExecutionPath replacement) {
+  if (index > steps_.size() || steps_.size() - index < count) {
+    return absl::InvalidArgumentError("replaced range out of bounds");
+  }
+  const size_t end = index + count;
+  for (size_t i = 0; i < steps_.size(); ++i) {
+    if (i >= index && i < end) {
+      continue;
+    }
+    for (size_t target : targets_[i]) {
+      if (target > index && target < end) {
+        return absl::FailedPreconditionError(
+            absl::StrCat("step ", i, " jumps into the replaced range"));
+      }
+    }
+  }
+
+  const size_t new_size = steps_.size() - count + replacement.size();
+  std::vector<std::vector<size_t>> new_targets;
+  new_targets.reserve(replacement.size());
+  for (size_t i = 0; i < replacement.size(); ++i) {
+    CEL_ASSIGN_OR_RETURN(
+        std::vector<size_t> targets,
+        GetJumpTargets(*replacement[i], index + i, new_size));
+    new_targets.push_back(std::move(targets));
+  }
+
+  for (auto& targets : targets_) {
+    for (size_t& target : targets) {
+      if (target >= end && target != index) {
+        target = target - count + replacement.size();
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<ExpressionStep>> new_steps;
+  new_steps.reserve(replacement.size());
+  for (auto& step : replacement) {
+    new_steps.push_back(std::unique_ptr<ExpressionStep>(
+        const_cast<ExpressionStep*>(step.release())));
+  }
+  steps_.erase(steps_.begin() + index, steps_.begin() + end);
+  steps_.insert(steps_.begin() + index,
+                std::make_move_iterator(new_steps.begin()),
+                std::make_move_iterator(new_steps.end()));
+  targets_.erase(targets_.begin() + index, targets_.begin() + end);
+  targets_.insert(targets_.begin() + index,
+                  std::make_move_iterator(new_targets.begin()),
+                  std::make_move_iterator(new_targets.end()));
+  UpdateIncoming();
+  return absl::OkStatus();
+}
+
+ExecutionPath PeepholeProgram::Release() && {
+  ExecutionPath path;
+  path.reserve(steps_.size());
+  std::vector<int> offsets;
+  for (size_t i = 0; i < steps_.size(); ++i) {
+    if (!targets_[i].empty()) {
+      offsets.clear();
+      for (size_t target : targets_[i]) {
+        offsets.push_back(static_cast<int>(target) - static_cast<int>(i) - 1);
+      }
+      if (offsets != steps_[i]->GetJumpOffsets()) {
+        steps_[i]->SetJumpOffsets(offsets);
+      }
+    }
+    path.push_back(std::move(steps_[i]));
+  }
+  steps_.clear();
+  targets_.clear();
+  incoming_.clear();
+  return path;
+}
+
+void PeepholeProgram::UpdateIncoming() {
+  incoming_.assign(steps_.size() + 1, 0);
+  for (const auto& targets : targets_) {
+    for (size_t target : targets) {
+      ++incoming_[target];
+    }
+  }
+}
+
+absl::StatusOr<ExecutionPath> ApplyPeepholeOptimizers(
+    PlannerContext& context,
+    absl::Span<const std::unique_ptr<PeepholeOptimizer>> optimizers,
+    ExecutionPath path) {
+  if (optimizers.empty()) {
+    return path;
+  }
+  CEL_ASSIGN_OR_RETURN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+  for (const auto& optimizer : optimizers) {
+    CEL_RETURN_IF_ERROR(optimizer->Optimize(context, program));
+  }
+  return std::move(program).Release();
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,125 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// API for rewriting flattened programs after planning.
+//
+// Program optimizers only see the plan for the AST node being visited.
+// Peephole optimizers see each complete subprogram (the main program and each
+// lazily evaluated subexpression) once planning has finished, so they can
+// rewrite step sequences produced for different nodes, such as a jump that
+// lands on another jump.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PEEPHOLE_OPTIMIZER_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PEEPHOLE_OPTIMIZER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "common/native_type.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+// A flattened subprogram being rewritten.
+//
+// Jumps are tracked by their absolute target (the index of the step they
+// land on, or `size()` for the end of the program) and are kept consistent as
+// steps are replaced. The relative offsets of the steps are updated when the
+// program is released.
+class PeepholeProgram {
+ public:
+  // Fails if a jump in `path` is out of range.
+  static absl::StatusOr<PeepholeProgram> Create(ExecutionPath path);
+
+  PeepholeProgram(PeepholeProgram&&) = default;
+  PeepholeProgram& operator=(PeepholeProgram&&) = default;
+
+  size_t size() const { return steps_.size(); }
+
+  const ExpressionStep& step(size_t index) const { return *steps_[index]; }
+
+  // Returns true if the steps starting at `index` have the native type ids in
+  // `pattern`, in order. A default constructed id matches any step.
+  bool Matches(size_t index, absl::Span<const cel::NativeTypeId> pattern) const;
+
+  // Returns the absolute targets of the jumps of the step at `index`, in the
+  // order of `ExpressionStep::GetJumpOffsets`.
+  absl::Span<const size_t> jump_targets(size_t index) const {
+    return targets_[index];
+  }
+
+  // Returns true if any jump lands on the step at `index`.
+  bool IsJumpTarget(size_t index) const { return incoming_[index] > 0; }
+
+  // Retargets the `n`th jump of the step at `index`.
+  absl::Status SetJumpTarget(size_t index, size_t n, size_t target);
+
+  // Replaces the `count` steps starting at `index` with `replacement`.
+  //
+  // Jumps from outside of the range may only land on its first step, they
+  // land on the first replacement step afterwards (or the step following the
+  // range if `replacement` is empty). Jump offsets of the replacement steps
+  // are relative to their new position.
+  absl::Status Replace(size_t index, size_t count, ExecutionPath replacement);
+
+  // Removes the `count` steps starting at `index`.
+  absl::Status Remove(size_t index, size_t count) {
+    return Replace(index, count, ExecutionPath());
+  }
+
+  // Returns the rewritten program.
+  ExecutionPath Release() &&;
+
+ private:
+  PeepholeProgram() = default;
+
+  void UpdateIncoming();
+
+  // The steps are created mutable and only made const when added to a plan.
+  // They are owned here until the program is released, so the jump offsets
+  // can be updated in place.
+  std::vector<std::unique_ptr<ExpressionStep>> steps_;
+  std::vector<std::vector<size_t>> targets_;
+  std::vector<int> incoming_;
+};
+
+// Interface for peephole optimizers.
+//
+// If any are present, the FlatExprBuilder applies them in order to each
+// flattened subprogram after planning.
+//
+// The instance is shared by all expressions planned by the builder, so
+// implementations must be thread safe.
+class PeepholeOptimizer {
+ public:
+  virtual ~PeepholeOptimizer() = default;
+
+  virtual absl::Status Optimize(PlannerContext& context,
+                                PeepholeProgram& program) const = 0;
+};
+
+// Applies `optimizers` in order to `path`.
+absl::StatusOr<ExecutionPath> ApplyPeepholeOptimizers(
+    PlannerContext& context,
+    absl::Span<const std::unique_ptr<PeepholeOptimizer>> optimizers,
+    ExecutionPath path);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PEEPHOLE_OPTIMIZER_H_
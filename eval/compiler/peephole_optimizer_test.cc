@@ -0,0 +1,162 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/peephole_optimizer.h"
+
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common/native_type.h"
+#include "common/value.h"
+#include "eval/eval/compiler_constant_step.h"
+#include "eval/eval/const_value_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/jump_step.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::IntValue;
+using testing::ElementsAre;
+using testing::Optional;
+using cel::internal::StatusIs;
+
+absl::StatusOr<ExecutionPath> MakePath(int constants) {
+  ExecutionPath path;
+  for (int i = 0; i < constants; ++i) {
+    CEL_ASSIGN_OR_RETURN(path.emplace_back(),
+                         CreateConstValueStep(IntValue(i), i));
+  }
+  return path;
+}
+
+// Builds:
+//   0: const 0
+//   1: jump -> 4
+//   2: const 2
+//   3: const 3
+//   4: const 4
+absl::StatusOr<ExecutionPath> MakeJumpPath() {
+  ExecutionPath path;
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(),
+                       CreateConstValueStep(IntValue(0), 0));
+  CEL_ASSIGN_OR_RETURN(path.emplace_back(), CreateJumpStep(2, -1));
+  for (int i = 2; i < 5; ++i) {
+    CEL_ASSIGN_OR_RETURN(path.emplace_back(),
+                         CreateConstValueStep(IntValue(i), i));
+  }
+  return path;
+}
+
+TEST(PeepholeProgramTest, TracksJumpTargets) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+
+  EXPECT_EQ(program.size(), 5);
+  EXPECT_THAT(program.jump_targets(1), ElementsAre(4));
+  EXPECT_TRUE(program.jump_targets(0).empty());
+  EXPECT_TRUE(program.IsJumpTarget(4));
+  EXPECT_FALSE(program.IsJumpTarget(3));
+}
+
+TEST(PeepholeProgramTest, Matches) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+  const cel::NativeTypeId kConstant =
+      cel::NativeTypeId::For<CompilerConstantStep>();
+
+  EXPECT_TRUE(program.Matches(2, {kConstant, kConstant, kConstant}));
+  EXPECT_TRUE(program.Matches(0, {kConstant, cel::NativeTypeId()}));
+  EXPECT_FALSE(program.Matches(0, {kConstant, kConstant}));
+  EXPECT_FALSE(program.Matches(3, {kConstant, kConstant, kConstant}));
+}
+
+TEST(PeepholeProgramTest, RemoveUpdatesOffsets) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+
+  ASSERT_OK(program.Remove(2, 1));
+  EXPECT_THAT(program.jump_targets(1), ElementsAre(3));
+
+  ExecutionPath result = std::move(program).Release();
+  ASSERT_EQ(result.size(), 4);
+  EXPECT_THAT(GetJumpStepOffset(*result[1]), Optional(1));
+}
+
+TEST(PeepholeProgramTest, ReplaceKeepsJumpsToFirstStep) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+  ASSERT_OK_AND_ASSIGN(ExecutionPath replacement, MakePath(3));
+
+  ASSERT_OK(program.Replace(4, 1, std::move(replacement)));
+
+  EXPECT_EQ(program.size(), 7);
+  EXPECT_THAT(program.jump_targets(1), ElementsAre(4));
+}
+
+TEST(PeepholeProgramTest, RemoveTargetFollowsToNextStep) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+
+  ASSERT_OK(program.Remove(4, 1));
+
+  EXPECT_THAT(program.jump_targets(1), ElementsAre(4));
+  EXPECT_EQ(program.size(), 4);
+  ExecutionPath result = std::move(program).Release();
+  EXPECT_THAT(GetJumpStepOffset(*result[1]), Optional(2));
+}
+
+TEST(PeepholeProgramTest, ReplaceRejectsJumpsIntoRange) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+
+  EXPECT_THAT(program.Remove(3, 2),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_EQ(program.size(), 5);
+}
+
+TEST(PeepholeProgramTest, SetJumpTarget) {
+  ASSERT_OK_AND_ASSIGN(ExecutionPath path, MakeJumpPath());
+  ASSERT_OK_AND_ASSIGN(PeepholeProgram program,
+                       PeepholeProgram::Create(std::move(path)));
+
+  ASSERT_OK(program.SetJumpTarget(1, 0, 5));
+  EXPECT_FALSE(program.IsJumpTarget(4));
+  EXPECT_TRUE(program.IsJumpTarget(5));
+  EXPECT_THAT(program.SetJumpTarget(1, 0, 6),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  ExecutionPath result = std::move(program).Release();
+  EXPECT_THAT(GetJumpStepOffset(*result[1]), Optional(3));
+}
+
+TEST(PeepholeProgramTest, CreateRejectsOutOfRangeJumps) {
+  ExecutionPath path;
+  ASSERT_OK_AND_ASSIGN(path.emplace_back(), CreateJumpStep(1, -1));
+
+  EXPECT_THAT(PeepholeProgram::Create(std::move(path)),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,344 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/profiling.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/expression_step_base.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using Counters = EvaluationProfile::Counters;
+
+int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Returns the bytes allocated by the evaluation so far, as counted against
+// `max_evaluation_bytes` if it is set, otherwise the space used on the
+// evaluation arena.
+int64_t ArenaBytes(ExecutionFrameBase& frame) {
+  if (absl::optional<uint64_t> allocated = frame.allocated_bytes();
+      allocated.has_value()) {
+    return static_cast<int64_t>(*allocated);
+  }
+  google::protobuf::Arena* arena = cel::extensions::ProtoMemoryManagerArena(
+      frame.value_manager().GetMemoryManager());
+  if (arena == nullptr) {
+    return 0;
+  }
+  return static_cast<int64_t>(arena->SpaceUsed());
+}
+
+void Record(Counters& counters, int64_t start_nanos, int64_t start_bytes,
+            ExecutionFrameBase& frame) {
+  counters.count.fetch_add(1, std::memory_order_relaxed);
+  counters.nanos.fetch_add(NowNanos() - start_nanos,
+                           std::memory_order_relaxed);
+  counters.arena_bytes.fetch_add(ArenaBytes(frame) - start_bytes,
+                                 std::memory_order_relaxed);
+}
+
+std::string DescribeExpr(const cel::ast_internal::Expr& expr) {
+  if (expr.has_const_expr()) {
+    return "<const>";
+  }
+  if (expr.has_ident_expr()) {
+    return expr.ident_expr().name();
+  }
+  if (expr.has_select_expr()) {
+    if (expr.select_expr().test_only()) {
+      return absl::StrCat("has(.", expr.select_expr().field(), ")");
+    }
+    return absl::StrCat(".", expr.select_expr().field());
+  }
+  if (expr.has_call_expr()) {
+    if (expr.call_expr().has_target()) {
+      return absl::StrCat(".", expr.call_expr().function(), "()");
+    }
+    return absl::StrCat(expr.call_expr().function(), "()");
+  }
+  if (expr.has_list_expr()) {
+    return "<list>";
+  }
+  if (expr.has_struct_expr()) {
+    return absl::StrCat(expr.struct_expr().name(), "{}");
+  }
+  if (expr.has_map_expr()) {
+    return "<map>";
+  }
+  if (expr.has_comprehension_expr()) {
+    return "<comprehension>";
+  }
+  return "<unspecified>";
+}
+
+// Bookkeeping for nodes that have been entered but not yet exited on the
+// stack machine.
+//
+// Steps are shared by every evaluation of a program, so the start time can't
+// live in the step itself. Evaluation of a single frame happens on one
+// thread, so a thread local stack is sufficient to pair the enter and exit
+// steps.
+struct ActiveNode {
+  const Counters* counters;
+  int64_t start_nanos;
+  int64_t start_bytes;
+};
+
+std::vector<ActiveNode>& ActiveNodes() {
+  static thread_local std::vector<ActiveNode> active_nodes;
+  return active_nodes;
+}
+
+class ProfileEnterStep : public ExpressionStepBase {
+ public:
+  ProfileEnterStep(int64_t expr_id, std::shared_ptr<Counters> counters,
+                   bool is_root)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/false),
+        counters_(std::move(counters)),
+        is_root_(is_root) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    std::vector<ActiveNode>& active_nodes = ActiveNodes();
+    if (is_root_) {
+      // Discard anything left over from an evaluation that ended in an error.
+      active_nodes.clear();
+    }
+    active_nodes.push_back(
+        {counters_.get(), NowNanos(), ArenaBytes(*frame)});
+    return absl::OkStatus();
+  }
+
+ private:
+  std::shared_ptr<Counters> counters_;
+  bool is_root_;
+};
+
+class ProfileExitStep : public ExpressionStepBase {
+ public:
+  ProfileExitStep(int64_t expr_id, std::shared_ptr<Counters> counters)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/false),
+        counters_(std::move(counters)) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    std::vector<ActiveNode>& active_nodes = ActiveNodes();
+    // Entries above this node's are only left behind if a nested evaluation
+    // failed, so they can be dropped.
+    while (!active_nodes.empty()) {
+      ActiveNode node = active_nodes.back();
+      active_nodes.pop_back();
+      if (node.counters == counters_.get()) {
+        Record(*counters_, node.start_nanos, node.start_bytes, *frame);
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  std::shared_ptr<Counters> counters_;
+};
+
+class ProfileDirectStep : public DirectExpressionStep {
+ public:
+  ProfileDirectStep(std::unique_ptr<DirectExpressionStep> expression,
+                    std::shared_ptr<Counters> counters)
+      : DirectExpressionStep(expression->expr_id()),
+        expression_(std::move(expression)),
+        counters_(std::move(counters)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
+                        AttributeTrail& trail) const override {
+    int64_t start_nanos = NowNanos();
+    int64_t start_bytes = ArenaBytes(frame);
+    absl::Status status = expression_->Evaluate(frame, result, trail);
+    Record(*counters_, start_nanos, start_bytes, frame);
+    return status;
+  }
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{expression_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.push_back(std::move(expression_));
+    return dependencies;
+  };
+
+ private:
+  std::unique_ptr<DirectExpressionStep> expression_;
+  std::shared_ptr<Counters> counters_;
+};
+
+class ProfileOptimizer : public ProgramOptimizer {
+ public:
+  ProfileOptimizer(std::shared_ptr<EvaluationProfile> profile,
+                   int64_t root_expr_id)
+      : profile_(std::move(profile)), root_expr_id_(root_expr_id) {}
+
+  absl::Status OnPreVisit(PlannerContext& context,
+                          const cel::ast_internal::Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context,
+                           const cel::ast_internal::Expr& node) override {
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr) {
+      return absl::OkStatus();
+    }
+
+    // Alias the profile so that it outlives the planned program.
+    auto counters = std::shared_ptr<Counters>(
+        profile_,
+        &profile_->GetOrCreateCounters(node.id(), DescribeExpr(node)));
+
+    if (subexpression->IsRecursive()) {
+      auto program = subexpression->ExtractRecursiveProgram();
+      return context.ReplaceSubplan(
+          node,
+          std::make_unique<ProfileDirectStep>(std::move(program.step),
+                                              counters),
+          program.depth);
+    }
+
+    if (context.GetSubplan(node).empty()) {
+      return absl::OkStatus();
+    }
+
+    CEL_ASSIGN_OR_RETURN(ExecutionPath subplan, context.ExtractSubplan(node));
+    ExecutionPath path;
+    path.reserve(subplan.size() + 2);
+    path.push_back(std::make_unique<ProfileEnterStep>(
+        node.id(), counters, node.id() == root_expr_id_));
+    std::move(subplan.begin(), subplan.end(), std::back_inserter(path));
+    path.push_back(
+        std::make_unique<ProfileExitStep>(node.id(), std::move(counters)));
+    return context.ReplaceSubplan(node, std::move(path));
+  }
+
+ private:
+  std::shared_ptr<EvaluationProfile> profile_;
+  int64_t root_expr_id_;
+};
+
+}  // namespace
+
+EvaluationProfile::Counters& EvaluationProfile::GetOrCreateCounters(
+    int64_t expr_id, absl::string_view description) {
+  absl::MutexLock lock(&mutex_);
+  auto [it, inserted] = entries_.try_emplace(expr_id);
+  if (inserted) {
+    it->second.description = std::string(description);
+  }
+  return it->second.counters;
+}
+
+std::vector<ExprProfile> EvaluationProfile::Snapshot() const {
+  std::vector<ExprProfile> out;
+  {
+    absl::MutexLock lock(&mutex_);
+    out.reserve(entries_.size());
+    for (const auto& [expr_id, entry] : entries_) {
+      int64_t count = entry.counters.count.load(std::memory_order_relaxed);
+      if (count == 0) {
+        continue;
+      }
+      out.push_back(ExprProfile{
+          expr_id, entry.description, count,
+          absl::Nanoseconds(
+              entry.counters.nanos.load(std::memory_order_relaxed)),
+          entry.counters.arena_bytes.load(std::memory_order_relaxed)});
+    }
+  }
+  std::sort(out.begin(), out.end(),
+            [](const ExprProfile& lhs, const ExprProfile& rhs) {
+              if (lhs.total_time != rhs.total_time) {
+                return lhs.total_time > rhs.total_time;
+              }
+              return lhs.expr_id < rhs.expr_id;
+            });
+  return out;
+}
+
+std::string EvaluationProfile::FormatTable() const {
+  std::string out = absl::StrFormat("%8s %10s %14s %12s %12s  %s\n", "expr_id",
+                                    "count", "total", "mean", "arena_bytes",
+                                    "description");
+  for (const ExprProfile& entry : Snapshot()) {
+    absl::StrAppendFormat(
+        &out, "%8d %10d %14s %12s %12d  %s\n", entry.expr_id, entry.count,
+        absl::FormatDuration(entry.total_time),
+        absl::FormatDuration(entry.total_time / entry.count),
+        entry.arena_bytes, entry.description);
+  }
+  return out;
+}
+
+void EvaluationProfile::Reset() {
+  absl::MutexLock lock(&mutex_);
+  for (auto& [expr_id, entry] : entries_) {
+    entry.counters.count.store(0, std::memory_order_relaxed);
+    entry.counters.nanos.store(0, std::memory_order_relaxed);
+    entry.counters.arena_bytes.store(0, std::memory_order_relaxed);
+  }
+}
+
+ProgramOptimizerFactory CreateProfilingExtension(
+    std::shared_ptr<EvaluationProfile> profile) {
+  return [profile = std::move(profile)](PlannerContext&,
+                                        const cel::ast_internal::AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    return std::make_unique<ProfileOptimizer>(profile, ast.root_expr().id());
+  };
+}
+
+}  // namespace google::api::expr::runtime
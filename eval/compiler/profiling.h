@@ -0,0 +1,118 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Planner extension for profiling the evaluation of a CEL expression.
+//
+// CEL users should not use this directly.
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PROFILING_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PROFILING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Aggregated profile for a single expression node.
+//
+// Time and arena bytes are inclusive of the node's subexpressions.
+struct ExprProfile {
+  int64_t expr_id;
+  // Short description of the node (e.g. function or identifier name).
+  std::string description;
+  // Number of times the node was evaluated.
+  int64_t count;
+  // Cumulative wall time spent evaluating the node.
+  absl::Duration total_time;
+  // Cumulative bytes allocated by the evaluation, as counted against
+  // `RuntimeOptions::max_evaluation_bytes` if it is set. Otherwise the growth
+  // of the evaluation arena (if the evaluation uses a google::protobuf::Arena
+  // based memory manager).
+  int64_t arena_bytes;
+};
+
+// Thread-safe sink for per-node evaluation statistics.
+//
+// Statistics are keyed by expr id and aggregated across all evaluations of
+// the programs planned with the associated extension. A profile should only
+// be shared between programs planned from the same AST, otherwise the expr
+// ids are ambiguous.
+//
+// Expr ids can be mapped back to the source AST with `NavigableAst::FindId`.
+class EvaluationProfile {
+ public:
+  // Counters for a single node. Updated without locking during evaluation.
+  struct Counters {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> nanos{0};
+    std::atomic<int64_t> arena_bytes{0};
+  };
+
+  EvaluationProfile() = default;
+
+  EvaluationProfile(const EvaluationProfile&) = delete;
+  EvaluationProfile& operator=(const EvaluationProfile&) = delete;
+
+  // Returns the counters for the given expr id, creating them if needed.
+  //
+  // The returned reference is stable for the lifetime of the profile. Used by
+  // the profiling extension at plan time.
+  Counters& GetOrCreateCounters(int64_t expr_id,
+                                absl::string_view description)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns a snapshot of the recorded statistics ordered by descending total
+  // time. Nodes that were never evaluated are omitted.
+  std::vector<ExprProfile> Snapshot() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Formats the snapshot as a flat, human readable table.
+  std::string FormatTable() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Resets all counters to zero.
+  void Reset() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    std::string description;
+    Counters counters;
+  };
+
+  mutable absl::Mutex mutex_;
+  absl::node_hash_map<int64_t, Entry> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Create a new profiling extension recording into the given profile.
+//
+// Each planned node is bracketed with steps that record its call count,
+// elapsed time and arena growth. This adds overhead to every step so should
+// only be used for diagnostics. For recursively planned programs, the direct
+// steps are wrapped instead.
+//
+// Like the instrumentation extension, this should typically be added last if
+// any program optimizations are applied.
+ProgramOptimizerFactory CreateProfilingExtension(
+    std::shared_ptr<EvaluationProfile> profile);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_PROFILING_H_
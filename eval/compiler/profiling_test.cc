@@ -0,0 +1,155 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/profiling.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/time/time.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::Field;
+using testing::HasSubstr;
+using testing::UnorderedElementsAre;
+
+class ProfilingTest : public testing::TestWithParam<bool> {
+ public:
+  ProfilingTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {}
+
+  void SetUp() override {
+    if (GetParam()) {
+      options_.max_recursion_depth = -1;
+    }
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+std::vector<int64_t> ProfiledIds(const EvaluationProfile& profile) {
+  std::vector<int64_t> ids;
+  for (const ExprProfile& entry : profile.Snapshot()) {
+    ids.push_back(entry.expr_id);
+  }
+  return ids;
+}
+
+TEST_P(ProfilingTest, CountsEvaluations) {
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  auto profile = std::make_shared<EvaluationProfile>();
+  builder.AddProgramOptimizer(CreateProfilingExtension(profile));
+
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("1 + 2 == 3"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateExpressionImpl(std::move(ast),
+                                                    /*issues=*/nullptr));
+
+  cel::Activation activation;
+  for (int i = 0; i < 3; ++i) {
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    ASSERT_OK_AND_ASSIGN(
+        auto value,
+        plan.EvaluateWithCallback(activation, EvaluationListener(), state));
+    ASSERT_TRUE(value->Is<BoolValue>() && value->As<BoolValue>().NativeValue());
+  }
+
+  // AST for the test expression:
+  //            == <4>
+  //           /     \
+  //        +<2>     3<5>
+  //       /    \
+  //    1<1>   2<3>
+  EXPECT_THAT(ProfiledIds(*profile), UnorderedElementsAre(1, 2, 3, 4, 5));
+  std::vector<ExprProfile> snapshot = profile->Snapshot();
+  absl::Duration root_time = absl::ZeroDuration();
+  for (const ExprProfile& entry : snapshot) {
+    EXPECT_EQ(entry.count, 3) << entry.expr_id;
+    if (entry.expr_id == 4) {
+      root_time = entry.total_time;
+    }
+  }
+  // Time is inclusive, so the root is the most expensive node.
+  EXPECT_EQ(snapshot.front().total_time, root_time);
+
+  EXPECT_THAT(profile->FormatTable(), HasSubstr("_==_()"));
+
+  profile->Reset();
+  EXPECT_THAT(profile->Snapshot(), testing::IsEmpty());
+}
+
+TEST_P(ProfilingTest, ShortCircuitedBranchNotCounted) {
+  FlatExprBuilder builder(function_registry_, type_registry_, options_);
+  auto profile = std::make_shared<EvaluationProfile>();
+  builder.AddProgramOptimizer(CreateProfilingExtension(profile));
+
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("false && (1 + 2 == 3)"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       cel::extensions::CreateAstFromParsedExpr(expr));
+  ASSERT_OK_AND_ASSIGN(auto plan,
+                       builder.CreateExpressionImpl(std::move(ast),
+                                                    /*issues=*/nullptr));
+
+  auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+  cel::Activation activation;
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      plan.EvaluateWithCallback(activation, EvaluationListener(), state));
+  ASSERT_TRUE(value->Is<BoolValue>() && !value->As<BoolValue>().NativeValue());
+
+  // AST for the test expression:
+  //            && <2>
+  //           /     \
+  //     false<1>    == <6>
+  //                   ...
+  EXPECT_THAT(profile->Snapshot(),
+              UnorderedElementsAre(Field(&ExprProfile::expr_id, 1),
+                                   Field(&ExprProfile::expr_id, 2)));
+}
+
+INSTANTIATE_TEST_SUITE_P(ProfilingTest, ProfilingTest, testing::Bool());
+
+}  // namespace
+}  // namespace google::api::expr::runtime
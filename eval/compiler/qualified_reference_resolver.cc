@@ -27,6 +27,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/ast.h"
 #include "base/ast_internal/ast_impl.h"
 #include "base/ast_internal/expr.h"
@@ -35,6 +36,7 @@
 #include "common/ast_rewrite.h"
 #include "eval/compiler/flat_expr_builder_extensions.h"
 #include "eval/compiler/resolver.h"
+#include "eval/compiler/rule_set.h"
 #include "runtime/internal/issue_collector.h"
 #include "runtime/runtime_issue.h"
 
@@ -58,7 +60,8 @@ bool IsSpecialFunction(absl::string_view function_name) {
          function_name == cel::builtin::kOr ||
          function_name == cel::builtin::kIndex ||
          function_name == cel::builtin::kTernary ||
-         function_name == kOptionalOr || function_name == kOptionalOrValue;
+         function_name == kOptionalOr || function_name == kOptionalOrValue ||
+         function_name == kRuleSetFunction;
 }
 
 bool OverloadExists(const Resolver& resolver, absl::string_view name,
@@ -80,7 +83,8 @@ absl::optional<std::string> BestOverloadMatch(const Resolver& resolver,
   }
   auto arguments_matcher = ArgumentsMatcher(argument_count);
   // Check from most qualified to least qualified for a matching overload.
-  auto names = resolver.FullyQualifiedNames(base_name);
+  absl::Span<const std::string> names =
+      resolver.QualifiedNameCandidates(base_name);
   for (auto name = names.begin(); name != names.end(); ++name) {
     if (OverloadExists(resolver, *name, arguments_matcher)) {
       if (base_name[0] == '.') {
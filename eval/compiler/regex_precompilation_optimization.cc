@@ -14,6 +14,7 @@
 
 #include "eval/compiler/regex_precompilation_optimization.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -23,12 +24,19 @@
 
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "absl/types/optional.h"
 #include "base/ast_internal/ast_impl.h"
 #include "base/ast_internal/expr.h"
 #include "base/builtins.h"
+#include "common/ast_traverse.h"
+#include "common/ast_visitor_base.h"
 #include "common/native_type.h"
 #include "common/value.h"
 #include "eval/compiler/flat_expr_builder_extensions.h"
@@ -37,8 +45,10 @@
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/regex_match_step.h"
 #include "internal/casts.h"
+#include "internal/regex_cache.h"
 #include "internal/status_macros.h"
 #include "re2/re2.h"
+#include "re2/set.h"
 
 namespace google::api::expr::runtime {
 namespace {
@@ -50,6 +60,7 @@ using ::cel::StringValue;
 using ::cel::Value;
 using ::cel::ast_internal::AstImpl;
 using ::cel::ast_internal::Call;
+using ::cel::ast_internal::Comprehension;
 using ::cel::ast_internal::Expr;
 using ::cel::ast_internal::Reference;
 using ::cel::internal::down_cast;
@@ -86,13 +97,178 @@ bool IsFunctionOverload(const Expr& expr, absl::string_view function,
   return false;
 }
 
+bool IsLogicalOr(const Expr& expr) {
+  return expr.has_call_expr() && !expr.call_expr().has_target() &&
+         expr.call_expr().function() == cel::builtin::kOr &&
+         expr.call_expr().args().size() == 2;
+}
+
+const Expr& MatchSubject(const Expr& match_call) {
+  const Call& call_expr = match_call.call_expr();
+  return call_expr.has_target() ? call_expr.target() : call_expr.args().front();
+}
+
+const Expr& MatchPattern(const Expr& match_call) {
+  return match_call.call_expr().args().back();
+}
+
+bool IsConstantString(const Expr& expr) {
+  return expr.has_const_expr() && expr.const_expr().has_string_value();
+}
+
+bool IsIdent(const Expr& expr, absl::string_view name) {
+  return expr.has_ident_expr() && expr.ident_expr().name() == name;
+}
+
+// Identifiers and field selections on them are free of side effects, so
+// evaluating them once instead of once per disjunct doesn't change the result.
+bool IsSimpleOperand(const Expr& expr) {
+  if (expr.has_ident_expr()) {
+    return true;
+  }
+  return expr.has_select_expr() && !expr.select_expr().test_only() &&
+         IsSimpleOperand(expr.select_expr().operand());
+}
+
+bool SameSimpleOperand(const Expr& lhs, const Expr& rhs) {
+  if (lhs.has_ident_expr()) {
+    return IsIdent(rhs, lhs.ident_expr().name());
+  }
+  return rhs.has_select_expr() && !rhs.select_expr().test_only() &&
+         lhs.select_expr().field() == rhs.select_expr().field() &&
+         SameSimpleOperand(lhs.select_expr().operand(),
+                           rhs.select_expr().operand());
+}
+
+// Returns the dot-qualified name of a simple operand, e.g. "request.url".
+std::string SimpleOperandPath(const Expr& simple_operand) {
+  if (simple_operand.has_select_expr()) {
+    return absl::StrCat(
+        SimpleOperandPath(simple_operand.select_expr().operand()), ".",
+        simple_operand.select_expr().field());
+  }
+  return simple_operand.ident_expr().name();
+}
+
+const std::string& RootIdentName(const Expr& simple_operand) {
+  if (simple_operand.has_select_expr()) {
+    return RootIdentName(simple_operand.select_expr().operand());
+  }
+  return simple_operand.ident_expr().name();
+}
+
+void CollectDisjuncts(const Expr& expr, std::vector<const Expr*>& disjuncts,
+                      std::vector<const Expr*>& inner_nodes) {
+  if (!IsLogicalOr(expr)) {
+    disjuncts.push_back(&expr);
+    return;
+  }
+  inner_nodes.push_back(&expr);
+  for (const Expr& arg : expr.call_expr().args()) {
+    CollectDisjuncts(arg, disjuncts, inner_nodes);
+  }
+}
+
+struct LiteralPattern {
+  LiteralMatchKind kind;
+  std::string literal;
+};
+
+bool IsRegexMetacharacter(char c) {
+  switch (c) {
+    case '\\':
+    case '.':
+    case '^':
+    case '$':
+    case '|':
+    case '?':
+    case '*':
+    case '+':
+    case '(':
+    case ')':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsPrintableAscii(char c) { return c >= 0x20 && c < 0x7f; }
+
+// Returns the literal matched by the pattern if it consists of printable
+// ASCII characters and escaped punctuation only, optionally anchored with a
+// leading '^' and/or a trailing '$'.
+//
+// Without the multi-line flag, RE2 anchors only match at the beginning and
+// end of the text, so these patterns are exactly prefix, suffix, equality and
+// substring tests.
+absl::optional<LiteralPattern> ClassifyLiteralPattern(
+    absl::string_view pattern) {
+  bool anchored_start = absl::ConsumePrefix(&pattern, "^");
+  bool anchored_end = false;
+
+  std::string literal;
+  literal.reserve(pattern.size());
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    char c = pattern[i];
+    if (c == '\\') {
+      if (++i == pattern.size()) {
+        return absl::nullopt;
+      }
+      c = pattern[i];
+      // Escaped letters and digits are character classes or assertions.
+      if (!IsPrintableAscii(c) || absl::ascii_isalnum(c)) {
+        return absl::nullopt;
+      }
+      literal.push_back(c);
+      continue;
+    }
+    if (c == '$' && i + 1 == pattern.size()) {
+      anchored_end = true;
+      continue;
+    }
+    if (!IsPrintableAscii(c) || IsRegexMetacharacter(c)) {
+      return absl::nullopt;
+    }
+    literal.push_back(c);
+  }
+
+  LiteralMatchKind kind = LiteralMatchKind::kContains;
+  if (anchored_start && anchored_end) {
+    kind = LiteralMatchKind::kExact;
+  } else if (anchored_start) {
+    kind = LiteralMatchKind::kPrefix;
+  } else if (anchored_end) {
+    kind = LiteralMatchKind::kSuffix;
+  }
+  return LiteralPattern{kind, std::move(literal)};
+}
+
+// A disjunction of matches() calls on the same operand that can be evaluated
+// with a single RE2::Set scan.
+struct MatchDisjunction {
+  const Expr* subject;
+  std::vector<std::string> patterns;
+  // Whether the patterns were matched by the original plan regardless of the
+  // input. Invalid patterns are reported at plan time for these, the same as
+  // for individual matches() calls.
+  bool report_errors;
+};
+
 // Abstraction for deduplicating regular expressions over the course of a single
 // create expression call. Should not be used during evaluation. Uses
 // std::shared_ptr and std::weak_ptr.
+//
+// If a cache is provided, programs are also shared with other create
+// expression calls and with dynamic matches() calls.
 class RegexProgramBuilder final {
  public:
-  explicit RegexProgramBuilder(int max_program_size)
-      : max_program_size_(max_program_size) {}
+  RegexProgramBuilder(int max_program_size,
+                      absl::Nullable<cel::internal::RegexCache*> cache)
+      : max_program_size_(max_program_size), cache_(cache) {}
 
   absl::StatusOr<std::shared_ptr<const RE2>> BuildRegexProgram(
       std::string pattern) {
@@ -103,7 +279,9 @@ class RegexProgramBuilder final {
       }
       programs_.erase(existing);
     }
-    auto program = std::make_shared<RE2>(pattern);
+    std::shared_ptr<const RE2> program =
+        cache_ != nullptr ? cache_->GetOrCompile(pattern)
+                          : std::make_shared<const RE2>(pattern);
     if (max_program_size_ > 0 && program->ProgramSize() > max_program_size_) {
       return absl::InvalidArgumentError("exceeded RE2 max program size");
     }
@@ -117,21 +295,112 @@ class RegexProgramBuilder final {
 
  private:
   const int max_program_size_;
+  absl::Nullable<cel::internal::RegexCache*> cache_;
   absl::flat_hash_map<std::string, std::weak_ptr<const RE2>> programs_;
 };
 
+// Distinct constant patterns matched against one operand throughout a
+// program, which share a single scan of the operand.
+struct SharedScan {
+  std::vector<std::string> patterns;
+  // Index of each pattern in `patterns`.
+  absl::flat_hash_map<std::string, size_t> indices;
+  // Built on first use. Null if the patterns couldn't be compiled into a set.
+  std::shared_ptr<const RegexSet> regex_set;
+  bool built = false;
+};
+
+// Collects the constant, non-literal patterns of the matches() calls in a
+// program by operand.
+class MatchPatternCollector : public cel::AstVisitorBase {
+ public:
+  explicit MatchPatternCollector(const ReferenceMap& reference_map)
+      : reference_map_(reference_map) {}
+
+  void PreVisitExpr(const Expr&) override {}
+
+  void PostVisitExpr(const Expr&) override {}
+
+  void PreVisitSelect(const Expr&, const cel::SelectExpr&) override {}
+
+  void PostVisitCall(const Expr& expr, const Call& call) override {
+    if (!IsFunctionOverload(expr, cel::builtin::kRegexMatch, "matches_string",
+                            2, reference_map_) ||
+        !IsSimpleOperand(MatchSubject(expr)) ||
+        !IsConstantString(MatchPattern(expr))) {
+      return;
+    }
+    const std::string& pattern =
+        MatchPattern(expr).const_expr().string_value();
+    if (ClassifyLiteralPattern(pattern).has_value()) {
+      // Literal patterns don't run the regex engine at all.
+      return;
+    }
+    SharedScan& scan = scans_[SimpleOperandPath(MatchSubject(expr))];
+    if (scan.indices.insert({pattern, scan.patterns.size()}).second) {
+      scan.patterns.push_back(pattern);
+    }
+  }
+
+  // Returns the operands with at least `min_patterns` patterns.
+  absl::flat_hash_map<std::string, SharedScan> TakeScans(size_t min_patterns) {
+    absl::erase_if(scans_, [min_patterns](const auto& entry) {
+      return entry.second.patterns.size() < min_patterns;
+    });
+    return std::move(scans_);
+  }
+
+ private:
+  const ReferenceMap& reference_map_;
+  absl::flat_hash_map<std::string, SharedScan> scans_;
+};
+
+// A pattern's slot in a shared scan.
+struct ScanSlot {
+  std::shared_ptr<const RegexSet> regex_set;
+  size_t index;
+};
+
 class RegexPrecompilationOptimization : public ProgramOptimizer {
  public:
-  explicit RegexPrecompilationOptimization(const ReferenceMap& reference_map,
-                                           int regex_max_program_size)
-      : reference_map_(reference_map),
-        regex_program_builder_(regex_max_program_size) {}
+  RegexPrecompilationOptimization(
+      const AstImpl& ast, int regex_max_program_size,
+      absl::Nullable<cel::internal::RegexCache*> regex_cache,
+      int shared_scan_min_patterns)
+      : reference_map_(ast.reference_map()),
+        regex_program_builder_(regex_max_program_size, regex_cache) {
+    if (shared_scan_min_patterns > 0) {
+      MatchPatternCollector collector(reference_map_);
+      cel::AstTraverse(ast.root_expr(), collector);
+      // A single pattern gains nothing from a set.
+      shared_scans_ = collector.TakeScans(
+          std::max<size_t>(2, static_cast<size_t>(shared_scan_min_patterns)));
+    }
+  }
 
   absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    if (claimed_.contains(node.id())) {
+      return absl::OkStatus();
+    }
+    if (IsLogicalOr(node)) {
+      MaybeClaimDisjunction(node);
+    } else if (node.has_comprehension_expr()) {
+      MaybeClaimExists(node);
+    }
     return absl::OkStatus();
   }
 
   absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (auto it = disjunctions_.find(node.id()); it != disjunctions_.end()) {
+      MatchDisjunction disjunction = std::move(it->second);
+      disjunctions_.erase(it);
+      return RewriteDisjunction(context, node, disjunction);
+    }
+    if (claimed_.contains(node.id())) {
+      // Handled as part of the enclosing disjunction.
+      return absl::OkStatus();
+    }
+
     // Check that this is the correct matches overload instead of a user defined
     // overload.
     if (!IsFunctionOverload(node, cel::builtin::kRegexMatch, "matches_string",
@@ -165,11 +434,246 @@ class RegexPrecompilationOptimization : public ProgramOptimizer {
     const Expr& subject_expr =
         call_expr.has_target() ? call_expr.target() : call_expr.args().front();
 
+    CEL_ASSIGN_OR_RETURN(absl::optional<ScanSlot> scan,
+                         FindSharedScan(subject_expr, *regex_program));
     return RewritePlan(context, subexpression, node, subject_expr,
-                       std::move(regex_program));
+                       std::move(regex_program), std::move(scan));
   }
 
  private:
+  bool IsConstantMatch(const Expr& expr) const {
+    return IsFunctionOverload(expr, cel::builtin::kRegexMatch,
+                              "matches_string", 2, reference_map_) &&
+           IsSimpleOperand(MatchSubject(expr));
+  }
+
+  // Records `a.matches(r1) || a.matches(r2) || ...` for rewriting, where all of
+  // the patterns are constant.
+  void MaybeClaimDisjunction(const Expr& node) {
+    std::vector<const Expr*> disjuncts;
+    std::vector<const Expr*> inner_nodes;
+    CollectDisjuncts(node, disjuncts, inner_nodes);
+
+    const Expr& subject = MatchSubject(*disjuncts.front());
+    MatchDisjunction disjunction{&subject, {}, /*report_errors=*/true};
+    for (const Expr* disjunct : disjuncts) {
+      if (!IsConstantMatch(*disjunct) ||
+          !IsConstantString(MatchPattern(*disjunct)) ||
+          !SameSimpleOperand(subject, MatchSubject(*disjunct))) {
+        return;
+      }
+      disjunction.patterns.push_back(
+          MatchPattern(*disjunct).const_expr().string_value());
+    }
+
+    for (const Expr* inner_node : inner_nodes) {
+      claimed_.insert(inner_node->id());
+    }
+    for (const Expr* disjunct : disjuncts) {
+      claimed_.insert(disjunct->id());
+    }
+    disjunctions_.insert({node.id(), std::move(disjunction)});
+  }
+
+  // Records `[r1, r2, ...].exists(r, a.matches(r))` for rewriting, where the
+  // list is a literal of constant strings.
+  void MaybeClaimExists(const Expr& node) {
+    const Comprehension& comprehension = node.comprehension_expr();
+    const std::string& accu_var = comprehension.accu_var();
+    const std::string& iter_var = comprehension.iter_var();
+
+    const Expr& init = comprehension.accu_init();
+    if (!init.has_const_expr() || !init.const_expr().has_bool_value() ||
+        init.const_expr().bool_value()) {
+      return;
+    }
+    if (!IsIdent(comprehension.result(), accu_var)) {
+      return;
+    }
+    const Expr& condition = comprehension.loop_condition();
+    if (!condition.has_call_expr() ||
+        condition.call_expr().function() != cel::builtin::kNotStrictlyFalse ||
+        condition.call_expr().args().size() != 1) {
+      return;
+    }
+    const Expr& negation = condition.call_expr().args().front();
+    if (!negation.has_call_expr() ||
+        negation.call_expr().function() != cel::builtin::kNot ||
+        negation.call_expr().args().size() != 1 ||
+        !IsIdent(negation.call_expr().args().front(), accu_var)) {
+      return;
+    }
+    const Expr& step = comprehension.loop_step();
+    if (!IsLogicalOr(step) || !IsIdent(step.call_expr().args()[0], accu_var)) {
+      return;
+    }
+    const Expr& match = step.call_expr().args()[1];
+    if (!IsConstantMatch(match) || !IsIdent(MatchPattern(match), iter_var)) {
+      return;
+    }
+    const Expr& subject = MatchSubject(match);
+    const std::string& subject_root = RootIdentName(subject);
+    if (subject_root == iter_var || subject_root == accu_var) {
+      return;
+    }
+
+    const Expr& range = comprehension.iter_range();
+    if (!range.has_list_expr() || range.list_expr().elements().empty()) {
+      return;
+    }
+    // Patterns are only matched if the range is non-empty, so errors are
+    // left to the original plan.
+    MatchDisjunction disjunction{&subject, {}, /*report_errors=*/false};
+    for (const auto& element : range.list_expr().elements()) {
+      if (element.optional() || !IsConstantString(element.expr())) {
+        return;
+      }
+      disjunction.patterns.push_back(
+          element.expr().const_expr().string_value());
+    }
+    disjunctions_.insert({node.id(), std::move(disjunction)});
+  }
+
+  // Returns the slot of the pattern in the shared scan of the subject, if any.
+  absl::StatusOr<absl::optional<ScanSlot>> FindSharedScan(
+      const Expr& subject, const RE2& regex_program) {
+    if (shared_scans_.empty() || !IsSimpleOperand(subject)) {
+      return absl::nullopt;
+    }
+    auto scan = shared_scans_.find(SimpleOperandPath(subject));
+    if (scan == shared_scans_.end()) {
+      return absl::nullopt;
+    }
+    auto index = scan->second.indices.find(regex_program.pattern());
+    if (index == scan->second.indices.end()) {
+      return absl::nullopt;
+    }
+    if (!scan->second.built) {
+      scan->second.built = true;
+      // Invalid patterns are reported by their own call, the set is just
+      // skipped.
+      CEL_ASSIGN_OR_RETURN(
+          scan->second.regex_set,
+          BuildRegexSet(MatchDisjunction{&subject, scan->second.patterns,
+                                         /*report_errors=*/false}));
+    }
+    if (scan->second.regex_set == nullptr) {
+      return absl::nullopt;
+    }
+    return ScanSlot{scan->second.regex_set, index->second};
+  }
+
+  // Returns nullptr if the set can't be built and the plan is left as is.
+  absl::StatusOr<std::shared_ptr<const RegexSet>> BuildRegexSet(
+      const MatchDisjunction& disjunction) {
+    auto regex_set = std::make_shared<RegexSet>();
+    regex_set->set =
+        std::make_unique<RE2::Set>(RE2::Options(), RE2::UNANCHORED);
+    for (const std::string& pattern : disjunction.patterns) {
+      absl::StatusOr<std::shared_ptr<const RE2>> program =
+          regex_program_builder_.BuildRegexProgram(pattern);
+      if (!program.ok()) {
+        if (disjunction.report_errors) {
+          return std::move(program).status();
+        }
+        return nullptr;
+      }
+      if (regex_set->set->Add(pattern, /*error=*/nullptr) < 0) {
+        return nullptr;
+      }
+      regex_set->programs.push_back(*std::move(program));
+    }
+    if (!regex_set->set->Compile()) {
+      return nullptr;
+    }
+    return regex_set;
+  }
+
+  absl::Status RewriteDisjunction(PlannerContext& context, const Expr& node,
+                                  const MatchDisjunction& disjunction) {
+    CEL_ASSIGN_OR_RETURN(std::shared_ptr<const RegexSet> regex_set,
+                         BuildRegexSet(disjunction));
+    if (regex_set == nullptr) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    if (subexpression->IsRecursive()) {
+      if (!IsLogicalOr(node)) {
+        // Recursive comprehension steps don't expose their dependencies.
+        return absl::OkStatus();
+      }
+      RewriteRecursiveDisjunction(subexpression, node, std::move(regex_set));
+      return absl::OkStatus();
+    }
+
+    if (context.GetSubplan(*disjunction.subject).empty()) {
+      // This subexpression was already optimized, nothing to do.
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan,
+                         context.ExtractSubplan(*disjunction.subject));
+    CEL_ASSIGN_OR_RETURN(
+        new_plan.emplace_back(),
+        CreateRegexSetMatchStep(std::move(regex_set), node.id()));
+    return context.ReplaceSubplan(node, std::move(new_plan));
+  }
+
+  // Checks that the recursive plan for the disjunction has the same shape as
+  // the AST down to the subject of the leftmost matches() call.
+  static bool HasDisjunctionPlan(const DirectExpressionStep* step,
+                                 const Expr* expr) {
+    while (true) {
+      if (step->expr_id() != expr->id()) {
+        return false;
+      }
+      auto deps = step->GetDependencies();
+      if (!deps.has_value() || deps->empty()) {
+        return false;
+      }
+      if (!IsLogicalOr(*expr)) {
+        return deps->front()->expr_id() == MatchSubject(*expr).id();
+      }
+      if (deps->size() != 2) {
+        return false;
+      }
+      step = deps->front();
+      expr = &expr->call_expr().args().front();
+    }
+  }
+
+  void RewriteRecursiveDisjunction(
+      absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
+      const Expr& node, std::shared_ptr<const RegexSet> regex_set) {
+    auto program = subexpression->ExtractRecursiveProgram();
+    if (!HasDisjunctionPlan(program.step.get(), &node)) {
+      // Possibly already modified, put the plan back.
+      subexpression->set_recursive_program(std::move(program.step),
+                                           program.depth);
+      return;
+    }
+
+    std::unique_ptr<DirectExpressionStep> step = std::move(program.step);
+    const Expr* expr = &node;
+    while (IsLogicalOr(*expr)) {
+      step = std::move(step->ExtractDependencies()->front());
+      expr = &expr->call_expr().args().front();
+    }
+    std::unique_ptr<DirectExpressionStep> subject =
+        std::move(step->ExtractDependencies()->front());
+
+    subexpression->set_recursive_program(
+        CreateDirectRegexSetMatchStep(node.id(), std::move(subject),
+                                      std::move(regex_set)),
+        program.depth);
+  }
+
   absl::optional<std::string> GetConstantString(
       PlannerContext& context,
       absl::Nullable<ProgramBuilder::Subexpression*> subexpression,
@@ -216,19 +720,19 @@ class RegexPrecompilationOptimization : public ProgramOptimizer {
       PlannerContext& context,
       absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
       const Expr& call, const Expr& subject,
-      std::shared_ptr<const RE2> regex_program) {
+      std::shared_ptr<const RE2> regex_program, absl::optional<ScanSlot> scan) {
     if (subexpression->IsRecursive()) {
       return RewriteRecursivePlan(subexpression, call, subject,
-                                  std::move(regex_program));
+                                  std::move(regex_program), std::move(scan));
     }
     return RewriteStackMachinePlan(context, call, subject,
-                                   std::move(regex_program));
+                                   std::move(regex_program), std::move(scan));
   }
 
   absl::Status RewriteRecursivePlan(
       absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
       const Expr& call, const Expr& subject,
-      std::shared_ptr<const RE2> regex_program) {
+      std::shared_ptr<const RE2> regex_program, absl::optional<ScanSlot> scan) {
     auto program = subexpression->ExtractRecursiveProgram();
     auto deps = program.step->ExtractDependencies();
     if (!deps.has_value() || deps->size() != 2) {
@@ -237,16 +741,27 @@ class RegexPrecompilationOptimization : public ProgramOptimizer {
                                            program.depth);
       return absl::OkStatus();
     }
-    subexpression->set_recursive_program(
-        CreateDirectRegexMatchStep(call.id(), std::move(deps->at(0)),
-                                   std::move(regex_program)),
-        program.depth);
+    std::unique_ptr<DirectExpressionStep> step;
+    if (auto literal = ClassifyLiteralPattern(regex_program->pattern());
+        literal.has_value()) {
+      step = CreateDirectLiteralMatchStep(call.id(), std::move(deps->at(0)),
+                                          literal->kind,
+                                          std::move(literal->literal));
+    } else if (scan.has_value()) {
+      step = CreateDirectRegexScanMatchStep(call.id(), std::move(deps->at(0)),
+                                            std::move(scan->regex_set),
+                                            scan->index);
+    } else {
+      step = CreateDirectRegexMatchStep(call.id(), std::move(deps->at(0)),
+                                        std::move(regex_program));
+    }
+    subexpression->set_recursive_program(std::move(step), program.depth);
     return absl::OkStatus();
   }
 
   absl::Status RewriteStackMachinePlan(
       PlannerContext& context, const Expr& call, const Expr& subject,
-      std::shared_ptr<const RE2> regex_program) {
+      std::shared_ptr<const RE2> regex_program, absl::optional<ScanSlot> scan) {
     if (context.GetSubplan(subject).empty()) {
       // This subexpression was already optimized, nothing to do.
       return absl::OkStatus();
@@ -254,15 +769,33 @@ class RegexPrecompilationOptimization : public ProgramOptimizer {
 
     CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan,
                          context.ExtractSubplan(subject));
-    CEL_ASSIGN_OR_RETURN(
-        new_plan.emplace_back(),
-        CreateRegexMatchStep(std::move(regex_program), call.id()));
+    if (auto literal = ClassifyLiteralPattern(regex_program->pattern());
+        literal.has_value()) {
+      CEL_ASSIGN_OR_RETURN(
+          new_plan.emplace_back(),
+          CreateLiteralMatchStep(literal->kind, std::move(literal->literal),
+                                 call.id()));
+    } else if (scan.has_value()) {
+      CEL_ASSIGN_OR_RETURN(
+          new_plan.emplace_back(),
+          CreateRegexScanMatchStep(std::move(scan->regex_set), scan->index,
+                                   call.id()));
+    } else {
+      CEL_ASSIGN_OR_RETURN(
+          new_plan.emplace_back(),
+          CreateRegexMatchStep(std::move(regex_program), call.id()));
+    }
 
     return context.ReplaceSubplan(call, std::move(new_plan));
   }
 
   const ReferenceMap& reference_map_;
   RegexProgramBuilder regex_program_builder_;
+  // Nodes that are rewritten as part of an enclosing disjunction.
+  absl::flat_hash_set<int64_t> claimed_;
+  absl::flat_hash_map<int64_t, MatchDisjunction> disjunctions_;
+  // Keyed by the path of the operand, see SimpleOperandPath.
+  absl::flat_hash_map<std::string, SharedScan> shared_scans_;
 };
 
 }  // namespace
@@ -270,8 +803,14 @@ class RegexPrecompilationOptimization : public ProgramOptimizer {
 ProgramOptimizerFactory CreateRegexPrecompilationExtension(
     int regex_max_program_size) {
   return [=](PlannerContext& context, const AstImpl& ast) {
+    cel::internal::RegexCache* regex_cache = nullptr;
+    if (int capacity = context.options().regex_cache_capacity; capacity > 0) {
+      regex_cache = &cel::internal::RegexCache::Global();
+      regex_cache->EnsureCapacity(capacity);
+    }
     return std::make_unique<RegexPrecompilationOptimization>(
-        ast.reference_map(), regex_max_program_size);
+        ast, regex_max_program_size, regex_cache,
+        context.options().regex_shared_scan_min_patterns);
   };
 }
 }  // namespace google::api::expr::runtime
@@ -21,6 +21,12 @@ namespace google::api::expr::runtime {
 
 // Create a new extension for the FlatExprBuilder that precompiles constant
 // regular expressions used in the standard 'Match' function.
+//
+// Disjunctions of matches() calls on the same identifier or field selection
+// with constant patterns (`a.matches(r1) || a.matches(r2)`), and the
+// equivalent `[r1, r2].exists(r, a.matches(r))` over a list literal, are
+// evaluated with a single RE2::Set scan. The exists() form is only rewritten
+// for stack machine plans.
 ProgramOptimizerFactory CreateRegexPrecompilationExtension(
     int regex_max_program_size);
 
@@ -14,6 +14,7 @@
 
 #include "eval/compiler/regex_precompilation_optimization.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -23,8 +24,12 @@
 #include "google/api/expr/v1alpha1/checked.pb.h"
 #include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "base/ast_internal/ast_impl.h"
 #include "base/ast_internal/expr.h"
+#include "base/attribute.h"
 #include "common/memory.h"
 #include "common/values/legacy_value_manager.h"
 #include "eval/compiler/cel_expression_builder_flat_impl.h"
@@ -37,20 +42,37 @@
 #include "eval/public/cel_expression.h"
 #include "eval/public/cel_options.h"
 #include "eval/public/cel_value.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/regex_cache.h"
+#include "internal/status_macros.h"
 #include "internal/testing.h"
 #include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
 #include "runtime/internal/issue_collector.h"
+#include "runtime/managed_value_factory.h"
 #include "runtime/runtime_issue.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
 #include "google/protobuf/arena.h"
 
 namespace google::api::expr::runtime {
 namespace {
 
+using ::cel::BoolValue;
+using ::cel::ErrorValue;
+using ::cel::IntValue;
 using ::cel::RuntimeIssue;
+using ::cel::StringValue;
+using ::cel::Value;
 using ::cel::ast_internal::CheckedExpr;
+using ::cel::internal::StatusIs;
 using ::cel::runtime_internal::IssueCollector;
 using ::google::api::expr::parser::Parse;
 using testing::ElementsAre;
+using testing::HasSubstr;
 
 namespace exprpb = google::api::expr::v1alpha1;
 
@@ -270,6 +292,316 @@ TEST_P(RegexConstFoldInteropTest, WrongTypeNotOptimized) {
   EXPECT_TRUE(CheckNoMatchingOverloadError(result));
 }
 
+class RegexSetTest : public testing::TestWithParam<bool> {
+ public:
+  RegexSetTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {}
+
+  void SetUp() override {
+    if (EnableRecursivePlanning()) {
+      options_.max_recursion_depth = -1;
+    }
+    options_.regex_max_program_size = 100;
+  }
+
+  bool EnableRecursivePlanning() { return GetParam(); }
+
+ protected:
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 const cel::Activation& activation) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    builder.AddProgramOptimizer(
+        CreateRegexPrecompilationExtension(options_.regex_max_program_size));
+
+    CEL_ASSIGN_OR_RETURN(exprpb::ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromParsedExpr(expr));
+    CEL_ASSIGN_OR_RETURN(auto plan,
+                         builder.CreateExpressionImpl(std::move(ast),
+                                                      /*issues=*/nullptr));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  // Without any registered functions, evaluation only succeeds if the
+  // matches() calls were replaced.
+  void DisableFunctions() { options_.fail_on_warnings = false; }
+
+  absl::Status RegisterFunctions() {
+    return cel::RegisterStandardFunctions(function_registry_, options_);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_P(RegexSetTest, DisjunctionMatchesAny) {
+  ASSERT_OK(RegisterFunctions());
+  constexpr absl::string_view kExpr =
+      "s.matches('^a') || s.matches('b$') || s.matches('c+')";
+  const std::pair<absl::string_view, bool> kCases[] = {
+      {"axx", true}, {"xxb", true}, {"xcx", true}, {"xxx", false}};
+
+  for (const auto& [input, expected] : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("s", StringValue(input));
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(kExpr, activation));
+    ASSERT_TRUE(result.Is<BoolValue>()) << input;
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), expected) << input;
+  }
+}
+
+TEST_P(RegexSetTest, ReplacesDisjunction) {
+  DisableFunctions();
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("xbarx"));
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("s.matches('foo') || s.matches('bar') || s.matches('baz')",
+               activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, DifferentOperandsNotCombined) {
+  DisableFunctions();
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("foo"));
+  activation.InsertOrAssignValue("t", StringValue("bar"));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("s.matches('foo') || t.matches('bar')",
+                                activation));
+
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+}
+
+TEST_P(RegexSetTest, NonStringSubject) {
+  ASSERT_OK(RegisterFunctions());
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", IntValue(1));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("s.matches('foo') || s.matches('bar')",
+                                activation));
+
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue().message(),
+              HasSubstr("No matching overloads"));
+}
+
+TEST_P(RegexSetTest, InvalidPatternInDisjunction) {
+  ASSERT_OK(RegisterFunctions());
+  cel::Activation activation;
+
+  EXPECT_THAT(Evaluate("s.matches('(') || s.matches('bar')", activation),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_P(RegexSetTest, ExistsOverConstantPatterns) {
+  ASSERT_OK(RegisterFunctions());
+  constexpr absl::string_view kExpr = "['^a', 'b$'].exists(p, s.matches(p))";
+  const std::pair<absl::string_view, bool> kCases[] = {
+      {"axx", true}, {"xxb", true}, {"xxx", false}};
+
+  for (const auto& [input, expected] : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("s", StringValue(input));
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(kExpr, activation));
+    ASSERT_TRUE(result.Is<BoolValue>()) << input;
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), expected) << input;
+  }
+}
+
+TEST_P(RegexSetTest, ReplacesExists) {
+  if (EnableRecursivePlanning()) {
+    GTEST_SKIP() << "exists() is only rewritten for stack machine plans";
+  }
+  DisableFunctions();
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("xxb"));
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("['^a', 'b$'].exists(p, s.matches(p))", activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, InvalidPatternInExistsDeferred) {
+  ASSERT_OK(RegisterFunctions());
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("foo"));
+
+  // The invalid pattern is only reported at evaluation, where the error is
+  // absorbed by the later match.
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("['(', 'foo'].exists(p, s.matches(p))", activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, LiteralPatterns) {
+  ASSERT_OK(RegisterFunctions());
+  struct TestCase {
+    absl::string_view pattern;
+    absl::string_view input;
+    bool expected;
+  };
+  const TestCase kCases[] = {
+      {"^foo", "foobar", true},      {"^foo", "barfoo", false},
+      {"bar$", "foobar", true},      {"bar$", "barfoo", false},
+      {"^foo$", "foo", true},        {"^foo$", "foo\n", false},
+      {"oba", "foobar", true},       {"oba", "fooBar", false},
+      {"a\\\\.b", "xa.bx", true}, {"a\\\\.b", "xacbx", false},
+      {"^$", "", true},              {"^$", "x", false},
+      {"", "anything", true},
+  };
+
+  for (const TestCase& test_case : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("s", StringValue(test_case.input));
+    std::string expr = absl::StrCat("s.matches('", test_case.pattern, "')");
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(expr, activation));
+    ASSERT_TRUE(result.Is<BoolValue>()) << expr;
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), test_case.expected)
+        << expr << " with input '" << test_case.input << "'";
+  }
+}
+
+TEST_P(RegexSetTest, ReplacesLiteralPattern) {
+  DisableFunctions();
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("foobar"));
+
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("s.matches('^foo')", activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, SharesProgramsThroughCache) {
+  ASSERT_OK(RegisterFunctions());
+  options_.regex_cache_capacity = 16;
+  cel::internal::RegexCache& cache = cel::internal::RegexCache::Global();
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("cached"));
+
+  const size_t size_before = cache.size();
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(
+        Value result,
+        Evaluate(EnableRecursivePlanning() ? "s.matches('^cached-r$')"
+                                           : "s.matches('^cached-s$')",
+                 activation));
+    ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+    EXPECT_FALSE(result.As<BoolValue>().NativeValue());
+  }
+
+  EXPECT_GE(cache.capacity(), 16);
+  EXPECT_EQ(cache.size(), size_before + 1);
+}
+
+TEST_P(RegexSetTest, SharedScanMatchesEachPattern) {
+  ASSERT_OK(RegisterFunctions());
+  options_.regex_shared_scan_min_patterns = 2;
+  constexpr absl::string_view kExpr =
+      "[s.matches('a+b'), s.matches('c.d'), s.matches('^x[0-9]'), "
+      "t.matches('a+b')]";
+  struct TestCase {
+    absl::string_view s;
+    absl::string_view t;
+    absl::string_view expected;
+  };
+  const TestCase kCases[] = {
+      {"aab", "aab", "[true, false, false, true]"},
+      {"x1cxd", "b", "[false, true, true, false]"},
+      {"", "ab", "[false, false, false, true]"},
+  };
+
+  for (const TestCase& test_case : kCases) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("s", StringValue(test_case.s));
+    activation.InsertOrAssignValue("t", StringValue(test_case.t));
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         Evaluate(absl::StrCat(kExpr, " == ",
+                                               test_case.expected),
+                                  activation));
+    ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+    EXPECT_TRUE(result.As<BoolValue>().NativeValue()) << test_case.s;
+  }
+}
+
+TEST_P(RegexSetTest, SharedScanRescansChangedSubject) {
+  ASSERT_OK(RegisterFunctions());
+  options_.regex_shared_scan_min_patterns = 2;
+  cel::Activation activation;
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("['ab', 'xd', 'ab'].map(x, [x.matches('a.'), x.matches('.d')]) "
+               "== [[true, false], [false, true], [true, false]]",
+               activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, ReplacesMatchesWithSharedScan) {
+  DisableFunctions();
+  options_.regex_shared_scan_min_patterns = 2;
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("aabxcxd"));
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("s.matches('a+b') ? s.matches('c.d') : false", activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, SharedScanPartiallyUnknownSubject) {
+  ASSERT_OK(RegisterFunctions());
+  options_.regex_shared_scan_min_patterns = 2;
+  options_.unknown_processing = cel::UnknownProcessingOptions::kAttributeOnly;
+  cel::Activation activation;
+  activation.InsertOrAssignValue("s", StringValue("aab"));
+  activation.SetUnknownPatterns({cel::AttributePattern(
+      "s", {cel::AttributeQualifierPattern::OfString("f")})});
+
+  // The results don't carry the subject's attribute, so the calls they are
+  // passed to don't see a partially unknown argument.
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("!s.matches('a+b') == s.matches('c.d')", activation));
+
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexSetTest, SharedScanInvalidPattern) {
+  ASSERT_OK(RegisterFunctions());
+  options_.regex_shared_scan_min_patterns = 2;
+  cel::Activation activation;
+
+  EXPECT_THAT(Evaluate("s.matches('(') ? s.matches('a+b') : false",
+                       activation),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+INSTANTIATE_TEST_SUITE_P(RegexSetTest, RegexSetTest, testing::Bool());
+
 INSTANTIATE_TEST_SUITE_P(RegexPrecompilationExtensionTest,
                          RegexPrecompilationExtensionTest, testing::Bool());
 
@@ -28,7 +28,9 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/kind.h"
 #include "common/memory.h"
 #include "common/type.h"
@@ -43,37 +45,78 @@ namespace google::api::expr::runtime {
 
 using ::cel::Value;
 
-Resolver::Resolver(
-    absl::string_view container, const cel::FunctionRegistry& function_registry,
-    const cel::TypeRegistry&, cel::ValueManager& value_factory,
+namespace {
+
+std::vector<std::string> QualifyName(
+    absl::string_view name, absl::Span<const std::string> namespace_prefixes) {
+  std::vector<std::string> names;
+  // Handle the case where the name contains a leading '.' indicating it is
+  // already fully-qualified.
+  if (absl::StartsWith(name, ".")) {
+    names.push_back(std::string(name.substr(1)));
+    return names;
+  }
+
+  // namespace prefixes is guaranteed to contain at least empty string, so this
+  // function will always produce at least one result.
+  names.reserve(namespace_prefixes.size());
+  for (const auto& prefix : namespace_prefixes) {
+    names.push_back(absl::StrCat(prefix, name));
+  }
+  return names;
+}
+
+}  // namespace
+
+const std::vector<std::string>* QualifiedNameCache::FindOrInsert(
+    absl::string_view name,
+    absl::Span<const std::string> namespace_prefixes) const {
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    if (auto it = names_.find(name); it != names_.end()) {
+      return &it->second;
+    }
+    if (names_.size() >= kMaxSize) {
+      return nullptr;
+    }
+  }
+  std::vector<std::string> qualified_names =
+      QualifyName(name, namespace_prefixes);
+  absl::MutexLock lock(&mutex_);
+  if (auto it = names_.find(name); it != names_.end()) {
+    return &it->second;
+  }
+  if (names_.size() >= kMaxSize) {
+    return nullptr;
+  }
+  return &names_.try_emplace(name, std::move(qualified_names)).first->second;
+}
+
+std::shared_ptr<const ContainerNames> ComputeContainerNames(
+    absl::string_view container,
     const absl::flat_hash_map<std::string, cel::TypeRegistry::Enumeration>&
-        resolveable_enums,
-    bool resolve_qualified_type_identifiers)
-    : namespace_prefixes_(),
-      enum_value_map_(),
-      function_registry_(function_registry),
-      value_factory_(value_factory),
-      resolveable_enums_(resolveable_enums),
-      resolve_qualified_type_identifiers_(resolve_qualified_type_identifiers) {
-  // The constructor for the registry determines the set of possible namespace
-  // prefixes which may appear within the given expression container, and also
-  // eagerly maps possible enum names to enum values.
+        resolveable_enums) {
+  // Determines the set of possible namespace prefixes which may appear within
+  // the given expression container, and eagerly maps possible enum names to
+  // enum values.
+  auto names = std::make_shared<ContainerNames>();
 
   auto container_elements = absl::StrSplit(container, '.');
   std::string prefix = "";
-  namespace_prefixes_.push_back(prefix);
+  names->namespace_prefixes.push_back(prefix);
   for (const auto& elem : container_elements) {
     // Tolerate trailing / leading '.'.
     if (elem.empty()) {
       continue;
     }
     absl::StrAppend(&prefix, elem, ".");
-    namespace_prefixes_.insert(namespace_prefixes_.begin(), prefix);
+    names->namespace_prefixes.insert(names->namespace_prefixes.begin(),
+                                     prefix);
   }
 
-  for (const auto& prefix : namespace_prefixes_) {
-    for (auto iter = resolveable_enums_.begin();
-         iter != resolveable_enums_.end(); ++iter) {
+  for (const auto& prefix : names->namespace_prefixes) {
+    for (auto iter = resolveable_enums.begin(); iter != resolveable_enums.end();
+         ++iter) {
       absl::string_view enum_name = iter->first;
       if (!absl::StartsWith(enum_name, prefix)) {
         continue;
@@ -85,49 +128,71 @@ Resolver::Resolver(
       for (const auto& enumerator : enum_type.enumerators) {
         auto key = absl::StrCat(remainder, !remainder.empty() ? "." : "",
                                 enumerator.name);
-        enum_value_map_[key] = value_factory.CreateIntValue(enumerator.number);
+        names->enum_values[key] = cel::IntValue(enumerator.number);
       }
     }
   }
+  return names;
 }
 
+Resolver::Resolver(
+    absl::string_view container, const cel::FunctionRegistry& function_registry,
+    const cel::TypeRegistry& type_registry, cel::ValueManager& value_factory,
+    const absl::flat_hash_map<std::string, cel::TypeRegistry::Enumeration>&
+        resolveable_enums,
+    bool resolve_qualified_type_identifiers)
+    : Resolver(ComputeContainerNames(container, resolveable_enums),
+               function_registry, type_registry, value_factory,
+               resolve_qualified_type_identifiers) {}
+
+Resolver::Resolver(std::shared_ptr<const ContainerNames> names,
+                   const cel::FunctionRegistry& function_registry,
+                   const cel::TypeRegistry&, cel::ValueManager& value_factory,
+                   bool resolve_qualified_type_identifiers)
+    : names_(std::move(names)),
+      function_registry_(function_registry),
+      value_factory_(value_factory),
+      resolve_qualified_type_identifiers_(resolve_qualified_type_identifiers) {}
+
 std::vector<std::string> Resolver::FullyQualifiedNames(absl::string_view name,
                                                        int64_t expr_id) const {
   // TODO(issues/105): refactor the reference resolution into this method.
   // and handle the case where this id is in the reference map as either a
   // function name or identifier name.
-  std::vector<std::string> names;
-  // Handle the case where the name contains a leading '.' indicating it is
-  // already fully-qualified.
-  if (absl::StartsWith(name, ".")) {
-    std::string fully_qualified_name = std::string(name.substr(1));
-    names.push_back(fully_qualified_name);
-    return names;
-  }
+  absl::Span<const std::string> names = QualifiedNameCandidates(name);
+  return std::vector<std::string>(names.begin(), names.end());
+}
 
-  // namespace prefixes is guaranteed to contain at least empty string, so this
-  // function will always produce at least one result.
-  for (const auto& prefix : namespace_prefixes_) {
-    std::string fully_qualified_name = absl::StrCat(prefix, name);
-    names.push_back(fully_qualified_name);
+absl::Span<const std::string> Resolver::QualifiedNameCandidates(
+    absl::string_view name) const {
+  if (const std::vector<std::string>* names =
+          names_->qualified_names.FindOrInsert(name,
+                                               names_->namespace_prefixes);
+      names != nullptr) {
+    return *names;
   }
-  return names;
+  if (auto it = uncached_names_.find(name); it != uncached_names_.end()) {
+    return it->second;
+  }
+  return uncached_names_
+      .try_emplace(name, QualifyName(name, names_->namespace_prefixes))
+      .first->second;
 }
 
 absl::optional<cel::Value> Resolver::FindConstant(absl::string_view name,
                                                   int64_t expr_id) const {
-  auto names = FullyQualifiedNames(name, expr_id);
-  for (const auto& name : names) {
+  for (const auto& qualified_name : QualifiedNameCandidates(name)) {
     // Attempt to resolve the fully qualified name to a known enum.
-    auto enum_entry = enum_value_map_.find(name);
-    if (enum_entry != enum_value_map_.end()) {
+    auto enum_entry = names_->enum_values.find(qualified_name);
+    if (enum_entry != names_->enum_values.end()) {
       return enum_entry->second;
     }
     // Conditionally resolve fully qualified names as type values if the option
     // to do so is configured in the expression builder. If the type name is
     // not qualified, then it too may be returned as a constant value.
-    if (resolve_qualified_type_identifiers_ || !absl::StrContains(name, ".")) {
-      auto type_value = value_factory_.FindType(name);
+    if (resolve_qualified_type_identifiers_ ||
+        !absl::StrContains(qualified_name, ".")) {
+      auto type_value = value_factory_.FindType(qualified_name);
       if (type_value.ok() && type_value->has_value()) {
         return value_factory_.CreateTypeValue(**type_value);
       }
@@ -143,7 +208,7 @@ std::vector<cel::FunctionOverloadReference> Resolver::FindOverloads(
   // Resolve the fully qualified names and then search the function registry
   // for possible matches.
   std::vector<cel::FunctionOverloadReference> funcs;
-  auto names = FullyQualifiedNames(name, expr_id);
+  absl::Span<const std::string> names = QualifiedNameCandidates(name);
   for (auto it = names.begin(); it != names.end(); it++) {
     // Only one set of overloads is returned along the namespace hierarchy as
     // the function name resolution follows the same behavior as variable name
@@ -164,9 +229,9 @@ std::vector<cel::FunctionRegistry::LazyOverload> Resolver::FindLazyOverloads(
   // Resolve the fully qualified names and then search the function registry
   // for possible matches.
   std::vector<cel::FunctionRegistry::LazyOverload> funcs;
-  auto names = FullyQualifiedNames(name, expr_id);
-  for (const auto& name : names) {
-    funcs = function_registry_.FindLazyOverloads(name, receiver_style, types);
+  for (const auto& qualified_name : QualifiedNameCandidates(name)) {
+    funcs = function_registry_.FindLazyOverloads(qualified_name,
+                                                 receiver_style, types);
     if (!funcs.empty()) {
       return funcs;
     }
@@ -176,12 +241,11 @@ std::vector<cel::FunctionRegistry::LazyOverload> Resolver::FindLazyOverloads(
 
 absl::StatusOr<absl::optional<std::pair<std::string, cel::Type>>>
 Resolver::FindType(absl::string_view name, int64_t expr_id) const {
-  auto qualified_names = FullyQualifiedNames(name, expr_id);
-  for (auto& qualified_name : qualified_names) {
+  for (const auto& qualified_name : QualifiedNameCandidates(name)) {
     CEL_ASSIGN_OR_RETURN(auto maybe_type,
                          value_factory_.FindType(qualified_name));
     if (maybe_type.has_value()) {
-      return std::make_pair(std::move(qualified_name), std::move(*maybe_type));
+      return std::make_pair(qualified_name, std::move(*maybe_type));
     }
   }
   return absl::nullopt;
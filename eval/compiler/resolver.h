@@ -15,15 +15,21 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_RESOLVER_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_RESOLVER_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/kind.h"
 #include "common/value.h"
 #include "common/value_manager.h"
@@ -33,6 +39,49 @@
 
 namespace google::api::expr::runtime {
 
+// Memoizes the candidate qualified names of the names looked up within a
+// container, so that they are only built once for all the expressions sharing
+// the container. Thread-safe.
+class QualifiedNameCache {
+ public:
+  // Upper bound on the number of names memoized.
+  static constexpr size_t kMaxSize = size_t{1} << 14;
+
+  QualifiedNameCache() = default;
+
+  QualifiedNameCache(const QualifiedNameCache&) = delete;
+  QualifiedNameCache& operator=(const QualifiedNameCache&) = delete;
+
+  // Returns the candidates of `name` for `namespace_prefixes`, computing them
+  // if needed. Returns nullptr if `name` is not memoized and the cache is full.
+  // The result is valid for the lifetime of the cache.
+  const std::vector<std::string>* FindOrInsert(
+      absl::string_view name,
+      absl::Span<const std::string> namespace_prefixes) const;
+
+ private:
+  mutable absl::Mutex mutex_;
+  mutable absl::node_hash_map<std::string, std::vector<std::string>> names_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// The names resolvable within an expression container: the candidate
+// namespace prefixes, most qualified first, and the enum constants keyed by
+// their name relative to one of the prefixes.
+//
+// These only depend on the container and the registered enums, so they can be
+// computed once and shared by the resolvers of many expressions.
+struct ContainerNames {
+  std::vector<std::string> namespace_prefixes;
+  absl::flat_hash_map<std::string, cel::Value> enum_values;
+  QualifiedNameCache qualified_names;
+};
+
+std::shared_ptr<const ContainerNames> ComputeContainerNames(
+    absl::string_view container,
+    const absl::flat_hash_map<std::string, cel::TypeRegistry::Enumeration>&
+        resolveable_enums);
+
 // Resolver assists with finding functions and types within a container.
 //
 // This class builds on top of the cel::FunctionRegistry and cel::TypeRegistry
@@ -51,6 +100,14 @@ class Resolver {
           resolveable_enums,
       bool resolve_qualified_type_identifiers = true);
 
+  // Creates a resolver with names computed beforehand by
+  // ComputeContainerNames.
+  Resolver(std::shared_ptr<const ContainerNames> names,
+           const cel::FunctionRegistry& function_registry,
+           const cel::TypeRegistry& type_registry,
+           cel::ValueManager& value_factory,
+           bool resolve_qualified_type_identifiers = true);
+
   ~Resolver() = default;
 
   // FindConstant will return an enum constant value or a type value if one
@@ -85,13 +142,19 @@ class Resolver {
   std::vector<std::string> FullyQualifiedNames(absl::string_view base_name,
                                                int64_t expr_id = -1) const;
 
+  // Same as FullyQualifiedNames, but without copying the names, which are
+  // memoized across the resolvers sharing the container names. The result is
+  // valid for the lifetime of the resolver.
+  absl::Span<const std::string> QualifiedNameCandidates(
+      absl::string_view base_name) const;
+
  private:
-  std::vector<std::string> namespace_prefixes_;
-  absl::flat_hash_map<std::string, cel::Value> enum_value_map_;
+  std::shared_ptr<const ContainerNames> names_;
   const cel::FunctionRegistry& function_registry_;
   cel::ValueManager& value_factory_;
-  const absl::flat_hash_map<std::string, cel::TypeRegistry::Enumeration>&
-      resolveable_enums_;
+  // Candidates of the names which didn't fit in the shared cache.
+  mutable absl::node_hash_map<std::string, std::vector<std::string>>
+      uncached_names_;
 
   bool resolve_qualified_type_identifiers_;
 };
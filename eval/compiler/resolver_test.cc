@@ -20,6 +20,7 @@
 
 #include "absl/status/status.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/type_provider.h"
 #include "common/memory.h"
 #include "common/type_factory.h"
@@ -44,6 +45,7 @@ using ::cel::TypeFactory;
 using ::cel::TypeManager;
 using ::cel::TypeValue;
 using ::cel::ValueManager;
+using testing::ElementsAre;
 using testing::Eq;
 
 class FakeFunction : public CelFunction {
@@ -105,6 +107,27 @@ TEST_F(ResolverTest, TestFullyQualifiedNamesAbsoluteName) {
   EXPECT_THAT(names[0], Eq("google.api.expr.absolute_name"));
 }
 
+TEST_F(ResolverTest, QualifiedNameCandidatesSharedAcrossResolvers) {
+  CelFunctionRegistry func_registry;
+  std::shared_ptr<const ContainerNames> container_names =
+      ComputeContainerNames("google.api", type_registry_.resolveable_enums());
+  Resolver resolver(container_names, func_registry.InternalGetRegistry(),
+                    type_registry_.InternalGetModernRegistry(),
+                    value_factory_);
+  Resolver other_resolver(container_names, func_registry.InternalGetRegistry(),
+                          type_registry_.InternalGetModernRegistry(),
+                          value_factory_);
+
+  absl::Span<const std::string> names =
+      resolver.QualifiedNameCandidates("simple_name");
+  EXPECT_THAT(names, ElementsAre("google.api.simple_name", "google.simple_name",
+                                 "simple_name"));
+  EXPECT_EQ(other_resolver.QualifiedNameCandidates("simple_name").data(),
+            names.data());
+  EXPECT_THAT(other_resolver.QualifiedNameCandidates(".simple_name"),
+              ElementsAre("simple_name"));
+}
+
 TEST_F(ResolverTest, TestFindConstantEnum) {
   CelFunctionRegistry func_registry;
   type_registry_.Register(TestMessage::TestEnum_descriptor());
@@ -126,6 +149,29 @@ TEST_F(ResolverTest, TestFindConstantEnum) {
   EXPECT_THAT((*enum_value).As<IntValue>().NativeValue(), Eq(2L));
 }
 
+TEST_F(ResolverTest, TestSharedContainerNames) {
+  CelFunctionRegistry func_registry;
+  type_registry_.Register(TestMessage::TestEnum_descriptor());
+
+  std::shared_ptr<const ContainerNames> names =
+      ComputeContainerNames("google.api.expr.runtime.TestMessage",
+                            type_registry_.resolveable_enums());
+  Resolver resolver(names, func_registry.InternalGetRegistry(),
+                    type_registry_.InternalGetModernRegistry(), value_factory_);
+  Resolver other_resolver(names, func_registry.InternalGetRegistry(),
+                          type_registry_.InternalGetModernRegistry(),
+                          value_factory_);
+
+  EXPECT_THAT(resolver.FullyQualifiedNames("simple_name"),
+              Eq(other_resolver.FullyQualifiedNames("simple_name")));
+  for (const Resolver* r : {&resolver, &other_resolver}) {
+    auto enum_value = r->FindConstant("TestEnum.TEST_ENUM_1", -1);
+    ASSERT_TRUE(enum_value);
+    ASSERT_TRUE(enum_value->Is<IntValue>());
+    EXPECT_THAT((*enum_value).As<IntValue>().NativeValue(), Eq(1L));
+  }
+}
+
 TEST_F(ResolverTest, TestFindConstantUnqualifiedType) {
   CelFunctionRegistry func_registry;
   Resolver resolver("cel", func_registry.InternalGetRegistry(),
@@ -0,0 +1,138 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/rule_set.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::CheckedExpr;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+using ::cel::ast_internal::SourceInfo;
+using ::cel::ast_internal::Type;
+
+// Adds `offset` to the ids of `root` and its descendants, returning the
+// largest id after renumbering.
+int64_t OffsetIds(Expr& root, int64_t offset) {
+  int64_t max_id = 0;
+  std::vector<Expr*> stack = {&root};
+  while (!stack.empty()) {
+    Expr* expr = stack.back();
+    stack.pop_back();
+    expr->set_id(expr->id() + offset);
+    max_id = std::max(max_id, expr->id());
+    if (expr->has_select_expr()) {
+      stack.push_back(&expr->mutable_select_expr().mutable_operand());
+    } else if (expr->has_call_expr()) {
+      auto& call = expr->mutable_call_expr();
+      if (call.has_target()) {
+        stack.push_back(&call.mutable_target());
+      }
+      for (auto& arg : call.mutable_args()) {
+        stack.push_back(&arg);
+      }
+    } else if (expr->has_list_expr()) {
+      for (auto& element : expr->mutable_list_expr().mutable_elements()) {
+        stack.push_back(&element.mutable_expr());
+      }
+    } else if (expr->has_struct_expr()) {
+      for (auto& field : expr->mutable_struct_expr().mutable_fields()) {
+        field.set_id(field.id() + offset);
+        max_id = std::max(max_id, field.id());
+        stack.push_back(&field.mutable_value());
+      }
+    } else if (expr->has_map_expr()) {
+      for (auto& entry : expr->mutable_map_expr().mutable_entries()) {
+        entry.set_id(entry.id() + offset);
+        max_id = std::max(max_id, entry.id());
+        stack.push_back(&entry.mutable_key());
+        stack.push_back(&entry.mutable_value());
+      }
+    } else if (expr->has_comprehension_expr()) {
+      auto& comprehension = expr->mutable_comprehension_expr();
+      stack.push_back(&comprehension.mutable_iter_range());
+      stack.push_back(&comprehension.mutable_accu_init());
+      stack.push_back(&comprehension.mutable_loop_condition());
+      stack.push_back(&comprehension.mutable_loop_step());
+      stack.push_back(&comprehension.mutable_result());
+    }
+  }
+  return max_id;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<cel::Ast>> CombineRuleSet(
+    std::vector<std::unique_ptr<cel::Ast>> rules) {
+  if (rules.empty()) {
+    return absl::InvalidArgumentError("rule set must have at least one rule");
+  }
+  const bool is_checked = rules.front()->IsChecked();
+  Expr root;
+  auto& call = root.mutable_call_expr();
+  call.set_function(kRuleSetFunction);
+  call.mutable_args().reserve(rules.size());
+  absl::flat_hash_map<int64_t, Reference> reference_map;
+  absl::flat_hash_map<int64_t, Type> type_map;
+  // Ids are positive, so the ids of each rule are offset past the largest id
+  // of the previous rules.
+  int64_t max_id = 0;
+  for (std::unique_ptr<cel::Ast>& rule : rules) {
+    if (rule == nullptr) {
+      return absl::InvalidArgumentError("rule set rule must not be null");
+    }
+    if (rule->IsChecked() != is_checked) {
+      return absl::InvalidArgumentError(
+          "rule set rules must either all be checked or all be unchecked");
+    }
+    AstImpl& rule_impl = AstImpl::CastFromPublicAst(*rule);
+    const int64_t offset = max_id;
+    Expr& arg = call.mutable_args().emplace_back(
+        std::move(rule_impl.root_expr()));
+    max_id = std::max(max_id, OffsetIds(arg, offset));
+    for (auto& [id, reference] : rule_impl.reference_map()) {
+      reference_map.insert({id + offset, std::move(reference)});
+    }
+    for (const auto& [id, type] : rule_impl.type_map()) {
+      type_map.insert({id + offset, type});
+    }
+  }
+  root.set_id(max_id + 1);
+
+  if (!is_checked) {
+    return std::make_unique<AstImpl>(std::move(root), SourceInfo());
+  }
+  return std::make_unique<AstImpl>(
+      CheckedExpr(std::move(reference_map), std::move(type_map), SourceInfo(),
+                  /*expr_version=*/"", std::move(root)));
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,45 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_RULE_SET_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_RULE_SET_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/ast.h"
+
+namespace google::api::expr::runtime {
+
+// Function called by the root of a combined rule set, with the rules as
+// arguments. '@' is not valid in a CEL identifier so it can't collide with
+// user functions.
+inline constexpr absl::string_view kRuleSetFunction = "@rule_set";
+
+// Combines `rules` into one AST calling `kRuleSetFunction` with each rule as
+// an argument, in order.
+//
+// Expression ids are renumbered so that they are unique across the rules,
+// along with the references and types of checked rules. The source info of
+// the rules is dropped since their positions refer to different sources.
+//
+// The rules must either all be checked or all be unchecked.
+absl::StatusOr<std::unique_ptr<cel::Ast>> CombineRuleSet(
+    std::vector<std::unique_ptr<cel::Ast>> rules);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_RULE_SET_H_
@@ -0,0 +1,107 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/rule_set.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "internal/testing.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::CheckedExpr;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+using ::cel::ast_internal::SourceInfo;
+using cel::internal::StatusIs;
+
+// Returns `x == 1`, with ids 1 to 3.
+Expr MakeRule() {
+  Expr expr;
+  expr.set_id(2);
+  auto& call = expr.mutable_call_expr();
+  call.set_function("_==_");
+  Expr& lhs = call.mutable_args().emplace_back();
+  lhs.set_id(1);
+  lhs.mutable_ident_expr().set_name("x");
+  Expr& rhs = call.mutable_args().emplace_back();
+  rhs.set_id(3);
+  rhs.mutable_const_expr().set_int64_value(1);
+  return expr;
+}
+
+std::unique_ptr<cel::Ast> MakeCheckedRule() {
+  CheckedExpr checked;
+  checked.set_expr(MakeRule());
+  checked.mutable_reference_map()[2] = Reference("", {"equals"}, {});
+  return std::make_unique<AstImpl>(std::move(checked));
+}
+
+TEST(CombineRuleSetTest, RenumbersIds) {
+  std::vector<std::unique_ptr<cel::Ast>> rules;
+  rules.push_back(std::make_unique<AstImpl>(MakeRule(), SourceInfo()));
+  rules.push_back(std::make_unique<AstImpl>(MakeRule(), SourceInfo()));
+  ASSERT_OK_AND_ASSIGN(auto ast, CombineRuleSet(std::move(rules)));
+
+  const Expr& root = AstImpl::CastFromPublicAst(*ast).root_expr();
+  ASSERT_TRUE(root.has_call_expr());
+  EXPECT_EQ(root.call_expr().function(), kRuleSetFunction);
+  EXPECT_EQ(root.id(), 7);
+  ASSERT_EQ(root.call_expr().args().size(), 2);
+  absl::flat_hash_set<int64_t> ids;
+  for (const Expr& rule : root.call_expr().args()) {
+    ids.insert(rule.id());
+    for (const Expr& arg : rule.call_expr().args()) {
+      ids.insert(arg.id());
+    }
+  }
+  EXPECT_THAT(ids, testing::UnorderedElementsAre(1, 2, 3, 4, 5, 6));
+}
+
+TEST(CombineRuleSetTest, RenumbersReferences) {
+  std::vector<std::unique_ptr<cel::Ast>> rules;
+  rules.push_back(MakeCheckedRule());
+  rules.push_back(MakeCheckedRule());
+  ASSERT_OK_AND_ASSIGN(auto ast, CombineRuleSet(std::move(rules)));
+
+  const AstImpl& ast_impl = AstImpl::CastFromPublicAst(*ast);
+  EXPECT_TRUE(ast_impl.IsChecked());
+  EXPECT_NE(ast_impl.GetReference(2), nullptr);
+  EXPECT_NE(ast_impl.GetReference(5), nullptr);
+  EXPECT_EQ(ast_impl.reference_map().size(), 2);
+}
+
+TEST(CombineRuleSetTest, RejectsMixedRules) {
+  std::vector<std::unique_ptr<cel::Ast>> rules;
+  rules.push_back(MakeCheckedRule());
+  rules.push_back(std::make_unique<AstImpl>(MakeRule(), SourceInfo()));
+  EXPECT_THAT(CombineRuleSet(std::move(rules)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(CombineRuleSetTest, RejectsEmptyRuleSet) {
+  EXPECT_THAT(CombineRuleSet({}), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,361 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/typed_arithmetic_optimization.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "base/kind.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/arithmetic_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+
+using ReferenceMap = absl::flat_hash_map<int64_t, Reference>;
+
+struct TypedOverload {
+  absl::string_view overload_id;
+  absl::string_view function;
+  ArithmeticOp op;
+  cel::Kind kind;
+};
+
+// Overload ids from the standard declarations used by the type checker.
+constexpr TypedOverload kTypedOverloads[] = {
+    {"add_int64", cel::builtin::kAdd, ArithmeticOp::kAdd, cel::Kind::kInt},
+    {"add_uint64", cel::builtin::kAdd, ArithmeticOp::kAdd, cel::Kind::kUint},
+    {"add_double", cel::builtin::kAdd, ArithmeticOp::kAdd, cel::Kind::kDouble},
+    {"subtract_int64", cel::builtin::kSubtract, ArithmeticOp::kSubtract,
+     cel::Kind::kInt},
+    {"subtract_uint64", cel::builtin::kSubtract, ArithmeticOp::kSubtract,
+     cel::Kind::kUint},
+    {"subtract_double", cel::builtin::kSubtract, ArithmeticOp::kSubtract,
+     cel::Kind::kDouble},
+    {"multiply_int64", cel::builtin::kMultiply, ArithmeticOp::kMultiply,
+     cel::Kind::kInt},
+    {"multiply_uint64", cel::builtin::kMultiply, ArithmeticOp::kMultiply,
+     cel::Kind::kUint},
+    {"multiply_double", cel::builtin::kMultiply, ArithmeticOp::kMultiply,
+     cel::Kind::kDouble},
+    {"divide_int64", cel::builtin::kDivide, ArithmeticOp::kDivide,
+     cel::Kind::kInt},
+    {"divide_uint64", cel::builtin::kDivide, ArithmeticOp::kDivide,
+     cel::Kind::kUint},
+    {"divide_double", cel::builtin::kDivide, ArithmeticOp::kDivide,
+     cel::Kind::kDouble},
+    {"modulo_int64", cel::builtin::kModulo, ArithmeticOp::kModulo,
+     cel::Kind::kInt},
+    {"modulo_uint64", cel::builtin::kModulo, ArithmeticOp::kModulo,
+     cel::Kind::kUint},
+    {"less_int64", cel::builtin::kLess, ArithmeticOp::kLess, cel::Kind::kInt},
+    {"less_uint64", cel::builtin::kLess, ArithmeticOp::kLess,
+     cel::Kind::kUint},
+    {"less_double", cel::builtin::kLess, ArithmeticOp::kLess,
+     cel::Kind::kDouble},
+    {"less_equals_int64", cel::builtin::kLessOrEqual,
+     ArithmeticOp::kLessOrEqual, cel::Kind::kInt},
+    {"less_equals_uint64", cel::builtin::kLessOrEqual,
+     ArithmeticOp::kLessOrEqual, cel::Kind::kUint},
+    {"less_equals_double", cel::builtin::kLessOrEqual,
+     ArithmeticOp::kLessOrEqual, cel::Kind::kDouble},
+    {"greater_int64", cel::builtin::kGreater, ArithmeticOp::kGreater,
+     cel::Kind::kInt},
+    {"greater_uint64", cel::builtin::kGreater, ArithmeticOp::kGreater,
+     cel::Kind::kUint},
+    {"greater_double", cel::builtin::kGreater, ArithmeticOp::kGreater,
+     cel::Kind::kDouble},
+    {"greater_equals_int64", cel::builtin::kGreaterOrEqual,
+     ArithmeticOp::kGreaterOrEqual, cel::Kind::kInt},
+    {"greater_equals_uint64", cel::builtin::kGreaterOrEqual,
+     ArithmeticOp::kGreaterOrEqual, cel::Kind::kUint},
+    {"greater_equals_double", cel::builtin::kGreaterOrEqual,
+     ArithmeticOp::kGreaterOrEqual, cel::Kind::kDouble},
+};
+
+struct TemporalOverload {
+  absl::string_view overload_id;
+  absl::string_view function;
+  ArithmeticOp op;
+  cel::Kind lhs_kind;
+  cel::Kind rhs_kind;
+};
+
+constexpr TemporalOverload kTemporalOverloads[] = {
+    {"add_timestamp_duration", cel::builtin::kAdd, ArithmeticOp::kAdd,
+     cel::Kind::kTimestamp, cel::Kind::kDuration},
+    {"add_duration_timestamp", cel::builtin::kAdd, ArithmeticOp::kAdd,
+     cel::Kind::kDuration, cel::Kind::kTimestamp},
+    {"add_duration_duration", cel::builtin::kAdd, ArithmeticOp::kAdd,
+     cel::Kind::kDuration, cel::Kind::kDuration},
+    {"subtract_timestamp_duration", cel::builtin::kSubtract,
+     ArithmeticOp::kSubtract, cel::Kind::kTimestamp, cel::Kind::kDuration},
+    {"subtract_timestamp_timestamp", cel::builtin::kSubtract,
+     ArithmeticOp::kSubtract, cel::Kind::kTimestamp, cel::Kind::kTimestamp},
+    {"subtract_duration_duration", cel::builtin::kSubtract,
+     ArithmeticOp::kSubtract, cel::Kind::kDuration, cel::Kind::kDuration},
+    {"less_timestamp", cel::builtin::kLess, ArithmeticOp::kLess,
+     cel::Kind::kTimestamp, cel::Kind::kTimestamp},
+    {"less_duration", cel::builtin::kLess, ArithmeticOp::kLess,
+     cel::Kind::kDuration, cel::Kind::kDuration},
+    {"less_equals_timestamp", cel::builtin::kLessOrEqual,
+     ArithmeticOp::kLessOrEqual, cel::Kind::kTimestamp, cel::Kind::kTimestamp},
+    {"less_equals_duration", cel::builtin::kLessOrEqual,
+     ArithmeticOp::kLessOrEqual, cel::Kind::kDuration, cel::Kind::kDuration},
+    {"greater_timestamp", cel::builtin::kGreater, ArithmeticOp::kGreater,
+     cel::Kind::kTimestamp, cel::Kind::kTimestamp},
+    {"greater_duration", cel::builtin::kGreater, ArithmeticOp::kGreater,
+     cel::Kind::kDuration, cel::Kind::kDuration},
+    {"greater_equals_timestamp", cel::builtin::kGreaterOrEqual,
+     ArithmeticOp::kGreaterOrEqual, cel::Kind::kTimestamp,
+     cel::Kind::kTimestamp},
+    {"greater_equals_duration", cel::builtin::kGreaterOrEqual,
+     ArithmeticOp::kGreaterOrEqual, cel::Kind::kDuration,
+     cel::Kind::kDuration},
+};
+
+// A call with typed operands, resolved to the overloads of its function.
+struct ResolvedCall {
+  ArithmeticOp op;
+  cel::Kind lhs_kind;
+  cel::Kind rhs_kind;
+  std::vector<cel::FunctionOverloadReference> overloads;
+};
+
+// Returns the entry of `table` for a global binary call if the checker pinned
+// it to exactly one of the overloads in the table.
+template <typename Overload, size_t N>
+absl::optional<Overload> FindOverloadIn(const Expr& expr,
+                                        const ReferenceMap& reference_map,
+                                        const Overload (&table)[N]) {
+  if (!expr.has_call_expr()) {
+    return absl::nullopt;
+  }
+  const auto& call_expr = expr.call_expr();
+  if (call_expr.has_target() || call_expr.args().size() != 2) {
+    return absl::nullopt;
+  }
+  auto reference = reference_map.find(expr.id());
+  if (reference == reference_map.end() ||
+      reference->second.overload_id().size() != 1) {
+    return absl::nullopt;
+  }
+  absl::string_view overload_id = reference->second.overload_id().front();
+  for (const Overload& overload : table) {
+    if (overload.overload_id == overload_id &&
+        overload.function == call_expr.function()) {
+      return overload;
+    }
+  }
+  return absl::nullopt;
+}
+
+bool HasStandardOverload(
+    absl::Span<const cel::FunctionOverloadReference> overloads,
+    cel::Kind lhs_kind, cel::Kind rhs_kind) {
+  for (const auto& overload : overloads) {
+    const auto& types = overload.descriptor.types();
+    if (overload.descriptor.is_strict() && types.size() == 2 &&
+        types[0] == lhs_kind && types[1] == rhs_kind) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the overloads of `function` as the planner resolves them, or
+// nullopt if there are lazy overloads or no standard overload for the kinds.
+absl::optional<std::vector<cel::FunctionOverloadReference>>
+FindStandardOverloads(const Expr& expr, absl::string_view function,
+                      cel::Kind lhs_kind, cel::Kind rhs_kind,
+                      const Resolver& resolver) {
+  // Match the function resolution of the planner. Lazy overloads shadow the
+  // eager ones, and may differ per activation.
+  if (!resolver
+           .FindLazyOverloads(function, /*receiver_style=*/false,
+                              ArgumentsMatcher(2), expr.id())
+           .empty()) {
+    return absl::nullopt;
+  }
+  std::vector<cel::FunctionOverloadReference> overloads =
+      resolver.FindOverloads(function, /*receiver_style=*/false,
+                             ArgumentsMatcher(2), expr.id());
+  if (!HasStandardOverload(overloads, lhs_kind, rhs_kind)) {
+    return absl::nullopt;
+  }
+  return overloads;
+}
+
+// As ResolveTypedArithmeticCall, for the timestamp and duration overloads.
+absl::optional<ResolvedCall> ResolveTypedTemporalCall(
+    const Expr& expr, const ReferenceMap& reference_map,
+    const Resolver& resolver) {
+  absl::optional<TemporalOverload> temporal_overload =
+      FindOverloadIn(expr, reference_map, kTemporalOverloads);
+  if (!temporal_overload.has_value()) {
+    return absl::nullopt;
+  }
+  absl::optional<std::vector<cel::FunctionOverloadReference>> overloads =
+      FindStandardOverloads(expr, temporal_overload->function,
+                            temporal_overload->lhs_kind,
+                            temporal_overload->rhs_kind, resolver);
+  if (!overloads.has_value()) {
+    return absl::nullopt;
+  }
+  return ResolvedCall{temporal_overload->op, temporal_overload->lhs_kind,
+                      temporal_overload->rhs_kind, *std::move(overloads)};
+}
+
+absl::optional<ResolvedCall> ResolveCall(const Expr& expr,
+                                         const ReferenceMap& reference_map,
+                                         const Resolver& resolver) {
+  absl::optional<TypedArithmeticCall> typed_call =
+      ResolveTypedArithmeticCall(expr, reference_map, resolver);
+  if (typed_call.has_value()) {
+    return ResolvedCall{typed_call->op, typed_call->kind, typed_call->kind,
+                        std::move(typed_call->overloads)};
+  }
+  return ResolveTypedTemporalCall(expr, reference_map, resolver);
+}
+
+class TypedArithmeticOptimization : public ProgramOptimizer {
+ public:
+  explicit TypedArithmeticOptimization(const ReferenceMap& reference_map)
+      : reference_map_(reference_map) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    absl::optional<ResolvedCall> typed_call =
+        ResolveCall(node, reference_map_, context.resolver());
+    if (!typed_call.has_value()) {
+      return absl::OkStatus();
+    }
+
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || subexpression->IsFlattened()) {
+      // Already modified, can't update further.
+      return absl::OkStatus();
+    }
+
+    if (subexpression->IsRecursive()) {
+      return RewriteRecursivePlan(subexpression, node, *std::move(typed_call));
+    }
+    return RewriteStackMachinePlan(context, node, *std::move(typed_call));
+  }
+
+ private:
+  absl::Status RewriteRecursivePlan(
+      absl::Nonnull<ProgramBuilder::Subexpression*> subexpression,
+      const Expr& call, ResolvedCall typed_call) {
+    auto program = subexpression->ExtractRecursiveProgram();
+    auto deps = program.step->ExtractDependencies();
+    if (!deps.has_value() || deps->size() != 2) {
+      // Possibly already const-folded, put the plan back.
+      subexpression->set_recursive_program(std::move(program.step),
+                                           program.depth);
+      return absl::OkStatus();
+    }
+    subexpression->set_recursive_program(
+        CreateDirectArithmeticStep(
+            call.id(), call.call_expr(), typed_call.op, typed_call.lhs_kind,
+            typed_call.rhs_kind, std::move(deps->at(0)),
+            std::move(deps->at(1)), std::move(typed_call.overloads)),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+  absl::Status RewriteStackMachinePlan(PlannerContext& context,
+                                       const Expr& call,
+                                       ResolvedCall typed_call) {
+    const Expr& lhs = call.call_expr().args()[0];
+    const Expr& rhs = call.call_expr().args()[1];
+    if (context.GetSubplan(lhs).empty() || context.GetSubplan(rhs).empty()) {
+      // This subexpression was already optimized, nothing to do.
+      return absl::OkStatus();
+    }
+
+    CEL_ASSIGN_OR_RETURN(ExecutionPath new_plan, context.ExtractSubplan(lhs));
+    CEL_ASSIGN_OR_RETURN(ExecutionPath rhs_plan, context.ExtractSubplan(rhs));
+    std::move(rhs_plan.begin(), rhs_plan.end(), std::back_inserter(new_plan));
+    CEL_ASSIGN_OR_RETURN(
+        new_plan.emplace_back(),
+        CreateArithmeticStep(call.call_expr(), call.id(), typed_call.op,
+                             typed_call.lhs_kind, typed_call.rhs_kind,
+                             std::move(typed_call.overloads)));
+
+    return context.ReplaceSubplan(call, std::move(new_plan));
+  }
+
+  const ReferenceMap& reference_map_;
+};
+
+}  // namespace
+
+absl::optional<TypedArithmeticCall> ResolveTypedArithmeticCall(
+    const Expr& expr, const ReferenceMap& reference_map,
+    const Resolver& resolver) {
+  absl::optional<TypedOverload> typed_overload =
+      FindOverloadIn(expr, reference_map, kTypedOverloads);
+  if (!typed_overload.has_value()) {
+    return absl::nullopt;
+  }
+  absl::optional<std::vector<cel::FunctionOverloadReference>> overloads =
+      FindStandardOverloads(expr, typed_overload->function,
+                            typed_overload->kind, typed_overload->kind,
+                            resolver);
+  if (!overloads.has_value()) {
+    return absl::nullopt;
+  }
+  return TypedArithmeticCall{typed_overload->op, typed_overload->kind,
+                             *std::move(overloads)};
+}
+
+ProgramOptimizerFactory CreateTypedArithmeticExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    if (ast.reference_map().empty()) {
+      return nullptr;
+    }
+    return std::make_unique<TypedArithmeticOptimization>(ast.reference_map());
+  };
+}
+
+}  // namespace google::api::expr::runtime
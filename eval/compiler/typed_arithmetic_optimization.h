@@ -0,0 +1,71 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_TYPED_ARITHMETIC_OPTIMIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_TYPED_ARITHMETIC_OPTIMIZATION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/expr.h"
+#include "base/kind.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/eval/arithmetic_step.h"
+#include "runtime/function_overload_reference.h"
+
+namespace google::api::expr::runtime {
+
+// A call the type checker resolved to one of the standard arithmetic or
+// ordering overloads.
+struct TypedArithmeticCall {
+  ArithmeticOp op;
+  // Kind of both operands.
+  cel::Kind kind;
+  // The eagerly bound overloads of the called function.
+  std::vector<cel::FunctionOverloadReference> overloads;
+};
+
+// Returns the typed call for `expr` if the reference map pins it to a single
+// standard arithmetic or ordering overload and the planner would dispatch it
+// to a strict, eagerly bound overload with that signature.
+absl::optional<TypedArithmeticCall> ResolveTypedArithmeticCall(
+    const cel::ast_internal::Expr& expr,
+    const absl::flat_hash_map<int64_t, cel::ast_internal::Reference>&
+        reference_map,
+    const Resolver& resolver);
+
+// Create a new extension for the FlatExprBuilder that evaluates arithmetic
+// (`+`, `-`, `*`, `/`, `%`) and ordering (`<`, `<=`, `>`, `>=`) calls inline
+// when the type checker resolved them to the standard int, uint or double
+// overload, for example `add_int64`.
+//
+// Timestamp and duration arithmetic and ordering, for example
+// `subtract_timestamp_timestamp`, are also evaluated inline, honoring
+// `RuntimeOptions::enable_timestamp_duration_overflow_errors`.
+//
+// Only applies to checked expressions. The call is left alone if the
+// registered overloads don't include a strict, eagerly bound overload with
+// the checked signature, but the extension otherwise assumes the registered
+// implementation is the standard one.
+//
+// Arguments that are errors, unknowns or of an unexpected kind are handled by
+// the generic function dispatch, so results are unchanged.
+ProgramOptimizerFactory CreateTypedArithmeticExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_TYPED_ARITHMETIC_OPTIMIZATION_H_
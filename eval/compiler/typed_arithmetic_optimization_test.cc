@@ -0,0 +1,250 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/typed_arithmetic_optimization.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::ErrorValue;
+using ::cel::IntValue;
+using ::cel::UintValue;
+using ::cel::Value;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::HasSubstr;
+using cel::internal::StatusIs;
+
+class TypedArithmeticTest : public testing::TestWithParam<bool> {
+ public:
+  TypedArithmeticTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {}
+
+  void SetUp() override {
+    if (GetParam()) {
+      options_.max_recursion_depth = -1;
+    }
+  }
+
+ protected:
+  // Evaluates a binary call with fake reference information pinning the root
+  // call to `overload_id`.
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 absl::string_view overload_id,
+                                 const cel::Activation& activation) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    builder.AddProgramOptimizer(CreateTypedArithmeticExtension());
+
+    CEL_ASSIGN_OR_RETURN(ParsedExpr parsed_expr, Parse(expression));
+    CheckedExpr checked_expr;
+    checked_expr.mutable_expr()->Swap(parsed_expr.mutable_expr());
+    checked_expr.mutable_source_info()->Swap(
+        parsed_expr.mutable_source_info());
+    (*checked_expr.mutable_reference_map())[checked_expr.expr().id()]
+        .add_overload_id(std::string(overload_id));
+
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromCheckedExpr(
+                             checked_expr));
+    CEL_ASSIGN_OR_RETURN(auto plan,
+                         builder.CreateExpressionImpl(std::move(ast),
+                                                      /*issues=*/nullptr));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 absl::string_view overload_id, Value x,
+                                 Value y) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("x", std::move(x));
+    activation.InsertOrAssignValue("y", std::move(y));
+    return Evaluate(expression, overload_id, activation);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_P(TypedArithmeticTest, IntArithmetic) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  struct TestCase {
+    absl::string_view expression;
+    absl::string_view overload_id;
+    int64_t expected;
+  };
+  const TestCase kCases[] = {
+      {"x + y", "add_int64", 9},      {"x - y", "subtract_int64", 5},
+      {"x * y", "multiply_int64", 14}, {"x / y", "divide_int64", 3},
+      {"x % y", "modulo_int64", 1},
+  };
+
+  for (const TestCase& test_case : kCases) {
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         Evaluate(test_case.expression, test_case.overload_id,
+                                  IntValue(7), IntValue(2)));
+    ASSERT_TRUE(result.Is<IntValue>())
+        << test_case.expression << " " << result.DebugString();
+    EXPECT_EQ(result.As<IntValue>().NativeValue(), test_case.expected)
+        << test_case.expression;
+  }
+}
+
+TEST_P(TypedArithmeticTest, Comparisons) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  struct TestCase {
+    absl::string_view expression;
+    absl::string_view overload_id;
+    Value x;
+    Value y;
+    bool expected;
+  };
+  const TestCase kCases[] = {
+      {"x < y", "less_int64", IntValue(1), IntValue(2), true},
+      {"x <= y", "less_equals_uint64", UintValue(2), UintValue(2), true},
+      {"x > y", "greater_double", DoubleValue(1.5), DoubleValue(2.5), false},
+      {"x >= y", "greater_equals_int64", IntValue(2), IntValue(1), true},
+      {"x < y", "less_double", DoubleValue(std::nan("")), DoubleValue(1.0),
+       false},
+  };
+
+  for (const TestCase& test_case : kCases) {
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         Evaluate(test_case.expression, test_case.overload_id,
+                                  test_case.x, test_case.y));
+    ASSERT_TRUE(result.Is<BoolValue>())
+        << test_case.expression << " " << result.DebugString();
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), test_case.expected)
+        << test_case.expression;
+  }
+}
+
+TEST_P(TypedArithmeticTest, ArithmeticErrors) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("x + y", "add_int64",
+               IntValue(std::numeric_limits<int64_t>::max()), IntValue(1)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("integer overflow")));
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x - y", "subtract_uint64",
+                                        UintValue(1), UintValue(2)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kOutOfRange));
+
+  ASSERT_OK_AND_ASSIGN(
+      result, Evaluate("x / y", "divide_int64", IntValue(1), IntValue(0)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("divide by zero")));
+
+  ASSERT_OK_AND_ASSIGN(
+      result, Evaluate("x % y", "modulo_uint64", UintValue(1), UintValue(0)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x / y", "divide_double",
+                                        DoubleValue(1.0), DoubleValue(0.0)));
+  ASSERT_TRUE(result.Is<DoubleValue>()) << result.DebugString();
+  EXPECT_TRUE(std::isinf(result.As<DoubleValue>().NativeValue()));
+}
+
+TEST_P(TypedArithmeticTest, UnexpectedKindsUseGenericDispatch) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+
+  // Mismatched with the pinned overload, but another overload applies.
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x + y", "add_int64",
+                                              UintValue(1), UintValue(2)));
+  ASSERT_TRUE(result.Is<UintValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<UintValue>().NativeValue(), 3);
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x + y", "add_int64", IntValue(1),
+                                        DoubleValue(2.0)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kUnknown,
+                       HasSubstr("No matching overloads")));
+}
+
+TEST_P(TypedArithmeticTest, ErrorsPropagate) {
+  ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  cel::Activation activation;
+  activation.InsertOrAssignValue("y", IntValue(1));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("x + y", "add_int64", activation));
+
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kUnknown, HasSubstr("x")));
+}
+
+TEST_P(TypedArithmeticTest, SkippedWithoutRegisteredOverload) {
+  // No overloads are registered, so the call is planned as usual and fails at
+  // evaluation.
+  options_.fail_on_warnings = false;
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result, Evaluate("x + y", "add_int64", IntValue(1), IntValue(2)));
+
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+}
+
+INSTANTIATE_TEST_SUITE_P(TypedArithmeticTest, TypedArithmeticTest,
+                         testing::Bool());
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,265 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/typed_kernel_optimization.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "base/kind.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder_extensions.h"
+#include "eval/compiler/resolver.h"
+#include "eval/compiler/typed_arithmetic_optimization.h"
+#include "eval/eval/arithmetic_step.h"
+#include "eval/eval/compiler_constant_step.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/typed_kernel_step.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::Reference;
+
+using ReferenceMap = absl::flat_hash_map<int64_t, Reference>;
+
+bool IsComparison(ArithmeticOp op) {
+  switch (op) {
+    case ArithmeticOp::kLess:
+    case ArithmeticOp::kLessOrEqual:
+    case ArithmeticOp::kGreater:
+    case ArithmeticOp::kGreaterOrEqual:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Reads a planned constant into `out` if it is of `kind`.
+bool ConstantScalar(cel::Kind kind, const cel::Value& value,
+                    TypedKernelScalar& out) {
+  switch (kind) {
+    case cel::Kind::kBool:
+      if (!value.Is<cel::BoolValue>()) {
+        return false;
+      }
+      out.bool_value = value.As<cel::BoolValue>().NativeValue();
+      return true;
+    case cel::Kind::kInt:
+      if (!value.Is<cel::IntValue>()) {
+        return false;
+      }
+      out.int_value = value.As<cel::IntValue>().NativeValue();
+      return true;
+    case cel::Kind::kUint:
+      if (!value.Is<cel::UintValue>()) {
+        return false;
+      }
+      out.uint_value = value.As<cel::UintValue>().NativeValue();
+      return true;
+    case cel::Kind::kDouble:
+      if (!value.Is<cel::DoubleValue>()) {
+        return false;
+      }
+      out.double_value = value.As<cel::DoubleValue>().NativeValue();
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Lowers a subexpression and its recursive plan to the nodes of a kernel.
+class KernelBuilder {
+ public:
+  KernelBuilder(const ReferenceMap& reference_map, const Resolver& resolver,
+                bool short_circuiting)
+      : reference_map_(reference_map),
+        resolver_(resolver),
+        short_circuiting_(short_circuiting) {}
+
+  // Lowers `expr`, planned as `step`, to a node producing a value of `kind`,
+  // or of the kind of its operation if `kind` is absent. Returns the index
+  // of the node, if any.
+  absl::optional<size_t> Lower(const Expr& expr,
+                               const DirectExpressionStep* step,
+                               absl::optional<cel::Kind> kind) {
+    step = UnwrapTypedKernelStep(step);
+
+    if (absl::optional<TypedArithmeticCall> call =
+            ResolveTypedArithmeticCall(expr, reference_map_, resolver_);
+        call.has_value()) {
+      cel::Kind result_kind =
+          IsComparison(call->op) ? cel::Kind::kBool : call->kind;
+      if (kind.has_value() && *kind != result_kind) {
+        return absl::nullopt;
+      }
+      TypedKernelNode node{TypedKernelNode::Type::kArithmetic, result_kind};
+      node.op = call->op;
+      node.operand_kind = call->kind;
+      if (LowerOperands(expr, step, call->kind, node)) {
+        return AddNode(node);
+      }
+    } else if (short_circuiting_ && IsLogicCall(expr)) {
+      if (kind.has_value() && *kind != cel::Kind::kBool) {
+        return absl::nullopt;
+      }
+      TypedKernelNode node{expr.call_expr().function() == cel::builtin::kAnd
+                               ? TypedKernelNode::Type::kAnd
+                               : TypedKernelNode::Type::kOr,
+                           cel::Kind::kBool};
+      if (LowerOperands(expr, step, cel::Kind::kBool, node)) {
+        return AddNode(node);
+      }
+    }
+
+    if (!kind.has_value()) {
+      return absl::nullopt;
+    }
+    const auto* constant =
+        TryDowncastDirectStep<DirectCompilerConstantStep>(step);
+    TypedKernelNode node{TypedKernelNode::Type::kConstant, *kind};
+    if (constant != nullptr &&
+        ConstantScalar(*kind, constant->value(), node.constant)) {
+      return AddNode(node);
+    }
+    node.type = TypedKernelNode::Type::kLeaf;
+    node.lhs = leaves_.size();
+    leaves_.push_back(step);
+    return AddNode(node);
+  }
+
+  size_t operation_count() const { return operation_count_; }
+
+  std::vector<TypedKernelNode> ExtractNodes() { return std::move(nodes_); }
+
+  std::vector<const DirectExpressionStep*> ExtractLeaves() {
+    return std::move(leaves_);
+  }
+
+ private:
+  static bool IsLogicCall(const Expr& expr) {
+    if (!expr.has_call_expr()) {
+      return false;
+    }
+    const auto& call_expr = expr.call_expr();
+    return !call_expr.has_target() && call_expr.args().size() == 2 &&
+           (call_expr.function() == cel::builtin::kAnd ||
+            call_expr.function() == cel::builtin::kOr);
+  }
+
+  // Lowers the two operands of the call `expr` to nodes of `operand_kind`,
+  // if `step` evaluates it from the plans of the operands.
+  bool LowerOperands(const Expr& expr, const DirectExpressionStep* step,
+                     cel::Kind operand_kind, TypedKernelNode& node) {
+    const auto& args = expr.call_expr().args();
+    auto deps = step->GetDependencies();
+    if (!deps.has_value() || deps->size() != 2 ||
+        (*deps)[0]->expr_id() != args[0].id() ||
+        (*deps)[1]->expr_id() != args[1].id()) {
+      return false;
+    }
+    absl::optional<size_t> lhs = Lower(args[0], (*deps)[0], operand_kind);
+    absl::optional<size_t> rhs = Lower(args[1], (*deps)[1], operand_kind);
+    if (!lhs.has_value() || !rhs.has_value()) {
+      return false;
+    }
+    node.lhs = *lhs;
+    node.rhs = *rhs;
+    ++operation_count_;
+    return true;
+  }
+
+  size_t AddNode(const TypedKernelNode& node) {
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  const ReferenceMap& reference_map_;
+  const Resolver& resolver_;
+  bool short_circuiting_;
+  std::vector<TypedKernelNode> nodes_;
+  std::vector<const DirectExpressionStep*> leaves_;
+  size_t operation_count_ = 0;
+};
+
+class TypedKernelOptimization : public ProgramOptimizer {
+ public:
+  explicit TypedKernelOptimization(const ReferenceMap& reference_map)
+      : reference_map_(reference_map) {}
+
+  absl::Status OnPreVisit(PlannerContext& context, const Expr& node) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status OnPostVisit(PlannerContext& context, const Expr& node) override {
+    if (!node.has_call_expr()) {
+      return absl::OkStatus();
+    }
+    ProgramBuilder::Subexpression* subexpression =
+        context.program_builder().GetSubexpression(&node);
+    if (subexpression == nullptr || !subexpression->IsRecursive()) {
+      return absl::OkStatus();
+    }
+
+    KernelBuilder builder(reference_map_, context.resolver(),
+                          context.options().short_circuiting);
+    absl::optional<size_t> root =
+        builder.Lower(node, subexpression->recursive_program().step.get(),
+                      /*kind=*/absl::nullopt);
+    // A single operation is evaluated as fast by its own step.
+    if (!root.has_value() || builder.operation_count() < 2) {
+      return absl::OkStatus();
+    }
+
+    auto program = subexpression->ExtractRecursiveProgram();
+    subexpression->set_recursive_program(
+        CreateDirectTypedKernelStep(node.id(), builder.ExtractNodes(),
+                                    builder.ExtractLeaves(),
+                                    std::move(program.step)),
+        program.depth);
+    return absl::OkStatus();
+  }
+
+ private:
+  const ReferenceMap& reference_map_;
+};
+
+}  // namespace
+
+ProgramOptimizerFactory CreateTypedKernelExtension() {
+  return [](PlannerContext& context, const AstImpl& ast)
+             -> absl::StatusOr<std::unique_ptr<ProgramOptimizer>> {
+    // Traced programs report every intermediate result to the listener.
+    if (ast.reference_map().empty() ||
+        context.options().enable_recursive_tracing ||
+        context.options().max_recursion_depth == 0) {
+      return nullptr;
+    }
+    return std::make_unique<TypedKernelOptimization>(ast.reference_map());
+  };
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,40 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_COMPILER_TYPED_KERNEL_OPTIMIZATION_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_COMPILER_TYPED_KERNEL_OPTIMIZATION_H_
+
+#include "eval/compiler/flat_expr_builder_extensions.h"
+
+namespace google::api::expr::runtime {
+
+// Create a new extension for the FlatExprBuilder that lowers trees of
+// arithmetic, ordering and logic operations in checked expressions to typed
+// kernels, which are evaluated on native scalars in a single step, without
+// boxing intermediate results as values or dispatching each call.
+//
+// Calls are lowered if the type checker resolved them to a standard int,
+// uint or double overload, as for `CreateTypedArithmeticExtension`. Other
+// subexpressions are evaluated as usual and their results used as operands.
+// Only recursively planned subexpressions with at least two operations are
+// lowered, and programs traced for evaluation listeners are left alone.
+//
+// Kernels fall back to the interpreted plan for operands of an unexpected kind
+// (including errors and unknowns) and for operations that fail, so results
+// are unchanged.
+ProgramOptimizerFactory CreateTypedKernelExtension();
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_COMPILER_TYPED_KERNEL_OPTIMIZATION_H_
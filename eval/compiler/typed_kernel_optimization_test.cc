@@ -0,0 +1,225 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/compiler/typed_kernel_optimization.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/value.h"
+#include "eval/compiler/flat_expr_builder.h"
+#include "eval/compiler/typed_arithmetic_optimization.h"
+#include "eval/eval/evaluator_core.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_registry.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/type_registry.h"
+#include "google/protobuf/arena.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::ErrorValue;
+using ::cel::IntValue;
+using ::cel::UintValue;
+using ::cel::Value;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::HasSubstr;
+using cel::internal::StatusIs;
+
+// Records the overload `<name>_<suffix>` in `checked_expr` for every
+// arithmetic and ordering call in `expr`, as the type checker would for
+// operands of a single type.
+void PinOverloads(const google::api::expr::v1alpha1::Expr& expr,
+                  absl::string_view suffix, CheckedExpr& checked_expr) {
+  constexpr std::pair<absl::string_view, absl::string_view> kOverloads[] = {
+      {"_+_", "add"},         {"_-_", "subtract"},
+      {"_*_", "multiply"},    {"_/_", "divide"},
+      {"_%_", "modulo"},      {"_<_", "less"},
+      {"_<=_", "less_equals"}, {"_>_", "greater"},
+      {"_>=_", "greater_equals"},
+  };
+  if (!expr.has_call_expr()) {
+    return;
+  }
+  for (const auto& [function, overload] : kOverloads) {
+    if (expr.call_expr().function() == function) {
+      (*checked_expr.mutable_reference_map())[expr.id()].add_overload_id(
+          absl::StrCat(overload, "_", suffix));
+    }
+  }
+  for (const auto& arg : expr.call_expr().args()) {
+    PinOverloads(arg, suffix, checked_expr);
+  }
+}
+
+class TypedKernelTest : public testing::TestWithParam<bool> {
+ public:
+  TypedKernelTest()
+      : managed_value_factory_(
+            type_registry_.GetComposedTypeProvider(),
+            cel::extensions::ProtoMemoryManagerRef(&arena_)) {
+    options_.max_recursion_depth = -1;
+  }
+
+  void SetUp() override {
+    ASSERT_OK(cel::RegisterStandardFunctions(function_registry_, options_));
+  }
+
+ protected:
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 absl::string_view overload_suffix,
+                                 const cel::Activation& activation) {
+    FlatExprBuilder builder(function_registry_, type_registry_, options_);
+    // Kernels are also built over typed arithmetic steps.
+    if (GetParam()) {
+      builder.AddProgramOptimizer(CreateTypedArithmeticExtension());
+    }
+    builder.AddProgramOptimizer(CreateTypedKernelExtension());
+
+    CEL_ASSIGN_OR_RETURN(ParsedExpr parsed_expr, Parse(expression));
+    CheckedExpr checked_expr;
+    checked_expr.mutable_expr()->Swap(parsed_expr.mutable_expr());
+    checked_expr.mutable_source_info()->Swap(
+        parsed_expr.mutable_source_info());
+    PinOverloads(checked_expr.expr(), overload_suffix, checked_expr);
+
+    CEL_ASSIGN_OR_RETURN(auto ast,
+                         cel::extensions::CreateAstFromCheckedExpr(
+                             checked_expr));
+    CEL_ASSIGN_OR_RETURN(auto plan,
+                         builder.CreateExpressionImpl(std::move(ast),
+                                                      /*issues=*/nullptr));
+    auto state = plan.MakeEvaluatorState(managed_value_factory_.get());
+    return plan.EvaluateWithCallback(activation, EvaluationListener(), state);
+  }
+
+  absl::StatusOr<Value> Evaluate(absl::string_view expression, Value x,
+                                 Value y) {
+    cel::Activation activation;
+    activation.InsertOrAssignValue("x", std::move(x));
+    activation.InsertOrAssignValue("y", std::move(y));
+    return Evaluate(expression, "int64", activation);
+  }
+
+  cel::RuntimeOptions options_;
+  cel::FunctionRegistry function_registry_;
+  cel::TypeRegistry type_registry_;
+  google::protobuf::Arena arena_;
+  cel::ManagedValueFactory managed_value_factory_;
+};
+
+TEST_P(TypedKernelTest, IntArithmetic) {
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("x + y * 3 - 1", IntValue(7), IntValue(2)));
+  ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 12);
+
+  ASSERT_OK_AND_ASSIGN(
+      result, Evaluate("(x + y) * (x - y) / 5 % 4", IntValue(7), IntValue(2)));
+  ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 1);
+}
+
+TEST_P(TypedKernelTest, ComparisonsAndLogic) {
+  struct TestCase {
+    absl::string_view expression;
+    bool expected;
+  };
+  const TestCase kCases[] = {
+      {"(x + y) * (x - y) > 40 && x % y == 1", true},
+      {"x - y < 0 || x * y >= 14", true},
+      {"x < y && x / (y - y) > 0", false},
+      {"x / y < 4 || x / (y - y) > 0", true},
+  };
+
+  for (const TestCase& test_case : kCases) {
+    ASSERT_OK_AND_ASSIGN(Value result, Evaluate(test_case.expression,
+                                                IntValue(7), IntValue(2)));
+    ASSERT_TRUE(result.Is<BoolValue>())
+        << test_case.expression << " " << result.DebugString();
+    EXPECT_EQ(result.As<BoolValue>().NativeValue(), test_case.expected)
+        << test_case.expression;
+  }
+}
+
+TEST_P(TypedKernelTest, DoubleArithmetic) {
+  cel::Activation activation;
+  activation.InsertOrAssignValue("x", DoubleValue(1.5));
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result, Evaluate("x * 2.0 + x / 0.5 < 6.5", "double", activation));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(TypedKernelTest, FailedOperationsFallBack) {
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("x + 9223372036854775807 - y", IntValue(7), IntValue(2)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("integer overflow")));
+
+  ASSERT_OK_AND_ASSIGN(result,
+                       Evaluate("x / (y - y) + 1", IntValue(7), IntValue(2)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("divide by zero")));
+
+  // Errors are absorbed by logical operators as usual.
+  ASSERT_OK_AND_ASSIGN(
+      result, Evaluate("x / (y - y) > 0 || x > y", IntValue(7), IntValue(2)));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(TypedKernelTest, UnexpectedKindsFallBack) {
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("x + y * 3", UintValue(7), UintValue(2)));
+  ASSERT_TRUE(result.Is<UintValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<UintValue>().NativeValue(), 13);
+
+  cel::Activation activation;
+  activation.InsertOrAssignValue("y", IntValue(1));
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x + y * 2", "int64", activation));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kUnknown, HasSubstr("x")));
+}
+
+INSTANTIATE_TEST_SUITE_P(TypedKernelTest, TypedKernelTest, testing::Bool());
+
+}  // namespace
+}  // namespace google::api::expr::runtime
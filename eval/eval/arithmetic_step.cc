@@ -0,0 +1,752 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/arithmetic_step.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "absl/meta/type_traits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast_internal/expr.h"
+#include "base/kind.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/expression_step_base.h"
+#include "eval/eval/function_step.h"
+#include "internal/number.h"
+#include "internal/overflow.h"
+#include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/runtime_options.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::DurationValue;
+using ::cel::IntValue;
+using ::cel::TimestampValue;
+using ::cel::UintValue;
+using ::cel::Value;
+using ::cel::ValueKind;
+using ::cel::ValueManager;
+using ::cel::internal::ComparisonResult;
+
+template <typename T>
+struct OperandTraits;
+
+template <>
+struct OperandTraits<int64_t> {
+  static constexpr ValueKind kKind = ValueKind::kInt;
+  static int64_t Get(const Value& value) {
+    return value.As<IntValue>().NativeValue();
+  }
+  static Value Wrap(int64_t value) { return IntValue(value); }
+};
+
+template <>
+struct OperandTraits<uint64_t> {
+  static constexpr ValueKind kKind = ValueKind::kUint;
+  static uint64_t Get(const Value& value) {
+    return value.As<UintValue>().NativeValue();
+  }
+  static Value Wrap(uint64_t value) { return UintValue(value); }
+};
+
+template <>
+struct OperandTraits<double> {
+  static constexpr ValueKind kKind = ValueKind::kDouble;
+  static double Get(const Value& value) {
+    return value.As<DoubleValue>().NativeValue();
+  }
+  static Value Wrap(double value) { return DoubleValue(value); }
+};
+
+template <>
+struct OperandTraits<absl::Time> {
+  static constexpr ValueKind kKind = ValueKind::kTimestamp;
+  static absl::Time Get(const Value& value) {
+    return value.As<TimestampValue>().NativeValue();
+  }
+  static Value Wrap(absl::Time value) { return TimestampValue(value); }
+};
+
+template <>
+struct OperandTraits<absl::Duration> {
+  static constexpr ValueKind kKind = ValueKind::kDuration;
+  static absl::Duration Get(const Value& value) {
+    return value.As<DurationValue>().NativeValue();
+  }
+  static Value Wrap(absl::Duration value) { return DurationValue(value); }
+};
+
+// Whether the standard functions define `op` for operands of types L and R.
+template <ArithmeticOp Op, typename L, typename R>
+constexpr bool IsDefinedFor() {
+  if constexpr (std::is_arithmetic_v<L> || std::is_arithmetic_v<R>) {
+    return std::is_same_v<L, R> &&
+           (Op != ArithmeticOp::kModulo || std::is_integral_v<L>);
+  } else {
+    constexpr bool kSameType = std::is_same_v<L, R>;
+    constexpr bool kTimestampLhs = std::is_same_v<L, absl::Time>;
+    switch (Op) {
+      case ArithmeticOp::kAdd:
+        // timestamp + duration, duration + timestamp, duration + duration.
+        return !(kSameType && kTimestampLhs);
+      case ArithmeticOp::kSubtract:
+        // timestamp - duration, timestamp - timestamp, duration - duration.
+        return kSameType || kTimestampLhs;
+      case ArithmeticOp::kLess:
+      case ArithmeticOp::kLessOrEqual:
+      case ArithmeticOp::kGreater:
+      case ArithmeticOp::kGreaterOrEqual:
+        return kSameType;
+      default:
+        return false;
+    }
+  }
+}
+
+template <typename T>
+Value FromChecked(ValueManager& value_manager, absl::StatusOr<T> result) {
+  if (!result.ok()) {
+    return value_manager.CreateErrorValue(std::move(result).status());
+  }
+  return OperandTraits<T>::Wrap(*result);
+}
+
+// Mirrors the standard arithmetic and comparison functions in
+// runtime/standard. Integer add, subtract and multiply check for overflow
+// inline where the compiler supports it, and only call into the checked
+// helpers to produce the (identical) error.
+template <ArithmeticOp Op, typename T>
+Value Apply(ValueManager& value_manager, T lhs, T rhs) {
+  using Traits = OperandTraits<T>;
+  if constexpr (Op == ArithmeticOp::kLess) {
+    return BoolValue(lhs < rhs);
+  } else if constexpr (Op == ArithmeticOp::kLessOrEqual) {
+    return BoolValue(lhs <= rhs);
+  } else if constexpr (Op == ArithmeticOp::kGreater) {
+    return BoolValue(rhs < lhs);
+  } else if constexpr (Op == ArithmeticOp::kGreaterOrEqual) {
+    return BoolValue(rhs <= lhs);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    static_assert(Op != ArithmeticOp::kModulo);
+    if constexpr (Op == ArithmeticOp::kAdd) {
+      return Traits::Wrap(lhs + rhs);
+    } else if constexpr (Op == ArithmeticOp::kSubtract) {
+      return Traits::Wrap(lhs - rhs);
+    } else if constexpr (Op == ArithmeticOp::kMultiply) {
+      return Traits::Wrap(lhs * rhs);
+    } else {
+      // IEEE division, division by zero results in +/- inf or NaN.
+      return Traits::Wrap(lhs / rhs);
+    }
+  } else if constexpr (Op == ArithmeticOp::kAdd) {
+#if ABSL_HAVE_BUILTIN(__builtin_add_overflow)
+    T sum;
+    if (!__builtin_add_overflow(lhs, rhs, &sum)) {
+      return Traits::Wrap(sum);
+    }
+#endif
+    return FromChecked(value_manager, cel::internal::CheckedAdd(lhs, rhs));
+  } else if constexpr (Op == ArithmeticOp::kSubtract) {
+#if ABSL_HAVE_BUILTIN(__builtin_sub_overflow)
+    T diff;
+    if (!__builtin_sub_overflow(lhs, rhs, &diff)) {
+      return Traits::Wrap(diff);
+    }
+#endif
+    return FromChecked(value_manager, cel::internal::CheckedSub(lhs, rhs));
+  } else if constexpr (Op == ArithmeticOp::kMultiply) {
+#if ABSL_HAVE_BUILTIN(__builtin_mul_overflow)
+    T prod;
+    if (!__builtin_mul_overflow(lhs, rhs, &prod)) {
+      return Traits::Wrap(prod);
+    }
+#endif
+    return FromChecked(value_manager, cel::internal::CheckedMul(lhs, rhs));
+  } else if constexpr (Op == ArithmeticOp::kDivide) {
+    return FromChecked(value_manager, cel::internal::CheckedDiv(lhs, rhs));
+  } else {
+    return FromChecked(value_manager, cel::internal::CheckedMod(lhs, rhs));
+  }
+}
+
+// Mirrors the timestamp and duration functions in runtime/standard, which
+// check for overflow if `RuntimeOptions::enable_timestamp_duration_overflow_
+// errors` is set. The checked helpers split the operands into whole seconds
+// and nanoseconds rather than using the general absl::Duration arithmetic.
+template <ArithmeticOp Op, typename L, typename R>
+Value ApplyTemporal(ExecutionFrameBase& frame, L lhs, R rhs) {
+  if constexpr (Op == ArithmeticOp::kLess) {
+    return BoolValue(lhs < rhs);
+  } else if constexpr (Op == ArithmeticOp::kLessOrEqual) {
+    return BoolValue(lhs <= rhs);
+  } else if constexpr (Op == ArithmeticOp::kGreater) {
+    return BoolValue(rhs < lhs);
+  } else if constexpr (Op == ArithmeticOp::kGreaterOrEqual) {
+    return BoolValue(rhs <= lhs);
+  } else if constexpr (Op == ArithmeticOp::kAdd &&
+                       std::is_same_v<R, absl::Time>) {
+    // duration + timestamp
+    return ApplyTemporal<Op, R, L>(frame, rhs, lhs);
+  } else if constexpr (Op == ArithmeticOp::kAdd) {
+    if (!frame.options().enable_timestamp_duration_overflow_errors) {
+      return OperandTraits<L>::Wrap(lhs + rhs);
+    }
+    return FromChecked(frame.value_manager(),
+                       cel::internal::CheckedAdd(lhs, rhs));
+  } else {
+    static_assert(Op == ArithmeticOp::kSubtract);
+    using Result = decltype(lhs - rhs);
+    if (!frame.options().enable_timestamp_duration_overflow_errors) {
+      return OperandTraits<Result>::Wrap(lhs - rhs);
+    }
+    return FromChecked(frame.value_manager(),
+                       cel::internal::CheckedSub(lhs, rhs));
+  }
+}
+
+template <ArithmeticOp Op, typename L, typename R>
+Value ApplyOperands(ExecutionFrameBase& frame, const Value& lhs,
+                    const Value& rhs) {
+  if constexpr (std::is_arithmetic_v<L>) {
+    return Apply<Op, L>(frame.value_manager(), OperandTraits<L>::Get(lhs),
+                        OperandTraits<R>::Get(rhs));
+  } else {
+    return ApplyTemporal<Op, L, R>(frame, OperandTraits<L>::Get(lhs),
+                                   OperandTraits<R>::Get(rhs));
+  }
+}
+
+template <typename L, typename R>
+bool OperandsMatch(const Value& lhs, const Value& rhs) {
+  return lhs->kind() == OperandTraits<L>::kKind &&
+         rhs->kind() == OperandTraits<R>::kKind;
+}
+
+template <ArithmeticOp Op, typename L, typename R>
+class ArithmeticStep final : public ExpressionStepBase {
+ public:
+  ArithmeticStep(int64_t expr_id, std::unique_ptr<ExpressionStep> fallback)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        fallback_(std::move(fallback)) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(2)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Value stack underflow");
+    }
+    if (frame->enable_unknowns()) {
+      return fallback_->Evaluate(frame);
+    }
+    absl::Span<const Value> args = frame->value_stack().GetSpan(2);
+    if (!OperandsMatch<L, R>(args[0], args[1])) {
+      return fallback_->Evaluate(frame);
+    }
+    Value result = ApplyOperands<Op, L, R>(*frame, args[0], args[1]);
+    frame->value_stack().PopAndPush(2, std::move(result));
+    return absl::OkStatus();
+  }
+
+ private:
+  // The generic function step for the call.
+  std::unique_ptr<ExpressionStep> fallback_;
+};
+
+template <ArithmeticOp Op, typename L, typename R>
+class DirectArithmeticStep final : public DirectExpressionStep {
+ public:
+  DirectArithmeticStep(int64_t expr_id, std::string name,
+                       std::unique_ptr<DirectExpressionStep> lhs,
+                       std::unique_ptr<DirectExpressionStep> rhs,
+                       std::vector<cel::FunctionOverloadReference> overloads)
+      : DirectExpressionStep(expr_id),
+        name_(std::move(name)),
+        lhs_(std::move(lhs)),
+        rhs_(std::move(rhs)),
+        overloads_(std::move(overloads)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& trail) const override {
+    Value args[2];
+    AttributeTrail arg_trails[2];
+    CEL_RETURN_IF_ERROR(lhs_->Evaluate(frame, args[0], arg_trails[0]));
+    CEL_RETURN_IF_ERROR(rhs_->Evaluate(frame, args[1], arg_trails[1]));
+
+    if (frame.unknown_processing_enabled()) {
+      for (int i = 0; i < 2; ++i) {
+        if (frame.attribute_utility().CheckForUnknown(arg_trails[i],
+                                                      /*use_partial=*/true)) {
+          args[i] = frame.attribute_utility().CreateUnknownSet(
+              arg_trails[i].attribute());
+        }
+      }
+    }
+
+    if (OperandsMatch<L, R>(args[0], args[1])) {
+      result = ApplyOperands<Op, L, R>(frame, args[0], args[1]);
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(result, InvokeFunctionOverloads(
+                                     frame, expr_id_, name_, overloads_,
+                                     absl::MakeConstSpan(args)));
+    return absl::OkStatus();
+  }
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{lhs_.get(), rhs_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.push_back(std::move(lhs_));
+    dependencies.push_back(std::move(rhs_));
+    return dependencies;
+  }
+
+ private:
+  std::string name_;
+  std::unique_ptr<DirectExpressionStep> lhs_;
+  std::unique_ptr<DirectExpressionStep> rhs_;
+  std::vector<cel::FunctionOverloadReference> overloads_;
+};
+
+template <typename T>
+struct TypeTag {
+  using type = T;
+};
+
+// Calls `f` with the TypeTag of the operand type for `kind`, if any.
+template <typename F>
+void VisitOperandType(cel::Kind kind, F&& f) {
+  switch (kind) {
+    case cel::Kind::kInt:
+      return f(TypeTag<int64_t>{});
+    case cel::Kind::kUint:
+      return f(TypeTag<uint64_t>{});
+    case cel::Kind::kDouble:
+      return f(TypeTag<double>{});
+    case cel::Kind::kTimestamp:
+      return f(TypeTag<absl::Time>{});
+    case cel::Kind::kDuration:
+      return f(TypeTag<absl::Duration>{});
+    default:
+      return;
+  }
+}
+
+template <ArithmeticOp Op>
+using OpTag = std::integral_constant<ArithmeticOp, Op>;
+
+// Calls `f` with the OpTag for `op`.
+template <typename F>
+void VisitArithmeticOp(ArithmeticOp op, F&& f) {
+  switch (op) {
+    case ArithmeticOp::kAdd:
+      return f(OpTag<ArithmeticOp::kAdd>{});
+    case ArithmeticOp::kSubtract:
+      return f(OpTag<ArithmeticOp::kSubtract>{});
+    case ArithmeticOp::kMultiply:
+      return f(OpTag<ArithmeticOp::kMultiply>{});
+    case ArithmeticOp::kDivide:
+      return f(OpTag<ArithmeticOp::kDivide>{});
+    case ArithmeticOp::kModulo:
+      return f(OpTag<ArithmeticOp::kModulo>{});
+    case ArithmeticOp::kLess:
+      return f(OpTag<ArithmeticOp::kLess>{});
+    case ArithmeticOp::kLessOrEqual:
+      return f(OpTag<ArithmeticOp::kLessOrEqual>{});
+    case ArithmeticOp::kGreater:
+      return f(OpTag<ArithmeticOp::kGreater>{});
+    case ArithmeticOp::kGreaterOrEqual:
+      return f(OpTag<ArithmeticOp::kGreaterOrEqual>{});
+  }
+}
+
+// Calls `f` with the op and operand type tags, if `op` is defined for
+// operands of `lhs_kind` and `rhs_kind`.
+template <typename F>
+void VisitDefined(ArithmeticOp op, cel::Kind lhs_kind, cel::Kind rhs_kind,
+                  F&& f) {
+  VisitArithmeticOp(op, [&](auto op_tag) {
+    using OpT = absl::decay_t<decltype(op_tag)>;
+    VisitOperandType(lhs_kind, [&](auto lhs_tag) {
+      using L = typename absl::decay_t<decltype(lhs_tag)>::type;
+      VisitOperandType(rhs_kind, [&](auto rhs_tag) {
+        using R = typename absl::decay_t<decltype(rhs_tag)>::type;
+        if constexpr (IsDefinedFor<OpT::value, L, R>()) {
+          f(OpT{}, TypeTag<L>{}, TypeTag<R>{});
+        }
+      });
+    });
+  });
+}
+
+// Returns nullptr if `op` isn't supported for `lhs_kind` and `rhs_kind`.
+template <template <ArithmeticOp, typename, typename> class Step,
+          typename Base, typename... Args>
+std::unique_ptr<Base> MakeStep(ArithmeticOp op, cel::Kind lhs_kind,
+                               cel::Kind rhs_kind, Args&&... args) {
+  std::unique_ptr<Base> step;
+  VisitDefined(op, lhs_kind, rhs_kind,
+               [&](auto op_tag, auto lhs_tag, auto rhs_tag) {
+                 step = std::make_unique<
+                     Step<absl::decay_t<decltype(op_tag)>::value,
+                          typename absl::decay_t<decltype(lhs_tag)>::type,
+                          typename absl::decay_t<decltype(rhs_tag)>::type>>(
+                     std::forward<Args>(args)...);
+               });
+  return step;
+}
+
+constexpr cel::Kind kNumericKinds[] = {cel::Kind::kInt, cel::Kind::kUint,
+                                       cel::Kind::kDouble};
+
+// Returns the position of `kind` in kNumericKinds, or -1.
+int NumericKindIndex(ValueKind kind) {
+  switch (kind) {
+    case ValueKind::kInt:
+      return 0;
+    case ValueKind::kUint:
+      return 1;
+    case ValueKind::kDouble:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+// Returns the set of operand kind pairs, with bit `3 * lhs + rhs` for the
+// positions of the kinds in kNumericKinds, that `overloads` dispatches to
+// some overload.
+uint16_t DispatchedNumericPairs(
+    absl::Span<const cel::FunctionOverloadReference> overloads) {
+  uint16_t pairs = 0;
+  for (int lhs = 0; lhs < 3; ++lhs) {
+    for (int rhs = 0; rhs < 3; ++rhs) {
+      const cel::Kind types[] = {kNumericKinds[lhs], kNumericKinds[rhs]};
+      for (const auto& overload : overloads) {
+        if (overload.descriptor.ShapeMatches(/*receiver_style=*/false,
+                                             types)) {
+          pairs |= 1 << (3 * lhs + rhs);
+          break;
+        }
+      }
+    }
+  }
+  return pairs;
+}
+
+// Returns the pair of operand kinds if it is in `pairs`, or -1.
+int InlineNumericPair(const Value& lhs, const Value& rhs, uint16_t pairs) {
+  const int lhs_index = NumericKindIndex(lhs->kind());
+  const int rhs_index = NumericKindIndex(rhs->kind());
+  if (lhs_index < 0 || rhs_index < 0) {
+    return -1;
+  }
+  const int pair = 3 * lhs_index + rhs_index;
+  return (pairs & (1 << pair)) != 0 ? pair : -1;
+}
+
+// Compares the operands of an inline pair as cel::internal::Number does,
+// without wrapping them in a variant first.
+ComparisonResult CompareNumbers(const Value& lhs, const Value& rhs, int pair) {
+  switch (pair) {
+    case 0:
+      return cel::internal::Compare(OperandTraits<int64_t>::Get(lhs),
+                                    OperandTraits<int64_t>::Get(rhs));
+    case 1:
+      return cel::internal::IntCompareVisitor(
+          OperandTraits<int64_t>::Get(lhs))(OperandTraits<uint64_t>::Get(rhs));
+    case 2:
+      return cel::internal::IntCompareVisitor(
+          OperandTraits<int64_t>::Get(lhs))(OperandTraits<double>::Get(rhs));
+    case 3:
+      return cel::internal::UintCompareVisitor(
+          OperandTraits<uint64_t>::Get(lhs))(OperandTraits<int64_t>::Get(rhs));
+    case 4:
+      return cel::internal::Compare(OperandTraits<uint64_t>::Get(lhs),
+                                    OperandTraits<uint64_t>::Get(rhs));
+    case 5:
+      return cel::internal::UintCompareVisitor(
+          OperandTraits<uint64_t>::Get(lhs))(OperandTraits<double>::Get(rhs));
+    case 6:
+      return cel::internal::DoubleCompareVisitor(
+          OperandTraits<double>::Get(lhs))(OperandTraits<int64_t>::Get(rhs));
+    case 7:
+      return cel::internal::DoubleCompareVisitor(
+          OperandTraits<double>::Get(lhs))(OperandTraits<uint64_t>::Get(rhs));
+    default:
+      return cel::internal::DoubleCompare(OperandTraits<double>::Get(lhs),
+                                          OperandTraits<double>::Get(rhs));
+  }
+}
+
+template <NumericComparisonOp Op>
+bool Holds(ComparisonResult cmp) {
+  if constexpr (Op == NumericComparisonOp::kEqual) {
+    return cmp == ComparisonResult::kEqual;
+  } else if constexpr (Op == NumericComparisonOp::kNotEqual) {
+    return cmp != ComparisonResult::kEqual;
+  } else if constexpr (Op == NumericComparisonOp::kLess) {
+    return cmp == ComparisonResult::kLesser;
+  } else if constexpr (Op == NumericComparisonOp::kLessOrEqual) {
+    return cmp == ComparisonResult::kLesser || cmp == ComparisonResult::kEqual;
+  } else if constexpr (Op == NumericComparisonOp::kGreater) {
+    return cmp == ComparisonResult::kGreater;
+  } else {
+    return cmp == ComparisonResult::kGreater || cmp == ComparisonResult::kEqual;
+  }
+}
+
+template <NumericComparisonOp Op>
+class NumericComparisonStep final : public ExpressionStepBase {
+ public:
+  NumericComparisonStep(int64_t expr_id, uint16_t pairs,
+                        std::unique_ptr<ExpressionStep> fallback)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        pairs_(pairs),
+        fallback_(std::move(fallback)) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(2)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Value stack underflow");
+    }
+    if (frame->enable_unknowns()) {
+      return fallback_->Evaluate(frame);
+    }
+    absl::Span<const Value> args = frame->value_stack().GetSpan(2);
+    const int pair = InlineNumericPair(args[0], args[1], pairs_);
+    if (pair < 0) {
+      return fallback_->Evaluate(frame);
+    }
+    bool result = Holds<Op>(CompareNumbers(args[0], args[1], pair));
+    frame->value_stack().PopAndPush(2, BoolValue(result));
+    return absl::OkStatus();
+  }
+
+ private:
+  uint16_t pairs_;
+  // The generic function step for the call.
+  std::unique_ptr<ExpressionStep> fallback_;
+};
+
+template <NumericComparisonOp Op>
+class DirectNumericComparisonStep final : public DirectExpressionStep {
+ public:
+  DirectNumericComparisonStep(
+      int64_t expr_id, std::string name, uint16_t pairs,
+      std::unique_ptr<DirectExpressionStep> lhs,
+      std::unique_ptr<DirectExpressionStep> rhs,
+      std::vector<cel::FunctionOverloadReference> overloads)
+      : DirectExpressionStep(expr_id),
+        name_(std::move(name)),
+        pairs_(pairs),
+        lhs_(std::move(lhs)),
+        rhs_(std::move(rhs)),
+        overloads_(std::move(overloads)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& trail) const override {
+    Value args[2];
+    AttributeTrail arg_trails[2];
+    CEL_RETURN_IF_ERROR(lhs_->Evaluate(frame, args[0], arg_trails[0]));
+    CEL_RETURN_IF_ERROR(rhs_->Evaluate(frame, args[1], arg_trails[1]));
+
+    if (frame.unknown_processing_enabled()) {
+      for (int i = 0; i < 2; ++i) {
+        if (frame.attribute_utility().CheckForUnknown(arg_trails[i],
+                                                      /*use_partial=*/true)) {
+          args[i] = frame.attribute_utility().CreateUnknownSet(
+              arg_trails[i].attribute());
+        }
+      }
+    }
+
+    if (const int pair = InlineNumericPair(args[0], args[1], pairs_);
+        pair >= 0) {
+      result = BoolValue(Holds<Op>(CompareNumbers(args[0], args[1], pair)));
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(result, InvokeFunctionOverloads(
+                                     frame, expr_id_, name_, overloads_,
+                                     absl::MakeConstSpan(args)));
+    return absl::OkStatus();
+  }
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{lhs_.get(), rhs_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.push_back(std::move(lhs_));
+    dependencies.push_back(std::move(rhs_));
+    return dependencies;
+  }
+
+ private:
+  std::string name_;
+  uint16_t pairs_;
+  std::unique_ptr<DirectExpressionStep> lhs_;
+  std::unique_ptr<DirectExpressionStep> rhs_;
+  std::vector<cel::FunctionOverloadReference> overloads_;
+};
+
+template <template <NumericComparisonOp> class Step, typename Base,
+          typename... Args>
+std::unique_ptr<Base> MakeComparisonStep(NumericComparisonOp op,
+                                         Args&&... args) {
+  switch (op) {
+    case NumericComparisonOp::kEqual:
+      return std::make_unique<Step<NumericComparisonOp::kEqual>>(
+          std::forward<Args>(args)...);
+    case NumericComparisonOp::kNotEqual:
+      return std::make_unique<Step<NumericComparisonOp::kNotEqual>>(
+          std::forward<Args>(args)...);
+    case NumericComparisonOp::kLess:
+      return std::make_unique<Step<NumericComparisonOp::kLess>>(
+          std::forward<Args>(args)...);
+    case NumericComparisonOp::kLessOrEqual:
+      return std::make_unique<Step<NumericComparisonOp::kLessOrEqual>>(
+          std::forward<Args>(args)...);
+    case NumericComparisonOp::kGreater:
+      return std::make_unique<Step<NumericComparisonOp::kGreater>>(
+          std::forward<Args>(args)...);
+    case NumericComparisonOp::kGreaterOrEqual:
+      return std::make_unique<Step<NumericComparisonOp::kGreaterOrEqual>>(
+          std::forward<Args>(args)...);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+bool IsSupportedArithmeticOp(ArithmeticOp op, cel::Kind kind) {
+  return IsSupportedArithmeticOp(op, kind, kind);
+}
+
+bool IsSupportedArithmeticOp(ArithmeticOp op, cel::Kind lhs_kind,
+                             cel::Kind rhs_kind) {
+  bool supported = false;
+  VisitDefined(op, lhs_kind, rhs_kind,
+               [&](auto, auto, auto) { supported = true; });
+  return supported;
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectArithmeticStep(
+    int64_t expr_id, const cel::ast_internal::Call& call, ArithmeticOp op,
+    cel::Kind operand_kind, std::unique_ptr<DirectExpressionStep> lhs,
+    std::unique_ptr<DirectExpressionStep> rhs,
+    std::vector<cel::FunctionOverloadReference> overloads) {
+  return CreateDirectArithmeticStep(expr_id, call, op, operand_kind,
+                                    operand_kind, std::move(lhs),
+                                    std::move(rhs), std::move(overloads));
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectArithmeticStep(
+    int64_t expr_id, const cel::ast_internal::Call& call, ArithmeticOp op,
+    cel::Kind lhs_kind, cel::Kind rhs_kind,
+    std::unique_ptr<DirectExpressionStep> lhs,
+    std::unique_ptr<DirectExpressionStep> rhs,
+    std::vector<cel::FunctionOverloadReference> overloads) {
+  if (!IsSupportedArithmeticOp(op, lhs_kind, rhs_kind)) {
+    std::vector<std::unique_ptr<DirectExpressionStep>> deps;
+    deps.push_back(std::move(lhs));
+    deps.push_back(std::move(rhs));
+    return CreateDirectFunctionStep(expr_id, call, std::move(deps),
+                                    std::move(overloads));
+  }
+  return MakeStep<DirectArithmeticStep, DirectExpressionStep>(
+      op, lhs_kind, rhs_kind, expr_id, call.function(), std::move(lhs),
+      std::move(rhs), std::move(overloads));
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateArithmeticStep(
+    const cel::ast_internal::Call& call, int64_t expr_id, ArithmeticOp op,
+    cel::Kind operand_kind,
+    std::vector<cel::FunctionOverloadReference> overloads) {
+  return CreateArithmeticStep(call, expr_id, op, operand_kind, operand_kind,
+                              std::move(overloads));
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateArithmeticStep(
+    const cel::ast_internal::Call& call, int64_t expr_id, ArithmeticOp op,
+    cel::Kind lhs_kind, cel::Kind rhs_kind,
+    std::vector<cel::FunctionOverloadReference> overloads) {
+  CEL_ASSIGN_OR_RETURN(std::unique_ptr<ExpressionStep> fallback,
+                       CreateFunctionStep(call, expr_id, std::move(overloads)));
+  if (!IsSupportedArithmeticOp(op, lhs_kind, rhs_kind)) {
+    return fallback;
+  }
+  return MakeStep<ArithmeticStep, ExpressionStep>(
+      op, lhs_kind, rhs_kind, expr_id, std::move(fallback));
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectNumericComparisonStep(
+    int64_t expr_id, const cel::ast_internal::Call& call,
+    NumericComparisonOp op, std::unique_ptr<DirectExpressionStep> lhs,
+    std::unique_ptr<DirectExpressionStep> rhs,
+    std::vector<cel::FunctionOverloadReference> overloads) {
+  const uint16_t pairs = DispatchedNumericPairs(overloads);
+  if (pairs == 0) {
+    std::vector<std::unique_ptr<DirectExpressionStep>> deps;
+    deps.push_back(std::move(lhs));
+    deps.push_back(std::move(rhs));
+    return CreateDirectFunctionStep(expr_id, call, std::move(deps),
+                                    std::move(overloads));
+  }
+  return MakeComparisonStep<DirectNumericComparisonStep, DirectExpressionStep>(
+      op, expr_id, call.function(), pairs, std::move(lhs), std::move(rhs),
+      std::move(overloads));
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateNumericComparisonStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    NumericComparisonOp op,
+    std::vector<cel::FunctionOverloadReference> overloads) {
+  const uint16_t pairs = DispatchedNumericPairs(overloads);
+  CEL_ASSIGN_OR_RETURN(std::unique_ptr<ExpressionStep> fallback,
+                       CreateFunctionStep(call, expr_id, std::move(overloads)));
+  if (pairs == 0) {
+    return fallback;
+  }
+  return MakeComparisonStep<NumericComparisonStep, ExpressionStep>(
+      op, expr_id, pairs, std::move(fallback));
+}
+
+}  // namespace google::api::expr::runtime
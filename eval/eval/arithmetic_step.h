@@ -0,0 +1,130 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_ARITHMETIC_STEP_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_ARITHMETIC_STEP_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "base/ast_internal/expr.h"
+#include "base/kind.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "runtime/function_overload_reference.h"
+
+namespace google::api::expr::runtime {
+
+// Binary operators with standard overloads for int, uint and double operands,
+// or timestamp and duration operands, that may be evaluated inline.
+enum class ArithmeticOp {
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kDivide,
+  // Not defined for double.
+  kModulo,
+  kLess,
+  kLessOrEqual,
+  kGreater,
+  kGreaterOrEqual,
+};
+
+// Returns whether `op` is defined for two operands of `kind`.
+bool IsSupportedArithmeticOp(ArithmeticOp op, cel::Kind kind);
+
+// Returns whether `op` is defined for operands of `lhs_kind` and `rhs_kind`,
+// e.g. timestamp - duration.
+bool IsSupportedArithmeticOp(ArithmeticOp op, cel::Kind lhs_kind,
+                             cel::Kind rhs_kind);
+
+// Create a direct step that applies `op` to the results of lhs and rhs inline
+// when both are of `operand_kind`, with the same results (including overflow
+// and division by zero errors) as the standard function.
+//
+// Any other combination of arguments is dispatched to `overloads`, the
+// overloads of the call's function, exactly as the function step would.
+std::unique_ptr<DirectExpressionStep> CreateDirectArithmeticStep(
+    int64_t expr_id, const cel::ast_internal::Call& call, ArithmeticOp op,
+    cel::Kind operand_kind, std::unique_ptr<DirectExpressionStep> lhs,
+    std::unique_ptr<DirectExpressionStep> rhs,
+    std::vector<cel::FunctionOverloadReference> overloads);
+
+// As above, for operands of `lhs_kind` and `rhs_kind`. Timestamp and duration
+// arithmetic reports overflow only if
+// `RuntimeOptions::enable_timestamp_duration_overflow_errors` is set, as the
+// standard functions do.
+std::unique_ptr<DirectExpressionStep> CreateDirectArithmeticStep(
+    int64_t expr_id, const cel::ast_internal::Call& call, ArithmeticOp op,
+    cel::Kind lhs_kind, cel::Kind rhs_kind,
+    std::unique_ptr<DirectExpressionStep> lhs,
+    std::unique_ptr<DirectExpressionStep> rhs,
+    std::vector<cel::FunctionOverloadReference> overloads);
+
+// Create a stack machine step that replaces the top two values on the stack
+// with the result of `op`, as for `CreateDirectArithmeticStep`.
+//
+// If unknown processing is enabled the stack machine step always dispatches
+// to `overloads`, since partial unknowns depend on the attribute trails.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateArithmeticStep(
+    const cel::ast_internal::Call& call, int64_t expr_id, ArithmeticOp op,
+    cel::Kind operand_kind,
+    std::vector<cel::FunctionOverloadReference> overloads);
+
+// As above, for operands of `lhs_kind` and `rhs_kind`.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateArithmeticStep(
+    const cel::ast_internal::Call& call, int64_t expr_id, ArithmeticOp op,
+    cel::Kind lhs_kind, cel::Kind rhs_kind,
+    std::vector<cel::FunctionOverloadReference> overloads);
+
+// Comparisons with standard overloads for every combination of int, uint and
+// double operands, which compare the operands on a single number line.
+enum class NumericComparisonOp {
+  kEqual,
+  kNotEqual,
+  kLess,
+  kLessOrEqual,
+  kGreater,
+  kGreaterOrEqual,
+};
+
+// Create a direct step that applies `op` to the results of lhs and rhs inline
+// when they are any combination of int, uint and double that `overloads`
+// dispatches to a registered overload, with the same results as the standard
+// comparison and equality functions. The comparison doesn't depend on the
+// kinds being known when planning.
+//
+// Any other combination of arguments is dispatched to `overloads`, the
+// overloads of the call's function, exactly as the function step would.
+std::unique_ptr<DirectExpressionStep> CreateDirectNumericComparisonStep(
+    int64_t expr_id, const cel::ast_internal::Call& call,
+    NumericComparisonOp op, std::unique_ptr<DirectExpressionStep> lhs,
+    std::unique_ptr<DirectExpressionStep> rhs,
+    std::vector<cel::FunctionOverloadReference> overloads);
+
+// Create a stack machine step that replaces the top two values on the stack
+// with the result of `op`, as for `CreateDirectNumericComparisonStep`.
+//
+// If unknown processing is enabled the stack machine step always dispatches
+// to `overloads`, since partial unknowns depend on the attribute trails.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateNumericComparisonStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    NumericComparisonOp op,
+    std::vector<cel::FunctionOverloadReference> overloads);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_ARITHMETIC_STEP_H_
@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/attribute_pattern_trie.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
+#include "base/attribute.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::AttributePattern;
+using ::cel::AttributeQualifier;
+
+template <typename Map, typename Key>
+typename Map::mapped_type::element_type* GetOrAdd(Map& map, Key&& key) {
+  auto& child = map[std::forward<Key>(key)];
+  if (child == nullptr) {
+    child = std::make_unique<typename Map::mapped_type::element_type>();
+  }
+  return child.get();
+}
+
+template <typename Map, typename Key>
+const typename Map::mapped_type::element_type* Find(const Map& map,
+                                                    const Key& key) {
+  auto it = map.find(key);
+  return it == map.end() ? nullptr : it->second.get();
+}
+
+}  // namespace
+
+AttributePatternTrie::AttributePatternTrie(
+    absl::Span<const AttributePattern> patterns) {
+  for (const AttributePattern& pattern : patterns) {
+    Node* node = &roots_[std::string(pattern.variable())];
+    for (const auto& qualifier : pattern.qualifier_path()) {
+      if (qualifier.IsWildcard()) {
+        if (node->wildcard == nullptr) {
+          node->wildcard = std::make_unique<Node>();
+        }
+        node = node->wildcard.get();
+      } else {
+        node = AddChild(*node, *qualifier.value());
+      }
+      if (node == nullptr) {
+        break;
+      }
+    }
+    // A pattern with a qualifier that matches nothing may still partially
+    // match the attributes that stop before it.
+    if (node != nullptr) {
+      node->terminal = true;
+    }
+  }
+}
+
+AttributePatternTrie::Node* AttributePatternTrie::AddChild(
+    Node& node, const AttributeQualifier& value) {
+  if (auto key = value.GetInt64Key(); key.has_value()) {
+    return GetOrAdd(node.int_children, *key);
+  }
+  if (auto key = value.GetUint64Key(); key.has_value()) {
+    return GetOrAdd(node.uint_children, *key);
+  }
+  if (auto key = value.GetStringKey(); key.has_value()) {
+    return GetOrAdd(node.string_children, std::string(*key));
+  }
+  if (auto key = value.GetBoolKey(); key.has_value()) {
+    return GetOrAdd(node.bool_children, *key);
+  }
+  return nullptr;
+}
+
+const AttributePatternTrie::Node* AttributePatternTrie::FindChild(
+    const Node& node, const AttributeQualifier& qualifier) {
+  if (auto key = qualifier.GetInt64Key(); key.has_value()) {
+    return Find(node.int_children, *key);
+  }
+  if (auto key = qualifier.GetUint64Key(); key.has_value()) {
+    return Find(node.uint_children, *key);
+  }
+  if (auto key = qualifier.GetStringKey(); key.has_value()) {
+    return Find(node.string_children, *key);
+  }
+  if (auto key = qualifier.GetBoolKey(); key.has_value()) {
+    return Find(node.bool_children, *key);
+  }
+  return nullptr;
+}
+
+AttributePattern::MatchType AttributePatternTrie::Match(
+    const cel::Attribute& attribute) const {
+  auto root = roots_.find(attribute.variable_name());
+  if (root == roots_.end()) {
+    return AttributePattern::MatchType::NONE;
+  }
+  // Every node is on the path of some pattern, so reaching one past the end
+  // of the attribute is a partial match.
+  absl::InlinedVector<const Node*, 4> nodes = {&root->second};
+  absl::InlinedVector<const Node*, 4> next;
+  for (const AttributeQualifier& qualifier : attribute.qualifier_path()) {
+    next.clear();
+    for (const Node* node : nodes) {
+      if (node->terminal) {
+        return AttributePattern::MatchType::FULL;
+      }
+      if (const Node* child = FindChild(*node, qualifier); child != nullptr) {
+        next.push_back(child);
+      }
+      if (node->wildcard != nullptr) {
+        next.push_back(node->wildcard.get());
+      }
+    }
+    if (next.empty()) {
+      return AttributePattern::MatchType::NONE;
+    }
+    nodes.swap(next);
+  }
+  for (const Node* node : nodes) {
+    if (node->terminal) {
+      return AttributePattern::MatchType::FULL;
+    }
+  }
+  return AttributePattern::MatchType::PARTIAL;
+}
+
+}  // namespace google::api::expr::runtime
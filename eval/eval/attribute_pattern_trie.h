@@ -0,0 +1,68 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_ATTRIBUTE_PATTERN_TRIE_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_ATTRIBUTE_PATTERN_TRIE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "base/attribute.h"
+
+namespace google::api::expr::runtime {
+
+// Index of a set of attribute patterns, keyed by variable name and then by
+// qualifier, with a separate branch for wildcards.
+//
+// Matching an attribute visits the patterns sharing a prefix with it, instead
+// of comparing it with every pattern.
+class AttributePatternTrie {
+ public:
+  explicit AttributePatternTrie(
+      absl::Span<const cel::AttributePattern> patterns);
+
+  AttributePatternTrie(AttributePatternTrie&&) = default;
+  AttributePatternTrie& operator=(AttributePatternTrie&&) = default;
+
+  // Returns FULL if any of the patterns fully matches `attribute`, otherwise
+  // PARTIAL if any of them partially matches it, as AttributePattern::IsMatch.
+  cel::AttributePattern::MatchType Match(const cel::Attribute& attribute) const;
+
+ private:
+  struct Node {
+    // Whether a pattern ends at this node.
+    bool terminal = false;
+    absl::flat_hash_map<int64_t, std::unique_ptr<Node>> int_children;
+    absl::flat_hash_map<uint64_t, std::unique_ptr<Node>> uint_children;
+    absl::flat_hash_map<std::string, std::unique_ptr<Node>> string_children;
+    absl::flat_hash_map<bool, std::unique_ptr<Node>> bool_children;
+    std::unique_ptr<Node> wildcard;
+  };
+
+  // Returns the child of `node` for `value`, or nullptr if the qualifier can't
+  // be matched by any attribute.
+  static Node* AddChild(Node& node, const cel::AttributeQualifier& value);
+
+  static const Node* FindChild(const Node& node,
+                               const cel::AttributeQualifier& qualifier);
+
+  absl::flat_hash_map<std::string, Node> roots_;
+};
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_ATTRIBUTE_PATTERN_TRIE_H_
@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/attribute_pattern_trie.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "base/attribute.h"
+#include "internal/testing.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::Attribute;
+using ::cel::AttributePattern;
+using ::cel::AttributeQualifier;
+using ::cel::AttributeQualifierPattern;
+using MatchType = ::cel::AttributePattern::MatchType;
+
+// Returns the closest match of `attribute` by scanning `patterns`.
+MatchType ScanPatterns(const std::vector<AttributePattern>& patterns,
+                       const Attribute& attribute) {
+  MatchType result = MatchType::NONE;
+  for (const auto& pattern : patterns) {
+    MatchType match = pattern.IsMatch(attribute);
+    if (match == MatchType::FULL) {
+      return match;
+    }
+    if (match == MatchType::PARTIAL) {
+      result = match;
+    }
+  }
+  return result;
+}
+
+TEST(AttributePatternTrieTest, Empty) {
+  AttributePatternTrie trie({});
+
+  EXPECT_EQ(trie.Match(Attribute("a")), MatchType::NONE);
+}
+
+TEST(AttributePatternTrieTest, MatchesLikePatterns) {
+  std::vector<AttributePattern> patterns = {
+      AttributePattern("a", {AttributeQualifierPattern::OfString("b"),
+                             AttributeQualifierPattern::OfInt(1)}),
+      AttributePattern("a", {AttributeQualifierPattern::CreateWildcard(),
+                             AttributeQualifierPattern::OfBool(true)}),
+      AttributePattern("c", {}),
+      AttributePattern("d", {AttributeQualifierPattern::OfUint(2),
+                             AttributeQualifierPattern::CreateWildcard()}),
+      AttributePattern(
+          "e", {AttributeQualifierPattern::OfString("f"),
+                AttributeQualifierPattern(AttributeQualifier())}),
+  };
+  AttributePatternTrie trie(patterns);
+
+  std::vector<Attribute> attributes = {
+      Attribute("a"),
+      Attribute("a", {AttributeQualifier::OfString("b")}),
+      Attribute("a", {AttributeQualifier::OfString("b"),
+                      AttributeQualifier::OfInt(1)}),
+      Attribute("a", {AttributeQualifier::OfString("b"),
+                      AttributeQualifier::OfInt(1),
+                      AttributeQualifier::OfString("x")}),
+      Attribute("a", {AttributeQualifier::OfString("b"),
+                      AttributeQualifier::OfUint(1)}),
+      Attribute("a", {AttributeQualifier::OfInt(7),
+                      AttributeQualifier::OfBool(true)}),
+      Attribute("a", {AttributeQualifier::OfInt(7),
+                      AttributeQualifier::OfBool(false)}),
+      Attribute("a", {AttributeQualifier()}),
+      Attribute("b"),
+      Attribute("c"),
+      Attribute("c", {AttributeQualifier::OfString("x")}),
+      Attribute("d", {AttributeQualifier::OfUint(2)}),
+      Attribute("d", {AttributeQualifier::OfUint(2),
+                      AttributeQualifier::OfString("x")}),
+      Attribute("d", {AttributeQualifier::OfInt(2)}),
+      Attribute("e", {AttributeQualifier::OfString("f")}),
+      Attribute("e", {AttributeQualifier::OfString("f"),
+                      AttributeQualifier::OfString("g")}),
+  };
+  for (size_t i = 0; i < attributes.size(); ++i) {
+    EXPECT_EQ(trie.Match(attributes[i]), ScanPatterns(patterns, attributes[i]))
+        << "attribute " << i;
+  }
+}
+
+TEST(AttributePatternTrieTest, ManyPatterns) {
+  std::vector<AttributePattern> patterns;
+  for (int i = 0; i < 1000; ++i) {
+    patterns.push_back(AttributePattern(
+        "var", {AttributeQualifierPattern::OfInt(i),
+                AttributeQualifierPattern::OfString("field")}));
+  }
+  AttributePatternTrie trie(patterns);
+
+  Attribute attribute("var", {AttributeQualifier::OfInt(999),
+                              AttributeQualifier::OfString("field")});
+  EXPECT_EQ(trie.Match(attribute), MatchType::FULL);
+  EXPECT_EQ(trie.Match(Attribute("var", {AttributeQualifier::OfInt(500)})),
+            MatchType::PARTIAL);
+  EXPECT_EQ(trie.Match(Attribute("var", {AttributeQualifier::OfInt(1000)})),
+            MatchType::NONE);
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
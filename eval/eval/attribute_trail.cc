@@ -1,28 +1,85 @@
 #include "eval/eval/attribute_trail.h"
 
-#include <algorithm>
-#include <iterator>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/log/absl_check.h"
+#include "absl/types/optional.h"
 #include "base/attribute.h"
 
 namespace google::api::expr::runtime {
 
+// A trail is either a root, holding the variable name or a complete
+// attribute, or a qualifier added to its parent.
+class AttributeTrail::Node final {
+ public:
+  explicit Node(std::string variable_name)
+      : variable_name_(std::move(variable_name)) {}
+
+  explicit Node(cel::Attribute attribute) : attribute_(std::move(attribute)) {}
+
+  Node(std::shared_ptr<const Node> parent, cel::AttributeQualifier qualifier)
+      : parent_(std::move(parent)), qualifier_(std::move(qualifier)) {}
+
+  const cel::Attribute& attribute() const {
+    if (!attribute_.has_value()) {
+      Materialize();
+    }
+    return *attribute_;
+  }
+
+ private:
+  void Materialize() const {
+    if (parent_ == nullptr) {
+      attribute_.emplace(std::move(variable_name_));
+      return;
+    }
+    // Collect the qualifiers added since the closest materialized node.
+    std::vector<const Node*> steps;
+    const Node* base = this;
+    while (base->parent_ != nullptr && !base->attribute_.has_value()) {
+      steps.push_back(base);
+      base = base->parent_.get();
+    }
+    const cel::Attribute& base_attribute = base->attribute();
+    std::vector<cel::AttributeQualifier> qualifiers;
+    qualifiers.reserve(base_attribute.qualifier_path().size() + steps.size());
+    qualifiers.assign(base_attribute.qualifier_path().begin(),
+                      base_attribute.qualifier_path().end());
+    for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+      qualifiers.push_back(*(*it)->qualifier_);
+    }
+    attribute_.emplace(std::string(base_attribute.variable_name()),
+                       std::move(qualifiers));
+  }
+
+  const std::shared_ptr<const Node> parent_;
+  const absl::optional<cel::AttributeQualifier> qualifier_;
+  // Only used by roots, until the attribute is materialized.
+  mutable std::string variable_name_;
+  mutable absl::optional<cel::Attribute> attribute_;
+};
+
+AttributeTrail::AttributeTrail(std::string variable_name)
+    : node_(std::make_shared<const Node>(std::move(variable_name))) {}
+
+AttributeTrail::AttributeTrail(cel::Attribute attribute)
+    : node_(std::make_shared<const Node>(std::move(attribute))) {}
+
 // Creates AttributeTrail with attribute path incremented by "qualifier".
 AttributeTrail AttributeTrail::Step(cel::AttributeQualifier qualifier) const {
   // Cannot continue void trail
   if (empty()) return AttributeTrail();
 
-  std::vector<cel::AttributeQualifier> qualifiers;
-  qualifiers.reserve(attribute_->qualifier_path().size() + 1);
-  std::copy_n(attribute_->qualifier_path().begin(),
-              attribute_->qualifier_path().size(),
-              std::back_inserter(qualifiers));
-  qualifiers.push_back(std::move(qualifier));
-  return AttributeTrail(cel::Attribute(std::string(attribute_->variable_name()),
-                                       std::move(qualifiers)));
+  return AttributeTrail(
+      std::make_shared<const Node>(node_, std::move(qualifier)));
+}
+
+const cel::Attribute& AttributeTrail::attribute() const {
+  ABSL_DCHECK(!empty());
+  return node_->attribute();
 }
 
 }  // namespace google::api::expr::runtime
@@ -1,11 +1,10 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_ATTRIBUTE_TRAIL_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_ATTRIBUTE_TRAIL_H_
 
+#include <memory>
 #include <string>
 #include <utility>
 
-#include "absl/types/optional.h"
-#include "absl/utility/utility.h"
 #include "base/attribute.h"
 
 namespace google::api::expr::runtime {
@@ -13,21 +12,25 @@ namespace google::api::expr::runtime {
 // AttributeTrail reflects current attribute path.
 // It is functionally similar to cel::Attribute, yet intended to have better
 // complexity on attribute path increment operations.
-// TODO(issues/41) Current AttributeTrail implementation is equivalent to
-// cel::Attribute - improve it.
+//
+// The trail is a persistent list: stepping it allocates one node referring to
+// the parent trail instead of copying the path, so that tracking a select
+// chain is linear in its depth. The full cel::Attribute is only materialized
+// when requested, i.e. when the trail is matched against unknown or missing
+// attribute patterns, and is then kept by the node.
+//
 // Intended to be used in conjunction with cel::Value, describing the attribute
-// value originated from.
+// value originated from. Like the values of an evaluation, trails must not be
+// shared between threads.
 // Empty AttributeTrail denotes object with attribute path not defined
 // or supported.
 class AttributeTrail {
  public:
-  AttributeTrail() : attribute_(absl::nullopt) {}
+  AttributeTrail() = default;
 
-  explicit AttributeTrail(std::string variable_name)
-      : attribute_(absl::in_place, std::move(variable_name)) {}
+  explicit AttributeTrail(std::string variable_name);
 
-  explicit AttributeTrail(cel::Attribute attribute)
-      : attribute_(std::move(attribute)) {}
+  explicit AttributeTrail(cel::Attribute attribute);
 
   AttributeTrail(const AttributeTrail&) = default;
   AttributeTrail& operator=(const AttributeTrail&) = default;
@@ -43,12 +46,20 @@ class AttributeTrail {
   }
 
   // Returns CelAttribute that corresponds to content of AttributeTrail.
-  const cel::Attribute& attribute() const { return attribute_.value(); }
+  //
+  // Materialized on the first call for the trail, in time linear in the
+  // number of qualifiers added since the closest materialized parent.
+  const cel::Attribute& attribute() const;
 
-  bool empty() const { return !attribute_.has_value(); }
+  bool empty() const { return node_ == nullptr; }
 
  private:
-  absl::optional<cel::Attribute> attribute_;
+  class Node;
+
+  explicit AttributeTrail(std::shared_ptr<const Node> node)
+      : node_(std::move(node)) {}
+
+  std::shared_ptr<const Node> node_;
 };
 
 }  // namespace google::api::expr::runtime
@@ -28,4 +28,30 @@ TEST(AttributeTrailTest, AttributeTrailStep) {
             CelAttribute("ident", {CreateCelAttributeQualifier(step_value)}));
 }
 
+TEST(AttributeTrailTest, AttributeTrailSharesParent) {
+  std::string a = "a";
+  std::string b = "b";
+  std::string c = "c";
+  AttributeTrail root("ident");
+  AttributeTrail ab = root.Step(&a).Step(&b);
+  // Materialized before the trails stepped from it.
+  ASSERT_EQ(ab.attribute(),
+            CelAttribute("ident", {cel::AttributeQualifier::OfString("a"),
+                                   cel::AttributeQualifier::OfString("b")}));
+  AttributeTrail abc = ab.Step(&c);
+  AttributeTrail abd = ab.Step(cel::AttributeQualifier::OfInt(1));
+
+  EXPECT_EQ(abc.attribute(),
+            CelAttribute("ident", {cel::AttributeQualifier::OfString("a"),
+                                   cel::AttributeQualifier::OfString("b"),
+                                   cel::AttributeQualifier::OfString("c")}));
+  EXPECT_EQ(abd.attribute(),
+            CelAttribute("ident", {cel::AttributeQualifier::OfString("a"),
+                                   cel::AttributeQualifier::OfString("b"),
+                                   cel::AttributeQualifier::OfInt(1)}));
+  EXPECT_EQ(root.attribute(), CelAttribute("ident", {}));
+  EXPECT_EQ(AttributeTrail(CelAttribute("x", {})).Step(&a).attribute(),
+            CelAttribute("x", {cel::AttributeQualifier::OfString("a")}));
+}
+
 }  // namespace google::api::expr::runtime
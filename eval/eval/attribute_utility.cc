@@ -1,5 +1,6 @@
 #include "eval/eval/attribute_utility.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <utility>
@@ -14,6 +15,7 @@
 #include "base/function_result_set.h"
 #include "base/internal/unknown_set.h"
 #include "common/value.h"
+#include "eval/eval/attribute_pattern_trie.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/internal/errors.h"
 #include "internal/status_macros.h"
@@ -32,31 +34,30 @@ using ::cel::base_internal::UnknownSet;
 
 using Accumulator = AttributeUtility::Accumulator;
 
-bool AttributeUtility::CheckForMissingAttribute(
-    const AttributeTrail& trail) const {
-  if (trail.empty()) {
-    return false;
-  }
+namespace {
 
-  for (const auto& pattern : missing_attribute_patterns_) {
-    // (b/161297249) Preserving existing behavior for now, will add a streamz
-    // for partial match, follow up with tightening up which fields are exposed
-    // to the condition (w/ ajay and jim)
-    if (pattern.IsMatch(trail.attribute()) ==
-        cel::AttributePattern::MatchType::FULL) {
-      return true;
-    }
-  }
-  return false;
-}
+// Below this number of patterns, scanning them is cheaper than building the
+// trie.
+constexpr size_t kMinPatternsForTrie = 16;
 
-// Checks whether particular corresponds to any patterns that define unknowns.
-bool AttributeUtility::CheckForUnknown(const AttributeTrail& trail,
-                                       bool use_partial) const {
+}  // namespace
+
+bool AttributeUtility::MatchesAny(
+    absl::Span<const cel::AttributePattern> patterns,
+    absl::optional<AttributePatternTrie>& trie, const AttributeTrail& trail,
+    bool use_partial) {
   if (trail.empty()) {
     return false;
   }
-  for (const auto& pattern : unknown_patterns_) {
+  if (patterns.size() >= kMinPatternsForTrie) {
+    if (!trie.has_value()) {
+      trie.emplace(patterns);
+    }
+    auto match = trie->Match(trail.attribute());
+    return match == cel::AttributePattern::MatchType::FULL ||
+           (use_partial && match == cel::AttributePattern::MatchType::PARTIAL);
+  }
+  for (const auto& pattern : patterns) {
     auto current_match = pattern.IsMatch(trail.attribute());
     if (current_match == cel::AttributePattern::MatchType::FULL ||
         (use_partial &&
@@ -67,6 +68,23 @@ bool AttributeUtility::CheckForUnknown(const AttributeTrail& trail,
   return false;
 }
 
+bool AttributeUtility::CheckForMissingAttribute(
+    const AttributeTrail& trail) const {
+  // (b/161297249) Preserving existing behavior for now, will add a streamz
+  // for partial match, follow up with tightening up which fields are exposed
+  // to the condition (w/ ajay and jim)
+  return MatchesAny(missing_attribute_patterns_,
+                    missing_attribute_pattern_trie_, trail,
+                    /*use_partial=*/false);
+}
+
+// Checks whether particular corresponds to any patterns that define unknowns.
+bool AttributeUtility::CheckForUnknown(const AttributeTrail& trail,
+                                       bool use_partial) const {
+  return MatchesAny(unknown_patterns_, unknown_pattern_trie_, trail,
+                    use_partial);
+}
+
 // Creates merged UnknownAttributeSet.
 // Scans over the args collection, merges any UnknownSets found in
 // it together with initial_set (if initial_set is not null).
@@ -2,6 +2,7 @@
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_UNKNOWNS_UTILITY_H_
 
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/attribute.h"
 #include "base/attribute_set.h"
@@ -9,6 +10,7 @@
 #include "base/function_result_set.h"
 #include "common/value.h"
 #include "common/value_manager.h"
+#include "eval/eval/attribute_pattern_trie.h"
 #include "eval/eval/attribute_trail.h"
 
 namespace google::api::expr::runtime {
@@ -132,9 +134,18 @@ class AttributeUtility {
   void Add(Accumulator& a, const cel::UnknownValue& v) const;
   void Add(Accumulator& a, const AttributeTrail& attr) const;
 
+  // Returns whether any of `patterns` matches the attribute of `trail`, using
+  // `trie` for large sets of patterns.
+  static bool MatchesAny(absl::Span<const cel::AttributePattern> patterns,
+                         absl::optional<AttributePatternTrie>& trie,
+                         const AttributeTrail& trail, bool use_partial);
+
   absl::Span<const cel::AttributePattern> unknown_patterns_;
   absl::Span<const cel::AttributePattern> missing_attribute_patterns_;
   cel::ValueManager& value_factory_;
+  // Indexes of the patterns, built on first use.
+  mutable absl::optional<AttributePatternTrie> unknown_pattern_trie_;
+  mutable absl::optional<AttributePatternTrie> missing_attribute_pattern_trie_;
 };
 
 }  // namespace google::api::expr::runtime
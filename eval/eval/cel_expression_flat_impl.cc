@@ -29,6 +29,7 @@
 #include "eval/eval/comprehension_slots.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "eval/eval/evaluator_state_pool.h"
 #include "eval/internal/adapter_activation_impl.h"
 #include "eval/internal/interop.h"
 #include "eval/public/base_activation.h"
@@ -71,21 +72,46 @@ CelExpressionFlatEvaluationState::CelExpressionFlatEvaluationState(
     : arena_(arena),
       state_(expression.MakeEvaluatorState(ProtoMemoryManagerRef(arena_))) {}
 
+CelExpressionFlatImpl::CelExpressionFlatImpl(FlatExpression flat_expression)
+    : flat_expression_(std::move(flat_expression)) {
+  if (flat_expression_.options().evaluator_state_pool_size > 0) {
+    state_pool_ = std::make_unique<EvaluatorStatePool>(
+        flat_expression_, flat_expression_.options().evaluator_state_pool_size);
+  }
+}
+
+absl::StatusOr<CelValue> CelExpressionFlatImpl::TraceImpl(
+    const BaseActivation& activation, google::protobuf::Arena* arena,
+    FlatExpressionEvaluatorState& state, CelEvaluationListener callback) const {
+  state.Reset();
+  cel::interop_internal::AdapterActivationImpl modern_activation(activation);
+
+  CEL_ASSIGN_OR_RETURN(cel::Value value,
+                       flat_expression_.EvaluateWithCallback(
+                           modern_activation, AdaptListener(callback), state));
+
+  return cel::interop_internal::ModernValueToLegacyValueOrDie(arena, value);
+}
+
 absl::StatusOr<CelValue> CelExpressionFlatImpl::Trace(
     const BaseActivation& activation, CelEvaluationState* _state,
     CelEvaluationListener callback) const {
   auto state =
       ::cel::internal::down_cast<CelExpressionFlatEvaluationState*>(_state);
-  state->state().Reset();
-  cel::interop_internal::AdapterActivationImpl modern_activation(activation);
-
-  CEL_ASSIGN_OR_RETURN(
-      cel::Value value,
-      flat_expression_.EvaluateWithCallback(
-          modern_activation, AdaptListener(callback), state->state()));
+  return TraceImpl(activation, state->arena(), state->state(),
+                   std::move(callback));
+}
 
-  return cel::interop_internal::ModernValueToLegacyValueOrDie(state->arena(),
-                                                              value);
+absl::StatusOr<CelValue> CelExpressionFlatImpl::Trace(
+    const BaseActivation& activation, google::protobuf::Arena* arena,
+    CelEvaluationListener callback) const {
+  if (state_pool_ != nullptr) {
+    EvaluatorStatePool::Lease state =
+        state_pool_->Acquire(ProtoMemoryManagerRef(arena));
+    return TraceImpl(activation, arena, state.get(), std::move(callback));
+  }
+  CelExpressionFlatEvaluationState state(arena, flat_expression_);
+  return TraceImpl(activation, arena, state.state(), std::move(callback));
 }
 
 std::unique_ptr<CelEvaluationState> CelExpressionFlatImpl::InitializeState(
@@ -99,6 +125,22 @@ absl::StatusOr<CelValue> CelExpressionFlatImpl::Evaluate(
   return Trace(activation, state, CelEvaluationListener());
 }
 
+CelExpressionRecursiveImpl::CelExpressionRecursiveImpl(
+    FlatExpression flat_expression)
+    : flat_expression_(std::move(flat_expression)),
+      root_(cel::internal::down_cast<const WrappedDirectStep*>(
+                flat_expression_.path()[0].get())
+                ->wrapped()) {
+  const FlatExpression* traced = flat_expression_.traced_expression();
+  if (traced != nullptr && traced->path().size() == 1 &&
+      traced->path()[0]->GetNativeTypeId() ==
+          cel::NativeTypeId::For<WrappedDirectStep>()) {
+    traced_root_ = cel::internal::down_cast<const WrappedDirectStep*>(
+                       traced->path()[0].get())
+                       ->wrapped();
+  }
+}
+
 absl::StatusOr<std::unique_ptr<CelExpressionRecursiveImpl>>
 CelExpressionRecursiveImpl::Create(FlatExpression flat_expr) {
   if (flat_expr.path().empty() ||
@@ -125,9 +167,15 @@ absl::StatusOr<CelValue> CelExpressionRecursiveImpl::Trace(
                                      flat_expression_.options(), factory.get(),
                                      slots);
 
+  const DirectExpressionStep* root =
+      callback && traced_root_ != nullptr ? traced_root_ : root_;
   cel::Value result;
   AttributeTrail trail;
-  CEL_RETURN_IF_ERROR(root_->Evaluate(execution_frame, result, trail));
+  absl::Status status;
+  if (!root->EvaluateFast(execution_frame, result, trail, status)) {
+    return status;
+  }
+  CEL_RETURN_IF_ERROR(execution_frame.CheckMemoryBudget());
 
   return cel::interop_internal::ModernValueToLegacyValueOrDie(arena, result);
 }
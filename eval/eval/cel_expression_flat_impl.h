@@ -22,6 +22,7 @@
 #include "absl/status/statusor.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "eval/eval/evaluator_state_pool.h"
 #include "eval/public/cel_expression.h"
 #include "extensions/protobuf/memory_manager.h"
 #include "internal/casts.h"
@@ -49,8 +50,7 @@ class CelExpressionFlatEvaluationState : public CelEvaluationState {
 // This class adapts FlatExpression to implement the CelExpression interface.
 class CelExpressionFlatImpl : public CelExpression {
  public:
-  explicit CelExpressionFlatImpl(FlatExpression flat_expression)
-      : flat_expression_(std::move(flat_expression)) {}
+  explicit CelExpressionFlatImpl(FlatExpression flat_expression);
 
   // Move-only
   CelExpressionFlatImpl(const CelExpressionFlatImpl&) = delete;
@@ -64,16 +64,14 @@ class CelExpressionFlatImpl : public CelExpression {
 
   absl::StatusOr<CelValue> Evaluate(const BaseActivation& activation,
                                     google::protobuf::Arena* arena) const override {
-    return Evaluate(activation, InitializeState(arena).get());
+    return Trace(activation, arena, CelEvaluationListener());
   }
 
   absl::StatusOr<CelValue> Evaluate(const BaseActivation& activation,
                                     CelEvaluationState* state) const override;
   absl::StatusOr<CelValue> Trace(
       const BaseActivation& activation, google::protobuf::Arena* arena,
-      CelEvaluationListener callback) const override {
-    return Trace(activation, InitializeState(arena).get(), callback);
-  }
+      CelEvaluationListener callback) const override;
 
   absl::StatusOr<CelValue> Trace(const BaseActivation& activation,
                                  CelEvaluationState* state,
@@ -83,7 +81,15 @@ class CelExpressionFlatImpl : public CelExpression {
   const FlatExpression& flat_expression() const { return flat_expression_; }
 
  private:
+  absl::StatusOr<CelValue> TraceImpl(const BaseActivation& activation,
+                                     google::protobuf::Arena* arena,
+                                     FlatExpressionEvaluatorState& state,
+                                     CelEvaluationListener callback) const;
+
   FlatExpression flat_expression_;
+  // Optional cache of evaluator states used when the caller does not provide
+  // one. Null if pooling is disabled.
+  std::unique_ptr<EvaluatorStatePool> state_pool_;
 };
 
 // Implementation of the CelExpression that evaluates a recursive representation
@@ -146,14 +152,13 @@ class CelExpressionRecursiveImpl : public CelExpression {
   const DirectExpressionStep* root() const { return root_; }
 
  private:
-  explicit CelExpressionRecursiveImpl(FlatExpression flat_expression)
-      : flat_expression_(std::move(flat_expression)),
-        root_(cel::internal::down_cast<const WrappedDirectStep*>(
-                  flat_expression_.path()[0].get())
-                  ->wrapped()) {}
+  explicit CelExpressionRecursiveImpl(FlatExpression flat_expression);
 
   FlatExpression flat_expression_;
   const DirectExpressionStep* root_;
+  // Root of the traced copy of the expression, used by evaluations with a
+  // listener. Null if the expression wasn't planned with tracing.
+  const DirectExpressionStep* traced_root_ = nullptr;
 };
 
 }  // namespace google::api::expr::runtime
@@ -0,0 +1,260 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/comparison_jump_step.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/kind.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/expression_step_base.h"
+#include "internal/status_macros.h"
+#include "runtime/internal/errors.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::ErrorValue;
+using ::cel::IntValue;
+using ::cel::StringValue;
+using ::cel::UintValue;
+using ::cel::UnknownValue;
+using ::cel::Value;
+using ::cel::ValueKind;
+using ::cel::ValueKindToKind;
+
+template <typename T>
+bool Compare(ComparisonOp op, const T& lhs, const T& rhs) {
+  switch (op) {
+    case ComparisonOp::kEqual:
+      return lhs == rhs;
+    case ComparisonOp::kNotEqual:
+      return lhs != rhs;
+    case ComparisonOp::kLess:
+      return lhs < rhs;
+    case ComparisonOp::kLessOrEqual:
+      return lhs <= rhs;
+    case ComparisonOp::kGreater:
+      return rhs < lhs;
+    case ComparisonOp::kGreaterOrEqual:
+      return rhs <= lhs;
+  }
+  return false;
+}
+
+// Returns the result of the comparison if it can be done inline.
+absl::optional<bool> CompareInline(ComparisonOp op, ComparisonKinds kinds,
+                                   const Value& lhs, const Value& rhs) {
+  ValueKind kind = lhs->kind();
+  if (kind != rhs->kind() || !kinds.Contains(ValueKindToKind(kind))) {
+    return absl::nullopt;
+  }
+  switch (kind) {
+    case ValueKind::kBool:
+      return Compare(op, lhs.As<BoolValue>().NativeValue(),
+                     rhs.As<BoolValue>().NativeValue());
+    case ValueKind::kInt:
+      return Compare(op, lhs.As<IntValue>().NativeValue(),
+                     rhs.As<IntValue>().NativeValue());
+    case ValueKind::kUint:
+      return Compare(op, lhs.As<UintValue>().NativeValue(),
+                     rhs.As<UintValue>().NativeValue());
+    case ValueKind::kDouble:
+      return Compare(op, lhs.As<DoubleValue>().NativeValue(),
+                     rhs.As<DoubleValue>().NativeValue());
+    case ValueKind::kString:
+      return Compare(op, lhs.As<StringValue>().Compare(rhs.As<StringValue>()),
+                     0);
+    default:
+      return absl::nullopt;
+  }
+}
+
+class ComparisonJumpStepBase : public ExpressionStepBase {
+ public:
+  ComparisonJumpStepBase(ComparisonOp op, ComparisonKinds kinds,
+                         std::unique_ptr<const ExpressionStep> comparison,
+                         int64_t expr_id)
+      // The comparison result is reported to listeners by
+      // `EvaluateComparison`, not the evaluator.
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/false),
+        op_(op),
+        kinds_(kinds),
+        comparison_(std::move(comparison)) {}
+
+ protected:
+  // Returns the comparison result if it was computed inline, with the operands
+  // still on the stack. Otherwise the comparison step is evaluated and its
+  // result is left on the stack in place of the operands.
+  absl::StatusOr<absl::optional<bool>> EvaluateComparison(
+      ExecutionFrame* frame) const {
+    if (!frame->value_stack().HasEnough(2)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Value stack underflow");
+    }
+    if (!frame->enable_unknowns() && !frame->callback()) {
+      absl::Span<const Value> args = frame->value_stack().GetSpan(2);
+      absl::optional<bool> result =
+          CompareInline(op_, kinds_, args[0], args[1]);
+      if (result.has_value()) {
+        return result;
+      }
+    }
+    CEL_RETURN_IF_ERROR(comparison_->Evaluate(frame));
+    if (frame->callback() && comparison_->comes_from_ast()) {
+      CEL_RETURN_IF_ERROR(frame->callback()(comparison_->id(),
+                                            frame->value_stack().Peek(),
+                                            frame->value_factory()));
+    }
+    return absl::nullopt;
+  }
+
+ private:
+  const ComparisonOp op_;
+  const ComparisonKinds kinds_;
+  const std::unique_ptr<const ExpressionStep> comparison_;
+};
+
+class TernaryComparisonJumpStep final : public ComparisonJumpStepBase {
+ public:
+  TernaryComparisonJumpStep(ComparisonOp op, ComparisonKinds kinds,
+                            std::unique_ptr<const ExpressionStep> comparison,
+                            int error_jump_offset, int false_jump_offset,
+                            int64_t expr_id)
+      : ComparisonJumpStepBase(op, kinds, std::move(comparison), expr_id),
+        error_jump_offset_(error_jump_offset),
+        false_jump_offset_(false_jump_offset) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    CEL_ASSIGN_OR_RETURN(absl::optional<bool> condition,
+                         EvaluateComparison(frame));
+    if (condition.has_value()) {
+      frame->value_stack().Pop(2);
+      return *condition ? absl::OkStatus() : frame->JumpTo(false_jump_offset_);
+    }
+
+    // Same as BoolCheckJump followed by CondJump(false).
+    const Value& value = frame->value_stack().Peek();
+    if (value->Is<BoolValue>()) {
+      bool result = value.As<BoolValue>().NativeValue();
+      frame->value_stack().Pop(1);
+      return result ? absl::OkStatus() : frame->JumpTo(false_jump_offset_);
+    }
+    if (!value->Is<ErrorValue>() && !value->Is<UnknownValue>()) {
+      frame->value_stack().PopAndPush(frame->value_factory().CreateErrorValue(
+          cel::runtime_internal::CreateNoMatchingOverloadError(
+              "<jump_condition>")));
+    }
+    return frame->JumpTo(error_jump_offset_);
+  }
+
+  std::vector<int> GetJumpOffsets() const override {
+    return {error_jump_offset_, false_jump_offset_};
+  }
+
+  void SetJumpOffsets(absl::Span<const int> offsets) override {
+    error_jump_offset_ = offsets[0];
+    false_jump_offset_ = offsets[1];
+  }
+
+ private:
+  int error_jump_offset_;
+  int false_jump_offset_;
+};
+
+class ShortCircuitComparisonJumpStep final : public ComparisonJumpStepBase {
+ public:
+  ShortCircuitComparisonJumpStep(
+      ComparisonOp op, ComparisonKinds kinds,
+      std::unique_ptr<const ExpressionStep> comparison, bool jump_condition,
+      int jump_offset, int64_t expr_id)
+      : ComparisonJumpStepBase(op, kinds, std::move(comparison), expr_id),
+        jump_condition_(jump_condition),
+        jump_offset_(jump_offset) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    CEL_ASSIGN_OR_RETURN(absl::optional<bool> condition,
+                         EvaluateComparison(frame));
+    if (condition.has_value()) {
+      frame->value_stack().PopAndPush(2, BoolValue(*condition));
+    } else {
+      const Value& value = frame->value_stack().Peek();
+      if (!value->Is<BoolValue>()) {
+        return absl::OkStatus();
+      }
+      condition = value.As<BoolValue>().NativeValue();
+    }
+    if (*condition == jump_condition_) {
+      return frame->JumpTo(jump_offset_);
+    }
+    return absl::OkStatus();
+  }
+
+  std::vector<int> GetJumpOffsets() const override { return {jump_offset_}; }
+
+  void SetJumpOffsets(absl::Span<const int> offsets) override {
+    jump_offset_ = offsets[0];
+  }
+
+ private:
+  const bool jump_condition_;
+  int jump_offset_;
+};
+
+}  // namespace
+
+void ComparisonKinds::Add(cel::Kind kind) {
+  switch (kind) {
+    case cel::Kind::kBool:
+    case cel::Kind::kInt:
+    case cel::Kind::kUint:
+    case cel::Kind::kDouble:
+    case cel::Kind::kString:
+      mask_ |= Bit(kind);
+      break;
+    default:
+      break;
+  }
+}
+
+std::unique_ptr<ExpressionStep> CreateTernaryComparisonJumpStep(
+    ComparisonOp op, ComparisonKinds kinds,
+    std::unique_ptr<const ExpressionStep> comparison, int error_jump_offset,
+    int false_jump_offset, int64_t expr_id) {
+  return std::make_unique<TernaryComparisonJumpStep>(
+      op, kinds, std::move(comparison), error_jump_offset, false_jump_offset,
+      expr_id);
+}
+
+std::unique_ptr<ExpressionStep> CreateShortCircuitComparisonJumpStep(
+    ComparisonOp op, ComparisonKinds kinds,
+    std::unique_ptr<const ExpressionStep> comparison, bool jump_condition,
+    int jump_offset, int64_t expr_id) {
+  return std::make_unique<ShortCircuitComparisonJumpStep>(
+      op, kinds, std::move(comparison), jump_condition, jump_offset, expr_id);
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,93 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Stack machine steps fusing a comparison with the conditional jump that
+// consumes its result.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPARISON_JUMP_STEP_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPARISON_JUMP_STEP_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "base/kind.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+enum class ComparisonOp {
+  kEqual,
+  kNotEqual,
+  kLess,
+  kLessOrEqual,
+  kGreater,
+  kGreaterOrEqual,
+};
+
+// Set of operand kinds for which a comparison may be evaluated inline.
+class ComparisonKinds {
+ public:
+  ComparisonKinds() = default;
+
+  // Only bool (equality only), int, uint, double and string are supported,
+  // other kinds are ignored.
+  void Add(cel::Kind kind);
+
+  bool Contains(cel::Kind kind) const {
+    return (mask_ & Bit(kind)) != 0;
+  }
+
+  bool empty() const { return mask_ == 0; }
+
+ private:
+  static constexpr uint64_t Bit(cel::Kind kind) {
+    return uint64_t{1} << static_cast<int>(kind);
+  }
+
+  uint64_t mask_ = 0;
+};
+
+// Create a step replacing the condition of a ternary, i.e. the sequence
+//
+//   <comparison>, BoolCheckJump, CondJump(false, /*leave_on_stack=*/false)
+//
+// When both operands on top of the stack are of the same kind in `kinds`, the
+// comparison is done inline and no value is pushed. Otherwise `comparison`,
+// which must replace the top two values with the comparison result, is
+// evaluated and the jumps are applied to its result. The fallback is also
+// used when unknowns are enabled or an evaluation listener is set, so traces
+// are unchanged.
+//
+// Offsets are relative to the fused step, as for the jump steps.
+std::unique_ptr<ExpressionStep> CreateTernaryComparisonJumpStep(
+    ComparisonOp op, ComparisonKinds kinds,
+    std::unique_ptr<const ExpressionStep> comparison, int error_jump_offset,
+    int false_jump_offset, int64_t expr_id);
+
+// Create a step replacing the first operand of a short-circuiting logical
+// operator, i.e. the sequence
+//
+//   <comparison>, CondJump(jump_condition, /*leave_on_stack=*/true,
+//                          jump_offset)
+//
+// The comparison result is always left on the stack for the logical operator
+// step. As above, `comparison` is the fallback for other operand kinds.
+std::unique_ptr<ExpressionStep> CreateShortCircuitComparisonJumpStep(
+    ComparisonOp op, ComparisonKinds kinds,
+    std::unique_ptr<const ExpressionStep> comparison, bool jump_condition,
+    int jump_offset, int64_t expr_id);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPARISON_JUMP_STEP_H_
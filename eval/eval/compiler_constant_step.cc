@@ -22,10 +22,12 @@ namespace google::api::expr::runtime {
 
 using ::cel::Value;
 
-absl::Status DirectCompilerConstantStep::Evaluate(
-    ExecutionFrameBase& frame, Value& result, AttributeTrail& attribute) const {
+bool DirectCompilerConstantStep::EvaluateFast(ExecutionFrameBase& frame,
+                                              Value& result,
+                                              AttributeTrail& attribute,
+                                              absl::Status& status) const {
   result = value_;
-  return absl::OkStatus();
+  return true;
 }
 
 absl::Status CompilerConstantStep::Evaluate(ExecutionFrame* frame) const {
@@ -31,13 +31,14 @@ namespace google::api::expr::runtime {
 //
 // Overrides NativeTypeId() allow the FlatExprBuilder and extensions to
 // inspect the underlying value.
-class DirectCompilerConstantStep : public DirectExpressionStep {
+class DirectCompilerConstantStep : public FastDirectExpressionStep {
  public:
   DirectCompilerConstantStep(cel::Value value, int64_t expr_id)
-      : DirectExpressionStep(expr_id), value_(std::move(value)) {}
+      : FastDirectExpressionStep(expr_id), value_(std::move(value)) {}
 
-  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
-                        AttributeTrail& attribute) const override;
+  bool EvaluateFast(ExecutionFrameBase& frame, cel::Value& result,
+                    AttributeTrail& attribute,
+                    absl::Status& status) const override;
 
   cel::NativeTypeId GetNativeTypeId() const override {
     return cel::NativeTypeId::For<DirectCompilerConstantStep>();
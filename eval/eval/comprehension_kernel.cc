@@ -0,0 +1,450 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/comprehension_kernel.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "common/casting.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "common/values/contiguous_list_value.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/overflow.h"
+#include "internal/status_macros.h"
+#include "runtime/runtime_options.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::BoolValueView;
+using ::cel::Cast;
+using ::cel::DoubleValue;
+using ::cel::DoubleValueView;
+using ::cel::IntValue;
+using ::cel::IntValueView;
+using ::cel::StringValue;
+using ::cel::StringValueView;
+using ::cel::UintValue;
+using ::cel::UintValueView;
+using ::cel::Value;
+using ::cel::ValueKind;
+using ::cel::ValueView;
+
+using Kind = ComprehensionKernel::Kind;
+using Op = ComprehensionKernel::Op;
+
+bool IsComparison(Op op) {
+  switch (op) {
+    case Op::kEqual:
+    case Op::kNotEqual:
+    case Op::kLess:
+    case Op::kLessOrEqual:
+    case Op::kGreater:
+    case Op::kGreaterOrEqual:
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+bool ApplyComparison(Op op, const T& lhs, const T& rhs) {
+  switch (op) {
+    case Op::kEqual:
+      return lhs == rhs;
+    case Op::kNotEqual:
+      return lhs != rhs;
+    case Op::kLess:
+      return lhs < rhs;
+    case Op::kLessOrEqual:
+      return lhs <= rhs;
+    case Op::kGreater:
+      return rhs < lhs;
+    case Op::kGreaterOrEqual:
+      return rhs <= lhs;
+    default:
+      return false;
+  }
+}
+
+// Returns nullopt if `element` is not of the kind of `constant`.
+absl::optional<bool> Compare(Op op, ValueView element, const Value& constant) {
+  if (element.kind() != constant.kind()) {
+    return absl::nullopt;
+  }
+  switch (constant.kind()) {
+    case ValueKind::kBool:
+      return ApplyComparison(op, Cast<BoolValueView>(element).NativeValue(),
+                             Cast<BoolValue>(constant).NativeValue());
+    case ValueKind::kInt:
+      return ApplyComparison(op, Cast<IntValueView>(element).NativeValue(),
+                             Cast<IntValue>(constant).NativeValue());
+    case ValueKind::kUint:
+      return ApplyComparison(op, Cast<UintValueView>(element).NativeValue(),
+                             Cast<UintValue>(constant).NativeValue());
+    case ValueKind::kDouble:
+      return ApplyComparison(op, Cast<DoubleValueView>(element).NativeValue(),
+                             Cast<DoubleValue>(constant).NativeValue());
+    case ValueKind::kString:
+      return ApplyComparison(op,
+                             Cast<StringValueView>(element).Compare(
+                                 Cast<StringValue>(constant)),
+                             0);
+    default:
+      return absl::nullopt;
+  }
+}
+
+template <typename T>
+absl::StatusOr<T> ApplyArithmetic(Op op, T lhs, T rhs) {
+  switch (op) {
+    case Op::kAdd:
+      return cel::internal::CheckedAdd(lhs, rhs);
+    case Op::kSubtract:
+      return cel::internal::CheckedSub(lhs, rhs);
+    case Op::kMultiply:
+      return cel::internal::CheckedMul(lhs, rhs);
+    default:
+      return absl::InvalidArgumentError("not an arithmetic operator");
+  }
+}
+
+absl::StatusOr<double> ApplyArithmetic(Op op, double lhs, double rhs) {
+  switch (op) {
+    case Op::kAdd:
+      return lhs + rhs;
+    case Op::kSubtract:
+      return lhs - rhs;
+    case Op::kMultiply:
+      return lhs * rhs;
+    default:
+      return absl::InvalidArgumentError("not an arithmetic operator");
+  }
+}
+
+// Returns nullopt if `element` is not of the kind of `constant`, or the
+// operation results in an error (integer overflow).
+absl::optional<Value> Combine(Op op, ValueView element,
+                              const Value& constant) {
+  if (element.kind() != constant.kind()) {
+    return absl::nullopt;
+  }
+  switch (constant.kind()) {
+    case ValueKind::kInt: {
+      absl::StatusOr<int64_t> result =
+          ApplyArithmetic(op, Cast<IntValueView>(element).NativeValue(),
+                          Cast<IntValue>(constant).NativeValue());
+      if (!result.ok()) {
+        return absl::nullopt;
+      }
+      return IntValue(*result);
+    }
+    case ValueKind::kUint: {
+      absl::StatusOr<uint64_t> result =
+          ApplyArithmetic(op, Cast<UintValueView>(element).NativeValue(),
+                          Cast<UintValue>(constant).NativeValue());
+      if (!result.ok()) {
+        return absl::nullopt;
+      }
+      return UintValue(*result);
+    }
+    case ValueKind::kDouble: {
+      absl::StatusOr<double> result =
+          ApplyArithmetic(op, Cast<DoubleValueView>(element).NativeValue(),
+                          Cast<DoubleValue>(constant).NativeValue());
+      if (!result.ok()) {
+        return absl::nullopt;
+      }
+      return DoubleValue(*result);
+    }
+    default:
+      return absl::nullopt;
+  }
+}
+
+enum class ElementResult {
+  // The element is not of the kind of the constant, or the operation results
+  // in an error.
+  kUnsupported,
+  kSkip,
+  // Add the element, or the result of map(), to the result list.
+  kAppend,
+  // The element decides the result of exists() or all().
+  kDecided,
+};
+
+ElementResult ApplyKernel(const ComprehensionKernel& kernel,
+                          ValueView element, absl::optional<Value>& mapped) {
+  if (kernel.kind == Kind::kMap) {
+    mapped = Combine(kernel.op, element, kernel.constant);
+    return mapped.has_value() ? ElementResult::kAppend
+                              : ElementResult::kUnsupported;
+  }
+  absl::optional<bool> matches = Compare(kernel.op, element, kernel.constant);
+  if (!matches.has_value()) {
+    return ElementResult::kUnsupported;
+  }
+  switch (kernel.kind) {
+    case Kind::kExists:
+    case Kind::kAll:
+      // Once decided the accumulator no longer changes: if the loop
+      // condition is not short-circuiting, later elements may not even have
+      // a matching overload without affecting the result.
+      return *matches == (kernel.kind == Kind::kExists)
+                 ? ElementResult::kDecided
+                 : ElementResult::kSkip;
+    default:
+      return *matches ? ElementResult::kAppend : ElementResult::kSkip;
+  }
+}
+
+// Visits the elements of a list, or the keys of a map, with their position.
+absl::Status ForEachElement(
+    const cel::ListValue& range, cel::ValueManager& value_manager,
+    absl::FunctionRef<absl::StatusOr<bool>(size_t, ValueView)> callback) {
+  return range.ForEach(value_manager, callback);
+}
+
+absl::Status ForEachElement(
+    const cel::MapValue& range, cel::ValueManager& value_manager,
+    absl::FunctionRef<absl::StatusOr<bool>(size_t, ValueView)> callback) {
+  size_t index = 0;
+  return range.ForEach(
+      value_manager, [&](ValueView key, ValueView) -> absl::StatusOr<bool> {
+        return callback(index++, key);
+      });
+}
+
+struct KernelState {
+  bool supported = true;
+  // Index of the element deciding the result of exists() or all().
+  absl::optional<size_t> decided_at;
+  // The result of filter() or map().
+  cel::Unique<cel::ListValueBuilder> builder;
+};
+
+template <typename Range>
+absl::Status EvaluateSequentially(const ComprehensionKernel& kernel,
+                                  const Range& range,
+                                  cel::ValueManager& value_manager,
+                                  KernelState& state) {
+  absl::optional<Value> mapped;
+  return ForEachElement(
+      range, value_manager,
+      [&](size_t index, ValueView element) -> absl::StatusOr<bool> {
+        switch (ApplyKernel(kernel, element, mapped)) {
+          case ElementResult::kUnsupported:
+            state.supported = false;
+            return false;
+          case ElementResult::kSkip:
+            return true;
+          case ElementResult::kAppend:
+            if (mapped.has_value()) {
+              CEL_RETURN_IF_ERROR(state.builder->Add(*std::move(mapped)));
+              mapped.reset();
+            } else {
+              CEL_RETURN_IF_ERROR(state.builder->Add(Value(element)));
+            }
+            return true;
+          case ElementResult::kDecided:
+            state.decided_at = index;
+            return false;
+        }
+        return true;
+      });
+}
+
+// A range of elements evaluated by a single task.
+struct Chunk {
+  size_t begin;
+  size_t end;
+  bool supported = true;
+  absl::optional<size_t> decided_at;
+  // Indices of the elements kept by filter().
+  std::vector<size_t> kept;
+  // Results of map().
+  std::vector<Value> mapped;
+};
+
+// Only reads the elements and the kernel, so that chunks may be evaluated
+// concurrently: neither the value manager nor the frame are used.
+void EvaluateChunk(const ComprehensionKernel& kernel,
+                   const std::vector<Value>& elements, Chunk& chunk) {
+  absl::optional<Value> mapped;
+  for (size_t i = chunk.begin; i < chunk.end; ++i) {
+    switch (ApplyKernel(kernel, elements[i], mapped)) {
+      case ElementResult::kUnsupported:
+        chunk.supported = false;
+        return;
+      case ElementResult::kSkip:
+        break;
+      case ElementResult::kAppend:
+        if (mapped.has_value()) {
+          chunk.mapped.push_back(*std::move(mapped));
+          mapped.reset();
+        } else {
+          chunk.kept.push_back(i);
+        }
+        break;
+      case ElementResult::kDecided:
+        chunk.decided_at = i;
+        return;
+    }
+  }
+}
+
+// Splits the range into chunks evaluated by `runner`, then merges the chunk
+// results in order. The outcome is the same as evaluating sequentially.
+template <typename Range>
+absl::Status EvaluateInParallel(const ComprehensionKernel& kernel,
+                                const Range& range, size_t size,
+                                size_t chunk_size,
+                                const cel::ParallelTaskRunner& runner,
+                                cel::ValueManager& value_manager,
+                                KernelState& state) {
+  // The list implementation may depend on the value manager to access its
+  // elements, so they are copied out on the calling thread.
+  std::vector<Value> elements;
+  elements.reserve(size);
+  CEL_RETURN_IF_ERROR(ForEachElement(
+      range, value_manager,
+      [&](size_t, ValueView element) -> absl::StatusOr<bool> {
+        elements.push_back(Value(element));
+        return true;
+      }));
+
+  std::vector<Chunk> chunks((elements.size() + chunk_size - 1) / chunk_size);
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve(chunks.size());
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    Chunk& chunk = chunks[i];
+    chunk.begin = i * chunk_size;
+    chunk.end = std::min(elements.size(), chunk.begin + chunk_size);
+    tasks.push_back([&kernel, &elements, &chunk]() {
+      EvaluateChunk(kernel, elements, chunk);
+    });
+  }
+  runner(absl::MakeConstSpan(tasks));
+
+  for (Chunk& chunk : chunks) {
+    if (!chunk.supported) {
+      state.supported = false;
+      return absl::OkStatus();
+    }
+    for (size_t index : chunk.kept) {
+      CEL_RETURN_IF_ERROR(state.builder->Add(elements[index]));
+    }
+    for (Value& value : chunk.mapped) {
+      CEL_RETURN_IF_ERROR(state.builder->Add(std::move(value)));
+    }
+    if (chunk.decided_at.has_value()) {
+      state.decided_at = chunk.decided_at;
+      break;
+    }
+  }
+  return absl::OkStatus();
+}
+
+template <typename Range>
+absl::StatusOr<bool> EvaluateKernel(const ComprehensionKernel& kernel,
+                                    const Range& range, bool shortcircuiting,
+                                    ExecutionFrameBase& frame,
+                                    cel::Value& result) {
+  if (IsComparison(kernel.op) == (kernel.kind == Kind::kMap)) {
+    return false;
+  }
+  cel::ValueManager& value_manager = frame.value_manager();
+  CEL_ASSIGN_OR_RETURN(size_t size, range.Size());
+
+  // The elements are all visited before counting any iteration, so nothing is
+  // observable if the generic loop has to be used after all.
+  KernelState state;
+  if (kernel.kind == Kind::kFilter || kernel.kind == Kind::kMap) {
+    CEL_ASSIGN_OR_RETURN(state.builder,
+                         cel::NewContiguousListValueBuilder(value_manager));
+    // A map produces exactly one element per iteration; a filter at most one.
+    if (kernel.kind == Kind::kMap) {
+      state.builder->Reserve(size);
+    }
+  }
+  const cel::RuntimeOptions& options = frame.options();
+  const size_t chunk_size = static_cast<size_t>(
+      std::max(options.parallel_comprehension_chunk_size, 1));
+  if (options.comprehension_task_runner && size > chunk_size) {
+    CEL_RETURN_IF_ERROR(EvaluateInParallel(kernel, range, size, chunk_size,
+                                           options.comprehension_task_runner,
+                                           value_manager, state));
+  } else {
+    CEL_RETURN_IF_ERROR(
+        EvaluateSequentially(kernel, range, value_manager, state));
+  }
+  if (!state.supported) {
+    return false;
+  }
+
+  // The generic loop stops on the iteration after the one deciding the
+  // result, when the loop condition is evaluated.
+  size_t iterations = size;
+  if (state.decided_at.has_value() && shortcircuiting) {
+    iterations = std::min(size, *state.decided_at + 2);
+  }
+  if (iterations > frame.RemainingIterations()) {
+    return frame.RemainingIterationsExceededError();
+  }
+  frame.CountIterations(iterations);
+
+  switch (kernel.kind) {
+    case Kind::kExists:
+      result = BoolValue(state.decided_at.has_value());
+      break;
+    case Kind::kAll:
+      result = BoolValue(!state.decided_at.has_value());
+      break;
+    default:
+      result = std::move(*state.builder).Build();
+      break;
+  }
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> EvaluateComprehensionKernel(
+    const ComprehensionKernel& kernel, const cel::ListValue& range,
+    bool shortcircuiting, ExecutionFrameBase& frame, cel::Value& result) {
+  return EvaluateKernel(kernel, range, shortcircuiting, frame, result);
+}
+
+absl::StatusOr<bool> EvaluateComprehensionKernel(
+    const ComprehensionKernel& kernel, const cel::MapValue& range,
+    bool shortcircuiting, ExecutionFrameBase& frame, cel::Value& result) {
+  return EvaluateKernel(kernel, range, shortcircuiting, frame, result);
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,71 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPREHENSION_KERNEL_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPREHENSION_KERNEL_H_
+
+#include "absl/status/statusor.h"
+#include "common/value.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+// A comprehension over a list whose loop step only compares or combines each
+// element with a constant, e.g. `list.exists(x, x == 1)` or
+// `list.map(x, x * 2)`.
+//
+// These are evaluated as a loop over the elements, instead of binding the
+// iteration variable and evaluating the loop step for each of them.
+struct ComprehensionKernel {
+  enum class Kind { kExists, kAll, kFilter, kMap };
+
+  // Applied as `element op constant`.
+  enum class Op {
+    kEqual,
+    kNotEqual,
+    kLess,
+    kLessOrEqual,
+    kGreater,
+    kGreaterOrEqual,
+    kAdd,
+    kSubtract,
+    kMultiply,
+  };
+
+  Kind kind;
+  Op op;
+  // A bool, int, uint, double or string.
+  cel::Value constant;
+};
+
+// Evaluates `kernel` over the elements of `range`.
+//
+// Returns false, leaving `result` unchanged, unless every element has the
+// kind of the constant and none of them results in an error. The caller must
+// evaluate the comprehension as usual in that case.
+//
+// Iterations are counted as for the generic loop, the loop condition being
+// short-circuiting or not as given.
+absl::StatusOr<bool> EvaluateComprehensionKernel(
+    const ComprehensionKernel& kernel, const cel::ListValue& range,
+    bool shortcircuiting, ExecutionFrameBase& frame, cel::Value& result);
+
+// As above, over the keys of `range` in iteration order.
+absl::StatusOr<bool> EvaluateComprehensionKernel(
+    const ComprehensionKernel& kernel, const cel::MapValue& range,
+    bool shortcircuiting, ExecutionFrameBase& frame, cel::Value& result);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPREHENSION_KERNEL_H_
@@ -16,12 +16,12 @@
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_COMPREHENSION_SLOTS_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/base/no_destructor.h"
-#include "absl/types/optional.h"
 #include "common/value.h"
 #include "eval/eval/attribute_trail.h"
 
@@ -34,6 +34,13 @@ namespace google::api::expr::runtime {
 // runtime stack.
 //
 // Callers must handle range checking.
+//
+// Each slot records the generation it was set in, and only the slots of the
+// current generation are set. Clearing a slot releases its value and
+// attribute trail. Resetting the slots starts a new generation, releasing the
+// slots still set first, so no value outlives the evaluation (and its memory
+// manager) that set it. Comprehensions clear their slots when they finish, so
+// after a successful evaluation the reset is constant time.
 class ComprehensionSlots {
  public:
   struct Slot {
@@ -48,7 +55,7 @@ class ComprehensionSlots {
     return *instance;
   }
 
-  explicit ComprehensionSlots(size_t size) : size_(size), slots_(size) {}
+  explicit ComprehensionSlots(size_t size) : slots_(size) {}
 
   // Move only
   ComprehensionSlots(const ComprehensionSlots&) = delete;
@@ -60,24 +67,36 @@ class ComprehensionSlots {
   // If not set, returns nullptr.
   Slot* Get(size_t index) {
     ABSL_ASSERT(index >= 0 && index < slots_.size());
-    auto& slot = slots_[index];
-    if (!slot.has_value()) return nullptr;
-    return &slot.value();
+    auto& entry = slots_[index];
+    if (entry.generation != generation_) return nullptr;
+    return &entry.slot;
   }
 
+  // Unsets every slot.
   void Reset() {
-    slots_.clear();
-    slots_.resize(size_);
+    if (set_count_ != 0) {
+      for (auto& entry : slots_) {
+        if (entry.generation == generation_) {
+          Release(entry);
+        }
+      }
+      set_count_ = 0;
+    }
+    ++generation_;
   }
 
   void ClearSlot(size_t index) {
     ABSL_ASSERT(index >= 0 && index < slots_.size());
-    slots_[index] = absl::nullopt;
+    auto& entry = slots_[index];
+    if (entry.generation == generation_) {
+      Release(entry);
+      --set_count_;
+    }
   }
 
   void Set(size_t index) {
     ABSL_ASSERT(index >= 0 && index < slots_.size());
-    slots_[index].emplace();
+    Set(index, cel::Value(), AttributeTrail());
   }
 
   void Set(size_t index, cel::Value value) {
@@ -86,14 +105,36 @@ class ComprehensionSlots {
 
   void Set(size_t index, cel::Value value, AttributeTrail attribute) {
     ABSL_ASSERT(index >= 0 && index < slots_.size());
-    slots_[index] = Slot{std::move(value), std::move(attribute)};
+    auto& entry = slots_[index];
+    entry.slot.value = std::move(value);
+    entry.slot.attribute = std::move(attribute);
+    if (entry.generation != generation_) {
+      entry.generation = generation_;
+      ++set_count_;
+    }
   }
 
   size_t size() const { return slots_.size(); }
 
  private:
-  size_t size_;
-  std::vector<absl::optional<Slot>> slots_;
+  // Generation of the slots which are not set, never current.
+  static constexpr uint64_t kUnset = 0;
+
+  struct Entry {
+    Slot slot;
+    uint64_t generation = kUnset;
+  };
+
+  static void Release(Entry& entry) {
+    entry.slot.value = cel::Value();
+    entry.slot.attribute = AttributeTrail();
+    entry.generation = kUnset;
+  }
+
+  std::vector<Entry> slots_;
+  uint64_t generation_ = kUnset + 1;
+  // Number of slots set in the current generation.
+  size_t set_count_ = 0;
 };
 
 }  // namespace google::api::expr::runtime
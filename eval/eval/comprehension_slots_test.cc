@@ -14,6 +14,9 @@
 
 #include "eval/eval/comprehension_slots.h"
 
+#include <string>
+
+#include "absl/strings/cord.h"
 #include "base/attribute.h"
 #include "base/type_provider.h"
 #include "common/memory.h"
@@ -40,6 +43,19 @@ using ::cel::ValueManager;
 using testing::Truly;
 using cel::internal::IsOkAndHolds;
 
+namespace {
+
+// Returns a string value backed by external memory which sets `*released`
+// once nothing references it anymore.
+StringValue MakeTrackedString(bool* released) {
+  // Long enough to not be inlined in the cord.
+  static const std::string* const kData = new std::string(64, 'x');
+  return StringValue(absl::MakeCordFromExternal(
+      *kData, [released]() { *released = true; }));
+}
+
+}  // namespace
+
 TEST(ComprehensionSlots, Basic) {
   cel::common_internal::LegacyValueManager factory(
       MemoryManagerRef::ReferenceCounting(), TypeProvider::Builtin());
@@ -86,4 +102,66 @@ TEST(ComprehensionSlots, Basic) {
   EXPECT_TRUE(slot3 == nullptr);
 }
 
+TEST(ComprehensionSlots, SetAfterReset) {
+  cel::common_internal::LegacyValueManager factory(
+      MemoryManagerRef::ReferenceCounting(), TypeProvider::Builtin());
+
+  ComprehensionSlots slots(2);
+  slots.Set(0, factory.CreateUncheckedStringValue("abcd"),
+            AttributeTrail(Attribute("fake_attr")));
+  slots.Reset();
+  ASSERT_EQ(slots.Get(0), nullptr);
+
+  // A slot set without a value doesn't expose the stale one.
+  slots.Set(0);
+  auto* slot0 = slots.Get(0);
+  ASSERT_TRUE(slot0 != nullptr);
+  EXPECT_FALSE(slot0->value->Is<StringValue>());
+  EXPECT_TRUE(slot0->attribute.empty());
+  EXPECT_EQ(slots.Get(1), nullptr);
+
+  slots.Reset();
+  slots.Set(1, factory.CreateUncheckedStringValue("efgh"));
+  EXPECT_EQ(slots.Get(0), nullptr);
+  auto* slot1 = slots.Get(1);
+  ASSERT_TRUE(slot1 != nullptr);
+  EXPECT_EQ(slot1->value->As<StringValue>().ToString(), "efgh");
+}
+
+TEST(ComprehensionSlots, ClearSlotReleasesValue) {
+  ComprehensionSlots slots(2);
+  bool released = false;
+  slots.Set(0, MakeTrackedString(&released),
+            AttributeTrail(Attribute("fake_attr")));
+  ASSERT_FALSE(released);
+
+  slots.ClearSlot(0);
+  EXPECT_TRUE(released);
+  EXPECT_EQ(slots.Get(0), nullptr);
+}
+
+TEST(ComprehensionSlots, ResetReleasesSetSlots) {
+  ComprehensionSlots slots(3);
+  bool released0 = false;
+  bool released2 = false;
+  slots.Set(0, MakeTrackedString(&released0));
+  slots.Set(2, MakeTrackedString(&released2));
+  // Setting a slot again doesn't count it twice.
+  slots.Set(2, MakeTrackedString(&released2));
+  slots.ClearSlot(0);
+  ASSERT_TRUE(released0);
+  released2 = false;
+
+  // Slot 2 was left set, as by an evaluation that failed inside a
+  // comprehension.
+  slots.Reset();
+  EXPECT_TRUE(released2);
+  EXPECT_EQ(slots.Get(2), nullptr);
+
+  bool released1 = false;
+  slots.Set(1, MakeTrackedString(&released1));
+  slots.Reset();
+  EXPECT_TRUE(released1);
+}
+
 }  // namespace google::api::expr::runtime
@@ -4,24 +4,32 @@
 #include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/attribute.h"
+#include "base/builtins.h"
 #include "base/kind.h"
 #include "common/casting.h"
+#include "common/native_type.h"
 #include "common/value.h"
 #include "common/value_kind.h"
+#include "common/value_manager.h"
 #include "eval/eval/attribute_trail.h"
+#include "eval/eval/comprehension_kernel.h"
 #include "eval/eval/comprehension_slots.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
 #include "eval/internal/errors.h"
 #include "eval/public/cel_attribute.h"
+#include "internal/casts.h"
 #include "internal/status_macros.h"
 #include "runtime/internal/mutable_list_impl.h"
 
@@ -63,8 +71,7 @@ absl::Status ComprehensionFinish::Evaluate(ExecutionFrame* frame) const {
   }
   Value result = frame->value_stack().Peek();
   frame->value_stack().Pop(3);
-  if (frame->enable_comprehension_list_append() &&
-      MutableListValue::Is(result)) {
+  if (MutableListValue::Is(result)) {
     // We assume this is 'owned' by the evaluator stack so const cast is safe
     // here.
     // Convert the buildable list to an actual cel::ListValue.
@@ -86,6 +93,23 @@ class ComprehensionInitStep : public ExpressionStepBase {
   absl::Status ProjectKeys(ExecutionFrame* frame) const;
 };
 
+// Visits the elements of a list, or the keys of a map, with their position.
+absl::Status ForEachElement(
+    const ListValue& range, cel::ValueManager& value_manager,
+    absl::FunctionRef<absl::StatusOr<bool>(size_t, ValueView)> callback) {
+  return range.ForEach(value_manager, callback);
+}
+
+absl::Status ForEachElement(
+    const MapValue& range, cel::ValueManager& value_manager,
+    absl::FunctionRef<absl::StatusOr<bool>(size_t, ValueView)> callback) {
+  size_t index = 0;
+  return range.ForEach(
+      value_manager, [&](ValueView key, ValueView) -> absl::StatusOr<bool> {
+        return callback(index++, key);
+      });
+}
+
 absl::StatusOr<Value> ProjectKeysImpl(ExecutionFrameBase& frame,
                                       const MapValue& range,
                                       const AttributeTrail& trail) {
@@ -144,6 +168,7 @@ class ComprehensionDirectStep : public DirectExpressionStep {
       std::unique_ptr<DirectExpressionStep> loop_step,
       std::unique_ptr<DirectExpressionStep> condition_step,
       std::unique_ptr<DirectExpressionStep> result_step, bool shortcircuiting,
+      bool count_iterations_in_bulk, ComprehensionShortcut shortcut,
       int64_t expr_id)
       : DirectExpressionStep(expr_id),
         iter_slot_(iter_slot),
@@ -153,11 +178,26 @@ class ComprehensionDirectStep : public DirectExpressionStep {
         loop_step_(std::move(loop_step)),
         condition_(std::move(condition_step)),
         result_step_(std::move(result_step)),
-        shortcircuiting_(shortcircuiting) {}
+        shortcircuiting_(shortcircuiting),
+        count_iterations_in_bulk_(count_iterations_in_bulk),
+        shortcut_(shortcut) {}
   absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
                         AttributeTrail& trail) const override;
 
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<ComprehensionDirectStep>();
+  }
+
+  void set_kernel(ComprehensionKernel kernel) { kernel_ = std::move(kernel); }
+
  private:
+  // Evaluates the comprehension over the elements of a list, or the keys of
+  // a map.
+  template <typename Range>
+  absl::Status EvaluateRange(ExecutionFrameBase& frame, const Range& range,
+                             const AttributeTrail& range_attr, Value& result,
+                             AttributeTrail& trail) const;
+
   size_t iter_slot_;
   size_t accu_slot_;
   std::unique_ptr<DirectExpressionStep> range_;
@@ -165,8 +205,11 @@ class ComprehensionDirectStep : public DirectExpressionStep {
   std::unique_ptr<DirectExpressionStep> loop_step_;
   std::unique_ptr<DirectExpressionStep> condition_;
   std::unique_ptr<DirectExpressionStep> result_step_;
+  absl::optional<ComprehensionKernel> kernel_;
 
   bool shortcircuiting_;
+  bool count_iterations_in_bulk_;
+  ComprehensionShortcut shortcut_;
 };
 
 absl::Status ComprehensionDirectStep::Evaluate(ExecutionFrameBase& frame,
@@ -176,7 +219,10 @@ absl::Status ComprehensionDirectStep::Evaluate(ExecutionFrameBase& frame,
   AttributeTrail range_attr;
   CEL_RETURN_IF_ERROR(range_->Evaluate(frame, range, range_attr));
 
-  if (InstanceOf<MapValue>(range)) {
+  // The keys of a map are only copied into a list when the iteration variable
+  // is qualified by its position for unknown processing. Otherwise they are
+  // visited in place.
+  if (InstanceOf<MapValue>(range) && frame.unknown_processing_enabled()) {
     const auto& map_value = Cast<MapValue>(range);
     CEL_ASSIGN_OR_RETURN(range, ProjectKeysImpl(frame, map_value, range_attr));
   }
@@ -188,14 +234,39 @@ absl::Status ComprehensionDirectStep::Evaluate(ExecutionFrameBase& frame,
       return absl::OkStatus();
       break;
     default:
-      if (!InstanceOf<ListValue>(range)) {
-        result = frame.value_manager().CreateErrorValue(
-            CreateNoMatchingOverloadError("<iter_range>"));
-        return absl::OkStatus();
-      }
+      break;
+  }
+  if (InstanceOf<MapValue>(range)) {
+    return EvaluateRange(frame, Cast<MapValue>(range), range_attr, result,
+                         trail);
+  }
+  if (InstanceOf<ListValue>(range)) {
+    return EvaluateRange(frame, Cast<ListValue>(range), range_attr, result,
+                         trail);
   }
+  result = frame.value_manager().CreateErrorValue(
+      CreateNoMatchingOverloadError("<iter_range>"));
+  return absl::OkStatus();
+}
 
-  const auto& range_list = Cast<ListValue>(range);
+template <typename Range>
+absl::Status ComprehensionDirectStep::EvaluateRange(
+    ExecutionFrameBase& frame, const Range& range,
+    const AttributeTrail& range_attr, Value& result,
+    AttributeTrail& trail) const {
+
+  // The kernel neither binds the iteration variable nor evaluates the loop
+  // step, which would be observable through a listener or unknown patterns.
+  if (kernel_.has_value() && !frame.callback() &&
+      !frame.unknown_processing_enabled()) {
+    CEL_ASSIGN_OR_RETURN(bool evaluated,
+                         EvaluateComprehensionKernel(*kernel_, range,
+                                                     shortcircuiting_, frame,
+                                                     result));
+    if (evaluated) {
+      return absl::OkStatus();
+    }
+  }
 
   Value accu_init;
   AttributeTrail accu_init_attr;
@@ -206,37 +277,80 @@ absl::Status ComprehensionDirectStep::Evaluate(ExecutionFrameBase& frame,
   ComprehensionSlots::Slot* accu_slot =
       frame.comprehension_slots().Get(accu_slot_);
   ABSL_DCHECK(accu_slot != nullptr);
+  CEL_ASSIGN_OR_RETURN(size_t range_size, range.Size());
+  if (MutableListValue::Is(accu_slot->value)) {
+    // Map and filter append at most one element per iteration.
+    MutableListValue::Cast(accu_slot->value).Reserve(range_size);
+  }
 
   frame.comprehension_slots().Set(iter_slot_);
   ComprehensionSlots::Slot* iter_slot =
       frame.comprehension_slots().Get(iter_slot_);
   ABSL_DCHECK(iter_slot != nullptr);
 
+  // If the loop is the only one counting iterations until it completes, and
+  // the budget covers the whole range, iterations are counted once done.
+  bool check_iterations = true;
+  if (count_iterations_in_bulk_) {
+    check_iterations = range_size > frame.RemainingIterations();
+  }
+  size_t iterations = 0;
+
+  // The loop condition of all() and exists() is evaluated in place, unless a
+  // listener observes its subexpressions.
+  const bool native_condition = (shortcut_ == ComprehensionShortcut::kAll ||
+                                 shortcut_ == ComprehensionShortcut::kExists) &&
+                                !frame.callback();
+
   Value condition;
   AttributeTrail condition_attr;
   bool should_skip_result = false;
-  CEL_RETURN_IF_ERROR(range_list.ForEach(
-      frame.value_manager(),
+  CEL_RETURN_IF_ERROR(ForEachElement(
+      range, frame.value_manager(),
       [&](size_t index, ValueView v) -> absl::StatusOr<bool> {
-        CEL_RETURN_IF_ERROR(frame.IncrementIterations());
-        // Evaluate loop condition first.
-        CEL_RETURN_IF_ERROR(
-            condition_->Evaluate(frame, condition, condition_attr));
-
-        if (condition.kind() == cel::ValueKind::kError ||
-            condition.kind() == cel::ValueKind::kUnknown) {
-          result = std::move(condition);
-          should_skip_result = true;
-          return false;
-        }
-        if (condition.kind() != cel::ValueKind::kBool) {
-          result = frame.value_manager().CreateErrorValue(
-              CreateNoMatchingOverloadError("<loop_condition>"));
-          should_skip_result = true;
-          return false;
+        if (check_iterations) {
+          CEL_RETURN_IF_ERROR(frame.IncrementIterations());
+        } else {
+          ++iterations;
         }
-        if (shortcircuiting_ && !Cast<BoolValue>(condition).NativeValue()) {
-          return false;
+        // Evaluate loop condition first.
+        if (native_condition) {
+          // Same as @not_strictly_false(accu) for all(), and
+          // @not_strictly_false(!accu) for exists().
+          const Value& accu = accu_slot->value;
+          if (InstanceOf<BoolValue>(accu)) {
+            if (shortcircuiting_ &&
+                Cast<BoolValue>(accu).NativeValue() !=
+                    (shortcut_ == ComprehensionShortcut::kAll)) {
+              return false;
+            }
+          } else if (shortcut_ == ComprehensionShortcut::kAll &&
+                     accu.kind() != cel::ValueKind::kError &&
+                     accu.kind() != cel::ValueKind::kUnknown) {
+            result = frame.value_manager().CreateErrorValue(
+                CreateNoMatchingOverloadError(cel::builtin::kNotStrictlyFalse));
+            should_skip_result = true;
+            return false;
+          }
+        } else {
+          CEL_RETURN_IF_ERROR(
+              condition_->Evaluate(frame, condition, condition_attr));
+
+          if (condition.kind() == cel::ValueKind::kError ||
+              condition.kind() == cel::ValueKind::kUnknown) {
+            result = std::move(condition);
+            should_skip_result = true;
+            return false;
+          }
+          if (condition.kind() != cel::ValueKind::kBool) {
+            result = frame.value_manager().CreateErrorValue(
+                CreateNoMatchingOverloadError("<loop_condition>"));
+            should_skip_result = true;
+            return false;
+          }
+          if (shortcircuiting_ && !Cast<BoolValue>(condition).NativeValue()) {
+            return false;
+          }
         }
 
         iter_slot->value = v;
@@ -256,6 +370,7 @@ absl::Status ComprehensionDirectStep::Evaluate(ExecutionFrameBase& frame,
         return true;
       }));
 
+  frame.CountIterations(iterations);
   frame.comprehension_slots().ClearSlot(iter_slot_);
   // Error state is already set to the return value, just clean up.
   if (should_skip_result) {
@@ -264,8 +379,7 @@ absl::Status ComprehensionDirectStep::Evaluate(ExecutionFrameBase& frame,
   }
 
   CEL_RETURN_IF_ERROR(result_step_->Evaluate(frame, result, trail));
-  if (frame.options().enable_comprehension_list_append &&
-      MutableListValue::Is(result)) {
+  if (MutableListValue::Is(result)) {
     // We assume the list builder is 'owned' by the evaluator stack so
     // destructive operation is safe here.
     //
@@ -310,6 +424,16 @@ void ComprehensionNextStep::set_error_jump_offset(int offset) {
   error_jump_offset_ = offset;
 }
 
+std::vector<int> ComprehensionNextStep::GetJumpOffsets() const {
+  return {jump_offset_, error_jump_offset_};
+}
+
+void ComprehensionNextStep::SetJumpOffsets(absl::Span<const int> offsets) {
+  ABSL_DCHECK_EQ(offsets.size(), 2);
+  jump_offset_ = offsets[0];
+  error_jump_offset_ = offsets[1];
+}
+
 // Stack changes of ComprehensionNextStep.
 //
 // Stack before:
@@ -369,6 +493,14 @@ absl::Status ComprehensionNextStep::Evaluate(ExecutionFrame* frame) const {
 
   CEL_ASSIGN_OR_RETURN(auto iter_range_list_size, iter_range_list.Size());
 
+  if (next_index == 0) {
+    // Map and filter append at most one element per iteration.
+    Value& accu = frame->comprehension_slots().Get(accu_slot_)->value;
+    if (MutableListValue::Is(accu)) {
+      MutableListValue::Cast(accu).Reserve(iter_range_list_size);
+    }
+  }
+
   if (next_index >= static_cast<int64_t>(iter_range_list_size)) {
     // Make sure the iter var is out of scope.
     frame->comprehension_slots().ClearSlot(iter_slot_);
@@ -422,6 +554,16 @@ void ComprehensionCondStep::set_error_jump_offset(int offset) {
   error_jump_offset_ = offset;
 }
 
+std::vector<int> ComprehensionCondStep::GetJumpOffsets() const {
+  return {jump_offset_, error_jump_offset_};
+}
+
+void ComprehensionCondStep::SetJumpOffsets(absl::Span<const int> offsets) {
+  ABSL_DCHECK_EQ(offsets.size(), 2);
+  jump_offset_ = offsets[0];
+  error_jump_offset_ = offsets[1];
+}
+
 // Check the break condition for the comprehension.
 //
 // If the condition is false jump to the `result` subexpression.
@@ -467,11 +609,23 @@ std::unique_ptr<DirectExpressionStep> CreateDirectComprehensionStep(
     std::unique_ptr<DirectExpressionStep> loop_step,
     std::unique_ptr<DirectExpressionStep> condition_step,
     std::unique_ptr<DirectExpressionStep> result_step, bool shortcircuiting,
-    int64_t expr_id) {
+    int64_t expr_id, bool count_iterations_in_bulk,
+    ComprehensionShortcut shortcut) {
   return std::make_unique<ComprehensionDirectStep>(
       iter_slot, accu_slot, std::move(range), std::move(accu_init),
       std::move(loop_step), std::move(condition_step), std::move(result_step),
-      shortcircuiting, expr_id);
+      shortcircuiting, count_iterations_in_bulk, shortcut, expr_id);
+}
+
+bool SetComprehensionKernel(DirectExpressionStep& step,
+                            ComprehensionKernel kernel) {
+  if (step.GetNativeTypeId() !=
+      cel::NativeTypeId::For<ComprehensionDirectStep>()) {
+    return false;
+  }
+  cel::internal::down_cast<ComprehensionDirectStep&>(step).set_kernel(
+      std::move(kernel));
+  return true;
 }
 
 std::unique_ptr<ExpressionStep> CreateComprehensionFinishStep(size_t accu_slot,
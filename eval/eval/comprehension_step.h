@@ -4,8 +4,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "eval/eval/comprehension_kernel.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
@@ -21,6 +24,9 @@ class ComprehensionNextStep : public ExpressionStepBase {
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
 
+  std::vector<int> GetJumpOffsets() const override;
+  void SetJumpOffsets(absl::Span<const int> offsets) override;
+
  private:
   size_t iter_slot_;
   size_t accu_slot_;
@@ -38,6 +44,9 @@ class ComprehensionCondStep : public ExpressionStepBase {
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
 
+  std::vector<int> GetJumpOffsets() const override;
+  void SetJumpOffsets(absl::Span<const int> offsets) override;
+
  private:
   size_t iter_slot_;
   size_t accu_slot_;
@@ -46,7 +55,23 @@ class ComprehensionCondStep : public ExpressionStepBase {
   bool shortcircuiting_;
 };
 
+// Loop shapes of the standard macros that the direct comprehension step
+// evaluates natively.
+enum class ComprehensionShortcut {
+  kNone,
+  // all(): the loop condition is `@not_strictly_false(accu)`.
+  kAll,
+  // exists(): the loop condition is `@not_strictly_false(!accu)`.
+  kExists,
+};
+
 // Creates a step for executing a comprehension.
+//
+// `count_iterations_in_bulk` may be set if evaluating the loop condition and
+// step never evaluates another comprehension: the iteration budget is then
+// checked once per loop rather than on every iteration when sufficient.
+//
+// The caller is responsible for `shortcut` matching the loop.
 std::unique_ptr<DirectExpressionStep> CreateDirectComprehensionStep(
     size_t iter_slot, size_t accu_slot,
     std::unique_ptr<DirectExpressionStep> range,
@@ -54,7 +79,16 @@ std::unique_ptr<DirectExpressionStep> CreateDirectComprehensionStep(
     std::unique_ptr<DirectExpressionStep> loop_step,
     std::unique_ptr<DirectExpressionStep> condition_step,
     std::unique_ptr<DirectExpressionStep> result_step, bool shortcircuiting,
-    int64_t expr_id);
+    int64_t expr_id, bool count_iterations_in_bulk = false,
+    ComprehensionShortcut shortcut = ComprehensionShortcut::kNone);
+
+// Has `step`, if created by CreateDirectComprehensionStep, evaluate `kernel`
+// whenever possible instead of the loop it was created with.
+//
+// The caller is responsible for the kernel being equivalent to the loop.
+// Returns false if `step` is not a comprehension step.
+bool SetComprehensionKernel(DirectExpressionStep& step,
+                            ComprehensionKernel kernel);
 
 // Creates a cleanup step for the comprehension.
 // Removes the comprehension context then pushes the 'result' sub expression to
@@ -1,5 +1,6 @@
 #include "eval/eval/comprehension_step.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -52,6 +53,7 @@ using testing::_;
 using testing::Eq;
 using testing::Return;
 using testing::SizeIs;
+using testing::UnorderedElementsAre;
 using cel::internal::StatusIs;
 
 Ident CreateIdent(const std::string& var) {
@@ -281,6 +283,17 @@ class DirectComprehensionTest : public testing::Test {
     return std::move(*builder).Build();
   }
 
+  // returns a two element map for testing {1: true, 2: false}.
+  absl::StatusOr<cel::MapValue> MakeMap() {
+    CEL_ASSIGN_OR_RETURN(auto builder,
+                         value_manager_.get().NewMapValueBuilder(
+                             value_manager_.get().GetDynDynMapType()));
+
+    CEL_RETURN_IF_ERROR(builder->Put(IntValue(1), BoolValue(true)));
+    CEL_RETURN_IF_ERROR(builder->Put(IntValue(2), BoolValue(false)));
+    return std::move(*builder).Build();
+  }
+
  protected:
   google::protobuf::Arena arena_;
   cel::ManagedValueFactory value_manager_;
@@ -497,6 +510,44 @@ TEST_F(DirectComprehensionTest, IterationLimit) {
               StatusIs(absl::StatusCode::kInternal));
 }
 
+TEST_F(DirectComprehensionTest, IterationLimitCountedInBulk) {
+  cel::RuntimeOptions options;
+  options.comprehension_max_iterations = 3;
+  ExecutionFrameBase frame(empty_activation_, /*callback=*/nullptr, options,
+                           value_manager_.get(), slots_);
+
+  auto loop_step = std::make_unique<MockDirectStep>();
+  MockDirectStep* mock = loop_step.get();
+
+  // The budget covers the first evaluation, then runs out on the first
+  // iteration of the second one.
+  EXPECT_CALL(*mock, Evaluate(_, _, _))
+      .Times(2)
+      .WillRepeatedly([](ExecutionFrameBase&, Value& result, AttributeTrail&) {
+        result = BoolValue(false);
+        return absl::OkStatus();
+      });
+
+  ASSERT_OK_AND_ASSIGN(auto list, MakeList());
+
+  auto compre_step = CreateDirectComprehensionStep(
+      0, 1,
+      /*range_step=*/CreateConstValueDirectStep(std::move(list)),
+      /*accu_init=*/CreateConstValueDirectStep(BoolValue(false)),
+      /*loop_step=*/std::move(loop_step),
+      /*condition_step=*/CreateConstValueDirectStep(BoolValue(true)),
+      /*result_step=*/CreateDirectSlotIdentStep("__result__", 1, -1),
+      /*shortcircuiting=*/true, -1, /*count_iterations_in_bulk=*/true);
+
+  Value result;
+  AttributeTrail trail;
+  ASSERT_OK(compre_step->Evaluate(frame, result, trail));
+  EXPECT_EQ(frame.RemainingIterations(), 0u);
+  EXPECT_THAT(compre_step->Evaluate(frame, result, trail),
+              StatusIs(absl::StatusCode::kInternal,
+                       "Iteration budget exceeded"));
+}
+
 TEST_F(DirectComprehensionTest, Exhaustive) {
   cel::RuntimeOptions options;
 
@@ -530,5 +581,43 @@ TEST_F(DirectComprehensionTest, Exhaustive) {
   EXPECT_THAT(result, BoolValueIs(false));
 }
 
+TEST_F(DirectComprehensionTest, MapKeys) {
+  cel::RuntimeOptions options;
+
+  ExecutionFrameBase frame(empty_activation_, /*callback=*/nullptr, options,
+                           value_manager_.get(), slots_);
+
+  auto loop_step = std::make_unique<MockDirectStep>();
+  MockDirectStep* mock = loop_step.get();
+
+  std::vector<int64_t> keys;
+  EXPECT_CALL(*mock, Evaluate(_, _, _))
+      .Times(2)
+      .WillRepeatedly([&keys](ExecutionFrameBase& frame, Value& result,
+                              AttributeTrail&) {
+        const Value& key = frame.comprehension_slots().Get(0)->value;
+        keys.push_back(key.As<IntValue>().NativeValue());
+        result = BoolValue(false);
+        return absl::OkStatus();
+      });
+
+  ASSERT_OK_AND_ASSIGN(auto map, MakeMap());
+
+  auto compre_step = CreateDirectComprehensionStep(
+      0, 1,
+      /*range_step=*/CreateConstValueDirectStep(std::move(map)),
+      /*accu_init=*/CreateConstValueDirectStep(BoolValue(false)),
+      /*loop_step=*/std::move(loop_step),
+      /*condition_step=*/CreateConstValueDirectStep(BoolValue(true)),
+      /*result_step=*/CreateDirectSlotIdentStep("__result__", 1, -1),
+      /*shortcircuiting=*/true, -1);
+
+  Value result;
+  AttributeTrail trail;
+  ASSERT_OK(compre_step->Evaluate(frame, result, trail));
+  EXPECT_THAT(result, BoolValueIs(false));
+  EXPECT_THAT(keys, UnorderedElementsAre(1, 2));
+}
+
 }  // namespace
 }  // namespace google::api::expr::runtime
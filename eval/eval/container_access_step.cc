@@ -1,31 +1,39 @@
 #include "eval/eval/container_access_step.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/ast_internal/expr.h"
 #include "base/attribute.h"
+#include "base/builtins.h"
 #include "base/kind.h"
 #include "common/casting.h"
 #include "common/native_type.h"
 #include "common/value.h"
 #include "common/value_kind.h"
+#include "common/value_manager.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/attribute_utility.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
+#include "eval/eval/function_step.h"
 #include "eval/internal/errors.h"
 #include "internal/casts.h"
 #include "internal/number.h"
 #include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
 #include "runtime/internal/errors.h"
 
 namespace google::api::expr::runtime {
@@ -34,6 +42,7 @@ namespace {
 
 using ::cel::AttributeQualifier;
 using ::cel::BoolValue;
+using ::cel::BoolValueView;
 using ::cel::Cast;
 using ::cel::DoubleValue;
 using ::cel::ErrorValue;
@@ -41,11 +50,13 @@ using ::cel::InstanceOf;
 using ::cel::IntValue;
 using ::cel::ListValue;
 using ::cel::MapValue;
+using ::cel::OptionalValue;
 using ::cel::StringValue;
 using ::cel::UintValue;
 using ::cel::Value;
 using ::cel::ValueKind;
 using ::cel::ValueKindToString;
+using ::cel::ValueManager;
 using ::cel::ValueView;
 using ::cel::internal::Number;
 using ::cel::runtime_internal::CreateNoSuchKeyError;
@@ -95,51 +106,107 @@ AttributeQualifier AttributeQualifierFromValue(const Value& v) {
   }
 }
 
+// Looks up `key` in `cel_map`, given `key_hash` if it is its
+// `cel::MapKeyHash`. Returns an error value if the lookup fails, and nullopt
+// if the key is missing.
+absl::optional<ValueView> FindInMap(const MapValue& cel_map, const Value& key,
+                                    absl::optional<size_t> key_hash,
+                                    ExecutionFrameBase& frame,
+                                    Value& scratch) {
+  auto lookup =
+      key_hash.has_value()
+          ? cel_map.FindHashed(frame.value_manager(), key, *key_hash, scratch)
+          : cel_map.Find(frame.value_manager(), key, scratch);
+  if (!lookup.ok()) {
+    scratch =
+        frame.value_manager().CreateErrorValue(std::move(lookup).status());
+    return ValueView{scratch};
+  }
+  if (lookup->second) {
+    return lookup->first;
+  }
+  return absl::nullopt;
+}
+
+// Looks up the numeric `key` in a map declared with keys of `map_key_kind`,
+// which are the only keys it should hold: a single probe finds the key in a
+// map matching its declaration.
+absl::optional<ValueView> FindNumberInTypedMap(
+    const MapValue& cel_map, const Value& key, const Number& number,
+    absl::optional<size_t> key_hash, ValueKind map_key_kind,
+    ExecutionFrameBase& frame, Value& scratch) {
+  switch (map_key_kind) {
+    case ValueKind::kInt64:
+      if (key->Is<IntValue>()) {
+        return FindInMap(cel_map, key, key_hash, frame, scratch);
+      }
+      if (number.LosslessConvertibleToInt()) {
+        return FindInMap(cel_map,
+                         frame.value_manager().CreateIntValue(number.AsInt()),
+                         absl::nullopt, frame, scratch);
+      }
+      return absl::nullopt;
+    case ValueKind::kUint64:
+      if (key->Is<UintValue>()) {
+        return FindInMap(cel_map, key, key_hash, frame, scratch);
+      }
+      if (number.LosslessConvertibleToUint()) {
+        return FindInMap(
+            cel_map, frame.value_manager().CreateUintValue(number.AsUint()),
+            absl::nullopt, frame, scratch);
+      }
+      return absl::nullopt;
+    default:
+      // The map has no numeric keys.
+      return absl::nullopt;
+  }
+}
+
 ValueView LookupInMap(const MapValue& cel_map, const Value& key,
+                      absl::optional<size_t> key_hash,
+                      absl::optional<ValueKind> map_key_kind,
                       ExecutionFrameBase& frame, Value& scratch) {
   if (frame.options().enable_heterogeneous_equality) {
     // Double isn't a supported key type but may be convertible to an integer.
     absl::optional<Number> number = CelNumberFromValue(key);
     if (number.has_value()) {
+      if (map_key_kind.has_value()) {
+        if (auto found =
+                FindNumberInTypedMap(cel_map, key, *number, key_hash,
+                                     *map_key_kind, frame, scratch);
+            found.has_value()) {
+          return *found;
+        }
+        // Nothing checks the runtime map against its declaration, e.g. a
+        // legacy or custom map may hold keys of another kind, so a miss falls
+        // back to the lookup below.
+      }
       // Consider uint as uint first then try coercion (prefer matching the
       // original type of the key value).
       if (key->Is<UintValue>()) {
-        auto lookup = cel_map.Find(frame.value_manager(), key, scratch);
-        if (!lookup.ok()) {
-          scratch = frame.value_manager().CreateErrorValue(
-              std::move(lookup).status());
-          return ValueView{scratch};
-        }
-        if (lookup->second) {
-          return lookup->first;
+        if (auto found = FindInMap(cel_map, key, key_hash, frame, scratch);
+            found.has_value()) {
+          return *found;
         }
       }
       // double / int / uint -> int
       if (number->LosslessConvertibleToInt()) {
-        auto lookup = cel_map.Find(
-            frame.value_manager(),
-            frame.value_manager().CreateIntValue(number->AsInt()), scratch);
-        if (!lookup.ok()) {
-          scratch = frame.value_manager().CreateErrorValue(
-              std::move(lookup).status());
-          return ValueView{scratch};
-        }
-        if (lookup->second) {
-          return lookup->first;
+        if (auto found = FindInMap(
+                cel_map, frame.value_manager().CreateIntValue(number->AsInt()),
+                key->Is<IntValue>() ? key_hash : absl::nullopt, frame,
+                scratch);
+            found.has_value()) {
+          return *found;
         }
       }
-      // double / int -> uint
-      if (number->LosslessConvertibleToUint()) {
-        auto lookup = cel_map.Find(
-            frame.value_manager(),
-            frame.value_manager().CreateUintValue(number->AsUint()), scratch);
-        if (!lookup.ok()) {
-          scratch = frame.value_manager().CreateErrorValue(
-              std::move(lookup).status());
-          return ValueView{scratch};
-        }
-        if (lookup->second) {
-          return lookup->first;
+      // double / int -> uint, uint keys were already looked up.
+      if (!key->Is<UintValue>() && number->LosslessConvertibleToUint()) {
+        if (auto found = FindInMap(
+                cel_map,
+                frame.value_manager().CreateUintValue(number->AsUint()),
+                absl::nullopt, frame, scratch);
+            found.has_value()) {
+          return *found;
         }
       }
       scratch = frame.value_manager().CreateErrorValue(
@@ -154,6 +221,20 @@ ValueView LookupInMap(const MapValue& cel_map, const Value& key,
     return ValueView{scratch};
   }
 
+  if (key_hash.has_value()) {
+    auto lookup =
+        cel_map.FindHashed(frame.value_manager(), key, *key_hash, scratch);
+    if (!lookup.ok()) {
+      scratch =
+          frame.value_manager().CreateErrorValue(std::move(lookup).status());
+      return ValueView{scratch};
+    }
+    if (lookup->second) {
+      return lookup->first;
+    }
+    // Missing keys fall through to `Get`, which reports them.
+  }
+
   absl::StatusOr<ValueView> lookup =
       cel_map.Get(frame.value_manager(), key, scratch);
   if (!lookup.ok()) {
@@ -207,11 +288,14 @@ ValueView LookupInList(const ListValue& cel_list, const Value& key,
 }
 
 ValueView LookupInContainer(const Value& container, const Value& key,
+                            absl::optional<size_t> key_hash,
+                            absl::optional<ValueKind> map_key_kind,
                             ExecutionFrameBase& frame, Value& scratch) {
   // Select steps can be applied to either maps or messages
   switch (container.kind()) {
     case ValueKind::kMap: {
-      return LookupInMap(Cast<MapValue>(container), key, frame, scratch);
+      return LookupInMap(Cast<MapValue>(container), key, key_hash,
+                         map_key_kind, frame, scratch);
     }
     case ValueKind::kList: {
       return LookupInList(Cast<ListValue>(container), key, frame, scratch);
@@ -225,8 +309,12 @@ ValueView LookupInContainer(const Value& container, const Value& key,
   }
 }
 
+// `key_hash` is `MapKeyHash` of `key` if it was computed when planning, and
+// `map_key_kind` the checked kind of the keys of the container if it is a map.
 ValueView PerformLookup(ExecutionFrameBase& frame, const Value& container,
-                        const Value& key, const AttributeTrail& container_trail,
+                        const Value& key, absl::optional<size_t> key_hash,
+                        absl::optional<ValueKind> map_key_kind,
+                        const AttributeTrail& container_trail,
                         bool enable_optional_types, Value& scratch,
                         AttributeTrail& trail) {
   if (frame.unknown_processing_enabled()) {
@@ -267,8 +355,8 @@ ValueView PerformLookup(ExecutionFrameBase& frame, const Value& container,
       scratch = cel::OptionalValue::None();
       return ValueView{scratch};
     }
-    auto result =
-        LookupInContainer(optional_value.Value(), key, frame, scratch);
+    auto result = LookupInContainer(optional_value.Value(), key, key_hash,
+                                    map_key_kind, frame, scratch);
     if (auto error_value = cel::As<cel::ErrorValueView>(result);
         error_value && cel::IsNoSuchKey(error_value->NativeValue())) {
       scratch = cel::OptionalValue::None();
@@ -279,24 +367,37 @@ ValueView PerformLookup(ExecutionFrameBase& frame, const Value& container,
     return ValueView{scratch};
   }
 
-  return LookupInContainer(container, key, frame, scratch);
+  return LookupInContainer(container, key, key_hash, map_key_kind, frame,
+                           scratch);
 }
 
 // ContainerAccessStep performs message field access specified by Expr::Select
 // message.
+//
+// If kAttributeTracking is false, the program was planned without unknown or
+// missing attribute support and attribute trails are never computed.
+template <bool kAttributeTracking>
 class ContainerAccessStep : public ExpressionStepBase {
  public:
-  ContainerAccessStep(int64_t expr_id, bool enable_optional_types)
+  ContainerAccessStep(int64_t expr_id, bool enable_optional_types,
+                      absl::optional<size_t> key_hash,
+                      absl::optional<ValueKind> map_key_kind)
       : ExpressionStepBase(expr_id),
-        enable_optional_types_(enable_optional_types) {}
+        enable_optional_types_(enable_optional_types),
+        key_hash_(key_hash),
+        map_key_kind_(map_key_kind) {}
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
 
  private:
   bool enable_optional_types_;
+  absl::optional<size_t> key_hash_;
+  absl::optional<ValueKind> map_key_kind_;
 };
 
-absl::Status ContainerAccessStep::Evaluate(ExecutionFrame* frame) const {
+template <bool kAttributeTracking>
+absl::Status ContainerAccessStep<kAttributeTracking>::Evaluate(
+    ExecutionFrame* frame) const {
   if (!frame->value_stack().HasEnough(kNumContainerAccessArguments)) {
     return absl::Status(
         absl::StatusCode::kInternal,
@@ -306,13 +407,25 @@ absl::Status ContainerAccessStep::Evaluate(ExecutionFrame* frame) const {
   Value scratch;
   AttributeTrail result_trail;
   auto args = frame->value_stack().GetSpan(kNumContainerAccessArguments);
-  const AttributeTrail& container_trail =
-      frame->value_stack().GetAttributeSpan(kNumContainerAccessArguments)[0];
 
-  auto result = PerformLookup(*frame, args[0], args[1], container_trail,
-                              enable_optional_types_, scratch, result_trail);
-  frame->value_stack().PopAndPush(kNumContainerAccessArguments, Value{result},
-                                  std::move(result_trail));
+  if constexpr (kAttributeTracking) {
+    const AttributeTrail& container_trail =
+        frame->value_stack().GetAttributeSpan(kNumContainerAccessArguments)[0];
+
+    auto result = PerformLookup(*frame, args[0], args[1], key_hash_,
+                                map_key_kind_, container_trail,
+                                enable_optional_types_, scratch, result_trail);
+    frame->value_stack().PopAndPush(kNumContainerAccessArguments,
+                                    Value{result}, std::move(result_trail));
+  } else {
+    // All trails are empty if attribute tracking is disabled, and the
+    // container trail is only consulted when unknowns are enabled.
+    auto result = PerformLookup(*frame, args[0], args[1], key_hash_,
+                                map_key_kind_, result_trail,
+                                enable_optional_types_, scratch, result_trail);
+    frame->value_stack().PopAndPushValue(kNumContainerAccessArguments,
+                                         Value{result});
+  }
 
   return absl::OkStatus();
 }
@@ -322,11 +435,14 @@ class DirectContainerAccessStep : public DirectExpressionStep {
   DirectContainerAccessStep(
       std::unique_ptr<DirectExpressionStep> container_step,
       std::unique_ptr<DirectExpressionStep> key_step,
-      bool enable_optional_types, int64_t expr_id)
+      bool enable_optional_types, int64_t expr_id,
+      absl::optional<size_t> key_hash, absl::optional<ValueKind> map_key_kind)
       : DirectExpressionStep(expr_id),
         container_step_(std::move(container_step)),
         key_step_(std::move(key_step)),
-        enable_optional_types_(enable_optional_types) {}
+        enable_optional_types_(enable_optional_types),
+        key_hash_(key_hash),
+        map_key_kind_(map_key_kind) {}
 
   absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
                         AttributeTrail& trail) const override;
@@ -335,6 +451,8 @@ class DirectContainerAccessStep : public DirectExpressionStep {
   std::unique_ptr<DirectExpressionStep> container_step_;
   std::unique_ptr<DirectExpressionStep> key_step_;
   bool enable_optional_types_;
+  absl::optional<size_t> key_hash_;
+  absl::optional<ValueKind> map_key_kind_;
 };
 
 absl::Status DirectContainerAccessStep::Evaluate(ExecutionFrameBase& frame,
@@ -349,9 +467,385 @@ absl::Status DirectContainerAccessStep::Evaluate(ExecutionFrameBase& frame,
       container_step_->Evaluate(frame, container, container_trail));
   CEL_RETURN_IF_ERROR(key_step_->Evaluate(frame, key, key_trail));
 
-  result = PerformLookup(frame, container, key, container_trail,
-                         enable_optional_types_, result, trail);
+  result = PerformLookup(frame, container, key, key_hash_, map_key_kind_,
+                         container_trail, enable_optional_types_, result,
+                         trail);
+
+  return absl::OkStatus();
+}
+
+// Sets `value` to the entry of `key` in `cel_map`, given `key_hash` if it is
+// its `cel::MapKeyHash`. Returns whether the key is present.
+absl::StatusOr<bool> FindMapEntry(const MapValue& cel_map, ValueView key,
+                                  absl::optional<size_t> key_hash,
+                                  ValueManager& value_manager, Value& value) {
+  Value scratch;
+  absl::StatusOr<std::pair<ValueView, bool>> lookup =
+      key_hash.has_value()
+          ? cel_map.FindHashed(value_manager, key, *key_hash, scratch)
+          : cel_map.Find(value_manager, key, scratch);
+  CEL_RETURN_IF_ERROR(lookup.status());
+  if (!lookup->second) {
+    return false;
+  }
+  value = Value{lookup->first};
+  return true;
+}
+
+// Like `MapValue::Has`, but uses `key_hash` if it is known.
+absl::StatusOr<bool> ContainsMapKey(const MapValue& cel_map, ValueView key,
+                                    absl::optional<size_t> key_hash,
+                                    ValueManager& value_manager) {
+  Value scratch;
+  if (key_hash.has_value()) {
+    CEL_ASSIGN_OR_RETURN(
+        auto lookup,
+        cel_map.FindHashed(value_manager, key, *key_hash, scratch));
+    return lookup.second;
+  }
+  CEL_ASSIGN_OR_RETURN(ValueView has, cel_map.Has(value_manager, key, scratch));
+  auto has_value = cel::As<BoolValueView>(has);
+  return has_value.has_value() && has_value->NativeValue();
+}
+
+// `map[?key]`, with the results of the standard `_[?_]` overload for maps.
+// Returns false, leaving `result` alone, for keys of another kind.
+absl::StatusOr<bool> OptionalIndexMap(const MapValue& cel_map, const Value& key,
+                                      absl::optional<size_t> key_hash,
+                                      ValueManager& value_manager,
+                                      Value& result) {
+  Value value;
+  switch (key->kind()) {
+    case ValueKind::kDouble: {
+      // Try int/uint.
+      Number number = Number::FromDouble(key.As<DoubleValue>().NativeValue());
+      if (number.LosslessConvertibleToInt()) {
+        CEL_ASSIGN_OR_RETURN(bool found,
+                             FindMapEntry(cel_map, IntValue{number.AsInt()},
+                                          absl::nullopt, value_manager, value));
+        if (found) {
+          result = OptionalValue::Of(value_manager.GetMemoryManager(),
+                                     std::move(value));
+          return true;
+        }
+      }
+      if (number.LosslessConvertibleToUint()) {
+        CEL_ASSIGN_OR_RETURN(bool found,
+                             FindMapEntry(cel_map, UintValue{number.AsUint()},
+                                          absl::nullopt, value_manager, value));
+        if (found) {
+          result = OptionalValue::Of(value_manager.GetMemoryManager(),
+                                     std::move(value));
+          return true;
+        }
+      }
+      result = OptionalValue::None();
+      return true;
+    }
+    case ValueKind::kBool:
+    case ValueKind::kInt:
+    case ValueKind::kUint:
+    case ValueKind::kString:
+      break;
+    default:
+      return false;
+  }
+
+  CEL_ASSIGN_OR_RETURN(bool found, FindMapEntry(cel_map, key, key_hash,
+                                                value_manager, value));
+  if (!found) {
+    if (key->Is<IntValue>() && key.As<IntValue>().NativeValue() >= 0) {
+      CEL_ASSIGN_OR_RETURN(
+          found, FindMapEntry(cel_map,
+                              UintValue{static_cast<uint64_t>(
+                                  key.As<IntValue>().NativeValue())},
+                              absl::nullopt, value_manager, value));
+    } else if (key->Is<UintValue>() &&
+               key.As<UintValue>().NativeValue() <=
+                   static_cast<uint64_t>(
+                       std::numeric_limits<int64_t>::max())) {
+      CEL_ASSIGN_OR_RETURN(
+          found, FindMapEntry(cel_map,
+                              IntValue{static_cast<int64_t>(
+                                  key.As<UintValue>().NativeValue())},
+                              absl::nullopt, value_manager, value));
+    }
+  }
+  if (found) {
+    result =
+        OptionalValue::Of(value_manager.GetMemoryManager(), std::move(value));
+  } else {
+    result = OptionalValue::None();
+  }
+  return true;
+}
+
+// `list[?index]`, with the results of the standard `_[?_]` overload for
+// lists.
+absl::Status OptionalIndexList(const ListValue& cel_list, int64_t index,
+                               ValueManager& value_manager, Value& result) {
+  CEL_ASSIGN_OR_RETURN(size_t size, cel_list.Size());
+  if (index < 0 || static_cast<size_t>(index) >= size) {
+    result = OptionalValue::None();
+    return absl::OkStatus();
+  }
+  CEL_ASSIGN_OR_RETURN(Value element,
+                       cel_list.Get(value_manager, static_cast<size_t>(index)));
+  result =
+      OptionalValue::Of(value_manager.GetMemoryManager(), std::move(element));
+  return absl::OkStatus();
+}
+
+// Evaluates `container[?key]` for the arguments the standard `_[?_]` overloads
+// accept, as they would. Other arguments are left to the overloads.
+struct OptionalIndexKernel {
+  static constexpr absl::string_view kName = "_[?_]";
+
+  static absl::StatusOr<bool> Apply(ExecutionFrameBase& frame,
+                                    absl::Span<const Value> args,
+                                    absl::optional<size_t> key_hash,
+                                    Value& result) {
+    const Value& container = args[0];
+    const Value& key = args[1];
+    if (key->Is<ErrorValue>() || key->Is<cel::UnknownValue>()) {
+      // The overloads are strict.
+      return false;
+    }
+    switch (container->kind()) {
+      case ValueKind::kMap:
+        return OptionalIndexMap(Cast<MapValue>(container), key, key_hash,
+                                frame.value_manager(), result);
+      case ValueKind::kList:
+        if (!key->Is<IntValue>()) {
+          return false;
+        }
+        CEL_RETURN_IF_ERROR(OptionalIndexList(
+            Cast<ListValue>(container), key.As<IntValue>().NativeValue(),
+            frame.value_manager(), result));
+        return true;
+      case ValueKind::kOpaque:
+        break;
+      default:
+        return false;
+    }
+
+    if (cel::NativeTypeId::Of(container) !=
+        cel::NativeTypeId::For<cel::OptionalValueInterface>()) {
+      return false;
+    }
+    const auto& optional_value =
+        *cel::internal::down_cast<const cel::OptionalValueInterface*>(
+            Cast<cel::OpaqueValue>(container).operator->());
+    if (!optional_value.HasValue()) {
+      result = OptionalValue::None();
+      return true;
+    }
+    Value value = optional_value.Value();
+    if (value->Is<MapValue>()) {
+      return OptionalIndexMap(Cast<MapValue>(value), key, key_hash,
+                              frame.value_manager(), result);
+    }
+    if (value->Is<ListValue>() && key->Is<IntValue>()) {
+      CEL_RETURN_IF_ERROR(OptionalIndexList(
+          Cast<ListValue>(value), key.As<IntValue>().NativeValue(),
+          frame.value_manager(), result));
+      return true;
+    }
+    return false;
+  }
+};
+
+// Evaluates `key in map` for the arguments the standard `@in` overloads for
+// maps accept, as they would. Other arguments, including lists, are left to
+// the overloads.
+struct MapMembershipKernel {
+  static constexpr absl::string_view kName = cel::builtin::kIn;
+
+  static absl::StatusOr<bool> Apply(ExecutionFrameBase& frame,
+                                    absl::Span<const Value> args,
+                                    absl::optional<size_t> key_hash,
+                                    Value& result) {
+    const Value& key = args[0];
+    const Value& container = args[1];
+    if (!container->Is<MapValue>()) {
+      return false;
+    }
+    const auto& cel_map = Cast<MapValue>(container);
+    ValueManager& value_manager = frame.value_manager();
+    const bool enable_heterogeneous_equality =
+        frame.options().enable_heterogeneous_equality;
+
+    switch (key->kind()) {
+      case ValueKind::kBool:
+      case ValueKind::kString: {
+        absl::StatusOr<bool> found =
+            ContainsMapKey(cel_map, key, key_hash, value_manager);
+        if (found.ok()) {
+          result = BoolValue{*found};
+        } else if (enable_heterogeneous_equality) {
+          result = BoolValue{false};
+        } else {
+          result = value_manager.CreateErrorValue(std::move(found).status());
+        }
+        return true;
+      }
+      case ValueKind::kInt:
+      case ValueKind::kUint: {
+        absl::StatusOr<bool> found =
+            ContainsMapKey(cel_map, key, key_hash, value_manager);
+        if (!enable_heterogeneous_equality) {
+          if (found.ok()) {
+            result = BoolValue{*found};
+          } else {
+            result = value_manager.CreateErrorValue(std::move(found).status());
+          }
+          return true;
+        }
+        if (!found.ok() || !*found) {
+          absl::optional<Number> number = CelNumberFromValue(key);
+          if (key->Is<IntValue>() && number->LosslessConvertibleToUint()) {
+            found = ContainsMapKey(cel_map, UintValue{number->AsUint()},
+                                   absl::nullopt, value_manager);
+          } else if (key->Is<UintValue>() &&
+                     number->LosslessConvertibleToInt()) {
+            found = ContainsMapKey(cel_map, IntValue{number->AsInt()},
+                                   absl::nullopt, value_manager);
+          }
+        }
+        result = BoolValue{found.ok() && *found};
+        return true;
+      }
+      case ValueKind::kDouble: {
+        if (!enable_heterogeneous_equality) {
+          // No overload for double keys.
+          return false;
+        }
+        Number number = Number::FromDouble(key.As<DoubleValue>().NativeValue());
+        absl::StatusOr<bool> found = false;
+        if (number.LosslessConvertibleToInt()) {
+          found = ContainsMapKey(cel_map, IntValue{number.AsInt()},
+                                 absl::nullopt, value_manager);
+        }
+        if ((!found.ok() || !*found) && number.LosslessConvertibleToUint()) {
+          found = ContainsMapKey(cel_map, UintValue{number.AsUint()},
+                                 absl::nullopt, value_manager);
+        }
+        result = BoolValue{found.ok() && *found};
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+};
+
+// Stack machine step for a call evaluated inline by `Kernel` when possible,
+// and by `fallback`, the generic function step for the call, otherwise.
+template <typename Kernel>
+class InlineAccessStep final : public ExpressionStepBase {
+ public:
+  InlineAccessStep(int64_t expr_id, std::unique_ptr<ExpressionStep> fallback,
+                   absl::optional<size_t> key_hash)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        fallback_(std::move(fallback)),
+        key_hash_(key_hash) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(kNumContainerAccessArguments)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Value stack underflow");
+    }
+    if (frame->enable_unknowns()) {
+      // Partial unknowns depend on the attribute trails.
+      return fallback_->Evaluate(frame);
+    }
+    Value result;
+    absl::Span<const Value> args =
+        frame->value_stack().GetSpan(kNumContainerAccessArguments);
+    CEL_ASSIGN_OR_RETURN(bool applied,
+                         Kernel::Apply(*frame, args, key_hash_, result));
+    if (!applied) {
+      return fallback_->Evaluate(frame);
+    }
+    frame->value_stack().PopAndPush(kNumContainerAccessArguments,
+                                    std::move(result));
+    return absl::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<ExpressionStep> fallback_;
+  absl::optional<size_t> key_hash_;
+};
+
+template <typename Kernel>
+class DirectInlineAccessStep final : public DirectExpressionStep {
+ public:
+  DirectInlineAccessStep(int64_t expr_id,
+                         std::unique_ptr<DirectExpressionStep> lhs,
+                         std::unique_ptr<DirectExpressionStep> rhs,
+                         std::vector<cel::FunctionOverloadReference> overloads,
+                         absl::optional<size_t> key_hash)
+      : DirectExpressionStep(expr_id),
+        lhs_(std::move(lhs)),
+        rhs_(std::move(rhs)),
+        overloads_(std::move(overloads)),
+        key_hash_(key_hash) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& trail) const override {
+    Value args[kNumContainerAccessArguments];
+    AttributeTrail arg_trails[kNumContainerAccessArguments];
+    CEL_RETURN_IF_ERROR(lhs_->Evaluate(frame, args[0], arg_trails[0]));
+    CEL_RETURN_IF_ERROR(rhs_->Evaluate(frame, args[1], arg_trails[1]));
+
+    if (frame.unknown_processing_enabled()) {
+      for (int i = 0; i < kNumContainerAccessArguments; ++i) {
+        if (frame.attribute_utility().CheckForUnknown(arg_trails[i],
+                                                      /*use_partial=*/true)) {
+          args[i] = frame.attribute_utility().CreateUnknownSet(
+              arg_trails[i].attribute());
+        }
+      }
+    }
+
+    CEL_ASSIGN_OR_RETURN(
+        bool applied,
+        Kernel::Apply(frame, absl::MakeConstSpan(args), key_hash_, result));
+    if (applied) {
+      return absl::OkStatus();
+    }
+    CEL_ASSIGN_OR_RETURN(result, InvokeFunctionOverloads(
+                                     frame, expr_id_, Kernel::kName,
+                                     overloads_, absl::MakeConstSpan(args)));
+    return absl::OkStatus();
+  }
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{lhs_.get(), rhs_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.push_back(std::move(lhs_));
+    dependencies.push_back(std::move(rhs_));
+    return dependencies;
+  }
+
+ private:
+  std::unique_ptr<DirectExpressionStep> lhs_;
+  std::unique_ptr<DirectExpressionStep> rhs_;
+  std::vector<cel::FunctionOverloadReference> overloads_;
+  absl::optional<size_t> key_hash_;
+};
 
+absl::Status CheckInlineAccessCall(const cel::ast_internal::Call& call) {
+  int arg_count = call.args().size() + (call.has_target() ? 1 : 0);
+  if (arg_count != kNumContainerAccessArguments) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Invalid argument count for ", call.function(), ": ", arg_count));
+  }
   return absl::OkStatus();
 }
 
@@ -360,22 +854,73 @@ absl::Status DirectContainerAccessStep::Evaluate(ExecutionFrameBase& frame,
 std::unique_ptr<DirectExpressionStep> CreateDirectContainerAccessStep(
     std::unique_ptr<DirectExpressionStep> container_step,
     std::unique_ptr<DirectExpressionStep> key_step, bool enable_optional_types,
-    int64_t expr_id) {
+    int64_t expr_id, absl::optional<size_t> key_hash,
+    absl::optional<cel::ValueKind> map_key_kind) {
   return std::make_unique<DirectContainerAccessStep>(
       std::move(container_step), std::move(key_step), enable_optional_types,
-      expr_id);
+      expr_id, key_hash, map_key_kind);
 }
 
 // Factory method for Select - based Execution step
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateContainerAccessStep(
     const cel::ast_internal::Call& call, int64_t expr_id,
-    bool enable_optional_types) {
+    bool enable_optional_types, bool enable_attribute_tracking,
+    absl::optional<size_t> key_hash,
+    absl::optional<cel::ValueKind> map_key_kind) {
   int arg_count = call.args().size() + (call.has_target() ? 1 : 0);
   if (arg_count != kNumContainerAccessArguments) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Invalid argument count for index operation: ", arg_count));
   }
-  return std::make_unique<ContainerAccessStep>(expr_id, enable_optional_types);
+  if (!enable_attribute_tracking) {
+    return std::make_unique<ContainerAccessStep<false>>(
+        expr_id, enable_optional_types, key_hash, map_key_kind);
+  }
+  return std::make_unique<ContainerAccessStep<true>>(
+      expr_id, enable_optional_types, key_hash, map_key_kind);
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectOptionalContainerAccessStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> container_step,
+    std::unique_ptr<DirectExpressionStep> key_step,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash) {
+  return std::make_unique<DirectInlineAccessStep<OptionalIndexKernel>>(
+      expr_id, std::move(container_step), std::move(key_step),
+      std::move(overloads), key_hash);
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>>
+CreateOptionalContainerAccessStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash) {
+  CEL_RETURN_IF_ERROR(CheckInlineAccessCall(call));
+  CEL_ASSIGN_OR_RETURN(std::unique_ptr<ExpressionStep> fallback,
+                       CreateFunctionStep(call, expr_id, std::move(overloads)));
+  return std::make_unique<InlineAccessStep<OptionalIndexKernel>>(
+      expr_id, std::move(fallback), key_hash);
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectMapMembershipStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> key_step,
+    std::unique_ptr<DirectExpressionStep> container_step,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash) {
+  return std::make_unique<DirectInlineAccessStep<MapMembershipKernel>>(
+      expr_id, std::move(key_step), std::move(container_step),
+      std::move(overloads), key_hash);
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateMapMembershipStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash) {
+  CEL_RETURN_IF_ERROR(CheckInlineAccessCall(call));
+  CEL_ASSIGN_OR_RETURN(std::unique_ptr<ExpressionStep> fallback,
+                       CreateFunctionStep(call, expr_id, std::move(overloads)));
+  return std::make_unique<InlineAccessStep<MapMembershipKernel>>(
+      expr_id, std::move(fallback), key_hash);
 }
 
 }  // namespace google::api::expr::runtime
@@ -1,25 +1,91 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_CONTAINER_ACCESS_STEP_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_CONTAINER_ACCESS_STEP_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "base/ast_internal/expr.h"
+#include "common/value_kind.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "runtime/function_overload_reference.h"
 
 namespace google::api::expr::runtime {
 
+// If the key is a constant, `key_hash` may be its `cel::MapKeyHash`, which is
+// then used to look it up in maps instead of hashing it on every access.
+//
+// If the container was checked as a map, `map_key_kind` may be the kind of its
+// keys. With heterogeneous equality, numeric keys are then looked up in the
+// form of that kind only, in a single probe, instead of trying each of the
+// numeric kinds they convert to.
 std::unique_ptr<DirectExpressionStep> CreateDirectContainerAccessStep(
     std::unique_ptr<DirectExpressionStep> container_step,
     std::unique_ptr<DirectExpressionStep> key_step, bool enable_optional_types,
-    int64_t expr_id);
+    int64_t expr_id, absl::optional<size_t> key_hash = absl::nullopt,
+    absl::optional<cel::ValueKind> map_key_kind = absl::nullopt);
 
 // Factory method for Select - based Execution step
+//
+// If enable_attribute_tracking is false, the returned step never constructs
+// attribute trails. This is only valid if the program is evaluated with
+// unknown processing and missing attribute errors disabled.
+//
+// See `CreateDirectContainerAccessStep` for `key_hash` and `map_key_kind`.
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateContainerAccessStep(
     const cel::ast_internal::Call& call, int64_t expr_id,
-    bool enable_optional_types = false);
+    bool enable_optional_types = false, bool enable_attribute_tracking = true,
+    absl::optional<size_t> key_hash = absl::nullopt,
+    absl::optional<cel::ValueKind> map_key_kind = absl::nullopt);
+
+// Create a direct step for the optional index operator `container[?key]`.
+//
+// Maps, lists and optional containers are indexed inline, with the results of
+// the standard `_[?_]` overloads, instead of dispatching the call and
+// converting its arguments. Any other arguments, including errors and
+// unknowns, are dispatched to `overloads`, the overloads of the call's
+// function, exactly as the function step would.
+//
+// See `CreateDirectContainerAccessStep` for `key_hash`.
+std::unique_ptr<DirectExpressionStep> CreateDirectOptionalContainerAccessStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> container_step,
+    std::unique_ptr<DirectExpressionStep> key_step,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash = absl::nullopt);
+
+// Create a stack machine step for `container[?key]`, as for
+// `CreateDirectOptionalContainerAccessStep`.
+//
+// If unknown processing is enabled the stack machine step always dispatches
+// to `overloads`, since partial unknowns depend on the attribute trails.
+absl::StatusOr<std::unique_ptr<ExpressionStep>>
+CreateOptionalContainerAccessStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash = absl::nullopt);
+
+// Create a direct step for `key in container`, which tests maps for the key
+// inline with the results of the standard `@in` overloads for maps. Lists and
+// any other arguments are dispatched to `overloads`.
+//
+// See `CreateDirectContainerAccessStep` for `key_hash`.
+std::unique_ptr<DirectExpressionStep> CreateDirectMapMembershipStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> key_step,
+    std::unique_ptr<DirectExpressionStep> container_step,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash = absl::nullopt);
+
+// Create a stack machine step for `key in container`, as for
+// `CreateDirectMapMembershipStep`. Dispatches to `overloads` if unknown
+// processing is enabled.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateMapMembershipStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    absl::optional<size_t> key_hash = absl::nullopt);
 
 }  // namespace google::api::expr::runtime
 
@@ -505,6 +505,113 @@ TEST_F(ContainerAccessHeterogeneousLookupsTest, StringKeyUnaffected) {
   EXPECT_THAT(result, test::IsCelInt64(3));
 }
 
+// Evaluates `container[key]` planned with the checked kind of the map keys.
+CelValue EvaluateTypedMapLookup(google::protobuf::Arena* arena,
+                                CelValue container, CelValue key,
+                                cel::ValueKind map_key_kind,
+                                bool use_recursive_impl) {
+  ExecutionPath path;
+  cel::ast_internal::Call call;
+  call.set_function(cel::builtin::kIndex);
+  call.mutable_args().emplace_back().mutable_ident_expr().set_name(
+      "container");
+  call.mutable_args().emplace_back().mutable_ident_expr().set_name("key");
+  if (use_recursive_impl) {
+    path.push_back(std::make_unique<WrappedDirectStep>(
+        CreateDirectContainerAccessStep(
+            CreateDirectIdentStep("container", 1),
+            CreateDirectIdentStep("key", 2),
+            /*enable_optional_types=*/false, 3, /*key_hash=*/absl::nullopt,
+            map_key_kind),
+        3));
+  } else {
+    path.push_back(
+        std::move(CreateIdentStep(call.args()[0].ident_expr(), 1).value()));
+    path.push_back(
+        std::move(CreateIdentStep(call.args()[1].ident_expr(), 2).value()));
+    path.push_back(std::move(
+        CreateContainerAccessStep(call, 3, /*enable_optional_types=*/false,
+                                  /*enable_attribute_tracking=*/true,
+                                  /*key_hash=*/absl::nullopt, map_key_kind)
+            .value()));
+  }
+  cel::RuntimeOptions options;
+  options.enable_heterogeneous_equality = true;
+  CelExpressionFlatImpl cel_expr(
+      FlatExpression(std::move(path), /*comprehension_slot_count=*/0,
+                     TypeProvider::Builtin(), options));
+  Activation activation;
+  activation.InsertValue("container", container);
+  activation.InsertValue("key", key);
+  return *cel_expr.Evaluate(activation, arena);
+}
+
+TEST_F(ContainerAccessHeterogeneousLookupsTest, TypedMapKeys) {
+  CelMapBuilder int_map;
+  ASSERT_OK(int_map.Add(CelValue::CreateInt64(1), CelValue::CreateInt64(2)));
+  CelMapBuilder uint_map;
+  ASSERT_OK(
+      uint_map.Add(CelValue::CreateUint64(1), CelValue::CreateUint64(3)));
+  for (bool use_recursive_impl : {false, true}) {
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&int_map),
+                                       CelValue::CreateDouble(1.0),
+                                       cel::ValueKind::kInt64,
+                                       use_recursive_impl),
+                test::IsCelInt64(2));
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&int_map),
+                                       CelValue::CreateUint64(1),
+                                       cel::ValueKind::kInt64,
+                                       use_recursive_impl),
+                test::IsCelInt64(2));
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&int_map),
+                                       CelValue::CreateInt64(3),
+                                       cel::ValueKind::kInt64,
+                                       use_recursive_impl),
+                test::IsCelError(_));
+    EXPECT_THAT(
+        EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&uint_map),
+                               CelValue::CreateInt64(1),
+                               cel::ValueKind::kUint64, use_recursive_impl),
+        test::IsCelUint64(3));
+    EXPECT_THAT(
+        EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&uint_map),
+                               CelValue::CreateDouble(1.5),
+                               cel::ValueKind::kUint64, use_recursive_impl),
+        test::IsCelError(_));
+  }
+}
+
+TEST_F(ContainerAccessHeterogeneousLookupsTest, TypedMapKeysMismatchedMap) {
+  // The runtime maps don't hold keys of the declared kind.
+  CelMapBuilder uint_map;
+  ASSERT_OK(
+      uint_map.Add(CelValue::CreateUint64(1), CelValue::CreateUint64(3)));
+  CelMapBuilder int_map;
+  ASSERT_OK(int_map.Add(CelValue::CreateInt64(1), CelValue::CreateInt64(2)));
+  for (bool use_recursive_impl : {false, true}) {
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&uint_map),
+                                       CelValue::CreateInt64(1),
+                                       cel::ValueKind::kInt64,
+                                       use_recursive_impl),
+                test::IsCelUint64(3));
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&int_map),
+                                       CelValue::CreateDouble(1.0),
+                                       cel::ValueKind::kUint64,
+                                       use_recursive_impl),
+                test::IsCelInt64(2));
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&int_map),
+                                       CelValue::CreateInt64(1),
+                                       cel::ValueKind::kString,
+                                       use_recursive_impl),
+                test::IsCelInt64(2));
+    EXPECT_THAT(EvaluateTypedMapLookup(&arena_, CelValue::CreateMap(&uint_map),
+                                       CelValue::CreateInt64(2),
+                                       cel::ValueKind::kInt64,
+                                       use_recursive_impl),
+                test::IsCelError(_));
+  }
+}
+
 class ContainerAccessHeterogeneousLookupsDisabledTest : public testing::Test {
  public:
   ContainerAccessHeterogeneousLookupsDisabledTest() {
@@ -12,12 +12,15 @@
 #include "absl/types/optional.h"
 #include "base/ast_internal/expr.h"
 #include "common/casting.h"
+#include "common/native_type.h"
 #include "common/value.h"
+#include "common/values/contiguous_list_value.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/attribute_utility.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
+#include "internal/casts.h"
 #include "internal/status_macros.h"
 #include "runtime/internal/mutable_list_impl.h"
 
@@ -43,6 +46,14 @@ class CreateListStep : public ExpressionStepBase {
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
 
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<CreateListStep>();
+  }
+
+  int list_size() const { return list_size_; }
+
+  bool has_optional_elements() const { return !optional_indices_.empty(); }
+
  private:
   int list_size_;
   absl::flat_hash_set<int32_t> optional_indices_;
@@ -83,9 +94,8 @@ absl::Status CreateListStep::Evaluate(ExecutionFrame* frame) const {
     }
   }
 
-  CEL_ASSIGN_OR_RETURN(auto builder,
-                       frame->value_manager().NewListValueBuilder(
-                           frame->value_manager().GetDynListType()));
+  CEL_ASSIGN_OR_RETURN(auto builder, cel::NewContiguousListValueBuilder(
+                                         frame->value_manager()));
 
   builder->Reserve(args.size());
   for (size_t i = 0; i < args.size(); ++i) {
@@ -106,7 +116,7 @@ absl::Status CreateListStep::Evaluate(ExecutionFrame* frame) const {
   }
 
   frame->value_stack().PopAndPush(list_size_, std::move(*builder).Build());
-  return absl::OkStatus();
+  return frame->CheckMemoryBudget();
 }
 
 absl::flat_hash_set<int32_t> MakeOptionalIndicesSet(
@@ -131,9 +141,8 @@ class CreateListDirectStep : public DirectExpressionStep {
 
   absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
                         AttributeTrail& attribute_trail) const override {
-    CEL_ASSIGN_OR_RETURN(auto builder,
-                         frame.value_manager().NewListValueBuilder(
-                             frame.value_manager().GetDynListType()));
+    CEL_ASSIGN_OR_RETURN(auto builder, cel::NewContiguousListValueBuilder(
+                                           frame.value_manager()));
 
     builder->Reserve(elements_.size());
     AttributeUtility::Accumulator unknowns =
@@ -191,7 +200,7 @@ class CreateListDirectStep : public DirectExpressionStep {
     }
     result = std::move(*builder).Build();
 
-    return absl::OkStatus();
+    return frame.CheckMemoryBudget();
   }
 
  private:
@@ -207,9 +216,8 @@ class MutableListStep : public ExpressionStepBase {
 };
 
 absl::Status MutableListStep::Evaluate(ExecutionFrame* frame) const {
-  CEL_ASSIGN_OR_RETURN(auto builder,
-                       frame->value_manager().NewListValueBuilder(
-                           frame->value_manager().GetDynListType()));
+  CEL_ASSIGN_OR_RETURN(auto builder, cel::NewContiguousListValueBuilder(
+                                         frame->value_manager()));
 
   frame->value_stack().Push(cel::OpaqueValue{
       frame->value_manager().GetMemoryManager().MakeShared<MutableListValue>(
@@ -229,9 +237,8 @@ class DirectMutableListStep : public DirectExpressionStep {
 absl::Status DirectMutableListStep::Evaluate(
     ExecutionFrameBase& frame, Value& result,
     AttributeTrail& attribute_trail) const {
-  CEL_ASSIGN_OR_RETURN(auto builder,
-                       frame.value_manager().NewListValueBuilder(
-                           frame.value_manager().GetDynListType()));
+  CEL_ASSIGN_OR_RETURN(auto builder, cel::NewContiguousListValueBuilder(
+                                         frame.value_manager()));
 
   result = cel::OpaqueValue{
       frame.value_manager().GetMemoryManager().MakeShared<MutableListValue>(
@@ -259,6 +266,18 @@ std::unique_ptr<ExpressionStep> CreateMutableListStep(int64_t expr_id) {
   return std::make_unique<MutableListStep>(expr_id);
 }
 
+absl::optional<int> GetCreateListStepSize(const ExpressionStep& step) {
+  if (step.GetNativeTypeId() != cel::NativeTypeId::For<CreateListStep>()) {
+    return absl::nullopt;
+  }
+  const auto& create_list =
+      cel::internal::down_cast<const CreateListStep&>(step);
+  if (create_list.has_optional_elements()) {
+    return absl::nullopt;
+  }
+  return create_list.list_size();
+}
+
 std::unique_ptr<DirectExpressionStep> CreateDirectMutableListStep(
     int64_t expr_id) {
   return std::make_unique<DirectMutableListStep>(expr_id);
@@ -7,6 +7,7 @@
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "base/ast_internal/expr.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
@@ -28,6 +29,10 @@ absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateCreateListStep(
 // list-building comprehension (rather than a user authored expression).
 std::unique_ptr<ExpressionStep> CreateMutableListStep(int64_t expr_id);
 
+// Returns the number of elements of `step` if it was created by
+// `CreateCreateListStep` for a list without optional elements.
+absl::optional<int> GetCreateListStepSize(const ExpressionStep& step);
+
 // Factory method for CreateList which constructs a mutable list.
 //
 // This is intended for the list construction step is generated for a
@@ -8,6 +8,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "base/ast_internal/expr.h"
 #include "base/attribute.h"
 #include "base/attribute_set.h"
@@ -16,6 +17,7 @@
 #include "common/memory.h"
 #include "common/value.h"
 #include "common/value_testing.h"
+#include "common/values/contiguous_list_value.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/cel_expression_flat_impl.h"
 #include "eval/eval/const_value_step.h"
@@ -45,14 +47,17 @@ using ::cel::ErrorValue;
 using ::cel::InstanceOf;
 using ::cel::IntValue;
 using ::cel::ListValue;
+using ::cel::StringValue;
 using ::cel::TypeProvider;
 using ::cel::UnknownValue;
 using ::cel::Value;
 using ::cel::ast_internal::Expr;
 using ::cel::test::IntValueIs;
+using testing::ElementsAre;
 using testing::Eq;
 using testing::HasSubstr;
 using testing::Not;
+using testing::Optional;
 using testing::UnorderedElementsAre;
 using cel::internal::IsOk;
 using cel::internal::IsOkAndHolds;
@@ -275,6 +280,40 @@ TEST(CreateDirectListStep, Basic) {
   EXPECT_THAT(Cast<ListValue>(result).Size(), IsOkAndHolds(2));
 }
 
+TEST(CreateDirectListStep, ContiguousElements) {
+  cel::ManagedValueFactory value_factory(
+      cel::TypeProvider::Builtin(), cel::MemoryManagerRef::ReferenceCounting());
+
+  cel::Activation activation;
+  cel::RuntimeOptions options;
+
+  ExecutionFrameBase frame(activation, options, value_factory.get());
+
+  std::vector<std::unique_ptr<DirectExpressionStep>> deps;
+  deps.push_back(CreateConstValueDirectStep(IntValue(1), -1));
+  deps.push_back(CreateConstValueDirectStep(IntValue(2), -1));
+  auto ints = CreateDirectListStep(std::move(deps), {}, -1);
+
+  deps.clear();
+  deps.push_back(CreateConstValueDirectStep(IntValue(1), -1));
+  deps.push_back(CreateConstValueDirectStep(StringValue("two"), -1));
+  auto mixed = CreateDirectListStep(std::move(deps), {}, -1);
+
+  cel::Value result;
+  AttributeTrail attr;
+
+  ASSERT_OK(ints->Evaluate(frame, result, attr));
+  ASSERT_TRUE(InstanceOf<ListValue>(result));
+  EXPECT_THAT(cel::AsContiguousList<cel::IntListValue>(Cast<ListValue>(result)),
+              Optional(ElementsAre(1, 2)));
+
+  ASSERT_OK(mixed->Evaluate(frame, result, attr));
+  ASSERT_TRUE(InstanceOf<ListValue>(result));
+  EXPECT_THAT(Cast<ListValue>(result).Size(), IsOkAndHolds(2));
+  EXPECT_EQ(cel::AsContiguousList<cel::IntListValue>(Cast<ListValue>(result)),
+            absl::nullopt);
+}
+
 TEST(CreateDirectListStep, ForwardFirstError) {
   cel::ManagedValueFactory value_factory(
       cel::TypeProvider::Builtin(), cel::MemoryManagerRef::ReferenceCounting());
@@ -123,7 +123,7 @@ absl::Status CreateStructStepForMap::Evaluate(ExecutionFrame* frame) const {
 
   frame->value_stack().PopAndPush(2 * entry_count_, std::move(result));
 
-  return absl::OkStatus();
+  return frame->CheckMemoryBudget();
 }
 
 class DirectCreateMapStep : public DirectExpressionStep {
@@ -231,7 +231,7 @@ absl::Status DirectCreateMapStep::Evaluate(
   }
 
   result = std::move(*builder).Build();
-  return absl::OkStatus();
+  return frame.CheckMemoryBudget();
 }
 
 }  // namespace
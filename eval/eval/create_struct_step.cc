@@ -14,6 +14,8 @@
 
 #include "eval/eval/create_struct_step.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -46,16 +48,52 @@ using ::cel::InstanceOf;
 using ::cel::StructValueBuilderInterface;
 using ::cel::UnknownValue;
 using ::cel::Value;
+using ::cel::ValueBuilder;
+
+// Sets the fields of a struct being created, by the field numbers resolved at
+// plan time where available.
+class StructFieldSetter {
+ public:
+  StructFieldSetter(std::vector<std::string> names,
+                    std::vector<int64_t> numbers)
+      : names_(std::move(names)),
+        numbers_(std::move(numbers)),
+        set_by_number_(!numbers_.empty()) {
+    numbers_.resize(names_.size());
+  }
+
+  size_t size() const { return names_.size(); }
+
+  absl::Status Set(ValueBuilder& builder, size_t index, Value value) const {
+    if (numbers_[index] > 0 && set_by_number_.load(std::memory_order_relaxed)) {
+      absl::Status status = builder.SetFieldByNumber(numbers_[index], value);
+      if (!absl::IsUnimplemented(status)) {
+        return status;
+      }
+      // Some legacy builders only support setting fields by name. The type of
+      // the created struct is fixed, so the others are set by name too.
+      set_by_number_.store(false, std::memory_order_relaxed);
+    }
+    return builder.SetFieldByName(names_[index], std::move(value));
+  }
+
+ private:
+  std::vector<std::string> names_;
+  // Zero where the number is unknown.
+  std::vector<int64_t> numbers_;
+  mutable std::atomic<bool> set_by_number_;
+};
 
 // `CreateStruct` implementation for message/struct.
 class CreateStructStepForStruct final : public ExpressionStepBase {
  public:
   CreateStructStepForStruct(int64_t expr_id, std::string name,
                             std::vector<std::string> entries,
-                            absl::flat_hash_set<int32_t> optional_indices)
+                            absl::flat_hash_set<int32_t> optional_indices,
+                            std::vector<int64_t> field_numbers)
       : ExpressionStepBase(expr_id),
         name_(std::move(name)),
-        entries_(std::move(entries)),
+        entries_(std::move(entries), std::move(field_numbers)),
         optional_indices_(std::move(optional_indices)) {}
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
@@ -64,7 +102,7 @@ class CreateStructStepForStruct final : public ExpressionStepBase {
   absl::StatusOr<Value> DoEvaluate(ExecutionFrame* frame) const;
 
   std::string name_;
-  std::vector<std::string> entries_;
+  StructFieldSetter entries_;
   absl::flat_hash_set<int32_t> optional_indices_;
 };
 
@@ -95,18 +133,16 @@ absl::StatusOr<Value> CreateStructStepForStruct::DoEvaluate(
   auto builder = std::move(*maybe_builder);
 
   for (int i = 0; i < entries_size; ++i) {
-    const auto& entry = entries_[i];
     auto& arg = args[i];
     if (optional_indices_.contains(static_cast<int32_t>(i))) {
       if (auto optional_arg = cel::As<cel::OptionalValue>(arg); optional_arg) {
         if (!optional_arg->HasValue()) {
           continue;
         }
-        CEL_RETURN_IF_ERROR(
-            builder->SetFieldByName(entry, optional_arg->Value()));
+        CEL_RETURN_IF_ERROR(entries_.Set(*builder, i, optional_arg->Value()));
       }
     } else {
-      CEL_RETURN_IF_ERROR(builder->SetFieldByName(entry, std::move(arg)));
+      CEL_RETURN_IF_ERROR(entries_.Set(*builder, i, std::move(arg)));
     }
   }
 
@@ -135,10 +171,11 @@ class DirectCreateStructStep : public DirectExpressionStep {
   DirectCreateStructStep(
       int64_t expr_id, std::string name, std::vector<std::string> field_keys,
       std::vector<std::unique_ptr<DirectExpressionStep>> deps,
-      absl::flat_hash_set<int32_t> optional_indices)
+      absl::flat_hash_set<int32_t> optional_indices,
+      std::vector<int64_t> field_numbers)
       : DirectExpressionStep(expr_id),
         name_(std::move(name)),
-        field_keys_(std::move(field_keys)),
+        field_keys_(std::move(field_keys), std::move(field_numbers)),
         deps_(std::move(deps)),
         optional_indices_(std::move(optional_indices)) {}
 
@@ -147,7 +184,7 @@ class DirectCreateStructStep : public DirectExpressionStep {
 
  private:
   std::string name_;
-  std::vector<std::string> field_keys_;
+  StructFieldSetter field_keys_;
   std::vector<std::unique_ptr<DirectExpressionStep>> deps_;
   absl::flat_hash_set<int32_t> optional_indices_;
 };
@@ -201,8 +238,7 @@ absl::Status DirectCreateStructStep::Evaluate(ExecutionFrameBase& frame,
         if (!optional_arg->HasValue()) {
           continue;
         }
-        auto status =
-            builder->SetFieldByName(field_keys_[i], optional_arg->Value());
+        auto status = field_keys_.Set(*builder, i, optional_arg->Value());
         if (!status.ok()) {
           result = frame.value_manager().CreateErrorValue(std::move(status));
           return absl::OkStatus();
@@ -211,8 +247,7 @@ absl::Status DirectCreateStructStep::Evaluate(ExecutionFrameBase& frame,
       continue;
     }
 
-    auto status =
-        builder->SetFieldByName(field_keys_[i], std::move(field_value));
+    auto status = field_keys_.Set(*builder, i, std::move(field_value));
     if (!status.ok()) {
       result = frame.value_manager().CreateErrorValue(std::move(status));
       return absl::OkStatus();
@@ -233,18 +268,20 @@ absl::Status DirectCreateStructStep::Evaluate(ExecutionFrameBase& frame,
 std::unique_ptr<DirectExpressionStep> CreateDirectCreateStructStep(
     std::string resolved_name, std::vector<std::string> field_keys,
     std::vector<std::unique_ptr<DirectExpressionStep>> deps,
-    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id) {
+    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id,
+    std::vector<int64_t> field_numbers) {
   return std::make_unique<DirectCreateStructStep>(
       expr_id, std::move(resolved_name), std::move(field_keys), std::move(deps),
-      std::move(optional_indices));
+      std::move(optional_indices), std::move(field_numbers));
 }
 
 std::unique_ptr<ExpressionStep> CreateCreateStructStep(
     std::string name, std::vector<std::string> field_keys,
-    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id) {
+    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id,
+    std::vector<int64_t> field_numbers) {
   // MakeOptionalIndicesSet(create_struct_expr)
   return std::make_unique<CreateStructStepForStruct>(
       expr_id, std::move(name), std::move(field_keys),
-      std::move(optional_indices));
+      std::move(optional_indices), std::move(field_numbers));
 }
 }  // namespace google::api::expr::runtime
@@ -28,16 +28,23 @@ namespace google::api::expr::runtime {
 
 // Creates an `ExpressionStep` which performs `CreateStruct` for a
 // message/struct.
+//
+// `field_numbers`, if not empty, holds the numbers of the fields in
+// `field_keys` resolved at plan time, or 0 where unknown. Fields with a number
+// are set by number, which avoids looking them up by name on every
+// evaluation, unless the type's builder doesn't support it.
 std::unique_ptr<DirectExpressionStep> CreateDirectCreateStructStep(
     std::string name, std::vector<std::string> field_keys,
     std::vector<std::unique_ptr<DirectExpressionStep>> deps,
-    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id);
+    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id,
+    std::vector<int64_t> field_numbers = {});
 
 // Creates an `ExpressionStep` which performs `CreateStruct` for a
 // message/struct.
 std::unique_ptr<ExpressionStep> CreateCreateStructStep(
     std::string name, std::vector<std::string> field_keys,
-    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id);
+    absl::flat_hash_set<int32_t> optional_indices, int64_t expr_id,
+    std::vector<int64_t> field_numbers = {});
 
 }  // namespace google::api::expr::runtime
 
@@ -66,7 +66,8 @@ using testing::IsNull;
 using testing::Not;
 using testing::Pointwise;
 
-absl::StatusOr<ExecutionPath> MakeStackMachinePath(absl::string_view field) {
+absl::StatusOr<ExecutionPath> MakeStackMachinePath(absl::string_view field,
+                                                   int64_t field_number) {
   ExecutionPath path;
   Expr expr0;
 
@@ -78,7 +79,7 @@ absl::StatusOr<ExecutionPath> MakeStackMachinePath(absl::string_view field) {
                                       {std::string(field)},
                                       /*optional_indices=*/{},
 
-                                      /*id=*/-1);
+                                      /*id=*/-1, {field_number});
 
   path.push_back(std::move(step0));
   path.push_back(std::move(step1));
@@ -86,7 +87,8 @@ absl::StatusOr<ExecutionPath> MakeStackMachinePath(absl::string_view field) {
   return path;
 }
 
-absl::StatusOr<ExecutionPath> MakeRecursivePath(absl::string_view field) {
+absl::StatusOr<ExecutionPath> MakeRecursivePath(absl::string_view field,
+                                                int64_t field_number) {
   ExecutionPath path;
 
   std::vector<std::unique_ptr<DirectExpressionStep>> deps;
@@ -97,7 +99,7 @@ absl::StatusOr<ExecutionPath> MakeRecursivePath(absl::string_view field) {
                                    {std::string(field)}, std::move(deps),
                                    /*optional_indices=*/{},
 
-                                   /*id=*/-1);
+                                   /*id=*/-1, {field_number});
 
   path.push_back(std::make_unique<WrappedDirectStep>(std::move(step1), -1));
 
@@ -105,12 +107,14 @@ absl::StatusOr<ExecutionPath> MakeRecursivePath(absl::string_view field) {
 }
 
 // Helper method. Creates simple pipeline containing CreateStruct step that
-// builds message and runs it.
+// builds message and runs it. The field is set by name unless `field_number`
+// is given.
 absl::StatusOr<CelValue> RunExpression(absl::string_view field,
                                        const CelValue& value,
                                        google::protobuf::Arena* arena,
                                        bool enable_unknowns,
-                                       bool enable_recursive_planning) {
+                                       bool enable_recursive_planning,
+                                       int64_t field_number = 0) {
   CelTypeRegistry type_registry;
   type_registry.RegisterTypeProvider(
       std::make_unique<ProtobufDescriptorProvider>(
@@ -135,9 +139,9 @@ absl::StatusOr<CelValue> RunExpression(absl::string_view field,
   ExecutionPath path;
 
   if (enable_recursive_planning) {
-    CEL_ASSIGN_OR_RETURN(path, MakeRecursivePath(field));
+    CEL_ASSIGN_OR_RETURN(path, MakeRecursivePath(field, field_number));
   } else {
-    CEL_ASSIGN_OR_RETURN(path, MakeStackMachinePath(field));
+    CEL_ASSIGN_OR_RETURN(path, MakeStackMachinePath(field, field_number));
   }
 
   CelExpressionFlatImpl cel_expr(
@@ -284,6 +288,28 @@ TEST_P(CreateCreateStructStepTest, TestSetBoolField) {
   ASSERT_EQ(test_msg.bool_value(), true);
 }
 
+TEST_P(CreateCreateStructStepTest, TestSetFieldByNumber) {
+  Arena arena;
+
+  ASSERT_OK_AND_ASSIGN(
+      CelValue result,
+      RunExpression("int64_value", CelValue::CreateInt64(2), &arena,
+                    enable_unknowns(), enable_recursive_planning(),
+                    TestMessage::kInt64ValueFieldNumber));
+  ASSERT_TRUE(result.IsMessage()) << result.DebugString();
+  TestMessage test_msg;
+  test_msg.MergeFrom(*result.MessageOrDie());
+  EXPECT_EQ(test_msg.int64_value(), 2);
+
+  // Type errors are reported as when setting the field by name.
+  ASSERT_OK_AND_ASSIGN(
+      result, RunExpression("int64_value", CelValue::CreateStringView("2"),
+                            &arena, enable_unknowns(),
+                            enable_recursive_planning(),
+                            TestMessage::kInt64ValueFieldNumber));
+  EXPECT_TRUE(result.IsError()) << result.DebugString();
+}
+
 // Test that fields of type int32_t are set correctly
 TEST_P(CreateCreateStructStepTest, TestSetInt32Field) {
   Arena arena;
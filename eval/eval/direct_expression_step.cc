@@ -15,18 +15,33 @@
 
 #include <utility>
 
+#include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "common/value.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/evaluator_core.h"
-#include "internal/status_macros.h"
 
 namespace google::api::expr::runtime {
 
+bool DirectExpressionStep::EvaluateFast(ExecutionFrameBase& frame,
+                                        cel::Value& result,
+                                        AttributeTrail& attribute,
+                                        absl::Status& status) const {
+  absl::Status evaluate_status = Evaluate(frame, result, attribute);
+  if (ABSL_PREDICT_FALSE(!evaluate_status.ok())) {
+    status = std::move(evaluate_status);
+    return false;
+  }
+  return true;
+}
+
 absl::Status WrappedDirectStep::Evaluate(ExecutionFrame* frame) const {
   cel::Value result;
   AttributeTrail attribute_trail;
-  CEL_RETURN_IF_ERROR(impl_->Evaluate(*frame, result, attribute_trail));
+  absl::Status status;
+  if (!impl_->EvaluateFast(*frame, result, attribute_trail, status)) {
+    return status;
+  }
   frame->value_stack().Push(std::move(result), std::move(attribute_trail));
   return absl::OkStatus();
 }
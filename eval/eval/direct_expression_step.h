@@ -14,17 +14,20 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_DIRECT_EXPRESSION_STEP_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_DIRECT_EXPRESSION_STEP_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "absl/types/optional.h"
 #include "common/native_type.h"
 #include "common/value.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/evaluator_core.h"
+#include "eval/eval/step_arena.h"
 
 namespace google::api::expr::runtime {
 
@@ -43,12 +46,27 @@ class DirectExpressionStep {
 
   virtual ~DirectExpressionStep() = default;
 
+  // Allocated like the stack machine steps, see `ExpressionStep`.
+  static void* operator new(size_t size) { return AllocateStep(size); }
+  static void operator delete(void* step) noexcept { DeallocateStep(step); }
+
   int64_t expr_id() const { return expr_id_; }
   bool comes_from_ast() const { return expr_id_ >= 0; }
 
   virtual absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
                                 AttributeTrail& attribute) const = 0;
 
+  // Evaluates like `Evaluate`, but reports success as `true` instead of an OK
+  // `absl::Status`, so the recursive planner's hot path does not construct and
+  // test a status per node. On failure returns `false` and assigns the error
+  // to `status`, which is otherwise left untouched.
+  //
+  // The default wraps `Evaluate`. Core steps override it, see
+  // `FastDirectExpressionStep`, and evaluate their dependencies through it.
+  virtual bool EvaluateFast(ExecutionFrameBase& frame, cel::Value& result,
+                            AttributeTrail& attribute,
+                            absl::Status& status) const;
+
   // Return a type id for this node.
   //
   // Users must not make any assumptions about the type if the default value is
@@ -76,6 +94,26 @@ class DirectExpressionStep {
   int64_t expr_id_;
 };
 
+// Base for direct steps implemented by `EvaluateFast`, which `Evaluate`
+// forwards to.
+class FastDirectExpressionStep : public DirectExpressionStep {
+ public:
+  using DirectExpressionStep::DirectExpressionStep;
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
+                        AttributeTrail& attribute) const final {
+    absl::Status status;
+    if (ABSL_PREDICT_FALSE(!EvaluateFast(frame, result, attribute, status))) {
+      return status;
+    }
+    return absl::OkStatus();
+  }
+
+  bool EvaluateFast(ExecutionFrameBase& frame, cel::Value& result,
+                    AttributeTrail& attribute,
+                    absl::Status& status) const override = 0;
+};
+
 // Wrapper for direct steps to work with the stack machine impl.
 class WrappedDirectStep : public ExpressionStep {
  public:
@@ -15,6 +15,7 @@
 #include "eval/eval/evaluator_core.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
 
@@ -24,14 +25,19 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/utility/utility.h"
 #include "base/type_provider.h"
 #include "common/memory.h"
+#include "common/type_introspector.h"
+#include "common/types/thread_safe_type_manager.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "runtime/activation_interface.h"
 #include "runtime/managed_value_factory.h"
+#include "runtime/program_metrics.h"
 
 namespace google::api::expr::runtime {
 
@@ -57,6 +63,18 @@ void FlatExpressionEvaluatorState::Reset() {
   comprehension_slots_.Reset();
 }
 
+void FlatExpressionEvaluatorState::Rebind(cel::ValueManager& value_factory) {
+  managed_value_factory_.reset();
+  value_factory_ = &value_factory;
+}
+
+void FlatExpressionEvaluatorState::Rebind(
+    const cel::TypeProvider& type_provider,
+    cel::MemoryManagerRef memory_manager) {
+  managed_value_factory_.emplace(type_provider, memory_manager);
+  value_factory_ = &managed_value_factory_->get();
+}
+
 const ExpressionStep* ExecutionFrame::Next() {
   while (true) {
     const size_t end_pos = execution_path_.size();
@@ -66,22 +84,28 @@ const ExpressionStep* ExecutionFrame::Next() {
       ABSL_ASSUME(step != nullptr);
       return step;
     }
-    if (ABSL_PREDICT_TRUE(pc_ == end_pos)) {
-      if (!call_stack_.empty()) {
-        pc_ = call_stack_.back().return_pc;
-        execution_path_ = call_stack_.back().return_expression;
-        ABSL_DCHECK_EQ(value_stack().size(),
-                       call_stack_.back().expected_stack_size);
-        call_stack_.pop_back();
-        continue;
-      }
-    } else {
-      ABSL_LOG(ERROR) << "Attempting to step beyond the end of execution path.";
+    if (ReturnFromSubexpression()) {
+      continue;
     }
     return nullptr;
   }
 }
 
+bool ExecutionFrame::ReturnFromSubexpression() {
+  if (ABSL_PREDICT_FALSE(pc_ != execution_path_.size())) {
+    ABSL_LOG(ERROR) << "Attempting to step beyond the end of execution path.";
+    return false;
+  }
+  if (call_stack_.empty()) {
+    return false;
+  }
+  pc_ = call_stack_.back().return_pc;
+  execution_path_ = call_stack_.back().return_expression;
+  ABSL_DCHECK_EQ(value_stack().size(), call_stack_.back().expected_stack_size);
+  call_stack_.pop_back();
+  return true;
+}
+
 namespace {
 
 // This class abuses the fact that `absl::Status` is trivially destructible when
@@ -123,21 +147,41 @@ absl::StatusOr<cel::Value> ExecutionFrame::Evaluate(
     EvaluationListener& listener) {
   const size_t initial_stack_size = value_stack().size();
 
-  if (!listener) {
-    for (const ExpressionStep* expr = Next();
-         ABSL_PREDICT_TRUE(expr != nullptr); expr = Next()) {
-      if (EvaluationStatus status(expr->Evaluate(this)); !status.ok()) {
-        return std::move(status).Consume();
-      }
+  if (ABSL_PREDICT_FALSE(interruptible())) {
+    // Fail evaluations which are cancelled or past their deadline before they
+    // start, rather than after their first kInterruptCheckInterval steps.
+    if (absl::Status status = CheckInterruptsNow(); !status.ok()) {
+      return status;
     }
+  }
+
+  if (!listener && !interruptible()) {
+    // Dispatch directly over the current subexpression's steps. The call stack
+    // is only consulted when the end of a subexpression is reached, keeping
+    // the per-step overhead to a bounds check and the virtual call.
+    //
+    // Steps may change the program counter (jumps) or the current
+    // subexpression (calls), so both are re-read on every iteration.
+    do {
+      while (ABSL_PREDICT_TRUE(pc_ < execution_path_.size())) {
+        const ExpressionStep* expr = execution_path_[pc_++].get();
+        ABSL_ASSUME(expr != nullptr);
+        if (EvaluationStatus status(expr->Evaluate(this)); !status.ok()) {
+          return std::move(status).Consume();
+        }
+      }
+    } while (ReturnFromSubexpression());
   } else {
     for (const ExpressionStep* expr = Next();
          ABSL_PREDICT_TRUE(expr != nullptr); expr = Next()) {
       if (EvaluationStatus status(expr->Evaluate(this)); !status.ok()) {
         return std::move(status).Consume();
       }
+      if (EvaluationStatus status(CheckInterrupts()); !status.ok()) {
+        return std::move(status).Consume();
+      }
 
-      if (!expr->comes_from_ast()) {
+      if (!listener || !expr->comes_from_ast()) {
         continue;
       }
 
@@ -162,6 +206,11 @@ absl::StatusOr<cel::Value> ExecutionFrame::Evaluate(
         ", actual=", final_stack_size));
   }
 
+  if (absl::Status status = CheckMemoryBudget();
+      ABSL_PREDICT_FALSE(!status.ok())) {
+    return status;
+  }
+
   cel::Value value = std::move(value_stack().Peek());
   value_stack().Pop(1);
   return value;
@@ -182,17 +231,78 @@ FlatExpressionEvaluatorState FlatExpression::MakeEvaluatorState(
 absl::StatusOr<cel::Value> FlatExpression::EvaluateWithCallback(
     const cel::ActivationInterface& activation, EvaluationListener listener,
     FlatExpressionEvaluatorState& state) const {
+  if (listener && traced_expression_ != nullptr) {
+    return traced_expression_->EvaluateWithMetrics(
+        activation, std::move(listener), state, metrics_.get());
+  }
+  return EvaluateWithMetrics(activation, std::move(listener), state,
+                             metrics_.get());
+}
+
+absl::StatusOr<cel::Value> FlatExpression::EvaluateWithMetrics(
+    const cel::ActivationInterface& activation, EvaluationListener listener,
+    FlatExpressionEvaluatorState& state,
+    absl::Nullable<cel::ProgramMetrics*> metrics) const {
   state.Reset();
 
   ExecutionFrame frame(subexpressions_, activation, options_, state,
                        std::move(listener));
 
+  if (ABSL_PREDICT_TRUE(metrics == nullptr)) {
+    return frame.Evaluate(frame.callback());
+  }
+  const int64_t start_nanos = absl::GetCurrentTimeNanos();
+  absl::StatusOr<cel::Value> result = frame.Evaluate(frame.callback());
+  RecordEvaluation(*metrics, start_nanos, result.status(),
+                   result.ok() ? *result : cel::Value(), frame);
+  return result;
+}
+
+absl::StatusOr<cel::Value> FlatExpression::EvaluateIncrementally(
+    const cel::ActivationInterface& activation, IncrementalCache& cache,
+    FlatExpressionEvaluatorState& state) const {
+  state.Reset();
+
+  ExecutionFrame frame(subexpressions_, activation, options_, state);
+  frame.set_incremental_cache(&cache);
+
   return frame.Evaluate(frame.callback());
 }
 
+void RecordEvaluation(cel::ProgramMetrics& metrics, int64_t start_nanos,
+                      const absl::Status& status, const cel::Value& result,
+                      const ExecutionFrameBase& frame) {
+  using Outcome = cel::ProgramMetrics::Outcome;
+  Outcome outcome = Outcome::kValue;
+  if (!status.ok()) {
+    outcome = Outcome::kFailure;
+  } else if (result.Is<cel::ErrorValue>()) {
+    outcome = Outcome::kError;
+  } else if (result.Is<cel::UnknownValue>()) {
+    outcome = Outcome::kUnknown;
+  }
+  metrics.Record(outcome,
+                 absl::Nanoseconds(absl::GetCurrentTimeNanos() - start_nanos),
+                 static_cast<uint64_t>(frame.iterations()),
+                 frame.allocated_bytes().value_or(0));
+}
+
 cel::ManagedValueFactory FlatExpression::MakeValueFactory(
     cel::MemoryManagerRef memory_manager) const {
-  return cel::ManagedValueFactory(type_provider_, memory_manager);
+  return cel::ManagedValueFactory(type_provider_, memory_manager,
+                                  interned_types_.operator->());
+}
+
+cel::Shared<cel::common_internal::ThreadSafeTypeManager>
+FlatExpression::NewInternedTypes() {
+  // The interned types outlive the evaluations creating them, so they are
+  // reference counted regardless of the memory manager of the evaluation.
+  // Their introspector is never consulted, the evaluations' value managers
+  // look types up with the type provider of the expression instead.
+  cel::MemoryManagerRef memory_manager =
+      cel::MemoryManagerRef::ReferenceCounting();
+  return memory_manager.MakeShared<cel::common_internal::ThreadSafeTypeManager>(
+      memory_manager, cel::NewThreadSafeTypeIntrospector(memory_manager));
 }
 
 }  // namespace google::api::expr::runtime
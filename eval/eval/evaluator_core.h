@@ -15,40 +15,58 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_EVALUATOR_CORE_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_EVALUATOR_CORE_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/base/optimization.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/type_provider.h"
+#include "common/internal/reference_count.h"
 #include "common/memory.h"
 #include "common/native_type.h"
 #include "common/type_factory.h"
 #include "common/type_manager.h"
+#include "common/types/thread_safe_type_manager.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "eval/eval/attribute_utility.h"
 #include "eval/eval/comprehension_slots.h"
 #include "eval/eval/evaluator_stack.h"
+#include "eval/eval/step_arena.h"
 #include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/function_overload_reference.h"
 #include "runtime/managed_value_factory.h"
+#include "runtime/program_metrics.h"
+#include "runtime/program_references.h"
 #include "runtime/runtime.h"
 #include "runtime/runtime_options.h"
+#include "runtime/variable_layout.h"
 
 namespace google::api::expr::runtime {
 
 // Forward declaration of ExecutionFrame, to resolve circular dependency.
 class ExecutionFrame;
 
+// Defined in eval/eval/incremental_step.h.
+class IncrementalCache;
+
 using EvaluationListener = cel::TraceableProgram::EvaluationListener;
 
 // Class Expression represents single execution step.
@@ -62,6 +80,11 @@ class ExpressionStep {
 
   virtual ~ExpressionStep() = default;
 
+  // Steps planned for a program are stored in its step arena (see
+  // eval/eval/step_arena.h).
+  static void* operator new(size_t size) { return AllocateStep(size); }
+  static void operator delete(void* step) noexcept { DeallocateStep(step); }
+
   // Performs actual evaluation.
   // Values are passed between Expression objects via EvaluatorStack, which is
   // supplied with context.
@@ -89,6 +112,16 @@ class ExpressionStep {
     return cel::NativeTypeId();
   }
 
+  // Returns the offsets this step may pass to `ExecutionFrame::JumpTo`.
+  //
+  // Steps which change the execution order must report their offsets so the
+  // planner can keep them consistent when rewriting a flattened program.
+  virtual std::vector<int> GetJumpOffsets() const { return {}; }
+
+  // Replaces the offsets reported by `GetJumpOffsets`, given in the same
+  // order. Only called by the planner, before the program is evaluated.
+  virtual void SetJumpOffsets(absl::Span<const int> offsets) {}
+
  private:
   const int64_t id_;
   const bool comes_from_ast_;
@@ -113,6 +146,15 @@ class FlatExpressionEvaluatorState {
 
   void Reset();
 
+  // Rebinds the state to a caller-owned value manager. The allocated stack and
+  // slot storage is retained so the state can be reused for a new evaluation.
+  void Rebind(cel::ValueManager& value_factory);
+
+  // Rebinds the state to a new owned value manager using the given type
+  // provider and memory manager.
+  void Rebind(const cel::TypeProvider& type_provider,
+              cel::MemoryManagerRef memory_manager);
+
   EvaluatorStack& value_stack() { return value_stack_; }
 
   ComprehensionSlots& comprehension_slots() { return comprehension_slots_; }
@@ -153,7 +195,12 @@ class ExecutionFrameBase {
                            activation.GetMissingAttributes(), value_manager),
         slots_(&ComprehensionSlots::GetEmptyInstance()),
         max_iterations_(options.comprehension_max_iterations),
-        iterations_(0) {}
+        iterations_(0),
+        max_cost_(static_cast<uint64_t>(
+            std::max<int64_t>(options.max_evaluation_cost, 0))) {
+    StartMemoryAccounting();
+    StartInterruptChecks();
+  }
 
   ExecutionFrameBase(const cel::ActivationInterface& activation,
                      EvaluationListener callback,
@@ -168,7 +215,12 @@ class ExecutionFrameBase {
                            activation.GetMissingAttributes(), value_manager),
         slots_(&slots),
         max_iterations_(options.comprehension_max_iterations),
-        iterations_(0) {}
+        iterations_(0),
+        max_cost_(static_cast<uint64_t>(
+            std::max<int64_t>(options.max_evaluation_cost, 0))) {
+    StartMemoryAccounting();
+    StartInterruptChecks();
+  }
 
   const cel::ActivationInterface& activation() const { return *activation_; }
 
@@ -204,20 +256,195 @@ class ExecutionFrameBase {
 
   ComprehensionSlots& comprehension_slots() { return *slots_; }
 
-  // Increment iterations and return an error if the iteration budget is
-  // exceeded
+  // Number of comprehension iterations counted so far. Iterations are only
+  // counted if limited by `comprehension_max_iterations`.
+  int iterations() const { return iterations_; }
+
+  // Increment iterations and return an error if the iteration or memory budget
+  // is exceeded
   absl::Status IncrementIterations() {
+    if (absl::Status status = CheckInterrupts(); !status.ok()) {
+      return status;
+    }
+    if (ABSL_PREDICT_FALSE(memory_accounting_.has_value())) {
+      if (absl::Status status = CheckMemoryBudget(); !status.ok()) {
+        return status;
+      }
+    }
+    if (absl::Status status = AddCost(1); !status.ok()) {
+      return status;
+    }
     if (max_iterations_ == 0) {
       return absl::OkStatus();
     }
     iterations_++;
     if (iterations_ >= max_iterations_) {
-      return absl::Status(absl::StatusCode::kInternal,
-                          "Iteration budget exceeded");
+      return IterationBudgetExceededError();
+    }
+    return absl::OkStatus();
+  }
+
+  // Adds `cost` to the cost of the evaluation and returns an error if it
+  // exceeds `max_evaluation_cost`.
+  absl::Status AddCost(uint64_t cost) {
+    if (ABSL_PREDICT_TRUE(max_cost_ == 0)) {
+      return absl::OkStatus();
+    }
+    cost_ += cost;
+    if (cost_ > max_cost_) {
+      return CostBudgetExceededError();
+    }
+    return absl::OkStatus();
+  }
+
+  static absl::Status CostBudgetExceededError() {
+    return absl::ResourceExhaustedError("Evaluation cost budget exceeded");
+  }
+
+  // Returns the number of iterations that can be counted before the budget is
+  // exceeded.
+  //
+  // Loops which know no other loop counts iterations until they complete may
+  // check this once, then count their iterations with CountIterations().
+  size_t RemainingIterations() const {
+    size_t remaining = RemainingIterationsWithinIterationBudget();
+    if (max_cost_ != 0) {
+      remaining = std::min<uint64_t>(remaining, max_cost_ - cost_);
+    }
+    return remaining;
+  }
+
+  // Returns the error for iterations exceeding RemainingIterations(), from
+  // whichever of the iteration and cost budgets is the tighter.
+  absl::Status RemainingIterationsExceededError() const {
+    if (max_cost_ != 0 &&
+        max_cost_ - cost_ < RemainingIterationsWithinIterationBudget()) {
+      return CostBudgetExceededError();
+    }
+    return IterationBudgetExceededError();
+  }
+
+  // Counts `count` iterations at once, which must not exceed
+  // RemainingIterations().
+  void CountIterations(size_t count) {
+    ABSL_DCHECK_LE(count, RemainingIterations());
+    cost_ += max_cost_ != 0 ? count : 0;
+    if (max_iterations_ == 0) {
+      return;
+    }
+    iterations_ += static_cast<int>(count);
+  }
+
+  static absl::Status IterationBudgetExceededError() {
+    return absl::Status(absl::StatusCode::kInternal,
+                        "Iteration budget exceeded");
+  }
+
+  // Returns the number of bytes allocated by the evaluation so far, if
+  // `max_evaluation_bytes` is set.
+  absl::optional<uint64_t> allocated_bytes() const {
+    if (!memory_accounting_.has_value()) {
+      return absl::nullopt;
+    }
+    return memory_accounting_->bytes_allocated();
+  }
+
+  // Returns an error if the evaluation allocated more than
+  // `max_evaluation_bytes`.
+  absl::Status CheckMemoryBudget() const {
+    if (memory_accounting_.has_value() &&
+        memory_accounting_->bytes_allocated() >
+            static_cast<uint64_t>(options_->max_evaluation_bytes)) {
+      return MemoryBudgetExceededError();
+    }
+    return absl::OkStatus();
+  }
+
+  static absl::Status MemoryBudgetExceededError() {
+    return absl::ResourceExhaustedError("Memory budget exceeded");
+  }
+
+  // Number of calls to CheckInterrupts() between checks of the deadline and
+  // the cancellation token.
+  static constexpr uint32_t kInterruptCheckInterval = 256;
+
+  // Whether the evaluation has a deadline or may be cancelled.
+  bool interruptible() const { return interruptible_; }
+
+  // Returns an error if the evaluation was cancelled or ran past its deadline.
+  //
+  // Only checks once every kInterruptCheckInterval calls, so that the clock
+  // isn't read on every step of short evaluations.
+  absl::Status CheckInterrupts() {
+    if (ABSL_PREDICT_TRUE(!interruptible_) || --interrupt_countdown_ != 0) {
+      return absl::OkStatus();
+    }
+    interrupt_countdown_ = kInterruptCheckInterval;
+    return CheckInterruptsNow();
+  }
+
+  // As CheckInterrupts(), but checks unconditionally.
+  absl::Status CheckInterruptsNow() const {
+    if (cancellation_token_ != nullptr && cancellation_token_->cancelled()) {
+      return absl::CancelledError("Evaluation cancelled");
+    }
+    if (deadline_ != absl::InfiniteFuture() && absl::Now() >= deadline_) {
+      return absl::DeadlineExceededError("Evaluation deadline exceeded");
     }
     return absl::OkStatus();
   }
 
+  // Results of the memoized function calls made by this evaluation, keyed by
+  // FunctionMemoizer::MakeKey. Created on first use.
+  absl::flat_hash_map<std::string, cel::Value>& memoized_results() {
+    if (memoized_results_ == nullptr) {
+      memoized_results_ =
+          std::make_unique<absl::flat_hash_map<std::string, cel::Value>>();
+    }
+    return *memoized_results_;
+  }
+
+  // Overloads of lazily bound functions resolved by this evaluation, keyed by
+  // call site and the kinds of the arguments of the call. The providers of the
+  // activation are consulted once per key and evaluation rather than on every
+  // call. Created on first use.
+  using LazyOverloadCache =
+      absl::flat_hash_map<std::pair<const void*, uint64_t>,
+                          absl::optional<cel::FunctionOverloadReference>>;
+
+  LazyOverloadCache& lazy_overloads() const {
+    if (lazy_overloads_ == nullptr) {
+      lazy_overloads_ = std::make_unique<LazyOverloadCache>();
+    }
+    return *lazy_overloads_;
+  }
+
+  // Last subject scanned by each shared regex scan in this evaluation, keyed
+  // by the scanned set. See CreateRegexScanMatchStep.
+  struct RegexScanResult {
+    std::string subject;
+    // Whether each pattern of the set matches `subject`. Empty until the
+    // first scan.
+    std::vector<bool> matches;
+  };
+  using RegexScanCache = absl::flat_hash_map<const void*, RegexScanResult>;
+
+  RegexScanCache& regex_scans() const {
+    if (regex_scans_ == nullptr) {
+      regex_scans_ = std::make_unique<RegexScanCache>();
+    }
+    return *regex_scans_;
+  }
+
+  // Results of subexpressions cached by earlier evaluations of an
+  // incrementally evaluated program, or null if the evaluation isn't
+  // incremental.
+  IncrementalCache* incremental_cache() const { return incremental_cache_; }
+
+  void set_incremental_cache(IncrementalCache* cache) {
+    incremental_cache_ = cache;
+  }
+
  protected:
   absl::Nonnull<const cel::ActivationInterface*> activation_;
   EvaluationListener callback_;
@@ -227,6 +454,46 @@ class ExecutionFrameBase {
   absl::Nonnull<ComprehensionSlots*> slots_;
   const int max_iterations_;
   int iterations_;
+  // Zero if the cost isn't limited.
+  const uint64_t max_cost_;
+  uint64_t cost_ = 0;
+  absl::optional<cel::MemoryAccountingScope> memory_accounting_;
+  std::unique_ptr<absl::flat_hash_map<std::string, cel::Value>>
+      memoized_results_;
+  mutable std::unique_ptr<LazyOverloadCache> lazy_overloads_;
+  mutable std::unique_ptr<RegexScanCache> regex_scans_;
+  IncrementalCache* incremental_cache_ = nullptr;
+  absl::Time deadline_ = absl::InfiniteFuture();
+  absl::Nullable<const cel::CancellationToken*> cancellation_token_ = nullptr;
+  bool interruptible_ = false;
+  uint32_t interrupt_countdown_ = kInterruptCheckInterval;
+
+ private:
+  size_t RemainingIterationsWithinIterationBudget() const {
+    if (max_iterations_ == 0) {
+      return std::numeric_limits<size_t>::max();
+    }
+    return iterations_ + 1 >= max_iterations_
+               ? 0
+               : static_cast<size_t>(max_iterations_ - iterations_ - 1);
+  }
+
+  void StartMemoryAccounting() {
+    if (options_->max_evaluation_bytes > 0) {
+      memory_accounting_.emplace();
+    }
+  }
+
+  void StartInterruptChecks() {
+    deadline_ = activation_->GetDeadline();
+    if (options_->evaluation_timeout != absl::InfiniteDuration()) {
+      deadline_ =
+          std::min(deadline_, absl::Now() + options_->evaluation_timeout);
+    }
+    cancellation_token_ = activation_->GetCancellationToken();
+    interruptible_ =
+        deadline_ != absl::InfiniteFuture() || cancellation_token_ != nullptr;
+  }
 };
 
 // ExecutionFrame manages the context needed for expression evaluation.
@@ -248,7 +515,9 @@ class ExecutionFrame : public ExecutionFrameBase {
         pc_(0UL),
         execution_path_(flat),
         state_(state),
-        subexpressions_() {}
+        subexpressions_() {
+    state_.value_stack().SetAttributeTracking(attribute_tracking_enabled());
+  }
 
   ExecutionFrame(absl::Span<const ExecutionPathView> subexpressions,
                  const cel::ActivationInterface& activation,
@@ -262,6 +531,7 @@ class ExecutionFrame : public ExecutionFrameBase {
         state_(state),
         subexpressions_(subexpressions) {
     ABSL_DCHECK(!subexpressions.empty());
+    state_.value_stack().SetAttributeTracking(attribute_tracking_enabled());
   }
 
   // Returns next expression to evaluate.
@@ -347,6 +617,11 @@ class ExecutionFrame : public ExecutionFrameBase {
   }
 
  private:
+  // Restores the caller's subexpression if the end of a called subexpression
+  // has been reached. Returns false if evaluation of the main expression is
+  // complete.
+  bool ReturnFromSubexpression();
+
   struct SubFrame {
     size_t return_pc;
     size_t expected_stack_size;
@@ -373,18 +648,26 @@ class FlatExpression {
         subexpressions_({path_}),
         comprehension_slots_size_(comprehension_slots_size),
         type_provider_(type_provider),
-        options_(options) {}
+        options_(options),
+        interned_types_(NewInternedTypes()) {}
 
   FlatExpression(ExecutionPath path,
                  std::vector<ExecutionPathView> subexpressions,
                  size_t comprehension_slots_size,
                  const cel::TypeProvider& type_provider,
-                 const cel::RuntimeOptions& options)
+                 const cel::RuntimeOptions& options,
+                 std::shared_ptr<const cel::VariableLayout> variable_layout =
+                     nullptr,
+                 std::shared_ptr<const cel::ProgramReferences> references =
+                     nullptr)
       : path_(std::move(path)),
         subexpressions_(std::move(subexpressions)),
         comprehension_slots_size_(comprehension_slots_size),
         type_provider_(type_provider),
-        options_(options) {}
+        options_(options),
+        variable_layout_(std::move(variable_layout)),
+        references_(std::move(references)),
+        interned_types_(NewInternedTypes()) {}
 
   // Move-only
   FlatExpression(FlatExpression&&) = default;
@@ -409,9 +692,26 @@ class FlatExpression {
       const cel::ActivationInterface& activation, EvaluationListener listener,
       FlatExpressionEvaluatorState& state) const;
 
+  // Evaluate the expression, reusing the results of the subexpressions cached
+  // in `cache` by earlier evaluations, for expressions planned with cached
+  // subexpressions (see eval/compiler/incremental_evaluation.h).
+  absl::StatusOr<cel::Value> EvaluateIncrementally(
+      const cel::ActivationInterface& activation, IncrementalCache& cache,
+      FlatExpressionEvaluatorState& state) const;
+
+  // Returns a value manager for a single evaluation of the expression, which
+  // interns the composite types it creates in interned_types(). The value
+  // manager itself is only meant to be used by one thread.
   cel::ManagedValueFactory MakeValueFactory(
       cel::MemoryManagerRef memory_manager) const;
 
+  // Types interned for the evaluations of the expression, shared between
+  // threads. Types already interned are found without taking locks.
+  const cel::Shared<cel::common_internal::ThreadSafeTypeManager>&
+  interned_types() const {
+    return interned_types_;
+  }
+
   const ExecutionPath& path() const { return path_; }
 
   absl::Span<const ExecutionPathView> subexpressions() const {
@@ -422,14 +722,88 @@ class FlatExpression {
 
   size_t comprehension_slots_size() const { return comprehension_slots_size_; }
 
+  const cel::TypeProvider& type_provider() const { return type_provider_; }
+
+  // Slots assigned to the free variables in the expression. May be null if
+  // the expression was not planned with a layout.
+  const std::shared_ptr<const cel::VariableLayout>& variable_layout() const {
+    return variable_layout_;
+  }
+
+  // Names the expression may reference. May be null if the expression was
+  // not planned with reference tracking.
+  const std::shared_ptr<const cel::ProgramReferences>& references() const {
+    return references_;
+  }
+
+  // A copy of the expression planned with trace steps, used by evaluations
+  // with a listener. May be null if the listener is served by this
+  // expression's own steps, as is always the case for stack machine steps.
+  const FlatExpression* traced_expression() const {
+    return traced_expression_.get();
+  }
+
+  void set_traced_expression(std::unique_ptr<const FlatExpression> traced) {
+    traced_expression_ = std::move(traced);
+  }
+
+  // Takes over the ownership of the immortal storage of the constants of the
+  // expression, deleting it once the steps referring to it are destroyed.
+  void set_immortal_constants(cel::common_internal::ImmortalRef constants) {
+    immortal_constants_ = std::move(constants);
+  }
+
+  // Takes over the ownership of the arena the steps of the expression were
+  // allocated from, releasing it once the steps are destroyed.
+  void set_step_arena(std::unique_ptr<StepArena> arena) {
+    step_arena_ = std::move(arena);
+  }
+
+  // The arena the steps of the expression were allocated from. May be null
+  // if the steps are heap allocated.
+  const StepArena* step_arena() const { return step_arena_.get(); }
+
+  // Metrics recorded for the evaluations of the expression, including those
+  // served by its traced copy. May be null if metrics are disabled.
+  const std::shared_ptr<cel::ProgramMetrics>& metrics() const {
+    return metrics_;
+  }
+
+  void set_metrics(std::shared_ptr<cel::ProgramMetrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
+
  private:
+  absl::StatusOr<cel::Value> EvaluateWithMetrics(
+      const cel::ActivationInterface& activation, EvaluationListener listener,
+      FlatExpressionEvaluatorState& state,
+      absl::Nullable<cel::ProgramMetrics*> metrics) const;
+
+  static cel::Shared<cel::common_internal::ThreadSafeTypeManager>
+  NewInternedTypes();
+
+  // Declared first so that they are destroyed after the steps.
+  std::unique_ptr<StepArena> step_arena_;
+  cel::common_internal::ImmortalRef immortal_constants_;
   ExecutionPath path_;
   std::vector<ExecutionPathView> subexpressions_;
   size_t comprehension_slots_size_;
   const cel::TypeProvider& type_provider_;
   cel::RuntimeOptions options_;
+  std::shared_ptr<const cel::VariableLayout> variable_layout_;
+  std::shared_ptr<const cel::ProgramReferences> references_;
+  std::unique_ptr<const FlatExpression> traced_expression_;
+  std::shared_ptr<cel::ProgramMetrics> metrics_;
+  cel::Shared<cel::common_internal::ThreadSafeTypeManager> interned_types_;
 };
 
+// Records in `metrics` an evaluation which started at `start_nanos`, as
+// returned by absl::GetCurrentTimeNanos, and completed with `status` and
+// `result` in `frame`.
+void RecordEvaluation(cel::ProgramMetrics& metrics, int64_t start_nanos,
+                      const absl::Status& status, const cel::Value& result,
+                      const ExecutionFrameBase& frame);
+
 }  // namespace google::api::expr::runtime
 
 #endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_EVALUATOR_CORE_H_
@@ -4,7 +4,9 @@ namespace google::api::expr::runtime {
 
 void EvaluatorStack::Clear() {
   stack_.clear();
-  attribute_stack_.clear();
+  if (track_attributes_) {
+    attribute_stack_.clear();
+  }
   current_size_ = 0;
 }
 
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "absl/base/optimization.h"
+#include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/types/span.h"
 #include "common/value.h"
@@ -41,6 +42,27 @@ class EvaluatorStack {
   // Dumps the entire stack state as is.
   void Clear();
 
+  // Sets whether the stack keeps the attribute trails it is given. Must be
+  // called while the stack is empty.
+  //
+  // Programs planned without unknown processing or missing attribute errors
+  // only ever push empty trails. Without tracking, the stack skips writing
+  // them, so that each push and pop only touches the value, and reads of the
+  // trails return a preallocated run of empty trails instead.
+  void SetAttributeTracking(bool enabled) {
+    if (enabled == track_attributes_) {
+      return;
+    }
+    ABSL_DCHECK(empty());
+    track_attributes_ = enabled;
+    attribute_stack_.clear();
+    if (!enabled) {
+      attribute_stack_.resize(max_size_);
+    }
+  }
+
+  bool attribute_tracking_enabled() const { return track_attributes_; }
+
   // Gets the last size elements of the stack.
   // Checking that stack has enough elements is caller's responsibility.
   // Please note that calls to Push may invalidate returned Span object.
@@ -99,23 +121,31 @@ class EvaluatorStack {
       ABSL_LOG(FATAL) << "Trying to pop more elements (" << size
                       << ") than the current stack size: " << current_size_;
     }
-    while (size > 0) {
-      stack_.pop_back();
-      attribute_stack_.pop_back();
-      current_size_--;
-      size--;
+    // Truncate both stacks at once rather than element by element.
+    current_size_ -= size;
+    stack_.erase(stack_.begin() + current_size_, stack_.end());
+    if (track_attributes_) {
+      attribute_stack_.erase(attribute_stack_.begin() + current_size_,
+                             attribute_stack_.end());
     }
   }
 
   // Put element on the top of the stack.
-  void Push(cel::Value value) { Push(std::move(value), AttributeTrail()); }
+  void Push(cel::Value value) {
+    if (ABSL_PREDICT_FALSE(current_size_ >= max_size())) {
+      ABSL_LOG(ERROR) << "No room to push more elements on to EvaluatorStack";
+    }
+    stack_.push_back(std::move(value));
+    PushAttribute(AttributeTrail());
+    current_size_++;
+  }
 
   void Push(cel::Value value, AttributeTrail attribute) {
     if (ABSL_PREDICT_FALSE(current_size_ >= max_size())) {
       ABSL_LOG(ERROR) << "No room to push more elements on to EvaluatorStack";
     }
     stack_.push_back(std::move(value));
-    attribute_stack_.push_back(std::move(attribute));
+    PushAttribute(std::move(attribute));
     current_size_++;
   }
 
@@ -124,9 +154,30 @@ class EvaluatorStack {
       Push(std::move(value), std::move(attribute));
       return;
     }
-    Pop(size - 1);
+    if (size > 1) {
+      Pop(size - 1);
+    }
+    stack_[current_size_ - 1] = std::move(value);
+    if (track_attributes_) {
+      attribute_stack_[current_size_ - 1] = std::move(attribute);
+    }
+  }
+
+  // Replace the top size elements of the stack with value, leaving the
+  // attribute trail of the remaining slot untouched.
+  //
+  // Only valid for steps planned without attribute tracking: every attribute
+  // trail on the stack is empty in that case, so the slot already holds the
+  // correct trail.
+  void PopAndPushValue(size_t size, cel::Value value) {
+    if (size == 0) {
+      Push(std::move(value));
+      return;
+    }
+    if (size > 1) {
+      Pop(size - 1);
+    }
     stack_[current_size_ - 1] = std::move(value);
-    attribute_stack_[current_size_ - 1] = std::move(attribute);
   }
 
   // Replace element on the top of the stack.
@@ -149,9 +200,21 @@ class EvaluatorStack {
   void SetMaxSize(size_t size) {
     max_size_ = size;
     Reserve(size);
+    if (!track_attributes_ && attribute_stack_.size() < size) {
+      attribute_stack_.resize(size);
+    }
   }
 
  private:
+  void PushAttribute(AttributeTrail attribute) {
+    if (ABSL_PREDICT_TRUE(track_attributes_)) {
+      attribute_stack_.push_back(std::move(attribute));
+    } else if (ABSL_PREDICT_FALSE(current_size_ >= attribute_stack_.size())) {
+      // Pushed past the max size, grow the run of empty trails.
+      attribute_stack_.emplace_back();
+    }
+  }
+
   // Preallocate stack.
   void Reserve(size_t size) {
     stack_.reserve(size);
@@ -159,9 +222,12 @@ class EvaluatorStack {
   }
 
   std::vector<cel::Value> stack_;
+  // Without attribute tracking, at least `current_size_` empty trails which
+  // are never written.
   std::vector<AttributeTrail> attribute_stack_;
   size_t max_size_;
   size_t current_size_;
+  bool track_attributes_ = true;
 };
 
 }  // namespace google::api::expr::runtime
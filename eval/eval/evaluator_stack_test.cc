@@ -90,6 +90,84 @@ TEST(EvaluatorStackTest, Clear) {
   ASSERT_TRUE(stack.empty());
 }
 
+TEST(EvaluatorStackTest, PopMultiple) {
+  google::protobuf::Arena arena;
+  auto manager = ProtoMemoryManagerRef(&arena);
+  cel::common_internal::LegacyValueManager value_factory(
+      manager, TypeProvider::Builtin());
+  EvaluatorStack stack(10);
+
+  stack.Push(value_factory.CreateIntValue(1), AttributeTrail("name"));
+  stack.Push(value_factory.CreateIntValue(2));
+  stack.Push(value_factory.CreateIntValue(3));
+  stack.Push(value_factory.CreateIntValue(4));
+
+  stack.PopAndPush(3, value_factory.CreateIntValue(5));
+  ASSERT_EQ(stack.size(), 2);
+  ASSERT_EQ(stack.size(), stack.attribute_size());
+  ASSERT_EQ(stack.Peek().As<cel::IntValue>().NativeValue(), 5);
+  ASSERT_TRUE(stack.PeekAttribute().empty());
+
+  stack.Pop(1);
+  ASSERT_EQ(stack.Peek().As<cel::IntValue>().NativeValue(), 1);
+  ASSERT_FALSE(stack.PeekAttribute().empty());
+
+  stack.Pop(1);
+  ASSERT_TRUE(stack.empty());
+}
+
+TEST(EvaluatorStackTest, PopAndPushValue) {
+  google::protobuf::Arena arena;
+  auto manager = ProtoMemoryManagerRef(&arena);
+  cel::common_internal::LegacyValueManager value_factory(
+      manager, TypeProvider::Builtin());
+  EvaluatorStack stack(10);
+
+  stack.Push(value_factory.CreateIntValue(1));
+  stack.Push(value_factory.CreateIntValue(2));
+  stack.Push(value_factory.CreateIntValue(3));
+
+  stack.PopAndPushValue(2, value_factory.CreateIntValue(4));
+  ASSERT_EQ(stack.size(), 2);
+  ASSERT_EQ(stack.size(), stack.attribute_size());
+  ASSERT_EQ(stack.Peek().As<cel::IntValue>().NativeValue(), 4);
+  ASSERT_TRUE(stack.PeekAttribute().empty());
+
+  stack.PopAndPushValue(1, value_factory.CreateIntValue(5));
+  ASSERT_EQ(stack.size(), 2);
+  ASSERT_EQ(stack.Peek().As<cel::IntValue>().NativeValue(), 5);
+}
+
+TEST(EvaluatorStackTest, WithoutAttributeTracking) {
+  google::protobuf::Arena arena;
+  auto manager = ProtoMemoryManagerRef(&arena);
+  cel::common_internal::LegacyValueManager value_factory(
+      manager, TypeProvider::Builtin());
+  EvaluatorStack stack(2);
+  stack.SetAttributeTracking(false);
+
+  // Pushing past the max size is logged, but still supported.
+  stack.Push(value_factory.CreateIntValue(1), AttributeTrail("name"));
+  stack.Push(value_factory.CreateIntValue(2));
+  stack.Push(value_factory.CreateIntValue(3), AttributeTrail("name"));
+  ASSERT_EQ(stack.size(), 3);
+  ASSERT_EQ(stack.Peek().As<cel::IntValue>().NativeValue(), 3);
+  ASSERT_TRUE(stack.PeekAttribute().empty());
+  for (const auto& trail : stack.GetAttributeSpan(3)) {
+    ASSERT_TRUE(trail.empty());
+  }
+
+  stack.PopAndPush(2, value_factory.CreateIntValue(4), AttributeTrail("name"));
+  ASSERT_EQ(stack.size(), 2);
+  ASSERT_EQ(stack.Peek().As<cel::IntValue>().NativeValue(), 4);
+  ASSERT_TRUE(stack.PeekAttribute().empty());
+
+  stack.Clear();
+  stack.SetAttributeTracking(true);
+  stack.Push(value_factory.CreateIntValue(1), AttributeTrail("name"));
+  ASSERT_FALSE(stack.PeekAttribute().empty());
+}
+
 }  // namespace
 
 }  // namespace google::api::expr::runtime
@@ -0,0 +1,103 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/evaluator_state_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "common/memory.h"
+#include "common/value_manager.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+EvaluatorStatePool::EvaluatorStatePool(const FlatExpression& expression,
+                                       size_t capacity)
+    : value_stack_size_(expression.path().size()),
+      comprehension_slots_size_(expression.comprehension_slots_size()),
+      type_provider_(&expression.type_provider()),
+      capacity_(capacity),
+      idle_(std::make_unique<std::atomic<FlatExpressionEvaluatorState*>[]>(
+          capacity)) {
+  for (size_t i = 0; i < capacity_; ++i) {
+    idle_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+EvaluatorStatePool::~EvaluatorStatePool() {
+  for (size_t i = 0; i < capacity_; ++i) {
+    delete idle_[i].exchange(nullptr, std::memory_order_acquire);
+  }
+}
+
+std::unique_ptr<FlatExpressionEvaluatorState> EvaluatorStatePool::TryTake() {
+  for (size_t i = 0; i < capacity_; ++i) {
+    // Cheap check first to avoid contending on empty slots.
+    if (idle_[i].load(std::memory_order_relaxed) == nullptr) {
+      continue;
+    }
+    if (auto* state = idle_[i].exchange(nullptr, std::memory_order_acquire);
+        state != nullptr) {
+      return std::unique_ptr<FlatExpressionEvaluatorState>(state);
+    }
+  }
+  return nullptr;
+}
+
+EvaluatorStatePool::Lease EvaluatorStatePool::Acquire(
+    cel::ValueManager& value_manager) {
+  std::unique_ptr<FlatExpressionEvaluatorState> state = TryTake();
+  if (state == nullptr) {
+    state = std::make_unique<FlatExpressionEvaluatorState>(
+        value_stack_size_, comprehension_slots_size_, value_manager);
+  } else {
+    state->Rebind(value_manager);
+  }
+  return Lease(this, std::move(state));
+}
+
+EvaluatorStatePool::Lease EvaluatorStatePool::Acquire(
+    cel::MemoryManagerRef memory_manager) {
+  std::unique_ptr<FlatExpressionEvaluatorState> state = TryTake();
+  if (state == nullptr) {
+    state = std::make_unique<FlatExpressionEvaluatorState>(
+        value_stack_size_, comprehension_slots_size_, *type_provider_,
+        memory_manager);
+  } else {
+    state->Rebind(*type_provider_, memory_manager);
+  }
+  return Lease(this, std::move(state));
+}
+
+void EvaluatorStatePool::Release(
+    std::unique_ptr<FlatExpressionEvaluatorState> state) {
+  // Drop any values still referenced by the state so they do not outlive the
+  // memory manager they were created with.
+  state->Reset();
+  for (size_t i = 0; i < capacity_; ++i) {
+    FlatExpressionEvaluatorState* expected = nullptr;
+    if (idle_[i].compare_exchange_strong(expected, state.get(),
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+      state.release();
+      return;
+    }
+  }
+  // Pool is full, let the state be freed.
+}
+
+}  // namespace google::api::expr::runtime
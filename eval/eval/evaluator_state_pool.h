@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_EVALUATOR_STATE_POOL_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_EVALUATOR_STATE_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "base/type_provider.h"
+#include "common/memory.h"
+#include "common/value_manager.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+// A bounded pool of reusable FlatExpressionEvaluatorState instances for a
+// single FlatExpression.
+//
+// Evaluating a stack machine program requires a value stack and comprehension
+// slots sized for the program. The pool keeps up to `capacity` idle states so
+// that steady state evaluation does not need to allocate them.
+//
+// Acquire and release are lock-free: idle states are kept in a fixed array of
+// atomic slots. If no idle state is available, a new one is allocated. If the
+// pool is full when a state is returned, the state is freed.
+//
+// Thread safe.
+class EvaluatorStatePool {
+ public:
+  // RAII handle for a state borrowed from the pool. The state is reset and
+  // returned to the pool when the lease is destroyed.
+  class Lease {
+   public:
+    Lease(Lease&& other) noexcept
+        : pool_(other.pool_), state_(std::move(other.state_)) {}
+    Lease& operator=(Lease&&) = delete;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    ~Lease() {
+      if (state_ != nullptr) {
+        pool_->Release(std::move(state_));
+      }
+    }
+
+    FlatExpressionEvaluatorState& get() { return *state_; }
+    FlatExpressionEvaluatorState& operator*() { return *state_; }
+    FlatExpressionEvaluatorState* operator->() { return state_.get(); }
+
+   private:
+    friend class EvaluatorStatePool;
+
+    Lease(absl::Nonnull<EvaluatorStatePool*> pool,
+          std::unique_ptr<FlatExpressionEvaluatorState> state)
+        : pool_(pool), state_(std::move(state)) {}
+
+    absl::Nonnull<EvaluatorStatePool*> pool_;
+    std::unique_ptr<FlatExpressionEvaluatorState> state_;
+  };
+
+  // `expression` is only consulted for sizing the states. It does not need to
+  // outlive the pool, but its type provider does.
+  EvaluatorStatePool(const FlatExpression& expression, size_t capacity);
+
+  ~EvaluatorStatePool();
+
+  EvaluatorStatePool(const EvaluatorStatePool&) = delete;
+  EvaluatorStatePool& operator=(const EvaluatorStatePool&) = delete;
+
+  // Borrow a state bound to the given caller-owned value manager.
+  Lease Acquire(cel::ValueManager& value_manager);
+
+  // Borrow a state that owns a value manager using the given memory manager.
+  Lease Acquire(cel::MemoryManagerRef memory_manager);
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  std::unique_ptr<FlatExpressionEvaluatorState> TryTake();
+  void Release(std::unique_ptr<FlatExpressionEvaluatorState> state);
+
+  const size_t value_stack_size_;
+  const size_t comprehension_slots_size_;
+  absl::Nonnull<const cel::TypeProvider*> type_provider_;
+  const size_t capacity_;
+  std::unique_ptr<std::atomic<FlatExpressionEvaluatorState*>[]> idle_;
+};
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_EVALUATOR_STATE_POOL_H_
@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/evaluator_state_pool.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "base/type_provider.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/values/legacy_value_manager.h"
+#include "eval/eval/const_value_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/testing.h"
+#include "runtime/activation.h"
+#include "runtime/runtime_options.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::IntValue;
+using ::cel::MemoryManagerRef;
+using ::cel::TypeProvider;
+using ::cel::common_internal::LegacyValueManager;
+using testing::Eq;
+using testing::Ne;
+
+FlatExpression MakeConstExpression(int64_t value) {
+  ExecutionPath path;
+  path.push_back(CreateConstValueStep(IntValue(value), /*expr_id=*/1).value());
+  return FlatExpression(std::move(path), /*comprehension_slots_size=*/2,
+                        TypeProvider::Builtin(), cel::RuntimeOptions{});
+}
+
+TEST(EvaluatorStatePoolTest, ReusesReleasedState) {
+  FlatExpression expr = MakeConstExpression(42);
+  EvaluatorStatePool pool(expr, /*capacity=*/2);
+  LegacyValueManager value_manager(MemoryManagerRef::ReferenceCounting(),
+                                   TypeProvider::Builtin());
+
+  FlatExpressionEvaluatorState* first_state = nullptr;
+  {
+    EvaluatorStatePool::Lease lease = pool.Acquire(value_manager);
+    first_state = &lease.get();
+    EXPECT_EQ(&lease->value_manager(), &value_manager);
+    EXPECT_EQ(lease->comprehension_slots().size(), 2);
+  }
+
+  LegacyValueManager other_value_manager(MemoryManagerRef::ReferenceCounting(),
+                                         TypeProvider::Builtin());
+  EvaluatorStatePool::Lease lease = pool.Acquire(other_value_manager);
+  EXPECT_THAT(&lease.get(), Eq(first_state));
+  EXPECT_EQ(&lease->value_manager(), &other_value_manager);
+}
+
+TEST(EvaluatorStatePoolTest, AllocatesWhenEmpty) {
+  FlatExpression expr = MakeConstExpression(42);
+  EvaluatorStatePool pool(expr, /*capacity=*/1);
+  LegacyValueManager value_manager(MemoryManagerRef::ReferenceCounting(),
+                                   TypeProvider::Builtin());
+
+  EvaluatorStatePool::Lease lease1 = pool.Acquire(value_manager);
+  EvaluatorStatePool::Lease lease2 = pool.Acquire(value_manager);
+  EXPECT_THAT(&lease1.get(), Ne(&lease2.get()));
+}
+
+TEST(EvaluatorStatePoolTest, ZeroCapacity) {
+  FlatExpression expr = MakeConstExpression(42);
+  EvaluatorStatePool pool(expr, /*capacity=*/0);
+  LegacyValueManager value_manager(MemoryManagerRef::ReferenceCounting(),
+                                   TypeProvider::Builtin());
+
+  EvaluatorStatePool::Lease lease = pool.Acquire(value_manager);
+  EXPECT_EQ(&lease->value_manager(), &value_manager);
+}
+
+TEST(EvaluatorStatePoolTest, OwnedValueManager) {
+  FlatExpression expr = MakeConstExpression(42);
+  EvaluatorStatePool pool(expr, /*capacity=*/1);
+
+  EvaluatorStatePool::Lease lease =
+      pool.Acquire(MemoryManagerRef::ReferenceCounting());
+  EXPECT_EQ(lease->memory_manager().memory_management(),
+            cel::MemoryManagement::kReferenceCounting);
+}
+
+TEST(EvaluatorStatePoolTest, Evaluate) {
+  FlatExpression expr = MakeConstExpression(42);
+  EvaluatorStatePool pool(expr, /*capacity=*/1);
+  LegacyValueManager value_manager(MemoryManagerRef::ReferenceCounting(),
+                                   TypeProvider::Builtin());
+  cel::Activation activation;
+
+  for (int i = 0; i < 3; ++i) {
+    EvaluatorStatePool::Lease lease = pool.Acquire(value_manager);
+    ASSERT_OK_AND_ASSIGN(
+        cel::Value result,
+        expr.EvaluateWithCallback(activation, EvaluationListener(),
+                                  lease.get()));
+    ASSERT_TRUE(result->Is<IntValue>());
+    EXPECT_EQ(result->As<IntValue>().NativeValue(), 42);
+    EXPECT_TRUE(lease->value_stack().empty());
+  }
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,214 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/function_memoizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/function_descriptor.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::Value;
+using ::cel::ValueKind;
+
+template <typename T>
+void AppendFixed(std::string& key, T value) {
+  char buffer[sizeof(T)];
+  std::memcpy(buffer, &value, sizeof(T));
+  key.append(buffer, sizeof(T));
+}
+
+void AppendBytes(std::string& key, absl::string_view bytes) {
+  AppendFixed<uint64_t>(key, bytes.size());
+  key.append(bytes.data(), bytes.size());
+}
+
+}  // namespace
+
+FunctionMemoizer::FunctionMemoizer(
+    size_t cache_capacity, std::shared_ptr<FunctionMemoizationStats> stats)
+    : shard_capacity_(
+          cache_capacity == 0
+              ? 0
+              : std::max<size_t>(
+                    (cache_capacity + kNumShards - 1) / kNumShards, 1)),
+      stats_(std::move(stats)),
+      shards_(shard_capacity_ == 0 ? nullptr
+                                   : std::make_unique<Shard[]>(kNumShards)) {}
+
+bool FunctionMemoizer::AppendKey(std::string& key, const Value& arg) {
+  ValueKind kind = arg->kind();
+  key.push_back(static_cast<char>(kind));
+  std::string scratch;
+  switch (kind) {
+    case ValueKind::kNull:
+      return true;
+    case ValueKind::kBool:
+      key.push_back(arg.As<cel::BoolValue>().NativeValue() ? 1 : 0);
+      return true;
+    case ValueKind::kInt:
+      AppendFixed<int64_t>(key, arg.As<cel::IntValue>().NativeValue());
+      return true;
+    case ValueKind::kUint:
+      AppendFixed<uint64_t>(key, arg.As<cel::UintValue>().NativeValue());
+      return true;
+    case ValueKind::kDouble:
+      // Keyed by representation, so that 0.0 and -0.0 are told apart.
+      AppendFixed<double>(key, arg.As<cel::DoubleValue>().NativeValue());
+      return true;
+    case ValueKind::kString:
+      AppendBytes(key, arg.As<cel::StringValue>().NativeString(scratch));
+      return true;
+    case ValueKind::kBytes:
+      AppendBytes(key, arg.As<cel::BytesValue>().NativeString(scratch));
+      return true;
+    case ValueKind::kTimestamp: {
+      absl::Time time = arg.As<cel::TimestampValue>().NativeValue();
+      int64_t seconds = absl::ToUnixSeconds(time);
+      AppendFixed<int64_t>(key, seconds);
+      AppendFixed<int64_t>(
+          key, absl::ToInt64Nanoseconds(time - absl::FromUnixSeconds(seconds)));
+      return true;
+    }
+    case ValueKind::kDuration: {
+      absl::Duration remainder;
+      int64_t seconds =
+          absl::IDivDuration(arg.As<cel::DurationValue>().NativeValue(),
+                             absl::Seconds(1), &remainder);
+      AppendFixed<int64_t>(key, seconds);
+      AppendFixed<int64_t>(key, absl::ToInt64Nanoseconds(remainder));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+absl::optional<Value> FunctionMemoizer::OwnedCopy(const Value& result) {
+  switch (result->kind()) {
+    case ValueKind::kNull:
+    case ValueKind::kBool:
+    case ValueKind::kInt:
+    case ValueKind::kUint:
+    case ValueKind::kDouble:
+    case ValueKind::kTimestamp:
+    case ValueKind::kDuration:
+      return result;
+    case ValueKind::kString:
+      return cel::StringValue(result.As<cel::StringValue>().NativeCord());
+    case ValueKind::kBytes:
+      return cel::BytesValue(result.As<cel::BytesValue>().NativeCord());
+    default:
+      return absl::nullopt;
+  }
+}
+
+absl::optional<std::string> FunctionMemoizer::MakeKey(
+    const cel::FunctionDescriptor& descriptor, absl::Span<const Value> args) {
+  std::string key;
+  AppendBytes(key, descriptor.name());
+  key.push_back(descriptor.receiver_style() ? 1 : 0);
+  for (const Value& arg : args) {
+    if (!AppendKey(key, arg)) {
+      return absl::nullopt;
+    }
+  }
+  return key;
+}
+
+FunctionMemoizer::Shard& FunctionMemoizer::ShardFor(
+    absl::string_view key) const {
+  return shards_[absl::Hash<absl::string_view>{}(key) % kNumShards];
+}
+
+absl::optional<Value> FunctionMemoizer::Find(ExecutionFrameBase& frame,
+                                             absl::string_view key) const {
+  auto& memoized_results = frame.memoized_results();
+  if (auto it = memoized_results.find(key); it != memoized_results.end()) {
+    if (stats_ != nullptr) {
+      stats_->evaluation_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    return it->second;
+  }
+  if (shards_ != nullptr) {
+    Shard& shard = ShardFor(key);
+    absl::MutexLock lock(&shard.mutex);
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      if (stats_ != nullptr) {
+        stats_->cache_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+      return it->second->value;
+    }
+  }
+  if (stats_ != nullptr) {
+    stats_->misses.fetch_add(1, std::memory_order_relaxed);
+  }
+  return absl::nullopt;
+}
+
+void FunctionMemoizer::Store(ExecutionFrameBase& frame, std::string key,
+                             const Value& result) const {
+  if (result->Is<cel::ErrorValue>() || result->Is<cel::UnknownValue>()) {
+    return;
+  }
+  if (shards_ != nullptr) {
+    if (absl::optional<Value> owned = OwnedCopy(result); owned.has_value()) {
+      Shard& shard = ShardFor(key);
+      absl::MutexLock lock(&shard.mutex);
+      if (!shard.index.contains(key)) {
+        shard.entries.push_front(Entry{key, *std::move(owned)});
+        shard.index.insert({shard.entries.front().key, shard.entries.begin()});
+        while (shard.entries.size() > shard_capacity_) {
+          shard.index.erase(shard.entries.back().key);
+          shard.entries.pop_back();
+        }
+      }
+    }
+  }
+  frame.memoized_results().insert_or_assign(std::move(key), result);
+}
+
+size_t FunctionMemoizer::cache_size() const {
+  if (shards_ == nullptr) {
+    return 0;
+  }
+  size_t size = 0;
+  for (size_t i = 0; i < kNumShards; ++i) {
+    absl::MutexLock lock(&shards_[i].mutex);
+    size += shards_[i].entries.size();
+  }
+  return size;
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_FUNCTION_MEMOIZER_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_FUNCTION_MEMOIZER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/function_descriptor.h"
+#include "common/value.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+// Counters for the memoized calls of the programs sharing them. Updated
+// without locking during evaluation.
+struct FunctionMemoizationStats {
+  // Calls answered with the result of an earlier call in the same evaluation.
+  std::atomic<int64_t> evaluation_hits{0};
+  // Calls answered with a result cached by an earlier evaluation.
+  std::atomic<int64_t> cache_hits{0};
+  // Calls which invoked the function.
+  std::atomic<int64_t> misses{0};
+};
+
+// Memoizes the results of calls to pure functions (see
+// cel::FunctionDescriptor::is_pure) for the call steps of a program.
+//
+// Results are reused within an evaluation through the table of the
+// ExecutionFrameBase. If `cache_capacity` is non-zero, results of primitive
+// kinds are also kept in a bounded LRU cache shared by every evaluation of the
+// program, split across shards by key to reduce lock contention.
+//
+// Only calls whose arguments are all of primitive kinds (null, bool, int,
+// uint, double, string, bytes, timestamp and duration) are memoized.
+class FunctionMemoizer final {
+ public:
+  FunctionMemoizer(size_t cache_capacity,
+                   std::shared_ptr<FunctionMemoizationStats> stats);
+
+  FunctionMemoizer(const FunctionMemoizer&) = delete;
+  FunctionMemoizer& operator=(const FunctionMemoizer&) = delete;
+
+  // Returns the key of a call to the overload described by `descriptor` with
+  // `args`, or `absl::nullopt` if the call can't be memoized.
+  static absl::optional<std::string> MakeKey(
+      const cel::FunctionDescriptor& descriptor,
+      absl::Span<const cel::Value> args);
+
+  // Appends an unambiguous encoding of `value` to `key`. Returns false if
+  // values of its kind can't be part of a key.
+  static bool AppendKey(std::string& key, const cel::Value& value);
+
+  // Returns a copy of `result` which doesn't refer to the memory of the
+  // evaluation which produced it, or `absl::nullopt` if values of its kind
+  // aren't cached between evaluations.
+  static absl::optional<cel::Value> OwnedCopy(const cel::Value& result);
+
+  // Returns the memoized result for `key`, if any.
+  absl::optional<cel::Value> Find(ExecutionFrameBase& frame,
+                                  absl::string_view key) const;
+
+  // Records the result of the call identified by `key`. Errors and unknowns
+  // are not memoized.
+  void Store(ExecutionFrameBase& frame, std::string key,
+             const cel::Value& result) const;
+
+  // Number of results in the cache shared between evaluations.
+  size_t cache_size() const;
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Entry {
+    std::string key;
+    cel::Value value;
+  };
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    // Most recently used first.
+    std::list<Entry> entries ABSL_GUARDED_BY(mutex);
+    // Keys point into the key of the corresponding entry.
+    absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  Shard& ShardFor(absl::string_view key) const;
+
+  const size_t shard_capacity_;
+  std::shared_ptr<FunctionMemoizationStats> stats_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_FUNCTION_MEMOIZER_H_
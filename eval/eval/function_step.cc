@@ -1,6 +1,7 @@
 #include "eval/eval/function_step.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -8,6 +9,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -20,11 +22,15 @@
 #include "base/function_descriptor.h"
 #include "base/kind.h"
 #include "common/casting.h"
+#include "common/memory.h"
+#include "common/native_type.h"
 #include "common/value.h"
+#include "common/value_kind.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
+#include "eval/eval/function_memoizer.h"
 #include "eval/internal/errors.h"
 #include "internal/status_macros.h"
 #include "runtime/activation_interface.h"
@@ -85,30 +91,52 @@ std::string ToLegacyKindName(absl::string_view type_name) {
   return std::string(type_name);
 }
 
-std::string CallArgTypeString(absl::Span<const cel::Value> args) {
+std::string CallArgTypeString(absl::Span<const cel::ValueKind> arg_kinds) {
   std::string call_sig_string = "";
 
-  for (size_t i = 0; i < args.size(); i++) {
-    const auto& arg = args[i];
+  for (size_t i = 0; i < arg_kinds.size(); i++) {
     if (!call_sig_string.empty()) {
       absl::StrAppend(&call_sig_string, ", ");
     }
-    absl::StrAppend(
-        &call_sig_string,
-        ToLegacyKindName(cel::KindToString(ValueKindToKind(arg->kind()))));
+    absl::StrAppend(&call_sig_string, ToLegacyKindName(cel::KindToString(
+                                          ValueKindToKind(arg_kinds[i]))));
   }
   return absl::StrCat("(", call_sig_string, ")");
 }
 
+// Error for a call without an overload matching its arguments. The message is
+// only formatted if the error is inspected, as it is often pruned by a logical
+// operator.
+class NoMatchingOverloadError final : public cel::LazyError {
+ public:
+  NoMatchingOverloadError(absl::string_view name,
+                          absl::Span<const cel::Value> args)
+      : name_(name) {
+    arg_kinds_.reserve(args.size());
+    for (const auto& arg : args) {
+      arg_kinds_.push_back(arg->kind());
+    }
+  }
+
+ private:
+  absl::Status Format() const override {
+    return cel::runtime_internal::CreateNoMatchingOverloadError(
+        absl::StrCat(name_, CallArgTypeString(arg_kinds_)));
+  }
+
+  std::string name_;
+  absl::InlinedVector<cel::ValueKind, 4> arg_kinds_;
+};
+
 // Convert partially unknown arguments to unknowns before passing to the
 // function.
 // TODO(issues/52): See if this can be refactored to remove the eager
 // arguments copy.
 // Argument and attribute spans are expected to be equal length.
-std::vector<cel::Value> CheckForPartialUnknowns(
+absl::InlinedVector<cel::Value, 4> CheckForPartialUnknowns(
     ExecutionFrame* frame, absl::Span<const cel::Value> args,
     absl::Span<const AttributeTrail> attrs) {
-  std::vector<cel::Value> result;
+  absl::InlinedVector<cel::Value, 4> result;
   result.reserve(args.size());
   for (size_t i = 0; i < args.size(); i++) {
     const AttributeTrail& trail = attrs.subspan(i, 1)[0];
@@ -144,6 +172,61 @@ bool IsUnknownFunctionResultError(const Value& result) {
 // resolve to a single function implementation and a descriptor or none.
 using ResolveResult = absl::optional<cel::FunctionOverloadReference>;
 
+// Monomorphic inline cache keyed by the kinds of the arguments to a call.
+//
+// Matching overloads only depends on the argument kinds, so the outcome for
+// the last combination of kinds seen by a step is kept in a single atomic
+// word: the kinds in the upper bits and a small payload in the lower bits.
+// Calls with more arguments than fit in the word are not cached.
+class KindSignatureCache {
+ public:
+  static constexpr size_t kMaxArguments = 7;
+  static constexpr int kPayloadBits = 21;
+  static constexpr uint64_t kMaxPayload = (uint64_t{1} << kPayloadBits) - 1;
+
+  KindSignatureCache() = default;
+
+  // Copies start out empty.
+  KindSignatureCache(const KindSignatureCache&) {}
+  KindSignatureCache& operator=(const KindSignatureCache&) = delete;
+
+  // Returns the key for `args`, or `absl::nullopt` if it can't be cached.
+  static absl::optional<uint64_t> Signature(
+      absl::Span<const cel::Value> args) {
+    if (args.size() > kMaxArguments) {
+      return absl::nullopt;
+    }
+    uint64_t signature = 0;
+    for (const auto& arg : args) {
+      signature = (signature << kKindBits) | static_cast<uint64_t>(arg->kind());
+    }
+    return signature;
+  }
+
+  absl::optional<uint64_t> Find(uint64_t signature) const {
+    uint64_t entry = entry_.load(std::memory_order_relaxed);
+    if ((entry & 1) == 0 || (entry >> (kPayloadBits + 1)) != signature) {
+      return absl::nullopt;
+    }
+    return (entry >> 1) & kMaxPayload;
+  }
+
+  void Store(uint64_t signature, uint64_t payload) const {
+    if (payload > kMaxPayload) {
+      return;
+    }
+    // The entry is self-contained, so relaxed ordering is sufficient.
+    entry_.store((signature << (kPayloadBits + 1)) | (payload << 1) | 1,
+                 std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr int kKindBits = 6;
+  static_assert(kMaxArguments * kKindBits + kPayloadBits + 1 <= 64);
+
+  mutable std::atomic<uint64_t> entry_{0};
+};
+
 // Implementation of ExpressionStep that finds suitable CelFunction overload and
 // invokes it. Abstract base class standardizes behavior between lazy and eager
 // function bindings. Derived classes provide ResolveFunction behavior.
@@ -173,15 +256,20 @@ class AbstractFunctionStep : public ExpressionStepBase {
  protected:
   std::string name_;
   size_t num_arguments_;
+  // Memoizes calls to pure overloads, if set.
+  std::shared_ptr<const FunctionMemoizer> memoizer_;
 };
 
 inline absl::StatusOr<Value> Invoke(
     const cel::FunctionOverloadReference& overload, int64_t expr_id,
     absl::Span<const cel::Value> args, ExecutionFrameBase& frame) {
+  CEL_RETURN_IF_ERROR(frame.AddCost(1));
   FunctionEvaluationContext context(frame.value_manager());
 
   CEL_ASSIGN_OR_RETURN(Value result,
                        overload.implementation.Invoke(context, args));
+  // Functions such as list concatenation may allocate without bound.
+  CEL_RETURN_IF_ERROR(frame.CheckMemoryBudget());
 
   if (frame.unknown_function_results_enabled() &&
       IsUnknownFunctionResultError(result)) {
@@ -191,6 +279,29 @@ inline absl::StatusOr<Value> Invoke(
   return result;
 }
 
+// Like Invoke, but answers calls of pure overloads from `memoizer` if it is
+// set and has the result of an earlier call with the same arguments.
+absl::StatusOr<Value> InvokeMemoized(
+    const FunctionMemoizer* memoizer,
+    const cel::FunctionOverloadReference& overload, int64_t expr_id,
+    absl::Span<const cel::Value> args, ExecutionFrameBase& frame) {
+  if (memoizer == nullptr || !overload.descriptor.is_pure()) {
+    return Invoke(overload, expr_id, args, frame);
+  }
+  absl::optional<std::string> key =
+      FunctionMemoizer::MakeKey(overload.descriptor, args);
+  if (!key.has_value()) {
+    return Invoke(overload, expr_id, args, frame);
+  }
+  if (absl::optional<Value> memoized = memoizer->Find(frame, *key);
+      memoized.has_value()) {
+    return *std::move(memoized);
+  }
+  CEL_ASSIGN_OR_RETURN(Value result, Invoke(overload, expr_id, args, frame));
+  memoizer->Store(frame, *std::move(key), result);
+  return result;
+}
+
 Value NoOverloadResult(absl::string_view name,
                        absl::Span<const cel::Value> args,
                        ExecutionFrameBase& frame) {
@@ -216,9 +327,10 @@ Value NoOverloadResult(absl::string_view name,
 
   // If no errors or unknowns in input args, create new CelError for missing
   // overload.
-  return frame.value_manager().CreateErrorValue(
-      cel::runtime_internal::CreateNoMatchingOverloadError(
-          absl::StrCat(name, CallArgTypeString(args))));
+  return cel::ErrorValue(
+      frame.value_manager()
+          .GetMemoryManager()
+          .MakeShared<const NoMatchingOverloadError>(name, args));
 }
 
 absl::StatusOr<Value> AbstractFunctionStep::DoEvaluate(
@@ -226,7 +338,7 @@ absl::StatusOr<Value> AbstractFunctionStep::DoEvaluate(
   // Create Span object that contains input arguments to the function.
   auto input_args = frame->value_stack().GetSpan(num_arguments_);
 
-  std::vector<cel::Value> unknowns_args;
+  absl::InlinedVector<cel::Value, 4> unknowns_args;
   // Preprocess args. If an argument is partially unknown, convert it to an
   // unknown attribute set.
   if (frame->enable_unknowns()) {
@@ -242,7 +354,8 @@ absl::StatusOr<Value> AbstractFunctionStep::DoEvaluate(
   // Overload found and is allowed to consume the arguments.
   if (matched_function.has_value() &&
       ShouldAcceptOverload(matched_function->descriptor, input_args)) {
-    return Invoke(*matched_function, id(), input_args, *frame);
+    return InvokeMemoized(memoizer_.get(), *matched_function, id(),
+                          input_args, *frame);
   }
 
   return NoOverloadResult(name_, input_args, *frame);
@@ -265,20 +378,40 @@ absl::Status AbstractFunctionStep::Evaluate(ExecutionFrame* frame) const {
 
 absl::StatusOr<ResolveResult> ResolveStatic(
     absl::Span<const cel::Value> input_args,
-    absl::Span<const cel::FunctionOverloadReference> overloads) {
+    absl::Span<const cel::FunctionOverloadReference> overloads,
+    const KindSignatureCache& cache) {
+  // The payload is the index of the matching overload, or kNoMatch.
+  constexpr uint64_t kNoMatch = KindSignatureCache::kMaxPayload;
+
+  absl::optional<uint64_t> signature =
+      KindSignatureCache::Signature(input_args);
+  if (signature.has_value()) {
+    if (auto index = cache.Find(*signature); index.has_value()) {
+      if (*index == kNoMatch) {
+        return absl::nullopt;
+      }
+      return ResolveResult(overloads[*index]);
+    }
+  }
+
   ResolveResult result = absl::nullopt;
+  uint64_t index = kNoMatch;
 
-  for (const auto& overload : overloads) {
-    if (ArgumentKindsMatch(overload.descriptor, input_args)) {
+  for (size_t i = 0; i < overloads.size(); ++i) {
+    if (ArgumentKindsMatch(overloads[i].descriptor, input_args)) {
       // More than one overload matches our arguments.
       if (result.has_value()) {
         return absl::Status(absl::StatusCode::kInternal,
                             "Cannot resolve overloads");
       }
 
-      result.emplace(overload);
+      result.emplace(overloads[i]);
+      index = i;
     }
   }
+  if (signature.has_value()) {
+    cache.Store(*signature, index);
+  }
   return result;
 }
 
@@ -286,7 +419,38 @@ absl::StatusOr<ResolveResult> ResolveLazy(
     absl::Span<const cel::Value> input_args, absl::string_view name,
     bool receiver_style,
     absl::Span<const cel::FunctionRegistry::LazyOverload> providers,
-    const ExecutionFrameBase& frame) {
+    const ExecutionFrameBase& frame, const KindSignatureCache& cache) {
+  // The payload is the set of providers whose descriptors match the argument
+  // kinds. The implementation the providers return depends on the activation,
+  // so it is only reused within an evaluation, where `cache` identifies the
+  // call site.
+  absl::optional<uint64_t> signature;
+  if (providers.size() <= KindSignatureCache::kPayloadBits) {
+    signature = KindSignatureCache::Signature(input_args);
+  }
+  absl::optional<uint64_t> candidates;
+  if (signature.has_value()) {
+    const auto& resolved = frame.lazy_overloads();
+    if (auto it = resolved.find(std::make_pair(&cache, *signature));
+        it != resolved.end()) {
+      return it->second;
+    }
+    candidates = cache.Find(*signature);
+    if (!candidates.has_value()) {
+      uint64_t matching = 0;
+      for (size_t i = 0; i < providers.size(); ++i) {
+        if (ArgumentKindsMatch(providers[i].descriptor, input_args)) {
+          matching |= uint64_t{1} << i;
+        }
+      }
+      cache.Store(*signature, matching);
+      candidates = matching;
+    }
+    if (*candidates == 0) {
+      return absl::nullopt;
+    }
+  }
+
   ResolveResult result = absl::nullopt;
 
   std::vector<cel::Kind> arg_types(input_args.size());
@@ -298,11 +462,14 @@ absl::StatusOr<ResolveResult> ResolveLazy(
   cel::FunctionDescriptor matcher{name, receiver_style, arg_types};
 
   const cel::ActivationInterface& activation = frame.activation();
-  for (auto provider : providers) {
+  for (size_t i = 0; i < providers.size(); ++i) {
+    const auto& provider = providers[i];
     // The LazyFunctionStep has so far only resolved by function shape, check
     // that the runtime argument kinds agree with the specific descriptor for
     // the provider candidates.
-    if (!ArgumentKindsMatch(provider.descriptor, input_args)) {
+    if (candidates.has_value()
+            ? ((*candidates >> i) & 1) == 0
+            : !ArgumentKindsMatch(provider.descriptor, input_args)) {
       continue;
     }
 
@@ -319,24 +486,53 @@ absl::StatusOr<ResolveResult> ResolveLazy(
     }
   }
 
+  if (signature.has_value()) {
+    frame.lazy_overloads().try_emplace(std::make_pair(&cache, *signature),
+                                       result);
+  }
   return result;
 }
 
+// An overload created while planning, which the function step owns.
+struct OwnedOverload {
+  cel::FunctionDescriptor descriptor;
+  std::shared_ptr<const cel::Function> implementation;
+};
+
 class EagerFunctionStep : public AbstractFunctionStep {
  public:
   EagerFunctionStep(std::vector<cel::FunctionOverloadReference> overloads,
-                    const std::string& name, size_t num_args, int64_t expr_id)
+                    const std::string& name, size_t num_args, int64_t expr_id,
+                    std::shared_ptr<const OwnedOverload> owned = nullptr)
       : AbstractFunctionStep(name, num_args, expr_id),
-        overloads_(std::move(overloads)) {}
+        overloads_(std::move(overloads)),
+        owned_(std::move(owned)) {}
 
   absl::StatusOr<ResolveResult> ResolveFunction(
       absl::Span<const cel::Value> input_args,
       const ExecutionFrame* frame) const override {
-    return ResolveStatic(input_args, overloads_);
+    return ResolveStatic(input_args, overloads_, cache_);
+  }
+
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<EagerFunctionStep>();
+  }
+
+  // Returns a copy of this step with calls memoized by `memoizer`.
+  std::unique_ptr<EagerFunctionStep> WithMemoizer(
+      std::shared_ptr<const FunctionMemoizer> memoizer) const {
+    auto step = std::make_unique<EagerFunctionStep>(overloads_, name_,
+                                                    num_arguments_, id(),
+                                                    owned_);
+    step->memoizer_ = std::move(memoizer);
+    return step;
   }
 
  private:
   std::vector<cel::FunctionOverloadReference> overloads_;
+  // Referenced by `overloads_`, if set.
+  std::shared_ptr<const OwnedOverload> owned_;
+  KindSignatureCache cache_;
 };
 
 class LazyFunctionStep : public AbstractFunctionStep {
@@ -358,26 +554,32 @@ class LazyFunctionStep : public AbstractFunctionStep {
  private:
   bool receiver_style_;
   std::vector<cel::FunctionRegistry::LazyOverload> providers_;
+  KindSignatureCache cache_;
 };
 
 absl::StatusOr<ResolveResult> LazyFunctionStep::ResolveFunction(
     absl::Span<const cel::Value> input_args,
     const ExecutionFrame* frame) const {
-  return ResolveLazy(input_args, name_, receiver_style_, providers_, *frame);
+  return ResolveLazy(input_args, name_, receiver_style_, providers_, *frame,
+                     cache_);
 }
 
 class StaticResolver {
  public:
-  explicit StaticResolver(std::vector<cel::FunctionOverloadReference> overloads)
-      : overloads_(std::move(overloads)) {}
+  explicit StaticResolver(std::vector<cel::FunctionOverloadReference> overloads,
+                          std::shared_ptr<const OwnedOverload> owned = nullptr)
+      : overloads_(std::move(overloads)), owned_(std::move(owned)) {}
 
   absl::StatusOr<ResolveResult> Resolve(ExecutionFrameBase& frame,
                                         absl::Span<const Value> input) const {
-    return ResolveStatic(input, overloads_);
+    return ResolveStatic(input, overloads_, cache_);
   }
 
  private:
   std::vector<cel::FunctionOverloadReference> overloads_;
+  // Referenced by `overloads_`, if set.
+  std::shared_ptr<const OwnedOverload> owned_;
+  KindSignatureCache cache_;
 };
 
 class LazyResolver {
@@ -391,29 +593,32 @@ class LazyResolver {
 
   absl::StatusOr<ResolveResult> Resolve(ExecutionFrameBase& frame,
                                         absl::Span<const Value> input) const {
-    return ResolveLazy(input, name_, receiver_style_, providers_, frame);
+    return ResolveLazy(input, name_, receiver_style_, providers_, frame,
+                       cache_);
   }
 
  private:
   std::vector<cel::FunctionRegistry::LazyOverload> providers_;
   std::string name_;
   bool receiver_style_;
+  KindSignatureCache cache_;
 };
 
 template <typename Resolver>
-class DirectFunctionStepImpl : public DirectExpressionStep {
+class DirectFunctionStepImpl : public FastDirectExpressionStep {
  public:
   DirectFunctionStepImpl(
       int64_t expr_id, const std::string& name,
       std::vector<std::unique_ptr<DirectExpressionStep>> arg_steps,
       Resolver&& resolver)
-      : DirectExpressionStep(expr_id),
+      : FastDirectExpressionStep(expr_id),
         name_(name),
         arg_steps_(std::move(arg_steps)),
         resolver_(std::forward<Resolver>(resolver)) {}
 
-  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
-                        AttributeTrail& trail) const override {
+  bool EvaluateFast(ExecutionFrameBase& frame, cel::Value& result,
+                    AttributeTrail& trail,
+                    absl::Status& status) const override {
     absl::InlinedVector<Value, 2> args;
     absl::InlinedVector<AttributeTrail, 2> arg_trails;
 
@@ -421,8 +626,10 @@ class DirectFunctionStepImpl : public DirectExpressionStep {
     arg_trails.resize(arg_steps_.size());
 
     for (size_t i = 0; i < arg_steps_.size(); i++) {
-      CEL_RETURN_IF_ERROR(
-          arg_steps_[i]->Evaluate(frame, args[i], arg_trails[i]));
+      if (!arg_steps_[i]->EvaluateFast(frame, args[i], arg_trails[i],
+                                       status)) {
+        return false;
+      }
     }
 
     if (frame.unknown_processing_enabled()) {
@@ -435,20 +642,28 @@ class DirectFunctionStepImpl : public DirectExpressionStep {
       }
     }
 
-    CEL_ASSIGN_OR_RETURN(ResolveResult resolved_function,
-                         resolver_.Resolve(frame, args));
-
-    if (resolved_function.has_value() &&
-        ShouldAcceptOverload(resolved_function->descriptor, args)) {
-      CEL_ASSIGN_OR_RETURN(result,
-                           Invoke(*resolved_function, expr_id_, args, frame));
+    absl::StatusOr<ResolveResult> resolved_function =
+        resolver_.Resolve(frame, args);
+    if (ABSL_PREDICT_FALSE(!resolved_function.ok())) {
+      status = std::move(resolved_function).status();
+      return false;
+    }
 
-      return absl::OkStatus();
+    if (resolved_function->has_value() &&
+        ShouldAcceptOverload((*resolved_function)->descriptor, args)) {
+      absl::StatusOr<Value> value = InvokeMemoized(
+          memoizer_.get(), **resolved_function, expr_id_, args, frame);
+      if (ABSL_PREDICT_FALSE(!value.ok())) {
+        status = std::move(value).status();
+        return false;
+      }
+      result = *std::move(value);
+      return true;
     }
 
     result = NoOverloadResult(name_, args, frame);
 
-    return absl::OkStatus();
+    return true;
   }
 
   absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
@@ -466,15 +681,40 @@ class DirectFunctionStepImpl : public DirectExpressionStep {
     return std::move(arg_steps_);
   }
 
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<DirectFunctionStepImpl>();
+  }
+
+  void set_memoizer(std::shared_ptr<const FunctionMemoizer> memoizer) {
+    memoizer_ = std::move(memoizer);
+  }
+
  private:
   friend Resolver;
   std::string name_;
   std::vector<std::unique_ptr<DirectExpressionStep>> arg_steps_;
   Resolver resolver_;
+  // Memoizes calls to pure overloads, if set.
+  std::shared_ptr<const FunctionMemoizer> memoizer_;
 };
 
 }  // namespace
 
+absl::StatusOr<Value> InvokeFunctionOverloads(
+    ExecutionFrameBase& frame, int64_t expr_id, absl::string_view name,
+    absl::Span<const cel::FunctionOverloadReference> overloads,
+    absl::Span<const Value> args) {
+  // Only used off the fast path, so not worth caching.
+  KindSignatureCache cache;
+  CEL_ASSIGN_OR_RETURN(ResolveResult resolved_function,
+                       ResolveStatic(args, overloads, cache));
+  if (resolved_function.has_value() &&
+      ShouldAcceptOverload(resolved_function->descriptor, args)) {
+    return Invoke(*resolved_function, expr_id, args, frame);
+  }
+  return NoOverloadResult(name, args, frame);
+}
+
 std::unique_ptr<DirectExpressionStep> CreateDirectFunctionStep(
     int64_t expr_id, const cel::ast_internal::Call& call,
     std::vector<std::unique_ptr<DirectExpressionStep>> deps,
@@ -484,6 +724,32 @@ std::unique_ptr<DirectExpressionStep> CreateDirectFunctionStep(
       StaticResolver(std::move(overloads)));
 }
 
+std::unique_ptr<DirectExpressionStep> CreateDirectFunctionStep(
+    int64_t expr_id, const cel::ast_internal::Call& call,
+    std::vector<std::unique_ptr<DirectExpressionStep>> deps,
+    cel::FunctionDescriptor descriptor,
+    std::shared_ptr<const cel::Function> implementation) {
+  auto owned = std::make_shared<const OwnedOverload>(
+      OwnedOverload{std::move(descriptor), std::move(implementation)});
+  std::vector<cel::FunctionOverloadReference> overloads{
+      {owned->descriptor, *owned->implementation}};
+  return std::make_unique<DirectFunctionStepImpl<StaticResolver>>(
+      expr_id, call.function(), std::move(deps),
+      StaticResolver(std::move(overloads), std::move(owned)));
+}
+
+std::unique_ptr<DirectExpressionStep> MemoizeDirectFunctionStep(
+    std::unique_ptr<DirectExpressionStep> step,
+    std::shared_ptr<const FunctionMemoizer> memoizer) {
+  using EagerDirectFunctionStep = DirectFunctionStepImpl<StaticResolver>;
+  if (step->GetNativeTypeId() ==
+      cel::NativeTypeId::For<EagerDirectFunctionStep>()) {
+    static_cast<EagerDirectFunctionStep&>(*step).set_memoizer(
+        std::move(memoizer));
+  }
+  return step;
+}
+
 std::unique_ptr<DirectExpressionStep> CreateDirectLazyFunctionStep(
     int64_t expr_id, const cel::ast_internal::Call& call,
     std::vector<std::unique_ptr<DirectExpressionStep>> deps,
@@ -513,4 +779,29 @@ absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateFunctionStep(
                                              num_args, expr_id);
 }
 
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateFunctionStep(
+    const cel::ast_internal::Call& call_expr, int64_t expr_id,
+    cel::FunctionDescriptor descriptor,
+    std::shared_ptr<const cel::Function> implementation) {
+  bool receiver_style = call_expr.has_target();
+  size_t num_args = call_expr.args().size() + (receiver_style ? 1 : 0);
+  auto owned = std::make_shared<const OwnedOverload>(
+      OwnedOverload{std::move(descriptor), std::move(implementation)});
+  std::vector<cel::FunctionOverloadReference> overloads{
+      {owned->descriptor, *owned->implementation}};
+  return std::make_unique<EagerFunctionStep>(std::move(overloads),
+                                             call_expr.function(), num_args,
+                                             expr_id, std::move(owned));
+}
+
+std::unique_ptr<const ExpressionStep> MemoizeFunctionStep(
+    std::unique_ptr<const ExpressionStep> step,
+    std::shared_ptr<const FunctionMemoizer> memoizer) {
+  if (step->GetNativeTypeId() != cel::NativeTypeId::For<EagerFunctionStep>()) {
+    return step;
+  }
+  return static_cast<const EagerFunctionStep&>(*step).WithMemoizer(
+      std::move(memoizer));
+}
+
 }  // namespace google::api::expr::runtime
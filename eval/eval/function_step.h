@@ -6,9 +6,15 @@
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/ast_internal/expr.h"
+#include "base/function.h"
+#include "base/function_descriptor.h"
+#include "common/value.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "eval/eval/function_memoizer.h"
 #include "runtime/function_overload_reference.h"
 #include "runtime/function_registry.h"
 
@@ -22,6 +28,20 @@ std::unique_ptr<DirectExpressionStep> CreateDirectFunctionStep(
     std::vector<std::unique_ptr<DirectExpressionStep>> deps,
     std::vector<cel::FunctionOverloadReference> overloads);
 
+// Like CreateDirectFunctionStep, but for a single overload owned by the step,
+// such as one created while planning the call.
+std::unique_ptr<DirectExpressionStep> CreateDirectFunctionStep(
+    int64_t expr_id, const cel::ast_internal::Call& call,
+    std::vector<std::unique_ptr<DirectExpressionStep>> deps,
+    cel::FunctionDescriptor descriptor,
+    std::shared_ptr<const cel::Function> implementation);
+
+// Memoizes the calls of `step` to pure overloads with `memoizer`, if it is a
+// step created by CreateDirectFunctionStep. Otherwise returns `step` as is.
+std::unique_ptr<DirectExpressionStep> MemoizeDirectFunctionStep(
+    std::unique_ptr<DirectExpressionStep> step,
+    std::shared_ptr<const FunctionMemoizer> memoizer);
+
 // Factory method for Call-based execution step where the function has been
 // statically resolved from a set of lazy functions configured in the
 // CelFunctionRegistry.
@@ -30,6 +50,18 @@ std::unique_ptr<DirectExpressionStep> CreateDirectLazyFunctionStep(
     std::vector<std::unique_ptr<DirectExpressionStep>> deps,
     std::vector<cel::FunctionRegistry::LazyOverload> providers);
 
+// Resolves and invokes the overload from `overloads` matching already
+// evaluated `args`, with the same handling of errors, unknowns and missing
+// overloads as the function steps. Partially unknown arguments must already
+// have been replaced with unknown sets.
+//
+// Intended as the fallback for specialized steps which only handle a subset
+// of the argument kinds inline.
+absl::StatusOr<cel::Value> InvokeFunctionOverloads(
+    ExecutionFrameBase& frame, int64_t expr_id, absl::string_view name,
+    absl::Span<const cel::FunctionOverloadReference> overloads,
+    absl::Span<const cel::Value> args);
+
 // Factory method for Call-based execution step where the function will be
 // resolved at runtime (lazily) from an input Activation.
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateFunctionStep(
@@ -43,6 +75,19 @@ absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateFunctionStep(
     const cel::ast_internal::Call& call, int64_t expr_id,
     std::vector<cel::FunctionOverloadReference> overloads);
 
+// Like CreateFunctionStep, but for a single overload owned by the step, such
+// as one created while planning the call.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateFunctionStep(
+    const cel::ast_internal::Call& call, int64_t expr_id,
+    cel::FunctionDescriptor descriptor,
+    std::shared_ptr<const cel::Function> implementation);
+
+// Like MemoizeDirectFunctionStep, for steps created by the eager overloads of
+// CreateFunctionStep.
+std::unique_ptr<const ExpressionStep> MemoizeFunctionStep(
+    std::unique_ptr<const ExpressionStep> step,
+    std::shared_ptr<const FunctionMemoizer> memoizer);
+
 }  // namespace google::api::expr::runtime
 
 #endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_FUNCTION_STEP_H_
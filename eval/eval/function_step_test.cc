@@ -516,6 +516,56 @@ TEST_P(FunctionStepTest, LazyFunctionOverloadingTest) {
   EXPECT_TRUE(value.BoolOrDie());
 }
 
+TEST_P(FunctionStepTest, RepeatedCallsWithChangingArgumentKinds) {
+  CelFunctionRegistry registry;
+  ASSERT_OK(registry.Register(
+      PortableUnaryFunctionAdapter<int64_t, int64_t>::Create(
+          "Floor", false, [](google::protobuf::Arena*, int64_t val) { return val; })));
+  ASSERT_OK(registry.Register(
+      PortableUnaryFunctionAdapter<double, double>::Create(
+          "Floor", false,
+          [](google::protobuf::Arena*, double val) { return std::floor(val); })));
+
+  Ident ident;
+  ident.set_name("param");
+  Call call;
+  call.mutable_args().emplace_back();
+  call.set_function("Floor");
+
+  ExecutionPath path;
+  ASSERT_OK_AND_ASSIGN(auto step0, CreateIdentStep(ident, GetExprId()));
+  ASSERT_OK_AND_ASSIGN(auto step1, MakeTestFunctionStep(call, registry));
+  path.push_back(std::move(step0));
+  path.push_back(std::move(step1));
+
+  std::unique_ptr<CelExpressionFlatImpl> impl = GetExpression(std::move(path));
+  google::protobuf::Arena arena;
+
+  // Overload resolution is cached per step by argument kinds; each change of
+  // kinds must still resolve to the right overload.
+  for (int i = 0; i < 2; ++i) {
+    Activation activation;
+    activation.InsertValue("param", CelValue::CreateInt64(2));
+    ASSERT_OK_AND_ASSIGN(CelValue value, impl->Evaluate(activation, &arena));
+    ASSERT_TRUE(value.IsInt64());
+    EXPECT_EQ(value.Int64OrDie(), 2);
+
+    activation.RemoveValueEntry("param");
+    activation.InsertValue("param", CelValue::CreateDouble(2.5));
+    ASSERT_OK_AND_ASSIGN(value, impl->Evaluate(activation, &arena));
+    ASSERT_TRUE(value.IsDouble());
+    EXPECT_EQ(value.DoubleOrDie(), 2.0);
+
+    activation.RemoveValueEntry("param");
+    activation.InsertValue("param", CelValue::CreateBool(true));
+    ASSERT_OK_AND_ASSIGN(value, impl->Evaluate(activation, &arena));
+    ASSERT_TRUE(value.IsError());
+    EXPECT_THAT(*value.ErrorOrDie(),
+                StatusIs(absl::StatusCode::kUnknown,
+                         testing::HasSubstr("Floor(bool)")));
+  }
+}
+
 // Test situation when no overloads match input arguments during evaluation
 // and at least one of arguments is error.
 TEST_P(FunctionStepTest,
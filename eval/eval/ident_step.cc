@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "absl/base/nullability.h"
+#include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -20,6 +21,7 @@
 #include "eval/eval/expression_step_base.h"
 #include "eval/internal/errors.h"
 #include "internal/status_macros.h"
+#include "runtime/variable_layout.h"
 
 namespace google::api::expr::runtime {
 
@@ -29,73 +31,121 @@ using ::cel::Value;
 using ::cel::ValueView;
 using ::cel::runtime_internal::CreateError;
 
+// Slot assigned to a free variable in the program's variable layout.
+//
+// layout is null if the step was planned without a layout.
+struct VariableSlot {
+  absl::Nullable<const cel::VariableLayout*> layout = nullptr;
+  size_t index = 0;
+};
+
+template <bool kAttributeTracking>
 class IdentStep : public ExpressionStepBase {
  public:
-  IdentStep(absl::string_view name, int64_t expr_id)
-      : ExpressionStepBase(expr_id), name_(name) {}
+  IdentStep(absl::string_view name, VariableSlot slot, int64_t expr_id)
+      : ExpressionStepBase(expr_id), name_(name), slot_(slot) {}
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
 
  private:
-  struct IdentResult {
-    ValueView value;
-    AttributeTrail trail;
-  };
-
   std::string name_;
+  VariableSlot slot_;
 };
 
-absl::Status LookupIdent(const std::string& name, ExecutionFrameBase& frame,
-                         Value& result, AttributeTrail& attribute) {
-  if (frame.attribute_tracking_enabled()) {
-    attribute = AttributeTrail(name);
-    if (frame.missing_attribute_errors_enabled() &&
-        frame.attribute_utility().CheckForMissingAttribute(attribute)) {
-      CEL_ASSIGN_OR_RETURN(
-          result, frame.attribute_utility().CreateMissingAttributeError(
-                      attribute.attribute()));
-      return absl::OkStatus();
+// Looks up the named variable in the activation.
+//
+// If kAttributeTracking is false, the program was planned without unknown
+// or missing attribute support and the attribute trail is left untouched.
+//
+// Follows `DirectExpressionStep::EvaluateFast`: returns false and assigns
+// `status` on failure.
+template <bool kAttributeTracking>
+bool LookupIdent(const std::string& name, VariableSlot slot,
+                 ExecutionFrameBase& frame, Value& result,
+                 AttributeTrail& attribute, absl::Status& status) {
+  if constexpr (kAttributeTracking) {
+    if (frame.attribute_tracking_enabled()) {
+      attribute = AttributeTrail(name);
+      if (frame.missing_attribute_errors_enabled() &&
+          frame.attribute_utility().CheckForMissingAttribute(attribute)) {
+        absl::StatusOr<cel::ErrorValue> error =
+            frame.attribute_utility().CreateMissingAttributeError(
+                attribute.attribute());
+        if (!error.ok()) {
+          status = std::move(error).status();
+          return false;
+        }
+        result = *std::move(error);
+        return true;
+      }
+      if (frame.unknown_processing_enabled() &&
+          frame.attribute_utility().CheckForUnknownExact(attribute)) {
+        result =
+            frame.attribute_utility().CreateUnknownSet(attribute.attribute());
+        return true;
+      }
     }
-    if (frame.unknown_processing_enabled() &&
-        frame.attribute_utility().CheckForUnknownExact(attribute)) {
-      result =
-          frame.attribute_utility().CreateUnknownSet(attribute.attribute());
-      return absl::OkStatus();
+  }
+
+  if (slot.layout != nullptr) {
+    if (absl::Nullable<const Value*> value =
+            frame.activation().FindVariableBySlot(*slot.layout, slot.index);
+        value != nullptr) {
+      result = *value;
+      return true;
     }
   }
 
-  CEL_ASSIGN_OR_RETURN(auto value, frame.activation().FindVariable(
-                                       frame.value_manager(), name, result));
+  auto value =
+      frame.activation().FindVariable(frame.value_manager(), name, result);
+  if (!value.ok()) {
+    status = std::move(value).status();
+    return false;
+  }
 
-  if (value.has_value()) {
-    result = *value;
-    return absl::OkStatus();
+  if (value->has_value()) {
+    result = **value;
+    return true;
   }
 
   result = frame.value_manager().CreateErrorValue(CreateError(
       absl::StrCat("No value with name \"", name, "\" found in Activation")));
 
-  return absl::OkStatus();
+  return true;
 }
 
-absl::Status IdentStep::Evaluate(ExecutionFrame* frame) const {
+template <bool kAttributeTracking>
+absl::Status IdentStep<kAttributeTracking>::Evaluate(
+    ExecutionFrame* frame) const {
   Value value;
   AttributeTrail attribute;
 
-  CEL_RETURN_IF_ERROR(LookupIdent(name_, *frame, value, attribute));
+  absl::Status status;
+  if (!LookupIdent<kAttributeTracking>(name_, slot_, *frame, value, attribute,
+                                       status)) {
+    return status;
+  }
 
-  frame->value_stack().Push(std::move(value), std::move(attribute));
+  if constexpr (kAttributeTracking) {
+    frame->value_stack().Push(std::move(value), std::move(attribute));
+  } else {
+    frame->value_stack().Push(std::move(value));
+  }
 
   return absl::OkStatus();
 }
 
+absl::Status SlotOutOfScopeError(absl::string_view name) {
+  return absl::InternalError(
+      absl::StrCat("Comprehension variable accessed out of scope: ", name));
+}
+
 absl::StatusOr<absl::Nonnull<const ComprehensionSlots::Slot*>> LookupSlot(
     absl::string_view name, size_t slot_index, ExecutionFrameBase& frame) {
   const ComprehensionSlots::Slot* slot =
       frame.comprehension_slots().Get(slot_index);
   if (slot == nullptr) {
-    return absl::InternalError(
-        absl::StrCat("Comprehension variable accessed out of scope: ", name));
+    return SlotOutOfScopeError(name);
   }
   return slot;
 }
@@ -119,37 +169,46 @@ class SlotStep : public ExpressionStepBase {
   size_t slot_index_;
 };
 
-class DirectIdentStep : public DirectExpressionStep {
+template <bool kAttributeTracking>
+class DirectIdentStep : public FastDirectExpressionStep {
  public:
-  DirectIdentStep(absl::string_view name, int64_t expr_id)
-      : DirectExpressionStep(expr_id), name_(name) {}
-
-  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
-                        AttributeTrail& attribute) const override {
-    return LookupIdent(name_, frame, result, attribute);
+  DirectIdentStep(absl::string_view name, VariableSlot slot, int64_t expr_id)
+      : FastDirectExpressionStep(expr_id), name_(name), slot_(slot) {}
+
+  bool EvaluateFast(ExecutionFrameBase& frame, Value& result,
+                    AttributeTrail& attribute,
+                    absl::Status& status) const override {
+    return LookupIdent<kAttributeTracking>(name_, slot_, frame, result,
+                                           attribute, status);
   }
 
  private:
   std::string name_;
+  VariableSlot slot_;
 };
 
-class DirectSlotStep : public DirectExpressionStep {
+class DirectSlotStep : public FastDirectExpressionStep {
  public:
   DirectSlotStep(std::string name, size_t slot_index, int64_t expr_id)
-      : DirectExpressionStep(expr_id),
+      : FastDirectExpressionStep(expr_id),
         name_(std::move(name)),
         slot_index_(slot_index) {}
 
-  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
-                        AttributeTrail& attribute) const override {
-    CEL_ASSIGN_OR_RETURN(const ComprehensionSlots::Slot* slot,
-                         LookupSlot(name_, slot_index_, frame));
+  bool EvaluateFast(ExecutionFrameBase& frame, Value& result,
+                    AttributeTrail& attribute,
+                    absl::Status& status) const override {
+    const ComprehensionSlots::Slot* slot =
+        frame.comprehension_slots().Get(slot_index_);
+    if (ABSL_PREDICT_FALSE(slot == nullptr)) {
+      status = SlotOutOfScopeError(name_);
+      return false;
+    }
 
     if (frame.attribute_tracking_enabled()) {
       attribute = slot->attribute;
     }
     result = slot->value;
-    return absl::OkStatus();
+    return true;
   }
 
  private:
@@ -160,8 +219,26 @@ class DirectSlotStep : public DirectExpressionStep {
 }  // namespace
 
 std::unique_ptr<DirectExpressionStep> CreateDirectIdentStep(
-    absl::string_view identifier, int64_t expr_id) {
-  return std::make_unique<DirectIdentStep>(identifier, expr_id);
+    absl::string_view identifier, int64_t expr_id,
+    bool enable_attribute_tracking) {
+  if (!enable_attribute_tracking) {
+    return std::make_unique<DirectIdentStep<false>>(identifier, VariableSlot{},
+                                                    expr_id);
+  }
+  return std::make_unique<DirectIdentStep<true>>(identifier, VariableSlot{},
+                                                 expr_id);
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectIdentStep(
+    absl::string_view identifier, int64_t expr_id,
+    bool enable_attribute_tracking,
+    absl::Nonnull<const cel::VariableLayout*> variable_layout,
+    size_t variable_slot) {
+  VariableSlot slot{variable_layout, variable_slot};
+  if (!enable_attribute_tracking) {
+    return std::make_unique<DirectIdentStep<false>>(identifier, slot, expr_id);
+  }
+  return std::make_unique<DirectIdentStep<true>>(identifier, slot, expr_id);
 }
 
 std::unique_ptr<DirectExpressionStep> CreateDirectSlotIdentStep(
@@ -171,8 +248,27 @@ std::unique_ptr<DirectExpressionStep> CreateDirectSlotIdentStep(
 }
 
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateIdentStep(
-    const cel::ast_internal::Ident& ident_expr, int64_t expr_id) {
-  return std::make_unique<IdentStep>(ident_expr.name(), expr_id);
+    const cel::ast_internal::Ident& ident_expr, int64_t expr_id,
+    bool enable_attribute_tracking) {
+  if (!enable_attribute_tracking) {
+    return std::make_unique<IdentStep<false>>(ident_expr.name(),
+                                              VariableSlot{}, expr_id);
+  }
+  return std::make_unique<IdentStep<true>>(ident_expr.name(), VariableSlot{},
+                                           expr_id);
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateIdentStep(
+    const cel::ast_internal::Ident& ident_expr, int64_t expr_id,
+    bool enable_attribute_tracking,
+    absl::Nonnull<const cel::VariableLayout*> variable_layout,
+    size_t variable_slot) {
+  VariableSlot slot{variable_layout, variable_slot};
+  if (!enable_attribute_tracking) {
+    return std::make_unique<IdentStep<false>>(ident_expr.name(), slot,
+                                              expr_id);
+  }
+  return std::make_unique<IdentStep<true>>(ident_expr.name(), slot, expr_id);
 }
 
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateIdentStepForSlot(
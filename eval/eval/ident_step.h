@@ -1,26 +1,56 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_IDENT_STEP_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_IDENT_STEP_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
+#include "absl/base/nullability.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "base/ast_internal/expr.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "runtime/variable_layout.h"
 
 namespace google::api::expr::runtime {
 
+// If enable_attribute_tracking is false, the returned step never constructs
+// attribute trails. This is only valid if the program is evaluated with
+// unknown processing and missing attribute errors disabled.
 std::unique_ptr<DirectExpressionStep> CreateDirectIdentStep(
-    absl::string_view identifier, int64_t expr_id);
+    absl::string_view identifier, int64_t expr_id,
+    bool enable_attribute_tracking = true);
+
+// Variant that first attempts to resolve the variable by its slot in the
+// program's variable layout (see cel::SlotActivation). The layout must outlive
+// the returned step.
+std::unique_ptr<DirectExpressionStep> CreateDirectIdentStep(
+    absl::string_view identifier, int64_t expr_id,
+    bool enable_attribute_tracking,
+    absl::Nonnull<const cel::VariableLayout*> variable_layout,
+    size_t variable_slot);
 
 std::unique_ptr<DirectExpressionStep> CreateDirectSlotIdentStep(
     absl::string_view identifier, size_t slot_index, int64_t expr_id);
 
 // Factory method for Ident - based Execution step
+//
+// If enable_attribute_tracking is false, the returned step never constructs
+// attribute trails. This is only valid if the program is evaluated with
+// unknown processing and missing attribute errors disabled.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateIdentStep(
+    const cel::ast_internal::Ident& ident, int64_t expr_id,
+    bool enable_attribute_tracking = true);
+
+// Variant that first attempts to resolve the variable by its slot in the
+// program's variable layout (see cel::SlotActivation). The layout must outlive
+// the returned step.
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateIdentStep(
-    const cel::ast_internal::Ident& ident, int64_t expr_id);
+    const cel::ast_internal::Ident& ident, int64_t expr_id,
+    bool enable_attribute_tracking,
+    absl::Nonnull<const cel::VariableLayout*> variable_layout,
+    size_t variable_slot);
 
 // Factory method for identifier that has been assigned to a slot.
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateIdentStepForSlot(
@@ -68,6 +68,36 @@ TEST(IdentStepTest, TestIdentStep) {
   EXPECT_THAT(result.StringOrDie().value(), Eq("test"));
 }
 
+TEST(IdentStepTest, TestIdentStepWithoutAttributeTracking) {
+  Expr expr;
+  auto& ident_expr = expr.mutable_ident_expr();
+  ident_expr.set_name("name0");
+
+  ASSERT_OK_AND_ASSIGN(auto step,
+                       CreateIdentStep(ident_expr, expr.id(),
+                                       /*enable_attribute_tracking=*/false));
+
+  ExecutionPath path;
+  path.push_back(std::move(step));
+
+  CelExpressionFlatImpl impl(
+      FlatExpression(std::move(path), /*comprehension_slot_count=*/0,
+                     TypeProvider::Builtin(), cel::RuntimeOptions{}));
+
+  Activation activation;
+  Arena arena;
+  std::string value("test");
+
+  activation.InsertValue("name0", CelValue::CreateString(&value));
+  auto status0 = impl.Evaluate(activation, &arena);
+  ASSERT_OK(status0);
+
+  CelValue result = status0.value();
+
+  ASSERT_TRUE(result.IsString());
+  EXPECT_THAT(result.StringOrDie().value(), Eq("test"));
+}
+
 TEST(IdentStepTest, TestIdentStepNameNotFound) {
   Expr expr;
   auto& ident_expr = expr.mutable_ident_expr();
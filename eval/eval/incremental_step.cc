@@ -0,0 +1,130 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/incremental_step.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/value.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/status_macros.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+absl::string_view VariableOf(absl::string_view path) {
+  return path.substr(0, path.find('.'));
+}
+
+// Returns true if one of the paths is the other or one of its fields.
+bool Overlaps(absl::string_view lhs, absl::string_view rhs) {
+  if (lhs.size() > rhs.size()) {
+    std::swap(lhs, rhs);
+  }
+  return absl::StartsWith(rhs, lhs) &&
+         (rhs.size() == lhs.size() || rhs[lhs.size()] == '.');
+}
+
+class DirectIncrementalStep : public DirectExpressionStep {
+ public:
+  DirectIncrementalStep(size_t slot, std::unique_ptr<DirectExpressionStep> step,
+                        int64_t expr_id)
+      : DirectExpressionStep(expr_id), slot_(slot), step_(std::move(step)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
+                        AttributeTrail& attribute) const override {
+    IncrementalCache* cache = frame.incremental_cache();
+    if (cache == nullptr) {
+      return step_->Evaluate(frame, result, attribute);
+    }
+    if (const IncrementalCache::Entry* entry = cache->Find(slot_);
+        entry != nullptr) {
+      result = entry->value;
+      attribute = entry->attribute;
+      return absl::OkStatus();
+    }
+    CEL_RETURN_IF_ERROR(step_->Evaluate(frame, result, attribute));
+    cache->Store(slot_, result, attribute);
+    return absl::OkStatus();
+  }
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{step_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.push_back(std::move(step_));
+    return dependencies;
+  }
+
+ private:
+  size_t slot_;
+  std::unique_ptr<DirectExpressionStep> step_;
+};
+
+}  // namespace
+
+size_t IncrementalDependencies::Add(std::vector<std::string> paths) {
+  size_t slot = paths_.size();
+  for (const std::string& path : paths) {
+    std::vector<size_t>& slots = slots_by_variable_[VariableOf(path)];
+    if (slots.empty() || slots.back() != slot) {
+      slots.push_back(slot);
+    }
+  }
+  paths_.push_back(std::move(paths));
+  return slot;
+}
+
+void IncrementalDependencies::Invalidate(absl::string_view changed,
+                                         IncrementalCache& cache) const {
+  auto it = slots_by_variable_.find(VariableOf(changed));
+  if (it == slots_by_variable_.end()) {
+    return;
+  }
+  for (size_t slot : it->second) {
+    if (cache.Find(slot) == nullptr) {
+      continue;
+    }
+    for (const std::string& path : paths_[slot]) {
+      if (Overlaps(path, changed)) {
+        cache.Invalidate(slot);
+        break;
+      }
+    }
+  }
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectIncrementalStep(
+    size_t slot, std::unique_ptr<DirectExpressionStep> step, int64_t expr_id) {
+  return std::make_unique<DirectIncrementalStep>(slot, std::move(step),
+                                                 expr_id);
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,106 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_INCREMENTAL_STEP_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_INCREMENTAL_STEP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/value.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+
+namespace google::api::expr::runtime {
+
+// Results of the cached subexpressions of an incrementally evaluated program,
+// kept from one evaluation to the next. Indexed by slot, as assigned by
+// IncrementalDependencies.
+class IncrementalCache final {
+ public:
+  struct Entry {
+    cel::Value value;
+    AttributeTrail attribute;
+  };
+
+  explicit IncrementalCache(size_t size) : entries_(size) {}
+
+  IncrementalCache(IncrementalCache&&) = default;
+  IncrementalCache& operator=(IncrementalCache&&) = default;
+
+  // Returns the cached result of `slot`, or null if it must be computed.
+  const Entry* Find(size_t slot) const {
+    return entries_[slot].has_value() ? &*entries_[slot] : nullptr;
+  }
+
+  void Store(size_t slot, const cel::Value& value,
+             const AttributeTrail& attribute) {
+    entries_[slot] = Entry{value, attribute};
+  }
+
+  void Invalidate(size_t slot) { entries_[slot].reset(); }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  std::vector<absl::optional<Entry>> entries_;
+};
+
+// The attribute paths (e.g. `request.user.id`) the cached subexpressions of an
+// incrementally evaluated program depend on, used to find the results which
+// are stale after some of the variables of the program changed.
+class IncrementalDependencies final {
+ public:
+  IncrementalDependencies() = default;
+
+  IncrementalDependencies(const IncrementalDependencies&) = delete;
+  IncrementalDependencies& operator=(const IncrementalDependencies&) = delete;
+
+  // Adds a subexpression depending on `paths`, returning its slot.
+  size_t Add(std::vector<std::string> paths);
+
+  // Number of slots.
+  size_t size() const { return paths_.size(); }
+
+  const std::vector<std::string>& paths(size_t slot) const {
+    return paths_[slot];
+  }
+
+  // Invalidates the results in `cache` which depend on `changed`, a variable
+  // name or an attribute path. A result depends on a path if it reads the
+  // path, a field of it, or the attribute the path is a field of.
+  void Invalidate(absl::string_view changed, IncrementalCache& cache) const;
+
+ private:
+  std::vector<std::vector<std::string>> paths_;
+  // Slots by the variable their paths start from.
+  absl::flat_hash_map<std::string, std::vector<size_t>> slots_by_variable_;
+};
+
+// Returns a step evaluating `step` unless the incremental cache of the frame
+// (see ExecutionFrameBase::incremental_cache) holds a result for `slot`, and
+// caching its result otherwise. Evaluates `step` as is if the frame has no
+// incremental cache.
+std::unique_ptr<DirectExpressionStep> CreateDirectIncrementalStep(
+    size_t slot, std::unique_ptr<DirectExpressionStep> step, int64_t expr_id);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_INCREMENTAL_STEP_H_
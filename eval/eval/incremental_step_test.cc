@@ -0,0 +1,109 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/incremental_step.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/value.h"
+#include "eval/eval/attribute_trail.h"
+#include "internal/testing.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::cel::IntValue;
+
+// Returns the slots of `cache` which hold a result.
+std::vector<size_t> CachedSlots(const IncrementalCache& cache) {
+  std::vector<size_t> slots;
+  for (size_t slot = 0; slot < cache.size(); ++slot) {
+    if (cache.Find(slot) != nullptr) {
+      slots.push_back(slot);
+    }
+  }
+  return slots;
+}
+
+class IncrementalDependenciesTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    dependencies_.Add({"a"});
+    dependencies_.Add({"a.b", "c"});
+    dependencies_.Add({"a.b.c"});
+    dependencies_.Add({"a.bc"});
+    dependencies_.Add({});
+  }
+
+  IncrementalCache FullCache() {
+    IncrementalCache cache(dependencies_.size());
+    for (size_t slot = 0; slot < cache.size(); ++slot) {
+      cache.Store(slot, IntValue(static_cast<int64_t>(slot)),
+                  AttributeTrail());
+    }
+    return cache;
+  }
+
+  IncrementalDependencies dependencies_;
+};
+
+TEST_F(IncrementalDependenciesTest, InvalidatesVariable) {
+  IncrementalCache cache = FullCache();
+  dependencies_.Invalidate("a", cache);
+  EXPECT_THAT(CachedSlots(cache), testing::ElementsAre(4));
+}
+
+TEST_F(IncrementalDependenciesTest, InvalidatesAttributePath) {
+  IncrementalCache cache = FullCache();
+  dependencies_.Invalidate("a.b", cache);
+  // Slot 0 reads all of `a`, slots 1 and 2 read `a.b` and a field of it.
+  EXPECT_THAT(CachedSlots(cache), testing::ElementsAre(3, 4));
+}
+
+TEST_F(IncrementalDependenciesTest, InvalidatesField) {
+  IncrementalCache cache = FullCache();
+  dependencies_.Invalidate("a.b.d", cache);
+  EXPECT_THAT(CachedSlots(cache), testing::ElementsAre(2, 3, 4));
+}
+
+TEST_F(IncrementalDependenciesTest, IgnoresUnreadVariables) {
+  IncrementalCache cache = FullCache();
+  dependencies_.Invalidate("d", cache);
+  dependencies_.Invalidate("ab", cache);
+  EXPECT_THAT(CachedSlots(cache), testing::ElementsAre(0, 1, 2, 3, 4));
+
+  dependencies_.Invalidate("c", cache);
+  EXPECT_THAT(CachedSlots(cache), testing::ElementsAre(0, 2, 3, 4));
+}
+
+TEST(IncrementalCacheTest, StoresResults) {
+  IncrementalCache cache(2);
+  EXPECT_EQ(cache.Find(0), nullptr);
+
+  cache.Store(0, IntValue(42), AttributeTrail("x"));
+  const IncrementalCache::Entry* entry = cache.Find(0);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->value.As<IntValue>().NativeValue(), 42);
+  EXPECT_EQ(entry->attribute.attribute().variable_name(), "x");
+  EXPECT_EQ(cache.Find(1), nullptr);
+
+  cache.Invalidate(0);
+  EXPECT_EQ(cache.Find(0), nullptr);
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
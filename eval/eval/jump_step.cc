@@ -21,8 +21,10 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/optional.h"
+#include "common/native_type.h"
 #include "common/value.h"
 #include "eval/internal/errors.h"
+#include "internal/casts.h"
 
 namespace google::api::expr::runtime {
 
@@ -43,6 +45,10 @@ class JumpStep : public JumpStepBase {
   absl::Status Evaluate(ExecutionFrame* frame) const override {
     return Jump(frame);
   }
+
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<JumpStep>();
+  }
 };
 
 class CondJumpStep : public JumpStepBase {
@@ -76,6 +82,13 @@ class CondJumpStep : public JumpStepBase {
     return absl::OkStatus();
   }
 
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<CondJumpStep>();
+  }
+
+  bool jump_condition() const { return jump_condition_; }
+  bool leave_on_stack() const { return leave_on_stack_; }
+
  private:
   const bool jump_condition_;
   const bool leave_on_stack_;
@@ -117,6 +130,10 @@ class BoolCheckJumpStep : public JumpStepBase {
 
     return absl::OkStatus();
   }
+
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<BoolCheckJumpStep>();
+  }
 };
 
 }  // namespace
@@ -145,4 +162,33 @@ absl::StatusOr<std::unique_ptr<JumpStepBase>> CreateBoolCheckJumpStep(
   return std::make_unique<BoolCheckJumpStep>(jump_offset, expr_id);
 }
 
+absl::optional<CondJumpStepParams> GetCondJumpStepParams(
+    const ExpressionStep& step) {
+  if (step.GetNativeTypeId() != cel::NativeTypeId::For<CondJumpStep>()) {
+    return absl::nullopt;
+  }
+  const auto& cond_jump = cel::internal::down_cast<const CondJumpStep&>(step);
+  if (!cond_jump.jump_offset().has_value()) {
+    return absl::nullopt;
+  }
+  return CondJumpStepParams{cond_jump.jump_condition(),
+                            cond_jump.leave_on_stack(),
+                            *cond_jump.jump_offset()};
+}
+
+absl::optional<int> GetBoolCheckJumpStepOffset(const ExpressionStep& step) {
+  if (step.GetNativeTypeId() != cel::NativeTypeId::For<BoolCheckJumpStep>()) {
+    return absl::nullopt;
+  }
+  return cel::internal::down_cast<const BoolCheckJumpStep&>(step)
+      .jump_offset();
+}
+
+absl::optional<int> GetJumpStepOffset(const ExpressionStep& step) {
+  if (step.GetNativeTypeId() != cel::NativeTypeId::For<JumpStep>()) {
+    return absl::nullopt;
+  }
+  return cel::internal::down_cast<const JumpStep&>(step).jump_offset();
+}
+
 }  // namespace google::api::expr::runtime
@@ -16,10 +16,13 @@
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_JUMP_STEP_H_
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "absl/status/statusor.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
 
@@ -32,6 +35,21 @@ class JumpStepBase : public ExpressionStepBase {
 
   void set_jump_offset(int offset) { jump_offset_ = offset; }
 
+  absl::optional<int> jump_offset() const { return jump_offset_; }
+
+  std::vector<int> GetJumpOffsets() const override {
+    if (!jump_offset_.has_value()) {
+      return {};
+    }
+    return {*jump_offset_};
+  }
+
+  void SetJumpOffsets(absl::Span<const int> offsets) override {
+    if (!offsets.empty()) {
+      jump_offset_ = offsets[0];
+    }
+  }
+
   absl::Status Jump(ExecutionFrame* frame) const {
     if (!jump_offset_.has_value()) {
       return absl::Status(absl::StatusCode::kInternal, "Jump offset not set");
@@ -62,6 +80,26 @@ absl::StatusOr<std::unique_ptr<JumpStepBase>> CreateCondJumpStep(
 absl::StatusOr<std::unique_ptr<JumpStepBase>> CreateBoolCheckJumpStep(
     absl::optional<int> jump_offset, int64_t expr_id);
 
+// Parameters of a conditional jump step, for plan rewrites.
+struct CondJumpStepParams {
+  bool jump_condition;
+  bool leave_on_stack;
+  int jump_offset;
+};
+
+// Returns the parameters of `step` if it was created by `CreateCondJumpStep`
+// and its offset has been set.
+absl::optional<CondJumpStepParams> GetCondJumpStepParams(
+    const ExpressionStep& step);
+
+// Returns the jump offset of `step` if it was created by
+// `CreateBoolCheckJumpStep` and its offset has been set.
+absl::optional<int> GetBoolCheckJumpStepOffset(const ExpressionStep& step);
+
+// Returns the jump offset of `step` if it was created by `CreateJumpStep` and
+// its offset has been set.
+absl::optional<int> GetJumpStepOffset(const ExpressionStep& step);
+
 }  // namespace google::api::expr::runtime
 
 #endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_JUMP_STEP_H_
@@ -18,10 +18,12 @@
 #include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "google/api/expr/v1alpha1/value.pb.h"
 #include "absl/base/nullability.h"
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "common/value.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/direct_expression_step.h"
@@ -48,7 +50,7 @@ class CheckLazyInitStep : public ExpressionStepBase {
     if (slot != nullptr) {
       frame->value_stack().Push(slot->value, slot->attribute);
       // skip next step (assign to slot)
-      return frame->JumpTo(1);
+      return frame->JumpTo(jump_offset_);
     }
 
     // return to next step (assign to slot)
@@ -56,9 +58,16 @@ class CheckLazyInitStep : public ExpressionStepBase {
     return absl::OkStatus();
   }
 
+  std::vector<int> GetJumpOffsets() const override { return {jump_offset_}; }
+
+  void SetJumpOffsets(absl::Span<const int> offsets) override {
+    jump_offset_ = offsets[0];
+  }
+
  private:
   size_t slot_index_;
   size_t subexpression_index_;
+  int jump_offset_ = 1;
 };
 
 class DirectCheckLazyInitStep : public DirectExpressionStep {
@@ -112,6 +121,31 @@ class BindStep : public DirectExpressionStep {
   std::unique_ptr<DirectExpressionStep> subexpression_;
 };
 
+class ClearSlotsStep : public DirectExpressionStep {
+ public:
+  ClearSlotsStep(std::vector<size_t> slot_indices,
+                 std::unique_ptr<DirectExpressionStep> expression,
+                 int64_t expr_id)
+      : DirectExpressionStep(expr_id),
+        slot_indices_(std::move(slot_indices)),
+        expression_(std::move(expression)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override {
+    CEL_RETURN_IF_ERROR(expression_->Evaluate(frame, result, attribute));
+
+    for (size_t slot_index : slot_indices_) {
+      frame.comprehension_slots().ClearSlot(slot_index);
+    }
+
+    return absl::OkStatus();
+  }
+
+ private:
+  std::vector<size_t> slot_indices_;
+  std::unique_ptr<DirectExpressionStep> expression_;
+};
+
 class AssignSlotStep : public ExpressionStepBase {
  public:
   explicit AssignSlotStep(size_t slot_index, bool should_pop)
@@ -187,4 +221,11 @@ std::unique_ptr<ExpressionStep> CreateClearSlotStep(size_t slot_index,
   return std::make_unique<ClearSlotStep>(slot_index, expr_id);
 }
 
+std::unique_ptr<DirectExpressionStep> CreateDirectClearSlotsStep(
+    std::vector<size_t> slot_indices,
+    std::unique_ptr<DirectExpressionStep> expression, int64_t expr_id) {
+  return std::make_unique<ClearSlotsStep>(std::move(slot_indices),
+                                          std::move(expression), expr_id);
+}
+
 }  // namespace google::api::expr::runtime
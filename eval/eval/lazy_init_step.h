@@ -40,6 +40,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "absl/base/nullability.h"
 #include "eval/eval/direct_expression_step.h"
@@ -75,6 +76,13 @@ std::unique_ptr<ExpressionStep> CreateAssignSlotAndPopStep(size_t slot_index);
 std::unique_ptr<ExpressionStep> CreateClearSlotStep(size_t slot_index,
                                                     int64_t expr_id);
 
+// Creates a step evaluating `expression`, then clearing `slot_indices`.
+// Used for the slots of aliases hoisted out of the loops nested in
+// `expression`, which stay initialized for its whole evaluation.
+std::unique_ptr<DirectExpressionStep> CreateDirectClearSlotsStep(
+    std::vector<size_t> slot_indices,
+    std::unique_ptr<DirectExpressionStep> expression, int64_t expr_id);
+
 }  // namespace google::api::expr::runtime
 
 #endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_LAZY_INIT_STEP_H_
@@ -0,0 +1,131 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/list_membership_step.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common/casting.h"
+#include "common/value.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/expression_step_base.h"
+#include "internal/status_macros.h"
+#include "runtime/internal/primitive_value_set.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::ErrorValue;
+using ::cel::InstanceOf;
+using ::cel::UnknownValue;
+using ::cel::Value;
+using ::cel::runtime_internal::PrimitiveValueSet;
+
+bool IsPassThrough(const Value& value) {
+  return InstanceOf<ErrorValue>(value) || InstanceOf<UnknownValue>(value);
+}
+
+class ConstantListMembershipStep final : public ExpressionStepBase {
+ public:
+  ConstantListMembershipStep(int64_t expr_id,
+                             std::shared_ptr<const PrimitiveValueSet> set)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        set_(std::move(set)) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(1)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Insufficient arguments supplied for list "
+                          "membership test");
+    }
+    const Value& element = frame->value_stack().Peek();
+    if (IsPassThrough(element)) {
+      return absl::OkStatus();
+    }
+    // Like the replaced call, a partially unknown operand makes the result
+    // unknown.
+    if (frame->enable_unknowns()) {
+      const AttributeTrail& trail = frame->value_stack().PeekAttribute();
+      if (frame->attribute_utility().CheckForUnknown(trail,
+                                                     /*use_partial=*/true)) {
+        frame->value_stack().PopAndPush(
+            frame->attribute_utility().CreateUnknownSet(trail.attribute()));
+        return absl::OkStatus();
+      }
+    }
+    // The result isn't an attribute, so the operand's trail is dropped.
+    frame->value_stack().PopAndPush(BoolValue(set_->Contains(element)));
+    return absl::OkStatus();
+  }
+
+ private:
+  const std::shared_ptr<const PrimitiveValueSet> set_;
+};
+
+class DirectConstantListMembershipStep final : public DirectExpressionStep {
+ public:
+  DirectConstantListMembershipStep(
+      int64_t expr_id, std::unique_ptr<DirectExpressionStep> element,
+      std::shared_ptr<const PrimitiveValueSet> set)
+      : DirectExpressionStep(expr_id),
+        element_(std::move(element)),
+        set_(std::move(set)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override {
+    AttributeTrail element_attr;
+    CEL_RETURN_IF_ERROR(element_->Evaluate(frame, result, element_attr));
+    if (IsPassThrough(result)) {
+      return absl::OkStatus();
+    }
+    if (frame.unknown_processing_enabled() &&
+        frame.attribute_utility().CheckForUnknown(element_attr,
+                                                  /*use_partial=*/true)) {
+      result =
+          frame.attribute_utility().CreateUnknownSet(element_attr.attribute());
+      return absl::OkStatus();
+    }
+    result = BoolValue(set_->Contains(result));
+    return absl::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<DirectExpressionStep> element_;
+  const std::shared_ptr<const PrimitiveValueSet> set_;
+};
+
+}  // namespace
+
+std::unique_ptr<DirectExpressionStep> CreateDirectConstantListMembershipStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> element,
+    std::shared_ptr<const PrimitiveValueSet> set) {
+  return std::make_unique<DirectConstantListMembershipStep>(
+      expr_id, std::move(element), std::move(set));
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>>
+CreateConstantListMembershipStep(
+    std::shared_ptr<const PrimitiveValueSet> set, int64_t expr_id) {
+  return std::make_unique<ConstantListMembershipStep>(expr_id, std::move(set));
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_LIST_MEMBERSHIP_STEP_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_LIST_MEMBERSHIP_STEP_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "runtime/internal/primitive_value_set.h"
+
+namespace google::api::expr::runtime {
+
+// Create a direct step that tests whether the result of element is a member
+// of the given constant set.
+std::unique_ptr<DirectExpressionStep> CreateDirectConstantListMembershipStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> element,
+    std::shared_ptr<const cel::runtime_internal::PrimitiveValueSet> set);
+
+// Create a stack machine step that replaces the top of the stack with whether
+// it is a member of the given constant set.
+absl::StatusOr<std::unique_ptr<ExpressionStep>>
+CreateConstantListMembershipStep(
+    std::shared_ptr<const cel::runtime_internal::PrimitiveValueSet> set,
+    int64_t expr_id);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_LIST_MEMBERSHIP_STEP_H_
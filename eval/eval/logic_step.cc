@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -18,7 +19,6 @@
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
 #include "eval/internal/errors.h"
-#include "internal/status_macros.h"
 #include "runtime/internal/errors.h"
 
 namespace google::api::expr::runtime {
@@ -40,10 +40,10 @@ enum class OpType { kAnd, kOr };
 
 // Shared logic for the fall through case (we didn't see the shortcircuit
 // value).
-absl::Status ReturnLogicResult(ExecutionFrameBase& frame, OpType op_type,
-                               Value& lhs_result, Value& rhs_result,
-                               AttributeTrail& attribute_trail,
-                               AttributeTrail& rhs_attr) {
+void ReturnLogicResult(ExecutionFrameBase& frame, OpType op_type,
+                       Value& lhs_result, Value& rhs_result,
+                       AttributeTrail& attribute_trail,
+                       AttributeTrail& rhs_attr) {
   ValueKind lhs_kind = lhs_result.kind();
   ValueKind rhs_kind = rhs_result.kind();
 
@@ -54,26 +54,26 @@ absl::Status ReturnLogicResult(ExecutionFrameBase& frame, OpType op_type,
       // Clear attribute trail so this doesn't get re-identified as a new
       // unknown and reset the accumulated attributes.
       attribute_trail = AttributeTrail();
-      return absl::OkStatus();
+      return;
     } else if (lhs_kind == ValueKind::kUnknown) {
-      return absl::OkStatus();
+      return;
     } else if (rhs_kind == ValueKind::kUnknown) {
       lhs_result = std::move(rhs_result);
       attribute_trail = std::move(rhs_attr);
-      return absl::OkStatus();
+      return;
     }
   }
 
   if (lhs_kind == ValueKind::kError) {
-    return absl::OkStatus();
+    return;
   } else if (rhs_kind == ValueKind::kError) {
     lhs_result = std::move(rhs_result);
     attribute_trail = std::move(rhs_attr);
-    return absl::OkStatus();
+    return;
   }
 
   if (lhs_kind == ValueKind::kBool && rhs_kind == ValueKind::kBool) {
-    return absl::OkStatus();
+    return;
   }
 
   // Otherwise, add a no overload error.
@@ -81,21 +81,35 @@ absl::Status ReturnLogicResult(ExecutionFrameBase& frame, OpType op_type,
   lhs_result =
       frame.value_manager().CreateErrorValue(CreateNoMatchingOverloadError(
           op_type == OpType::kOr ? cel::builtin::kOr : cel::builtin::kAnd));
-  return absl::OkStatus();
 }
 
-class ExhaustiveDirectLogicStep : public DirectExpressionStep {
+class ExhaustiveDirectLogicStep : public FastDirectExpressionStep {
  public:
   explicit ExhaustiveDirectLogicStep(std::unique_ptr<DirectExpressionStep> lhs,
                                      std::unique_ptr<DirectExpressionStep> rhs,
                                      OpType op_type, int64_t expr_id)
-      : DirectExpressionStep(expr_id),
+      : FastDirectExpressionStep(expr_id),
         lhs_(std::move(lhs)),
         rhs_(std::move(rhs)),
         op_type_(op_type) {}
 
-  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
-                        AttributeTrail& attribute_trail) const override;
+  bool EvaluateFast(ExecutionFrameBase& frame, cel::Value& result,
+                    AttributeTrail& attribute_trail,
+                    absl::Status& status) const override;
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return std::vector<const DirectExpressionStep*>{lhs_.get(), rhs_.get()};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.reserve(2);
+    dependencies.push_back(std::move(lhs_));
+    dependencies.push_back(std::move(rhs_));
+    return dependencies;
+  }
 
  private:
   std::unique_ptr<DirectExpressionStep> lhs_;
@@ -103,22 +117,27 @@ class ExhaustiveDirectLogicStep : public DirectExpressionStep {
   OpType op_type_;
 };
 
-absl::Status ExhaustiveDirectLogicStep::Evaluate(
-    ExecutionFrameBase& frame, cel::Value& result,
-    AttributeTrail& attribute_trail) const {
-  CEL_RETURN_IF_ERROR(lhs_->Evaluate(frame, result, attribute_trail));
+bool ExhaustiveDirectLogicStep::EvaluateFast(ExecutionFrameBase& frame,
+                                             cel::Value& result,
+                                             AttributeTrail& attribute_trail,
+                                             absl::Status& status) const {
+  if (!lhs_->EvaluateFast(frame, result, attribute_trail, status)) {
+    return false;
+  }
   ValueKind lhs_kind = result.kind();
 
   Value rhs_result;
   AttributeTrail rhs_attr;
-  CEL_RETURN_IF_ERROR(rhs_->Evaluate(frame, rhs_result, attribute_trail));
+  if (!rhs_->EvaluateFast(frame, rhs_result, attribute_trail, status)) {
+    return false;
+  }
 
   ValueKind rhs_kind = rhs_result.kind();
   if (lhs_kind == ValueKind::kBool) {
     bool lhs_bool = Cast<BoolValue>(result).NativeValue();
     if ((op_type_ == OpType::kOr && lhs_bool) ||
         (op_type_ == OpType::kAnd && !lhs_bool)) {
-      return absl::OkStatus();
+      return true;
     }
   }
 
@@ -128,26 +147,42 @@ absl::Status ExhaustiveDirectLogicStep::Evaluate(
         (op_type_ == OpType::kAnd && !rhs_bool)) {
       result = std::move(rhs_result);
       attribute_trail = std::move(rhs_attr);
-      return absl::OkStatus();
+      return true;
     }
   }
 
-  return ReturnLogicResult(frame, op_type_, result, rhs_result, attribute_trail,
-                           rhs_attr);
+  ReturnLogicResult(frame, op_type_, result, rhs_result, attribute_trail,
+                    rhs_attr);
+  return true;
 }
 
-class DirectLogicStep : public DirectExpressionStep {
+class DirectLogicStep : public FastDirectExpressionStep {
  public:
   explicit DirectLogicStep(std::unique_ptr<DirectExpressionStep> lhs,
                            std::unique_ptr<DirectExpressionStep> rhs,
                            OpType op_type, int64_t expr_id)
-      : DirectExpressionStep(expr_id),
+      : FastDirectExpressionStep(expr_id),
         lhs_(std::move(lhs)),
         rhs_(std::move(rhs)),
         op_type_(op_type) {}
 
-  absl::Status Evaluate(ExecutionFrameBase& frame, cel::Value& result,
-                        AttributeTrail& attribute_trail) const override;
+  bool EvaluateFast(ExecutionFrameBase& frame, cel::Value& result,
+                    AttributeTrail& attribute_trail,
+                    absl::Status& status) const override;
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return std::vector<const DirectExpressionStep*>{lhs_.get(), rhs_.get()};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.reserve(2);
+    dependencies.push_back(std::move(lhs_));
+    dependencies.push_back(std::move(rhs_));
+    return dependencies;
+  }
 
  private:
   std::unique_ptr<DirectExpressionStep> lhs_;
@@ -155,22 +190,27 @@ class DirectLogicStep : public DirectExpressionStep {
   OpType op_type_;
 };
 
-absl::Status DirectLogicStep::Evaluate(ExecutionFrameBase& frame, Value& result,
-                                       AttributeTrail& attribute_trail) const {
-  CEL_RETURN_IF_ERROR(lhs_->Evaluate(frame, result, attribute_trail));
+bool DirectLogicStep::EvaluateFast(ExecutionFrameBase& frame, Value& result,
+                                   AttributeTrail& attribute_trail,
+                                   absl::Status& status) const {
+  if (!lhs_->EvaluateFast(frame, result, attribute_trail, status)) {
+    return false;
+  }
   ValueKind lhs_kind = result.kind();
   if (lhs_kind == ValueKind::kBool) {
     bool lhs_bool = Cast<BoolValue>(result).NativeValue();
     if ((op_type_ == OpType::kOr && lhs_bool) ||
         (op_type_ == OpType::kAnd && !lhs_bool)) {
-      return absl::OkStatus();
+      return true;
     }
   }
 
   Value rhs_result;
   AttributeTrail rhs_attr;
 
-  CEL_RETURN_IF_ERROR(rhs_->Evaluate(frame, rhs_result, attribute_trail));
+  if (!rhs_->EvaluateFast(frame, rhs_result, attribute_trail, status)) {
+    return false;
+  }
 
   ValueKind rhs_kind = rhs_result.kind();
 
@@ -180,12 +220,13 @@ absl::Status DirectLogicStep::Evaluate(ExecutionFrameBase& frame, Value& result,
         (op_type_ == OpType::kAnd && !rhs_bool)) {
       result = std::move(rhs_result);
       attribute_trail = std::move(rhs_attr);
-      return absl::OkStatus();
+      return true;
     }
   }
 
-  return ReturnLogicResult(frame, op_type_, result, rhs_result, attribute_trail,
-                           rhs_attr);
+  ReturnLogicResult(frame, op_type_, result, rhs_result, attribute_trail,
+                    rhs_attr);
+  return true;
 }
 
 class LogicalOpStep : public ExpressionStepBase {
@@ -53,8 +53,11 @@ using ::cel::Value;
 using ::cel::ValueManager;
 using ::cel::ast_internal::Expr;
 using ::cel::extensions::ProtoMemoryManagerRef;
+using ::cel::internal::StatusIs;
 using ::google::protobuf::Arena;
+using testing::_;
 using testing::Eq;
+using testing::Return;
 
 class LogicStepTest : public testing::TestWithParam<bool> {
  public:
@@ -579,6 +582,75 @@ INSTANTIATE_TEST_SUITE_P(
           name, (shortcircuiting_enabled ? "ShortcircuitingEnabled" : ""));
     });
 
+class MockDirectStep : public DirectExpressionStep {
+ public:
+  MockDirectStep() : DirectExpressionStep(-1) {}
+
+  MOCK_METHOD(absl::Status, Evaluate,
+              (ExecutionFrameBase&, Value&, AttributeTrail&), (const override));
+};
+
+class DirectLogicStepEvaluateFastTest : public testing::TestWithParam<bool> {
+ public:
+  DirectLogicStepEvaluateFastTest()
+      : value_factory_(TypeProvider::Builtin(),
+                       ProtoMemoryManagerRef(&arena_)) {}
+
+  bool ShortcircuitingEnabled() { return GetParam(); }
+
+  ValueManager& value_manager() { return value_factory_.get(); }
+
+ protected:
+  Arena arena_;
+  ManagedValueFactory value_factory_;
+};
+
+TEST_P(DirectLogicStepEvaluateFastTest, LeavesStatusUntouchedOnSuccess) {
+  std::unique_ptr<DirectExpressionStep> op = CreateDirectAndStep(
+      CreateConstValueDirectStep(BoolValue(true)),
+      CreateConstValueDirectStep(BoolValue(false)), -1,
+      ShortcircuitingEnabled());
+
+  cel::Activation activation;
+  cel::RuntimeOptions options;
+  ExecutionFrameBase frame(activation, options, value_manager());
+
+  Value value;
+  AttributeTrail attr;
+  absl::Status status = absl::CancelledError("untouched");
+  ASSERT_TRUE(op->EvaluateFast(frame, value, attr, status));
+  ASSERT_TRUE(InstanceOf<BoolValue>(value));
+  EXPECT_FALSE(Cast<BoolValue>(value).NativeValue());
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kCancelled, "untouched"));
+}
+
+TEST_P(DirectLogicStepEvaluateFastTest, PropagatesDependencyFailure) {
+  // The mock only implements `Evaluate`, so it is reached through the default
+  // `EvaluateFast`.
+  auto rhs = std::make_unique<MockDirectStep>();
+  ON_CALL(*rhs, Evaluate(_, _, _))
+      .WillByDefault(Return(absl::InternalError("test rhs error")));
+
+  std::unique_ptr<DirectExpressionStep> op = CreateDirectAndStep(
+      CreateConstValueDirectStep(BoolValue(true)), std::move(rhs), -1,
+      ShortcircuitingEnabled());
+
+  cel::Activation activation;
+  cel::RuntimeOptions options;
+  ExecutionFrameBase frame(activation, options, value_manager());
+
+  Value value;
+  AttributeTrail attr;
+  absl::Status status;
+  EXPECT_FALSE(op->EvaluateFast(frame, value, attr, status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kInternal, "test rhs error"));
+  EXPECT_THAT(op->Evaluate(frame, value, attr),
+              StatusIs(absl::StatusCode::kInternal, "test rhs error"));
+}
+
+INSTANTIATE_TEST_SUITE_P(DirectLogicStepEvaluateFastTest,
+                         DirectLogicStepEvaluateFastTest, testing::Bool());
+
 }  // namespace
 
 }  // namespace google::api::expr::runtime
@@ -14,13 +14,18 @@
 
 #include "eval/eval/optional_or_step.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "common/casting.h"
@@ -29,8 +34,10 @@
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
+#include "eval/eval/function_step.h"
 #include "eval/eval/jump_step.h"
 #include "internal/status_macros.h"
+#include "runtime/function_overload_reference.h"
 #include "runtime/internal/errors.h"
 
 namespace google::api::expr::runtime {
@@ -40,11 +47,16 @@ namespace {
 using ::cel::As;
 using ::cel::ErrorValue;
 using ::cel::InstanceOf;
+using ::cel::MapValue;
 using ::cel::OptionalValue;
+using ::cel::StringValue;
+using ::cel::StructValue;
 using ::cel::UnknownValue;
 using ::cel::Value;
 using ::cel::runtime_internal::CreateNoMatchingOverloadError;
 
+constexpr absl::string_view kOptionalSelectFn = "_?._";
+
 enum class OptionalOrKind { kOrOptional, kOrValue };
 
 ErrorValue MakeNoOverloadError(OptionalOrKind kind) {
@@ -271,6 +283,106 @@ absl::Status DirectOptionalOrStep::Evaluate(ExecutionFrameBase& frame,
   return absl::OkStatus();
 }
 
+class DirectOptionalSelectOrValueStep : public DirectExpressionStep {
+ public:
+  DirectOptionalSelectOrValueStep(
+      int64_t expr_id, std::unique_ptr<DirectExpressionStep> operand,
+      std::vector<std::string> fields,
+      std::vector<cel::FunctionOverloadReference> overloads,
+      std::unique_ptr<DirectExpressionStep> alternative)
+      : DirectExpressionStep(expr_id),
+        operand_(std::move(operand)),
+        overloads_(std::move(overloads)),
+        alternative_(std::move(alternative)) {
+    fields_.reserve(fields.size());
+    for (std::string& field : fields) {
+      StringValue key(field);
+      fields_.push_back(Field{std::move(field), std::move(key)});
+    }
+  }
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override;
+
+ private:
+  struct Field {
+    std::string name;
+    // The name as a map key and as the argument of `_?._`.
+    StringValue key;
+  };
+
+  std::unique_ptr<DirectExpressionStep> operand_;
+  std::vector<Field> fields_;
+  std::vector<cel::FunctionOverloadReference> overloads_;
+  std::unique_ptr<DirectExpressionStep> alternative_;
+};
+
+absl::Status DirectOptionalSelectOrValueStep::Evaluate(
+    ExecutionFrameBase& frame, Value& result, AttributeTrail& attribute) const {
+  CEL_RETURN_IF_ERROR(operand_->Evaluate(frame, result, attribute));
+  if (frame.unknown_processing_enabled() &&
+      frame.attribute_utility().CheckForUnknown(attribute,
+                                                /*use_partial=*/true)) {
+    result = frame.attribute_utility().CreateUnknownSet(attribute.attribute());
+  }
+  attribute = AttributeTrail();
+
+  // Whether `result` is the value of an engaged optional, as opposed to the
+  // result of the operand or of a `_?._` overload.
+  bool engaged = false;
+  Value field_value;
+  for (const Field& field : fields_) {
+    bool found = false;
+    if (auto map_value = As<MapValue>(static_cast<const Value&>(result));
+        map_value) {
+      CEL_ASSIGN_OR_RETURN(std::tie(field_value, found),
+                           map_value->Find(frame.value_manager(), field.key));
+    } else if (auto struct_value =
+                   As<StructValue>(static_cast<const Value&>(result));
+               struct_value) {
+      CEL_ASSIGN_OR_RETURN(found, struct_value->HasFieldByName(field.name));
+      if (found) {
+        CEL_ASSIGN_OR_RETURN(
+            field_value,
+            struct_value->GetFieldByName(frame.value_manager(), field.name));
+      }
+    } else {
+      Value operand = engaged ? Value(OptionalValue::Of(
+                                    frame.value_manager().GetMemoryManager(),
+                                    std::move(result)))
+                              : std::move(result);
+      CEL_ASSIGN_OR_RETURN(
+          result, InvokeFunctionOverloads(frame, expr_id_, kOptionalSelectFn,
+                                          overloads_, {operand, field.key}));
+      if (InstanceOf<ErrorValue>(result) || InstanceOf<UnknownValue>(result)) {
+        // Forwarded by the remaining selects and by orValue.
+        return absl::OkStatus();
+      }
+      engaged = false;
+      auto optional_value =
+          As<OptionalValue>(static_cast<const Value&>(result));
+      if (!optional_value.has_value()) {
+        continue;
+      }
+      if (!optional_value->HasValue()) {
+        return alternative_->Evaluate(frame, result, attribute);
+      }
+      result = optional_value->Value();
+      engaged = true;
+      continue;
+    }
+    if (!found) {
+      return alternative_->Evaluate(frame, result, attribute);
+    }
+    result = std::move(field_value);
+    engaged = true;
+  }
+  if (!engaged) {
+    result = MakeNoOverloadError(OptionalOrKind::kOrValue);
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<JumpStepBase>> CreateOptionalHasValueJumpStep(
@@ -302,4 +414,14 @@ std::unique_ptr<DirectExpressionStep> CreateDirectOptionalOrStep(
   }
 }
 
+std::unique_ptr<DirectExpressionStep> CreateDirectOptionalSelectOrValueStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> operand,
+    std::vector<std::string> fields,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    std::unique_ptr<DirectExpressionStep> alternative) {
+  return std::make_unique<DirectOptionalSelectOrValueStep>(
+      expr_id, std::move(operand), std::move(fields), std::move(overloads),
+      std::move(alternative));
+}
+
 }  // namespace google::api::expr::runtime
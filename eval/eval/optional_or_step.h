@@ -17,11 +17,14 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/status/statusor.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/jump_step.h"
+#include "runtime/function_overload_reference.h"
 
 namespace google::api::expr::runtime {
 
@@ -47,6 +50,20 @@ std::unique_ptr<DirectExpressionStep> CreateDirectOptionalOrStep(
     std::unique_ptr<DirectExpressionStep> alternative, bool is_or_value,
     bool short_circuiting);
 
+// Creates a step implementing the short-circuiting
+// `operand.?field1.?field2...orValue(alternative)`, selecting `fields` in
+// order.
+//
+// Fields of maps and structs are selected directly, without materializing the
+// intermediate optionals. Any other operand is selected through `overloads`,
+// the overloads of `_?._`, which also handle errors, unknowns and optional
+// operands.
+std::unique_ptr<DirectExpressionStep> CreateDirectOptionalSelectOrValueStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> operand,
+    std::vector<std::string> fields,
+    std::vector<cel::FunctionOverloadReference> overloads,
+    std::unique_ptr<DirectExpressionStep> alternative);
+
 }  // namespace google::api::expr::runtime
 
 #endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_OPTIONAL_OR_STEP_H_
@@ -15,19 +15,23 @@
 #include "eval/eval/optional_or_step.h"
 
 #include <memory>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "common/casting.h"
 #include "common/memory.h"
 #include "common/type_reflector.h"
 #include "common/value.h"
 #include "common/value_kind.h"
+#include "common/value_manager.h"
 #include "common/value_testing.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/const_value_step.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "internal/status_macros.h"
 #include "internal/testing.h"
 #include "runtime/activation.h"
 #include "runtime/internal/errors.h"
@@ -356,5 +360,51 @@ TEST_F(OptionalOrTest, OptionalOrValueLeftWrongType) {
                   HasSubstr(cel::runtime_internal::kErrNoMatchingOverload))));
 }
 
+absl::StatusOr<Value> MakeNestedMap(cel::ValueManager& value_manager) {
+  CEL_ASSIGN_OR_RETURN(auto inner, value_manager.NewMapValueBuilder(
+                                       value_manager.GetStringDynMapType()));
+  CEL_RETURN_IF_ERROR(inner->Put(cel::StringValue("b"), IntValue(42)));
+  CEL_ASSIGN_OR_RETURN(auto outer, value_manager.NewMapValueBuilder(
+                                       value_manager.GetStringDynMapType()));
+  CEL_RETURN_IF_ERROR(
+      outer->Put(cel::StringValue("a"), std::move(*inner).Build()));
+  return std::move(*outer).Build();
+}
+
+TEST_F(OptionalOrTest, OptionalSelectOrValuePresentShortcutRight) {
+  RuntimeOptions options;
+  ExecutionFrameBase frame(empty_activation_, options, value_factory_.get());
+  ASSERT_OK_AND_ASSIGN(Value map, MakeNestedMap(value_factory_.get()));
+
+  std::unique_ptr<DirectExpressionStep> step =
+      CreateDirectOptionalSelectOrValueStep(
+          /*expr_id=*/-1, CreateConstValueDirectStep(std::move(map)),
+          {"a", "b"}, /*overloads=*/{}, MockNeverCalledDirectStep());
+
+  Value result;
+  AttributeTrail scratch;
+
+  ASSERT_OK(step->Evaluate(frame, result, scratch));
+  EXPECT_THAT(result, IntValueIs(42));
+}
+
+TEST_F(OptionalOrTest, OptionalSelectOrValueAbsentReturnRight) {
+  RuntimeOptions options;
+  ExecutionFrameBase frame(empty_activation_, options, value_factory_.get());
+  ASSERT_OK_AND_ASSIGN(Value map, MakeNestedMap(value_factory_.get()));
+
+  std::unique_ptr<DirectExpressionStep> step =
+      CreateDirectOptionalSelectOrValueStep(
+          /*expr_id=*/-1, CreateConstValueDirectStep(std::move(map)),
+          {"a", "c"}, /*overloads=*/{},
+          CreateConstValueDirectStep(IntValue(7)));
+
+  Value result;
+  AttributeTrail scratch;
+
+  ASSERT_OK(step->Evaluate(frame, result, scratch));
+  EXPECT_THAT(result, IntValueIs(7));
+}
+
 }  // namespace
 }  // namespace google::api::expr::runtime
@@ -14,23 +14,31 @@
 
 #include "eval/eval/regex_match_step.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/cord.h"
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
+#include "base/builtins.h"
 #include "common/casting.h"
 #include "common/value.h"
+#include "common/value_manager.h"
 #include "eval/eval/attribute_trail.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "eval/eval/expression_step_base.h"
 #include "internal/status_macros.h"
+#include "internal/string_search.h"
 #include "re2/re2.h"
+#include "re2/set.h"
+#include "runtime/internal/errors.h"
 
 namespace google::api::expr::runtime {
 
@@ -125,6 +133,320 @@ class RegexMatchDirectStep final : public DirectExpressionStep {
   const std::shared_ptr<const RE2> re2_;
 };
 
+bool MatchesLiteral(LiteralMatchKind kind, absl::string_view literal,
+                    absl::string_view value) {
+  switch (kind) {
+    case LiteralMatchKind::kExact:
+      return value == literal;
+    case LiteralMatchKind::kPrefix:
+      return absl::StartsWith(value, literal);
+    case LiteralMatchKind::kSuffix:
+      return absl::EndsWith(value, literal);
+    case LiteralMatchKind::kContains:
+      return cel::internal::ContainsSubstring(value, literal);
+  }
+  return false;
+}
+
+struct MatchesLiteralVisitor final {
+  LiteralMatchKind kind;
+  absl::string_view literal;
+
+  bool operator()(const absl::Cord& value) const {
+    if (auto flat = value.TryFlat(); flat.has_value()) {
+      return MatchesLiteral(kind, literal, *flat);
+    }
+    switch (kind) {
+      case LiteralMatchKind::kExact:
+        return value == literal;
+      case LiteralMatchKind::kPrefix:
+        return value.StartsWith(literal);
+      case LiteralMatchKind::kSuffix:
+        return value.EndsWith(literal);
+      case LiteralMatchKind::kContains:
+        return cel::internal::ContainsSubstring(value, literal);
+    }
+    return false;
+  }
+
+  bool operator()(absl::string_view value) const {
+    return MatchesLiteral(kind, literal, value);
+  }
+};
+
+class LiteralMatchStep final : public ExpressionStepBase {
+ public:
+  LiteralMatchStep(int64_t expr_id, LiteralMatchKind kind, std::string literal)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        kind_(kind),
+        literal_(std::move(literal)) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(kNumRegexMatchArguments)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Insufficient arguments supplied for regular "
+                          "expression match");
+    }
+    const Value& subject = frame->value_stack().Peek();
+    if (!subject.Is<StringValue>()) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "First argument for regular "
+                          "expression match must be a string");
+    }
+    bool match = subject.As<StringValue>().NativeValue(
+        MatchesLiteralVisitor{kind_, literal_});
+    // Clears the subject's attribute trail: the result isn't an attribute.
+    frame->value_stack().PopAndPush(kNumRegexMatchArguments, BoolValue(match));
+    return absl::OkStatus();
+  }
+
+ private:
+  const LiteralMatchKind kind_;
+  const std::string literal_;
+};
+
+class LiteralMatchDirectStep final : public DirectExpressionStep {
+ public:
+  LiteralMatchDirectStep(int64_t expr_id,
+                         std::unique_ptr<DirectExpressionStep> subject,
+                         LiteralMatchKind kind, std::string literal)
+      : DirectExpressionStep(expr_id),
+        subject_(std::move(subject)),
+        kind_(kind),
+        literal_(std::move(literal)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override {
+    AttributeTrail subject_attr;
+    CEL_RETURN_IF_ERROR(subject_->Evaluate(frame, result, subject_attr));
+    if (InstanceOf<ErrorValue>(result) || InstanceOf<UnknownValue>(result)) {
+      return absl::OkStatus();
+    }
+
+    if (!InstanceOf<StringValue>(result)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "First argument for regular "
+                          "expression match must be a string");
+    }
+    bool match = Cast<StringValue>(result).NativeValue(
+        MatchesLiteralVisitor{kind_, literal_});
+    result = BoolValue(match);
+    return absl::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<DirectExpressionStep> subject_;
+  const LiteralMatchKind kind_;
+  const std::string literal_;
+};
+
+bool MatchesAny(const RegexSet& regex_set, absl::string_view value) {
+  RE2::Set::ErrorInfo error_info;
+  if (regex_set.set->Match(value, nullptr, &error_info)) {
+    return true;
+  }
+  if (error_info.kind == RE2::Set::kNoError) {
+    return false;
+  }
+  // The set ran out of DFA memory, match the patterns one at a time instead.
+  for (const auto& program : regex_set.programs) {
+    if (RE2::PartialMatch(value, *program)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+struct MatchesAnyVisitor final {
+  const RegexSet& regex_set;
+
+  bool operator()(const absl::Cord& value) const {
+    if (auto flat = value.TryFlat(); flat.has_value()) {
+      return MatchesAny(regex_set, *flat);
+    }
+    return MatchesAny(regex_set, static_cast<std::string>(value));
+  }
+
+  bool operator()(absl::string_view value) const {
+    return MatchesAny(regex_set, value);
+  }
+};
+
+// Replaced calls may have had a non-string subject, in which case the
+// disjunction would evaluate to the overload resolution error.
+Value RegexSetMatch(const RegexSet& regex_set, const Value& subject,
+                    cel::ValueManager& value_manager) {
+  if (!InstanceOf<StringValue>(subject)) {
+    return value_manager.CreateErrorValue(
+        cel::runtime_internal::CreateNoMatchingOverloadError(
+            cel::builtin::kRegexMatch));
+  }
+  return BoolValue(
+      Cast<StringValue>(subject).NativeValue(MatchesAnyVisitor{regex_set}));
+}
+
+class RegexSetMatchStep final : public ExpressionStepBase {
+ public:
+  RegexSetMatchStep(int64_t expr_id, std::shared_ptr<const RegexSet> regex_set)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        regex_set_(std::move(regex_set)) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(kNumRegexMatchArguments)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Insufficient arguments supplied for regular "
+                          "expression match");
+    }
+    const Value& subject = frame->value_stack().Peek();
+    if (InstanceOf<ErrorValue>(subject) || InstanceOf<UnknownValue>(subject)) {
+      return absl::OkStatus();
+    }
+    Value result = RegexSetMatch(*regex_set_, subject, frame->value_manager());
+    // Clears the subject's attribute trail: the result isn't an attribute.
+    frame->value_stack().PopAndPush(kNumRegexMatchArguments,
+                                    std::move(result));
+    return absl::OkStatus();
+  }
+
+ private:
+  const std::shared_ptr<const RegexSet> regex_set_;
+};
+
+class RegexSetMatchDirectStep final : public DirectExpressionStep {
+ public:
+  RegexSetMatchDirectStep(int64_t expr_id,
+                          std::unique_ptr<DirectExpressionStep> subject,
+                          std::shared_ptr<const RegexSet> regex_set)
+      : DirectExpressionStep(expr_id),
+        subject_(std::move(subject)),
+        regex_set_(std::move(regex_set)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override {
+    AttributeTrail subject_attr;
+    CEL_RETURN_IF_ERROR(subject_->Evaluate(frame, result, subject_attr));
+    if (InstanceOf<ErrorValue>(result) || InstanceOf<UnknownValue>(result)) {
+      return absl::OkStatus();
+    }
+    result = RegexSetMatch(*regex_set_, result, frame.value_manager());
+    return absl::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<DirectExpressionStep> subject_;
+  const std::shared_ptr<const RegexSet> regex_set_;
+};
+
+bool ScanMatches(const ExecutionFrameBase& frame, const RegexSet& regex_set,
+                 size_t index, absl::string_view value) {
+  ExecutionFrameBase::RegexScanResult& scan =
+      frame.regex_scans()[&regex_set];
+  if (scan.matches.empty() || scan.subject != value) {
+    std::vector<int> matching;
+    RE2::Set::ErrorInfo error_info;
+    if (!regex_set.set->Match(value, &matching, &error_info) &&
+        error_info.kind != RE2::Set::kNoError) {
+      // The set ran out of DFA memory, match this pattern on its own.
+      return RE2::PartialMatch(value, *regex_set.programs[index]);
+    }
+    scan.subject = std::string(value);
+    scan.matches.assign(regex_set.programs.size(), false);
+    for (int match : matching) {
+      scan.matches[match] = true;
+    }
+  }
+  return scan.matches[index];
+}
+
+struct ScanMatchesVisitor final {
+  const ExecutionFrameBase& frame;
+  const RegexSet& regex_set;
+  size_t index;
+
+  bool operator()(const absl::Cord& value) const {
+    if (auto flat = value.TryFlat(); flat.has_value()) {
+      return ScanMatches(frame, regex_set, index, *flat);
+    }
+    return ScanMatches(frame, regex_set, index,
+                       static_cast<std::string>(value));
+  }
+
+  bool operator()(absl::string_view value) const {
+    return ScanMatches(frame, regex_set, index, value);
+  }
+};
+
+class RegexScanMatchStep final : public ExpressionStepBase {
+ public:
+  RegexScanMatchStep(int64_t expr_id, std::shared_ptr<const RegexSet> regex_set,
+                     size_t index)
+      : ExpressionStepBase(expr_id, /*comes_from_ast=*/true),
+        regex_set_(std::move(regex_set)),
+        index_(index) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(kNumRegexMatchArguments)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "Insufficient arguments supplied for regular "
+                          "expression match");
+    }
+    const Value& subject = frame->value_stack().Peek();
+    if (InstanceOf<ErrorValue>(subject) || InstanceOf<UnknownValue>(subject)) {
+      return absl::OkStatus();
+    }
+    if (!InstanceOf<StringValue>(subject)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "First argument for regular "
+                          "expression match must be a string");
+    }
+    bool match = Cast<StringValue>(subject).NativeValue(
+        ScanMatchesVisitor{*frame, *regex_set_, index_});
+    // Clears the subject's attribute trail: the result isn't an attribute.
+    frame->value_stack().PopAndPush(kNumRegexMatchArguments, BoolValue(match));
+    return absl::OkStatus();
+  }
+
+ private:
+  const std::shared_ptr<const RegexSet> regex_set_;
+  const size_t index_;
+};
+
+class RegexScanMatchDirectStep final : public DirectExpressionStep {
+ public:
+  RegexScanMatchDirectStep(int64_t expr_id,
+                           std::unique_ptr<DirectExpressionStep> subject,
+                           std::shared_ptr<const RegexSet> regex_set,
+                           size_t index)
+      : DirectExpressionStep(expr_id),
+        subject_(std::move(subject)),
+        regex_set_(std::move(regex_set)),
+        index_(index) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override {
+    AttributeTrail subject_attr;
+    CEL_RETURN_IF_ERROR(subject_->Evaluate(frame, result, subject_attr));
+    if (InstanceOf<ErrorValue>(result) || InstanceOf<UnknownValue>(result)) {
+      return absl::OkStatus();
+    }
+
+    if (!InstanceOf<StringValue>(result)) {
+      return absl::Status(absl::StatusCode::kInternal,
+                          "First argument for regular "
+                          "expression match must be a string");
+    }
+    bool match = Cast<StringValue>(result).NativeValue(
+        ScanMatchesVisitor{frame, *regex_set_, index_});
+    result = BoolValue(match);
+    return absl::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<DirectExpressionStep> subject_;
+  const std::shared_ptr<const RegexSet> regex_set_;
+  const size_t index_;
+};
+
 }  // namespace
 
 std::unique_ptr<DirectExpressionStep> CreateDirectRegexMatchStep(
@@ -139,4 +461,41 @@ absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateRegexMatchStep(
   return std::make_unique<RegexMatchStep>(expr_id, std::move(re2));
 }
 
+std::unique_ptr<DirectExpressionStep> CreateDirectLiteralMatchStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> subject,
+    LiteralMatchKind kind, std::string literal) {
+  return std::make_unique<LiteralMatchDirectStep>(expr_id, std::move(subject),
+                                                  kind, std::move(literal));
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateLiteralMatchStep(
+    LiteralMatchKind kind, std::string literal, int64_t expr_id) {
+  return std::make_unique<LiteralMatchStep>(expr_id, kind, std::move(literal));
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectRegexSetMatchStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> subject,
+    std::shared_ptr<const RegexSet> regex_set) {
+  return std::make_unique<RegexSetMatchDirectStep>(
+      expr_id, std::move(subject), std::move(regex_set));
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateRegexSetMatchStep(
+    std::shared_ptr<const RegexSet> regex_set, int64_t expr_id) {
+  return std::make_unique<RegexSetMatchStep>(expr_id, std::move(regex_set));
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectRegexScanMatchStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> subject,
+    std::shared_ptr<const RegexSet> regex_set, size_t index) {
+  return std::make_unique<RegexScanMatchDirectStep>(
+      expr_id, std::move(subject), std::move(regex_set), index);
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateRegexScanMatchStep(
+    std::shared_ptr<const RegexSet> regex_set, size_t index, int64_t expr_id) {
+  return std::make_unique<RegexScanMatchStep>(expr_id, std::move(regex_set),
+                                              index);
+}
+
 }  // namespace google::api::expr::runtime
@@ -15,13 +15,17 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_REGEX_MATCH_STEP_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_EVAL_REGEX_MATCH_STEP_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/status/statusor.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
 #include "re2/re2.h"
+#include "re2/set.h"
 
 namespace google::api::expr::runtime {
 
@@ -32,6 +36,60 @@ std::unique_ptr<DirectExpressionStep> CreateDirectRegexMatchStep(
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateRegexMatchStep(
     std::shared_ptr<const RE2> re2, int64_t expr_id);
 
+// How a literal pattern is matched against the subject.
+enum class LiteralMatchKind {
+  // `^literal$`
+  kExact,
+  // `^literal`
+  kPrefix,
+  // `literal$`
+  kSuffix,
+  // `literal`
+  kContains,
+};
+
+// Create a direct step for a regular expression match where the pattern is
+// a literal, possibly anchored at either end. Evaluates the same as the
+// equivalent RE2 match without running the regex engine.
+std::unique_ptr<DirectExpressionStep> CreateDirectLiteralMatchStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> subject,
+    LiteralMatchKind kind, std::string literal);
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateLiteralMatchStep(
+    LiteralMatchKind kind, std::string literal, int64_t expr_id);
+
+// Precompiled disjunction of regular expressions.
+//
+// `set` matches all of the patterns in a single pass. `programs` holds the
+// individual patterns, which are used as a fallback if the set exceeds its
+// DFA memory budget.
+struct RegexSet {
+  std::unique_ptr<RE2::Set> set;
+  std::vector<std::shared_ptr<const RE2>> programs;
+};
+
+// Create a direct step that evaluates to true if the subject matches any of
+// the patterns in the set.
+std::unique_ptr<DirectExpressionStep> CreateDirectRegexSetMatchStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> subject,
+    std::shared_ptr<const RegexSet> regex_set);
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateRegexSetMatchStep(
+    std::shared_ptr<const RegexSet> regex_set, int64_t expr_id);
+
+// Create a direct step that evaluates to true if the subject matches the
+// pattern at `index` in the set.
+//
+// The set holds the patterns of all the steps matching the same operand. The
+// first of these steps to see a given subject scans it with the whole set and
+// records the result in the frame, so the others only look up their pattern.
+std::unique_ptr<DirectExpressionStep> CreateDirectRegexScanMatchStep(
+    int64_t expr_id, std::unique_ptr<DirectExpressionStep> subject,
+    std::shared_ptr<const RegexSet> regex_set, size_t index);
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateRegexScanMatchStep(
+    std::shared_ptr<const RegexSet> regex_set, size_t index, int64_t expr_id);
+
 }
 
 #endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_REGEX_MATCH_STEP_H_
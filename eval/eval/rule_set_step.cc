@@ -0,0 +1,189 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/rule_set_step.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/native_type.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "eval/eval/expression_step_base.h"
+#include "internal/casts.h"
+#include "internal/status_macros.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::NativeTypeId;
+using ::cel::ParsedListValue;
+using ::cel::Value;
+
+// The results of the rules of a rule set.
+//
+// Exposed to the evaluator as a list so that it can be planned as the result
+// of an expression, but the elements may be errors or unknowns, which lists
+// can't otherwise hold. Only intended to be unpacked by the rule set program.
+class RuleSetResults final : public cel::ParsedListValueInterface {
+ public:
+  explicit RuleSetResults(std::vector<Value> results)
+      : results_(std::move(results)) {}
+
+  const std::vector<Value>& results() const { return results_; }
+
+  std::string DebugString() const override {
+    return absl::StrCat(
+        "rule_set[",
+        absl::StrJoin(results_, ", ",
+                      [](std::string* out, const Value& result) {
+                        out->append(result.DebugString());
+                      }),
+        "]");
+  }
+
+  size_t Size() const override { return results_.size(); }
+
+  absl::StatusOr<cel::JsonArray> ConvertToJsonArray(
+      cel::AnyToJsonConverter&) const override {
+    return absl::FailedPreconditionError(
+        "rule set results are not convertible to JSON");
+  }
+
+ protected:
+  cel::Type GetTypeImpl(cel::TypeManager& type_manager) const override {
+    return cel::ListType(type_manager.GetDynListType());
+  }
+
+ private:
+  absl::StatusOr<cel::ValueView> GetImpl(cel::ValueManager&, size_t index,
+                                         Value&) const override {
+    return results_[index];
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<RuleSetResults>();
+  }
+
+  const std::vector<Value> results_;
+};
+
+Value MakeRuleSetResults(cel::ValueManager& value_manager,
+                         std::vector<Value> results) {
+  return cel::ListValue(ParsedListValue(
+      value_manager.GetMemoryManager().MakeShared<RuleSetResults>(
+          std::move(results))));
+}
+
+class RuleSetStep : public ExpressionStepBase {
+ public:
+  RuleSetStep(size_t rule_count, int64_t expr_id)
+      : ExpressionStepBase(expr_id), rule_count_(rule_count) {}
+
+  absl::Status Evaluate(ExecutionFrame* frame) const override {
+    if (!frame->value_stack().HasEnough(rule_count_)) {
+      return absl::InternalError("RuleSetStep: stack underflow");
+    }
+    auto args = frame->value_stack().GetSpan(rule_count_);
+    Value result = MakeRuleSetResults(frame->value_manager(),
+                                      std::vector<Value>(args.begin(),
+                                                         args.end()));
+    frame->value_stack().PopAndPush(rule_count_, std::move(result));
+    return absl::OkStatus();
+  }
+
+ private:
+  size_t rule_count_;
+};
+
+class DirectRuleSetStep : public DirectExpressionStep {
+ public:
+  DirectRuleSetStep(std::vector<std::unique_ptr<DirectExpressionStep>> rules,
+                    int64_t expr_id)
+      : DirectExpressionStep(expr_id), rules_(std::move(rules)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& attribute) const override {
+    std::vector<Value> results(rules_.size());
+    AttributeTrail rule_attribute;
+    for (size_t i = 0; i < rules_.size(); ++i) {
+      CEL_RETURN_IF_ERROR(
+          rules_[i]->Evaluate(frame, results[i], rule_attribute));
+    }
+    result = MakeRuleSetResults(frame.value_manager(), std::move(results));
+    return absl::OkStatus();
+  }
+
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    std::vector<const DirectExpressionStep*> dependencies;
+    dependencies.reserve(rules_.size());
+    for (const auto& rule : rules_) {
+      dependencies.push_back(rule.get());
+    }
+    return dependencies;
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    return std::move(rules_);
+  }
+
+ private:
+  std::vector<std::unique_ptr<DirectExpressionStep>> rules_;
+};
+
+}  // namespace
+
+absl::Nullable<const std::vector<Value>*> GetRuleSetResults(
+    const Value& value) {
+  if (auto parsed = cel::As<ParsedListValue>(value);
+      parsed.has_value() &&
+      NativeTypeId::Of(*parsed) == NativeTypeId::For<RuleSetResults>()) {
+    return &cel::internal::down_cast<const RuleSetResults&>(
+                *(*parsed).operator->())
+                .results();
+  }
+  return nullptr;
+}
+
+std::unique_ptr<ExpressionStep> CreateRuleSetStep(size_t rule_count,
+                                                  int64_t expr_id) {
+  return std::make_unique<RuleSetStep>(rule_count, expr_id);
+}
+
+std::unique_ptr<DirectExpressionStep> CreateDirectRuleSetStep(
+    std::vector<std::unique_ptr<DirectExpressionStep>> rules,
+    int64_t expr_id) {
+  return std::make_unique<DirectRuleSetStep>(std::move(rules), expr_id);
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,54 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Program steps collecting the results of the rules of a rule set, planned
+// as one expression so that the subexpressions shared by the rules are only
+// evaluated once.
+//
+// Unlike a list, the results of the rules are collected as is, so an error
+// or unknown only affects the result of the rule that produced it.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_RULE_SET_STEP_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_RULE_SET_STEP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "common/value.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+
+namespace google::api::expr::runtime {
+
+// Returns the results of the rules if `value` was produced by a rule set step,
+// or null otherwise.
+absl::Nullable<const std::vector<cel::Value>*> GetRuleSetResults(
+    const cel::Value& value);
+
+// Factory method for a step collecting the results of the top `rule_count`
+// values on the stack.
+std::unique_ptr<ExpressionStep> CreateRuleSetStep(size_t rule_count,
+                                                  int64_t expr_id);
+
+// Factory method for a recursive step evaluating each of `rules` in order and
+// collecting their results.
+std::unique_ptr<DirectExpressionStep> CreateDirectRuleSetStep(
+    std::vector<std::unique_ptr<DirectExpressionStep>> rules, int64_t expr_id);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_RULE_SET_STEP_H_
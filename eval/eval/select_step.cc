@@ -1,11 +1,13 @@
 #include "eval/eval/select_step.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <utility>
 
+#include "absl/base/optimization.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -36,6 +38,7 @@ using ::cel::InstanceOf;
 using ::cel::MapValue;
 using ::cel::NullValue;
 using ::cel::OptionalValue;
+using ::cel::ParsedStructValue;
 using ::cel::ProtoWrapperTypeOptions;
 using ::cel::StringValue;
 using ::cel::StructValue;
@@ -79,9 +82,58 @@ absl::optional<Value> CheckForMarkedAttributes(const AttributeTrail& trail,
   return absl::nullopt;
 }
 
+// Whether `struct_value` is a message of the type `typed_field` was resolved
+// against. Legacy struct values only support access by name.
+bool IsTypedFieldOf(const StructValue& struct_value,
+                    const absl::optional<TypedSelectField>& typed_field) {
+  return typed_field.has_value() &&
+         InstanceOf<ParsedStructValue>(struct_value) &&
+         struct_value.GetTypeName() == typed_field->message_type;
+}
+
+absl::StatusOr<ValueView> GetStructField(
+    const StructValue& struct_value, const std::string& field,
+    const absl::optional<TypedSelectField>& typed_field,
+    cel::ValueManager& value_factory, Value& scratch,
+    ProtoWrapperTypeOptions unboxing_option) {
+  if (IsTypedFieldOf(struct_value, typed_field)) {
+    return struct_value.GetFieldByNumber(value_factory, typed_field->number,
+                                         scratch, unboxing_option);
+  }
+  return struct_value.GetFieldByName(value_factory, field, scratch,
+                                     unboxing_option);
+}
+
+absl::StatusOr<bool> HasStructField(
+    const StructValue& struct_value, const std::string& field,
+    const absl::optional<TypedSelectField>& typed_field) {
+  if (IsTypedFieldOf(struct_value, typed_field)) {
+    return struct_value.HasFieldByNumber(typed_field->number);
+  }
+  return struct_value.HasFieldByName(field);
+}
+
+// Selects `field` from `map_value` by name and its precomputed hash, falling
+// back to `Get` with `field_value` to report missing keys.
+absl::StatusOr<ValueView> GetMapField(const MapValue& map_value,
+                                      const std::string& field,
+                                      const StringValue& field_value,
+                                      size_t field_hash,
+                                      cel::ValueManager& value_factory,
+                                      Value& scratch) {
+  CEL_ASSIGN_OR_RETURN(
+      auto lookup,
+      map_value.FindByString(value_factory, field, field_hash, scratch));
+  if (lookup.second) {
+    return lookup.first;
+  }
+  return map_value.Get(value_factory, field_value, scratch);
+}
+
 ValueView TestOnlySelect(const StructValue& msg, const std::string& field,
+                         const absl::optional<TypedSelectField>& typed_field,
                          cel::ValueManager& value_factory, Value& scratch) {
-  absl::StatusOr<bool> result = msg.HasFieldByName(field);
+  absl::StatusOr<bool> result = HasStructField(msg, field, typed_field);
 
   if (!result.ok()) {
     scratch = value_factory.CreateErrorValue(std::move(result).status());
@@ -107,18 +159,25 @@ ValueView TestOnlySelect(const MapValue& map, const StringValue& field_name,
 
 // SelectStep performs message field access specified by Expr::Select
 // message.
+//
+// If kAttributeTracking is false, the program was planned without unknown or
+// missing attribute support and attribute trails are never computed.
+template <bool kAttributeTracking>
 class SelectStep : public ExpressionStepBase {
  public:
   SelectStep(StringValue value, bool test_field_presence, int64_t expr_id,
-             bool enable_wrapper_type_null_unboxing, bool enable_optional_types)
+             bool enable_wrapper_type_null_unboxing, bool enable_optional_types,
+             absl::optional<TypedSelectField> typed_field)
       : ExpressionStepBase(expr_id),
         field_value_(std::move(value)),
         field_(field_value_.ToString()),
+        field_hash_(cel::MapKeyHash(field_value_)),
         test_field_presence_(test_field_presence),
         unboxing_option_(enable_wrapper_type_null_unboxing
                              ? ProtoWrapperTypeOptions::kUnsetNull
                              : ProtoWrapperTypeOptions::kUnsetProtoDefault),
-        enable_optional_types_(enable_optional_types) {}
+        enable_optional_types_(enable_optional_types),
+        typed_field_(std::move(typed_field)) {}
 
   absl::Status Evaluate(ExecutionFrame* frame) const override;
 
@@ -128,21 +187,36 @@ class SelectStep : public ExpressionStepBase {
   absl::StatusOr<std::pair<ValueView, bool>> PerformSelect(
       ExecutionFrame* frame, const Value& arg, Value& scratch) const;
 
+  // Replace the operand on top of the stack with the select result.
+  void SetResult(ExecutionFrame* frame, Value result,
+                 AttributeTrail& result_trail) const {
+    if constexpr (kAttributeTracking) {
+      frame->value_stack().PopAndPush(std::move(result),
+                                      std::move(result_trail));
+    } else {
+      frame->value_stack().PopAndPushValue(1, std::move(result));
+    }
+  }
+
   cel::StringValue field_value_;
   std::string field_;
+  // `cel::MapKeyHash` of `field_value_`, for selecting it from maps.
+  size_t field_hash_;
   bool test_field_presence_;
   ProtoWrapperTypeOptions unboxing_option_;
   bool enable_optional_types_;
+  absl::optional<TypedSelectField> typed_field_;
 };
 
-absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
+template <bool kAttributeTracking>
+absl::Status SelectStep<kAttributeTracking>::Evaluate(
+    ExecutionFrame* frame) const {
   if (!frame->value_stack().HasEnough(1)) {
     return absl::Status(absl::StatusCode::kInternal,
                         "No arguments supplied for Select-type expression");
   }
 
   const Value& arg = frame->value_stack().Peek();
-  const AttributeTrail& trail = frame->value_stack().PeekAttribute();
 
   if (InstanceOf<UnknownValue>(arg) || InstanceOf<ErrorValue>(arg)) {
     // Bubble up unknowns and errors.
@@ -152,15 +226,17 @@ absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
   AttributeTrail result_trail;
 
   // Handle unknown resolution.
-  if (frame->enable_unknowns() || frame->enable_missing_attribute_errors()) {
-    result_trail = trail.Step(&field_);
+  if constexpr (kAttributeTracking) {
+    if (frame->enable_unknowns() || frame->enable_missing_attribute_errors()) {
+      result_trail = frame->value_stack().PeekAttribute().Step(&field_);
+    }
   }
 
   if (arg->Is<NullValue>()) {
-    frame->value_stack().PopAndPush(
-        frame->value_factory().CreateErrorValue(
-            cel::runtime_internal::CreateError("Message is NULL")),
-        std::move(result_trail));
+    SetResult(frame,
+              frame->value_factory().CreateErrorValue(
+                  cel::runtime_internal::CreateError("Message is NULL")),
+              result_trail);
     return absl::OkStatus();
   }
 
@@ -175,18 +251,21 @@ absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
 
   if (!(optional_arg != nullptr || arg->Is<MapValue>() ||
         arg->Is<StructValue>())) {
-    frame->value_stack().PopAndPush(
+    SetResult(
+        frame,
         frame->value_factory().CreateErrorValue(InvalidSelectTargetError()),
-        std::move(result_trail));
+        result_trail);
     return absl::OkStatus();
   }
 
-  absl::optional<Value> marked_attribute_check =
-      CheckForMarkedAttributes(result_trail, *frame);
-  if (marked_attribute_check.has_value()) {
-    frame->value_stack().PopAndPush(std::move(marked_attribute_check).value(),
-                                    std::move(result_trail));
-    return absl::OkStatus();
+  if constexpr (kAttributeTracking) {
+    absl::optional<Value> marked_attribute_check =
+        CheckForMarkedAttributes(result_trail, *frame);
+    if (marked_attribute_check.has_value()) {
+      SetResult(frame, std::move(marked_attribute_check).value(),
+                result_trail);
+      return absl::OkStatus();
+    }
   }
 
   Value result_scratch;
@@ -195,7 +274,8 @@ absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
   if (test_field_presence_) {
     if (optional_arg != nullptr) {
       if (!optional_arg->HasValue()) {
-        frame->value_stack().PopAndPush(cel::BoolValue{false});
+        AttributeTrail empty_trail;
+        SetResult(frame, cel::BoolValue{false}, empty_trail);
         return absl::OkStatus();
       }
       return PerformTestOnlySelect(frame, optional_arg->Value(),
@@ -217,13 +297,13 @@ absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
         std::tie(result, ok),
         PerformSelect(frame, optional_arg->Value(), result_scratch));
     if (!ok) {
-      frame->value_stack().PopAndPush(cel::OptionalValue::None(),
-                                      std::move(result_trail));
+      SetResult(frame, cel::OptionalValue::None(), result_trail);
       return absl::OkStatus();
     }
-    frame->value_stack().PopAndPush(
-        cel::OptionalValue::Of(frame->memory_manager(), cel::Value{result}),
-        std::move(result_trail));
+    SetResult(frame,
+              cel::OptionalValue::Of(frame->memory_manager(),
+                                     cel::Value{result}),
+              result_trail);
     return absl::OkStatus();
   }
 
@@ -231,17 +311,20 @@ absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
   // Select steps can be applied to either maps or messages
   switch (arg->kind()) {
     case ValueKind::kStruct: {
-      CEL_ASSIGN_OR_RETURN(auto result, arg.As<StructValue>().GetFieldByName(
-                                            frame->value_factory(), field_,
-                                            result_scratch, unboxing_option_));
-      frame->value_stack().PopAndPush(Value{result}, std::move(result_trail));
+      CEL_ASSIGN_OR_RETURN(
+          auto result,
+          GetStructField(arg.As<StructValue>(), field_, typed_field_,
+                         frame->value_factory(), result_scratch,
+                         unboxing_option_));
+      SetResult(frame, Value{result}, result_trail);
       return absl::OkStatus();
     }
     case ValueKind::kMap: {
       CEL_ASSIGN_OR_RETURN(
-          auto result, arg.As<MapValue>().Get(frame->value_factory(),
-                                              field_value_, result_scratch));
-      frame->value_stack().PopAndPush(Value{result}, std::move(result_trail));
+          auto result,
+          GetMapField(arg.As<MapValue>(), field_, field_value_, field_hash_,
+                      frame->value_factory(), result_scratch));
+      SetResult(frame, Value{result}, result_trail);
       return absl::OkStatus();
     }
     default:
@@ -250,17 +333,23 @@ absl::Status SelectStep::Evaluate(ExecutionFrame* frame) const {
   }
 }
 
-absl::Status SelectStep::PerformTestOnlySelect(ExecutionFrame* frame,
-                                               const Value& arg,
-                                               Value& scratch) const {
+template <bool kAttributeTracking>
+absl::Status SelectStep<kAttributeTracking>::PerformTestOnlySelect(
+    ExecutionFrame* frame, const Value& arg, Value& scratch) const {
+  AttributeTrail empty_trail;
   switch (arg->kind()) {
     case ValueKind::kMap:
-      frame->value_stack().PopAndPush(Value{TestOnlySelect(
-          arg.As<MapValue>(), field_value_, frame->value_factory(), scratch)});
+      SetResult(frame,
+                Value{TestOnlySelect(arg.As<MapValue>(), field_value_,
+                                     frame->value_factory(), scratch)},
+                empty_trail);
       return absl::OkStatus();
     case ValueKind::kMessage:
-      frame->value_stack().PopAndPush(Value{TestOnlySelect(
-          arg.As<StructValue>(), field_, frame->value_factory(), scratch)});
+      SetResult(frame,
+                Value{TestOnlySelect(arg.As<StructValue>(), field_,
+                                     typed_field_, frame->value_factory(),
+                                     scratch)},
+                empty_trail);
       return absl::OkStatus();
     default:
       // Control flow should have returned earlier.
@@ -268,23 +357,28 @@ absl::Status SelectStep::PerformTestOnlySelect(ExecutionFrame* frame,
   }
 }
 
-absl::StatusOr<std::pair<ValueView, bool>> SelectStep::PerformSelect(
-    ExecutionFrame* frame, const Value& arg, Value& scratch) const {
+template <bool kAttributeTracking>
+absl::StatusOr<std::pair<ValueView, bool>>
+SelectStep<kAttributeTracking>::PerformSelect(ExecutionFrame* frame,
+                                              const Value& arg,
+                                              Value& scratch) const {
   switch (arg->kind()) {
     case ValueKind::kStruct: {
       const auto& struct_value = arg.As<StructValue>();
-      CEL_ASSIGN_OR_RETURN(auto ok, struct_value.HasFieldByName(field_));
+      CEL_ASSIGN_OR_RETURN(auto ok,
+                           HasStructField(struct_value, field_, typed_field_));
       if (!ok) {
         return std::pair{cel::NullValueView{}, false};
       }
-      CEL_ASSIGN_OR_RETURN(auto result, struct_value.GetFieldByName(
-                                            frame->value_factory(), field_,
-                                            scratch, unboxing_option_));
+      CEL_ASSIGN_OR_RETURN(
+          auto result,
+          GetStructField(struct_value, field_, typed_field_,
+                         frame->value_factory(), scratch, unboxing_option_));
       return std::pair{result, true};
     }
     case ValueKind::kMap: {
-      return arg.As<MapValue>().Find(frame->value_factory(), field_value_,
-                                     scratch);
+      return arg.As<MapValue>().FindByString(frame->value_factory(), field_,
+                                             field_hash_, scratch);
     }
     default:
       // Control flow should have returned earlier.
@@ -292,30 +386,36 @@ absl::StatusOr<std::pair<ValueView, bool>> SelectStep::PerformSelect(
   }
 }
 
-class DirectSelectStep : public DirectExpressionStep {
+class DirectSelectStep : public FastDirectExpressionStep {
  public:
   DirectSelectStep(int64_t expr_id,
                    std::unique_ptr<DirectExpressionStep> operand,
                    StringValue field, bool test_only,
                    bool enable_wrapper_type_null_unboxing,
-                   bool enable_optional_types)
-      : DirectExpressionStep(expr_id),
+                   bool enable_optional_types,
+                   absl::optional<TypedSelectField> typed_field)
+      : FastDirectExpressionStep(expr_id),
         operand_(std::move(operand)),
         field_value_(std::move(field)),
         field_(field_value_.ToString()),
+        field_hash_(cel::MapKeyHash(field_value_)),
         test_only_(test_only),
         unboxing_option_(enable_wrapper_type_null_unboxing
                              ? ProtoWrapperTypeOptions::kUnsetNull
                              : ProtoWrapperTypeOptions::kUnsetProtoDefault),
-        enable_optional_types_(enable_optional_types) {}
-
-  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
-                        AttributeTrail& attribute) const override {
-    CEL_RETURN_IF_ERROR(operand_->Evaluate(frame, result, attribute));
+        enable_optional_types_(enable_optional_types),
+        typed_field_(std::move(typed_field)) {}
+
+  bool EvaluateFast(ExecutionFrameBase& frame, Value& result,
+                    AttributeTrail& attribute,
+                    absl::Status& status) const override {
+    if (!operand_->EvaluateFast(frame, result, attribute, status)) {
+      return false;
+    }
 
     if (InstanceOf<ErrorValue>(result) || InstanceOf<UnknownValue>(result)) {
       // Just forward.
-      return absl::OkStatus();
+      return true;
     }
 
     if (frame.attribute_tracking_enabled()) {
@@ -323,7 +423,7 @@ class DirectSelectStep : public DirectExpressionStep {
       absl::optional<Value> value = CheckForMarkedAttributes(attribute, frame);
       if (value.has_value()) {
         result = std::move(value).value();
-        return absl::OkStatus();
+        return true;
       }
     }
 
@@ -344,14 +444,14 @@ class DirectSelectStep : public DirectExpressionStep {
       case ValueKind::kNull:
         result = frame.value_manager().CreateErrorValue(
             cel::runtime_internal::CreateError("Message is NULL"));
-        return absl::OkStatus();
+        return true;
       default:
         if (optional_arg != nullptr) {
           break;
         }
         result =
             frame.value_manager().CreateErrorValue(InvalidSelectTargetError());
-        return absl::OkStatus();
+        return true;
     }
 
     Value scratch;
@@ -359,28 +459,26 @@ class DirectSelectStep : public DirectExpressionStep {
       if (optional_arg != nullptr) {
         if (!optional_arg->HasValue()) {
           result = cel::BoolValue{false};
-          return absl::OkStatus();
+          return true;
         }
         result = PerformTestOnlySelect(frame, optional_arg->Value(), scratch);
-        return absl::OkStatus();
+        return true;
       }
       result = PerformTestOnlySelect(frame, result, scratch);
-      return absl::OkStatus();
+      return true;
     }
 
     if (optional_arg != nullptr) {
       if (!optional_arg->HasValue()) {
         // result is still buffer for the container. just return.
-        return absl::OkStatus();
+        return true;
       }
-      CEL_ASSIGN_OR_RETURN(
-          result, PerformOptionalSelect(frame, optional_arg->Value(), scratch));
-
-      return absl::OkStatus();
+      return AssignOrFail(
+          PerformOptionalSelect(frame, optional_arg->Value(), scratch), result,
+          status);
     }
 
-    CEL_ASSIGN_OR_RETURN(result, PerformSelect(frame, result, scratch));
-    return absl::OkStatus();
+    return AssignOrFail(PerformSelect(frame, result, scratch), result, status);
   }
 
  private:
@@ -395,6 +493,17 @@ class DirectSelectStep : public DirectExpressionStep {
                                           const Value& value,
                                           Value& scratch) const;
 
+  // Assigns the selected value to `result`, or its error to `status`.
+  static bool AssignOrFail(absl::StatusOr<ValueView> selected, Value& result,
+                           absl::Status& status) {
+    if (ABSL_PREDICT_FALSE(!selected.ok())) {
+      status = std::move(selected).status();
+      return false;
+    }
+    result = *selected;
+    return true;
+  }
+
   // Field name in formats supported by each of the map and struct field access
   // APIs.
   //
@@ -402,11 +511,14 @@ class DirectSelectStep : public DirectExpressionStep {
   // plan time.
   StringValue field_value_;
   std::string field_;
+  // `cel::MapKeyHash` of `field_value_`, for selecting it from maps.
+  size_t field_hash_;
 
   // whether this is a has() expression.
   bool test_only_;
   ProtoWrapperTypeOptions unboxing_option_;
   bool enable_optional_types_;
+  absl::optional<TypedSelectField> typed_field_;
 };
 
 ValueView DirectSelectStep::PerformTestOnlySelect(ExecutionFrameBase& frame,
@@ -417,7 +529,7 @@ ValueView DirectSelectStep::PerformTestOnlySelect(ExecutionFrameBase& frame,
       return TestOnlySelect(Cast<MapValue>(value), field_value_,
                             frame.value_manager(), scratch);
     case ValueKind::kMessage:
-      return TestOnlySelect(Cast<StructValue>(value), field_,
+      return TestOnlySelect(Cast<StructValue>(value), field_, typed_field_,
                             frame.value_manager(), scratch);
     default:
       // Control flow should have returned earlier.
@@ -432,22 +544,25 @@ absl::StatusOr<ValueView> DirectSelectStep::PerformOptionalSelect(
   switch (value.kind()) {
     case ValueKind::kStruct: {
       auto struct_value = Cast<StructValue>(value);
-      CEL_ASSIGN_OR_RETURN(auto ok, struct_value.HasFieldByName(field_));
+      CEL_ASSIGN_OR_RETURN(auto ok,
+                           HasStructField(struct_value, field_, typed_field_));
       if (!ok) {
         scratch = OptionalValue::None();
         return ValueView{scratch};
       }
-      CEL_ASSIGN_OR_RETURN(auto result, struct_value.GetFieldByName(
-                                            frame.value_manager(), field_,
-                                            scratch, unboxing_option_));
+      CEL_ASSIGN_OR_RETURN(
+          auto result,
+          GetStructField(struct_value, field_, typed_field_,
+                         frame.value_manager(), scratch, unboxing_option_));
       scratch = OptionalValue::Of(frame.value_manager().GetMemoryManager(),
                                   Value(result));
       return ValueView{scratch};
     }
     case ValueKind::kMap: {
-      CEL_ASSIGN_OR_RETURN(auto lookup,
-                           Cast<MapValue>(value).Find(frame.value_manager(),
-                                                      field_value_, scratch));
+      CEL_ASSIGN_OR_RETURN(
+          auto lookup,
+          Cast<MapValue>(value).FindByString(frame.value_manager(), field_,
+                                             field_hash_, scratch));
       if (!lookup.second) {
         scratch = OptionalValue::None();
         return ValueView{scratch};
@@ -466,12 +581,12 @@ absl::StatusOr<ValueView> DirectSelectStep::PerformSelect(
     ExecutionFrameBase& frame, const cel::Value& value, Value& scratch) const {
   switch (value.kind()) {
     case ValueKind::kStruct: {
-      return Cast<StructValue>(value).GetFieldByName(
-          frame.value_manager(), field_, scratch, unboxing_option_);
+      return GetStructField(Cast<StructValue>(value), field_, typed_field_,
+                            frame.value_manager(), scratch, unboxing_option_);
     }
     case ValueKind::kMap: {
-      return Cast<MapValue>(value).Get(frame.value_manager(), field_value_,
-                                       scratch);
+      return GetMapField(Cast<MapValue>(value), field_, field_value_,
+                         field_hash_, frame.value_manager(), scratch);
     }
     default:
       // Control flow should have returned earlier.
@@ -484,21 +599,39 @@ absl::StatusOr<ValueView> DirectSelectStep::PerformSelect(
 std::unique_ptr<DirectExpressionStep> CreateDirectSelectStep(
     std::unique_ptr<DirectExpressionStep> operand, StringValue field,
     bool test_only, int64_t expr_id, bool enable_wrapper_type_null_unboxing,
-    bool enable_optional_types) {
+    bool enable_optional_types, absl::optional<TypedSelectField> typed_field) {
   return std::make_unique<DirectSelectStep>(
       expr_id, std::move(operand), std::move(field), test_only,
-      enable_wrapper_type_null_unboxing, enable_optional_types);
+      enable_wrapper_type_null_unboxing, enable_optional_types,
+      std::move(typed_field));
 }
 
 // Factory method for Select - based Execution step
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateSelectStep(
     const cel::ast_internal::Select& select_expr, int64_t expr_id,
     bool enable_wrapper_type_null_unboxing, cel::ValueManager& value_factory,
-    bool enable_optional_types) {
-  return std::make_unique<SelectStep>(
+    bool enable_optional_types, bool enable_attribute_tracking) {
+  return CreateSelectStep(
+      select_expr, expr_id, enable_wrapper_type_null_unboxing,
       value_factory.CreateUncheckedStringValue(select_expr.field()),
-      select_expr.test_only(), expr_id, enable_wrapper_type_null_unboxing,
-      enable_optional_types);
+      enable_optional_types, enable_attribute_tracking);
+}
+
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateSelectStep(
+    const cel::ast_internal::Select& select_expr, int64_t expr_id,
+    bool enable_wrapper_type_null_unboxing, cel::StringValue field,
+    bool enable_optional_types, bool enable_attribute_tracking,
+    absl::optional<TypedSelectField> typed_field) {
+  if (!enable_attribute_tracking) {
+    return std::make_unique<SelectStep<false>>(
+        std::move(field), select_expr.test_only(), expr_id,
+        enable_wrapper_type_null_unboxing, enable_optional_types,
+        std::move(typed_field));
+  }
+  return std::make_unique<SelectStep<true>>(
+      std::move(field), select_expr.test_only(), expr_id,
+      enable_wrapper_type_null_unboxing, enable_optional_types,
+      std::move(typed_field));
 }
 
 }  // namespace google::api::expr::runtime
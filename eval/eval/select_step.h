@@ -3,8 +3,10 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "base/ast_internal/expr.h"
 #include "common/value.h"
 #include "common/value_manager.h"
@@ -13,17 +15,41 @@
 
 namespace google::api::expr::runtime {
 
+// Field of a message type, resolved at plan time from the checked type of the
+// operand of a select.
+//
+// Messages which support it are read by the field number rather than looked up
+// by name on every evaluation. Other values are selected as usual.
+struct TypedSelectField {
+  // Fully qualified name of the message type the field was resolved against.
+  std::string message_type;
+  int64_t number;
+};
+
 // Factory method for recursively evaluated select step.
 std::unique_ptr<DirectExpressionStep> CreateDirectSelectStep(
     std::unique_ptr<DirectExpressionStep> operand, cel::StringValue field,
     bool test_only, int64_t expr_id, bool enable_wrapper_type_null_unboxing,
-    bool enable_optional_types = false);
+    bool enable_optional_types = false,
+    absl::optional<TypedSelectField> typed_field = absl::nullopt);
 
 // Factory method for Select - based Execution step
+//
+// If enable_attribute_tracking is false, the returned step never constructs
+// attribute trails. This is only valid if the program is evaluated with
+// unknown processing and missing attribute errors disabled.
 absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateSelectStep(
     const cel::ast_internal::Select& select_expr, int64_t expr_id,
     bool enable_wrapper_type_null_unboxing, cel::ValueManager& value_factory,
-    bool enable_optional_types = false);
+    bool enable_optional_types = false, bool enable_attribute_tracking = true);
+
+// Overload of the above selecting the field named `field`, which is usually
+// interned by the planner.
+absl::StatusOr<std::unique_ptr<ExpressionStep>> CreateSelectStep(
+    const cel::ast_internal::Select& select_expr, int64_t expr_id,
+    bool enable_wrapper_type_null_unboxing, cel::StringValue field,
+    bool enable_optional_types = false, bool enable_attribute_tracking = true,
+    absl::optional<TypedSelectField> typed_field = absl::nullopt);
 
 }  // namespace google::api::expr::runtime
 
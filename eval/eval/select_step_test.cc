@@ -1403,6 +1403,77 @@ TEST_F(DirectSelectStepTest, HasStruct) {
   EXPECT_FALSE(Cast<BoolValue>(result).NativeValue());
 }
 
+TEST_F(DirectSelectStepTest, SelectFromTypedStruct) {
+  cel::Activation activation;
+  RuntimeOptions options;
+  TypedSelectField typed_field{
+      std::string(TestAllTypes::descriptor()->full_name()),
+      TestAllTypes::kSingleInt64FieldNumber};
+
+  auto select_step = CreateDirectSelectStep(
+      CreateDirectIdentStep("test_all_types", -1),
+      value_manager_.get().CreateUncheckedStringValue("single_int64"),
+      /*test_only=*/false, -1,
+      /*enable_wrapper_type_null_unboxing=*/true,
+      /*enable_optional_types=*/false, typed_field);
+  auto has_step = CreateDirectSelectStep(
+      CreateDirectIdentStep("test_all_types", -1),
+      value_manager_.get().CreateUncheckedStringValue("single_int64"),
+      /*test_only=*/true, -1,
+      /*enable_wrapper_type_null_unboxing=*/true,
+      /*enable_optional_types=*/false, typed_field);
+
+  TestAllTypes message;
+  message.set_single_int64(1);
+  ASSERT_OK_AND_ASSIGN(Value parsed_message,
+                       ProtoMessageToValue(value_manager_.get(), message));
+
+  // Parsed messages are read by field number, legacy ones by name.
+  for (const Value& struct_val : {parsed_message, TestWrapMessage(&message)}) {
+    activation.InsertOrAssignValue("test_all_types", struct_val);
+    ExecutionFrameBase frame(activation, options, value_manager_.get());
+
+    Value result;
+    AttributeTrail attr;
+    ASSERT_OK(select_step->Evaluate(frame, result, attr));
+    EXPECT_THAT(result, IntValueIs(1));
+
+    ASSERT_OK(has_step->Evaluate(frame, result, attr));
+    ASSERT_TRUE(InstanceOf<BoolValue>(result));
+    EXPECT_TRUE(Cast<BoolValue>(result).NativeValue());
+  }
+}
+
+TEST_F(DirectSelectStepTest, SelectFromStructOfOtherType) {
+  cel::Activation activation;
+  RuntimeOptions options;
+
+  // Values of another type than the one the field was resolved against are
+  // read by name.
+  auto step = CreateDirectSelectStep(
+      CreateDirectIdentStep("test_all_types", -1),
+      value_manager_.get().CreateUncheckedStringValue("single_int64"),
+      /*test_only=*/false, -1,
+      /*enable_wrapper_type_null_unboxing=*/true,
+      /*enable_optional_types=*/false,
+      TypedSelectField{"google.api.expr.runtime.TestMessage",
+                       TestAllTypes::kSingleInt32FieldNumber});
+
+  TestAllTypes message;
+  message.set_single_int32(2);
+  message.set_single_int64(1);
+  ASSERT_OK_AND_ASSIGN(Value struct_val,
+                       ProtoMessageToValue(value_manager_.get(), message));
+  activation.InsertOrAssignValue("test_all_types", struct_val);
+
+  ExecutionFrameBase frame(activation, options, value_manager_.get());
+
+  Value result;
+  AttributeTrail attr;
+  ASSERT_OK(step->Evaluate(frame, result, attr));
+  EXPECT_THAT(result, IntValueIs(1));
+}
+
 TEST_F(DirectSelectStepTest, SelectFromUnsupportedType) {
   cel::Activation activation;
   RuntimeOptions options;
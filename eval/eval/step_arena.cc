@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "eval/eval/step_arena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "absl/base/attributes.h"
+#include "absl/base/nullability.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+// Every step is preceded by a header recording where its storage came from,
+// which is kept as large as the alignment so that the step stays aligned.
+constexpr size_t kAlignment = alignof(std::max_align_t);
+constexpr size_t kHeaderSize = kAlignment;
+
+// Programs are typically small, so the arena starts with a small block and
+// doubles the following ones.
+constexpr size_t kInitialBlockSize = 1024;
+constexpr size_t kMaxBlockSize = 32 * 1024;
+
+enum class StepStorage : uintptr_t { kHeap, kArena };
+
+ABSL_CONST_INIT thread_local StepArena* current_step_arena = nullptr;
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+}  // namespace
+
+StepArena::Scope::Scope(StepArena& arena) : previous_(current_step_arena) {
+  current_step_arena = &arena;
+}
+
+StepArena::Scope::~Scope() { current_step_arena = previous_; }
+
+absl::Nonnull<void*> StepArena::Allocate(size_t size) {
+  size = AlignUp(size);
+  if (size > remaining_) {
+    next_block_size_ = next_block_size_ == 0
+                           ? kInitialBlockSize
+                           : std::min(next_block_size_ * 2, kMaxBlockSize);
+    size_t block_size = std::max(next_block_size_, size);
+    // Storage from operator new[] is aligned for any scalar type.
+    blocks_.push_back(std::unique_ptr<char[]>(new char[block_size]));
+    position_ = blocks_.back().get();
+    remaining_ = block_size;
+    bytes_reserved_ += block_size;
+  }
+  void* storage = position_;
+  position_ += size;
+  remaining_ -= size;
+  return storage;
+}
+
+absl::Nullable<StepArena*> StepArena::Current() { return current_step_arena; }
+
+absl::Nonnull<void*> AllocateStep(size_t size) {
+  StepArena* arena = current_step_arena;
+  char* storage;
+  StepStorage kind;
+  if (arena != nullptr) {
+    storage = static_cast<char*>(arena->Allocate(kHeaderSize + size));
+    kind = StepStorage::kArena;
+  } else {
+    storage = static_cast<char*>(::operator new(kHeaderSize + size));
+    kind = StepStorage::kHeap;
+  }
+  *reinterpret_cast<StepStorage*>(storage) = kind;
+  return storage + kHeaderSize;
+}
+
+void DeallocateStep(absl::Nullable<void*> step) noexcept {
+  if (step == nullptr) {
+    return;
+  }
+  char* storage = static_cast<char*>(step) - kHeaderSize;
+  if (*reinterpret_cast<StepStorage*>(storage) == StepStorage::kHeap) {
+    ::operator delete(storage);
+  }
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_STEP_ARENA_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_STEP_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/base/nullability.h"
+
+namespace google::api::expr::runtime {
+
+// Storage for the steps of a planned program.
+//
+// Steps created while a `StepArena::Scope` is alive on the calling thread are
+// bump allocated from its arena, so that they are laid out contiguously in
+// the order they are planned, which closely follows the execution order.
+// Steps keep being owned through `std::unique_ptr`: deleting an arena step
+// runs its destructor, while its storage is released with the arena.
+//
+// The arena must outlive every step allocated from it.
+class StepArena final {
+ public:
+  // Installs `arena` as the storage for the steps created on the calling
+  // thread, until destroyed. Scopes may be nested.
+  class Scope final {
+   public:
+    explicit Scope(StepArena& arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    StepArena* const previous_;
+  };
+
+  StepArena() = default;
+
+  StepArena(const StepArena&) = delete;
+  StepArena& operator=(const StepArena&) = delete;
+
+  // Returns storage for `size` bytes, aligned for any scalar type.
+  absl::Nonnull<void*> Allocate(size_t size);
+
+  // Total number of bytes reserved by the arena.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+  // Returns the arena of the innermost scope on the calling thread, if any.
+  static absl::Nullable<StepArena*> Current();
+
+ private:
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* position_ = nullptr;
+  size_t remaining_ = 0;
+  size_t next_block_size_ = 0;
+  size_t bytes_reserved_ = 0;
+};
+
+// Allocation functions of the step base classes, serving the current step
+// arena if any or the heap otherwise.
+absl::Nonnull<void*> AllocateStep(size_t size);
+void DeallocateStep(absl::Nullable<void*> step) noexcept;
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_STEP_ARENA_H_
@@ -0,0 +1,92 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "eval/eval/step_arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "internal/testing.h"
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::testing::IsNull;
+
+class TestStep {
+ public:
+  explicit TestStep(int& destroyed) : destroyed_(destroyed) {}
+  ~TestStep() { ++destroyed_; }
+
+  static void* operator new(size_t size) { return AllocateStep(size); }
+  static void operator delete(void* step) noexcept { DeallocateStep(step); }
+
+ private:
+  int& destroyed_;
+  char padding_[40];
+};
+
+TEST(StepArena, AllocatesContiguously) {
+  StepArena arena;
+  int destroyed = 0;
+  {
+    StepArena::Scope scope(arena);
+    auto first = std::make_unique<TestStep>(destroyed);
+    auto second = std::make_unique<TestStep>(destroyed);
+    EXPECT_GT(reinterpret_cast<uintptr_t>(second.get()),
+              reinterpret_cast<uintptr_t>(first.get()));
+    EXPECT_LT(reinterpret_cast<uintptr_t>(second.get()) -
+                  reinterpret_cast<uintptr_t>(first.get()),
+              2 * sizeof(TestStep));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first.get()) %
+                  alignof(std::max_align_t),
+              0);
+  }
+  EXPECT_EQ(destroyed, 2);
+  EXPECT_GT(arena.bytes_reserved(), 0);
+}
+
+TEST(StepArena, HeapWithoutScope) {
+  EXPECT_THAT(StepArena::Current(), IsNull());
+  int destroyed = 0;
+  auto step = std::make_unique<TestStep>(destroyed);
+  step.reset();
+  EXPECT_EQ(destroyed, 1);
+}
+
+TEST(StepArena, NestedScopes) {
+  StepArena outer;
+  StepArena inner;
+  {
+    StepArena::Scope outer_scope(outer);
+    EXPECT_EQ(StepArena::Current(), &outer);
+    {
+      StepArena::Scope inner_scope(inner);
+      EXPECT_EQ(StepArena::Current(), &inner);
+    }
+    EXPECT_EQ(StepArena::Current(), &outer);
+  }
+  EXPECT_THAT(StepArena::Current(), IsNull());
+}
+
+TEST(StepArena, LargeAllocations) {
+  StepArena arena;
+  void* small = arena.Allocate(16);
+  void* large = arena.Allocate(1024 * 1024);
+  EXPECT_NE(small, large);
+  EXPECT_GE(arena.bytes_reserved(), 1024 * 1024);
+}
+
+}  // namespace
+}  // namespace google::api::expr::runtime
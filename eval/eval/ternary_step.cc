@@ -4,9 +4,11 @@
 #include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "base/builtins.h"
 #include "common/casting.h"
 #include "common/value.h"
@@ -81,6 +83,21 @@ class ExhaustiveDirectTernaryStep : public DirectExpressionStep {
     return absl::OkStatus();
   }
 
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{condition_.get(), left_.get(), right_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.reserve(3);
+    dependencies.push_back(std::move(condition_));
+    dependencies.push_back(std::move(left_));
+    dependencies.push_back(std::move(right_));
+    return dependencies;
+  }
+
  private:
   std::unique_ptr<DirectExpressionStep> condition_;
   std::unique_ptr<DirectExpressionStep> left_;
@@ -125,6 +142,21 @@ class ShortcircuitingDirectTernaryStep : public DirectExpressionStep {
     return right_->Evaluate(frame, result, attribute);
   }
 
+  absl::optional<std::vector<const DirectExpressionStep*>> GetDependencies()
+      const override {
+    return {{condition_.get(), left_.get(), right_.get()}};
+  }
+
+  absl::optional<std::vector<std::unique_ptr<DirectExpressionStep>>>
+  ExtractDependencies() override {
+    std::vector<std::unique_ptr<DirectExpressionStep>> dependencies;
+    dependencies.reserve(3);
+    dependencies.push_back(std::move(condition_));
+    dependencies.push_back(std::move(left_));
+    dependencies.push_back(std::move(right_));
+    return dependencies;
+  }
+
  private:
   std::unique_ptr<DirectExpressionStep> condition_;
   std::unique_ptr<DirectExpressionStep> left_;
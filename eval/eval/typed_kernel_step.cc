@@ -0,0 +1,315 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eval/eval/typed_kernel_step.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "base/kind.h"
+#include "common/native_type.h"
+#include "common/value.h"
+#include "eval/eval/arithmetic_step.h"
+#include "eval/eval/attribute_trail.h"
+#include "eval/eval/direct_expression_step.h"
+#include "eval/eval/evaluator_core.h"
+#include "internal/casts.h"
+#include "internal/overflow.h"
+#include "internal/status_macros.h"
+
+namespace google::api::expr::runtime {
+
+namespace {
+
+using ::cel::BoolValue;
+using ::cel::DoubleValue;
+using ::cel::IntValue;
+using ::cel::UintValue;
+using ::cel::Value;
+
+// Reads `value` into `out` if it is of `kind`.
+bool FromValue(cel::Kind kind, const Value& value, TypedKernelScalar& out) {
+  switch (kind) {
+    case cel::Kind::kBool:
+      if (!value.Is<BoolValue>()) {
+        return false;
+      }
+      out.bool_value = value.As<BoolValue>().NativeValue();
+      return true;
+    case cel::Kind::kInt:
+      if (!value.Is<IntValue>()) {
+        return false;
+      }
+      out.int_value = value.As<IntValue>().NativeValue();
+      return true;
+    case cel::Kind::kUint:
+      if (!value.Is<UintValue>()) {
+        return false;
+      }
+      out.uint_value = value.As<UintValue>().NativeValue();
+      return true;
+    case cel::Kind::kDouble:
+      if (!value.Is<DoubleValue>()) {
+        return false;
+      }
+      out.double_value = value.As<DoubleValue>().NativeValue();
+      return true;
+    default:
+      return false;
+  }
+}
+
+Value ToValue(cel::Kind kind, const TypedKernelScalar& scalar) {
+  switch (kind) {
+    case cel::Kind::kInt:
+      return IntValue(scalar.int_value);
+    case cel::Kind::kUint:
+      return UintValue(scalar.uint_value);
+    case cel::Kind::kDouble:
+      return DoubleValue(scalar.double_value);
+    default:
+      return BoolValue(scalar.bool_value);
+  }
+}
+
+template <typename T>
+T& Get(TypedKernelScalar& scalar) {
+  if constexpr (std::is_same_v<T, int64_t>) {
+    return scalar.int_value;
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    return scalar.uint_value;
+  } else {
+    return scalar.double_value;
+  }
+}
+
+// Computes `op` for integral operands, returning false where the standard
+// function returns an error.
+template <typename T>
+bool ComputeIntegral(ArithmeticOp op, T lhs, T rhs, T& out) {
+  switch (op) {
+    case ArithmeticOp::kAdd:
+#if ABSL_HAVE_BUILTIN(__builtin_add_overflow)
+      return !__builtin_add_overflow(lhs, rhs, &out);
+#else
+      if (auto sum = cel::internal::CheckedAdd(lhs, rhs); sum.ok()) {
+        out = *sum;
+        return true;
+      }
+      return false;
+#endif
+    case ArithmeticOp::kSubtract:
+#if ABSL_HAVE_BUILTIN(__builtin_sub_overflow)
+      return !__builtin_sub_overflow(lhs, rhs, &out);
+#else
+      if (auto diff = cel::internal::CheckedSub(lhs, rhs); diff.ok()) {
+        out = *diff;
+        return true;
+      }
+      return false;
+#endif
+    case ArithmeticOp::kMultiply:
+#if ABSL_HAVE_BUILTIN(__builtin_mul_overflow)
+      return !__builtin_mul_overflow(lhs, rhs, &out);
+#else
+      if (auto prod = cel::internal::CheckedMul(lhs, rhs); prod.ok()) {
+        out = *prod;
+        return true;
+      }
+      return false;
+#endif
+    case ArithmeticOp::kDivide:
+    case ArithmeticOp::kModulo:
+      if (rhs == 0) {
+        return false;
+      }
+      if constexpr (std::is_signed_v<T>) {
+        if (lhs == std::numeric_limits<T>::min() && rhs == -1) {
+          return false;
+        }
+      }
+      out = op == ArithmeticOp::kDivide ? lhs / rhs : lhs % rhs;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Applies `op` to operands of type `T`, returning false where the standard
+// function returns an error.
+template <typename T>
+bool Apply(ArithmeticOp op, T lhs, T rhs, TypedKernelScalar& out) {
+  switch (op) {
+    case ArithmeticOp::kLess:
+      out.bool_value = lhs < rhs;
+      return true;
+    case ArithmeticOp::kLessOrEqual:
+      out.bool_value = lhs <= rhs;
+      return true;
+    case ArithmeticOp::kGreater:
+      out.bool_value = rhs < lhs;
+      return true;
+    case ArithmeticOp::kGreaterOrEqual:
+      out.bool_value = rhs <= lhs;
+      return true;
+    default:
+      break;
+  }
+  if constexpr (std::is_floating_point_v<T>) {
+    switch (op) {
+      case ArithmeticOp::kAdd:
+        out.double_value = lhs + rhs;
+        return true;
+      case ArithmeticOp::kSubtract:
+        out.double_value = lhs - rhs;
+        return true;
+      case ArithmeticOp::kMultiply:
+        out.double_value = lhs * rhs;
+        return true;
+      case ArithmeticOp::kDivide:
+        // IEEE division, division by zero results in +/- inf or NaN.
+        out.double_value = lhs / rhs;
+        return true;
+      default:
+        return false;
+    }
+  } else {
+    return ComputeIntegral<T>(op, lhs, rhs, Get<T>(out));
+  }
+}
+
+class DirectTypedKernelStep final : public DirectExpressionStep {
+ public:
+  DirectTypedKernelStep(int64_t expr_id, std::vector<TypedKernelNode> nodes,
+                        std::vector<const DirectExpressionStep*> leaves,
+                        std::unique_ptr<DirectExpressionStep> fallback)
+      : DirectExpressionStep(expr_id),
+        nodes_(std::move(nodes)),
+        leaves_(std::move(leaves)),
+        fallback_(std::move(fallback)) {}
+
+  absl::Status Evaluate(ExecutionFrameBase& frame, Value& result,
+                        AttributeTrail& trail) const override {
+    // Partial unknowns depend on the attribute trails of the leaves, which
+    // the kernel doesn't track.
+    if (!frame.unknown_processing_enabled() && !nodes_.empty()) {
+      TypedKernelScalar scalar;
+      CEL_ASSIGN_OR_RETURN(bool ok,
+                           EvaluateNode(frame, nodes_.size() - 1, scalar));
+      if (ok) {
+        result = ToValue(nodes_.back().kind, scalar);
+        trail = AttributeTrail();
+        return absl::OkStatus();
+      }
+    }
+    return fallback_->Evaluate(frame, result, trail);
+  }
+
+  cel::NativeTypeId GetNativeTypeId() const override {
+    return cel::NativeTypeId::For<DirectTypedKernelStep>();
+  }
+
+  const DirectExpressionStep* fallback() const { return fallback_.get(); }
+
+ private:
+  // Evaluates the node at `index` into `out`. Returns false if the kernel
+  // can't compute the result, in which case the fallback is evaluated.
+  absl::StatusOr<bool> EvaluateNode(ExecutionFrameBase& frame, size_t index,
+                                    TypedKernelScalar& out) const {
+    const TypedKernelNode& node = nodes_[index];
+    switch (node.type) {
+      case TypedKernelNode::Type::kLeaf: {
+        Value value;
+        AttributeTrail trail;
+        CEL_RETURN_IF_ERROR(leaves_[node.lhs]->Evaluate(frame, value, trail));
+        return FromValue(node.kind, value, out);
+      }
+      case TypedKernelNode::Type::kConstant:
+        out = node.constant;
+        return true;
+      case TypedKernelNode::Type::kAnd:
+      case TypedKernelNode::Type::kOr: {
+        CEL_ASSIGN_OR_RETURN(bool ok, EvaluateNode(frame, node.lhs, out));
+        if (!ok) {
+          return false;
+        }
+        // `false && x` and `true || x` are decided by the first operand.
+        if (out.bool_value == (node.type == TypedKernelNode::Type::kOr)) {
+          return true;
+        }
+        return EvaluateNode(frame, node.rhs, out);
+      }
+      case TypedKernelNode::Type::kArithmetic: {
+        TypedKernelScalar lhs;
+        TypedKernelScalar rhs;
+        CEL_ASSIGN_OR_RETURN(bool ok, EvaluateNode(frame, node.lhs, lhs));
+        if (!ok) {
+          return false;
+        }
+        CEL_ASSIGN_OR_RETURN(ok, EvaluateNode(frame, node.rhs, rhs));
+        if (!ok) {
+          return false;
+        }
+        switch (node.operand_kind) {
+          case cel::Kind::kInt:
+            return Apply<int64_t>(node.op, lhs.int_value, rhs.int_value, out);
+          case cel::Kind::kUint:
+            return Apply<uint64_t>(node.op, lhs.uint_value, rhs.uint_value,
+                                   out);
+          case cel::Kind::kDouble:
+            return Apply<double>(node.op, lhs.double_value, rhs.double_value,
+                                 out);
+          default:
+            return false;
+        }
+      }
+    }
+    return false;
+  }
+
+  std::vector<TypedKernelNode> nodes_;
+  // Owned by `fallback_`.
+  std::vector<const DirectExpressionStep*> leaves_;
+  std::unique_ptr<DirectExpressionStep> fallback_;
+};
+
+}  // namespace
+
+std::unique_ptr<DirectExpressionStep> CreateDirectTypedKernelStep(
+    int64_t expr_id, std::vector<TypedKernelNode> nodes,
+    std::vector<const DirectExpressionStep*> leaves,
+    std::unique_ptr<DirectExpressionStep> fallback) {
+  return std::make_unique<DirectTypedKernelStep>(
+      expr_id, std::move(nodes), std::move(leaves), std::move(fallback));
+}
+
+const DirectExpressionStep* UnwrapTypedKernelStep(
+    const DirectExpressionStep* step) {
+  if (step != nullptr && step->GetNativeTypeId() ==
+                             cel::NativeTypeId::For<DirectTypedKernelStep>()) {
+    return cel::internal::down_cast<const DirectTypedKernelStep*>(step)
+        ->fallback();
+  }
+  return step;
+}
+
+}  // namespace google::api::expr::runtime
@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EVAL_EVAL_TYPED_KERNEL_STEP_H_
+#define THIRD_PARTY_CEL_CPP_EVAL_EVAL_TYPED_KERNEL_STEP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/kind.h"
+#include "eval/eval/arithmetic_step.h"
+#include "eval/eval/direct_expression_step.h"
+
+namespace google::api::expr::runtime {
+
+// Native value of a typed kernel node, of the kind of the node.
+union TypedKernelScalar {
+  bool bool_value;
+  int64_t int_value;
+  uint64_t uint_value;
+  double double_value;
+};
+
+// Node of a typed kernel: a tree of typed arithmetic, ordering and logic
+// operations lowered from a checked subexpression and evaluated on native
+// scalars, without boxing intermediate results as values.
+struct TypedKernelNode {
+  enum class Type {
+    // Value of the subexpression evaluated by the leaf step `lhs`.
+    kLeaf,
+    // Constant stored in the node.
+    kConstant,
+    // `op` applied to the nodes `lhs` and `rhs`, both of `operand_kind`.
+    kArithmetic,
+    // Short-circuiting logical and / or of the nodes `lhs` and `rhs`.
+    kAnd,
+    kOr,
+  };
+
+  Type type;
+  // Kind of the node's result, one of kBool, kInt, kUint or kDouble.
+  cel::Kind kind;
+  ArithmeticOp op = ArithmeticOp::kAdd;
+  cel::Kind operand_kind = cel::Kind::kAny;
+  // Indices of the operand nodes, which precede this node, or of the leaf
+  // step.
+  size_t lhs = 0;
+  size_t rhs = 0;
+  TypedKernelScalar constant = {false};
+};
+
+// Create a direct step evaluating the typed kernel `nodes`, rooted at the last
+// node.
+//
+// `leaves` are steps within `fallback`, the interpreted plan of the same
+// subexpression, which the step owns. If any leaf isn't of the expected kind
+// (for example an error or unknown), an operation fails (overflow, division by
+// zero) or unknown processing is enabled, the result is that of `fallback`
+// instead, so results are unchanged.
+std::unique_ptr<DirectExpressionStep> CreateDirectTypedKernelStep(
+    int64_t expr_id, std::vector<TypedKernelNode> nodes,
+    std::vector<const DirectExpressionStep*> leaves,
+    std::unique_ptr<DirectExpressionStep> fallback);
+
+// Returns the fallback plan of `step` if it is a typed kernel step, or `step`
+// itself.
+const DirectExpressionStep* UnwrapTypedKernelStep(
+    const DirectExpressionStep* step);
+
+}  // namespace google::api::expr::runtime
+
+#endif  // THIRD_PARTY_CEL_CPP_EVAL_EVAL_TYPED_KERNEL_STEP_H_
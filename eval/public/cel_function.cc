@@ -1,8 +1,8 @@
 #include "eval/public/cel_function.h"
 
 #include <cstddef>
-#include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "base/function.h"
@@ -60,7 +60,9 @@ absl::StatusOr<Value> CelFunction::Invoke(
     absl::Span<const Value> arguments) const {
   google::protobuf::Arena* arena =
       ProtoMemoryManagerArena(context.value_factory().GetMemoryManager());
-  std::vector<CelValue> legacy_args;
+  // Arguments are converted into inline storage, so calls with few arguments
+  // don't allocate. Lists, maps and messages are viewed in place.
+  absl::InlinedVector<CelValue, 4> legacy_args;
   legacy_args.reserve(arguments.size());
 
   // Users shouldn't be able to create expressions that call registered
@@ -39,7 +39,15 @@ cel::RuntimeOptions ConvertToRuntimeOptions(const InterpreterOptions& options) {
                              options.enable_empty_wrapper_null_unboxing,
                              options.enable_lazy_bind_initialization,
                              options.max_recursion_depth,
-                             options.enable_recursive_tracing};
+                             options.enable_recursive_tracing,
+                             options.evaluator_state_pool_size,
+                             options.regex_cache_capacity,
+                             options.regex_shared_scan_min_patterns,
+                             options.comprehension_task_runner,
+                             options.parallel_comprehension_chunk_size,
+                             options.max_evaluation_bytes,
+                             options.enable_bind_hoisting,
+                             options.max_evaluation_cost};
 }
 
 }  // namespace google::api::expr::runtime
@@ -17,6 +17,8 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_PUBLIC_CEL_OPTIONS_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_PUBLIC_CEL_OPTIONS_H_
 
+#include <cstdint>
+
 #include "absl/base/attributes.h"
 #include "runtime/runtime_options.h"
 #include "google/protobuf/arena.h"
@@ -65,6 +67,9 @@ struct InterpreterOptions {
 
   // Enable list append within comprehensions. Note, this option is not safe
   // with hand-rolled ASTs.
+  //
+  // Comprehensions shaped like the map and filter macros, whose accumulator is
+  // only read to append to it, are appended to in place regardless.
   bool enable_comprehension_list_append = false;
 
   // Enable RE2 match() overload.
@@ -180,9 +185,84 @@ struct InterpreterOptions {
 
   // Enable tracing support for recursively planned programs.
   //
-  // Unlike the stack machine implementation, supporting tracing can affect
-  // performance whether or not tracing is requested for a given evaluation.
+  // A traced copy of each recursively planned program is kept and used for
+  // the evaluations which request tracing, so enabling this roughly doubles
+  // the cost of planning but not the cost of untraced evaluations.
   bool enable_recursive_tracing = false;
+
+  // Maximum number of idle evaluator states retained by each stack machine
+  // program for reuse across evaluations.
+  //
+  // Reusing states avoids allocating the value stack and comprehension slots
+  // for every evaluation. Idle states are kept until the program is destroyed.
+  //
+  // 0 disables pooling.
+  int evaluator_state_pool_size = 0;
+
+  // Capacity of the process-wide cache of compiled regular expressions used
+  // by `matches`, both for patterns precompiled at plan time and for patterns
+  // compiled during evaluation.
+  //
+  // The cache is shared by every runtime in the process and holds the largest
+  // capacity requested by any of them.
+  //
+  // 0 disables caching.
+  int regex_cache_capacity = 0;
+
+  // Minimum number of distinct constant patterns matched against the same
+  // operand, an identifier or a field selection on one, for regex
+  // precompilation to compile them into one multi-pattern RE2::Set. The
+  // operand is then scanned once per evaluation and each `matches` call
+  // answers from the set of matching patterns instead of running its own
+  // regex.
+  //
+  // Literal patterns, which are matched with string comparisons, don't count.
+  //
+  // 0 disables shared scans.
+  int regex_shared_scan_min_patterns = 0;
+
+  // Runner for splitting comprehensions evaluated as typed loops over a list
+  // of primitives (e.g. `xs.exists(x, x == 1)`) into tasks over chunks of the
+  // list, merged in order once all of them completed.
+  //
+  // Only comprehensions the planner can prove free of side effects are split,
+  // and the tasks neither allocate values nor access the activation. Results
+  // are the same as evaluating on the calling thread.
+  //
+  // Unset disables parallel evaluation.
+  cel::ParallelTaskRunner comprehension_task_runner;
+
+  // Number of elements in each task given to `comprehension_task_runner`.
+  // Ranges of at most this size are evaluated on the calling thread.
+  int parallel_comprehension_chunk_size = 16384;
+
+  // Maximum number of bytes a single evaluation may allocate through its
+  // memory manager, counting both pooled and reference counted allocations
+  // made on the evaluating thread. Evaluation fails with a resource exhausted
+  // error once the budget is crossed. The check is made as comprehensions
+  // iterate and when the evaluation completes, so the budget may be exceeded
+  // by the allocations made in between.
+  //
+  // 0 disables the limit.
+  int64_t max_evaluation_bytes = 0;
+
+  // Hoist the values of cel.bind() out of the enclosing comprehension loops
+  // when their initializers don't reference any of the loops' variables.
+  //
+  // Such a value is computed at most once for each evaluation of the
+  // outermost loop it doesn't depend on, instead of once per iteration of the
+  // innermost loop. This assumes that functions return the same result when
+  // called again with the same arguments.
+  bool enable_bind_hoisting = false;
+
+  // Maximum cost of a single evaluation, counting 1 for each function call
+  // and 1 for each comprehension iteration. Evaluation fails with a resource
+  // exhausted error once the budget is crossed. cel::EstimateCost (see
+  // runtime/cost_estimator.h) bounds the cost of an expression before it is
+  // planned.
+  //
+  // 0 disables the limit.
+  int64_t max_evaluation_cost = 0;
 };
 // LINT.ThenChange(//depot/google3/runtime/runtime_options.h)
 
@@ -1,10 +1,15 @@
 #include "eval/public/containers/container_backed_map_impl.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
-#include "absl/container/node_hash_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash.h"
+#include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/optional.h"
@@ -82,6 +87,130 @@ class CelValueEq {
   const CelValue& other_;
 };
 
+// Hashes the usual key kinds without visiting the value.
+size_t HashKey(const CelValue& key) {
+  switch (key.type()) {
+    case CelValue::Type::kBool:
+      return absl::HashOf(key.BoolOrDie());
+    case CelValue::Type::kInt64:
+      return absl::HashOf(key.Int64OrDie());
+    case CelValue::Type::kUint64:
+      return absl::HashOf(key.Uint64OrDie());
+    case CelValue::Type::kString:
+      return absl::HashOf(key.StringOrDie().value());
+    default:
+      return key.template Visit<size_t>(HasherOp());
+  }
+}
+
+bool KeysEqual(const CelValue& key1, const CelValue& key2) {
+  if (key1.type() != key2.type()) {
+    return false;
+  }
+  switch (key1.type()) {
+    case CelValue::Type::kBool:
+      return key1.BoolOrDie() == key2.BoolOrDie();
+    case CelValue::Type::kInt64:
+      return key1.Int64OrDie() == key2.Int64OrDie();
+    case CelValue::Type::kUint64:
+      return key1.Uint64OrDie() == key2.Uint64OrDie();
+    case CelValue::Type::kString:
+      return key1.StringOrDie().value() == key2.StringOrDie().value();
+    default:
+      return key1.template Visit<bool>(CelValueEq(key2));
+  }
+}
+
+// Immutable CelMap with the keys and values in contiguous arrays, indexed by
+// an open-addressed table of entry positions with linear probing.
+class FrozenCelMap final : public CelMap {
+ public:
+  // Returns an error if the keys aren't unique.
+  static absl::StatusOr<std::unique_ptr<CelMap>> Create(
+      std::vector<CelValue> keys, std::vector<CelValue> values) {
+    auto map = absl::WrapUnique(
+        new FrozenCelMap(std::move(keys), std::move(values)));
+    if (!map->BuildIndex()) {
+      return absl::InvalidArgumentError("duplicate map keys");
+    }
+    return map;
+  }
+
+  int size() const override { return keys_.size(); }
+
+  absl::optional<CelValue> operator[](CelValue cel_key) const override {
+    const size_t entry = Find(cel_key);
+    if (entry == kNotFound) {
+      return absl::nullopt;
+    }
+    return values_[entry];
+  }
+
+  absl::StatusOr<bool> Has(const CelValue& cel_key) const override {
+    return Find(cel_key) != kNotFound;
+  }
+
+  absl::StatusOr<const CelList*> ListKeys() const override {
+    return &key_list_;
+  }
+
+ private:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  class KeyList final : public CelList {
+   public:
+    explicit KeyList(absl::Span<const CelValue> keys) : keys_(keys) {}
+
+    int size() const override { return keys_.size(); }
+
+    CelValue operator[](int index) const override { return keys_[index]; }
+
+   private:
+    absl::Span<const CelValue> keys_;
+  };
+
+  FrozenCelMap(std::vector<CelValue> keys, std::vector<CelValue> values)
+      : keys_(std::move(keys)),
+        values_(std::move(values)),
+        // At most half of the slots are used, so probe sequences stay short.
+        slots_(absl::bit_ceil(2 * keys_.size() + 1), 0),
+        key_list_(keys_) {}
+
+  // Indexes every entry. Returns false if a key is repeated.
+  bool BuildIndex() {
+    const size_t mask = slots_.size() - 1;
+    for (size_t entry = 0; entry < keys_.size(); ++entry) {
+      size_t slot = HashKey(keys_[entry]) & mask;
+      for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+        if (KeysEqual(keys_[slots_[slot] - 1], keys_[entry])) {
+          return false;
+        }
+      }
+      slots_[slot] = static_cast<uint32_t>(entry + 1);
+    }
+    return true;
+  }
+
+  // Returns the position of the entry for `key`, or kNotFound.
+  size_t Find(const CelValue& key) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = HashKey(key) & mask; slots_[slot] != 0;
+         slot = (slot + 1) & mask) {
+      const size_t entry = slots_[slot] - 1;
+      if (KeysEqual(keys_[entry], key)) {
+        return entry;
+      }
+    }
+    return kNotFound;
+  }
+
+  std::vector<CelValue> keys_;
+  std::vector<CelValue> values_;
+  // Position of an entry plus one, or zero for an empty slot.
+  std::vector<uint32_t> slots_;
+  KeyList key_list_;
+};
+
 }  // namespace
 
 // Map element access operator.
@@ -103,26 +232,39 @@ absl::Status CelMapBuilder::Add(CelValue key, CelValue value) {
   return absl::OkStatus();
 }
 
+std::unique_ptr<CelMap> CelMapBuilder::Freeze() && {
+  std::vector<CelValue> keys = std::move(key_list_).Release();
+  std::vector<CelValue> values;
+  values.reserve(keys.size());
+  for (const CelValue& key : keys) {
+    values.push_back(values_map_.find(key)->second);
+  }
+  values_map_.clear();
+  // The keys are unique, the builder rejects duplicates.
+  return *FrozenCelMap::Create(std::move(keys), std::move(values));
+}
+
 // CelValue hasher functor.
 size_t CelMapBuilder::Hasher::operator()(const CelValue& key) const {
-  return key.template Visit<size_t>(HasherOp());
+  return HashKey(key);
 }
 
 bool CelMapBuilder::Equal::operator()(const CelValue& key1,
                                       const CelValue& key2) const {
-  if (key1.type() != key2.type()) {
-    return false;
-  }
-  return key1.template Visit<bool>(CelValueEq(key2));
+  return KeysEqual(key1, key2);
 }
 
 absl::StatusOr<std::unique_ptr<CelMap>> CreateContainerBackedMap(
     absl::Span<const std::pair<CelValue, CelValue>> key_values) {
-  auto map = std::make_unique<CelMapBuilder>();
+  std::vector<CelValue> keys;
+  std::vector<CelValue> values;
+  keys.reserve(key_values.size());
+  values.reserve(key_values.size());
   for (const auto& key_value : key_values) {
-    CEL_RETURN_IF_ERROR(map->Add(key_value.first, key_value.second));
+    keys.push_back(key_value.first);
+    values.push_back(key_value.second);
   }
-  return map;
+  return FrozenCelMap::Create(std::move(keys), std::move(values));
 }
 
 }  // namespace runtime
@@ -1,10 +1,12 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_PUBLIC_CONTAINERS_CONTAINER_BACKED_MAP_IMPL_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_PUBLIC_CONTAINERS_CONTAINER_BACKED_MAP_IMPL_H_
 
+#include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
-#include "absl/container/node_hash_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "eval/public/cel_value.h"
@@ -22,6 +24,12 @@ class CelMapBuilder : public CelMap {
   // already exists.
   absl::Status Add(CelValue key, CelValue value);
 
+  // Preallocates space for the given number of entries.
+  void Reserve(size_t capacity) {
+    values_map_.reserve(capacity);
+    key_list_.Reserve(capacity);
+  }
+
   int size() const override { return values_map_.size(); }
 
   absl::optional<CelValue> operator[](CelValue cel_key) const override;
@@ -34,6 +42,14 @@ class CelMapBuilder : public CelMap {
     return &key_list_;
   }
 
+  // Converts the entries added so far into an immutable map, leaving the
+  // builder empty.
+  //
+  // The frozen map keeps its keys and values in two contiguous arrays, in the
+  // order they were added, and finds them through a compact open-addressed
+  // index, so it is smaller and faster to query than the builder.
+  std::unique_ptr<CelMap> Freeze() &&;
+
  private:
   // Custom CelList implementation for maintaining key list.
   class KeyList : public CelList {
@@ -46,6 +62,10 @@ class CelMapBuilder : public CelMap {
 
     void Add(const CelValue& key) { keys_.push_back(key); }
 
+    void Reserve(size_t capacity) { keys_.reserve(capacity); }
+
+    std::vector<CelValue> Release() && { return std::move(keys_); }
+
    private:
     std::vector<CelValue> keys_;
   };
@@ -57,11 +77,14 @@ class CelMapBuilder : public CelMap {
     bool operator()(const CelValue& key1, const CelValue& key2) const;
   };
 
-  absl::node_hash_map<CelValue, CelValue, Hasher, Equal> values_map_;
+  // Entries are stored inline; references into the table are never handed
+  // out, so pointer stability is not needed.
+  absl::flat_hash_map<CelValue, CelValue, Hasher, Equal> values_map_;
   KeyList key_list_;
 };
 
-// Factory method creating container-backed CelMap.
+// Factory method creating container-backed CelMap. The map is built frozen,
+// see CelMapBuilder::Freeze.
 absl::StatusOr<std::unique_ptr<CelMap>> CreateContainerBackedMap(
     absl::Span<const std::pair<CelValue, CelValue>> key_values);
 
@@ -1,5 +1,7 @@
 #include "eval/public/containers/container_backed_map_impl.h"
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -15,6 +17,7 @@ namespace {
 using testing::Eq;
 using testing::IsNull;
 using testing::Not;
+using cel::internal::IsOkAndHolds;
 using cel::internal::StatusIs;
 
 TEST(ContainerBackedMapImplTest, TestMapInt64) {
@@ -182,6 +185,76 @@ TEST(CelMapBuilder, RepeatKeysFail) {
       StatusIs(absl::StatusCode::kInvalidArgument, "duplicate map keys"));
 }
 
+TEST(CelMapBuilder, Reserve) {
+  CelMapBuilder builder;
+  builder.Reserve(100);
+  EXPECT_EQ(builder.size(), 0);
+  for (int64_t i = 0; i < 100; ++i) {
+    ASSERT_OK(builder.Add(CelValue::CreateInt64(i), CelValue::CreateInt64(-i)));
+  }
+  EXPECT_EQ(builder.size(), 100);
+  for (int64_t i = 0; i < 100; ++i) {
+    auto lookup = builder[CelValue::CreateInt64(i)];
+    ASSERT_TRUE(lookup.has_value());
+    EXPECT_EQ(lookup->Int64OrDie(), -i);
+  }
+  ASSERT_OK_AND_ASSIGN(const CelList* keys, builder.ListKeys());
+  ASSERT_EQ(keys->size(), 100);
+  EXPECT_EQ((*keys)[42].Int64OrDie(), 42);
+}
+
+TEST(CelMapBuilder, Freeze) {
+  const std::string kKey = "key";
+  CelMapBuilder builder;
+  for (int64_t i = 0; i < 100; ++i) {
+    ASSERT_OK(builder.Add(CelValue::CreateInt64(i), CelValue::CreateInt64(-i)));
+  }
+  ASSERT_OK(builder.Add(CelValue::CreateUint64(1), CelValue::CreateBool(true)));
+  ASSERT_OK(builder.Add(CelValue::CreateString(&kKey), CelValue::CreateNull()));
+
+  std::unique_ptr<CelMap> cel_map = std::move(builder).Freeze();
+  EXPECT_EQ(builder.size(), 0);
+  ASSERT_EQ(cel_map->size(), 102);
+  for (int64_t i = 0; i < 100; ++i) {
+    auto lookup = (*cel_map)[CelValue::CreateInt64(i)];
+    ASSERT_TRUE(lookup.has_value());
+    EXPECT_EQ(lookup->Int64OrDie(), -i);
+  }
+  EXPECT_FALSE((*cel_map)[CelValue::CreateInt64(100)].has_value());
+  EXPECT_THAT(cel_map->Has(CelValue::CreateUint64(1)), IsOkAndHolds(true));
+  EXPECT_THAT(cel_map->Has(CelValue::CreateUint64(2)), IsOkAndHolds(false));
+  EXPECT_THAT(cel_map->Has(CelValue::CreateStringView("key")),
+              IsOkAndHolds(true));
+  EXPECT_THAT(cel_map->Has(CelValue::CreateBool(true)), IsOkAndHolds(false));
+
+  // Keys are listed in the order they were added.
+  ASSERT_OK_AND_ASSIGN(const CelList* keys, cel_map->ListKeys());
+  ASSERT_EQ(keys->size(), 102);
+  EXPECT_EQ((*keys)[42].Int64OrDie(), 42);
+  EXPECT_EQ((*keys)[100].Uint64OrDie(), 1);
+  EXPECT_EQ((*keys)[101].StringOrDie().value(), "key");
+}
+
+TEST(ContainerBackedMapImplTest, RepeatKeysFail) {
+  std::vector<std::pair<CelValue, CelValue>> args = {
+      {CelValue::CreateInt64(1), CelValue::CreateInt64(2)},
+      {CelValue::CreateUint64(1), CelValue::CreateInt64(3)},
+      {CelValue::CreateInt64(1), CelValue::CreateInt64(4)}};
+
+  EXPECT_THAT(CreateContainerBackedMap(args),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "duplicate map keys"));
+}
+
+TEST(ContainerBackedMapImplTest, EmptyMap) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<CelMap> cel_map,
+                       CreateContainerBackedMap({}));
+  EXPECT_EQ(cel_map->size(), 0);
+  EXPECT_FALSE((*cel_map)[CelValue::CreateInt64(1)].has_value());
+  ASSERT_OK_AND_ASSIGN(const CelList* keys, cel_map->ListKeys());
+  EXPECT_EQ(keys->size(), 0);
+}
+
 }  // namespace
 
 }  // namespace google::api::expr::runtime
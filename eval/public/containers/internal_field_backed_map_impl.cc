@@ -197,9 +197,11 @@ absl::StatusOr<bool> FieldBackedMapImpl::LookupMapValue(
     case google::protobuf::FieldDescriptor::CPPTYPE_STRING: {
       CelValue::StringHolder key_value;
       key.GetValue(&key_value);
-      auto str = key_value.value();
-      proto_key.SetStringValue(std::string(str.begin(), str.end()));
-    } break;
+      return cel::extensions::protobuf_internal::LookupMapValue(
+          *reflection_, *message_, *descriptor_,
+          cel::extensions::protobuf_internal::StringMapKey(key_value.value()),
+          value_ref);
+    }
     case google::protobuf::FieldDescriptor::CPPTYPE_UINT32: {
       uint64_t key_value;
       key.GetValue(&key_value);
@@ -245,6 +245,28 @@ TEST(FieldBackedMapImplTest, StringKeyTest) {
             false);
 }
 
+TEST(FieldBackedMapImplTest, StringKeyOfDifferentLengthsTest) {
+  TestMessage message;
+  auto field_map = message.mutable_string_int32_map();
+  (*field_map)["a"] = 1;
+  (*field_map)[std::string(64, 'a')] = 2;
+
+  google::protobuf::Arena arena;
+  auto cel_map = CreateMap(&message, "string_int32_map", &arena);
+
+  // Lookups reuse the storage of the previous key, so a short key following a
+  // long one must not match the remainder of the long key.
+  std::string long_key(64, 'a');
+  std::string short_key = "a";
+  std::string prefix_key = "aa";
+  EXPECT_EQ((*cel_map)[CelValue::CreateString(&long_key)]->Int64OrDie(), 2);
+  EXPECT_EQ((*cel_map)[CelValue::CreateString(&short_key)]->Int64OrDie(), 1);
+  EXPECT_FALSE((*cel_map)[CelValue::CreateString(&prefix_key)].has_value());
+  EXPECT_TRUE(cel_map->Has(CelValue::CreateString(&long_key)).value_or(false));
+  EXPECT_FALSE(
+      cel_map->Has(CelValue::CreateString(&prefix_key)).value_or(true));
+}
+
 TEST(FieldBackedMapImplTest, EmptySizeTest) {
   TestMessage message;
   google::protobuf::Arena arena;
@@ -120,6 +120,13 @@ std::unique_ptr<CelExpressionBuilder> CreatePortableExprBuilder(
     if (!status.ok()) {
       ABSL_LOG(ERROR) << "Failed to register @cel.hasField: " << status;
     }
+    status = builder->GetRegistry()->RegisterLazyFunction(
+        CelFunctionDescriptor(cel::extensions::kFieldsHasChain, false,
+                              {cel::Kind::kAny, cel::Kind::kList,
+                               cel::Kind::kList}));
+    if (!status.ok()) {
+      ABSL_LOG(ERROR) << "Failed to register @cel.hasFieldChain: " << status;
+    }
     // Add runtime implementation.
     flat_expr_builder.AddProgramOptimizer(
         CreateSelectOptimizationProgramOptimizer());
@@ -27,12 +27,12 @@
 
 #include "google/protobuf/wrappers.pb.h"
 #include "google/protobuf/message.h"
+#include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
-#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "eval/public/cel_value.h"
 #include "eval/public/structs/legacy_any_packing.h"
@@ -111,10 +111,8 @@ WellKnownType GetWellKnownType(absl::string_view type_name) {
            {"google.protobuf.StringValue", kStringValue},
            {"google.protobuf.BytesValue", kBytesValue},
            {"google.protobuf.Any", kAny}});
-  if (!well_known_types_map->contains(type_name)) {
-    return kUnknown;
-  }
-  return well_known_types_map->at(type_name);
+  auto it = well_known_types_map->find(type_name);
+  return it == well_known_types_map->end() ? kUnknown : it->second;
 }
 
 // IsJSONSafe indicates whether the int is safely representable as a floating
@@ -182,7 +180,7 @@ class DynamicMap : public CelMap {
   class DynamicMapKeyList : public CelList {
    public:
     explicit DynamicMapKeyList(const Struct* values)
-        : values_(values), keys_(), initialized_(false) {}
+        : values_(values), keys_() {}
 
     // Index access
     CelValue operator[](int index) const override {
@@ -198,19 +196,17 @@ class DynamicMap : public CelMap {
 
    private:
     void CheckInit() const {
-      absl::MutexLock lock(&mutex_);
-      if (!initialized_) {
+      absl::call_once(init_once_, [this]() {
+        keys_.reserve(values_->fields_size());
         for (const auto& it : values_->fields()) {
           keys_.push_back(CelValue::CreateString(&it.first));
         }
-        initialized_ = true;
-      }
+      });
     }
 
     const Struct* values_;
-    mutable absl::Mutex mutex_;
+    mutable absl::once_flag init_once_;
     mutable std::vector<CelValue> keys_;
-    mutable bool initialized_;
   };
 
   Arena* arena_;
@@ -252,7 +248,7 @@ CelValue CreateCelValue(const Any& any_value,
     return CreateErrorValue(arena, "Malformed type_url string");
   }
 
-  std::string full_name = std::string(type_url.substr(pos + 1));
+  absl::string_view full_name = absl::string_view(type_url).substr(pos + 1);
   WellKnownType type = GetWellKnownType(full_name);
   switch (type) {
     case kDoubleValue: {
@@ -399,21 +395,22 @@ CelValue CreateCelValue(const Any& any_value,
           type_provider->ProvideLegacyAnyPackingApis(full_name);
       if (!any_apis.has_value()) {
         return CreateErrorValue(
-            arena, "Failed to get AnyPackingApis for " + full_name);
+            arena,
+            absl::StrCat("Failed to get AnyPackingApis for ", full_name));
       }
       std::optional<const LegacyTypeInfoApis*> type_info =
           type_provider->ProvideLegacyTypeInfo(full_name);
       if (!type_info.has_value()) {
-        return CreateErrorValue(arena,
-                                "Failed to get TypeInfo for " + full_name);
+        return CreateErrorValue(
+            arena, absl::StrCat("Failed to get TypeInfo for ", full_name));
       }
       absl::StatusOr<google::protobuf::MessageLite*> nested_message =
           (*any_apis)->Unpack(any_value, arena);
       if (!nested_message.ok()) {
         // Failed to unpack.
         // TODO(issues/25) What error code?
-        return CreateErrorValue(arena,
-                                "Failed to unpack Any into " + full_name);
+        return CreateErrorValue(
+            arena, absl::StrCat("Failed to unpack Any into ", full_name));
       }
       return CelValue::CreateMessageWrapper(
           CelValue::MessageWrapper(*nested_message, *type_info));
@@ -846,16 +843,13 @@ absl::StatusOr<ListValue*> CreateMessageFromValue(
   if (wrapper == nullptr) {
     wrapper = google::protobuf::Arena::Create<ListValue>(arena);
   }
+  wrapper->mutable_values()->Reserve(wrapper->values_size() + list.size());
   for (int i = 0; i < list.size(); i++) {
     auto element = list.Get(arena, i);
-    Value* element_value = nullptr;
-    CEL_ASSIGN_OR_RETURN(
-        element_value,
-        CreateMessageFromValue(element, element_value, type_provider, arena));
-    if (element_value == nullptr) {
-      return absl::InternalError("Couldn't create value for a list element.");
-    }
-    wrapper->add_values()->Swap(element_value);
+    // Written in place, rather than into a separate message swapped in after.
+    CEL_RETURN_IF_ERROR(CreateMessageFromValue(element, wrapper->add_values(),
+                                               type_provider, arena)
+                            .status());
   }
   return wrapper;
 }
@@ -878,20 +872,15 @@ absl::StatusOr<Struct*> CreateMessageFromValue(
     if (!k.IsString()) {
       return absl::InternalError("map key is expected to have String type.");
     }
-    std::string key(k.StringOrDie().value());
-
     auto v = map.Get(arena, k);
     if (!v.has_value()) {
       return absl::InternalError("map value is expected to have value.");
     }
-    Value* field_value = nullptr;
-    CEL_ASSIGN_OR_RETURN(
-        field_value,
-        CreateMessageFromValue(v.value(), field_value, type_provider, arena));
-    if (field_value == nullptr) {
-      return absl::InternalError("Couldn't create value for a field element.");
-    }
-    (*fields)[key].Swap(field_value);
+    Value& field_value = (*fields)[std::string(k.StringOrDie().value())];
+    field_value.Clear();
+    CEL_RETURN_IF_ERROR(
+        CreateMessageFromValue(v.value(), &field_value, type_provider, arena)
+            .status());
   }
   return wrapper;
 }
@@ -977,18 +966,18 @@ absl::StatusOr<Value*> CreateMessageFromValue(
       }
     } break;
     case CelValue::Type::kList: {
-      ListValue* list_wrapper = nullptr;
-      CEL_ASSIGN_OR_RETURN(list_wrapper,
-                           CreateMessageFromValue(cel_value, list_wrapper,
-                                                  type_provider, arena));
-      wrapper->mutable_list_value()->Swap(list_wrapper);
+      ListValue* list_wrapper = wrapper->mutable_list_value();
+      list_wrapper->Clear();
+      CEL_RETURN_IF_ERROR(
+          CreateMessageFromValue(cel_value, list_wrapper, type_provider, arena)
+              .status());
     } break;
     case CelValue::Type::kMap: {
-      Struct* struct_wrapper = nullptr;
-      CEL_ASSIGN_OR_RETURN(struct_wrapper,
-                           CreateMessageFromValue(cel_value, struct_wrapper,
-                                                  type_provider, arena));
-      wrapper->mutable_struct_value()->Swap(struct_wrapper);
+      Struct* struct_wrapper = wrapper->mutable_struct_value();
+      struct_wrapper->Clear();
+      CEL_RETURN_IF_ERROR(CreateMessageFromValue(cel_value, struct_wrapper,
+                                                 type_provider, arena)
+                              .status());
     } break;
     case CelValue::Type::kNullType:
       wrapper->set_null_value(google::protobuf::NULL_VALUE);
@@ -1063,6 +1063,52 @@ TEST_F(CelProtoWrapperTest, WrapStruct) {
   ExpectWrappedMessage(cel_value, any);
 }
 
+TEST_F(CelProtoWrapperTest, WrapNestedStructAndList) {
+  const std::string kField1 = "field1";
+  const std::string kField2 = "field2";
+  const std::string kElement = "element";
+  std::vector<std::pair<CelValue, CelValue>> inner_args = {
+      {CelValue::CreateString(CelValue::StringHolder(&kField2)),
+       CelValue::CreateString(CelValue::StringHolder(&kElement))}};
+  auto inner_map = CreateContainerBackedMap(
+                       absl::Span<std::pair<CelValue, CelValue>>(
+                           inner_args.data(), inner_args.size()))
+                       .value();
+  std::vector<CelValue> list_elems = {CelValue::CreateDouble(1.5),
+                                      CelValue::CreateMap(inner_map.get())};
+  ContainerBackedListImpl list(std::move(list_elems));
+  std::vector<std::pair<CelValue, CelValue>> args = {
+      {CelValue::CreateString(CelValue::StringHolder(&kField1)),
+       CelValue::CreateList(&list)}};
+  auto cel_map =
+      CreateContainerBackedMap(
+          absl::Span<std::pair<CelValue, CelValue>>(args.data(), args.size()))
+          .value();
+  auto cel_value = CelValue::CreateMap(cel_map.get());
+
+  Value json;
+  auto* json_list =
+      (*json.mutable_struct_value()->mutable_fields())[kField1]
+          .mutable_list_value();
+  json_list->add_values()->set_number_value(1.5);
+  (*json_list->add_values()->mutable_struct_value()->mutable_fields())[kField2]
+      .set_string_value(kElement);
+  ExpectWrappedMessage(cel_value, json);
+  ExpectWrappedMessage(cel_value, json.struct_value());
+
+  // The previous contents of the destination are replaced.
+  Value stale;
+  stale.mutable_struct_value()->mutable_fields()->insert({kField2, Value()});
+  (*stale.mutable_struct_value()->mutable_fields())[kField1]
+      .mutable_list_value()
+      ->add_values()
+      ->set_bool_value(true);
+  Value* result = &stale;
+  ASSERT_OK(CreateMessageFromValue(cel_value, result, type_provider(), arena())
+                .status());
+  EXPECT_THAT(stale, EqualsProto(json));
+}
+
 TEST_F(CelProtoWrapperTest, WrapAnyMessage) {
   TestMessage test;
   test.set_string_value("test");
@@ -14,14 +14,16 @@
 
 #include "eval/public/structs/proto_message_type_adapter.h"
 
+#include <atomic>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "google/protobuf/util/message_differencer.h"
 #include "absl/base/no_destructor.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -44,6 +46,7 @@
 #include "extensions/protobuf/internal/qualify.h"
 #include "extensions/protobuf/memory_manager.h"
 #include "internal/casts.h"
+#include "internal/proto_equality.h"
 #include "internal/status_macros.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
@@ -88,12 +91,8 @@ inline absl::StatusOr<google::protobuf::Message*> UnwrapMessage(
 }
 
 bool ProtoEquals(const google::protobuf::Message& m1, const google::protobuf::Message& m2) {
-  // Equality behavior is undefined for message differencer if input messages
-  // have different descriptors. For CEL just return false.
-  if (m1.GetDescriptor() != m2.GetDescriptor()) {
-    return false;
-  }
-  return google::protobuf::util::MessageDifferencer::Equals(m1, m2);
+  // Messages of different types aren't equal.
+  return cel::internal::ProtoMessageEquals(m1, m2);
 }
 
 // Implements CEL's notion of field presence for protobuf.
@@ -440,8 +439,245 @@ CelValue MessageCelValueFactory(const google::protobuf::Message* message) {
       MessageWrapper(message, &DucktypedMessageAdapter::GetSingleton()));
 }
 
+// Specialized field readers used by ProtoFieldAccessTable. Each one is
+// equivalent to CreateCelValueFromField for a particular field type and label.
+
+absl::StatusOr<CelValue> GetBoolField(const Message* message,
+                                      const FieldDescriptor* field,
+                                      ProtoWrapperTypeOptions, google::protobuf::Arena*) {
+  return CelValue::CreateBool(
+      message->GetReflection()->GetBool(*message, field));
+}
+
+absl::StatusOr<CelValue> GetInt32Field(const Message* message,
+                                       const FieldDescriptor* field,
+                                       ProtoWrapperTypeOptions, google::protobuf::Arena*) {
+  return CelValue::CreateInt64(
+      message->GetReflection()->GetInt32(*message, field));
+}
+
+absl::StatusOr<CelValue> GetInt64Field(const Message* message,
+                                       const FieldDescriptor* field,
+                                       ProtoWrapperTypeOptions, google::protobuf::Arena*) {
+  return CelValue::CreateInt64(
+      message->GetReflection()->GetInt64(*message, field));
+}
+
+absl::StatusOr<CelValue> GetUInt32Field(const Message* message,
+                                        const FieldDescriptor* field,
+                                        ProtoWrapperTypeOptions,
+                                        google::protobuf::Arena*) {
+  return CelValue::CreateUint64(
+      message->GetReflection()->GetUInt32(*message, field));
+}
+
+absl::StatusOr<CelValue> GetUInt64Field(const Message* message,
+                                        const FieldDescriptor* field,
+                                        ProtoWrapperTypeOptions,
+                                        google::protobuf::Arena*) {
+  return CelValue::CreateUint64(
+      message->GetReflection()->GetUInt64(*message, field));
+}
+
+absl::StatusOr<CelValue> GetFloatField(const Message* message,
+                                       const FieldDescriptor* field,
+                                       ProtoWrapperTypeOptions, google::protobuf::Arena*) {
+  return CelValue::CreateDouble(
+      message->GetReflection()->GetFloat(*message, field));
+}
+
+absl::StatusOr<CelValue> GetDoubleField(const Message* message,
+                                        const FieldDescriptor* field,
+                                        ProtoWrapperTypeOptions,
+                                        google::protobuf::Arena*) {
+  return CelValue::CreateDouble(
+      message->GetReflection()->GetDouble(*message, field));
+}
+
+absl::StatusOr<CelValue> GetEnumField(const Message* message,
+                                      const FieldDescriptor* field,
+                                      ProtoWrapperTypeOptions, google::protobuf::Arena*) {
+  return CelValue::CreateInt64(
+      message->GetReflection()->GetEnumValue(*message, field));
+}
+
+const std::string* GetStringReference(const Message* message,
+                                      const FieldDescriptor* field,
+                                      google::protobuf::Arena* arena) {
+  std::string buffer;
+  const std::string* value =
+      &message->GetReflection()->GetStringReference(*message, field, &buffer);
+  if (value == &buffer) {
+    value = google::protobuf::Arena::Create<std::string>(arena, std::move(buffer));
+  }
+  return value;
+}
+
+absl::StatusOr<CelValue> GetStringField(const Message* message,
+                                        const FieldDescriptor* field,
+                                        ProtoWrapperTypeOptions,
+                                        google::protobuf::Arena* arena) {
+  return CelValue::CreateString(GetStringReference(message, field, arena));
+}
+
+absl::StatusOr<CelValue> GetBytesField(const Message* message,
+                                       const FieldDescriptor* field,
+                                       ProtoWrapperTypeOptions,
+                                       google::protobuf::Arena* arena) {
+  return CelValue::CreateBytes(GetStringReference(message, field, arena));
+}
+
+absl::StatusOr<CelValue> GetMessageField(const Message* message,
+                                         const FieldDescriptor* field,
+                                         ProtoWrapperTypeOptions,
+                                         google::protobuf::Arena* arena) {
+  return internal::UnwrapMessageToValue(
+      &message->GetReflection()->GetMessage(*message, field),
+      &MessageCelValueFactory, arena);
+}
+
+absl::StatusOr<CelValue> GetWrapperField(
+    const Message* message, const FieldDescriptor* field,
+    ProtoWrapperTypeOptions unboxing_option, google::protobuf::Arena* arena) {
+  const Reflection* reflection = message->GetReflection();
+  // Unset wrapper types have special semantics. If set, return the unwrapped
+  // value, else return 'null'.
+  if (unboxing_option == ProtoWrapperTypeOptions::kUnsetNull &&
+      !reflection->HasField(*message, field)) {
+    return internal::UnwrapMessageToValue(nullptr, &MessageCelValueFactory,
+                                          arena);
+  }
+  return internal::UnwrapMessageToValue(
+      &reflection->GetMessage(*message, field), &MessageCelValueFactory, arena);
+}
+
+absl::StatusOr<CelValue> GetRepeatedField(const Message* message,
+                                          const FieldDescriptor* field,
+                                          ProtoWrapperTypeOptions,
+                                          google::protobuf::Arena* arena) {
+  return CelValue::CreateList(
+      google::protobuf::Arena::Create<internal::FieldBackedListImpl>(
+          arena, message, field, &MessageCelValueFactory, arena));
+}
+
+absl::StatusOr<CelValue> GetMapField(const Message* message,
+                                     const FieldDescriptor* field,
+                                     ProtoWrapperTypeOptions,
+                                     google::protobuf::Arena* arena) {
+  return CelValue::CreateMap(
+      google::protobuf::Arena::Create<internal::FieldBackedMapImpl>(
+          arena, message, field, &MessageCelValueFactory, arena));
+}
+
+bool HasSingularField(const Message* message, const FieldDescriptor* field) {
+  return message->GetReflection()->HasField(*message, field);
+}
+
+// Lists and maps are considered present when non-empty.
+bool HasRepeatedField(const Message* message, const FieldDescriptor* field) {
+  return message->GetReflection()->FieldSize(*message, field) != 0;
+}
+
+bool IsWrapperMessage(const google::protobuf::Descriptor* descriptor) {
+  switch (descriptor->well_known_type()) {
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_BOOLVALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_BYTESVALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_DOUBLEVALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_FLOATVALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_INT32VALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_INT64VALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_STRINGVALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_UINT32VALUE:
+    case google::protobuf::Descriptor::WELLKNOWNTYPE_UINT64VALUE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+using FieldGetter = absl::StatusOr<CelValue> (*)(const Message*,
+                                                 const FieldDescriptor*,
+                                                 ProtoWrapperTypeOptions,
+                                                 google::protobuf::Arena*);
+
+FieldGetter SelectFieldGetter(const FieldDescriptor* field) {
+  if (field->is_map()) {
+    return &GetMapField;
+  }
+  if (field->is_repeated()) {
+    return &GetRepeatedField;
+  }
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return &GetBoolField;
+    case FieldDescriptor::CPPTYPE_INT32:
+      return &GetInt32Field;
+    case FieldDescriptor::CPPTYPE_INT64:
+      return &GetInt64Field;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return &GetUInt32Field;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return &GetUInt64Field;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return &GetFloatField;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return &GetDoubleField;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return &GetEnumField;
+    case FieldDescriptor::CPPTYPE_STRING:
+      return field->type() == FieldDescriptor::TYPE_BYTES ? &GetBytesField
+                                                          : &GetStringField;
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return IsWrapperMessage(field->message_type()) ? &GetWrapperField
+                                                     : &GetMessageField;
+    default:
+      // Not expected, defer to the generic path for its error handling.
+      return nullptr;
+  }
+}
+
 }  // namespace
 
+// Field accessors for a single message type, keyed by field name.
+class ProtoFieldAccessTable {
+ public:
+  struct Entry {
+    const FieldDescriptor* field;
+    FieldGetter get;
+    bool (*has)(const Message*, const FieldDescriptor*);
+  };
+
+  explicit ProtoFieldAccessTable(const google::protobuf::Descriptor* descriptor) {
+    entries_.reserve(descriptor->field_count());
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      const FieldDescriptor* field = descriptor->field(i);
+      FieldGetter get = SelectFieldGetter(field);
+      if (get == nullptr) {
+        continue;
+      }
+      auto* has =
+          field->is_repeated() ? &HasRepeatedField : &HasSingularField;
+      entries_.insert({field->name(), Entry{field, get, has}});
+    }
+  }
+
+  // Returns the entry for the named field or nullptr if there is none, e.g. for
+  // extensions.
+  const Entry* Find(absl::string_view field_name) const {
+    auto it = entries_.find(field_name);
+    return it != entries_.end() ? &it->second : nullptr;
+  }
+
+ private:
+  // Keys reference the names owned by the field descriptors.
+  absl::flat_hash_map<absl::string_view, Entry> entries_;
+};
+
+std::shared_ptr<const ProtoFieldAccessTable> CreateProtoFieldAccessTable(
+    const google::protobuf::Descriptor* descriptor) {
+  return std::make_shared<const ProtoFieldAccessTable>(descriptor);
+}
+
 std::string ProtoMessageTypeAdapter::DebugString(
     const MessageWrapper& wrapped_message) const {
   if (!wrapped_message.HasFullProto() ||
@@ -507,7 +743,7 @@ ProtoMessageTypeAdapter::NewInstance(
 
   // This implementation requires arena-backed memory manager.
   google::protobuf::Arena* arena = ProtoMemoryManagerArena(memory_manager);
-  const Message* prototype = message_factory_->GetPrototype(descriptor_);
+  const Message* prototype = GetPrototype();
 
   Message* msg = (prototype != nullptr) ? prototype->New(arena) : nullptr;
 
@@ -518,6 +754,17 @@ ProtoMessageTypeAdapter::NewInstance(
   return MessageWrapper::Builder(msg);
 }
 
+const google::protobuf::Message* ProtoMessageTypeAdapter::GetPrototype() const {
+  const Message* prototype = prototype_.load(std::memory_order_acquire);
+  if (prototype == nullptr) {
+    // The factory returns the same prototype each time, so racing lookups
+    // store the same pointer.
+    prototype = message_factory_->GetPrototype(descriptor_);
+    prototype_.store(prototype, std::memory_order_release);
+  }
+  return prototype;
+}
+
 bool ProtoMessageTypeAdapter::DefinesField(absl::string_view field_name) const {
   return descriptor_->FindFieldByName(field_name) != nullptr;
 }
@@ -526,6 +773,12 @@ absl::StatusOr<bool> ProtoMessageTypeAdapter::HasField(
     absl::string_view field_name, const CelValue::MessageWrapper& value) const {
   CEL_ASSIGN_OR_RETURN(const google::protobuf::Message* message,
                        UnwrapMessage(value, "HasField"));
+  if (field_access_table_ != nullptr) {
+    if (const auto* entry = field_access_table_->Find(field_name);
+        entry != nullptr) {
+      return entry->has(message, entry->field);
+    }
+  }
   return HasFieldImpl(message, descriptor_, field_name);
 }
 
@@ -536,6 +789,13 @@ absl::StatusOr<CelValue> ProtoMessageTypeAdapter::GetField(
   CEL_ASSIGN_OR_RETURN(const google::protobuf::Message* message,
                        UnwrapMessage(instance, "GetField"));
 
+  if (field_access_table_ != nullptr) {
+    if (const auto* entry = field_access_table_->Find(field_name);
+        entry != nullptr) {
+      return entry->get(message, entry->field, unboxing_option,
+                        ProtoMemoryManagerArena(memory_manager));
+    }
+  }
   return GetFieldImpl(message, descriptor_, field_name, unboxing_option,
                       memory_manager);
 }
@@ -15,7 +15,10 @@
 #ifndef THIRD_PARTY_CEL_CPP_EVAL_PUBLIC_STRUCTS_PROTO_MESSAGE_TYPE_ADAPTER_H_
 #define THIRD_PARTY_CEL_CPP_EVAL_PUBLIC_STRUCTS_PROTO_MESSAGE_TYPE_ADAPTER_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.h"
@@ -31,6 +34,18 @@
 
 namespace google::api::expr::runtime {
 
+// Precomputed field accessors for a message type.
+class ProtoFieldAccessTable;
+
+// Creates the field accessor table for `descriptor`.
+//
+// Each field gets an accessor specialized for its type and label, so adapters
+// using the table can read fields without the name lookup and type dispatch
+// of the generic reflection path. Building the table costs a pass over the
+// fields, so it's intended for adapters that are cached and reused.
+std::shared_ptr<const ProtoFieldAccessTable> CreateProtoFieldAccessTable(
+    const google::protobuf::Descriptor* descriptor);
+
 // Implementation for legacy struct (message) type apis using reflection.
 //
 // Note: The type info API implementation attached to message values is
@@ -44,6 +59,16 @@ class ProtoMessageTypeAdapter : public LegacyTypeInfoApis,
                           google::protobuf::MessageFactory* message_factory)
       : message_factory_(message_factory), descriptor_(descriptor) {}
 
+  // `field_access_table` must have been created for `descriptor`. It is used
+  // by `HasField` and `GetField`.
+  ProtoMessageTypeAdapter(
+      const google::protobuf::Descriptor* descriptor,
+      google::protobuf::MessageFactory* message_factory,
+      std::shared_ptr<const ProtoFieldAccessTable> field_access_table)
+      : message_factory_(message_factory),
+        descriptor_(descriptor),
+        field_access_table_(std::move(field_access_table)) {}
+
   ~ProtoMessageTypeAdapter() override = default;
 
   // Implement LegacyTypeInfoApis
@@ -111,8 +136,14 @@ class ProtoMessageTypeAdapter : public LegacyTypeInfoApis,
                         const CelValue& value, google::protobuf::Arena* arena,
                         google::protobuf::Message* message) const;
 
+  // Returns the prototype of `descriptor_` from `message_factory_`, looking it
+  // up on first use.
+  const google::protobuf::Message* GetPrototype() const;
+
   google::protobuf::MessageFactory* message_factory_;
   const google::protobuf::Descriptor* descriptor_;
+  std::shared_ptr<const ProtoFieldAccessTable> field_access_table_;
+  mutable std::atomic<const google::protobuf::Message*> prototype_{nullptr};
 };
 
 // Returns a TypeInfo provider representing an arbitrary message.
@@ -57,29 +57,43 @@ using cel::internal::StatusIs;
 
 using LegacyQualifyResult = LegacyTypeAccessApis::LegacyQualifyResult;
 
-class ProtoMessageTypeAccessorTest : public testing::TestWithParam<bool> {
+enum class AccessorKind {
+  kGeneric,
+  kTypeSpecific,
+  kFieldAccessTable,
+};
+
+class ProtoMessageTypeAccessorTest
+    : public testing::TestWithParam<AccessorKind> {
  public:
   ProtoMessageTypeAccessorTest()
       : type_specific_instance_(
             google::protobuf::DescriptorPool::generated_pool()->FindMessageTypeByName(
                 "google.api.expr.runtime.TestMessage"),
-            google::protobuf::MessageFactory::generated_factory()) {}
+            google::protobuf::MessageFactory::generated_factory()),
+        field_access_table_instance_(
+            TestMessage::descriptor(),
+            google::protobuf::MessageFactory::generated_factory(),
+            CreateProtoFieldAccessTable(TestMessage::descriptor())) {}
 
   const LegacyTypeAccessApis& GetAccessApis() {
-    bool use_generic_instance = GetParam();
-    if (use_generic_instance) {
-      // implementation detail: in general, type info implementations may
-      // return a different accessor object based on the messsage instance, but
-      // this implemenation returns the same one no matter the message.
-      return *GetGenericProtoTypeInfoInstance().GetAccessApis(dummy_);
-
-    } else {
-      return type_specific_instance_;
+    switch (GetParam()) {
+      case AccessorKind::kGeneric:
+        // implementation detail: in general, type info implementations may
+        // return a different accessor object based on the messsage instance,
+        // but this implemenation returns the same one no matter the message.
+        return *GetGenericProtoTypeInfoInstance().GetAccessApis(dummy_);
+      case AccessorKind::kTypeSpecific:
+        return type_specific_instance_;
+      case AccessorKind::kFieldAccessTable:
+        break;
     }
+    return field_access_table_instance_;
   }
 
  private:
   ProtoMessageTypeAdapter type_specific_instance_;
+  ProtoMessageTypeAdapter field_access_table_instance_;
   CelValue::MessageWrapper dummy_;
 };
 
@@ -367,8 +381,50 @@ TEST_P(ProtoMessageTypeAccessorTest, IsEqualToNonMessageInequal) {
   EXPECT_FALSE(accessor.IsEqualTo(value2, value));
 }
 
+TEST_P(ProtoMessageTypeAccessorTest, GetFieldScalarTypes) {
+  google::protobuf::Arena arena;
+  const LegacyTypeAccessApis& accessor = GetAccessApis();
+
+  auto manager = ProtoMemoryManagerRef(&arena);
+
+  TestMessage example;
+  example.set_int32_value(1);
+  example.set_uint32_value(2);
+  example.set_uint64_value(3);
+  example.set_float_value(1.5);
+  example.set_double_value(2.5);
+  example.set_string_value("foo");
+  example.set_cord_value("bar");
+  example.set_bytes_value("baz");
+  example.set_bool_value(true);
+  example.set_enum_value(TestMessage::TEST_ENUM_2);
+  example.mutable_message_value()->set_int64_value(10);
+
+  MessageWrapper value(&example, nullptr);
+
+  auto get_field = [&](absl::string_view field) {
+    return accessor.GetField(field, value, ProtoWrapperTypeOptions::kUnsetNull,
+                             manager);
+  };
+  EXPECT_THAT(get_field("int32_value"), IsOkAndHolds(test::IsCelInt64(1)));
+  EXPECT_THAT(get_field("uint32_value"), IsOkAndHolds(test::IsCelUint64(2)));
+  EXPECT_THAT(get_field("uint64_value"), IsOkAndHolds(test::IsCelUint64(3)));
+  EXPECT_THAT(get_field("float_value"), IsOkAndHolds(test::IsCelDouble(1.5)));
+  EXPECT_THAT(get_field("double_value"), IsOkAndHolds(test::IsCelDouble(2.5)));
+  EXPECT_THAT(get_field("string_value"),
+              IsOkAndHolds(test::IsCelString("foo")));
+  EXPECT_THAT(get_field("cord_value"), IsOkAndHolds(test::IsCelString("bar")));
+  EXPECT_THAT(get_field("bytes_value"), IsOkAndHolds(test::IsCelBytes("baz")));
+  EXPECT_THAT(get_field("bool_value"), IsOkAndHolds(test::IsCelBool(true)));
+  EXPECT_THAT(get_field("enum_value"), IsOkAndHolds(test::IsCelInt64(2)));
+  EXPECT_THAT(get_field("message_value"),
+              IsOkAndHolds(test::IsCelMessage(EqualsProto("int64_value: 10"))));
+}
+
 INSTANTIATE_TEST_SUITE_P(GenericAndSpecific, ProtoMessageTypeAccessorTest,
-                         testing::Bool());
+                         testing::Values(AccessorKind::kGeneric,
+                                         AccessorKind::kTypeSpecific,
+                                         AccessorKind::kFieldAccessTable));
 
 TEST(GetGenericProtoTypeInfoInstance, GetTypeName) {
   const LegacyTypeInfoApis& info_api = GetGenericProtoTypeInfoInstance();
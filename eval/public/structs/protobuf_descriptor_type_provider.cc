@@ -51,20 +51,25 @@ ProtobufDescriptorProvider::CreateTypeAdapter(absl::string_view name) const {
     return nullptr;
   }
 
-  return std::make_unique<ProtoMessageTypeAdapter>(descriptor,
-                                                   message_factory_);
+  return std::make_unique<ProtoMessageTypeAdapter>(
+      descriptor, message_factory_, CreateProtoFieldAccessTable(descriptor));
 }
 
 const ProtoMessageTypeAdapter* ProtobufDescriptorProvider::GetTypeAdapter(
     absl::string_view name) const {
+  {
+    // Types are looked up whenever a message is created, so lookups of types
+    // which are already cached only take a reader lock.
+    absl::ReaderMutexLock lock(&mu_);
+    if (auto it = type_cache_.find(name); it != type_cache_.end()) {
+      return it->second.get();
+    }
+  }
   absl::MutexLock lock(&mu_);
-  auto it = type_cache_.find(name);
-  if (it != type_cache_.end()) {
-    return it->second.get();
+  auto [it, inserted] = type_cache_.try_emplace(name);
+  if (inserted) {
+    it->second = CreateTypeAdapter(name);
   }
-  auto type_provider = CreateTypeAdapter(name);
-  const ProtoMessageTypeAdapter* result = type_provider.get();
-  type_cache_[name] = std::move(type_provider);
-  return result;
+  return it->second.get();
 }
 }  // namespace google::api::expr::runtime
@@ -15,6 +15,8 @@
 #include "eval/public/structs/protobuf_descriptor_type_provider.h"
 
 #include <optional>
+#include <thread>
+#include <vector>
 
 #include "google/protobuf/wrappers.pb.h"
 #include "eval/public/cel_value.h"
@@ -89,5 +91,34 @@ TEST(ProtobufDescriptorProvider, NotFound) {
   ASSERT_FALSE(type_info.has_value());
 }
 
+TEST(ProtobufDescriptorProvider, ConcurrentNewInstance) {
+  ProtobufDescriptorProvider provider(
+      google::protobuf::DescriptorPool::generated_pool(),
+      google::protobuf::MessageFactory::generated_factory());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&provider]() {
+      auto manager = ProtoMemoryManager();
+      for (int i = 0; i < 100; ++i) {
+        auto type_adapter =
+            provider.ProvideLegacyType("google.protobuf.Int64Value");
+        ASSERT_TRUE(type_adapter.has_value());
+        ASSERT_OK_AND_ASSIGN(
+            CelValue::MessageWrapper::Builder value,
+            type_adapter->mutation_apis()->NewInstance(manager));
+        ASSERT_OK(type_adapter->mutation_apis()->SetField(
+            "value", CelValue::CreateInt64(i), manager, value));
+        ASSERT_OK_AND_ASSIGN(CelValue adapted,
+                             type_adapter->mutation_apis()
+                                 ->AdaptFromWellKnownType(manager, value));
+        EXPECT_THAT(adapted, test::IsCelInt64(i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 }  // namespace
 }  // namespace google::api::expr::runtime
@@ -86,6 +86,32 @@ TEST(UnknownAttributeSetTest, TestMergeSets) {
   EXPECT_THAT(attrs1, testing::UnorderedPointwise(Eq(), attrs2));
 }
 
+TEST(UnknownAttributeSetTest, TestMergeSharesSubsets) {
+  const std::string kAttr1 = "a1";
+
+  CelAttribute cel_attr1(
+      "root", std::vector<CelAttributeQualifier>({CreateCelAttributeQualifier(
+                  CelValue::CreateString(&kAttr1))}));
+  CelAttribute cel_attr2(
+      "root", std::vector<CelAttributeQualifier>(
+                  {CreateCelAttributeQualifier(CelValue::CreateInt64(2))}));
+
+  UnknownAttributeSet unknown_set1({cel_attr2, cel_attr1, cel_attr2});
+  UnknownAttributeSet unknown_set2({cel_attr1});
+  EXPECT_THAT(unknown_set1.size(), Eq(2));
+
+  UnknownAttributeSet merged =
+      UnknownAttributeSet::Merge(unknown_set1, unknown_set2);
+  EXPECT_EQ(merged, unknown_set1);
+  EXPECT_EQ(&*merged.begin(), &*unknown_set1.begin());
+
+  merged = UnknownAttributeSet::Merge(unknown_set2, unknown_set1);
+  EXPECT_EQ(&*merged.begin(), &*unknown_set1.begin());
+
+  merged = UnknownAttributeSet::Merge(UnknownAttributeSet(), unknown_set2);
+  EXPECT_EQ(&*merged.begin(), &*unknown_set2.begin());
+}
+
 }  // namespace
 
 }  // namespace runtime
@@ -42,6 +42,8 @@ namespace {
 using ::google::api::expr::v1alpha1::Expr;
 using ::google::api::expr::v1alpha1::ParsedExpr;
 using ::google::api::expr::v1alpha1::SourceInfo;
+using ::cel::internal::AllocationCounters;
+using ::cel::internal::CountingArenaOptions;
 using ::google::rpc::context::AttributeContext;
 
 InterpreterOptions GetOptions(google::protobuf::Arena& arena) {
@@ -63,7 +65,7 @@ InterpreterOptions GetOptions(google::protobuf::Arena& arena) {
 // Evaluates cel expression:
 // '1 + 1 + 1 .... +1'
 static void BM_Eval(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   InterpreterOptions options = GetOptions(arena);
 
   auto builder = CreateCelExpressionBuilder(options);
@@ -87,8 +89,9 @@ static void BM_Eval(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&root_expr, &source_info));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
-    google::protobuf::Arena arena;
+    google::protobuf::Arena arena(CountingArenaOptions());
     Activation activation;
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -108,7 +111,7 @@ absl::Status EmptyCallback(int64_t expr_id, const CelValue& value,
 // Traces cel expression with an empty callback:
 // '1 + 1 + 1 .... +1'
 static void BM_Eval_Trace(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   InterpreterOptions options = GetOptions(arena);
   options.enable_recursive_tracing = true;
 
@@ -133,8 +136,9 @@ static void BM_Eval_Trace(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&root_expr, &source_info));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
-    google::protobuf::Arena arena;
+    google::protobuf::Arena arena(CountingArenaOptions());
     Activation activation;
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Trace(activation, &arena, EmptyCallback));
@@ -151,7 +155,7 @@ BENCHMARK(BM_Eval_Trace)->Range(1, 10000);
 // Evaluates cel expression:
 // '"a" + "a" + "a" .... + "a"'
 static void BM_EvalString(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   InterpreterOptions options = GetOptions(arena);
 
   auto builder = CreateCelExpressionBuilder(options);
@@ -175,8 +179,9 @@ static void BM_EvalString(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&root_expr, &source_info));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
-    google::protobuf::Arena arena;
+    google::protobuf::Arena arena(CountingArenaOptions());
     Activation activation;
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -193,7 +198,7 @@ BENCHMARK(BM_EvalString)->Range(1, 10000);
 // Traces cel expression with an empty callback:
 // '"a" + "a" + "a" .... + "a"'
 static void BM_EvalString_Trace(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   InterpreterOptions options = GetOptions(arena);
   options.enable_recursive_tracing = true;
 
@@ -218,8 +223,9 @@ static void BM_EvalString_Trace(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&root_expr, &source_info));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
-    google::protobuf::Arena arena;
+    google::protobuf::Arena arena(CountingArenaOptions());
     Activation activation;
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Trace(activation, &arena, EmptyCallback));
@@ -271,6 +277,7 @@ void BM_PolicyNative(benchmark::State& state) {
       absl::flat_hash_set<std::string>{"10.0.1.1", "10.0.1.2", "10.0.1.3"};
   auto attributes = absl::btree_map<std::string, std::string>{
       {"ip", kIP}, {"token", kToken}, {"path", kPath}};
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     auto result = NativeCheck(attributes, denylists, allowlists);
     ASSERT_TRUE(result);
@@ -280,7 +287,7 @@ void BM_PolicyNative(benchmark::State& state) {
 BENCHMARK(BM_PolicyNative);
 
 void BM_PolicySymbolic(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
    !(ip in ["10.0.1.4", "10.0.1.5", "10.0.1.6"]) &&
    ((path.startsWith("v1") && token in ["v1", "v2", "admin"]) ||
@@ -306,6 +313,7 @@ void BM_PolicySymbolic(benchmark::State& state) {
   activation.InsertValue("path", CelValue::CreateStringView(kPath));
   activation.InsertValue("token", CelValue::CreateStringView(kToken));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -339,7 +347,7 @@ class RequestMap : public CelMap {
 
 // Uses a lazily constructed map container for "ip", "path", and "token".
 void BM_PolicySymbolicMap(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
    !(request.ip in ["10.0.1.4", "10.0.1.5", "10.0.1.6"]) &&
    ((request.path.startsWith("v1") && request.token in ["v1", "v2", "admin"]) ||
@@ -361,6 +369,7 @@ void BM_PolicySymbolicMap(benchmark::State& state) {
   RequestMap request;
   activation.InsertValue("request", CelValue::CreateMap(&request));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -372,7 +381,7 @@ BENCHMARK(BM_PolicySymbolicMap);
 
 // Uses a protobuf container for "ip", "path", and "token".
 void BM_PolicySymbolicProto(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
    !(request.ip in ["10.0.1.4", "10.0.1.5", "10.0.1.6"]) &&
    ((request.path.startsWith("v1") && request.token in ["v1", "v2", "admin"]) ||
@@ -397,6 +406,7 @@ void BM_PolicySymbolicProto(benchmark::State& state) {
   request.set_token(kToken);
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -457,7 +467,7 @@ comprehension_expr: <
 >)";
 
 void BM_Comprehension(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Expr expr;
   Activation activation;
   ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kListSum, &expr));
@@ -479,6 +489,7 @@ void BM_Comprehension(benchmark::State& state) {
 
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&expr, nullptr));
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -490,7 +501,7 @@ void BM_Comprehension(benchmark::State& state) {
 BENCHMARK(BM_Comprehension)->Range(1, 1 << 20);
 
 void BM_Comprehension_Trace(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Expr expr;
   Activation activation;
   ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kListSum, &expr));
@@ -513,6 +524,7 @@ void BM_Comprehension_Trace(benchmark::State& state) {
 
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&expr, nullptr));
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Trace(activation, &arena, EmptyCallback));
@@ -524,7 +536,7 @@ void BM_Comprehension_Trace(benchmark::State& state) {
 BENCHMARK(BM_Comprehension_Trace)->Range(1, 1 << 20);
 
 void BM_HasMap(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
                        parser::Parse("has(request.path) && !has(request.ip)"));
@@ -543,6 +555,7 @@ void BM_HasMap(benchmark::State& state) {
           map_pairs.data(), map_pairs.size()));
   activation.InsertValue("request", CelValue::CreateMap((*cel_map).get()));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -554,7 +567,7 @@ void BM_HasMap(benchmark::State& state) {
 BENCHMARK(BM_HasMap);
 
 void BM_HasProto(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
                        parser::Parse("has(request.path) && !has(request.ip)"));
@@ -571,6 +584,7 @@ void BM_HasProto(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -582,7 +596,7 @@ void BM_HasProto(benchmark::State& state) {
 BENCHMARK(BM_HasProto);
 
 void BM_HasProtoMap(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
                        parser::Parse("has(request.headers.create_time) && "
@@ -599,6 +613,7 @@ void BM_HasProtoMap(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -610,7 +625,7 @@ void BM_HasProtoMap(benchmark::State& state) {
 BENCHMARK(BM_HasProtoMap);
 
 void BM_ReadProtoMap(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
      request.headers.create_time == "2021-01-01"
@@ -627,6 +642,7 @@ void BM_ReadProtoMap(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -638,7 +654,7 @@ void BM_ReadProtoMap(benchmark::State& state) {
 BENCHMARK(BM_ReadProtoMap);
 
 void BM_NestedProtoFieldRead(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
       !request.a.b.c.d.e
@@ -655,6 +671,7 @@ void BM_NestedProtoFieldRead(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -666,7 +683,7 @@ void BM_NestedProtoFieldRead(benchmark::State& state) {
 BENCHMARK(BM_NestedProtoFieldRead);
 
 void BM_NestedProtoFieldReadDefaults(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
       !request.a.b.c.d.e
@@ -682,6 +699,7 @@ void BM_NestedProtoFieldReadDefaults(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -693,7 +711,7 @@ void BM_NestedProtoFieldReadDefaults(benchmark::State& state) {
 BENCHMARK(BM_NestedProtoFieldReadDefaults);
 
 void BM_ProtoStructAccess(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
       has(request.auth.claims.iss) && request.auth.claims.iss == 'accounts.google.com'
@@ -712,6 +730,7 @@ void BM_ProtoStructAccess(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -723,7 +742,7 @@ void BM_ProtoStructAccess(benchmark::State& state) {
 BENCHMARK(BM_ProtoStructAccess);
 
 void BM_ProtoListAccess(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, parser::Parse(R"cel(
       "//.../accessLevels/MY_LEVEL_4" in request.auth.access_levels
@@ -745,6 +764,7 @@ void BM_ProtoListAccess(benchmark::State& state) {
   activation.InsertValue("request",
                          CelProtoWrapper::CreateMessage(&request, &arena));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -850,7 +870,7 @@ comprehension_expr: <
 >)";
 
 void BM_NestedComprehension(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Expr expr;
   Activation activation;
   ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kNestedListSum, &expr));
@@ -872,6 +892,7 @@ void BM_NestedComprehension(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&expr, nullptr));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -883,7 +904,7 @@ void BM_NestedComprehension(benchmark::State& state) {
 BENCHMARK(BM_NestedComprehension)->Range(1, 1 << 10);
 
 void BM_NestedComprehension_Trace(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Expr expr;
   Activation activation;
   ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kNestedListSum, &expr));
@@ -907,6 +928,7 @@ void BM_NestedComprehension_Trace(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(auto cel_expr,
                        builder->CreateExpression(&expr, nullptr));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Trace(activation, &arena, EmptyCallback));
@@ -918,7 +940,7 @@ void BM_NestedComprehension_Trace(benchmark::State& state) {
 BENCHMARK(BM_NestedComprehension_Trace)->Range(1, 1 << 10);
 
 void BM_ListComprehension(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
                        parser::Parse("list_var.map(x, x * 2)"));
@@ -940,6 +962,7 @@ void BM_ListComprehension(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(
       auto cel_expr, builder->CreateExpression(&(parsed_expr.expr()), nullptr));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -951,7 +974,7 @@ void BM_ListComprehension(benchmark::State& state) {
 BENCHMARK(BM_ListComprehension)->Range(1, 1 << 16);
 
 void BM_ListComprehension_Trace(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
                        parser::Parse("list_var.map(x, x * 2)"));
@@ -975,6 +998,7 @@ void BM_ListComprehension_Trace(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(
       auto cel_expr, builder->CreateExpression(&(parsed_expr.expr()), nullptr));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Trace(activation, &arena, EmptyCallback));
@@ -986,7 +1010,7 @@ void BM_ListComprehension_Trace(benchmark::State& state) {
 BENCHMARK(BM_ListComprehension_Trace)->Range(1, 1 << 16);
 
 void BM_ListComprehension_Opt(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
   ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
                        parser::Parse("list_var.map(x, x * 2)"));
@@ -1010,6 +1034,7 @@ void BM_ListComprehension_Opt(benchmark::State& state) {
   ASSERT_OK_AND_ASSIGN(
       auto cel_expr, builder->CreateExpression(&(parsed_expr.expr()), nullptr));
 
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     ASSERT_OK_AND_ASSIGN(CelValue result,
                          cel_expr->Evaluate(activation, &arena));
@@ -1021,7 +1046,7 @@ void BM_ListComprehension_Opt(benchmark::State& state) {
 BENCHMARK(BM_ListComprehension_Opt)->Range(1, 1 << 16);
 
 void BM_ComprehensionCpp(benchmark::State& state) {
-  google::protobuf::Arena arena;
+  google::protobuf::Arena arena(CountingArenaOptions());
   Activation activation;
 
   int len = state.range(0);
@@ -1038,6 +1063,7 @@ void BM_ComprehensionCpp(benchmark::State& state) {
     }
     return sum;
   };
+  AllocationCounters allocation_counters(state);
   for (auto _ : state) {
     int result = op();
     ASSERT_EQ(result, len);
@@ -0,0 +1,249 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Scaling benchmarks for programs and runtimes shared between threads.
+//
+// Each benchmark runs with 1 to 64 threads and reports `per_thread/s`, the
+// throughput of a single thread. It stays flat as threads are added unless
+// the threads contend on shared state, such as the registries and caches of
+// the runtime, the parser or the reference counts of shared values.
+//
+// BM_SharedConstant compares evaluating a program whose constant list is
+// shared by every thread against a list owned by each thread. With reference
+// counting, the former increments the count of the shared list on every
+// evaluation, so a gap which widens with the thread count measures the cost of
+// the cache line bouncing between cores.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/base/no_destructor.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/benchmark.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/constant_folding.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+#include "google/protobuf/arena.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::ProtobufRuntimeAdapter;
+using ::cel::extensions::ProtoMemoryManagerRef;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+constexpr absl::string_view kPolicy = R"cel(
+    !(ip in ["10.0.1.4", "10.0.1.5", "10.0.1.6"]) &&
+    ((path.startsWith("v1") && token in ["v1", "v2", "admin"]) ||
+     (path.startsWith("v2") && token in ["v2", "admin"]) ||
+     (path.startsWith("/admin") && token == "admin" &&
+      ip in ["10.0.1.1",  "10.0.1.2", "10.0.1.3"])))cel";
+
+constexpr int kListSize = 64;
+
+enum class MemoryManagement : int {
+  kPooling = 0,
+  kReferenceCounting = 1,
+};
+
+enum class ListOwnership : int {
+  kSharedConstant = 0,
+  kPerThread = 1,
+};
+
+// Programs shared by every benchmark thread.
+struct SharedPrograms {
+  ParsedExpr policy_expr;
+  std::unique_ptr<const Runtime> runtime;
+  std::unique_ptr<Program> policy;
+  // `[0, 1, ...].exists(x, x == y)`, folded into a shared constant list.
+  std::unique_ptr<Program> constant_list;
+  // `xs.exists(x, x == y)`, with `xs` bound by each thread.
+  std::unique_ptr<Program> bound_list;
+};
+
+absl::StatusOr<std::unique_ptr<Program>> CreateProgram(
+    const Runtime& runtime, absl::string_view expression) {
+  CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+  return ProtobufRuntimeAdapter::CreateProgram(runtime, expr);
+}
+
+absl::StatusOr<SharedPrograms> CreateSharedPrograms() {
+  SharedPrograms shared;
+  CEL_ASSIGN_OR_RETURN(shared.policy_expr, Parse(kPolicy));
+
+  CEL_ASSIGN_OR_RETURN(auto builder,
+                       CreateStandardRuntimeBuilder(RuntimeOptions()));
+  // Folded constants are reference counted, so that evaluations from every
+  // thread share them.
+  CEL_RETURN_IF_ERROR(extensions::EnableConstantFolding(
+      builder, MemoryManagerRef::ReferenceCounting()));
+  CEL_ASSIGN_OR_RETURN(shared.runtime, std::move(builder).Build());
+
+  CEL_ASSIGN_OR_RETURN(shared.policy,
+                       ProtobufRuntimeAdapter::CreateProgram(
+                           *shared.runtime, shared.policy_expr));
+  std::vector<int> elements(kListSize);
+  for (int i = 0; i < kListSize; ++i) {
+    elements[i] = i;
+  }
+  CEL_ASSIGN_OR_RETURN(
+      shared.constant_list,
+      CreateProgram(*shared.runtime,
+                    absl::StrCat("[", absl::StrJoin(elements, ", "),
+                                 "].exists(x, x == y)")));
+  CEL_ASSIGN_OR_RETURN(shared.bound_list,
+                       CreateProgram(*shared.runtime, "xs.exists(x, x == y)"));
+  return shared;
+}
+
+const SharedPrograms& GetSharedPrograms() {
+  static const absl::NoDestructor<SharedPrograms> shared([] {
+    auto shared = CreateSharedPrograms();
+    ABSL_CHECK_OK(shared.status());  // Crash OK
+    return std::move(*shared);
+  }());
+  return *shared;
+}
+
+void ReportPerThreadThroughput(benchmark::State& state) {
+  state.counters["per_thread/s"] =
+      benchmark::Counter(static_cast<double>(state.iterations()),
+                         benchmark::Counter::kIsRate |
+                             benchmark::Counter::kAvgThreads);
+}
+
+void BindPolicyRequest(Activation& activation) {
+  activation.InsertOrAssignValue("ip", StringValue("10.0.1.2"));
+  activation.InsertOrAssignValue("path", StringValue("/admin/users"));
+  activation.InsertOrAssignValue("token", StringValue("admin"));
+}
+
+// Evaluates the policy program shared by all threads, each with its own
+// activation and memory manager.
+void BM_SharedProgramEvaluate(benchmark::State& state) {
+  const SharedPrograms& shared = GetSharedPrograms();
+  const auto memory_management = static_cast<MemoryManagement>(state.range(0));
+
+  Activation activation;
+  BindPolicyRequest(activation);
+
+  if (memory_management == MemoryManagement::kReferenceCounting) {
+    ManagedValueFactory value_factory(shared.policy->GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    for (auto _ : state) {
+      ASSERT_OK_AND_ASSIGN(Value result, shared.policy->Evaluate(
+                                             activation, value_factory.get()));
+      ASSERT_TRUE(result.Is<BoolValue>());
+    }
+  } else {
+    for (auto _ : state) {
+      google::protobuf::Arena arena;
+      ManagedValueFactory value_factory(shared.policy->GetTypeProvider(),
+                                        ProtoMemoryManagerRef(&arena));
+      ASSERT_OK_AND_ASSIGN(Value result, shared.policy->Evaluate(
+                                             activation, value_factory.get()));
+      ASSERT_TRUE(result.Is<BoolValue>());
+    }
+  }
+  ReportPerThreadThroughput(state);
+}
+
+BENCHMARK(BM_SharedProgramEvaluate)
+    ->Arg(static_cast<int>(MemoryManagement::kPooling))
+    ->Arg(static_cast<int>(MemoryManagement::kReferenceCounting))
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+void BM_SharedConstant(benchmark::State& state) {
+  const SharedPrograms& shared = GetSharedPrograms();
+  const auto ownership = static_cast<ListOwnership>(state.range(0));
+
+  ManagedValueFactory value_factory(shared.bound_list->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  Activation activation;
+  activation.InsertOrAssignValue("y", IntValue(kListSize - 1));
+  const Program* program = shared.constant_list.get();
+  if (ownership == ListOwnership::kPerThread) {
+    ASSERT_OK_AND_ASSIGN(auto builder,
+                         value_factory.get().NewListValueBuilder(
+                             value_factory.get().GetDynListType()));
+    for (int i = 0; i < kListSize; ++i) {
+      ASSERT_OK(builder->Add(IntValue(i)));
+    }
+    activation.InsertOrAssignValue("xs", std::move(*builder).Build());
+    program = shared.bound_list.get();
+  }
+
+  for (auto _ : state) {
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         program->Evaluate(activation, value_factory.get()));
+    ASSERT_TRUE(result.Is<BoolValue>() &&
+                result.As<BoolValue>().NativeValue());
+  }
+  ReportPerThreadThroughput(state);
+}
+
+BENCHMARK(BM_SharedConstant)
+    ->Arg(static_cast<int>(ListOwnership::kSharedConstant))
+    ->Arg(static_cast<int>(ListOwnership::kPerThread))
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Plans the policy concurrently against the shared runtime, exercising its
+// function registry and type caches.
+void BM_SharedRuntimeCreateProgram(benchmark::State& state) {
+  const SharedPrograms& shared = GetSharedPrograms();
+  for (auto _ : state) {
+    ASSERT_OK_AND_ASSIGN(auto program,
+                         ProtobufRuntimeAdapter::CreateProgram(
+                             *shared.runtime, shared.policy_expr));
+    benchmark::DoNotOptimize(program);
+  }
+  ReportPerThreadThroughput(state);
+}
+
+BENCHMARK(BM_SharedRuntimeCreateProgram)->ThreadRange(1, 64)->UseRealTime();
+
+// Parses the policy concurrently, exercising any global parser state.
+void BM_ConcurrentParse(benchmark::State& state) {
+  for (auto _ : state) {
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse(kPolicy));
+    benchmark::DoNotOptimize(expr);
+  }
+  ReportPerThreadThroughput(state);
+}
+
+BENCHMARK(BM_ConcurrentParse)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,167 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Cold start benchmarks for the modern runtime: the cost of building a
+// configured runtime, with and without the extensions, before the first
+// program is planned.
+//
+// CreateStandardRuntimeBuilder shares the standard definitions returned by
+// GetStandardFunctionRegistry between runtimes. BM_RegisterStandardFunctions
+// measures registering them into each runtime instead.
+
+#include <memory>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/bindings_ext.h"
+#include "extensions/encoders.h"
+#include "extensions/math_ext.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "extensions/protobuf/type_reflector.h"
+#include "extensions/sets_functions.h"
+#include "extensions/strings.h"
+#include "internal/benchmark.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/macro_registry.h"
+#include "parser/options.h"
+#include "parser/parser.h"
+#include "parser/standard_macros.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/optional_types.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_builder_factory.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_functions.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::ProtobufRuntimeAdapter;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+// Registers every runtime extension. The bindings extension only contributes
+// macros, so it is accounted for by the parser setup in
+// BM_CreateStandardEnvironmentWithExtensions.
+absl::Status RegisterAllExtensions(RuntimeBuilder& builder,
+                                   const RuntimeOptions& options) {
+  CEL_RETURN_IF_ERROR(extensions::RegisterStringsFunctions(
+      builder.function_registry(), options));
+  CEL_RETURN_IF_ERROR(extensions::RegisterMathExtensionFunctions(
+      builder.function_registry(), options));
+  CEL_RETURN_IF_ERROR(extensions::RegisterSetsFunctions(
+      builder.function_registry(), options));
+  CEL_RETURN_IF_ERROR(extensions::RegisterEncodersFunctions(
+      builder.function_registry(), options));
+  CEL_RETURN_IF_ERROR(extensions::EnableOptionalTypes(builder));
+  builder.type_registry().AddTypeProvider(
+      std::make_unique<extensions::ProtoTypeReflector>());
+  return absl::OkStatus();
+}
+
+// Builds a runtime sharing the frozen standard definitions.
+void BM_CreateStandardRuntime(benchmark::State& state) {
+  RuntimeOptions options;
+  for (auto _ : state) {
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    benchmark::DoNotOptimize(runtime);
+  }
+}
+
+BENCHMARK(BM_CreateStandardRuntime);
+
+// Builds a runtime registering its own copy of the standard definitions.
+void BM_RegisterStandardFunctions(benchmark::State& state) {
+  RuntimeOptions options;
+  for (auto _ : state) {
+    RuntimeBuilder builder = CreateRuntimeBuilder(options);
+    ASSERT_OK(RegisterStandardFunctions(builder.function_registry(), options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    benchmark::DoNotOptimize(runtime);
+  }
+}
+
+BENCHMARK(BM_RegisterStandardFunctions);
+
+void BM_CreateStandardRuntimeWithExtensions(benchmark::State& state) {
+  RuntimeOptions options;
+  for (auto _ : state) {
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK(RegisterAllExtensions(builder, options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    benchmark::DoNotOptimize(runtime);
+  }
+}
+
+BENCHMARK(BM_CreateStandardRuntimeWithExtensions);
+
+// Sets up both halves of an environment with every extension: the macros
+// of the parser, including the bindings, and the runtime.
+void BM_CreateStandardEnvironmentWithExtensions(benchmark::State& state) {
+  RuntimeOptions options;
+  ParserOptions parser_options;
+  for (auto _ : state) {
+    MacroRegistry macros;
+    ASSERT_OK(RegisterStandardMacros(macros, parser_options));
+    ASSERT_OK(extensions::RegisterBindingsMacros(macros, parser_options));
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK(RegisterAllExtensions(builder, options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    benchmark::DoNotOptimize(macros);
+    benchmark::DoNotOptimize(runtime);
+  }
+}
+
+BENCHMARK(BM_CreateStandardEnvironmentWithExtensions);
+
+// Time to the first result: builds a runtime, then plans and evaluates a
+// small program against it.
+void BM_FirstEvaluation(benchmark::State& state) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                       Parse("'hello'.startsWith(greeting) && size(xs) > 2"));
+  Activation activation;
+  activation.InsertOrAssignValue("greeting", StringValue("he"));
+  for (auto _ : state) {
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(auto program,
+                         ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    ASSERT_OK_AND_ASSIGN(auto list_builder,
+                         value_factory.get().NewListValueBuilder(
+                             value_factory.get().GetDynListType()));
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_OK(list_builder->Add(IntValue(i)));
+    }
+    activation.InsertOrAssignValue("xs", std::move(*list_builder).Build());
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         program->Evaluate(activation, value_factory.get()));
+    ASSERT_TRUE(result.Is<BoolValue>() && result.As<BoolValue>().NativeValue());
+  }
+}
+
+BENCHMARK(BM_FirstEvaluation);
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,250 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// End-to-end benchmarks over generated policies shaped like common workloads:
+// role based access control, request validation and request routing.
+//
+// Each benchmark parses and plans a policy with the given number of rules
+// (from roughly 10 to 10k expression nodes), then evaluates it against a
+// generated activation. Besides the evaluation time measured by the
+// benchmark library, it reports:
+//
+//   build_us:     time to parse and plan the policy.
+//   p50_ns, p90_ns, p99_ns: evaluation latency percentiles.
+//   bytes/eval:   bytes allocated through the memory manager per evaluation.
+//   peak_rss_kb:  peak resident set size of the process so far.
+//
+// Every policy is run with both the stack machine and the recursive planner.
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "common/memory.h"
+#include "eval/public/activation.h"
+#include "eval/public/builtin_func_registrar.h"
+#include "eval/public/cel_expr_builder_factory.h"
+#include "eval/public/cel_expression.h"
+#include "eval/public/cel_options.h"
+#include "eval/public/cel_value.h"
+#include "eval/public/containers/container_backed_map_impl.h"
+#include "internal/benchmark.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "google/protobuf/arena.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace google::api::expr::runtime {
+namespace {
+
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using ::google::api::expr::parser::Parse;
+
+enum class Planner : int {
+  kStackMachine = 0,
+  kRecursive = 1,
+};
+
+// A generated policy and the activation it is evaluated against.
+struct Workload {
+  std::string expression;
+  // Backing storage for the string values bound in `activation`.
+  std::deque<std::string> strings;
+  std::unique_ptr<CelMap> map;
+  Activation activation;
+};
+
+void BindString(Workload& workload, absl::string_view name,
+                std::string value) {
+  workload.strings.push_back(std::move(value));
+  workload.activation.InsertValue(
+      name, CelValue::CreateStringView(workload.strings.back()));
+}
+
+// `role` is granted `action` on resources under its project:
+//
+//   (role == "role_0" && resource.startsWith("/projects/p_0/") &&
+//    action in ["get", "list", "update"]) || ...
+void MakeRbacWorkload(int rules, Workload& workload) {
+  std::vector<std::string> terms;
+  terms.reserve(rules);
+  for (int i = 0; i < rules; ++i) {
+    terms.push_back(absl::StrCat("(role == \"role_", i,
+                                 "\" && resource.startsWith(\"/projects/p_", i,
+                                 "/\") && action in [\"get\", \"list\", "
+                                 "\"update\"])"));
+  }
+  workload.expression = absl::StrJoin(terms, " || ");
+  BindString(workload, "role", absl::StrCat("role_", rules - 1));
+  BindString(workload, "resource",
+             absl::StrCat("/projects/p_", rules - 1, "/objects/o_1"));
+  BindString(workload, "action", "list");
+}
+
+// Every field of `request` is within bounds:
+//
+//   size(request) == N && request["f_0"] >= 0 && request["f_0"] < 1000 && ...
+void MakeValidationWorkload(int rules, Workload& workload) {
+  auto request = std::make_unique<CelMapBuilder>();
+  request->Reserve(rules);
+  std::vector<std::string> terms;
+  terms.reserve(rules + 1);
+  terms.push_back(absl::StrCat("size(request) == ", rules));
+  for (int i = 0; i < rules; ++i) {
+    terms.push_back(absl::StrCat("request[\"f_", i, "\"] >= 0 && request[\"f_",
+                                 i, "\"] < 1000"));
+    workload.strings.push_back(absl::StrCat("f_", i));
+    ASSERT_OK(request->Add(CelValue::CreateStringView(workload.strings.back()),
+                           CelValue::CreateInt64(i % 1000)));
+  }
+  workload.expression = absl::StrJoin(terms, " && ");
+  workload.activation.InsertValue("request",
+                                  CelValue::CreateMap(request.get()));
+  workload.map = std::move(request);
+}
+
+// Selects the backends of the routes matching the request:
+//
+//   [{"host": "h_0", "prefix": "/svc_0/", "backend": "b_0"}, ...]
+//       .filter(r, host == r.host && path.startsWith(r.prefix))
+//       .map(r, r.backend)
+void MakeRoutingWorkload(int rules, Workload& workload) {
+  std::vector<std::string> routes;
+  routes.reserve(rules);
+  for (int i = 0; i < rules; ++i) {
+    routes.push_back(absl::StrCat("{\"host\": \"h_", i % 16,
+                                  "\", \"prefix\": \"/svc_", i,
+                                  "/\", \"backend\": \"b_", i, "\"}"));
+  }
+  workload.expression =
+      absl::StrCat("[", absl::StrJoin(routes, ", "),
+                   "].filter(r, host == r.host && path.startsWith(r.prefix))"
+                   ".map(r, r.backend)");
+  BindString(workload, "host", absl::StrCat("h_", (rules / 2) % 16));
+  BindString(workload, "path", absl::StrCat("/svc_", rules / 2, "/v1/items"));
+}
+
+int64_t PeakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+#endif
+  return 0;
+}
+
+int64_t Percentile(const std::vector<int64_t>& sorted, double percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto index = static_cast<size_t>(percentile * (sorted.size() - 1));
+  return sorted[index];
+}
+
+int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void RunWorkload(benchmark::State& state,
+                 void (*make_workload)(int, Workload&)) {
+  const int rules = static_cast<int>(state.range(0));
+  const auto planner = static_cast<Planner>(state.range(1));
+
+  Workload workload;
+  make_workload(rules, workload);
+
+  InterpreterOptions options;
+  if (planner == Planner::kRecursive) {
+    options.max_recursion_depth = -1;
+  }
+  auto builder = CreateCelExpressionBuilder(options);
+  ASSERT_OK(RegisterBuiltinFunctions(builder->GetRegistry(), options));
+
+  int64_t build_start = NowNanos();
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, Parse(workload.expression));
+  ASSERT_OK_AND_ASSIGN(auto expression,
+                       builder->CreateExpression(&parsed_expr.expr(),
+                                                 &parsed_expr.source_info()));
+  int64_t build_nanos = NowNanos() - build_start;
+
+  std::vector<int64_t> latencies;
+  uint64_t bytes_allocated = 0;
+  for (auto _ : state) {
+    google::protobuf::Arena arena;
+    cel::MemoryAccountingScope accounting;
+    int64_t start = NowNanos();
+    auto result = expression->Evaluate(workload.activation, &arena);
+    latencies.push_back(NowNanos() - start);
+    bytes_allocated += accounting.bytes_allocated();
+    ASSERT_OK(result);
+    ASSERT_FALSE(result->IsError()) << result->DebugString();
+    benchmark::DoNotOptimize(*result);
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["build_us"] = static_cast<double>(build_nanos) / 1000;
+  state.counters["p50_ns"] = static_cast<double>(Percentile(latencies, 0.5));
+  state.counters["p90_ns"] = static_cast<double>(Percentile(latencies, 0.9));
+  state.counters["p99_ns"] = static_cast<double>(Percentile(latencies, 0.99));
+  state.counters["bytes/eval"] = benchmark::Counter(
+      static_cast<double>(bytes_allocated), benchmark::Counter::kAvgIterations);
+  state.counters["peak_rss_kb"] = static_cast<double>(PeakRssKb());
+}
+
+void BM_RbacPolicy(benchmark::State& state) {
+  RunWorkload(state, &MakeRbacWorkload);
+}
+
+void BM_ValidationPolicy(benchmark::State& state) {
+  RunWorkload(state, &MakeValidationWorkload);
+}
+
+void BM_RoutingPolicy(benchmark::State& state) {
+  RunWorkload(state, &MakeRoutingWorkload);
+}
+
+void WorkloadArgs(benchmark::internal::Benchmark* bench) {
+  for (Planner planner : {Planner::kStackMachine, Planner::kRecursive}) {
+    for (int rules : {1, 10, 100, 1000}) {
+      bench->ArgPair(rules, static_cast<int>(planner));
+    }
+  }
+}
+
+BENCHMARK(BM_RbacPolicy)->Apply(WorkloadArgs);
+BENCHMARK(BM_ValidationPolicy)->Apply(WorkloadArgs);
+BENCHMARK(BM_RoutingPolicy)->Apply(WorkloadArgs);
+
+}  // namespace
+}  // namespace google::api::expr::runtime
@@ -14,6 +14,7 @@
 
 #include "extensions/bindings_ext.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -743,5 +744,88 @@ INSTANTIATE_TEST_SUITE_P(BindingsExtInteractionsTest,
                          BindingsExtInteractionsTest,
                          /*enable_select_optimization=*/testing::Bool());
 
+struct BindHoistingTestCase {
+  std::string expr;
+  bool expected_result;
+  int expected_calls;
+};
+
+class BindHoistingTest
+    : public testing::TestWithParam<std::tuple<BindHoistingTestCase, bool>> {
+ protected:
+  const BindHoistingTestCase& GetTestCase() { return std::get<0>(GetParam()); }
+  bool GetEnableRecursivePlan() { return std::get<1>(GetParam()); }
+};
+
+TEST_P(BindHoistingTest, EvaluatesInvariantBindsOncePerOuterIteration) {
+  const BindHoistingTestCase& test_case = GetTestCase();
+  std::vector<Macro> all_macros = Macro::AllMacros();
+  std::vector<Macro> bindings_macros = cel::extensions::bindings_macros();
+  all_macros.insert(all_macros.end(), bindings_macros.begin(),
+                    bindings_macros.end());
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr,
+                       ParseWithMacros(test_case.expr, all_macros, "<input>"));
+
+  InterpreterOptions options;
+  options.enable_bind_hoisting = true;
+  options.max_recursion_depth = GetEnableRecursivePlan() ? -1 : 0;
+  std::unique_ptr<CelExpressionBuilder> builder =
+      CreateCelExpressionBuilder(options);
+  ASSERT_OK(RegisterBuiltinFunctions(builder->GetRegistry()));
+  int calls = 0;
+  ASSERT_OK((FunctionAdapter<int64_t, int64_t>::CreateAndRegister(
+      "twice", false,
+      [&calls](Arena*, int64_t value) -> int64_t {
+        ++calls;
+        return value * 2;
+      },
+      builder->GetRegistry())));
+
+  ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                       builder->CreateExpression(&parsed_expr.expr(),
+                                                 &parsed_expr.source_info()));
+  Arena arena;
+  Activation activation;
+  ASSERT_OK_AND_ASSIGN(CelValue out, cel_expr->Evaluate(activation, &arena));
+  ASSERT_TRUE(out.IsBool()) << out.DebugString();
+  EXPECT_EQ(out.BoolOrDie(), test_case.expected_result);
+  EXPECT_EQ(calls, test_case.expected_calls);
+
+  // The hoisted slots are cleared between evaluations.
+  calls = 0;
+  ASSERT_OK_AND_ASSIGN(out, cel_expr->Evaluate(activation, &arena));
+  ASSERT_TRUE(out.IsBool()) << out.DebugString();
+  EXPECT_EQ(out.BoolOrDie(), test_case.expected_result);
+  EXPECT_EQ(calls, test_case.expected_calls);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BindHoistingTest, BindHoistingTest,
+    testing::Combine(
+        testing::ValuesIn<BindHoistingTestCase>({
+            // Invariant in the inner loop.
+            {"[1, 2, 3].all(x, [4, 5, 6].all(y, "
+             "cel.bind(z, twice(x), z > 0 && y > 0)))",
+             true, 3},
+            // Depends on the inner loop variable.
+            {"[1, 2, 3].all(x, [4, 5, 6].all(y, "
+             "cel.bind(z, twice(y), z > x)))",
+             true, 9},
+            // Invariant in both loops.
+            {"[1, 2, 3].all(x, [4, 5, 6].all(y, "
+             "cel.bind(z, twice(7), z > x + y)))",
+             true, 1},
+            // The inner loop's result differs between outer iterations.
+            {"[1, 2, 3].map(x, [4, 5].map(y, "
+             "cel.bind(z, twice(x), z + y))) == "
+             "[[6, 7], [8, 9], [10, 11]]",
+             true, 3},
+            // Depends on an enclosing bind evaluated per outer iteration.
+            {"[1, 2, 3].all(x, cel.bind(w, x + 1, [4, 5].all(y, "
+             "cel.bind(z, twice(w), z > y))))",
+             false, 2},
+        }),
+        /*enable_recursive_planning=*/testing::Bool()));
+
 }  // namespace
 }  // namespace cel::extensions
@@ -20,11 +20,11 @@
 #include "absl/base/nullability.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "absl/strings/escaping.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "eval/public/cel_function_registry.h"
 #include "eval/public/cel_options.h"
+#include "internal/base64.h"
 #include "internal/status_macros.h"
 #include "runtime/function_adapter.h"
 #include "runtime/function_registry.h"
@@ -36,9 +36,9 @@ namespace {
 
 absl::StatusOr<Value> Base64Decode(ValueManager& value_manager,
                                    const StringValue& value) {
-  std::string in;
+  std::string scratch;
   std::string out;
-  if (!absl::Base64Unescape(value.NativeString(in), &out)) {
+  if (!internal::Base64Decode(value.NativeString(scratch), &out)) {
     return ErrorValue{absl::InvalidArgumentError("invalid base64 data")};
   }
   return value_manager.CreateBytesValue(std::move(out));
@@ -46,10 +46,10 @@ absl::StatusOr<Value> Base64Decode(ValueManager& value_manager,
 
 absl::StatusOr<Value> Base64Encode(ValueManager& value_manager,
                                    const BytesValue& value) {
-  std::string in;
-  std::string out;
-  absl::Base64Escape(value.NativeString(in), &out);
-  return value_manager.CreateStringValue(std::move(out));
+  // The encoding is ASCII, so it doesn't need to be validated as UTF-8. Cords
+  // are encoded chunk by chunk rather than flattened first.
+  return value_manager.CreateUncheckedStringValue(value.NativeValue(
+      [](const auto& bytes) { return internal::Base64Encode(bytes); }));
 }
 
 }  // namespace
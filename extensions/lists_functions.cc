@@ -0,0 +1,500 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/lists_functions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/meta/type_traits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "internal/casts.h"
+#include "internal/status_macros.h"
+#include "runtime/function_adapter.h"
+#include "runtime/function_registry.h"
+#include "runtime/runtime_options.h"
+
+namespace cel::extensions {
+
+namespace {
+
+// A contiguous range of another list, viewed in place.
+class SliceListValue final : public ParsedListValueInterface {
+ public:
+  // Returns the slice if `value` is one.
+  static const SliceListValue* AsSlice(const ListValue& value) {
+    if (auto parsed = As<ParsedListValue>(value);
+        parsed.has_value() &&
+        NativeTypeId::Of(*parsed) == NativeTypeId::For<SliceListValue>()) {
+      return &cel::internal::down_cast<const SliceListValue&>(
+          *(*parsed).operator->());
+    }
+    return nullptr;
+  }
+
+  SliceListValue(ListValue list, size_t offset, size_t size)
+      : list_(std::move(list)), offset_(offset), size_(size) {}
+
+  const ListValue& list() const { return list_; }
+
+  size_t offset() const { return offset_; }
+
+  std::string DebugString() const override {
+    return absl::StrCat(list_.DebugString(), ".slice(", offset_, ", ",
+                        offset_ + size_, ")");
+  }
+
+  size_t Size() const override { return size_; }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter& converter) const override {
+    CEL_ASSIGN_OR_RETURN(auto json_list, list_.ConvertToJsonArray(converter));
+    JsonArrayBuilder builder;
+    builder.reserve(size_);
+    size_t index = 0;
+    for (const auto& element : json_list) {
+      if (index >= offset_ + size_) {
+        break;
+      }
+      if (index++ >= offset_) {
+        builder.push_back(element);
+      }
+    }
+    return std::move(builder).Build();
+  }
+
+ protected:
+  Type GetTypeImpl(TypeManager& type_manager) const override {
+    return list_.GetType(type_manager);
+  }
+
+ private:
+  absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
+                                    Value& scratch) const override {
+    return list_.Get(value_manager, offset_ + index, scratch);
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<SliceListValue>();
+  }
+
+  const ListValue list_;
+  const size_t offset_;
+  const size_t size_;
+};
+
+absl::StatusOr<ListValue> NewList(ValueManager& value_manager,
+                                  std::vector<Value> elements) {
+  CEL_ASSIGN_OR_RETURN(auto builder, value_manager.NewListValueBuilder(
+                                         value_manager.GetDynListType()));
+  builder->Reserve(elements.size());
+  for (auto& element : elements) {
+    CEL_RETURN_IF_ERROR(builder->Add(std::move(element)));
+  }
+  return std::move(*builder).Build();
+}
+
+absl::StatusOr<Value> Distinct(ValueManager& value_manager,
+                               const ListValue& list) {
+  CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+  std::vector<Value> distinct;
+  distinct.reserve(size);
+  // Positions in `distinct` by `ValueHash`. Equal values hash the same, so
+  // each element only needs to be compared with those in its bucket.
+  absl::flat_hash_map<size_t, std::vector<size_t>> buckets;
+  buckets.reserve(size);
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        CEL_ASSIGN_OR_RETURN(auto hash, ValueHash(value_manager, element));
+        auto& bucket = buckets[hash];
+        for (size_t index : bucket) {
+          CEL_ASSIGN_OR_RETURN(auto equal,
+                               distinct[index].Equal(value_manager, element));
+          if (auto equal_bool = As<BoolValue>(equal);
+              equal_bool.has_value() && equal_bool->NativeValue()) {
+            return true;
+          }
+        }
+        bucket.push_back(distinct.size());
+        distinct.push_back(Value(element));
+        return true;
+      }));
+  if (distinct.size() == size) {
+    return list;
+  }
+  return NewList(value_manager, std::move(distinct));
+}
+
+absl::StatusOr<size_t> FlattenedSize(ValueManager& value_manager,
+                                     ListValueView list, int64_t depth) {
+  CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+  if (depth == 0) {
+    return size;
+  }
+  size_t flattened_size = 0;
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        if (auto nested = As<ListValueView>(element); nested.has_value()) {
+          CEL_ASSIGN_OR_RETURN(
+              auto nested_size,
+              FlattenedSize(value_manager, *nested, depth - 1));
+          flattened_size += nested_size;
+        } else {
+          ++flattened_size;
+        }
+        return true;
+      }));
+  return flattened_size;
+}
+
+absl::Status AppendFlattened(ValueManager& value_manager, ListValueView list,
+                             int64_t depth, ListValueBuilder& builder) {
+  return list.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        if (auto nested = As<ListValueView>(element);
+            nested.has_value() && depth > 0) {
+          CEL_RETURN_IF_ERROR(
+              AppendFlattened(value_manager, *nested, depth - 1, builder));
+        } else {
+          CEL_RETURN_IF_ERROR(builder.Add(Value(element)));
+        }
+        return true;
+      });
+}
+
+absl::StatusOr<Value> Flatten(ValueManager& value_manager,
+                              const ListValue& list, int64_t depth) {
+  if (depth < 0) {
+    return ErrorValue(
+        absl::InvalidArgumentError("flatten(): level must be non-negative"));
+  }
+  if (depth == 0) {
+    return list;
+  }
+  // Sizing the result up front costs a traversal, but the builder never
+  // grows.
+  CEL_ASSIGN_OR_RETURN(auto flattened_size,
+                       FlattenedSize(value_manager, list, depth));
+  CEL_ASSIGN_OR_RETURN(auto builder, value_manager.NewListValueBuilder(
+                                         value_manager.GetDynListType()));
+  builder->Reserve(flattened_size);
+  CEL_RETURN_IF_ERROR(AppendFlattened(value_manager, list, depth, *builder));
+  return std::move(*builder).Build();
+}
+
+absl::StatusOr<Value> Flatten1(ValueManager& value_manager,
+                               const ListValue& list) {
+  return Flatten(value_manager, list, 1);
+}
+
+absl::StatusOr<Value> Slice(ValueManager& value_manager, const ListValue& list,
+                            int64_t start, int64_t end) {
+  CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+  if (start < 0 || end < 0) {
+    return ErrorValue(absl::InvalidArgumentError(
+        absl::StrCat("cannot slice(", start, ", ", end,
+                     "), negative indexes not supported")));
+  }
+  if (start > end) {
+    return ErrorValue(absl::InvalidArgumentError(
+        absl::StrCat("cannot slice(", start, ", ", end,
+                     "), start index must be less than or equal to end "
+                     "index")));
+  }
+  if (static_cast<uint64_t>(end) > size) {
+    return ErrorValue(absl::InvalidArgumentError(
+        absl::StrCat("cannot slice(", start, ", ", end, "), list is length ",
+                     size)));
+  }
+  if (start == 0 && static_cast<uint64_t>(end) == size) {
+    return list;
+  }
+  // Slicing a slice views the original list, so slices never nest.
+  ListValue source = list;
+  size_t offset = static_cast<size_t>(start);
+  if (const auto* slice = SliceListValue::AsSlice(list); slice != nullptr) {
+    source = slice->list();
+    offset += slice->offset();
+  }
+  return ListValue(ParsedListValue(
+      value_manager.GetMemoryManager().MakeShared<SliceListValue>(
+          std::move(source), offset, static_cast<size_t>(end - start))));
+}
+
+// How `sort()` and `@sortByAssociatedKeys()` order values of one kind. Keys
+// are the native values of elements, so that sorting compares them directly.
+template <typename View>
+struct SortTraits {
+  using Key =
+      absl::remove_cvref_t<decltype(std::declval<View>().NativeValue())>;
+
+  static Key GetKey(ValueView value) {
+    return Cast<View>(value).NativeValue();
+  }
+
+  static bool Less(const Key& lhs, const Key& rhs) { return lhs < rhs; }
+
+  static Value ToValue(Key key) {
+    return typename View::alternative_type(std::move(key));
+  }
+};
+
+template <>
+struct SortTraits<BoolValueView> {
+  // Not `bool`, since `std::vector<bool>` can't be sorted in place.
+  using Key = int;
+
+  static Key GetKey(ValueView value) {
+    return Cast<BoolValueView>(value).NativeValue() ? 1 : 0;
+  }
+
+  static bool Less(Key lhs, Key rhs) { return lhs < rhs; }
+
+  static Value ToValue(Key key) { return BoolValue(key != 0); }
+};
+
+template <>
+struct SortTraits<DoubleValueView> {
+  using Key = double;
+
+  static Key GetKey(ValueView value) {
+    return Cast<DoubleValueView>(value).NativeValue();
+  }
+
+  // NaN orders after every other double, which keeps the ordering strict and
+  // weak.
+  static bool Less(Key lhs, Key rhs) {
+    return lhs < rhs || (std::isnan(rhs) && !std::isnan(lhs));
+  }
+
+  static Value ToValue(Key key) { return DoubleValue(key); }
+};
+
+template <typename View>
+struct ByteStringSortTraits {
+  using Key = typename View::alternative_type;
+
+  static Key GetKey(ValueView value) { return Key(Cast<View>(value)); }
+
+  static bool Less(const Key& lhs, const Key& rhs) {
+    return lhs.Compare(rhs) < 0;
+  }
+
+  static Value ToValue(Key key) { return key; }
+};
+
+template <>
+struct SortTraits<StringValueView> : ByteStringSortTraits<StringValueView> {};
+
+template <>
+struct SortTraits<BytesValueView> : ByteStringSortTraits<BytesValueView> {};
+
+// Calls `fn` with the `SortTraits` of `kind`.
+template <typename Fn>
+absl::StatusOr<Value> VisitSortTraits(absl::string_view function,
+                                      ValueKind kind, Fn fn) {
+  switch (kind) {
+    case ValueKind::kBool:
+      return fn(SortTraits<BoolValueView>());
+    case ValueKind::kInt:
+      return fn(SortTraits<IntValueView>());
+    case ValueKind::kUint:
+      return fn(SortTraits<UintValueView>());
+    case ValueKind::kDouble:
+      return fn(SortTraits<DoubleValueView>());
+    case ValueKind::kString:
+      return fn(SortTraits<StringValueView>());
+    case ValueKind::kBytes:
+      return fn(SortTraits<BytesValueView>());
+    case ValueKind::kDuration:
+      return fn(SortTraits<DurationValueView>());
+    case ValueKind::kTimestamp:
+      return fn(SortTraits<TimestampValueView>());
+    default:
+      return ErrorValue(absl::InvalidArgumentError(
+          absl::StrCat(function, ": list elements must be comparable")));
+  }
+}
+
+// Returns the kind of the elements of the non-empty `list`, or `nullopt` if
+// they are of different kinds.
+absl::StatusOr<absl::optional<ValueKind>> ElementKind(
+    ValueManager& value_manager, const ListValue& list) {
+  absl::optional<ValueKind> kind;
+  bool mixed = false;
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        if (!kind.has_value()) {
+          kind = element.kind();
+        }
+        mixed = element.kind() != *kind;
+        return !mixed;
+      }));
+  if (mixed) {
+    return absl::nullopt;
+  }
+  return kind;
+}
+
+template <typename Traits>
+absl::StatusOr<std::vector<typename Traits::Key>> SortKeys(
+    ValueManager& value_manager, const ListValue& list, size_t size) {
+  std::vector<typename Traits::Key> keys;
+  keys.reserve(size);
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_manager, [&keys](ValueView element) -> absl::StatusOr<bool> {
+        keys.push_back(Traits::GetKey(element));
+        return true;
+      }));
+  return keys;
+}
+
+absl::StatusOr<Value> Sort(ValueManager& value_manager, const ListValue& list) {
+  CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+  if (size == 0) {
+    return list;
+  }
+  CEL_ASSIGN_OR_RETURN(auto kind, ElementKind(value_manager, list));
+  if (!kind.has_value()) {
+    return ErrorValue(absl::InvalidArgumentError(
+        "sort(): list elements must have the same type"));
+  }
+  return VisitSortTraits(
+      "sort()", *kind, [&](auto traits) -> absl::StatusOr<Value> {
+        using Traits = decltype(traits);
+        CEL_ASSIGN_OR_RETURN(auto keys,
+                             SortKeys<Traits>(value_manager, list, size));
+        std::sort(keys.begin(), keys.end(), Traits::Less);
+        CEL_ASSIGN_OR_RETURN(auto builder,
+                             value_manager.NewListValueBuilder(
+                                 value_manager.GetDynListType()));
+        builder->Reserve(size);
+        for (auto& key : keys) {
+          CEL_RETURN_IF_ERROR(builder->Add(Traits::ToValue(std::move(key))));
+        }
+        return std::move(*builder).Build();
+      });
+}
+
+// Returns `list` ordered by `keys`, which are associated with the elements of
+// `list` by position. Elements with equal keys keep their relative order.
+absl::StatusOr<Value> SortByAssociatedKeys(ValueManager& value_manager,
+                                           const ListValue& list,
+                                           const ListValue& keys) {
+  CEL_ASSIGN_OR_RETURN(auto size, list.Size());
+  CEL_ASSIGN_OR_RETURN(auto keys_size, keys.Size());
+  if (size != keys_size) {
+    return ErrorValue(absl::InvalidArgumentError(
+        "@sortByAssociatedKeys() expected a list of the same size as the "
+        "associated keys list"));
+  }
+  if (size == 0) {
+    return list;
+  }
+  CEL_ASSIGN_OR_RETURN(auto kind, ElementKind(value_manager, keys));
+  if (!kind.has_value()) {
+    return ErrorValue(absl::InvalidArgumentError(
+        "sortBy(): sort keys must have the same type"));
+  }
+  return VisitSortTraits(
+      "sortBy()", *kind, [&](auto traits) -> absl::StatusOr<Value> {
+        using Traits = decltype(traits);
+        CEL_ASSIGN_OR_RETURN(auto native_keys,
+                             SortKeys<Traits>(value_manager, keys, size));
+        std::vector<size_t> order(size);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&native_keys](size_t lhs, size_t rhs) {
+                           return Traits::Less(native_keys[lhs],
+                                               native_keys[rhs]);
+                         });
+        std::vector<Value> elements;
+        elements.reserve(size);
+        CEL_RETURN_IF_ERROR(list.ForEach(
+            value_manager,
+            [&elements](ValueView element) -> absl::StatusOr<bool> {
+              elements.push_back(Value(element));
+              return true;
+            }));
+        std::vector<Value> sorted;
+        sorted.reserve(size);
+        for (size_t index : order) {
+          sorted.push_back(std::move(elements[index]));
+        }
+        return NewList(value_manager, std::move(sorted));
+      });
+}
+
+}  // namespace
+
+absl::Status RegisterListsFunctions(FunctionRegistry& registry,
+                                    const RuntimeOptions& options) {
+  CEL_RETURN_IF_ERROR(registry.Register(
+      UnaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&>::
+          CreateDescriptor("distinct", /*receiver_style=*/true),
+      UnaryFunctionAdapter<absl::StatusOr<Value>,
+                           const ListValue&>::WrapFunction(Distinct)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      UnaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&>::
+          CreateDescriptor("flatten", /*receiver_style=*/true),
+      UnaryFunctionAdapter<absl::StatusOr<Value>,
+                           const ListValue&>::WrapFunction(Flatten1)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      BinaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&,
+                            int64_t>::CreateDescriptor("flatten",
+                                                       /*receiver_style=*/true),
+      BinaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&,
+                            int64_t>::WrapFunction(Flatten)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      VariadicFunctionAdapter<
+          absl::StatusOr<Value>, const ListValue&, int64_t,
+          int64_t>::CreateDescriptor("slice", /*receiver_style=*/true),
+      VariadicFunctionAdapter<absl::StatusOr<Value>, const ListValue&,
+                              int64_t, int64_t>::WrapFunction(Slice)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      UnaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&>::
+          CreateDescriptor("sort", /*receiver_style=*/true),
+      UnaryFunctionAdapter<absl::StatusOr<Value>,
+                           const ListValue&>::WrapFunction(Sort)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      BinaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&,
+                            const ListValue&>::
+          CreateDescriptor("@sortByAssociatedKeys", /*receiver_style=*/true),
+      BinaryFunctionAdapter<absl::StatusOr<Value>, const ListValue&,
+                            const ListValue&>::
+          WrapFunction(SortByAssociatedKeys)));
+  return absl::OkStatus();
+}
+
+}  // namespace cel::extensions
@@ -0,0 +1,151 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/lists_functions.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "eval/public/activation.h"
+#include "eval/public/builtin_func_registrar.h"
+#include "eval/public/cel_expr_builder_factory.h"
+#include "eval/public/cel_expression.h"
+#include "eval/public/cel_options.h"
+#include "eval/public/cel_value.h"
+#include "extensions/lists_macros.h"
+#include "internal/testing.h"
+#include "parser/macro.h"
+#include "parser/parser.h"
+#include "runtime/runtime_options.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::v1alpha1::Expr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using ::google::api::expr::v1alpha1::SourceInfo;
+
+using ::google::api::expr::parser::ParseWithMacros;
+using ::google::api::expr::runtime::Activation;
+using ::google::api::expr::runtime::CelExpressionBuilder;
+using ::google::api::expr::runtime::CelValue;
+using ::google::api::expr::runtime::CreateCelExpressionBuilder;
+using ::google::api::expr::runtime::InterpreterOptions;
+
+using ::google::protobuf::Arena;
+using cel::internal::IsOk;
+using testing::HasSubstr;
+
+struct TestInfo {
+  std::string expr;
+  // If set, the expression must evaluate to an error with this message.
+  std::string error = "";
+};
+
+class CelListsFunctionsTest : public testing::TestWithParam<TestInfo> {};
+
+TEST_P(CelListsFunctionsTest, EndToEnd) {
+  const TestInfo& test_info = GetParam();
+  std::vector<Macro> all_macros = Macro::AllMacros();
+  for (auto& macro : lists_macros()) {
+    all_macros.push_back(std::move(macro));
+  }
+  auto result = ParseWithMacros(test_info.expr, all_macros, "<input>");
+  EXPECT_THAT(result, IsOk());
+
+  ParsedExpr parsed_expr = *result;
+  Expr expr = parsed_expr.expr();
+  SourceInfo source_info = parsed_expr.source_info();
+
+  InterpreterOptions options;
+  options.enable_heterogeneous_equality = true;
+  std::unique_ptr<CelExpressionBuilder> builder =
+      CreateCelExpressionBuilder(options);
+  ASSERT_OK(RegisterListsFunctions(
+      builder->GetRegistry()->InternalGetRegistry(), cel::RuntimeOptions{}));
+  ASSERT_OK(google::api::expr::runtime::RegisterBuiltinFunctions(
+      builder->GetRegistry(), options));
+
+  ASSERT_OK_AND_ASSIGN(auto cel_expr,
+                       builder->CreateExpression(&expr, &source_info));
+  Arena arena;
+  Activation activation;
+  ASSERT_OK_AND_ASSIGN(CelValue out, cel_expr->Evaluate(activation, &arena));
+  if (!test_info.error.empty()) {
+    ASSERT_TRUE(out.IsError()) << test_info.expr << " -> " << out.DebugString();
+    EXPECT_THAT(out.ErrorOrDie()->message(), HasSubstr(test_info.error));
+    return;
+  }
+  ASSERT_TRUE(out.IsBool()) << test_info.expr << " -> " << out.DebugString();
+  EXPECT_TRUE(out.BoolOrDie()) << test_info.expr << " -> " << out.DebugString();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    CelListsFunctionsTest, CelListsFunctionsTest,
+    testing::ValuesIn<TestInfo>({
+        {"[].distinct() == []"},
+        {"[1, 2, 1u, 2.0, 3].distinct() == [1, 2, 3]"},
+        {"['b', 'a', 'b'].distinct() == ['b', 'a']"},
+        {"[[1], [1.0], [2]].distinct() == [[1], [2]]"},
+        {"[{'a': 1}, {'a': 1u}].distinct() == [{'a': 1}]"},
+        {"[null, null, false].distinct() == [null, false]"},
+
+        {"[].flatten() == []"},
+        {"[1, [2, [3, 4]]].flatten() == [1, 2, [3, 4]]"},
+        {"[1, [2, [3, 4]]].flatten(2) == [1, 2, 3, 4]"},
+        {"[[], [1], [[2]]].flatten(5) == [1, 2]"},
+        {"[1, [2]].flatten(0) == [1, [2]]"},
+        {"[1].flatten(-1)", "level must be non-negative"},
+
+        {"[1, 2, 3, 4].slice(1, 3) == [2, 3]"},
+        {"[1, 2, 3, 4].slice(0, 4) == [1, 2, 3, 4]"},
+        {"[1, 2, 3, 4].slice(2, 2) == []"},
+        {"[1, 2, 3, 4].slice(1, 4).slice(1, 2) == [3]"},
+        {"[1, 2, 3, 4].slice(1, 3).size() == 2"},
+        {"3 in [1, 2, 3, 4].slice(1, 3)"},
+        {"[1, 2, 3, 4].slice(1, 3).map(x, x * 2) == [4, 6]"},
+        {"[1].slice(-1, 1)", "negative indexes not supported"},
+        {"[1].slice(1, 0)", "start index must be less than or equal"},
+        {"[1].slice(0, 2)", "list is length 1"},
+
+        {"[].sort() == []"},
+        {"[3, 1, 2].sort() == [1, 2, 3]"},
+        {"[3u, 1u].sort() == [1u, 3u]"},
+        {"[2.5, -1.0, 0.5].sort() == [-1.0, 0.5, 2.5]"},
+        {"['b', 'c', 'a'].sort() == ['a', 'b', 'c']"},
+        {"[b'b', b'a'].sort() == [b'a', b'b']"},
+        {"[true, false, true].sort() == [false, true, true]"},
+        {"[duration('2s'), duration('1s')].sort() == "
+         "[duration('1s'), duration('2s')]"},
+        {"[timestamp('2024-01-02T00:00:00Z'), "
+         "timestamp('2024-01-01T00:00:00Z')].sort()[0] == "
+         "timestamp('2024-01-01T00:00:00Z')"},
+        {"[1, 'a'].sort()", "list elements must have the same type"},
+        {"[1, 2.0].sort()", "list elements must have the same type"},
+        {"[[1]].sort()", "list elements must be comparable"},
+
+        {"[].sortBy(x, x) == []"},
+        {"[1, 2, 3].sortBy(x, -x) == [3, 2, 1]"},
+        {"[{'n': 'b', 'k': 2}, {'n': 'a', 'k': 1}, {'n': 'c', 'k': 1}]"
+         ".sortBy(e, e.k).map(e, e.n) == ['a', 'c', 'b']"},
+        {"['bb', 'a', 'ccc'].sortBy(s, size(s)) == ['a', 'bb', 'ccc']"},
+        {"[1, 2].sortBy(x, x == 1 ? 'a' : 1)",
+         "sort keys must have the same type"},
+    }));
+
+}  // namespace
+}  // namespace cel::extensions
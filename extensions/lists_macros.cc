@@ -0,0 +1,74 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/lists_macros.h"
+
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "common/expr.h"
+#include "common/operators.h"
+#include "parser/macro.h"
+#include "parser/macro_expr_factory.h"
+
+namespace cel::extensions {
+
+namespace {
+
+using ::google::api::expr::common::CelOperator;
+
+static constexpr char kSortBy[] = "sortBy";
+static constexpr char kSortByAssociatedKeys[] = "@sortByAssociatedKeys";
+static constexpr char kSortByInput[] = "@__sortBy_input__";
+static constexpr char kUnusedIterVar[] = "#unused";
+
+// `list.sortBy(e, key)` becomes
+//
+//   cel.bind(@__sortBy_input__, list,
+//            @__sortBy_input__.@sortByAssociatedKeys(
+//                @__sortBy_input__.map(e, key)))
+//
+// so that `list` is only evaluated once.
+absl::optional<Expr> ExpandSortBy(MacroExprFactory& factory, Expr& target,
+                                  absl::Span<Expr> args) {
+  if (!args[0].has_ident_expr()) {
+    return factory.ReportErrorAt(
+        args[0], "sortBy(var, ...) variable name must be a simple identifier");
+  }
+  auto keys = factory.NewComprehension(
+      args[0].ident_expr().name(), factory.NewIdent(kSortByInput),
+      kAccumulatorVariableName, factory.NewList(), factory.NewBoolConst(true),
+      factory.NewCall(
+          CelOperator::ADD, factory.NewAccuIdent(),
+          factory.NewList(factory.NewListElement(std::move(args[1])))),
+      factory.NewAccuIdent());
+  auto sorted = factory.NewMemberCall(
+      kSortByAssociatedKeys, factory.NewIdent(kSortByInput), std::move(keys));
+  return factory.NewComprehension(
+      kUnusedIterVar, factory.NewList(), kSortByInput, std::move(target),
+      factory.NewBoolConst(false), factory.NewIdent(kSortByInput),
+      std::move(sorted));
+}
+
+}  // namespace
+
+std::vector<Macro> lists_macros() {
+  absl::StatusOr<Macro> sort_by = Macro::Receiver(kSortBy, 2, ExpandSortBy);
+  return {*sort_by};
+}
+
+}  // namespace cel::extensions
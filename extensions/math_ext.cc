@@ -14,18 +14,24 @@
 
 #include "extensions/math_ext.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <utility>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
 #include "common/casting.h"
 #include "common/value.h"
+#include "common/values/contiguous_list_value.h"
 #include "eval/public/cel_function_registry.h"
 #include "eval/public/cel_number.h"
 #include "eval/public/cel_options.h"
+#include "internal/overflow.h"
 #include "internal/status_macros.h"
 #include "runtime/function_adapter.h"
 #include "runtime/function_registry.h"
@@ -41,6 +47,8 @@ using ::google::api::expr::runtime::InterpreterOptions;
 
 static constexpr char kMathMin[] = "math.@min";
 static constexpr char kMathMax[] = "math.@max";
+static constexpr char kMathSum[] = "math.sum";
+static constexpr char kMathAvg[] = "math.avg";
 
 struct ToValueVisitor {
   Value operator()(uint64_t v) const { return UintValue{v}; }
@@ -88,31 +96,6 @@ Value Min(ValueManager &, T v1, U v2) {
   return MinValue(CelNumber(v1), CelNumber(v2));
 }
 
-absl::StatusOr<Value> MinList(ValueManager &value_manager,
-                              const ListValue &values) {
-  CEL_ASSIGN_OR_RETURN(auto iterator, values.NewIterator(value_manager));
-  if (!iterator->HasNext()) {
-    return ErrorValue(
-        absl::InvalidArgumentError("math.@min argument must not be empty"));
-  }
-  Value scratch;
-  CEL_ASSIGN_OR_RETURN(auto value, iterator->Next(value_manager, scratch));
-  absl::StatusOr<CelNumber> current = ValueToNumber(value, kMathMin);
-  if (!current.ok()) {
-    return ErrorValue{current.status()};
-  }
-  CelNumber min = *current;
-  while (iterator->HasNext()) {
-    CEL_ASSIGN_OR_RETURN(value, iterator->Next(value_manager, scratch));
-    absl::StatusOr<CelNumber> other = ValueToNumber(value, kMathMin);
-    if (!other.ok()) {
-      return ErrorValue{other.status()};
-    }
-    min = MinNumber(min, *other);
-  }
-  return NumberToValue(min);
-}
-
 CelNumber MaxNumber(CelNumber v1, CelNumber v2) {
   if (v2 > v1) {
     return v2;
@@ -129,29 +112,245 @@ Value Max(ValueManager &, T v1, U v2) {
   return MaxValue(CelNumber(v1), CelNumber(v2));
 }
 
+absl::StatusOr<int64_t> NativeAdd(int64_t v1, int64_t v2) {
+  return cel::internal::CheckedAdd(v1, v2);
+}
+
+absl::StatusOr<uint64_t> NativeAdd(uint64_t v1, uint64_t v2) {
+  return cel::internal::CheckedAdd(v1, v2);
+}
+
+absl::StatusOr<double> NativeAdd(double v1, double v2) { return v1 + v2; }
+
+// Minimum, maximum and sum of a run of numbers of the same kind.
+template <typename T>
+struct NativeFold {
+  explicit NativeFold(T value) : min(value), max(value), sum(value) {}
+
+  void Add(T value) {
+    // Same selection as MinNumber and MaxNumber, so NaNs are treated alike.
+    if (value < min) {
+      min = value;
+    }
+    if (value > max) {
+      max = value;
+    }
+    if (sum.ok()) {
+      sum = NativeAdd(*sum, value);
+    }
+  }
+
+  T min;
+  T max;
+  absl::StatusOr<T> sum;
+};
+
+// Accumulates the numeric elements of a list in a single ForEach pass.
+//
+// While all elements have the same kind, which is the common case, they are
+// folded as native values. The first element of a different kind moves the
+// fold over to CelNumber, which orders values across int, uint and double.
+class NumericListFold {
+ public:
+  explicit NumericListFold(absl::string_view function) : function_(function) {}
+
+  absl::Status Fold(ValueManager &value_manager, const ListValue &values) {
+    if (auto ints = AsContiguousList<IntListValue>(values); ints) {
+      AddAll(*ints);
+      return absl::OkStatus();
+    }
+    if (auto doubles = AsContiguousList<DoubleListValue>(values); doubles) {
+      AddAll(*doubles);
+      return absl::OkStatus();
+    }
+    absl::Status error;
+    CEL_RETURN_IF_ERROR(values.ForEach(
+        value_manager,
+        [this, &error](ValueView element) -> absl::StatusOr<bool> {
+          if (auto int_value = As<IntValueView>(element); int_value) {
+            Add(int_value->NativeValue());
+          } else if (auto uint_value = As<UintValueView>(element);
+                     uint_value) {
+            Add(uint_value->NativeValue());
+          } else if (auto double_value = As<DoubleValueView>(element);
+                     double_value) {
+            Add(double_value->NativeValue());
+          } else {
+            error = absl::InvalidArgumentError(
+                absl::StrCat(function_, " arguments must be numeric"));
+            return false;
+          }
+          return true;
+        }));
+    return error;
+  }
+
+  size_t size() const { return size_; }
+
+  // Both require a non-empty fold.
+  CelNumber Min() const {
+    return mixed_ ? min_ : absl::visit(NativeMin{}, native_);
+  }
+  CelNumber Max() const {
+    return mixed_ ? max_ : absl::visit(NativeMax{}, native_);
+  }
+
+  // Sums lists of a single kind in that kind, reporting overflow of ints and
+  // uints, and lists of mixed kinds as double. The sum of no elements is 0.
+  absl::StatusOr<CelNumber> Sum() const {
+    if (mixed_) {
+      return CelNumber::FromDouble(double_sum_);
+    }
+    return absl::visit(NativeSum{}, native_);
+  }
+
+  // Requires a non-empty fold.
+  double Mean() const { return double_sum_ / static_cast<double>(size_); }
+
+ private:
+  struct NativeMin {
+    CelNumber operator()(absl::monostate) const {
+      return CelNumber::FromInt64(0);
+    }
+    template <typename T>
+    CelNumber operator()(const NativeFold<T> &fold) const {
+      return CelNumber(fold.min);
+    }
+  };
+
+  struct NativeMax {
+    CelNumber operator()(absl::monostate) const {
+      return CelNumber::FromInt64(0);
+    }
+    template <typename T>
+    CelNumber operator()(const NativeFold<T> &fold) const {
+      return CelNumber(fold.max);
+    }
+  };
+
+  struct NativeSum {
+    absl::StatusOr<CelNumber> operator()(absl::monostate) const {
+      return CelNumber::FromInt64(0);
+    }
+    template <typename T>
+    absl::StatusOr<CelNumber> operator()(const NativeFold<T> &fold) const {
+      CEL_ASSIGN_OR_RETURN(T sum, fold.sum);
+      return CelNumber(sum);
+    }
+  };
+
+  template <typename T>
+  void Add(T value) {
+    ++size_;
+    double_sum_ += static_cast<double>(value);
+    if (mixed_) {
+      AddMixed(CelNumber(value));
+      return;
+    }
+    if (auto *fold = absl::get_if<NativeFold<T>>(&native_); fold != nullptr) {
+      fold->Add(value);
+      return;
+    }
+    if (absl::holds_alternative<absl::monostate>(native_)) {
+      native_ = NativeFold<T>(value);
+      return;
+    }
+    min_ = absl::visit(NativeMin{}, native_);
+    max_ = absl::visit(NativeMax{}, native_);
+    mixed_ = true;
+    AddMixed(CelNumber(value));
+  }
+
+  // Folds the elements of a contiguous list, without dispatching on the kind of
+  // each element once the first one has been added.
+  template <typename T>
+  void AddAll(absl::Span<const T> values) {
+    if (values.empty()) {
+      return;
+    }
+    Add(values.front());
+    auto *fold = absl::get_if<NativeFold<T>>(&native_);
+    if (mixed_ || fold == nullptr) {
+      for (T value : values.subspan(1)) {
+        Add(value);
+      }
+      return;
+    }
+    for (T value : values.subspan(1)) {
+      fold->Add(value);
+      double_sum_ += static_cast<double>(value);
+    }
+    size_ += values.size() - 1;
+  }
+
+  void AddMixed(CelNumber number) {
+    min_ = MinNumber(min_, number);
+    max_ = MaxNumber(max_, number);
+  }
+
+  absl::string_view function_;
+  size_t size_ = 0;
+  double double_sum_ = 0;
+  absl::variant<absl::monostate, NativeFold<int64_t>, NativeFold<uint64_t>,
+                NativeFold<double>>
+      native_;
+  bool mixed_ = false;
+  CelNumber min_ = CelNumber::FromInt64(0);
+  CelNumber max_ = CelNumber::FromInt64(0);
+};
+
+absl::Status EmptyListError(absl::string_view function) {
+  return absl::InvalidArgumentError(
+      absl::StrCat(function, " argument must not be empty"));
+}
+
+absl::StatusOr<Value> MinList(ValueManager &value_manager,
+                              const ListValue &values) {
+  NumericListFold fold(kMathMin);
+  if (absl::Status status = fold.Fold(value_manager, values); !status.ok()) {
+    return ErrorValue(std::move(status));
+  }
+  if (fold.size() == 0) {
+    return ErrorValue(EmptyListError(kMathMin));
+  }
+  return NumberToValue(fold.Min());
+}
+
 absl::StatusOr<Value> MaxList(ValueManager &value_manager,
                               const ListValue &values) {
-  CEL_ASSIGN_OR_RETURN(auto iterator, values.NewIterator(value_manager));
-  if (!iterator->HasNext()) {
-    return ErrorValue(
-        absl::InvalidArgumentError("math.@max argument must not be empty"));
+  NumericListFold fold(kMathMax);
+  if (absl::Status status = fold.Fold(value_manager, values); !status.ok()) {
+    return ErrorValue(std::move(status));
   }
-  Value scratch;
-  CEL_ASSIGN_OR_RETURN(auto value, iterator->Next(value_manager, scratch));
-  absl::StatusOr<CelNumber> current = ValueToNumber(value, kMathMax);
-  if (!current.ok()) {
-    return ErrorValue{current.status()};
+  if (fold.size() == 0) {
+    return ErrorValue(EmptyListError(kMathMax));
   }
-  CelNumber min = *current;
-  while (iterator->HasNext()) {
-    CEL_ASSIGN_OR_RETURN(value, iterator->Next(value_manager, scratch));
-    absl::StatusOr<CelNumber> other = ValueToNumber(value, kMathMax);
-    if (!other.ok()) {
-      return ErrorValue{other.status()};
-    }
-    min = MaxNumber(min, *other);
+  return NumberToValue(fold.Max());
+}
+
+absl::StatusOr<Value> SumList(ValueManager &value_manager,
+                              const ListValue &values) {
+  NumericListFold fold(kMathSum);
+  if (absl::Status status = fold.Fold(value_manager, values); !status.ok()) {
+    return ErrorValue(std::move(status));
+  }
+  absl::StatusOr<CelNumber> sum = fold.Sum();
+  if (!sum.ok()) {
+    return ErrorValue(std::move(sum).status());
   }
-  return NumberToValue(min);
+  return NumberToValue(*sum);
+}
+
+absl::StatusOr<Value> AvgList(ValueManager &value_manager,
+                              const ListValue &values) {
+  NumericListFold fold(kMathAvg);
+  if (absl::Status status = fold.Fold(value_manager, values); !status.ok()) {
+    return ErrorValue(std::move(status));
+  }
+  if (fold.size() == 0) {
+    return ErrorValue(EmptyListError(kMathAvg));
+  }
+  return DoubleValue(fold.Mean());
 }
 
 template <typename T, typename U>
@@ -260,6 +459,17 @@ absl::Status RegisterMathExtensionFunctions(FunctionRegistry &registry,
       UnaryFunctionAdapter<absl::StatusOr<Value>, ListValue>::WrapFunction(
           MaxList)));
 
+  CEL_RETURN_IF_ERROR(registry.Register(
+      UnaryFunctionAdapter<absl::StatusOr<Value>, ListValue>::CreateDescriptor(
+          kMathSum, false),
+      UnaryFunctionAdapter<absl::StatusOr<Value>, ListValue>::WrapFunction(
+          SumList)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      UnaryFunctionAdapter<absl::StatusOr<Value>, ListValue>::CreateDescriptor(
+          kMathAvg, false),
+      UnaryFunctionAdapter<absl::StatusOr<Value>, ListValue>::WrapFunction(
+          AvgList)));
+
   return absl::OkStatus();
 }
 
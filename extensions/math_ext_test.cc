@@ -14,6 +14,8 @@
 
 #include "extensions/math_ext.h"
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
@@ -57,6 +59,8 @@ using cel::internal::StatusIs;
 
 constexpr absl::string_view kMathMin = "math.@min";
 constexpr absl::string_view kMathMax = "math.@max";
+constexpr absl::string_view kMathSum = "math.sum";
+constexpr absl::string_view kMathAvg = "math.avg";
 
 struct TestCase {
   absl::string_view operation;
@@ -81,6 +85,14 @@ TestCase MaxCase(CelValue list, CelValue result) {
   return TestCase{kMathMax, list, absl::nullopt, result};
 }
 
+TestCase SumCase(CelValue list, CelValue result) {
+  return TestCase{kMathSum, list, absl::nullopt, result};
+}
+
+TestCase AvgCase(CelValue list, CelValue result) {
+  return TestCase{kMathAvg, list, absl::nullopt, result};
+}
+
 struct MacroTestCase {
   absl::string_view expr;
   absl::string_view err = "";
@@ -275,6 +287,103 @@ TEST(MathExtTest, MinMaxList) {
   ExpectResult(MaxCase(CelValue::CreateList(&bad_middle_item), err_value));
 }
 
+TEST(MathExtTest, MinMaxHomogeneousList) {
+  ContainerBackedListImpl int_list({CelValue::CreateInt64(3),
+                                    CelValue::CreateInt64(-7),
+                                    CelValue::CreateInt64(5)});
+  ExpectResult(
+      MinCase(CelValue::CreateList(&int_list), CelValue::CreateInt64(-7)));
+  ExpectResult(
+      MaxCase(CelValue::CreateList(&int_list), CelValue::CreateInt64(5)));
+
+  ContainerBackedListImpl uint_list({CelValue::CreateUint64(3u),
+                                     CelValue::CreateUint64(1u),
+                                     CelValue::CreateUint64(8u)});
+  ExpectResult(
+      MinCase(CelValue::CreateList(&uint_list), CelValue::CreateUint64(1u)));
+  ExpectResult(
+      MaxCase(CelValue::CreateList(&uint_list), CelValue::CreateUint64(8u)));
+
+  ContainerBackedListImpl double_list({CelValue::CreateDouble(0.5),
+                                       CelValue::CreateDouble(-2.5),
+                                       CelValue::CreateDouble(1.5)});
+  ExpectResult(MinCase(CelValue::CreateList(&double_list),
+                       CelValue::CreateDouble(-2.5)));
+  ExpectResult(
+      MaxCase(CelValue::CreateList(&double_list), CelValue::CreateDouble(1.5)));
+
+  // A list which only becomes mixed after its first few elements keeps the
+  // kind of the first of several equal values.
+  ContainerBackedListImpl late_mixed_list({CelValue::CreateInt64(2),
+                                           CelValue::CreateInt64(1),
+                                           CelValue::CreateDouble(1.0),
+                                           CelValue::CreateUint64(3u)});
+  ExpectResult(MinCase(CelValue::CreateList(&late_mixed_list),
+                       CelValue::CreateInt64(1)));
+  ExpectResult(MaxCase(CelValue::CreateList(&late_mixed_list),
+                       CelValue::CreateUint64(3u)));
+}
+
+TEST(MathExtTest, SumAvgList) {
+  ContainerBackedListImpl empty_list({});
+  ExpectResult(
+      SumCase(CelValue::CreateList(&empty_list), CelValue::CreateInt64(0)));
+  absl::Status empty_list_err =
+      absl::InvalidArgumentError("argument must not be empty");
+  ExpectResult(AvgCase(CelValue::CreateList(&empty_list),
+                       CelValue::CreateError(&empty_list_err)));
+
+  ContainerBackedListImpl int_list({CelValue::CreateInt64(1),
+                                    CelValue::CreateInt64(2),
+                                    CelValue::CreateInt64(4)});
+  ExpectResult(
+      SumCase(CelValue::CreateList(&int_list), CelValue::CreateInt64(7)));
+  ExpectResult(AvgCase(CelValue::CreateList(&int_list),
+                       CelValue::CreateDouble(7.0 / 3.0)));
+
+  ContainerBackedListImpl uint_list(
+      {CelValue::CreateUint64(1u), CelValue::CreateUint64(2u)});
+  ExpectResult(
+      SumCase(CelValue::CreateList(&uint_list), CelValue::CreateUint64(3u)));
+  ExpectResult(
+      AvgCase(CelValue::CreateList(&uint_list), CelValue::CreateDouble(1.5)));
+
+  ContainerBackedListImpl double_list(
+      {CelValue::CreateDouble(0.5), CelValue::CreateDouble(0.25)});
+  ExpectResult(SumCase(CelValue::CreateList(&double_list),
+                       CelValue::CreateDouble(0.75)));
+
+  ContainerBackedListImpl mixed_list({CelValue::CreateInt64(1),
+                                      CelValue::CreateUint64(2u),
+                                      CelValue::CreateDouble(0.5)});
+  ExpectResult(
+      SumCase(CelValue::CreateList(&mixed_list), CelValue::CreateDouble(3.5)));
+  ExpectResult(AvgCase(CelValue::CreateList(&mixed_list),
+                       CelValue::CreateDouble(3.5 / 3.0)));
+
+  absl::Status overflow_err = absl::OutOfRangeError("integer overflow");
+  ContainerBackedListImpl overflow_list(
+      {CelValue::CreateInt64(std::numeric_limits<int64_t>::max()),
+       CelValue::CreateInt64(1)});
+  ExpectResult(SumCase(CelValue::CreateList(&overflow_list),
+                       CelValue::CreateError(&overflow_err)));
+  ExpectResult(AvgCase(CelValue::CreateList(&overflow_list),
+                       CelValue::CreateDouble(
+                           (static_cast<double>(
+                                std::numeric_limits<int64_t>::max()) +
+                            1.0) /
+                           2.0)));
+
+  absl::Status bad_arg_err =
+      absl::InvalidArgumentError("arguments must be numeric");
+  ContainerBackedListImpl bad_list(
+      {CelValue::CreateInt64(1), CelValue::CreateBool(true)});
+  ExpectResult(SumCase(CelValue::CreateList(&bad_list),
+                       CelValue::CreateError(&bad_arg_err)));
+  ExpectResult(AvgCase(CelValue::CreateList(&bad_list),
+                       CelValue::CreateError(&bad_arg_err)));
+}
+
 using MathExtMacroParamsTest = testing::TestWithParam<MacroTestCase>;
 TEST_P(MathExtMacroParamsTest, MacroTests) {
   const MacroTestCase& test_case = GetParam();
@@ -28,9 +28,11 @@
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/overload.h"
+#include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "base/ast.h"
 #include "base/ast_internal/ast_impl.h"
@@ -39,6 +41,8 @@
 #include "extensions/protobuf/internal/ast.h"
 #include "internal/proto_time_encoding.h"
 #include "internal/status_macros.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/map.h"
 
 namespace cel::extensions {
 namespace internal {
@@ -368,7 +372,48 @@ absl::StatusOr<Reference> ConvertProtoReferenceToNative(
   return ret_val;
 }
 
-absl::StatusOr<CheckedExpr> ConvertProtoCheckedExprToNative(
+absl::Status ValidateProtoType(const google::api::expr::v1alpha1::Type& type) {
+  switch (type.type_kind_case()) {
+    case google::api::expr::v1alpha1::Type::kDyn:
+    case google::api::expr::v1alpha1::Type::kNull:
+    case google::api::expr::v1alpha1::Type::kMessageType:
+    case google::api::expr::v1alpha1::Type::kTypeParam:
+    case google::api::expr::v1alpha1::Type::kError:
+      return absl::OkStatus();
+    case google::api::expr::v1alpha1::Type::kPrimitive:
+      return ToNative(type.primitive()).status();
+    case google::api::expr::v1alpha1::Type::kWrapper:
+      return ToNative(type.wrapper()).status();
+    case google::api::expr::v1alpha1::Type::kWellKnown:
+      return ToNative(type.well_known()).status();
+    case google::api::expr::v1alpha1::Type::kListType:
+      return ValidateProtoType(type.list_type().elem_type());
+    case google::api::expr::v1alpha1::Type::kMapType:
+      CEL_RETURN_IF_ERROR(ValidateProtoType(type.map_type().key_type()));
+      return ValidateProtoType(type.map_type().value_type());
+    case google::api::expr::v1alpha1::Type::kFunction:
+      for (const auto& arg_type : type.function().arg_types()) {
+        CEL_RETURN_IF_ERROR(ValidateProtoType(arg_type));
+      }
+      return ValidateProtoType(type.function().result_type());
+    case google::api::expr::v1alpha1::Type::kType:
+      return ValidateProtoType(type.type());
+    case google::api::expr::v1alpha1::Type::kAbstractType:
+      for (const auto& parameter_type :
+           type.abstract_type().parameter_types()) {
+        CEL_RETURN_IF_ERROR(ValidateProtoType(parameter_type));
+      }
+      return absl::OkStatus();
+    default:
+      return absl::InvalidArgumentError(
+          "Illegal type specified for google::api::expr::v1alpha1::Type.");
+  }
+}
+
+namespace {
+
+// Converts everything but the type map of `checked_expr`.
+absl::StatusOr<CheckedExpr> ConvertProtoCheckedExprToNativeWithoutTypes(
     const CheckedExprPb& checked_expr) {
   CheckedExpr ret_val;
   for (const auto& pair : checked_expr.reference_map()) {
@@ -379,13 +424,6 @@ absl::StatusOr<CheckedExpr> ConvertProtoCheckedExprToNative(
     ret_val.mutable_reference_map().emplace(pair.first,
                                             *(std::move(native_reference)));
   }
-  for (const auto& pair : checked_expr.type_map()) {
-    auto native_type = ConvertProtoTypeToNative(pair.second);
-    if (!native_type.ok()) {
-      return native_type.status();
-    }
-    ret_val.mutable_type_map().emplace(pair.first, *(std::move(native_type)));
-  }
   auto native_source_info =
       ConvertProtoSourceInfoToNative(checked_expr.source_info());
   if (!native_source_info.ok()) {
@@ -401,6 +439,23 @@ absl::StatusOr<CheckedExpr> ConvertProtoCheckedExprToNative(
   return ret_val;
 }
 
+}  // namespace
+
+absl::StatusOr<CheckedExpr> ConvertProtoCheckedExprToNative(
+    const CheckedExprPb& checked_expr) {
+  CEL_ASSIGN_OR_RETURN(
+      CheckedExpr ret_val,
+      ConvertProtoCheckedExprToNativeWithoutTypes(checked_expr));
+  for (const auto& pair : checked_expr.type_map()) {
+    auto native_type = ConvertProtoTypeToNative(pair.second);
+    if (!native_type.ok()) {
+      return native_type.status();
+    }
+    ret_val.mutable_type_map().emplace(pair.first, *(std::move(native_type)));
+  }
+  return ret_val;
+}
+
 }  // namespace internal
 
 namespace {
@@ -505,6 +560,10 @@ absl::StatusOr<SourceInfoPb> SourceInfoToProto(const SourceInfo& source_info) {
     result.add_line_offsets(line_offset);
   }
 
+  source_info.compact_positions().ForEach(
+      [&result](int64_t id, int32_t offset) {
+        (*result.mutable_positions())[id] = offset;
+      });
   for (auto pos_iter = source_info.positions().begin();
        pos_iter != source_info.positions().end(); ++pos_iter) {
     (*result.mutable_positions())[pos_iter->first] = pos_iter->second;
@@ -693,6 +752,45 @@ absl::Status TypeToProto(const Type& type, TypePb* result) {
   return absl::visit(TypeKindToProtoVisitor{result}, type.type_kind());
 }
 
+// Converts the types of a checked expression when looked up. The types are
+// copied onto an arena, which is much cheaper than converting them, and must
+// have been validated by `ValidateProtoType()`.
+class ProtoTypeMap final : public ast_internal::LazyTypeMap {
+ public:
+  explicit ProtoTypeMap(
+      const google::protobuf::Map<int64_t, TypePb>& type_map)
+      : checked_expr_(google::protobuf::Arena::Create<CheckedExprPb>(&arena_)) {
+    *checked_expr_->mutable_type_map() = type_map;
+  }
+
+  absl::optional<Type> FindType(int64_t expr_id) const override {
+    auto it = checked_expr_->type_map().find(expr_id);
+    if (it == checked_expr_->type_map().end()) {
+      return absl::nullopt;
+    }
+    return Convert(it->second);
+  }
+
+  absl::flat_hash_map<int64_t, Type> ConvertAll() const override {
+    absl::flat_hash_map<int64_t, Type> types;
+    types.reserve(checked_expr_->type_map().size());
+    for (const auto& [id, type] : checked_expr_->type_map()) {
+      types.emplace(id, Convert(type));
+    }
+    return types;
+  }
+
+ private:
+  static Type Convert(const TypePb& type) {
+    absl::StatusOr<Type> native_type = internal::ConvertProtoTypeToNative(type);
+    ABSL_DCHECK_OK(native_type.status());
+    return native_type.ok() ? *std::move(native_type) : Type(DynamicType());
+  }
+
+  google::protobuf::Arena arena_;
+  absl::Nonnull<CheckedExprPb*> checked_expr_;
+};
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<Ast>> CreateAstFromParsedExpr(
@@ -730,9 +828,16 @@ absl::StatusOr<ParsedExprPb> CreateParsedExprFromAst(const Ast& ast) {
 
 absl::StatusOr<std::unique_ptr<Ast>> CreateAstFromCheckedExpr(
     const CheckedExprPb& checked_expr) {
-  CEL_ASSIGN_OR_RETURN(cel::ast_internal::CheckedExpr expr,
-                       internal::ConvertProtoCheckedExprToNative(checked_expr));
-  return std::make_unique<cel::ast_internal::AstImpl>(std::move(expr));
+  // Types are validated now, so that a malformed AST is still rejected here,
+  // but only converted when looked up.
+  for (const auto& [id, type] : checked_expr.type_map()) {
+    CEL_RETURN_IF_ERROR(internal::ValidateProtoType(type));
+  }
+  CEL_ASSIGN_OR_RETURN(
+      cel::ast_internal::CheckedExpr expr,
+      internal::ConvertProtoCheckedExprToNativeWithoutTypes(checked_expr));
+  return std::make_unique<cel::ast_internal::AstImpl>(
+      std::move(expr), std::make_unique<ProtoTypeMap>(checked_expr.type_map()));
 }
 
 absl::StatusOr<google::api::expr::v1alpha1::CheckedExpr> CreateCheckedExprFromAst(
@@ -19,6 +19,7 @@
 
 #include "google/api/expr/v1alpha1/checked.pb.h"
 #include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "base/ast.h"
 #include "base/ast_internal/expr.h"
@@ -39,6 +40,9 @@ absl::StatusOr<ast_internal::Reference> ConvertProtoReferenceToNative(
     const google::api::expr::v1alpha1::Reference& reference);
 absl::StatusOr<ast_internal::CheckedExpr> ConvertProtoCheckedExprToNative(
     const google::api::expr::v1alpha1::CheckedExpr& checked_expr);
+// Returns the error `ConvertProtoTypeToNative()` would return for `type`,
+// without converting it.
+absl::Status ValidateProtoType(const google::api::expr::v1alpha1::Type& type);
 
 // Conversion utility for the protobuf constant CEL value representation.
 absl::StatusOr<ast_internal::Constant> ConvertConstant(
@@ -60,7 +64,7 @@ absl::StatusOr<google::api::expr::v1alpha1::ParsedExpr> CreateParsedExprFromAst(
 
 // Creates a runtime AST from a checked protobuf AST.
 // May return a non-ok Status if the AST is malformed (e.g. unset required
-// fields).
+// fields). The entries of the type map are converted when first looked up.
 absl::StatusOr<std::unique_ptr<Ast>> CreateAstFromCheckedExpr(
     const google::api::expr::v1alpha1::CheckedExpr& checked_expr);
 
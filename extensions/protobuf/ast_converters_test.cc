@@ -522,6 +522,27 @@ TEST(AstConvertersTest, CheckedExprToAst) {
   ASSERT_TRUE(ast->IsChecked());
 }
 
+TEST(AstConvertersTest, CheckedExprToAstTypeError) {
+  CheckedExprPb checked_expr;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        type_map {
+          key: 1
+          value { list_type { elem_type { map_type { key_type {} } } } }
+        }
+        expr { id: 1 ident_expr { name: "expr" } }
+      )pb",
+      &checked_expr));
+
+  EXPECT_THAT(
+      CreateAstFromCheckedExpr(checked_expr),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Illegal type specified for "
+                         "google::api::expr::v1alpha1::Type.")));
+  EXPECT_THAT(internal::ValidateProtoType(checked_expr.type_map().at(1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(AstConvertersTest, AstToCheckedExprBasic) {
   ast_internal::Expr expr;
   expr.set_id(1);
@@ -643,6 +664,25 @@ TEST_P(CheckedExprToAstTypesTest, CheckedExprToAstTypes) {
               IsOkAndHolds(EqualsProto(checked_expr_)));
 }
 
+TEST_P(CheckedExprToAstTypesTest, CheckedExprToAstTypesOnDemand) {
+  TypePb test_type;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(GetParam().type, &test_type));
+  (*checked_expr_.mutable_type_map())[1] = test_type;
+  ASSERT_OK_AND_ASSIGN(ast_internal::Type expected_type,
+                       internal::ConvertProtoTypeToNative(test_type));
+
+  ASSERT_OK_AND_ASSIGN(auto ast, CreateAstFromCheckedExpr(checked_expr_));
+  const auto& impl = ast_internal::AstImpl::CastFromPublicAst(*ast);
+
+  const ast_internal::Type* type = impl.FindType(1);
+  ASSERT_NE(type, nullptr);
+  EXPECT_EQ(*type, expected_type);
+  // Looking the type up again returns the same conversion.
+  EXPECT_EQ(impl.FindType(1), type);
+  EXPECT_EQ(impl.FindType(2), nullptr);
+  EXPECT_EQ(impl.GetType(1), expected_type);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Types, CheckedExprToAstTypesTest,
     testing::ValuesIn<CheckedExprToAstTypesTestCase>({
@@ -18,6 +18,8 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "common/value.h"
 #include "internal/status_macros.h"
 #include "runtime/activation.h"
@@ -62,7 +64,8 @@ absl::StatusOr<Value> GetFieldValue(const google::protobuf::FieldDescriptor* fie
 absl::Status BindProtoToActivation(
     const Descriptor& descriptor, const StructValue& struct_value,
     ValueManager& value_manager, Activation& activation,
-    BindProtoUnsetFieldBehavior unset_field_behavior) {
+    BindProtoUnsetFieldBehavior unset_field_behavior,
+    BindProtoBindingMode binding_mode) {
   for (int i = 0; i < descriptor.field_count(); i++) {
     const google::protobuf::FieldDescriptor* field_desc = descriptor.field(i);
     CEL_ASSIGN_OR_RETURN(bool should_bind,
@@ -72,6 +75,19 @@ absl::Status BindProtoToActivation(
       continue;
     }
 
+    if (binding_mode == BindProtoBindingMode::kLazy) {
+      // The struct value shares the adapted message, so the copy captured by
+      // each provider is cheap.
+      activation.InsertOrAssignValueProvider(
+          field_desc->name(),
+          [field_desc, struct_value = StructValue(struct_value)](
+              ValueManager& value_manager,
+              absl::string_view) -> absl::StatusOr<absl::optional<Value>> {
+            return GetFieldValue(field_desc, struct_value, value_manager);
+          });
+      continue;
+    }
+
     CEL_ASSIGN_OR_RETURN(
         Value field, GetFieldValue(field_desc, struct_value, value_manager));
 
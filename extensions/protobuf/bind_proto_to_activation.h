@@ -36,6 +36,20 @@ enum class BindProtoUnsetFieldBehavior {
   kSkip
 };
 
+// Option for when the bound fields of the context proto are converted to
+// values.
+enum class BindProtoBindingMode {
+  // Convert every bound field when binding.
+  kEager,
+  // Bind each field as a value provider that is only converted the first time
+  // the field is looked up. Preferred for large context messages where most
+  // expressions only reference a few of the fields.
+  //
+  // Converted fields are memoized by the activation, so the value manager
+  // used for evaluation must outlive the activation.
+  kLazy,
+};
+
 namespace protobuf_internal {
 
 // Implements binding provided the context message has already
@@ -44,7 +58,8 @@ absl::Status BindProtoToActivation(
     const google::protobuf::Descriptor& descriptor, const StructValue& struct_value,
     ValueManager& value_manager, Activation& activation,
     BindProtoUnsetFieldBehavior unset_field_behavior =
-        BindProtoUnsetFieldBehavior::kSkip);
+        BindProtoUnsetFieldBehavior::kSkip,
+    BindProtoBindingMode binding_mode = BindProtoBindingMode::kEager);
 
 }  // namespace protobuf_internal
 
@@ -80,11 +95,16 @@ absl::Status BindProtoToActivation(
 // for the field (either an explicit default value or a type specific default).
 //
 // For repeated fields, an unset field is bound as an empty list.
+//
+// By default every bound field is converted when binding.
+// BindProtoBindingMode::kLazy defers converting each field until the field is
+// first looked up during evaluation.
 template <typename T>
 absl::Status BindProtoToActivation(
     const T& context, ValueManager& value_manager, Activation& activation,
     BindProtoUnsetFieldBehavior unset_field_behavior =
-        BindProtoUnsetFieldBehavior::kSkip) {
+        BindProtoUnsetFieldBehavior::kSkip,
+    BindProtoBindingMode binding_mode = BindProtoBindingMode::kEager) {
   static_assert(protobuf_internal::IsProtoMessage<T>);
   // TODO(uncreated-issue/68): for simplicity, just convert the whole message to a
   // struct value. For performance, may be better to convert members as needed.
@@ -104,9 +124,9 @@ absl::Status BindProtoToActivation(
         absl::StrCat("context missing descriptor: ", context.GetTypeName()));
   }
 
-  return protobuf_internal::BindProtoToActivation(*descriptor, struct_value,
-                                                  value_manager, activation,
-                                                  unset_field_behavior);
+  return protobuf_internal::BindProtoToActivation(
+      *descriptor, struct_value, value_manager, activation,
+      unset_field_behavior, binding_mode);
 }
 
 }  // namespace cel::extensions
@@ -245,6 +245,43 @@ TEST_P(BindProtoToActivationTest, BindProtoToActivationMapComplex) {
               IsOkAndHolds(Optional(IsMapValueOfSize(2))));
 }
 
+TEST_P(BindProtoToActivationTest, BindProtoToActivationLazy) {
+  ProtoTypeReflector provider;
+  ManagedValueFactory value_factory(provider, memory_manager());
+  TestAllTypes test_all_types;
+  test_all_types.set_single_int64(123);
+  test_all_types.add_repeated_int64(456);
+  Activation activation;
+
+  ASSERT_OK(BindProtoToActivation(
+      test_all_types, value_factory.get(), activation,
+      BindProtoUnsetFieldBehavior::kSkip, BindProtoBindingMode::kLazy));
+
+  EXPECT_THAT(activation.FindVariable(value_factory.get(), "single_int64"),
+              IsOkAndHolds(Optional(IntValueIs(123))));
+  EXPECT_THAT(activation.FindVariable(value_factory.get(), "repeated_int64"),
+              IsOkAndHolds(Optional(IsListValueOfSize(1))));
+  EXPECT_THAT(activation.FindVariable(value_factory.get(), "single_int32"),
+              IsOkAndHolds(Eq(absl::nullopt)));
+}
+
+TEST_P(BindProtoToActivationTest, BindProtoToActivationLazyDefault) {
+  ProtoTypeReflector provider;
+  ManagedValueFactory value_factory(provider, memory_manager());
+  TestAllTypes test_all_types;
+  Activation activation;
+
+  ASSERT_OK(BindProtoToActivation(
+      test_all_types, value_factory.get(), activation,
+      BindProtoUnsetFieldBehavior::kBindDefaultValue,
+      BindProtoBindingMode::kLazy));
+
+  EXPECT_THAT(activation.FindVariable(value_factory.get(), "single_int32"),
+              IsOkAndHolds(Optional(IntValueIs(-32))));
+  EXPECT_THAT(activation.FindVariable(value_factory.get(), "single_any"),
+              IsOkAndHolds(Optional(test::IsNullValue())));
+}
+
 INSTANTIATE_TEST_SUITE_P(Runner, BindProtoToActivationTest,
                          ::testing::Values(MemoryManagement::kReferenceCounting,
                                            MemoryManagement::kPooling));
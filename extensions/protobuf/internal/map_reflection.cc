@@ -14,6 +14,10 @@
 
 #include "extensions/protobuf/internal/map_reflection.h"
 
+#include <string>
+
+#include "absl/strings/string_view.h"
+
 namespace google::protobuf::expr {
 
 class CelMapReflectionFriend final {
@@ -115,4 +119,18 @@ bool InsertOrLookupMapValue(const google::protobuf::Reflection& reflection,
       reflection, message, field, key, value);
 }
 
+const google::protobuf::MapKey& StringMapKey(absl::string_view value) {
+  thread_local google::protobuf::MapKey key = [] {
+    google::protobuf::MapKey key;
+    key.SetStringValue(std::string());
+    return key;
+  }();
+  // MapKey only accepts string values by value, which would allocate for each
+  // lookup. The string it holds is not const, so assign to it in place.
+  const_cast<std::string&>(  // NOLINT(google3-runtime-const-cast)
+      key.GetStringValue())
+      .assign(value.data(), value.size());
+  return key;
+}
+
 }  // namespace cel::extensions::protobuf_internal
@@ -16,6 +16,7 @@
 #define THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_INTERNAL_MAP_REFLECTION_H_
 
 #include "absl/base/attributes.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/message.h"
 
@@ -55,6 +56,12 @@ bool InsertOrLookupMapValue(const google::protobuf::Reflection& reflection,
                             google::protobuf::MapValueRef* value)
     ABSL_ATTRIBUTE_NONNULL();
 
+// Returns a string map key holding `value`, for lookups in map fields with
+// string keys. The key belongs to the calling thread and is reused by the next
+// call on it, so lookups only allocate when `value` outgrows its buffer. The
+// returned reference is valid until then.
+const google::protobuf::MapKey& StringMapKey(absl::string_view value);
+
 }  // namespace cel::extensions::protobuf_internal
 
 #endif  // THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_INTERNAL_MAP_REFLECTION_H_
@@ -29,6 +29,8 @@
 #include "absl/base/attributes.h"
 #include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/log/absl_check.h"
 #include "absl/numeric/bits.h"
 #include "absl/status/status.h"
@@ -36,6 +38,7 @@
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
@@ -59,6 +62,7 @@
 #include "extensions/protobuf/internal/map_reflection.h"
 #include "extensions/protobuf/internal/qualify.h"
 #include "extensions/protobuf/internal/struct.h"
+#include "extensions/protobuf/internal/struct_view.h"
 #include "extensions/protobuf/internal/timestamp.h"
 #include "extensions/protobuf/internal/wrappers.h"
 #include "extensions/protobuf/json.h"
@@ -66,14 +70,16 @@
 #include "internal/align.h"
 #include "internal/casts.h"
 #include "internal/new.h"
+#include "internal/proto_equality.h"
+#include "internal/proto_wire.h"
 #include "internal/status_macros.h"
 #include "runtime/runtime_options.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/reflection.h"
 #include "google/protobuf/text_format.h"
-#include "google/protobuf/util/message_differencer.h"
 
 namespace cel {
 
@@ -709,8 +715,14 @@ absl::StatusOr<ValueView> ProtoBytesRepeatedFieldToValueAccessor(
     absl::Nonnull<const google::protobuf::Reflection*> reflection,
     absl::Nonnull<const google::protobuf::FieldDescriptor*> field, int index,
     ValueManager& value_manager, Value& value) {
-  value = BytesValue{reflection->GetRepeatedString(*message, field, index)};
-  return value;
+  std::string scratch;
+  const auto& field_value =
+      reflection->GetRepeatedStringReference(*message, field, index, &scratch);
+  if (&field_value == &scratch) {
+    value = BytesValue{std::move(scratch)};
+    return value;
+  }
+  return BytesValueView{field_value};
 }
 
 absl::StatusOr<ValueView> ProtoStringRepeatedFieldToValueAccessor(
@@ -718,9 +730,14 @@ absl::StatusOr<ValueView> ProtoStringRepeatedFieldToValueAccessor(
     absl::Nonnull<const google::protobuf::Reflection*> reflection,
     absl::Nonnull<const google::protobuf::FieldDescriptor*> field, int index,
     ValueManager& value_manager, Value& value) {
-  value = value_manager.CreateUncheckedStringValue(
-      reflection->GetRepeatedString(*message, field, index));
-  return value;
+  std::string scratch;
+  const auto& field_value =
+      reflection->GetRepeatedStringReference(*message, field, index, &scratch);
+  if (&field_value == &scratch) {
+    value = value_manager.CreateUncheckedStringValue(std::move(scratch));
+    return value;
+  }
+  return StringValueView{field_value};
 }
 
 absl::StatusOr<ValueView> ProtoNullRepeatedFieldToValueAccessor(
@@ -1085,24 +1102,31 @@ class ParsedProtoListValueInterface
 
   absl::Status ForEach(ValueManager& value_manager,
                        ForEachCallback callback) const final {
-    const auto size = Size();
-    Value element_scratch;
-    for (size_t index = 0; index < size; ++index) {
-      CEL_ASSIGN_OR_RETURN(
-          auto element,
-          field_to_value_accessor_(
-              shared_from_this(), &message_, GetReflectionOrDie(message_),
-              field_, static_cast<int>(index), value_manager, element_scratch));
-      CEL_ASSIGN_OR_RETURN(auto ok, callback(element));
-      if (!ok) {
-        break;
-      }
-    }
-    return absl::OkStatus();
+    return ForEach(value_manager,
+                   [callback](size_t, ValueView element)
+                       -> absl::StatusOr<bool> { return callback(element); });
   }
 
   absl::Status ForEach(ValueManager& value_manager,
                        ForEachWithIndexCallback callback) const final {
+    switch (field_->cpp_type()) {
+      case google::protobuf::FieldDescriptor::CPPTYPE_BOOL:
+        return ForEachScalar<bool, BoolValueView>(callback);
+      case google::protobuf::FieldDescriptor::CPPTYPE_INT32:
+        return ForEachScalar<int32_t, IntValueView>(callback);
+      case google::protobuf::FieldDescriptor::CPPTYPE_INT64:
+        return ForEachScalar<int64_t, IntValueView>(callback);
+      case google::protobuf::FieldDescriptor::CPPTYPE_UINT32:
+        return ForEachScalar<uint32_t, UintValueView>(callback);
+      case google::protobuf::FieldDescriptor::CPPTYPE_UINT64:
+        return ForEachScalar<uint64_t, UintValueView>(callback);
+      case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+        return ForEachScalar<float, DoubleValueView>(callback);
+      case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+        return ForEachScalar<double, DoubleValueView>(callback);
+      default:
+        break;
+    }
     const auto size = Size();
     Value element_scratch;
     for (size_t index = 0; index < size; ++index) {
@@ -1126,6 +1150,23 @@ class ParsedProtoListValueInterface
   }
 
  private:
+  // Iterates a repeated scalar field through a typed view of it, rather than
+  // going through the reflection accessors for each element.
+  template <typename T, typename V>
+  absl::Status ForEachScalar(ForEachWithIndexCallback callback) const {
+    const auto elements =
+        GetReflectionOrDie(message_)->GetRepeatedFieldRef<T>(message_, field_);
+    const int size = elements.size();
+    for (int index = 0; index < size; ++index) {
+      CEL_ASSIGN_OR_RETURN(auto ok, callback(static_cast<size_t>(index),
+                                             V{elements.Get(index)}));
+      if (!ok) {
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
   absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
                                     Value& scratch) const final {
     return field_to_value_accessor_(
@@ -1181,7 +1222,9 @@ class ParsedProtoMapValueInterface
         field_(field),
         map_key_from_value_(map_key_from_value),
         map_key_to_value_(map_key_to_value),
-        map_value_to_value_(map_value_to_value) {}
+        map_value_to_value_(map_value_to_value),
+        string_keys_(field_->message_type()->map_key()->cpp_type() ==
+                     google::protobuf::FieldDescriptor::CPPTYPE_STRING) {}
 
   std::string DebugString() const final {
     google::protobuf::TextFormat::Printer printer;
@@ -1272,8 +1315,24 @@ class ParsedProtoMapValueInterface
  private:
   absl::StatusOr<absl::optional<ValueView>> FindImpl(
       ValueManager& value_manager, ValueView key, Value& scratch) const final {
-    google::protobuf::MapKey map_key;
-    CEL_RETURN_IF_ERROR(map_key_from_value_(key, map_key));
+    google::protobuf::MapKey map_key_scratch;
+    CEL_ASSIGN_OR_RETURN(const auto* map_key, ToMapKey(key, map_key_scratch));
+    return Lookup(value_manager, *map_key, scratch);
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> FindStringImpl(
+      ValueManager& value_manager, absl::string_view key, size_t hash,
+      Value& scratch) const final {
+    if (!string_keys_) {
+      return ParsedMapValueInterface::FindStringImpl(value_manager, key, hash,
+                                                     scratch);
+    }
+    return Lookup(value_manager, StringMapKey(key), scratch);
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> Lookup(
+      ValueManager& value_manager, const google::protobuf::MapKey& map_key,
+      Value& scratch) const {
     google::protobuf::MapValueConstRef map_value;
     if (!LookupMapValue(*GetReflectionOrDie(message_), message_, *field_,
                         map_key, &map_value)) {
@@ -1288,10 +1347,25 @@ class ParsedProtoMapValueInterface
 
   absl::StatusOr<bool> HasImpl(ValueManager& value_manager,
                                ValueView key) const final {
-    google::protobuf::MapKey map_key;
-    CEL_RETURN_IF_ERROR(map_key_from_value_(key, map_key));
+    google::protobuf::MapKey map_key_scratch;
+    CEL_ASSIGN_OR_RETURN(const auto* map_key, ToMapKey(key, map_key_scratch));
     return ContainsMapKey(*GetReflectionOrDie(message_), message_, *field_,
-                          map_key);
+                          *map_key);
+  }
+
+  // Converts `key` to the key of the map field for a lookup. String keys use
+  // the reusable key of the calling thread, rather than copying them into
+  // `scratch`.
+  absl::StatusOr<absl::Nonnull<const google::protobuf::MapKey*>> ToMapKey(
+      ValueView key, google::protobuf::MapKey& scratch) const {
+    if (string_keys_) {
+      if (auto string_value = As<StringValueView>(key); string_value) {
+        std::string flat;
+        return &StringMapKey(string_value->NativeString(flat));
+      }
+    }
+    CEL_RETURN_IF_ERROR(map_key_from_value_(key, scratch));
+    return &scratch;
   }
 
   NativeTypeId GetNativeTypeId() const final {
@@ -1303,6 +1377,7 @@ class ParsedProtoMapValueInterface
   ProtoMapKeyFromValueConverter map_key_from_value_;
   ProtoMapKeyToValueConverter map_key_to_value_;
   ProtoMapValueToValueConverter map_value_to_value_;
+  const bool string_keys_;
 };
 
 class ParsedProtoQualifyState final : public ProtoQualifyState {
@@ -1485,7 +1560,7 @@ class ParsedProtoStructValueInterface
     for (const auto* field : fields) {
       CEL_ASSIGN_OR_RETURN(
           auto value,
-          ProtoFieldToValue(shared_from_this(), &message(), reflection, field,
+          ProtoFieldToValue(owner(), &message(), reflection, field,
                             value_manager, value_scratch,
                             ProtoWrapperTypeOptions::kUnsetProtoDefault));
       CEL_ASSIGN_OR_RETURN(auto ok, callback(field->name(), value));
@@ -1504,8 +1579,8 @@ class ParsedProtoStructValueInterface
     }
     auto memory_manager = value_manager.GetMemoryManager();
     ParsedProtoQualifyState qualify_state(&message(), message().GetDescriptor(),
-                                          message().GetReflection(),
-                                          shared_from_this(), value_manager);
+                                          message().GetReflection(), owner(),
+                                          value_manager);
     for (int i = 0; i < qualifiers.size() - 1; i++) {
       const auto& qualifier = qualifiers[i];
       CEL_RETURN_IF_ERROR(
@@ -1531,6 +1606,12 @@ class ParsedProtoStructValueInterface
   virtual const google::protobuf::Message& message() const = 0;
 
  protected:
+  // Returns the owner of the memory of `message()`, which values aliasing
+  // parts of it keep alive. Values viewing a part of another message return
+  // the owner of that message, so that deep selects refer to the root rather
+  // than to a chain of intermediate values.
+  virtual Shared<const void> owner() const { return shared_from_this(); }
+
   Type GetTypeImpl(TypeManager& type_manager) const final {
     return type_manager.CreateStructType(message().GetTypeName());
   }
@@ -1545,7 +1626,7 @@ class ParsedProtoStructValueInterface
       const auto& rhs_message = parsed_proto_struct_value->message();
       if (lhs_message.GetDescriptor() == rhs_message.GetDescriptor()) {
         return BoolValueView{
-            google::protobuf::util::MessageDifferencer::Equals(lhs_message, rhs_message)};
+            cel::internal::ProtoMessageEquals(lhs_message, rhs_message)};
       }
     }
     return ParsedStructValueInterface::EqualImpl(value_manager, other, scratch);
@@ -1568,10 +1649,46 @@ class ParsedProtoStructValueInterface
       ValueManager& value_manager,
       absl::Nonnull<const google::protobuf::FieldDescriptor*> field_desc, Value& scratch,
       ProtoWrapperTypeOptions unboxing_options) const {
-    return ProtoFieldToValue(shared_from_this(), &message(),
-                             message().GetReflection(), field_desc,
-                             value_manager, scratch, unboxing_options);
+    const auto* reflection = message().GetReflection();
+    if (field_desc->is_repeated() ||
+        field_desc->cpp_type() !=
+            google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE ||
+        field_desc->message_type()->well_known_type() !=
+            google::protobuf::Descriptor::WELLKNOWNTYPE_ANY ||
+        !reflection->HasField(message(), field_desc) ||
+        !CanRetain(value_manager)) {
+      return ProtoFieldToValue(owner(), &message(), reflection, field_desc,
+                               value_manager, scratch, unboxing_options);
+    }
+    // Unpacking `google.protobuf.Any` parses its payload, so the result is
+    // kept for later accesses, keyed by the address of the `Any`.
+    const google::protobuf::Message* any =
+        &reflection->GetMessage(message(), field_desc);
+    {
+      absl::MutexLock lock(&unpacked_any_mutex_);
+      if (auto it = unpacked_any_.find(any); it != unpacked_any_.end()) {
+        scratch = it->second;
+        return scratch;
+      }
+    }
+    CEL_ASSIGN_OR_RETURN(
+        auto value, ProtoFieldToValue(owner(), &message(), reflection,
+                                      field_desc, value_manager, scratch,
+                                      unboxing_options));
+    if (!InstanceOf<ErrorValueView>(value)) {
+      absl::MutexLock lock(&unpacked_any_mutex_);
+      unpacked_any_.try_emplace(any, value);
+    }
+    return value;
   }
+
+  // Returns whether values created by `value_manager` live at least as long as
+  // this value, so that it may retain them.
+  virtual bool CanRetain(ValueManager& value_manager) const { return false; }
+
+  mutable absl::Mutex unpacked_any_mutex_;
+  mutable absl::flat_hash_map<const google::protobuf::Message*, Value>
+      unpacked_any_ ABSL_GUARDED_BY(unpacked_any_mutex_);
 };
 
 const ParsedProtoStructValueInterface* AsParsedProtoStructValue(
@@ -1586,14 +1703,22 @@ const ParsedProtoStructValueInterface* AsParsedProtoStructValue(
 class PooledParsedProtoStructValueInterface final
     : public ParsedProtoStructValueInterface {
  public:
-  explicit PooledParsedProtoStructValueInterface(
-      absl::Nonnull<const google::protobuf::Message*> message)
-      : message_(message) {}
+  // `arena` is the arena this value is allocated on, if any.
+  PooledParsedProtoStructValueInterface(
+      absl::Nonnull<const google::protobuf::Message*> message,
+      absl::Nullable<google::protobuf::Arena*> arena)
+      : message_(message), arena_(arena) {}
 
   const google::protobuf::Message& message() const override { return *message_; }
 
  private:
+  bool CanRetain(ValueManager& value_manager) const override {
+    return arena_ != nullptr &&
+           ProtoMemoryManagerArena(value_manager.GetMemoryManager()) == arena_;
+  }
+
   absl::Nonnull<const google::protobuf::Message*> message_;
+  absl::Nullable<google::protobuf::Arena*> arena_;
 };
 
 class AliasingParsedProtoStructValueInterface final
@@ -1605,6 +1730,9 @@ class AliasingParsedProtoStructValueInterface final
 
   const google::protobuf::Message& message() const override { return *message_; }
 
+ protected:
+  Shared<const void> owner() const override { return alias_; }
+
  private:
   absl::Nonnull<const google::protobuf::Message*> message_;
   Shared<const void> alias_;
@@ -1632,6 +1760,11 @@ class ReffedStaticParsedProtoStructValueInterface final
   }
 
  private:
+  bool CanRetain(ValueManager& value_manager) const override {
+    return value_manager.GetMemoryManager().memory_management() ==
+           MemoryManagement::kReferenceCounting;
+  }
+
   void Finalize() noexcept override {
     reinterpret_cast<google::protobuf::MessageLite*>(reinterpret_cast<char*>(this) +
                                            MessageOffset())
@@ -1661,6 +1794,11 @@ class ReffedDynamicParsedProtoStructValueInterface final
   const google::protobuf::Message& message() const override { return *message_; }
 
  private:
+  bool CanRetain(ValueManager& value_manager) const override {
+    return value_manager.GetMemoryManager().memory_management() ==
+           MemoryManagement::kReferenceCounting;
+  }
+
   void Finalize() noexcept override { delete message_; }
 
   void Delete() noexcept override { delete this; }
@@ -1668,6 +1806,315 @@ class ReffedDynamicParsedProtoStructValueInterface final
   absl::Nonnull<const google::protobuf::Message*> message_;
 };
 
+// `ParsedStructValueInterface` backed by the serialized form of a message.
+//
+// The offsets of each tag are indexed on the first field access, after which
+// only the fields that are accessed are decoded. Decoded fields are merged into
+// a partial message which is retained, on the arena when there is one, so
+// repeated accesses do not decode again. Operations that need the whole
+// message, such as equality or JSON conversion, parse it in full once.
+class LazyParsedProtoStructValueInterface final
+    : public ParsedStructValueInterface,
+      public EnableSharedFromThis<LazyParsedProtoStructValueInterface> {
+ public:
+  LazyParsedProtoStructValueInterface(
+      absl::Nonnull<const google::protobuf::Message*> prototype, absl::Cord serialized,
+      absl::Nullable<google::protobuf::Arena*> arena)
+      : prototype_(prototype),
+        serialized_(std::move(serialized)),
+        arena_(arena) {}
+
+  absl::string_view GetTypeName() const override {
+    return prototype_->GetDescriptor()->full_name();
+  }
+
+  std::string DebugString() const override {
+    auto message = FullMessage();
+    if (!message.ok()) {
+      return message.status().ToString();
+    }
+    return (*message)->DebugString();
+  }
+
+  absl::StatusOr<size_t> GetSerializedSize(AnyToJsonConverter&) const override {
+    return serialized_.size();
+  }
+
+  absl::Status SerializeTo(AnyToJsonConverter&,
+                           absl::Cord& value) const override {
+    value.Append(serialized_);
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<std::string> GetTypeUrl(
+      absl::string_view prefix) const override {
+    return MakeTypeUrlWithPrefix(prefix, GetTypeName());
+  }
+
+  absl::StatusOr<Json> ConvertToJson(
+      AnyToJsonConverter& value_manager) const override {
+    CEL_ASSIGN_OR_RETURN(auto message, FullMessage());
+    return ProtoMessageToJson(value_manager, *message);
+  }
+
+  bool IsZeroValue() const override {
+    if (serialized_.empty()) {
+      return true;
+    }
+    auto message = FullMessage();
+    return message.ok() && (*message)->ByteSizeLong() == 0;
+  }
+
+  absl::StatusOr<ValueView> GetFieldByName(
+      ValueManager& value_manager, absl::string_view name, Value& scratch,
+      ProtoWrapperTypeOptions unboxing_options) const override {
+    const auto* desc = prototype_->GetDescriptor();
+    const auto* field_desc = desc->FindFieldByName(name);
+    if (ABSL_PREDICT_FALSE(field_desc == nullptr)) {
+      field_desc = prototype_->GetReflection()->FindKnownExtensionByName(name);
+      if (ABSL_PREDICT_FALSE(field_desc == nullptr)) {
+        scratch = NoSuchFieldError(name);
+        return scratch;
+      }
+    }
+    return GetField(value_manager, field_desc, scratch, unboxing_options);
+  }
+
+  absl::StatusOr<ValueView> GetFieldByNumber(
+      ValueManager& value_manager, int64_t number, Value& scratch,
+      ProtoWrapperTypeOptions unboxing_options) const override {
+    if (!IsValidFieldNumber(number)) {
+      scratch = NoSuchFieldError(absl::StrCat(number));
+      return scratch;
+    }
+    const auto* desc = prototype_->GetDescriptor();
+    const auto* field_desc = desc->FindFieldByNumber(static_cast<int>(number));
+    if (ABSL_PREDICT_FALSE(field_desc == nullptr)) {
+      scratch = NoSuchFieldError(absl::StrCat(number));
+      return scratch;
+    }
+    return GetField(value_manager, field_desc, scratch, unboxing_options);
+  }
+
+  absl::StatusOr<bool> HasFieldByName(absl::string_view name) const override {
+    const auto* desc = prototype_->GetDescriptor();
+    const auto* field_desc = desc->FindFieldByName(name);
+    if (ABSL_PREDICT_FALSE(field_desc == nullptr)) {
+      field_desc = prototype_->GetReflection()->FindKnownExtensionByName(name);
+      if (ABSL_PREDICT_FALSE(field_desc == nullptr)) {
+        return NoSuchFieldError(name).NativeValue();
+      }
+    }
+    return HasField(field_desc);
+  }
+
+  absl::StatusOr<bool> HasFieldByNumber(int64_t number) const override {
+    if (!IsValidFieldNumber(number)) {
+      return NoSuchFieldError(absl::StrCat(number)).NativeValue();
+    }
+    const auto* desc = prototype_->GetDescriptor();
+    const auto* field_desc = desc->FindFieldByNumber(static_cast<int>(number));
+    if (ABSL_PREDICT_FALSE(field_desc == nullptr)) {
+      return NoSuchFieldError(absl::StrCat(number)).NativeValue();
+    }
+    return HasField(field_desc);
+  }
+
+  absl::Status ForEachField(ValueManager& value_manager,
+                            ForEachFieldCallback callback) const override {
+    // The full message is never modified once parsed, so it can be read
+    // without holding the lock.
+    CEL_ASSIGN_OR_RETURN(auto message, FullMessage());
+    std::vector<const google::protobuf::FieldDescriptor*> fields;
+    const auto* reflection = message->GetReflection();
+    reflection->ListFields(*message, &fields);
+    Value value_scratch;
+    for (const auto* field : fields) {
+      CEL_ASSIGN_OR_RETURN(
+          auto value,
+          ProtoFieldToValue(shared_from_this(), message, reflection, field,
+                            value_manager, value_scratch,
+                            ProtoWrapperTypeOptions::kUnsetProtoDefault));
+      CEL_ASSIGN_OR_RETURN(auto ok, callback(field->name(), value));
+      if (!ok) {
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ protected:
+  Type GetTypeImpl(TypeManager& type_manager) const override {
+    return type_manager.CreateStructType(GetTypeName());
+  }
+
+ private:
+  // Half open byte range of `serialized_` holding one or more consecutive
+  // tag/value pairs.
+  struct FieldSpan {
+    size_t begin;
+    size_t end;
+  };
+
+  absl::StatusOr<ValueView> EqualImpl(ValueManager& value_manager,
+                                      ParsedStructValueView other,
+                                      Value& scratch) const override {
+    if (const auto* parsed_proto_struct_value = AsParsedProtoStructValue(other);
+        parsed_proto_struct_value) {
+      const auto& rhs_message = parsed_proto_struct_value->message();
+      if (prototype_->GetDescriptor() == rhs_message.GetDescriptor()) {
+        CEL_ASSIGN_OR_RETURN(auto lhs_message, FullMessage());
+        return BoolValueView{
+            cel::internal::ProtoMessageEquals(*lhs_message, rhs_message)};
+      }
+    }
+    return ParsedStructValueInterface::EqualImpl(value_manager, other, scratch);
+  }
+
+  NativeTypeId GetNativeTypeId() const override {
+    return NativeTypeId::For<LazyParsedProtoStructValueInterface>();
+  }
+
+  absl::StatusOr<bool> HasField(
+      absl::Nonnull<const google::protobuf::FieldDescriptor*> field_desc) const {
+    absl::MutexLock lock(&mutex_);
+    CEL_ASSIGN_OR_RETURN(auto message, DecodeField(field_desc));
+    const auto* reflect = message->GetReflection();
+    if (field_desc->is_map() || field_desc->is_repeated()) {
+      return reflect->FieldSize(*message, field_desc) > 0;
+    }
+    return reflect->HasField(*message, field_desc);
+  }
+
+  absl::StatusOr<ValueView> GetField(
+      ValueManager& value_manager,
+      absl::Nonnull<const google::protobuf::FieldDescriptor*> field_desc, Value& scratch,
+      ProtoWrapperTypeOptions unboxing_options) const {
+    // Values referencing the partial message only reference the storage of
+    // `field_desc`, which is not modified by decoding other fields. The lock
+    // is held for the conversion itself as it reads presence information that
+    // is shared between fields.
+    absl::MutexLock lock(&mutex_);
+    CEL_ASSIGN_OR_RETURN(auto message, DecodeField(field_desc));
+    return ProtoFieldToValue(shared_from_this(), message,
+                             message->GetReflection(), field_desc,
+                             value_manager, scratch, unboxing_options);
+  }
+
+  // Members of a oneof must be decoded together, so that the last one present
+  // on the wire wins as it would when parsing the whole message.
+  static int FieldKey(
+      absl::Nonnull<const google::protobuf::FieldDescriptor*> field_desc) {
+    if (const auto* oneof = field_desc->containing_oneof(); oneof != nullptr) {
+      return -1 - oneof->index();
+    }
+    return field_desc->number();
+  }
+
+  ArenaUniquePtr<google::protobuf::Message> NewMessage() const {
+    return ArenaUniquePtr<google::protobuf::Message>(prototype_->New(arena_),
+                                           DefaultArenaDeleter{arena_});
+  }
+
+  // Records the byte ranges of each field. Returns `false` if the message
+  // uses groups or is malformed, in which case it is parsed in full instead.
+  bool BuildIndex() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    const auto* desc = prototype_->GetDescriptor();
+    absl::Cord data = serialized_;
+    while (!data.empty()) {
+      const size_t begin = serialized_.size() - data.size();
+      auto tag = internal::VarintDecode<uint32_t>(data);
+      if (ABSL_PREDICT_FALSE(!tag.has_value())) {
+        return false;
+      }
+      auto field = internal::DecodeProtoWireTag(tag->value);
+      if (ABSL_PREDICT_FALSE(!field.has_value())) {
+        return false;
+      }
+      data.RemovePrefix(tag->size_bytes);
+      if (ABSL_PREDICT_FALSE(!internal::SkipLengthValue(data, field->type()))) {
+        return false;
+      }
+      const size_t end = serialized_.size() - data.size();
+      const auto* field_desc =
+          desc->FindFieldByNumber(static_cast<int>(field->field_number()));
+      auto& spans = index_[field_desc != nullptr
+                               ? FieldKey(field_desc)
+                               : static_cast<int>(field->field_number())];
+      if (!spans.empty() && spans.back().end == begin) {
+        // Coalesce consecutive occurrences, i.e. unpacked repeated fields.
+        spans.back().end = end;
+      } else {
+        spans.push_back(FieldSpan{begin, end});
+      }
+    }
+    return true;
+  }
+
+  absl::StatusOr<absl::Nonnull<const google::protobuf::Message*>> DecodeField(
+      absl::Nonnull<const google::protobuf::FieldDescriptor*> field_desc) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (full_ != nullptr) {
+      return full_.get();
+    }
+    if (!indexed_) {
+      indexed_ = true;
+      index_ok_ = BuildIndex();
+    }
+    if (!index_ok_) {
+      return FullMessageLocked();
+    }
+    if (partial_ == nullptr) {
+      partial_ = NewMessage();
+    }
+    const int key = FieldKey(field_desc);
+    if (auto it = index_.find(key); it != index_.end()) {
+      absl::Cord field_data;
+      for (const auto& span : it->second) {
+        field_data.Append(
+            serialized_.Subcord(span.begin, span.end - span.begin));
+      }
+      if (!partial_->MergePartialFromCord(field_data)) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("failed to parse `", GetTypeName(), "`"));
+      }
+      // Absent from the index means the field has already been decoded or is
+      // not present on the wire, either way there is nothing left to do.
+      index_.erase(it);
+    }
+    return partial_.get();
+  }
+
+  absl::StatusOr<absl::Nonnull<const google::protobuf::Message*>> FullMessage() const {
+    absl::MutexLock lock(&mutex_);
+    return FullMessageLocked();
+  }
+
+  absl::StatusOr<absl::Nonnull<const google::protobuf::Message*>> FullMessageLocked()
+      const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (full_ == nullptr) {
+      auto message = NewMessage();
+      if (!message->ParsePartialFromCord(serialized_)) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("failed to parse `", GetTypeName(), "`"));
+      }
+      full_ = std::move(message);
+    }
+    return full_.get();
+  }
+
+  absl::Nonnull<const google::protobuf::Message*> const prototype_;
+  const absl::Cord serialized_;
+  absl::Nullable<google::protobuf::Arena*> const arena_;
+  mutable absl::Mutex mutex_;
+  mutable bool indexed_ ABSL_GUARDED_BY(mutex_) = false;
+  mutable bool index_ok_ ABSL_GUARDED_BY(mutex_) = false;
+  mutable absl::flat_hash_map<int, absl::InlinedVector<FieldSpan, 1>> index_
+      ABSL_GUARDED_BY(mutex_);
+  mutable ArenaUniquePtr<google::protobuf::Message> partial_ ABSL_GUARDED_BY(mutex_);
+  mutable ArenaUniquePtr<google::protobuf::Message> full_ ABSL_GUARDED_BY(mutex_);
+};
+
 void ProtoMessageDestruct(void* object) {
   static_cast<google::protobuf::Message*>(object)->~Message();
 }
@@ -1908,7 +2355,7 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
     auto* copied_message = (*arena_copy_construct)(arena, message);
     return ParsedStructValue{
         memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-            copied_message)};
+            copied_message, ProtoMemoryManagerArena(memory_manager))};
   }
   switch (memory_manager.memory_management()) {
     case MemoryManagement::kPooling: {
@@ -1917,7 +2364,7 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
       memory_manager.OwnCustomDestructor(copied_message, &ProtoMessageDestruct);
       return ParsedStructValue{
           memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-              copied_message)};
+              copied_message, ProtoMemoryManagerArena(memory_manager))};
     }
     case MemoryManagement::kReferenceCounting: {
       auto* block = static_cast<char*>(memory_manager.Allocate(
@@ -1956,7 +2403,7 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
     auto* moved_message = (*arena_move_construct)(arena, message);
     return ParsedStructValue{
         memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-            moved_message)};
+            moved_message, ProtoMemoryManagerArena(memory_manager))};
   }
   switch (memory_manager.memory_management()) {
     case MemoryManagement::kPooling: {
@@ -1965,7 +2412,7 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
       memory_manager.OwnCustomDestructor(moved_message, &ProtoMessageDestruct);
       return ParsedStructValue{
           memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-              moved_message)};
+              moved_message, ProtoMemoryManagerArena(memory_manager))};
     }
     case MemoryManagement::kReferenceCounting: {
       auto* block = static_cast<char*>(memory_manager.Allocate(
@@ -1988,6 +2435,27 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
 absl::StatusOr<Value> ProtoMessageToValueImpl(
     ValueManager& value_manager, Shared<const void> aliased,
     absl::Nonnull<const google::protobuf::Message*> message) {
+  if (aliased || value_manager.GetMemoryManager().memory_management() ==
+                     MemoryManagement::kPooling) {
+    // The lifetime of `message` is already managed, so generated JSON messages
+    // can be viewed in place instead of being converted up front.
+    const auto* desc = message->GetDescriptor();
+    if (desc == google::protobuf::Struct::descriptor()) {
+      return GeneratedStructProtoAsMapValue(
+          value_manager, std::move(aliased),
+          google::protobuf::DownCastToGenerated<google::protobuf::Struct>(*message));
+    }
+    if (desc == google::protobuf::ListValue::descriptor()) {
+      return GeneratedListValueProtoAsListValue(
+          value_manager, std::move(aliased),
+          google::protobuf::DownCastToGenerated<google::protobuf::ListValue>(*message));
+    }
+    if (desc == google::protobuf::Value::descriptor()) {
+      return GeneratedValueProtoAsValue(
+          value_manager, std::move(aliased),
+          google::protobuf::DownCastToGenerated<google::protobuf::Value>(*message));
+    }
+  }
   {
     CEL_ASSIGN_OR_RETURN(auto well_known,
                          WellKnownProtoMessageToValue(value_manager, message));
@@ -1998,13 +2466,13 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
   auto memory_manager = value_manager.GetMemoryManager();
   switch (memory_manager.memory_management()) {
     case MemoryManagement::kPooling: {
-      if (!aliased) {
+      if (!aliased || common_internal::GetReferenceCount(aliased) == nullptr) {
         // `message` is indirectly owned by something on an arena. The user is
         // responsible for ensuring they are the same arena or that `message`
         // outlives the resulting value.
         return ParsedStructValue{
             memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-                message)};
+                message, ProtoMemoryManagerArena(memory_manager))};
       }
       // `message` is indirectly owned by something reference counted. The
       // destructor of the implementation will decrement the reference count.
@@ -2304,6 +2772,18 @@ absl::Status ProtoMessageFromValueImpl(
     return ProtoMessageCopy(message, to_desc,
                             &parsed_proto_struct_value->message());
   }
+  if (value.kind() == ValueKind::kStruct &&
+      value.GetTypeName() == to_desc->full_name()) {
+    // Other struct values of the same type, such as lazily parsed messages,
+    // are copied through their serialized form.
+    ProtoAnyToJsonConverter converter(pool, factory);
+    CEL_ASSIGN_OR_RETURN(auto serialized, value.Serialize(converter));
+    if (!message->ParsePartialFromCord(serialized)) {
+      return absl::UnknownError(
+          absl::StrCat("failed to parse `", to_desc->full_name(), "`"));
+    }
+    return absl::OkStatus();
+  }
 
   return TypeConversionError(value.GetTypeName(), message->GetTypeName())
       .NativeValue();
@@ -2333,7 +2813,7 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
     case MemoryManagement::kPooling:
       return ParsedStructValue{
           memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-              message.release())};
+              message.release(), ProtoMemoryManagerArena(memory_manager))};
     case MemoryManagement::kReferenceCounting:
       return ParsedStructValue{
           memory_manager
@@ -2342,6 +2822,31 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
   }
 }
 
+absl::StatusOr<Value> ProtoMessageToLazyValueImpl(
+    ValueManager& value_manager,
+    absl::Nonnull<const google::protobuf::Message*> prototype, absl::Cord serialized) {
+  return ProtoMessageToLazyValueImpl(value_manager,
+                                     value_manager.type_provider(), prototype,
+                                     std::move(serialized));
+}
+
+absl::StatusOr<Value> ProtoMessageToLazyValueImpl(
+    ValueFactory& value_factory, const TypeReflector& type_reflector,
+    absl::Nonnull<const google::protobuf::Message*> prototype, absl::Cord serialized) {
+  if (prototype->GetDescriptor()->well_known_type() !=
+      google::protobuf::Descriptor::WELLKNOWNTYPE_UNSPECIFIED) {
+    // Well known types are converted to their CEL equivalents, which requires
+    // the whole message anyway.
+    return ProtoMessageToValueImpl(value_factory, type_reflector, prototype,
+                                   serialized);
+  }
+  auto memory_manager = value_factory.GetMemoryManager();
+  return ParsedStructValue{
+      memory_manager.MakeShared<LazyParsedProtoStructValueInterface>(
+          prototype, std::move(serialized),
+          ProtoMemoryManagerArena(memory_manager))};
+}
+
 StructValue ProtoMessageAsStructValueImpl(
     ValueFactory& value_factory, absl::Nonnull<google::protobuf::Message*> message) {
   auto memory_manager = value_factory.GetMemoryManager();
@@ -2349,7 +2854,7 @@ StructValue ProtoMessageAsStructValueImpl(
     case MemoryManagement::kPooling:
       return ParsedStructValue{
           memory_manager.MakeShared<PooledParsedProtoStructValueInterface>(
-              message)};
+              message, ProtoMemoryManagerArena(memory_manager))};
     case MemoryManagement::kReferenceCounting:
       return ParsedStructValue{
           memory_manager
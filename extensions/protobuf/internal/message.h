@@ -23,6 +23,7 @@
 #include "absl/base/nullability.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "common/memory.h"
 #include "common/value.h"
 #include "common/value_manager.h"
@@ -141,6 +142,17 @@ absl::StatusOr<Value> ProtoMessageToValueImpl(
     absl::Nonnull<const google::protobuf::Message*> prototype,
     const absl::Cord& serialized);
 
+// Adapts a serialized protocol buffer message to a value without parsing it
+// up front. Fields are decoded individually on first access. `prototype`
+// should be the prototype message returned from the message factory. Well known
+// types are parsed eagerly.
+absl::StatusOr<Value> ProtoMessageToLazyValueImpl(
+    ValueManager& value_manager,
+    absl::Nonnull<const google::protobuf::Message*> prototype, absl::Cord serialized);
+absl::StatusOr<Value> ProtoMessageToLazyValueImpl(
+    ValueFactory& value_factory, const TypeReflector& type_reflector,
+    absl::Nonnull<const google::protobuf::Message*> prototype, absl::Cord serialized);
+
 // Converts a value to a protocol buffer message.
 absl::StatusOr<absl::Nonnull<google::protobuf::Message*>> ProtoMessageFromValueImpl(
     ValueView value, absl::Nonnull<const google::protobuf::DescriptorPool*> pool,
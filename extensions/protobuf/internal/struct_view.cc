@@ -0,0 +1,376 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/protobuf/internal/struct_view.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/variant.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "extensions/protobuf/internal/struct_lite.h"
+#include "internal/status_macros.h"
+
+namespace cel::extensions::protobuf_internal {
+
+namespace {
+
+void AppendDebugString(const google::protobuf::Value& message,
+                       std::string& out);
+
+void AppendDebugString(const google::protobuf::Struct& message,
+                       std::string& out) {
+  out.push_back('{');
+  bool first = true;
+  for (const auto& field : message.fields()) {
+    if (!first) {
+      out.append(", ");
+    }
+    first = false;
+    out.append(StringValueView(field.first).DebugString());
+    out.append(": ");
+    AppendDebugString(field.second, out);
+  }
+  out.push_back('}');
+}
+
+void AppendDebugString(const google::protobuf::ListValue& message,
+                       std::string& out) {
+  out.push_back('[');
+  bool first = true;
+  for (const auto& element : message.values()) {
+    if (!first) {
+      out.append(", ");
+    }
+    first = false;
+    AppendDebugString(element, out);
+  }
+  out.push_back(']');
+}
+
+void AppendDebugString(const google::protobuf::Value& message,
+                       std::string& out) {
+  switch (message.kind_case()) {
+    case google::protobuf::Value::kBoolValue:
+      out.append(BoolValueView(message.bool_value()).DebugString());
+      break;
+    case google::protobuf::Value::kNumberValue:
+      out.append(DoubleValueView(message.number_value()).DebugString());
+      break;
+    case google::protobuf::Value::kStringValue:
+      out.append(StringValueView(message.string_value()).DebugString());
+      break;
+    case google::protobuf::Value::kStructValue:
+      AppendDebugString(message.struct_value(), out);
+      break;
+    case google::protobuf::Value::kListValue:
+      AppendDebugString(message.list_value(), out);
+      break;
+    default:
+      out.append(NullValueView().DebugString());
+      break;
+  }
+}
+
+// Adapts `message`, storing the result in `scratch` if it cannot be returned
+// as a view.
+ValueView ValueProtoToValueView(ValueManager& value_manager,
+                                const Shared<const void>& aliased,
+                                const google::protobuf::Value& message,
+                                Value& scratch);
+
+class StructProtoKeyIterator final : public ValueIterator {
+ public:
+  StructProtoKeyIterator(Shared<const void> aliased,
+                         const google::protobuf::Struct& message)
+      : aliased_(std::move(aliased)),
+        begin_(message.fields().begin()),
+        end_(message.fields().end()) {}
+
+  bool HasNext() override { return begin_ != end_; }
+
+  absl::StatusOr<ValueView> Next(ValueManager&, Value&) override {
+    if (ABSL_PREDICT_FALSE(begin_ == end_)) {
+      return absl::FailedPreconditionError(
+          "ValueIterator::Next() called when "
+          "ValueIterator::HasNext() returns false");
+    }
+    StringValueView key(begin_->first);
+    ++begin_;
+    return key;
+  }
+
+ private:
+  using const_iterator =
+      google::protobuf::Map<std::string, google::protobuf::Value>::const_iterator;
+
+  // Keeps the message alive for as long as the iterator is.
+  Shared<const void> aliased_;
+  const_iterator begin_;
+  const_iterator end_;
+};
+
+class StructProtoMapValueInterface final
+    : public ParsedMapValueInterface,
+      public EnableSharedFromThis<StructProtoMapValueInterface> {
+ public:
+  StructProtoMapValueInterface(Shared<const void> aliased,
+                               const google::protobuf::Struct& message)
+      : aliased_(std::move(aliased)), message_(message) {}
+
+  std::string DebugString() const override {
+    std::string out;
+    AppendDebugString(message_, out);
+    return out;
+  }
+
+  absl::StatusOr<JsonObject> ConvertToJsonObject(
+      AnyToJsonConverter&) const override {
+    CEL_ASSIGN_OR_RETURN(auto json, GeneratedStructProtoToJson(message_));
+    return absl::get<JsonObject>(std::move(json));
+  }
+
+  bool IsEmpty() const override { return message_.fields().empty(); }
+
+  size_t Size() const override {
+    return static_cast<size_t>(message_.fields_size());
+  }
+
+  absl::StatusOr<ListValueView> ListKeys(ValueManager& value_manager,
+                                         ListValue& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto builder,
+                         value_manager.NewListValueBuilder(ListTypeView{}));
+    builder->Reserve(Size());
+    for (const auto& field : message_.fields()) {
+      CEL_RETURN_IF_ERROR(builder->Add(StringValue(field.first)));
+    }
+    scratch = std::move(*builder).Build();
+    return ListValueView{scratch};
+  }
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachCallback callback) const override {
+    Value value_scratch;
+    for (const auto& field : message_.fields()) {
+      CEL_ASSIGN_OR_RETURN(
+          auto ok,
+          callback(StringValueView(field.first),
+                   ValueProtoToValueView(value_manager, Alias(), field.second,
+                                         value_scratch)));
+      if (!ok) {
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<absl::Nonnull<ValueIteratorPtr>> NewIterator(
+      ValueManager&) const override {
+    return std::make_unique<StructProtoKeyIterator>(Alias(), message_);
+  }
+
+ private:
+  absl::StatusOr<absl::optional<ValueView>> FindImpl(
+      ValueManager& value_manager, ValueView key,
+      Value& scratch) const override {
+    auto string_key = As<StringValueView>(key);
+    if (!string_key.has_value()) {
+      return absl::nullopt;
+    }
+    auto it = message_.fields().find(string_key->NativeString());
+    if (it == message_.fields().end()) {
+      return absl::nullopt;
+    }
+    return ValueProtoToValueView(value_manager, Alias(), it->second, scratch);
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> FindStringImpl(
+      ValueManager& value_manager, absl::string_view key, size_t,
+      Value& scratch) const override {
+    auto it = message_.fields().find(key);
+    if (it == message_.fields().end()) {
+      return absl::nullopt;
+    }
+    return ValueProtoToValueView(value_manager, Alias(), it->second, scratch);
+  }
+
+  absl::StatusOr<bool> HasImpl(ValueManager&, ValueView key) const override {
+    auto string_key = As<StringValueView>(key);
+    if (!string_key.has_value()) {
+      return false;
+    }
+    return message_.fields().contains(string_key->NativeString());
+  }
+
+  NativeTypeId GetNativeTypeId() const override {
+    return NativeTypeId::For<StructProtoMapValueInterface>();
+  }
+
+  // Nested values keep the owner of the root message alive, rather than this
+  // value, when there is one.
+  Shared<const void> Alias() const {
+    if (aliased_) {
+      return aliased_;
+    }
+    return shared_from_this();
+  }
+
+  Shared<const void> aliased_;
+  const google::protobuf::Struct& message_;
+};
+
+class ListValueProtoListValueInterface final
+    : public ParsedListValueInterface,
+      public EnableSharedFromThis<ListValueProtoListValueInterface> {
+ public:
+  ListValueProtoListValueInterface(Shared<const void> aliased,
+                                   const google::protobuf::ListValue& message)
+      : aliased_(std::move(aliased)), message_(message) {}
+
+  std::string DebugString() const override {
+    std::string out;
+    AppendDebugString(message_, out);
+    return out;
+  }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter&) const override {
+    CEL_ASSIGN_OR_RETURN(auto json, GeneratedListValueProtoToJson(message_));
+    return absl::get<JsonArray>(std::move(json));
+  }
+
+  bool IsEmpty() const override { return message_.values().empty(); }
+
+  size_t Size() const override {
+    return static_cast<size_t>(message_.values_size());
+  }
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachWithIndexCallback callback) const override {
+    Value element_scratch;
+    const size_t size = Size();
+    for (size_t index = 0; index < size; ++index) {
+      CEL_ASSIGN_OR_RETURN(
+          auto ok, callback(index, ValueProtoToValueView(
+                                       value_manager, Alias(),
+                                       message_.values(static_cast<int>(index)),
+                                       element_scratch)));
+      if (!ok) {
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  using ParsedListValueInterface::ForEach;
+
+ private:
+  absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
+                                    Value& scratch) const override {
+    return ValueProtoToValueView(value_manager, Alias(),
+                                 message_.values(static_cast<int>(index)),
+                                 scratch);
+  }
+
+  NativeTypeId GetNativeTypeId() const override {
+    return NativeTypeId::For<ListValueProtoListValueInterface>();
+  }
+
+  Shared<const void> Alias() const {
+    if (aliased_) {
+      return aliased_;
+    }
+    return shared_from_this();
+  }
+
+  Shared<const void> aliased_;
+  const google::protobuf::ListValue& message_;
+};
+
+ValueView ValueProtoToValueView(ValueManager& value_manager,
+                                const Shared<const void>& aliased,
+                                const google::protobuf::Value& message,
+                                Value& scratch) {
+  switch (message.kind_case()) {
+    case google::protobuf::Value::kBoolValue:
+      return BoolValueView{message.bool_value()};
+    case google::protobuf::Value::kNumberValue:
+      return DoubleValueView{message.number_value()};
+    case google::protobuf::Value::kStringValue:
+      return StringValueView{message.string_value()};
+    case google::protobuf::Value::kStructValue:
+      scratch = GeneratedStructProtoAsMapValue(value_manager, aliased,
+                                               message.struct_value());
+      return scratch;
+    case google::protobuf::Value::kListValue:
+      scratch = GeneratedListValueProtoAsListValue(value_manager, aliased,
+                                                   message.list_value());
+      return scratch;
+    default:
+      // Unset is treated as null, the same as when converting to JSON.
+      return NullValueView{};
+  }
+}
+
+}  // namespace
+
+MapValue GeneratedStructProtoAsMapValue(ValueManager& value_manager,
+                                        Shared<const void> aliased,
+                                        const google::protobuf::Struct& message) {
+  return ParsedMapValue{
+      value_manager.GetMemoryManager().MakeShared<StructProtoMapValueInterface>(
+          std::move(aliased), message)};
+}
+
+ListValue GeneratedListValueProtoAsListValue(
+    ValueManager& value_manager, Shared<const void> aliased,
+    const google::protobuf::ListValue& message) {
+  return ParsedListValue{value_manager.GetMemoryManager()
+                             .MakeShared<ListValueProtoListValueInterface>(
+                                 std::move(aliased), message)};
+}
+
+Value GeneratedValueProtoAsValue(ValueManager& value_manager,
+                                 Shared<const void> aliased,
+                                 const google::protobuf::Value& message) {
+  switch (message.kind_case()) {
+    case google::protobuf::Value::kStructValue:
+      return GeneratedStructProtoAsMapValue(value_manager, std::move(aliased),
+                                            message.struct_value());
+    case google::protobuf::Value::kListValue:
+      return GeneratedListValueProtoAsListValue(
+          value_manager, std::move(aliased), message.list_value());
+    default: {
+      Value scratch;
+      return Value(
+          ValueProtoToValueView(value_manager, aliased, message, scratch));
+    }
+  }
+}
+
+}  // namespace cel::extensions::protobuf_internal
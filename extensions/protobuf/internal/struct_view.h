@@ -0,0 +1,53 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Adapters presenting the generated `google.protobuf.Struct`,
+// `google.protobuf.ListValue` and `google.protobuf.Value` messages as CEL
+// values without converting them.
+
+#ifndef THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_INTERNAL_STRUCT_VIEW_H_
+#define THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_INTERNAL_STRUCT_VIEW_H_
+
+#include "google/protobuf/struct.pb.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel::extensions::protobuf_internal {
+
+// Returns a map value referencing `message`. Key lookups go directly to the
+// underlying map field and only the entries that are accessed are adapted.
+//
+// `aliased` is the owner of `message`. It may be empty, in which case the
+// caller is responsible for ensuring `message` outlives the result.
+MapValue GeneratedStructProtoAsMapValue(ValueManager& value_manager,
+                                        Shared<const void> aliased,
+                                        const google::protobuf::Struct& message);
+
+// Returns a list value referencing `message`. See
+// `GeneratedStructProtoAsMapValue` for the meaning of `aliased`.
+ListValue GeneratedListValueProtoAsListValue(
+    ValueManager& value_manager, Shared<const void> aliased,
+    const google::protobuf::ListValue& message);
+
+// Returns the value held by `message`, with structs and lists referencing
+// `message`. See `GeneratedStructProtoAsMapValue` for the meaning of
+// `aliased`.
+Value GeneratedValueProtoAsValue(ValueManager& value_manager,
+                                 Shared<const void> aliased,
+                                 const google::protobuf::Value& message);
+
+}  // namespace cel::extensions::protobuf_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_INTERNAL_STRUCT_VIEW_H_
@@ -0,0 +1,155 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/protobuf/internal/struct_view.h"
+
+#include <utility>
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/types/variant.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "internal/testing.h"
+
+namespace cel::extensions::protobuf_internal {
+namespace {
+
+using ::cel::test::BoolValueIs;
+using ::cel::test::DoubleValueIs;
+using ::cel::test::StringValueIs;
+using testing::Eq;
+using testing::Pair;
+using cel::internal::IsOkAndHolds;
+
+class StructViewTest : public common_internal::ThreadCompatibleValueTest<> {
+ protected:
+  google::protobuf::Struct MakeStruct() {
+    google::protobuf::Struct message;
+    auto& fields = *message.mutable_fields();
+    fields["name"].set_string_value("foo");
+    fields["count"].set_number_value(2);
+    fields["enabled"].set_bool_value(true);
+    fields["nothing"].set_null_value(google::protobuf::NULL_VALUE);
+    auto& nested = *fields["nested"].mutable_struct_value()->mutable_fields();
+    nested["inner"].set_string_value("bar");
+    auto* list = fields["list"].mutable_list_value();
+    list->add_values()->set_number_value(1);
+    list->add_values()->set_string_value("two");
+    return message;
+  }
+};
+
+TEST_P(StructViewTest, Find) {
+  google::protobuf::Struct message = MakeStruct();
+  MapValue map = GeneratedStructProtoAsMapValue(
+      value_manager(), Shared<const void>(), message);
+
+  EXPECT_THAT(map.Size(), IsOkAndHolds(Eq(6)));
+  EXPECT_THAT(map.Find(value_manager(), StringValue("name")),
+              IsOkAndHolds(Pair(StringValueIs("foo"), true)));
+  EXPECT_THAT(map.Find(value_manager(), StringValue("count")),
+              IsOkAndHolds(Pair(DoubleValueIs(2), true)));
+  EXPECT_THAT(map.Find(value_manager(), StringValue("enabled")),
+              IsOkAndHolds(Pair(BoolValueIs(true), true)));
+  ASSERT_OK_AND_ASSIGN(auto nothing,
+                       map.Find(value_manager(), StringValue("nothing")));
+  EXPECT_TRUE(nothing.second);
+  EXPECT_TRUE(InstanceOf<NullValue>(nothing.first));
+  ASSERT_OK_AND_ASSIGN(auto missing,
+                       map.Find(value_manager(), StringValue("missing")));
+  EXPECT_FALSE(missing.second);
+  ASSERT_OK_AND_ASSIGN(auto wrong_key_type,
+                       map.Find(value_manager(), IntValue(1)));
+  EXPECT_FALSE(wrong_key_type.second);
+
+  EXPECT_THAT(map.Has(value_manager(), StringValue("name")),
+              IsOkAndHolds(BoolValueIs(true)));
+  EXPECT_THAT(map.Has(value_manager(), StringValue("missing")),
+              IsOkAndHolds(BoolValueIs(false)));
+}
+
+TEST_P(StructViewTest, Nested) {
+  google::protobuf::Struct message = MakeStruct();
+  MapValue map = GeneratedStructProtoAsMapValue(
+      value_manager(), Shared<const void>(), message);
+
+  ASSERT_OK_AND_ASSIGN(auto nested,
+                       map.Find(value_manager(), StringValue("nested")));
+  ASSERT_TRUE(nested.second);
+  ASSERT_TRUE(InstanceOf<MapValue>(nested.first));
+  EXPECT_THAT(Cast<MapValue>(nested.first)
+                  .Find(value_manager(), StringValue("inner")),
+              IsOkAndHolds(Pair(StringValueIs("bar"), true)));
+
+  ASSERT_OK_AND_ASSIGN(auto list,
+                       map.Find(value_manager(), StringValue("list")));
+  ASSERT_TRUE(list.second);
+  ASSERT_TRUE(InstanceOf<ListValue>(list.first));
+  ListValue list_value = Cast<ListValue>(list.first);
+  EXPECT_THAT(list_value.Size(), IsOkAndHolds(Eq(2)));
+  EXPECT_THAT(list_value.Get(value_manager(), 0),
+              IsOkAndHolds(DoubleValueIs(1)));
+  EXPECT_THAT(list_value.Get(value_manager(), 1),
+              IsOkAndHolds(StringValueIs("two")));
+}
+
+TEST_P(StructViewTest, ConvertToJson) {
+  google::protobuf::Struct message = MakeStruct();
+  MapValue map = GeneratedStructProtoAsMapValue(
+      value_manager(), Shared<const void>(), message);
+
+  ASSERT_OK_AND_ASSIGN(auto json, map.ConvertToJson(value_manager()));
+  ASSERT_TRUE(absl::holds_alternative<JsonObject>(json));
+  EXPECT_EQ(absl::get<JsonObject>(json).size(), 6);
+}
+
+TEST_P(StructViewTest, Iterate) {
+  google::protobuf::Struct message;
+  (*message.mutable_fields())["only"].set_string_value("value");
+  MapValue map = GeneratedStructProtoAsMapValue(
+      value_manager(), Shared<const void>(), message);
+
+  ASSERT_OK_AND_ASSIGN(auto iterator, map.NewIterator(value_manager()));
+  ASSERT_TRUE(iterator->HasNext());
+  EXPECT_THAT(iterator->Next(value_manager()),
+              IsOkAndHolds(StringValueIs("only")));
+  EXPECT_FALSE(iterator->HasNext());
+  EXPECT_EQ(map.DebugString(), "{\"only\": \"value\"}");
+}
+
+TEST_P(StructViewTest, Value) {
+  google::protobuf::Value message;
+  EXPECT_TRUE(InstanceOf<NullValue>(GeneratedValueProtoAsValue(
+      value_manager(), Shared<const void>(), message)));
+  message.set_number_value(1.5);
+  EXPECT_THAT(GeneratedValueProtoAsValue(value_manager(), Shared<const void>(),
+                                         message),
+              DoubleValueIs(1.5));
+  message.mutable_list_value()->add_values()->set_bool_value(false);
+  Value value = GeneratedValueProtoAsValue(value_manager(),
+                                           Shared<const void>(), message);
+  ASSERT_TRUE(InstanceOf<ListValue>(value));
+  EXPECT_THAT(Cast<ListValue>(value).Get(value_manager(), 0),
+              IsOkAndHolds(BoolValueIs(false)));
+}
+
+INSTANTIATE_TEST_SUITE_P(StructViewTest, StructViewTest,
+                         ::testing::Values(MemoryManagement::kReferenceCounting,
+                                           MemoryManagement::kPooling));
+
+}  // namespace
+}  // namespace cel::extensions::protobuf_internal
@@ -14,13 +14,16 @@
 
 #include "extensions/protobuf/memory_manager.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 #include "absl/base/nullability.h"
 #include "common/casting.h"
 #include "common/memory.h"
 #include "common/native_type.h"
+#include "internal/huge_pages.h"
 #include "google/protobuf/arena.h"
 
 namespace cel {
@@ -29,6 +32,11 @@ namespace extensions {
 
 namespace {
 
+using ::cel::internal::AllocateBlock;
+using ::cel::internal::DeallocateBlock;
+using ::cel::internal::HugePages;
+using ::cel::internal::HugePageSize;
+
 absl::Nonnull<void*> ProtoPoolingMemoryManagerAllocate(void* arena, size_t size,
                                                        size_t align) {
   return static_cast<google::protobuf::Arena*>(arena)->AllocateAligned(size, align);
@@ -69,6 +77,16 @@ class ProtoPoolingMemoryManager final : public PoolingMemoryManager {
   google::protobuf::Arena arena_;
 };
 
+template <HugePages kHugePages>
+void* AllocateArenaBlock(size_t size) {
+  return AllocateBlock(size, kHugePages);
+}
+
+template <HugePages kHugePages>
+void DeallocateArenaBlock(void* block, size_t size) {
+  DeallocateBlock(block, size, kHugePages);
+}
+
 const PoolingMemoryManagerVirtualTable& ProtoMemoryManagerVirtualTable() {
   static const PoolingMemoryManagerVirtualTable vtable{
       NativeTypeId::For<google::protobuf::Arena>(), &ProtoPoolingMemoryManagerAllocate,
@@ -123,6 +141,55 @@ absl::Nullable<google::protobuf::Arena*> ProtoMemoryManagerArena(
   return nullptr;
 }
 
+ReusableProtoArena::ReusableProtoArena(size_t initial_block_size,
+                                       size_t max_retained_size,
+                                       HugePages huge_pages)
+    : max_retained_size_(std::max(initial_block_size, max_retained_size)),
+      huge_pages_(HugePageSize() != 0 ? huge_pages : HugePages::kNone) {
+  InitArena(initial_block_size);
+}
+
+void ReusableProtoArena::InitArena(size_t initial_block_size) {
+  arena_.reset();
+  // Arena blocks are 8 byte aligned and sized.
+  initial_block_size_ = (initial_block_size + 7) & ~size_t{7};
+  if (huge_pages_ != HugePages::kNone &&
+      initial_block_size_ >= HugePageSize()) {
+    // Huge page blocks are mapped in whole pages, make use of all of it.
+    initial_block_size_ = (initial_block_size_ + HugePageSize() - 1) /
+                          HugePageSize() * HugePageSize();
+  }
+  initial_block_ = std::unique_ptr<char, BlockDeleter>(
+      static_cast<char*>(AllocateBlock(initial_block_size_, huge_pages_)),
+      BlockDeleter{initial_block_size_, huge_pages_});
+  google::protobuf::ArenaOptions options;
+  options.initial_block = initial_block_.get();
+  options.initial_block_size = initial_block_size_;
+  if (huge_pages_ != HugePages::kNone) {
+    // Grow up to blocks of one huge page, so that the blocks of large requests
+    // are backed by huge pages.
+    options.max_block_size = std::max(options.max_block_size, HugePageSize());
+    const bool transparent = huge_pages_ == HugePages::kTransparent;
+    options.block_alloc = transparent
+                              ? &AllocateArenaBlock<HugePages::kTransparent>
+                              : &AllocateArenaBlock<HugePages::kExplicit>;
+    options.block_dealloc = transparent
+                                ? &DeallocateArenaBlock<HugePages::kTransparent>
+                                : &DeallocateArenaBlock<HugePages::kExplicit>;
+  }
+  arena_.emplace(options);
+}
+
+void ReusableProtoArena::Reset() {
+  uint64_t allocated = arena_->SpaceAllocated();
+  if (allocated > initial_block_size_ &&
+      initial_block_size_ < max_retained_size_) {
+    InitArena(std::min<uint64_t>(allocated, max_retained_size_));
+    return;
+  }
+  arena_->Reset();
+}
+
 }  // namespace extensions
 
 }  // namespace cel
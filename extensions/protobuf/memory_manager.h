@@ -15,11 +15,15 @@
 #ifndef THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_MEMORY_MANAGER_H_
 #define THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_MEMORY_MANAGER_H_
 
+#include <cstddef>
+#include <memory>
 #include <utility>
 
 #include "absl/base/attributes.h"
 #include "absl/base/nullability.h"
+#include "absl/types/optional.h"
 #include "common/memory.h"
+#include "internal/huge_pages.h"
 #include "google/protobuf/arena.h"
 
 namespace cel::extensions {
@@ -59,6 +63,79 @@ ABSL_MUST_USE_RESULT T* NewInProtoArena(MemoryManagerRef memory_manager,
                                   std::forward<Args>(args)...);
 }
 
+// An arena for evaluating one request at a time, which keeps its memory
+// across `Reset()`.
+//
+// The arena allocates from an initial block owned by this instance. `Reset()`
+// destroys the objects allocated since the previous reset and frees the blocks
+// other than the initial one, like `google::protobuf::Arena::Reset`. If the
+// arena outgrew the initial block, it is replaced by one large enough for the
+// allocations of that request, up to `max_retained_size`, so that once the
+// watermark is reached evaluations no longer allocate arena blocks.
+//
+// Typical use is one instance per thread, passing `memory_manager()` to a
+// `ManagedValueFactory` or to `TraceableProgram::Evaluate` for each request
+// and calling `Reset()` after the results are consumed.
+//
+// With `huge_pages` other than `kNone`, the blocks of a huge page or more,
+// including the retained block once it grows that large, are backed by huge
+// pages (see internal/huge_pages.h). This cuts the TLB misses of requests
+// allocating hundreds of megabytes, e.g. for large activations or rule sets.
+//
+// Not thread safe.
+class ReusableProtoArena final {
+ public:
+  static constexpr size_t kDefaultInitialBlockSize = 4096;
+  static constexpr size_t kDefaultMaxRetainedSize = 1 << 20;
+
+  explicit ReusableProtoArena(
+      size_t initial_block_size = kDefaultInitialBlockSize,
+      size_t max_retained_size = kDefaultMaxRetainedSize,
+      ::cel::internal::HugePages huge_pages =
+          ::cel::internal::HugePages::kNone);
+
+  ReusableProtoArena(const ReusableProtoArena&) = delete;
+  ReusableProtoArena& operator=(const ReusableProtoArena&) = delete;
+
+  absl::Nonnull<google::protobuf::Arena*> arena()
+      ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    return &*arena_;
+  }
+
+  MemoryManagerRef memory_manager() ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    return ProtoMemoryManagerRef(arena());
+  }
+
+  // The size of the block retained across resets.
+  size_t retained_size() const { return initial_block_size_; }
+
+  ::cel::internal::HugePages huge_pages() const { return huge_pages_; }
+
+  // Destroys everything allocated from the arena. Objects, values and memory
+  // managers obtained from it must not be used afterwards.
+  void Reset();
+
+ private:
+  // Deallocates the initial block with the size and huge pages it was
+  // allocated with.
+  struct BlockDeleter {
+    void operator()(char* block) const noexcept {
+      ::cel::internal::DeallocateBlock(block, size, huge_pages);
+    }
+
+    size_t size;
+    ::cel::internal::HugePages huge_pages;
+  };
+
+  void InitArena(size_t initial_block_size);
+
+  const size_t max_retained_size_;
+  const ::cel::internal::HugePages huge_pages_;
+  size_t initial_block_size_ = 0;
+  std::unique_ptr<char, BlockDeleter> initial_block_;
+  absl::optional<google::protobuf::Arena> arena_;
+};
+
 }  // namespace cel::extensions
 
 #endif  // THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_MEMORY_MANAGER_H_
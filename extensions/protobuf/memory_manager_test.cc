@@ -14,7 +14,10 @@
 
 #include "extensions/protobuf/memory_manager.h"
 
+#include <cstddef>
+
 #include "common/memory.h"
+#include "internal/huge_pages.h"
 #include "internal/testing.h"
 #include "google/protobuf/arena.h"
 
@@ -52,5 +55,85 @@ TEST(ProtoMemoryManagerRef, Arena) {
   EXPECT_THAT(ProtoMemoryManagerArena(memory_manager), IsNull());
 }
 
+TEST(ReusableProtoArena, MemoryManager) {
+  ReusableProtoArena arena;
+  EXPECT_EQ(arena.memory_manager().memory_management(),
+            MemoryManagement::kPooling);
+  EXPECT_THAT(ProtoMemoryManagerArena(arena.memory_manager()),
+              Eq(arena.arena()));
+}
+
+TEST(ReusableProtoArena, RetainsWatermark) {
+  ReusableProtoArena arena(/*initial_block_size=*/256);
+  EXPECT_EQ(arena.retained_size(), 256);
+
+  auto allocate = [&arena]() {
+    for (int i = 0; i < 64; ++i) {
+      ASSERT_THAT(arena.memory_manager().Allocate(64, 8), NotNull());
+    }
+  };
+  allocate();
+  EXPECT_GT(arena.arena()->SpaceAllocated(), 256);
+  arena.Reset();
+  size_t retained = arena.retained_size();
+  EXPECT_GE(retained, 64 * 64);
+
+  // The next request of the same size fits in the retained block.
+  allocate();
+  EXPECT_EQ(arena.arena()->SpaceAllocated(), retained);
+  arena.Reset();
+  EXPECT_EQ(arena.retained_size(), retained);
+  EXPECT_EQ(arena.arena()->SpaceUsed(), 0);
+}
+
+TEST(ReusableProtoArena, CapsRetainedSize) {
+  ReusableProtoArena arena(/*initial_block_size=*/256,
+                           /*max_retained_size=*/1024);
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_THAT(arena.memory_manager().Allocate(64, 8), NotNull());
+  }
+  arena.Reset();
+  EXPECT_EQ(arena.retained_size(), 1024);
+}
+
+TEST(ReusableProtoArena, RunsDestructorsOnReset) {
+  ReusableProtoArena arena;
+  int destroyed = 0;
+  struct Counter {
+    explicit Counter(int* count) : count(count) {}
+    ~Counter() { ++*count; }
+    int* count;
+  };
+  google::protobuf::Arena::Create<Counter>(arena.arena(), &destroyed);
+  arena.Reset();
+  EXPECT_EQ(destroyed, 1);
+}
+
+TEST(ReusableProtoArena, HugePages) {
+  for (internal::HugePages huge_pages :
+       {internal::HugePages::kTransparent, internal::HugePages::kExplicit}) {
+    ReusableProtoArena arena(/*initial_block_size=*/256,
+                             /*max_retained_size=*/size_t{64} << 20,
+                             huge_pages);
+    if (internal::HugePageSize() == 0) {
+      EXPECT_EQ(arena.huge_pages(), internal::HugePages::kNone);
+      continue;
+    }
+    EXPECT_EQ(arena.huge_pages(), huge_pages);
+    const size_t size = internal::HugePageSize() / 4;
+    for (int i = 0; i < 12; ++i) {
+      ASSERT_THAT(arena.memory_manager().Allocate(size, 8), NotNull());
+    }
+    arena.Reset();
+    // Retained in whole huge pages.
+    EXPECT_GE(arena.retained_size(), 3 * internal::HugePageSize());
+    EXPECT_EQ(arena.retained_size() % internal::HugePageSize(), 0);
+    for (int i = 0; i < 12; ++i) {
+      ASSERT_THAT(arena.memory_manager().Allocate(size, 8), NotNull());
+    }
+    EXPECT_EQ(arena.arena()->SpaceAllocated(), arena.retained_size());
+  }
+}
+
 }  // namespace
 }  // namespace cel::extensions
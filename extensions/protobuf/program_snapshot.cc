@@ -0,0 +1,100 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/protobuf/program_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/status_macros.h"
+#include "runtime/runtime.h"
+
+namespace cel::extensions {
+
+namespace {
+
+constexpr absl::string_view kMagic = "CELS";
+constexpr size_t kHeaderSize = 16;
+
+void AppendLittleEndian(uint64_t value, size_t size, std::string& out) {
+  for (size_t i = 0; i < size; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint64_t ReadLittleEndian(absl::string_view bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+absl::StatusOr<std::string> SerializeProgramSnapshot(
+    const google::api::expr::v1alpha1::CheckedExpr& expr,
+    uint64_t registry_fingerprint) {
+  std::string snapshot(kMagic);
+  AppendLittleEndian(kProgramSnapshotVersion, 4, snapshot);
+  AppendLittleEndian(registry_fingerprint, 8, snapshot);
+  if (!expr.AppendToString(&snapshot)) {
+    return absl::InvalidArgumentError("failed to serialize checked expression");
+  }
+  return snapshot;
+}
+
+absl::StatusOr<google::api::expr::v1alpha1::CheckedExpr>
+ParseProgramSnapshot(absl::string_view snapshot,
+                     uint64_t registry_fingerprint) {
+  if (snapshot.size() < kHeaderSize || snapshot.substr(0, 4) != kMagic) {
+    return absl::InvalidArgumentError("not a program snapshot");
+  }
+  uint64_t version = ReadLittleEndian(snapshot.substr(4, 4));
+  if (version != kProgramSnapshotVersion) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("unsupported program snapshot version: ", version));
+  }
+  if (ReadLittleEndian(snapshot.substr(8, 8)) != registry_fingerprint) {
+    return absl::FailedPreconditionError(
+        "program snapshot was created for another function registry");
+  }
+  google::api::expr::v1alpha1::CheckedExpr expr;
+  snapshot.remove_prefix(kHeaderSize);
+  if (!expr.ParseFromArray(snapshot.data(),
+                           static_cast<int>(snapshot.size()))) {
+    return absl::InvalidArgumentError(
+        "malformed checked expression in program snapshot");
+  }
+  return expr;
+}
+
+absl::StatusOr<std::unique_ptr<TraceableProgram>> CreateProgramFromSnapshot(
+    const Runtime& runtime, absl::string_view snapshot,
+    uint64_t registry_fingerprint,
+    const Runtime::CreateProgramOptions& options) {
+  CEL_ASSIGN_OR_RETURN(google::api::expr::v1alpha1::CheckedExpr expr,
+                       ParseProgramSnapshot(snapshot, registry_fingerprint));
+  return ProtobufRuntimeAdapter::CreateProgram(runtime, expr, options);
+}
+
+}  // namespace cel::extensions
@@ -0,0 +1,72 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Program snapshots persist a checked expression along with the fingerprint of
+// the function registry it was checked against, so that restarting processes
+// can skip parsing and type checking.
+//
+// The format is a fixed size header followed by the serialized CheckedExpr:
+//
+//   bytes 0-3    magic "CELS"
+//   bytes 4-7    format version, little endian
+//   bytes 8-15   FunctionRegistry::DescriptorFingerprint, little endian
+//   bytes 16-    google.api.expr.v1alpha1.CheckedExpr
+//
+// The CheckedExpr carries everything planning reads from the checker: the
+// resolved overload IDs and identifiers in its reference map, and regular
+// expression patterns as constants.
+
+#ifndef THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_PROGRAM_SNAPSHOT_H_
+#define THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_PROGRAM_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "runtime/runtime.h"
+
+namespace cel::extensions {
+
+// The version written by SerializeProgramSnapshot.
+inline constexpr uint32_t kProgramSnapshotVersion = 1;
+
+// Serializes `expr` into a snapshot bound to `registry_fingerprint`, the
+// FunctionRegistry::DescriptorFingerprint of the registry used to check it.
+absl::StatusOr<std::string> SerializeProgramSnapshot(
+    const google::api::expr::v1alpha1::CheckedExpr& expr,
+    uint64_t registry_fingerprint);
+
+// Reads the checked expression of `snapshot`.
+//
+// Returns a FailedPrecondition error if the snapshot has an unsupported
+// version or was created for a registry with another fingerprint, in which
+// case the expression needs to be checked again, and an InvalidArgument error
+// if it is malformed.
+absl::StatusOr<google::api::expr::v1alpha1::CheckedExpr>
+ParseProgramSnapshot(absl::string_view snapshot,
+                     uint64_t registry_fingerprint);
+
+// Plans the checked expression of `snapshot` with `runtime`, which must have
+// been built with a registry of `registry_fingerprint`.
+absl::StatusOr<std::unique_ptr<TraceableProgram>> CreateProgramFromSnapshot(
+    const Runtime& runtime, absl::string_view snapshot,
+    uint64_t registry_fingerprint,
+    const Runtime::CreateProgramOptions& options = {});
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_PROGRAM_SNAPSHOT_H_
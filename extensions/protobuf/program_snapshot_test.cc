@@ -0,0 +1,126 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/protobuf/program_snapshot.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::cel::test::BoolValueIs;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::HasSubstr;
+using cel::internal::StatusIs;
+
+class ProgramSnapshotTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(RuntimeBuilder builder,
+                         CreateStandardRuntimeBuilder(RuntimeOptions()));
+    fingerprint_ = builder.function_registry().DescriptorFingerprint();
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+  }
+
+  CheckedExpr MakeCheckedExpr(const ParsedExpr& parsed) {
+    CheckedExpr checked;
+    *checked.mutable_expr() = parsed.expr();
+    *checked.mutable_source_info() = parsed.source_info();
+    return checked;
+  }
+
+  uint64_t fingerprint_ = 0;
+  std::unique_ptr<const Runtime> runtime_;
+};
+
+TEST_F(ProgramSnapshotTest, RoundTrip) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed,
+                       Parse("'abc'.matches('^a.c$') && [1, 2].exists(x, "
+                             "x == 2)"));
+  CheckedExpr checked = MakeCheckedExpr(parsed);
+  ASSERT_OK_AND_ASSIGN(std::string snapshot,
+                       SerializeProgramSnapshot(checked, fingerprint_));
+
+  ASSERT_OK_AND_ASSIGN(CheckedExpr parsed_snapshot,
+                       ParseProgramSnapshot(snapshot, fingerprint_));
+  EXPECT_EQ(parsed_snapshot.SerializeAsString(), checked.SerializeAsString());
+
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TraceableProgram> program,
+      CreateProgramFromSnapshot(*runtime_, snapshot, fingerprint_));
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  Activation activation;
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory.get()));
+  EXPECT_THAT(result, BoolValueIs(true));
+}
+
+TEST_F(ProgramSnapshotTest, RejectsOtherRegistry) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed, Parse("1 + 2"));
+  ASSERT_OK_AND_ASSIGN(
+      std::string snapshot,
+      SerializeProgramSnapshot(MakeCheckedExpr(parsed), fingerprint_ + 1));
+
+  EXPECT_THAT(CreateProgramFromSnapshot(*runtime_, snapshot, fingerprint_),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("another function registry")));
+}
+
+TEST_F(ProgramSnapshotTest, RejectsMalformedSnapshots) {
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed, Parse("1 + 2"));
+  ASSERT_OK_AND_ASSIGN(
+      std::string snapshot,
+      SerializeProgramSnapshot(MakeCheckedExpr(parsed), fingerprint_));
+
+  EXPECT_THAT(ParseProgramSnapshot(snapshot.substr(0, 10), fingerprint_),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseProgramSnapshot("XXXX" + snapshot.substr(4), fingerprint_),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  std::string future_version = snapshot;
+  future_version[4] = 2;
+  EXPECT_THAT(ParseProgramSnapshot(future_version, fingerprint_),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("version")));
+
+  std::string truncated = snapshot.substr(0, snapshot.size() - 1);
+  EXPECT_THAT(ParseProgramSnapshot(truncated, fingerprint_),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace cel::extensions
@@ -29,6 +29,7 @@
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "common/any.h"
@@ -730,11 +731,11 @@ ProtoTypeReflector::NewStructValueBuilder(ValueFactory& value_factory,
                                           StructTypeView type) const {
   // Well known types are handled via `NewValueBuilder`. If we are requested to
   // create a well known type here, we pretend we do not support it.
-  const auto* descriptor =
-      descriptor_pool()->FindMessageTypeByName(type.name());
-  if (descriptor == nullptr) {
+  auto found = FindPrototype(type.name());
+  if (!found.has_value()) {
     return absl::nullopt;
   }
+  const auto* descriptor = found->descriptor;
   switch (descriptor->well_known_type()) {
     case google::protobuf::Descriptor::WELLKNOWNTYPE_BOOLVALUE:
       ABSL_FALLTHROUGH_INTENDED;
@@ -769,10 +770,7 @@ ProtoTypeReflector::NewStructValueBuilder(ValueFactory& value_factory,
     default:
       break;
   }
-  const auto* prototype = message_factory()->GetPrototype(descriptor);
-  if (prototype == nullptr) {
-    return absl::nullopt;
-  }
+  const auto* prototype = found->prototype;
   auto memory_manager = value_factory.GetMemoryManager();
   auto* arena = ProtoMemoryManagerArena(memory_manager);
   auto message = protobuf_internal::ArenaUniquePtr<google::protobuf::Message>{
@@ -791,7 +789,26 @@ absl::StatusOr<absl::optional<Value>> ProtoTypeReflector::DeserializeValueImpl(
   if (!ParseTypeUrl(type_url, &type_name)) {
     return absl::InvalidArgumentError("invalid type URL");
   }
-  const auto* descriptor = descriptor_pool()->FindMessageTypeByName(type_name);
+  auto found = FindPrototype(type_name);
+  if (!found.has_value()) {
+    return absl::nullopt;
+  }
+  // Fields of the payload are decoded as they are accessed.
+  return protobuf_internal::ProtoMessageToLazyValueImpl(
+      value_factory, *this, found->prototype, value);
+}
+
+absl::optional<ProtoTypeReflector::Prototype> ProtoTypeReflector::FindPrototype(
+    absl::string_view name) const {
+  {
+    absl::ReaderMutexLock lock(&prototypes_mutex_);
+    if (auto it = prototypes_.find(name); it != prototypes_.end()) {
+      return it->second;
+    }
+  }
+  // Types which aren't found are not cached, as the pool may be backed by a
+  // database which learns about them later.
+  const auto* descriptor = descriptor_pool()->FindMessageTypeByName(name);
   if (descriptor == nullptr) {
     return absl::nullopt;
   }
@@ -799,8 +816,9 @@ absl::StatusOr<absl::optional<Value>> ProtoTypeReflector::DeserializeValueImpl(
   if (prototype == nullptr) {
     return absl::nullopt;
   }
-  return protobuf_internal::ProtoMessageToValueImpl(value_factory, *this,
-                                                    prototype, value);
+  absl::WriterMutexLock lock(&prototypes_mutex_);
+  return prototypes_.try_emplace(name, Prototype{descriptor, prototype})
+      .first->second;
 }
 
 }  // namespace cel::extensions
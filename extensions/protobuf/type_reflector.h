@@ -15,10 +15,15 @@
 #ifndef THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_TYPE_REFLECTOR_H_
 #define THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_TYPE_REFLECTOR_H_
 
+#include <string>
+
 #include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "common/memory.h"
 #include "common/type.h"
@@ -52,11 +57,25 @@ class ProtoTypeReflector : public TypeReflector, public ProtoTypeIntrospector {
   }
 
  private:
+  struct Prototype {
+    absl::Nonnull<const google::protobuf::Descriptor*> descriptor;
+    absl::Nonnull<const google::protobuf::Message*> prototype;
+  };
+
   absl::StatusOr<absl::optional<Value>> DeserializeValueImpl(
       ValueFactory& value_factory, absl::string_view type_url,
       const absl::Cord& value) const final;
 
+  // Returns the descriptor and prototype of the message type `name`, or
+  // `absl::nullopt` if the descriptor pool or the message factory doesn't
+  // know it. Found types are cached, so that creating and parsing messages
+  // doesn't look them up in the pool and the factory each time.
+  absl::optional<Prototype> FindPrototype(absl::string_view name) const;
+
   absl::Nonnull<google::protobuf::MessageFactory*> const message_factory_;
+  mutable absl::Mutex prototypes_mutex_;
+  mutable absl::flat_hash_map<std::string, Prototype> prototypes_
+      ABSL_GUARDED_BY(prototypes_mutex_);
 };
 
 }  // namespace cel::extensions
@@ -15,7 +15,11 @@
 #include "extensions/protobuf/type_reflector.h"
 
 #include "google/protobuf/wrappers.pb.h"
+#include <utility>
+
 #include "absl/status/status.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "common/memory.h"
 #include "common/type.h"
@@ -30,6 +34,7 @@ namespace cel::extensions {
 namespace {
 
 using ::google::api::expr::test::v1::proto2::TestAllTypes;
+using cel::internal::IsOkAndHolds;
 using cel::internal::StatusIs;
 
 class ProtoTypeReflectorTest
@@ -125,6 +130,40 @@ TEST_P(ProtoTypeReflectorTest, NewStructValueBuilder_TypeConversionError) {
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST_P(ProtoTypeReflectorTest, NewStructValueBuilder_Repeatedly) {
+  // The prototype is cached after the first builder, so later builders must
+  // produce independent messages.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(
+        auto builder,
+        value_manager().NewStructValueBuilder(value_manager().CreateStructType(
+            TestAllTypes::descriptor()->full_name())));
+    ASSERT_TRUE(builder.has_value());
+    ASSERT_OK((*builder)->SetFieldByName("single_int64", IntValue(i)));
+    ASSERT_OK_AND_ASSIGN(auto value, std::move(**builder).Build());
+    EXPECT_THAT(value.GetFieldByName(value_manager(), "single_int64"),
+                IsOkAndHolds(test::IntValueIs(i)));
+  }
+}
+
+TEST_P(ProtoTypeReflectorTest, DeserializeValue_Repeatedly) {
+  TestAllTypes message;
+  message.set_single_string("foo");
+  absl::Cord serialized = message.SerializeAsCord();
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(
+        auto value,
+        value_manager().DeserializeValue(
+            absl::StrCat("type.googleapis.com/",
+                         TestAllTypes::descriptor()->full_name()),
+            serialized));
+    ASSERT_TRUE(value.has_value());
+    EXPECT_THAT(*value, test::StructValueIs(test::StructValueFieldIs(
+                            &value_manager(), "single_string",
+                            test::StringValueIs("foo"))));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     ProtoTypeReflectorTest, ProtoTypeReflectorTest,
     ::testing::Values(MemoryManagement::kPooling,
@@ -32,6 +32,8 @@
 #include "absl/base/nullability.h"
 #include "absl/functional/overload.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "common/memory.h"
 #include "common/value.h"
 #include "common/value_factory.h"
 #include "common/value_manager.h"
@@ -39,11 +41,13 @@
 #include "extensions/protobuf/internal/enum.h"
 #include "extensions/protobuf/internal/message.h"
 #include "extensions/protobuf/internal/struct_lite.h"
+#include "extensions/protobuf/internal/struct_view.h"
 #include "extensions/protobuf/internal/timestamp_lite.h"
 #include "extensions/protobuf/internal/wrappers_lite.h"
 #include "internal/status_macros.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/generated_enum_reflection.h"
+#include "google/protobuf/message.h"
 
 namespace cel::extensions {
 
@@ -196,6 +200,61 @@ ProtoMessageToValue(ValueManager& value_manager, T&& value,
   return scratch;
 }
 
+// Adapt a serialized protobuf message to a cel::Value without parsing it.
+//
+// The serialized bytes are retained and only the fields that are accessed are
+// decoded, which is considerably cheaper than parsing when an expression reads
+// a few fields of a large message. Operations on the whole message (equality,
+// JSON conversion, iterating fields) still parse it in full.
+//
+// `prototype` must outlive the returned value. WKTs are parsed eagerly.
+inline absl::StatusOr<Value> ProtoMessageToLazyValue(
+    ValueManager& value_manager,
+    absl::Nonnull<const google::protobuf::Message*> prototype, absl::Cord serialized) {
+  return protobuf_internal::ProtoMessageToLazyValueImpl(
+      value_manager, prototype, std::move(serialized));
+}
+
+// Adapt a serialized protobuf message to a cel::Value without parsing it.
+//
+// T must be a generated protobuf message class.
+template <typename T>
+std::enable_if_t<protobuf_internal::IsProtoMessage<T>, absl::StatusOr<Value>>
+ProtoMessageToLazyValue(ValueManager& value_manager, absl::Cord serialized) {
+  return ProtoMessageToLazyValue(value_manager, &T::default_instance(),
+                                 std::move(serialized));
+}
+
+// Adapt a google.protobuf.Struct to a cel::MapValue which reads directly from
+// `message`, without first converting it to JSON.
+//
+// Keys are looked up in the underlying map and only the values which are
+// accessed are adapted. `message` must outlive the returned value.
+inline MapValue ProtoStructAsMapValue(
+    ValueManager& value_manager,
+    const google::protobuf::Struct& message ABSL_ATTRIBUTE_LIFETIME_BOUND) {
+  return protobuf_internal::GeneratedStructProtoAsMapValue(
+      value_manager, Shared<const void>(), message);
+}
+
+// Adapt a google.protobuf.ListValue to a cel::ListValue which reads directly
+// from `message`. `message` must outlive the returned value.
+inline ListValue ProtoListValueAsListValue(
+    ValueManager& value_manager,
+    const google::protobuf::ListValue& message ABSL_ATTRIBUTE_LIFETIME_BOUND) {
+  return protobuf_internal::GeneratedListValueProtoAsListValue(
+      value_manager, Shared<const void>(), message);
+}
+
+// Adapt a google.protobuf.Value to a cel::Value. Nested structs and lists read
+// directly from `message`, which must outlive the returned value.
+inline Value ProtoValueAsValue(
+    ValueManager& value_manager,
+    const google::protobuf::Value& message ABSL_ATTRIBUTE_LIFETIME_BOUND) {
+  return protobuf_internal::GeneratedValueProtoAsValue(
+      value_manager, Shared<const void>(), message);
+}
+
 // Extract a protobuf message from a CEL value.
 //
 // Handles unwrapping message types with special meanings in CEL (WKTs).
@@ -0,0 +1,160 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/protobuf/value_export.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "extensions/protobuf/internal/struct.h"
+#include "internal/status_macros.h"
+#include "internal/time.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+
+namespace {
+
+void SetIntValue(int64_t value, google::protobuf::Value& out) {
+  if (value < kJsonMinInt || value > kJsonMaxInt) {
+    out.set_string_value(absl::StrCat(value));
+    return;
+  }
+  out.set_number_value(static_cast<double>(value));
+}
+
+void SetUintValue(uint64_t value, google::protobuf::Value& out) {
+  if (value > kJsonMaxUint) {
+    out.set_string_value(absl::StrCat(value));
+    return;
+  }
+  out.set_number_value(static_cast<double>(value));
+}
+
+}  // namespace
+
+absl::Status ExportValueAsProtoValue(ValueManager& value_manager,
+                                     ValueView value,
+                                     google::protobuf::Value& out) {
+  switch (value.kind()) {
+    case ValueKind::kNull:
+      out.set_null_value(google::protobuf::NULL_VALUE);
+      return absl::OkStatus();
+    case ValueKind::kBool:
+      out.set_bool_value(Cast<BoolValueView>(value).NativeValue());
+      return absl::OkStatus();
+    case ValueKind::kInt:
+      SetIntValue(Cast<IntValueView>(value).NativeValue(), out);
+      return absl::OkStatus();
+    case ValueKind::kUint:
+      SetUintValue(Cast<UintValueView>(value).NativeValue(), out);
+      return absl::OkStatus();
+    case ValueKind::kDouble:
+      out.set_number_value(Cast<DoubleValueView>(value).NativeValue());
+      return absl::OkStatus();
+    case ValueKind::kString:
+      Cast<StringValueView>(value).NativeValue(
+          [&out](const auto& string) { out.set_string_value(string); });
+      return absl::OkStatus();
+    case ValueKind::kBytes: {
+      std::string scratch;
+      absl::Base64Escape(Cast<BytesValueView>(value).NativeString(scratch),
+                         out.mutable_string_value());
+      return absl::OkStatus();
+    }
+    case ValueKind::kDuration: {
+      CEL_ASSIGN_OR_RETURN(*out.mutable_string_value(),
+                           internal::EncodeDurationToJson(
+                               Cast<DurationValueView>(value).NativeValue()));
+      return absl::OkStatus();
+    }
+    case ValueKind::kTimestamp: {
+      CEL_ASSIGN_OR_RETURN(*out.mutable_string_value(),
+                           internal::EncodeTimestampToJson(
+                               Cast<TimestampValueView>(value).NativeValue()));
+      return absl::OkStatus();
+    }
+    case ValueKind::kList:
+      return ExportListValueAsProtoListValue(
+          value_manager, Cast<ListValueView>(value), *out.mutable_list_value());
+    case ValueKind::kMap:
+      return ExportMapValueAsProtoStruct(value_manager,
+                                         Cast<MapValueView>(value),
+                                         *out.mutable_struct_value());
+    default: {
+      // Messages, and the errors for kinds without a JSON representation, go
+      // through the generic conversion.
+      CEL_ASSIGN_OR_RETURN(auto json, value.ConvertToJson(value_manager));
+      return protobuf_internal::DynamicValueProtoFromJson(json, out);
+    }
+  }
+}
+
+absl::Status ExportListValueAsProtoListValue(ValueManager& value_manager,
+                                             ListValueView value,
+                                             google::protobuf::ListValue& out) {
+  CEL_ASSIGN_OR_RETURN(size_t size, value.Size());
+  auto* values = out.mutable_values();
+  values->Reserve(static_cast<int>(values->size() + size));
+  return value.ForEach(
+      value_manager,
+      [&value_manager, values](ValueView element) -> absl::StatusOr<bool> {
+        CEL_RETURN_IF_ERROR(
+            ExportValueAsProtoValue(value_manager, element, *values->Add()));
+        return true;
+      });
+}
+
+absl::Status ExportMapValueAsProtoStruct(ValueManager& value_manager,
+                                         MapValueView value,
+                                         google::protobuf::Struct& out) {
+  auto* fields = out.mutable_fields();
+  return value.ForEach(
+      value_manager,
+      [&value_manager, fields](ValueView key,
+                               ValueView entry) -> absl::StatusOr<bool> {
+        auto string_key = As<StringValueView>(key);
+        if (!string_key.has_value()) {
+          return TypeConversionError(
+                     absl::StrCat("map<", key.GetTypeName(), ", ?>"),
+                     "google.protobuf.Struct")
+              .NativeValue();
+        }
+        CEL_RETURN_IF_ERROR(ExportValueAsProtoValue(
+            value_manager, entry, (*fields)[string_key->NativeString()]));
+        return true;
+      });
+}
+
+absl::StatusOr<absl::Nonnull<google::protobuf::Value*>> ExportValueAsProtoValue(
+    ValueManager& value_manager, ValueView value,
+    absl::Nonnull<google::protobuf::Arena*> arena) {
+  auto* out = google::protobuf::Arena::Create<google::protobuf::Value>(arena);
+  CEL_RETURN_IF_ERROR(ExportValueAsProtoValue(value_manager, value, *out));
+  return out;
+}
+
+}  // namespace cel::extensions
@@ -0,0 +1,56 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_VALUE_EXPORT_H_
+#define THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_VALUE_EXPORT_H_
+
+// Exports CEL values directly into `google.protobuf.Value` and friends,
+// following the same rules as `Value::ConvertToJson` without building an
+// intermediate `Json` tree. Messages are populated in place, so exporting into
+// an arena-allocated message keeps the whole result on that arena.
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+
+// Exports `value` into `out`. `out` is expected to be empty.
+absl::Status ExportValueAsProtoValue(ValueManager& value_manager,
+                                     ValueView value,
+                                     google::protobuf::Value& out);
+
+// Exports `value` into `out`. `out` is expected to be empty.
+absl::Status ExportListValueAsProtoListValue(ValueManager& value_manager,
+                                             ListValueView value,
+                                             google::protobuf::ListValue& out);
+
+// Exports `value` into `out`. Only maps with string keys can be exported.
+// `out` is expected to be empty.
+absl::Status ExportMapValueAsProtoStruct(ValueManager& value_manager,
+                                         MapValueView value,
+                                         google::protobuf::Struct& out);
+
+// Exports `value` into a new `google.protobuf.Value` allocated on `arena`.
+absl::StatusOr<absl::Nonnull<google::protobuf::Value*>> ExportValueAsProtoValue(
+    ValueManager& value_manager, ValueView value,
+    absl::Nonnull<google::protobuf::Arena*> arena);
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_EXTENSIONS_PROTOBUF_VALUE_EXPORT_H_
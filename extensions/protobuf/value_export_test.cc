@@ -0,0 +1,137 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/protobuf/value_export.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "internal/proto_matchers.h"
+#include "internal/testing.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::cel::internal::test::EqualsProto;
+using testing::HasSubstr;
+using cel::internal::StatusIs;
+
+class ValueExportTest : public common_internal::ThreadCompatibleValueTest<> {
+ public:
+  google::protobuf::Value Export(ValueView value) {
+    google::protobuf::Value out;
+    ABSL_CHECK_OK(ExportValueAsProtoValue(value_manager(), value, out));
+    return out;
+  }
+};
+
+TEST_P(ValueExportTest, Scalars) {
+  EXPECT_THAT(Export(NullValue()), EqualsProto("null_value: NULL_VALUE"));
+  EXPECT_THAT(Export(BoolValue(true)), EqualsProto("bool_value: true"));
+  EXPECT_THAT(Export(IntValue(-2)), EqualsProto("number_value: -2"));
+  EXPECT_THAT(Export(UintValue(2)), EqualsProto("number_value: 2"));
+  EXPECT_THAT(Export(DoubleValue(1.5)), EqualsProto("number_value: 1.5"));
+  EXPECT_THAT(Export(StringValue("foo")), EqualsProto("string_value: 'foo'"));
+  EXPECT_THAT(Export(BytesValue("foo")), EqualsProto("string_value: 'Zm9v'"));
+  EXPECT_THAT(Export(DurationValue(absl::Seconds(90))),
+              EqualsProto("string_value: '90s'"));
+  EXPECT_THAT(Export(TimestampValue(absl::UnixEpoch())),
+              EqualsProto("string_value: '1970-01-01T00:00:00Z'"));
+}
+
+TEST_P(ValueExportTest, IntegersOutsideDoublePrecisionAsStrings) {
+  EXPECT_THAT(Export(IntValue(std::numeric_limits<int64_t>::max())),
+              EqualsProto("string_value: '9223372036854775807'"));
+  EXPECT_THAT(Export(UintValue(std::numeric_limits<uint64_t>::max())),
+              EqualsProto("string_value: '18446744073709551615'"));
+}
+
+TEST_P(ValueExportTest, ListsAndMaps) {
+  ASSERT_OK_AND_ASSIGN(
+      auto list_builder,
+      value_manager().NewListValueBuilder(value_manager().GetDynListType()));
+  ASSERT_OK(list_builder->Add(IntValue(1)));
+  ASSERT_OK(list_builder->Add(StringValue("two")));
+  ASSERT_OK_AND_ASSIGN(auto map_builder,
+                       value_manager().NewMapValueBuilder(
+                           value_manager().GetDynDynMapType()));
+  ASSERT_OK(map_builder->Put(StringValue("list"),
+                             std::move(*list_builder).Build()));
+  ASSERT_OK(map_builder->Put(StringValue("flag"), BoolValue(false)));
+  MapValue map = std::move(*map_builder).Build();
+
+  google::protobuf::Struct out;
+  ASSERT_OK(ExportMapValueAsProtoStruct(value_manager(), map, out));
+
+  EXPECT_THAT(out, EqualsProto(R"pb(
+                fields {
+                  key: "list"
+                  value {
+                    list_value {
+                      values { number_value: 1 }
+                      values { string_value: "two" }
+                    }
+                  }
+                }
+                fields {
+                  key: "flag"
+                  value { bool_value: false }
+                }
+              )pb"));
+}
+
+TEST_P(ValueExportTest, NonStringMapKey) {
+  ASSERT_OK_AND_ASSIGN(auto map_builder,
+                       value_manager().NewMapValueBuilder(
+                           value_manager().GetDynDynMapType()));
+  ASSERT_OK(map_builder->Put(IntValue(1), BoolValue(true)));
+  MapValue map = std::move(*map_builder).Build();
+
+  google::protobuf::Value out;
+  EXPECT_THAT(ExportValueAsProtoValue(value_manager(), map, out),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("google.protobuf.Struct")));
+}
+
+TEST_P(ValueExportTest, Unsupported) {
+  google::protobuf::Value out;
+  EXPECT_THAT(
+      ExportValueAsProtoValue(value_manager(), TypeValue(IntType()), out),
+      StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_P(ValueExportTest, ArenaAllocated) {
+  google::protobuf::Arena arena;
+  ASSERT_OK_AND_ASSIGN(
+      google::protobuf::Value * out,
+      ExportValueAsProtoValue(value_manager(), StringValue("foo"), &arena));
+  EXPECT_EQ(out->GetArena(), &arena);
+  EXPECT_THAT(*out, EqualsProto("string_value: 'foo'"));
+}
+
+INSTANTIATE_TEST_SUITE_P(ValueExportTest, ValueExportTest,
+                         ::testing::Values(MemoryManagement::kReferenceCounting,
+                                           MemoryManagement::kPooling));
+
+}  // namespace
+}  // namespace cel::extensions
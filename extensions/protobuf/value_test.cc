@@ -29,6 +29,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "base/attribute.h"
@@ -64,6 +65,7 @@ using ::cel::test::StructValueIs;
 using ::cel::test::TimestampValueIs;
 using ::cel::test::UintValueIs;
 using ::cel::test::ValueKindIs;
+using ::google::api::expr::test::v1::proto2::NestedTestAllTypes;
 using ::google::api::expr::test::v1::proto2::TestAllTypes;
 using testing::_;
 using testing::AllOf;
@@ -494,6 +496,166 @@ TEST_P(ProtoValueWrapTest, ProtoMessageQualifyHas) {
   EXPECT_THAT(Value(qualify_value.first), BoolValueIs(true));
 }
 
+TEST_P(ProtoValueWrapTest, LazyGetFieldByName) {
+  TestAllTypes message = ParseTextOrDie<TestAllTypes>(
+      R"pb(single_int32: 1,
+           single_string: "foo"
+           standalone_message { bb: 42 }
+           repeated_int64: [ 1, 2 ]
+           repeated_string: [ "a", "b" ])pb");
+  ASSERT_OK_AND_ASSIGN(auto value,
+                       ProtoMessageToLazyValue<TestAllTypes>(
+                           value_manager(), message.SerializeAsCord()));
+  ASSERT_THAT(value, StructValueIs(_));
+  EXPECT_EQ(value.GetTypeName(), "google.api.expr.test.v1.proto2.TestAllTypes");
+
+  EXPECT_THAT(value, StructValueIs(StructValueFieldIs(
+                         &value_manager(), "single_int32", IntValueIs(Eq(1)))));
+  EXPECT_THAT(value,
+              StructValueIs(StructValueFieldIs(
+                  &value_manager(), "single_string", StringValueIs("foo"))));
+  EXPECT_THAT(value,
+              StructValueIs(StructValueFieldHas("single_int64", Eq(false))));
+  EXPECT_THAT(value, StructValueIs(StructValueFieldHas("repeated_int64",
+                                                       IsTrue())));
+
+  StructValue struct_value = Cast<StructValue>(value);
+  ASSERT_OK_AND_ASSIGN(
+      auto nested,
+      struct_value.GetFieldByName(value_manager(), "standalone_message"));
+  EXPECT_THAT(nested, StructValueIs(StructValueFieldIs(
+                          &value_manager(), "bb", IntValueIs(Eq(42)))));
+  ASSERT_OK_AND_ASSIGN(
+      auto list,
+      struct_value.GetFieldByName(value_manager(), "repeated_string"));
+  EXPECT_THAT(list.DebugString(), AllOf(HasSubstr("a"), HasSubstr("b")));
+
+  // Accessing a field again uses the already decoded value.
+  EXPECT_THAT(struct_value.GetFieldByNumber(
+                  value_manager(), TestAllTypes::kSingleInt32FieldNumber),
+              IsOkAndHolds(IntValueIs(1)));
+  EXPECT_THAT(struct_value.GetFieldByName(value_manager(), "does_not_exist"),
+              IsOkAndHolds(ErrorValueIs(StatusIs(absl::StatusCode::kNotFound,
+                                                 HasSubstr("no_such_field")))));
+}
+
+TEST_P(ProtoValueWrapTest, GetAnyFieldRepeatedly) {
+  TestAllTypes payload;
+  payload.set_single_int64(42);
+  payload.mutable_standalone_message()->set_bb(7);
+  TestAllTypes message;
+  message.mutable_single_any()->PackFrom(payload);
+  ASSERT_OK_AND_ASSIGN(auto value,
+                       ProtoMessageToValue(value_manager(), message));
+  StructValue struct_value = Cast<StructValue>(value);
+
+  // The second access reuses the payload unpacked by the first one.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto any,
+                         struct_value.GetFieldByName(value_manager(),
+                                                     "single_any"));
+    ASSERT_THAT(any, StructValueIs(_));
+    EXPECT_EQ(any.GetTypeName(),
+              "google.api.expr.test.v1.proto2.TestAllTypes");
+    EXPECT_THAT(any, StructValueIs(StructValueFieldIs(
+                         &value_manager(), "single_int64", IntValueIs(42))));
+    EXPECT_THAT(any,
+                StructValueIs(StructValueFieldHas("single_int32", Eq(false))));
+    ASSERT_OK_AND_ASSIGN(auto nested,
+                         Cast<StructValue>(any).GetFieldByName(
+                             value_manager(), "standalone_message"));
+    EXPECT_THAT(nested, StructValueIs(StructValueFieldIs(
+                            &value_manager(), "bb", IntValueIs(Eq(7)))));
+  }
+}
+
+TEST_P(ProtoValueWrapTest, ProtoMessageDeepSelect) {
+  Value payload;
+  {
+    ASSERT_OK_AND_ASSIGN(
+        auto value,
+        ProtoMessageToValue(
+            value_manager(),
+            ParseTextOrDie<NestedTestAllTypes>(
+                R"pb(child { child { payload { single_int64: 1 } } })pb")));
+    ASSERT_OK_AND_ASSIGN(auto child, Cast<StructValue>(value).GetFieldByName(
+                                         value_manager(), "child"));
+    ASSERT_OK_AND_ASSIGN(auto grandchild,
+                         Cast<StructValue>(child).GetFieldByName(
+                             value_manager(), "child"));
+    ASSERT_OK_AND_ASSIGN(payload, Cast<StructValue>(grandchild).GetFieldByName(
+                                      value_manager(), "payload"));
+  }
+
+  // The selected message views the memory of the root message, which it
+  // keeps alive after the root and intermediate values are gone.
+  EXPECT_THAT(payload,
+              StructValueIs(StructValueFieldIs(&value_manager(), "single_int64",
+                                               IntValueIs(Eq(1)))));
+}
+
+TEST_P(ProtoValueWrapTest, LazyLastOneofMemberWins) {
+  absl::Cord serialized =
+      ParseTextOrDie<TestAllTypes>(R"pb(single_nested_message { bb: 1 })pb")
+          .SerializeAsCord();
+  serialized.Append(
+      ParseTextOrDie<TestAllTypes>(R"pb(single_nested_enum: BAR)pb")
+          .SerializeAsCord());
+  ASSERT_OK_AND_ASSIGN(auto value, ProtoMessageToLazyValue<TestAllTypes>(
+                                       value_manager(), serialized));
+
+  EXPECT_THAT(value, StructValueIs(StructValueFieldHas("single_nested_message",
+                                                       Eq(false))));
+  EXPECT_THAT(value, StructValueIs(StructValueFieldIs(&value_manager(),
+                                                      "single_nested_enum",
+                                                      IntValueIs(Eq(1)))));
+}
+
+TEST_P(ProtoValueWrapTest, LazyWholeMessageOperations) {
+  TestAllTypes message =
+      ParseTextOrDie<TestAllTypes>(R"pb(single_int32: 1, single_int64: 2)pb");
+  ASSERT_OK_AND_ASSIGN(auto value,
+                       ProtoMessageToLazyValue<TestAllTypes>(
+                           value_manager(), message.SerializeAsCord()));
+  ASSERT_OK_AND_ASSIGN(auto parsed,
+                       ProtoMessageToValue(value_manager(), message));
+
+  EXPECT_THAT(value.Equal(value_manager(), parsed),
+              IsOkAndHolds(BoolValueIs(true)));
+  EXPECT_THAT(parsed.Equal(value_manager(), value),
+              IsOkAndHolds(BoolValueIs(true)));
+  EXPECT_THAT(value.DebugString(),
+              AllOf(HasSubstr("single_int32:"), HasSubstr("single_int64:")));
+
+  std::vector<std::string> fields;
+  auto cb = [&fields](absl::string_view field,
+                      ValueView) -> absl::StatusOr<bool> {
+    fields.push_back(std::string(field));
+    return true;
+  };
+  ASSERT_OK(Cast<StructValue>(value).ForEachField(value_manager(), cb));
+  EXPECT_THAT(fields, UnorderedElementsAre("single_int32", "single_int64"));
+
+  ASSERT_OK_AND_ASSIGN(auto serialized, value.Serialize(value_manager()));
+  EXPECT_EQ(serialized, message.SerializeAsCord());
+}
+
+TEST_P(ProtoValueWrapTest, LazyMalformed) {
+  ASSERT_OK_AND_ASSIGN(auto value, ProtoMessageToLazyValue<TestAllTypes>(
+                                       value_manager(), absl::Cord("\xff")));
+  EXPECT_THAT(Cast<StructValue>(value).GetFieldByName(value_manager(),
+                                                      "single_int32"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_P(ProtoValueWrapTest, LazyWellKnownType) {
+  google::protobuf::Int64Value message;
+  message.set_value(42);
+  EXPECT_THAT(ProtoMessageToLazyValue<google::protobuf::Int64Value>(
+                  value_manager(), message.SerializeAsCord()),
+              IsOkAndHolds(IntValueIs(Eq(42))));
+}
+
 TEST_P(ProtoValueWrapTest, ProtoInt64MapListKeys) {
   if (memory_management() == MemoryManagement::kReferenceCounting) {
     GTEST_SKIP() << "TODO(uncreated-issue/66): use after free";
@@ -647,6 +809,40 @@ TEST_P(ProtoValueWrapTest, ProtoStringMapListKeys) {
   EXPECT_THAT(key0, StringValueIs("key1"));
 }
 
+TEST_P(ProtoValueWrapTest, ProtoStringMapFind) {
+  if (memory_management() == MemoryManagement::kReferenceCounting) {
+    GTEST_SKIP() << "TODO(uncreated-issue/66): use after free";
+  }
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      ProtoMessageToValue(
+          value_manager(),
+          ParseTextOrDie<TestAllTypes>(
+              R"pb(
+                map_string_int64 { key: "a" value: 1 }
+                map_string_int64 {
+                  key: "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                  value: 2
+                })pb")));
+  ASSERT_OK_AND_ASSIGN(auto map_value,
+                       Cast<StructValue>(value).GetFieldByName(
+                           value_manager(), "map_string_int64"));
+  ASSERT_THAT(map_value, MapValueIs(_));
+  const auto& map = Cast<MapValue>(map_value);
+
+  // A short key looked up after a long one must not match the remainder of
+  // the long key.
+  EXPECT_THAT(map.Get(value_manager(),
+                      StringValue("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa")),
+              IsOkAndHolds(IntValueIs(2)));
+  EXPECT_THAT(map.Get(value_manager(), StringValue("a")),
+              IsOkAndHolds(IntValueIs(1)));
+  EXPECT_THAT(map.Has(value_manager(), StringValue("aa")),
+              IsOkAndHolds(BoolValueIs(false)));
+  EXPECT_THAT(map.Has(value_manager(), IntValue(1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST_P(ProtoValueWrapTest, ProtoMapDebugString) {
   ASSERT_OK_AND_ASSIGN(
       auto value,
@@ -783,6 +979,66 @@ TEST_P(ProtoValueWrapTest, ProtoListForEachWithIndex) {
               ElementsAre(Pair(0, IntValueIs(1)), Pair(1, IntValueIs(2))));
 }
 
+TEST_P(ProtoValueWrapTest, ProtoListForEachStopsEarly) {
+  ASSERT_OK_AND_ASSIGN(
+      auto value,
+      ProtoMessageToValue(value_manager(), ParseTextOrDie<TestAllTypes>(
+                                               R"pb(
+                                                 repeated_float: 1
+                                                 repeated_float: 2
+                                                 repeated_float: 3
+                                               )pb")));
+  ASSERT_OK_AND_ASSIGN(auto field_value,
+                       Cast<StructValue>(value).GetFieldByName(
+                           value_manager(), "repeated_float"));
+
+  ASSERT_THAT(field_value, ListValueIs(_));
+
+  ListValue list_value = Cast<ListValue>(field_value);
+
+  std::vector<Value> elements;
+
+  auto cb = [&elements](ValueView value) -> absl::StatusOr<bool> {
+    elements.push_back(Value{value});
+    return elements.size() < 2;
+  };
+
+  ASSERT_OK(list_value.ForEach(value_manager(), cb));
+
+  EXPECT_THAT(elements, ElementsAre(DoubleValueIs(1), DoubleValueIs(2)));
+}
+
+TEST_P(ProtoValueWrapTest, ProtoStringListForEach) {
+  std::vector<Value> elements;
+  {
+    ASSERT_OK_AND_ASSIGN(
+        auto value,
+        ProtoMessageToValue(value_manager(), ParseTextOrDie<TestAllTypes>(
+                                                 R"pb(
+                                                   repeated_string: "foo"
+                                                   repeated_string: "bar"
+                                                   repeated_bytes: "baz"
+                                                 )pb")));
+    ASSERT_OK_AND_ASSIGN(auto strings, Cast<StructValue>(value).GetFieldByName(
+                                           value_manager(), "repeated_string"));
+    ASSERT_OK_AND_ASSIGN(auto bytes, Cast<StructValue>(value).GetFieldByName(
+                                         value_manager(), "repeated_bytes"));
+
+    auto cb = [&elements](ValueView value) -> absl::StatusOr<bool> {
+      elements.push_back(Value{value});
+      return true;
+    };
+
+    ASSERT_OK(Cast<ListValue>(strings).ForEach(value_manager(), cb));
+    ASSERT_OK(Cast<ListValue>(bytes).ForEach(value_manager(), cb));
+  }
+
+  // The elements are views of the fields during iteration, and must be
+  // copied when kept past the lifetime of the list.
+  EXPECT_THAT(elements, ElementsAre(StringValueIs("foo"), StringValueIs("bar"),
+                                    BytesValueIs("baz")));
+}
+
 TEST_P(ProtoValueWrapTest, ProtoListDebugString) {
   ASSERT_OK_AND_ASSIGN(
       auto value,
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+
 #include "extensions/regex_functions.h"
 
 #include <memory>
@@ -20,89 +21,108 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
-#include "eval/public/cel_function.h"
+#include "base/function.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/public/cel_function_registry.h"
 #include "eval/public/cel_options.h"
-#include "eval/public/cel_value.h"
-#include "eval/public/containers/container_backed_map_impl.h"
-#include "eval/public/portable_cel_function_adapter.h"
+#include "internal/regex_cache.h"
+#include "internal/status_macros.h"
+#include "runtime/function_adapter.h"
+#include "runtime/function_registry.h"
+#include "runtime/runtime_options.h"
 #include "re2/re2.h"
 
 namespace cel::extensions {
 namespace {
 
-using ::google::api::expr::runtime::CelFunction;
-using ::google::api::expr::runtime::CelFunctionRegistry;
-using ::google::api::expr::runtime::CelValue;
-using ::google::api::expr::runtime::CreateErrorValue;
-using ::google::api::expr::runtime::InterpreterOptions;
-using ::google::api::expr::runtime::PortableBinaryFunctionAdapter;
-using ::google::api::expr::runtime::PortableFunctionAdapter;
-using ::google::protobuf::Arena;
+// Applies a compiled pattern to the string arguments of a call. The pattern
+// is always the second argument.
+using RegexImpl = absl::StatusOr<Value> (*)(ValueManager& value_factory,
+                                            const RE2& re2,
+                                            absl::Span<const Value> args);
+
+// Returns `capture`, a view into `text` holding the contents of `target`, as a
+// string sharing the storage of `target` rather than a copy.
+StringValue CaptureValue(const StringValue& target, absl::string_view text,
+                         absl::string_view capture) {
+  if (capture.data() == nullptr) {
+    // Optional group which did not participate in the match.
+    return StringValue();
+  }
+  return StringValue(common_internal::AsSharedByteString(target).Substring(
+      static_cast<size_t>(capture.data() - text.data()), capture.size()));
+}
 
 // Extract matched group values from the given target string and rewrite the
 // string
-CelValue ExtractString(Arena* arena, CelValue::StringHolder target,
-                       CelValue::StringHolder regex,
-                       CelValue::StringHolder rewrite) {
-  RE2 re2(regex.value());
+absl::StatusOr<Value> ExtractString(ValueManager& value_factory,
+                                    const RE2& re2,
+                                    absl::Span<const Value> args) {
   if (!re2.ok()) {
-    return CreateErrorValue(
-        arena, absl::InvalidArgumentError("Given Regex is Invalid"));
+    return value_factory.CreateErrorValue(
+        absl::InvalidArgumentError("Given Regex is Invalid"));
   }
+  std::string target_scratch;
+  std::string rewrite_scratch;
   std::string output;
-  auto result = RE2::Extract(target.value(), re2, rewrite.value(), &output);
+  auto result = RE2::Extract(
+      args[0].As<StringValue>().NativeString(target_scratch), re2,
+      args[2].As<StringValue>().NativeString(rewrite_scratch), &output);
   if (!result) {
-    return CreateErrorValue(
-        arena, absl::InvalidArgumentError(
-                   "Unable to extract string for the given regex"));
+    return value_factory.CreateErrorValue(absl::InvalidArgumentError(
+        "Unable to extract string for the given regex"));
   }
-  return CelValue::CreateString(
-      google::protobuf::Arena::Create<std::string>(arena, output));
+  return value_factory.CreateUncheckedStringValue(std::move(output));
 }
 
 // Captures the first unnamed/named group value
 // NOTE: For capturing all the groups, use CaptureStringN instead
-CelValue CaptureString(Arena* arena, CelValue::StringHolder target,
-                       CelValue::StringHolder regex) {
-  RE2 re2(regex.value());
+absl::StatusOr<Value> CaptureString(ValueManager& value_factory,
+                                    const RE2& re2,
+                                    absl::Span<const Value> args) {
   if (!re2.ok()) {
-    return CreateErrorValue(
-        arena, absl::InvalidArgumentError("Given Regex is Invalid"));
+    return value_factory.CreateErrorValue(
+        absl::InvalidArgumentError("Given Regex is Invalid"));
   }
-  std::string output;
-  auto result = RE2::FullMatch(target.value(), re2, &output);
+  const StringValue& target = args[0].As<StringValue>();
+  std::string scratch;
+  absl::string_view text = target.NativeString(scratch);
+  absl::string_view capture;
+  auto result = RE2::FullMatch(text, re2, &capture);
   if (!result) {
-    return CreateErrorValue(
-        arena, absl::InvalidArgumentError(
-                   "Unable to capture groups for the given regex"));
-  } else {
-    auto cel_value = CelValue::CreateString(
-        google::protobuf::Arena::Create<std::string>(arena, output));
-    return cel_value;
+    return value_factory.CreateErrorValue(absl::InvalidArgumentError(
+        "Unable to capture groups for the given regex"));
   }
+  return CaptureValue(target, text, capture);
 }
 
 // Does a FullMatchN on the given string and regex and returns a map with <key,
 // value> pairs as follows:
 //   a. For a named group - <named_group_name, captured_string>
 //   b. For an unnamed group - <group_index, captured_string>
-CelValue CaptureStringN(Arena* arena, CelValue::StringHolder target,
-                        CelValue::StringHolder regex) {
-  RE2 re2(regex.value());
+absl::StatusOr<Value> CaptureStringN(ValueManager& value_factory,
+                                     const RE2& re2,
+                                     absl::Span<const Value> args) {
   if (!re2.ok()) {
-    return CreateErrorValue(
-        arena, absl::InvalidArgumentError("Given Regex is Invalid"));
+    return value_factory.CreateErrorValue(
+        absl::InvalidArgumentError("Given Regex is Invalid"));
   }
   const int capturing_groups_count = re2.NumberOfCapturingGroups();
   const auto& named_capturing_groups_map = re2.CapturingGroupNames();
   if (capturing_groups_count <= 0) {
-    return CreateErrorValue(arena,
-                            absl::InvalidArgumentError(
-                                "Capturing groups were not found in the given "
-                                "regex."));
+    return value_factory.CreateErrorValue(absl::InvalidArgumentError(
+        "Capturing groups were not found in the given regex."));
   }
-  std::vector<std::string> captured_strings(capturing_groups_count);
+  const StringValue& target = args[0].As<StringValue>();
+  std::string scratch;
+  absl::string_view text = target.NativeString(scratch);
+  std::vector<absl::string_view> captured_strings(capturing_groups_count);
   std::vector<RE2::Arg> captured_string_addresses(capturing_groups_count);
   std::vector<RE2::Arg*> argv(capturing_groups_count);
   for (int j = 0; j < capturing_groups_count; j++) {
@@ -110,75 +130,142 @@ CelValue CaptureStringN(Arena* arena, CelValue::StringHolder target,
     argv[j] = &captured_string_addresses[j];
   }
   auto result =
-      RE2::FullMatchN(target.value(), re2, argv.data(), capturing_groups_count);
+      RE2::FullMatchN(text, re2, argv.data(), capturing_groups_count);
   if (!result) {
-    return CreateErrorValue(
-        arena, absl::InvalidArgumentError(
-                   "Unable to capture groups for the given regex"));
+    return value_factory.CreateErrorValue(absl::InvalidArgumentError(
+        "Unable to capture groups for the given regex"));
   }
-  std::vector<std::pair<CelValue, CelValue>> cel_values;
+  CEL_ASSIGN_OR_RETURN(auto builder,
+                       value_factory.NewMapValueBuilder(MapTypeView{}));
+  builder->Reserve(capturing_groups_count);
   for (int index = 1; index <= capturing_groups_count; index++) {
     auto it = named_capturing_groups_map.find(index);
     std::string name = it != named_capturing_groups_map.end()
                            ? it->second
                            : std::to_string(index);
-    cel_values.emplace_back(
-        CelValue::CreateString(google::protobuf::Arena::Create<std::string>(arena, name)),
-        CelValue::CreateString(google::protobuf::Arena::Create<std::string>(
-            arena, captured_strings[index - 1])));
+    CEL_RETURN_IF_ERROR(builder->Put(
+        value_factory.CreateUncheckedStringValue(std::move(name)),
+        CaptureValue(target, text, captured_strings[index - 1])));
   }
-  auto container_map = google::api::expr::runtime::CreateContainerBackedMap(
-      absl::MakeSpan(cel_values));
-
-  // Release ownership of container_map to Arena.
-  ::google::api::expr::runtime::CelMap* cel_map = container_map->release();
-  arena->Own(cel_map);
-  return CelValue::CreateMap(cel_map);
+  return std::move(*builder).Build();
 }
 
-absl::Status RegisterRegexFunctions(CelFunctionRegistry* registry) {
+// Implements the regex extension functions. The pattern is compiled on each
+// call, or fetched from the shared regex cache if it is enabled. A constant
+// pattern is compiled once when the program is planned instead.
+class RegexFunction : public Function {
+ public:
+  RegexFunction(RegexImpl impl, bool use_cache)
+      : impl_(impl), use_cache_(use_cache) {}
+
+  absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                               absl::Span<const Value> args) const override {
+    CEL_RETURN_IF_ERROR(CheckArgs(args));
+    std::string scratch;
+    absl::string_view pattern = args[1].As<StringValue>().NativeString(scratch);
+    if (use_cache_) {
+      std::shared_ptr<const RE2> re2 =
+          internal::RegexCache::Global().GetOrCompile(pattern);
+      return impl_(context.value_factory(), *re2, args);
+    }
+    RE2 re2(pattern);
+    return impl_(context.value_factory(), re2, args);
+  }
+
+  absl::StatusOr<std::unique_ptr<Function>> Specialize(
+      ValueManager& value_factory,
+      absl::Span<const absl::optional<Value>> constant_args) const override {
+    if (constant_args.size() < 2 || !constant_args[1].has_value() ||
+        !constant_args[1]->Is<StringValue>()) {
+      return nullptr;
+    }
+    std::string pattern = constant_args[1]->As<StringValue>().NativeString();
+    std::shared_ptr<const RE2> re2 =
+        use_cache_ ? internal::RegexCache::Global().GetOrCompile(pattern)
+                   : std::make_shared<const RE2>(pattern);
+    if (!re2->ok()) {
+      // Left to report the error on each call.
+      return nullptr;
+    }
+    return std::make_unique<BoundRegexFunction>(impl_, std::move(re2));
+  }
+
+ private:
+  // Specialization for a constant pattern.
+  class BoundRegexFunction : public Function {
+   public:
+    BoundRegexFunction(RegexImpl impl, std::shared_ptr<const RE2> re2)
+        : impl_(impl), re2_(std::move(re2)) {}
+
+    absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                                 absl::Span<const Value> args) const override {
+      CEL_RETURN_IF_ERROR(CheckArgs(args));
+      return impl_(context.value_factory(), *re2_, args);
+    }
+
+   private:
+    RegexImpl impl_;
+    std::shared_ptr<const RE2> re2_;
+  };
+
+  static absl::Status CheckArgs(absl::Span<const Value> args) {
+    if (args.size() < 2 || args.size() > 3) {
+      return absl::InvalidArgumentError(
+          "unexpected number of arguments for regex function");
+    }
+    for (const Value& arg : args) {
+      if (!arg.Is<StringValue>()) {
+        return absl::InvalidArgumentError(
+            "unexpected argument types for regex function");
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  RegexImpl impl_;
+  bool use_cache_;
+};
+
+}  // namespace
+
+absl::Status RegisterRegexFunctions(FunctionRegistry& registry,
+                                    const RuntimeOptions& options) {
+  if (!options.enable_regex) {
+    return absl::OkStatus();
+  }
+  const bool use_cache = options.regex_cache_capacity > 0;
+  if (use_cache) {
+    internal::RegexCache::Global().EnsureCapacity(
+        options.regex_cache_capacity);
+  }
+
   // Register Regex Extract Function
-  CEL_RETURN_IF_ERROR(
-      (PortableFunctionAdapter<CelValue, CelValue::StringHolder,
-                               CelValue::StringHolder, CelValue::StringHolder>::
-           CreateAndRegister(
-               kRegexExtract, /*receiver_type=*/false,
-               [](Arena* arena, CelValue::StringHolder target,
-                  CelValue::StringHolder regex,
-                  CelValue::StringHolder rewrite) -> CelValue {
-                 return ExtractString(arena, target, regex, rewrite);
-               },
-               registry)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      VariadicFunctionAdapter<absl::StatusOr<Value>, StringValue, StringValue,
+                              StringValue>::CreateDescriptor(kRegexExtract,
+                                                             /*receiver_style=*/
+                                                             false),
+      std::make_unique<RegexFunction>(&ExtractString, use_cache)));
 
   // Register Regex Captures Function
-  CEL_RETURN_IF_ERROR(registry->Register(
-      PortableBinaryFunctionAdapter<CelValue, CelValue::StringHolder,
-                                    CelValue::StringHolder>::
-          Create(kRegexCapture, /*receiver_style=*/false,
-                 [](Arena* arena, CelValue::StringHolder target,
-                    CelValue::StringHolder regex) -> CelValue {
-                   return CaptureString(arena, target, regex);
-                 })));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      BinaryFunctionAdapter<absl::StatusOr<Value>, StringValue, StringValue>::
+          CreateDescriptor(kRegexCapture, /*receiver_style=*/false),
+      std::make_unique<RegexFunction>(&CaptureString, use_cache)));
 
   // Register Regex CaptureN Function
-  return registry->Register(
-      PortableBinaryFunctionAdapter<CelValue, CelValue::StringHolder,
-                                    CelValue::StringHolder>::
-          Create(kRegexCaptureN, /*receiver_style=*/false,
-                 [](Arena* arena, CelValue::StringHolder target,
-                    CelValue::StringHolder regex) -> CelValue {
-                   return CaptureStringN(arena, target, regex);
-                 }));
+  return registry.Register(
+      BinaryFunctionAdapter<absl::StatusOr<Value>, StringValue, StringValue>::
+          CreateDescriptor(kRegexCaptureN, /*receiver_style=*/false),
+      std::make_unique<RegexFunction>(&CaptureStringN, use_cache));
 }
 
-}  // namespace
-
-absl::Status RegisterRegexFunctions(CelFunctionRegistry* registry,
-                                    const InterpreterOptions& options) {
-  if (options.enable_regex) {
-    CEL_RETURN_IF_ERROR(RegisterRegexFunctions(registry));
-  }
-  return absl::OkStatus();
+absl::Status RegisterRegexFunctions(
+    google::api::expr::runtime::CelFunctionRegistry* registry,
+    const google::api::expr::runtime::InterpreterOptions& options) {
+  return RegisterRegexFunctions(
+      registry->InternalGetRegistry(),
+      google::api::expr::runtime::ConvertToRuntimeOptions(options));
 }
 
 }  // namespace cel::extensions
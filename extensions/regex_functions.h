@@ -16,8 +16,11 @@
 #define THIRD_PARTY_CEL_CPP_EXTENSIONS_REGEX_FUNCTIONS_H_
 
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "eval/public/cel_function_registry.h"
 #include "eval/public/cel_options.h"
+#include "runtime/function_registry.h"
+#include "runtime/runtime_options.h"
 
 namespace cel::extensions {
 
@@ -27,6 +30,15 @@ constexpr absl::string_view kRegexCaptureN = "re.captureN";
 
 // Register Extract and Capture Functions for RE2
 // Requires options.enable_regex to be true
+//
+// Constant patterns are compiled once when the program is planned if function
+// specialization is enabled (see runtime/function_specialization.h). Other
+// patterns are shared through the regex cache if
+// options.regex_cache_capacity is set. Captured groups share the storage of
+// the target string.
+absl::Status RegisterRegexFunctions(FunctionRegistry& registry,
+                                    const RuntimeOptions& options);
+
 absl::Status RegisterRegexFunctions(
     google::api::expr::runtime::CelFunctionRegistry* registry,
     const google::api::expr::runtime::InterpreterOptions& options);
@@ -19,18 +19,33 @@
 #include <utility>
 #include <vector>
 
+#include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "google/protobuf/arena.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/cord_test_helpers.h"
 #include "absl/types/span.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/values/legacy_value_manager.h"
 #include "eval/public/activation.h"
 #include "eval/public/cel_expr_builder_factory.h"
 #include "eval/public/cel_options.h"
 #include "eval/public/cel_value.h"
 #include "eval/public/containers/container_backed_map_impl.h"
 #include "eval/public/testing/matchers.h"
+#include "extensions/protobuf/runtime_adapter.h"
 #include "internal/testing.h"
+#include "parser/options.h"
 #include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/constant_folding.h"
+#include "runtime/function_specialization.h"
+#include "runtime/reference_resolver.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
 
 namespace cel::extensions {
 
@@ -43,6 +58,8 @@ using ::google::api::expr::parser::Parse;
 using ::google::api::expr::runtime::test::IsCelError;
 using ::google::api::expr::runtime::test::IsCelString;
 using cel::internal::IsOkAndHolds;
+using ::google::api::expr::parser::ParserOptions;
+using ::google::api::expr::v1alpha1::ParsedExpr;
 
 struct TestCase {
   const std::string expr_string;
@@ -246,6 +263,90 @@ TEST_P(RegexFunctionsTest, RegexFunctionsTests) {
 INSTANTIATE_TEST_SUITE_P(RegexFunctionsTest, RegexFunctionsTest,
                          testing::ValuesIn(createParams()));
 
+// Runs the regex functions on the modern runtime, with and without constant
+// patterns compiled at plan time.
+class RegexFunctionsRuntimeTest : public testing::TestWithParam<bool> {
+ protected:
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 const Activation& activation) {
+    RuntimeOptions options;
+    options.enable_regex = true;
+    CEL_ASSIGN_OR_RETURN(auto builder, CreateStandardRuntimeBuilder(options));
+    CEL_RETURN_IF_ERROR(
+        RegisterRegexFunctions(builder.function_registry(), options));
+    // Resolves `re.capture(...)` to the namespaced function.
+    CEL_RETURN_IF_ERROR(
+        EnableReferenceResolver(builder, ReferenceResolverEnabled::kAlways));
+    if (GetParam()) {
+      CEL_RETURN_IF_ERROR(EnableConstantFolding(builder, memory_manager_));
+      CEL_RETURN_IF_ERROR(EnableFunctionSpecialization(builder));
+    }
+    CEL_ASSIGN_OR_RETURN(auto runtime, std::move(builder).Build());
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr,
+                         Parse(expression, "<input>", ParserOptions{}));
+    CEL_ASSIGN_OR_RETURN(std::unique_ptr<Program> program,
+                         ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+    common_internal::LegacyValueManager value_factory(
+        memory_manager_, runtime->GetTypeProvider());
+    return program->Evaluate(activation, value_factory);
+  }
+
+  MemoryManagerRef memory_manager_ = MemoryManagerRef::ReferenceCounting();
+};
+
+TEST_P(RegexFunctionsRuntimeTest, CapturesFromCord) {
+  Activation activation;
+  activation.InsertOrAssignValue(
+      "target", StringValue{absl::MakeFragmentedCord(
+                    {"The user test", "user belongs to test", "domain"})});
+
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("re.capture(target, 'The user (.*) belongs.*') == 'testuser' && "
+               "re.captureN(target, "
+               "'The (user|domain) (?P<Username>.*) belongs to (.*)') == "
+               "{'1': 'user', 'Username': 'testuser', '3': 'testdomain'} && "
+               "re.extract(target, '.* (\\w+)$', 'in \\1') == "
+               "'in testdomain'",
+               activation));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexFunctionsRuntimeTest, UnmatchedOptionalGroupIsEmpty) {
+  Activation activation;
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("re.captureN('ab', '(a)(x)?(b)') == {'1': 'a', '2': '', '3': "
+               "'b'}",
+               activation));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(RegexFunctionsRuntimeTest, InvalidConstantPatternIsAnError) {
+  Activation activation;
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Evaluate("re.capture('foo', 'fo(o+)(abc')", activation));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("Regex is Invalid")));
+}
+
+TEST_P(RegexFunctionsRuntimeTest, DynamicPattern) {
+  Activation activation;
+  activation.InsertOrAssignValue("pattern", StringValue("f(o+)"));
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("re.capture('foo', pattern) == 'oo'", activation));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+INSTANTIATE_TEST_SUITE_P(RegexFunctionsRuntimeTest, RegexFunctionsRuntimeTest,
+                         /*specialize=*/testing::Bool());
+
 }  // namespace
 
 }  // namespace cel::extensions
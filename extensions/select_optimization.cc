@@ -14,6 +14,7 @@
 
 #include "extensions/select_optimization.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
@@ -245,6 +246,26 @@ absl::StatusOr<Value> MapKeyFromQualifier(const AttributeQualifier& qual,
   }
 }
 
+// Reads the field using the field number resolved at plan time, avoiding a
+// lookup by name. Legacy struct values only support access by name.
+absl::StatusOr<Value> GetStructField(const StructValue& struct_value,
+                                     const FieldSpecifier& field_specifier,
+                                     ValueManager& value_factory) {
+  if (InstanceOf<ParsedStructValue>(struct_value)) {
+    return struct_value.GetFieldByNumber(value_factory,
+                                         field_specifier.number);
+  }
+  return struct_value.GetFieldByName(value_factory, field_specifier.name);
+}
+
+absl::StatusOr<bool> HasStructField(const StructValue& struct_value,
+                                    const FieldSpecifier& field_specifier) {
+  if (InstanceOf<ParsedStructValue>(struct_value)) {
+    return struct_value.HasFieldByNumber(field_specifier.number);
+  }
+  return struct_value.HasFieldByName(field_specifier.name);
+}
+
 absl::StatusOr<Value> ApplyQualifier(const Value& operand,
                                      const SelectQualifier& qualifier,
                                      ValueManager& value_factory) {
@@ -256,8 +277,8 @@ absl::StatusOr<Value> ApplyQualifier(const Value& operand,
                   cel::runtime_internal::CreateNoMatchingOverloadError(
                       "<select>"));
             }
-            return operand.As<StructValue>().GetFieldByName(
-                value_factory, field_specifier.name);
+            return GetStructField(operand.As<StructValue>(), field_specifier,
+                                  value_factory);
           },
           [&](const AttributeQualifier& qualifier) -> absl::StatusOr<Value> {
             if (operand.Is<ListValue>()) {
@@ -280,6 +301,35 @@ absl::StatusOr<Value> ApplyQualifier(const Value& operand,
       qualifier);
 }
 
+absl::StatusOr<Value> TestPresence(const Value& operand,
+                                   const SelectQualifier& qualifier,
+                                   ValueManager& value_factory) {
+  return absl::visit(
+      absl::Overload(
+          [&](const FieldSpecifier& field_specifier) -> absl::StatusOr<Value> {
+            if (!operand.Is<StructValue>()) {
+              return value_factory.CreateErrorValue(
+                  cel::runtime_internal::CreateNoMatchingOverloadError(
+                      "<select>"));
+            }
+            CEL_ASSIGN_OR_RETURN(
+                bool present,
+                HasStructField(operand.As<StructValue>(), field_specifier));
+            return value_factory.CreateBoolValue(present);
+          },
+          [&](const AttributeQualifier& qualifier) -> absl::StatusOr<Value> {
+            if (!operand.Is<MapValue>() || qualifier.kind() != Kind::kString) {
+              return value_factory.CreateErrorValue(
+                  cel::runtime_internal::CreateNoMatchingOverloadError("has"));
+            }
+
+            return operand.As<MapValue>().Has(
+                value_factory, value_factory.CreateUncheckedStringValue(
+                                   std::string(*qualifier.GetStringKey())));
+          }),
+      qualifier);
+}
+
 absl::StatusOr<Value> FallbackSelect(
     const Value& root, absl::Span<const SelectQualifier> select_path,
     bool presence_test, ValueManager& value_factory) {
@@ -298,32 +348,7 @@ absl::StatusOr<Value> FallbackSelect(
 
   const auto& last_instruction = select_path.back();
   if (presence_test) {
-    return absl::visit(
-        absl::Overload(
-            [&](const FieldSpecifier& field_specifier)
-                -> absl::StatusOr<Value> {
-              if (!elem->Is<StructValue>()) {
-                return value_factory.CreateErrorValue(
-                    cel::runtime_internal::CreateNoMatchingOverloadError(
-                        "<select>"));
-              }
-              CEL_ASSIGN_OR_RETURN(
-                  bool present,
-                  elem->As<StructValue>().HasFieldByName(field_specifier.name));
-              return value_factory.CreateBoolValue(present);
-            },
-            [&](const AttributeQualifier& qualifier) -> absl::StatusOr<Value> {
-              if (!elem->Is<MapValue>() || qualifier.kind() != Kind::kString) {
-                return value_factory.CreateErrorValue(
-                    cel::runtime_internal::CreateNoMatchingOverloadError(
-                        "has"));
-              }
-
-              return elem->As<MapValue>().Has(
-                  value_factory, value_factory.CreateUncheckedStringValue(
-                                     std::string(*qualifier.GetStringKey())));
-            }),
-        last_instruction);
+    return TestPresence(*elem, last_instruction, value_factory);
   }
 
   return ApplyQualifier(*elem, last_instruction, value_factory);
@@ -362,6 +387,85 @@ absl::StatusOr<std::vector<SelectQualifier>> SelectInstructionsFromCall(
   return instructions;
 }
 
+// Returns the path lengths that need a presence test for a fused
+// @cel.hasFieldChain call. The lengths are strictly increasing and the last
+// one covers the full path.
+absl::StatusOr<std::vector<size_t>> PresenceLevelsFromCall(
+    const ast_internal::Call& call, size_t path_size) {
+  if (call.args().size() != 3 || !call.args()[2].has_list_expr()) {
+    return absl::InvalidArgumentError("Invalid cel.hasFieldChain call");
+  }
+  std::vector<size_t> levels;
+  const auto& ast_levels = call.args()[2].list_expr().elements();
+  levels.reserve(ast_levels.size());
+  for (const ListExprElement& element : ast_levels) {
+    if (!element.has_expr() || !element.expr().has_const_expr() ||
+        !element.expr().const_expr().has_int64_value()) {
+      return absl::InvalidArgumentError("Invalid cel.hasFieldChain level");
+    }
+    int64_t level = element.expr().const_expr().int64_value();
+    if (level <= 0 || level > static_cast<int64_t>(path_size) ||
+        (!levels.empty() && static_cast<size_t>(level) <= levels.back())) {
+      return absl::InvalidArgumentError("Invalid cel.hasFieldChain level");
+    }
+    levels.push_back(static_cast<size_t>(level));
+  }
+  if (levels.empty() || levels.back() != path_size) {
+    return absl::InvalidArgumentError("Invalid cel.hasFieldChain levels");
+  }
+  return levels;
+}
+
+// A presence test, or a fused chain of presence tests, over a message field
+// path rooted at an identifier.
+struct PresenceChain {
+  absl::string_view root;
+  const std::vector<ListExprElement>* path;
+  std::vector<int64_t> levels;
+};
+
+// Matches a rewritten @cel.hasField or @cel.hasFieldChain call whose path only
+// traverses message fields.
+absl::optional<PresenceChain> GetPresenceChain(const Expr& expr) {
+  if (!expr.has_call_expr()) {
+    return absl::nullopt;
+  }
+  const auto& call = expr.call_expr();
+  bool fused = call.function() == kFieldsHasChain;
+  if (!fused && call.function() != kFieldsHas) {
+    return absl::nullopt;
+  }
+  if (call.args().size() != (fused ? 3 : 2) ||
+      !call.args()[0].has_ident_expr() || !call.args()[1].has_list_expr()) {
+    return absl::nullopt;
+  }
+  PresenceChain chain;
+  chain.root = call.args()[0].ident_expr().name();
+  chain.path = &call.args()[1].list_expr().elements();
+  for (const ListExprElement& element : *chain.path) {
+    if (!element.has_expr() || !element.expr().has_list_expr()) {
+      return absl::nullopt;
+    }
+  }
+  if (!fused) {
+    chain.levels.push_back(static_cast<int64_t>(chain.path->size()));
+    return chain;
+  }
+  for (const ListExprElement& element : call.args()[2].list_expr().elements()) {
+    chain.levels.push_back(element.expr().const_expr().int64_value());
+  }
+  return chain;
+}
+
+// Compares two field specifiers generated by MakeSelectPathExpr.
+bool SameField(const ListExprElement& lhs, const ListExprElement& rhs) {
+  const auto& lhs_field = lhs.expr().list_expr().elements();
+  const auto& rhs_field = rhs.expr().list_expr().elements();
+  return lhs_field.size() == 2 && rhs_field.size() == 2 &&
+         lhs_field[0].expr().const_expr() == rhs_field[0].expr().const_expr() &&
+         lhs_field[1].expr().const_expr() == rhs_field[1].expr().const_expr();
+}
+
 class RewriterImpl : public AstRewriterBase {
  public:
   RewriterImpl(const AstImpl& ast, PlannerContext& planner_context)
@@ -418,6 +522,10 @@ class RewriterImpl : public AstRewriterBase {
       return false;
     }
     path_.pop_back();
+    if (expr.has_call_expr() &&
+        expr.call_expr().function() == ::cel::builtin::kAnd) {
+      return FusePresenceTests(expr);
+    }
     auto candidate_iter = candidates_.find(&expr);
     if (candidate_iter == candidates_.end()) {
       return false;
@@ -460,6 +568,55 @@ class RewriterImpl : public AstRewriterBase {
   absl::Status GetProgressStatus() const { return progress_status_; }
 
  private:
+  // Fuses `has(a.b) && has(a.b.c)` into a single @cel.hasFieldChain call that
+  // walks the longest path once, testing presence at each requested level.
+  //
+  // The operands have already been rewritten, so nested conjunctions fuse
+  // bottom up. Only message field paths are fused: an unset message field
+  // reads as the default instance, so the walk can continue through it and
+  // the first absent level decides the whole conjunction.
+  bool FusePresenceTests(Expr& expr) {
+    auto& args = expr.mutable_call_expr().mutable_args();
+    if (args.size() != 2) {
+      return false;
+    }
+    absl::optional<PresenceChain> lhs = GetPresenceChain(args[0]);
+    absl::optional<PresenceChain> rhs = GetPresenceChain(args[1]);
+    if (!lhs.has_value() || !rhs.has_value() || lhs->root != rhs->root) {
+      return false;
+    }
+    size_t longer = lhs->path->size() >= rhs->path->size() ? 0 : 1;
+    const PresenceChain& long_chain = longer == 0 ? *lhs : *rhs;
+    const PresenceChain& short_chain = longer == 0 ? *rhs : *lhs;
+    for (size_t i = 0; i < short_chain.path->size(); ++i) {
+      if (!SameField((*short_chain.path)[i], (*long_chain.path)[i])) {
+        return false;
+      }
+    }
+
+    std::vector<int64_t> levels = lhs->levels;
+    levels.insert(levels.end(), rhs->levels.begin(), rhs->levels.end());
+    absl::c_sort(levels);
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+    auto& long_args = args[longer].mutable_call_expr().mutable_args();
+    Expr call;
+    call.set_id(expr.id());
+    call.mutable_call_expr().set_function(kFieldsHasChain);
+    call.mutable_call_expr().mutable_args().reserve(3);
+    call.mutable_call_expr().mutable_args().push_back(std::move(long_args[0]));
+    call.mutable_call_expr().mutable_args().push_back(std::move(long_args[1]));
+    Expr& ast_levels = call.mutable_call_expr().mutable_args().emplace_back();
+    for (int64_t level : levels) {
+      Expr const_expr;
+      const_expr.mutable_const_expr().set_int64_value(level);
+      ast_levels.mutable_list_expr().mutable_elements().emplace_back().set_expr(
+          std::move(const_expr));
+    }
+    expr = std::move(call);
+    return true;
+  }
+
   SelectPath GetSelectPath(Expr* expr) {
     SelectPath result;
     result.test_only = false;
@@ -529,10 +686,12 @@ class OptimizedSelectImpl {
  public:
   OptimizedSelectImpl(std::vector<SelectQualifier> select_path,
                       std::vector<AttributeQualifier> qualifiers,
-                      bool presence_test, SelectOptimizationOptions options)
+                      bool presence_test, SelectOptimizationOptions options,
+                      std::vector<size_t> presence_levels = {})
       : select_path_(std::move(select_path)),
         qualifiers_(std::move(qualifiers)),
         presence_test_(presence_test),
+        presence_levels_(std::move(presence_levels)),
         options_(options)
 
   {
@@ -548,6 +707,15 @@ class OptimizedSelectImpl {
   absl::StatusOr<Value> ApplySelect(ExecutionFrameBase& frame,
                                     const StructValue& struct_value) const;
 
+  // Evaluates a fused chain of presence tests in one walk of the path.
+  // Unknown and missing attributes are checked at each tested level, so the
+  // result matches the unfused conjunction.
+  absl::StatusOr<Value> ApplyPresenceChain(
+      ExecutionFrameBase& frame, const StructValue& struct_value,
+      const AttributeTrail& operand_trail) const;
+
+  bool is_presence_chain() const { return !presence_levels_.empty(); }
+
   AttributeTrail GetAttributeTrail(const AttributeTrail& operand_trail) const;
 
   absl::optional<Attribute> attribute() const { return attribute_; }
@@ -561,6 +729,9 @@ class OptimizedSelectImpl {
   std::vector<SelectQualifier> select_path_;
   std::vector<AttributeQualifier> qualifiers_;
   bool presence_test_;
+  // Path lengths tested for presence by a fused @cel.hasFieldChain. Empty for
+  // a plain select or presence test.
+  std::vector<size_t> presence_levels_;
   SelectOptimizationOptions options_;
 };
 
@@ -621,19 +792,60 @@ absl::StatusOr<Value> OptimizedSelectImpl::ApplySelect(
       presence_test_, frame.value_manager());
 }
 
+absl::StatusOr<Value> OptimizedSelectImpl::ApplyPresenceChain(
+    ExecutionFrameBase& frame, const StructValue& struct_value,
+    const AttributeTrail& operand_trail) const {
+  ValueManager& value_factory = frame.value_manager();
+  const bool check_marked =
+      frame.attribute_tracking_enabled() && !operand_trail.empty();
+  AttributeTrail trail;
+  if (check_marked) {
+    trail = operand_trail;
+  }
+  Value elem = struct_value;
+  auto level = presence_levels_.begin();
+  for (size_t i = 0; i < select_path_.size(); ++i) {
+    if (check_marked) {
+      trail = trail.Step(qualifiers_[i]);
+    }
+    if (i + 1 == *level) {
+      if (check_marked) {
+        // A marked level also marks every deeper level, so the remaining
+        // tests can't change the result.
+        CEL_ASSIGN_OR_RETURN(absl::optional<Value> marked,
+                             CheckForMarkedAttributes(frame, trail));
+        if (marked.has_value()) {
+          return std::move(marked).value();
+        }
+      }
+      CEL_ASSIGN_OR_RETURN(
+          Value present, TestPresence(elem, select_path_[i], value_factory));
+      if (!InstanceOf<BoolValue>(present) ||
+          !Cast<BoolValue>(present).NativeValue() ||
+          ++level == presence_levels_.end()) {
+        return present;
+      }
+    }
+    CEL_ASSIGN_OR_RETURN(elem,
+                         ApplyQualifier(elem, select_path_[i], value_factory));
+    if (InstanceOf<ErrorValue>(elem)) {
+      return elem;
+    }
+  }
+  // The last level always covers the full path.
+  return value_factory.CreateBoolValue(true);
+}
+
 AttributeTrail OptimizedSelectImpl::GetAttributeTrail(
     const AttributeTrail& operand_trail) const {
   if (operand_trail.empty()) {
     return AttributeTrail();
   }
-  std::vector<AttributeQualifier> qualifiers = std::vector<AttributeQualifier>(
-      operand_trail.attribute().qualifier_path().begin(),
-      operand_trail.attribute().qualifier_path().end());
-  qualifiers.reserve(qualifiers_.size() + qualifiers.size());
-  absl::c_copy(qualifiers_, std::back_inserter(qualifiers));
-  return AttributeTrail(
-      Attribute(std::string(operand_trail.attribute().variable_name()),
-                std::move(qualifiers)));
+  AttributeTrail trail = operand_trail;
+  for (const AttributeQualifier& qualifier : qualifiers_) {
+    trail = trail.Step(qualifier);
+  }
+  return trail;
 }
 
 class StackMachineImpl : public ExpressionStepBase {
@@ -673,6 +885,19 @@ absl::Status StackMachineImpl::Evaluate(ExecutionFrame* frame) const {
     return absl::OkStatus();
   }
 
+  if (impl_.is_presence_chain()) {
+    if (!operand->Is<StructValue>()) {
+      return absl::InvalidArgumentError(
+          "Expected struct type for select optimization.");
+    }
+    CEL_ASSIGN_OR_RETURN(
+        Value result,
+        impl_.ApplyPresenceChain(*frame, operand->As<StructValue>(),
+                                 frame->value_stack().PeekAttribute()));
+    frame->value_stack().PopAndPush(std::move(result));
+    return absl::OkStatus();
+  }
+
   if (frame->enable_attribute_tracking()) {
     // Compute the attribute trail then check for any marked values.
     // When possible, this is computed at plan time based on the optimized
@@ -736,6 +961,18 @@ absl::Status RecursiveImpl::Evaluate(ExecutionFrameBase& frame, Value& result,
     return absl::OkStatus();
   }
 
+  if (impl_.is_presence_chain()) {
+    if (!InstanceOf<StructValue>(result)) {
+      return absl::InvalidArgumentError(
+          "Expected struct type for select optimization");
+    }
+    CEL_ASSIGN_OR_RETURN(
+        result,
+        impl_.ApplyPresenceChain(frame, Cast<StructValue>(result), attribute));
+    attribute = AttributeTrail();
+    return absl::OkStatus();
+  }
+
   if (frame.attribute_tracking_enabled()) {
     attribute = impl_.GetAttributeTrail(attribute);
     CEL_ASSIGN_OR_RETURN(auto value,
@@ -779,7 +1016,7 @@ absl::Status SelectOptimizer::OnPostVisit(PlannerContext& context,
   }
 
   absl::string_view fn = node.call_expr().function();
-  if (fn != kFieldsHas && fn != kCelAttribute) {
+  if (fn != kFieldsHas && fn != kCelAttribute && fn != kFieldsHasChain) {
     return absl::OkStatus();
   }
 
@@ -788,7 +1025,7 @@ absl::Status SelectOptimizer::OnPostVisit(PlannerContext& context,
     return absl::InvalidArgumentError("Invalid cel.attribute call");
   }
 
-  if (node.call_expr().args().size() == 3) {
+  if (node.call_expr().args().size() == 3 && fn != kFieldsHasChain) {
     return absl::UnimplementedError("Optionals not yet supported");
   }
 
@@ -800,9 +1037,15 @@ absl::Status SelectOptimizer::OnPostVisit(PlannerContext& context,
   }
 
   bool presence_test = false;
+  std::vector<size_t> presence_levels;
 
   if (fn == kFieldsHas) {
     presence_test = true;
+  } else if (fn == kFieldsHasChain) {
+    presence_test = true;
+    CEL_ASSIGN_OR_RETURN(
+        presence_levels,
+        PresenceLevelsFromCall(node.call_expr(), instructions.size()));
   }
 
   const Expr& operand = node.call_expr().args()[0];
@@ -836,7 +1079,7 @@ absl::Status SelectOptimizer::OnPostVisit(PlannerContext& context,
   }
 
   OptimizedSelectImpl impl(std::move(instructions), std::move(qualifiers),
-                           presence_test, options_);
+                           presence_test, options_, std::move(presence_levels));
 
   if (subexpression->IsRecursive()) {
     auto program = subexpression->ExtractRecursiveProgram();
@@ -23,6 +23,9 @@ namespace cel::extensions {
 
 constexpr char kCelAttribute[] = "@cel.attribute";
 constexpr char kFieldsHas[] = "@cel.hasField";
+// Fused conjunction of presence tests along one field path, e.g.
+// `has(a.b) && has(a.b.c)`. The third argument lists the tested path lengths.
+constexpr char kFieldsHasChain[] = "@cel.hasFieldChain";
 
 // Configuration options for the select optimization.
 struct SelectOptimizationOptions {
@@ -0,0 +1,212 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/select_optimization.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/attribute.h"
+#include "eval/public/activation.h"
+#include "eval/public/builtin_func_registrar.h"
+#include "eval/public/cel_expr_builder_factory.h"
+#include "eval/public/cel_expression.h"
+#include "eval/public/cel_options.h"
+#include "eval/public/cel_value.h"
+#include "eval/public/structs/cel_proto_wrapper.h"
+#include "eval/public/unknown_set.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "proto/test/v1/proto2/test_all_types.pb.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::test::v1::proto2::NestedTestAllTypes;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::Expr;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::runtime::Activation;
+using ::google::api::expr::runtime::CelExpressionBuilder;
+using ::google::api::expr::runtime::CelProtoWrapper;
+using ::google::api::expr::runtime::CelValue;
+using ::google::api::expr::runtime::CreateCelExpressionBuilder;
+using ::google::api::expr::runtime::InterpreterOptions;
+using ::google::api::expr::runtime::RegisterBuiltinFunctions;
+using ::google::api::expr::runtime::UnknownProcessingOptions;
+using ::google::protobuf::Arena;
+
+constexpr absl::string_view kNestedType =
+    "google.api.expr.test.v1.proto2.NestedTestAllTypes";
+constexpr absl::string_view kPayloadType =
+    "google.api.expr.test.v1.proto2.TestAllTypes";
+
+// Stands in for the type checker: annotates `msg` and its `child` and
+// `payload` selections with their message types.
+void AnnotateTypes(const Expr& expr, CheckedExpr& checked) {
+  switch (expr.expr_kind_case()) {
+    case Expr::kIdentExpr:
+      if (expr.ident_expr().name() == "msg") {
+        (*checked.mutable_type_map())[expr.id()].set_message_type(kNestedType);
+      }
+      break;
+    case Expr::kSelectExpr:
+      AnnotateTypes(expr.select_expr().operand(), checked);
+      if (expr.select_expr().field() == "child") {
+        (*checked.mutable_type_map())[expr.id()].set_message_type(kNestedType);
+      } else if (expr.select_expr().field() == "payload") {
+        (*checked.mutable_type_map())[expr.id()].set_message_type(
+            kPayloadType);
+      }
+      break;
+    case Expr::kCallExpr:
+      for (const Expr& arg : expr.call_expr().args()) {
+        AnnotateTypes(arg, checked);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+absl::StatusOr<CheckedExpr> MakeCheckedExpr(absl::string_view expression) {
+  CEL_ASSIGN_OR_RETURN(auto parsed, Parse(expression));
+  CheckedExpr checked;
+  *checked.mutable_expr() = parsed.expr();
+  *checked.mutable_source_info() = parsed.source_info();
+  AnnotateTypes(checked.expr(), checked);
+  return checked;
+}
+
+std::unique_ptr<CelExpressionBuilder> MakeBuilder(
+    InterpreterOptions options) {
+  auto builder = CreateCelExpressionBuilder(options);
+  ABSL_CHECK_OK(RegisterBuiltinFunctions(builder->GetRegistry()));
+  return builder;
+}
+
+NestedTestAllTypes MakeMessage(int depth) {
+  NestedTestAllTypes msg;
+  NestedTestAllTypes* elem = &msg;
+  for (int i = 0; i < depth; ++i) {
+    elem = elem->mutable_child();
+  }
+  if (depth > 0) {
+    elem->mutable_payload()->set_single_int64(42);
+  }
+  return msg;
+}
+
+class PresenceChainTest
+    : public testing::TestWithParam<std::tuple<std::string, bool>> {
+ protected:
+  const std::string& expression() { return std::get<0>(GetParam()); }
+  bool enable_recursive_planning() { return std::get<1>(GetParam()); }
+};
+
+TEST_P(PresenceChainTest, MatchesUnoptimized) {
+  ASSERT_OK_AND_ASSIGN(CheckedExpr checked, MakeCheckedExpr(expression()));
+
+  InterpreterOptions options;
+  options.max_recursion_depth = enable_recursive_planning() ? -1 : 0;
+  auto reference_builder = MakeBuilder(options);
+  options.enable_select_optimization = true;
+  auto optimized_builder = MakeBuilder(options);
+
+  ASSERT_OK_AND_ASSIGN(auto reference,
+                       reference_builder->CreateExpression(&checked));
+  ASSERT_OK_AND_ASSIGN(auto optimized,
+                       optimized_builder->CreateExpression(&checked));
+
+  for (int depth = 0; depth <= 3; ++depth) {
+    Arena arena;
+    NestedTestAllTypes msg = MakeMessage(depth);
+    Activation activation;
+    activation.InsertValue("msg", CelProtoWrapper::CreateMessage(&msg, &arena));
+
+    ASSERT_OK_AND_ASSIGN(CelValue expected,
+                         reference->Evaluate(activation, &arena));
+    ASSERT_OK_AND_ASSIGN(CelValue actual,
+                         optimized->Evaluate(activation, &arena));
+    ASSERT_TRUE(expected.IsBool()) << expected.DebugString();
+    ASSERT_TRUE(actual.IsBool()) << actual.DebugString();
+    EXPECT_EQ(actual.BoolOrDie(), expected.BoolOrDie())
+        << expression() << " depth: " << depth;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    PresenceChainTest, PresenceChainTest,
+    testing::Combine(
+        testing::Values(
+            "has(msg.child) && has(msg.child.child)",
+            "has(msg.child.child) && has(msg.child)",
+            "has(msg.child) && has(msg.child.child) && "
+            "has(msg.child.child.payload)",
+            "has(msg.child) && has(msg.child.payload) && "
+            "msg.child.payload.single_int64 == 42",
+            "has(msg.child.child) && has(msg.child.payload)",
+            "has(msg.child) && has(msg.child.child) || has(msg.payload)"),
+        /*enable_recursive_planning=*/testing::Bool()));
+
+class PresenceChainUnknownsTest : public testing::TestWithParam<bool> {};
+
+// The fused walk checks for unknowns level by level, so an absent parent
+// still decides the conjunction before a marked descendant is reached.
+TEST_P(PresenceChainUnknownsTest, AbsentParentShortCircuitsUnknownChild) {
+  ASSERT_OK_AND_ASSIGN(
+      CheckedExpr checked,
+      MakeCheckedExpr("has(msg.child) && has(msg.child.child)"));
+
+  InterpreterOptions options;
+  options.max_recursion_depth = GetParam() ? -1 : 0;
+  options.unknown_processing = UnknownProcessingOptions::kAttributeOnly;
+  options.enable_select_optimization = true;
+  auto builder = MakeBuilder(options);
+  ASSERT_OK_AND_ASSIGN(auto cel_expr, builder->CreateExpression(&checked));
+
+  Arena arena;
+  Activation activation;
+  activation.set_unknown_attribute_patterns({AttributePattern(
+      "msg", {AttributeQualifierPattern::OfString("child"),
+              AttributeQualifierPattern::OfString("child")})});
+
+  NestedTestAllTypes msg;
+  activation.InsertValue("msg", CelProtoWrapper::CreateMessage(&msg, &arena));
+  ASSERT_OK_AND_ASSIGN(CelValue out, cel_expr->Evaluate(activation, &arena));
+  ASSERT_TRUE(out.IsBool()) << out.DebugString();
+  EXPECT_FALSE(out.BoolOrDie());
+
+  msg = MakeMessage(2);
+  ASSERT_OK_AND_ASSIGN(out, cel_expr->Evaluate(activation, &arena));
+  ASSERT_TRUE(out.IsUnknownSet()) << out.DebugString();
+  EXPECT_THAT(out.UnknownSetOrDie()->unknown_attributes(),
+              testing::ElementsAre(
+                  Attribute("msg", {AttributeQualifier::OfString("child"),
+                                    AttributeQualifier::OfString("child")})));
+}
+
+INSTANTIATE_TEST_SUITE_P(PresenceChainUnknownsTest, PresenceChainUnknownsTest,
+                         /*enable_recursive_planning=*/testing::Bool());
+
+}  // namespace
+}  // namespace cel::extensions
@@ -14,6 +14,9 @@
 
 #include "extensions/sets_functions.h"
 
+#include <cstddef>
+#include <memory>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "base/function_adapter.h"
@@ -21,15 +24,83 @@
 #include "common/value_manager.h"
 #include "internal/status_macros.h"
 #include "runtime/function_registry.h"
+#include "runtime/internal/primitive_value_set.h"
 #include "runtime/runtime_options.h"
 
 namespace cel::extensions {
 
 namespace {
 
+using ::cel::runtime_internal::PrimitiveValueSet;
+
+// Below this many element comparisons, scanning the lists directly is cheaper
+// than building a hash set.
+constexpr size_t kMinHashedComparisons = 64;
+
+absl::StatusOr<bool> ShouldHash(const ListValue& lhs, const ListValue& rhs) {
+  CEL_ASSIGN_OR_RETURN(size_t lhs_size, lhs.Size());
+  CEL_ASSIGN_OR_RETURN(size_t rhs_size, rhs.Size());
+  return lhs_size * rhs_size >= kMinHashedComparisons;
+}
+
+// Returns a hash set of the elements of list, or nullptr if any element is not
+// a primitive supported by `PrimitiveValueSet`.
+absl::StatusOr<std::unique_ptr<PrimitiveValueSet>> BuildValueSet(
+    ValueManager& value_factory, const ListValue& list) {
+  auto set = std::make_unique<PrimitiveValueSet>();
+  bool supported = true;
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_factory,
+      [&set, &supported](ValueView element) -> absl::StatusOr<bool> {
+        supported = set->Insert(element);
+        return supported;
+      }));
+  if (!supported) {
+    return nullptr;
+  }
+  return set;
+}
+
+// Returns whether every element of list is in set.
+absl::StatusOr<bool> ContainsAll(ValueManager& value_factory,
+                                 const PrimitiveValueSet& set,
+                                 const ListValue& list) {
+  bool any_missing = false;
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_factory,
+      [&set, &any_missing](ValueView element) -> absl::StatusOr<bool> {
+        any_missing = !set.Contains(element);
+        return !any_missing;
+      }));
+  return !any_missing;
+}
+
+// Returns whether any element of list is in set.
+absl::StatusOr<bool> ContainsAny(ValueManager& value_factory,
+                                 const PrimitiveValueSet& set,
+                                 const ListValue& list) {
+  bool exists = false;
+  CEL_RETURN_IF_ERROR(list.ForEach(
+      value_factory,
+      [&set, &exists](ValueView element) -> absl::StatusOr<bool> {
+        exists = set.Contains(element);
+        return !exists;
+      }));
+  return exists;
+}
+
 absl::StatusOr<Value> SetsContains(ValueManager& value_factory,
                                    const ListValue& list,
                                    const ListValue& sublist) {
+  CEL_ASSIGN_OR_RETURN(bool should_hash, ShouldHash(list, sublist));
+  if (should_hash) {
+    CEL_ASSIGN_OR_RETURN(auto set, BuildValueSet(value_factory, list));
+    if (set != nullptr) {
+      CEL_ASSIGN_OR_RETURN(bool contains,
+                           ContainsAll(value_factory, *set, sublist));
+      return value_factory.CreateBoolValue(contains);
+    }
+  }
   bool any_missing = false;
   CEL_RETURN_IF_ERROR(sublist.ForEach(
       value_factory,
@@ -50,6 +121,21 @@ absl::StatusOr<Value> SetsContains(ValueManager& value_factory,
 absl::StatusOr<Value> SetsIntersects(ValueManager& value_factory,
                                      const ListValue& list,
                                      const ListValue& sublist) {
+  CEL_ASSIGN_OR_RETURN(bool should_hash, ShouldHash(list, sublist));
+  if (should_hash) {
+    // Intersection is symmetric, so either list can be hashed.
+    CEL_ASSIGN_OR_RETURN(auto set, BuildValueSet(value_factory, sublist));
+    if (set != nullptr) {
+      CEL_ASSIGN_OR_RETURN(bool exists, ContainsAny(value_factory, *set, list));
+      return value_factory.CreateBoolValue(exists);
+    }
+    CEL_ASSIGN_OR_RETURN(set, BuildValueSet(value_factory, list));
+    if (set != nullptr) {
+      CEL_ASSIGN_OR_RETURN(bool exists,
+                           ContainsAny(value_factory, *set, sublist));
+      return value_factory.CreateBoolValue(exists);
+    }
+  }
   bool exists = false;
   CEL_RETURN_IF_ERROR(list.ForEach(
       value_factory,
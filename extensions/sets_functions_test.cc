@@ -138,6 +138,30 @@ INSTANTIATE_TEST_SUITE_P(
         {"!sets.equivalent([b'foo'], [b'bar'])"},
 
         {"sets.equivalent([null], [null])"},
+
+        // Large enough to use the hashed implementation.
+        {"sets.contains(['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'], "
+         "['h', 'g', 'f', 'e', 'd', 'c', 'b', 'a'])"},
+        {"!sets.contains(['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'], "
+         "['h', 'g', 'f', 'e', 'd', 'c', 'b', 'z'])"},
+        {"sets.contains([1, 2, 3, 4, 5, 6, 7, 8], "
+         "[8u, 7.0, 6, 5u, 4.0, 3, 2u, 1.0])"},
+        {"!sets.contains([1, 2, 3, 4, 5, 6, 7, 8], "
+         "[8u, 7.0, 6, 5u, 4.0, 3, 2u, 1.5])"},
+        {"sets.intersects(['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'], "
+         "['z', 'y', 'x', 'w', 'v', 'u', 't', 'a'])"},
+        {"!sets.intersects(['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'], "
+         "['z', 'y', 'x', 'w', 'v', 'u', 't', 's'])"},
+        {"sets.intersects([[1], 2, 3, 4, 5, 6, 7, 8], "
+         "[9, 10, 11, 12, 13, 14, 15, 8.0])"},
+        {"sets.intersects([[1], 2, 3, 4, 5, 6, 7, 8], "
+         "[9, 10, 11, 12, 13, 14, 15, [1]])"},
+        {"sets.equivalent([1, 2, 3, 4, 5, 6, 7, 8, 8], "
+         "[8u, 7.0, 6, 5u, 4.0, 3, 2u, 1.0])"},
+        {"sets.equivalent([null, 2, 3, 4, 5, 6, 7, 8], "
+         "[8u, 7.0, 6, 5u, 4.0, 3, 2u, null])"},
+        {"!sets.equivalent([true, 2, 3, 4, 5, 6, 7, 8], "
+         "[8u, 7.0, 6, 5u, 4.0, 3, 2u, 1])"},
         {"!sets.equivalent([null], [])"},
 
         {"sets.equivalent([type(1), type(1u)], [type(1u), type(1)])"},
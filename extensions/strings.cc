@@ -14,18 +14,25 @@
 
 #include "extensions/strings.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
+#include <memory>
 #include <string>
-#include <tuple>
 #include <utility>
+#include <vector>
 
+#include "absl/functional/overload.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/function.h"
 #include "common/casting.h"
 #include "common/type.h"
 #include "common/value.h"
@@ -33,6 +40,7 @@
 #include "eval/public/cel_function_registry.h"
 #include "eval/public/cel_options.h"
 #include "internal/status_macros.h"
+#include "internal/string_replacer.h"
 #include "internal/utf8.h"
 #include "runtime/function_adapter.h"
 #include "runtime/function_registry.h"
@@ -49,41 +57,67 @@ struct AppendToStringVisitor {
   void operator()(absl::string_view string) const { append_to.append(string); }
 
   void operator()(const absl::Cord& cord) const {
-    append_to.append(static_cast<std::string>(cord));
+    for (absl::string_view chunk : cord.Chunks()) {
+      append_to.append(chunk);
+    }
   }
 };
 
+size_t ByteSize(StringValueView string) {
+  return string.NativeValue(
+      [](const auto& alternative) -> size_t { return alternative.size(); });
+}
+
 absl::StatusOr<Value> Join2(ValueManager& value_manager, const ListValue& value,
                             const StringValue& separator) {
-  std::string result;
-  CEL_ASSIGN_OR_RETURN(auto iterator, value.NewIterator(value_manager));
-  Value element_scratch;
-  if (iterator->HasNext()) {
-    CEL_ASSIGN_OR_RETURN(auto element,
-                         iterator->Next(value_manager, element_scratch));
-    if (auto string_element = As<StringValueView>(element); string_element) {
-      string_element->NativeValue(AppendToStringVisitor{result});
-    } else {
-      return ErrorValue{
-          runtime_internal::CreateNoMatchingOverloadError("join")};
-    }
-  }
   std::string separator_scratch;
   absl::string_view separator_view = separator.NativeString(separator_scratch);
-  while (iterator->HasNext()) {
-    result.append(separator_view);
-    CEL_ASSIGN_OR_RETURN(auto element,
-                         iterator->Next(value_manager, element_scratch));
-    if (auto string_element = As<StringValueView>(element); string_element) {
-      string_element->NativeValue(AppendToStringVisitor{result});
-    } else {
-      return ErrorValue{
-          runtime_internal::CreateNoMatchingOverloadError("join")};
-    }
+  // Check the elements and size the result up front, so that it is allocated
+  // exactly once.
+  size_t size = 0;
+  size_t count = 0;
+  bool all_strings = true;
+  bool is_ascii = common_internal::AsSharedByteString(separator).IsAscii();
+  CEL_RETURN_IF_ERROR(value.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        auto string_element = As<StringValueView>(element);
+        if (!string_element) {
+          all_strings = false;
+          return false;
+        }
+        size += ByteSize(*string_element);
+        is_ascii =
+            is_ascii &&
+            common_internal::AsSharedByteStringView(*string_element).IsAscii();
+        ++count;
+        return true;
+      }));
+  if (!all_strings) {
+    return ErrorValue{runtime_internal::CreateNoMatchingOverloadError("join")};
+  }
+  if (count > 1) {
+    size += separator_view.size() * (count - 1);
   }
-  result.shrink_to_fit();
+  std::string result;
+  result.reserve(size);
+  bool first = true;
+  CEL_RETURN_IF_ERROR(value.ForEach(
+      value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+        if (!first) {
+          result.append(separator_view);
+        }
+        first = false;
+        Cast<StringValueView>(element).NativeValue(
+            AppendToStringVisitor{result});
+        return true;
+      }));
   // We assume the original string was well-formed.
-  return value_manager.CreateUncheckedStringValue(std::move(result));
+  StringValue joined =
+      value_manager.CreateUncheckedStringValue(std::move(result));
+  if (is_ascii) {
+    common_internal::MarkAsciiStringValue(joined);
+  }
+  return joined;
 }
 
 absl::StatusOr<Value> Join1(ValueManager& value_manager,
@@ -91,61 +125,23 @@ absl::StatusOr<Value> Join1(ValueManager& value_manager,
   return Join2(value_manager, value, StringValue{});
 }
 
-struct SplitWithEmptyDelimiter {
-  ValueManager& value_manager;
-  int64_t& limit;
-  ListValueBuilder& builder;
-
-  absl::StatusOr<Value> operator()(absl::string_view string) const {
-    char32_t rune;
-    size_t count;
-    std::string buffer;
-    buffer.reserve(4);
-    while (!string.empty() && limit > 1) {
-      std::tie(rune, count) = internal::Utf8Decode(string);
-      buffer.clear();
-      internal::Utf8Encode(buffer, rune);
-      CEL_RETURN_IF_ERROR(builder.Add(
-          value_manager.CreateUncheckedStringValue(absl::string_view(buffer))));
-      --limit;
-      string.remove_prefix(count);
-    }
-    if (!string.empty()) {
-      CEL_RETURN_IF_ERROR(
-          builder.Add(value_manager.CreateUncheckedStringValue(string)));
-    }
-    return std::move(builder).Build();
-  }
-
-  absl::StatusOr<Value> operator()(const absl::Cord& string) const {
-    auto begin = string.char_begin();
-    auto end = string.char_end();
-    char32_t rune;
-    size_t count;
-    std::string buffer;
-    while (begin != end && limit > 1) {
-      std::tie(rune, count) = internal::Utf8Decode(begin);
-      buffer.clear();
-      internal::Utf8Encode(buffer, rune);
-      CEL_RETURN_IF_ERROR(builder.Add(
-          value_manager.CreateUncheckedStringValue(absl::string_view(buffer))));
-      --limit;
-      absl::Cord::Advance(&begin, count);
-    }
-    if (begin != end) {
-      buffer.clear();
-      while (begin != end) {
-        auto chunk = absl::Cord::ChunkRemaining(begin);
-        buffer.append(chunk);
-        absl::Cord::Advance(&begin, chunk.size());
-      }
-      buffer.shrink_to_fit();
-      CEL_RETURN_IF_ERROR(builder.Add(
-          value_manager.CreateUncheckedStringValue(std::move(buffer))));
+// Returns the number of pieces `Split3` produces for a non-empty `content` and
+// `delimiter`, so the result list is allocated once.
+size_t SplitPieceCount(absl::string_view content, absl::string_view delimiter,
+                       int64_t limit) {
+  size_t count = 1;
+  size_t offset = 0;
+  while (limit > 1) {
+    auto pos = content.find(delimiter, offset);
+    if (pos == absl::string_view::npos) {
+      break;
     }
-    return std::move(builder).Build();
+    ++count;
+    --limit;
+    offset = pos + delimiter.size();
   }
-};
+  return count;
+}
 
 absl::StatusOr<Value> Split3(ValueManager& value_manager,
                              const StringValue& string,
@@ -167,28 +163,45 @@ absl::StatusOr<Value> Split3(ValueManager& value_manager,
     CEL_RETURN_IF_ERROR(builder->Add(StringValue{}));
     return std::move(*builder).Build();
   }
+  // Each piece is a substring of `string` sharing its storage, so the only
+  // copy made is the flattening of a fragmented cord for searching.
+  const common_internal::SharedByteString& bytes =
+      common_internal::AsSharedByteString(string);
+  std::string content_scratch;
+  absl::string_view content_view = string.NativeString(content_scratch);
+  size_t offset = 0;
   if (delimiter.IsEmpty()) {
-    // If the delimiter is empty, we split between every code point.
-    return string.NativeValue(
-        SplitWithEmptyDelimiter{value_manager, limit, *builder});
+    // If the delimiter is empty, we split between every code point. There are
+    // at most as many code points as bytes.
+    builder->Reserve(static_cast<size_t>(
+        std::min<int64_t>(limit, static_cast<int64_t>(content_view.size()))));
+    while (offset < content_view.size() && limit > 1) {
+      size_t count = internal::Utf8Decode(content_view.substr(offset)).second;
+      CEL_RETURN_IF_ERROR(
+          builder->Add(StringValue(bytes.Substring(offset, count))));
+      --limit;
+      offset += count;
+    }
+    if (offset < content_view.size()) {
+      CEL_RETURN_IF_ERROR(builder->Add(StringValue(bytes.Substring(offset))));
+    }
+    return std::move(*builder).Build();
   }
   // At this point we know the string is not empty and the delimiter is not
   // empty.
   std::string delimiter_scratch;
   absl::string_view delimiter_view = delimiter.NativeString(delimiter_scratch);
-  std::string content_scratch;
-  absl::string_view content_view = string.NativeString(content_scratch);
-  while (limit > 1 && !content_view.empty()) {
-    auto pos = content_view.find(delimiter_view);
+  builder->Reserve(SplitPieceCount(content_view, delimiter_view, limit));
+  while (limit > 1 && offset < content_view.size()) {
+    auto pos = content_view.find(delimiter_view, offset);
     if (pos == absl::string_view::npos) {
       break;
     }
-    // We assume the original string was well-formed.
-    CEL_RETURN_IF_ERROR(builder->Add(
-        value_manager.CreateUncheckedStringValue(content_view.substr(0, pos))));
+    CEL_RETURN_IF_ERROR(
+        builder->Add(StringValue(bytes.Substring(offset, pos - offset))));
     --limit;
-    content_view.remove_prefix(pos + delimiter_view.size());
-    if (content_view.empty()) {
+    offset = pos + delimiter_view.size();
+    if (offset == content_view.size()) {
       // We found the delimiter at the end of the string. Add an empty string
       // to the end of the list.
       CEL_RETURN_IF_ERROR(builder->Add(StringValue{}));
@@ -197,10 +210,7 @@ absl::StatusOr<Value> Split3(ValueManager& value_manager,
   }
   // We have one left in the limit or do not have any more matches. Add
   // whatever is left as the remaining entry.
-  //
-  // We assume the original string was well-formed.
-  CEL_RETURN_IF_ERROR(
-      builder->Add(value_manager.CreateUncheckedStringValue(content_view)));
+  CEL_RETURN_IF_ERROR(builder->Add(StringValue(bytes.Substring(offset))));
   return std::move(*builder).Build();
 }
 
@@ -210,14 +220,187 @@ absl::StatusOr<Value> Split2(ValueManager& value_manager,
   return Split3(value_manager, string, delimiter, -1);
 }
 
+constexpr uint64_t kEachByte = 0x0101010101010101;
+
+// Returns `word` with the high bit of each byte set if that byte is an ASCII
+// uppercase letter, and every other bit clear. Bytes are handled
+// independently, so this is correct regardless of endianness.
+uint64_t AsciiUpperMask(uint64_t word) {
+  // Clearing the high bits first means the additions below cannot carry
+  // across bytes.
+  const uint64_t low = word & (kEachByte * 0x7f);
+  const uint64_t at_least_a = low + kEachByte * (0x80 - 'A');
+  const uint64_t above_z = low + kEachByte * (0x80 - 'Z' - 1);
+  return at_least_a & ~above_z & ~word & (kEachByte * 0x80);
+}
+
+// Returns the offset of the first ASCII uppercase letter in `string`, or
+// `absl::string_view::npos` if there is none.
+size_t FindAsciiUpper(absl::string_view string) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= string.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, string.data() + i, sizeof(word));
+    if (AsciiUpperMask(word) != 0) {
+      break;
+    }
+  }
+  for (; i < string.size(); ++i) {
+    if (absl::ascii_isupper(static_cast<unsigned char>(string[i]))) {
+      return i;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+// Lowercases the ASCII letters in `[data, data + size)` eight bytes at a time.
+void AsciiToLower(char* data, size_t size) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    // 'a' - 'A' is 0x20, the mask bit shifted down by two.
+    word |= AsciiUpperMask(word) >> 2;
+    std::memcpy(data + i, &word, sizeof(word));
+  }
+  for (; i < size; ++i) {
+    data[i] = absl::ascii_tolower(static_cast<unsigned char>(data[i]));
+  }
+}
+
 absl::StatusOr<Value> LowerAscii(ValueManager& value_manager,
                                  const StringValue& string) {
+  // Most inputs are already lowercase, in which case the input is returned
+  // as is rather than copied.
+  size_t pos = string.NativeValue(absl::Overload(
+      [](absl::string_view view) -> size_t { return FindAsciiUpper(view); },
+      [](const absl::Cord& cord) -> size_t {
+        size_t offset = 0;
+        for (absl::string_view chunk : cord.Chunks()) {
+          if (size_t chunk_pos = FindAsciiUpper(chunk);
+              chunk_pos != absl::string_view::npos) {
+            return offset + chunk_pos;
+          }
+          offset += chunk.size();
+        }
+        return absl::string_view::npos;
+      }));
+  if (pos == absl::string_view::npos) {
+    return string;
+  }
   std::string content = string.NativeString();
-  absl::AsciiStrToLower(&content);
+  AsciiToLower(content.data() + pos, content.size() - pos);
   // We assume the original string was well-formed.
-  return value_manager.CreateUncheckedStringValue(std::move(content));
+  StringValue result =
+      value_manager.CreateUncheckedStringValue(std::move(content));
+  if (common_internal::AsSharedByteString(string).IsAscii()) {
+    common_internal::MarkAsciiStringValue(result);
+  }
+  return result;
+}
+
+absl::StatusOr<internal::StringReplacer> MakeStringReplacer(
+    ValueManager& value_manager, const MapValue& replacements) {
+  std::vector<std::pair<std::string, std::string>> pairs;
+  bool all_strings = true;
+  CEL_RETURN_IF_ERROR(replacements.ForEach(
+      value_manager,
+      [&](ValueView key, ValueView value) -> absl::StatusOr<bool> {
+        auto string_key = As<StringValueView>(key);
+        auto string_value = As<StringValueView>(value);
+        if (!string_key || !string_value) {
+          all_strings = false;
+          return false;
+        }
+        pairs.emplace_back(string_key->NativeString(),
+                           string_value->NativeString());
+        return true;
+      }));
+  if (!all_strings) {
+    return absl::InvalidArgumentError(
+        "replaceAll: replacements must be a map of strings to strings");
+  }
+  return internal::StringReplacer::Create(pairs);
+}
+
+Value ReplaceAll(ValueManager& value_manager,
+                 const internal::StringReplacer& replacer,
+                 const StringValue& string) {
+  std::string scratch;
+  absl::optional<std::string> replaced =
+      replacer.Replace(string.NativeString(scratch));
+  if (!replaced.has_value()) {
+    return string;
+  }
+  // A needle which is well-formed UTF-8 can only match at code point
+  // boundaries, so the result is well-formed as well.
+  return value_manager.CreateUncheckedStringValue(*std::move(replaced));
 }
 
+// Implements `string.replaceAll(map)`, which replaces every key of the map
+// with its value in a single pass over the string.
+//
+// The automaton matching the keys is built on each call, unless the map is a
+// constant, in which case it is built once when the program is planned.
+class ReplaceAllFunction : public Function {
+ public:
+  absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                               absl::Span<const Value> args) const override {
+    CEL_RETURN_IF_ERROR(CheckArgs(args));
+    absl::StatusOr<internal::StringReplacer> replacer = MakeStringReplacer(
+        context.value_factory(), args[1].As<MapValue>());
+    if (!replacer.ok()) {
+      return context.value_factory().CreateErrorValue(
+          std::move(replacer).status());
+    }
+    return ReplaceAll(context.value_factory(), *replacer,
+                      args[0].As<StringValue>());
+  }
+
+  absl::StatusOr<std::unique_ptr<Function>> Specialize(
+      ValueManager& value_factory,
+      absl::Span<const absl::optional<Value>> constant_args) const override {
+    if (constant_args.size() != 2 || !constant_args[1].has_value() ||
+        !constant_args[1]->Is<MapValue>()) {
+      return nullptr;
+    }
+    absl::StatusOr<internal::StringReplacer> replacer =
+        MakeStringReplacer(value_factory, constant_args[1]->As<MapValue>());
+    if (!replacer.ok()) {
+      // Left to report the error on each call.
+      return nullptr;
+    }
+    return std::make_unique<BoundReplaceAllFunction>(*std::move(replacer));
+  }
+
+ private:
+  // Specialization for a constant map.
+  class BoundReplaceAllFunction : public Function {
+   public:
+    explicit BoundReplaceAllFunction(internal::StringReplacer replacer)
+        : replacer_(std::move(replacer)) {}
+
+    absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                                 absl::Span<const Value> args) const override {
+      CEL_RETURN_IF_ERROR(CheckArgs(args));
+      return ReplaceAll(context.value_factory(), replacer_,
+                        args[0].As<StringValue>());
+    }
+
+   private:
+    internal::StringReplacer replacer_;
+  };
+
+  static absl::Status CheckArgs(absl::Span<const Value> args) {
+    if (args.size() != 2 || !args[0].Is<StringValue>() ||
+        !args[1].Is<MapValue>()) {
+      return absl::InvalidArgumentError(
+          "unexpected arguments for replaceAll");
+    }
+    return absl::OkStatus();
+  }
+};
+
 }  // namespace
 
 absl::Status RegisterStringsFunctions(FunctionRegistry& registry,
@@ -248,6 +431,10 @@ absl::Status RegisterStringsFunctions(FunctionRegistry& registry,
           CreateDescriptor("lowerAscii", /*receiver_style=*/true),
       UnaryFunctionAdapter<absl::StatusOr<Value>, StringValue>::WrapFunction(
           LowerAscii)));
+  CEL_RETURN_IF_ERROR(registry.Register(
+      BinaryFunctionAdapter<absl::StatusOr<Value>, StringValue, MapValue>::
+          CreateDescriptor("replaceAll", /*receiver_style=*/true),
+      std::make_unique<ReplaceAllFunction>()));
   return absl::OkStatus();
 }
 
@@ -19,6 +19,7 @@
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "absl/strings/cord.h"
+#include "absl/strings/cord_test_helpers.h"
 #include "common/memory.h"
 #include "common/value.h"
 #include "common/values/legacy_value_manager.h"
@@ -27,6 +28,8 @@
 #include "parser/options.h"
 #include "parser/parser.h"
 #include "runtime/activation.h"
+#include "runtime/constant_folding.h"
+#include "runtime/function_specialization.h"
 #include "runtime/runtime.h"
 #include "runtime/runtime_builder.h"
 #include "runtime/runtime_options.h"
@@ -68,5 +71,156 @@ TEST(Strings, SplitWithEmptyDelimiterCord) {
   EXPECT_TRUE(result.As<BoolValue>().NativeValue());
 }
 
+TEST(Strings, SplitJoinSharedStorage) {
+  MemoryManagerRef memory_manager = MemoryManagerRef::ReferenceCounting();
+  const auto options = RuntimeOptions{};
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  EXPECT_OK(RegisterStringsFunctions(builder.function_registry(), options));
+
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr expr,
+      Parse("foo.split(', ') == ['a', 'bc', '', 'def'] && "
+            "bar.split(', ') == ['a', 'bc', '', 'def'] && "
+            "bar.split(', ', 2) == ['a', 'bc, , def'] && "
+            "bar.split('') == ['a', ',', ' ', 'b', 'c', ',', ' ', ',', ' ', "
+            "'d', 'e', 'f'] && "
+            "'a,'.split(',') == ['a', ''] && "
+            "foo.split(', ').join(', ') == bar && "
+            "['', 'x', ''].join('-') == '-x-' && "
+            "[foo].join() == bar && [].join(',') == ''",
+            "<input>", ParserOptions{}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  common_internal::LegacyValueManager value_factory(memory_manager,
+                                                    runtime->GetTypeProvider());
+
+  Activation activation;
+  activation.InsertOrAssignValue(
+      "foo",
+      StringValue{absl::MakeFragmentedCord({"a, b", "c, ", ", de", "f"})});
+  ASSERT_OK_AND_ASSIGN(auto bar,
+                       value_factory.CreateStringValue("a, bc, , def"));
+  activation.InsertOrAssignValue("bar", bar);
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory));
+  ASSERT_TRUE(result.Is<BoolValue>());
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST(Strings, LowerAscii) {
+  MemoryManagerRef memory_manager = MemoryManagerRef::ReferenceCounting();
+  const auto options = RuntimeOptions{};
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  EXPECT_OK(RegisterStringsFunctions(builder.function_registry(), options));
+
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr expr,
+      Parse("foo.lowerAscii() == bar && bar.lowerAscii() == bar && "
+            "'Content-Type: TEXT/Plain; CHARSET=\\u00c4'.lowerAscii() == "
+            "'content-type: text/plain; charset=\\u00c4'",
+            "<input>", ParserOptions{}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  common_internal::LegacyValueManager value_factory(memory_manager,
+                                                    runtime->GetTypeProvider());
+
+  Activation activation;
+  activation.InsertOrAssignValue(
+      "foo", StringValue{absl::MakeFragmentedCord(
+                 {"X-Forwarded-", "For: ", "abcdefgh", "ijklmnoP"})});
+  activation.InsertOrAssignValue(
+      "bar", StringValue{"x-forwarded-for: abcdefghijklmnop"});
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory));
+  ASSERT_TRUE(result.Is<BoolValue>());
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+class StringsReplaceAllTest : public testing::TestWithParam<bool> {};
+
+TEST_P(StringsReplaceAllTest, ReplaceAll) {
+  const bool specialize = GetParam();
+  MemoryManagerRef memory_manager = MemoryManagerRef::ReferenceCounting();
+  const auto options = RuntimeOptions{};
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  EXPECT_OK(RegisterStringsFunctions(builder.function_registry(), options));
+  if (specialize) {
+    ASSERT_OK(EnableConstantFolding(builder, memory_manager));
+    ASSERT_OK(EnableFunctionSpecialization(builder));
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr expr,
+      Parse("foo.replaceAll({'<': '&lt;', '>': '&gt;', '&': '&amp;'}) == "
+            "'&lt;a href=\"?x&amp;y\"&gt;' && "
+            "'abba'.replaceAll(swap) == 'baab' && "
+            "'abc'.replaceAll({}) == 'abc'",
+            "<input>", ParserOptions{}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  common_internal::LegacyValueManager value_factory(memory_manager,
+                                                    runtime->GetTypeProvider());
+
+  Activation activation;
+  activation.InsertOrAssignValue(
+      "foo", StringValue{absl::MakeFragmentedCord({"<a hr", "ef=\"?x&y\">"})});
+  ASSERT_OK_AND_ASSIGN(auto swap,
+                       value_factory.NewMapValueBuilder(
+                           value_factory.GetDynDynMapType()));
+  ASSERT_OK(swap->Put(StringValue("a"), StringValue("b")));
+  ASSERT_OK(swap->Put(StringValue("b"), StringValue("a")));
+  activation.InsertOrAssignValue("swap", std::move(*swap).Build());
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(StringsReplaceAllTest, NotAStringMap) {
+  const bool specialize = GetParam();
+  MemoryManagerRef memory_manager = MemoryManagerRef::ReferenceCounting();
+  const auto options = RuntimeOptions{};
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  EXPECT_OK(RegisterStringsFunctions(builder.function_registry(), options));
+  if (specialize) {
+    ASSERT_OK(EnableConstantFolding(builder, memory_manager));
+    ASSERT_OK(EnableFunctionSpecialization(builder));
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("'abc'.replaceAll({'a': 1})",
+                                              "<input>", ParserOptions{}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  common_internal::LegacyValueManager value_factory(memory_manager,
+                                                    runtime->GetTypeProvider());
+
+  Activation activation;
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory));
+  EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+}
+
+INSTANTIATE_TEST_SUITE_P(StringsReplaceAllTest, StringsReplaceAllTest,
+                         testing::Bool());
+
 }  // namespace
 }  // namespace cel::extensions
@@ -0,0 +1,215 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/base64.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/optimization.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+
+namespace cel::internal {
+
+namespace {
+
+constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Maps each pair of sextets to its two characters, so that three bytes are
+// encoded with two lookups.
+struct EncodeTable {
+  constexpr EncodeTable() : pairs() {
+    for (size_t i = 0; i < 4096; ++i) {
+      pairs[i * 2] = kAlphabet[i >> 6];
+      pairs[i * 2 + 1] = kAlphabet[i & 0x3f];
+    }
+  }
+
+  char pairs[4096 * 2];
+};
+
+// Values with bits above the low 24 set mark characters outside of the
+// alphabet, so that the sextets of a block can be combined with bitwise or and
+// validated with a single comparison.
+constexpr uint32_t kInvalid = 0x01ffffff;
+
+// Maps each character to its sextet, shifted into place for each of the four
+// positions of a block.
+struct DecodeTable {
+  constexpr DecodeTable() : shifted() {
+    for (auto& position : shifted) {
+      for (auto& sextet : position) {
+        sextet = kInvalid;
+      }
+    }
+    for (uint32_t i = 0; i < 64; ++i) {
+      auto c = static_cast<unsigned char>(kAlphabet[i]);
+      shifted[0][c] = i << 18;
+      shifted[1][c] = i << 12;
+      shifted[2][c] = i << 6;
+      shifted[3][c] = i;
+    }
+  }
+
+  std::array<std::array<uint32_t, 256>, 4> shifted;
+};
+
+constexpr EncodeTable kEncodeTable;
+constexpr DecodeTable kDecodeTable;
+
+inline uint32_t DecodeBlock(const unsigned char* in, size_t size) {
+  uint32_t block = 0;
+  for (size_t i = 0; i < size; ++i) {
+    block |= kDecodeTable.shifted[i][in[i]];
+  }
+  return block;
+}
+
+bool ContainsWhitespace(absl::string_view in) {
+  for (char c : in) {
+    if (absl::ascii_isspace(static_cast<unsigned char>(c))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DecodeWithoutWhitespace(absl::string_view in, std::string* out) {
+  size_t size = in.size();
+  if (size % 4 == 0 && size != 0) {
+    // Padding is only accepted when it completes the final block.
+    size -= in[size - 1] == '=' ? (in[size - 2] == '=' ? 2 : 1) : 0;
+  }
+  const size_t tail = size % 4;
+  if (tail == 1) {
+    return false;
+  }
+  const size_t blocks = size / 4;
+  out->resize(blocks * 3 + (tail == 0 ? 0 : tail - 1));
+  const auto* src = reinterpret_cast<const unsigned char*>(in.data());
+  char* dst = out->data();
+  for (size_t i = 0; i < blocks; ++i, src += 4, dst += 3) {
+    uint32_t block = DecodeBlock(src, 4);
+    if (ABSL_PREDICT_FALSE(block > 0xffffff)) {
+      return false;
+    }
+    dst[0] = static_cast<char>(block >> 16);
+    dst[1] = static_cast<char>(block >> 8);
+    dst[2] = static_cast<char>(block);
+  }
+  if (tail != 0) {
+    // Like `absl::Base64Unescape`, the unused low bits of the final sextet
+    // are ignored.
+    uint32_t block = DecodeBlock(src, tail);
+    if (block > 0xffffff) {
+      return false;
+    }
+    dst[0] = static_cast<char>(block >> 16);
+    if (tail == 3) {
+      dst[1] = static_cast<char>(block >> 8);
+    }
+  }
+  return true;
+}
+
+// Encodes the whole three byte groups of [src, src + size) to `dst`, returning
+// the end of the output.
+char* EncodeGroups(const unsigned char* src, size_t size, char* dst) {
+  const auto* end = src + size / 3 * 3;
+  for (; src != end; src += 3, dst += 4) {
+    uint32_t block = (uint32_t{src[0]} << 16) | (uint32_t{src[1]} << 8) |
+                     uint32_t{src[2]};
+    const char* high = &kEncodeTable.pairs[(block >> 12) * 2];
+    const char* low = &kEncodeTable.pairs[(block & 0xfff) * 2];
+    dst[0] = high[0];
+    dst[1] = high[1];
+    dst[2] = low[0];
+    dst[3] = low[1];
+  }
+  return dst;
+}
+
+// Encodes the final `size` (less than three) bytes at `src` to `dst`, which
+// is already padded.
+void EncodeTail(const unsigned char* src, size_t size, char* dst) {
+  switch (size) {
+    case 1:
+      dst[0] = kAlphabet[src[0] >> 2];
+      dst[1] = kAlphabet[(src[0] & 0x03) << 4];
+      break;
+    case 2:
+      dst[0] = kAlphabet[src[0] >> 2];
+      dst[1] = kAlphabet[((src[0] & 0x03) << 4) | (src[1] >> 4)];
+      dst[2] = kAlphabet[(src[1] & 0x0f) << 2];
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+std::string Base64Encode(absl::string_view in) {
+  std::string out(Base64EncodedSize(in.size()), '=');
+  const auto* src = reinterpret_cast<const unsigned char*>(in.data());
+  char* dst = EncodeGroups(src, in.size(), out.data());
+  EncodeTail(src + in.size() / 3 * 3, in.size() % 3, dst);
+  return out;
+}
+
+std::string Base64Encode(const absl::Cord& in) {
+  if (auto flat = in.TryFlat(); flat.has_value()) {
+    return Base64Encode(*flat);
+  }
+  std::string out(Base64EncodedSize(in.size()), '=');
+  char* dst = out.data();
+  // The bytes of a group split across chunks.
+  unsigned char carry[3];
+  size_t carried = 0;
+  for (absl::string_view chunk : in.Chunks()) {
+    const auto* src = reinterpret_cast<const unsigned char*>(chunk.data());
+    size_t size = chunk.size();
+    while (carried != 0 && carried < 3 && size != 0) {
+      carry[carried++] = *src++;
+      --size;
+    }
+    if (carried == 3) {
+      dst = EncodeGroups(carry, 3, dst);
+      carried = 0;
+    }
+    dst = EncodeGroups(src, size, dst);
+    for (size_t i = size / 3 * 3; i < size; ++i) {
+      carry[carried++] = src[i];
+    }
+  }
+  EncodeTail(carry, carried, dst);
+  return out;
+}
+
+bool Base64Decode(absl::string_view in, std::string* out) {
+  if (ABSL_PREDICT_TRUE(DecodeWithoutWhitespace(in, out))) {
+    return true;
+  }
+  // Anything other than whitespace which the fast path rejects is invalid, so
+  // only inputs with whitespace pay for a second pass.
+  return ContainsWhitespace(in) && absl::Base64Unescape(in, out);
+}
+
+}  // namespace cel::internal
@@ -0,0 +1,47 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_BASE64_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_BASE64_H_
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+
+namespace cel::internal {
+
+// Returns the length of the padded base64 encoding of `size` bytes.
+constexpr size_t Base64EncodedSize(size_t size) { return (size + 2) / 3 * 4; }
+
+// Returns the padded encoding of `in` with the standard alphabet, equivalent
+// to `absl::Base64Escape`. The result is allocated once, at its final size.
+std::string Base64Encode(absl::string_view in);
+
+// As above, encoding the chunks of `in` in place rather than flattening it.
+std::string Base64Encode(const absl::Cord& in);
+
+// Decodes `in` into `out`, accepting the same inputs as `absl::Base64Unescape`:
+// the standard alphabet with optional padding. Returns false if `in` isn't
+// valid base64, in which case `out` is unspecified.
+//
+// Inputs without whitespace are decoded in blocks of four characters straight
+// into `out`, sized exactly once. Whitespace, which `absl::Base64Unescape`
+// skips, is handled by deferring to it.
+bool Base64Decode(absl::string_view in, std::string* out);
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_BASE64_H_
@@ -0,0 +1,124 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/base64.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "absl/random/random.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/cord_test_helpers.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+TEST(Base64Encode, MatchesAbslBase64Escape) {
+  std::string in;
+  for (int i = 0; i < 300; ++i) {
+    EXPECT_EQ(Base64Encode(in), absl::Base64Escape(in)) << i;
+    EXPECT_EQ(Base64Encode(in).size(), Base64EncodedSize(in.size()));
+    in.push_back(static_cast<char>(i * 7 + 3));
+  }
+}
+
+TEST(Base64Encode, EncodesCordChunks) {
+  std::string in;
+  for (int i = 0; i < 64; ++i) {
+    in.push_back(static_cast<char>(i * 7 + 3));
+  }
+  for (size_t chunk_size = 1; chunk_size < 8; ++chunk_size) {
+    for (size_t size = 0; size <= in.size(); ++size) {
+      std::vector<absl::string_view> chunks;
+      for (size_t pos = 0; pos < size; pos += chunk_size) {
+        chunks.push_back(absl::string_view(in).substr(
+            pos, std::min(chunk_size, size - pos)));
+      }
+      EXPECT_EQ(Base64Encode(absl::MakeFragmentedCord(chunks)),
+                absl::Base64Escape(in.substr(0, size)))
+          << chunk_size << " " << size;
+    }
+  }
+}
+
+TEST(Base64Decode, RoundTrips) {
+  std::string in;
+  for (int i = 0; i < 300; ++i) {
+    std::string out;
+    ASSERT_TRUE(Base64Decode(Base64Encode(in), &out)) << i;
+    EXPECT_EQ(out, in);
+    in.push_back(static_cast<char>(i * 11 + 5));
+  }
+}
+
+TEST(Base64Decode, MatchesAbslBase64Unescape) {
+  for (absl::string_view input : {
+           "",
+           "aGVsbG8=",
+           "aGVsbG8",
+           "aGVsbA==",
+           "aGVsbA",
+           "aGVsbG9=",
+           "ab==",
+           "aGVs bG8=",
+           "aGVs\nbG8=",
+           " aGVsbG8=",
+           "aGVsbG8= ",
+           // Malformed.
+           "a",
+           "=",
+           "====",
+           "a===",
+           "aGVsbA=",
+           "aGVsbG8==",
+           "aG=sbG8=",
+           "aGVsbG8-",
+           "aGVsbG8_",
+           "aGVs\x80G8=",
+       }) {
+    std::string expected;
+    bool expected_ok = absl::Base64Unescape(input, &expected);
+    std::string out;
+    EXPECT_EQ(Base64Decode(input, &out), expected_ok) << input;
+    if (expected_ok) {
+      EXPECT_EQ(out, expected) << input;
+    }
+  }
+}
+
+TEST(Base64Decode, MatchesAbslBase64UnescapeForRandomInputs) {
+  constexpr absl::string_view kCharacters = "AQgw+/=  \n-_";
+  absl::BitGen bitgen;
+  for (int i = 0; i < 10000; ++i) {
+    std::string input(absl::Uniform<size_t>(bitgen, 0, 13), ' ');
+    for (char& c : input) {
+      c = kCharacters[absl::Uniform<size_t>(bitgen, 0, kCharacters.size())];
+    }
+    std::string expected;
+    bool expected_ok = absl::Base64Unescape(input, &expected);
+    std::string out;
+    ASSERT_EQ(Base64Decode(input, &out), expected_ok) << input;
+    if (expected_ok) {
+      ASSERT_EQ(out, expected) << input;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace cel::internal
@@ -0,0 +1,133 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/benchmark.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "absl/base/attributes.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::internal {
+
+namespace {
+
+// The allocations of each thread are counted separately, so that counting
+// doesn't contend between the threads of multithreaded benchmarks.
+struct ThreadAllocationCounts {
+  uint64_t allocs;
+  uint64_t bytes;
+  uint64_t arena_bytes;
+};
+
+ABSL_CONST_INIT thread_local ThreadAllocationCounts thread_counts = {0, 0, 0};
+
+void* CountedAllocate(size_t size) {
+  ++thread_counts.allocs;
+  thread_counts.bytes += size;
+  // `malloc(0)` may return null, but `operator new` must not.
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* CountingBlockAlloc(size_t size) {
+  thread_counts.arena_bytes += size;
+  void* block = std::malloc(size);
+  if (block == nullptr) {
+    std::abort();
+  }
+  return block;
+}
+
+void CountingBlockDealloc(void* block, size_t) { std::free(block); }
+
+double PerIteration(uint64_t count, benchmark::IterationCount iterations) {
+  return iterations == 0 ? 0.0
+                         : static_cast<double>(count) /
+                               static_cast<double>(iterations);
+}
+
+}  // namespace
+
+google::protobuf::ArenaOptions CountingArenaOptions() {
+  google::protobuf::ArenaOptions options;
+  options.block_alloc = &CountingBlockAlloc;
+  options.block_dealloc = &CountingBlockDealloc;
+  return options;
+}
+
+AllocationCounters::AllocationCounters(benchmark::State& state)
+    : state_(state),
+      allocs_(thread_counts.allocs),
+      bytes_(thread_counts.bytes),
+      arena_bytes_(thread_counts.arena_bytes) {}
+
+AllocationCounters::~AllocationCounters() {
+  const benchmark::IterationCount iterations = state_.iterations();
+  state_.counters["allocs/iter"] =
+      PerIteration(thread_counts.allocs - allocs_, iterations);
+  state_.counters["bytes/iter"] =
+      PerIteration(thread_counts.bytes - bytes_, iterations);
+  state_.counters["arena_bytes/iter"] =
+      PerIteration(thread_counts.arena_bytes - arena_bytes_, iterations);
+}
+
+}  // namespace cel::internal
+
+// Replacements of the global allocation functions, which count the
+// allocations of the calling thread. Allocation failures abort, as benchmarks
+// don't recover from them. The aligned overloads are left to the standard
+// library.
+
+void* operator new(size_t size) {
+  void* ptr = cel::internal::CountedAllocate(size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  void* ptr = cel::internal::CountedAllocate(size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return cel::internal::CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return cel::internal::CountedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
@@ -15,6 +15,49 @@
 #ifndef THIRD_PARTY_CEL_CPP_INTERNAL_BENCHMARK_H_
 #define THIRD_PARTY_CEL_CPP_INTERNAL_BENCHMARK_H_
 
+#include <cstdint>
+
 #include "benchmark/benchmark.h"  // IWYU pragma: export
+#include "google/protobuf/arena.h"
+
+namespace cel::internal {
+
+// Returns options for an arena whose blocks count towards the
+// `arena_bytes/iter` counter of `AllocationCounters`. The blocks are
+// allocated with `std::malloc`, so they are not counted as heap allocations.
+google::protobuf::ArenaOptions CountingArenaOptions();
+
+// Reports the allocations made by the calling thread while it is alive as
+// counters of `state`, averaged over the iterations of the benchmark:
+//
+// - `allocs/iter`: calls of the global `operator new`.
+// - `bytes/iter`: bytes requested from the global `operator new`.
+// - `arena_bytes/iter`: bytes of the blocks allocated by arenas created with
+//   `CountingArenaOptions()`.
+//
+// Create it right before the benchmark loop, so that the setup is not
+// counted:
+//
+//   AllocationCounters allocation_counters(state);
+//   for (auto _ : state) {
+//     ...
+//   }
+class AllocationCounters final {
+ public:
+  explicit AllocationCounters(benchmark::State& state);
+
+  AllocationCounters(const AllocationCounters&) = delete;
+  AllocationCounters& operator=(const AllocationCounters&) = delete;
+
+  ~AllocationCounters();
+
+ private:
+  benchmark::State& state_;
+  const uint64_t allocs_;
+  const uint64_t bytes_;
+  const uint64_t arena_bytes_;
+};
+
+}  // namespace cel::internal
 
 #endif  // THIRD_PARTY_CEL_CPP_INTERNAL_BENCHMARK_H_
@@ -48,7 +48,7 @@ class ABSL_ATTRIBUTE_TRIVIAL_ABI CopyOnWrite final {
 
     template <typename... Args,
               typename = std::enable_if_t<std::is_constructible_v<T, Args...>>>
-    explicit Rep(Args&&... args) : value(std::forward<Args>(value)...) {}
+    explicit Rep(Args&&... args) : value(std::forward<Args>(args)...) {}
 
     Rep(const Rep&) = delete;
     Rep(Rep&&) = delete;
@@ -0,0 +1,123 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/huge_pages.h"
+
+#include <cstddef>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include "absl/base/nullability.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace cel::internal {
+
+namespace {
+
+#ifdef __linux__
+
+// Reads the size of the transparent huge pages, falling back to the default
+// size of the reserved huge pages.
+size_t ReadHugePageSize() {
+  size_t size = 0;
+  if (std::ifstream file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+      file >> size && size != 0) {
+    return size;
+  }
+  std::ifstream meminfo("/proc/meminfo");
+  for (std::string line; std::getline(meminfo, line);) {
+    absl::string_view value = line;
+    // e.g. "Hugepagesize:       2048 kB"
+    if (absl::ConsumePrefix(&value, "Hugepagesize:") &&
+        absl::ConsumeSuffix(&value, " kB") &&
+        absl::SimpleAtoi(absl::StripAsciiWhitespace(value), &size)) {
+      return size * 1024;
+    }
+  }
+  return 0;
+}
+
+#endif  // __linux__
+
+bool IsMapped(size_t size, HugePages huge_pages) {
+  return huge_pages != HugePages::kNone && HugePageSize() != 0 &&
+         size >= HugePageSize();
+}
+
+size_t RoundUpToHugePages(size_t size) {
+  const size_t huge_page_size = HugePageSize();
+  return (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+
+}  // namespace
+
+size_t HugePageSize() {
+#ifdef __linux__
+  static const size_t huge_page_size = ReadHugePageSize();
+  return huge_page_size;
+#else
+  return 0;
+#endif
+}
+
+absl::Nonnull<void*> AllocateBlock(size_t size, HugePages huge_pages) {
+  if (!IsMapped(size, huge_pages)) {
+    return ::operator new(size);
+  }
+#ifdef __linux__
+  const size_t mapped_size = RoundUpToHugePages(size);
+  void* block = MAP_FAILED;
+  if (huge_pages == HugePages::kExplicit) {
+    block = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+  if (block == MAP_FAILED) {
+    block = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ABSL_CHECK(block != MAP_FAILED)  // Crash OK
+        << "failed to map " << mapped_size << " bytes";
+#ifdef MADV_HUGEPAGE
+    // Only advisory, the block is backed by regular pages if it fails.
+    madvise(block, mapped_size, MADV_HUGEPAGE);
+#endif
+  }
+  return block;
+#else
+  return ::operator new(size);
+#endif
+}
+
+void DeallocateBlock(absl::Nonnull<void*> block, size_t size,
+                     HugePages huge_pages) noexcept {
+  if (!IsMapped(size, huge_pages)) {
+    ::operator delete(block, size);
+    return;
+  }
+#ifdef __linux__
+  munmap(block, RoundUpToHugePages(size));
+#else
+  ::operator delete(block, size);
+#endif
+}
+
+}  // namespace cel::internal
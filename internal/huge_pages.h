@@ -0,0 +1,56 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_HUGE_PAGES_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_HUGE_PAGES_H_
+
+#include <cstddef>
+
+#include "absl/base/attributes.h"
+#include "absl/base/nullability.h"
+
+namespace cel::internal {
+
+// How large memory blocks are backed by the huge pages of the platform, which
+// cut the TLB misses of memory spanning many pages.
+enum class HugePages {
+  // Regular pages, allocated with `::operator new`.
+  kNone,
+  // Memory mapped blocks advised to be backed by transparent huge pages, as
+  // the kernel finds them available.
+  kTransparent,
+  // Memory mapped blocks backed by huge pages reserved by the administrator
+  // (e.g. vm.nr_hugepages), or by transparent huge pages once none is left.
+  kExplicit,
+};
+
+// Returns the size of the huge pages of the platform, e.g. 2 MiB on x86-64
+// Linux, or 0 if the platform doesn't support them.
+ABSL_ATTRIBUTE_CONST_FUNCTION size_t HugePageSize();
+
+// Allocates a block of at least `size` bytes, aligned to at least
+// `alignof(std::max_align_t)`. Blocks of a huge page or more are memory mapped
+// and backed by huge pages as requested by `huge_pages`, their size rounded up
+// to a whole number of huge pages. Smaller blocks, and every block on
+// platforms without huge pages, are allocated with `::operator new`.
+absl::Nonnull<void*> AllocateBlock(size_t size, HugePages huge_pages);
+
+// Deallocates a block returned by `AllocateBlock` with the same `size` and
+// `huge_pages`.
+void DeallocateBlock(absl::Nonnull<void*> block, size_t size,
+                     HugePages huge_pages) noexcept;
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_HUGE_PAGES_H_
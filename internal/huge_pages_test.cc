@@ -0,0 +1,54 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/huge_pages.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "absl/numeric/bits.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+TEST(HugePageSize, PowerOf2OrUnsupported) {
+  const size_t size = HugePageSize();
+  EXPECT_TRUE(size == 0 || absl::has_single_bit(size));
+}
+
+class AllocateBlockTest : public testing::TestWithParam<HugePages> {};
+
+TEST_P(AllocateBlockTest, SmallBlock) {
+  void* block = AllocateBlock(256, GetParam());
+  std::memset(block, 'x', 256);
+  DeallocateBlock(block, 256, GetParam());
+}
+
+TEST_P(AllocateBlockTest, LargeBlock) {
+  // Not a whole number of huge pages.
+  const size_t size = 3 * (HugePageSize() != 0 ? HugePageSize() : 4096) + 8;
+  auto* block = static_cast<char*>(AllocateBlock(size, GetParam()));
+  std::memset(block, 'x', size);
+  EXPECT_EQ(block[size - 1], 'x');
+  DeallocateBlock(block, size, GetParam());
+}
+
+INSTANTIATE_TEST_SUITE_P(AllocateBlockTest, AllocateBlockTest,
+                         testing::Values(HugePages::kNone,
+                                         HugePages::kTransparent,
+                                         HugePages::kExplicit));
+
+}  // namespace
+}  // namespace cel::internal
@@ -0,0 +1,175 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_INTERN_TABLE_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_INTERN_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace cel::internal {
+
+// Insert-only hash table of interned values, such as types, keyed by views
+// into the values they map to. Lookups of present keys take no locks: they
+// read an immutable array of entry pointers published with release semantics.
+// Insertions are serialized by a mutex, which lookups only take after a miss.
+//
+// When the table grows, the entries are copied into a larger array which is
+// then published in place of the old one. Readers may still be probing the old
+// array, so it is retired rather than freed, until the table is destroyed.
+// Since each array is twice the size of the last, the retired arrays take no
+// more memory than the current one. Entries are never removed.
+//
+// `Hash` and `Eq` must be transparent to every lookup key type used.
+template <typename K, typename V, typename Hash, typename Eq>
+class InternTable final {
+ public:
+  InternTable() = default;
+
+  InternTable(const InternTable&) = delete;
+  InternTable& operator=(const InternTable&) = delete;
+
+  // Returns the value interned for `key`, or `nullptr`. Never blocks.
+  template <typename L>
+  const V* Find(const L& key) const {
+    return Find(table_.load(std::memory_order_acquire), key, Hash{}(key));
+  }
+
+  // Returns the value interned for `key`, interning the value returned by
+  // `make_value()` if there is none. `key_of` returns the key of a value,
+  // which must remain valid for as long as the value does.
+  template <typename L, typename MakeValue, typename KeyOf>
+  V FindOrInsert(const L& key, MakeValue make_value, KeyOf key_of) {
+    const size_t hash = Hash{}(key);
+    if (const V* value =
+            Find(table_.load(std::memory_order_acquire), key, hash);
+        value != nullptr) {
+      return *value;
+    }
+    // Built outside of the lock; discarded if another thread won the race.
+    V value = make_value();
+    lock_count_.fetch_add(1, std::memory_order_relaxed);
+    absl::MutexLock lock(&mutex_);
+    if (const V* existing =
+            Find(table_.load(std::memory_order_relaxed), key, hash);
+        existing != nullptr) {
+      return *existing;
+    }
+    auto entry = std::make_unique<Entry>(std::move(value), key_of, hash);
+    if ((size() + 1) * 2 > capacity()) {
+      Grow();
+    }
+    Insert(*tables_.back(), entry.get());
+    size_.store(size_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    entries_.push_back(std::move(entry));
+    return entries_.back()->value;
+  }
+
+  // Number of interned values.
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  // Number of times the mutex was taken, i.e. the lookups which missed. At
+  // least `size()`, more if threads raced to intern the same key.
+  size_t lock_count() const {
+    return lock_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t kMinCapacity = 16;
+
+  struct Entry {
+    template <typename KeyOf>
+    Entry(V value, KeyOf key_of, size_t hash)
+        : value(std::move(value)), key(key_of(this->value)), hash(hash) {}
+
+    const V value;
+    const K key;
+    const size_t hash;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : capacity(capacity),
+          slots(std::make_unique<std::atomic<const Entry*>[]>(capacity)) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    const size_t capacity;
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+  };
+
+  template <typename L>
+  static const V* Find(const Table* table, const L& key, size_t hash) {
+    if (table == nullptr) {
+      return nullptr;
+    }
+    const size_t mask = table->capacity - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+      const Entry* entry = table->slots[index].load(std::memory_order_acquire);
+      if (entry == nullptr) {
+        return nullptr;
+      }
+      if (entry->hash == hash && Eq{}(entry->key, key)) {
+        return &entry->value;
+      }
+    }
+  }
+
+  // The table is at most half full, so probing always finds an empty slot.
+  static void Insert(Table& table, const Entry* entry) {
+    const size_t mask = table.capacity - 1;
+    size_t index = entry->hash & mask;
+    while (table.slots[index].load(std::memory_order_relaxed) != nullptr) {
+      index = (index + 1) & mask;
+    }
+    table.slots[index].store(entry, std::memory_order_release);
+  }
+
+  size_t capacity() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return tables_.empty() ? 0 : tables_.back()->capacity;
+  }
+
+  void Grow() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto table = std::make_unique<Table>(
+        tables_.empty() ? kMinCapacity : capacity() * 2);
+    for (const auto& entry : entries_) {
+      Insert(*table, entry.get());
+    }
+    table_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  // The most recently published table.
+  std::atomic<const Table*> table_{nullptr};
+  absl::Mutex mutex_;
+  // Only modified with `mutex_` held.
+  std::atomic<size_t> size_{0};
+  std::atomic<size_t> lock_count_{0};
+  // Every table published so far, the current one last.
+  std::vector<std::unique_ptr<Table>> tables_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::unique_ptr<Entry>> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_INTERN_TABLE_H_
@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/intern_table.h"
+
+#include <functional>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+using StringTable = InternTable<absl::string_view, std::string,
+                                absl::Hash<absl::string_view>, std::equal_to<>>;
+
+std::string Intern(StringTable& table, absl::string_view key) {
+  return table.FindOrInsert(
+      key, [&]() { return std::string(key); },
+      [](const std::string& value) -> absl::string_view { return value; });
+}
+
+TEST(InternTable, FindOrInsert) {
+  StringTable table;
+  EXPECT_EQ(table.Find(absl::string_view("a")), nullptr);
+
+  EXPECT_EQ(Intern(table, "a"), "a");
+  EXPECT_EQ(Intern(table, "a"), "a");
+  EXPECT_EQ(table.size(), 1);
+  // Only the first lookup missed.
+  EXPECT_EQ(table.lock_count(), 1);
+
+  const std::string* found = table.Find(absl::string_view("a"));
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(*found, "a");
+}
+
+TEST(InternTable, ValuesSurviveGrowth) {
+  StringTable table;
+  Intern(table, "key_0");
+  const std::string* first = table.Find(absl::string_view("key_0"));
+  for (int i = 1; i < 1000; ++i) {
+    Intern(table, absl::StrCat("key_", i));
+  }
+  EXPECT_EQ(table.size(), 1000);
+  EXPECT_EQ(table.Find(absl::string_view("key_0")), first);
+  for (int i = 0; i < 1000; ++i) {
+    std::string key = absl::StrCat("key_", i);
+    const std::string* found = table.Find(absl::string_view(key));
+    ASSERT_NE(found, nullptr) << key;
+    EXPECT_EQ(*found, key);
+  }
+}
+
+TEST(InternTable, Concurrent) {
+  StringTable table;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&table]() {
+      for (int i = 0; i < 500; ++i) {
+        std::string key = absl::StrCat("key_", i);
+        EXPECT_EQ(Intern(table, key), key);
+        EXPECT_NE(table.Find(absl::string_view(key)), nullptr);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(table.size(), 500);
+}
+
+}  // namespace
+}  // namespace cel::internal
@@ -71,6 +71,69 @@ bool IsFinite(absl::Time t) {
   return t != absl::InfiniteFuture() && t != absl::InfinitePast();
 }
 
+// Sets `sum` to `x + y`, returning true if the sum overflows.
+bool AddOverflows(int64_t x, int64_t y, int64_t& sum) {
+#if ABSL_HAVE_BUILTIN(__builtin_add_overflow)
+  return __builtin_add_overflow(x, y, &sum);
+#else
+  if (y > 0 ? x > kInt64Max - y : x < kInt64Min - y) {
+    return true;
+  }
+  sum = x + y;
+  return false;
+#endif
+}
+
+// Sets `diff` to `x - y`, returning true if the difference overflows.
+bool SubOverflows(int64_t x, int64_t y, int64_t& diff) {
+#if ABSL_HAVE_BUILTIN(__builtin_sub_overflow)
+  return __builtin_sub_overflow(x, y, &diff);
+#else
+  if (y < 0 ? x > kInt64Max + y : x < kInt64Min + y) {
+    return true;
+  }
+  diff = x - y;
+  return false;
+#endif
+}
+
+// Sets `nanos` to `seconds` in nanoseconds, returning true if it overflows.
+bool SecondsToNanosOverflows(int64_t seconds, int64_t& nanos) {
+#if ABSL_HAVE_BUILTIN(__builtin_mul_overflow)
+  return __builtin_mul_overflow(seconds, kOneSecondNanos, &nanos);
+#else
+  if (seconds > kInt64Max / kOneSecondNanos ||
+      seconds < kInt64Min / kOneSecondNanos) {
+    return true;
+  }
+  nanos = seconds * kOneSecondNanos;
+  return false;
+#endif
+}
+
+// A finite time or duration as whole seconds and the remaining nanoseconds,
+// the representation the timestamp arithmetic works on. Splitting only reads
+// the seconds of the absl representation, avoiding the general duration
+// division.
+struct SecondsAndNanos {
+  int64_t seconds;
+  int64_t nanos;
+};
+
+// Seconds since the Unix epoch rounded down, and nanos in [0, 999999999].
+SecondsAndNanos Split(absl::Time t) {
+  const int64_t seconds = absl::ToUnixSeconds(t);
+  return {seconds,
+          absl::ToInt64Nanoseconds(t - absl::FromUnixSeconds(seconds))};
+}
+
+// Seconds truncated toward zero, and nanos in [-999999999, 999999999] with
+// the sign of the duration.
+SecondsAndNanos Split(absl::Duration d) {
+  const int64_t seconds = absl::ToInt64Seconds(d);
+  return {seconds, absl::ToInt64Nanoseconds(d - absl::Seconds(seconds))};
+}
+
 }  // namespace
 
 absl::StatusOr<int64_t> CheckedAdd(int64_t x, int64_t y) {
@@ -237,31 +300,28 @@ absl::StatusOr<absl::Duration> CheckedNegation(absl::Duration v) {
 absl::StatusOr<absl::Time> CheckedAdd(absl::Time t, absl::Duration d) {
   CEL_RETURN_IF_ERROR(
       CheckRange(IsFinite(t) && IsFinite(d), "timestamp overflow"));
-  // First we break time into its components by truncating and subtracting.
-  const int64_t s1 = absl::ToUnixSeconds(t);
-  const int64_t ns1 = (t - absl::FromUnixSeconds(s1)) / absl::Nanoseconds(1);
-
-  // Second we break duration into its components by dividing and modulo.
-  // Truncate to seconds.
-  const int64_t s2 = d / kOneSecondDuration;
-  // Get remainder.
-  const int64_t ns2 = absl::ToInt64Nanoseconds(d % kOneSecondDuration);
+  const SecondsAndNanos lhs = Split(t);
+  const SecondsAndNanos rhs = Split(d);
 
   // Add seconds first, detecting any overflow.
-  CEL_ASSIGN_OR_RETURN(int64_t s, CheckedAdd(s1, s2));
-  // Nanoseconds cannot overflow as nanos are normalized to [0, 999999999].
-  absl::Duration ns = absl::Nanoseconds(ns2 + ns1);
-
-  // Normalize nanoseconds to be positive and carry extra nanos to seconds.
-  if (ns < absl::ZeroDuration() || ns >= kOneSecondDuration) {
-    // Add seconds, or no-op if nanseconds negative (ns never < -999_999_999ns)
-    CEL_ASSIGN_OR_RETURN(s, CheckedAdd(s, ns / kOneSecondDuration));
-    ns -= (ns / kOneSecondDuration) * kOneSecondDuration;
-    // Subtract a second to make the nanos positive.
-    if (ns < absl::ZeroDuration()) {
-      CEL_ASSIGN_OR_RETURN(s, CheckedAdd(s, -1));
-      ns += kOneSecondDuration;
-    }
+  int64_t s;
+  if (AddOverflows(lhs.seconds, rhs.seconds, s)) {
+    return absl::OutOfRangeError("integer overflow");
+  }
+  // Nanoseconds cannot overflow, the sum is in [-999999999, 1999999998].
+  int64_t ns = lhs.nanos + rhs.nanos;
+
+  // Normalize nanoseconds to be positive and carry to seconds.
+  int64_t carry = 0;
+  if (ns < 0) {
+    ns += kOneSecondNanos;
+    carry = -1;
+  } else if (ns >= kOneSecondNanos) {
+    ns -= kOneSecondNanos;
+    carry = 1;
+  }
+  if (carry != 0 && AddOverflows(s, carry, s)) {
+    return absl::OutOfRangeError("integer overflow");
   }
   // Check if the the number of seconds from Unix epoch is within our acceptable
   // range.
@@ -269,7 +329,7 @@ absl::StatusOr<absl::Time> CheckedAdd(absl::Time t, absl::Duration d) {
       CheckRange(s >= kMinUnixTime && s <= kMaxUnixTime, "timestamp overflow"));
 
   // Return resulting time.
-  return absl::FromUnixSeconds(s) + ns;
+  return absl::FromUnixSeconds(s) + absl::Nanoseconds(ns);
 }
 
 absl::StatusOr<absl::Time> CheckedSub(absl::Time t, absl::Duration d) {
@@ -280,22 +340,19 @@ absl::StatusOr<absl::Time> CheckedSub(absl::Time t, absl::Duration d) {
 absl::StatusOr<absl::Duration> CheckedSub(absl::Time t1, absl::Time t2) {
   CEL_RETURN_IF_ERROR(
       CheckRange(IsFinite(t1) && IsFinite(t2), "integer overflow"));
-  // First we break time into its components by truncating and subtracting.
-  const int64_t s1 = absl::ToUnixSeconds(t1);
-  const int64_t ns1 = (t1 - absl::FromUnixSeconds(s1)) / absl::Nanoseconds(1);
-  const int64_t s2 = absl::ToUnixSeconds(t2);
-  const int64_t ns2 = (t2 - absl::FromUnixSeconds(s2)) / absl::Nanoseconds(1);
-
-  // Subtract seconds first, detecting any overflow.
-  CEL_ASSIGN_OR_RETURN(int64_t s, CheckedSub(s1, s2));
-  // Nanoseconds cannot overflow as nanos are normalized to [0, 999999999].
-  absl::Duration ns = absl::Nanoseconds(ns1 - ns2);
-
-  // Scale the seconds result to nanos.
-  CEL_ASSIGN_OR_RETURN(const int64_t t, CheckedMul(s, kOneSecondNanos));
-  // Add the seconds (scaled to nanos) to the nanosecond value.
-  CEL_ASSIGN_OR_RETURN(const int64_t v,
-                       CheckedAdd(t, absl::ToInt64Nanoseconds(ns)));
+  const SecondsAndNanos lhs = Split(t1);
+  const SecondsAndNanos rhs = Split(t2);
+
+  // Subtract seconds first, then scale them to nanos and add the difference
+  // of the nanos, detecting any overflow. The difference of the nanos cannot
+  // overflow as they are normalized to [0, 999999999].
+  int64_t s;
+  int64_t v;
+  if (SubOverflows(lhs.seconds, rhs.seconds, s) ||
+      SecondsToNanosOverflows(s, v) ||
+      AddOverflows(v, lhs.nanos - rhs.nanos, v)) {
+    return absl::OutOfRangeError("integer overflow");
+  }
   return absl::Nanoseconds(v);
 }
 
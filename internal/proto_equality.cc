@@ -0,0 +1,207 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/proto_equality.h"
+
+#include <string>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace cel::internal {
+
+namespace {
+
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+
+enum class Comparison {
+  kEqual,
+  kNotEqual,
+  // The messages must be compared by MessageDifferencer.
+  kUnsupported,
+};
+
+Comparison CompareMessages(const Message& lhs, const Message& rhs);
+
+Comparison FromBool(bool equal) {
+  return equal ? Comparison::kEqual : Comparison::kNotEqual;
+}
+
+Comparison CompareSingularField(const Message& lhs, const Message& rhs,
+                                const FieldDescriptor& field) {
+  const Reflection& lhs_reflection = *lhs.GetReflection();
+  const Reflection& rhs_reflection = *rhs.GetReflection();
+  switch (field.cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return FromBool(lhs_reflection.GetInt32(lhs, &field) ==
+                      rhs_reflection.GetInt32(rhs, &field));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return FromBool(lhs_reflection.GetInt64(lhs, &field) ==
+                      rhs_reflection.GetInt64(rhs, &field));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return FromBool(lhs_reflection.GetUInt32(lhs, &field) ==
+                      rhs_reflection.GetUInt32(rhs, &field));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return FromBool(lhs_reflection.GetUInt64(lhs, &field) ==
+                      rhs_reflection.GetUInt64(rhs, &field));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return FromBool(lhs_reflection.GetDouble(lhs, &field) ==
+                      rhs_reflection.GetDouble(rhs, &field));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return FromBool(lhs_reflection.GetFloat(lhs, &field) ==
+                      rhs_reflection.GetFloat(rhs, &field));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return FromBool(lhs_reflection.GetBool(lhs, &field) ==
+                      rhs_reflection.GetBool(rhs, &field));
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return FromBool(lhs_reflection.GetEnumValue(lhs, &field) ==
+                      rhs_reflection.GetEnumValue(rhs, &field));
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string lhs_scratch;
+      std::string rhs_scratch;
+      return FromBool(
+          lhs_reflection.GetStringReference(lhs, &field, &lhs_scratch) ==
+          rhs_reflection.GetStringReference(rhs, &field, &rhs_scratch));
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return CompareMessages(lhs_reflection.GetMessage(lhs, &field),
+                             rhs_reflection.GetMessage(rhs, &field));
+  }
+  return Comparison::kUnsupported;
+}
+
+Comparison CompareRepeatedElement(const Message& lhs, const Message& rhs,
+                                  const FieldDescriptor& field, int index) {
+  const Reflection& lhs_reflection = *lhs.GetReflection();
+  const Reflection& rhs_reflection = *rhs.GetReflection();
+  switch (field.cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return FromBool(lhs_reflection.GetRepeatedInt32(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedInt32(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return FromBool(lhs_reflection.GetRepeatedInt64(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedInt64(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return FromBool(lhs_reflection.GetRepeatedUInt32(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedUInt32(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return FromBool(lhs_reflection.GetRepeatedUInt64(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedUInt64(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return FromBool(lhs_reflection.GetRepeatedDouble(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedDouble(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return FromBool(lhs_reflection.GetRepeatedFloat(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedFloat(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return FromBool(lhs_reflection.GetRepeatedBool(lhs, &field, index) ==
+                      rhs_reflection.GetRepeatedBool(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return FromBool(
+          lhs_reflection.GetRepeatedEnumValue(lhs, &field, index) ==
+          rhs_reflection.GetRepeatedEnumValue(rhs, &field, index));
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string lhs_scratch;
+      std::string rhs_scratch;
+      return FromBool(lhs_reflection.GetRepeatedStringReference(
+                          lhs, &field, index, &lhs_scratch) ==
+                      rhs_reflection.GetRepeatedStringReference(
+                          rhs, &field, index, &rhs_scratch));
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return CompareMessages(
+          lhs_reflection.GetRepeatedMessage(lhs, &field, index),
+          rhs_reflection.GetRepeatedMessage(rhs, &field, index));
+  }
+  return Comparison::kUnsupported;
+}
+
+Comparison CompareField(const Message& lhs, const Message& rhs,
+                        const FieldDescriptor& field) {
+  if (!field.is_repeated()) {
+    return CompareSingularField(lhs, rhs, field);
+  }
+  if (field.is_map()) {
+    // The differencer compares map entries regardless of their order.
+    return Comparison::kUnsupported;
+  }
+  int size = lhs.GetReflection()->FieldSize(lhs, &field);
+  if (size != rhs.GetReflection()->FieldSize(rhs, &field)) {
+    return Comparison::kNotEqual;
+  }
+  for (int i = 0; i < size; ++i) {
+    if (Comparison comparison = CompareRepeatedElement(lhs, rhs, field, i);
+        comparison != Comparison::kEqual) {
+      return comparison;
+    }
+  }
+  return Comparison::kEqual;
+}
+
+// Compares messages of the same type. Any difference found before a field
+// which isn't supported is also reported by the differencer, which compares
+// every field.
+Comparison CompareMessages(const Message& lhs, const Message& rhs) {
+  const Descriptor* descriptor = lhs.GetDescriptor();
+  if (descriptor->well_known_type() == Descriptor::WELLKNOWNTYPE_ANY) {
+    // The differencer compares the messages packed in Any.
+    return Comparison::kUnsupported;
+  }
+  const Reflection& lhs_reflection = *lhs.GetReflection();
+  const Reflection& rhs_reflection = *rhs.GetReflection();
+  if (!lhs_reflection.GetUnknownFields(lhs).empty() ||
+      !rhs_reflection.GetUnknownFields(rhs).empty()) {
+    return Comparison::kUnsupported;
+  }
+
+  std::vector<const FieldDescriptor*> lhs_fields;
+  std::vector<const FieldDescriptor*> rhs_fields;
+  lhs_reflection.ListFields(lhs, &lhs_fields);
+  rhs_reflection.ListFields(rhs, &rhs_fields);
+  if (lhs_fields != rhs_fields) {
+    return Comparison::kNotEqual;
+  }
+  for (const FieldDescriptor* field : lhs_fields) {
+    if (Comparison comparison = CompareField(lhs, rhs, *field);
+        comparison != Comparison::kEqual) {
+      return comparison;
+    }
+  }
+  return Comparison::kEqual;
+}
+
+}  // namespace
+
+bool ProtoMessageEquals(const Message& lhs, const Message& rhs) {
+  // The differencer's behavior is undefined for messages of different types.
+  if (lhs.GetDescriptor() != rhs.GetDescriptor()) {
+    return false;
+  }
+  switch (CompareMessages(lhs, rhs)) {
+    case Comparison::kEqual:
+      return true;
+    case Comparison::kNotEqual:
+      return false;
+    case Comparison::kUnsupported:
+      break;
+  }
+  return google::protobuf::util::MessageDifferencer::Equals(lhs, rhs);
+}
+
+}  // namespace cel::internal
@@ -0,0 +1,36 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_PROTO_EQUALITY_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_PROTO_EQUALITY_H_
+
+#include "google/protobuf/message.h"
+
+namespace cel::internal {
+
+// Returns whether `lhs` and `rhs` are equal, as determined by
+// `google::protobuf::util::MessageDifferencer::Equals`. Messages of different
+// types are never equal.
+//
+// Messages of the same type are compared field by field through reflection,
+// which avoids setting up a differencer for the messages typically compared
+// in expressions. Messages with map fields, `google.protobuf.Any` fields or
+// unknown fields, which the differencer treats specially, are still compared
+// by the differencer.
+bool ProtoMessageEquals(const google::protobuf::Message& lhs,
+                        const google::protobuf::Message& rhs);
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_PROTO_EQUALITY_H_
@@ -0,0 +1,110 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/proto_equality.h"
+
+#include <limits>
+
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/struct.pb.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+using ::google::protobuf::FileDescriptorProto;
+
+FileDescriptorProto MakeFile() {
+  FileDescriptorProto file;
+  file.set_name("foo.proto");
+  file.add_dependency("bar.proto");
+  file.add_public_dependency(0);
+  auto* message = file.add_message_type();
+  message->set_name("Foo");
+  auto* field = message->add_field();
+  field->set_name("bar");
+  field->set_number(1);
+  field->set_type(google::protobuf::FieldDescriptorProto::TYPE_INT64);
+  return file;
+}
+
+TEST(ProtoMessageEquals, EqualMessages) {
+  EXPECT_TRUE(ProtoMessageEquals(MakeFile(), MakeFile()));
+  EXPECT_TRUE(
+      ProtoMessageEquals(FileDescriptorProto(), FileDescriptorProto()));
+}
+
+TEST(ProtoMessageEquals, DifferentMessages) {
+  FileDescriptorProto lhs = MakeFile();
+
+  FileDescriptorProto rhs = MakeFile();
+  rhs.set_name("baz.proto");
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+
+  rhs = MakeFile();
+  rhs.mutable_message_type(0)->mutable_field(0)->set_number(2);
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+
+  rhs = MakeFile();
+  rhs.add_dependency("baz.proto");
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+
+  // Explicitly set default values are told apart from unset fields.
+  rhs = MakeFile();
+  rhs.set_package("");
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+}
+
+TEST(ProtoMessageEquals, DifferentTypes) {
+  google::protobuf::Int64Value lhs;
+  google::protobuf::UInt64Value rhs;
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+}
+
+TEST(ProtoMessageEquals, NaN) {
+  google::protobuf::DoubleValue value;
+  value.set_value(std::numeric_limits<double>::quiet_NaN());
+  EXPECT_FALSE(ProtoMessageEquals(value, value));
+}
+
+TEST(ProtoMessageEquals, MapFields) {
+  google::protobuf::Struct lhs;
+  (*lhs.mutable_fields())["a"].set_number_value(1);
+  (*lhs.mutable_fields())["b"].set_string_value("b");
+  google::protobuf::Struct rhs;
+  (*rhs.mutable_fields())["b"].set_string_value("b");
+  (*rhs.mutable_fields())["a"].set_number_value(1);
+  EXPECT_TRUE(ProtoMessageEquals(lhs, rhs));
+
+  (*rhs.mutable_fields())["a"].set_number_value(2);
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+}
+
+TEST(ProtoMessageEquals, AnyFields) {
+  google::protobuf::Any lhs;
+  lhs.PackFrom(MakeFile());
+  google::protobuf::Any rhs;
+  rhs.PackFrom(MakeFile());
+  EXPECT_TRUE(ProtoMessageEquals(lhs, rhs));
+
+  FileDescriptorProto other = MakeFile();
+  other.set_name("baz.proto");
+  rhs.PackFrom(other);
+  EXPECT_FALSE(ProtoMessageEquals(lhs, rhs));
+}
+
+}  // namespace
+}  // namespace cel::internal
@@ -0,0 +1,108 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/regex_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/no_destructor.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "re2/re2.h"
+
+namespace cel::internal {
+
+namespace {
+
+constexpr size_t kGlobalShards = 16;
+
+}  // namespace
+
+RegexCache& RegexCache::Global() {
+  static absl::NoDestructor<RegexCache> cache(0, kGlobalShards);
+  return *cache;
+}
+
+RegexCache::RegexCache(size_t capacity, size_t num_shards)
+    : capacity_(capacity),
+      num_shards_(std::max<size_t>(num_shards, 1)),
+      shards_(std::make_unique<Shard[]>(num_shards_)) {}
+
+void RegexCache::EnsureCapacity(size_t capacity) {
+  size_t current = capacity_.load(std::memory_order_relaxed);
+  while (current < capacity &&
+         !capacity_.compare_exchange_weak(current, capacity,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+size_t RegexCache::ShardCapacity() const {
+  size_t capacity = capacity_.load(std::memory_order_relaxed);
+  if (capacity == 0) {
+    return 0;
+  }
+  return std::max<size_t>((capacity + num_shards_ - 1) / num_shards_, 1);
+}
+
+size_t RegexCache::size() const {
+  size_t size = 0;
+  for (size_t i = 0; i < num_shards_; ++i) {
+    absl::MutexLock lock(&shards_[i].mutex);
+    size += shards_[i].entries.size();
+  }
+  return size;
+}
+
+std::shared_ptr<const RE2> RegexCache::GetOrCompile(absl::string_view pattern) {
+  const size_t shard_capacity = ShardCapacity();
+  if (shard_capacity == 0) {
+    return std::make_shared<const RE2>(pattern);
+  }
+
+  Shard& shard =
+      shards_[absl::Hash<absl::string_view>{}(pattern) % num_shards_];
+  {
+    absl::MutexLock lock(&shard.mutex);
+    if (auto it = shard.index.find(pattern); it != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      return it->second->program;
+    }
+  }
+
+  // Compile without holding the lock, compilation of a large pattern is
+  // much more expensive than the lookup.
+  auto program = std::make_shared<const RE2>(pattern);
+
+  absl::MutexLock lock(&shard.mutex);
+  if (auto it = shard.index.find(pattern); it != shard.index.end()) {
+    // Compiled concurrently by another caller.
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->program;
+  }
+  shard.entries.push_front(Entry{std::string(pattern), program});
+  shard.index.insert({shard.entries.front().pattern, shard.entries.begin()});
+  while (shard.entries.size() > shard_capacity) {
+    shard.index.erase(shard.entries.back().pattern);
+    shard.entries.pop_back();
+  }
+  return program;
+}
+
+}  // namespace cel::internal
@@ -0,0 +1,89 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_REGEX_CACHE_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_REGEX_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "re2/re2.h"
+
+namespace cel::internal {
+
+// Thread-safe, bounded LRU cache of compiled regular expressions.
+//
+// Programs are reference counted, so evicting an entry does not invalidate
+// programs that are still held by callers. Entries are split across shards
+// by pattern to reduce lock contention; each shard evicts independently.
+//
+// Programs are compiled with the default RE2 options. Limits such as the
+// maximum program size are left to callers since they do not affect the
+// compiled program.
+class RegexCache final {
+ public:
+  // Returns the process-wide cache. It starts with a capacity of zero (no
+  // caching) and grows with calls to `EnsureCapacity`.
+  static RegexCache& Global();
+
+  RegexCache(size_t capacity, size_t num_shards);
+
+  RegexCache(const RegexCache&) = delete;
+  RegexCache& operator=(const RegexCache&) = delete;
+
+  // Returns the compiled program for the pattern, compiling and caching it if
+  // needed. Never returns nullptr. Invalid patterns are cached as well; check
+  // `RE2::ok()` on the result.
+  std::shared_ptr<const RE2> GetOrCompile(absl::string_view pattern);
+
+  // Raises the capacity to at least `capacity` entries.
+  void EnsureCapacity(size_t capacity);
+
+  size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+  // Number of cached entries.
+  size_t size() const;
+
+ private:
+  struct Entry {
+    std::string pattern;
+    std::shared_ptr<const RE2> program;
+  };
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    // Most recently used first.
+    std::list<Entry> entries ABSL_GUARDED_BY(mutex);
+    // Keys point into the pattern of the corresponding entry.
+    absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  size_t ShardCapacity() const;
+
+  std::atomic<size_t> capacity_;
+  const size_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_REGEX_CACHE_H_
@@ -0,0 +1,106 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/regex_cache.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "internal/testing.h"
+#include "re2/re2.h"
+
+namespace cel::internal {
+namespace {
+
+TEST(RegexCache, ReturnsCachedProgram) {
+  RegexCache cache(/*capacity=*/4, /*num_shards=*/1);
+
+  std::shared_ptr<const RE2> first = cache.GetOrCompile("a+b");
+  std::shared_ptr<const RE2> second = cache.GetOrCompile("a+b");
+
+  ASSERT_TRUE(first->ok());
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_TRUE(RE2::PartialMatch("xaabx", *first));
+}
+
+TEST(RegexCache, CachesInvalidPatterns) {
+  RegexCache cache(/*capacity=*/4, /*num_shards=*/1);
+
+  std::shared_ptr<const RE2> program = cache.GetOrCompile("(");
+
+  ASSERT_NE(program, nullptr);
+  EXPECT_FALSE(program->ok());
+  EXPECT_EQ(cache.GetOrCompile("("), program);
+}
+
+TEST(RegexCache, EvictsLeastRecentlyUsed) {
+  RegexCache cache(/*capacity=*/2, /*num_shards=*/1);
+
+  std::shared_ptr<const RE2> a = cache.GetOrCompile("a");
+  std::shared_ptr<const RE2> b = cache.GetOrCompile("b");
+  // Touch a so that b is evicted next.
+  EXPECT_EQ(cache.GetOrCompile("a"), a);
+  cache.GetOrCompile("c");
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.GetOrCompile("a"), a);
+  std::shared_ptr<const RE2> new_b = cache.GetOrCompile("b");
+  EXPECT_NE(new_b, b);
+  // Evicted programs remain usable by existing holders.
+  EXPECT_TRUE(RE2::FullMatch("b", *b));
+}
+
+TEST(RegexCache, ZeroCapacityDisablesCaching) {
+  RegexCache cache(/*capacity=*/0, /*num_shards=*/1);
+
+  std::shared_ptr<const RE2> first = cache.GetOrCompile("a");
+  std::shared_ptr<const RE2> second = cache.GetOrCompile("a");
+
+  EXPECT_NE(first, second);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(RegexCache, EnsureCapacityOnlyGrows) {
+  RegexCache cache(/*capacity=*/0, /*num_shards=*/4);
+
+  cache.EnsureCapacity(16);
+  cache.EnsureCapacity(8);
+
+  EXPECT_EQ(cache.capacity(), 16);
+  EXPECT_EQ(cache.GetOrCompile("a"), cache.GetOrCompile("a"));
+}
+
+TEST(RegexCache, ConcurrentAccess) {
+  RegexCache cache(/*capacity=*/8, /*num_shards=*/4);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&cache]() {
+      for (int j = 0; j < 100; ++j) {
+        ASSERT_TRUE(cache.GetOrCompile(absl::StrCat("p", j % 16))->ok());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_LE(cache.size(), 8);
+}
+
+}  // namespace
+}  // namespace cel::internal
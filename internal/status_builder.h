@@ -46,6 +46,8 @@ class StatusBuilder final {
 
   explicit StatusBuilder(const absl::Status& status) : status_(status) {}
 
+  explicit StatusBuilder(absl::Status&& status) : status_(std::move(status)) {}
+
   StatusBuilder(const StatusBuilder&) = default;
 
   StatusBuilder(StatusBuilder&&) = default;
@@ -135,6 +135,13 @@ class StatusAdaptor final {
 
   StatusAdaptor(const absl::Status& status) : builder_(status) {}  // NOLINT
 
+  // Temporaries, such as the results of the `Evaluate` calls of the steps,
+  // are moved instead of copied: checking an OK result is then a single test
+  // of its representation, and errors keep their payload without touching
+  // its reference count.
+  StatusAdaptor(absl::Status&& status)  // NOLINT
+      : builder_(std::move(status)) {}
+
   StatusAdaptor& operator=(const StatusAdaptor&) = delete;
 
   StatusAdaptor& operator=(StatusAdaptor&&) = delete;
@@ -0,0 +1,153 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "internal/string_replacer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+
+namespace cel::internal {
+
+absl::StatusOr<StringReplacer> StringReplacer::Create(
+    absl::Span<const std::pair<std::string, std::string>> replacements) {
+  StringReplacer replacer;
+  replacer.replacements_.assign(replacements.begin(), replacements.end());
+  std::vector<State>& states = replacer.states_;
+  states.emplace_back();
+  // Build the trie of the needles.
+  for (size_t i = 0; i < replacer.replacements_.size(); ++i) {
+    const std::string& needle = replacer.replacements_[i].first;
+    if (needle.empty()) {
+      return absl::InvalidArgumentError("cannot replace an empty string");
+    }
+    int32_t state = 0;
+    for (char c : needle) {
+      int32_t next = replacer.Child(state, c);
+      if (next == 0) {
+        next = static_cast<int32_t>(states.size());
+        states.emplace_back();
+        states.back().depth = states[state].depth + 1;
+        auto& children = states[state].children;
+        children.insert(
+            std::lower_bound(children.begin(), children.end(),
+                             std::make_pair(c, int32_t{0})),
+            std::make_pair(c, next));
+      }
+      state = next;
+    }
+    if (states[state].output != -1) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("duplicate replacement for '", needle, "'"));
+    }
+    states[state].output = static_cast<int32_t>(i);
+  }
+  // Compute the failure links breadth first, so that the failure state of
+  // each state, being shallower, is complete before the state itself.
+  std::deque<int32_t> queue;
+  for (const auto& [c, child] : states[0].children) {
+    queue.push_back(child);
+  }
+  while (!queue.empty()) {
+    int32_t state = queue.front();
+    queue.pop_front();
+    for (const auto& [c, child] : states[state].children) {
+      int32_t failure = replacer.Transition(states[state].failure, c);
+      states[child].failure = failure;
+      if (states[child].output == -1) {
+        states[child].output = states[failure].output;
+      }
+      queue.push_back(child);
+    }
+  }
+  return replacer;
+}
+
+int32_t StringReplacer::Child(int32_t state, char c) const {
+  const auto& children = states_[state].children;
+  auto it = std::lower_bound(
+      children.begin(), children.end(), c,
+      [](const std::pair<char, int32_t>& child, char c) {
+        return child.first < c;
+      });
+  return it != children.end() && it->first == c ? it->second : 0;
+}
+
+int32_t StringReplacer::Transition(int32_t state, char c) const {
+  while (true) {
+    int32_t next = Child(state, c);
+    if (next != 0 || state == 0) {
+      return next;
+    }
+    state = states_[state].failure;
+  }
+}
+
+absl::optional<std::string> StringReplacer::Replace(
+    absl::string_view subject) const {
+  absl::optional<std::string> result;
+  size_t cursor = 0;
+  while (cursor < subject.size()) {
+    // Find the leftmost-longest match at or after `cursor`. A match is only
+    // final once the current state is too shallow for any later match to
+    // start at or before it.
+    int32_t state = 0;
+    size_t match_start = 0;
+    int32_t match = -1;
+    for (size_t i = cursor; i < subject.size(); ++i) {
+      state = Transition(state, subject[i]);
+      if (match != -1 && i + 1 - states_[state].depth > match_start) {
+        break;
+      }
+      int32_t output = states_[state].output;
+      if (output == -1) {
+        continue;
+      }
+      size_t start = i + 1 - replacements_[output].first.size();
+      if (match == -1 || start < match_start ||
+          (start == match_start &&
+           replacements_[output].first.size() >
+               replacements_[match].first.size())) {
+        match_start = start;
+        match = output;
+      }
+    }
+    if (match == -1) {
+      break;
+    }
+    if (!result.has_value()) {
+      result.emplace();
+      result->reserve(subject.size());
+    }
+    result->append(subject.data() + cursor, match_start - cursor);
+    result->append(replacements_[match].second);
+    cursor = match_start + replacements_[match].first.size();
+  }
+  if (result.has_value()) {
+    result->append(subject.data() + cursor, subject.size() - cursor);
+  }
+  return result;
+}
+
+}  // namespace cel::internal
@@ -0,0 +1,70 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_STRING_REPLACER_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_STRING_REPLACER_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+
+namespace cel::internal {
+
+// Replaces several needles in a single pass over the subject, using an
+// Aho-Corasick automaton built once from the needles.
+//
+// At each position the leftmost occurrence of any needle is replaced, and of
+// the needles starting there the longest one wins. Replacements do not
+// overlap and their output is not scanned again, so `{"a": "b", "b": "a"}`
+// swaps the two letters.
+class StringReplacer final {
+ public:
+  // Fails if a needle is empty or given twice.
+  static absl::StatusOr<StringReplacer> Create(
+      absl::Span<const std::pair<std::string, std::string>> replacements);
+
+  StringReplacer(StringReplacer&&) = default;
+  StringReplacer& operator=(StringReplacer&&) = default;
+
+  // Returns `subject` with the needles replaced, or `absl::nullopt` if none
+  // of them occurs in it.
+  absl::optional<std::string> Replace(absl::string_view subject) const;
+
+ private:
+  struct State {
+    // Goto transitions, sorted by byte.
+    std::vector<std::pair<char, int32_t>> children;
+    int32_t failure = 0;
+    int32_t depth = 0;
+    // Index of the longest needle which is a suffix of this state, or -1.
+    int32_t output = -1;
+  };
+
+  StringReplacer() = default;
+
+  int32_t Child(int32_t state, char c) const;
+  int32_t Transition(int32_t state, char c) const;
+
+  std::vector<State> states_;
+  std::vector<std::pair<std::string, std::string>> replacements_;
+};
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_STRING_REPLACER_H_
@@ -0,0 +1,94 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "internal/string_replacer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/optional.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+using Replacements = std::vector<std::pair<std::string, std::string>>;
+
+absl::optional<std::string> Replace(const Replacements& replacements,
+                                    absl::string_view subject) {
+  auto replacer = StringReplacer::Create(replacements);
+  if (!replacer.ok()) {
+    ADD_FAILURE() << replacer.status();
+    return absl::nullopt;
+  }
+  return replacer->Replace(subject);
+}
+
+TEST(StringReplacer, NoMatch) {
+  EXPECT_EQ(Replace({{"foo", "bar"}}, ""), absl::nullopt);
+  EXPECT_EQ(Replace({{"foo", "bar"}}, "fo of oof"), absl::nullopt);
+  EXPECT_EQ(Replace({}, "foo"), absl::nullopt);
+}
+
+TEST(StringReplacer, Single) {
+  EXPECT_THAT(Replace({{"foo", "bar"}}, "foo"), Optional(Eq("bar")));
+  EXPECT_THAT(Replace({{"foo", "bar"}}, "a foo, a ffoo"),
+              Optional(Eq("a bar, a fbar")));
+  EXPECT_THAT(Replace({{"o", ""}}, "foo"), Optional(Eq("f")));
+}
+
+TEST(StringReplacer, NonOverlapping) {
+  EXPECT_THAT(Replace({{"aa", "b"}}, "aaaaa"), Optional(Eq("bba")));
+}
+
+TEST(StringReplacer, OutputNotRescanned) {
+  EXPECT_THAT(Replace({{"a", "b"}, {"b", "a"}}, "abba"),
+              Optional(Eq("baab")));
+}
+
+TEST(StringReplacer, LeftmostWins) {
+  EXPECT_THAT(Replace({{"bcd", "X"}, {"abc", "Y"}}, "abcd"),
+              Optional(Eq("Yd")));
+  // The earlier match ends later than the shorter one.
+  EXPECT_THAT(Replace({{"bc", "X"}, {"abcd", "Y"}}, "abcd"),
+              Optional(Eq("Y")));
+  EXPECT_THAT(Replace({{"bc", "X"}, {"abcd", "Y"}}, "abce"),
+              Optional(Eq("aXe")));
+}
+
+TEST(StringReplacer, LongestWins) {
+  EXPECT_THAT(Replace({{"a", "1"}, {"ab", "2"}, {"abc", "3"}}, "abcaba"),
+              Optional(Eq("321")));
+  EXPECT_THAT(Replace({{"he", "1"}, {"she", "2"}, {"hers", "3"}}, "ushers"),
+              Optional(Eq("u2rs")));
+}
+
+TEST(StringReplacer, Utf8) {
+  EXPECT_THAT(Replace({{"ä", "ae"}, {"ö", "oe"}}, "Köln ä"),
+              Optional(Eq("Koeln ae")));
+}
+
+TEST(StringReplacer, Errors) {
+  EXPECT_THAT(StringReplacer::Create({{"", "x"}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(StringReplacer::Create({{"a", "x"}, {"a", "y"}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace cel::internal
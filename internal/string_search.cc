@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "internal/string_search.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+
+namespace cel::internal {
+
+size_t FindSubstring(absl::string_view haystack, absl::string_view needle) {
+  if (needle.empty()) {
+    return 0;
+  }
+  if (needle.size() > haystack.size()) {
+    return absl::string_view::npos;
+  }
+  const char* const begin = haystack.data();
+  // One past the last position a match may start at.
+  const char* const end = begin + (haystack.size() - needle.size() + 1);
+  const char first = needle.front();
+  if (needle.size() == 1) {
+    const void* match = std::memchr(begin, first, end - begin);
+    return match == nullptr ? absl::string_view::npos
+                            : static_cast<const char*>(match) - begin;
+  }
+  const size_t last_offset = needle.size() - 1;
+  const char last = needle[last_offset];
+  const char* candidate = begin;
+  while (candidate < end) {
+    candidate = static_cast<const char*>(
+        std::memchr(candidate, first, end - candidate));
+    if (candidate == nullptr) {
+      break;
+    }
+    if (candidate[last_offset] == last &&
+        std::memcmp(candidate + 1, needle.data() + 1, last_offset - 1) == 0) {
+      return candidate - begin;
+    }
+    ++candidate;
+  }
+  return absl::string_view::npos;
+}
+
+bool ContainsSubstring(const absl::Cord& haystack, absl::string_view needle) {
+  if (auto flat = haystack.TryFlat(); flat.has_value()) {
+    return ContainsSubstring(*flat, needle);
+  }
+  if (needle.size() > haystack.size()) {
+    return false;
+  }
+  if (needle.empty()) {
+    return true;
+  }
+  // Matches straddling chunks are searched in a window made of the bytes
+  // preceding the chunk, at most the size of the needle minus one, and as
+  // many bytes from the start of the chunk.
+  const size_t overlap = needle.size() - 1;
+  std::string tail;
+  std::string window;
+  for (absl::string_view chunk : haystack.Chunks()) {
+    if (!tail.empty()) {
+      absl::string_view head = chunk.substr(0, overlap);
+      window.assign(tail);
+      window.append(head.data(), head.size());
+      if (ContainsSubstring(window, needle)) {
+        return true;
+      }
+    }
+    if (ContainsSubstring(chunk, needle)) {
+      return true;
+    }
+    if (overlap == 0) {
+      continue;
+    }
+    if (chunk.size() >= overlap) {
+      tail.assign(chunk.data() + (chunk.size() - overlap), overlap);
+    } else {
+      tail.append(chunk.data(), chunk.size());
+      if (tail.size() > overlap) {
+        tail.erase(0, tail.size() - overlap);
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace cel::internal
@@ -0,0 +1,46 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_STRING_SEARCH_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_STRING_SEARCH_H_
+
+#include <cstddef>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+
+namespace cel::internal {
+
+// Substring search shared by the string functions and the literal matches of
+// regular expressions.
+//
+// Candidates are located with `memchr` on the first byte of the needle, which
+// is vectorized by the C library, and filtered on its last byte before the
+// remaining bytes are compared.
+
+// Returns the offset of the first occurrence of `needle` in `haystack`, or
+// `absl::string_view::npos`.
+size_t FindSubstring(absl::string_view haystack, absl::string_view needle);
+
+inline bool ContainsSubstring(absl::string_view haystack,
+                              absl::string_view needle) {
+  return FindSubstring(haystack, needle) != absl::string_view::npos;
+}
+
+// Same as above, searching the chunks of `haystack` in place instead of
+// flattening it.
+bool ContainsSubstring(const absl::Cord& haystack, absl::string_view needle);
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_STRING_SEARCH_H_
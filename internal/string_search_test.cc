@@ -0,0 +1,75 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "internal/string_search.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/cord_test_helpers.h"
+#include "absl/strings/string_view.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+TEST(FindSubstring, Basic) {
+  EXPECT_EQ(FindSubstring("", ""), 0);
+  EXPECT_EQ(FindSubstring("abc", ""), 0);
+  EXPECT_EQ(FindSubstring("", "a"), absl::string_view::npos);
+  EXPECT_EQ(FindSubstring("abc", "c"), 2);
+  EXPECT_EQ(FindSubstring("abc", "abc"), 0);
+  EXPECT_EQ(FindSubstring("abc", "abcd"), absl::string_view::npos);
+  EXPECT_EQ(FindSubstring("abacabad", "abad"), 4);
+  EXPECT_EQ(FindSubstring("aaaab", "ab"), 3);
+  EXPECT_EQ(FindSubstring("abxbab", "ab"), 0);
+  EXPECT_EQ(FindSubstring("xaxbx", "ab"), absl::string_view::npos);
+  EXPECT_EQ(FindSubstring(absl::string_view("a\0b", 3),
+                          absl::string_view("\0b", 2)),
+            1);
+}
+
+TEST(FindSubstring, MatchesStringFind) {
+  const std::string haystack = "the quick brown fox jumps over the lazy dog";
+  for (size_t begin = 0; begin < haystack.size(); ++begin) {
+    for (size_t size = 0; begin + size <= haystack.size(); ++size) {
+      std::string needle = haystack.substr(begin, size);
+      EXPECT_EQ(FindSubstring(haystack, needle), haystack.find(needle))
+          << needle;
+    }
+  }
+  EXPECT_EQ(FindSubstring(haystack, "dog!"), absl::string_view::npos);
+  EXPECT_EQ(FindSubstring(haystack, "fax"), absl::string_view::npos);
+}
+
+TEST(ContainsSubstring, Cord) {
+  absl::Cord haystack =
+      absl::MakeFragmentedCord({"the qu", "i", "ck br", "own fox"});
+  ASSERT_FALSE(haystack.TryFlat().has_value());
+  const std::string flat(haystack);
+  for (size_t begin = 0; begin < flat.size(); ++begin) {
+    for (size_t size = 0; begin + size <= flat.size(); ++size) {
+      EXPECT_TRUE(ContainsSubstring(haystack, flat.substr(begin, size)))
+          << flat.substr(begin, size);
+    }
+  }
+  EXPECT_FALSE(ContainsSubstring(haystack, "quack"));
+  EXPECT_FALSE(ContainsSubstring(haystack, "fox!"));
+  EXPECT_FALSE(ContainsSubstring(haystack, "the quick brown fox!"));
+  EXPECT_TRUE(ContainsSubstring(absl::Cord("flat"), "la"));
+}
+
+}  // namespace
+}  // namespace cel::internal
@@ -14,9 +14,13 @@
 
 #include "internal/strings.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
@@ -41,6 +45,57 @@ constexpr int HexDigitToInt(char x) {
 
 constexpr bool IsOctalDigit(char x) { return x >= '0' && x <= '7'; }
 
+constexpr uint64_t kLowBits = 0x0101010101010101ULL;
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Whether any byte of `word` is zero.
+constexpr bool HasZeroByte(uint64_t word) {
+  return ((word - kLowBits) & ~word & kHighBits) != 0;
+}
+
+// Returns the offset of the first backslash or carriage return in `str` at or
+// after `pos`, or `str.size()` if there is none. Those are the only bytes the
+// unescaping doesn't copy as is, and most literals contain neither, so eight
+// bytes are tested at a time.
+size_t FindEscapeOrCarriageReturn(absl::string_view str, size_t pos) {
+  const char* data = str.data();
+  const size_t size = str.size();
+  while (pos + sizeof(uint64_t) <= size) {
+    uint64_t word;
+    std::memcpy(&word, data + pos, sizeof(word));
+    if (HasZeroByte(word ^ (kLowBits * '\\')) ||
+        HasZeroByte(word ^ (kLowBits * '\r'))) {
+      break;
+    }
+    pos += sizeof(word);
+  }
+  for (; pos < size; ++pos) {
+    if (data[pos] == '\\' || data[pos] == '\r') {
+      return pos;
+    }
+  }
+  return size;
+}
+
+// Returns the length of the longest prefix of `str` which is ASCII.
+size_t AsciiPrefixLength(absl::string_view str) {
+  const char* data = str.data();
+  const size_t size = str.size();
+  size_t pos = 0;
+  while (pos + sizeof(uint64_t) <= size) {
+    uint64_t word;
+    std::memcpy(&word, data + pos, sizeof(word));
+    if ((word & kHighBits) != 0) {
+      break;
+    }
+    pos += sizeof(word);
+  }
+  while (pos < size && static_cast<unsigned char>(data[pos]) < 0x80) {
+    ++pos;
+  }
+  return pos;
+}
+
 // Returns true when following conditions are met:
 // - <closing_str> is a suffix of <source>.
 // - No other unescaped occurrence of <closing_str> inside <source> (apart from
@@ -52,6 +107,25 @@ bool CheckForClosingString(absl::string_view source,
                            absl::string_view closing_str, std::string* error) {
   if (closing_str.empty()) return true;
 
+  if (source.find('\\') == absl::string_view::npos) {
+    // Without escapes, the first occurrence of the closing string must be the
+    // suffix.
+    size_t closing_pos = source.find(closing_str);
+    if (closing_pos == absl::string_view::npos) {
+      if (error) {
+        *error = absl::StrCat("String must end with ", closing_str);
+      }
+      return false;
+    }
+    if (closing_pos + closing_str.size() < source.size()) {
+      if (error) {
+        *error = absl::StrCat("String cannot contain unescaped ", closing_str);
+      }
+      return false;
+    }
+    return true;
+  }
+
   const char* p = source.data();
   const char* end = p + source.size();
 
@@ -120,7 +194,10 @@ bool UnescapeInternal(absl::string_view source, absl::string_view closing_str,
   // Strip off the closing_str from the end before unescaping.
   source = source.substr(0, source.size() - closing_str.size());
   if (!is_bytes_literal) {
-    if (!Utf8IsValid(source)) {
+    // Only validate from the first non-ASCII byte, if any.
+    absl::string_view non_ascii =
+        absl::ClippedSubstr(source, AsciiPrefixLength(source));
+    if (!non_ascii.empty() && !Utf8IsValid(non_ascii)) {
       if (error) {
         *error = absl::StrCat("Structurally invalid UTF8 string: ",
                               EscapeBytes(source));
@@ -129,6 +206,13 @@ bool UnescapeInternal(absl::string_view source, absl::string_view closing_str,
     }
   }
 
+  size_t literal_end = FindEscapeOrCarriageReturn(source, 0);
+  if (literal_end == source.size()) {
+    // Nothing to unescape.
+    dest->assign(source.data(), source.size());
+    return true;
+  }
+
   dest->reserve(source.size());
 
   const char* p = source.data();
@@ -138,7 +222,10 @@ bool UnescapeInternal(absl::string_view source, absl::string_view closing_str,
   while (p < end) {
     if (*p != '\\') {
       if (*p != '\r') {
-        dest->push_back(*p++);
+        // Copy the run up to the next escape or carriage return at once.
+        literal_end = FindEscapeOrCarriageReturn(source, p - source.data());
+        dest->append(p, source.data() + literal_end - p);
+        p = source.data() + literal_end;
       } else {
         // All types of newlines in different platforms i.e. '\r', '\n', '\r\n'
         // are replaced with '\n'.
@@ -655,6 +655,32 @@ TEST(StringsTest, TestNewlines) {
   ExpectParsedString("a\r\nb", {"'''a\\r\\nb'''"});
 }
 
+TEST(StringsTest, LongLiterals) {
+  // Escapes, carriage returns and non-ASCII bytes on either side of eight byte
+  // boundaries.
+  ExpectParsedString("abcdefghijklmnopqrstuvwxyz",
+                     {"'abcdefghijklmnopqrstuvwxyz'",
+                      "'''abcdefghijklmnopqrstuvwxyz'''"});
+  ExpectParsedString("abcdefg\nhijklmnop\tq", {"'abcdefg\\nhijklmnop\\tq'"});
+  ExpectParsedString("abcdefgh\nijklmnop\t", {"'abcdefgh\\nijklmnop\\t'"});
+  ExpectParsedString("abcdefghijklmno\nabcdefghijklmno\n",
+                     {"'''abcdefghijklmno\rabcdefghijklmno\r\n'''"});
+  ExpectParsedString("abcdefghijklmno\xC2\xA3gh",
+                     {"'abcdefghijklmno\xC2\xA3gh'",
+                      "'abcdefghijklmno\\u00A3gh'"});
+  ExpectParsedString("abcdefghijklmnop\\q\\rstuvwxyz",
+                     {"r'abcdefghijklmnop\\q\\rstuvwxyz'"});
+
+  EXPECT_THAT(ParseStringLiteral("'abcdefghijklmnop'qrstuvwxyz'"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("cannot contain unescaped '")));
+  EXPECT_THAT(ParseStringLiteral("'abcdefghijklmnop\xC2qrstuvwxyz'"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("Structurally invalid UTF8")));
+  ExpectParsedBytes("abcdefghijklmnop\xC2qrstuvwx",
+                    {"b'abcdefghijklmnop\xC2qrstuvwx'"});
+}
+
 TEST(RawStringsTest, CompareRawAndRegularStringParsing) {
   ExpectParsedString("\\n",
                      {"r'\\n'", "r\"\\n\"", "r'''\\n'''", "r\"\"\"\\n\"\"\""});
@@ -14,22 +14,289 @@
 
 #include "internal/time.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/civil_time.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "internal/status_macros.h"
 
 namespace cel::internal {
 
 namespace {
 
+// Civil fields of a timestamp in UTC.
+struct UtcFields {
+  int64_t year;
+  int month;
+  int day;
+  int hour;
+  int minute;
+  int second;
+  absl::Duration subsecond;
+};
+
+// Breaks down `timestamp` in UTC, as absl::UTCTimeZone().At() would. Returns
+// false outside of the range of CEL timestamps, which is left to absl.
+bool BreakDownUtc(absl::Time timestamp, UtcFields& fields) {
+  if (timestamp < MinTimestamp() || timestamp > MaxTimestamp()) {
+    return false;
+  }
+  constexpr int64_t kSecondsPerDay = 86400;
+  const int64_t seconds = absl::ToUnixSeconds(timestamp);
+  fields.subsecond = timestamp - absl::FromUnixSeconds(seconds);
+  int64_t days = seconds / kSecondsPerDay;
+  int64_t second_of_day = seconds % kSecondsPerDay;
+  if (second_of_day < 0) {
+    second_of_day += kSecondsPerDay;
+    --days;
+  }
+  fields.hour = static_cast<int>(second_of_day / 3600);
+  fields.minute = static_cast<int>(second_of_day / 60 % 60);
+  fields.second = static_cast<int>(second_of_day % 60);
+
+  // Converts days since 1970-01-01 to a date, counting 400 year eras from
+  // 0000-03-01 so that leap days fall at the end of a year.
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const int64_t day_of_era = days - era * 146097;
+  const int64_t year_of_era = (day_of_era - day_of_era / 1460 +
+                               day_of_era / 36524 - day_of_era / 146096) /
+                              365;
+  const int64_t day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const int64_t month_index = (5 * day_of_year + 2) / 153;
+  fields.day = static_cast<int>(day_of_year - (153 * month_index + 2) / 5 + 1);
+  fields.month = static_cast<int>(month_index < 10 ? month_index + 3
+                                                   : month_index - 9);
+  fields.year = year_of_era + era * 400 + (fields.month <= 2 ? 1 : 0);
+  return true;
+}
+
+// Writes `value` as exactly `width` decimal digits, returning the end.
+char* WriteDigits(char* out, uint64_t value, int width) {
+  for (int i = width - 1; i >= 0; --i) {
+    out[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return out + width;
+}
+
+// Writes `value` in decimal without leading zeros, returning the end.
+char* WriteNumber(char* out, uint64_t value) {
+  int width = 1;
+  for (uint64_t rest = value / 10; rest != 0; rest /= 10) {
+    ++width;
+  }
+  return WriteDigits(out, value, width);
+}
+
+// Writes the nine digit fraction `nanos` without trailing zeros, returning
+// the end.
+char* WriteTrimmedNanos(char* out, int64_t nanos) {
+  int width = 9;
+  for (; nanos % 10 == 0; nanos /= 10) {
+    --width;
+  }
+  return WriteDigits(out, nanos, width);
+}
+
+// Writes the fraction `nanos` with 3, 6 or 9 digits like protobuf does,
+// returning the end.
+char* WriteJsonNanos(char* out, int64_t nanos) {
+  constexpr int64_t kNanosPerMillisecond = 1000000;
+  constexpr int64_t kNanosPerMicrosecond = 1000;
+
+  if (nanos % kNanosPerMillisecond == 0) {
+    return WriteDigits(out, nanos / kNanosPerMillisecond, 3);
+  } else if (nanos % kNanosPerMicrosecond == 0) {
+    return WriteDigits(out, nanos / kNanosPerMicrosecond, 6);
+  }
+  return WriteDigits(out, nanos, 9);
+}
+
+// Writes `fields` as `%Y-%m-%dT%H:%M:%S`, or `%E4Y-%m-%dT%H:%M:%S` if
+// `pad_year`, returning the end.
+char* WriteUtcSeconds(char* out, const UtcFields& fields, bool pad_year) {
+  out = pad_year ? WriteDigits(out, fields.year, 4)
+                 : WriteNumber(out, fields.year);
+  *out++ = '-';
+  out = WriteDigits(out, fields.month, 2);
+  *out++ = '-';
+  out = WriteDigits(out, fields.day, 2);
+  *out++ = 'T';
+  out = WriteDigits(out, fields.hour, 2);
+  *out++ = ':';
+  out = WriteDigits(out, fields.minute, 2);
+  *out++ = ':';
+  return WriteDigits(out, fields.second, 2);
+}
+
+// Formats `timestamp` as `%Y-%m-%d%ET%H:%M:%E*SZ` in UTC.
 std::string RawFormatTimestamp(absl::Time timestamp) {
-  return absl::FormatTime("%Y-%m-%d%ET%H:%M:%E*SZ", timestamp,
-                          absl::UTCTimeZone());
+  UtcFields fields;
+  if (!BreakDownUtc(timestamp, fields) ||
+      fields.subsecond % absl::Nanoseconds(1) != absl::ZeroDuration()) {
+    return absl::FormatTime("%Y-%m-%d%ET%H:%M:%E*SZ", timestamp,
+                            absl::UTCTimeZone());
+  }
+  char buffer[kJsonTimeBufferSize];
+  char* out = WriteUtcSeconds(buffer, fields, /*pad_year=*/false);
+  const int64_t nanos = fields.subsecond / absl::Nanoseconds(1);
+  if (nanos != 0) {
+    *out++ = '.';
+    out = WriteTrimmedNanos(out, nanos);
+  }
+  *out++ = 'Z';
+  return std::string(buffer, out - buffer);
+}
+
+// Formats `duration` as absl::FormatDuration does, e.g. "1h2m3.5s" or
+// "1.5ms".
+std::string RawFormatDuration(absl::Duration duration) {
+  absl::Duration rest;
+  int64_t seconds = absl::IDivDuration(duration, absl::Seconds(1), &rest);
+  int64_t nanos = absl::IDivDuration(rest, absl::Nanoseconds(1), &rest);
+  if (rest != absl::ZeroDuration() || duration < MinDuration() ||
+      duration > MaxDuration()) {
+    // Fractions of nanoseconds, or overflowing the computation below.
+    return absl::FormatDuration(duration);
+  }
+  if (seconds == 0 && nanos == 0) {
+    return "0";
+  }
+  char buffer[kJsonTimeBufferSize];
+  char* out = buffer;
+  if (seconds < 0 || nanos < 0) {
+    *out++ = '-';
+    seconds = -seconds;
+    nanos = -nanos;
+  }
+  // Below one second, the duration is a fraction of the largest unit that
+  // is less than it.
+  if (seconds == 0) {
+    if (nanos < 1000) {
+      out = WriteNumber(out, nanos);
+      *out++ = 'n';
+    } else {
+      const bool micros = nanos < 1000000;
+      const int64_t unit = micros ? 1000 : 1000000;
+      out = WriteNumber(out, nanos / unit);
+      if (nanos % unit != 0) {
+        *out++ = '.';
+        out = WriteTrimmedNanos(out, nanos % unit * (1000000000 / unit));
+      }
+      *out++ = micros ? 'u' : 'm';
+    }
+    *out++ = 's';
+    return std::string(buffer, out - buffer);
+  }
+  if (seconds >= 3600) {
+    out = WriteNumber(out, seconds / 3600);
+    *out++ = 'h';
+  }
+  if (seconds % 3600 >= 60) {
+    out = WriteNumber(out, seconds % 3600 / 60);
+    *out++ = 'm';
+  }
+  if (seconds % 60 != 0 || nanos != 0) {
+    out = WriteNumber(out, seconds % 60);
+    if (nanos != 0) {
+      *out++ = '.';
+      out = WriteTrimmedNanos(out, nanos);
+    }
+    *out++ = 's';
+  }
+  return std::string(buffer, out - buffer);
+}
+
+bool ConsumeChar(absl::string_view& input, char c) {
+  if (input.empty() || input.front() != c) {
+    return false;
+  }
+  input.remove_prefix(1);
+  return true;
+}
+
+// Consumes exactly `n` decimal digits from the front of `input`.
+bool ConsumeDigits(absl::string_view& input, int n, int& value) {
+  if (input.size() < static_cast<size_t>(n)) {
+    return false;
+  }
+  int result = 0;
+  for (int i = 0; i < n; ++i) {
+    if (input[i] < '0' || input[i] > '9') {
+      return false;
+    }
+    result = result * 10 + (input[i] - '0');
+  }
+  input.remove_prefix(n);
+  value = result;
+  return true;
+}
+
+// Parses the canonical form of RFC 3339 timestamps. Returns absl::nullopt
+// for anything else, including leap seconds, lowercase separators and more
+// than nine fractional digits, which are left to absl::ParseTime. Only
+// inputs which absl::ParseTime accepts with the same result are parsed.
+absl::optional<absl::Time> ParseCanonicalRfc3339(absl::string_view input) {
+  int year, month, day, hour, minute, second;
+  if (!ConsumeDigits(input, 4, year) || !ConsumeChar(input, '-') ||
+      !ConsumeDigits(input, 2, month) || !ConsumeChar(input, '-') ||
+      !ConsumeDigits(input, 2, day) || !ConsumeChar(input, 'T') ||
+      !ConsumeDigits(input, 2, hour) || !ConsumeChar(input, ':') ||
+      !ConsumeDigits(input, 2, minute) || !ConsumeChar(input, ':') ||
+      !ConsumeDigits(input, 2, second)) {
+    return absl::nullopt;
+  }
+  int64_t nanos = 0;
+  if (ConsumeChar(input, '.')) {
+    int digits = 0;
+    while (!input.empty() && input.front() >= '0' && input.front() <= '9') {
+      if (++digits > 9) {
+        return absl::nullopt;
+      }
+      nanos = nanos * 10 + (input.front() - '0');
+      input.remove_prefix(1);
+    }
+    if (digits == 0) {
+      return absl::nullopt;
+    }
+    for (; digits < 9; ++digits) {
+      nanos *= 10;
+    }
+  }
+  int offset_minutes = 0;
+  if (!ConsumeChar(input, 'Z')) {
+    const bool negative = ConsumeChar(input, '-');
+    int offset_hour, offset_minute;
+    if ((!negative && !ConsumeChar(input, '+')) ||
+        !ConsumeDigits(input, 2, offset_hour) || !ConsumeChar(input, ':') ||
+        !ConsumeDigits(input, 2, offset_minute) || offset_hour > 23 ||
+        offset_minute > 59) {
+      return absl::nullopt;
+    }
+    offset_minutes = offset_hour * 60 + offset_minute;
+    if (negative) {
+      offset_minutes = -offset_minutes;
+    }
+  }
+  if (!input.empty() || month < 1 || month > 12 || day < 1 || hour > 23 ||
+      minute > 59 || second > 59) {
+    return absl::nullopt;
+  }
+  const absl::CivilSecond civil(year, month, day, hour, minute, second);
+  if (civil.day() != day) {
+    // Normalized, e.g. February 30th.
+    return absl::nullopt;
+  }
+  return absl::FromUnixSeconds(civil - absl::CivilSecond(1970)) -
+         absl::Minutes(offset_minutes) + absl::Nanoseconds(nanos);
 }
 
 }  // namespace
@@ -60,11 +327,11 @@ absl::StatusOr<absl::Duration> ParseDuration(absl::string_view input) {
 
 absl::StatusOr<std::string> FormatDuration(absl::Duration duration) {
   CEL_RETURN_IF_ERROR(ValidateDuration(duration));
-  return absl::FormatDuration(duration);
+  return RawFormatDuration(duration);
 }
 
 std::string DebugStringDuration(absl::Duration duration) {
-  return absl::FormatDuration(duration);
+  return RawFormatDuration(duration);
 }
 
 absl::Status ValidateTimestamp(absl::Time timestamp) {
@@ -83,11 +350,21 @@ absl::Status ValidateTimestamp(absl::Time timestamp) {
   return absl::OkStatus();
 }
 
+bool ParseRfc3339Time(absl::string_view input, absl::Time* time,
+                      std::string* err) {
+  if (absl::optional<absl::Time> parsed = ParseCanonicalRfc3339(input);
+      parsed.has_value()) {
+    *time = *parsed;
+    return true;
+  }
+  return absl::ParseTime(absl::RFC3339_full, input, absl::UTCTimeZone(), time,
+                         err);
+}
+
 absl::StatusOr<absl::Time> ParseTimestamp(absl::string_view input) {
   absl::Time timestamp;
   std::string err;
-  if (!absl::ParseTime(absl::RFC3339_full, input, absl::UTCTimeZone(),
-                       &timestamp, &err)) {
+  if (!ParseRfc3339Time(input, &timestamp, &err)) {
     return err.empty() ? absl::InvalidArgumentError(
                              "Failed to parse timestamp from string")
                        : absl::InvalidArgumentError(absl::StrCat(
@@ -102,58 +379,76 @@ absl::StatusOr<std::string> FormatTimestamp(absl::Time timestamp) {
   return RawFormatTimestamp(timestamp);
 }
 
-std::string FormatNanos(int32_t nanos) {
-  constexpr int32_t kNanosPerMillisecond = 1000000;
-  constexpr int32_t kNanosPerMicrosecond = 1000;
-
-  if (nanos % kNanosPerMillisecond == 0) {
-    return absl::StrFormat("%03d", nanos / kNanosPerMillisecond);
-  } else if (nanos % kNanosPerMicrosecond == 0) {
-    return absl::StrFormat("%06d", nanos / kNanosPerMicrosecond);
-  }
-  return absl::StrFormat("%09d", nanos);
-}
-
-absl::StatusOr<std::string> EncodeDurationToJson(absl::Duration duration) {
+absl::StatusOr<absl::string_view> EncodeDurationToJson(
+    absl::Duration duration, char (&buffer)[kJsonTimeBufferSize]) {
   // Adapted from protobuf time_util.
   CEL_RETURN_IF_ERROR(ValidateDuration(duration));
-  std::string result;
   int64_t seconds = absl::IDivDuration(duration, absl::Seconds(1), &duration);
   int64_t nanos = absl::IDivDuration(duration, absl::Nanoseconds(1), &duration);
 
+  char* out = buffer;
   if (seconds < 0 || nanos < 0) {
-    result = "-";
+    *out++ = '-';
     seconds = -seconds;
     nanos = -nanos;
   }
 
-  absl::StrAppend(&result, seconds);
+  out = WriteNumber(out, seconds);
   if (nanos != 0) {
-    absl::StrAppend(&result, ".", FormatNanos(nanos));
+    *out++ = '.';
+    out = WriteJsonNanos(out, nanos);
   }
 
-  absl::StrAppend(&result, "s");
-  return result;
+  *out++ = 's';
+  return absl::string_view(buffer, out - buffer);
 }
 
-absl::StatusOr<std::string> EncodeTimestampToJson(absl::Time timestamp) {
+absl::StatusOr<std::string> EncodeDurationToJson(absl::Duration duration) {
+  char buffer[kJsonTimeBufferSize];
+  CEL_ASSIGN_OR_RETURN(absl::string_view json,
+                       EncodeDurationToJson(duration, buffer));
+  return std::string(json);
+}
+
+absl::StatusOr<absl::string_view> EncodeTimestampToJson(
+    absl::Time timestamp, char (&buffer)[kJsonTimeBufferSize]) {
   // Adapted from protobuf time_util.
-  static constexpr absl::string_view kTimestampFormat = "%E4Y-%m-%dT%H:%M:%S";
   CEL_RETURN_IF_ERROR(ValidateTimestamp(timestamp));
+  UtcFields fields;
+  // Always in range after validation.
+  BreakDownUtc(timestamp, fields);
   // Handle nanos and the seconds separately to match proto JSON format.
-  absl::Time unix_seconds =
-      absl::FromUnixSeconds(absl::ToUnixSeconds(timestamp));
-  int64_t n = (timestamp - unix_seconds) / absl::Nanoseconds(1);
-
-  std::string result =
-      absl::FormatTime(kTimestampFormat, unix_seconds, absl::UTCTimeZone());
-
+  char* out = WriteUtcSeconds(buffer, fields, /*pad_year=*/true);
+  const int64_t n = fields.subsecond / absl::Nanoseconds(1);
   if (n > 0) {
-    absl::StrAppend(&result, ".", FormatNanos(n));
+    *out++ = '.';
+    out = WriteJsonNanos(out, n);
   }
 
-  absl::StrAppend(&result, "Z");
-  return result;
+  *out++ = 'Z';
+  return absl::string_view(buffer, out - buffer);
+}
+
+absl::StatusOr<std::string> EncodeTimestampToJson(absl::Time timestamp) {
+  char buffer[kJsonTimeBufferSize];
+  CEL_ASSIGN_OR_RETURN(absl::string_view json,
+                       EncodeTimestampToJson(timestamp, buffer));
+  return std::string(json);
+}
+
+absl::TimeZone::CivilInfo UtcCivilInfo(absl::Time timestamp) {
+  UtcFields fields;
+  if (!BreakDownUtc(timestamp, fields)) {
+    return absl::UTCTimeZone().At(timestamp);
+  }
+  absl::TimeZone::CivilInfo info;
+  info.cs = absl::CivilSecond(fields.year, fields.month, fields.day,
+                              fields.hour, fields.minute, fields.second);
+  info.subsecond = fields.subsecond;
+  info.offset = 0;
+  info.is_dst = false;
+  info.zone_abbr = "UTC";
+  return info;
 }
 
 std::string DebugStringTimestamp(absl::Time timestamp) {
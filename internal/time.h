@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_INTERNAL_TIME_H_
 #define THIRD_PARTY_CEL_CPP_INTERNAL_TIME_H_
 
+#include <cstddef>
 #include <string>
 
 #include "absl/status/status.h"
@@ -55,6 +56,10 @@ namespace cel::internal {
   return absl::UnixEpoch() + absl::Seconds(-62135596800);
 }
 
+// Size of the buffers taken by EncodeDurationToJson and EncodeTimestampToJson,
+// enough for any valid duration or timestamp.
+inline constexpr size_t kJsonTimeBufferSize = 32;
+
 absl::Status ValidateDuration(absl::Duration duration);
 
 absl::StatusOr<absl::Duration> ParseDuration(absl::string_view input);
@@ -67,12 +72,24 @@ absl::StatusOr<std::string> FormatDuration(absl::Duration duration);
 // This implementation is compatible with protobuf.
 absl::StatusOr<std::string> EncodeDurationToJson(absl::Duration duration);
 
+// Same as above, but writes the encoding into `buffer` and returns a view of
+// it rather than allocating.
+absl::StatusOr<absl::string_view> EncodeDurationToJson(
+    absl::Duration duration, char (&buffer)[kJsonTimeBufferSize]);
+
 std::string DebugStringDuration(absl::Duration duration);
 
 absl::Status ValidateTimestamp(absl::Time timestamp);
 
 absl::StatusOr<absl::Time> ParseTimestamp(absl::string_view input);
 
+// Parses `input` as absl::ParseTime with absl::RFC3339_full would, without
+// validating the range of the result. Timestamps in the canonical form
+// `YYYY-MM-DDTHH:MM:SS[.F](Z|+HH:MM|-HH:MM)` are parsed without the generic
+// format engine. On failure, `err` (if not null) may be set to a description.
+bool ParseRfc3339Time(absl::string_view input, absl::Time* time,
+                      std::string* err = nullptr);
+
 // Human-friendly format for timestamp provided to match DebugString.
 // Checks that the timestamp is in the supported range for CEL values.
 absl::StatusOr<std::string> FormatTimestamp(absl::Time timestamp);
@@ -81,6 +98,16 @@ absl::StatusOr<std::string> FormatTimestamp(absl::Time timestamp);
 // This implementation is compatible with protobuf.
 absl::StatusOr<std::string> EncodeTimestampToJson(absl::Time timestamp);
 
+// Same as above, but writes the encoding into `buffer` and returns a view of
+// it rather than allocating.
+absl::StatusOr<absl::string_view> EncodeTimestampToJson(
+    absl::Time timestamp, char (&buffer)[kJsonTimeBufferSize]);
+
+// Returns the civil time of `timestamp` in UTC, like absl::UTCTimeZone().At().
+// Valid timestamps are broken down without going through the time zone
+// library.
+absl::TimeZone::CivilInfo UtcCivilInfo(absl::Time timestamp);
+
 std::string DebugStringTimestamp(absl::Time timestamp);
 
 }  // namespace cel::internal
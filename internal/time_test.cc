@@ -14,10 +14,12 @@
 
 #include "internal/time.h"
 
+#include <cstdint>
 #include <string>
 
 #include "google/protobuf/util/time_util.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "internal/testing.h"
 
@@ -114,6 +116,42 @@ TEST(ParseTimestamp, Conformance) {
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST(ParseRfc3339Time, MatchesAbslParseTime) {
+  for (absl::string_view input : {
+           "1970-01-01T00:00:00Z",
+           "2024-02-29T12:34:56.5Z",
+           "2024-12-31T23:59:59.123456789Z",
+           "2024-06-01T08:00:00+02:00",
+           "2024-06-01T08:00:00.25-07:30",
+           "0001-01-01T00:00:00Z",
+           "9999-12-31T23:59:59.999999999Z",
+           // Outside of the canonical form.
+           "1-01-01T00:00:00Z",
+           "2024-06-01t08:00:00z",
+           "2016-12-31T23:59:60Z",
+           "2024-06-01T08:00:00.1234567891Z",
+           // Malformed.
+           "2023-02-29T00:00:00Z",
+           "2024-13-01T00:00:00Z",
+           "2024-06-01T08:00:00",
+           "2024-06-01T08:00:00.Z",
+           "2024-06-01 08:00:00Z",
+           "2024-06-01T08:00:00+0200",
+           "abc",
+           "",
+       }) {
+    absl::Time expected;
+    bool expected_ok = absl::ParseTime(absl::RFC3339_full, input,
+                                       absl::UTCTimeZone(), &expected, nullptr);
+    absl::Time parsed;
+    EXPECT_EQ(internal::ParseRfc3339Time(input, &parsed), expected_ok)
+        << input;
+    if (expected_ok) {
+      EXPECT_EQ(parsed, expected) << input;
+    }
+  }
+}
+
 TEST(FormatTimestamp, Conformance) {
   std::string formatted;
   ASSERT_OK_AND_ASSIGN(formatted, internal::FormatTimestamp(MinTimestamp()));
@@ -184,5 +222,82 @@ TEST(EncodeTimestampToJson, Conformance) {
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST(DebugStringDuration, MatchesAbslFormatDuration) {
+  for (absl::Duration duration : {
+           absl::ZeroDuration(),
+           absl::Nanoseconds(1),
+           absl::Nanoseconds(999),
+           absl::Nanoseconds(1500),
+           absl::Microseconds(999) + absl::Nanoseconds(999),
+           absl::Milliseconds(1) + absl::Nanoseconds(1),
+           absl::Milliseconds(999),
+           absl::Seconds(1),
+           absl::Seconds(59) + absl::Nanoseconds(123456789),
+           absl::Minutes(1),
+           absl::Hours(1),
+           absl::Hours(1) + absl::Seconds(1),
+           absl::Hours(25) + absl::Minutes(1) + absl::Milliseconds(500),
+           MaxDuration(),
+           MinDuration(),
+           // Not representable with nanoseconds.
+           absl::Nanoseconds(1) / 4,
+           absl::InfiniteDuration(),
+       }) {
+    EXPECT_EQ(DebugStringDuration(duration), absl::FormatDuration(duration));
+    EXPECT_EQ(DebugStringDuration(-duration), absl::FormatDuration(-duration));
+  }
+}
+
+TEST(DebugStringTimestamp, MatchesAbslFormatTime) {
+  for (absl::Time timestamp : {
+           absl::UnixEpoch(),
+           absl::UnixEpoch() - absl::Nanoseconds(1),
+           absl::FromUnixSeconds(951782400),   // 2000-02-29
+           absl::FromUnixSeconds(4107542400),  // 2100-03-01
+           absl::FromUnixSeconds(1709210096) + absl::Milliseconds(500),
+           absl::FromUnixSeconds(-2208988800) + absl::Nanoseconds(10),
+           MinTimestamp(),
+           MaxTimestamp(),
+           // Outside of the range of CEL timestamps.
+           MinTimestamp() - absl::Seconds(1),
+           MaxTimestamp() + absl::Seconds(1),
+           absl::UnixEpoch() + absl::Nanoseconds(1) / 4,
+       }) {
+    EXPECT_EQ(DebugStringTimestamp(timestamp),
+              absl::FormatTime("%Y-%m-%d%ET%H:%M:%E*SZ", timestamp,
+                               absl::UTCTimeZone()));
+  }
+}
+
+TEST(UtcCivilInfo, MatchesAbslUtcTimeZone) {
+  // Every day of four centuries, at different times of the day.
+  const absl::Time start = absl::FromUnixSeconds(-62135596800);
+  for (int64_t day = 0; day < 146097 * 4; day += 7) {
+    absl::Time timestamp = start + absl::Hours(24 * day) +
+                           absl::Seconds(day % 86400) +
+                           absl::Nanoseconds(day);
+    absl::TimeZone::CivilInfo expected = absl::UTCTimeZone().At(timestamp);
+    absl::TimeZone::CivilInfo info = UtcCivilInfo(timestamp);
+    EXPECT_EQ(info.cs, expected.cs) << timestamp;
+    EXPECT_EQ(info.subsecond, expected.subsecond) << timestamp;
+    EXPECT_EQ(info.offset, expected.offset);
+    EXPECT_EQ(info.is_dst, expected.is_dst);
+    EXPECT_STREQ(info.zone_abbr, expected.zone_abbr);
+  }
+  EXPECT_EQ(UtcCivilInfo(MaxTimestamp()).cs,
+            absl::CivilSecond(9999, 12, 31, 23, 59, 59));
+  EXPECT_EQ(UtcCivilInfo(absl::InfiniteFuture()).cs,
+            absl::UTCTimeZone().At(absl::InfiniteFuture()).cs);
+}
+
+TEST(EncodeTimestampToJson, Buffer) {
+  char buffer[kJsonTimeBufferSize];
+  ASSERT_OK_AND_ASSIGN(absl::string_view formatted,
+                       EncodeTimestampToJson(MaxTimestamp(), buffer));
+  EXPECT_EQ(formatted, "9999-12-31T23:59:59.999999999Z");
+  ASSERT_OK_AND_ASSIGN(formatted, EncodeDurationToJson(MinDuration(), buffer));
+  EXPECT_EQ(formatted, "-315576000000.999999999s");
+}
+
 }  // namespace
 }  // namespace cel::internal
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/time_zone_cache.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "absl/base/no_destructor.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "internal/intern_table.h"
+
+namespace cel::internal {
+
+namespace {
+
+// Bounds the memory taken by names from untrusted expressions. Later names
+// are resolved on every lookup.
+constexpr size_t kMaxCachedTimeZones = 1024;
+
+struct CachedTimeZone {
+  std::string name;
+  ResolvedTimeZone time_zone;
+};
+
+using TimeZoneTable =
+    InternTable<absl::string_view, CachedTimeZone,
+                absl::Hash<absl::string_view>, std::equal_to<>>;
+
+TimeZoneTable& GetTimeZoneTable() {
+  static absl::NoDestructor<TimeZoneTable> table;
+  return *table;
+}
+
+absl::optional<ResolvedTimeZone> ParseTimeZone(absl::string_view name) {
+  // Check to see whether the timezone is an IANA timezone.
+  absl::TimeZone zone;
+  if (absl::LoadTimeZone(name, &zone)) {
+    return ResolvedTimeZone(zone, absl::ZeroDuration());
+  }
+
+  // Check for times of the format: [+-]HH:MM and convert them into durations
+  // specified as [+-]HHhMMm.
+  if (absl::StrContains(name, ":")) {
+    std::string dur = absl::StrCat(name, "m");
+    absl::StrReplaceAll({{":", "h"}}, &dur);
+    absl::Duration offset;
+    if (absl::ParseDuration(dur, &offset)) {
+      return ResolvedTimeZone(absl::UTCTimeZone(), offset);
+    }
+  }
+  return absl::nullopt;
+}
+
+}  // namespace
+
+absl::optional<ResolvedTimeZone> ResolveTimeZone(absl::string_view name) {
+  if (name.empty()) {
+    return ResolvedTimeZone();
+  }
+  TimeZoneTable& table = GetTimeZoneTable();
+  if (const CachedTimeZone* cached = table.Find(name); cached != nullptr) {
+    return cached->time_zone;
+  }
+  absl::optional<ResolvedTimeZone> time_zone = ParseTimeZone(name);
+  if (!time_zone.has_value() || table.size() >= kMaxCachedTimeZones) {
+    return time_zone;
+  }
+  return table
+      .FindOrInsert(
+          name,
+          [&]() {
+            return CachedTimeZone{std::string(name), *time_zone};
+          },
+          [](const CachedTimeZone& cached) -> absl::string_view {
+            return cached.name;
+          })
+      .time_zone;
+}
+
+}  // namespace cel::internal
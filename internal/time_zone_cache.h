@@ -0,0 +1,59 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_INTERNAL_TIME_ZONE_CACHE_H_
+#define THIRD_PARTY_CEL_CPP_INTERNAL_TIME_ZONE_CACHE_H_
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "internal/time.h"
+
+namespace cel::internal {
+
+// A time zone argument of the CEL timestamp accessors, such as `getHours`.
+class ResolvedTimeZone final {
+ public:
+  ResolvedTimeZone() = default;
+
+  ResolvedTimeZone(absl::TimeZone zone, absl::Duration offset)
+      : zone_(zone), offset_(offset), utc_(zone == absl::UTCTimeZone()) {}
+
+  // Returns the civil time of `timestamp` in this time zone.
+  absl::TimeZone::CivilInfo At(absl::Time timestamp) const {
+    if (utc_) {
+      return UtcCivilInfo(timestamp + offset_);
+    }
+    return zone_.At(timestamp + offset_);
+  }
+
+ private:
+  absl::TimeZone zone_;
+  // Fixed offset from UTC, for zones of the form [+-]HH:MM.
+  absl::Duration offset_;
+  // Whether `zone_` is UTC, which is broken down without the time zone
+  // library. This includes the fixed offsets.
+  bool utc_ = true;
+};
+
+// Resolves `name`, either an IANA time zone name or a fixed UTC offset of the
+// form [+-]HH:MM, or UTC if empty. Returns `absl::nullopt` if it is neither.
+//
+// Resolved names are kept in a process-wide cache, so that repeated lookups of
+// the same time zone take no locks and do not reparse it.
+absl::optional<ResolvedTimeZone> ResolveTimeZone(absl::string_view name);
+
+}  // namespace cel::internal
+
+#endif  // THIRD_PARTY_CEL_CPP_INTERNAL_TIME_ZONE_CACHE_H_
@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/time_zone_cache.h"
+
+#include "absl/time/civil_time.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "internal/testing.h"
+
+namespace cel::internal {
+namespace {
+
+absl::Time Timestamp() {
+  return absl::FromCivil(absl::CivilSecond(2024, 1, 15, 12, 30, 0),
+                         absl::UTCTimeZone());
+}
+
+TEST(ResolveTimeZone, Empty) {
+  absl::optional<ResolvedTimeZone> time_zone = ResolveTimeZone("");
+  ASSERT_TRUE(time_zone.has_value());
+  EXPECT_EQ(time_zone->At(Timestamp()).cs,
+            absl::CivilSecond(2024, 1, 15, 12, 30, 0));
+}
+
+TEST(ResolveTimeZone, Iana) {
+  for (int i = 0; i < 2; ++i) {
+    absl::optional<ResolvedTimeZone> time_zone =
+        ResolveTimeZone("America/New_York");
+    ASSERT_TRUE(time_zone.has_value());
+    EXPECT_EQ(time_zone->At(Timestamp()).cs,
+              absl::CivilSecond(2024, 1, 15, 7, 30, 0));
+  }
+}
+
+TEST(ResolveTimeZone, FixedOffset) {
+  for (int i = 0; i < 2; ++i) {
+    absl::optional<ResolvedTimeZone> time_zone = ResolveTimeZone("+05:30");
+    ASSERT_TRUE(time_zone.has_value());
+    EXPECT_EQ(time_zone->At(Timestamp()).cs,
+              absl::CivilSecond(2024, 1, 15, 18, 0, 0));
+  }
+  absl::optional<ResolvedTimeZone> time_zone = ResolveTimeZone("-08:00");
+  ASSERT_TRUE(time_zone.has_value());
+  EXPECT_EQ(time_zone->At(Timestamp()).cs,
+            absl::CivilSecond(2024, 1, 15, 4, 30, 0));
+}
+
+TEST(ResolveTimeZone, Invalid) {
+  EXPECT_FALSE(ResolveTimeZone("Mars/Olympus_Mons").has_value());
+  EXPECT_FALSE(ResolveTimeZone("Mars/Olympus_Mons").has_value());
+  EXPECT_FALSE(ResolveTimeZone("+aa:bb").has_value());
+}
+
+}  // namespace
+}  // namespace cel::internal
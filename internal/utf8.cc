@@ -87,6 +87,29 @@ constexpr uint8_t kLeading[256] = {
 // clang-format on
 // NOLINTEND
 
+// Returns the length of the longest prefix of `str` which is entirely ASCII.
+// Checks the high bit of 16 bytes at a time, which compilers lower to vector
+// instructions on most targets, before finishing byte by byte.
+size_t AsciiPrefixLength(absl::string_view str) {
+  constexpr uint64_t kHighBits = 0x8080808080808080;
+  const char* data = str.data();
+  const size_t size = str.size();
+  size_t i = 0;
+  for (; i + 2 * sizeof(uint64_t) <= size; i += 2 * sizeof(uint64_t)) {
+    uint64_t lo;
+    uint64_t hi;
+    std::memcpy(&lo, data + i, sizeof(lo));
+    std::memcpy(&hi, data + i + sizeof(lo), sizeof(hi));
+    if (((lo | hi) & kHighBits) != 0) {
+      break;
+    }
+  }
+  while (i < size && static_cast<uint8_t>(data[i]) < kUtf8RuneSelf) {
+    ++i;
+  }
+  return i;
+}
+
 constexpr std::pair<const uint8_t, const uint8_t> kAccept[16] = {
     {kLow, kHigh}, {0xa0, kHigh}, {kLow, 0x9f}, {0x90, kHigh},
     {kLow, 0x8f},  {0x0, 0x0},    {0x0, 0x0},   {0x0, 0x0},
@@ -119,6 +142,14 @@ class StringReader final {
     input_.remove_prefix(n);
   }
 
+  // Consumes the longest run of ASCII characters at the front of the input,
+  // returning the number of bytes consumed.
+  size_t SkipAscii() {
+    size_t n = AsciiPrefixLength(input_);
+    input_.remove_prefix(n);
+    return n;
+  }
+
   void Reset(absl::string_view input) { input_ = input; }
 
  private:
@@ -189,6 +220,21 @@ class CordReader final {
     size_ -= n;
   }
 
+  // Consumes a run of ASCII characters at the front of the input, returning the
+  // number of bytes consumed. Only the current chunk is considered, so the run
+  // may end early at a chunk boundary.
+  size_t SkipAscii() {
+    if (index_ < buffer_.size() || input_.empty()) {
+      return 0;
+    }
+    size_t n = AsciiPrefixLength(*input_.chunk_begin());
+    if (n != 0) {
+      input_.RemovePrefix(n);
+      size_ -= n;
+    }
+    return n;
+  }
+
   void Reset(const absl::Cord& input) {
     input_ = input;
     size_ = input_.size();
@@ -208,6 +254,7 @@ bool Utf8IsValidImpl(BufferedByteReader* reader) {
   while (reader->HasRemaining()) {
     const auto b = static_cast<uint8_t>(reader->Read());
     if (b < kUtf8RuneSelf) {
+      reader->SkipAscii();
       continue;
     }
     const auto leading = kLeading[b];
@@ -244,6 +291,7 @@ size_t Utf8CodePointCountImpl(BufferedByteReader* reader) {
     count++;
     const auto b = static_cast<uint8_t>(reader->Read());
     if (b < kUtf8RuneSelf) {
+      count += reader->SkipAscii();
       continue;
     }
     const auto leading = kLeading[b];
@@ -279,7 +327,7 @@ std::pair<size_t, bool> Utf8ValidateImpl(BufferedByteReader* reader) {
   while (reader->HasRemaining()) {
     const auto b = static_cast<uint8_t>(reader->Read());
     if (b < kUtf8RuneSelf) {
-      count++;
+      count += 1 + reader->SkipAscii();
       continue;
     }
     const auto leading = kLeading[b];
@@ -299,6 +299,95 @@ INSTANTIATE_TEST_SUITE_P(Utf8DecodeTest, Utf8DecodeTest,
                              {0xFFFD, "\xef\xbf\xbd"},
                          }));
 
+TEST(Utf8, LongInputs) {
+  // Exercise the bulk ASCII scan with multi-byte and malformed sequences at
+  // every offset relative to the scan width.
+  for (size_t offset = 0; offset < 40; ++offset) {
+    std::string valid(offset, 'a');
+    valid.append("\xe6\x97\xa5");
+    valid.append(40, 'b');
+    EXPECT_TRUE(Utf8IsValid(valid)) << offset;
+    EXPECT_EQ(Utf8CodePointCount(valid), offset + 41) << offset;
+    EXPECT_EQ(Utf8Validate(valid), std::make_pair(offset + 41, true))
+        << offset;
+
+    std::string invalid(offset, 'a');
+    invalid.push_back('\xff');
+    invalid.append(40, 'b');
+    EXPECT_FALSE(Utf8IsValid(invalid)) << offset;
+    EXPECT_EQ(Utf8CodePointCount(invalid), offset + 41) << offset;
+    EXPECT_EQ(Utf8Validate(invalid), std::make_pair(offset, false)) << offset;
+
+    absl::Cord fragmented = absl::MakeFragmentedCord(
+        {invalid.substr(0, offset / 2), invalid.substr(offset / 2, 7),
+         invalid.substr(offset / 2 + 7)});
+    EXPECT_FALSE(Utf8IsValid(fragmented)) << offset;
+    EXPECT_EQ(Utf8CodePointCount(fragmented), offset + 41) << offset;
+    EXPECT_EQ(Utf8Validate(fragmented), std::make_pair(offset, false))
+        << offset;
+  }
+}
+
+std::string KilobyteString(absl::string_view unit, size_t kilobytes) {
+  std::string out;
+  while (out.size() < kilobytes * 1024) {
+    out.append(unit.data(), unit.size());
+  }
+  return out;
+}
+
+void BM_Utf8CodePointCount_String_Ascii(benchmark::State& state) {
+  std::string value = KilobyteString("0123456789", state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(Utf8CodePointCount(value));
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+BENCHMARK(BM_Utf8CodePointCount_String_Ascii)->Arg(1)->Arg(4)->Arg(64);
+
+void BM_Utf8CodePointCount_Cord_Ascii(benchmark::State& state) {
+  absl::Cord value(KilobyteString("0123456789", state.range(0)));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(Utf8CodePointCount(value));
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+BENCHMARK(BM_Utf8CodePointCount_Cord_Ascii)->Arg(1)->Arg(4)->Arg(64);
+
+void BM_Utf8CodePointCount_String_Mixed(benchmark::State& state) {
+  std::string value = KilobyteString(
+      "Content-Type: \xe6\x97\xa5\xe6\x9c\xac; ", state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(Utf8CodePointCount(value));
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+BENCHMARK(BM_Utf8CodePointCount_String_Mixed)->Arg(1)->Arg(4)->Arg(64);
+
+void BM_Utf8IsValid_String_Ascii(benchmark::State& state) {
+  std::string value = KilobyteString("0123456789", state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(Utf8IsValid(value));
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+BENCHMARK(BM_Utf8IsValid_String_Ascii)->Arg(1)->Arg(4)->Arg(64);
+
+void BM_Utf8IsValid_String_Japanese(benchmark::State& state) {
+  std::string value =
+      KilobyteString("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(Utf8IsValid(value));
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+BENCHMARK(BM_Utf8IsValid_String_Japanese)->Arg(1)->Arg(4)->Arg(64);
+
 void BM_Utf8CodePointCount_String_AsciiTen(benchmark::State& state) {
   for (auto s : state) {
     benchmark::DoNotOptimize(Utf8CodePointCount("0123456789"));
@@ -0,0 +1,390 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parser/internal/parser_macro_expr_factory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/overload.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/variant.h"
+#include "common/constant.h"
+#include "common/expr.h"
+#include "common/source.h"
+#include "internal/utf8.h"
+#include "parser/macro_registry.h"
+
+namespace cel_parser_internal {
+
+namespace {
+
+inline constexpr char32_t kDot = '.';
+inline constexpr char32_t kHat = '^';
+
+inline constexpr char32_t kWideDot = 0xff0e;
+inline constexpr char32_t kWideHat = 0xff3e;
+
+int32_t PositiveOrMax(int32_t value) {
+  return value >= 0 ? value : std::numeric_limits<int32_t>::max();
+}
+
+}  // namespace
+
+std::string DisplayParserError(const cel::Source& source,
+                               const ParserError& error) {
+  auto location =
+      source.GetLocation(error.range.begin).value_or(cel::SourceLocation{});
+  std::string s = absl::StrFormat("ERROR: %s:%zu:%zu: %s", source.description(),
+                                  location.line,
+                                  // add one to the 0-based column
+                                  location.column + 1, error.message);
+  if (auto snippet = source.Snippet(location.line); snippet) {
+    *snippet = absl::StrReplaceAll(*snippet, {{"\t", " "}});
+    absl::string_view snippet_view(*snippet);
+    std::string src_line;
+    src_line.append("\n | ");
+    src_line.append(*snippet);
+    std::string ind_line;
+    ind_line.append("\n | ");
+    for (int32_t i = 0; i < location.column && !snippet_view.empty(); ++i) {
+      size_t count;
+      std::tie(std::ignore, count) = cel::internal::Utf8Decode(snippet_view);
+      snippet_view.remove_prefix(count);
+      if (count > 1) {
+        cel::internal::Utf8Encode(ind_line, kWideDot);
+      } else {
+        cel::internal::Utf8Encode(ind_line, kDot);
+      }
+    }
+    size_t count = 0;
+    if (!snippet_view.empty()) {
+      std::tie(std::ignore, count) = cel::internal::Utf8Decode(snippet_view);
+    }
+    if (count > 1) {
+      cel::internal::Utf8Encode(ind_line, kWideHat);
+    } else {
+      cel::internal::Utf8Encode(ind_line, kHat);
+    }
+    s.append(src_line);
+    s.append(ind_line);
+  }
+  return s;
+}
+
+}  // namespace cel_parser_internal
+
+namespace cel {
+
+using ::cel_parser_internal::DisplayParserError;
+using ::cel_parser_internal::ParserError;
+using ::cel_parser_internal::PositiveOrMax;
+
+Expr ParserMacroExprFactory::ReportError(SourceRange range,
+                                         absl::string_view message) {
+  ++error_count_;
+  if (errors_.size() <= 100) {
+    errors_.push_back(ParserError{std::string(message), range});
+  }
+  return NewUnspecified(NextId(range));
+}
+
+void ParserMacroExprFactory::DiscardIdsFrom(int64_t id) {
+  positions_.erase(positions_.lower_bound(id), positions_.end());
+  for (auto it = macro_calls_.begin(); it != macro_calls_.end();) {
+    if (it->first >= id) {
+      macro_calls_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  expr_id_ = std::min(expr_id_, id);
+}
+
+std::string ParserMacroExprFactory::ErrorMessage() {
+  // Errors are collected as they are encountered, not by their location
+  // within the source. To have a more stable error message as implementation
+  // details change, we sort the collected errors by their source location
+  // first.
+  std::stable_sort(
+      errors_.begin(), errors_.end(),
+      [](const ParserError& lhs, const ParserError& rhs) -> bool {
+        auto lhs_begin = PositiveOrMax(lhs.range.begin);
+        auto lhs_end = PositiveOrMax(lhs.range.end);
+        auto rhs_begin = PositiveOrMax(rhs.range.begin);
+        auto rhs_end = PositiveOrMax(rhs.range.end);
+        return lhs_begin < rhs_begin ||
+               (lhs_begin == rhs_begin && lhs_end < rhs_end);
+      });
+  // Build the summary error message using the sorted errors.
+  bool errors_truncated = error_count_ > 100;
+  std::vector<std::string> messages;
+  messages.reserve(
+      errors_.size() +
+      errors_truncated);  // Reserve space for the transform and an
+                          // additional element when truncation occurs.
+  std::transform(errors_.begin(), errors_.end(), std::back_inserter(messages),
+                 [this](const ParserError& error) {
+                   return DisplayParserError(source_, error);
+                 });
+  if (errors_truncated) {
+    messages.emplace_back(
+        absl::StrCat(error_count_ - 100, " more errors were truncated."));
+  }
+  return absl::StrJoin(messages, "\n");
+}
+
+void ParserMacroExprFactory::AddMacroCall(int64_t macro_id,
+                                          absl::string_view function,
+                                          absl::optional<Expr> target,
+                                          std::vector<Expr> arguments) {
+  macro_calls_.insert(
+      {macro_id, target.has_value()
+                     ? NewMemberCall(0, function, std::move(*target),
+                                     std::move(arguments))
+                     : NewCall(0, function, std::move(arguments))});
+}
+
+Expr ParserMacroExprFactory::BuildMacroCallArg(const Expr& expr) {
+  if (auto it = macro_calls_.find(expr.id()); it != macro_calls_.end()) {
+    return NewUnspecified(expr.id());
+  }
+  return absl::visit(
+      absl::Overload(
+          [this, &expr](const UnspecifiedExpr&) -> Expr {
+            return NewUnspecified(expr.id());
+          },
+          [this, &expr](const Constant& const_expr) -> Expr {
+            return NewConst(expr.id(), const_expr);
+          },
+          [this, &expr](const IdentExpr& ident_expr) -> Expr {
+            return NewIdent(expr.id(), ident_expr.name());
+          },
+          [this, &expr](const SelectExpr& select_expr) -> Expr {
+            return select_expr.test_only()
+                       ? NewPresenceTest(
+                             expr.id(),
+                             BuildMacroCallArg(select_expr.operand()),
+                             select_expr.field())
+                       : NewSelect(expr.id(),
+                                   BuildMacroCallArg(select_expr.operand()),
+                                   select_expr.field());
+          },
+          [this, &expr](const CallExpr& call_expr) -> Expr {
+            std::vector<Expr> macro_arguments;
+            macro_arguments.reserve(call_expr.args().size());
+            for (const auto& argument : call_expr.args()) {
+              macro_arguments.push_back(BuildMacroCallArg(argument));
+            }
+            absl::optional<Expr> macro_target;
+            if (call_expr.has_target()) {
+              macro_target = BuildMacroCallArg(call_expr.target());
+            }
+            return macro_target.has_value()
+                       ? NewMemberCall(expr.id(), call_expr.function(),
+                                       std::move(*macro_target),
+                                       std::move(macro_arguments))
+                       : NewCall(expr.id(), call_expr.function(),
+                                 std::move(macro_arguments));
+          },
+          [this, &expr](const ListExpr& list_expr) -> Expr {
+            std::vector<ListExprElement> macro_elements;
+            macro_elements.reserve(list_expr.elements().size());
+            for (const auto& element : list_expr.elements()) {
+              auto& cloned_element = macro_elements.emplace_back();
+              if (element.has_expr()) {
+                cloned_element.set_expr(BuildMacroCallArg(element.expr()));
+              }
+              cloned_element.set_optional(element.optional());
+            }
+            return NewList(expr.id(), std::move(macro_elements));
+          },
+          [this, &expr](const StructExpr& struct_expr) -> Expr {
+            std::vector<StructExprField> macro_fields;
+            macro_fields.reserve(struct_expr.fields().size());
+            for (const auto& field : struct_expr.fields()) {
+              auto& macro_field = macro_fields.emplace_back();
+              macro_field.set_id(field.id());
+              macro_field.set_name(field.name());
+              macro_field.set_value(BuildMacroCallArg(field.value()));
+              macro_field.set_optional(field.optional());
+            }
+            return NewStruct(expr.id(), struct_expr.name(),
+                             std::move(macro_fields));
+          },
+          [this, &expr](const MapExpr& map_expr) -> Expr {
+            std::vector<MapExprEntry> macro_entries;
+            macro_entries.reserve(map_expr.entries().size());
+            for (const auto& entry : map_expr.entries()) {
+              auto& macro_entry = macro_entries.emplace_back();
+              macro_entry.set_id(entry.id());
+              macro_entry.set_key(BuildMacroCallArg(entry.key()));
+              macro_entry.set_value(BuildMacroCallArg(entry.value()));
+              macro_entry.set_optional(entry.optional());
+            }
+            return NewMap(expr.id(), std::move(macro_entries));
+          },
+          [this, &expr](const ComprehensionExpr& comprehension_expr) -> Expr {
+            return NewComprehension(
+                expr.id(), comprehension_expr.iter_var(),
+                BuildMacroCallArg(comprehension_expr.iter_range()),
+                comprehension_expr.accu_var(),
+                BuildMacroCallArg(comprehension_expr.accu_init()),
+                BuildMacroCallArg(comprehension_expr.loop_condition()),
+                BuildMacroCallArg(comprehension_expr.loop_step()),
+                BuildMacroCallArg(comprehension_expr.result()));
+          }),
+      expr.kind());
+}
+
+}  // namespace cel
+
+namespace cel_parser_internal {
+
+using ::cel::Expr;
+
+ExpressionBalancer::ExpressionBalancer(cel::ParserMacroExprFactory& factory,
+                                       std::string function, Expr expr,
+                                       bool flatten_nested)
+    : factory_(factory),
+      function_(std::move(function)),
+      flatten_nested_(flatten_nested) {
+  AppendTerm(std::move(expr));
+}
+
+void ExpressionBalancer::AddTerm(int64_t op, Expr term) {
+  ops_.push_back(op);
+  AppendTerm(std::move(term));
+}
+
+void ExpressionBalancer::AppendTerm(Expr term) {
+  if (!flatten_nested_ || !term.has_call_expr() ||
+      term.call_expr().has_target() ||
+      term.call_expr().function() != function_ ||
+      term.call_expr().args().size() != 2) {
+    terms_.push_back(std::move(term));
+    return;
+  }
+  // The call is rebuilt by Balance, keeping its ID as the operator ID so that
+  // the source positions carry over.
+  int64_t op = term.id();
+  std::vector<Expr> args = term.mutable_call_expr().release_args();
+  AppendTerm(std::move(args[0]));
+  ops_.push_back(op);
+  AppendTerm(std::move(args[1]));
+}
+
+Expr ExpressionBalancer::Balance() {
+  if (terms_.size() == 1) {
+    return std::move(terms_[0]);
+  }
+  return BalancedTree(0, ops_.size() - 1);
+}
+
+Expr ExpressionBalancer::BalancedTree(int lo, int hi) {
+  int mid = (lo + hi + 1) / 2;
+
+  std::vector<Expr> arguments;
+  arguments.reserve(2);
+
+  if (mid == lo) {
+    arguments.push_back(std::move(terms_[mid]));
+  } else {
+    arguments.push_back(BalancedTree(lo, mid - 1));
+  }
+
+  if (mid == hi) {
+    arguments.push_back(std::move(terms_[mid + 1]));
+  } else {
+    arguments.push_back(BalancedTree(mid + 1, hi));
+  }
+  return factory_.NewCall(ops_[mid], function_, std::move(arguments));
+}
+
+Expr GlobalCallOrMacro(cel::ParserMacroExprFactory& factory,
+                       const cel::MacroRegistry& macro_registry,
+                       bool add_macro_calls, int64_t expr_id,
+                       absl::string_view function, std::vector<Expr> args) {
+  if (auto macro = macro_registry.FindMacro(function, args.size(), false);
+      macro) {
+    std::vector<Expr> macro_args;
+    if (add_macro_calls) {
+      macro_args.reserve(args.size());
+      for (const auto& arg : args) {
+        macro_args.push_back(factory.BuildMacroCallArg(arg));
+      }
+    }
+    factory.BeginMacro(factory.GetSourceRange(expr_id));
+    auto expr = macro->Expand(factory, absl::nullopt, absl::MakeSpan(args));
+    factory.EndMacro();
+    if (expr) {
+      if (add_macro_calls) {
+        factory.AddMacroCall(expr->id(), function, absl::nullopt,
+                             std::move(macro_args));
+      }
+      // We did not end up using `expr_id`. Delete metadata.
+      factory.EraseId(expr_id);
+      return std::move(*expr);
+    }
+  }
+
+  return factory.NewCall(expr_id, function, std::move(args));
+}
+
+Expr ReceiverCallOrMacro(cel::ParserMacroExprFactory& factory,
+                         const cel::MacroRegistry& macro_registry,
+                         bool add_macro_calls, int64_t expr_id,
+                         absl::string_view function, Expr target,
+                         std::vector<Expr> args) {
+  if (auto macro = macro_registry.FindMacro(function, args.size(), true);
+      macro) {
+    Expr macro_target;
+    std::vector<Expr> macro_args;
+    if (add_macro_calls) {
+      macro_args.reserve(args.size());
+      macro_target = factory.BuildMacroCallArg(target);
+      for (const auto& arg : args) {
+        macro_args.push_back(factory.BuildMacroCallArg(arg));
+      }
+    }
+    factory.BeginMacro(factory.GetSourceRange(expr_id));
+    auto expr = macro->Expand(factory, std::ref(target), absl::MakeSpan(args));
+    factory.EndMacro();
+    if (expr) {
+      if (add_macro_calls) {
+        factory.AddMacroCall(expr->id(), function, std::move(macro_target),
+                             std::move(macro_args));
+      }
+      // We did not end up using `expr_id`. Delete metadata.
+      factory.EraseId(expr_id);
+      return std::move(*expr);
+    }
+  }
+  return factory.NewMemberCall(expr_id, function, std::move(target),
+                               std::move(args));
+}
+
+}  // namespace cel_parser_internal
@@ -0,0 +1,240 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_PARSER_INTERNAL_PARSER_MACRO_EXPR_FACTORY_H_
+#define THIRD_PARTY_CEL_CPP_PARSER_INTERNAL_PARSER_MACRO_EXPR_FACTORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/expr.h"
+#include "common/expr_factory.h"
+#include "common/source.h"
+#include "parser/macro_expr_factory.h"
+#include "parser/macro_registry.h"
+
+namespace cel_parser_internal {
+
+struct ParserError {
+  std::string message;
+  cel::SourceRange range;
+};
+
+// Formats `error` for display, including the offending line of `source`.
+std::string DisplayParserError(const cel::Source& source,
+                               const ParserError& error);
+
+}  // namespace cel_parser_internal
+
+namespace cel {
+
+// The expression factory shared by the parser implementations. It assigns
+// expression IDs, records their source ranges, collects errors, and expands
+// macros.
+class ParserMacroExprFactory final : public MacroExprFactory {
+ public:
+  explicit ParserMacroExprFactory(const cel::Source& source)
+      : MacroExprFactory(), source_(source) {}
+
+  void BeginMacro(SourceRange macro_position) {
+    macro_position_ = macro_position;
+  }
+
+  void EndMacro() { macro_position_ = SourceRange{}; }
+
+  Expr ReportError(absl::string_view message) override {
+    return ReportError(macro_position_, message);
+  }
+
+  Expr ReportError(int64_t expr_id, absl::string_view message) {
+    return ReportError(GetSourceRange(expr_id), message);
+  }
+
+  Expr ReportError(SourceRange range, absl::string_view message);
+
+  Expr ReportErrorAt(const Expr& expr, absl::string_view message) override {
+    return ReportError(GetSourceRange(expr.id()), message);
+  }
+
+  SourceRange GetSourceRange(int64_t id) const {
+    if (auto it = positions_.find(id); it != positions_.end()) {
+      return it->second;
+    }
+    return SourceRange{};
+  }
+
+  int64_t NextId(const SourceRange& range) {
+    auto id = expr_id_++;
+    if (range.begin != -1 || range.end != -1) {
+      positions_.insert(std::pair{id, range});
+    }
+    return id;
+  }
+
+  // Records the source range of `id`, for IDs allocated before the range of
+  // their expression is known.
+  void SetSourceRange(int64_t id, const SourceRange& range) {
+    positions_.insert_or_assign(id, range);
+  }
+
+  // Returns the ID the next expression will be assigned.
+  int64_t PeekNextId() const { return expr_id_; }
+
+  // Discards the IDs assigned from `id` onwards, along with their source
+  // ranges and macro calls, for expressions which were parsed but are not
+  // part of the result.
+  void DiscardIdsFrom(int64_t id);
+
+  bool HasErrors() const { return error_count_ != 0; }
+
+  std::string ErrorMessage();
+
+  void AddMacroCall(int64_t macro_id, absl::string_view function,
+                    absl::optional<Expr> target, std::vector<Expr> arguments);
+
+  Expr BuildMacroCallArg(const Expr& expr);
+
+  using ExprFactory::NewBoolConst;
+  using ExprFactory::NewBytesConst;
+  using ExprFactory::NewCall;
+  using ExprFactory::NewComprehension;
+  using ExprFactory::NewConst;
+  using ExprFactory::NewDoubleConst;
+  using ExprFactory::NewIdent;
+  using ExprFactory::NewIntConst;
+  using ExprFactory::NewList;
+  using ExprFactory::NewListElement;
+  using ExprFactory::NewMap;
+  using ExprFactory::NewMapEntry;
+  using ExprFactory::NewMemberCall;
+  using ExprFactory::NewNullConst;
+  using ExprFactory::NewPresenceTest;
+  using ExprFactory::NewSelect;
+  using ExprFactory::NewStringConst;
+  using ExprFactory::NewStruct;
+  using ExprFactory::NewStructField;
+  using ExprFactory::NewUintConst;
+  using ExprFactory::NewUnspecified;
+
+  const cel::Source& source() const { return source_; }
+
+  const absl::btree_map<int64_t, SourceRange>& positions() const {
+    return positions_;
+  }
+
+  const absl::flat_hash_map<int64_t, Expr>& macro_calls() const {
+    return macro_calls_;
+  }
+
+  absl::flat_hash_map<int64_t, Expr> release_macro_calls() {
+    return std::move(macro_calls_);
+  }
+
+  void EraseId(ExprId id) {
+    positions_.erase(id);
+    if (expr_id_ == id + 1) {
+      --expr_id_;
+    }
+  }
+
+ protected:
+  int64_t NextId() override { return NextId(macro_position_); }
+
+  int64_t CopyId(int64_t id) override {
+    if (id == 0) {
+      return 0;
+    }
+    return NextId(GetSourceRange(id));
+  }
+
+ private:
+  int64_t expr_id_ = 1;
+  absl::btree_map<int64_t, SourceRange> positions_;
+  absl::flat_hash_map<int64_t, Expr> macro_calls_;
+  std::vector<cel_parser_internal::ParserError> errors_;
+  size_t error_count_ = 0;
+  const Source& source_;
+  SourceRange macro_position_;
+};
+
+}  // namespace cel
+
+namespace cel_parser_internal {
+
+// balancer performs tree balancing on operators whose arguments are of equal
+// precedence.
+//
+// The purpose of the balancer is to ensure a compact serialization format for
+// the logical &&, || operators which have a tendency to create long DAGs which
+// are skewed in one direction. Since the operators are commutative re-ordering
+// the terms *must not* affect the evaluation result.
+//
+// Based on code from //third_party/cel/go/parser/helper.go
+class ExpressionBalancer final {
+ public:
+  // If `flatten_nested` is true, terms which are themselves calls of
+  // `function` are split into their operands, so that nested chains are
+  // balanced together.
+  ExpressionBalancer(cel::ParserMacroExprFactory& factory, std::string function,
+                     cel::Expr expr, bool flatten_nested = false);
+
+  // addTerm adds an operation identifier and term to the set of terms to be
+  // balanced.
+  void AddTerm(int64_t op, cel::Expr term);
+
+  // balance creates a balanced tree from the sub-terms and returns the final
+  // Expr value.
+  cel::Expr Balance();
+
+ private:
+  // balancedTree recursively balances the terms provided to a commutative
+  // operator.
+  cel::Expr BalancedTree(int lo, int hi);
+
+  void AppendTerm(cel::Expr term);
+
+ private:
+  cel::ParserMacroExprFactory& factory_;
+  std::string function_;
+  bool flatten_nested_;
+  std::vector<cel::Expr> terms_;
+  std::vector<int64_t> ops_;
+};
+
+// Expands the global call `function(args...)` with `expr_id` if it matches a
+// macro in `macro_registry`, otherwise creates the call expression.
+cel::Expr GlobalCallOrMacro(cel::ParserMacroExprFactory& factory,
+                            const cel::MacroRegistry& macro_registry,
+                            bool add_macro_calls, int64_t expr_id,
+                            absl::string_view function,
+                            std::vector<cel::Expr> args);
+
+// Expands the receiver call `target.function(args...)` with `expr_id` if it
+// matches a macro in `macro_registry`, otherwise creates the call expression.
+cel::Expr ReceiverCallOrMacro(cel::ParserMacroExprFactory& factory,
+                              const cel::MacroRegistry& macro_registry,
+                              bool add_macro_calls, int64_t expr_id,
+                              absl::string_view function, cel::Expr target,
+                              std::vector<cel::Expr> args);
+
+}  // namespace cel_parser_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_PARSER_INTERNAL_PARSER_MACRO_EXPR_FACTORY_H_
@@ -0,0 +1,1315 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parser/internal/recursive_descent_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "common/expr.h"
+#include "common/operators.h"
+#include "common/source.h"
+#include "internal/lexis.h"
+#include "internal/strings.h"
+#include "parser/internal/parser_macro_expr_factory.h"
+#include "parser/macro_registry.h"
+#include "parser/options.h"
+
+namespace cel_parser_internal {
+
+namespace {
+
+using ::cel::Expr;
+using ::cel::ListExprElement;
+using ::cel::MapExprEntry;
+using ::cel::SourceRange;
+using ::cel::StructExprField;
+using ::google::api::expr::common::CelOperator;
+
+// The tokens of Cel.g4, except for whitespace and comments.
+enum class TokenKind {
+  kEof,
+  // A token recognition error, which ends the token stream.
+  kError,
+  kEquals,
+  kNotEquals,
+  kIn,
+  kLess,
+  kLessEquals,
+  kGreaterEquals,
+  kGreater,
+  kLogicalAnd,
+  kLogicalOr,
+  kLBracket,
+  kRBracket,
+  kLBrace,
+  kRBrace,
+  kLParen,
+  kRParen,
+  kDot,
+  kComma,
+  kMinus,
+  kExclam,
+  kQuestionMark,
+  kColon,
+  kPlus,
+  kStar,
+  kSlash,
+  kPercent,
+  kTrue,
+  kFalse,
+  kNull,
+  kNumFloat,
+  kNumInt,
+  kNumUint,
+  kString,
+  kBytes,
+  kIdentifier,
+};
+
+struct Token {
+  TokenKind kind;
+  // Code point offsets of the token, `end` being exclusive.
+  int32_t begin;
+  int32_t end;
+};
+
+SourceRange TokenRange(const Token& token) {
+  return SourceRange{token.begin, token.end};
+}
+
+// Past the end of the content, never a valid code point.
+constexpr char32_t kEndOfInput = 0x110000;
+
+bool IsDigit(char32_t c) { return c >= '0' && c <= '9'; }
+
+bool IsHexDigit(char32_t c) {
+  return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool IsOctalDigit(char32_t c) { return c >= '0' && c <= '7'; }
+
+bool IsLetter(char32_t c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool IsQuote(char32_t c) { return c == '"' || c == '\''; }
+
+// Splits the content of a source into tokens, following the lexer rules of
+// Cel.g4.
+class Lexer final {
+ public:
+  explicit Lexer(cel::SourceContentView content)
+      : content_(content), size_(static_cast<int32_t>(content.size())) {}
+
+  // Returns the tokens of the content, ending with either an end of input or
+  // an error token.
+  std::vector<Token> Tokenize();
+
+ private:
+  char32_t At(int32_t index) const {
+    return index < size_ ? content_.at(index) : kEndOfInput;
+  }
+
+  // Returns the end of the whitespace and comments at `index`.
+  int32_t SkipHidden(int32_t index) const;
+
+  // Scans the NUM_FLOAT, NUM_INT or NUM_UINT at `index`.
+  Token ScanNumber(int32_t index) const;
+
+  // Returns the end of the exponent at `index`, or `index` if there is none.
+  int32_t ScanExponent(int32_t index) const;
+
+  // Scans the STRING whose quotes start at `quote`, raw or not, as a token of
+  // `kind` beginning at `begin`. Returns an error token ending after the
+  // offending code point if it does not match.
+  Token ScanString(TokenKind kind, int32_t begin, int32_t quote,
+                   bool raw) const;
+
+  // Returns the length of the escape sequence at `index`, or 0 if it is
+  // invalid, setting `error` to the offending position.
+  int32_t ScanEscape(int32_t index, int32_t& error) const;
+
+  Token ScanIdentifier(int32_t index) const;
+
+  Token Error(int32_t begin, int32_t error) const {
+    return Token{TokenKind::kError, begin, std::min(error + 1, size_)};
+  }
+
+  const cel::SourceContentView content_;
+  const int32_t size_;
+};
+
+std::vector<Token> Lexer::Tokenize() {
+  std::vector<Token> tokens;
+  // A rough estimate, avoiding most reallocations.
+  tokens.reserve(size_ / 2 + 1);
+  int32_t index = 0;
+  while (true) {
+    index = SkipHidden(index);
+    if (index >= size_) {
+      tokens.push_back(Token{TokenKind::kEof, size_, size_});
+      return tokens;
+    }
+    char32_t c = At(index);
+    char32_t next = At(index + 1);
+    Token token{TokenKind::kError, index, index + 1};
+    switch (c) {
+      case '=':
+        if (next != '=') {
+          token = Error(index, index + 1);
+          break;
+        }
+        token = Token{TokenKind::kEquals, index, index + 2};
+        break;
+      case '!':
+        token = next == '=' ? Token{TokenKind::kNotEquals, index, index + 2}
+                            : Token{TokenKind::kExclam, index, index + 1};
+        break;
+      case '<':
+        token = next == '=' ? Token{TokenKind::kLessEquals, index, index + 2}
+                            : Token{TokenKind::kLess, index, index + 1};
+        break;
+      case '>':
+        token = next == '='
+                    ? Token{TokenKind::kGreaterEquals, index, index + 2}
+                    : Token{TokenKind::kGreater, index, index + 1};
+        break;
+      case '&':
+        token = next == '&' ? Token{TokenKind::kLogicalAnd, index, index + 2}
+                            : Error(index, index + 1);
+        break;
+      case '|':
+        token = next == '|' ? Token{TokenKind::kLogicalOr, index, index + 2}
+                            : Error(index, index + 1);
+        break;
+      case '[':
+        token.kind = TokenKind::kLBracket;
+        break;
+      case ']':
+        token.kind = TokenKind::kRBracket;
+        break;
+      case '{':
+        token.kind = TokenKind::kLBrace;
+        break;
+      case '}':
+        token.kind = TokenKind::kRBrace;
+        break;
+      case '(':
+        token.kind = TokenKind::kLParen;
+        break;
+      case ')':
+        token.kind = TokenKind::kRParen;
+        break;
+      case '.':
+        if (IsDigit(next)) {
+          token = ScanNumber(index);
+        } else {
+          token.kind = TokenKind::kDot;
+        }
+        break;
+      case ',':
+        token.kind = TokenKind::kComma;
+        break;
+      case '-':
+        token.kind = TokenKind::kMinus;
+        break;
+      case '?':
+        token.kind = TokenKind::kQuestionMark;
+        break;
+      case ':':
+        token.kind = TokenKind::kColon;
+        break;
+      case '+':
+        token.kind = TokenKind::kPlus;
+        break;
+      case '*':
+        token.kind = TokenKind::kStar;
+        break;
+      case '/':
+        token.kind = TokenKind::kSlash;
+        break;
+      case '%':
+        token.kind = TokenKind::kPercent;
+        break;
+      case '"':
+      case '\'':
+        token = ScanString(TokenKind::kString, index, index, /*raw=*/false);
+        break;
+      default:
+        if (IsDigit(c)) {
+          token = ScanNumber(index);
+        } else if ((c == 'r' || c == 'R') && IsQuote(next)) {
+          token = ScanString(TokenKind::kString, index, index + 1,
+                             /*raw=*/true);
+        } else if ((c == 'b' || c == 'B') && IsQuote(next)) {
+          token = ScanString(TokenKind::kBytes, index, index + 1,
+                             /*raw=*/false);
+        } else if ((c == 'b' || c == 'B') && (next == 'r' || next == 'R') &&
+                   IsQuote(At(index + 2))) {
+          token = ScanString(TokenKind::kBytes, index, index + 2,
+                             /*raw=*/true);
+        } else if (IsLetter(c) || c == '_') {
+          token = ScanIdentifier(index);
+        } else {
+          token = Error(index, index);
+        }
+        break;
+    }
+    tokens.push_back(token);
+    if (token.kind == TokenKind::kError) {
+      return tokens;
+    }
+    index = token.end;
+  }
+}
+
+int32_t Lexer::SkipHidden(int32_t index) const {
+  while (index < size_) {
+    char32_t c = At(index);
+    if (c == '\t' || c == ' ' || c == '\r' || c == '\n' || c == '\f') {
+      ++index;
+    } else if (c == '/' && At(index + 1) == '/') {
+      index += 2;
+      while (index < size_ && At(index) != '\n') {
+        ++index;
+      }
+    } else {
+      break;
+    }
+  }
+  return index;
+}
+
+Token Lexer::ScanNumber(int32_t index) const {
+  int32_t begin = index;
+  if (At(index) == '.') {
+    ++index;
+    while (IsDigit(At(index))) {
+      ++index;
+    }
+    return Token{TokenKind::kNumFloat, begin, ScanExponent(index)};
+  }
+  if (At(index) == '0' && At(index + 1) == 'x' && IsHexDigit(At(index + 2))) {
+    index += 2;
+    while (IsHexDigit(At(index))) {
+      ++index;
+    }
+    if (At(index) == 'u' || At(index) == 'U') {
+      return Token{TokenKind::kNumUint, begin, index + 1};
+    }
+    return Token{TokenKind::kNumInt, begin, index};
+  }
+  while (IsDigit(At(index))) {
+    ++index;
+  }
+  if (At(index) == '.' && IsDigit(At(index + 1))) {
+    index += 2;
+    while (IsDigit(At(index))) {
+      ++index;
+    }
+    return Token{TokenKind::kNumFloat, begin, ScanExponent(index)};
+  }
+  if (int32_t end = ScanExponent(index); end != index) {
+    return Token{TokenKind::kNumFloat, begin, end};
+  }
+  if (At(index) == 'u' || At(index) == 'U') {
+    return Token{TokenKind::kNumUint, begin, index + 1};
+  }
+  return Token{TokenKind::kNumInt, begin, index};
+}
+
+int32_t Lexer::ScanExponent(int32_t index) const {
+  if (At(index) != 'e' && At(index) != 'E') {
+    return index;
+  }
+  int32_t end = index + 1;
+  if (At(end) == '+' || At(end) == '-') {
+    ++end;
+  }
+  if (!IsDigit(At(end))) {
+    return index;
+  }
+  while (IsDigit(At(end))) {
+    ++end;
+  }
+  return end;
+}
+
+Token Lexer::ScanString(TokenKind kind, int32_t begin, int32_t quote,
+                        bool raw) const {
+  char32_t q = At(quote);
+  if (At(quote + 1) == q && At(quote + 2) == q) {
+    // Triple quoted, ending at the first unescaped triple quote. Falls back to
+    // the empty string otherwise, as does the longest match of the lexer.
+    int32_t index = quote + 3;
+    while (index < size_) {
+      char32_t c = At(index);
+      if (c == q && At(index + 1) == q && At(index + 2) == q) {
+        return Token{kind, begin, index + 3};
+      }
+      if (c == '\\' && !raw) {
+        int32_t error;
+        int32_t length = ScanEscape(index, error);
+        if (length == 0) {
+          return Error(quote, error);
+        }
+        index += length;
+      } else {
+        ++index;
+      }
+    }
+    return Token{kind, begin, quote + 2};
+  }
+  int32_t index = quote + 1;
+  while (true) {
+    char32_t c = At(index);
+    if (c == q) {
+      return Token{kind, begin, index + 1};
+    }
+    if (c == '\n' || c == '\r' || c == kEndOfInput) {
+      return Error(quote, index);
+    }
+    if (c == '\\' && !raw) {
+      int32_t error;
+      int32_t length = ScanEscape(index, error);
+      if (length == 0) {
+        return Error(quote, error);
+      }
+      index += length;
+    } else {
+      ++index;
+    }
+  }
+}
+
+int32_t Lexer::ScanEscape(int32_t index, int32_t& error) const {
+  char32_t c = At(index + 1);
+  switch (c) {
+    case 'a':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+    case 'v':
+    case '"':
+    case '\'':
+    case '\\':
+    case '?':
+    case '`':
+      return 2;
+    case 'x':
+    case 'X':
+    case 'u':
+    case 'U': {
+      int32_t digits = c == 'u' ? 4 : c == 'U' ? 8 : 2;
+      for (int32_t i = 0; i < digits; ++i) {
+        if (!IsHexDigit(At(index + 2 + i))) {
+          error = index + 2 + i;
+          return 0;
+        }
+      }
+      return digits + 2;
+    }
+    default:
+      if (c >= '0' && c <= '3') {
+        for (int32_t i = 0; i < 2; ++i) {
+          if (!IsOctalDigit(At(index + 2 + i))) {
+            error = index + 2 + i;
+            return 0;
+          }
+        }
+        return 4;
+      }
+      error = index + 1;
+      return 0;
+  }
+}
+
+Token Lexer::ScanIdentifier(int32_t index) const {
+  int32_t begin = index;
+  while (IsLetter(At(index)) || IsDigit(At(index)) || At(index) == '_') {
+    ++index;
+  }
+  Token token{TokenKind::kIdentifier, begin, index};
+  // Keywords are at most 5 code points, all of them ASCII.
+  if (index - begin <= 5) {
+    std::string text = content_.ToString(begin, index);
+    if (text == "in") {
+      token.kind = TokenKind::kIn;
+    } else if (text == "true") {
+      token.kind = TokenKind::kTrue;
+    } else if (text == "false") {
+      token.kind = TokenKind::kFalse;
+    } else if (text == "null") {
+      token.kind = TokenKind::kNull;
+    }
+  }
+  return token;
+}
+
+// The tokens which may start a `primary`, as the ANTLR generated parser
+// reports them.
+constexpr absl::string_view kExpectedPrimary =
+    "{'[', '{', '(', '.', '-', '!', 'true', 'false', 'null', NUM_FLOAT, "
+    "NUM_INT, NUM_UINT, STRING, BYTES, IDENTIFIER}";
+
+absl::string_view RelationOperator(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::kLess:
+      return CelOperator::LESS;
+    case TokenKind::kLessEquals:
+      return CelOperator::LESS_EQUALS;
+    case TokenKind::kGreaterEquals:
+      return CelOperator::GREATER_EQUALS;
+    case TokenKind::kGreater:
+      return CelOperator::GREATER;
+    case TokenKind::kEquals:
+      return CelOperator::EQUALS;
+    case TokenKind::kNotEquals:
+      return CelOperator::NOT_EQUALS;
+    case TokenKind::kIn:
+      return CelOperator::IN;
+    default:
+      return absl::string_view();
+  }
+}
+
+absl::string_view AdditiveOperator(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::kPlus:
+      return CelOperator::ADD;
+    case TokenKind::kMinus:
+      return CelOperator::SUBTRACT;
+    default:
+      return absl::string_view();
+  }
+}
+
+absl::string_view MultiplicativeOperator(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::kStar:
+      return CelOperator::MULTIPLY;
+    case TokenKind::kSlash:
+      return CelOperator::DIVIDE;
+    case TokenKind::kPercent:
+      return CelOperator::MODULO;
+    default:
+      return absl::string_view();
+  }
+}
+
+std::string QuoteForError(absl::string_view text) {
+  return absl::StrCat(
+      "'",
+      absl::StrReplaceAll(text, {{"\n", "\\n"}, {"\r", "\\r"}, {"\t", "\\t"}}),
+      "'");
+}
+
+// Parses the rules of Cel.g4, building the expression as the visitor of the
+// ANTLR generated parse tree does: IDs are allocated in the same order, with
+// the same source ranges.
+class Parser final {
+ public:
+  Parser(const cel::MacroRegistry& macro_registry,
+         const cel::ParserOptions& options,
+         cel::ParserMacroExprFactory& factory, std::vector<Token> tokens)
+      : macro_registry_(macro_registry),
+        options_(options),
+        factory_(factory),
+        content_(factory.source().content()),
+        tokens_(std::move(tokens)) {}
+
+  absl::StatusOr<Expr> Parse();
+
+ private:
+  // A parsed expression, along with the recursion depth of the visitor when
+  // building it, which is limited by `ParserOptions::max_recursion_depth`.
+  struct Term {
+    Expr expr;
+    int depth = 1;
+    // Whether `expr` is a conditional outside of parentheses, which is one
+    // level shallower as a list element or call argument.
+    bool conditional = false;
+  };
+
+  const Token& Peek(size_t offset = 0) const {
+    return tokens_[std::min(pos_ + offset, tokens_.size() - 1)];
+  }
+
+  const Token& Next() {
+    const Token& token = tokens_[pos_];
+    previous_end_ = token.end;
+    if (pos_ + 1 < tokens_.size()) {
+      ++pos_;
+    }
+    return token;
+  }
+
+  std::string Text(const Token& token) const {
+    return content_.ToString(token.begin, token.end);
+  }
+
+  // Consumes the next token if it is of `kind`, otherwise reports a syntax
+  // error.
+  bool Expect(TokenKind kind, absl::string_view expected) {
+    if (Peek().kind != kind) {
+      SyntaxError(Peek(), expected);
+      return false;
+    }
+    Next();
+    return true;
+  }
+
+  // Reports a syntax error at `token` and stops parsing.
+  void SyntaxError(const Token& token, absl::string_view expected);
+
+  Term ParseExpr();
+  Term ParseConditional();
+  Term ParseLogical(TokenKind kind, absl::string_view function,
+                    Term (Parser::*parse_term)());
+  Term ParseConditionalOr() {
+    return ParseLogical(TokenKind::kLogicalOr, CelOperator::LOGICAL_OR,
+                        &Parser::ParseConditionalAnd);
+  }
+  Term ParseConditionalAnd() {
+    return ParseLogical(TokenKind::kLogicalAnd, CelOperator::LOGICAL_AND,
+                        &Parser::ParseRelation);
+  }
+  Term ParseBinary(absl::string_view (*lookup)(TokenKind),
+                   Term (Parser::*parse_operand)());
+  Term ParseRelation() {
+    return ParseBinary(RelationOperator, &Parser::ParseAdditive);
+  }
+  Term ParseAdditive() {
+    return ParseBinary(AdditiveOperator, &Parser::ParseMultiplicative);
+  }
+  Term ParseMultiplicative() {
+    return ParseBinary(MultiplicativeOperator, &Parser::ParseUnary);
+  }
+  Term ParseUnary();
+  Term ParseMember();
+  Term ParseSelectOrCall(int32_t begin, Term operand);
+  Term ParseIndex(int32_t begin, Term operand);
+  Term ParsePrimary();
+  Term ParseIdentOrGlobalCall();
+  Term ParseMessage();
+  Term ParseList();
+  Term ParseMap();
+  Term ParseLiteral();
+
+  // Parses the arguments of a call after the opening parenthesis, through
+  // the closing one, raising `depth` to that of the deepest argument.
+  std::vector<Expr> ParseArguments(int& depth);
+
+  // Reports `count` uses of optional syntax in `range`, if it is not enabled.
+  void ReportUnsupportedOptional(int count, SourceRange range);
+
+  // The depth of a list element or call argument, which the visitor builds
+  // without recursing in the case of a conditional.
+  static int ElementDepth(const Term& term) {
+    return term.conditional ? term.depth - 1 : term.depth;
+  }
+
+  Expr GlobalCallOrMacro(int64_t expr_id, absl::string_view function,
+                         std::vector<Expr> args) {
+    return cel_parser_internal::GlobalCallOrMacro(
+        factory_, macro_registry_, options_.add_macro_calls, expr_id, function,
+        std::move(args));
+  }
+
+  const cel::MacroRegistry& macro_registry_;
+  const cel::ParserOptions& options_;
+  cel::ParserMacroExprFactory& factory_;
+  const cel::SourceContentView content_;
+  const std::vector<Token> tokens_;
+  size_t pos_ = 0;
+  int32_t previous_end_ = 0;
+  // The nesting of `expr` rules, limited as by the ANTLR generated parser.
+  int expr_depth_ = 0;
+  // Set once parsing stops, either on a syntax error or when cancelled.
+  bool halted_ = false;
+  bool syntax_error_ = false;
+  std::string cancelled_;
+};
+
+absl::StatusOr<Expr> Parser::Parse() {
+  Term result = ParseExpr();
+  if (!halted_ && Peek().kind != TokenKind::kEof) {
+    SyntaxError(Peek(), "<EOF>");
+  }
+  if (!cancelled_.empty()) {
+    if (syntax_error_) {
+      return absl::InvalidArgumentError(factory_.ErrorMessage());
+    }
+    return absl::CancelledError(cancelled_);
+  }
+  if (!halted_ && result.depth > options_.max_recursion_depth) {
+    factory_.ReportError(
+        absl::StrFormat("Exceeded max recursion depth of %d when parsing.",
+                        options_.max_recursion_depth));
+  }
+  if (factory_.HasErrors()) {
+    return absl::InvalidArgumentError(factory_.ErrorMessage());
+  }
+  return std::move(result.expr);
+}
+
+void Parser::SyntaxError(const Token& token, absl::string_view expected) {
+  if (halted_) {
+    return;
+  }
+  halted_ = true;
+  syntax_error_ = true;
+  SourceRange range;
+  range.begin = token.begin;
+  if (token.kind == TokenKind::kError) {
+    factory_.ReportError(range,
+                         absl::StrCat("Syntax error: token recognition error "
+                                      "at: ",
+                                      QuoteForError(Text(token))));
+    return;
+  }
+  factory_.ReportError(
+      range, absl::StrCat("Syntax error: mismatched input ",
+                          token.kind == TokenKind::kEof
+                              ? std::string("<EOF>")
+                              : QuoteForError(Text(token)),
+                          " expecting ", expected));
+}
+
+Parser::Term Parser::ParseExpr() {
+  if (expr_depth_ > options_.max_recursion_depth) {
+    if (!halted_) {
+      halted_ = true;
+      cancelled_ =
+          absl::StrFormat("Expression recursion limit exceeded. limit: %d",
+                          options_.max_recursion_depth);
+    }
+    return Term{};
+  }
+  ++expr_depth_;
+  Term result = ParseConditional();
+  --expr_depth_;
+  return result;
+}
+
+Parser::Term Parser::ParseConditional() {
+  Term condition = ParseConditionalOr();
+  if (halted_ || Peek().kind != TokenKind::kQuestionMark) {
+    return condition;
+  }
+  int64_t op_id = factory_.NextId(TokenRange(Next()));
+  Term truthy = ParseConditionalOr();
+  if (halted_ || !Expect(TokenKind::kColon, "':'")) {
+    return Term{};
+  }
+  Term falsy = ParseExpr();
+  if (halted_) {
+    return Term{};
+  }
+  Term result;
+  result.depth =
+      1 + std::max({condition.depth, truthy.depth, falsy.depth});
+  result.conditional = true;
+  std::vector<Expr> arguments;
+  arguments.reserve(3);
+  arguments.push_back(std::move(condition.expr));
+  arguments.push_back(std::move(truthy.expr));
+  arguments.push_back(std::move(falsy.expr));
+  result.expr = factory_.NewCall(op_id, CelOperator::CONDITIONAL,
+                                 std::move(arguments));
+  return result;
+}
+
+Parser::Term Parser::ParseLogical(TokenKind kind, absl::string_view function,
+                                  Term (Parser::*parse_term)()) {
+  Term first = (this->*parse_term)();
+  if (halted_ || Peek().kind != kind) {
+    return first;
+  }
+  int depth = first.depth;
+  ExpressionBalancer balancer(factory_, std::string(function),
+                              std::move(first.expr),
+                              options_.enable_nested_logical_balancing);
+  while (Peek().kind == kind) {
+    SourceRange op_range = TokenRange(Next());
+    Term next = (this->*parse_term)();
+    if (halted_) {
+      return Term{};
+    }
+    // The visitor builds each term before the operator.
+    balancer.AddTerm(factory_.NextId(op_range), std::move(next.expr));
+    depth = std::max(depth, next.depth);
+  }
+  return Term{balancer.Balance(), depth + 1};
+}
+
+Parser::Term Parser::ParseBinary(absl::string_view (*lookup)(TokenKind),
+                                 Term (Parser::*parse_operand)()) {
+  Term lhs = (this->*parse_operand)();
+  while (!halted_) {
+    absl::string_view function = lookup(Peek().kind);
+    if (function.empty()) {
+      break;
+    }
+    int64_t op_id = factory_.NextId(TokenRange(Next()));
+    Term rhs = (this->*parse_operand)();
+    if (halted_) {
+      return Term{};
+    }
+    int depth = 1 + std::max(lhs.depth, rhs.depth);
+    std::vector<Expr> arguments;
+    arguments.reserve(2);
+    arguments.push_back(std::move(lhs.expr));
+    arguments.push_back(std::move(rhs.expr));
+    lhs = Term{GlobalCallOrMacro(op_id, function, std::move(arguments)),
+               depth};
+  }
+  return lhs;
+}
+
+Parser::Term Parser::ParseUnary() {
+  TokenKind kind = Peek().kind;
+  // A minus sign directly followed by a number is part of the literal.
+  if (kind != TokenKind::kExclam &&
+      (kind != TokenKind::kMinus || Peek(1).kind == TokenKind::kNumInt ||
+       Peek(1).kind == TokenKind::kNumFloat)) {
+    return ParseMember();
+  }
+  SourceRange op_range = TokenRange(Peek());
+  size_t count = 0;
+  while (Peek().kind == kind) {
+    Next();
+    ++count;
+  }
+  if (count % 2 == 0) {
+    Term result = ParseMember();
+    ++result.depth;
+    return result;
+  }
+  int64_t op_id = factory_.NextId(op_range);
+  Term operand = ParseMember();
+  if (halted_) {
+    return Term{};
+  }
+  std::vector<Expr> arguments;
+  arguments.push_back(std::move(operand.expr));
+  return Term{
+      GlobalCallOrMacro(op_id,
+                        kind == TokenKind::kExclam ? CelOperator::LOGICAL_NOT
+                                                   : CelOperator::NEGATE,
+                        std::move(arguments)),
+      operand.depth + 1};
+}
+
+Parser::Term Parser::ParseMember() {
+  int32_t begin = Peek().begin;
+  Term result = ParsePrimary();
+  while (!halted_) {
+    switch (Peek().kind) {
+      case TokenKind::kDot:
+        result = ParseSelectOrCall(begin, std::move(result));
+        break;
+      case TokenKind::kLBracket:
+        result = ParseIndex(begin, std::move(result));
+        break;
+      default:
+        return result;
+    }
+  }
+  return Term{};
+}
+
+Parser::Term Parser::ParseSelectOrCall(int32_t begin, Term operand) {
+  SourceRange op_range = TokenRange(Next());
+  bool optional = false;
+  if (Peek().kind == TokenKind::kQuestionMark) {
+    Next();
+    optional = true;
+  }
+  if (Peek().kind != TokenKind::kIdentifier) {
+    SyntaxError(Peek(), optional ? "IDENTIFIER" : "{'?', IDENTIFIER}");
+    return Term{};
+  }
+  const Token& id = Next();
+  std::string field = Text(id);
+  if (!optional && Peek().kind == TokenKind::kLParen) {
+    int64_t op_id = factory_.NextId(TokenRange(Next()));
+    int depth = operand.depth;
+    std::vector<Expr> arguments = ParseArguments(depth);
+    if (halted_) {
+      return Term{};
+    }
+    return Term{cel_parser_internal::ReceiverCallOrMacro(
+                    factory_, macro_registry_, options_.add_macro_calls,
+                    op_id, field, std::move(operand.expr),
+                    std::move(arguments)),
+                depth + 1};
+  }
+  int depth = operand.depth + 1;
+  if (optional) {
+    SourceRange range{begin, id.end};
+    if (!options_.enable_optional_syntax) {
+      return Term{factory_.ReportError(range, "unsupported syntax '.?'"),
+                  depth};
+    }
+    int64_t op_id = factory_.NextId(op_range);
+    std::vector<Expr> arguments;
+    arguments.reserve(2);
+    arguments.push_back(std::move(operand.expr));
+    arguments.push_back(
+        factory_.NewStringConst(factory_.NextId(range), std::move(field)));
+    return Term{
+        factory_.NewCall(op_id, CelOperator::OPT_SELECT, std::move(arguments)),
+        depth};
+  }
+  return Term{factory_.NewSelect(factory_.NextId(op_range),
+                                 std::move(operand.expr), std::move(field)),
+              depth};
+}
+
+Parser::Term Parser::ParseIndex(int32_t begin, Term operand) {
+  int64_t op_id = factory_.NextId(TokenRange(Next()));
+  bool optional = false;
+  if (Peek().kind == TokenKind::kQuestionMark) {
+    Next();
+    optional = true;
+  }
+  Term index = ParseExpr();
+  if (halted_ || !Expect(TokenKind::kRBracket, "']'")) {
+    return Term{};
+  }
+  int depth = 1 + std::max(operand.depth, index.depth);
+  if (optional && !options_.enable_optional_syntax) {
+    return Term{factory_.ReportError(SourceRange{begin, previous_end_},
+                                     "unsupported syntax '.?'"),
+                depth};
+  }
+  std::vector<Expr> arguments;
+  arguments.reserve(2);
+  arguments.push_back(std::move(operand.expr));
+  arguments.push_back(std::move(index.expr));
+  return Term{GlobalCallOrMacro(op_id,
+                                optional ? CelOperator::OPT_INDEX
+                                         : CelOperator::INDEX,
+                                std::move(arguments)),
+              depth};
+}
+
+Parser::Term Parser::ParsePrimary() {
+  switch (Peek().kind) {
+    case TokenKind::kDot:
+    case TokenKind::kIdentifier: {
+      // A qualified name followed by a brace is a message, otherwise only the
+      // first identifier is part of the primary.
+      size_t offset = Peek().kind == TokenKind::kDot ? 1 : 0;
+      if (Peek(offset).kind == TokenKind::kIdentifier) {
+        ++offset;
+        while (Peek(offset).kind == TokenKind::kDot &&
+               Peek(offset + 1).kind == TokenKind::kIdentifier) {
+          offset += 2;
+        }
+        if (Peek(offset).kind == TokenKind::kLBrace) {
+          return ParseMessage();
+        }
+      }
+      return ParseIdentOrGlobalCall();
+    }
+    case TokenKind::kLParen: {
+      Next();
+      Term result = ParseExpr();
+      if (halted_ || !Expect(TokenKind::kRParen, "')'")) {
+        return Term{};
+      }
+      result.conditional = false;
+      return result;
+    }
+    case TokenKind::kLBracket:
+      return ParseList();
+    case TokenKind::kLBrace:
+      return ParseMap();
+    case TokenKind::kMinus:
+      if (Peek(1).kind == TokenKind::kNumInt ||
+          Peek(1).kind == TokenKind::kNumFloat) {
+        return ParseLiteral();
+      }
+      Next();
+      SyntaxError(Peek(), "{NUM_FLOAT, NUM_INT}");
+      return Term{};
+    case TokenKind::kTrue:
+    case TokenKind::kFalse:
+    case TokenKind::kNull:
+    case TokenKind::kNumFloat:
+    case TokenKind::kNumInt:
+    case TokenKind::kNumUint:
+    case TokenKind::kString:
+    case TokenKind::kBytes:
+      return ParseLiteral();
+    default:
+      SyntaxError(Peek(), kExpectedPrimary);
+      return Term{};
+  }
+}
+
+Parser::Term Parser::ParseIdentOrGlobalCall() {
+  int32_t begin = Peek().begin;
+  std::string name;
+  if (Peek().kind == TokenKind::kDot) {
+    Next();
+    name = ".";
+  }
+  if (Peek().kind != TokenKind::kIdentifier) {
+    SyntaxError(Peek(), "IDENTIFIER");
+    return Term{};
+  }
+  const Token& id = Next();
+  std::string id_text = Text(id);
+  bool reserved = cel::internal::LexisIsReserved(id_text);
+  name += id_text;
+  if (Peek().kind != TokenKind::kLParen) {
+    if (reserved) {
+      return Term{factory_.ReportError(
+          SourceRange{begin, id.end},
+          absl::StrFormat("reserved identifier: %s", id_text))};
+    }
+    return Term{factory_.NewIdent(factory_.NextId(TokenRange(id)),
+                                  std::move(name))};
+  }
+  SourceRange open_range = TokenRange(Next());
+  if (reserved) {
+    // The visitor does not build the arguments, which need to be parsed
+    // regardless.
+    int depth = 0;
+    ParseArguments(depth);
+    if (halted_) {
+      return Term{};
+    }
+    return Term{factory_.ReportError(
+        SourceRange{begin, previous_end_},
+        absl::StrFormat("reserved identifier: %s", id_text))};
+  }
+  int64_t op_id = factory_.NextId(open_range);
+  int depth = 0;
+  std::vector<Expr> arguments = ParseArguments(depth);
+  if (halted_) {
+    return Term{};
+  }
+  return Term{GlobalCallOrMacro(op_id, name, std::move(arguments)),
+              depth + 1};
+}
+
+std::vector<Expr> Parser::ParseArguments(int& depth) {
+  std::vector<Expr> arguments;
+  if (Peek().kind == TokenKind::kRParen) {
+    Next();
+    return arguments;
+  }
+  while (true) {
+    Term argument = ParseExpr();
+    if (halted_) {
+      return arguments;
+    }
+    depth = std::max(depth, ElementDepth(argument));
+    arguments.push_back(std::move(argument.expr));
+    if (Peek().kind != TokenKind::kComma) {
+      break;
+    }
+    Next();
+  }
+  Expect(TokenKind::kRParen, "{')', ','}");
+  return arguments;
+}
+
+void Parser::ReportUnsupportedOptional(int count, SourceRange range) {
+  for (int i = 0; i < count; ++i) {
+    factory_.ReportError(range, "unsupported syntax '?'");
+  }
+}
+
+Parser::Term Parser::ParseMessage() {
+  std::string name;
+  if (Peek().kind == TokenKind::kDot) {
+    Next();
+    name = ".";
+  }
+  absl::StrAppend(&name, Text(Next()));
+  while (Peek().kind == TokenKind::kDot) {
+    Next();
+    absl::StrAppend(&name, ".", Text(Next()));
+  }
+  int64_t obj_id = factory_.NextId(TokenRange(Next()));
+  std::vector<StructExprField> fields;
+  int depth = 0;
+  if (Peek().kind == TokenKind::kQuestionMark ||
+      Peek().kind == TokenKind::kIdentifier) {
+    int32_t begin = Peek().begin;
+    int unsupported = 0;
+    while (true) {
+      bool optional = false;
+      if (Peek().kind == TokenKind::kQuestionMark) {
+        Next();
+        optional = true;
+      }
+      if (Peek().kind != TokenKind::kIdentifier) {
+        SyntaxError(Peek(), "IDENTIFIER");
+        return Term{};
+      }
+      std::string field = Text(Next());
+      if (Peek().kind != TokenKind::kColon) {
+        SyntaxError(Peek(), "':'");
+        return Term{};
+      }
+      int64_t init_id = factory_.NextId(TokenRange(Next()));
+      Term value = ParseExpr();
+      if (halted_) {
+        return Term{};
+      }
+      if (optional && !options_.enable_optional_syntax) {
+        // The visitor does not build the value of unsupported fields.
+        factory_.DiscardIdsFrom(init_id + 1);
+        ++unsupported;
+      } else {
+        depth = std::max(depth, value.depth);
+        fields.push_back(factory_.NewStructField(
+            init_id, std::move(field), std::move(value.expr), optional));
+      }
+      if (Peek().kind != TokenKind::kComma ||
+          (Peek(1).kind != TokenKind::kQuestionMark &&
+           Peek(1).kind != TokenKind::kIdentifier)) {
+        break;
+      }
+      Next();
+    }
+    ReportUnsupportedOptional(unsupported, SourceRange{begin, previous_end_});
+  }
+  if (Peek().kind == TokenKind::kComma) {
+    Next();
+  }
+  if (!Expect(TokenKind::kRBrace, "'}'")) {
+    return Term{};
+  }
+  return Term{factory_.NewStruct(obj_id, std::move(name), std::move(fields)),
+              depth + 1};
+}
+
+Parser::Term Parser::ParseList() {
+  int64_t list_id = factory_.NextId(TokenRange(Next()));
+  std::vector<ListExprElement> elements;
+  int depth = 0;
+  if (Peek().kind != TokenKind::kRBracket &&
+      Peek().kind != TokenKind::kComma) {
+    int32_t begin = Peek().begin;
+    int unsupported = 0;
+    while (true) {
+      bool optional = false;
+      if (Peek().kind == TokenKind::kQuestionMark) {
+        Next();
+        optional = true;
+      }
+      int64_t element_id = factory_.PeekNextId();
+      Term element = ParseExpr();
+      if (halted_) {
+        return Term{};
+      }
+      if (optional && !options_.enable_optional_syntax) {
+        // The visitor does not build unsupported elements.
+        factory_.DiscardIdsFrom(element_id);
+        ++unsupported;
+        elements.push_back(
+            factory_.NewListElement(factory_.NewUnspecified(0), false));
+      } else {
+        depth = std::max(depth, ElementDepth(element));
+        elements.push_back(
+            factory_.NewListElement(std::move(element.expr), optional));
+      }
+      if (Peek().kind != TokenKind::kComma ||
+          Peek(1).kind == TokenKind::kRBracket) {
+        break;
+      }
+      Next();
+    }
+    ReportUnsupportedOptional(unsupported, SourceRange{begin, previous_end_});
+  }
+  if (Peek().kind == TokenKind::kComma) {
+    Next();
+    if (!Expect(TokenKind::kRBracket, "']'")) {
+      return Term{};
+    }
+  } else if (!Expect(TokenKind::kRBracket, "{']', ','}")) {
+    return Term{};
+  }
+  return Term{factory_.NewList(list_id, std::move(elements)), depth + 1};
+}
+
+Parser::Term Parser::ParseMap() {
+  int64_t map_id = factory_.NextId(TokenRange(Next()));
+  std::vector<MapExprEntry> entries;
+  int depth = 0;
+  if (Peek().kind != TokenKind::kRBrace && Peek().kind != TokenKind::kComma) {
+    int32_t begin = Peek().begin;
+    int unsupported = 0;
+    while (true) {
+      // The visitor allocates the ID of the entry, whose source range is that
+      // of the colon, before building the key.
+      int64_t entry_id = factory_.NextId(SourceRange{});
+      bool optional = false;
+      if (Peek().kind == TokenKind::kQuestionMark) {
+        Next();
+        optional = true;
+      }
+      Term key = ParseExpr();
+      if (halted_) {
+        return Term{};
+      }
+      if (Peek().kind != TokenKind::kColon) {
+        SyntaxError(Peek(), "':'");
+        return Term{};
+      }
+      factory_.SetSourceRange(entry_id, TokenRange(Next()));
+      Term value = ParseExpr();
+      if (halted_) {
+        return Term{};
+      }
+      if (optional && !options_.enable_optional_syntax) {
+        // The visitor does not build the key and value of unsupported
+        // entries.
+        factory_.DiscardIdsFrom(entry_id + 1);
+        ++unsupported;
+        entries.push_back(factory_.NewMapEntry(0, factory_.NewUnspecified(0),
+                                               factory_.NewUnspecified(0),
+                                               false));
+      } else {
+        depth = std::max({depth, key.depth, value.depth});
+        entries.push_back(factory_.NewMapEntry(entry_id, std::move(key.expr),
+                                               std::move(value.expr),
+                                               optional));
+      }
+      if (Peek().kind != TokenKind::kComma ||
+          Peek(1).kind == TokenKind::kRBrace) {
+        break;
+      }
+      Next();
+    }
+    ReportUnsupportedOptional(unsupported, SourceRange{begin, previous_end_});
+  }
+  if (Peek().kind == TokenKind::kComma) {
+    Next();
+  }
+  if (!Expect(TokenKind::kRBrace, "'}'")) {
+    return Term{};
+  }
+  return Term{factory_.NewMap(map_id, std::move(entries)), depth + 1};
+}
+
+Parser::Term Parser::ParseLiteral() {
+  int32_t begin = Peek().begin;
+  std::string value;
+  if (Peek().kind == TokenKind::kMinus) {
+    Next();
+    value = "-";
+  }
+  const Token& token = Next();
+  SourceRange range{begin, token.end};
+  std::string text = Text(token);
+  switch (token.kind) {
+    case TokenKind::kNumInt: {
+      value += text;
+      int64_t int_value;
+      if (absl::StartsWith(text, "0x")) {
+        if (absl::SimpleHexAtoi(value, &int_value)) {
+          return Term{factory_.NewIntConst(factory_.NextId(range), int_value)};
+        }
+        return Term{factory_.ReportError(range, "invalid hex int literal")};
+      }
+      if (absl::SimpleAtoi(value, &int_value)) {
+        return Term{factory_.NewIntConst(factory_.NextId(range), int_value)};
+      }
+      return Term{factory_.ReportError(range, "invalid int literal")};
+    }
+    case TokenKind::kNumUint: {
+      // Trim the 'u' designator included in the uint literal.
+      value = text.substr(0, text.size() - 1);
+      uint64_t uint_value;
+      if (absl::StartsWith(text, "0x")) {
+        if (absl::SimpleHexAtoi(value, &uint_value)) {
+          return Term{
+              factory_.NewUintConst(factory_.NextId(range), uint_value)};
+        }
+        return Term{factory_.ReportError(range, "invalid hex uint literal")};
+      }
+      if (absl::SimpleAtoi(value, &uint_value)) {
+        return Term{factory_.NewUintConst(factory_.NextId(range), uint_value)};
+      }
+      return Term{factory_.ReportError(range, "invalid uint literal")};
+    }
+    case TokenKind::kNumFloat: {
+      value += text;
+      double double_value;
+      if (absl::SimpleAtod(value, &double_value)) {
+        return Term{
+            factory_.NewDoubleConst(factory_.NextId(range), double_value)};
+      }
+      return Term{factory_.ReportError(range, "invalid double literal")};
+    }
+    case TokenKind::kString: {
+      auto string_value = cel::internal::ParseStringLiteral(text);
+      if (!string_value.ok()) {
+        return Term{
+            factory_.ReportError(range, string_value.status().message())};
+      }
+      return Term{factory_.NewStringConst(factory_.NextId(range),
+                                          std::move(string_value).value())};
+    }
+    case TokenKind::kBytes: {
+      auto bytes_value = cel::internal::ParseBytesLiteral(text);
+      if (!bytes_value.ok()) {
+        return Term{
+            factory_.ReportError(range, bytes_value.status().message())};
+      }
+      return Term{factory_.NewBytesConst(factory_.NextId(range),
+                                         std::move(bytes_value).value())};
+    }
+    case TokenKind::kTrue:
+      return Term{factory_.NewBoolConst(factory_.NextId(range), true)};
+    case TokenKind::kFalse:
+      return Term{factory_.NewBoolConst(factory_.NextId(range), false)};
+    default:
+      return Term{factory_.NewNullConst(factory_.NextId(range))};
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<Expr> ParseWithRecursiveDescent(
+    const cel::MacroRegistry& macro_registry, const cel::ParserOptions& options,
+    cel::ParserMacroExprFactory& factory) {
+  std::vector<Token> tokens = Lexer(factory.source().content()).Tokenize();
+  return Parser(macro_registry, options, factory, std::move(tokens)).Parse();
+}
+
+}  // namespace cel_parser_internal
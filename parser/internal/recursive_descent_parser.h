@@ -0,0 +1,40 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_PARSER_INTERNAL_RECURSIVE_DESCENT_PARSER_H_
+#define THIRD_PARTY_CEL_CPP_PARSER_INTERNAL_RECURSIVE_DESCENT_PARSER_H_
+
+#include "absl/status/statusor.h"
+#include "common/expr.h"
+#include "parser/internal/parser_macro_expr_factory.h"
+#include "parser/macro_registry.h"
+#include "parser/options.h"
+
+namespace cel_parser_internal {
+
+// Parses the expression of `factory.source()` with a hand-written recursive
+// descent parser implementing the grammar of Cel.g4, building it with
+// `factory`.
+//
+// The expression, its IDs and their source ranges are the same as built by
+// the ANTLR generated parser, and so are the limits imposed by `options`.
+// Parsing stops at the first syntax error, so the error message may differ
+// when the expression is invalid.
+absl::StatusOr<cel::Expr> ParseWithRecursiveDescent(
+    const cel::MacroRegistry& macro_registry, const cel::ParserOptions& options,
+    cel::ParserMacroExprFactory& factory);
+
+}  // namespace cel_parser_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_PARSER_INTERNAL_RECURSIVE_DESCENT_PARSER_H_
@@ -18,7 +18,6 @@
 #include <utility>
 
 #include "absl/status/status.h"
-#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
@@ -40,7 +39,7 @@ absl::Status MacroRegistry::RegisterMacros(absl::Span<const Macro> macros) {
     const auto& macro = macros[i];
     if (!RegisterMacroImpl(macro)) {
       for (size_t j = 0; j < i; ++j) {
-        macros_.erase(macros[j].key());
+        macros_.erase(SignatureOf(macros[j]));
       }
       return absl::AlreadyExistsError(
           absl::StrCat("macro already exists: ", macro.key()));
@@ -52,26 +51,29 @@ absl::Status MacroRegistry::RegisterMacros(absl::Span<const Macro> macros) {
 absl::optional<Macro> MacroRegistry::FindMacro(absl::string_view name,
                                                size_t arg_count,
                                                bool receiver_style) const {
-  // <function>:<argument_count>:<receiver_style>
-  if (name.empty() || absl::StrContains(name, ':')) {
-    return absl::nullopt;
-  }
-  // Try argument count specific key first.
-  auto key = absl::StrCat(name, ":", arg_count, ":",
-                          receiver_style ? "true" : "false");
-  if (auto it = macros_.find(key); it != macros_.end()) {
+  // Try argument count specific signature first.
+  if (auto it = macros_.find(Signature{name, arg_count, receiver_style,
+                                       /*variadic=*/false});
+      it != macros_.end()) {
     return it->second;
   }
   // Next try variadic.
-  key = absl::StrCat(name, ":*:", receiver_style ? "true" : "false");
-  if (auto it = macros_.find(key); it != macros_.end()) {
+  if (auto it = macros_.find(
+          Signature{name, 0, receiver_style, /*variadic=*/true});
+      it != macros_.end()) {
     return it->second;
   }
   return absl::nullopt;
 }
 
+MacroRegistry::Signature MacroRegistry::SignatureOf(const Macro& macro) {
+  return Signature{macro.function(),
+                   macro.is_variadic() ? 0 : macro.argument_count(),
+                   macro.is_receiver_style(), macro.is_variadic()};
+}
+
 bool MacroRegistry::RegisterMacroImpl(const Macro& macro) {
-  return macros_.insert(std::pair{macro.key(), macro}).second;
+  return macros_.insert(std::pair{SignatureOf(macro), macro}).second;
 }
 
 }  // namespace cel
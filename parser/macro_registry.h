@@ -16,6 +16,7 @@
 #define THIRD_PARTY_CEL_CPP_PARSER_MACRO_REGISTRY_H_
 
 #include <cstddef>
+#include <utility>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
@@ -45,9 +46,35 @@ class MacroRegistry final {
                                   bool receiver_style) const;
 
  private:
+  // The call signature a macro matches, i.e. the fields of Macro::key(). These
+  // are hashed directly, so that lookups don't format a key for every call.
+  struct Signature final {
+    absl::string_view function;
+    // Zero for variadic macros.
+    size_t arg_count;
+    bool receiver_style;
+    bool variadic;
+
+    friend bool operator==(const Signature& lhs, const Signature& rhs) {
+      return lhs.function == rhs.function && lhs.arg_count == rhs.arg_count &&
+             lhs.receiver_style == rhs.receiver_style &&
+             lhs.variadic == rhs.variadic;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H state, const Signature& signature) {
+      return H::combine(std::move(state), signature.function,
+                        signature.arg_count, signature.receiver_style,
+                        signature.variadic);
+    }
+  };
+
+  // The signature of `macro`, which refers to the storage of `macro`.
+  static Signature SignatureOf(const Macro& macro);
+
   bool RegisterMacroImpl(const Macro& macro);
 
-  absl::flat_hash_map<absl::string_view, Macro> macros_;
+  absl::flat_hash_map<Signature, Macro> macros_;
 };
 
 }  // namespace cel
@@ -16,8 +16,11 @@
 
 #include "absl/status/status.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "common/expr.h"
 #include "internal/testing.h"
 #include "parser/macro.h"
+#include "parser/macro_expr_factory.h"
 
 namespace cel {
 namespace {
@@ -40,5 +43,31 @@ TEST(MacroRegistry, RegisterRollsback) {
   EXPECT_THAT(macros.FindMacro("has", 1, false), Eq(absl::nullopt));
 }
 
+TEST(MacroRegistry, FindMatchesSignature) {
+  MacroRegistry macros;
+  ASSERT_OK_AND_ASSIGN(
+      auto variadic,
+      Macro::ReceiverVarArg("pick", [](MacroExprFactory& factory, Expr&,
+                                       absl::Span<Expr>) {
+        return absl::optional<Expr>(factory.NewNullConst());
+      }));
+  ASSERT_THAT(macros.RegisterMacros({AllMacro(), variadic}), IsOk());
+
+  auto all = macros.FindMacro("all", 2, true);
+  ASSERT_NE(all, absl::nullopt);
+  EXPECT_EQ(all->key(), "all:2:true");
+  EXPECT_THAT(macros.FindMacro("all", 3, true), Eq(absl::nullopt));
+  EXPECT_THAT(macros.FindMacro("all", 2, false), Eq(absl::nullopt));
+
+  // Variadic macros match any argument count, but only their call style.
+  auto pick = macros.FindMacro("pick", 5, true);
+  ASSERT_NE(pick, absl::nullopt);
+  EXPECT_EQ(pick->key(), "pick:*:true");
+  EXPECT_THAT(macros.FindMacro("pick", 0, false), Eq(absl::nullopt));
+
+  EXPECT_THAT(macros.FindMacro("", 2, true), Eq(absl::nullopt));
+  EXPECT_THAT(macros.FindMacro("all:2", 2, true), Eq(absl::nullopt));
+}
+
 }  // namespace
 }  // namespace cel
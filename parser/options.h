@@ -47,6 +47,26 @@ struct ParserOptions final {
 
   // Enable support for optional syntax.
   bool enable_optional_syntax = false;
+
+  // Parse with the hand-written recursive descent parser instead of the ANTLR
+  // generated one. The resulting expression and source information are the
+  // same, but parsing stops at the first syntax error, so
+  // `error_recovery_limit` and `error_recovery_token_lookahead_limit` do not
+  // apply.
+  bool enable_recursive_descent_parser = false;
+
+  // Merge parenthesized `&&` and `||` operands into the enclosing chain of the
+  // same operator before balancing it, so that `(a || (b || (c || d)))` is as
+  // shallow as `a || b || c || d`. The operators are commutative, so this does
+  // not change the result, only the shape of the tree and the order of the
+  // operands of each call.
+  bool enable_nested_logical_balancing = false;
+
+  // Store the source positions of an AST returned by `ParseAst` in
+  // `SourceInfo::compact_positions()` instead of `SourceInfo::positions()`,
+  // using a few bytes per node instead of a hash map entry. Worth it when
+  // many ASTs are kept around and positions are only read to report errors.
+  bool compact_source_positions = false;
 };
 
 }  // namespace cel
@@ -22,20 +22,17 @@
 #include <exception>
 #include <functional>
 #include <iterator>
-#include <limits>
 #include <map>
 #include <memory>
 #include <string>
-#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "absl/base/macros.h"
+#include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
-#include "absl/container/btree_map.h"
-#include "absl/container/flat_hash_map.h"
-#include "absl/functional/overload.h"
+#include "absl/functional/function_ref.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -46,10 +43,10 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
-#include "absl/types/optional.h"
-#include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "antlr4-runtime.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
 #include "common/ast.h"
 #include "common/constant.h"
 #include "common/expr_factory.h"
@@ -59,15 +56,17 @@
 #include "internal/lexis.h"
 #include "internal/status_macros.h"
 #include "internal/strings.h"
-#include "internal/utf8.h"
 #include "parser/internal/CelBaseVisitor.h"
 #include "parser/internal/CelLexer.h"
 #include "parser/internal/CelParser.h"
+#include "parser/internal/parser_macro_expr_factory.h"
+#include "parser/internal/recursive_descent_parser.h"
 #include "parser/macro.h"
 #include "parser/macro_expr_factory.h"
 #include "parser/macro_registry.h"
 #include "parser/options.h"
 #include "parser/source_factory.h"
+#include "google/protobuf/arena.h"
 
 namespace google::api::expr::parser {
 namespace {
@@ -96,62 +95,6 @@ Expr ExprFromAny(std::any&& any) {
   return std::move(*expr);
 }
 
-struct ParserError {
-  std::string message;
-  SourceRange range;
-};
-
-inline constexpr char32_t kDot = '.';
-inline constexpr char32_t kHat = '^';
-
-inline constexpr char32_t kWideDot = 0xff0e;
-inline constexpr char32_t kWideHat = 0xff3e;
-
-std::string DisplayParserError(const cel::Source& source,
-                               const ParserError& error) {
-  auto location =
-      source.GetLocation(error.range.begin).value_or(SourceLocation{});
-  std::string s = absl::StrFormat("ERROR: %s:%zu:%zu: %s", source.description(),
-                                  location.line,
-                                  // add one to the 0-based column
-                                  location.column + 1, error.message);
-  if (auto snippet = source.Snippet(location.line); snippet) {
-    *snippet = absl::StrReplaceAll(*snippet, {{"\t", " "}});
-    absl::string_view snippet_view(*snippet);
-    std::string src_line;
-    src_line.append("\n | ");
-    src_line.append(*snippet);
-    std::string ind_line;
-    ind_line.append("\n | ");
-    for (int32_t i = 0; i < location.column && !snippet_view.empty(); ++i) {
-      size_t count;
-      std::tie(std::ignore, count) = internal::Utf8Decode(snippet_view);
-      snippet_view.remove_prefix(count);
-      if (count > 1) {
-        internal::Utf8Encode(ind_line, kWideDot);
-      } else {
-        internal::Utf8Encode(ind_line, kDot);
-      }
-    }
-    size_t count = 0;
-    if (!snippet_view.empty()) {
-      std::tie(std::ignore, count) = internal::Utf8Decode(snippet_view);
-    }
-    if (count > 1) {
-      internal::Utf8Encode(ind_line, kWideHat);
-    } else {
-      internal::Utf8Encode(ind_line, kHat);
-    }
-    s.append(src_line);
-    s.append(ind_line);
-  }
-  return s;
-}
-
-int32_t PositiveOrMax(int32_t value) {
-  return value >= 0 ? value : std::numeric_limits<int32_t>::max();
-}
-
 SourceRange SourceRangeFromToken(const antlr4::Token* token) {
   SourceRange range;
   if (token != nullptr) {
@@ -187,245 +130,6 @@ SourceRange SourceRangeFromParserRuleContext(
 
 }  // namespace
 
-class ParserMacroExprFactory final : public MacroExprFactory {
- public:
-  explicit ParserMacroExprFactory(const cel::Source& source)
-      : MacroExprFactory(), source_(source) {}
-
-  void BeginMacro(SourceRange macro_position) {
-    macro_position_ = macro_position;
-  }
-
-  void EndMacro() { macro_position_ = SourceRange{}; }
-
-  Expr ReportError(absl::string_view message) override {
-    return ReportError(macro_position_, message);
-  }
-
-  Expr ReportError(int64_t expr_id, absl::string_view message) {
-    return ReportError(GetSourceRange(expr_id), message);
-  }
-
-  Expr ReportError(SourceRange range, absl::string_view message) {
-    ++error_count_;
-    if (errors_.size() <= 100) {
-      errors_.push_back(ParserError{std::string(message), range});
-    }
-    return NewUnspecified(NextId(range));
-  }
-
-  Expr ReportErrorAt(const Expr& expr, absl::string_view message) override {
-    return ReportError(GetSourceRange(expr.id()), message);
-  }
-
-  SourceRange GetSourceRange(int64_t id) const {
-    if (auto it = positions_.find(id); it != positions_.end()) {
-      return it->second;
-    }
-    return SourceRange{};
-  }
-
-  int64_t NextId(const SourceRange& range) {
-    auto id = expr_id_++;
-    if (range.begin != -1 || range.end != -1) {
-      positions_.insert(std::pair{id, range});
-    }
-    return id;
-  }
-
-  bool HasErrors() const { return error_count_ != 0; }
-
-  std::string ErrorMessage() {
-    // Errors are collected as they are encountered, not by their location
-    // within the source. To have a more stable error message as implementation
-    // details change, we sort the collected errors by their source location
-    // first.
-    std::stable_sort(
-        errors_.begin(), errors_.end(),
-        [](const ParserError& lhs, const ParserError& rhs) -> bool {
-          auto lhs_begin = PositiveOrMax(lhs.range.begin);
-          auto lhs_end = PositiveOrMax(lhs.range.end);
-          auto rhs_begin = PositiveOrMax(rhs.range.begin);
-          auto rhs_end = PositiveOrMax(rhs.range.end);
-          return lhs_begin < rhs_begin ||
-                 (lhs_begin == rhs_begin && lhs_end < rhs_end);
-        });
-    // Build the summary error message using the sorted errors.
-    bool errors_truncated = error_count_ > 100;
-    std::vector<std::string> messages;
-    messages.reserve(
-        errors_.size() +
-        errors_truncated);  // Reserve space for the transform and an
-                            // additional element when truncation occurs.
-    std::transform(errors_.begin(), errors_.end(), std::back_inserter(messages),
-                   [this](const ParserError& error) {
-                     return cel::DisplayParserError(source_, error);
-                   });
-    if (errors_truncated) {
-      messages.emplace_back(
-          absl::StrCat(error_count_ - 100, " more errors were truncated."));
-    }
-    return absl::StrJoin(messages, "\n");
-  }
-
-  void AddMacroCall(int64_t macro_id, absl::string_view function,
-                    absl::optional<Expr> target, std::vector<Expr> arguments) {
-    macro_calls_.insert(
-        {macro_id, target.has_value()
-                       ? NewMemberCall(0, function, std::move(*target),
-                                       std::move(arguments))
-                       : NewCall(0, function, std::move(arguments))});
-  }
-
-  Expr BuildMacroCallArg(const Expr& expr) {
-    if (auto it = macro_calls_.find(expr.id()); it != macro_calls_.end()) {
-      return NewUnspecified(expr.id());
-    }
-    return absl::visit(
-        absl::Overload(
-            [this, &expr](const UnspecifiedExpr&) -> Expr {
-              return NewUnspecified(expr.id());
-            },
-            [this, &expr](const Constant& const_expr) -> Expr {
-              return NewConst(expr.id(), const_expr);
-            },
-            [this, &expr](const IdentExpr& ident_expr) -> Expr {
-              return NewIdent(expr.id(), ident_expr.name());
-            },
-            [this, &expr](const SelectExpr& select_expr) -> Expr {
-              return select_expr.test_only()
-                         ? NewPresenceTest(
-                               expr.id(),
-                               BuildMacroCallArg(select_expr.operand()),
-                               select_expr.field())
-                         : NewSelect(expr.id(),
-                                     BuildMacroCallArg(select_expr.operand()),
-                                     select_expr.field());
-            },
-            [this, &expr](const CallExpr& call_expr) -> Expr {
-              std::vector<Expr> macro_arguments;
-              macro_arguments.reserve(call_expr.args().size());
-              for (const auto& argument : call_expr.args()) {
-                macro_arguments.push_back(BuildMacroCallArg(argument));
-              }
-              absl::optional<Expr> macro_target;
-              if (call_expr.has_target()) {
-                macro_target = BuildMacroCallArg(call_expr.target());
-              }
-              return macro_target.has_value()
-                         ? NewMemberCall(expr.id(), call_expr.function(),
-                                         std::move(*macro_target),
-                                         std::move(macro_arguments))
-                         : NewCall(expr.id(), call_expr.function(),
-                                   std::move(macro_arguments));
-            },
-            [this, &expr](const ListExpr& list_expr) -> Expr {
-              std::vector<ListExprElement> macro_elements;
-              macro_elements.reserve(list_expr.elements().size());
-              for (const auto& element : list_expr.elements()) {
-                auto& cloned_element = macro_elements.emplace_back();
-                if (element.has_expr()) {
-                  cloned_element.set_expr(BuildMacroCallArg(element.expr()));
-                }
-                cloned_element.set_optional(element.optional());
-              }
-              return NewList(expr.id(), std::move(macro_elements));
-            },
-            [this, &expr](const StructExpr& struct_expr) -> Expr {
-              std::vector<StructExprField> macro_fields;
-              macro_fields.reserve(struct_expr.fields().size());
-              for (const auto& field : struct_expr.fields()) {
-                auto& macro_field = macro_fields.emplace_back();
-                macro_field.set_id(field.id());
-                macro_field.set_name(field.name());
-                macro_field.set_value(BuildMacroCallArg(field.value()));
-                macro_field.set_optional(field.optional());
-              }
-              return NewStruct(expr.id(), struct_expr.name(),
-                               std::move(macro_fields));
-            },
-            [this, &expr](const MapExpr& map_expr) -> Expr {
-              std::vector<MapExprEntry> macro_entries;
-              macro_entries.reserve(map_expr.entries().size());
-              for (const auto& entry : map_expr.entries()) {
-                auto& macro_entry = macro_entries.emplace_back();
-                macro_entry.set_id(entry.id());
-                macro_entry.set_key(BuildMacroCallArg(entry.key()));
-                macro_entry.set_value(BuildMacroCallArg(entry.value()));
-                macro_entry.set_optional(entry.optional());
-              }
-              return NewMap(expr.id(), std::move(macro_entries));
-            },
-            [this, &expr](const ComprehensionExpr& comprehension_expr) -> Expr {
-              return NewComprehension(
-                  expr.id(), comprehension_expr.iter_var(),
-                  BuildMacroCallArg(comprehension_expr.iter_range()),
-                  comprehension_expr.accu_var(),
-                  BuildMacroCallArg(comprehension_expr.accu_init()),
-                  BuildMacroCallArg(comprehension_expr.loop_condition()),
-                  BuildMacroCallArg(comprehension_expr.loop_step()),
-                  BuildMacroCallArg(comprehension_expr.result()));
-            }),
-        expr.kind());
-  }
-
-  using ExprFactory::NewBoolConst;
-  using ExprFactory::NewBytesConst;
-  using ExprFactory::NewCall;
-  using ExprFactory::NewComprehension;
-  using ExprFactory::NewConst;
-  using ExprFactory::NewDoubleConst;
-  using ExprFactory::NewIdent;
-  using ExprFactory::NewIntConst;
-  using ExprFactory::NewList;
-  using ExprFactory::NewListElement;
-  using ExprFactory::NewMap;
-  using ExprFactory::NewMapEntry;
-  using ExprFactory::NewMemberCall;
-  using ExprFactory::NewNullConst;
-  using ExprFactory::NewPresenceTest;
-  using ExprFactory::NewSelect;
-  using ExprFactory::NewStringConst;
-  using ExprFactory::NewStruct;
-  using ExprFactory::NewStructField;
-  using ExprFactory::NewUintConst;
-  using ExprFactory::NewUnspecified;
-
-  const absl::btree_map<int64_t, SourceRange>& positions() const {
-    return positions_;
-  }
-
-  const absl::flat_hash_map<int64_t, Expr>& macro_calls() const {
-    return macro_calls_;
-  }
-
-  void EraseId(ExprId id) {
-    positions_.erase(id);
-    if (expr_id_ == id + 1) {
-      --expr_id_;
-    }
-  }
-
- protected:
-  int64_t NextId() override { return NextId(macro_position_); }
-
-  int64_t CopyId(int64_t id) override {
-    if (id == 0) {
-      return 0;
-    }
-    return NextId(GetSourceRange(id));
-  }
-
- private:
-  int64_t expr_id_ = 1;
-  absl::btree_map<int64_t, SourceRange> positions_;
-  absl::flat_hash_map<int64_t, Expr> macro_calls_;
-  std::vector<ParserError> errors_;
-  size_t error_count_ = 0;
-  const Source& source_;
-  SourceRange macro_position_;
-};
-
 }  // namespace cel
 
 namespace google::api::expr::parser {
@@ -457,6 +161,7 @@ using ::cel::StructExprField;
 using ::cel_parser_internal::CelBaseVisitor;
 using ::cel_parser_internal::CelLexer;
 using ::cel_parser_internal::CelParser;
+using ::cel_parser_internal::ExpressionBalancer;
 using common::CelOperator;
 using common::ReverseLookupOperator;
 using ::google::api::expr::v1alpha1::ParsedExpr;
@@ -549,85 +254,14 @@ class ScopedIncrement final {
   int& recursion_depth_;
 };
 
-// balancer performs tree balancing on operators whose arguments are of equal
-// precedence.
-//
-// The purpose of the balancer is to ensure a compact serialization format for
-// the logical &&, || operators which have a tendency to create long DAGs which
-// are skewed in one direction. Since the operators are commutative re-ordering
-// the terms *must not* affect the evaluation result.
-//
-// Based on code from //third_party/cel/go/parser/helper.go
-class ExpressionBalancer final {
- public:
-  ExpressionBalancer(cel::ParserMacroExprFactory& factory, std::string function,
-                     Expr expr);
-
-  // addTerm adds an operation identifier and term to the set of terms to be
-  // balanced.
-  void AddTerm(int64_t op, Expr term);
-
-  // balance creates a balanced tree from the sub-terms and returns the final
-  // Expr value.
-  Expr Balance();
-
- private:
-  // balancedTree recursively balances the terms provided to a commutative
-  // operator.
-  Expr BalancedTree(int lo, int hi);
-
- private:
-  cel::ParserMacroExprFactory& factory_;
-  std::string function_;
-  std::vector<Expr> terms_;
-  std::vector<int64_t> ops_;
-};
-
-ExpressionBalancer::ExpressionBalancer(cel::ParserMacroExprFactory& factory,
-                                       std::string function, Expr expr)
-    : factory_(factory), function_(std::move(function)) {
-  terms_.push_back(std::move(expr));
-}
-
-void ExpressionBalancer::AddTerm(int64_t op, Expr term) {
-  terms_.push_back(std::move(term));
-  ops_.push_back(op);
-}
-
-Expr ExpressionBalancer::Balance() {
-  if (terms_.size() == 1) {
-    return std::move(terms_[0]);
-  }
-  return BalancedTree(0, ops_.size() - 1);
-}
-
-Expr ExpressionBalancer::BalancedTree(int lo, int hi) {
-  int mid = (lo + hi + 1) / 2;
-
-  std::vector<Expr> arguments;
-  arguments.reserve(2);
-
-  if (mid == lo) {
-    arguments.push_back(std::move(terms_[mid]));
-  } else {
-    arguments.push_back(BalancedTree(lo, mid - 1));
-  }
-
-  if (mid == hi) {
-    arguments.push_back(std::move(terms_[mid + 1]));
-  } else {
-    arguments.push_back(BalancedTree(mid + 1, hi));
-  }
-  return factory_.NewCall(ops_[mid], function_, std::move(arguments));
-}
-
 class ParserVisitor final : public CelBaseVisitor,
                             public antlr4::BaseErrorListener {
  public:
   ParserVisitor(const cel::Source& source, int max_recursion_depth,
                 const cel::MacroRegistry& macro_registry,
                 bool add_macro_calls = false,
-                bool enable_optional_syntax = false);
+                bool enable_optional_syntax = false,
+                bool enable_nested_logical_balancing = false);
   ~ParserVisitor() override;
 
   std::any visit(antlr4::tree::ParseTree* tree) override;
@@ -673,8 +307,7 @@ class ParserVisitor final : public CelBaseVisitor,
   std::any visitBoolTrue(CelParser::BoolTrueContext* ctx) override;
   std::any visitBoolFalse(CelParser::BoolFalseContext* ctx) override;
   std::any visitNull(CelParser::NullContext* ctx) override;
-  absl::Status GetSourceInfo(google::api::expr::v1alpha1::SourceInfo* source_info) const;
-  EnrichedSourceInfo enriched_source_info() const;
+  cel::ParserMacroExprFactory& factory() { return factory_; }
   void syntaxError(antlr4::Recognizer* recognizer,
                    antlr4::Token* offending_symbol, size_t line, size_t col,
                    const std::string& msg, std::exception_ptr e) override;
@@ -703,9 +336,17 @@ class ParserVisitor final : public CelBaseVisitor,
   }
 
   Expr GlobalCallOrMacroImpl(int64_t expr_id, absl::string_view function,
-                             std::vector<Expr> args);
+                             std::vector<Expr> args) {
+    return cel_parser_internal::GlobalCallOrMacro(
+        factory_, macro_registry_, add_macro_calls_, expr_id, function,
+        std::move(args));
+  }
   Expr ReceiverCallOrMacroImpl(int64_t expr_id, absl::string_view function,
-                               Expr target, std::vector<Expr> args);
+                               Expr target, std::vector<Expr> args) {
+    return cel_parser_internal::ReceiverCallOrMacro(
+        factory_, macro_registry_, add_macro_calls_, expr_id, function,
+        std::move(target), std::move(args));
+  }
   std::string ExtractQualifiedName(antlr4::ParserRuleContext* ctx,
                                    const Expr& e);
   // Attempt to unnest parse context.
@@ -722,20 +363,23 @@ class ParserVisitor final : public CelBaseVisitor,
   const int max_recursion_depth_;
   const bool add_macro_calls_;
   const bool enable_optional_syntax_;
+  const bool enable_nested_logical_balancing_;
 };
 
 ParserVisitor::ParserVisitor(const cel::Source& source,
                              const int max_recursion_depth,
                              const cel::MacroRegistry& macro_registry,
                              const bool add_macro_calls,
-                             bool enable_optional_syntax)
+                             bool enable_optional_syntax,
+                             bool enable_nested_logical_balancing)
     : source_(source),
       factory_(source_),
       macro_registry_(macro_registry),
       recursion_depth_(0),
       max_recursion_depth_(max_recursion_depth),
       add_macro_calls_(add_macro_calls),
-      enable_optional_syntax_(enable_optional_syntax) {}
+      enable_optional_syntax_(enable_optional_syntax),
+      enable_nested_logical_balancing_(enable_nested_logical_balancing) {}
 
 ParserVisitor::~ParserVisitor() {}
 
@@ -928,7 +572,8 @@ std::any ParserVisitor::visitConditionalOr(
   if (ctx->ops.empty()) {
     return ExprToAny(std::move(result));
   }
-  ExpressionBalancer b(factory_, CelOperator::LOGICAL_OR, std::move(result));
+  ExpressionBalancer b(factory_, CelOperator::LOGICAL_OR, std::move(result),
+                       enable_nested_logical_balancing_);
   for (size_t i = 0; i < ctx->ops.size(); ++i) {
     auto op = ctx->ops[i];
     if (i >= ctx->e1.size()) {
@@ -949,7 +594,8 @@ std::any ParserVisitor::visitConditionalAnd(
   if (ctx->ops.empty()) {
     return ExprToAny(std::move(result));
   }
-  ExpressionBalancer b(factory_, CelOperator::LOGICAL_AND, std::move(result));
+  ExpressionBalancer b(factory_, CelOperator::LOGICAL_AND, std::move(result),
+                       enable_nested_logical_balancing_);
   for (size_t i = 0; i < ctx->ops.size(); ++i) {
     auto op = ctx->ops[i];
     if (i >= ctx->e1.size()) {
@@ -1380,37 +1026,6 @@ std::any ParserVisitor::visitNull(CelParser::NullContext* ctx) {
       factory_.NextId(SourceRangeFromParserRuleContext(ctx))));
 }
 
-absl::Status ParserVisitor::GetSourceInfo(
-    google::api::expr::v1alpha1::SourceInfo* source_info) const {
-  source_info->set_location(source_.description());
-  for (const auto& positions : factory_.positions()) {
-    source_info->mutable_positions()->insert(
-        std::pair{positions.first, positions.second.begin});
-  }
-  source_info->mutable_line_offsets()->Reserve(source_.line_offsets().size());
-  for (const auto& line_offset : source_.line_offsets()) {
-    source_info->mutable_line_offsets()->Add(line_offset);
-  }
-  for (const auto& macro_call : factory_.macro_calls()) {
-    google::api::expr::v1alpha1::Expr macro_call_proto;
-    CEL_RETURN_IF_ERROR(cel::extensions::protobuf_internal::ExprToProto(
-        macro_call.second, &macro_call_proto));
-    source_info->mutable_macro_calls()->insert(
-        std::pair{macro_call.first, std::move(macro_call_proto)});
-  }
-  return absl::OkStatus();
-}
-
-EnrichedSourceInfo ParserVisitor::enriched_source_info() const {
-  std::map<int64_t, std::pair<int32_t, int32_t>> offsets;
-  for (const auto& positions : factory_.positions()) {
-    offsets.insert(
-        std::pair{positions.first,
-                  std::pair{positions.second.begin, positions.second.end - 1}});
-  }
-  return EnrichedSourceInfo(std::move(offsets));
-}
-
 void ParserVisitor::syntaxError(antlr4::Recognizer* recognizer,
                                 antlr4::Token* offending_symbol, size_t line,
                                 size_t col, const std::string& msg,
@@ -1428,67 +1043,6 @@ bool ParserVisitor::HasErrored() const { return factory_.HasErrors(); }
 
 std::string ParserVisitor::ErrorMessage() { return factory_.ErrorMessage(); }
 
-Expr ParserVisitor::GlobalCallOrMacroImpl(int64_t expr_id,
-                                          absl::string_view function,
-                                          std::vector<Expr> args) {
-  if (auto macro = macro_registry_.FindMacro(function, args.size(), false);
-      macro) {
-    std::vector<Expr> macro_args;
-    if (add_macro_calls_) {
-      macro_args.reserve(args.size());
-      for (const auto& arg : args) {
-        macro_args.push_back(factory_.BuildMacroCallArg(arg));
-      }
-    }
-    factory_.BeginMacro(factory_.GetSourceRange(expr_id));
-    auto expr = macro->Expand(factory_, absl::nullopt, absl::MakeSpan(args));
-    factory_.EndMacro();
-    if (expr) {
-      if (add_macro_calls_) {
-        factory_.AddMacroCall(expr->id(), function, absl::nullopt,
-                              std::move(macro_args));
-      }
-      // We did not end up using `expr_id`. Delete metadata.
-      factory_.EraseId(expr_id);
-      return std::move(*expr);
-    }
-  }
-
-  return factory_.NewCall(expr_id, function, std::move(args));
-}
-
-Expr ParserVisitor::ReceiverCallOrMacroImpl(int64_t expr_id,
-                                            absl::string_view function,
-                                            Expr target,
-                                            std::vector<Expr> args) {
-  if (auto macro = macro_registry_.FindMacro(function, args.size(), true);
-      macro) {
-    Expr macro_target;
-    std::vector<Expr> macro_args;
-    if (add_macro_calls_) {
-      macro_args.reserve(args.size());
-      macro_target = factory_.BuildMacroCallArg(target);
-      for (const auto& arg : args) {
-        macro_args.push_back(factory_.BuildMacroCallArg(arg));
-      }
-    }
-    factory_.BeginMacro(factory_.GetSourceRange(expr_id));
-    auto expr = macro->Expand(factory_, std::ref(target), absl::MakeSpan(args));
-    factory_.EndMacro();
-    if (expr) {
-      if (add_macro_calls_) {
-        factory_.AddMacroCall(expr->id(), function, std::move(macro_target),
-                              std::move(macro_args));
-      }
-      // We did not end up using `expr_id`. Delete metadata.
-      factory_.EraseId(expr_id);
-      return std::move(*expr);
-    }
-  }
-  return factory_.NewMemberCall(expr_id, function, std::move(target),
-                                std::move(args));
-}
-
 std::string ParserVisitor::ExtractQualifiedName(antlr4::ParserRuleContext* ctx,
                                                 const Expr& e) {
   if (e == Expr{}) {
@@ -1624,55 +1178,108 @@ class RecoveryLimitErrorStrategy final : public DefaultErrorStrategy {
   int recovery_token_lookahead_limit_;
 };
 
-}  // namespace
-
-absl::StatusOr<ParsedExpr> Parse(absl::string_view expression,
-                                 absl::string_view description,
-                                 const ParserOptions& options) {
-  std::vector<Macro> macros = Macro::AllMacros();
-  if (options.enable_optional_syntax) {
-    macros.push_back(cel::OptMapMacro());
-    macros.push_back(cel::OptFlatMapMacro());
+absl::Status GetSourceInfo(
+    const cel::ParserMacroExprFactory& factory,
+    google::api::expr::v1alpha1::SourceInfo* source_info) {
+  const cel::Source& source = factory.source();
+  source_info->set_location(source.description());
+  for (const auto& positions : factory.positions()) {
+    source_info->mutable_positions()->insert(
+        std::pair{positions.first, positions.second.begin});
   }
-  return ParseWithMacros(expression, macros, description, options);
+  source_info->mutable_line_offsets()->Reserve(source.line_offsets().size());
+  for (const auto& line_offset : source.line_offsets()) {
+    source_info->mutable_line_offsets()->Add(line_offset);
+  }
+  for (const auto& macro_call : factory.macro_calls()) {
+    // Converted in place, so that the call is allocated on the arena of
+    // `source_info` if it has one.
+    CEL_RETURN_IF_ERROR(cel::extensions::protobuf_internal::ExprToProto(
+        macro_call.second,
+        &(*source_info->mutable_macro_calls())[macro_call.first]));
+  }
+  return absl::OkStatus();
 }
 
-absl::StatusOr<ParsedExpr> ParseWithMacros(absl::string_view expression,
-                                           const std::vector<Macro>& macros,
-                                           absl::string_view description,
-                                           const ParserOptions& options) {
-  CEL_ASSIGN_OR_RETURN(auto verbose_parsed_expr,
-                       EnrichedParse(expression, macros, description, options));
-  return verbose_parsed_expr.parsed_expr();
+absl::Status GetParsedExpr(const Expr& expr,
+                           const cel::ParserMacroExprFactory& factory,
+                           ParsedExpr& parsed_expr) {
+  CEL_RETURN_IF_ERROR(cel::extensions::protobuf_internal::ExprToProto(
+      expr, parsed_expr.mutable_expr()));
+  return GetSourceInfo(factory, parsed_expr.mutable_source_info());
 }
 
-absl::StatusOr<VerboseParsedExpr> EnrichedParse(
-    absl::string_view expression, const std::vector<Macro>& macros,
-    absl::string_view description, const ParserOptions& options) {
-  CEL_ASSIGN_OR_RETURN(auto source,
-                       cel::NewSource(expression, std::string(description)));
-  cel::MacroRegistry macro_registry;
-  CEL_RETURN_IF_ERROR(macro_registry.RegisterMacros(macros));
-  return EnrichedParse(*source, macro_registry, options);
+// Moves the macro calls out of `factory`, which must not be used after.
+cel::ast_internal::SourceInfo ReleaseSourceInfo(
+    cel::ParserMacroExprFactory& factory, bool compact_positions) {
+  const cel::Source& source = factory.source();
+  cel::ast_internal::SourceInfo source_info;
+  source_info.set_location(std::string(source.description()));
+  if (compact_positions) {
+    // The positions are already sorted by id, so there is no need to go
+    // through the map.
+    cel::ast_internal::SourcePositionTable table;
+    for (const auto& positions : factory.positions()) {
+      table.Append(positions.first, positions.second.begin);
+    }
+    table.ShrinkToFit();
+    source_info.set_compact_positions(std::move(table));
+  } else {
+    source_info.mutable_positions().reserve(factory.positions().size());
+    for (const auto& positions : factory.positions()) {
+      source_info.mutable_positions().insert(
+          std::pair{positions.first, positions.second.begin});
+    }
+  }
+  source_info.mutable_line_offsets().assign(source.line_offsets().begin(),
+                                            source.line_offsets().end());
+  source_info.set_macro_calls(factory.release_macro_calls());
+  return source_info;
 }
 
-absl::StatusOr<VerboseParsedExpr> EnrichedParse(
+EnrichedSourceInfo GetEnrichedSourceInfo(
+    const cel::ParserMacroExprFactory& factory) {
+  std::map<int64_t, std::pair<int32_t, int32_t>> offsets;
+  for (const auto& positions : factory.positions()) {
+    offsets.insert(
+        std::pair{positions.first,
+                  std::pair{positions.second.begin, positions.second.end - 1}});
+  }
+  return EnrichedSourceInfo(std::move(offsets));
+}
+
+// Parses `source`, passing the resulting expression and the factory holding
+// its source information to `finish`.
+template <typename T>
+absl::StatusOr<T> ParseImpl(
     const cel::Source& source, const cel::MacroRegistry& registry,
-    const ParserOptions& options) {
+    const ParserOptions& options,
+    absl::FunctionRef<absl::StatusOr<T>(Expr, cel::ParserMacroExprFactory&)>
+        finish) {
+  if (source.content().size() > options.expression_size_codepoint_limit) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "expression size exceeds codepoint limit.", " input size: ",
+        source.content().size(), ", limit: ",
+        options.expression_size_codepoint_limit));
+  }
+  if (options.enable_recursive_descent_parser) {
+    cel::ParserMacroExprFactory factory(source);
+    CEL_ASSIGN_OR_RETURN(
+        Expr expr,
+        cel_parser_internal::ParseWithRecursiveDescent(registry, options,
+                                                       factory));
+    return finish(std::move(expr), factory);
+  }
   try {
     CodePointStream input(source.content(), source.description());
-    if (input.size() > options.expression_size_codepoint_limit) {
-      return absl::InvalidArgumentError(absl::StrCat(
-          "expression size exceeds codepoint limit.", " input size: ",
-          input.size(), ", limit: ", options.expression_size_codepoint_limit));
-    }
     CelLexer lexer(&input);
     CommonTokenStream tokens(&lexer);
     CelParser parser(&tokens);
     ExprRecursionListener listener(options.max_recursion_depth);
     ParserVisitor visitor(source, options.max_recursion_depth, registry,
                           options.add_macro_calls,
-                          options.enable_optional_syntax);
+                          options.enable_optional_syntax,
+                          options.enable_nested_logical_balancing);
 
     lexer.removeErrorListeners();
     parser.removeErrorListeners();
@@ -1701,14 +1308,7 @@ absl::StatusOr<VerboseParsedExpr> EnrichedParse(
     }
 
     // root is deleted as part of the parser context
-    ParsedExpr parsed_expr;
-    CEL_RETURN_IF_ERROR(cel::extensions::protobuf_internal::ExprToProto(
-        expr, parsed_expr.mutable_expr()));
-    CEL_RETURN_IF_ERROR(
-        visitor.GetSourceInfo(parsed_expr.mutable_source_info()));
-    auto enriched_source_info = visitor.enriched_source_info();
-    return VerboseParsedExpr(std::move(parsed_expr),
-                             std::move(enriched_source_info));
+    return finish(std::move(expr), visitor.factory());
   } catch (const std::exception& e) {
     return absl::AbortedError(e.what());
   } catch (const char* what) {
@@ -1720,12 +1320,110 @@ absl::StatusOr<VerboseParsedExpr> EnrichedParse(
   }
 }
 
+std::vector<Macro> DefaultMacros(const ParserOptions& options) {
+  std::vector<Macro> macros = Macro::AllMacros();
+  if (options.enable_optional_syntax) {
+    macros.push_back(cel::OptMapMacro());
+    macros.push_back(cel::OptFlatMapMacro());
+  }
+  return macros;
+}
+
+}  // namespace
+
+absl::StatusOr<ParsedExpr> Parse(absl::string_view expression,
+                                 absl::string_view description,
+                                 const ParserOptions& options) {
+  return ParseWithMacros(expression, DefaultMacros(options), description,
+                         options);
+}
+
+absl::StatusOr<ParsedExpr> ParseWithMacros(absl::string_view expression,
+                                           const std::vector<Macro>& macros,
+                                           absl::string_view description,
+                                           const ParserOptions& options) {
+  CEL_ASSIGN_OR_RETURN(auto source,
+                       cel::NewSource(expression, std::string(description)));
+  cel::MacroRegistry macro_registry;
+  CEL_RETURN_IF_ERROR(macro_registry.RegisterMacros(macros));
+  return Parse(*source, macro_registry, options);
+}
+
+absl::StatusOr<VerboseParsedExpr> EnrichedParse(
+    absl::string_view expression, const std::vector<Macro>& macros,
+    absl::string_view description, const ParserOptions& options) {
+  CEL_ASSIGN_OR_RETURN(auto source,
+                       cel::NewSource(expression, std::string(description)));
+  cel::MacroRegistry macro_registry;
+  CEL_RETURN_IF_ERROR(macro_registry.RegisterMacros(macros));
+  return EnrichedParse(*source, macro_registry, options);
+}
+
+absl::StatusOr<VerboseParsedExpr> EnrichedParse(
+    const cel::Source& source, const cel::MacroRegistry& registry,
+    const ParserOptions& options) {
+  return ParseImpl<VerboseParsedExpr>(
+      source, registry, options,
+      [](Expr expr, cel::ParserMacroExprFactory& factory)
+          -> absl::StatusOr<VerboseParsedExpr> {
+        ParsedExpr parsed_expr;
+        CEL_RETURN_IF_ERROR(GetParsedExpr(expr, factory, parsed_expr));
+        auto enriched_source_info = GetEnrichedSourceInfo(factory);
+        return VerboseParsedExpr(std::move(parsed_expr),
+                                 std::move(enriched_source_info));
+      });
+}
+
+// Builds the ParsedExpr directly, rather than copying it out of an
+// EnrichedParse result, which also collects source ranges for every node.
 absl::StatusOr<google::api::expr::v1alpha1::ParsedExpr> Parse(
     const cel::Source& source, const cel::MacroRegistry& registry,
     const ParserOptions& options) {
-  CEL_ASSIGN_OR_RETURN(auto verbose_expr,
-                       EnrichedParse(source, registry, options));
-  return verbose_expr.parsed_expr();
+  return ParseImpl<ParsedExpr>(
+      source, registry, options,
+      [](Expr expr, cel::ParserMacroExprFactory& factory)
+          -> absl::StatusOr<ParsedExpr> {
+        ParsedExpr parsed_expr;
+        CEL_RETURN_IF_ERROR(GetParsedExpr(expr, factory, parsed_expr));
+        return parsed_expr;
+      });
+}
+
+absl::StatusOr<absl::Nonnull<google::api::expr::v1alpha1::ParsedExpr*>> Parse(
+    const cel::Source& source, const cel::MacroRegistry& registry,
+    absl::Nonnull<google::protobuf::Arena*> arena,
+    const ParserOptions& options) {
+  return ParseImpl<absl::Nonnull<ParsedExpr*>>(
+      source, registry, options,
+      [arena](Expr expr, cel::ParserMacroExprFactory& factory)
+          -> absl::StatusOr<absl::Nonnull<ParsedExpr*>> {
+        auto* parsed_expr = google::protobuf::Arena::Create<ParsedExpr>(arena);
+        CEL_RETURN_IF_ERROR(GetParsedExpr(expr, factory, *parsed_expr));
+        return parsed_expr;
+      });
+}
+
+absl::StatusOr<std::unique_ptr<cel::Ast>> ParseAst(
+    absl::string_view expression, absl::string_view description,
+    const ParserOptions& options) {
+  CEL_ASSIGN_OR_RETURN(auto source,
+                       cel::NewSource(expression, std::string(description)));
+  cel::MacroRegistry macro_registry;
+  CEL_RETURN_IF_ERROR(macro_registry.RegisterMacros(DefaultMacros(options)));
+  return ParseAst(*source, macro_registry, options);
+}
+
+absl::StatusOr<std::unique_ptr<cel::Ast>> ParseAst(
+    const cel::Source& source, const cel::MacroRegistry& registry,
+    const ParserOptions& options) {
+  return ParseImpl<std::unique_ptr<cel::Ast>>(
+      source, registry, options,
+      [compact_positions = options.compact_source_positions](
+          Expr expr, cel::ParserMacroExprFactory& factory)
+          -> absl::StatusOr<std::unique_ptr<cel::Ast>> {
+        return std::make_unique<cel::ast_internal::AstImpl>(
+            std::move(expr), ReleaseSourceInfo(factory, compact_positions));
+      });
 }
 
 }  // namespace google::api::expr::parser
@@ -15,17 +15,21 @@
 #ifndef THIRD_PARTY_CEL_CPP_PARSER_PARSER_H_
 #define THIRD_PARTY_CEL_CPP_PARSER_PARSER_H_
 
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/base/nullability.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "common/ast.h"
 #include "common/source.h"
 #include "parser/macro.h"
 #include "parser/macro_registry.h"
 #include "parser/options.h"
 #include "parser/source_factory.h"
+#include "google/protobuf/arena.h"
 
 namespace google::api::expr::parser {
 
@@ -70,6 +74,25 @@ absl::StatusOr<google::api::expr::v1alpha1::ParsedExpr> Parse(
     const cel::Source& source, const cel::MacroRegistry& registry,
     const ParserOptions& options = ParserOptions());
 
+// Like Parse, but allocates the ParsedExpr, and with it every node and string
+// of the expression and its source info, on `arena`. The result is owned by
+// `arena` and freed with its blocks, rather than node by node.
+absl::StatusOr<absl::Nonnull<google::api::expr::v1alpha1::ParsedExpr*>> Parse(
+    const cel::Source& source, const cel::MacroRegistry& registry,
+    absl::Nonnull<google::protobuf::Arena*> arena,
+    const ParserOptions& options = ParserOptions());
+
+// Like Parse, but returns the native AST built by the parser instead of
+// converting it to a ParsedExpr, which callers planning or checking the
+// expression would otherwise convert back.
+absl::StatusOr<std::unique_ptr<cel::Ast>> ParseAst(
+    absl::string_view expression, absl::string_view description = "<input>",
+    const ParserOptions& options = ParserOptions());
+
+absl::StatusOr<std::unique_ptr<cel::Ast>> ParseAst(
+    const cel::Source& source, const cel::MacroRegistry& registry,
+    const ParserOptions& options = ParserOptions());
+
 }  // namespace google::api::expr::parser
 
 #endif  // THIRD_PARTY_CEL_CPP_PARSER_PARSER_H_
@@ -0,0 +1,213 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the parser over a corpus of expressions of different shapes.
+//
+// The benchmarks of the ANTLR parser are cumulative, so the cost of each stage
+// is the difference between two of them:
+//
+// - BM_Lex: tokenizing the expression.
+// - BM_ParseTree: tokenizing and building the ANTLR parse tree.
+// - BM_ParseAstWithoutMacros: the above and building the AST.
+// - BM_ParseAst: the above and expanding the standard macros.
+//
+// BM_ParseAstRecursiveDescent is BM_ParseAst with the recursive descent
+// parser, and BM_ParseProto is BM_ParseAst with the conversion to
+// google.api.expr.v1alpha1.ParsedExpr.
+//
+// Every benchmark reports the bytes parsed per second and the allocations
+// per parse.
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/strings/str_cat.h"
+#include "antlr4-runtime.h"
+#include "common/source.h"
+#include "internal/benchmark.h"
+#include "internal/testing.h"
+#include "parser/internal/CelLexer.h"
+#include "parser/internal/CelParser.h"
+#include "parser/macro.h"
+#include "parser/macro_registry.h"
+#include "parser/options.h"
+#include "parser/parser.h"
+
+namespace google::api::expr::parser {
+namespace {
+
+using ::cel::internal::AllocationCounters;
+using ::cel_parser_internal::CelLexer;
+using ::cel_parser_internal::CelParser;
+
+struct CorpusEntry {
+  std::string name;
+  std::string expression;
+};
+
+// Returns `1 + (1 + (... + 1))` nested `depth` times.
+std::string NestedExpression(int depth) {
+  std::string expression;
+  for (int i = 0; i < depth; ++i) {
+    expression.append("1 + (");
+  }
+  expression.append("1");
+  expression.append(depth, ')');
+  return expression;
+}
+
+// Returns a disjunction of string comparisons of at least `size` bytes.
+std::string LongExpression(size_t size) {
+  std::string expression = "x == 'value_0'";
+  for (int i = 1; expression.size() < size; ++i) {
+    absl::StrAppend(&expression, " || x == 'value_", i, "'");
+  }
+  return expression;
+}
+
+const std::vector<CorpusEntry>& Corpus() {
+  static const auto* corpus = new std::vector<CorpusEntry>{
+      {"small", "a + b"},
+      {"typical",
+       "request.auth.claims.email.endsWith('@example.com') && "
+       "request.time < timestamp('2030-01-01T00:00:00Z') && "
+       "resource.labels['env'] in ['prod', 'staging']"},
+      {"macro_heavy",
+       "items.all(i, i.price > 0) && "
+       "items.exists(i, i.tags.exists_one(t, t == 'sale')) && "
+       "items.map(i, i.price * i.quantity).filter(p, p > 100).size() < 10 && "
+       "has(order.discount)"},
+      {"deeply_nested", NestedExpression(64)},
+      {"long_100kb", LongExpression(100 * 1024)},
+  };
+  return *corpus;
+}
+
+ParserOptions BenchmarkOptions() {
+  ParserOptions options;
+  // The long expression is above the default limit.
+  options.expression_size_codepoint_limit = 1 << 20;
+  return options;
+}
+
+// Labels the benchmark with the name of its corpus entry, and returns the
+// expression.
+const std::string& StartBenchmark(benchmark::State& state) {
+  const CorpusEntry& entry = Corpus()[state.range(0)];
+  state.SetLabel(entry.name);
+  return entry.expression;
+}
+
+void FinishBenchmark(benchmark::State& state, const std::string& expression) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(expression.size()));
+}
+
+void ApplyCorpus(benchmark::internal::Benchmark* benchmark) {
+  benchmark->DenseRange(0, static_cast<int>(Corpus().size()) - 1);
+}
+
+// The parser reads the expression through its own code point stream, which
+// avoids the UTF-32 copy made by ANTLRInputStream. That copy is small next
+// to tokenizing.
+void BM_Lex(benchmark::State& state) {
+  const std::string& expression = StartBenchmark(state);
+  AllocationCounters allocation_counters(state);
+  for (auto _ : state) {
+    antlr4::ANTLRInputStream input(expression);
+    CelLexer lexer(&input);
+    lexer.removeErrorListeners();
+    antlr4::CommonTokenStream tokens(&lexer);
+    tokens.fill();
+    benchmark::DoNotOptimize(tokens.size());
+  }
+  FinishBenchmark(state, expression);
+}
+
+BENCHMARK(BM_Lex)->Apply(ApplyCorpus);
+
+void BM_ParseTree(benchmark::State& state) {
+  const std::string& expression = StartBenchmark(state);
+  AllocationCounters allocation_counters(state);
+  for (auto _ : state) {
+    antlr4::ANTLRInputStream input(expression);
+    CelLexer lexer(&input);
+    lexer.removeErrorListeners();
+    antlr4::CommonTokenStream tokens(&lexer);
+    CelParser parser(&tokens);
+    parser.removeErrorListeners();
+    benchmark::DoNotOptimize(parser.start());
+  }
+  FinishBenchmark(state, expression);
+}
+
+BENCHMARK(BM_ParseTree)->Apply(ApplyCorpus);
+
+void RunParseAst(benchmark::State& state, const std::vector<Macro>& macros,
+                 const ParserOptions& options) {
+  const std::string& expression = StartBenchmark(state);
+  ASSERT_OK_AND_ASSIGN(auto source, cel::NewSource(expression));
+  cel::MacroRegistry registry;
+  ASSERT_OK(registry.RegisterMacros(macros));
+  AllocationCounters allocation_counters(state);
+  for (auto _ : state) {
+    auto ast = ParseAst(*source, registry, options);
+    ASSERT_OK(ast);
+    benchmark::DoNotOptimize(ast);
+  }
+  FinishBenchmark(state, expression);
+}
+
+void BM_ParseAstWithoutMacros(benchmark::State& state) {
+  RunParseAst(state, {}, BenchmarkOptions());
+}
+
+BENCHMARK(BM_ParseAstWithoutMacros)->Apply(ApplyCorpus);
+
+void BM_ParseAst(benchmark::State& state) {
+  RunParseAst(state, Macro::AllMacros(), BenchmarkOptions());
+}
+
+BENCHMARK(BM_ParseAst)->Apply(ApplyCorpus);
+
+void BM_ParseAstRecursiveDescent(benchmark::State& state) {
+  ParserOptions options = BenchmarkOptions();
+  options.enable_recursive_descent_parser = true;
+  RunParseAst(state, Macro::AllMacros(), options);
+}
+
+BENCHMARK(BM_ParseAstRecursiveDescent)->Apply(ApplyCorpus);
+
+void BM_ParseProto(benchmark::State& state) {
+  const std::string& expression = StartBenchmark(state);
+  ASSERT_OK_AND_ASSIGN(auto source, cel::NewSource(expression));
+  cel::MacroRegistry registry;
+  ASSERT_OK(registry.RegisterMacros(Macro::AllMacros()));
+  const ParserOptions options = BenchmarkOptions();
+  AllocationCounters allocation_counters(state);
+  for (auto _ : state) {
+    auto parsed_expr = Parse(*source, registry, options);
+    ASSERT_OK(parsed_expr);
+    benchmark::DoNotOptimize(parsed_expr);
+  }
+  FinishBenchmark(state, expression);
+}
+
+BENCHMARK(BM_ParseProto)->Apply(ApplyCorpus);
+
+}  // namespace
+}  // namespace google::api::expr::parser
@@ -14,6 +14,7 @@
 
 #include "parser/parser.h"
 
+#include <algorithm>
 #include <list>
 #include <string>
 #include <thread>
@@ -23,25 +24,36 @@
 #include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "absl/algorithm/container.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/source.h"
+#include "extensions/protobuf/ast_converters.h"
 #include "internal/benchmark.h"
+#include "internal/proto_matchers.h"
 #include "internal/testing.h"
 #include "parser/macro.h"
+#include "parser/macro_registry.h"
 #include "parser/options.h"
 #include "parser/source_factory.h"
 #include "testutil/expr_printer.h"
+#include "google/protobuf/arena.h"
 
 namespace google::api::expr::parser {
 
 namespace {
 
 using ::google::api::expr::v1alpha1::Expr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
 using testing::HasSubstr;
 using testing::Not;
 using cel::internal::IsOk;
+using cel::internal::StatusIs;
+using cel::internal::test::EqualsProto;
 
 struct TestInfo {
   TestInfo(const std::string& I, const std::string& P,
@@ -1417,6 +1429,150 @@ TEST_P(ExpressionTest, Parse) {
   }
 }
 
+TEST_P(ExpressionTest, RecursiveDescentParse) {
+  const TestInfo& test_info = GetParam();
+  ParserOptions options;
+  if (!test_info.M.empty()) {
+    options.add_macro_calls = true;
+  }
+  options.enable_optional_syntax = true;
+  options.enable_recursive_descent_parser = true;
+
+  std::vector<Macro> macros = Macro::AllMacros();
+  macros.push_back(cel::OptMapMacro());
+  macros.push_back(cel::OptFlatMapMacro());
+  auto result = EnrichedParse(test_info.I, macros, "<input>", options);
+  if (test_info.E.empty()) {
+    ASSERT_THAT(result, IsOk());
+  } else {
+    EXPECT_THAT(result, Not(IsOk()));
+    // Parsing stops at the first syntax error, rather than recovering from it
+    // as the ANTLR generated parser does.
+    if (!absl::StrContains(test_info.E, "Syntax error")) {
+      EXPECT_EQ(test_info.E, result.status().message());
+    }
+    return;
+  }
+
+  if (!test_info.P.empty()) {
+    KindAndIdAdorner kind_and_id_adorner;
+    testutil::ExprPrinter w(kind_and_id_adorner);
+    std::string adorned_string = w.print(result->parsed_expr().expr());
+    EXPECT_EQ(test_info.P, adorned_string) << result->parsed_expr();
+  }
+
+  if (!test_info.L.empty()) {
+    LocationAdorner location_adorner(result->parsed_expr().source_info());
+    testutil::ExprPrinter w(location_adorner);
+    std::string adorned_string = w.print(result->parsed_expr().expr());
+    EXPECT_EQ(test_info.L, adorned_string) << result->parsed_expr();
+  }
+
+  if (!test_info.R.empty()) {
+    EXPECT_EQ(test_info.R, ConvertEnrichedSourceInfoToString(
+                               result->enriched_source_info()));
+  }
+
+  if (!test_info.M.empty()) {
+    EXPECT_EQ(test_info.M, ConvertMacroCallsToString(
+                               result.value().parsed_expr().source_info()))
+        << result->parsed_expr();
+  }
+}
+
+TEST_P(ExpressionTest, ParseAst) {
+  const TestInfo& test_info = GetParam();
+  ParserOptions options;
+  if (!test_info.M.empty()) {
+    options.add_macro_calls = true;
+  }
+  options.enable_optional_syntax = true;
+
+  std::vector<Macro> macros = Macro::AllMacros();
+  macros.push_back(cel::OptMapMacro());
+  macros.push_back(cel::OptFlatMapMacro());
+  ASSERT_OK_AND_ASSIGN(auto source, cel::NewSource(test_info.I));
+  cel::MacroRegistry registry;
+  ASSERT_OK(registry.RegisterMacros(macros));
+  auto expected = Parse(*source, registry, options);
+  auto result = ParseAst(*source, registry, options);
+  if (!expected.ok()) {
+    EXPECT_THAT(result, StatusIs(expected.status().code(),
+                                 expected.status().message()));
+    return;
+  }
+  ASSERT_OK(result);
+  ASSERT_OK_AND_ASSIGN(auto expected_ast,
+                       cel::extensions::CreateAstFromParsedExpr(*expected));
+  const auto& expected_impl =
+      cel::ast_internal::AstImpl::CastFromPublicAst(*expected_ast);
+  const auto& impl = cel::ast_internal::AstImpl::CastFromPublicAst(**result);
+  EXPECT_EQ(impl.root_expr(), expected_impl.root_expr());
+  EXPECT_EQ(impl.source_info(), expected_impl.source_info());
+}
+
+TEST_P(ExpressionTest, ParseAstCompactPositions) {
+  const TestInfo& test_info = GetParam();
+  ParserOptions options;
+  if (!test_info.M.empty()) {
+    options.add_macro_calls = true;
+  }
+  options.enable_optional_syntax = true;
+
+  std::vector<Macro> macros = Macro::AllMacros();
+  macros.push_back(cel::OptMapMacro());
+  macros.push_back(cel::OptFlatMapMacro());
+  ASSERT_OK_AND_ASSIGN(auto source, cel::NewSource(test_info.I));
+  cel::MacroRegistry registry;
+  ASSERT_OK(registry.RegisterMacros(macros));
+  auto expected = ParseAst(*source, registry, options);
+  options.compact_source_positions = true;
+  auto result = ParseAst(*source, registry, options);
+  if (!expected.ok()) {
+    EXPECT_THAT(result, StatusIs(expected.status().code(),
+                                 expected.status().message()));
+    return;
+  }
+  ASSERT_OK(result);
+  const auto& expected_impl =
+      cel::ast_internal::AstImpl::CastFromPublicAst(**expected);
+  const auto& impl = cel::ast_internal::AstImpl::CastFromPublicAst(**result);
+  EXPECT_THAT(impl.source_info().positions(), testing::IsEmpty());
+  EXPECT_EQ(impl.source_info().compact_positions().size(),
+            expected_impl.source_info().positions().size());
+  for (const auto& [id, offset] : expected_impl.source_info().positions()) {
+    EXPECT_EQ(impl.source_info().GetPosition(id), offset);
+  }
+  EXPECT_EQ(impl.source_info(), expected_impl.source_info());
+}
+
+TEST_P(ExpressionTest, ParseOnArena) {
+  const TestInfo& test_info = GetParam();
+  ParserOptions options;
+  if (!test_info.M.empty()) {
+    options.add_macro_calls = true;
+  }
+  options.enable_optional_syntax = true;
+
+  std::vector<Macro> macros = Macro::AllMacros();
+  macros.push_back(cel::OptMapMacro());
+  macros.push_back(cel::OptFlatMapMacro());
+  ASSERT_OK_AND_ASSIGN(auto source, cel::NewSource(test_info.I));
+  cel::MacroRegistry registry;
+  ASSERT_OK(registry.RegisterMacros(macros));
+  auto expected = Parse(*source, registry, options);
+  google::protobuf::Arena arena;
+  auto result = Parse(*source, registry, &arena, options);
+  if (!expected.ok()) {
+    EXPECT_THAT(result, StatusIs(expected.status().code(),
+                                 expected.status().message()));
+    return;
+  }
+  ASSERT_OK(result);
+  EXPECT_EQ((*result)->GetArena(), &arena);
+  EXPECT_THAT(**result, EqualsProto(*expected));
+}
+
 TEST(ExpressionTest, TsanOom) {
   Parse(
       "[[a([[???[a[[??[a([[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[["
@@ -1495,6 +1651,51 @@ TEST(ExpressionTest, RecursionDepthIgnoresParentheses) {
   EXPECT_THAT(result, IsOk());
 }
 
+TEST(ExpressionTest, RecursiveDescentRecursionDepth) {
+  ParserOptions options;
+  options.enable_recursive_descent_parser = true;
+  options.max_recursion_depth = 16;
+  EXPECT_THAT(Parse("[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]", "", options), IsOk());
+
+  options.max_recursion_depth = 6;
+  EXPECT_THAT(Parse("(((1 + 2 + 3 + 4 + (5 + 6))))", "", options), IsOk());
+  auto result = Parse("1 + 2 + 3 + 4 + 5 + 6 + 7", "", options);
+  EXPECT_THAT(result, Not(IsOk()));
+  EXPECT_THAT(result.status().message(),
+              HasSubstr("Exceeded max recursion depth of 6 when parsing."));
+}
+
+// Returns the depth of the nested calls of `expr`.
+int CallDepth(const Expr& expr) {
+  int depth = 0;
+  for (const Expr& arg : expr.call_expr().args()) {
+    depth = std::max(depth, CallDepth(arg));
+  }
+  return expr.has_call_expr() ? depth + 1 : 0;
+}
+
+TEST(ExpressionTest, NestedLogicalBalancing) {
+  constexpr absl::string_view kExpression =
+      "(a || (b || (c || (d || (e || (f || (g || h))))))) && x";
+  for (bool recursive_descent : {false, true}) {
+    ParserOptions options;
+    options.enable_recursive_descent_parser = recursive_descent;
+    ASSERT_OK_AND_ASSIGN(ParsedExpr unbalanced,
+                         Parse(kExpression, "", options));
+    EXPECT_EQ(CallDepth(unbalanced.expr()), 8);
+
+    options.enable_nested_logical_balancing = true;
+    ASSERT_OK_AND_ASSIGN(ParsedExpr balanced, Parse(kExpression, "", options));
+    EXPECT_EQ(CallDepth(balanced.expr()), 4);
+    // The same nodes are reused, so the IDs and their positions are the same.
+    EXPECT_EQ(balanced.source_info().positions_size(),
+              unbalanced.source_info().positions_size());
+    // Operands of other operators are not merged.
+    ASSERT_EQ(balanced.expr().call_expr().function(), "_&&_");
+    EXPECT_EQ(balanced.expr().call_expr().args(1).ident_expr().name(), "x");
+  }
+}
+
 std::string TestName(const testing::TestParamInfo<TestInfo>& test_info) {
   std::string name = absl::StrCat(test_info.index, "-", test_info.param.I);
   absl::c_replace_if(name, [](char c) { return !absl::ascii_isalnum(c); }, '_');
@@ -14,6 +14,8 @@
 
 #include "runtime/activation.h"
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -21,7 +23,9 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/function.h"
 #include "base/function_descriptor.h"
 #include "common/value.h"
@@ -38,34 +42,35 @@ absl::StatusOr<absl::optional<ValueView>> Activation::FindVariable(
   }
 
   const ValueEntry& entry = iter->second;
-  if (entry.provider.has_value()) {
-    return ProvideValue(factory, name, scratch);
+  if (entry.provided != nullptr) {
+    return ProvideValue(factory, name, *entry.provided);
   }
   if (entry.value.has_value()) {
-    scratch = *entry.value;
-    return scratch;
+    return ValueView(*entry.value);
   }
   return absl::nullopt;
 }
 
 absl::StatusOr<absl::optional<ValueView>> Activation::ProvideValue(
-    ValueManager& factory, absl::string_view name, Value& scratch) const {
-  absl::MutexLock lock(&mutex_);
-  auto iter = values_.find(name);
-  ABSL_ASSERT(iter != values_.end());
-  ValueEntry& entry = iter->second;
-  if (entry.value.has_value()) {
-    scratch = *entry.value;
-    return scratch;
+    ValueManager& factory, absl::string_view name, ProvidedValue& provided) {
+  if (provided.ready.load(std::memory_order_acquire)) {
+    return ValueView(*provided.value);
   }
 
-  CEL_ASSIGN_OR_RETURN(auto result, (*entry.provider)(factory, name));
-  if (result.has_value()) {
-    entry.value = std::move(result);
-    scratch = *entry.value;
-    return scratch;
+  absl::MutexLock lock(&provided.mutex);
+  if (provided.ready.load(std::memory_order_relaxed)) {
+    return ValueView(*provided.value);
   }
-  return absl::nullopt;
+
+  // Errors and absent values are not memoized, the provider is retried on the
+  // next lookup.
+  CEL_ASSIGN_OR_RETURN(auto result, provided.provider(factory, name));
+  if (!result.has_value()) {
+    return absl::nullopt;
+  }
+  provided.value = std::move(result);
+  provided.ready.store(true, std::memory_order_release);
+  return ValueView(*provided.value);
 }
 
 std::vector<FunctionOverloadReference> Activation::FindFunctionOverloads(
@@ -82,17 +87,46 @@ std::vector<FunctionOverloadReference> Activation::FindFunctionOverloads(
   return result;
 }
 
+bool Activation::BindEntry(absl::string_view name, ValueEntry entry) {
+  auto [iter, inserted] = values_.try_emplace(name);
+  const bool was_bound = !inserted && (iter->second.value.has_value() ||
+                                       iter->second.provided != nullptr);
+  iter->second = std::move(entry);
+  return !was_bound;
+}
+
 bool Activation::InsertOrAssignValue(absl::string_view name, Value value) {
-  return values_
-      .insert_or_assign(name, ValueEntry{std::move(value), absl::nullopt})
-      .second;
+  return BindEntry(name, ValueEntry{std::move(value), nullptr});
+}
+
+size_t Activation::InsertValues(
+    absl::Span<const std::pair<absl::string_view, Value>> values) {
+  size_t inserted = 0;
+  for (const auto& [name, value] : values) {
+    inserted += BindEntry(name, ValueEntry{value, nullptr}) ? 1 : 0;
+  }
+  return inserted;
 }
 
 bool Activation::InsertOrAssignValueProvider(absl::string_view name,
                                              ValueProvider provider) {
-  return values_
-      .insert_or_assign(name, ValueEntry{absl::nullopt, std::move(provider)})
-      .second;
+  return BindEntry(name,
+                   ValueEntry{absl::nullopt, std::make_unique<ProvidedValue>(
+                                                 std::move(provider))});
+}
+
+void Activation::Clear() {
+  // Keep the entries, and so their names, for the next evaluation. An entry
+  // with neither a value nor a provider is unbound.
+  for (auto& [name, entry] : values_) {
+    entry.value.reset();
+    entry.provided.reset();
+  }
+  functions_.clear();
+  unknown_patterns_.clear();
+  missing_patterns_.clear();
+  deadline_ = absl::InfiniteFuture();
+  cancellation_token_.reset();
 }
 
 bool Activation::InsertFunction(const cel::FunctionDescriptor& descriptor,
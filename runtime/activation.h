@@ -15,17 +15,21 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_ACTIVATION_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_ACTIVATION_H_
 
+#include <atomic>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/attribute.h"
@@ -34,6 +38,7 @@
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
 #include "runtime/function_overload_reference.h"
 
 namespace cel {
@@ -69,14 +74,48 @@ class Activation final : public ActivationInterface {
     return missing_patterns_;
   }
 
+  absl::Time GetDeadline() const override { return deadline_; }
+
+  absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const override {
+    return cancellation_token_.get();
+  }
+
   // Bind a value to a named variable.
   //
   // Returns false if the entry for name was overwritten.
   bool InsertOrAssignValue(absl::string_view name, Value value);
 
+  // Bind each value to the named variable, as if by InsertOrAssignValue in
+  // order.
+  //
+  // Returns the number of variables that weren't bound before.
+  size_t InsertValues(
+      absl::Span<const std::pair<absl::string_view, Value>> values);
+
+  // Reserve room for `n` variables, so binding up to `n` variables doesn't
+  // grow the activation.
+  void Reserve(size_t n) { values_.reserve(n); }
+
+  // Unbind every variable and function, and reset the unknown and missing
+  // patterns, the deadline and the cancellation token, so the activation can
+  // be reused for another evaluation.
+  //
+  // The names of the variables bound before and the memory for them are
+  // kept: binding the same names again, as when building an activation per
+  // request, neither allocates the names nor grows the activation.
+  void Clear();
+
   // Bind a provider to a named variable. The result of the provider may be
   // memoized by the activation.
   //
+  // The provider is invoked at most once per memoized result, even if the
+  // activation is shared by concurrent evaluations: a lookup that races with
+  // the first invocation waits for it, and lookups after the value is
+  // memoized are lock-free. The provided value is shared by every evaluation
+  // using the activation, so it must not be allocated with a memory manager
+  // that is destroyed before the activation.
+  //
   // Returns false if the entry for name was overwritten.
   bool InsertOrAssignValueProvider(absl::string_view name,
                                    ValueProvider provider);
@@ -89,17 +128,42 @@ class Activation final : public ActivationInterface {
     missing_patterns_ = std::move(patterns);
   }
 
+  // Fail evaluations using this activation with a deadline exceeded error
+  // once `deadline` has passed.
+  void SetDeadline(absl::Time deadline) { deadline_ = deadline; }
+
+  // Fail evaluations using this activation with a cancelled error once
+  // `token` is cancelled.
+  void SetCancellationToken(std::shared_ptr<const CancellationToken> token) {
+    cancellation_token_ = std::move(token);
+  }
+
   // Returns true if the function was inserted (no other registered function has
   // a matching descriptor).
   bool InsertFunction(const cel::FunctionDescriptor& descriptor,
                       std::unique_ptr<cel::Function> impl);
 
  private:
+  // State for a lazily provided value.
+  //
+  // Heap allocated so that the address is stable when the map rehashes.
+  struct ProvidedValue {
+    explicit ProvidedValue(ValueProvider provider)
+        : provider(std::move(provider)) {}
+
+    // Set with release semantics once value is memoized. value is immutable
+    // afterwards, so readers that observe it don't need to lock.
+    std::atomic<bool> ready{false};
+    // Serializes invocations of the provider for this entry only.
+    absl::Mutex mutex;
+    ValueProvider provider ABSL_GUARDED_BY(mutex);
+    absl::optional<Value> value;
+  };
+
   struct ValueEntry {
-    // If provider is present, then access must be synchronized to maintain
-    // thread-compatible semantics for the lazily provided value.
+    // Exactly one of value or provided is set.
     absl::optional<Value> value;
-    absl::optional<ValueProvider> provider;
+    std::unique_ptr<ProvidedValue> provided;
   };
 
   struct FunctionEntry {
@@ -108,19 +172,23 @@ class Activation final : public ActivationInterface {
   };
 
   // Internal getter for provided values.
-  // Assumes entry for name is present and is a provided value.
   // Handles synchronization for caching the provided value.
-  absl::StatusOr<absl::optional<ValueView>> ProvideValue(
+  static absl::StatusOr<absl::optional<ValueView>> ProvideValue(
       ValueManager& value_factory, absl::string_view name,
-      Value& scratch) const;
+      ProvidedValue& provided);
 
-  // mutex_ used for safe caching of provided variables
-  mutable absl::Mutex mutex_;
-  mutable absl::flat_hash_map<std::string, ValueEntry> values_;
+  // Binds `entry` to `name`, reusing the entry of a name unbound by Clear.
+  // Returns false if a bound entry was overwritten.
+  bool BindEntry(absl::string_view name, ValueEntry entry);
+
+  absl::flat_hash_map<std::string, ValueEntry> values_;
 
   std::vector<cel::AttributePattern> unknown_patterns_;
   std::vector<cel::AttributePattern> missing_patterns_;
 
+  absl::Time deadline_ = absl::InfiniteFuture();
+  std::shared_ptr<const CancellationToken> cancellation_token_;
+
   absl::flat_hash_map<std::string, std::vector<FunctionEntry>> functions_;
 };
 
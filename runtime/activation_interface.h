@@ -15,20 +15,26 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_ACTIVATION_INTERFACE_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_ACTIVATION_INTERFACE_H_
 
+#include <cstddef>
 #include <vector>
 
+#include "absl/base/nullability.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/attribute.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "internal/status_macros.h"
+#include "runtime/cancellation_token.h"
 #include "runtime/function_overload_reference.h"
 
 namespace cel {
 
+class VariableLayout;
+
 // Interface for providing runtime with variable lookups.
 //
 // Clients should prefer to use one of the concrete implementations provided by
@@ -53,6 +59,18 @@ class ActivationInterface {
     return Value{*maybe};
   }
 
+  // Find value for the variable assigned to `slot` in the layout of the program
+  // being evaluated.
+  //
+  // Activations that store variables by slot for `layout` (see
+  // SlotActivation) return the bound value directly, skipping the lookup by
+  // name. Returns nullptr if the variable is not bound this way, in which case
+  // the evaluator falls back to FindVariable.
+  virtual absl::Nullable<const Value*> FindVariableBySlot(
+      const VariableLayout& layout, size_t slot) const {
+    return nullptr;
+  }
+
   // Find a set of context function overloads by name.
   virtual std::vector<FunctionOverloadReference> FindFunctionOverloads(
       absl::string_view name) const = 0;
@@ -78,6 +96,23 @@ class ActivationInterface {
   // using this activation.
   virtual absl::Span<const cel::AttributePattern> GetMissingAttributes()
       const = 0;
+
+  // Return the time after which evaluations using this activation fail with a
+  // deadline exceeded error.
+  //
+  // The deadline is checked periodically rather than on every evaluation step.
+  // RuntimeOptions::evaluation_timeout may set an earlier deadline.
+  virtual absl::Time GetDeadline() const { return absl::InfiniteFuture(); }
+
+  // Return a token whose cancellation fails evaluations using this activation
+  // with a cancelled error, or nullptr if they can't be cancelled.
+  //
+  // The token must remain valid for the duration of any evaluation using this
+  // activation.
+  virtual absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const {
+    return nullptr;
+  }
 };
 
 }  // namespace cel
@@ -14,10 +14,15 @@
 
 #include "runtime/activation.h"
 
+#include <atomic>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "base/attribute.h"
 #include "base/function.h"
@@ -103,6 +108,63 @@ TEST_F(ActivationTest, InsertValueOverwrite) {
               IsOkAndHolds(Optional(IsIntValue(0))));
 }
 
+TEST_F(ActivationTest, InsertValues) {
+  Activation activation;
+  activation.Reserve(3);
+  EXPECT_TRUE(activation.InsertOrAssignValue(
+      "var1", value_factory_.CreateIntValue(0)));
+
+  EXPECT_EQ(
+      activation.InsertValues({{"var1", value_factory_.CreateIntValue(1)},
+                               {"var2", value_factory_.CreateIntValue(2)},
+                               {"var3", value_factory_.CreateIntValue(3)},
+                               {"var3", value_factory_.CreateIntValue(4)}}),
+      2);
+
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var1"),
+              IsOkAndHolds(Optional(IsIntValue(1))));
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var2"),
+              IsOkAndHolds(Optional(IsIntValue(2))));
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var3"),
+              IsOkAndHolds(Optional(IsIntValue(4))));
+}
+
+TEST_F(ActivationTest, Clear) {
+  Activation activation;
+  EXPECT_TRUE(activation.InsertOrAssignValue(
+      "var1", value_factory_.CreateIntValue(1)));
+  EXPECT_TRUE(activation.InsertOrAssignValueProvider(
+      "var2", [](ValueManager& factory, absl::string_view name) {
+        return factory.CreateIntValue(2);
+      }));
+  EXPECT_TRUE(
+      activation.InsertFunction(FunctionDescriptor("Fn", false, {Kind::kInt}),
+                                std::make_unique<FunctionImpl>()));
+  activation.SetUnknownPatterns({AttributePattern("var1", {})});
+  activation.SetDeadline(absl::UnixEpoch());
+
+  activation.Clear();
+
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var1"),
+              IsOkAndHolds(Eq(absl::nullopt)));
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var2"),
+              IsOkAndHolds(Eq(absl::nullopt)));
+  EXPECT_THAT(activation.FindFunctionOverloads("Fn"), IsEmpty());
+  EXPECT_THAT(activation.GetUnknownAttributes(), IsEmpty());
+  EXPECT_EQ(activation.GetDeadline(), absl::InfiniteFuture());
+
+  // Names unbound by Clear are inserted, not overwritten.
+  EXPECT_TRUE(activation.InsertOrAssignValue(
+      "var1", value_factory_.CreateIntValue(3)));
+  EXPECT_EQ(
+      activation.InsertValues({{"var2", value_factory_.CreateIntValue(4)}}),
+      1);
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var1"),
+              IsOkAndHolds(Optional(IsIntValue(3))));
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var2"),
+              IsOkAndHolds(Optional(IsIntValue(4))));
+}
+
 TEST_F(ActivationTest, InsertProvider) {
   Activation activation;
 
@@ -156,6 +218,57 @@ TEST_F(ActivationTest, ProviderMemoized) {
   EXPECT_EQ(call_count, 1);
 }
 
+TEST_F(ActivationTest, ProviderRetriedAfterError) {
+  Activation activation;
+  int call_count = 0;
+
+  EXPECT_TRUE(activation.InsertOrAssignValueProvider(
+      "var1",
+      [&call_count](ValueManager& factory,
+                    absl::string_view name) -> absl::StatusOr<Value> {
+        if (call_count++ == 0) {
+          return absl::InternalError("test");
+        }
+        return factory.CreateIntValue(42);
+      }));
+
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var1"),
+              StatusIs(absl::StatusCode::kInternal, "test"));
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var1"),
+              IsOkAndHolds(Optional(IsIntValue(42))));
+  EXPECT_THAT(activation.FindVariable(value_factory_, "var1"),
+              IsOkAndHolds(Optional(IsIntValue(42))));
+  EXPECT_EQ(call_count, 2);
+}
+
+TEST(ActivationConcurrencyTest, ProviderCalledOnce) {
+  Activation activation;
+  std::atomic<int> call_count = 0;
+
+  EXPECT_TRUE(activation.InsertOrAssignValueProvider(
+      "var1", [&call_count](ValueManager& factory, absl::string_view name) {
+        call_count.fetch_add(1);
+        return factory.CreateIntValue(42);
+      }));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&activation]() {
+      common_internal::LegacyValueManager value_factory(
+          MemoryManagerRef::ReferenceCounting(), TypeProvider::Builtin());
+      for (int j = 0; j < 100; ++j) {
+        EXPECT_THAT(activation.FindVariable(value_factory, "var1"),
+                    IsOkAndHolds(Optional(IsIntValue(42))));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(call_count.load(), 1);
+}
+
 TEST_F(ActivationTest, InsertProviderOverwrite) {
   Activation activation;
 
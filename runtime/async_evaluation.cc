@@ -0,0 +1,188 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/async_evaluation.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/attribute.h"
+#include "base/function.h"
+#include "base/function_descriptor.h"
+#include "base/function_result.h"
+#include "base/function_result_set.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/eval/function_memoizer.h"
+#include "internal/status_macros.h"
+#include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/function_registry.h"
+#include "runtime/runtime.h"
+#include "runtime/variable_layout.h"
+
+namespace cel {
+
+using ::google::api::expr::runtime::FunctionMemoizer;
+
+// Implements an asynchronous function for the passes of an evaluation.
+class AsyncEvaluation::PendingFunction final : public Function {
+ public:
+  PendingFunction(AsyncEvaluation& evaluation, FunctionDescriptor descriptor)
+      : evaluation_(evaluation), descriptor_(std::move(descriptor)) {}
+
+  absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                               absl::Span<const Value> args) const override {
+    return evaluation_.Call(descriptor_, args);
+  }
+
+  const FunctionDescriptor& descriptor() const { return descriptor_; }
+
+ private:
+  AsyncEvaluation& evaluation_;
+  FunctionDescriptor descriptor_;
+};
+
+// The activation of a pass, binding the asynchronous functions on top of the
+// activation of the evaluation.
+class AsyncEvaluation::PassActivation final : public ActivationInterface {
+ public:
+  explicit PassActivation(const AsyncEvaluation& evaluation)
+      : evaluation_(evaluation) {}
+
+  absl::StatusOr<absl::optional<ValueView>> FindVariable(
+      ValueManager& factory, absl::string_view name,
+      Value& scratch) const override {
+    return evaluation_.activation_.FindVariable(factory, name, scratch);
+  }
+  using ActivationInterface::FindVariable;
+
+  absl::Nullable<const Value*> FindVariableBySlot(
+      const VariableLayout& layout, size_t slot) const override {
+    return evaluation_.activation_.FindVariableBySlot(layout, slot);
+  }
+
+  std::vector<FunctionOverloadReference> FindFunctionOverloads(
+      absl::string_view name) const override {
+    std::vector<FunctionOverloadReference> overloads =
+        evaluation_.activation_.FindFunctionOverloads(name);
+    for (const auto& function : evaluation_.functions_) {
+      if (function->descriptor().name() == name) {
+        overloads.push_back({function->descriptor(), *function});
+      }
+    }
+    return overloads;
+  }
+
+  absl::Span<const AttributePattern> GetUnknownAttributes() const override {
+    return evaluation_.activation_.GetUnknownAttributes();
+  }
+
+  absl::Span<const AttributePattern> GetMissingAttributes() const override {
+    return evaluation_.activation_.GetMissingAttributes();
+  }
+
+  absl::Time GetDeadline() const override {
+    return evaluation_.activation_.GetDeadline();
+  }
+
+  absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const override {
+    return evaluation_.activation_.GetCancellationToken();
+  }
+
+ private:
+  const AsyncEvaluation& evaluation_;
+};
+
+absl::Status RegisterAsyncFunction(FunctionRegistry& registry,
+                                   const FunctionDescriptor& descriptor) {
+  return registry.RegisterLazyFunction(descriptor);
+}
+
+AsyncEvaluation::AsyncEvaluation(
+    const Program& program, const ActivationInterface& activation,
+    ValueManager& value_factory,
+    std::vector<FunctionDescriptor> async_functions)
+    : program_(program),
+      activation_(activation),
+      value_factory_(value_factory) {
+  functions_.reserve(async_functions.size());
+  for (auto& descriptor : async_functions) {
+    functions_.push_back(
+        std::make_unique<PendingFunction>(*this, std::move(descriptor)));
+  }
+}
+
+AsyncEvaluation::~AsyncEvaluation() = default;
+
+absl::StatusOr<absl::Span<const PendingCall>> AsyncEvaluation::Evaluate() {
+  pending_.clear();
+  pending_keys_.clear();
+  pending_key_set_.clear();
+  ++passes_;
+
+  PassActivation activation(*this);
+  CEL_ASSIGN_OR_RETURN(Value result,
+                       program_.Evaluate(activation, value_factory_));
+  // Pending calls can only affect the result through an unknown value.
+  if (!pending_.empty() && result->Is<UnknownValue>()) {
+    return absl::MakeConstSpan(pending_);
+  }
+  pending_.clear();
+  pending_keys_.clear();
+  pending_key_set_.clear();
+  result_ = std::move(result);
+  return absl::Span<const PendingCall>();
+}
+
+void AsyncEvaluation::Resolve(size_t index, Value result) {
+  ABSL_CHECK_LT(index, pending_keys_.size());  // Crash OK
+  resolved_.insert_or_assign(pending_keys_[index], std::move(result));
+}
+
+Value AsyncEvaluation::Call(const FunctionDescriptor& descriptor,
+                            absl::Span<const Value> args) {
+  absl::optional<std::string> key = FunctionMemoizer::MakeKey(descriptor, args);
+  if (!key.has_value()) {
+    return value_factory_.CreateErrorValue(absl::InvalidArgumentError(
+        absl::StrCat("asynchronous function '", descriptor.name(),
+                     "' called with arguments of unsupported kinds")));
+  }
+  if (auto it = resolved_.find(*key); it != resolved_.end()) {
+    return it->second;
+  }
+  if (pending_key_set_.insert(*key).second) {
+    pending_.push_back(
+        PendingCall{descriptor, std::vector<Value>(args.begin(), args.end())});
+    pending_keys_.push_back(*std::move(key));
+  }
+  return value_factory_.CreateUnknownValue(
+      FunctionResultSet(FunctionResult(descriptor, /*expr_id=*/0)));
+}
+
+}  // namespace cel
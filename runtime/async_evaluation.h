@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_ASYNC_EVALUATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_ASYNC_EVALUATION_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "base/function.h"
+#include "base/function_descriptor.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/activation_interface.h"
+#include "runtime/function_registry.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+// Registers `descriptor` as a function implemented by AsyncEvaluation, such
+// as one backed by a remote lookup.
+absl::Status RegisterAsyncFunction(FunctionRegistry& registry,
+                                   const FunctionDescriptor& descriptor);
+
+// A call to an asynchronous function, which an evaluation is waiting for.
+struct PendingCall {
+  // The called overload.
+  FunctionDescriptor descriptor;
+  // The arguments, valid for the lifetime of the evaluation's value factory.
+  std::vector<Value> args;
+};
+
+// Evaluates a program calling asynchronous functions (see
+// RegisterAsyncFunction) without blocking a thread while their results are
+// computed.
+//
+// Each pass of the evaluation runs the program. A call to an asynchronous
+// function whose result isn't known yet is recorded as pending and results in
+// an unknown value, and the pass carries on with the rest of the program so
+// that all the independent calls are collected in the same batch. If the
+// result depends on pending calls, Evaluate returns them, and the caller
+// resolves the batch on any thread (e.g. with a single remote lookup), records
+// the results with Resolve and runs another pass. Calls which don't affect the
+// result, such as those short-circuited by a logical operator, aren't
+// returned.
+//
+// A pass doesn't suspend the evaluator state: the next pass runs the program
+// from the start, serving the calls resolved so far from the recorded
+// results. As CEL expressions are side effect free, this replays the earlier
+// passes up to the calls that were pending. Calls whose arguments depend on
+// other pending calls are returned by later passes.
+//
+// Asynchronous functions may only be called with arguments of primitive
+// kinds (null, bool, int, uint, double, string, bytes, timestamp and
+// duration). The runtime must be built with unknown processing enabled (see
+// RuntimeOptions::unknown_processing), so that pending results propagate as
+// unknowns.
+//
+// Not thread safe, but passes may run on different threads.
+class AsyncEvaluation final {
+ public:
+  // `program`, `activation` and `value_factory` must outlive the evaluation.
+  // `async_functions` are the descriptors registered with
+  // RegisterAsyncFunction.
+  AsyncEvaluation(const Program& program, const ActivationInterface& activation,
+                  ValueManager& value_factory,
+                  std::vector<FunctionDescriptor> async_functions);
+
+  ~AsyncEvaluation();
+
+  AsyncEvaluation(const AsyncEvaluation&) = delete;
+  AsyncEvaluation& operator=(const AsyncEvaluation&) = delete;
+
+  // Runs a pass of the evaluation. Returns the pending calls which the result
+  // depends on, or an empty span once the evaluation is complete and result()
+  // is set.
+  absl::StatusOr<absl::Span<const PendingCall>> Evaluate();
+
+  // Records the result of the `index`th pending call returned by the last
+  // pass. An ErrorValue is handled as if the function returned it.
+  void Resolve(size_t index, Value result);
+
+  // The result of the completed evaluation.
+  const Value& result() const { return result_; }
+
+  // The number of passes run so far.
+  int passes() const { return passes_; }
+
+ private:
+  class PendingFunction;
+  class PassActivation;
+
+  // Returns the result of the call of `descriptor` with `args` if it was
+  // resolved, otherwise records it as pending and returns an unknown value.
+  Value Call(const FunctionDescriptor& descriptor,
+             absl::Span<const Value> args);
+
+  const Program& program_;
+  const ActivationInterface& activation_;
+  ValueManager& value_factory_;
+  std::vector<std::unique_ptr<PendingFunction>> functions_;
+  // Results of the resolved calls, keyed by call.
+  absl::flat_hash_map<std::string, Value> resolved_;
+  // The pending calls of the last pass, and their keys.
+  std::vector<PendingCall> pending_;
+  std::vector<std::string> pending_keys_;
+  absl::flat_hash_set<std::string> pending_key_set_;
+  Value result_;
+  int passes_ = 0;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_ASYNC_EVALUATION_H_
@@ -0,0 +1,180 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/async_evaluation.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/function_descriptor.h"
+#include "common/kind.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::ProtobufRuntimeAdapter;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::ElementsAre;
+using testing::SizeIs;
+
+FunctionDescriptor IsMemberDescriptor() {
+  return FunctionDescriptor("is_member", /*receiver_style=*/false,
+                            {Kind::kString, Kind::kString});
+}
+
+FunctionDescriptor ManagerDescriptor() {
+  return FunctionDescriptor("manager", /*receiver_style=*/false,
+                            {Kind::kString});
+}
+
+std::vector<std::string> CallStrings(absl::Span<const PendingCall> calls) {
+  std::vector<std::string> strings;
+  for (const auto& call : calls) {
+    std::string call_string = call.descriptor.name();
+    for (const auto& arg : call.args) {
+      absl::StrAppend(&call_string, " ", arg.As<StringValue>().ToString());
+    }
+    strings.push_back(std::move(call_string));
+  }
+  return strings;
+}
+
+class AsyncEvaluationTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    RuntimeOptions options;
+    options.unknown_processing = UnknownProcessingOptions::kAttributeOnly;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK(RegisterAsyncFunction(builder.function_registry(),
+                                    IsMemberDescriptor()));
+    ASSERT_OK(RegisterAsyncFunction(builder.function_registry(),
+                                    ManagerDescriptor()));
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+    activation_.InsertOrAssignValue("user", StringValue("alice"));
+    activation_.InsertOrAssignValue("enabled", BoolValue(true));
+  }
+
+  std::unique_ptr<AsyncEvaluation> StartEvaluation(
+      absl::string_view expression) {
+    auto parsed_expr = Parse(expression);
+    EXPECT_OK(parsed_expr);
+    auto program =
+        ProtobufRuntimeAdapter::CreateProgram(*runtime_, *parsed_expr);
+    EXPECT_OK(program);
+    program_ = *std::move(program);
+    value_factory_ = std::make_unique<ManagedValueFactory>(
+        program_->GetTypeProvider(), MemoryManagerRef::ReferenceCounting());
+    return std::make_unique<AsyncEvaluation>(
+        *program_, activation_, value_factory_->get(),
+        std::vector<FunctionDescriptor>{IsMemberDescriptor(),
+                                        ManagerDescriptor()});
+  }
+
+  std::unique_ptr<const Runtime> runtime_;
+  std::unique_ptr<Program> program_;
+  Activation activation_;
+  std::unique_ptr<ManagedValueFactory> value_factory_;
+};
+
+TEST_F(AsyncEvaluationTest, BatchesIndependentCalls) {
+  auto evaluation = StartEvaluation(
+      "is_member(user, 'admins') || is_member(user, 'owners')");
+
+  ASSERT_OK_AND_ASSIGN(auto pending, evaluation->Evaluate());
+  EXPECT_THAT(CallStrings(pending),
+              ElementsAre("is_member alice admins", "is_member alice owners"));
+  evaluation->Resolve(0, BoolValue(false));
+  evaluation->Resolve(1, BoolValue(true));
+
+  ASSERT_OK_AND_ASSIGN(pending, evaluation->Evaluate());
+  EXPECT_THAT(pending, SizeIs(0));
+  ASSERT_TRUE(evaluation->result().Is<BoolValue>());
+  EXPECT_TRUE(evaluation->result().As<BoolValue>().NativeValue());
+  EXPECT_EQ(evaluation->passes(), 2);
+}
+
+TEST_F(AsyncEvaluationTest, DedupesCalls) {
+  auto evaluation = StartEvaluation(
+      "is_member(user, 'admins') && (enabled || is_member(user, 'admins'))");
+
+  ASSERT_OK_AND_ASSIGN(auto pending, evaluation->Evaluate());
+  EXPECT_THAT(CallStrings(pending), ElementsAre("is_member alice admins"));
+  evaluation->Resolve(0, BoolValue(true));
+
+  ASSERT_OK_AND_ASSIGN(pending, evaluation->Evaluate());
+  EXPECT_THAT(pending, SizeIs(0));
+  EXPECT_TRUE(evaluation->result().As<BoolValue>().NativeValue());
+}
+
+TEST_F(AsyncEvaluationTest, DependentCallsResolvedInLaterPasses) {
+  auto evaluation = StartEvaluation("is_member(manager(user), 'admins')");
+
+  ASSERT_OK_AND_ASSIGN(auto pending, evaluation->Evaluate());
+  EXPECT_THAT(CallStrings(pending), ElementsAre("manager alice"));
+  evaluation->Resolve(0, StringValue("bob"));
+
+  ASSERT_OK_AND_ASSIGN(pending, evaluation->Evaluate());
+  EXPECT_THAT(CallStrings(pending), ElementsAre("is_member bob admins"));
+  evaluation->Resolve(0, BoolValue(true));
+
+  ASSERT_OK_AND_ASSIGN(pending, evaluation->Evaluate());
+  EXPECT_THAT(pending, SizeIs(0));
+  EXPECT_TRUE(evaluation->result().As<BoolValue>().NativeValue());
+  EXPECT_EQ(evaluation->passes(), 3);
+}
+
+TEST_F(AsyncEvaluationTest, SkipsCallsNotAffectingResult) {
+  auto evaluation =
+      StartEvaluation("!enabled && is_member(user, 'admins')");
+
+  ASSERT_OK_AND_ASSIGN(auto pending, evaluation->Evaluate());
+  EXPECT_THAT(pending, SizeIs(0));
+  ASSERT_TRUE(evaluation->result().Is<BoolValue>());
+  EXPECT_FALSE(evaluation->result().As<BoolValue>().NativeValue());
+}
+
+TEST_F(AsyncEvaluationTest, ResolvedErrorsPropagate) {
+  auto evaluation = StartEvaluation("is_member(user, 'admins')");
+
+  ASSERT_OK_AND_ASSIGN(auto pending, evaluation->Evaluate());
+  ASSERT_THAT(pending, SizeIs(1));
+  evaluation->Resolve(0, ErrorValue(absl::UnavailableError("lookup failed")));
+
+  ASSERT_OK_AND_ASSIGN(pending, evaluation->Evaluate());
+  EXPECT_THAT(pending, SizeIs(0));
+  ASSERT_TRUE(evaluation->result().Is<ErrorValue>());
+  EXPECT_EQ(evaluation->result().As<ErrorValue>().NativeValue().message(),
+            "lookup failed");
+}
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,47 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_CANCELLATION_TOKEN_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_CANCELLATION_TOKEN_H_
+
+#include <atomic>
+
+namespace cel {
+
+// Token for cancelling evaluations from another thread.
+//
+// Evaluations using an activation which returns the token from
+// ActivationInterface::GetCancellationToken fail with a cancelled error soon
+// after Cancel is called. Cancellation is checked periodically, not on every
+// evaluation step, so short evaluations may still complete.
+//
+// Thread-safe.
+class CancellationToken final {
+ public:
+  CancellationToken() = default;
+
+  CancellationToken(const CancellationToken&) = delete;
+  CancellationToken& operator=(const CancellationToken&) = delete;
+
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<bool> cancelled_{false};
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_CANCELLATION_TOKEN_H_
@@ -0,0 +1,1142 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "runtime/columnar_evaluation.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "base/builtins.h"
+#include "common/kind.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "internal/overflow.h"
+#include "internal/status_macros.h"
+#include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Expr;
+using ::cel::ast_internal::PrimitiveType;
+using ::cel::ast_internal::Reference;
+
+enum class ColumnarOp {
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kDivide,
+  kModulo,
+  kEqual,
+  kNotEqual,
+  kLess,
+  kLessOrEqual,
+  kGreater,
+  kGreaterOrEqual,
+};
+
+bool IsComparison(ColumnarOp op) {
+  switch (op) {
+    case ColumnarOp::kAdd:
+    case ColumnarOp::kSubtract:
+    case ColumnarOp::kMultiply:
+    case ColumnarOp::kDivide:
+    case ColumnarOp::kModulo:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// A standard overload of an arithmetic or ordering function.
+struct ColumnarOverload {
+  absl::string_view overload_id;
+  absl::string_view function;
+  ColumnarOp op;
+  // Kind of both operands.
+  Kind kind;
+};
+
+constexpr ColumnarOverload kColumnarOverloads[] = {
+    {"add_int64", builtin::kAdd, ColumnarOp::kAdd, Kind::kInt},
+    {"add_uint64", builtin::kAdd, ColumnarOp::kAdd, Kind::kUint},
+    {"add_double", builtin::kAdd, ColumnarOp::kAdd, Kind::kDouble},
+    {"subtract_int64", builtin::kSubtract, ColumnarOp::kSubtract, Kind::kInt},
+    {"subtract_uint64", builtin::kSubtract, ColumnarOp::kSubtract,
+     Kind::kUint},
+    {"subtract_double", builtin::kSubtract, ColumnarOp::kSubtract,
+     Kind::kDouble},
+    {"multiply_int64", builtin::kMultiply, ColumnarOp::kMultiply, Kind::kInt},
+    {"multiply_uint64", builtin::kMultiply, ColumnarOp::kMultiply,
+     Kind::kUint},
+    {"multiply_double", builtin::kMultiply, ColumnarOp::kMultiply,
+     Kind::kDouble},
+    {"divide_int64", builtin::kDivide, ColumnarOp::kDivide, Kind::kInt},
+    {"divide_uint64", builtin::kDivide, ColumnarOp::kDivide, Kind::kUint},
+    {"divide_double", builtin::kDivide, ColumnarOp::kDivide, Kind::kDouble},
+    {"modulo_int64", builtin::kModulo, ColumnarOp::kModulo, Kind::kInt},
+    {"modulo_uint64", builtin::kModulo, ColumnarOp::kModulo, Kind::kUint},
+    {"less_bool", builtin::kLess, ColumnarOp::kLess, Kind::kBool},
+    {"less_int64", builtin::kLess, ColumnarOp::kLess, Kind::kInt},
+    {"less_uint64", builtin::kLess, ColumnarOp::kLess, Kind::kUint},
+    {"less_double", builtin::kLess, ColumnarOp::kLess, Kind::kDouble},
+    {"less_string", builtin::kLess, ColumnarOp::kLess, Kind::kString},
+    {"less_equals_bool", builtin::kLessOrEqual, ColumnarOp::kLessOrEqual,
+     Kind::kBool},
+    {"less_equals_int64", builtin::kLessOrEqual, ColumnarOp::kLessOrEqual,
+     Kind::kInt},
+    {"less_equals_uint64", builtin::kLessOrEqual, ColumnarOp::kLessOrEqual,
+     Kind::kUint},
+    {"less_equals_double", builtin::kLessOrEqual, ColumnarOp::kLessOrEqual,
+     Kind::kDouble},
+    {"less_equals_string", builtin::kLessOrEqual, ColumnarOp::kLessOrEqual,
+     Kind::kString},
+    {"greater_bool", builtin::kGreater, ColumnarOp::kGreater, Kind::kBool},
+    {"greater_int64", builtin::kGreater, ColumnarOp::kGreater, Kind::kInt},
+    {"greater_uint64", builtin::kGreater, ColumnarOp::kGreater, Kind::kUint},
+    {"greater_double", builtin::kGreater, ColumnarOp::kGreater,
+     Kind::kDouble},
+    {"greater_string", builtin::kGreater, ColumnarOp::kGreater,
+     Kind::kString},
+    {"greater_equals_bool", builtin::kGreaterOrEqual,
+     ColumnarOp::kGreaterOrEqual, Kind::kBool},
+    {"greater_equals_int64", builtin::kGreaterOrEqual,
+     ColumnarOp::kGreaterOrEqual, Kind::kInt},
+    {"greater_equals_uint64", builtin::kGreaterOrEqual,
+     ColumnarOp::kGreaterOrEqual, Kind::kUint},
+    {"greater_equals_double", builtin::kGreaterOrEqual,
+     ColumnarOp::kGreaterOrEqual, Kind::kDouble},
+    {"greater_equals_string", builtin::kGreaterOrEqual,
+     ColumnarOp::kGreaterOrEqual, Kind::kString},
+};
+
+bool IsColumnarKind(Kind kind) {
+  switch (kind) {
+    case Kind::kBool:
+    case Kind::kInt:
+    case Kind::kUint:
+    case Kind::kDouble:
+    case Kind::kString:
+      return true;
+    default:
+      return false;
+  }
+}
+
+absl::optional<Kind> CheckedKind(const AstImpl& ast, const Expr& expr) {
+  const ast_internal::Type& type = ast.GetType(expr.id());
+  if (!type.has_primitive()) {
+    return absl::nullopt;
+  }
+  switch (type.primitive()) {
+    case PrimitiveType::kBool:
+      return Kind::kBool;
+    case PrimitiveType::kInt64:
+      return Kind::kInt;
+    case PrimitiveType::kUint64:
+      return Kind::kUint;
+    case PrimitiveType::kDouble:
+      return Kind::kDouble;
+    case PrimitiveType::kString:
+      return Kind::kString;
+    default:
+      return absl::nullopt;
+  }
+}
+
+// Binds the columns of a row to their variables, looking up anything else in
+// the activation of the batch.
+class RowActivation final : public ActivationInterface {
+ public:
+  RowActivation(const RecordBatchView& batch,
+                const ActivationInterface& activation)
+      : batch_(batch), activation_(activation) {}
+
+  using ActivationInterface::FindVariable;
+
+  void set_row(size_t row) { row_ = row; }
+
+  absl::StatusOr<absl::optional<ValueView>> FindVariable(
+      ValueManager& factory, absl::string_view name,
+      Value& scratch) const override {
+    if (const ColumnView* column = batch_.FindColumn(name);
+        column != nullptr) {
+      scratch = column->GetValue(row_);
+      return ValueView(scratch);
+    }
+    return activation_.FindVariable(factory, name, scratch);
+  }
+
+  std::vector<FunctionOverloadReference> FindFunctionOverloads(
+      absl::string_view name) const override {
+    return activation_.FindFunctionOverloads(name);
+  }
+
+  absl::Span<const AttributePattern> GetUnknownAttributes() const override {
+    return activation_.GetUnknownAttributes();
+  }
+
+  absl::Span<const AttributePattern> GetMissingAttributes() const override {
+    return activation_.GetMissingAttributes();
+  }
+
+  absl::Time GetDeadline() const override {
+    return activation_.GetDeadline();
+  }
+
+  absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const override {
+    return activation_.GetCancellationToken();
+  }
+
+ private:
+  const RecordBatchView& batch_;
+  const ActivationInterface& activation_;
+  size_t row_ = 0;
+};
+
+// Values of a node for the rows of a chunk, in the vector of the node's kind.
+// Only the rows selected when evaluating the node are set.
+struct ChunkValues {
+  // Set for the rows which the program of the whole expression must
+  // evaluate.
+  std::vector<uint8_t> failed;
+  std::vector<uint8_t> bools;
+  std::vector<int64_t> ints;
+  std::vector<uint64_t> uints;
+  std::vector<double> doubles;
+  std::vector<absl::string_view> strings;
+  // Storage of the strings which aren't columns or constants.
+  std::vector<std::string> owned_strings;
+};
+
+template <typename T>
+std::vector<T>& ValuesOf(ChunkValues& values);
+
+template <>
+std::vector<uint8_t>& ValuesOf(ChunkValues& values) {
+  return values.bools;
+}
+
+template <>
+std::vector<int64_t>& ValuesOf(ChunkValues& values) {
+  return values.ints;
+}
+
+template <>
+std::vector<uint64_t>& ValuesOf(ChunkValues& values) {
+  return values.uints;
+}
+
+template <>
+std::vector<double>& ValuesOf(ChunkValues& values) {
+  return values.doubles;
+}
+
+template <>
+std::vector<absl::string_view>& ValuesOf(ChunkValues& values) {
+  return values.strings;
+}
+
+// Rows of a chunk to evaluate: the first `size` rows if dense, otherwise
+// `rows`.
+struct Selection {
+  bool dense = true;
+  size_t size = 0;
+  std::vector<uint32_t> rows;
+};
+
+// Dense selections are visited with a plain loop over the rows, which the
+// compiler vectorizes for the simple operations.
+template <typename F>
+void ForEachSelected(const Selection& selection, F f) {
+  if (selection.dense) {
+    for (size_t i = 0; i < selection.size; ++i) {
+      f(i);
+    }
+  } else {
+    for (uint32_t i : selection.rows) {
+      f(i);
+    }
+  }
+}
+
+// Sets the result of `op` on the values of `lhs` and `rhs` for the selected
+// rows, `op` returning false if the standard overload results in an error.
+template <typename T, typename R, typename Op>
+void ApplyBinary(const Selection& selection, ChunkValues& lhs,
+                 ChunkValues& rhs, ChunkValues& out, Op op) {
+  const T* lhs_values = ValuesOf<T>(lhs).data();
+  const T* rhs_values = ValuesOf<T>(rhs).data();
+  R* out_values = ValuesOf<R>(out).data();
+  const uint8_t* lhs_failed = lhs.failed.data();
+  const uint8_t* rhs_failed = rhs.failed.data();
+  uint8_t* out_failed = out.failed.data();
+  ForEachSelected(selection, [&](size_t i) {
+    bool ok = op(lhs_values[i], rhs_values[i], out_values[i]);
+    out_failed[i] = lhs_failed[i] | rhs_failed[i] | !ok;
+  });
+}
+
+template <typename T>
+bool SetIfOk(absl::StatusOr<T> result, T& out) {
+  if (!result.ok()) {
+    return false;
+  }
+  out = *result;
+  return true;
+}
+
+struct AddOp {
+  template <typename T>
+  bool operator()(T x, T y, T& out) const {
+#if ABSL_HAVE_BUILTIN(__builtin_add_overflow)
+    return !__builtin_add_overflow(x, y, &out);
+#else
+    return SetIfOk(cel::internal::CheckedAdd(x, y), out);
+#endif
+  }
+
+  bool operator()(double x, double y, double& out) const {
+    out = x + y;
+    return true;
+  }
+};
+
+struct SubtractOp {
+  template <typename T>
+  bool operator()(T x, T y, T& out) const {
+#if ABSL_HAVE_BUILTIN(__builtin_sub_overflow)
+    return !__builtin_sub_overflow(x, y, &out);
+#else
+    return SetIfOk(cel::internal::CheckedSub(x, y), out);
+#endif
+  }
+
+  bool operator()(double x, double y, double& out) const {
+    out = x - y;
+    return true;
+  }
+};
+
+struct MultiplyOp {
+  template <typename T>
+  bool operator()(T x, T y, T& out) const {
+#if ABSL_HAVE_BUILTIN(__builtin_mul_overflow)
+    return !__builtin_mul_overflow(x, y, &out);
+#else
+    return SetIfOk(cel::internal::CheckedMul(x, y), out);
+#endif
+  }
+
+  bool operator()(double x, double y, double& out) const {
+    out = x * y;
+    return true;
+  }
+};
+
+struct DivideOp {
+  template <typename T>
+  bool operator()(T x, T y, T& out) const {
+    return SetIfOk(cel::internal::CheckedDiv(x, y), out);
+  }
+
+  bool operator()(double x, double y, double& out) const {
+    out = x / y;
+    return true;
+  }
+};
+
+struct ModuloOp {
+  template <typename T>
+  bool operator()(T x, T y, T& out) const {
+    return SetIfOk(cel::internal::CheckedMod(x, y), out);
+  }
+};
+
+template <typename T>
+void ApplyArithmetic(ColumnarOp op, const Selection& selection,
+                     ChunkValues& lhs, ChunkValues& rhs, ChunkValues& out) {
+  switch (op) {
+    case ColumnarOp::kAdd:
+      return ApplyBinary<T, T>(selection, lhs, rhs, out, AddOp());
+    case ColumnarOp::kSubtract:
+      return ApplyBinary<T, T>(selection, lhs, rhs, out, SubtractOp());
+    case ColumnarOp::kMultiply:
+      return ApplyBinary<T, T>(selection, lhs, rhs, out, MultiplyOp());
+    case ColumnarOp::kDivide:
+      return ApplyBinary<T, T>(selection, lhs, rhs, out, DivideOp());
+    default:
+      if constexpr (!std::is_same_v<T, double>) {
+        return ApplyBinary<T, T>(selection, lhs, rhs, out, ModuloOp());
+      }
+  }
+}
+
+template <typename T>
+void ApplyComparison(ColumnarOp op, const Selection& selection,
+                     ChunkValues& lhs, ChunkValues& rhs, ChunkValues& out) {
+  switch (op) {
+    case ColumnarOp::kEqual:
+      return ApplyBinary<T, uint8_t>(selection, lhs, rhs, out,
+                                     [](T x, T y, uint8_t& result) {
+                                       result = x == y;
+                                       return true;
+                                     });
+    case ColumnarOp::kNotEqual:
+      return ApplyBinary<T, uint8_t>(selection, lhs, rhs, out,
+                                     [](T x, T y, uint8_t& result) {
+                                       result = x != y;
+                                       return true;
+                                     });
+    case ColumnarOp::kLess:
+      return ApplyBinary<T, uint8_t>(selection, lhs, rhs, out,
+                                     [](T x, T y, uint8_t& result) {
+                                       result = x < y;
+                                       return true;
+                                     });
+    case ColumnarOp::kLessOrEqual:
+      return ApplyBinary<T, uint8_t>(selection, lhs, rhs, out,
+                                     [](T x, T y, uint8_t& result) {
+                                       result = x <= y;
+                                       return true;
+                                     });
+    case ColumnarOp::kGreater:
+      return ApplyBinary<T, uint8_t>(selection, lhs, rhs, out,
+                                     [](T x, T y, uint8_t& result) {
+                                       result = x > y;
+                                       return true;
+                                     });
+    default:
+      return ApplyBinary<T, uint8_t>(selection, lhs, rhs, out,
+                                     [](T x, T y, uint8_t& result) {
+                                       result = x >= y;
+                                       return true;
+                                     });
+  }
+}
+
+// Sets the selected rows of `values`, of `kind`, from `value` if it has that
+// kind. Otherwise the rows fail.
+void Broadcast(const Value& value, Kind kind, const Selection& selection,
+               ChunkValues& values) {
+  if (value.kind() != kind) {
+    ForEachSelected(selection, [&](size_t i) { values.failed[i] = 1; });
+    return;
+  }
+  switch (kind) {
+    case Kind::kBool: {
+      uint8_t native = value.As<BoolValue>().NativeValue();
+      ForEachSelected(selection, [&](size_t i) { values.bools[i] = native; });
+      break;
+    }
+    case Kind::kInt: {
+      int64_t native = value.As<IntValue>().NativeValue();
+      ForEachSelected(selection, [&](size_t i) { values.ints[i] = native; });
+      break;
+    }
+    case Kind::kUint: {
+      uint64_t native = value.As<UintValue>().NativeValue();
+      ForEachSelected(selection, [&](size_t i) { values.uints[i] = native; });
+      break;
+    }
+    case Kind::kDouble: {
+      double native = value.As<DoubleValue>().NativeValue();
+      ForEachSelected(selection,
+                      [&](size_t i) { values.doubles[i] = native; });
+      break;
+    }
+    default: {
+      // Rows share the first owned string.
+      values.owned_strings[0] = value.As<StringValue>().NativeString();
+      absl::string_view native = values.owned_strings[0];
+      ForEachSelected(selection,
+                      [&](size_t i) { values.strings[i] = native; });
+      break;
+    }
+  }
+  ForEachSelected(selection, [&](size_t i) { values.failed[i] = 0; });
+}
+
+// Sets the value of a single row from the result of a program, which fails
+// if it doesn't have `kind`.
+void SetRow(const Value& value, Kind kind, size_t i, ChunkValues& values) {
+  if (value.kind() != kind) {
+    values.failed[i] = 1;
+    return;
+  }
+  values.failed[i] = 0;
+  switch (kind) {
+    case Kind::kBool:
+      values.bools[i] = value.As<BoolValue>().NativeValue();
+      break;
+    case Kind::kInt:
+      values.ints[i] = value.As<IntValue>().NativeValue();
+      break;
+    case Kind::kUint:
+      values.uints[i] = value.As<UintValue>().NativeValue();
+      break;
+    case Kind::kDouble:
+      values.doubles[i] = value.As<DoubleValue>().NativeValue();
+      break;
+    default:
+      values.owned_strings[i] = value.As<StringValue>().NativeString();
+      values.strings[i] = values.owned_strings[i];
+      break;
+  }
+}
+
+// Returns the value of row `i`. Strings are copied, as `values` borrows from
+// buffers reused for the next chunk and from the batch.
+Value GetRow(ValueManager& value_manager, ChunkValues& values, Kind kind,
+             size_t i) {
+  switch (kind) {
+    case Kind::kBool:
+      return BoolValue(values.bools[i] != 0);
+    case Kind::kInt:
+      return IntValue(values.ints[i]);
+    case Kind::kUint:
+      return UintValue(values.uints[i]);
+    case Kind::kDouble:
+      return DoubleValue(values.doubles[i]);
+    default:
+      return value_manager.CreateUncheckedStringValue(
+          std::string(values.strings[i]));
+  }
+}
+
+}  // namespace
+
+Value ColumnView::GetValue(size_t row) const {
+  if (!IsValid(row)) {
+    return NullValue();
+  }
+  switch (kind_) {
+    case Kind::kBool:
+      return BoolValue(bool_values_[row]);
+    case Kind::kInt:
+      return IntValue(int_values_[row]);
+    case Kind::kUint:
+      return UintValue(uint_values_[row]);
+    case Kind::kDouble:
+      return DoubleValue(double_values_[row]);
+    default:
+      return StringValue(std::string(string_value(row)));
+  }
+}
+
+ColumnView ColumnView::Bool(absl::Span<const bool> values,
+                            absl::Span<const uint8_t> validity) {
+  ColumnView column(Kind::kBool, values.size(), validity);
+  column.bool_values_ = values;
+  return column;
+}
+
+ColumnView ColumnView::Int(absl::Span<const int64_t> values,
+                           absl::Span<const uint8_t> validity) {
+  ColumnView column(Kind::kInt, values.size(), validity);
+  column.int_values_ = values;
+  return column;
+}
+
+ColumnView ColumnView::Uint(absl::Span<const uint64_t> values,
+                            absl::Span<const uint8_t> validity) {
+  ColumnView column(Kind::kUint, values.size(), validity);
+  column.uint_values_ = values;
+  return column;
+}
+
+ColumnView ColumnView::Double(absl::Span<const double> values,
+                              absl::Span<const uint8_t> validity) {
+  ColumnView column(Kind::kDouble, values.size(), validity);
+  column.double_values_ = values;
+  return column;
+}
+
+ColumnView ColumnView::String(absl::Span<const int32_t> offsets,
+                              absl::string_view data,
+                              absl::Span<const uint8_t> validity) {
+  ColumnView column(Kind::kString, offsets.empty() ? 0 : offsets.size() - 1,
+                    validity);
+  column.string_offsets_ = offsets;
+  column.string_data_ = data;
+  return column;
+}
+
+absl::Status RecordBatchView::AddColumn(absl::string_view name,
+                                        ColumnView column) {
+  if (column.size() != num_rows_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("column '", name, "' has ", column.size(),
+                     " rows, expected ", num_rows_));
+  }
+  if (!columns_.insert({std::string(name), column}).second) {
+    return absl::AlreadyExistsError(
+        absl::StrCat("column '", name, "' already added"));
+  }
+  return absl::OkStatus();
+}
+
+absl::Nullable<const ColumnView*> RecordBatchView::FindColumn(
+    absl::string_view name) const {
+  auto it = columns_.find(name);
+  if (it == columns_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+struct ColumnarProgram::Node {
+  enum class Type {
+    // The column bound to `name`, or the value of the variable in the
+    // activation if the batch has no such column.
+    kColumn,
+    kConstant,
+    // The subexpression planned as `program`, evaluated once per row.
+    kRow,
+    // `op` applied to the nodes `lhs` and `rhs`, both of `operand_kind`.
+    kOperation,
+    // Short-circuiting logical and / or of the nodes `lhs` and `rhs`.
+    kAnd,
+    kOr,
+    // Logical negation of the node `lhs`.
+    kNot,
+  };
+
+  Type type;
+  // Kind of the node's result, one of kBool, kInt, kUint, kDouble or
+  // kString.
+  Kind kind;
+  ColumnarOp op = ColumnarOp::kAdd;
+  Kind operand_kind = Kind::kAny;
+  // Indices of the operand nodes, which precede this node.
+  size_t lhs = 0;
+  size_t rhs = 0;
+  std::string name;
+  Value constant;
+  std::unique_ptr<Program> program;
+};
+
+// Lowers the checked subexpressions of an AST to the nodes of a columnar
+// program.
+class ColumnarProgram::Lowering {
+ public:
+  Lowering(const Runtime& runtime, const AstImpl& ast,
+           std::vector<Node>& nodes)
+      : runtime_(runtime), ast_(ast), nodes_(nodes) {}
+
+  // Lowers `expr` to a node producing a value of `kind`, or of the kind of
+  // its operation if `kind` is absent. Returns the index of the node, if
+  // any.
+  absl::StatusOr<absl::optional<size_t>> Lower(const Expr& expr,
+                                               absl::optional<Kind> kind) {
+    size_t size = nodes_.size();
+    CEL_ASSIGN_OR_RETURN(absl::optional<size_t> node, LowerImpl(expr, kind));
+    if (!node.has_value()) {
+      // Drop the operands lowered before failing.
+      nodes_.resize(size);
+    }
+    return node;
+  }
+
+ private:
+  absl::StatusOr<absl::optional<size_t>> LowerImpl(const Expr& expr,
+                                                   absl::optional<Kind> kind) {
+    if (expr.has_const_expr()) {
+      Node node{Node::Type::kConstant, Kind::kAny};
+      const Constant& constant = expr.const_expr();
+      if (constant.has_bool_value()) {
+        node.constant = BoolValue(constant.bool_value());
+      } else if (constant.has_int_value()) {
+        node.constant = IntValue(constant.int_value());
+      } else if (constant.has_uint_value()) {
+        node.constant = UintValue(constant.uint_value());
+      } else if (constant.has_double_value()) {
+        node.constant = DoubleValue(constant.double_value());
+      } else if (constant.has_string_value()) {
+        node.constant = StringValue(constant.string_value());
+      } else {
+        return absl::nullopt;
+      }
+      node.kind = ValueKindToKind(node.constant.kind());
+      if (kind.has_value() && *kind != node.kind) {
+        return absl::nullopt;
+      }
+      return AddNode(std::move(node));
+    }
+
+    if (expr.has_ident_expr()) {
+      const Reference* reference = ast_.GetReference(expr.id());
+      if (reference != nullptr && reference->has_value()) {
+        return absl::nullopt;
+      }
+      // Dynamically typed variables are read as the kind of their use, rows
+      // of other kinds failing.
+      absl::optional<Kind> checked_kind = CheckedKind(ast_, expr);
+      if (!checked_kind.has_value()) {
+        checked_kind = kind;
+      }
+      if (!checked_kind.has_value() ||
+          (kind.has_value() && *kind != *checked_kind)) {
+        return absl::nullopt;
+      }
+      Node node{Node::Type::kColumn, *checked_kind};
+      node.name = reference != nullptr && !reference->name().empty()
+                      ? reference->name()
+                      : expr.ident_expr().name();
+      return AddNode(std::move(node));
+    }
+
+    if (!expr.has_call_expr() || expr.call_expr().has_target()) {
+      return absl::nullopt;
+    }
+    const auto& call = expr.call_expr();
+    const auto& args = call.args();
+    if (kind.has_value() && !IsColumnarKind(*kind)) {
+      return absl::nullopt;
+    }
+
+    if ((call.function() == builtin::kAnd || call.function() == builtin::kOr) &&
+        args.size() == 2) {
+      if (kind.has_value() && *kind != Kind::kBool) {
+        return absl::nullopt;
+      }
+      Node node{call.function() == builtin::kAnd ? Node::Type::kAnd
+                                                 : Node::Type::kOr,
+                Kind::kBool};
+      node.operand_kind = Kind::kBool;
+      return LowerOperands(args, std::move(node));
+    }
+    if (call.function() == builtin::kNot && args.size() == 1) {
+      if (kind.has_value() && *kind != Kind::kBool) {
+        return absl::nullopt;
+      }
+      Node node{Node::Type::kNot, Kind::kBool};
+      node.operand_kind = Kind::kBool;
+      return LowerOperands(args, std::move(node));
+    }
+
+    if (args.size() != 2) {
+      return absl::nullopt;
+    }
+    Node node{Node::Type::kOperation, Kind::kBool};
+    if (call.function() == builtin::kEqual ||
+        call.function() == builtin::kInequal) {
+      // Only homogeneous equality is lowered, heterogeneous equality across
+      // numeric kinds is left to the program.
+      absl::optional<Kind> lhs_kind = CheckedKind(ast_, args[0]);
+      if (!lhs_kind.has_value() || lhs_kind != CheckedKind(ast_, args[1])) {
+        return absl::nullopt;
+      }
+      node.op = call.function() == builtin::kEqual ? ColumnarOp::kEqual
+                                                   : ColumnarOp::kNotEqual;
+      node.operand_kind = *lhs_kind;
+    } else {
+      const ColumnarOverload* overload = FindOverload(expr);
+      if (overload == nullptr) {
+        return absl::nullopt;
+      }
+      node.op = overload->op;
+      node.operand_kind = overload->kind;
+      node.kind = IsComparison(overload->op) ? Kind::kBool : overload->kind;
+    }
+    if (kind.has_value() && *kind != node.kind) {
+      return absl::nullopt;
+    }
+    return LowerOperands(args, std::move(node));
+  }
+
+  const ColumnarOverload* FindOverload(const Expr& expr) const {
+    const Reference* reference = ast_.GetReference(expr.id());
+    if (reference == nullptr || reference->overload_id().size() != 1) {
+      return nullptr;
+    }
+    for (const ColumnarOverload& overload : kColumnarOverloads) {
+      if (overload.overload_id == reference->overload_id().front() &&
+          overload.function == expr.call_expr().function()) {
+        return &overload;
+      }
+    }
+    return nullptr;
+  }
+
+  // Lowers the operands of `node`, planning those which can't be lowered as
+  // programs evaluated per row.
+  absl::StatusOr<absl::optional<size_t>> LowerOperands(
+      const std::vector<Expr>& args, Node node) {
+    size_t operands[2] = {0, 0};
+    for (size_t i = 0; i < args.size(); ++i) {
+      path_.push_back(i);
+      CEL_ASSIGN_OR_RETURN(absl::optional<size_t> operand,
+                           Lower(args[i], node.operand_kind));
+      if (!operand.has_value()) {
+        CEL_ASSIGN_OR_RETURN(operand, AddRowNode(node.operand_kind));
+      }
+      path_.pop_back();
+      operands[i] = *operand;
+    }
+    node.lhs = operands[0];
+    node.rhs = operands[1];
+    return AddNode(std::move(node));
+  }
+
+  // Plans the subexpression at the current path as a program of its own.
+  absl::StatusOr<size_t> AddRowNode(Kind kind) {
+    std::unique_ptr<AstImpl> ast = ast_.DeepCopy();
+    Expr* expr = &ast->root_expr();
+    for (size_t i : path_) {
+      expr = &expr->mutable_call_expr().mutable_args()[i];
+    }
+    Expr subexpression = std::move(*expr);
+    ast->root_expr() = std::move(subexpression);
+    Node node{Node::Type::kRow, kind};
+    CEL_ASSIGN_OR_RETURN(node.program, runtime_.CreateProgram(std::move(ast)));
+    return AddNode(std::move(node));
+  }
+
+  size_t AddNode(Node node) {
+    nodes_.push_back(std::move(node));
+    return nodes_.size() - 1;
+  }
+
+  const Runtime& runtime_;
+  const AstImpl& ast_;
+  std::vector<Node>& nodes_;
+  // Indices of the call arguments leading from the root to the expression
+  // being lowered.
+  std::vector<size_t> path_;
+};
+
+class ColumnarProgram::Evaluator {
+ public:
+  Evaluator(const ColumnarProgram& program, const RecordBatchView& batch,
+            const ActivationInterface& activation, ValueManager& value_manager)
+      : program_(program),
+        batch_(batch),
+        activation_(activation),
+        row_activation_(batch, activation),
+        value_manager_(value_manager) {}
+
+  absl::StatusOr<std::vector<Value>> Evaluate() {
+    std::vector<Value> results(batch_.num_rows());
+    if (!program_.vectorized() ||
+        !activation_.GetUnknownAttributes().empty() ||
+        !activation_.GetMissingAttributes().empty()) {
+      for (size_t row = 0; row < results.size(); ++row) {
+        CEL_ASSIGN_OR_RETURN(results[row], EvaluateRow(row));
+      }
+      return results;
+    }
+
+    CEL_RETURN_IF_ERROR(Prepare());
+    const size_t root = program_.nodes_.size() - 1;
+    const Kind root_kind = program_.nodes_[root].kind;
+    ChunkValues& root_values = values_[root];
+    for (size_t begin = 0; begin < results.size();
+         begin += program_.chunk_size_) {
+      Selection selection;
+      selection.size = std::min(program_.chunk_size_, results.size() - begin);
+      CEL_RETURN_IF_ERROR(EvaluateNode(root, begin, selection));
+      for (size_t i = 0; i < selection.size; ++i) {
+        if (root_values.failed[i]) {
+          CEL_ASSIGN_OR_RETURN(results[begin + i], EvaluateRow(begin + i));
+        } else {
+          results[begin + i] =
+              GetRow(value_manager_, root_values, root_kind, i);
+        }
+      }
+    }
+    return results;
+  }
+
+ private:
+  absl::StatusOr<Value> EvaluateRow(size_t row) {
+    row_activation_.set_row(row);
+    return program_.program_->Evaluate(row_activation_, value_manager_);
+  }
+
+  // Allocates the values of the nodes for a chunk and binds the columns.
+  absl::Status Prepare() {
+    const std::vector<Node>& nodes = program_.nodes_;
+    const size_t chunk_size = program_.chunk_size_;
+    values_.resize(nodes.size());
+    columns_.resize(nodes.size(), nullptr);
+    variables_.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      const Node& node = nodes[i];
+      ChunkValues& values = values_[i];
+      values.failed.resize(chunk_size);
+      switch (node.kind) {
+        case Kind::kBool:
+          values.bools.resize(chunk_size);
+          break;
+        case Kind::kInt:
+          values.ints.resize(chunk_size);
+          break;
+        case Kind::kUint:
+          values.uints.resize(chunk_size);
+          break;
+        case Kind::kDouble:
+          values.doubles.resize(chunk_size);
+          break;
+        default:
+          values.strings.resize(chunk_size);
+          values.owned_strings.resize(chunk_size);
+          break;
+      }
+      if (node.type != Node::Type::kColumn) {
+        continue;
+      }
+      // Variables which aren't columns have the same value for all the rows.
+      columns_[i] = batch_.FindColumn(node.name);
+      if (columns_[i] == nullptr) {
+        CEL_ASSIGN_OR_RETURN(variables_[i], activation_.FindVariable(
+                                                value_manager_, node.name));
+        if (!variables_[i].has_value()) {
+          variables_[i] = NullValue();
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status EvaluateNode(size_t index, size_t begin,
+                            const Selection& selection) {
+    const Node& node = program_.nodes_[index];
+    ChunkValues& values = values_[index];
+    switch (node.type) {
+      case Node::Type::kColumn:
+        if (columns_[index] != nullptr) {
+          ReadColumn(*columns_[index], node.kind, begin, selection, values);
+        } else {
+          Broadcast(*variables_[index], node.kind, selection, values);
+        }
+        return absl::OkStatus();
+      case Node::Type::kConstant:
+        Broadcast(node.constant, node.kind, selection, values);
+        return absl::OkStatus();
+      case Node::Type::kRow: {
+        absl::Status status = absl::OkStatus();
+        ForEachSelected(selection, [&](size_t i) {
+          if (!status.ok()) {
+            return;
+          }
+          row_activation_.set_row(begin + i);
+          absl::StatusOr<Value> result =
+              node.program->Evaluate(row_activation_, value_manager_);
+          if (!result.ok()) {
+            status = std::move(result).status();
+            return;
+          }
+          SetRow(*result, node.kind, i, values);
+        });
+        return status;
+      }
+      case Node::Type::kNot: {
+        CEL_RETURN_IF_ERROR(EvaluateNode(node.lhs, begin, selection));
+        ChunkValues& operand = values_[node.lhs];
+        ForEachSelected(selection, [&](size_t i) {
+          values.bools[i] = !operand.bools[i];
+          values.failed[i] = operand.failed[i];
+        });
+        return absl::OkStatus();
+      }
+      case Node::Type::kAnd:
+      case Node::Type::kOr:
+        return EvaluateLogic(node, begin, selection, values);
+      case Node::Type::kOperation:
+        break;
+    }
+
+    CEL_RETURN_IF_ERROR(EvaluateNode(node.lhs, begin, selection));
+    CEL_RETURN_IF_ERROR(EvaluateNode(node.rhs, begin, selection));
+    ChunkValues& lhs = values_[node.lhs];
+    ChunkValues& rhs = values_[node.rhs];
+    if (!IsComparison(node.op)) {
+      switch (node.operand_kind) {
+        case Kind::kInt:
+          ApplyArithmetic<int64_t>(node.op, selection, lhs, rhs, values);
+          break;
+        case Kind::kUint:
+          ApplyArithmetic<uint64_t>(node.op, selection, lhs, rhs, values);
+          break;
+        default:
+          ApplyArithmetic<double>(node.op, selection, lhs, rhs, values);
+          break;
+      }
+      return absl::OkStatus();
+    }
+    switch (node.operand_kind) {
+      case Kind::kBool:
+        ApplyComparison<uint8_t>(node.op, selection, lhs, rhs, values);
+        break;
+      case Kind::kInt:
+        ApplyComparison<int64_t>(node.op, selection, lhs, rhs, values);
+        break;
+      case Kind::kUint:
+        ApplyComparison<uint64_t>(node.op, selection, lhs, rhs, values);
+        break;
+      case Kind::kDouble:
+        ApplyComparison<double>(node.op, selection, lhs, rhs, values);
+        break;
+      default:
+        ApplyComparison<absl::string_view>(node.op, selection, lhs, rhs,
+                                           values);
+        break;
+    }
+    return absl::OkStatus();
+  }
+
+  // The right operand is only evaluated for the rows whose left operand
+  // doesn't decide the result. As for the interpreted operators, a failing
+  // operand is absorbed if the other one decides the result.
+  absl::Status EvaluateLogic(const Node& node, size_t begin,
+                             const Selection& selection, ChunkValues& values) {
+    const uint8_t decisive = node.type == Node::Type::kOr;
+    CEL_RETURN_IF_ERROR(EvaluateNode(node.lhs, begin, selection));
+    ChunkValues& lhs = values_[node.lhs];
+    Selection undecided;
+    undecided.dense = false;
+    ForEachSelected(selection, [&](size_t i) {
+      if (!lhs.failed[i] && lhs.bools[i] == decisive) {
+        values.bools[i] = decisive;
+        values.failed[i] = 0;
+      } else {
+        undecided.rows.push_back(static_cast<uint32_t>(i));
+      }
+    });
+    if (undecided.rows.empty()) {
+      return absl::OkStatus();
+    }
+    CEL_RETURN_IF_ERROR(EvaluateNode(node.rhs, begin, undecided));
+    ChunkValues& rhs = values_[node.rhs];
+    for (uint32_t i : undecided.rows) {
+      if (!rhs.failed[i] && rhs.bools[i] == decisive) {
+        values.bools[i] = decisive;
+        values.failed[i] = 0;
+      } else {
+        values.bools[i] = !decisive;
+        values.failed[i] = lhs.failed[i] | rhs.failed[i];
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  static void ReadColumn(const ColumnView& column, Kind kind, size_t begin,
+                         const Selection& selection, ChunkValues& values) {
+    if (column.kind() != kind) {
+      ForEachSelected(selection, [&](size_t i) { values.failed[i] = 1; });
+      return;
+    }
+    switch (kind) {
+      case Kind::kBool: {
+        const bool* data = column.bool_values().data() + begin;
+        ForEachSelected(selection,
+                        [&](size_t i) { values.bools[i] = data[i]; });
+        break;
+      }
+      case Kind::kInt: {
+        const int64_t* data = column.int_values().data() + begin;
+        ForEachSelected(selection, [&](size_t i) { values.ints[i] = data[i]; });
+        break;
+      }
+      case Kind::kUint: {
+        const uint64_t* data = column.uint_values().data() + begin;
+        ForEachSelected(selection,
+                        [&](size_t i) { values.uints[i] = data[i]; });
+        break;
+      }
+      case Kind::kDouble: {
+        const double* data = column.double_values().data() + begin;
+        ForEachSelected(selection,
+                        [&](size_t i) { values.doubles[i] = data[i]; });
+        break;
+      }
+      default:
+        ForEachSelected(selection, [&](size_t i) {
+          values.strings[i] = column.string_value(begin + i);
+        });
+        break;
+    }
+    // Null rows are bound to null, which has no overload of any operation.
+    ForEachSelected(selection, [&](size_t i) {
+      values.failed[i] = !column.IsValid(begin + i);
+    });
+  }
+
+  const ColumnarProgram& program_;
+  const RecordBatchView& batch_;
+  const ActivationInterface& activation_;
+  RowActivation row_activation_;
+  ValueManager& value_manager_;
+  std::vector<ChunkValues> values_;
+  // The column of each column node, or the value of its variable otherwise.
+  std::vector<const ColumnView*> columns_;
+  std::vector<absl::optional<Value>> variables_;
+};
+
+ColumnarProgram::~ColumnarProgram() = default;
+
+absl::StatusOr<std::unique_ptr<ColumnarProgram>> ColumnarProgram::Create(
+    const Runtime& runtime, std::unique_ptr<Ast> ast, size_t chunk_size) {
+  if (ast == nullptr || !ast->IsChecked()) {
+    return absl::InvalidArgumentError(
+        "columnar programs require a checked expression");
+  }
+  std::unique_ptr<ColumnarProgram> program(new ColumnarProgram());
+  program->chunk_size_ = std::max<size_t>(chunk_size, 1);
+  const AstImpl& ast_impl = AstImpl::CastFromPublicAst(*ast);
+  CEL_ASSIGN_OR_RETURN(
+      absl::optional<size_t> root,
+      Lowering(runtime, ast_impl, program->nodes_)
+          .Lower(ast_impl.root_expr(), absl::nullopt));
+  if (!root.has_value()) {
+    program->nodes_.clear();
+  }
+  CEL_ASSIGN_OR_RETURN(program->program_,
+                       runtime.CreateProgram(std::move(ast)));
+  return program;
+}
+
+bool ColumnarProgram::vectorized() const { return !nodes_.empty(); }
+
+absl::StatusOr<std::vector<Value>> ColumnarProgram::Evaluate(
+    const RecordBatchView& batch, const ActivationInterface& activation,
+    ValueManager& value_manager) const {
+  return Evaluator(*this, batch, activation, value_manager).Evaluate();
+}
+
+}  // namespace cel
@@ -0,0 +1,182 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_COLUMNAR_EVALUATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_COLUMNAR_EVALUATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "common/kind.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/activation_interface.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+// A column of a record batch, in the Arrow layout. The data isn't owned.
+//
+// Values are stored contiguously, strings as the concatenation of the values
+// and the offsets of their bounds. The optional validity bitmap has a bit per
+// row, least significant bit first: rows whose bit is unset are null.
+class ColumnView final {
+ public:
+  static ColumnView Bool(absl::Span<const bool> values,
+                         absl::Span<const uint8_t> validity = {});
+  static ColumnView Int(absl::Span<const int64_t> values,
+                        absl::Span<const uint8_t> validity = {});
+  static ColumnView Uint(absl::Span<const uint64_t> values,
+                         absl::Span<const uint8_t> validity = {});
+  static ColumnView Double(absl::Span<const double> values,
+                           absl::Span<const uint8_t> validity = {});
+  // `offsets` has an entry more than there are rows: the value of row `i` is
+  // `data.substr(offsets[i], offsets[i + 1] - offsets[i])`.
+  static ColumnView String(absl::Span<const int32_t> offsets,
+                           absl::string_view data,
+                           absl::Span<const uint8_t> validity = {});
+
+  // One of kBool, kInt, kUint, kDouble or kString.
+  Kind kind() const { return kind_; }
+
+  size_t size() const { return size_; }
+
+  bool IsValid(size_t row) const {
+    return validity_.empty() || (validity_[row / 8] >> (row % 8)) & 1;
+  }
+
+  absl::Span<const bool> bool_values() const { return bool_values_; }
+  absl::Span<const int64_t> int_values() const { return int_values_; }
+  absl::Span<const uint64_t> uint_values() const { return uint_values_; }
+  absl::Span<const double> double_values() const { return double_values_; }
+
+  absl::string_view string_value(size_t row) const {
+    return string_data_.substr(
+        static_cast<size_t>(string_offsets_[row]),
+        static_cast<size_t>(string_offsets_[row + 1] - string_offsets_[row]));
+  }
+
+  // Returns the value of `row`, or a NullValue if the row is null. Strings
+  // are copied, so the value doesn't reference the column's data.
+  Value GetValue(size_t row) const;
+
+ private:
+  ColumnView(Kind kind, size_t size, absl::Span<const uint8_t> validity)
+      : kind_(kind), size_(size), validity_(validity) {}
+
+  Kind kind_;
+  size_t size_;
+  absl::Span<const uint8_t> validity_;
+  absl::Span<const bool> bool_values_;
+  absl::Span<const int64_t> int_values_;
+  absl::Span<const uint64_t> uint_values_;
+  absl::Span<const double> double_values_;
+  absl::Span<const int32_t> string_offsets_;
+  absl::string_view string_data_;
+};
+
+// A batch of rows, stored as columns of the same size bound to variables.
+class RecordBatchView final {
+ public:
+  explicit RecordBatchView(size_t num_rows) : num_rows_(num_rows) {}
+
+  // Binds `column` to the variable `name`. Fails if the name is already bound
+  // or `column` doesn't have a value per row.
+  absl::Status AddColumn(absl::string_view name, ColumnView column);
+
+  size_t num_rows() const { return num_rows_; }
+
+  absl::Nullable<const ColumnView*> FindColumn(absl::string_view name) const;
+
+ private:
+  size_t num_rows_;
+  absl::flat_hash_map<std::string, ColumnView> columns_;
+};
+
+// Evaluates a checked expression over record batches, instead of once per
+// row with an activation of its own.
+//
+// The subexpressions of the root which the type checker resolved to standard
+// arithmetic, ordering, equality and logic overloads on bool, int, uint,
+// double or string operands, along with columns and constants, are evaluated
+// a chunk of rows at a time, each operation as a loop over the contiguous
+// values of its operands. Logical and / or only evaluate their right operand
+// for the rows which the left one doesn't decide. Any other subexpression is
+// planned as a program of its own and evaluated once per row.
+//
+// Rows for which an operation fails (overflow, division by zero), an operand
+// is null or of an unexpected kind are evaluated again with the program of
+// the whole expression, so results are those of `Program::Evaluate` with the
+// row's columns bound to their variables. Columns of null rows are bound to
+// null.
+//
+// Only valid if the standard functions are registered and not replaced with
+// custom implementations.
+class ColumnarProgram final {
+ public:
+  static constexpr size_t kDefaultChunkSize = 1024;
+
+  // Plans `ast`, which must be checked, with `runtime`.
+  static absl::StatusOr<std::unique_ptr<ColumnarProgram>> Create(
+      const Runtime& runtime, std::unique_ptr<Ast> ast,
+      size_t chunk_size = kDefaultChunkSize);
+
+  ~ColumnarProgram();
+
+  ColumnarProgram(const ColumnarProgram&) = delete;
+  ColumnarProgram& operator=(const ColumnarProgram&) = delete;
+
+  // Evaluates the expression for each row of `batch`, returning the result of
+  // row `i` at index `i`.
+  //
+  // Variables which aren't columns of `batch`, and functions, are looked up
+  // in `activation`. If it has unknown or missing attribute patterns, every
+  // row is evaluated by the program of the whole expression, as columns are
+  // read without checking them.
+  absl::StatusOr<std::vector<Value>> Evaluate(
+      const RecordBatchView& batch, const ActivationInterface& activation,
+      ValueManager& value_manager) const;
+
+  // Whether any operation is evaluated a chunk at a time, rather than every
+  // row being evaluated by the program of the whole expression.
+  bool vectorized() const;
+
+  // The program of the whole expression.
+  const Program& program() const { return *program_; }
+
+ private:
+  struct Node;
+  class Lowering;
+  class Evaluator;
+
+  ColumnarProgram() = default;
+
+  std::unique_ptr<Program> program_;
+  // Operations precede the nodes using them, the root being the last one.
+  std::vector<Node> nodes_;
+  size_t chunk_size_ = kDefaultChunkSize;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_COLUMNAR_EVALUATION_H_
@@ -0,0 +1,353 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "runtime/columnar_evaluation.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::Type;
+using testing::ElementsAre;
+using testing::HasSubstr;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+
+using PrimitiveTypes = absl::flat_hash_map<std::string, Type::PrimitiveType>;
+
+absl::string_view OverloadSuffix(Type::PrimitiveType type) {
+  switch (type) {
+    case Type::BOOL:
+      return "bool";
+    case Type::INT64:
+      return "int64";
+    case Type::UINT64:
+      return "uint64";
+    case Type::DOUBLE:
+      return "double";
+    default:
+      return "string";
+  }
+}
+
+// Records the types of the variables and calls of `expr` in `checked_expr`,
+// and the overloads of its arithmetic and ordering calls, as the type checker
+// would. Returns the type of `expr`.
+Type::PrimitiveType Check(const google::api::expr::v1alpha1::Expr& expr,
+                          const PrimitiveTypes& variables,
+                          CheckedExpr& checked_expr) {
+  constexpr std::pair<absl::string_view, absl::string_view> kOverloads[] = {
+      {"_+_", "add"},          {"_-_", "subtract"}, {"_*_", "multiply"},
+      {"_/_", "divide"},       {"_%_", "modulo"},   {"_<_", "less"},
+      {"_<=_", "less_equals"}, {"_>_", "greater"},  {"_>=_", "greater_equals"},
+  };
+  Type::PrimitiveType type = Type::PRIMITIVE_TYPE_UNSPECIFIED;
+  if (expr.has_const_expr()) {
+    const auto& constant = expr.const_expr();
+    if (constant.has_bool_value()) {
+      type = Type::BOOL;
+    } else if (constant.has_int64_value()) {
+      type = Type::INT64;
+    } else if (constant.has_uint64_value()) {
+      type = Type::UINT64;
+    } else if (constant.has_double_value()) {
+      type = Type::DOUBLE;
+    } else if (constant.has_string_value()) {
+      type = Type::STRING;
+    }
+  } else if (expr.has_ident_expr()) {
+    if (auto it = variables.find(expr.ident_expr().name());
+        it != variables.end()) {
+      type = it->second;
+    }
+  } else if (expr.has_call_expr()) {
+    const auto& call = expr.call_expr();
+    Type::PrimitiveType operand_type = Type::PRIMITIVE_TYPE_UNSPECIFIED;
+    for (const auto& arg : call.args()) {
+      operand_type = Check(arg, variables, checked_expr);
+    }
+    if (call.has_target()) {
+      Check(call.target(), variables, checked_expr);
+    }
+    type = Type::BOOL;
+    for (const auto& [function, overload] : kOverloads) {
+      if (call.function() == function) {
+        (*checked_expr.mutable_reference_map())[expr.id()].add_overload_id(
+            absl::StrCat(overload, "_", OverloadSuffix(operand_type)));
+        if (overload.substr(0, 4) != "less" &&
+            overload.substr(0, 7) != "greater") {
+          type = operand_type;
+        }
+      }
+    }
+    if (call.function() == "size") {
+      type = Type::INT64;
+    }
+  }
+  if (type != Type::PRIMITIVE_TYPE_UNSPECIFIED) {
+    (*checked_expr.mutable_type_map())[expr.id()].set_primitive(type);
+  }
+  return type;
+}
+
+class ColumnarProgramTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(auto builder,
+                         CreateStandardRuntimeBuilder(RuntimeOptions()));
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+  }
+
+  absl::StatusOr<std::unique_ptr<Ast>> MakeAst(absl::string_view expression) {
+    CEL_ASSIGN_OR_RETURN(auto parsed_expr, Parse(expression));
+    CheckedExpr checked_expr;
+    checked_expr.mutable_expr()->Swap(parsed_expr.mutable_expr());
+    checked_expr.mutable_source_info()->Swap(
+        parsed_expr.mutable_source_info());
+    Check(checked_expr.expr(), variables_, checked_expr);
+    return extensions::CreateAstFromCheckedExpr(checked_expr);
+  }
+
+  absl::StatusOr<std::unique_ptr<ColumnarProgram>> MakeProgram(
+      absl::string_view expression, size_t chunk_size = 2) {
+    CEL_ASSIGN_OR_RETURN(auto ast, MakeAst(expression));
+    return ColumnarProgram::Create(*runtime_, std::move(ast), chunk_size);
+  }
+
+  // Evaluates `program` over `batch`, checking that each row has the result
+  // of evaluating the whole expression with an activation of its own.
+  absl::StatusOr<std::vector<std::string>> Evaluate(
+      const ColumnarProgram& program, const RecordBatchView& batch,
+      const Activation& activation) {
+    ManagedValueFactory value_factory(program.program().GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    CEL_ASSIGN_OR_RETURN(
+        std::vector<Value> results,
+        program.Evaluate(batch, activation, value_factory.get()));
+    std::vector<std::string> strings;
+    for (size_t row = 0; row < results.size(); ++row) {
+      Activation row_activation;
+      for (const auto& [name, type] : variables_) {
+        if (const ColumnView* column = batch.FindColumn(name);
+            column != nullptr) {
+          row_activation.InsertOrAssignValue(name, column->GetValue(row));
+        }
+      }
+      CEL_ASSIGN_OR_RETURN(
+          Value expected,
+          program.program().Evaluate(row_activation, value_factory.get()));
+      EXPECT_EQ(results[row].DebugString(), expected.DebugString())
+          << "row " << row;
+      strings.push_back(results[row].DebugString());
+    }
+    return strings;
+  }
+
+  std::unique_ptr<const Runtime> runtime_;
+  PrimitiveTypes variables_ = {
+      {"x", Type::INT64}, {"y", Type::DOUBLE}, {"name", Type::STRING}};
+};
+
+TEST_F(ColumnarProgramTest, ArithmeticAndComparisons) {
+  std::vector<int64_t> x = {1, 2, 3, 4, 5};
+  std::vector<double> y = {0.5, 1.5, 2.5, 3.5, 4.5};
+  RecordBatchView batch(5);
+  ASSERT_OK(batch.AddColumn("x", ColumnView::Int(x)));
+  ASSERT_OK(batch.AddColumn("y", ColumnView::Double(y)));
+
+  ASSERT_OK_AND_ASSIGN(auto program, MakeProgram("x * 2 - 1"));
+  EXPECT_TRUE(program->vectorized());
+  EXPECT_THAT(Evaluate(*program, batch, Activation()),
+              IsOkAndHolds(ElementsAre("1", "3", "5", "7", "9")));
+
+  ASSERT_OK_AND_ASSIGN(program, MakeProgram("y * 2.0 >= 5.0"));
+  EXPECT_TRUE(program->vectorized());
+  EXPECT_THAT(Evaluate(*program, batch, Activation()),
+              IsOkAndHolds(ElementsAre("false", "false", "true", "true",
+                                       "true")));
+}
+
+TEST_F(ColumnarProgramTest, Strings) {
+  std::vector<int32_t> offsets = {0, 5, 8, 13};
+  RecordBatchView batch(3);
+  ASSERT_OK(
+      batch.AddColumn("name", ColumnView::String(offsets, "alicebobcarol")));
+
+  ASSERT_OK_AND_ASSIGN(auto program, MakeProgram("name == 'bob'"));
+  EXPECT_TRUE(program->vectorized());
+  EXPECT_THAT(Evaluate(*program, batch, Activation()),
+              IsOkAndHolds(ElementsAre("false", "true", "false")));
+
+  ASSERT_OK_AND_ASSIGN(program, MakeProgram("name"));
+  EXPECT_THAT(Evaluate(*program, batch, Activation()),
+              IsOkAndHolds(ElementsAre("\"alice\"", "\"bob\"", "\"carol\"")));
+}
+
+TEST_F(ColumnarProgramTest, StringResultsOwnTheirData) {
+  std::vector<int32_t> offsets = {0, 5, 8, 13, 16, 20};
+  std::string data = "alicebobcaroldaneve!";
+  std::vector<int64_t> x = {1, 2, 3, 4, 5};
+
+  for (absl::string_view expression :
+       {"name", "'constant'", "name + '!'"}) {
+    SCOPED_TRACE(expression);
+    ASSERT_OK_AND_ASSIGN(auto program, MakeProgram(expression));
+    ManagedValueFactory value_factory(program->program().GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    std::vector<Value> results;
+    std::vector<std::string> expected;
+    {
+      RecordBatchView batch(5);
+      ASSERT_OK(batch.AddColumn("name", ColumnView::String(offsets, data)));
+      ASSERT_OK(batch.AddColumn("x", ColumnView::Int(x)));
+      // More rows than the chunk size, so the chunk buffers are reused.
+      ASSERT_OK_AND_ASSIGN(results, program->Evaluate(batch, Activation(),
+                                                      value_factory.get()));
+      ASSERT_OK_AND_ASSIGN(expected, Evaluate(*program, batch, Activation()));
+    }
+    // Overwrite the batch's data, which the results must not reference.
+    std::string saved = data;
+    data.assign(data.size(), '#');
+
+    ASSERT_EQ(results.size(), expected.size());
+    for (size_t row = 0; row < results.size(); ++row) {
+      EXPECT_EQ(results[row].DebugString(), expected[row]) << "row " << row;
+    }
+    data = saved;
+  }
+}
+
+TEST_F(ColumnarProgramTest, FailingRowsUseProgram) {
+  std::vector<int64_t> x = {1, std::numeric_limits<int64_t>::max(), 0, 4};
+  // The third row is null.
+  std::vector<uint8_t> validity = {0b1011};
+  RecordBatchView batch(4);
+  ASSERT_OK(batch.AddColumn("x", ColumnView::Int(x, validity)));
+
+  ASSERT_OK_AND_ASSIGN(auto program, MakeProgram("x + 1 > 2"));
+  ASSERT_OK_AND_ASSIGN(auto results, Evaluate(*program, batch, Activation()));
+  EXPECT_EQ(results[0], "false");
+  EXPECT_THAT(results[1], HasSubstr("overflow"));
+  EXPECT_THAT(results[2], HasSubstr("No matching overloads"));
+  EXPECT_EQ(results[3], "true");
+}
+
+TEST_F(ColumnarProgramTest, LogicAbsorbsFailingOperands) {
+  std::vector<int64_t> x = {1, 0, 2, 0};
+  std::vector<double> y = {0.5, 0.5, 2.5, 2.5};
+  RecordBatchView batch(4);
+  ASSERT_OK(batch.AddColumn("x", ColumnView::Int(x)));
+  ASSERT_OK(batch.AddColumn("y", ColumnView::Double(y)));
+
+  ASSERT_OK_AND_ASSIGN(auto program, MakeProgram("10 / x > 1 && y > 1.0"));
+  ASSERT_OK_AND_ASSIGN(auto results, Evaluate(*program, batch, Activation()));
+  EXPECT_EQ(results[0], "false");
+  EXPECT_EQ(results[1], "false");
+  EXPECT_EQ(results[2], "true");
+  EXPECT_THAT(results[3], HasSubstr("divide by zero"));
+
+  ASSERT_OK_AND_ASSIGN(program, MakeProgram("y > 1.0 || 10 / x > 1"));
+  ASSERT_OK_AND_ASSIGN(results, Evaluate(*program, batch, Activation()));
+  EXPECT_EQ(results[0], "true");
+  EXPECT_THAT(results[1], HasSubstr("divide by zero"));
+  EXPECT_EQ(results[2], "true");
+  EXPECT_EQ(results[3], "true");
+}
+
+TEST_F(ColumnarProgramTest, UnsupportedSubexpressionsEvaluatedPerRow) {
+  std::vector<int32_t> offsets = {0, 5, 8, 13};
+  std::vector<int64_t> x = {5, 4, 3};
+  RecordBatchView batch(3);
+  ASSERT_OK(
+      batch.AddColumn("name", ColumnView::String(offsets, "alicebobcarol")));
+  ASSERT_OK(batch.AddColumn("x", ColumnView::Int(x)));
+
+  ASSERT_OK_AND_ASSIGN(auto program,
+                       MakeProgram("size(name) == x && name.startsWith('a')"));
+  EXPECT_TRUE(program->vectorized());
+  EXPECT_THAT(Evaluate(*program, batch, Activation()),
+              IsOkAndHolds(ElementsAre("true", "false", "false")));
+
+  ASSERT_OK_AND_ASSIGN(program, MakeProgram("[x, 1].exists(v, v > 4)"));
+  EXPECT_FALSE(program->vectorized());
+  EXPECT_THAT(Evaluate(*program, batch, Activation()),
+              IsOkAndHolds(ElementsAre("true", "false", "false")));
+}
+
+TEST_F(ColumnarProgramTest, VariablesOutsideBatch) {
+  std::vector<int64_t> x = {1, 2, 3};
+  RecordBatchView batch(3);
+  ASSERT_OK(batch.AddColumn("x", ColumnView::Int(x)));
+  variables_["limit"] = Type::INT64;
+  Activation activation;
+  activation.InsertOrAssignValue("limit", IntValue(2));
+
+  ASSERT_OK_AND_ASSIGN(auto program, MakeProgram("x < limit"));
+  ManagedValueFactory value_factory(program->program().GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<Value> results,
+      program->Evaluate(batch, activation, value_factory.get()));
+  ASSERT_EQ(results.size(), 3);
+  EXPECT_EQ(results[0].DebugString(), "true");
+  EXPECT_EQ(results[1].DebugString(), "false");
+  EXPECT_EQ(results[2].DebugString(), "false");
+}
+
+TEST_F(ColumnarProgramTest, InvalidBatches) {
+  std::vector<int64_t> x = {1, 2, 3};
+  RecordBatchView batch(2);
+  EXPECT_THAT(batch.AddColumn("x", ColumnView::Int(x)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  ASSERT_OK(batch.AddColumn("x", ColumnView::Int(absl::MakeSpan(x).first(2))));
+  EXPECT_THAT(batch.AddColumn("x", ColumnView::Int(absl::MakeSpan(x).first(2))),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+}
+
+TEST_F(ColumnarProgramTest, RequiresCheckedExpression) {
+  ASSERT_OK_AND_ASSIGN(auto parsed_expr, Parse("x + 1"));
+  ASSERT_OK_AND_ASSIGN(auto ast,
+                       extensions::CreateAstFromParsedExpr(parsed_expr));
+  EXPECT_THAT(ColumnarProgram::Create(*runtime_, std::move(ast)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace cel
@@ -72,9 +72,7 @@ MATCHER_P(IsErrorValue, expected_substr, "") {
 
 class ConstantFoldingExtTest : public testing::TestWithParam<TestCase> {};
 
-TEST_P(ConstantFoldingExtTest, Runner) {
-  RuntimeOptions options;
-  const TestCase& test_case = GetParam();
+void RunTestCase(const TestCase& test_case, const RuntimeOptions& options) {
   ASSERT_OK_AND_ASSIGN(cel::RuntimeBuilder builder,
                        CreateStandardRuntimeBuilder(options));
 
@@ -115,6 +113,17 @@ TEST_P(ConstantFoldingExtTest, Runner) {
                                         HasSubstr(test_case.status.message())));
 }
 
+TEST_P(ConstantFoldingExtTest, Runner) {
+  RuntimeOptions options;
+  RunTestCase(GetParam(), options);
+}
+
+TEST_P(ConstantFoldingExtTest, RecursiveRunner) {
+  RuntimeOptions options;
+  options.max_recursion_depth = -1;
+  RunTestCase(GetParam(), options);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Cases, ConstantFoldingExtTest,
     testing::ValuesIn(std::vector<TestCase>{
@@ -132,7 +141,12 @@ INSTANTIATE_TEST_SUITE_P(
         // TODO(uncreated-issue/32): Depends on map creation
         // {"map_create", "{'abc': 'def', 'abd': 'deg'}.size()", 2},
         {"custom_function", "prepend('def', 'abc') == 'abcdef'",
-         IsBoolValue(true)}}),
+         IsBoolValue(true)},
+        {"ternary", "(1 < 2 ? 'a' : 'b') + 'c' == 'ac'", IsBoolValue(true)},
+        {"ternary_constant_condition", "1 < 2 ? 1 : x", IsIntValue(1)},
+        {"logic", "(1 < 2 && 2 < 3) || false", IsBoolValue(true)},
+        {"logic_error", "1 / 0 == 1 || false",
+         IsErrorValue("divide by zero")}}),
 
     [](const testing::TestParamInfo<TestCase>& info) {
       return info.param.name;
@@ -0,0 +1,214 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/cost_estimator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/builtins.h"
+#include "common/expr.h"
+
+namespace cel {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+
+constexpr uint64_t kUnbounded = CostEstimate::kUnbounded;
+
+uint64_t SaturatingAdd(uint64_t lhs, uint64_t rhs) {
+  return lhs > kUnbounded - rhs ? kUnbounded : lhs + rhs;
+}
+
+uint64_t SaturatingMul(uint64_t lhs, uint64_t rhs) {
+  if (lhs == 0 || rhs == 0) {
+    return 0;
+  }
+  return lhs > kUnbounded / rhs ? kUnbounded : lhs * rhs;
+}
+
+CostEstimate Add(const CostEstimate& lhs, const CostEstimate& rhs) {
+  return CostEstimate{SaturatingAdd(lhs.min, rhs.min),
+                      SaturatingAdd(lhs.max, rhs.max)};
+}
+
+// Bounds on the number of elements of a collection.
+struct SizeEstimate {
+  uint64_t min = 0;
+  uint64_t max = kUnbounded;
+};
+
+class CostEstimator {
+ public:
+  explicit CostEstimator(const CostEstimatorOptions& options)
+      : options_(options) {}
+
+  CostEstimate Estimate(const Expr& expr) {
+    if (expr.has_select_expr()) {
+      return Estimate(expr.select_expr().operand());
+    }
+    if (expr.has_call_expr()) {
+      return EstimateCall(expr.call_expr());
+    }
+    if (expr.has_comprehension_expr()) {
+      return EstimateComprehension(expr.comprehension_expr());
+    }
+    CostEstimate cost;
+    if (expr.has_list_expr()) {
+      for (const auto& element : expr.list_expr().elements()) {
+        cost = Add(cost, Estimate(element.expr()));
+      }
+    } else if (expr.has_struct_expr()) {
+      for (const auto& field : expr.struct_expr().fields()) {
+        cost = Add(cost, Estimate(field.value()));
+      }
+    } else if (expr.has_map_expr()) {
+      for (const auto& entry : expr.map_expr().entries()) {
+        cost = Add(cost, Estimate(entry.key()));
+        cost = Add(cost, Estimate(entry.value()));
+      }
+    }
+    return cost;
+  }
+
+ private:
+  CostEstimate EstimateCall(const CallExpr& call) {
+    if (call.function() == builtin::kAnd || call.function() == builtin::kOr) {
+      // Either operand may be evaluated first and decide the result.
+      CostEstimate cost;
+      for (size_t i = 0; i < call.args().size(); ++i) {
+        CostEstimate arg = Estimate(call.args()[i]);
+        cost.min = i == 0 ? arg.min : std::min(cost.min, arg.min);
+        cost.max = SaturatingAdd(cost.max, arg.max);
+      }
+      return cost;
+    }
+    if (call.function() == builtin::kTernary && call.args().size() == 3) {
+      CostEstimate condition = Estimate(call.args()[0]);
+      CostEstimate truthy = Estimate(call.args()[1]);
+      CostEstimate falsy = Estimate(call.args()[2]);
+      return Add(condition, CostEstimate{std::min(truthy.min, falsy.min),
+                                         std::max(truthy.max, falsy.max)});
+    }
+    CostEstimate cost;
+    if (call.function() != builtin::kIndex) {
+      auto it = options_.function_costs.find(call.function());
+      uint64_t function_cost = it != options_.function_costs.end()
+                                   ? it->second
+                                   : options_.default_function_cost;
+      cost = CostEstimate{function_cost, function_cost};
+    }
+    if (call.has_target()) {
+      cost = Add(cost, Estimate(call.target()));
+    }
+    for (const auto& arg : call.args()) {
+      cost = Add(cost, Estimate(arg));
+    }
+    return cost;
+  }
+
+  CostEstimate EstimateComprehension(const ComprehensionExpr& comprehension) {
+    CostEstimate cost = Add(Estimate(comprehension.iter_range()),
+                            Estimate(comprehension.accu_init()));
+    SizeEstimate size = EstimateSize(comprehension.iter_range());
+
+    scopes_.push_back(comprehension.accu_var());
+    scopes_.push_back(comprehension.iter_var());
+    CostEstimate condition = Estimate(comprehension.loop_condition());
+    CostEstimate step = Estimate(comprehension.loop_step());
+    scopes_.pop_back();
+    CostEstimate result = Estimate(comprehension.result());
+    scopes_.pop_back();
+
+    // Each iteration costs 1 on top of its condition and step. Loops whose
+    // condition isn't always true may stop before their first iteration.
+    CostEstimate iteration = Add(CostEstimate{1, 1}, Add(condition, step));
+    const Expr& loop_condition = comprehension.loop_condition();
+    bool always_loops = loop_condition.has_const_expr() &&
+                        loop_condition.const_expr().has_bool_value() &&
+                        loop_condition.const_expr().bool_value();
+    CostEstimate loop{
+        always_loops ? SaturatingMul(size.min, iteration.min) : 0,
+        size.max == kUnbounded ? kUnbounded
+                               : SaturatingMul(size.max, iteration.max)};
+    return Add(Add(cost, loop), result);
+  }
+
+  SizeEstimate EstimateSize(const Expr& range) {
+    if (range.has_list_expr()) {
+      SizeEstimate size{0, 0};
+      for (const auto& element : range.list_expr().elements()) {
+        size.min += element.optional() ? 0 : 1;
+        size.max += 1;
+      }
+      return size;
+    }
+    if (range.has_map_expr()) {
+      SizeEstimate size{0, 0};
+      for (const auto& entry : range.map_expr().entries()) {
+        size.min += entry.optional() ? 0 : 1;
+        size.max += 1;
+      }
+      return size;
+    }
+    if (absl::optional<std::string> path = AttributePath(range);
+        path.has_value()) {
+      if (auto it = options_.size_hints.find(*path);
+          it != options_.size_hints.end()) {
+        return SizeEstimate{0, it->second};
+      }
+    }
+    return SizeEstimate{0, options_.default_max_size.value_or(kUnbounded)};
+  }
+
+  // Returns the attribute path read by `expr` if it is a variable followed by
+  // field selections, e.g. `request.items`.
+  absl::optional<std::string> AttributePath(const Expr& expr) const {
+    if (expr.has_ident_expr()) {
+      const std::string& name = expr.ident_expr().name();
+      if (std::find(scopes_.begin(), scopes_.end(), name) != scopes_.end()) {
+        return absl::nullopt;
+      }
+      return name;
+    }
+    if (expr.has_select_expr() && !expr.select_expr().test_only()) {
+      absl::optional<std::string> operand =
+          AttributePath(expr.select_expr().operand());
+      if (operand.has_value()) {
+        return absl::StrCat(*operand, ".", expr.select_expr().field());
+      }
+    }
+    return absl::nullopt;
+  }
+
+  const CostEstimatorOptions& options_;
+  // The variables of the enclosing comprehensions.
+  std::vector<std::string> scopes_;
+};
+
+}  // namespace
+
+CostEstimate EstimateCost(const Ast& ast, const CostEstimatorOptions& options) {
+  CostEstimator estimator(options);
+  return estimator.Estimate(AstImpl::CastFromPublicAst(ast).root_expr());
+}
+
+}  // namespace cel
@@ -0,0 +1,75 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_COST_ESTIMATOR_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_COST_ESTIMATOR_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "base/ast.h"
+
+namespace cel {
+
+// Bounds on the cost of evaluating an expression.
+//
+// Costs are counted in the units of RuntimeOptions::max_evaluation_cost: each
+// function call costs its function cost (see CostEstimatorOptions) and each
+// comprehension iteration costs 1. Variable lookups, field selections,
+// indexing, literals and the logical and conditional operators are free.
+struct CostEstimate {
+  static constexpr uint64_t kUnbounded = std::numeric_limits<uint64_t>::max();
+
+  // The cost of the cheapest evaluation, e.g. when every `&&` and `||`
+  // short-circuits and loops with a condition stop before their first
+  // iteration.
+  uint64_t min = 0;
+  // The cost of the most expensive evaluation, or kUnbounded if it depends on
+  // the size of a collection without a size hint.
+  uint64_t max = 0;
+};
+
+struct CostEstimatorOptions {
+  // The cost of a call to each function, by function name (e.g. `matches`).
+  // The runtime counts every call with a cost of 1, so the estimate only
+  // bounds runtime costs with the default function costs.
+  absl::flat_hash_map<std::string, uint64_t> function_costs;
+
+  // The cost of a call to a function without an entry in `function_costs`.
+  uint64_t default_function_cost = 1;
+
+  // The maximum size of the lists and maps bound to variables or read from
+  // their fields, by attribute path (e.g. `request.items`).
+  absl::flat_hash_map<std::string, uint64_t> size_hints;
+
+  // The maximum size assumed for the other collections iterated by
+  // comprehensions. If unset the maximum cost of such comprehensions is
+  // unbounded.
+  absl::optional<uint64_t> default_max_size;
+};
+
+// Returns bounds on the cost of evaluating `ast`, for admitting or rejecting
+// expressions before planning them.
+//
+// The bounds assume the expression is planned as written: optimizations such
+// as constant folding may make evaluations cheaper than `min`.
+CostEstimate EstimateCost(const Ast& ast,
+                          const CostEstimatorOptions& options = {});
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_COST_ESTIMATOR_H_
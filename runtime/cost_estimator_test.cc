@@ -0,0 +1,131 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/cost_estimator.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/ast.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+#include "google/protobuf/arena.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::ProtobufRuntimeAdapter;
+using ::cel::extensions::ProtoMemoryManagerRef;
+using ::cel::internal::IsOkAndHolds;
+using ::cel::internal::StatusIs;
+using ::cel::test::BoolValueIs;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using ::google::api::expr::parser::Parse;
+using testing::FieldsAre;
+
+absl::StatusOr<CostEstimate> Estimate(
+    absl::string_view expression, const CostEstimatorOptions& options = {}) {
+  CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+  CEL_ASSIGN_OR_RETURN(std::unique_ptr<Ast> ast,
+                       extensions::CreateAstFromParsedExpr(expr));
+  return EstimateCost(*ast, options);
+}
+
+TEST(CostEstimatorTest, Calls) {
+  EXPECT_THAT(Estimate("1 + 2 * 3"), IsOkAndHolds(FieldsAre(2, 2)));
+  EXPECT_THAT(Estimate("a.b[0]"), IsOkAndHolds(FieldsAre(0, 0)));
+}
+
+TEST(CostEstimatorTest, ShortCircuiting) {
+  EXPECT_THAT(Estimate("a.startsWith('x') || size(b) > 2"),
+              IsOkAndHolds(FieldsAre(1, 3)));
+  EXPECT_THAT(Estimate("a ? size(b) : size(c) + 1"),
+              IsOkAndHolds(FieldsAre(1, 2)));
+}
+
+TEST(CostEstimatorTest, FunctionCosts) {
+  CostEstimatorOptions options;
+  options.function_costs["matches"] = 10;
+  EXPECT_THAT(Estimate("s.matches('a+') && s.size() > 1", options),
+              IsOkAndHolds(FieldsAre(2, 12)));
+}
+
+TEST(CostEstimatorTest, ComprehensionOverLiteral) {
+  // Each iteration costs 1, plus 2 calls in the loop step.
+  EXPECT_THAT(Estimate("[1, 2, 3].map(x, x * 2)"),
+              IsOkAndHolds(FieldsAre(9, 9)));
+}
+
+TEST(CostEstimatorTest, ComprehensionOverVariable) {
+  ASSERT_OK_AND_ASSIGN(CostEstimate estimate,
+                       Estimate("request.items.exists(i, i > 0)"));
+  EXPECT_EQ(estimate.min, 0);
+  EXPECT_EQ(estimate.max, CostEstimate::kUnbounded);
+
+  CostEstimatorOptions options;
+  options.size_hints["request.items"] = 10;
+  EXPECT_THAT(Estimate("request.items.exists(i, i > 0)", options),
+              IsOkAndHolds(FieldsAre(0, 40)));
+
+  options.size_hints.clear();
+  options.default_max_size = 5;
+  EXPECT_THAT(Estimate("request.items.exists(i, i > 0)", options),
+              IsOkAndHolds(FieldsAre(0, 20)));
+}
+
+TEST(CostEstimatorTest, BoundsEvaluationCost) {
+  constexpr absl::string_view kExpression = "[1, 2, 3].all(x, x > 0)";
+  ASSERT_OK_AND_ASSIGN(CostEstimate estimate, Estimate(kExpression));
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse(kExpression));
+
+  for (int64_t budget : {static_cast<int64_t>(estimate.max), int64_t{2}}) {
+    RuntimeOptions options;
+    options.max_evaluation_cost = budget;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(auto program,
+                         ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+    google::protobuf::Arena arena;
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    Activation activation;
+    if (budget == 2) {
+      EXPECT_THAT(program->Evaluate(activation, value_factory.get()),
+                  StatusIs(absl::StatusCode::kResourceExhausted));
+    } else {
+      EXPECT_THAT(program->Evaluate(activation, value_factory.get()),
+                  IsOkAndHolds(BoolValueIs(true)));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace cel
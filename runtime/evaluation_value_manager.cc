@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/evaluation_value_manager.h"
+
+#include "absl/strings/string_view.h"
+#include "common/sized_input_view.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/values/value_cache.h"
+
+namespace cel {
+
+using ::cel::common_internal::EmptyListValue;
+using ::cel::common_internal::EmptyMapValue;
+using ::cel::common_internal::EmptyOptionalValue;
+
+ListType EvaluationValueManager::CreateListTypeImpl(TypeView element) {
+  if (interned_types_ != nullptr) {
+    return interned_types_->CreateListType(element);
+  }
+  return ListType(memory_manager_, Type(element));
+}
+
+MapType EvaluationValueManager::CreateMapTypeImpl(TypeView key,
+                                                  TypeView value) {
+  if (interned_types_ != nullptr) {
+    return interned_types_->CreateMapType(key, value);
+  }
+  return MapType(memory_manager_, Type(key), Type(value));
+}
+
+StructType EvaluationValueManager::CreateStructTypeImpl(
+    absl::string_view name) {
+  if (interned_types_ != nullptr) {
+    return interned_types_->CreateStructType(name);
+  }
+  return StructType(memory_manager_, name);
+}
+
+OpaqueType EvaluationValueManager::CreateOpaqueTypeImpl(
+    absl::string_view name, const SizedInputView<TypeView>& parameters) {
+  if (interned_types_ != nullptr) {
+    return interned_types_->CreateOpaqueType(name, parameters);
+  }
+  return OpaqueType(memory_manager_, name, parameters);
+}
+
+ListValue EvaluationValueManager::CreateZeroListValueImpl(ListTypeView type) {
+  return ParsedListValue(
+      memory_manager_.MakeShared<EmptyListValue>(ListType(type)));
+}
+
+MapValue EvaluationValueManager::CreateZeroMapValueImpl(MapTypeView type) {
+  return ParsedMapValue(
+      memory_manager_.MakeShared<EmptyMapValue>(MapType(type)));
+}
+
+OptionalValue EvaluationValueManager::CreateZeroOptionalValueImpl(
+    OptionalTypeView type) {
+  return OptionalValue(
+      memory_manager_.MakeShared<EmptyOptionalValue>(OptionalType(type)));
+}
+
+}  // namespace cel
@@ -0,0 +1,98 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_EVALUATION_VALUE_MANAGER_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_EVALUATION_VALUE_MANAGER_H_
+
+#include "absl/base/nullability.h"
+#include "absl/strings/string_view.h"
+#include "base/type_provider.h"
+#include "common/memory.h"
+#include "common/sized_input_view.h"
+#include "common/type.h"
+#include "common/type_factory.h"
+#include "common/type_introspector.h"
+#include "common/type_reflector.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel {
+
+// A value manager for a single evaluation, cheap enough to construct on the
+// stack for each one.
+//
+// Construction only stores references: the type provider of the program and
+// the memory manager are borrowed, and nothing is allocated until a value or
+// type actually needs storage. Composite types which aren't among the
+// process-wide builtin ones (e.g. `list(int)`) are created with
+// `interned_types` if provided, so that the evaluations sharing it reuse the
+// same types instead of creating them again. It should be thread safe and use
+// reference counting, e.g. the result of
+//
+//   NewThreadSafeTypeManager(MemoryManagerRef::ReferenceCounting(),
+//                            NewThreadSafeTypeIntrospector(
+//                                MemoryManagerRef::ReferenceCounting()));
+//
+// `type_provider`, `memory_manager` and `interned_types` must outlive the
+// value manager.
+class EvaluationValueManager final : public ValueManager {
+ public:
+  EvaluationValueManager(
+      const TypeProvider& type_provider, MemoryManagerRef memory_manager,
+      absl::Nullable<TypeFactory*> interned_types = nullptr)
+      : memory_manager_(memory_manager),
+        type_provider_(type_provider),
+        interned_types_(interned_types) {}
+
+  EvaluationValueManager(const EvaluationValueManager&) = delete;
+  EvaluationValueManager& operator=(const EvaluationValueManager&) = delete;
+
+  MemoryManagerRef GetMemoryManager() const override {
+    return memory_manager_;
+  }
+
+ protected:
+  const TypeIntrospector& GetTypeIntrospector() const override {
+    return type_provider_;
+  }
+
+  const TypeReflector& GetTypeReflector() const override {
+    return type_provider_;
+  }
+
+ private:
+  ListType CreateListTypeImpl(TypeView element) override;
+
+  MapType CreateMapTypeImpl(TypeView key, TypeView value) override;
+
+  StructType CreateStructTypeImpl(absl::string_view name) override;
+
+  OpaqueType CreateOpaqueTypeImpl(
+      absl::string_view name,
+      const SizedInputView<TypeView>& parameters) override;
+
+  ListValue CreateZeroListValueImpl(ListTypeView type) override;
+
+  MapValue CreateZeroMapValueImpl(MapTypeView type) override;
+
+  OptionalValue CreateZeroOptionalValueImpl(OptionalTypeView type) override;
+
+  MemoryManagerRef memory_manager_;
+  const TypeProvider& type_provider_;
+  absl::Nullable<TypeFactory*> interned_types_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_EVALUATION_VALUE_MANAGER_H_
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/evaluation_value_manager.h"
+
+#include <utility>
+
+#include "common/memory.h"
+#include "common/type.h"
+#include "common/type_introspector.h"
+#include "common/type_manager.h"
+#include "common/type_reflector.h"
+#include "common/value.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using cel::internal::IsOkAndHolds;
+
+TEST(EvaluationValueManager, CreatesValues) {
+  EvaluationValueManager value_manager(TypeReflector::Builtin(),
+                                       MemoryManagerRef::ReferenceCounting());
+  EXPECT_EQ(value_manager.GetMemoryManager().memory_management(),
+            MemoryManagement::kReferenceCounting);
+  EXPECT_EQ(value_manager.CreateIntValue(1), IntValue(1));
+  ASSERT_OK_AND_ASSIGN(auto builder, value_manager.NewListValueBuilder(
+                                         value_manager.GetDynListType()));
+  ASSERT_OK(builder->Add(IntValue(1)));
+  ListValue list = std::move(*builder).Build();
+  EXPECT_THAT(list.Size(), IsOkAndHolds(1));
+}
+
+TEST(EvaluationValueManager, CreatesTypes) {
+  EvaluationValueManager value_manager(TypeReflector::Builtin(),
+                                       MemoryManagerRef::ReferenceCounting());
+  StructType struct_type = value_manager.CreateStructType("test.Message");
+  EXPECT_EQ(struct_type.name(), "test.Message");
+  ListType list_type = value_manager.CreateListType(struct_type);
+  EXPECT_EQ(list_type.element(), struct_type);
+  MapType map_type = value_manager.CreateMapType(StringTypeView(), list_type);
+  EXPECT_EQ(map_type.value(), list_type);
+  ListValue zero = value_manager.CreateZeroListValue(list_type);
+  EXPECT_THAT(zero.IsEmpty(), IsOkAndHolds(true));
+}
+
+TEST(EvaluationValueManager, SharesInternedTypes) {
+  Shared<TypeManager> interned_types = NewThreadSafeTypeManager(
+      MemoryManagerRef::ReferenceCounting(),
+      NewThreadSafeTypeIntrospector(MemoryManagerRef::ReferenceCounting()));
+  EvaluationValueManager first_manager(TypeReflector::Builtin(),
+                                       MemoryManagerRef::ReferenceCounting(),
+                                       interned_types.operator->());
+  EvaluationValueManager second_manager(TypeReflector::Builtin(),
+                                        MemoryManagerRef::ReferenceCounting(),
+                                        interned_types.operator->());
+  StructType first = first_manager.CreateStructType("test.Message");
+  StructType second = second_manager.CreateStructType("test.Message");
+  EXPECT_EQ(first, second);
+  // Both evaluations got the same interned type.
+  EXPECT_EQ(first.name().data(), second.name().data());
+}
+
+}  // namespace
+}  // namespace cel
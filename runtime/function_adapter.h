@@ -18,10 +18,14 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_ADAPTER_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_ADAPTER_H_
 
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/functional/bind_front.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -33,6 +37,7 @@
 #include "common/kind.h"
 #include "common/value.h"
 #include "internal/status_macros.h"
+#include "runtime/function_registry.h"
 #include "runtime/internal/function_adapter.h"
 #include "runtime/register_function_helper.h"
 
@@ -140,6 +145,17 @@ struct Indexer {
   using type = typename IndexerImpl<N, Args...>::type;
 };
 
+// A stateless callable invoking `Fn`. The function is bound at compile time,
+// so calls through it are direct and may be inlined, unlike calls through a
+// std::function.
+template <auto Fn>
+struct StaticFunction {
+  template <typename... Args>
+  decltype(auto) operator()(Args&&... args) const {
+    return Fn(std::forward<Args>(args)...);
+  }
+};
+
 template <int N, typename... Args>
 struct ApplyHelper {
   template <typename T, typename Op>
@@ -227,6 +243,12 @@ struct ApplyHelper<0, Args...> {
 //            &SquareDifference,
 //            builder.function_registry());
 //    CEL_RETURN_IF_ERROR(status);
+//
+//    // Functions known at build time may be bound as template arguments
+//    // instead, which avoids the std::function indirection on every call.
+//    status = BinaryFunctionAdapter<double, double, double>::
+//        RegisterStaticGlobalOverload<&SquareDifference>(
+//            "sq_diff", builder.function_registry());
 //  }
 //
 // example CEL expression:
@@ -239,7 +261,16 @@ class BinaryFunctionAdapter
   using FunctionType = std::function<T(ValueManager&, U, V)>;
 
   static std::unique_ptr<cel::Function> WrapFunction(FunctionType fn) {
-    return std::make_unique<BinaryFunctionImpl>(std::move(fn));
+    return std::make_unique<BinaryFunctionImpl<FunctionType>>(std::move(fn));
+  }
+
+  // Like WrapFunction, but calls `Fn` directly instead of through a
+  // std::function.
+  template <auto Fn>
+  static std::unique_ptr<cel::Function> WrapStaticFunction() {
+    return std::make_unique<
+        BinaryFunctionImpl<runtime_internal::StaticFunction<Fn>>>(
+        runtime_internal::StaticFunction<Fn>{});
   }
 
   static FunctionDescriptor CreateDescriptor(absl::string_view name,
@@ -252,9 +283,10 @@ class BinaryFunctionAdapter
   }
 
  private:
+  template <typename Fn>
   class BinaryFunctionImpl : public cel::Function {
    public:
-    explicit BinaryFunctionImpl(FunctionType fn) : fn_(std::move(fn)) {}
+    explicit BinaryFunctionImpl(Fn fn) : fn_(std::move(fn)) {}
     absl::StatusOr<Value> Invoke(const FunctionEvaluationContext& context,
                                  absl::Span<const Value> args) const override {
       using Arg1Traits = runtime_internal::AdaptedTypeTraits<U>;
@@ -283,7 +315,7 @@ class BinaryFunctionAdapter
     }
 
    private:
-    BinaryFunctionAdapter::FunctionType fn_;
+    Fn fn_;
   };
 };
 
@@ -314,7 +346,16 @@ class UnaryFunctionAdapter : public RegisterHelper<UnaryFunctionAdapter<T, U>> {
   using FunctionType = std::function<T(ValueManager&, U)>;
 
   static std::unique_ptr<cel::Function> WrapFunction(FunctionType fn) {
-    return std::make_unique<UnaryFunctionImpl>(std::move(fn));
+    return std::make_unique<UnaryFunctionImpl<FunctionType>>(std::move(fn));
+  }
+
+  // Like WrapFunction, but calls `Fn` directly instead of through a
+  // std::function.
+  template <auto Fn>
+  static std::unique_ptr<cel::Function> WrapStaticFunction() {
+    return std::make_unique<
+        UnaryFunctionImpl<runtime_internal::StaticFunction<Fn>>>(
+        runtime_internal::StaticFunction<Fn>{});
   }
 
   static FunctionDescriptor CreateDescriptor(absl::string_view name,
@@ -325,9 +366,10 @@ class UnaryFunctionAdapter : public RegisterHelper<UnaryFunctionAdapter<T, U>> {
   }
 
  private:
+  template <typename Fn>
   class UnaryFunctionImpl : public cel::Function {
    public:
-    explicit UnaryFunctionImpl(FunctionType fn) : fn_(std::move(fn)) {}
+    explicit UnaryFunctionImpl(Fn fn) : fn_(std::move(fn)) {}
     absl::StatusOr<Value> Invoke(const FunctionEvaluationContext& context,
                                  absl::Span<const Value> args) const override {
       using ArgTraits = runtime_internal::AdaptedTypeTraits<U>;
@@ -350,7 +392,7 @@ class UnaryFunctionAdapter : public RegisterHelper<UnaryFunctionAdapter<T, U>> {
     }
 
    private:
-    FunctionType fn_;
+    Fn fn_;
   };
 };
 
@@ -366,7 +408,16 @@ class VariadicFunctionAdapter
   using FunctionType = std::function<T(ValueManager&, Args...)>;
 
   static std::unique_ptr<cel::Function> WrapFunction(FunctionType fn) {
-    return std::make_unique<VariadicFunctionImpl>(std::move(fn));
+    return std::make_unique<VariadicFunctionImpl<FunctionType>>(std::move(fn));
+  }
+
+  // Like WrapFunction, but calls `Fn` directly instead of through a
+  // std::function.
+  template <auto Fn>
+  static std::unique_ptr<cel::Function> WrapStaticFunction() {
+    return std::make_unique<
+        VariadicFunctionImpl<runtime_internal::StaticFunction<Fn>>>(
+        runtime_internal::StaticFunction<Fn>{});
   }
 
   static FunctionDescriptor CreateDescriptor(absl::string_view name,
@@ -378,9 +429,10 @@ class VariadicFunctionAdapter
   }
 
  private:
+  template <typename Fn>
   class VariadicFunctionImpl : public cel::Function {
    public:
-    explicit VariadicFunctionImpl(FunctionType fn) : fn_(std::move(fn)) {}
+    explicit VariadicFunctionImpl(Fn fn) : fn_(std::move(fn)) {}
 
     absl::StatusOr<Value> Invoke(const FunctionEvaluationContext& context,
                                  absl::Span<const Value> args) const override {
@@ -400,7 +452,98 @@ class VariadicFunctionAdapter
     }
 
    private:
-    FunctionType fn_;
+    Fn fn_;
+  };
+};
+
+// Specialization for functions taking any number of arguments of the same
+// type, such as `hash(a, b, c, d)`, which receive them as a single span.
+//
+// The arguments are handed to the function as a view of the evaluator's value
+// stack when `U` is `Value`. Otherwise they are converted into an inline
+// buffer, which only allocates for more than `kInlineArgs` arguments.
+//
+// A descriptor is needed for each supported number of arguments. `Register`
+// registers one overload for each of them, sharing the implementation.
+//
+// Example Usage:
+//  int64_t Sum(ValueManager&, absl::Span<const int64_t> xs) {
+//    return std::accumulate(xs.begin(), xs.end(), int64_t{0});
+//  }
+//
+//  CEL_RETURN_IF_ERROR(
+//      (VariadicFunctionAdapter<int64_t, absl::Span<const int64_t>>::Register(
+//          "sum", /*receiver_style=*/false, &Sum, /*min_args=*/1,
+//          /*max_args=*/8, registry)));
+template <typename T, typename U>
+class VariadicFunctionAdapter<T, absl::Span<const U>> {
+ public:
+  using FunctionType = std::function<T(ValueManager&, absl::Span<const U>)>;
+
+  static constexpr size_t kInlineArgs = 8;
+
+  static std::unique_ptr<cel::Function> WrapFunction(FunctionType fn) {
+    return std::make_unique<SpanFunctionImpl<FunctionType>>(std::move(fn));
+  }
+
+  // Like WrapFunction, but calls `Fn` directly instead of through a
+  // std::function.
+  template <auto Fn>
+  static std::unique_ptr<cel::Function> WrapStaticFunction() {
+    return std::make_unique<
+        SpanFunctionImpl<runtime_internal::StaticFunction<Fn>>>(
+        runtime_internal::StaticFunction<Fn>{});
+  }
+
+  static FunctionDescriptor CreateDescriptor(absl::string_view name,
+                                             bool receiver_style,
+                                             size_t num_args,
+                                             bool is_strict = true) {
+    return FunctionDescriptor(
+        name, receiver_style,
+        std::vector<cel::Kind>(num_args, runtime_internal::AdaptedKind<U>()),
+        is_strict);
+  }
+
+  // Registers an overload of `fn` for each number of arguments from
+  // `min_args` to `max_args`.
+  static absl::Status Register(absl::string_view name, bool receiver_style,
+                               FunctionType fn, size_t min_args,
+                               size_t max_args, FunctionRegistry& registry,
+                               bool is_strict = true) {
+    for (size_t num_args = min_args; num_args <= max_args; ++num_args) {
+      CEL_RETURN_IF_ERROR(registry.Register(
+          CreateDescriptor(name, receiver_style, num_args, is_strict),
+          WrapFunction(fn)));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  template <typename Fn>
+  class SpanFunctionImpl : public cel::Function {
+   public:
+    explicit SpanFunctionImpl(Fn fn) : fn_(std::move(fn)) {}
+
+    absl::StatusOr<Value> Invoke(const FunctionEvaluationContext& context,
+                                 absl::Span<const Value> args) const override {
+      if constexpr (std::is_same_v<U, Value>) {
+        return runtime_internal::AdaptedToHandleVisitor{}(
+            fn_(context.value_factory(), args));
+      } else {
+        absl::InlinedVector<U, kInlineArgs> typed_args(args.size());
+        for (size_t i = 0; i < args.size(); ++i) {
+          CEL_RETURN_IF_ERROR(
+              runtime_internal::HandleToAdaptedVisitor{args[i]}(
+                  &typed_args[i]));
+        }
+        return runtime_internal::AdaptedToHandleVisitor{}(
+            fn_(context.value_factory(), absl::MakeConstSpan(typed_args)));
+      }
+    }
+
+   private:
+    Fn fn_;
   };
 };
 
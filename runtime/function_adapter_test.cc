@@ -22,6 +22,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "base/function.h"
 #include "base/function_descriptor.h"
 #include "common/kind.h"
@@ -31,6 +32,7 @@
 #include "common/values/legacy_type_reflector.h"
 #include "common/values/legacy_value_manager.h"
 #include "internal/testing.h"
+#include "runtime/function_registry.h"
 
 namespace cel {
 namespace {
@@ -40,6 +42,17 @@ using testing::HasSubstr;
 using testing::IsEmpty;
 using cel::internal::StatusIs;
 
+int64_t AddTwo(ValueManager&, int64_t x) { return x + 2; }
+
+double Multiply(ValueManager&, double x, double y) { return x * y; }
+
+absl::StatusOr<Value> Describe(ValueManager& value_factory, int64_t int_val,
+                               bool bool_val, const StringValue& string_val) {
+  return value_factory.CreateStringValue(
+      absl::StrCat(int_val, "_", (bool_val ? "true" : "false"), "_",
+                   string_val.ToString()));
+}
+
 class FunctionAdapterTest : public ::testing::Test {
  public:
   FunctionAdapterTest()
@@ -796,5 +809,150 @@ TEST_F(FunctionAdapterTest,
                        HasSubstr("unexpected number of arguments")));
 }
 
+TEST_F(FunctionAdapterTest, UnaryFunctionAdapterWrapStaticFunction) {
+  using FunctionAdapter = UnaryFunctionAdapter<int64_t, int64_t>;
+
+  std::unique_ptr<Function> wrapped =
+      FunctionAdapter::WrapStaticFunction<&AddTwo>();
+
+  std::vector<Value> args{value_factory().CreateIntValue(40)};
+  ASSERT_OK_AND_ASSIGN(auto result, wrapped->Invoke(test_context(), args));
+
+  ASSERT_TRUE(result->Is<IntValue>());
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 42);
+}
+
+TEST_F(FunctionAdapterTest, BinaryFunctionAdapterWrapStaticFunction) {
+  using FunctionAdapter = BinaryFunctionAdapter<double, double, double>;
+
+  std::unique_ptr<Function> wrapped =
+      FunctionAdapter::WrapStaticFunction<&Multiply>();
+
+  std::vector<Value> args{value_factory().CreateDoubleValue(21.0),
+                          value_factory().CreateDoubleValue(2.0)};
+  ASSERT_OK_AND_ASSIGN(auto result, wrapped->Invoke(test_context(), args));
+
+  ASSERT_TRUE(result->Is<DoubleValue>());
+  EXPECT_EQ(result.As<DoubleValue>().NativeValue(), 42.0);
+
+  args.pop_back();
+  EXPECT_THAT(wrapped->Invoke(test_context(), args),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unexpected number of arguments")));
+}
+
+TEST_F(FunctionAdapterTest, VariadicFunctionAdapterWrapStaticFunction) {
+  std::unique_ptr<Function> fn =
+      VariadicFunctionAdapter<absl::StatusOr<Value>, int64_t, bool,
+                              const StringValue&>::
+          WrapStaticFunction<&Describe>();
+
+  std::vector<Value> args{value_factory().CreateIntValue(42),
+                          value_factory().CreateBoolValue(false)};
+  ASSERT_OK_AND_ASSIGN(args.emplace_back(),
+                       value_factory().CreateStringValue("abcd"));
+  ASSERT_OK_AND_ASSIGN(auto result, fn->Invoke(test_context(), args));
+  ASSERT_TRUE(result->Is<StringValue>());
+  EXPECT_EQ(result.As<StringValue>().ToString(), "42_false_abcd");
+}
+
+TEST_F(FunctionAdapterTest, RegisterStaticOverloads) {
+  FunctionRegistry registry;
+  ASSERT_OK((UnaryFunctionAdapter<int64_t, int64_t>::
+                 RegisterStaticGlobalOverload<&AddTwo>("add_two", registry)));
+  ASSERT_OK((BinaryFunctionAdapter<double, double, double>::
+                 RegisterStaticMemberOverload<&Multiply>("multiply",
+                                                         registry)));
+
+  auto overloads =
+      registry.FindStaticOverloads("add_two", false, {Kind::kInt});
+  ASSERT_EQ(overloads.size(), 1);
+  std::vector<Value> args{value_factory().CreateIntValue(40)};
+  ASSERT_OK_AND_ASSIGN(
+      auto result, overloads[0].implementation.Invoke(test_context(), args));
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 42);
+
+  EXPECT_EQ(registry
+                .FindStaticOverloads("multiply", true,
+                                     {Kind::kDouble, Kind::kDouble})
+                .size(),
+            1);
+}
+
+int64_t Sum(ValueManager&, absl::Span<const int64_t> xs) {
+  int64_t sum = 0;
+  for (int64_t x : xs) {
+    sum += x;
+  }
+  return sum;
+}
+
+TEST_F(FunctionAdapterTest, VariadicFunctionAdapterSpanCreateDescriptor) {
+  FunctionDescriptor desc =
+      VariadicFunctionAdapter<int64_t, absl::Span<const int64_t>>::
+          CreateDescriptor("sum", /*receiver_style=*/false, /*num_args=*/3);
+
+  EXPECT_EQ(desc.name(), "sum");
+  EXPECT_THAT(desc.types(), ElementsAre(Kind::kInt, Kind::kInt, Kind::kInt));
+}
+
+TEST_F(FunctionAdapterTest, VariadicFunctionAdapterSpanWrapStaticFunction) {
+  std::unique_ptr<Function> fn =
+      VariadicFunctionAdapter<int64_t, absl::Span<const int64_t>>::
+          WrapStaticFunction<&Sum>();
+
+  std::vector<Value> args;
+  for (int i = 0; i < 10; ++i) {
+    args.push_back(value_factory().CreateIntValue(i));
+  }
+  ASSERT_OK_AND_ASSIGN(auto result, fn->Invoke(test_context(), args));
+  ASSERT_TRUE(result->Is<IntValue>());
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 45);
+
+  args.push_back(value_factory().CreateBoolValue(true));
+  EXPECT_THAT(fn->Invoke(test_context(), args),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("expected int value")));
+}
+
+TEST_F(FunctionAdapterTest, VariadicFunctionAdapterSpanOfValues) {
+  const Value* first_arg = nullptr;
+  std::unique_ptr<Function> fn =
+      VariadicFunctionAdapter<absl::StatusOr<Value>,
+                              absl::Span<const Value>>::
+          WrapFunction([&](ValueManager& value_factory,
+                           absl::Span<const Value> values)
+                           -> absl::StatusOr<Value> {
+            first_arg = values.data();
+            return value_factory.CreateUintValue(values.size());
+          });
+
+  std::vector<Value> args{value_factory().CreateIntValue(1),
+                          value_factory().CreateBoolValue(false)};
+  ASSERT_OK_AND_ASSIGN(auto result, fn->Invoke(test_context(), args));
+  EXPECT_EQ(result.As<UintValue>().NativeValue(), 2);
+  // The values are viewed in place rather than copied.
+  EXPECT_EQ(first_arg, args.data());
+}
+
+TEST_F(FunctionAdapterTest, VariadicFunctionAdapterSpanRegister) {
+  FunctionRegistry registry;
+  ASSERT_OK(
+      (VariadicFunctionAdapter<int64_t, absl::Span<const int64_t>>::Register(
+          "sum", /*receiver_style=*/false, &Sum, /*min_args=*/1,
+          /*max_args=*/4, registry)));
+
+  EXPECT_THAT(registry.FindStaticOverloads("sum", false, {}), IsEmpty());
+  EXPECT_EQ(registry.FindStaticOverloads("sum", false, {Kind::kInt}).size(),
+            1);
+  EXPECT_EQ(registry
+                .FindStaticOverloads("sum", false,
+                                     {Kind::kInt, Kind::kInt, Kind::kInt,
+                                      Kind::kInt})
+                .size(),
+            1);
+  EXPECT_EQ(registry.ListFunctions()["sum"].size(), 4);
+}
+
 }  // namespace
 }  // namespace cel
@@ -0,0 +1,65 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_MEMOIZATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_MEMOIZATION_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "eval/eval/function_memoizer.h"
+#include "runtime/runtime_builder.h"
+
+namespace cel::extensions {
+
+// Counters for memoized calls: `evaluation_hits`, `cache_hits` and `misses`.
+using FunctionMemoizationStats =
+    google::api::expr::runtime::FunctionMemoizationStats;
+
+struct FunctionMemoizationOptions {
+  // Maximum number of results each program caches between evaluations. If
+  // zero, results are only reused within an evaluation.
+  size_t cache_capacity = 0;
+
+  // If set, counts the memoized calls of every program planned by the
+  // runtime.
+  std::shared_ptr<FunctionMemoizationStats> stats;
+};
+
+// Enable memoization of calls to pure functions in the runtime being built.
+//
+// Functions are marked pure with the `is_pure` argument of their
+// cel::FunctionDescriptor, meaning that their result only depends on their
+// arguments. Calls to them with the same arguments are then answered with
+// the result of the first call:
+//
+//  - within an evaluation, for results of any kind other than errors and
+//    unknowns.
+//  - across the evaluations of a program, for results of primitive kinds, if
+//    `options.cache_capacity` is non-zero. The cache evicts the least
+//    recently used results.
+//
+// Only calls with primitive arguments (null, bool, int, uint, double, string,
+// bytes, timestamp and duration) which resolve to eagerly bound overloads are
+// memoized. This is intended for expensive functions, such as remote lookups;
+// for cheap functions the lookup costs more than the call.
+//
+// If function specialization is also enabled, it should be enabled first.
+absl::Status EnableFunctionMemoization(
+    RuntimeBuilder& builder, const FunctionMemoizationOptions& options = {});
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_MEMOIZATION_H_
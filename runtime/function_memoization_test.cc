@@ -0,0 +1,196 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/function_memoization.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "base/function.h"
+#include "base/function_descriptor.h"
+#include "common/kind.h"
+#include "common/value.h"
+#include "extensions/protobuf/memory_manager.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+#include "google/protobuf/arena.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+// `lookup(string) -> string`, counting its calls.
+class LookupFunction : public Function {
+ public:
+  explicit LookupFunction(int& calls) : calls_(calls) {}
+
+  absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                               absl::Span<const Value> args) const override {
+    ++calls_;
+    return StringValue(
+        absl::StrCat("region-of-", args[0].As<StringValue>().ToString()));
+  }
+
+ private:
+  int& calls_;
+};
+
+enum class Planner { kStackMachine, kRecursive };
+
+class FunctionMemoizationTest : public testing::TestWithParam<Planner> {
+ protected:
+  // Plans `expression` with `lookup` registered, pure or not.
+  std::unique_ptr<Program> CreateProgram(
+      absl::string_view expression, bool is_pure,
+      const FunctionMemoizationOptions& memoization_options) {
+    RuntimeOptions options;
+    if (GetParam() == Planner::kRecursive) {
+      options.max_recursion_depth = -1;
+    }
+    auto builder = CreateStandardRuntimeBuilder(options);
+    EXPECT_OK(builder);
+    EXPECT_OK(builder->function_registry().Register(
+        FunctionDescriptor("lookup", /*receiver_style=*/false,
+                           {Kind::kString}, /*is_strict=*/true, is_pure),
+        std::make_unique<LookupFunction>(calls_)));
+    EXPECT_OK(EnableFunctionMemoization(*builder, memoization_options));
+    auto runtime = std::move(*builder).Build();
+    EXPECT_OK(runtime);
+    runtime_ = *std::move(runtime);
+
+    auto parsed_expr = Parse(expression);
+    EXPECT_OK(parsed_expr);
+    auto program =
+        ProtobufRuntimeAdapter::CreateProgram(*runtime_, *parsed_expr);
+    EXPECT_OK(program);
+    return *std::move(program);
+  }
+
+  // Evaluates `program` with its own arena, so that results cached between
+  // evaluations must not refer to the memory of an earlier one.
+  absl::StatusOr<std::string> Evaluate(const Program& program,
+                                       absl::string_view ip) {
+    google::protobuf::Arena arena;
+    ManagedValueFactory value_factory(program.GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    Activation activation;
+    activation.InsertOrAssignValue("ip", StringValue(ip));
+    auto result = program.Evaluate(activation, value_factory.get());
+    if (!result.ok()) {
+      return result.status();
+    }
+    if (!result->Is<StringValue>()) {
+      return absl::InternalError(result->DebugString());
+    }
+    return result->As<StringValue>().ToString();
+  }
+
+  int calls_ = 0;
+  std::unique_ptr<const Runtime> runtime_;
+};
+
+TEST_P(FunctionMemoizationTest, DedupesCallsWithinEvaluation) {
+  auto stats = std::make_shared<FunctionMemoizationStats>();
+  auto program = CreateProgram("lookup(ip) + '/' + lookup(ip)",
+                               /*is_pure=*/true, {0, stats});
+
+  ASSERT_OK_AND_ASSIGN(std::string result, Evaluate(*program, "10.0.0.1"));
+  EXPECT_EQ(result, "region-of-10.0.0.1/region-of-10.0.0.1");
+  EXPECT_EQ(calls_, 1);
+
+  // Without a cache, the next evaluation calls the function again.
+  ASSERT_OK_AND_ASSIGN(result, Evaluate(*program, "10.0.0.1"));
+  EXPECT_EQ(calls_, 2);
+  EXPECT_EQ(stats->evaluation_hits.load(), 2);
+  EXPECT_EQ(stats->cache_hits.load(), 0);
+  EXPECT_EQ(stats->misses.load(), 2);
+}
+
+TEST_P(FunctionMemoizationTest, DistinguishesArguments) {
+  auto program = CreateProgram("lookup(ip) + '/' + lookup(ip + '0')",
+                               /*is_pure=*/true, {16});
+
+  ASSERT_OK_AND_ASSIGN(std::string result, Evaluate(*program, "10.0.0.1"));
+  EXPECT_EQ(result, "region-of-10.0.0.1/region-of-10.0.0.10");
+  EXPECT_EQ(calls_, 2);
+}
+
+TEST_P(FunctionMemoizationTest, CachesAcrossEvaluations) {
+  auto stats = std::make_shared<FunctionMemoizationStats>();
+  auto program = CreateProgram("lookup(ip)", /*is_pure=*/true, {16, stats});
+
+  ASSERT_OK_AND_ASSIGN(std::string result, Evaluate(*program, "10.0.0.1"));
+  EXPECT_EQ(result, "region-of-10.0.0.1");
+  ASSERT_OK_AND_ASSIGN(result, Evaluate(*program, "10.0.0.1"));
+  EXPECT_EQ(result, "region-of-10.0.0.1");
+  ASSERT_OK_AND_ASSIGN(result, Evaluate(*program, "10.0.0.2"));
+  EXPECT_EQ(result, "region-of-10.0.0.2");
+
+  EXPECT_EQ(calls_, 2);
+  EXPECT_EQ(stats->evaluation_hits.load(), 0);
+  EXPECT_EQ(stats->cache_hits.load(), 1);
+  EXPECT_EQ(stats->misses.load(), 2);
+}
+
+TEST_P(FunctionMemoizationTest, CacheIsBounded) {
+  auto program = CreateProgram("lookup(ip)", /*is_pure=*/true, {1});
+
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_OK(Evaluate(*program, absl::StrCat("10.0.0.", i)));
+  }
+  EXPECT_EQ(calls_, 64);
+  // The most recent result is still cached.
+  ASSERT_OK(Evaluate(*program, "10.0.0.63"));
+  EXPECT_EQ(calls_, 64);
+
+  // Each of the 16 shards keeps at most one result, so most of the others
+  // were evicted.
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_OK(Evaluate(*program, absl::StrCat("10.0.0.", i)));
+  }
+  EXPECT_GE(calls_, 64 + 48);
+}
+
+TEST_P(FunctionMemoizationTest, ImpureFunctionsNotMemoized) {
+  auto stats = std::make_shared<FunctionMemoizationStats>();
+  auto program = CreateProgram("lookup(ip) + '/' + lookup(ip)",
+                               /*is_pure=*/false, {16, stats});
+
+  ASSERT_OK_AND_ASSIGN(std::string result, Evaluate(*program, "10.0.0.1"));
+  EXPECT_EQ(result, "region-of-10.0.0.1/region-of-10.0.0.1");
+  EXPECT_EQ(calls_, 2);
+  EXPECT_EQ(stats->misses.load(), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(FunctionMemoizationTest, FunctionMemoizationTest,
+                         testing::Values(Planner::kStackMachine,
+                                         Planner::kRecursive));
+
+}  // namespace
+}  // namespace cel::extensions
@@ -14,6 +14,8 @@
 
 #include "runtime/function_registry.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -119,6 +121,9 @@ FunctionRegistry::FindStaticOverloads(absl::string_view name,
                                       bool receiver_style,
                                       absl::Span<const cel::Kind> types) const {
   std::vector<cel::FunctionOverloadReference> matched_funcs;
+  if (base_ != nullptr) {
+    matched_funcs = base_->FindStaticOverloads(name, receiver_style, types);
+  }
 
   auto overloads = functions_.find(name);
   if (overloads == functions_.end()) {
@@ -138,6 +143,9 @@ std::vector<FunctionRegistry::LazyOverload> FunctionRegistry::FindLazyOverloads(
     absl::string_view name, bool receiver_style,
     absl::Span<const cel::Kind> types) const {
   std::vector<FunctionRegistry::LazyOverload> matched_funcs;
+  if (base_ != nullptr) {
+    matched_funcs = base_->FindLazyOverloads(name, receiver_style, types);
+  }
 
   auto overloads = functions_.find(name);
   if (overloads == functions_.end()) {
@@ -157,11 +165,16 @@ absl::node_hash_map<std::string, std::vector<const cel::FunctionDescriptor*>>
 FunctionRegistry::ListFunctions() const {
   absl::node_hash_map<std::string, std::vector<const cel::FunctionDescriptor*>>
       descriptor_map;
+  if (base_ != nullptr) {
+    descriptor_map = base_->ListFunctions();
+  }
 
   for (const auto& entry : functions_) {
-    std::vector<const cel::FunctionDescriptor*> descriptors;
+    std::vector<const cel::FunctionDescriptor*>& descriptors =
+        descriptor_map[entry.first];
     const RegistryEntry& function_entry = entry.second;
-    descriptors.reserve(function_entry.static_overloads.size() +
+    descriptors.reserve(descriptors.size() +
+                        function_entry.static_overloads.size() +
                         function_entry.lazy_overloads.size());
     for (const auto& entry : function_entry.static_overloads) {
       descriptors.push_back(entry.descriptor.get());
@@ -169,12 +182,75 @@ FunctionRegistry::ListFunctions() const {
     for (const auto& entry : function_entry.lazy_overloads) {
       descriptors.push_back(entry.descriptor.get());
     }
-    descriptor_map[entry.first] = std::move(descriptors);
   }
 
   return descriptor_map;
 }
 
+void FunctionRegistry::CollectDescriptors(
+    std::vector<std::pair<const cel::FunctionDescriptor*, bool>>& descriptors)
+    const {
+  if (base_ != nullptr) {
+    base_->CollectDescriptors(descriptors);
+  }
+  for (const auto& entry : functions_) {
+    for (const auto& overload : entry.second.static_overloads) {
+      descriptors.push_back({overload.descriptor.get(), false});
+    }
+    for (const auto& overload : entry.second.lazy_overloads) {
+      descriptors.push_back({overload.descriptor.get(), true});
+    }
+  }
+}
+
+uint64_t FunctionRegistry::DescriptorFingerprint() const {
+  if (fingerprint_.has_value()) {
+    return *fingerprint_;
+  }
+  std::vector<std::pair<const cel::FunctionDescriptor*, bool>> descriptors;
+  CollectDescriptors(descriptors);
+  // The map is unordered, so hash the descriptors in a canonical order.
+  std::sort(descriptors.begin(), descriptors.end(),
+            [](const auto& lhs, const auto& rhs) {
+              if (*lhs.first < *rhs.first) return true;
+              if (*rhs.first < *lhs.first) return false;
+              return lhs.second < rhs.second;
+            });
+
+  // FNV-1a, as absl::Hash is only stable within a process.
+  uint64_t fingerprint = 0xcbf29ce484222325;
+  auto mix = [&fingerprint](uint8_t byte) {
+    fingerprint ^= byte;
+    fingerprint *= 0x100000001b3;
+  };
+  for (const auto& [descriptor, lazy] : descriptors) {
+    for (char c : descriptor->name()) {
+      mix(static_cast<uint8_t>(c));
+    }
+    // Terminates the name, which may not contain a NUL.
+    mix(0);
+    mix(descriptor->receiver_style());
+    mix(descriptor->is_strict());
+    mix(lazy);
+    mix(static_cast<uint8_t>(descriptor->types().size()));
+    for (cel::Kind kind : descriptor->types()) {
+      mix(static_cast<uint8_t>(kind));
+    }
+  }
+  return fingerprint;
+}
+
+std::shared_ptr<const FunctionRegistry> FunctionRegistry::Freeze() && {
+  for (auto& entry : functions_) {
+    entry.second.static_overloads.shrink_to_fit();
+    entry.second.lazy_overloads.shrink_to_fit();
+  }
+  functions_.rehash(0);
+  auto frozen = std::make_shared<FunctionRegistry>(std::move(*this));
+  frozen->fingerprint_ = frozen->DescriptorFingerprint();
+  return frozen;
+}
+
 bool FunctionRegistry::DescriptorRegistered(
     const cel::FunctionDescriptor& descriptor) const {
   return !(FindStaticOverloads(descriptor.name(), descriptor.receiver_style(),
@@ -187,6 +263,9 @@ bool FunctionRegistry::DescriptorRegistered(
 
 bool FunctionRegistry::ValidateNonStrictOverload(
     const cel::FunctionDescriptor& descriptor) const {
+  if (base_ != nullptr && !base_->ValidateNonStrictOverload(descriptor)) {
+    return false;
+  }
   auto overloads = functions_.find(descriptor.name());
   if (overloads == functions_.end()) {
     return true;
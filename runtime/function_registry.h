@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_REGISTRY_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_REGISTRY_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,6 +25,7 @@
 #include "absl/container/node_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "base/function.h"
 #include "base/function_descriptor.h"
@@ -42,6 +44,11 @@ namespace cel {
 // The registry takes ownership of the cel::Function objects -- the registry
 // must outlive any program planned using it.
 //
+// A registry may extend an immutable base registry, such as the one returned by
+// GetStandardFunctionRegistry, which can be shared by any number of
+// registries. Lookups include the overloads of the base, and registering an
+// overload which conflicts with one of the base fails.
+//
 // This class is move-only.
 class FunctionRegistry {
  public:
@@ -53,6 +60,11 @@ class FunctionRegistry {
 
   FunctionRegistry() = default;
 
+  // Creates a registry extending `base`, which must not be modified
+  // afterwards.
+  explicit FunctionRegistry(std::shared_ptr<const FunctionRegistry> base)
+      : base_(std::move(base)) {}
+
   // Move-only
   FunctionRegistry(FunctionRegistry&&) = default;
   FunctionRegistry& operator=(FunctionRegistry&&) = default;
@@ -103,6 +115,22 @@ class FunctionRegistry {
   absl::node_hash_map<std::string, std::vector<const cel::FunctionDescriptor*>>
   ListFunctions() const;
 
+  // Returns a fingerprint of the registered descriptors, including whether
+  // they are lazy, but not of the implementations.
+  //
+  // The fingerprint only depends on the set of descriptors, and is stable
+  // across processes and builds. It identifies whether artifacts planned
+  // against one registry are compatible with another.
+  uint64_t DescriptorFingerprint() const;
+
+  // Returns the registry this one extends, if any.
+  const std::shared_ptr<const FunctionRegistry>& base() const { return base_; }
+
+  // Consumes the registry, returning an immutable snapshot of it to be shared
+  // as the base of other registries. The storage of the snapshot is compacted
+  // and its descriptor fingerprint is computed once.
+  std::shared_ptr<const FunctionRegistry> Freeze() &&;
+
  private:
   struct StaticFunctionEntry {
     StaticFunctionEntry(const cel::FunctionDescriptor& descriptor,
@@ -143,6 +171,15 @@ class FunctionRegistry {
   bool ValidateNonStrictOverload(
       const cel::FunctionDescriptor& descriptor) const;
 
+  // Appends the descriptors of this registry and its bases, paired with
+  // whether they are lazy.
+  void CollectDescriptors(
+      std::vector<std::pair<const cel::FunctionDescriptor*, bool>>&
+          descriptors) const;
+
+  std::shared_ptr<const FunctionRegistry> base_;
+  // Set once the registry is frozen.
+  absl::optional<uint64_t> fingerprint_;
   // indexed by function name (not type checker overload id).
   absl::flat_hash_map<std::string, RegistryEntry> functions_;
 };
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <memory>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -108,6 +109,104 @@ TEST(FunctionRegistryTest, ListFunctions) {
   EXPECT_THAT(registered_functions["ConstFunction"], SizeIs(1));
 }
 
+TEST(FunctionRegistryTest, DescriptorFingerprint) {
+  cel::FunctionDescriptor lazy_function_desc{"LazyFunction", false, {}};
+  FunctionRegistry registry;
+  FunctionRegistry reordered_registry;
+  FunctionRegistry lazy_registry;
+  EXPECT_EQ(registry.DescriptorFingerprint(),
+            reordered_registry.DescriptorFingerprint());
+
+  ASSERT_OK(registry.RegisterLazyFunction(lazy_function_desc));
+  ASSERT_OK(registry.Register(ConstIntFunction::MakeDescriptor(),
+                              std::make_unique<ConstIntFunction>()));
+  ASSERT_OK(reordered_registry.Register(ConstIntFunction::MakeDescriptor(),
+                                        std::make_unique<ConstIntFunction>()));
+  ASSERT_OK(reordered_registry.RegisterLazyFunction(lazy_function_desc));
+  ASSERT_OK(lazy_registry.RegisterLazyFunction(lazy_function_desc));
+  ASSERT_OK(
+      lazy_registry.RegisterLazyFunction(ConstIntFunction::MakeDescriptor()));
+
+  EXPECT_EQ(registry.DescriptorFingerprint(),
+            reordered_registry.DescriptorFingerprint());
+  EXPECT_NE(registry.DescriptorFingerprint(),
+            lazy_registry.DescriptorFingerprint());
+
+  FunctionRegistry empty_registry;
+  EXPECT_NE(registry.DescriptorFingerprint(),
+            empty_registry.DescriptorFingerprint());
+}
+
+TEST(FunctionRegistryTest, ExtendsBaseRegistry) {
+  auto base = std::make_shared<FunctionRegistry>();
+  ASSERT_OK(base->Register(ConstIntFunction::MakeDescriptor(),
+                           std::make_unique<ConstIntFunction>()));
+  cel::FunctionDescriptor lazy_function_desc{"LazyFunction", false, {}};
+
+  FunctionRegistry registry(base);
+  FunctionRegistry other_registry(base);
+  ASSERT_OK(registry.RegisterLazyFunction(lazy_function_desc));
+
+  EXPECT_THAT(registry.FindStaticOverloads("ConstFunction", false, {}),
+              SizeIs(1));
+  EXPECT_THAT(registry.FindLazyOverloads("LazyFunction", false, {}),
+              SizeIs(1));
+  EXPECT_THAT(other_registry.FindLazyOverloads("LazyFunction", false, {}),
+              SizeIs(0));
+  EXPECT_THAT(registry.Register(ConstIntFunction::MakeDescriptor(),
+                                std::make_unique<ConstIntFunction>()),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+
+  auto registered_functions = registry.ListFunctions();
+  EXPECT_THAT(registered_functions, SizeIs(2));
+  EXPECT_THAT(registered_functions["ConstFunction"], SizeIs(1));
+
+  FunctionRegistry flat_registry;
+  ASSERT_OK(flat_registry.Register(ConstIntFunction::MakeDescriptor(),
+                                   std::make_unique<ConstIntFunction>()));
+  ASSERT_OK(flat_registry.RegisterLazyFunction(lazy_function_desc));
+  EXPECT_EQ(registry.DescriptorFingerprint(),
+            flat_registry.DescriptorFingerprint());
+}
+
+TEST(FunctionRegistryTest, Freeze) {
+  cel::FunctionDescriptor lazy_function_desc{"LazyFunction", false, {}};
+  FunctionRegistry registry;
+  ASSERT_OK(registry.Register(ConstIntFunction::MakeDescriptor(),
+                              std::make_unique<ConstIntFunction>()));
+  ASSERT_OK(registry.RegisterLazyFunction(lazy_function_desc));
+  uint64_t fingerprint = registry.DescriptorFingerprint();
+
+  std::shared_ptr<const FunctionRegistry> frozen = std::move(registry).Freeze();
+  EXPECT_EQ(frozen->DescriptorFingerprint(), fingerprint);
+  EXPECT_THAT(frozen->FindStaticOverloads("ConstFunction", false, {}),
+              SizeIs(1));
+  EXPECT_THAT(frozen->FindLazyOverloads("LazyFunction", false, {}), SizeIs(1));
+
+  FunctionRegistry tenant_registry(frozen);
+  cel::FunctionDescriptor tenant_desc{"TenantFunction", false, {}};
+  ASSERT_OK(tenant_registry.RegisterLazyFunction(tenant_desc));
+  EXPECT_THAT(tenant_registry.ListFunctions(), SizeIs(3));
+  EXPECT_NE(tenant_registry.DescriptorFingerprint(), fingerprint);
+  EXPECT_EQ(frozen->DescriptorFingerprint(), fingerprint);
+}
+
+TEST(FunctionRegistryTest, BaseRegistryNonStrictOverload) {
+  auto base = std::make_shared<FunctionRegistry>();
+  cel::FunctionDescriptor non_strict_desc{
+      "NonStrictFunction", false, {}, /*is_strict=*/false};
+  ASSERT_OK(
+      base->Register(non_strict_desc, std::make_unique<ConstIntFunction>()));
+
+  FunctionRegistry registry(base);
+  cel::FunctionDescriptor strict_desc{
+      "NonStrictFunction", false, {cel::Kind::kInt}, /*is_strict=*/true};
+  EXPECT_THAT(
+      registry.Register(strict_desc, std::make_unique<ConstIntFunction>()),
+      StatusIs(absl::StatusCode::kAlreadyExists,
+               HasSubstr("Only one overload")));
+}
+
 TEST(FunctionRegistryTest, DefaultLazyProviderNoOverloadFound) {
   FunctionRegistry registry;
   Activation activation;
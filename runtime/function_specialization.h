@@ -0,0 +1,36 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_SPECIALIZATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_SPECIALIZATION_H_
+
+#include "absl/status/status.h"
+#include "runtime/runtime_builder.h"
+
+namespace cel::extensions {
+
+// Enable function specialization in the runtime being built.
+//
+// Calls with constant arguments which resolve to a single eagerly bound
+// overload are planned with the implementation returned by
+// cel::Function::Specialize, if any, e.g. to parse a constant pattern once
+// when the program is planned rather than on every call.
+//
+// If constant folding is also enabled, it should be enabled first so that
+// folded arguments are seen as constants.
+absl::Status EnableFunctionSpecialization(RuntimeBuilder& builder);
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_FUNCTION_SPECIALIZATION_H_
@@ -0,0 +1,200 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/function_specialization.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/function.h"
+#include "base/function_descriptor.h"
+#include "common/kind.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/constant_folding.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+// `has_prefix(string, string)`, specialized for a constant prefix.
+class HasPrefixFunction : public Function {
+ public:
+  static FunctionDescriptor MakeDescriptor() {
+    return FunctionDescriptor("has_prefix", /*receiver_style=*/false,
+                              {Kind::kString, Kind::kString});
+  }
+
+  explicit HasPrefixFunction(int& specialized_calls)
+      : specialized_calls_(specialized_calls) {}
+
+  absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                               absl::Span<const Value> args) const override {
+    return BoolValue(absl::StartsWith(args[0].As<StringValue>().ToString(),
+                                      args[1].As<StringValue>().ToString()));
+  }
+
+  absl::StatusOr<std::unique_ptr<Function>> Specialize(
+      ValueManager& value_factory,
+      absl::Span<const absl::optional<Value>> constant_args) const override {
+    if (!constant_args[1].has_value()) {
+      return nullptr;
+    }
+    return std::make_unique<ConstantPrefixFunction>(
+        constant_args[1]->As<StringValue>().ToString(), specialized_calls_);
+  }
+
+ private:
+  class ConstantPrefixFunction : public Function {
+   public:
+    ConstantPrefixFunction(std::string prefix, int& calls)
+        : prefix_(std::move(prefix)), calls_(calls) {}
+
+    absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                                 absl::Span<const Value> args) const override {
+      ++calls_;
+      return BoolValue(
+          absl::StartsWith(args[0].As<StringValue>().ToString(), prefix_));
+    }
+
+   private:
+    std::string prefix_;
+    int& calls_;
+  };
+
+  int& specialized_calls_;
+};
+
+struct TestCase {
+  std::string expression;
+  bool expected_result;
+  int expected_specialized_calls;
+  // Whether the constant argument is only seen with constant folding.
+  bool needs_folding = false;
+};
+
+enum class Planner { kStackMachine, kRecursive };
+
+class FunctionSpecializationTest
+    : public testing::TestWithParam<std::tuple<TestCase, Planner, bool>> {};
+
+TEST_P(FunctionSpecializationTest, Evaluate) {
+  const auto& [test_case, planner, constant_folding] = GetParam();
+  RuntimeOptions options;
+  if (planner == Planner::kRecursive) {
+    options.max_recursion_depth = -1;
+  }
+  ASSERT_OK_AND_ASSIGN(RuntimeBuilder builder,
+                       CreateStandardRuntimeBuilder(options));
+  int specialized_calls = 0;
+  ASSERT_OK(builder.function_registry().Register(
+      HasPrefixFunction::MakeDescriptor(),
+      std::make_unique<HasPrefixFunction>(specialized_calls)));
+  if (constant_folding) {
+    ASSERT_OK(
+        EnableConstantFolding(builder, MemoryManagerRef::ReferenceCounting()));
+  }
+  ASSERT_OK(EnableFunctionSpecialization(builder));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  ASSERT_OK_AND_ASSIGN(ParsedExpr parsed_expr, Parse(test_case.expression));
+  ASSERT_OK_AND_ASSIGN(auto program, ProtobufRuntimeAdapter::CreateProgram(
+                                         *runtime, parsed_expr));
+
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  Activation activation;
+  activation.InsertOrAssignValue("path", StringValue("/admin/users"));
+  activation.InsertOrAssignValue("prefix", StringValue("/admin"));
+
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory.get()));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<BoolValue>().NativeValue(), test_case.expected_result);
+  EXPECT_EQ(specialized_calls,
+            test_case.needs_folding && !constant_folding
+                ? 0
+                : test_case.expected_specialized_calls);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    FunctionSpecializationTest, FunctionSpecializationTest,
+    testing::Combine(
+        testing::Values(
+            TestCase{"has_prefix(path, '/admin')", true, 1},
+            TestCase{"has_prefix(path, '/users')", false, 1},
+            TestCase{"has_prefix(path, '/ad' + 'min')", true, 1,
+                     /*needs_folding=*/true},
+            TestCase{"has_prefix(path, prefix)", true, 0},
+            TestCase{"has_prefix(path, '/a') && has_prefix(path, prefix)",
+                     true, 1}),
+        testing::Values(Planner::kStackMachine, Planner::kRecursive),
+        testing::Bool()));
+
+TEST(FunctionSpecializationTest, TimestampAccessorsWithConstantTimeZone) {
+  ASSERT_OK_AND_ASSIGN(RuntimeBuilder builder,
+                       CreateStandardRuntimeBuilder(RuntimeOptions()));
+  ASSERT_OK(EnableFunctionSpecialization(builder));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  ManagedValueFactory value_factory(runtime->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  Activation activation;
+  activation.InsertOrAssignValue(
+      "ts", TimestampValue(absl::FromUnixSeconds(1705321800)));
+  activation.InsertOrAssignValue("tz", StringValue("America/New_York"));
+
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr parsed_expr,
+      Parse("ts.getHours('America/New_York') == 7 && "
+            "ts.getHours(tz) == 7 && ts.getMinutes('+05:30') == 0 && "
+            "ts.getDayOfWeek('America/New_York') == 1"));
+  ASSERT_OK_AND_ASSIGN(auto program, ProtobufRuntimeAdapter::CreateProgram(
+                                         *runtime, parsed_expr));
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory.get()));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+
+  ASSERT_OK_AND_ASSIGN(parsed_expr, Parse("ts.getHours('Mars/Olympus_Mons')"));
+  ASSERT_OK_AND_ASSIGN(program, ProtobufRuntimeAdapter::CreateProgram(
+                                    *runtime, parsed_expr));
+  ASSERT_OK_AND_ASSIGN(result,
+                       program->Evaluate(activation, value_factory.get()));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue().message(),
+              testing::HasSubstr("Invalid timezone"));
+}
+
+}  // namespace
+}  // namespace cel::extensions
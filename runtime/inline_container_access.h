@@ -0,0 +1,39 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INLINE_CONTAINER_ACCESS_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_INLINE_CONTAINER_ACCESS_H_
+
+#include "absl/status/status.h"
+#include "runtime/runtime_builder.h"
+
+namespace cel::extensions {
+
+// Enable inline container access in the runtime being built.
+//
+// Optional indexing (`container[?key]`) and, in checked expressions, map
+// membership tests (`key in map`) are evaluated in a single step which looks
+// up the key directly instead of dispatching the call through the function
+// registry. Constant keys are hashed when planning. Arguments that are errors,
+// unknowns or of an unexpected kind still use the registered overloads, so
+// results are unchanged.
+//
+// Only valid if the standard membership functions and the optional type
+// functions (see `EnableOptionalTypes`) are not replaced with custom
+// implementations. Calls are left alone if they aren't registered.
+absl::Status EnableInlineContainerAccess(RuntimeBuilder& builder);
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_INLINE_CONTAINER_ACCESS_H_
@@ -0,0 +1,209 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/inline_container_access.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/options.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/optional_types.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::parser::ParserOptions;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+struct TestOptions {
+  bool recursive = false;
+  bool enable_heterogeneous_equality = true;
+  bool inline_container_access = false;
+};
+
+absl::StatusOr<std::unique_ptr<const Runtime>> CreateRuntime(
+    const TestOptions& test_options) {
+  RuntimeOptions options;
+  options.enable_qualified_type_identifiers = true;
+  options.enable_heterogeneous_equality =
+      test_options.enable_heterogeneous_equality;
+  if (test_options.recursive) {
+    options.max_recursion_depth = -1;
+  }
+  CEL_ASSIGN_OR_RETURN(RuntimeBuilder builder,
+                       CreateStandardRuntimeBuilder(options));
+  if (test_options.enable_heterogeneous_equality) {
+    CEL_RETURN_IF_ERROR(EnableOptionalTypes(builder));
+  }
+  if (test_options.inline_container_access) {
+    CEL_RETURN_IF_ERROR(EnableInlineContainerAccess(builder));
+  }
+  return std::move(builder).Build();
+}
+
+// Evaluates `expression`, as if checked with the root call resolved to
+// `overload_id` if it isn't empty, and returns the debug string of the result
+// or the evaluation status.
+std::string Evaluate(const TestOptions& test_options,
+                     absl::string_view expression,
+                     absl::string_view overload_id) {
+  auto runtime = CreateRuntime(test_options);
+  if (!runtime.ok()) {
+    return runtime.status().ToString();
+  }
+  auto parsed_expr = Parse(expression, "<input>",
+                           ParserOptions{.enable_optional_syntax = true});
+  if (!parsed_expr.ok()) {
+    return parsed_expr.status().ToString();
+  }
+  absl::StatusOr<std::unique_ptr<TraceableProgram>> program;
+  if (overload_id.empty()) {
+    program = ProtobufRuntimeAdapter::CreateProgram(**runtime, *parsed_expr);
+  } else {
+    CheckedExpr checked_expr;
+    checked_expr.mutable_expr()->Swap(parsed_expr->mutable_expr());
+    checked_expr.mutable_source_info()->Swap(
+        parsed_expr->mutable_source_info());
+    (*checked_expr.mutable_reference_map())[checked_expr.expr().id()]
+        .add_overload_id(std::string(overload_id));
+    program = ProtobufRuntimeAdapter::CreateProgram(**runtime, checked_expr);
+  }
+  if (!program.ok()) {
+    return program.status().ToString();
+  }
+
+  ManagedValueFactory value_factory((*program)->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  Activation activation;
+  absl::StatusOr<Value> result =
+      (*program)->Evaluate(activation, value_factory.get());
+  if (!result.ok()) {
+    return result.status().ToString();
+  }
+  return result->DebugString();
+}
+
+struct TestCase {
+  absl::string_view expression;
+  absl::string_view overload_id;
+  absl::string_view expected;
+};
+
+class InlineContainerAccessTest : public testing::TestWithParam<bool> {
+ protected:
+  // Checks that `test_case` has the expected result, and the same one as
+  // without the extension.
+  void ExpectSameResult(const TestCase& test_case,
+                        bool enable_heterogeneous_equality = true) {
+    TestOptions options;
+    options.recursive = GetParam();
+    options.enable_heterogeneous_equality = enable_heterogeneous_equality;
+    std::string expected =
+        Evaluate(options, test_case.expression, test_case.overload_id);
+    options.inline_container_access = true;
+    std::string actual =
+        Evaluate(options, test_case.expression, test_case.overload_id);
+    EXPECT_EQ(actual, expected) << test_case.expression;
+    if (!test_case.expected.empty()) {
+      EXPECT_THAT(actual, testing::HasSubstr(test_case.expected))
+          << test_case.expression;
+    }
+  }
+};
+
+TEST_P(InlineContainerAccessTest, OptionalIndex) {
+  const TestCase kCases[] = {
+      {"{'a': 1}[?'a'].value()", "", "1"},
+      {"{'a': 1}[?'b'].hasValue()", "", "false"},
+      {"{1: 'x'}[?1u].value()", "", "\"x\""},
+      {"{1u: 'x'}[?1].value()", "", "\"x\""},
+      {"{1: 'x'}[?1.0].value()", "", "\"x\""},
+      {"{1: 'x'}[?1.5].hasValue()", "", "false"},
+      {"{true: 'x'}[?true].value()", "", "\"x\""},
+      {"[1, 2][?1].value()", "", "2"},
+      {"[1, 2][?2].hasValue()", "", "false"},
+      {"[1, 2][?-1].hasValue()", "", "false"},
+      {"optional.of({'a': 1})[?'a'].value()", "", "1"},
+      {"optional.none()[?'a'].hasValue()", "", "false"},
+      {"optional.of([1])[?0].value()", "", "1"},
+      {"optional.of([1])[?'a']", "", "No matching overloads"},
+      {"[1][?1u]", "", "No matching overloads"},
+      {"1[?1]", "", "No matching overloads"},
+      {"{'a': 1}[?[1]]", "", ""},
+      {"{'a': 1}[?1/0]", "", "divide by zero"},
+      {"(1/0)[?1]", "", "divide by zero"},
+      {"{'a': 1}[?'a']", "map_optindex_optional_value", "1"},
+      {"optional.of([1])[?0]", "optional_list_optindex_optional_int", "1"},
+  };
+  for (const TestCase& test_case : kCases) {
+    ExpectSameResult(test_case);
+  }
+}
+
+TEST_P(InlineContainerAccessTest, MapMembership) {
+  const TestCase kCases[] = {
+      {"'a' in {'a': 1}", "in_map", "true"},
+      {"'b' in {'a': 1}", "in_map", "false"},
+      {"true in {true: 1}", "in_map", "true"},
+      {"1u in {1: 2}", "in_map", "true"},
+      {"1 in {1u: 2}", "in_map", "true"},
+      {"-1 in {1u: 2}", "in_map", "false"},
+      {"1.0 in {1: 2}", "in_map", "true"},
+      {"1.5 in {1: 2}", "in_map", "false"},
+      {"[1] in {1: 2}", "in_map", "No matching overloads"},
+      {"1/0 in {1: 2}", "in_map", "divide by zero"},
+      {"1 in [1, 2]", "in_map", "true"},
+      {"'a' in {'a': 1}", "", "true"},
+  };
+  for (const TestCase& test_case : kCases) {
+    ExpectSameResult(test_case);
+  }
+}
+
+TEST_P(InlineContainerAccessTest, MapMembershipHomogeneousEquality) {
+  const TestCase kCases[] = {
+      {"'a' in {'a': 1}", "in_map", "true"},
+      {"1 in {1: 2}", "in_map", "true"},
+      {"1u in {1: 2}", "in_map", ""},
+      {"1.0 in {1: 2}", "in_map", "No matching overloads"},
+  };
+  for (const TestCase& test_case : kCases) {
+    ExpectSameResult(test_case, /*enable_heterogeneous_equality=*/false);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(InlineContainerAccessTest, InlineContainerAccessTest,
+                         testing::Bool());
+
+}  // namespace
+}  // namespace cel::extensions
@@ -0,0 +1,37 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INLINE_NUMERIC_COMPARISONS_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_INLINE_NUMERIC_COMPARISONS_H_
+
+#include "absl/status/status.h"
+#include "runtime/runtime_builder.h"
+
+namespace cel::extensions {
+
+// Enable inline numeric comparisons in the runtime being built.
+//
+// Equality and ordering calls whose operand kinds aren't known when planning
+// compare int, uint and double operands inline, including mixed kinds such as
+// `1 < 2u` or `dyn(x) == 1.0`, instead of resolving the overload on each
+// call. Arguments that are errors, unknowns or not numbers still use the
+// registered overloads, so results are unchanged.
+//
+// Only valid if the standard comparison and equality functions are registered
+// and not replaced with custom implementations.
+absl::Status EnableInlineNumericComparisons(RuntimeBuilder& builder);
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_INLINE_NUMERIC_COMPARISONS_H_
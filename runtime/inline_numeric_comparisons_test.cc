@@ -0,0 +1,168 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/inline_numeric_comparisons.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+constexpr int64_t kInt64Max = std::numeric_limits<int64_t>::max();
+constexpr int64_t kInt64Min = std::numeric_limits<int64_t>::min();
+constexpr uint64_t kUint64Max = std::numeric_limits<uint64_t>::max();
+
+// Evaluates `expression` with `x` and `y` bound to the given values and
+// returns the debug string of the result, so results with and without the
+// extension can be compared.
+absl::StatusOr<std::string> Evaluate(const RuntimeOptions& options,
+                                     bool enable_extension,
+                                     absl::string_view expression,
+                                     Value x, Value y) {
+  CEL_ASSIGN_OR_RETURN(RuntimeBuilder builder,
+                       CreateStandardRuntimeBuilder(options));
+  if (enable_extension) {
+    CEL_RETURN_IF_ERROR(EnableInlineNumericComparisons(builder));
+  }
+  CEL_ASSIGN_OR_RETURN(auto runtime, std::move(builder).Build());
+  CEL_ASSIGN_OR_RETURN(ParsedExpr parsed_expr, Parse(expression));
+  CEL_ASSIGN_OR_RETURN(
+      auto program, ProtobufRuntimeAdapter::CreateProgram(*runtime,
+                                                          parsed_expr));
+
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  Activation activation;
+  activation.InsertOrAssignValue("x", std::move(x));
+  activation.InsertOrAssignValue("y", std::move(y));
+  CEL_ASSIGN_OR_RETURN(Value result,
+                       program->Evaluate(activation, value_factory.get()));
+  return result.DebugString();
+}
+
+class InlineNumericComparisonsTest : public testing::TestWithParam<bool> {
+ protected:
+  RuntimeOptions Options() const {
+    RuntimeOptions options;
+    if (GetParam()) {
+      options.max_recursion_depth = -1;
+    }
+    return options;
+  }
+
+  void ExpectSameResult(const RuntimeOptions& options, Value x, Value y) {
+    constexpr absl::string_view kExpressions[] = {
+        "x == y", "x != y", "x < y",  "x <= y",
+        "x > y",  "x >= y", "x < y || y < x",
+    };
+    for (absl::string_view expression : kExpressions) {
+      ASSERT_OK_AND_ASSIGN(std::string expected,
+                           Evaluate(options, /*enable_extension=*/false,
+                                    expression, x, y));
+      ASSERT_OK_AND_ASSIGN(std::string actual,
+                           Evaluate(options, /*enable_extension=*/true,
+                                    expression, x, y));
+      EXPECT_EQ(actual, expected)
+          << expression << " with x = " << x.DebugString()
+          << ", y = " << y.DebugString();
+    }
+  }
+};
+
+TEST_P(InlineNumericComparisonsTest, MixedNumbers) {
+  const std::vector<Value> values = {
+      IntValue(0),
+      IntValue(-1),
+      IntValue(1),
+      IntValue(kInt64Max),
+      IntValue(kInt64Min),
+      UintValue(0),
+      UintValue(1),
+      UintValue(static_cast<uint64_t>(kInt64Max)),
+      UintValue(static_cast<uint64_t>(kInt64Max) + 1),
+      UintValue(kUint64Max),
+      DoubleValue(0.0),
+      DoubleValue(-0.5),
+      DoubleValue(1.0),
+      DoubleValue(9223372036854775807.0),
+      DoubleValue(18446744073709551615.0),
+      DoubleValue(-9223372036854775808.0),
+      DoubleValue(std::numeric_limits<double>::infinity()),
+      DoubleValue(std::numeric_limits<double>::quiet_NaN()),
+  };
+  for (const Value& x : values) {
+    for (const Value& y : values) {
+      ExpectSameResult(Options(), x, y);
+    }
+  }
+}
+
+TEST_P(InlineNumericComparisonsTest, HomogeneousEquality) {
+  RuntimeOptions options = Options();
+  options.enable_heterogeneous_equality = false;
+  ExpectSameResult(options, IntValue(1), IntValue(1));
+  ExpectSameResult(options, IntValue(1), UintValue(1));
+  ExpectSameResult(options, UintValue(2), DoubleValue(2.0));
+  ExpectSameResult(options, DoubleValue(1.5), DoubleValue(2.5));
+}
+
+TEST_P(InlineNumericComparisonsTest, OtherKindsUseGenericDispatch) {
+  ExpectSameResult(Options(), StringValue("a"), StringValue("b"));
+  ExpectSameResult(Options(), BoolValue(true), BoolValue(false));
+  ExpectSameResult(Options(), IntValue(1), StringValue("1"));
+  ExpectSameResult(Options(), NullValue(), DoubleValue(0.0));
+}
+
+TEST_P(InlineNumericComparisonsTest, Errors) {
+  for (absl::string_view expression :
+       {"1 / 0 < 2u", "2.0 >= 1 / 0", "1 / 0 == 1", "x < 1 / 0"}) {
+    ASSERT_OK_AND_ASSIGN(std::string expected,
+                         Evaluate(Options(), /*enable_extension=*/false,
+                                  expression, IntValue(1), IntValue(2)));
+    ASSERT_OK_AND_ASSIGN(std::string actual,
+                         Evaluate(Options(), /*enable_extension=*/true,
+                                  expression, IntValue(1), IntValue(2)));
+    EXPECT_EQ(actual, expected) << expression;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(InlineNumericComparisonsTest,
+                         InlineNumericComparisonsTest, testing::Bool());
+
+}  // namespace
+}  // namespace cel::extensions
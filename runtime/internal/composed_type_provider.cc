@@ -13,28 +13,80 @@
 // limitations under the License.
 #include "runtime/internal/composed_type_provider.h"
 
+#include <cstddef>
 #include <memory>
+#include <utility>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "common/type.h"
 #include "internal/status_macros.h"
 
 namespace cel::runtime_internal {
 
-absl::StatusOr<absl::optional<Unique<StructValueBuilder>>>
-ComposedTypeProvider::NewStructValueBuilder(ValueFactory& value_factory,
-                                            StructTypeView type) const {
-  for (const std::unique_ptr<TypeProvider>& provider : providers_) {
-    CEL_ASSIGN_OR_RETURN(auto builder,
-                         provider->NewStructValueBuilder(value_factory, type));
-    if (builder.has_value()) {
-      return builder;
+absl::optional<size_t> ComposedTypeProvider::FindCachedProvider(
+    absl::string_view type_name) const {
+  absl::ReaderMutexLock lock(&cache_->mutex);
+  if (auto it = cache_->providers.find(type_name);
+      it != cache_->providers.end()) {
+    return it->second;
+  }
+  return absl::nullopt;
+}
+
+void ComposedTypeProvider::CacheProvider(absl::string_view type_name,
+                                         size_t index) const {
+  absl::MutexLock lock(&cache_->mutex);
+  cache_->providers.insert_or_assign(type_name, index);
+}
+
+void ComposedTypeProvider::ClearProviderCache() {
+  absl::MutexLock lock(&cache_->mutex);
+  cache_->providers.clear();
+}
+
+template <typename Lookup>
+auto ComposedTypeProvider::FindWithProviderCache(
+    absl::string_view type_name, const Lookup& lookup) const
+    -> decltype(lookup(std::declval<const TypeProvider&>())) {
+  // With a single provider there is nothing to skip.
+  const bool use_cache = providers_.size() > 1;
+  absl::optional<size_t> cached =
+      use_cache ? FindCachedProvider(type_name) : absl::nullopt;
+  if (cached.has_value()) {
+    CEL_ASSIGN_OR_RETURN(auto result, lookup(*providers_[*cached]));
+    if (result.has_value()) {
+      return result;
+    }
+  }
+  for (size_t i = 0; i < providers_.size(); ++i) {
+    if (cached.has_value() && i == *cached) {
+      continue;
+    }
+    CEL_ASSIGN_OR_RETURN(auto result, lookup(*providers_[i]));
+    if (result.has_value()) {
+      if (use_cache) {
+        CacheProvider(type_name, i);
+      }
+      return result;
     }
   }
   return absl::nullopt;
 }
 
+absl::StatusOr<absl::optional<Unique<StructValueBuilder>>>
+ComposedTypeProvider::NewStructValueBuilder(ValueFactory& value_factory,
+                                            StructTypeView type) const {
+  return FindWithProviderCache(
+      type.name(),
+      [&](const TypeProvider& provider)
+          -> absl::StatusOr<absl::optional<Unique<StructValueBuilder>>> {
+        return provider.NewStructValueBuilder(value_factory, type);
+      });
+}
+
 absl::StatusOr<absl::optional<ValueView>> ComposedTypeProvider::FindValue(
     ValueFactory& value_factory, absl::string_view name, Value& scratch) const {
   for (const std::unique_ptr<TypeProvider>& provider : providers_) {
@@ -63,28 +115,25 @@ ComposedTypeProvider::DeserializeValueImpl(ValueFactory& value_factory,
 
 absl::StatusOr<absl::optional<TypeView>> ComposedTypeProvider::FindTypeImpl(
     TypeFactory& type_factory, absl::string_view name, Type& scratch) const {
-  for (const std::unique_ptr<TypeProvider>& provider : providers_) {
-    CEL_ASSIGN_OR_RETURN(auto result,
-                         provider->FindType(type_factory, name, scratch));
-    if (result.has_value()) {
-      return result;
-    }
-  }
-  return absl::nullopt;
+  return FindWithProviderCache(
+      name,
+      [&](const TypeProvider& provider)
+          -> absl::StatusOr<absl::optional<TypeView>> {
+        return provider.FindType(type_factory, name, scratch);
+      });
 }
 
 absl::StatusOr<absl::optional<StructTypeFieldView>>
 ComposedTypeProvider::FindStructTypeFieldByNameImpl(
     TypeFactory& type_factory, absl::string_view type, absl::string_view name,
     StructTypeField& scratch) const {
-  for (const std::unique_ptr<TypeProvider>& provider : providers_) {
-    CEL_ASSIGN_OR_RETURN(auto result, provider->FindStructTypeFieldByName(
-                                          type_factory, type, name, scratch));
-    if (result.has_value()) {
-      return result;
-    }
-  }
-  return absl::nullopt;
+  return FindWithProviderCache(
+      type,
+      [&](const TypeProvider& provider)
+          -> absl::StatusOr<absl::optional<StructTypeFieldView>> {
+        return provider.FindStructTypeFieldByName(type_factory, type, name,
+                                                  scratch);
+      });
 }
 
 }  // namespace cel::runtime_internal
@@ -14,10 +14,17 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_COMPOSED_TYPE_PROVIDER_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_COMPOSED_TYPE_PROVIDER_H_
 
+#include <cstddef>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "base/type_provider.h"
 
 namespace cel::runtime_internal {
@@ -30,11 +37,23 @@ namespace cel::runtime_internal {
 //
 // The builtin type provider is implicitly consulted first in a type manager,
 // so it is not represented here.
+//
+// With several providers, the provider which resolved a type name is
+// remembered, so that later lookups of the type, its fields and its builders
+// go straight to it instead of walking the providers again. Only the index of
+// the provider is remembered, as the types themselves may be allocated by the
+// factory of the lookup. The memo is cleared when a provider is added.
 class ComposedTypeProvider : public TypeProvider {
  public:
+  ComposedTypeProvider() = default;
+
+  ComposedTypeProvider(ComposedTypeProvider&&) = default;
+  ComposedTypeProvider& operator=(ComposedTypeProvider&&) = default;
+
   // Register an additional type provider.
   void AddTypeProvider(std::unique_ptr<TypeProvider> provider) {
     providers_.push_back(std::move(provider));
+    ClearProviderCache();
   }
 
   absl::StatusOr<absl::optional<Unique<StructValueBuilder>>>
@@ -61,7 +80,29 @@ class ComposedTypeProvider : public TypeProvider {
 
   // Implements TypeProvider
  private:
+  struct ProviderCache {
+    absl::Mutex mutex;
+    absl::flat_hash_map<std::string, size_t> providers ABSL_GUARDED_BY(mutex);
+  };
+
+  // Returns the index of the provider which last resolved `type_name`, if
+  // any.
+  absl::optional<size_t> FindCachedProvider(absl::string_view type_name) const;
+
+  void CacheProvider(absl::string_view type_name, size_t index) const;
+
+  void ClearProviderCache();
+
+  // Returns the first result of `lookup` for the providers, consulting the
+  // provider which last resolved `type_name` first.
+  template <typename Lookup>
+  auto FindWithProviderCache(absl::string_view type_name,
+                             const Lookup& lookup) const
+      -> decltype(lookup(std::declval<const TypeProvider&>()));
+
   std::vector<std::unique_ptr<TypeProvider>> providers_;
+  // Held by pointer so that the provider stays movable.
+  std::unique_ptr<ProviderCache> cache_ = std::make_unique<ProviderCache>();
 };
 
 }  // namespace cel::runtime_internal
@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/composed_type_provider.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/memory.h"
+#include "common/type.h"
+#include "common/type_factory.h"
+#include "common/type_reflector.h"
+#include "common/value_testing.h"
+#include "internal/testing.h"
+
+namespace cel::runtime_internal {
+namespace {
+
+using testing::Eq;
+using testing::IsFalse;
+using testing::IsTrue;
+using cel::internal::IsOkAndHolds;
+
+// Resolves the given type names, each with a single field `field`, and counts
+// the lookups it is asked for.
+class CountingTypeProvider : public TypeReflector {
+ public:
+  explicit CountingTypeProvider(absl::flat_hash_set<std::string> types)
+      : types_(std::move(types)) {}
+
+  int type_lookups() const { return type_lookups_; }
+  int field_lookups() const { return field_lookups_; }
+
+ protected:
+  absl::StatusOr<absl::optional<TypeView>> FindTypeImpl(
+      TypeFactory&, absl::string_view name, Type&) const override {
+    ++type_lookups_;
+    if (types_.contains(name)) {
+      return IntTypeView();
+    }
+    return absl::nullopt;
+  }
+
+  absl::StatusOr<absl::optional<StructTypeFieldView>>
+  FindStructTypeFieldByNameImpl(TypeFactory&, absl::string_view type,
+                                absl::string_view name,
+                                StructTypeField&) const override {
+    ++field_lookups_;
+    if (types_.contains(type) && name == "field") {
+      return StructTypeFieldView{"field", IntTypeView(), 1};
+    }
+    return absl::nullopt;
+  }
+
+ private:
+  absl::flat_hash_set<std::string> types_;
+  mutable int type_lookups_ = 0;
+  mutable int field_lookups_ = 0;
+};
+
+class ComposedTypeProviderTest
+    : public common_internal::ThreadCompatibleValueTest<> {
+ public:
+  void SetUp() override {
+    common_internal::ThreadCompatibleValueTest<>::SetUp();
+    auto first = std::make_unique<CountingTypeProvider>(
+        absl::flat_hash_set<std::string>{"test.First"});
+    auto second = std::make_unique<CountingTypeProvider>(
+        absl::flat_hash_set<std::string>{"test.Second"});
+    first_ = first.get();
+    second_ = second.get();
+    provider_.AddTypeProvider(std::move(first));
+    provider_.AddTypeProvider(std::move(second));
+  }
+
+  bool HasType(absl::string_view name) {
+    auto type = provider_.FindType(type_factory(), name);
+    ABSL_CHECK_OK(type.status());
+    return type->has_value();
+  }
+
+ protected:
+  ComposedTypeProvider provider_;
+  CountingTypeProvider* first_ = nullptr;
+  CountingTypeProvider* second_ = nullptr;
+};
+
+TEST_P(ComposedTypeProviderTest, RemembersResolvingProvider) {
+  EXPECT_THAT(HasType("test.Second"), IsTrue());
+  EXPECT_THAT(first_->type_lookups(), Eq(1));
+  EXPECT_THAT(second_->type_lookups(), Eq(1));
+
+  EXPECT_THAT(HasType("test.Second"), IsTrue());
+  EXPECT_THAT(first_->type_lookups(), Eq(1));
+  EXPECT_THAT(second_->type_lookups(), Eq(2));
+
+  ASSERT_OK_AND_ASSIGN(auto field, provider_.FindStructTypeFieldByName(
+                                       type_factory(), "test.Second", "field"));
+  EXPECT_THAT(field.has_value(), IsTrue());
+  EXPECT_THAT(first_->field_lookups(), Eq(0));
+  EXPECT_THAT(second_->field_lookups(), Eq(1));
+}
+
+TEST_P(ComposedTypeProviderTest, FallsBackWhenCachedProviderMisses) {
+  EXPECT_THAT(HasType("test.First"), IsTrue());
+  EXPECT_THAT(provider_.FindStructTypeFieldByName(type_factory(), "test.First",
+                                                  "missing"),
+              IsOkAndHolds(Eq(absl::nullopt)));
+  EXPECT_THAT(first_->field_lookups(), Eq(1));
+  EXPECT_THAT(second_->field_lookups(), Eq(1));
+}
+
+TEST_P(ComposedTypeProviderTest, UnknownTypesAreNotRemembered) {
+  EXPECT_THAT(HasType("test.Unknown"), IsFalse());
+  EXPECT_THAT(HasType("test.Unknown"), IsFalse());
+  EXPECT_THAT(first_->type_lookups(), Eq(2));
+  EXPECT_THAT(second_->type_lookups(), Eq(2));
+}
+
+TEST_P(ComposedTypeProviderTest, AddingProviderClearsMemo) {
+  EXPECT_THAT(HasType("test.Second"), IsTrue());
+  provider_.AddTypeProvider(std::make_unique<CountingTypeProvider>(
+      absl::flat_hash_set<std::string>{}));
+
+  EXPECT_THAT(HasType("test.Second"), IsTrue());
+  EXPECT_THAT(first_->type_lookups(), Eq(2));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ComposedTypeProviderTest, ComposedTypeProviderTest,
+    ::testing::Values(MemoryManagement::kPooling,
+                      MemoryManagement::kReferenceCounting));
+
+}  // namespace
+}  // namespace cel::runtime_internal
@@ -0,0 +1,220 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/concat_list_value.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "common/casting.h"
+#include "common/internal/allocation_counter.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "internal/casts.h"
+#include "internal/status_macros.h"
+
+namespace cel::runtime_internal {
+
+namespace {
+
+// A list which is the concatenation of two or more non-empty parts.
+class ConcatListValue final : public ParsedListValueInterface {
+ public:
+  // Returns the concatenation if `value` is one.
+  static const ConcatListValue* AsConcat(const ListValue& value) {
+    if (auto parsed = As<ParsedListValue>(value);
+        parsed.has_value() &&
+        NativeTypeId::Of(*parsed) == NativeTypeId::For<ConcatListValue>()) {
+      return &cel::internal::down_cast<const ConcatListValue&>(
+          *(*parsed).operator->());
+    }
+    return nullptr;
+  }
+
+  explicit ConcatListValue(std::vector<ListValue> parts,
+                           std::vector<size_t> ends)
+      : parts_(std::move(parts)), ends_(std::move(ends)) {}
+
+  const std::vector<ListValue>& parts() const { return parts_; }
+
+  std::string DebugString() const override {
+    return absl::StrJoin(parts_, " + ",
+                         [](std::string* out, const ListValue& part) {
+                           out->append(part.DebugString());
+                         });
+  }
+
+  size_t Size() const override { return ends_.back(); }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter& converter) const override {
+    JsonArrayBuilder builder;
+    builder.reserve(Size());
+    for (const auto& part : parts_) {
+      CEL_ASSIGN_OR_RETURN(auto json_part, part.ConvertToJsonArray(converter));
+      for (const auto& element : json_part) {
+        builder.push_back(element);
+      }
+    }
+    return std::move(builder).Build();
+  }
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachCallback callback) const override {
+    bool done = false;
+    for (size_t i = 0; i < parts_.size() && !done; ++i) {
+      CEL_RETURN_IF_ERROR(parts_[i].ForEach(
+          value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+            CEL_ASSIGN_OR_RETURN(auto ok, callback(element));
+            done = !ok;
+            return ok;
+          }));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachWithIndexCallback callback) const override {
+    bool done = false;
+    for (size_t i = 0; i < parts_.size() && !done; ++i) {
+      const size_t offset = i == 0 ? 0 : ends_[i - 1];
+      CEL_RETURN_IF_ERROR(parts_[i].ForEach(
+          value_manager,
+          [&](size_t index, ValueView element) -> absl::StatusOr<bool> {
+            CEL_ASSIGN_OR_RETURN(auto ok, callback(offset + index, element));
+            done = !ok;
+            return ok;
+          }));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<ValueView> Contains(
+      ValueManager& value_manager, ValueView other,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const override {
+    for (const auto& part : parts_) {
+      CEL_ASSIGN_OR_RETURN(auto result,
+                           part.Contains(value_manager, other, scratch));
+      if (auto bool_result = As<BoolValueView>(result);
+          bool_result.has_value() && bool_result->NativeValue()) {
+        return *bool_result;
+      }
+    }
+    return BoolValueView{false};
+  }
+
+ protected:
+  Type GetTypeImpl(TypeManager& type_manager) const override {
+    return ListType(type_manager.GetDynListType());
+  }
+
+ private:
+  absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
+                                    Value& scratch) const override {
+    const size_t i =
+        std::upper_bound(ends_.begin(), ends_.end(), index) - ends_.begin();
+    return parts_[i].Get(value_manager, i == 0 ? index : index - ends_[i - 1],
+                         scratch);
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<ConcatListValue>();
+  }
+
+  const std::vector<ListValue> parts_;
+  // The index one past the last element of each part in the concatenation.
+  const std::vector<size_t> ends_;
+};
+
+void AppendParts(const ListValue& value, std::vector<ListValue>& parts) {
+  if (const auto* concat = ConcatListValue::AsConcat(value);
+      concat != nullptr) {
+    parts.insert(parts.end(), concat->parts().begin(), concat->parts().end());
+  } else {
+    parts.push_back(value);
+  }
+}
+
+absl::StatusOr<ListValue> FlatConcat(ValueManager& value_manager,
+                                     const ListValue& lhs,
+                                     const ListValue& rhs) {
+  CEL_ASSIGN_OR_RETURN(auto list_builder, value_manager.NewListValueBuilder(
+                                              value_manager.GetDynListType()));
+  CEL_ASSIGN_OR_RETURN(auto lhs_size, lhs.Size());
+  CEL_ASSIGN_OR_RETURN(auto rhs_size, rhs.Size());
+  list_builder->Reserve(lhs_size + rhs_size);
+  for (const ListValue* operand : {&lhs, &rhs}) {
+    CEL_RETURN_IF_ERROR(operand->ForEach(
+        value_manager, [&](ValueView element) -> absl::StatusOr<bool> {
+          CEL_RETURN_IF_ERROR(list_builder->Add(Value(element)));
+          return true;
+        }));
+  }
+  return std::move(*list_builder).Build();
+}
+
+}  // namespace
+
+absl::StatusOr<ListValue> ConcatListValues(ValueManager& value_manager,
+                                           const ListValue& lhs,
+                                           const ListValue& rhs) {
+  std::vector<ListValue> parts;
+  AppendParts(lhs, parts);
+  AppendParts(rhs, parts);
+  if (parts.size() > kMaxConcatListParts) {
+    return FlatConcat(value_manager, lhs, rhs);
+  }
+  std::vector<ListValue> non_empty_parts;
+  non_empty_parts.reserve(parts.size());
+  std::vector<size_t> ends;
+  ends.reserve(parts.size());
+  size_t size = 0;
+  for (auto& part : parts) {
+    CEL_ASSIGN_OR_RETURN(auto part_size, part.Size());
+    if (part_size == 0) {
+      continue;
+    }
+    size += part_size;
+    ends.push_back(size);
+    non_empty_parts.push_back(std::move(part));
+  }
+  switch (non_empty_parts.size()) {
+    case 0:
+      return lhs;
+    case 1:
+      return std::move(non_empty_parts.front());
+    default:
+      // The parts are allocated by the vectors rather than the memory manager,
+      // so they are counted against any allocation budget here.
+      common_internal::CountAllocation(
+          non_empty_parts.capacity() * sizeof(ListValue) +
+          ends.capacity() * sizeof(size_t));
+      return ListValue(ParsedListValue(
+          value_manager.GetMemoryManager().MakeShared<ConcatListValue>(
+              std::move(non_empty_parts), std::move(ends))));
+  }
+}
+
+}  // namespace cel::runtime_internal
@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_CONCAT_LIST_VALUE_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_CONCAT_LIST_VALUE_H_
+
+#include <cstddef>
+
+#include "absl/status/statusor.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel::runtime_internal {
+
+// Operands of a concatenation beyond this number of parts are copied into a
+// flat list instead of being viewed in place.
+inline constexpr size_t kMaxConcatListParts = 16;
+
+// Returns the concatenation of `lhs` and `rhs`, viewing the elements of both
+// operands in place rather than copying them. Operands which are themselves
+// concatenations contribute their parts, so that the result is at most one
+// level deep. Indexing is logarithmic in the number of parts, and `ForEach`
+// and `Contains` stream through the parts.
+absl::StatusOr<ListValue> ConcatListValues(ValueManager& value_manager,
+                                           const ListValue& lhs,
+                                           const ListValue& rhs);
+
+}  // namespace cel::runtime_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_CONCAT_LIST_VALUE_H_
@@ -0,0 +1,160 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/concat_list_value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "base/type_provider.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "common/values/legacy_value_manager.h"
+#include "internal/testing.h"
+
+namespace cel::runtime_internal {
+namespace {
+
+using cel::internal::IsOkAndHolds;
+using testing::ElementsAre;
+
+class ConcatListValueTest : public testing::Test {
+ public:
+  ConcatListValueTest()
+      : value_factory_(MemoryManagerRef::ReferenceCounting(),
+                       TypeProvider::Builtin()) {}
+
+ protected:
+  ListValue MakeList(std::vector<int64_t> elements) {
+    auto builder = value_factory_.NewListValueBuilder(
+        value_factory_.GetDynListType());
+    ABSL_CHECK_OK(builder.status());
+    for (int64_t element : elements) {
+      ABSL_CHECK_OK((*builder)->Add(IntValue(element)));
+    }
+    return std::move(**builder).Build();
+  }
+
+  std::vector<int64_t> Elements(const ListValue& list) {
+    std::vector<int64_t> elements;
+    ABSL_CHECK_OK(list.ForEach(
+        value_factory_, [&](ValueView element) -> absl::StatusOr<bool> {
+          elements.push_back(Cast<IntValueView>(element).NativeValue());
+          return true;
+        }));
+    return elements;
+  }
+
+  common_internal::LegacyValueManager value_factory_;
+};
+
+TEST_F(ConcatListValueTest, Get) {
+  ASSERT_OK_AND_ASSIGN(
+      ListValue list,
+      ConcatListValues(value_factory_, MakeList({1, 2}), MakeList({3})));
+  EXPECT_THAT(list.Size(), IsOkAndHolds(3));
+  for (int64_t i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(Value element, list.Get(value_factory_, i));
+    EXPECT_EQ(Cast<IntValue>(element).NativeValue(), i + 1);
+  }
+  EXPECT_FALSE(list.Get(value_factory_, 3).ok());
+}
+
+TEST_F(ConcatListValueTest, ForEachWithIndex) {
+  ASSERT_OK_AND_ASSIGN(
+      ListValue list,
+      ConcatListValues(value_factory_, MakeList({10, 11}), MakeList({12})));
+  std::vector<size_t> indices;
+  ASSERT_OK(list.ForEach(
+      value_factory_,
+      [&](size_t index, ValueView element) -> absl::StatusOr<bool> {
+        EXPECT_EQ(Cast<IntValueView>(element).NativeValue(),
+                  static_cast<int64_t>(10 + index));
+        indices.push_back(index);
+        return true;
+      }));
+  EXPECT_THAT(indices, ElementsAre(0, 1, 2));
+}
+
+TEST_F(ConcatListValueTest, ForEachStopsEarly) {
+  ASSERT_OK_AND_ASSIGN(
+      ListValue list,
+      ConcatListValues(value_factory_, MakeList({1, 2}), MakeList({3, 4})));
+  std::vector<int64_t> elements;
+  ASSERT_OK(list.ForEach(
+      value_factory_, [&](ValueView element) -> absl::StatusOr<bool> {
+        elements.push_back(Cast<IntValueView>(element).NativeValue());
+        return elements.size() < 3;
+      }));
+  EXPECT_THAT(elements, ElementsAre(1, 2, 3));
+}
+
+TEST_F(ConcatListValueTest, Contains) {
+  ASSERT_OK_AND_ASSIGN(
+      ListValue list,
+      ConcatListValues(value_factory_, MakeList({1, 2}), MakeList({3})));
+  ASSERT_OK_AND_ASSIGN(Value found, list.Contains(value_factory_, IntValue(3)));
+  EXPECT_TRUE(Cast<BoolValue>(found).NativeValue());
+  ASSERT_OK_AND_ASSIGN(Value not_found,
+                       list.Contains(value_factory_, IntValue(4)));
+  EXPECT_FALSE(Cast<BoolValue>(not_found).NativeValue());
+}
+
+TEST_F(ConcatListValueTest, EmptyOperand) {
+  ASSERT_OK_AND_ASSIGN(
+      ListValue list,
+      ConcatListValues(value_factory_, MakeList({}), MakeList({1, 2})));
+  EXPECT_THAT(Elements(list), ElementsAre(1, 2));
+  ASSERT_OK_AND_ASSIGN(
+      list, ConcatListValues(value_factory_, MakeList({}), MakeList({})));
+  EXPECT_THAT(list.IsEmpty(), IsOkAndHolds(true));
+}
+
+TEST_F(ConcatListValueTest, NestedConcatenations) {
+  ASSERT_OK_AND_ASSIGN(
+      ListValue lhs,
+      ConcatListValues(value_factory_, MakeList({1}), MakeList({2, 3})));
+  ASSERT_OK_AND_ASSIGN(
+      ListValue rhs,
+      ConcatListValues(value_factory_, MakeList({4, 5}), MakeList({6})));
+  ASSERT_OK_AND_ASSIGN(ListValue list,
+                       ConcatListValues(value_factory_, lhs, rhs));
+  EXPECT_THAT(Elements(list), ElementsAre(1, 2, 3, 4, 5, 6));
+  ASSERT_OK_AND_ASSIGN(Value element, list.Get(value_factory_, 3));
+  EXPECT_EQ(Cast<IntValue>(element).NativeValue(), 4);
+}
+
+TEST_F(ConcatListValueTest, FlattensManyParts) {
+  ListValue list = MakeList({0});
+  std::vector<int64_t> expected = {0};
+  for (int64_t i = 1; i < 3 * kMaxConcatListParts; ++i) {
+    ASSERT_OK_AND_ASSIGN(list,
+                         ConcatListValues(value_factory_, list, MakeList({i})));
+    expected.push_back(i);
+  }
+  EXPECT_EQ(Elements(list), expected);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_OK_AND_ASSIGN(Value element, list.Get(value_factory_, i));
+    EXPECT_EQ(Cast<IntValue>(element).NativeValue(), expected[i]);
+  }
+}
+
+}  // namespace
+}  // namespace cel::runtime_internal
@@ -17,15 +17,18 @@
 #include <cstdint>
 #include <string>
 
+#include "absl/base/nullability.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
 #include "absl/types/variant.h"
 #include "base/ast_internal/expr.h"
 #include "common/constant.h"
+#include "common/internal/string_intern_pool.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "eval/internal/errors.h"
+#include "internal/utf8.h"
 
 namespace cel::runtime_internal {
 namespace {
@@ -33,6 +36,7 @@ using ::cel::ast_internal::Constant;
 
 struct ConvertVisitor {
   cel::ValueManager& value_factory;
+  absl::Nullable<cel::common_internal::StringInternPool*> string_pool;
 
   absl::StatusOr<cel::Value> operator()(absl::monostate) {
     return absl::InvalidArgumentError("unspecified constant");
@@ -54,7 +58,17 @@ struct ConvertVisitor {
     return value_factory.CreateDoubleValue(value);
   }
   absl::StatusOr<cel::Value> operator()(const cel::StringConstant& value) {
-    return value_factory.CreateUncheckedStringValue(value);
+    cel::StringValue string_value =
+        string_pool != nullptr
+            ? cel::StringValue(string_pool->Intern(value))
+            : value_factory.CreateUncheckedStringValue(value);
+    // Constants are converted once per plan, so pay for the scan here to let
+    // size and index operations on the constant skip decoding it.
+    if (auto [count, ok] = cel::internal::Utf8Validate(value);
+        ok && count == value.size()) {
+      cel::common_internal::MarkAsciiStringValue(string_value);
+    }
+    return string_value;
   }
   absl::StatusOr<cel::Value> operator()(const cel::BytesConstant& value) {
     return value_factory.CreateBytesValue(value);
@@ -75,9 +89,11 @@ struct ConvertVisitor {
 // given value factory.
 //
 // A status maybe returned if value creation fails.
-absl::StatusOr<Value> ConvertConstant(const Constant& constant,
-                                      ValueManager& value_factory) {
-  return absl::visit(ConvertVisitor{value_factory}, constant.constant_kind());
+absl::StatusOr<Value> ConvertConstant(
+    const Constant& constant, ValueManager& value_factory,
+    absl::Nullable<common_internal::StringInternPool*> string_pool) {
+  return absl::visit(ConvertVisitor{value_factory, string_pool},
+                     constant.constant_kind());
 }
 
 }  // namespace cel::runtime_internal
@@ -14,8 +14,10 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_CONVERT_CONSTANT_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_CONVERT_CONSTANT_H_
 
+#include "absl/base/nullability.h"
 #include "absl/status/statusor.h"
 #include "base/ast_internal/expr.h"
+#include "common/internal/string_intern_pool.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 
@@ -31,8 +33,12 @@ namespace cel::runtime_internal {
 //
 // A status may still be returned if value creation fails according to
 // value_factory's policy.
-absl::StatusOr<Value> ConvertConstant(const ast_internal::Constant& constant,
-                                      ValueManager& value_factory);
+//
+// If `string_pool` is not null, string constants are interned in it instead,
+// so that equal constants of a program share their bytes and hash.
+absl::StatusOr<Value> ConvertConstant(
+    const ast_internal::Constant& constant, ValueManager& value_factory,
+    absl::Nullable<common_internal::StringInternPool*> string_pool = nullptr);
 
 }  // namespace cel::runtime_internal
 
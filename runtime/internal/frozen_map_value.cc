@@ -0,0 +1,359 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/frozen_map_value.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "internal/status_macros.h"
+
+namespace cel::runtime_internal {
+
+namespace {
+
+// The average number of entries per bucket of the perfect hash. Larger
+// buckets need fewer seeds, but take longer to place.
+constexpr size_t kEntriesPerBucket = 4;
+
+// The number of seeds tried for a bucket before giving up.
+constexpr uint32_t kMaxSeed = uint32_t{1} << 20;
+
+// Returns the slot among `slot_count` of the entry with `hash`, given the seed
+// of its bucket.
+inline size_t SlotOf(size_t hash, uint32_t seed, size_t slot_count) {
+  uint64_t x = static_cast<uint64_t>(hash) ^
+               (uint64_t{seed} * uint64_t{0x9e3779b97f4a7c15});
+  x ^= x >> 33;
+  x *= uint64_t{0xff51afd7ed558ccd};
+  x ^= x >> 33;
+  return static_cast<size_t>(x % slot_count);
+}
+
+// Map keys are only equal if they are of the same kind, like the keys of the
+// maps created by `MapValueBuilder`.
+bool KeyEqual(ValueView lhs, ValueView rhs) {
+  if (lhs.kind() != rhs.kind()) {
+    return false;
+  }
+  switch (lhs.kind()) {
+    case ValueKind::kBool:
+      return Cast<BoolValueView>(lhs) == Cast<BoolValueView>(rhs);
+    case ValueKind::kInt:
+      return Cast<IntValueView>(lhs) == Cast<IntValueView>(rhs);
+    case ValueKind::kUint:
+      return Cast<UintValueView>(lhs) == Cast<UintValueView>(rhs);
+    case ValueKind::kString:
+      return Cast<StringValueView>(lhs) == Cast<StringValueView>(rhs);
+    default:
+      return false;
+  }
+}
+
+// Orders keys by kind and then by value, like the debug string of the maps
+// created by `MapValueBuilder`.
+bool KeyLess(ValueView lhs, ValueView rhs) {
+  if (lhs.kind() != rhs.kind()) {
+    return lhs.kind() < rhs.kind();
+  }
+  switch (lhs.kind()) {
+    case ValueKind::kBool:
+      return Cast<BoolValueView>(lhs) < Cast<BoolValueView>(rhs);
+    case ValueKind::kInt:
+      return Cast<IntValueView>(lhs) < Cast<IntValueView>(rhs);
+    case ValueKind::kUint:
+      return Cast<UintValueView>(lhs) < Cast<UintValueView>(rhs);
+    case ValueKind::kString:
+      return Cast<StringValueView>(lhs) < Cast<StringValueView>(rhs);
+    default:
+      return false;
+  }
+}
+
+struct FrozenMapEntry {
+  size_t hash;
+  Value key;
+  Value value;
+};
+
+class FrozenMapKeyIterator final : public ValueIterator {
+ public:
+  explicit FrozenMapKeyIterator(
+      const std::vector<FrozenMapEntry>& entries ABSL_ATTRIBUTE_LIFETIME_BOUND)
+      : begin_(entries.begin()), end_(entries.end()) {}
+
+  bool HasNext() override { return begin_ != end_; }
+
+  absl::StatusOr<ValueView> Next(ValueManager&, Value&) override {
+    if (ABSL_PREDICT_FALSE(begin_ == end_)) {
+      return absl::FailedPreconditionError(
+          "ValueIterator::Next() called when "
+          "ValueIterator::HasNext() returns false");
+    }
+    ValueView key = begin_->key;
+    ++begin_;
+    return key;
+  }
+
+ private:
+  std::vector<FrozenMapEntry>::const_iterator begin_;
+  const std::vector<FrozenMapEntry>::const_iterator end_;
+};
+
+// An immutable map whose entry for a key is at the slot given by the seed of
+// the bucket of the key.
+class FrozenMapValue final : public ParsedMapValueInterface {
+ public:
+  // `entries` are ordered by slot, and `seeds` has one seed per bucket.
+  FrozenMapValue(std::vector<FrozenMapEntry> entries,
+                 std::vector<uint32_t> seeds)
+      : entries_(std::move(entries)), seeds_(std::move(seeds)) {}
+
+  std::string DebugString() const override {
+    std::vector<const FrozenMapEntry*> entries;
+    entries.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+      entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const FrozenMapEntry* lhs, const FrozenMapEntry* rhs) {
+                return KeyLess(lhs->key, rhs->key);
+              });
+    return absl::StrCat(
+        "{",
+        absl::StrJoin(entries, ", ",
+                      [](std::string* out, const FrozenMapEntry* entry) {
+                        absl::StrAppend(out, entry->key.DebugString(), ": ",
+                                        entry->value.DebugString());
+                      }),
+        "}");
+  }
+
+  bool IsEmpty() const override { return false; }
+
+  size_t Size() const override { return entries_.size(); }
+
+  absl::StatusOr<JsonObject> ConvertToJsonObject(
+      AnyToJsonConverter& converter) const override {
+    JsonObjectBuilder builder;
+    builder.reserve(Size());
+    for (const auto& entry : entries_) {
+      if (!InstanceOf<StringValue>(entry.key)) {
+        return TypeConversionError(
+                   absl::StrCat("map<", entry.key.GetTypeName(), ", ?>"),
+                   "google.protobuf.Struct")
+            .NativeValue();
+      }
+      CEL_ASSIGN_OR_RETURN(auto json_value,
+                           entry.value.ConvertToJson(converter));
+      builder.insert(std::pair{Cast<StringValue>(entry.key).NativeCord(),
+                               std::move(json_value)});
+    }
+    return std::move(builder).Build();
+  }
+
+  absl::StatusOr<ListValueView> ListKeys(ValueManager& value_manager,
+                                         ListValue& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto keys, value_manager.NewListValueBuilder(
+                                        value_manager.GetDynListType()));
+    keys->Reserve(Size());
+    for (const auto& entry : entries_) {
+      CEL_RETURN_IF_ERROR(keys->Add(entry.key));
+    }
+    scratch = std::move(*keys).Build();
+    return scratch;
+  }
+
+  absl::Status ForEach(ValueManager& value_manager,
+                       ForEachCallback callback) const override {
+    for (const auto& entry : entries_) {
+      CEL_ASSIGN_OR_RETURN(auto ok, callback(entry.key, entry.value));
+      if (!ok) {
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<absl::Nonnull<ValueIteratorPtr>> NewIterator(
+      ValueManager&) const override {
+    return std::make_unique<FrozenMapKeyIterator>(entries_);
+  }
+
+ private:
+  const FrozenMapEntry* Lookup(ValueView key, size_t hash) const {
+    const FrozenMapEntry& entry =
+        entries_[SlotOf(hash, seeds_[hash % seeds_.size()], entries_.size())];
+    if (entry.hash == hash && KeyEqual(entry.key, key)) {
+      return &entry;
+    }
+    return nullptr;
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> FindImpl(ValueManager&,
+                                                     ValueView key,
+                                                     Value&) const override {
+    if (const auto* entry = Lookup(key, MapKeyHash(key)); entry != nullptr) {
+      return ValueView{entry->value};
+    }
+    return absl::nullopt;
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> FindHashedImpl(
+      ValueManager&, ValueView key, size_t hash, Value&) const override {
+    if (const auto* entry = Lookup(key, hash); entry != nullptr) {
+      return ValueView{entry->value};
+    }
+    return absl::nullopt;
+  }
+
+  absl::StatusOr<bool> HasImpl(ValueManager&, ValueView key) const override {
+    return Lookup(key, MapKeyHash(key)) != nullptr;
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FrozenMapValue>();
+  }
+
+  const std::vector<FrozenMapEntry> entries_;
+  const std::vector<uint32_t> seeds_;
+};
+
+// Finds the seed of every bucket, placing the entries of the largest buckets
+// first while most slots are free. Returns `false` if some bucket has no seed
+// which scatters its entries to distinct free slots.
+bool PlaceEntries(std::vector<FrozenMapEntry>& entries,
+                  std::vector<uint32_t>& seeds) {
+  const size_t slot_count = entries.size();
+  const size_t bucket_count =
+      (slot_count + kEntriesPerBucket - 1) / kEntriesPerBucket;
+  std::vector<std::vector<size_t>> buckets(bucket_count);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    buckets[entries[i].hash % bucket_count].push_back(i);
+  }
+  std::vector<size_t> order(bucket_count);
+  for (size_t i = 0; i < bucket_count; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return buckets[lhs].size() > buckets[rhs].size();
+  });
+
+  seeds.assign(bucket_count, 0);
+  std::vector<bool> taken(slot_count, false);
+  std::vector<size_t> slot_of_entry(entries.size());
+  std::vector<size_t> slots;
+  for (size_t bucket : order) {
+    const std::vector<size_t>& members = buckets[bucket];
+    if (members.empty()) {
+      break;
+    }
+    bool placed = false;
+    for (uint32_t seed = 0; seed < kMaxSeed && !placed; ++seed) {
+      slots.clear();
+      placed = true;
+      for (size_t member : members) {
+        size_t slot = SlotOf(entries[member].hash, seed, slot_count);
+        if (taken[slot] ||
+            std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          placed = false;
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (placed) {
+        seeds[bucket] = seed;
+      }
+    }
+    if (!placed) {
+      return false;
+    }
+    for (size_t i = 0; i < members.size(); ++i) {
+      taken[slots[i]] = true;
+      slot_of_entry[members[i]] = slots[i];
+    }
+  }
+
+  std::vector<FrozenMapEntry> placed(slot_count);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    placed[slot_of_entry[i]] = std::move(entries[i]);
+  }
+  entries = std::move(placed);
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<MapValue> FreezeMapValue(ValueManager& value_manager,
+                                        const MapValue& map) {
+  CEL_ASSIGN_OR_RETURN(auto size, map.Size());
+  if (size == 0 || IsFrozenMapValue(map)) {
+    return map;
+  }
+  std::vector<FrozenMapEntry> entries;
+  entries.reserve(size);
+  CEL_RETURN_IF_ERROR(map.ForEach(
+      value_manager,
+      [&](ValueView key, ValueView value) -> absl::StatusOr<bool> {
+        entries.push_back(
+            FrozenMapEntry{MapKeyHash(key), Value(key), Value(value)});
+        return true;
+      }));
+
+  // Keys with the same hash always land in the same slot.
+  std::vector<size_t> hashes;
+  hashes.reserve(entries.size());
+  for (const auto& entry : entries) {
+    hashes.push_back(entry.hash);
+  }
+  std::sort(hashes.begin(), hashes.end());
+  if (std::adjacent_find(hashes.begin(), hashes.end()) != hashes.end()) {
+    return map;
+  }
+
+  std::vector<uint32_t> seeds;
+  if (!PlaceEntries(entries, seeds)) {
+    return map;
+  }
+  return MapValue(ParsedMapValue(
+      value_manager.GetMemoryManager().MakeShared<FrozenMapValue>(
+          std::move(entries), std::move(seeds))));
+}
+
+bool IsFrozenMapValue(const MapValue& map) {
+  auto parsed = As<ParsedMapValue>(map);
+  return parsed.has_value() &&
+         NativeTypeId::Of(*parsed) == NativeTypeId::For<FrozenMapValue>();
+}
+
+}  // namespace cel::runtime_internal
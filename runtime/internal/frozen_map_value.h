@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_FROZEN_MAP_VALUE_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_FROZEN_MAP_VALUE_H_
+
+#include "absl/status/statusor.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel::runtime_internal {
+
+// Returns an immutable copy of `map` for lookups of constant maps, e.g. map
+// literals folded at plan time.
+//
+// The entries are stored contiguously, indexed by a minimal perfect hash of
+// `MapKeyHash(key)` built with hash and displace: the entries are split into
+// buckets of a few entries each, and every bucket records the seed which
+// scatters its entries to free slots. A lookup probes exactly one slot, with
+// no collision chains and no rehashing.
+//
+// Returns `map` itself if it is empty, or if no perfect hash is found, e.g.
+// because two keys have the same hash.
+absl::StatusOr<MapValue> FreezeMapValue(ValueManager& value_manager,
+                                        const MapValue& map);
+
+// Returns whether `map` was created by `FreezeMapValue`.
+bool IsFrozenMapValue(const MapValue& map);
+
+}  // namespace cel::runtime_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_FROZEN_MAP_VALUE_H_
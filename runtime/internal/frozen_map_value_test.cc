@@ -0,0 +1,162 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/frozen_map_value.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "base/type_provider.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "common/values/legacy_value_manager.h"
+#include "internal/testing.h"
+
+namespace cel::runtime_internal {
+namespace {
+
+using cel::internal::IsOkAndHolds;
+
+class FrozenMapValueTest : public testing::Test {
+ public:
+  FrozenMapValueTest()
+      : value_factory_(MemoryManagerRef::ReferenceCounting(),
+                       TypeProvider::Builtin()) {}
+
+ protected:
+  // Returns a map from the strings "key0", "key1", ... to their index.
+  MapValue MakeStringKeyedMap(int64_t size) {
+    auto builder = value_factory_.NewMapValueBuilder(
+        value_factory_.GetDynDynMapType());
+    ABSL_CHECK_OK(builder.status());
+    for (int64_t i = 0; i < size; ++i) {
+      ABSL_CHECK_OK((*builder)->Put(
+          value_factory_.CreateUncheckedStringValue(absl::StrCat("key", i)),
+          IntValue(i)));
+    }
+    return std::move(**builder).Build();
+  }
+
+  common_internal::LegacyValueManager value_factory_;
+};
+
+TEST_F(FrozenMapValueTest, FindsEveryKey) {
+  for (int64_t size : {1, 2, 3, 7, 64, 1000}) {
+    ASSERT_OK_AND_ASSIGN(
+        MapValue map, FreezeMapValue(value_factory_, MakeStringKeyedMap(size)));
+    EXPECT_TRUE(IsFrozenMapValue(map));
+    EXPECT_THAT(map.Size(), IsOkAndHolds(size));
+    for (int64_t i = 0; i < size; ++i) {
+      StringValue key =
+          value_factory_.CreateUncheckedStringValue(absl::StrCat("key", i));
+      ASSERT_OK_AND_ASSIGN(Value value, map.Get(value_factory_, key));
+      EXPECT_EQ(Cast<IntValue>(value).NativeValue(), i);
+      Value scratch;
+      ASSERT_OK_AND_ASSIGN(
+          auto found,
+          map.FindHashed(value_factory_, key, MapKeyHash(key), scratch));
+      EXPECT_TRUE(found.second);
+    }
+    ASSERT_OK_AND_ASSIGN(
+        auto missing,
+        map.Find(value_factory_,
+                 value_factory_.CreateUncheckedStringValue("missing")));
+    EXPECT_FALSE(missing.second);
+  }
+}
+
+TEST_F(FrozenMapValueTest, KeysOfDifferentKindsAreDistinct) {
+  ASSERT_OK_AND_ASSIGN(auto builder, value_factory_.NewMapValueBuilder(
+                                         value_factory_.GetDynDynMapType()));
+  ASSERT_OK(builder->Put(IntValue(1), IntValue(10)));
+  ASSERT_OK(builder->Put(BoolValue(true), IntValue(20)));
+  ASSERT_OK(builder->Put(value_factory_.CreateUncheckedStringValue("1"),
+                         IntValue(30)));
+  MapValue source = std::move(*builder).Build();
+  ASSERT_OK_AND_ASSIGN(MapValue map, FreezeMapValue(value_factory_, source));
+  ASSERT_TRUE(IsFrozenMapValue(map));
+  EXPECT_EQ(map.DebugString(), "{true: 20, 1: 10, \"1\": 30}");
+
+  ASSERT_OK_AND_ASSIGN(Value value, map.Get(value_factory_, IntValue(1)));
+  EXPECT_EQ(Cast<IntValue>(value).NativeValue(), 10);
+  ASSERT_OK_AND_ASSIGN(value, map.Has(value_factory_, UintValue(1)));
+  EXPECT_FALSE(Cast<BoolValue>(value).NativeValue());
+  EXPECT_FALSE(map.Get(value_factory_, DoubleValue(1.0)).ok());
+}
+
+TEST_F(FrozenMapValueTest, IteratesEveryEntry) {
+  ASSERT_OK_AND_ASSIGN(
+      MapValue map, FreezeMapValue(value_factory_, MakeStringKeyedMap(10)));
+  int64_t sum = 0;
+  ASSERT_OK(map.ForEach(
+      value_factory_,
+      [&](ValueView key, ValueView value) -> absl::StatusOr<bool> {
+        EXPECT_EQ(Cast<StringValueView>(key).ToString(),
+                  absl::StrCat("key", Cast<IntValueView>(value).NativeValue()));
+        sum += Cast<IntValueView>(value).NativeValue();
+        return true;
+      }));
+  EXPECT_EQ(sum, 45);
+
+  ASSERT_OK_AND_ASSIGN(ListValue keys, map.ListKeys(value_factory_));
+  EXPECT_THAT(keys.Size(), IsOkAndHolds(10));
+  ASSERT_OK_AND_ASSIGN(auto iterator, map.NewIterator(value_factory_));
+  size_t count = 0;
+  while (iterator->HasNext()) {
+    ASSERT_OK_AND_ASSIGN(Value key, iterator->Next(value_factory_));
+    ASSERT_OK_AND_ASSIGN(Value value, map.Get(value_factory_, key));
+    EXPECT_TRUE(InstanceOf<IntValue>(value));
+    ++count;
+  }
+  EXPECT_EQ(count, 10);
+}
+
+TEST_F(FrozenMapValueTest, EqualsSourceMap) {
+  MapValue source = MakeStringKeyedMap(20);
+  ASSERT_OK_AND_ASSIGN(MapValue map, FreezeMapValue(value_factory_, source));
+  ASSERT_OK_AND_ASSIGN(Value equal, map.Equal(value_factory_, source));
+  EXPECT_TRUE(Cast<BoolValue>(equal).NativeValue());
+  ASSERT_OK_AND_ASSIGN(equal, source.Equal(value_factory_, map));
+  EXPECT_TRUE(Cast<BoolValue>(equal).NativeValue());
+}
+
+TEST_F(FrozenMapValueTest, ConvertsStringKeyedMapToJson) {
+  ASSERT_OK_AND_ASSIGN(
+      MapValue map, FreezeMapValue(value_factory_, MakeStringKeyedMap(3)));
+  ASSERT_OK_AND_ASSIGN(auto json, map.ConvertToJsonObject(value_factory_));
+  EXPECT_EQ(json.size(), 3);
+
+  ASSERT_OK_AND_ASSIGN(auto builder, value_factory_.NewMapValueBuilder(
+                                         value_factory_.GetDynDynMapType()));
+  ASSERT_OK(builder->Put(IntValue(1), IntValue(1)));
+  ASSERT_OK_AND_ASSIGN(map, FreezeMapValue(value_factory_,
+                                           std::move(*builder).Build()));
+  EXPECT_FALSE(map.ConvertToJsonObject(value_factory_).ok());
+}
+
+TEST_F(FrozenMapValueTest, EmptyMapIsUnchanged) {
+  ASSERT_OK_AND_ASSIGN(
+      MapValue map, FreezeMapValue(value_factory_, MakeStringKeyedMap(0)));
+  EXPECT_FALSE(IsFrozenMapValue(map));
+  EXPECT_THAT(map.Size(), IsOkAndHolds(0));
+}
+
+}  // namespace
+}  // namespace cel::runtime_internal
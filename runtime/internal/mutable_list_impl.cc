@@ -34,6 +34,10 @@ absl::Status MutableListValue::Append(cel::Value element) {
   return list_builder_->Add(std::move(element));
 }
 
+void MutableListValue::Reserve(size_t capacity) {
+  list_builder_->Reserve(capacity);
+}
+
 absl::StatusOr<cel::ListValue> MutableListValue::Build() && {
   return std::move(*list_builder_).Build();
 }
@@ -17,6 +17,7 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_MUTABLE_LIST_IMPL_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_MUTABLE_LIST_IMPL_H_
 
+#include <cstddef>
 #include <string>
 
 #include "common/memory.h"
@@ -67,6 +68,9 @@ class MutableListValue final : public cel::OpaqueValueInterface {
   // Caller must validate that mutating this object is safe.
   absl::Status Append(cel::Value element);
 
+  // Reserve space for at least `capacity` elements.
+  void Reserve(size_t capacity);
+
   // Build a list value from this object.
   // The instance is no longer usable after the call to Build.
   // Caller must clean up any handles still referring to this object.
@@ -0,0 +1,170 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/primitive_value_set.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "common/casting.h"
+#include "common/value.h"
+
+namespace cel::runtime_internal {
+
+namespace {
+
+constexpr uint64_t kInt64Max =
+    static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+// -0.0 and 0.0 are equal but may hash differently.
+double NormalizeDouble(double value) { return value == 0.0 ? 0.0 : value; }
+
+struct ContainsVisitor final {
+  const absl::flat_hash_set<std::string>& set;
+
+  bool operator()(absl::string_view value) const {
+    return set.contains(value);
+  }
+
+  bool operator()(const absl::Cord& value) const {
+    if (auto flat = value.TryFlat(); flat.has_value()) {
+      return set.contains(*flat);
+    }
+    return set.contains(static_cast<std::string>(value));
+  }
+};
+
+struct InsertVisitor final {
+  absl::flat_hash_set<std::string>& set;
+
+  void operator()(absl::string_view value) const {
+    set.insert(std::string(value));
+  }
+
+  void operator()(const absl::Cord& value) const {
+    set.insert(static_cast<std::string>(value));
+  }
+};
+
+}  // namespace
+
+void PrimitiveValueSet::InsertBool(bool value) {
+  if (value) {
+    has_true_ = true;
+  } else {
+    has_false_ = true;
+  }
+}
+
+void PrimitiveValueSet::InsertInt(int64_t value) {
+  ints_.insert(value);
+  integral_doubles_.insert(NormalizeDouble(static_cast<double>(value)));
+}
+
+void PrimitiveValueSet::InsertUint(uint64_t value) {
+  uints_.insert(value);
+  integral_doubles_.insert(NormalizeDouble(static_cast<double>(value)));
+}
+
+void PrimitiveValueSet::InsertDouble(double value) {
+  if (std::isnan(value)) {
+    return;
+  }
+  doubles_.insert(NormalizeDouble(value));
+}
+
+void PrimitiveValueSet::InsertString(absl::string_view value) {
+  strings_.insert(std::string(value));
+}
+
+void PrimitiveValueSet::InsertBytes(absl::string_view value) {
+  bytes_.insert(std::string(value));
+}
+
+bool PrimitiveValueSet::Insert(ValueView value) {
+  if (auto string_value = As<StringValueView>(value); string_value) {
+    string_value->NativeValue(InsertVisitor{strings_});
+    return true;
+  }
+  if (auto int_value = As<IntValueView>(value); int_value) {
+    InsertInt(int_value->NativeValue());
+    return true;
+  }
+  if (auto uint_value = As<UintValueView>(value); uint_value) {
+    InsertUint(uint_value->NativeValue());
+    return true;
+  }
+  if (auto double_value = As<DoubleValueView>(value); double_value) {
+    InsertDouble(double_value->NativeValue());
+    return true;
+  }
+  if (auto bool_value = As<BoolValueView>(value); bool_value) {
+    InsertBool(bool_value->NativeValue());
+    return true;
+  }
+  if (auto bytes_value = As<BytesValueView>(value); bytes_value) {
+    bytes_value->NativeValue(InsertVisitor{bytes_});
+    return true;
+  }
+  return false;
+}
+
+bool PrimitiveValueSet::ContainsInt(int64_t value) const {
+  return ints_.contains(value) ||
+         (value >= 0 && uints_.contains(static_cast<uint64_t>(value))) ||
+         doubles_.contains(NormalizeDouble(static_cast<double>(value)));
+}
+
+bool PrimitiveValueSet::ContainsUint(uint64_t value) const {
+  return uints_.contains(value) ||
+         (value <= kInt64Max && ints_.contains(static_cast<int64_t>(value))) ||
+         doubles_.contains(NormalizeDouble(static_cast<double>(value)));
+}
+
+bool PrimitiveValueSet::ContainsDouble(double value) const {
+  if (std::isnan(value)) {
+    return false;
+  }
+  value = NormalizeDouble(value);
+  return doubles_.contains(value) || integral_doubles_.contains(value);
+}
+
+bool PrimitiveValueSet::Contains(ValueView value) const {
+  if (auto string_value = As<StringValueView>(value); string_value) {
+    return string_value->NativeValue(ContainsVisitor{strings_});
+  }
+  if (auto int_value = As<IntValueView>(value); int_value) {
+    return ContainsInt(int_value->NativeValue());
+  }
+  if (auto uint_value = As<UintValueView>(value); uint_value) {
+    return ContainsUint(uint_value->NativeValue());
+  }
+  if (auto double_value = As<DoubleValueView>(value); double_value) {
+    return ContainsDouble(double_value->NativeValue());
+  }
+  if (auto bool_value = As<BoolValueView>(value); bool_value) {
+    return bool_value->NativeValue() ? has_true_ : has_false_;
+  }
+  if (auto bytes_value = As<BytesValueView>(value); bytes_value) {
+    return bytes_value->NativeValue(ContainsVisitor{bytes_});
+  }
+  return false;
+}
+
+}  // namespace cel::runtime_internal
@@ -0,0 +1,74 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_PRIMITIVE_VALUE_SET_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_PRIMITIVE_VALUE_SET_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "common/value.h"
+
+namespace cel::runtime_internal {
+
+// Hashed set of primitive values that answers membership queries with the
+// same results as a linear scan with heterogeneous equality (e.g. `@in` on a
+// list of the same elements).
+//
+// Numeric comparisons follow cel::internal::Number: int and uint compare
+// exactly, while comparisons against a double are made in double precision.
+// NaN is never a member.
+class PrimitiveValueSet final {
+ public:
+  PrimitiveValueSet() = default;
+
+  PrimitiveValueSet(const PrimitiveValueSet&) = delete;
+  PrimitiveValueSet& operator=(const PrimitiveValueSet&) = delete;
+
+  void InsertBool(bool value);
+  void InsertInt(int64_t value);
+  void InsertUint(uint64_t value);
+  void InsertDouble(double value);
+  void InsertString(absl::string_view value);
+  void InsertBytes(absl::string_view value);
+
+  // Inserts value, returning false without modifying the set if its kind is
+  // not supported.
+  bool Insert(ValueView value);
+
+  // Returns whether value is equal to any element of the set. Values of kinds
+  // that can't be stored in the set are never members.
+  bool Contains(ValueView value) const;
+
+ private:
+  bool ContainsInt(int64_t value) const;
+  bool ContainsUint(uint64_t value) const;
+  bool ContainsDouble(double value) const;
+
+  bool has_true_ = false;
+  bool has_false_ = false;
+  absl::flat_hash_set<int64_t> ints_;
+  absl::flat_hash_set<uint64_t> uints_;
+  absl::flat_hash_set<double> doubles_;
+  // Double conversions of ints_ and uints_, used for lookups of doubles.
+  absl::flat_hash_set<double> integral_doubles_;
+  absl::flat_hash_set<std::string> strings_;
+  absl::flat_hash_set<std::string> bytes_;
+};
+
+}  // namespace cel::runtime_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_PRIMITIVE_VALUE_SET_H_
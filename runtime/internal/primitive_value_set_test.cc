@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/primitive_value_set.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "absl/strings/cord.h"
+#include "common/value.h"
+#include "internal/testing.h"
+
+namespace cel::runtime_internal {
+namespace {
+
+TEST(PrimitiveValueSetTest, Strings) {
+  PrimitiveValueSet set;
+  set.InsertString("foo");
+  set.InsertString("bar");
+
+  EXPECT_TRUE(set.Contains(StringValue("foo")));
+  EXPECT_TRUE(set.Contains(StringValue(absl::Cord("bar"))));
+  EXPECT_FALSE(set.Contains(StringValue("baz")));
+  EXPECT_FALSE(set.Contains(BytesValue("foo")));
+}
+
+TEST(PrimitiveValueSetTest, Bytes) {
+  PrimitiveValueSet set;
+  set.InsertBytes("foo");
+
+  EXPECT_TRUE(set.Contains(BytesValue("foo")));
+  EXPECT_FALSE(set.Contains(StringValue("foo")));
+}
+
+TEST(PrimitiveValueSetTest, Bools) {
+  PrimitiveValueSet set;
+  set.InsertBool(true);
+
+  EXPECT_TRUE(set.Contains(BoolValue(true)));
+  EXPECT_FALSE(set.Contains(BoolValue(false)));
+  EXPECT_FALSE(set.Contains(IntValue(1)));
+}
+
+TEST(PrimitiveValueSetTest, HeterogeneousNumbers) {
+  PrimitiveValueSet set;
+  set.InsertInt(1);
+  set.InsertUint(2);
+  set.InsertDouble(3.0);
+  set.InsertDouble(4.5);
+
+  EXPECT_TRUE(set.Contains(IntValue(1)));
+  EXPECT_TRUE(set.Contains(UintValue(1)));
+  EXPECT_TRUE(set.Contains(DoubleValue(1.0)));
+  EXPECT_TRUE(set.Contains(IntValue(2)));
+  EXPECT_TRUE(set.Contains(UintValue(2)));
+  EXPECT_TRUE(set.Contains(DoubleValue(2.0)));
+  EXPECT_TRUE(set.Contains(IntValue(3)));
+  EXPECT_TRUE(set.Contains(UintValue(3)));
+  EXPECT_TRUE(set.Contains(DoubleValue(4.5)));
+
+  EXPECT_FALSE(set.Contains(IntValue(4)));
+  EXPECT_FALSE(set.Contains(DoubleValue(1.5)));
+  EXPECT_FALSE(set.Contains(IntValue(-1)));
+  EXPECT_FALSE(set.Contains(StringValue("1")));
+  EXPECT_FALSE(set.Contains(NullValue()));
+}
+
+TEST(PrimitiveValueSetTest, SignedZero) {
+  PrimitiveValueSet set;
+  set.InsertDouble(-0.0);
+
+  EXPECT_TRUE(set.Contains(DoubleValue(0.0)));
+  EXPECT_TRUE(set.Contains(IntValue(0)));
+  EXPECT_TRUE(set.Contains(UintValue(0)));
+}
+
+TEST(PrimitiveValueSetTest, NanNeverMatches) {
+  PrimitiveValueSet set;
+  set.InsertDouble(std::nan(""));
+
+  EXPECT_FALSE(set.Contains(DoubleValue(std::nan(""))));
+}
+
+TEST(PrimitiveValueSetTest, LargeIntegers) {
+  PrimitiveValueSet set;
+  set.InsertUint(std::numeric_limits<uint64_t>::max());
+  set.InsertInt(std::numeric_limits<int64_t>::min());
+
+  EXPECT_TRUE(set.Contains(UintValue(std::numeric_limits<uint64_t>::max())));
+  EXPECT_TRUE(set.Contains(IntValue(std::numeric_limits<int64_t>::min())));
+  EXPECT_FALSE(set.Contains(IntValue(-1)));
+  // Comparisons with doubles are made in double precision.
+  EXPECT_TRUE(set.Contains(DoubleValue(18446744073709551616.0)));
+  EXPECT_TRUE(set.Contains(DoubleValue(-9223372036854775808.0)));
+}
+
+TEST(PrimitiveValueSetTest, InsertValue) {
+  PrimitiveValueSet set;
+  EXPECT_TRUE(set.Insert(StringValue("foo")));
+  EXPECT_TRUE(set.Insert(StringValue(absl::Cord("bar"))));
+  EXPECT_TRUE(set.Insert(BytesValue("baz")));
+  EXPECT_TRUE(set.Insert(IntValue(1)));
+  EXPECT_TRUE(set.Insert(UintValue(2)));
+  EXPECT_TRUE(set.Insert(DoubleValue(3.5)));
+  EXPECT_TRUE(set.Insert(BoolValue(false)));
+  EXPECT_FALSE(set.Insert(NullValue()));
+
+  EXPECT_TRUE(set.Contains(StringValue("foo")));
+  EXPECT_TRUE(set.Contains(StringValue("bar")));
+  EXPECT_TRUE(set.Contains(BytesValue("baz")));
+  EXPECT_TRUE(set.Contains(DoubleValue(1.0)));
+  EXPECT_TRUE(set.Contains(IntValue(2)));
+  EXPECT_TRUE(set.Contains(DoubleValue(3.5)));
+  EXPECT_TRUE(set.Contains(BoolValue(false)));
+  EXPECT_FALSE(set.Contains(BoolValue(true)));
+  EXPECT_FALSE(set.Contains(NullValue()));
+}
+
+}  // namespace
+}  // namespace cel::runtime_internal
@@ -0,0 +1,328 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/program_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/overload.h"
+#include "absl/hash/hash.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/variant.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "common/constant.h"
+#include "common/expr.h"
+
+namespace cel::runtime_internal {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::Reference;
+using ::cel::ast_internal::Type;
+
+template <typename T>
+void AppendFixed(std::string& out, T value) {
+  char buffer[sizeof(T)];
+  std::memcpy(buffer, &value, sizeof(T));
+  out.append(buffer, sizeof(T));
+}
+
+void AppendBytes(std::string& out, absl::string_view bytes) {
+  AppendFixed<uint64_t>(out, bytes.size());
+  out.append(bytes.data(), bytes.size());
+}
+
+void AppendConstant(std::string& out, const Constant& constant) {
+  out.push_back(static_cast<char>(constant.kind().index()));
+  absl::visit(absl::Overload([](absl::monostate) {}, [](std::nullptr_t) {},
+                             [&out](bool value) { out.push_back(value); },
+                             [&out](int64_t value) {
+                               AppendFixed<int64_t>(out, value);
+                             },
+                             [&out](uint64_t value) {
+                               AppendFixed<uint64_t>(out, value);
+                             },
+                             [&out](double value) {
+                               AppendFixed<double>(out, value);
+                             },
+                             [&out](const BytesConstant& value) {
+                               AppendBytes(out, value);
+                             },
+                             [&out](const StringConstant& value) {
+                               AppendBytes(out, value);
+                             },
+                             [&out](absl::Duration value) {
+                               AppendFixed<int64_t>(
+                                   out, absl::ToInt64Nanoseconds(value));
+                             },
+                             [&out](absl::Time value) {
+                               AppendFixed<int64_t>(
+                                   out, absl::ToUnixNanos(value));
+                             }),
+              constant.kind());
+}
+
+void AppendExpr(std::string& out, const Expr& expr) {
+  AppendFixed<int64_t>(out, expr.id());
+  out.push_back(static_cast<char>(expr.kind().index()));
+  absl::visit(
+      absl::Overload(
+          [](const UnspecifiedExpr&) {},
+          [&out](const Constant& const_expr) {
+            AppendConstant(out, const_expr);
+          },
+          [&out](const IdentExpr& ident_expr) {
+            AppendBytes(out, ident_expr.name());
+          },
+          [&out](const SelectExpr& select_expr) {
+            out.push_back(select_expr.test_only());
+            AppendBytes(out, select_expr.field());
+            AppendExpr(out, select_expr.operand());
+          },
+          [&out](const CallExpr& call_expr) {
+            AppendBytes(out, call_expr.function());
+            out.push_back(call_expr.has_target());
+            if (call_expr.has_target()) {
+              AppendExpr(out, call_expr.target());
+            }
+            AppendFixed<uint64_t>(out, call_expr.args().size());
+            for (const auto& arg : call_expr.args()) {
+              AppendExpr(out, arg);
+            }
+          },
+          [&out](const ListExpr& list_expr) {
+            AppendFixed<uint64_t>(out, list_expr.elements().size());
+            for (const auto& element : list_expr.elements()) {
+              out.push_back(element.optional());
+              AppendExpr(out, element.expr());
+            }
+          },
+          [&out](const StructExpr& struct_expr) {
+            AppendBytes(out, struct_expr.name());
+            AppendFixed<uint64_t>(out, struct_expr.fields().size());
+            for (const auto& field : struct_expr.fields()) {
+              AppendFixed<int64_t>(out, field.id());
+              out.push_back(field.optional());
+              AppendBytes(out, field.name());
+              AppendExpr(out, field.value());
+            }
+          },
+          [&out](const MapExpr& map_expr) {
+            AppendFixed<uint64_t>(out, map_expr.entries().size());
+            for (const auto& entry : map_expr.entries()) {
+              AppendFixed<int64_t>(out, entry.id());
+              out.push_back(entry.optional());
+              AppendExpr(out, entry.key());
+              AppendExpr(out, entry.value());
+            }
+          },
+          [&out](const ComprehensionExpr& comprehension_expr) {
+            AppendBytes(out, comprehension_expr.iter_var());
+            AppendBytes(out, comprehension_expr.accu_var());
+            AppendExpr(out, comprehension_expr.iter_range());
+            AppendExpr(out, comprehension_expr.accu_init());
+            AppendExpr(out, comprehension_expr.loop_condition());
+            AppendExpr(out, comprehension_expr.loop_step());
+            AppendExpr(out, comprehension_expr.result());
+          }),
+      expr.kind());
+}
+
+void AppendReference(std::string& out, const Reference& reference) {
+  AppendBytes(out, reference.name());
+  AppendFixed<uint64_t>(out, reference.overload_id().size());
+  for (const auto& overload_id : reference.overload_id()) {
+    AppendBytes(out, overload_id);
+  }
+  AppendConstant(out, reference.value());
+}
+
+void AppendType(std::string& out, const Type& type) {
+  out.push_back(static_cast<char>(type.type_kind().index()));
+  absl::visit(
+      absl::Overload(
+          [](ast_internal::DynamicType) {}, [](ast_internal::NullValue) {},
+          [&out](ast_internal::PrimitiveType primitive) {
+            AppendFixed<int32_t>(out, static_cast<int32_t>(primitive));
+          },
+          [&out](const ast_internal::PrimitiveTypeWrapper& wrapper) {
+            AppendFixed<int32_t>(out, static_cast<int32_t>(wrapper.type()));
+          },
+          [&out](ast_internal::WellKnownType well_known) {
+            AppendFixed<int32_t>(out, static_cast<int32_t>(well_known));
+          },
+          [&out](const ast_internal::ListType& list_type) {
+            out.push_back(list_type.has_elem_type());
+            if (list_type.has_elem_type()) {
+              AppendType(out, list_type.elem_type());
+            }
+          },
+          [&out](const ast_internal::MapType& map_type) {
+            out.push_back(map_type.has_key_type());
+            if (map_type.has_key_type()) {
+              AppendType(out, map_type.key_type());
+            }
+            out.push_back(map_type.has_value_type());
+            if (map_type.has_value_type()) {
+              AppendType(out, map_type.value_type());
+            }
+          },
+          [&out](const ast_internal::FunctionType& function_type) {
+            out.push_back(function_type.has_result_type());
+            if (function_type.has_result_type()) {
+              AppendType(out, function_type.result_type());
+            }
+            AppendFixed<uint64_t>(out, function_type.arg_types().size());
+            for (const auto& arg_type : function_type.arg_types()) {
+              AppendType(out, arg_type);
+            }
+          },
+          [&out](const ast_internal::MessageType& message_type) {
+            AppendBytes(out, message_type.type());
+          },
+          [&out](const ast_internal::ParamType& param_type) {
+            AppendBytes(out, param_type.type());
+          },
+          [&out](const std::unique_ptr<Type>& type_type) {
+            out.push_back(type_type != nullptr);
+            if (type_type != nullptr) {
+              AppendType(out, *type_type);
+            }
+          },
+          [](ast_internal::ErrorType) {},
+          [&out](const ast_internal::AbstractType& abstract_type) {
+            AppendBytes(out, abstract_type.name());
+            AppendFixed<uint64_t>(out, abstract_type.parameter_types().size());
+            for (const auto& parameter_type : abstract_type.parameter_types()) {
+              AppendType(out, parameter_type);
+            }
+          }),
+      type.type_kind());
+}
+
+}  // namespace
+
+ProgramCache::ProgramCache(size_t capacity)
+    : shard_capacity_(
+          std::max<size_t>((capacity + kNumShards - 1) / kNumShards, 1)),
+      shards_(std::make_unique<Shard[]>(kNumShards)) {}
+
+std::string ProgramCache::Fingerprint(const AstImpl& ast) {
+  std::string out;
+  out.push_back(ast.IsChecked());
+  AppendExpr(out, ast.root_expr());
+  if (ast.IsChecked()) {
+    std::vector<int64_t> ids;
+    ids.reserve(ast.reference_map().size());
+    for (const auto& [id, reference] : ast.reference_map()) {
+      ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    AppendFixed<uint64_t>(out, ids.size());
+    for (int64_t id : ids) {
+      AppendFixed<int64_t>(out, id);
+      AppendReference(out, ast.reference_map().at(id));
+    }
+    // The planner specializes some steps on the checked types, e.g. map
+    // lookups on the declared key type.
+    const auto& type_map = ast.type_map();
+    ids.clear();
+    ids.reserve(type_map.size());
+    for (const auto& [id, type] : type_map) {
+      ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    AppendFixed<uint64_t>(out, ids.size());
+    for (int64_t id : ids) {
+      AppendFixed<int64_t>(out, id);
+      AppendType(out, type_map.at(id));
+    }
+  }
+  return out;
+}
+
+ProgramCache::Shard& ProgramCache::ShardFor(
+    absl::string_view fingerprint) const {
+  return shards_[absl::Hash<absl::string_view>{}(fingerprint) % kNumShards];
+}
+
+absl::StatusOr<ProgramCache::Entry> ProgramCache::GetOrCreate(
+    const std::string& fingerprint, Factory factory) {
+  Shard& shard = ShardFor(fingerprint);
+  std::shared_ptr<Flight> flight;
+  {
+    absl::MutexLock lock(&shard.mutex);
+    if (auto it = shard.index.find(fingerprint); it != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      return it->second->entry;
+    }
+    if (auto it = shard.flights.find(fingerprint); it != shard.flights.end()) {
+      flight = it->second;
+    } else {
+      shard.flights.insert({fingerprint, std::make_shared<Flight>()});
+    }
+  }
+
+  if (flight != nullptr) {
+    absl::MutexLock lock(&flight->mutex,
+                         absl::Condition(&flight->done));
+    return flight->result;
+  }
+
+  absl::StatusOr<Entry> result = factory();
+
+  {
+    absl::MutexLock lock(&shard.mutex);
+    auto node = shard.flights.extract(fingerprint);
+    flight = std::move(node.mapped());
+    if (result.ok()) {
+      shard.entries.push_front(CachedEntry{fingerprint, *result});
+      shard.index.insert(
+          {shard.entries.front().fingerprint, shard.entries.begin()});
+      while (shard.entries.size() > shard_capacity_) {
+        shard.index.erase(shard.entries.back().fingerprint);
+        shard.entries.pop_back();
+      }
+    }
+  }
+  {
+    absl::MutexLock lock(&flight->mutex);
+    flight->result = result;
+    flight->done = true;
+  }
+  return result;
+}
+
+size_t ProgramCache::size() const {
+  size_t size = 0;
+  for (size_t i = 0; i < kNumShards; ++i) {
+    absl::MutexLock lock(&shards_[i].mutex);
+    size += shards_[i].entries.size();
+  }
+  return size;
+}
+
+}  // namespace cel::runtime_internal
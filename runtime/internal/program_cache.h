@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_PROGRAM_CACHE_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_PROGRAM_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "base/ast_internal/ast_impl.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_issue.h"
+
+namespace cel::runtime_internal {
+
+// Bounded LRU cache of the programs created by a runtime, keyed by the
+// fingerprint of their AST and split across shards by key to reduce lock
+// contention.
+//
+// Concurrent misses for the same key create the program once: the other
+// callers wait for the result of the first. Failures are returned to every
+// waiting caller but are not cached.
+class ProgramCache final {
+ public:
+  struct Entry {
+    std::shared_ptr<const TraceableProgram> program;
+    // The issues reported when the program was created.
+    std::vector<RuntimeIssue> issues;
+  };
+
+  using Factory = absl::FunctionRef<absl::StatusOr<Entry>()>;
+
+  explicit ProgramCache(size_t capacity);
+
+  ProgramCache(const ProgramCache&) = delete;
+  ProgramCache& operator=(const ProgramCache&) = delete;
+
+  // Returns a canonical encoding of `ast`, equal for two ASTs if and only if
+  // they are planned the same way by a runtime: the expressions, with their
+  // ids, and for checked ASTs the references and the types. Source positions
+  // and macro calls are ignored.
+  static std::string Fingerprint(const ast_internal::AstImpl& ast);
+
+  // Returns the entry cached for `fingerprint`, or creates it with `factory`.
+  absl::StatusOr<Entry> GetOrCreate(const std::string& fingerprint,
+                                    Factory factory);
+
+  // Number of cached programs.
+  size_t size() const;
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  // A program being created, shared by the callers waiting for it.
+  struct Flight {
+    absl::Mutex mutex;
+    bool done ABSL_GUARDED_BY(mutex) = false;
+    absl::StatusOr<Entry> result ABSL_GUARDED_BY(mutex);
+  };
+
+  struct CachedEntry {
+    std::string fingerprint;
+    Entry entry;
+  };
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    // Most recently used first.
+    std::list<CachedEntry> entries ABSL_GUARDED_BY(mutex);
+    // Keys point into the fingerprint of the corresponding entry.
+    absl::flat_hash_map<absl::string_view, std::list<CachedEntry>::iterator>
+        index ABSL_GUARDED_BY(mutex);
+    absl::flat_hash_map<std::string, std::shared_ptr<Flight>> flights
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  Shard& ShardFor(absl::string_view fingerprint) const;
+
+  const size_t shard_capacity_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace cel::runtime_internal
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_PROGRAM_CACHE_H_
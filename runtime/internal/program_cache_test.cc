@@ -0,0 +1,217 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/internal/program_cache.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "base/ast_internal/ast_impl.h"
+#include "base/ast_internal/expr.h"
+#include "internal/testing.h"
+#include "runtime/runtime_issue.h"
+
+namespace cel::runtime_internal {
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+using ::cel::ast_internal::CheckedExpr;
+using ::cel::ast_internal::Reference;
+using ::cel::ast_internal::SourceInfo;
+using ::cel::ast_internal::Type;
+using cel::internal::StatusIs;
+using testing::SizeIs;
+
+// Returns the AST of `x.f(2)`, with the receiver named `receiver`.
+AstImpl MakeCall(absl::string_view receiver, int64_t arg_id = 3) {
+  Expr expr;
+  expr.set_id(2);
+  auto& call = expr.mutable_call_expr();
+  call.set_function("f");
+  auto& target = call.mutable_target();
+  target.set_id(1);
+  target.mutable_ident_expr().set_name(receiver);
+  auto& arg = call.add_args();
+  arg.set_id(arg_id);
+  arg.mutable_const_expr().set_int_value(2);
+  return AstImpl(std::move(expr), SourceInfo());
+}
+
+ProgramCache::Entry MakeEntry(absl::string_view message) {
+  ProgramCache::Entry entry;
+  entry.issues.push_back(
+      RuntimeIssue::CreateWarning(absl::InvalidArgumentError(message)));
+  return entry;
+}
+
+TEST(ProgramCacheTest, FingerprintIdentifiesPlannedAsts) {
+  AstImpl ast = MakeCall("x");
+  EXPECT_EQ(ProgramCache::Fingerprint(ast),
+            ProgramCache::Fingerprint(MakeCall("x")));
+  EXPECT_NE(ProgramCache::Fingerprint(ast),
+            ProgramCache::Fingerprint(MakeCall("y")));
+  EXPECT_NE(ProgramCache::Fingerprint(ast),
+            ProgramCache::Fingerprint(MakeCall("x", /*arg_id=*/4)));
+
+  // Source positions don't change the plan.
+  AstImpl positioned = MakeCall("x");
+  positioned.source_info().mutable_positions()[1] = 10;
+  EXPECT_EQ(ProgramCache::Fingerprint(ast),
+            ProgramCache::Fingerprint(positioned));
+}
+
+TEST(ProgramCacheTest, FingerprintIncludesReferences) {
+  auto make_checked = [](absl::string_view overload_id) {
+    CheckedExpr expr;
+    expr.mutable_expr().set_id(1);
+    expr.mutable_expr().mutable_call_expr().set_function("f");
+    Reference reference;
+    reference.set_name("f");
+    reference.set_overload_id({std::string(overload_id)});
+    expr.mutable_reference_map()[1] = std::move(reference);
+    return AstImpl(std::move(expr));
+  };
+
+  EXPECT_EQ(ProgramCache::Fingerprint(make_checked("f_int")),
+            ProgramCache::Fingerprint(make_checked("f_int")));
+  EXPECT_NE(ProgramCache::Fingerprint(make_checked("f_int")),
+            ProgramCache::Fingerprint(make_checked("f_uint")));
+
+  Expr unchecked;
+  unchecked.set_id(1);
+  unchecked.mutable_call_expr().set_function("f");
+  EXPECT_NE(ProgramCache::Fingerprint(make_checked("f_int")),
+            ProgramCache::Fingerprint(
+                AstImpl(std::move(unchecked), SourceInfo())));
+}
+
+TEST(ProgramCacheTest, FingerprintIncludesTypes) {
+  // `m[1]`, with `m` declared as a map keyed by `key_type`.
+  auto make_checked = [](ast_internal::PrimitiveType key_type) {
+    CheckedExpr expr;
+    expr.mutable_expr().set_id(2);
+    auto& call = expr.mutable_expr().mutable_call_expr();
+    call.set_function("_[_]");
+    auto& map = call.add_args();
+    map.set_id(1);
+    map.mutable_ident_expr().set_name("m");
+    auto& key = call.add_args();
+    key.set_id(3);
+    key.mutable_const_expr().set_int_value(1);
+    expr.mutable_type_map()[1] = Type(ast_internal::MapType(
+        std::make_unique<Type>(key_type),
+        std::make_unique<Type>(ast_internal::DynamicType())));
+    return AstImpl(std::move(expr));
+  };
+
+  EXPECT_EQ(ProgramCache::Fingerprint(
+                make_checked(ast_internal::PrimitiveType::kInt64)),
+            ProgramCache::Fingerprint(
+                make_checked(ast_internal::PrimitiveType::kInt64)));
+  EXPECT_NE(ProgramCache::Fingerprint(
+                make_checked(ast_internal::PrimitiveType::kInt64)),
+            ProgramCache::Fingerprint(
+                make_checked(ast_internal::PrimitiveType::kUint64)));
+}
+
+TEST(ProgramCacheTest, ReusesEntries) {
+  ProgramCache cache(16);
+  int calls = 0;
+  auto factory = [&]() -> absl::StatusOr<ProgramCache::Entry> {
+    ++calls;
+    return MakeEntry("first");
+  };
+
+  ASSERT_OK_AND_ASSIGN(auto entry, cache.GetOrCreate("key", factory));
+  EXPECT_THAT(entry.issues, SizeIs(1));
+  ASSERT_OK_AND_ASSIGN(entry, cache.GetOrCreate("key", factory));
+  EXPECT_THAT(entry.issues, SizeIs(1));
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(cache.size(), 1);
+
+  ASSERT_OK(cache.GetOrCreate("other", factory));
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(ProgramCacheTest, DoesNotCacheFailures) {
+  ProgramCache cache(16);
+  int calls = 0;
+  auto factory = [&]() -> absl::StatusOr<ProgramCache::Entry> {
+    ++calls;
+    return absl::InvalidArgumentError("bad expression");
+  };
+
+  EXPECT_THAT(cache.GetOrCreate("key", factory),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(cache.GetOrCreate("key", factory),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(ProgramCacheTest, IsBounded) {
+  ProgramCache cache(16);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(cache.GetOrCreate(absl::StrCat("key", i), [&]() {
+      return absl::StatusOr<ProgramCache::Entry>(MakeEntry("entry"));
+    }));
+  }
+  EXPECT_LE(cache.size(), 16);
+  EXPECT_GT(cache.size(), 0);
+}
+
+TEST(ProgramCacheTest, CreatesConcurrentMissesOnce) {
+  ProgramCache cache(16);
+  std::atomic<int> calls{0};
+  absl::Notification release;
+  auto factory = [&]() -> absl::StatusOr<ProgramCache::Entry> {
+    calls.fetch_add(1);
+    release.WaitForNotification();
+    return MakeEntry("entry");
+  };
+
+  std::vector<std::thread> threads;
+  std::atomic<int> successes{0};
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      if (cache.GetOrCreate("key", factory).ok()) {
+        successes.fetch_add(1);
+      }
+    });
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  release.Notify();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(calls.load(), 1);
+  EXPECT_EQ(successes.load(), 4);
+}
+
+}  // namespace
+}  // namespace cel::runtime_internal
@@ -13,62 +13,213 @@
 // limitations under the License.
 #include "runtime/internal/runtime_impl.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/base/attributes.h"
+#include "absl/base/call_once.h"
 #include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/types/span.h"
 #include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
 #include "base/type_provider.h"
 #include "common/native_type.h"
 #include "common/value.h"
+#include "eval/compiler/branch_profile.h"
 #include "eval/eval/attribute_trail.h"
+#include "eval/eval/compiler_constant_step.h"
 #include "eval/eval/comprehension_slots.h"
 #include "eval/eval/direct_expression_step.h"
 #include "eval/eval/evaluator_core.h"
+#include "eval/eval/evaluator_state_pool.h"
+#include "eval/eval/incremental_step.h"
+#include "eval/eval/rule_set_step.h"
 #include "internal/casts.h"
 #include "internal/status_macros.h"
 #include "runtime/activation_interface.h"
+#include "runtime/program_metrics.h"
+#include "runtime/program_references.h"
 #include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/variable_layout.h"
 
 namespace cel::runtime_internal {
 namespace {
 
+using ::cel::ast_internal::AstImpl;
 using ::google::api::expr::runtime::AttributeTrail;
+using ::google::api::expr::runtime::BranchProfile;
+using ::google::api::expr::runtime::CompilerConstantStep;
 using ::google::api::expr::runtime::ComprehensionSlots;
+using ::google::api::expr::runtime::ContainerNames;
+using ::google::api::expr::runtime::DirectCompilerConstantStep;
 using ::google::api::expr::runtime::DirectExpressionStep;
+using ::google::api::expr::runtime::ExpressionStep;
+using ::google::api::expr::runtime::EvaluatorStatePool;
 using ::google::api::expr::runtime::ExecutionFrameBase;
 using ::google::api::expr::runtime::FlatExpression;
+using ::google::api::expr::runtime::FlatExpressionEvaluatorState;
+using ::google::api::expr::runtime::GetRuleSetResults;
+using ::google::api::expr::runtime::IncrementalCache;
+using ::google::api::expr::runtime::IncrementalDependencies;
+using ::google::api::expr::runtime::RecordEvaluation;
 using ::google::api::expr::runtime::WrappedDirectStep;
 
+// Returns the value of `step` if it is a constant, or null otherwise.
+absl::Nullable<const Value*> ConstantValue(const DirectExpressionStep& step) {
+  if (step.GetNativeTypeId() !=
+      NativeTypeId::For<DirectCompilerConstantStep>()) {
+    return nullptr;
+  }
+  return &internal::down_cast<const DirectCompilerConstantStep&>(step).value();
+}
+
+// Returns the result of `flat_expr` if the mainline expression is a single
+// constant, e.g. after constant folding, or null otherwise.
+absl::Nullable<const Value*> ConstantResult(const FlatExpression& flat_expr) {
+  if (flat_expr.subexpressions().empty() ||
+      flat_expr.subexpressions().front().size() != 1) {
+    return nullptr;
+  }
+  const ExpressionStep& step = *flat_expr.subexpressions().front().front();
+  if (step.GetNativeTypeId() == NativeTypeId::For<CompilerConstantStep>()) {
+    return &internal::down_cast<const CompilerConstantStep&>(step).value();
+  }
+  if (step.GetNativeTypeId() == NativeTypeId::For<WrappedDirectStep>()) {
+    return ConstantValue(
+        *internal::down_cast<const WrappedDirectStep&>(step).wrapped());
+  }
+  return nullptr;
+}
+
+// Evaluates a program whose result is `constant`, without copying it. The
+// evaluation still fails if it is cancelled or past its deadline.
+absl::StatusOr<ValueView> EvaluateConstantView(
+    const Value& constant ABSL_ATTRIBUTE_LIFETIME_BOUND,
+    const ActivationInterface& activation, const RuntimeOptions& options,
+    ValueManager& value_factory, absl::Nullable<ProgramMetrics*> metrics) {
+  const int64_t start_nanos =
+      metrics != nullptr ? absl::GetCurrentTimeNanos() : 0;
+  ExecutionFrameBase frame(activation, options, value_factory);
+  absl::Status status;
+  if (frame.interruptible()) {
+    status = frame.CheckInterruptsNow();
+  }
+  if (metrics != nullptr) {
+    RecordEvaluation(*metrics, start_nanos, status, constant, frame);
+  }
+  if (!status.ok()) {
+    return status;
+  }
+  return constant;
+}
+
 class ProgramImpl final : public TraceableProgram {
  public:
   using EvaluationListener = TraceableProgram::EvaluationListener;
   ProgramImpl(
       const std::shared_ptr<const RuntimeImpl::Environment>& environment,
       FlatExpression impl)
-      : environment_(environment), impl_(std::move(impl)) {}
+      : environment_(environment),
+        impl_(std::move(impl)),
+        constant_result_(ConstantResult(impl_)) {
+    if (impl_.options().evaluator_state_pool_size > 0) {
+      state_pool_ = std::make_unique<EvaluatorStatePool>(
+          impl_, impl_.options().evaluator_state_pool_size);
+    }
+  }
 
   absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
                                  ValueManager& value_factory) const override {
     return Trace(activation, EvaluationListener(), value_factory);
   }
 
+  absl::StatusOr<ValueView> EvaluateView(
+      const ActivationInterface& activation, ValueManager& value_factory,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const override {
+    if (constant_result_ != nullptr) {
+      return EvaluateConstantView(*constant_result_, activation,
+                                  impl_.options(), value_factory,
+                                  impl_.metrics().get());
+    }
+    return TraceableProgram::EvaluateView(activation, value_factory, scratch);
+  }
+
   absl::StatusOr<Value> Trace(const ActivationInterface& activation,
                               EvaluationListener callback,
                               ValueManager& value_factory) const override {
+    if (state_pool_ != nullptr) {
+      EvaluatorStatePool::Lease state = state_pool_->Acquire(value_factory);
+      return impl_.EvaluateWithCallback(activation, std::move(callback),
+                                        state.get());
+    }
     auto state = impl_.MakeEvaluatorState(value_factory);
     return impl_.EvaluateWithCallback(activation, std::move(callback), state);
   }
 
+  using TraceableProgram::EvaluateBatch;
+
+  std::vector<absl::StatusOr<Value>> EvaluateBatch(
+      absl::Span<const ActivationInterface* const> activations,
+      ValueManager& value_factory) const override {
+    if (state_pool_ != nullptr) {
+      EvaluatorStatePool::Lease state = state_pool_->Acquire(value_factory);
+      return EvaluateBatchWithState(activations, state.get());
+    }
+    auto state = impl_.MakeEvaluatorState(value_factory);
+    return EvaluateBatchWithState(activations, state);
+  }
+
   const TypeProvider& GetTypeProvider() const override {
     return environment_->type_registry.GetComposedTypeProvider();
   }
 
+  std::shared_ptr<const VariableLayout> GetVariableLayout() const override {
+    return impl_.variable_layout();
+  }
+
+  const ProgramReferences* GetReferences() const override {
+    return impl_.references().get();
+  }
+
+  const ProgramMetrics* GetMetrics() const override {
+    return impl_.metrics().get();
+  }
+
  private:
+  // The value stack and slots are reset before each evaluation, so one state
+  // can be shared by the whole batch.
+  std::vector<absl::StatusOr<Value>> EvaluateBatchWithState(
+      absl::Span<const ActivationInterface* const> activations,
+      FlatExpressionEvaluatorState& state) const {
+    std::vector<absl::StatusOr<Value>> results;
+    results.reserve(activations.size());
+    for (const ActivationInterface* activation : activations) {
+      results.push_back(impl_.EvaluateWithCallback(
+          *activation, EvaluationListener(), state));
+    }
+    return results;
+  }
+
   // Keep the Runtime environment alive while programs reference it.
   std::shared_ptr<const RuntimeImpl::Environment> environment_;
   FlatExpression impl_;
+  // Result of the program if it is a constant, owned by `impl_`.
+  absl::Nullable<const Value*> constant_result_;
+  // Optional cache of evaluator states. Null if pooling is disabled.
+  std::unique_ptr<EvaluatorStatePool> state_pool_;
 };
 
 class RecursiveProgramImpl final : public TraceableProgram {
@@ -76,39 +227,363 @@ class RecursiveProgramImpl final : public TraceableProgram {
   using EvaluationListener = TraceableProgram::EvaluationListener;
   RecursiveProgramImpl(
       const std::shared_ptr<const RuntimeImpl::Environment>& environment,
-      FlatExpression impl, absl::Nonnull<const DirectExpressionStep*> root)
-      : environment_(environment), impl_(std::move(impl)), root_(root) {}
+      FlatExpression impl, absl::Nonnull<const DirectExpressionStep*> root,
+      absl::Nullable<const DirectExpressionStep*> traced_root)
+      : environment_(environment),
+        impl_(std::move(impl)),
+        root_(root),
+        traced_root_(traced_root),
+        constant_result_(ConstantValue(*root)) {}
 
   absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
                                  ValueManager& value_factory) const override {
     return Trace(activation, /*callback=*/nullptr, value_factory);
   }
 
+  absl::StatusOr<ValueView> EvaluateView(
+      const ActivationInterface& activation, ValueManager& value_factory,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const override {
+    if (constant_result_ != nullptr) {
+      return EvaluateConstantView(*constant_result_, activation,
+                                  impl_.options(), value_factory,
+                                  impl_.metrics().get());
+    }
+    ComprehensionSlots slots(impl_.comprehension_slots_size());
+    ExecutionFrameBase frame(activation, /*callback=*/nullptr, impl_.options(),
+                             value_factory, slots);
+    CEL_RETURN_IF_ERROR(EvaluateRoot(*root_, frame, scratch));
+    return scratch;
+  }
+
   absl::StatusOr<Value> Trace(const ActivationInterface& activation,
                               EvaluationListener callback,
                               ValueManager& value_factory) const override {
+    const DirectExpressionStep* root =
+        callback && traced_root_ != nullptr ? traced_root_ : root_;
     ComprehensionSlots slots(impl_.comprehension_slots_size());
     ExecutionFrameBase frame(activation, std::move(callback), impl_.options(),
                              value_factory, slots);
 
     Value result;
-    AttributeTrail attribute;
-    CEL_RETURN_IF_ERROR(root_->Evaluate(frame, result, attribute));
+    CEL_RETURN_IF_ERROR(EvaluateRoot(*root, frame, result));
 
     return result;
   }
 
+  using TraceableProgram::EvaluateBatch;
+
+  std::vector<absl::StatusOr<Value>> EvaluateBatch(
+      absl::Span<const ActivationInterface* const> activations,
+      ValueManager& value_factory) const override {
+    std::vector<absl::StatusOr<Value>> results;
+    results.reserve(activations.size());
+    ComprehensionSlots slots(impl_.comprehension_slots_size());
+    for (const ActivationInterface* activation : activations) {
+      slots.Reset();
+      ExecutionFrameBase frame(*activation, /*callback=*/nullptr,
+                               impl_.options(), value_factory, slots);
+      Value result;
+      absl::Status status = EvaluateRoot(*root_, frame, result);
+      if (!status.ok()) {
+        results.push_back(std::move(status));
+        continue;
+      }
+      results.push_back(std::move(result));
+    }
+    return results;
+  }
+
   const TypeProvider& GetTypeProvider() const override {
     return environment_->type_registry.GetComposedTypeProvider();
   }
 
+  std::shared_ptr<const VariableLayout> GetVariableLayout() const override {
+    return impl_.variable_layout();
+  }
+
+  const ProgramReferences* GetReferences() const override {
+    return impl_.references().get();
+  }
+
+  const ProgramMetrics* GetMetrics() const override {
+    return impl_.metrics().get();
+  }
+
  private:
+  // Evaluates `root` in `frame`, recording the evaluation if metrics are
+  // enabled.
+  absl::Status EvaluateRoot(const DirectExpressionStep& root,
+                            ExecutionFrameBase& frame, Value& result) const {
+    ProgramMetrics* metrics = impl_.metrics().get();
+    const int64_t start_nanos =
+        metrics != nullptr ? absl::GetCurrentTimeNanos() : 0;
+    AttributeTrail attribute;
+    absl::Status status = root.Evaluate(frame, result, attribute);
+    if (status.ok()) {
+      status = frame.CheckMemoryBudget();
+    }
+    if (metrics != nullptr) {
+      RecordEvaluation(*metrics, start_nanos, status, result, frame);
+    }
+    return status;
+  }
+
   // Keep the Runtime environment alive while programs reference it.
   std::shared_ptr<const RuntimeImpl::Environment> environment_;
   FlatExpression impl_;
   absl::Nonnull<const DirectExpressionStep*> root_;
+  // Root of the traced copy of the program, used by evaluations with a
+  // listener. Null if the program wasn't planned with tracing.
+  absl::Nullable<const DirectExpressionStep*> traced_root_;
+  // Result of the program if it is a constant, owned by `impl_`.
+  absl::Nullable<const Value*> constant_result_;
+};
+
+// A program shared through the program cache of the runtime.
+class SharedProgramImpl final : public TraceableProgram {
+ public:
+  explicit SharedProgramImpl(std::shared_ptr<const TraceableProgram> program)
+      : program_(std::move(program)) {}
+
+  absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
+                                 ValueManager& value_factory) const override {
+    return program_->Evaluate(activation, value_factory);
+  }
+
+  absl::StatusOr<ValueView> EvaluateView(
+      const ActivationInterface& activation, ValueManager& value_factory,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const override {
+    return program_->EvaluateView(activation, value_factory, scratch);
+  }
+
+  absl::StatusOr<Value> Trace(const ActivationInterface& activation,
+                              EvaluationListener callback,
+                              ValueManager& value_factory) const override {
+    return program_->Trace(activation, std::move(callback), value_factory);
+  }
+
+  using TraceableProgram::EvaluateBatch;
+
+  std::vector<absl::StatusOr<Value>> EvaluateBatch(
+      absl::Span<const ActivationInterface* const> activations,
+      ValueManager& value_factory) const override {
+    return program_->EvaluateBatch(activations, value_factory);
+  }
+
+  const TypeProvider& GetTypeProvider() const override {
+    return program_->GetTypeProvider();
+  }
+
+  std::shared_ptr<const VariableLayout> GetVariableLayout() const override {
+    return program_->GetVariableLayout();
+  }
+
+  const ProgramReferences* GetReferences() const override {
+    return program_->GetReferences();
+  }
+
+  const ProgramMetrics* GetMetrics() const override {
+    return program_->GetMetrics();
+  }
+
+ private:
+  std::shared_ptr<const TraceableProgram> program_;
+};
+
+// Unpacks the results of the rules from the result of the combined program.
+class RuleSetProgramImpl final : public RuleSetProgram {
+ public:
+  RuleSetProgramImpl(std::unique_ptr<TraceableProgram> program,
+                     size_t rule_count)
+      : program_(std::move(program)), rule_count_(rule_count) {}
+
+  absl::StatusOr<std::vector<Value>> Evaluate(
+      const ActivationInterface& activation,
+      ValueManager& value_factory) const override {
+    CEL_ASSIGN_OR_RETURN(Value result,
+                         program_->Evaluate(activation, value_factory));
+    const std::vector<Value>* results = GetRuleSetResults(result);
+    if (results == nullptr || results->size() != rule_count_) {
+      return absl::InternalError(
+          absl::StrCat("unexpected rule set result: ", result.DebugString()));
+    }
+    return *results;
+  }
+
+  size_t rule_count() const override { return rule_count_; }
+
+  const TypeProvider& GetTypeProvider() const override {
+    return program_->GetTypeProvider();
+  }
+
+ private:
+  std::unique_ptr<TraceableProgram> program_;
+  size_t rule_count_;
+};
+
+class IncrementalProgramImpl final : public IncrementalProgram {
+ public:
+  IncrementalProgramImpl(
+      const std::shared_ptr<const RuntimeImpl::Environment>& environment,
+      FlatExpression impl,
+      std::shared_ptr<const IncrementalDependencies> dependencies)
+      : environment_(environment),
+        impl_(std::move(impl)),
+        dependencies_(std::move(dependencies)) {}
+
+  std::unique_ptr<State> NewState() const override {
+    return std::make_unique<StateImpl>(this, dependencies_->size());
+  }
+
+  absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
+                                 absl::Span<const std::string> changed,
+                                 State& state,
+                                 ValueManager& value_factory) const override {
+    auto* state_impl = dynamic_cast<StateImpl*>(&state);
+    if (state_impl == nullptr || state_impl->program != this) {
+      return absl::InvalidArgumentError(
+          "incremental evaluation state created by another program");
+    }
+    for (const std::string& path : changed) {
+      dependencies_->Invalidate(path, state_impl->cache);
+    }
+    auto evaluator_state = impl_.MakeEvaluatorState(value_factory);
+    return impl_.EvaluateIncrementally(activation, state_impl->cache,
+                                       evaluator_state);
+  }
+
+  const TypeProvider& GetTypeProvider() const override {
+    return environment_->type_registry.GetComposedTypeProvider();
+  }
+
+ private:
+  struct StateImpl final : public State {
+    StateImpl(const IncrementalProgramImpl* program, size_t size)
+        : program(program), cache(size) {}
+
+    const IncrementalProgramImpl* program;
+    IncrementalCache cache;
+  };
+
+  // Keep the Runtime environment alive while programs reference it.
+  std::shared_ptr<const RuntimeImpl::Environment> environment_;
+  FlatExpression impl_;
+  std::shared_ptr<const IncrementalDependencies> dependencies_;
+};
+
+// Evaluates a profiling plan until it is replaced by a plan ordered after the
+// collected profile.
+class TieredProgramImpl final : public Program {
+ public:
+  using Replan =
+      absl::AnyInvocable<absl::StatusOr<std::unique_ptr<TraceableProgram>>()>;
+  using Executor = absl::AnyInvocable<void(absl::AnyInvocable<void()>)>;
+
+  TieredProgramImpl(std::unique_ptr<TraceableProgram> profiling_program,
+                    Replan replan, int64_t profiled_evaluations,
+                    Executor executor)
+      : tiers_(std::make_shared<Tiers>(std::move(profiling_program),
+                                       std::move(replan))),
+        profiled_evaluations_(profiled_evaluations),
+        executor_(std::move(executor)) {}
+
+  // Waits for a replan in progress, and drops a pending one: it references
+  // the runtime, which only needs to outlive the program.
+  ~TieredProgramImpl() override { tiers_->Cancel(); }
+
+  absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
+                                 ValueManager& value_factory) const override {
+    if (const TraceableProgram* optimized =
+            tiers_->optimized.load(std::memory_order_acquire);
+        optimized != nullptr) {
+      return optimized->Evaluate(activation, value_factory);
+    }
+    absl::StatusOr<Value> result =
+        tiers_->profiling->Evaluate(activation, value_factory);
+    // Only the evaluation completing the profile plans the program again.
+    if (tiers_->evaluations.fetch_add(1, std::memory_order_relaxed) + 1 ==
+        profiled_evaluations_) {
+      if (executor_) {
+        executor_([tiers = tiers_]() { tiers->Optimize(); });
+      } else {
+        tiers_->Optimize();
+      }
+    }
+    return result;
+  }
+
+  const TypeProvider& GetTypeProvider() const override {
+    return tiers_->profiling->GetTypeProvider();
+  }
+
+  std::shared_ptr<const VariableLayout> GetVariableLayout() const override {
+    return tiers_->profiling->GetVariableLayout();
+  }
+
+  const ProgramReferences* GetReferences() const override {
+    return tiers_->profiling->GetReferences();
+  }
+
+ private:
+  // Shared with the task planning the program again, which may outlive the
+  // program. The task then finds `replan` reset and does nothing.
+  struct Tiers {
+    Tiers(std::unique_ptr<TraceableProgram> profiling, Replan replan)
+        : profiling(std::move(profiling)), replan(std::move(replan)) {}
+
+    // Plans the program again, unless the program is gone. Evaluations keep
+    // using the profiling plan if that fails.
+    void Optimize() {
+      absl::MutexLock lock(&mutex);
+      if (replan == nullptr) {
+        return;
+      }
+      absl::StatusOr<std::unique_ptr<TraceableProgram>> program = replan();
+      replan = nullptr;
+      if (!program.ok()) {
+        return;
+      }
+      optimized_program = *std::move(program);
+      optimized.store(optimized_program.get(), std::memory_order_release);
+    }
+
+    // Called when the program is destroyed, after which Optimize is a no-op.
+    void Cancel() {
+      absl::MutexLock lock(&mutex);
+      replan = nullptr;
+    }
+
+    const std::unique_ptr<TraceableProgram> profiling;
+    std::atomic<int64_t> evaluations{0};
+    // Held while planning the program again.
+    absl::Mutex mutex;
+    // Reset once it has run or the program is destroyed.
+    Replan replan ABSL_GUARDED_BY(mutex);
+    std::unique_ptr<TraceableProgram> optimized_program ABSL_GUARDED_BY(mutex);
+    // Published once `optimized_program` is set.
+    std::atomic<const TraceableProgram*> optimized{nullptr};
+  };
+
+  std::shared_ptr<Tiers> tiers_;
+  int64_t profiled_evaluations_;
+  mutable Executor executor_;
 };
 
+// Returns the root step of `flat_expr` if it is fully recursive, that is if
+// the mainline expression is exactly one recursive step, or null otherwise.
+absl::Nullable<const DirectExpressionStep*> RecursiveRoot(
+    const FlatExpression& flat_expr) {
+  if (flat_expr.subexpressions().empty() ||
+      flat_expr.subexpressions().front().size() != 1 ||
+      flat_expr.subexpressions().front().front()->GetNativeTypeId() !=
+          NativeTypeId::For<WrappedDirectStep>()) {
+    return nullptr;
+  }
+  return internal::down_cast<const WrappedDirectStep*>(
+             flat_expr.subexpressions().front().front().get())
+      ->wrapped();
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<Program>> RuntimeImpl::CreateProgram(
@@ -121,30 +596,146 @@ absl::StatusOr<std::unique_ptr<TraceableProgram>>
 RuntimeImpl::CreateTraceableProgram(
     std::unique_ptr<Ast> ast,
     const Runtime::CreateProgramOptions& options) const {
-  CEL_ASSIGN_OR_RETURN(auto flat_expr, expr_builder_.CreateExpressionImpl(
-                                           std::move(ast), options.issues));
+  if (program_cache_ == nullptr || ast == nullptr) {
+    CEL_ASSIGN_OR_RETURN(
+        auto flat_expr,
+        expr_builder_.CreateExpressionImpl(std::move(ast), options.issues,
+                                           container_names()));
+    return WrapExpression(std::move(flat_expr));
+  }
+  const std::string fingerprint =
+      ProgramCache::Fingerprint(AstImpl::CastFromPublicAst(*ast));
+  CEL_ASSIGN_OR_RETURN(
+      ProgramCache::Entry entry,
+      program_cache_->GetOrCreate(
+          fingerprint, [&]() -> absl::StatusOr<ProgramCache::Entry> {
+            ProgramCache::Entry entry;
+            CEL_ASSIGN_OR_RETURN(
+                auto flat_expr,
+                expr_builder_.CreateExpressionImpl(
+                    std::move(ast), &entry.issues, container_names()));
+            entry.program = WrapExpression(std::move(flat_expr));
+            return entry;
+          }));
+  if (options.issues != nullptr) {
+    *options.issues = std::move(entry.issues);
+  }
+  return std::make_unique<SharedProgramImpl>(std::move(entry.program));
+}
 
+std::vector<absl::StatusOr<std::unique_ptr<Program>>>
+RuntimeImpl::CreatePrograms(absl::Span<std::unique_ptr<Ast>> asts,
+                            BatchExecutor executor) const {
+  std::shared_ptr<const ContainerNames> container_names =
+      this->container_names();
+  std::vector<absl::StatusOr<std::unique_ptr<Program>>> programs(asts.size());
+  executor(asts.size(), [&](size_t shard) {
+    absl::StatusOr<FlatExpression> flat_expr =
+        expr_builder_.CreateExpressionImpl(std::move(asts[shard]),
+                                           /*issues=*/nullptr, container_names);
+    if (!flat_expr.ok()) {
+      programs[shard] = std::move(flat_expr).status();
+      return;
+    }
+    programs[shard] = WrapExpression(std::move(flat_expr).value());
+  });
+  return programs;
+}
+
+absl::StatusOr<std::unique_ptr<RuleSetProgram>>
+RuntimeImpl::CreateRuleSetProgram(
+    std::vector<std::unique_ptr<Ast>> rules,
+    const Runtime::CreateProgramOptions& options) const {
+  const size_t rule_count = rules.size();
+  CEL_ASSIGN_OR_RETURN(auto flat_expr,
+                       expr_builder_.CreateRuleSetExpressionImpl(
+                           std::move(rules), options.issues));
+  return std::make_unique<RuleSetProgramImpl>(
+      WrapExpression(std::move(flat_expr)), rule_count);
+}
+
+absl::StatusOr<std::unique_ptr<IncrementalProgram>>
+RuntimeImpl::CreateIncrementalProgram(
+    std::unique_ptr<Ast> ast,
+    const Runtime::CreateProgramOptions& options) const {
+  auto dependencies = std::make_shared<IncrementalDependencies>();
+  CEL_ASSIGN_OR_RETURN(auto flat_expr,
+                       expr_builder_.CreateIncrementalExpressionImpl(
+                           std::move(ast), options.issues, dependencies));
+  return std::make_unique<IncrementalProgramImpl>(
+      environment_, std::move(flat_expr), std::move(dependencies));
+}
+
+absl::StatusOr<std::unique_ptr<Program>> RuntimeImpl::CreateTieredProgram(
+    std::unique_ptr<Ast> ast, TieringOptions tiering_options,
+    const Runtime::CreateProgramOptions& options) const {
+  if (ast == nullptr) {
+    return absl::InvalidArgumentError("tiered program ast must not be null");
+  }
+  if (tiering_options.profiled_evaluations <= 0) {
+    return absl::InvalidArgumentError(
+        "tiered programs must be profiled for a positive number of "
+        "evaluations");
+  }
+  const AstImpl& ast_impl = AstImpl::CastFromPublicAst(*ast);
+  // Copied before planning, which may rewrite the AST.
+  std::unique_ptr<Ast> copy = ast_impl.DeepCopy();
+  auto profile = std::make_shared<BranchProfile>(ast_impl);
+  CEL_ASSIGN_OR_RETURN(auto flat_expr,
+                       expr_builder_.CreateBranchProfilingExpressionImpl(
+                           std::move(ast), options.issues, profile));
+  TieredProgramImpl::Replan replan =
+      [this, copy = std::move(copy), profile = std::move(profile),
+       min_evaluations = tiering_options.min_operand_evaluations]() mutable
+      -> absl::StatusOr<std::unique_ptr<TraceableProgram>> {
+    CEL_ASSIGN_OR_RETURN(auto flat_expr,
+                         expr_builder_.CreateProfileGuidedExpressionImpl(
+                             std::move(copy), /*issues=*/nullptr,
+                             std::move(profile), min_evaluations));
+    return WrapExpression(std::move(flat_expr));
+  };
+  return std::make_unique<TieredProgramImpl>(
+      WrapExpression(std::move(flat_expr)), std::move(replan),
+      tiering_options.profiled_evaluations,
+      std::move(tiering_options.executor));
+}
+
+std::unique_ptr<TraceableProgram> RuntimeImpl::WrapExpression(
+    FlatExpression flat_expr) const {
+  if (expr_builder_.options().enable_program_metrics) {
+    auto metrics = std::make_shared<ProgramMetrics>();
+    metrics->set_lock_counter(
+        [types = flat_expr.interned_types()]() -> uint64_t {
+          return types->lock_count();
+        });
+    flat_expr.set_metrics(std::move(metrics));
+  }
   // Special case if the program is fully recursive.
   //
   // This implementation avoids unnecessary allocs at evaluation time which
   // improves performance notably for small expressions.
-  if (expr_builder_.options().max_recursion_depth != 0 &&
-      !flat_expr.subexpressions().empty() &&
-      // mainline expression is exactly one recursive step.
-      flat_expr.subexpressions().front().size() == 1 &&
-      flat_expr.subexpressions().front().front()->GetNativeTypeId() ==
-          NativeTypeId::For<WrappedDirectStep>()) {
-    const DirectExpressionStep* root =
-        internal::down_cast<const WrappedDirectStep*>(
-            flat_expr.subexpressions().front().front().get())
-            ->wrapped();
-    return std::make_unique<RecursiveProgramImpl>(environment_,
-                                                  std::move(flat_expr), root);
+  if (expr_builder_.options().max_recursion_depth != 0) {
+    if (const DirectExpressionStep* root = RecursiveRoot(flat_expr);
+        root != nullptr) {
+      const DirectExpressionStep* traced_root =
+          flat_expr.traced_expression() != nullptr
+              ? RecursiveRoot(*flat_expr.traced_expression())
+              : nullptr;
+      return std::make_unique<RecursiveProgramImpl>(
+          environment_, std::move(flat_expr), root, traced_root);
+    }
   }
 
   return std::make_unique<ProgramImpl>(environment_, std::move(flat_expr));
 }
 
+std::shared_ptr<const ContainerNames> RuntimeImpl::container_names() const {
+  absl::call_once(container_names_once_, [this]() {
+    container_names_ = expr_builder_.ComputeContainerNames();
+  });
+  return container_names_;
+}
+
 bool TestOnly_IsRecursiveImpl(const Program* program) {
   return dynamic_cast<const RecursiveProgramImpl*>(program) != nullptr;
 }
@@ -16,13 +16,18 @@
 #define THIRD_PARTY_CEL_CPP_RUNTIME_INTERNAL_RUNTIME_IMPL_H_
 
 #include <memory>
+#include <utility>
+#include <vector>
 
+#include "absl/base/call_once.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "base/ast.h"
 #include "base/type_provider.h"
 #include "common/native_type.h"
 #include "eval/compiler/flat_expr_builder.h"
 #include "runtime/function_registry.h"
+#include "runtime/internal/program_cache.h"
 #include "runtime/runtime.h"
 #include "runtime/runtime_options.h"
 #include "runtime/type_registry.h"
@@ -32,14 +37,28 @@ namespace cel::runtime_internal {
 class RuntimeImpl : public Runtime {
  public:
   struct Environment {
+    Environment() = default;
+    explicit Environment(std::shared_ptr<const FunctionRegistry> base_functions)
+        : function_registry(std::move(base_functions)) {}
+
     TypeRegistry type_registry;
     FunctionRegistry function_registry;
   };
 
   explicit RuntimeImpl(const RuntimeOptions& options)
-      : environment_(std::make_shared<Environment>()),
+      : RuntimeImpl(options, nullptr) {}
+
+  // Creates a runtime whose function registry extends `base_functions`.
+  RuntimeImpl(const RuntimeOptions& options,
+              std::shared_ptr<const FunctionRegistry> base_functions)
+      : environment_(
+            std::make_shared<Environment>(std::move(base_functions))),
         expr_builder_(environment_->function_registry,
-                      environment_->type_registry, options) {}
+                      environment_->type_registry, options),
+        program_cache_(options.program_cache_size > 0
+                           ? std::make_unique<ProgramCache>(
+                                 options.program_cache_size)
+                           : nullptr) {}
 
   TypeRegistry& type_registry() { return environment_->type_registry; }
   const TypeRegistry& type_registry() const {
@@ -62,6 +81,26 @@ class RuntimeImpl : public Runtime {
       std::unique_ptr<Ast> ast,
       const Runtime::CreateProgramOptions& options) const override;
 
+  // Plans the whole batch with the same container names, which are only
+  // computed once.
+  std::vector<absl::StatusOr<std::unique_ptr<Program>>> CreatePrograms(
+      absl::Span<std::unique_ptr<Ast>> asts,
+      BatchExecutor executor) const override;
+
+  absl::StatusOr<std::unique_ptr<RuleSetProgram>> CreateRuleSetProgram(
+      std::vector<std::unique_ptr<Ast>> rules,
+      const Runtime::CreateProgramOptions& options) const override;
+
+  absl::StatusOr<std::unique_ptr<IncrementalProgram>> CreateIncrementalProgram(
+      std::unique_ptr<Ast> ast,
+      const Runtime::CreateProgramOptions& options) const override;
+
+  // The program is planned again with the builder of the runtime, which must
+  // outlive it.
+  absl::StatusOr<std::unique_ptr<Program>> CreateTieredProgram(
+      std::unique_ptr<Ast> ast, TieringOptions tiering_options,
+      const Runtime::CreateProgramOptions& options) const override;
+
   const TypeProvider& GetTypeProvider() const override {
     return environment_->type_registry.GetComposedTypeProvider();
   }
@@ -75,12 +114,28 @@ class RuntimeImpl : public Runtime {
   NativeTypeId GetNativeTypeId() const override {
     return NativeTypeId::For<RuntimeImpl>();
   }
+
+  std::unique_ptr<TraceableProgram> WrapExpression(
+      google::api::expr::runtime::FlatExpression flat_expr) const;
+
+  // The names resolvable within the container, computed when the first
+  // program is created. The registries are no longer modified by then, so
+  // they are shared by all the programs of the runtime, along with the
+  // qualified names memoized while planning them.
+  std::shared_ptr<const google::api::expr::runtime::ContainerNames>
+  container_names() const;
+
   // Note: this is mutable, but should only be accessed in a const context after
   // building is complete.
   //
   // This is used to keep alive the registries while programs reference them.
   std::shared_ptr<Environment> environment_;
   google::api::expr::runtime::FlatExprBuilder expr_builder_;
+  // Null if program caching is disabled.
+  std::unique_ptr<ProgramCache> program_cache_;
+  mutable absl::once_flag container_names_once_;
+  mutable std::shared_ptr<const google::api::expr::runtime::ContainerNames>
+      container_names_;
 };
 
 // Exposed for testing to validate program is recursively planned.
@@ -0,0 +1,44 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "runtime/layered_activation.h"
+
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+
+namespace cel {
+
+absl::StatusOr<absl::optional<ValueView>> LayeredActivation::FindVariable(
+    ValueManager& factory, absl::string_view name, Value& scratch) const {
+  const Overlay& overlay = overlay_.get();
+  if (!overlay.empty()) {
+    if (auto iter = overlay.find(name); iter != overlay.end()) {
+      return ValueView(iter->second);
+    }
+  }
+  return base_->FindVariable(factory, name, scratch);
+}
+
+bool LayeredActivation::InsertOrAssignValue(absl::string_view name,
+                                            Value value) {
+  return overlay_.mutable_get()
+      .insert_or_assign(name, std::move(value))
+      .second;
+}
+
+}  // namespace cel
@@ -0,0 +1,145 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_LAYERED_ACTIVATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_LAYERED_ACTIVATION_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/attribute.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "internal/copy_on_write.h"
+#include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/function_overload_reference.h"
+
+namespace cel {
+
+// Activation that overlays a small set of values over a shared, immutable base
+// activation.
+//
+// Variables are looked up in the overlay first and then in the base, so the
+// values common to many evaluations (configuration, feature flags, constant
+// maps) are bound once in the base instead of being copied into every
+// activation. Value providers of the base are memoized by the base and shared
+// by every layered activation over it (see
+// Activation::InsertOrAssignValueProvider).
+//
+// Usage:
+//
+//   auto base = std::make_shared<Activation>();
+//   base->InsertOrAssignValue("config", config);
+//   ...
+//   LayeredActivation activation(base);
+//   activation.InsertOrAssignValue("request", request);
+//   auto result = program->Evaluate(activation, value_manager);
+//
+// Creating and copying a layered activation is O(1): the overlay is copied
+// only when a copy that shares it is modified. Context functions are those of
+// the base. The unknown and missing attribute patterns are those of the base
+// unless set on the layered activation.
+class LayeredActivation final : public ActivationInterface {
+ public:
+  // `base` must not be null.
+  explicit LayeredActivation(std::shared_ptr<const ActivationInterface> base)
+      : base_(std::move(base)) {}
+
+  // Copies share the overlay until either of them is modified. Moves are
+  // copies, which leaves the source usable.
+  LayeredActivation(const LayeredActivation&) = default;
+  LayeredActivation& operator=(const LayeredActivation&) = default;
+
+  // Implements ActivationInterface.
+  absl::StatusOr<absl::optional<ValueView>> FindVariable(
+      ValueManager& factory, absl::string_view name,
+      Value& scratch) const override;
+  using ActivationInterface::FindVariable;
+
+  std::vector<FunctionOverloadReference> FindFunctionOverloads(
+      absl::string_view name) const override {
+    return base_->FindFunctionOverloads(name);
+  }
+
+  absl::Span<const cel::AttributePattern> GetUnknownAttributes()
+      const override {
+    if (unknown_patterns_.has_value()) {
+      return *unknown_patterns_;
+    }
+    return base_->GetUnknownAttributes();
+  }
+
+  absl::Span<const cel::AttributePattern> GetMissingAttributes()
+      const override {
+    if (missing_patterns_.has_value()) {
+      return *missing_patterns_;
+    }
+    return base_->GetMissingAttributes();
+  }
+
+  absl::Time GetDeadline() const override { return deadline_; }
+
+  absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const override {
+    return cancellation_token_.get();
+  }
+
+  const ActivationInterface& base() const { return *base_; }
+
+  // Bind a value to a named variable, shadowing any binding of the base.
+  //
+  // Returns false if the entry for name in the overlay was overwritten.
+  bool InsertOrAssignValue(absl::string_view name, Value value);
+
+  void SetUnknownPatterns(std::vector<cel::AttributePattern> patterns) {
+    unknown_patterns_ = std::move(patterns);
+  }
+
+  void SetMissingPatterns(std::vector<cel::AttributePattern> patterns) {
+    missing_patterns_ = std::move(patterns);
+  }
+
+  // See Activation::SetDeadline.
+  void SetDeadline(absl::Time deadline) { deadline_ = deadline; }
+
+  // See Activation::SetCancellationToken.
+  void SetCancellationToken(std::shared_ptr<const CancellationToken> token) {
+    cancellation_token_ = std::move(token);
+  }
+
+ private:
+  using Overlay = absl::flat_hash_map<std::string, Value>;
+
+  std::shared_ptr<const ActivationInterface> base_;
+  internal::CopyOnWrite<Overlay> overlay_;
+
+  absl::optional<std::vector<cel::AttributePattern>> unknown_patterns_;
+  absl::optional<std::vector<cel::AttributePattern>> missing_patterns_;
+
+  absl::Time deadline_ = absl::InfiniteFuture();
+  std::shared_ptr<const CancellationToken> cancellation_token_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_LAYERED_ACTIVATION_H_
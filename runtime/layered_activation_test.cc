@@ -0,0 +1,157 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "runtime/layered_activation.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "base/attribute.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::ProtobufRuntimeAdapter;
+using ::cel::test::BoolValueIs;
+using ::cel::test::IntValueIs;
+using ::google::api::expr::parser::Parse;
+using testing::IsEmpty;
+using testing::Optional;
+using testing::SizeIs;
+
+TEST(LayeredActivation, FindVariable) {
+  ManagedValueFactory value_factory(TypeProvider::Builtin(),
+                                    MemoryManagerRef::ReferenceCounting());
+  auto base = std::make_shared<Activation>();
+  base->InsertOrAssignValue("x", IntValue(1));
+  base->InsertOrAssignValue("y", IntValue(2));
+
+  LayeredActivation activation(base);
+  EXPECT_TRUE(activation.InsertOrAssignValue("y", IntValue(3)));
+  EXPECT_TRUE(activation.InsertOrAssignValue("z", IntValue(4)));
+  EXPECT_FALSE(activation.InsertOrAssignValue("z", IntValue(5)));
+
+  ASSERT_OK_AND_ASSIGN(auto x,
+                       activation.FindVariable(value_factory.get(), "x"));
+  EXPECT_THAT(x, Optional(IntValueIs(1)));
+  ASSERT_OK_AND_ASSIGN(auto y,
+                       activation.FindVariable(value_factory.get(), "y"));
+  EXPECT_THAT(y, Optional(IntValueIs(3)));
+  ASSERT_OK_AND_ASSIGN(auto z,
+                       activation.FindVariable(value_factory.get(), "z"));
+  EXPECT_THAT(z, Optional(IntValueIs(5)));
+  ASSERT_OK_AND_ASSIGN(auto w,
+                       activation.FindVariable(value_factory.get(), "w"));
+  EXPECT_EQ(w, absl::nullopt);
+
+  // The base is not modified.
+  ASSERT_OK_AND_ASSIGN(y, base->FindVariable(value_factory.get(), "y"));
+  EXPECT_THAT(y, Optional(IntValueIs(2)));
+}
+
+TEST(LayeredActivation, CopiesAreIndependent) {
+  ManagedValueFactory value_factory(TypeProvider::Builtin(),
+                                    MemoryManagerRef::ReferenceCounting());
+  LayeredActivation activation(std::make_shared<Activation>());
+  activation.InsertOrAssignValue("x", IntValue(1));
+
+  LayeredActivation copy = activation;
+  copy.InsertOrAssignValue("x", IntValue(2));
+  copy.InsertOrAssignValue("y", IntValue(3));
+
+  ASSERT_OK_AND_ASSIGN(auto x,
+                       activation.FindVariable(value_factory.get(), "x"));
+  EXPECT_THAT(x, Optional(IntValueIs(1)));
+  ASSERT_OK_AND_ASSIGN(auto y,
+                       activation.FindVariable(value_factory.get(), "y"));
+  EXPECT_EQ(y, absl::nullopt);
+  ASSERT_OK_AND_ASSIGN(x, copy.FindVariable(value_factory.get(), "x"));
+  EXPECT_THAT(x, Optional(IntValueIs(2)));
+}
+
+TEST(LayeredActivation, ProvidersAreShared) {
+  ManagedValueFactory value_factory(TypeProvider::Builtin(),
+                                    MemoryManagerRef::ReferenceCounting());
+  auto base = std::make_shared<Activation>();
+  int calls = 0;
+  base->InsertOrAssignValueProvider(
+      "x", [&calls](ValueManager&, absl::string_view)
+               -> absl::StatusOr<absl::optional<Value>> {
+        ++calls;
+        return IntValue(42);
+      });
+
+  for (int i = 0; i < 3; ++i) {
+    LayeredActivation activation(base);
+    ASSERT_OK_AND_ASSIGN(auto x,
+                         activation.FindVariable(value_factory.get(), "x"));
+    EXPECT_THAT(x, Optional(IntValueIs(42)));
+  }
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(LayeredActivation, AttributePatterns) {
+  auto base = std::make_shared<Activation>();
+  base->SetUnknownPatterns({AttributePattern("x", {})});
+
+  LayeredActivation activation(base);
+  EXPECT_THAT(activation.GetUnknownAttributes(), SizeIs(1));
+  EXPECT_THAT(activation.GetMissingAttributes(), IsEmpty());
+
+  activation.SetUnknownPatterns({});
+  activation.SetMissingPatterns({AttributePattern("y", {})});
+  EXPECT_THAT(activation.GetUnknownAttributes(), IsEmpty());
+  EXPECT_THAT(activation.GetMissingAttributes(), SizeIs(1));
+}
+
+TEST(LayeredActivation, Evaluate) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(auto expr, Parse("limit > request"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+
+  auto base = std::make_shared<Activation>();
+  base->InsertOrAssignValue("limit", IntValue(10));
+
+  LayeredActivation small(base);
+  small.InsertOrAssignValue("request", IntValue(1));
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(small, value_factory.get()));
+  EXPECT_THAT(result, BoolValueIs(true));
+
+  LayeredActivation large(base);
+  large.InsertOrAssignValue("request", IntValue(100));
+  ASSERT_OK_AND_ASSIGN(result, program->Evaluate(large, value_factory.get()));
+  EXPECT_THAT(result, BoolValueIs(false));
+}
+
+}  // namespace
+}  // namespace cel
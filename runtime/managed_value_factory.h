@@ -15,22 +15,25 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_MANAGED_VALUE_FACTORY_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_MANAGED_VALUE_FACTORY_H_
 
+#include "absl/base/nullability.h"
 #include "base/type_provider.h"
 #include "common/memory.h"
 #include "common/type_factory.h"
 #include "common/type_manager.h"
 #include "common/value_manager.h"
-#include "common/values/legacy_value_manager.h"
+#include "runtime/evaluation_value_manager.h"
 
 namespace cel {
 
 // A convenience class for managing objects associated with a ValueManager.
 class ManagedValueFactory {
  public:
-  // type_provider and memory_manager must outlive the ManagedValueFactory.
+  // type_provider, memory_manager and interned_types must outlive the
+  // ManagedValueFactory. See EvaluationValueManager for `interned_types`.
   ManagedValueFactory(const TypeProvider& type_provider,
-                      MemoryManagerRef memory_manager)
-      : value_manager_(memory_manager, type_provider) {}
+                      MemoryManagerRef memory_manager,
+                      absl::Nullable<TypeFactory*> interned_types = nullptr)
+      : value_manager_(type_provider, memory_manager, interned_types) {}
 
   // Move-only
   ManagedValueFactory(const ManagedValueFactory& other) = delete;
@@ -41,7 +44,7 @@ class ManagedValueFactory {
   ValueManager& get() { return value_manager_; }
 
  private:
-  common_internal::LegacyValueManager value_manager_;
+  EvaluationValueManager value_manager_;
 };
 
 }  // namespace cel
@@ -52,6 +52,7 @@ namespace {
 using ::cel::extensions::ProtobufRuntimeAdapter;
 using ::cel::extensions::ProtoMemoryManagerRef;
 using ::cel::test::BoolValueIs;
+using ::cel::test::ErrorValueIs;
 using ::cel::test::IntValueIs;
 using ::cel::test::OptionalValueIs;
 using ::cel::test::OptionalValueIsEmpty;
@@ -267,7 +268,21 @@ INSTANTIATE_TEST_SUITE_P(
             {"optional_orValue_absent", "optional.ofNonZeroValue(0).orValue(1)",
              IntValueIs(1)},
             {"optional_orValue_present", "optional.of(1).orValue(2)",
-             IntValueIs(1)}}),
+             IntValueIs(1)},
+            {"optional_select_chain_present",
+             "{'a': {'b': 1}}.?a.?b.orValue(2)", IntValueIs(1)},
+            {"optional_select_chain_absent",
+             "{'a': {'b': 1}}.?a.?c.orValue(2)", IntValueIs(2)},
+            {"optional_select_chain_absent_operand",
+             "{'a': {'b': 1}}.?c.?b.orValue(2)", IntValueIs(2)},
+            {"optional_select_optional_operand",
+             "optional.of({'a': 1}).?a.orValue(2)", IntValueIs(1)},
+            {"optional_select_none_operand", "optional.none().?a.orValue(2)",
+             IntValueIs(2)},
+            {"optional_select_chain_not_a_container",
+             "{'a': 1}.?a.?b.orValue(2)",
+             ErrorValueIs(StatusIs(absl::StatusCode::kUnknown,
+                                   HasSubstr("_[?_]")))}}),
         /*enable_short_circuiting*/ testing::Bool()),
     OptionalTypesTest::ToString);
 
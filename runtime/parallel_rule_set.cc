@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/parallel_rule_set.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "base/attribute.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/runtime.h"
+#include "runtime/variable_layout.h"
+
+namespace cel {
+
+namespace {
+
+// The activation of a single rule, which can be cancelled on its own unless
+// the activation of the evaluation already has a cancellation token.
+class RuleActivation final : public ActivationInterface {
+ public:
+  RuleActivation(const ActivationInterface& activation,
+                 const CancellationToken& token)
+      : activation_(activation), token_(token) {}
+
+  absl::StatusOr<absl::optional<ValueView>> FindVariable(
+      ValueManager& factory, absl::string_view name,
+      Value& scratch) const override {
+    return activation_.FindVariable(factory, name, scratch);
+  }
+  using ActivationInterface::FindVariable;
+
+  absl::Nullable<const Value*> FindVariableBySlot(
+      const VariableLayout& layout, size_t slot) const override {
+    return activation_.FindVariableBySlot(layout, slot);
+  }
+
+  std::vector<FunctionOverloadReference> FindFunctionOverloads(
+      absl::string_view name) const override {
+    return activation_.FindFunctionOverloads(name);
+  }
+
+  absl::Span<const AttributePattern> GetUnknownAttributes() const override {
+    return activation_.GetUnknownAttributes();
+  }
+
+  absl::Span<const AttributePattern> GetMissingAttributes() const override {
+    return activation_.GetMissingAttributes();
+  }
+
+  absl::Time GetDeadline() const override { return activation_.GetDeadline(); }
+
+  absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const override {
+    if (const CancellationToken* token = activation_.GetCancellationToken();
+        token != nullptr) {
+      return token;
+    }
+    return &token_;
+  }
+
+ private:
+  const ActivationInterface& activation_;
+  const CancellationToken& token_;
+};
+
+bool IsTrue(const absl::StatusOr<Value>& result) {
+  return result.ok() && result->Is<BoolValue>() &&
+         result->As<BoolValue>().NativeValue();
+}
+
+}  // namespace
+
+absl::StatusOr<ParallelRuleSet> ParallelRuleSet::Create(
+    const Runtime& runtime, std::vector<std::unique_ptr<Ast>> rules,
+    Runtime::BatchExecutor executor) {
+  std::vector<absl::StatusOr<std::unique_ptr<Program>>> programs =
+      runtime.CreatePrograms(absl::MakeSpan(rules), executor);
+  std::vector<std::unique_ptr<Program>> planned;
+  planned.reserve(programs.size());
+  for (absl::StatusOr<std::unique_ptr<Program>>& program : programs) {
+    if (!program.ok()) {
+      return std::move(program).status();
+    }
+    planned.push_back(*std::move(program));
+  }
+  return ParallelRuleSet(std::move(planned));
+}
+
+std::vector<absl::StatusOr<Value>> ParallelRuleSet::Evaluate(
+    const ActivationInterface& activation,
+    absl::Span<ValueManager* const> value_managers,
+    Runtime::BatchExecutor executor) const {
+  std::vector<absl::StatusOr<Value>> results(rules_.size());
+  const size_t num_shards = std::min(value_managers.size(), rules_.size());
+  if (num_shards == 0) {
+    return results;
+  }
+  std::atomic<size_t> next_rule{0};
+  executor(num_shards, [&](size_t shard) {
+    ValueManager& value_manager = *value_managers[shard];
+    for (size_t rule = next_rule.fetch_add(1, std::memory_order_relaxed);
+         rule < rules_.size();
+         rule = next_rule.fetch_add(1, std::memory_order_relaxed)) {
+      results[rule] = rules_[rule]->Evaluate(activation, value_manager);
+    }
+  });
+  return results;
+}
+
+absl::StatusOr<absl::optional<size_t>> ParallelRuleSet::EvaluateFirstMatch(
+    const ActivationInterface& activation,
+    absl::Span<ValueManager* const> value_managers,
+    Runtime::BatchExecutor executor) const {
+  const size_t rule_count = rules_.size();
+  std::vector<absl::StatusOr<Value>> results(rule_count);
+  const size_t num_shards = std::min(value_managers.size(), rule_count);
+  if (num_shards == 0) {
+    return absl::nullopt;
+  }
+  std::vector<CancellationToken> tokens(rule_count);
+  // Rules are claimed in order, so every rule before the first match is
+  // claimed, and evaluated to completion, before the match is known.
+  std::atomic<size_t> next_rule{0};
+  std::atomic<size_t> first_match{rule_count};
+  executor(num_shards, [&](size_t shard) {
+    ValueManager& value_manager = *value_managers[shard];
+    for (;;) {
+      const size_t rule = next_rule.fetch_add(1);
+      if (rule >= rule_count || rule > first_match.load()) {
+        return;
+      }
+      RuleActivation rule_activation(activation, tokens[rule]);
+      results[rule] = rules_[rule]->Evaluate(rule_activation, value_manager);
+      if (!IsTrue(results[rule])) {
+        continue;
+      }
+      size_t match = first_match.load();
+      while (rule < match && !first_match.compare_exchange_weak(match, rule)) {
+      }
+      if (rule < match) {
+        // A shard claiming a rule after the match was recorded sees it and
+        // returns, so only the rules claimed so far may be under evaluation.
+        const size_t claimed = std::min(next_rule.load(), rule_count);
+        for (size_t later = rule + 1; later < claimed; ++later) {
+          tokens[later].Cancel();
+        }
+      }
+    }
+  });
+
+  const size_t match = first_match.load();
+  for (size_t rule = 0; rule < match; ++rule) {
+    if (!results[rule].ok()) {
+      return results[rule].status();
+    }
+  }
+  if (match == rule_count) {
+    return absl::nullopt;
+  }
+  return match;
+}
+
+}  // namespace cel
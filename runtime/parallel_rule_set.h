@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_PARALLEL_RULE_SET_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_PARALLEL_RULE_SET_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/activation_interface.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+// Independent programs, the rules, evaluated concurrently over the same
+// activation.
+//
+// Unlike Runtime::CreateRuleSetProgram, which plans the rules as one program
+// evaluated on the calling thread, every rule is its own program and the
+// rules are spread across the shards of an executor. Shards claim the next
+// rule not yet claimed whenever they finish one, so a shard held up by an
+// expensive rule doesn't hold back the rules after it.
+//
+// Each shard evaluates with its own value manager, so the value managers
+// don't need to be thread safe, and the results of a shard are allocated with
+// its value manager. The activation is read by all the shards concurrently,
+// so it must be thread safe, as Activation is.
+//
+// The number of value managers bounds the number of shards of an evaluation.
+// Passing fewer value managers than the threads of a pool shared by requests
+// bounds the share of the pool taken by each request.
+class ParallelRuleSet final {
+ public:
+  // Plans each of `rules` as a program with Runtime::CreatePrograms, running
+  // the planning on `executor`.
+  static absl::StatusOr<ParallelRuleSet> Create(
+      const Runtime& runtime, std::vector<std::unique_ptr<Ast>> rules,
+      Runtime::BatchExecutor executor);
+
+  explicit ParallelRuleSet(std::vector<std::unique_ptr<Program>> rules)
+      : rules_(std::move(rules)) {}
+
+  ParallelRuleSet(ParallelRuleSet&&) = default;
+  ParallelRuleSet& operator=(ParallelRuleSet&&) = default;
+
+  size_t rule_count() const { return rules_.size(); }
+
+  const Program& rule(size_t index) const { return *rules_[index]; }
+
+  // Evaluates every rule, returning their results in the order of the rules.
+  //
+  // Runs one shard per value manager, up to the number of rules, on
+  // `executor`. `value_managers` must not be empty unless there are no
+  // rules.
+  std::vector<absl::StatusOr<Value>> Evaluate(
+      const ActivationInterface& activation,
+      absl::Span<ValueManager* const> value_managers,
+      Runtime::BatchExecutor executor) const;
+
+  // Returns the index of the first rule evaluating to true, or
+  // `absl::nullopt` if none does.
+  //
+  // Once a rule matches, the rules after it are no longer started and the
+  // evaluations of those already started are cancelled, unless the activation
+  // has a cancellation token of its own (see
+  // ActivationInterface::GetCancellationToken). Returns the status of the
+  // first rule before the match whose evaluation failed, as evaluating the
+  // rules in order would.
+  absl::StatusOr<absl::optional<size_t>> EvaluateFirstMatch(
+      const ActivationInterface& activation,
+      absl::Span<ValueManager* const> value_managers,
+      Runtime::BatchExecutor executor) const;
+
+ private:
+  std::vector<std::unique_ptr<Program>> rules_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_PARALLEL_RULE_SET_H_
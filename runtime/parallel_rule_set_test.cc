@@ -0,0 +1,204 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/parallel_rule_set.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "base/ast.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_adapter.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::test::BoolValueIs;
+using ::cel::test::IntValueIs;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+using testing::ElementsAre;
+using testing::Optional;
+
+void RunOnThreads(size_t num_shards, absl::FunctionRef<void(size_t)> shard) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_shards; ++i) {
+    threads.emplace_back([&shard, i]() { shard(i); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+class ParallelRuleSetTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(auto builder,
+                         CreateStandardRuntimeBuilder(RuntimeOptions()));
+    // Counts its calls and returns false.
+    ASSERT_OK(
+        (UnaryFunctionAdapter<bool, int64_t>::RegisterGlobalOverload(
+            "count",
+            [this](ValueManager&, int64_t) {
+              calls_.fetch_add(1);
+              return false;
+            },
+            builder.function_registry())));
+    ASSERT_OK((UnaryFunctionAdapter<absl::StatusOr<Value>, int64_t>::
+                   RegisterGlobalOverload(
+                       "fail",
+                       [](ValueManager&, int64_t) -> absl::StatusOr<Value> {
+                         return absl::InternalError("fail");
+                       },
+                       builder.function_registry())));
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+    for (int i = 0; i < 4; ++i) {
+      value_factories_.push_back(std::make_unique<ManagedValueFactory>(
+          runtime_->GetTypeProvider(), MemoryManagerRef::ReferenceCounting()));
+      value_managers_.push_back(&value_factories_.back()->get());
+    }
+  }
+
+  absl::StatusOr<ParallelRuleSet> CreateRuleSet(
+      const std::vector<std::string>& expressions) {
+    std::vector<std::unique_ptr<Ast>> rules;
+    for (const std::string& expression : expressions) {
+      CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+      CEL_ASSIGN_OR_RETURN(rules.emplace_back(),
+                           extensions::CreateAstFromParsedExpr(expr));
+    }
+    return ParallelRuleSet::Create(*runtime_, std::move(rules),
+                                   RunOnThreads);
+  }
+
+  std::unique_ptr<const Runtime> runtime_;
+  std::vector<std::unique_ptr<ManagedValueFactory>> value_factories_;
+  std::vector<ValueManager*> value_managers_;
+  std::atomic<int> calls_{0};
+};
+
+TEST_F(ParallelRuleSetTest, EvaluatesEveryRuleInOrder) {
+  ASSERT_OK_AND_ASSIGN(
+      ParallelRuleSet rule_set,
+      CreateRuleSet({"x + 1", "x * 2", "x > 2", "[1, 2, 3].exists(y, y == x)",
+                     "x - 1", "x == 2"}));
+  ASSERT_EQ(rule_set.rule_count(), 6);
+  Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+  EXPECT_THAT(
+      rule_set.Evaluate(activation, value_managers_, RunOnThreads),
+      ElementsAre(IsOkAndHolds(IntValueIs(3)), IsOkAndHolds(IntValueIs(4)),
+                  IsOkAndHolds(BoolValueIs(false)),
+                  IsOkAndHolds(BoolValueIs(true)), IsOkAndHolds(IntValueIs(1)),
+                  IsOkAndHolds(BoolValueIs(true))));
+}
+
+TEST_F(ParallelRuleSetTest, EvaluatesWithFewerShardsThanRules) {
+  ASSERT_OK_AND_ASSIGN(ParallelRuleSet rule_set,
+                       CreateRuleSet({"count(1)", "count(2)", "count(3)"}));
+  Activation activation;
+  EXPECT_THAT(rule_set.Evaluate(activation,
+                                absl::MakeSpan(value_managers_).subspan(0, 1),
+                                RunOnThreads),
+              ElementsAre(IsOkAndHolds(BoolValueIs(false)),
+                          IsOkAndHolds(BoolValueIs(false)),
+                          IsOkAndHolds(BoolValueIs(false))));
+  EXPECT_EQ(calls_.load(), 3);
+}
+
+TEST_F(ParallelRuleSetTest, FirstMatch) {
+  ASSERT_OK_AND_ASSIGN(
+      ParallelRuleSet rule_set,
+      CreateRuleSet({"x == 1", "x == 2", "x > 0", "'x' == 1", "x == 3"}));
+  Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+  EXPECT_THAT(
+      rule_set.EvaluateFirstMatch(activation, value_managers_, RunOnThreads),
+      IsOkAndHolds(Optional(1)));
+
+  activation.InsertOrAssignValue("x", IntValue(-1));
+  EXPECT_THAT(
+      rule_set.EvaluateFirstMatch(activation, value_managers_, RunOnThreads),
+      IsOkAndHolds(absl::nullopt));
+}
+
+TEST_F(ParallelRuleSetTest, FirstMatchSkipsRulesAfterMatch) {
+  ASSERT_OK_AND_ASSIGN(ParallelRuleSet rule_set,
+                       CreateRuleSet({"count(1)", "true", "count(2)",
+                                      "count(3)"}));
+  Activation activation;
+  // A single shard evaluates the rules in order.
+  EXPECT_THAT(rule_set.EvaluateFirstMatch(
+                  activation, absl::MakeSpan(value_managers_).subspan(0, 1),
+                  RunOnThreads),
+              IsOkAndHolds(Optional(1)));
+  EXPECT_EQ(calls_.load(), 1);
+}
+
+TEST_F(ParallelRuleSetTest, FirstMatchReportsFailuresBeforeMatch) {
+  ASSERT_OK_AND_ASSIGN(ParallelRuleSet rule_set,
+                       CreateRuleSet({"fail(1)", "true"}));
+  Activation activation;
+  EXPECT_THAT(
+      rule_set.EvaluateFirstMatch(activation, value_managers_, RunOnThreads),
+      StatusIs(absl::StatusCode::kInternal, "fail"));
+
+  ASSERT_OK_AND_ASSIGN(rule_set, CreateRuleSet({"true", "fail(1)"}));
+  EXPECT_THAT(
+      rule_set.EvaluateFirstMatch(activation, value_managers_, RunOnThreads),
+      IsOkAndHolds(Optional(0)));
+}
+
+TEST_F(ParallelRuleSetTest, EmptyRuleSet) {
+  ASSERT_OK_AND_ASSIGN(ParallelRuleSet rule_set, CreateRuleSet({}));
+  Activation activation;
+  EXPECT_TRUE(
+      rule_set.Evaluate(activation, value_managers_, RunOnThreads).empty());
+  EXPECT_THAT(
+      rule_set.EvaluateFirstMatch(activation, value_managers_, RunOnThreads),
+      IsOkAndHolds(absl::nullopt));
+}
+
+TEST_F(ParallelRuleSetTest, CreateFailsOnInvalidRule) {
+  EXPECT_THAT(CreateRuleSet({"true", "undefined_function()"}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,188 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/partial_evaluation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "common/ast_rewrite.h"
+#include "common/ast_traverse.h"
+#include "common/ast_visitor_base.h"
+#include "common/constant.h"
+#include "common/expr.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "common/value_manager.h"
+#include "internal/status_macros.h"
+#include "runtime/activation_interface.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+
+absl::optional<Constant> ToConstant(const Value& value) {
+  Constant constant;
+  switch (value->kind()) {
+    case ValueKind::kNull:
+      constant.set_null_value();
+      return constant;
+    case ValueKind::kBool:
+      constant.set_bool_value(value.As<BoolValue>().NativeValue());
+      return constant;
+    case ValueKind::kInt:
+      constant.set_int_value(value.As<IntValue>().NativeValue());
+      return constant;
+    case ValueKind::kUint:
+      constant.set_uint_value(value.As<UintValue>().NativeValue());
+      return constant;
+    case ValueKind::kDouble:
+      constant.set_double_value(value.As<DoubleValue>().NativeValue());
+      return constant;
+    case ValueKind::kString:
+      constant.set_string_value(value.As<StringValue>().NativeString());
+      return constant;
+    case ValueKind::kBytes:
+      constant.set_bytes_value(value.As<BytesValue>().NativeString());
+      return constant;
+    case ValueKind::kDuration:
+      constant.set_duration_value(value.As<DurationValue>().NativeValue());
+      return constant;
+    case ValueKind::kTimestamp:
+      constant.set_timestamp_value(value.As<TimestampValue>().NativeValue());
+      return constant;
+    default:
+      return absl::nullopt;
+  }
+}
+
+class IdCollector : public AstVisitorBase {
+ public:
+  void PreVisitExpr(const Expr& expr) override { ids_.push_back(expr.id()); }
+
+  void PostVisitExpr(const Expr&) override {}
+
+  void PreVisitSelect(const Expr&, const SelectExpr&) override {}
+
+  const std::vector<int64_t>& ids() const { return ids_; }
+
+ private:
+  std::vector<int64_t> ids_;
+};
+
+// Folds the subexpressions with known values to constants.
+class ResidualRewriter : public AstRewriterBase {
+ public:
+  ResidualRewriter(const absl::flat_hash_map<int64_t, Constant>& constants,
+                   AstImpl& ast)
+      : constants_(constants), ast_(ast) {}
+
+  void TraversalStackUpdate(absl::Span<absl::Nonnull<const Expr*>> path)
+      override {
+    path_ = path;
+  }
+
+  bool PreVisitRewrite(Expr& expr) override {
+    if (expr.has_const_expr()) {
+      return false;
+    }
+    auto it = constants_.find(expr.id());
+    if (it == constants_.end() || InComprehensionLoop()) {
+      return false;
+    }
+    // The references and macro calls of the folded subexpressions no longer
+    // apply.
+    IdCollector collector;
+    AstTraverse(expr, collector);
+    for (int64_t id : collector.ids()) {
+      ast_.reference_map().erase(id);
+      ast_.source_info().mutable_macro_calls().erase(id);
+    }
+    expr.set_const_expr(it->second);
+    return true;
+  }
+
+ private:
+  // Returns true if the current subexpression is evaluated by the iterations
+  // of a comprehension.
+  bool InComprehensionLoop() const {
+    for (size_t i = 0; i + 1 < path_.size(); ++i) {
+      if (!path_[i]->has_comprehension_expr()) {
+        continue;
+      }
+      const auto& comprehension = path_[i]->comprehension_expr();
+      if (path_[i + 1] != &comprehension.iter_range() &&
+          path_[i + 1] != &comprehension.accu_init()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const absl::flat_hash_map<int64_t, Constant>& constants_;
+  AstImpl& ast_;
+  absl::Span<absl::Nonnull<const Expr*>> path_;
+};
+
+}  // namespace
+
+absl::StatusOr<PartialEvaluation> PartialEvaluation::Evaluate(
+    const TraceableProgram& program, const ActivationInterface& activation,
+    ValueManager& value_factory) {
+  PartialEvaluation evaluation;
+  CEL_ASSIGN_OR_RETURN(
+      evaluation.result_,
+      program.Trace(
+          activation,
+          [&evaluation](int64_t expr_id, const Value& value,
+                        ValueManager&) -> absl::Status {
+            if (absl::optional<Constant> constant = ToConstant(value);
+                constant.has_value()) {
+              evaluation.constants_.insert_or_assign(expr_id,
+                                                     *std::move(constant));
+            } else {
+              evaluation.constants_.erase(expr_id);
+            }
+            return absl::OkStatus();
+          },
+          value_factory));
+  return evaluation;
+}
+
+absl::StatusOr<std::unique_ptr<Ast>> PartialEvaluation::Residualize(
+    std::unique_ptr<Ast> ast) const {
+  if (ast == nullptr) {
+    return absl::InvalidArgumentError("residualized ast must not be null");
+  }
+  AstImpl& ast_impl = AstImpl::CastFromPublicAst(*ast);
+  ResidualRewriter rewriter(constants_, ast_impl);
+  AstRewrite(ast_impl.root_expr(), rewriter);
+  return ast;
+}
+
+}  // namespace cel
@@ -0,0 +1,86 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_PARTIAL_EVALUATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_PARTIAL_EVALUATION_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "base/ast.h"
+#include "common/constant.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/activation_interface.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+// The result of evaluating a program with unknown attributes or functions
+// (see RuntimeOptions::unknown_processing), along with the values of its
+// subexpressions which were known.
+//
+// Once the unknowns are resolved, the program doesn't have to be evaluated
+// again from scratch: Residualize returns the residual of its AST, in which
+// the known subexpressions are folded to constants, so that planning and
+// evaluating the residual only computes what depended on the unknowns. For
+// instance, evaluating `request.size < 10 && origin.allowed(request.path)`
+// with `origin` unknown yields the residual
+// `true && origin.allowed("/index.html")`.
+//
+// Residuals only depend on the value of the unknowns, so they may be cached
+// by the caller for activations which agree on the known attributes.
+class PartialEvaluation final {
+ public:
+  // Evaluates `program` over `activation`, recording the values of its
+  // subexpressions.
+  //
+  // Values are observed with an evaluation listener: recursively planned
+  // programs must be planned with RuntimeOptions::enable_recursive_tracing,
+  // otherwise no subexpressions are folded.
+  static absl::StatusOr<PartialEvaluation> Evaluate(
+      const TraceableProgram& program, const ActivationInterface& activation,
+      ValueManager& value_factory);
+
+  PartialEvaluation(PartialEvaluation&&) = default;
+  PartialEvaluation& operator=(PartialEvaluation&&) = default;
+
+  // The result of the evaluation, which is an UnknownValue if it depends on
+  // unknowns.
+  const Value& result() const { return result_; }
+
+  // Returns `ast`, the AST `program` was planned from, with its subexpressions
+  // whose values were known folded to constants.
+  //
+  // Only values of the kinds which have constants are folded (null, bool,
+  // int, uint, double, string, bytes, duration and timestamp); the other
+  // subexpressions keep their structure, with their own subexpressions
+  // folded. Subexpressions evaluated by the iterations of a comprehension are
+  // not folded, as their values differ between iterations.
+  absl::StatusOr<std::unique_ptr<Ast>> Residualize(
+      std::unique_ptr<Ast> ast) const;
+
+ private:
+  PartialEvaluation() = default;
+
+  Value result_;
+  // The known values of subexpressions, by expression id.
+  absl::flat_hash_map<int64_t, Constant> constants_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_PARTIAL_EVALUATION_H_
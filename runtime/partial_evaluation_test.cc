@@ -0,0 +1,143 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/partial_evaluation.h"
+
+#include <memory>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/ast.h"
+#include "base/attribute.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::CreateAstFromParsedExpr;
+using ::cel::extensions::CreateParsedExprFromAst;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+
+constexpr absl::string_view kExpression =
+    "size < 10 && [1, 2].all(x, x < size) && path in origin";
+
+class PartialEvaluationTest : public testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    RuntimeOptions options;
+    options.unknown_processing = UnknownProcessingOptions::kAttributeOnly;
+    options.max_recursion_depth = GetParam();
+    options.enable_recursive_tracing = true;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+    value_factory_ = std::make_unique<ManagedValueFactory>(
+        runtime_->GetTypeProvider(), MemoryManagerRef::ReferenceCounting());
+  }
+
+  ValueManager& value_factory() { return value_factory_->get(); }
+
+  absl::StatusOr<std::unique_ptr<Ast>> ParseAst(absl::string_view expression) {
+    CEL_ASSIGN_OR_RETURN(ParsedExpr parsed_expr, Parse(expression));
+    return CreateAstFromParsedExpr(parsed_expr);
+  }
+
+  std::unique_ptr<const Runtime> runtime_;
+  std::unique_ptr<ManagedValueFactory> value_factory_;
+};
+
+TEST_P(PartialEvaluationTest, FoldsKnownSubexpressions) {
+  ASSERT_OK_AND_ASSIGN(auto ast, ParseAst(kExpression));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TraceableProgram> program,
+                       runtime_->CreateTraceableProgram(std::move(ast)));
+  Activation activation;
+  activation.InsertOrAssignValue("size", IntValue(5));
+  activation.InsertOrAssignValue("path", StringValue("/a"));
+  activation.SetUnknownPatterns({AttributePattern("origin", {})});
+
+  ASSERT_OK_AND_ASSIGN(
+      PartialEvaluation evaluation,
+      PartialEvaluation::Evaluate(*program, activation, value_factory()));
+  EXPECT_TRUE(evaluation.result().Is<UnknownValue>());
+
+  ASSERT_OK_AND_ASSIGN(ast, ParseAst(kExpression));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Ast> residual,
+                       evaluation.Residualize(std::move(ast)));
+  ASSERT_OK_AND_ASSIGN(ParsedExpr residual_expr,
+                       CreateParsedExprFromAst(*residual));
+  // The residual is `true && "/a" in origin`.
+  const auto& root = residual_expr.expr().call_expr();
+  ASSERT_EQ(root.args_size(), 2);
+  EXPECT_TRUE(root.args(0).const_expr().bool_value());
+  const auto& in = root.args(1).call_expr();
+  ASSERT_EQ(in.args_size(), 2);
+  EXPECT_EQ(in.args(0).const_expr().string_value(), "/a");
+  EXPECT_EQ(in.args(1).ident_expr().name(), "origin");
+  EXPECT_TRUE(residual_expr.source_info().macro_calls().empty());
+
+  // The residual no longer needs the known variables.
+  ASSERT_OK_AND_ASSIGN(program,
+                       runtime_->CreateTraceableProgram(std::move(residual)));
+  Activation origin_activation;
+  ASSERT_OK_AND_ASSIGN(auto origin,
+                       value_factory().NewListValueBuilder(
+                           value_factory().GetDynListType()));
+  ASSERT_OK(origin->Add(StringValue("/a")));
+  origin_activation.InsertOrAssignValue("origin", std::move(*origin).Build());
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(origin_activation,
+                                         value_factory()));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(PartialEvaluationTest, FoldsCompleteEvaluation) {
+  ASSERT_OK_AND_ASSIGN(auto ast, ParseAst("size < 10"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TraceableProgram> program,
+                       runtime_->CreateTraceableProgram(std::move(ast)));
+  Activation activation;
+  activation.InsertOrAssignValue("size", IntValue(20));
+
+  ASSERT_OK_AND_ASSIGN(
+      PartialEvaluation evaluation,
+      PartialEvaluation::Evaluate(*program, activation, value_factory()));
+  ASSERT_TRUE(evaluation.result().Is<BoolValue>());
+
+  ASSERT_OK_AND_ASSIGN(ast, ParseAst("size < 10"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Ast> residual,
+                       evaluation.Residualize(std::move(ast)));
+  ASSERT_OK_AND_ASSIGN(ParsedExpr residual_expr,
+                       CreateParsedExprFromAst(*residual));
+  EXPECT_FALSE(residual_expr.expr().const_expr().bool_value());
+  EXPECT_TRUE(residual_expr.expr().const_expr().has_bool_value());
+}
+
+INSTANTIATE_TEST_SUITE_P(PartialEvaluationTest, PartialEvaluationTest,
+                         testing::Values(0, -1));
+
+}  // namespace
+}  // namespace cel
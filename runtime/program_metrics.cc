@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "runtime/program_metrics.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/time/time.h"
+
+namespace cel {
+
+namespace {
+
+// Index of the shard of the calling thread. Threads are assigned shards
+// round robin when they first record a metric.
+size_t ThreadShard(size_t shards) {
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed);
+  return shard % shards;
+}
+
+}  // namespace
+
+ProgramMetrics::ProgramMetrics()
+    : shards_(std::make_unique<Shard[]>(kShards)) {}
+
+std::vector<absl::Duration> ProgramMetrics::LatencyBounds() {
+  std::vector<absl::Duration> bounds;
+  bounds.reserve(kLatencyBounds);
+  for (size_t i = 0; i < kLatencyBounds; ++i) {
+    bounds.push_back(absl::Microseconds(int64_t{1} << i));
+  }
+  return bounds;
+}
+
+size_t ProgramMetrics::LatencyBucket(absl::Duration latency) {
+  // The smallest i such that latency <= 2^i us.
+  int64_t micros =
+      absl::ToInt64Microseconds(absl::Ceil(latency, absl::Microseconds(1)));
+  if (micros <= 1) {
+    return 0;
+  }
+  size_t bucket = absl::bit_width(static_cast<uint64_t>(micros - 1));
+  return bucket < kLatencyBounds ? bucket : kLatencyBounds;
+}
+
+void ProgramMetrics::Record(Outcome outcome, absl::Duration latency,
+                            uint64_t iterations, uint64_t allocated_bytes) {
+  Shard& shard = shards_[ThreadShard(kShards)];
+  shard.outcomes[static_cast<size_t>(outcome)].fetch_add(
+      1, std::memory_order_relaxed);
+  shard.latency_buckets[LatencyBucket(latency)].fetch_add(
+      1, std::memory_order_relaxed);
+  shard.latency_sum_nanos.fetch_add(
+      static_cast<uint64_t>(absl::ToInt64Nanoseconds(latency)),
+      std::memory_order_relaxed);
+  if (iterations != 0) {
+    shard.iterations.fetch_add(iterations, std::memory_order_relaxed);
+  }
+  if (allocated_bytes != 0) {
+    shard.allocated_bytes.fetch_add(allocated_bytes,
+                                    std::memory_order_relaxed);
+  }
+}
+
+ProgramMetricsSnapshot ProgramMetrics::Snapshot() const {
+  ProgramMetricsSnapshot snapshot;
+  snapshot.latency_bounds = LatencyBounds();
+  snapshot.latency_bucket_counts.assign(kLatencyBounds + 1, 0);
+  uint64_t outcomes[kOutcomes] = {};
+  uint64_t latency_sum_nanos = 0;
+  for (size_t i = 0; i < kShards; ++i) {
+    const Shard& shard = shards_[i];
+    for (size_t j = 0; j < kOutcomes; ++j) {
+      outcomes[j] += shard.outcomes[j].load(std::memory_order_relaxed);
+    }
+    for (size_t j = 0; j <= kLatencyBounds; ++j) {
+      snapshot.latency_bucket_counts[j] +=
+          shard.latency_buckets[j].load(std::memory_order_relaxed);
+    }
+    latency_sum_nanos +=
+        shard.latency_sum_nanos.load(std::memory_order_relaxed);
+    snapshot.iterations += shard.iterations.load(std::memory_order_relaxed);
+    snapshot.allocated_bytes +=
+        shard.allocated_bytes.load(std::memory_order_relaxed);
+  }
+  snapshot.failures = outcomes[static_cast<size_t>(Outcome::kFailure)];
+  snapshot.error_results = outcomes[static_cast<size_t>(Outcome::kError)];
+  snapshot.unknown_results = outcomes[static_cast<size_t>(Outcome::kUnknown)];
+  for (uint64_t count : outcomes) {
+    snapshot.evaluations += count;
+  }
+  snapshot.latency_sum =
+      absl::Nanoseconds(static_cast<int64_t>(latency_sum_nanos));
+  if (lock_counter_) {
+    snapshot.shared_state_locks = lock_counter_();
+  }
+  return snapshot;
+}
+
+}  // namespace cel
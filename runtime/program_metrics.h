@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_METRICS_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace cel {
+
+// Aggregated metrics of the evaluations of a program, as of a call to
+// ProgramMetrics::Snapshot.
+//
+// The latency histogram has explicit bucket bounds, as the histograms of
+// OpenTelemetry: `latency_bucket_counts[i]` counts the evaluations which took
+// at most `latency_bounds[i]` and longer than `latency_bounds[i - 1]`, and the
+// last bucket counts those which took longer than every bound. Prometheus
+// histograms are the running sums of the bucket counts.
+struct ProgramMetricsSnapshot {
+  // Number of evaluations, including failed ones.
+  uint64_t evaluations = 0;
+  // Evaluations returning a non-ok status.
+  uint64_t failures = 0;
+  // Evaluations resulting in a CEL error.
+  uint64_t error_results = 0;
+  // Evaluations resulting in an unknown set.
+  uint64_t unknown_results = 0;
+
+  std::vector<absl::Duration> latency_bounds;
+  std::vector<uint64_t> latency_bucket_counts;
+  absl::Duration latency_sum = absl::ZeroDuration();
+
+  // Comprehension iterations, only counted if limited by
+  // `RuntimeOptions::comprehension_max_iterations`.
+  uint64_t iterations = 0;
+  // Bytes allocated by the evaluations, only counted if limited by
+  // `RuntimeOptions::max_evaluation_bytes`.
+  uint64_t allocated_bytes = 0;
+
+  // Locks taken by the evaluations in state shared across them, i.e. to
+  // intern a composite type the program had not created before. Evaluation
+  // state itself is never locked, so this stays flat in the steady state.
+  uint64_t shared_state_locks = 0;
+};
+
+// Metrics of the evaluations of a program, enabled by
+// `RuntimeOptions::enable_program_metrics` (see TraceableProgram::GetMetrics).
+//
+// Recording is lock-free: the counters are sharded, each thread incrementing
+// the counters of its own shard with relaxed atomic operations, and shards are
+// only summed by Snapshot. Thread safe.
+class ProgramMetrics final {
+ public:
+  enum class Outcome { kValue, kError, kUnknown, kFailure };
+
+  // Upper bounds of the latency buckets: powers of two from 1us to about 1s.
+  static constexpr size_t kLatencyBounds = 21;
+
+  ProgramMetrics();
+
+  ProgramMetrics(const ProgramMetrics&) = delete;
+  ProgramMetrics& operator=(const ProgramMetrics&) = delete;
+
+  static std::vector<absl::Duration> LatencyBounds();
+
+  void Record(Outcome outcome, absl::Duration latency, uint64_t iterations,
+              uint64_t allocated_bytes);
+
+  // Sets the function counting the locks taken in state shared by the
+  // evaluations, reported as `ProgramMetricsSnapshot::shared_state_locks`.
+  // Must be called before the metrics are shared between threads.
+  void set_lock_counter(std::function<uint64_t()> lock_counter) {
+    lock_counter_ = std::move(lock_counter);
+  }
+
+  ProgramMetricsSnapshot Snapshot() const;
+
+ private:
+  static constexpr size_t kShards = 16;
+  static constexpr size_t kOutcomes = 4;
+
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> outcomes[kOutcomes] = {};
+    std::atomic<uint64_t> latency_buckets[kLatencyBounds + 1] = {};
+    std::atomic<uint64_t> latency_sum_nanos{0};
+    std::atomic<uint64_t> iterations{0};
+    std::atomic<uint64_t> allocated_bytes{0};
+  };
+
+  static size_t LatencyBucket(absl::Duration latency);
+
+  std::unique_ptr<Shard[]> shards_;
+  std::function<uint64_t()> lock_counter_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_METRICS_H_
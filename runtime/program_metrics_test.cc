@@ -0,0 +1,112 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "runtime/program_metrics.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using testing::ElementsAreArray;
+using testing::SizeIs;
+
+using Outcome = ProgramMetrics::Outcome;
+
+TEST(ProgramMetrics, Empty) {
+  ProgramMetrics metrics;
+  ProgramMetricsSnapshot snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.evaluations, 0);
+  EXPECT_THAT(snapshot.latency_bounds, SizeIs(ProgramMetrics::kLatencyBounds));
+  EXPECT_THAT(snapshot.latency_bucket_counts,
+              ElementsAreArray(
+                  std::vector<uint64_t>(ProgramMetrics::kLatencyBounds + 1)));
+  EXPECT_EQ(snapshot.latency_sum, absl::ZeroDuration());
+}
+
+TEST(ProgramMetrics, Outcomes) {
+  ProgramMetrics metrics;
+  metrics.Record(Outcome::kValue, absl::ZeroDuration(), 0, 0);
+  metrics.Record(Outcome::kValue, absl::ZeroDuration(), 0, 0);
+  metrics.Record(Outcome::kError, absl::ZeroDuration(), 0, 0);
+  metrics.Record(Outcome::kUnknown, absl::ZeroDuration(), 0, 0);
+  metrics.Record(Outcome::kFailure, absl::ZeroDuration(), 3, 64);
+
+  ProgramMetricsSnapshot snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.evaluations, 5);
+  EXPECT_EQ(snapshot.error_results, 1);
+  EXPECT_EQ(snapshot.unknown_results, 1);
+  EXPECT_EQ(snapshot.failures, 1);
+  EXPECT_EQ(snapshot.iterations, 3);
+  EXPECT_EQ(snapshot.allocated_bytes, 64);
+}
+
+TEST(ProgramMetrics, LatencyHistogram) {
+  ProgramMetrics metrics;
+  for (absl::Duration latency :
+       {absl::Nanoseconds(10), absl::Microseconds(1), absl::Nanoseconds(1001),
+        absl::Microseconds(3), absl::Microseconds(4), absl::Seconds(10)}) {
+    metrics.Record(Outcome::kValue, latency, 0, 0);
+  }
+
+  ProgramMetricsSnapshot snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.latency_bounds[0], absl::Microseconds(1));
+  EXPECT_EQ(snapshot.latency_bounds[2], absl::Microseconds(4));
+  std::vector<uint64_t> expected(ProgramMetrics::kLatencyBounds + 1);
+  expected[0] = 2;
+  expected[1] = 1;
+  expected[2] = 2;
+  expected[ProgramMetrics::kLatencyBounds] = 1;
+  EXPECT_THAT(snapshot.latency_bucket_counts, ElementsAreArray(expected));
+  EXPECT_EQ(snapshot.latency_sum,
+            absl::Nanoseconds(10 + 1000 + 1001 + 3000 + 4000) +
+                absl::Seconds(10));
+}
+
+TEST(ProgramMetrics, SharedStateLocks) {
+  ProgramMetrics metrics;
+  EXPECT_EQ(metrics.Snapshot().shared_state_locks, 0);
+  uint64_t locks = 3;
+  metrics.set_lock_counter([&locks]() { return locks; });
+  EXPECT_EQ(metrics.Snapshot().shared_state_locks, 3);
+  locks = 4;
+  EXPECT_EQ(metrics.Snapshot().shared_state_locks, 4);
+}
+
+TEST(ProgramMetrics, ConcurrentRecords) {
+  ProgramMetrics metrics;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&metrics]() {
+      for (int j = 0; j < 1000; ++j) {
+        metrics.Record(Outcome::kValue, absl::Microseconds(1), 1, 0);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ProgramMetricsSnapshot snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.evaluations, 8000);
+  EXPECT_EQ(snapshot.iterations, 8000);
+  EXPECT_EQ(snapshot.latency_bucket_counts[0], 8000);
+}
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,51 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_REFERENCES_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_REFERENCES_H_
+
+#include <string>
+
+#include "absl/container/btree_set.h"
+
+namespace cel {
+
+// Names a planned program may reference during evaluation.
+//
+// Collected at plan time so that callers can skip building bindings the
+// program can never look up. The sets are conservative: a name may be listed
+// even if the branch referencing it is never evaluated, or was removed by a
+// later program optimization.
+struct ProgramReferences {
+  // Variables the program may look up in the activation. Qualified names are
+  // recorded after resolution against the expression container, e.g.
+  // `com.example.x` instead of `x`. Comprehension and bind variables are not
+  // included.
+  absl::btree_set<std::string> variables;
+
+  // Functions the program may call.
+  absl::btree_set<std::string> functions;
+
+  // Functions the program expects the activation to provide (registered as
+  // lazy functions). A subset of functions.
+  absl::btree_set<std::string> context_functions;
+
+  // Overload ids from the reference map of a checked expression. Empty for
+  // parsed-only expressions.
+  absl::btree_set<std::string> overload_ids;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_REFERENCES_H_
@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/program_replicas.h"
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "base/ast_internal/ast_impl.h"
+#include "runtime/runtime.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace cel {
+
+namespace {
+
+using ::cel::ast_internal::AstImpl;
+
+// Assigns the CPUs of a sysfs CPU list (e.g. "0-3,8-11") to `node` in
+// `cpu_nodes`. Returns false if the list is malformed.
+bool AddCpuList(absl::string_view list, size_t node,
+                std::vector<size_t>& cpu_nodes) {
+  for (absl::string_view range :
+       absl::StrSplit(list, ',', absl::SkipWhitespace())) {
+    std::pair<absl::string_view, absl::string_view> bounds =
+        absl::StrSplit(range, absl::MaxSplits('-', 1));
+    size_t first;
+    size_t last;
+    if (!absl::SimpleAtoi(bounds.first, &first)) {
+      return false;
+    }
+    if (bounds.second.empty()) {
+      last = first;
+    } else if (!absl::SimpleAtoi(bounds.second, &last) || last < first) {
+      return false;
+    }
+    if (cpu_nodes.size() <= last) {
+      cpu_nodes.resize(last + 1, 0);
+    }
+    for (size_t cpu = first; cpu <= last; ++cpu) {
+      cpu_nodes[cpu] = node;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int CurrentCpu() {
+#ifdef __linux__
+  return sched_getcpu();
+#else
+  return -1;
+#endif
+}
+
+std::vector<size_t> CpuNodes() {
+  std::vector<size_t> cpu_nodes;
+  for (size_t node = 0;; ++node) {
+    std::ifstream file(
+        absl::StrCat("/sys/devices/system/node/node", node, "/cpulist"));
+    if (!file) {
+      break;
+    }
+    std::string list;
+    std::getline(file, list);
+    if (!AddCpuList(list, node, cpu_nodes)) {
+      return {};
+    }
+  }
+  return cpu_nodes;
+}
+
+absl::StatusOr<ProgramReplicas> ProgramReplicas::Create(
+    const Runtime& runtime, const Ast& ast, size_t num_replicas,
+    Runtime::BatchExecutor executor, std::vector<size_t> cpu_replicas) {
+  if (num_replicas == 0) {
+    return absl::InvalidArgumentError("num_replicas must be positive");
+  }
+  for (size_t replica : cpu_replicas) {
+    if (replica >= num_replicas) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("cpu_replicas refers to replica ", replica, " of ",
+                       num_replicas));
+    }
+  }
+  const AstImpl& ast_impl = AstImpl::CastFromPublicAst(ast);
+  std::vector<std::unique_ptr<Ast>> asts;
+  asts.reserve(num_replicas);
+  for (size_t i = 0; i < num_replicas; ++i) {
+    asts.push_back(ast_impl.DeepCopy());
+  }
+  std::vector<absl::StatusOr<std::unique_ptr<Program>>> programs =
+      runtime.CreatePrograms(absl::MakeSpan(asts), executor);
+  std::vector<std::unique_ptr<Program>> replicas;
+  replicas.reserve(num_replicas);
+  for (absl::StatusOr<std::unique_ptr<Program>>& program : programs) {
+    if (!program.ok()) {
+      return std::move(program).status();
+    }
+    replicas.push_back(*std::move(program));
+  }
+  return ProgramReplicas(std::move(replicas), std::move(cpu_replicas));
+}
+
+const Program& ProgramReplicas::ForCurrentCpu() const {
+  const int cpu = CurrentCpu();
+  if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_replicas_.size()) {
+    return *replicas_.front();
+  }
+  return *replicas_[cpu_replicas_[cpu]];
+}
+
+}  // namespace cel
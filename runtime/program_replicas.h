@@ -0,0 +1,89 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_REPLICAS_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_REPLICAS_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "base/ast.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+// Returns the CPU the calling thread is running on, or -1 if the platform
+// doesn't tell.
+int CurrentCpu();
+
+// Returns the NUMA node of each CPU of the host, indexed by CPU number, or an
+// empty vector if the platform doesn't tell. Suitable as the `cpu_replicas`
+// of ProgramReplicas::Create for one replica per node.
+std::vector<size_t> CpuNodes();
+
+// Independently planned copies of the same program, so that the threads of
+// each NUMA node of a host can evaluate a copy allocated in the memory of
+// their node rather than reading the steps and constants of a single program
+// across sockets.
+//
+// Planning a replica allocates its steps, its constants and its precompiled
+// regular expressions on the planning thread, so with the usual first-touch
+// placement policy a replica resides on the node of the thread which planned
+// it. Regular expressions are only replicated if the runtime was built with
+// `RuntimeOptions::regex_cache_capacity` set to 0, otherwise the replicas
+// share the expressions of the process-wide cache.
+class ProgramReplicas final {
+ public:
+  // Plans `num_replicas` copies of `ast` with the runtime, calling `executor`
+  // once with one shard per replica. To place replica `i` on node `i`, the
+  // executor must run shard `i` on a thread bound to that node.
+  //
+  // `cpu_replicas` gives the index of the replica used by threads running on
+  // each CPU, indexed by CPU number, see CpuNodes. Threads running on other
+  // CPUs use the first replica.
+  //
+  // The replicas are planned with Runtime::CreatePrograms, which doesn't share
+  // programs through the program cache of the runtime.
+  static absl::StatusOr<ProgramReplicas> Create(
+      const Runtime& runtime, const Ast& ast, size_t num_replicas,
+      Runtime::BatchExecutor executor, std::vector<size_t> cpu_replicas = {});
+
+  ProgramReplicas(ProgramReplicas&&) = default;
+  ProgramReplicas& operator=(ProgramReplicas&&) = default;
+
+  size_t size() const { return replicas_.size(); }
+
+  const Program& replica(size_t index) const { return *replicas_[index]; }
+
+  // Returns the replica for the CPU the calling thread is running on. Threads
+  // may migrate between CPUs, so this should be called for each evaluation
+  // rather than once per thread.
+  const Program& ForCurrentCpu() const;
+
+ private:
+  ProgramReplicas(std::vector<std::unique_ptr<Program>> replicas,
+                  std::vector<size_t> cpu_replicas)
+      : replicas_(std::move(replicas)),
+        cpu_replicas_(std::move(cpu_replicas)) {}
+
+  std::vector<std::unique_ptr<Program>> replicas_;
+  std::vector<size_t> cpu_replicas_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_PROGRAM_REPLICAS_H_
@@ -0,0 +1,123 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/program_replicas.h"
+
+#include <cstddef>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "base/ast.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::test::BoolValueIs;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+
+void RunOnThreads(size_t num_shards, absl::FunctionRef<void(size_t)> shard) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_shards; ++i) {
+    threads.emplace_back([&shard, i]() { shard(i); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+class ProgramReplicasTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    RuntimeOptions options;
+    options.program_cache_size = 16;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, Parse("x.matches('^a+$')"));
+    ASSERT_OK_AND_ASSIGN(ast_, extensions::CreateAstFromParsedExpr(expr));
+  }
+
+  std::unique_ptr<const Runtime> runtime_;
+  std::unique_ptr<Ast> ast_;
+};
+
+TEST_F(ProgramReplicasTest, PlansIndependentReplicas) {
+  ASSERT_OK_AND_ASSIGN(
+      ProgramReplicas replicas,
+      ProgramReplicas::Create(*runtime_, *ast_, 2, RunOnThreads, {0, 1}));
+  ASSERT_EQ(replicas.size(), 2);
+  // Not shared through the program cache.
+  EXPECT_NE(&replicas.replica(0), &replicas.replica(1));
+
+  ManagedValueFactory value_factory(runtime_->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  Activation activation;
+  activation.InsertOrAssignValue("x", StringValue("aaa"));
+  for (size_t i = 0; i < replicas.size(); ++i) {
+    EXPECT_THAT(replicas.replica(i).Evaluate(activation, value_factory.get()),
+                IsOkAndHolds(BoolValueIs(true)));
+  }
+  EXPECT_THAT(
+      replicas.ForCurrentCpu().Evaluate(activation, value_factory.get()),
+      IsOkAndHolds(BoolValueIs(true)));
+}
+
+TEST_F(ProgramReplicasTest, ForCurrentCpu) {
+  // Every CPU mapped to the second replica.
+  std::vector<size_t> cpu_replicas(4096, 1);
+  ASSERT_OK_AND_ASSIGN(ProgramReplicas replicas,
+                       ProgramReplicas::Create(*runtime_, *ast_, 2,
+                                               RunOnThreads, cpu_replicas));
+  if (CurrentCpu() < 0) {
+    EXPECT_EQ(&replicas.ForCurrentCpu(), &replicas.replica(0));
+  } else {
+    EXPECT_EQ(&replicas.ForCurrentCpu(), &replicas.replica(1));
+  }
+}
+
+TEST_F(ProgramReplicasTest, InvalidArguments) {
+  EXPECT_THAT(ProgramReplicas::Create(*runtime_, *ast_, 0, RunOnThreads),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ProgramReplicas::Create(*runtime_, *ast_, 2, RunOnThreads, {2}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(CpuNodes, CoversCurrentCpu) {
+  std::vector<size_t> cpu_nodes = CpuNodes();
+  const int cpu = CurrentCpu();
+  if (!cpu_nodes.empty() && cpu >= 0) {
+    EXPECT_LT(static_cast<size_t>(cpu), cpu_nodes.size());
+  }
+}
+
+}  // namespace
+}  // namespace cel
@@ -80,6 +80,30 @@ class RegisterHelper {
     return Register(name, /*receiver_style=*/false, std::forward<FunctionT>(fn),
                     registry, /*strict=*/false);
   }
+
+  // Registers `Fn`, a function known at build time, which is called directly
+  // rather than through a std::function.
+  template <auto Fn>
+  static absl::Status RegisterStatic(absl::string_view name,
+                                     bool receiver_style,
+                                     FunctionRegistry& registry,
+                                     bool strict = true) {
+    return registry.Register(
+        AdapterT::CreateDescriptor(name, receiver_style, strict),
+        AdapterT::template WrapStaticFunction<Fn>());
+  }
+
+  template <auto Fn>
+  static absl::Status RegisterStaticGlobalOverload(absl::string_view name,
+                                                   FunctionRegistry& registry) {
+    return RegisterStatic<Fn>(name, /*receiver_style=*/false, registry);
+  }
+
+  template <auto Fn>
+  static absl::Status RegisterStaticMemberOverload(absl::string_view name,
+                                                   FunctionRegistry& registry) {
+    return RegisterStatic<Fn>(name, /*receiver_style=*/true, registry);
+  }
 };
 
 }  // namespace cel
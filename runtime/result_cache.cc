@@ -0,0 +1,245 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/result_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "eval/eval/function_memoizer.h"
+#include "internal/status_macros.h"
+#include "runtime/activation_interface.h"
+#include "runtime/program_references.h"
+#include "runtime/runtime.h"
+#include "runtime/variable_layout.h"
+
+namespace cel {
+
+namespace {
+
+using ::google::api::expr::runtime::FunctionMemoizer;
+
+class ResultCache final {
+ public:
+  ResultCache(size_t capacity, absl::Duration ttl)
+      : shard_capacity_(
+            std::max<size_t>((capacity + kNumShards - 1) / kNumShards, 1)),
+        ttl_(ttl),
+        shards_(std::make_unique<Shard[]>(kNumShards)) {}
+
+  absl::optional<Value> Find(absl::string_view key) const {
+    Shard& shard = ShardFor(key);
+    absl::MutexLock lock(&shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      return absl::nullopt;
+    }
+    if (absl::Now() - it->second->time > ttl_) {
+      shard.entries.erase(it->second);
+      shard.index.erase(it);
+      return absl::nullopt;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->value;
+  }
+
+  void Store(std::string key, Value value) const {
+    Shard& shard = ShardFor(key);
+    absl::MutexLock lock(&shard.mutex);
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      // Evaluated again after expiring, or concurrently by another thread.
+      it->second->value = std::move(value);
+      it->second->time = absl::Now();
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      return;
+    }
+    shard.entries.push_front(Entry{std::move(key), std::move(value),
+                                   absl::Now()});
+    shard.index.insert({shard.entries.front().key, shard.entries.begin()});
+    while (shard.entries.size() > shard_capacity_) {
+      shard.index.erase(shard.entries.back().key);
+      shard.entries.pop_back();
+    }
+  }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Entry {
+    std::string key;
+    Value value;
+    absl::Time time;
+  };
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    // Most recently used first.
+    std::list<Entry> entries ABSL_GUARDED_BY(mutex);
+    // Keys point into the key of the corresponding entry.
+    absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  Shard& ShardFor(absl::string_view key) const {
+    return shards_[absl::Hash<absl::string_view>{}(key) % kNumShards];
+  }
+
+  const size_t shard_capacity_;
+  const absl::Duration ttl_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+class ResultCachingProgram final : public Program {
+ public:
+  ResultCachingProgram(std::unique_ptr<Program> program,
+                       const ProgramReferences& references,
+                       const ResultCacheOptions& options)
+      : program_(std::move(program)),
+        references_(references),
+        layout_(program_->GetVariableLayout()),
+        stats_(options.stats),
+        cache_(options.capacity, options.ttl) {}
+
+  absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
+                                 ValueManager& value_factory) const override {
+    CEL_ASSIGN_OR_RETURN(absl::optional<std::string> key,
+                         MakeKey(activation, value_factory));
+    if (!key.has_value()) {
+      Count(&ResultCacheStats::bypasses);
+      return program_->Evaluate(activation, value_factory);
+    }
+    if (absl::optional<Value> cached = cache_.Find(*key); cached.has_value()) {
+      Count(&ResultCacheStats::hits);
+      return *std::move(cached);
+    }
+    Count(&ResultCacheStats::misses);
+    CEL_ASSIGN_OR_RETURN(Value result,
+                         program_->Evaluate(activation, value_factory));
+    if (absl::optional<Value> owned = FunctionMemoizer::OwnedCopy(result);
+        owned.has_value()) {
+      cache_.Store(*std::move(key), *std::move(owned));
+    }
+    return result;
+  }
+
+  const TypeProvider& GetTypeProvider() const override {
+    return program_->GetTypeProvider();
+  }
+
+  std::shared_ptr<const VariableLayout> GetVariableLayout() const override {
+    return layout_;
+  }
+
+  const ProgramReferences* GetReferences() const override {
+    return &references_;
+  }
+
+ private:
+  // Returns the key for the inputs of an evaluation with `activation`, or
+  // `absl::nullopt` if its result can't be cached.
+  absl::StatusOr<absl::optional<std::string>> MakeKey(
+      const ActivationInterface& activation,
+      ValueManager& value_factory) const {
+    if (!activation.GetUnknownAttributes().empty() ||
+        !activation.GetMissingAttributes().empty()) {
+      return absl::nullopt;
+    }
+    std::string key;
+    for (const std::string& name : references_.variables) {
+      absl::optional<Value> value;
+      if (layout_ != nullptr) {
+        if (absl::optional<size_t> slot = layout_->FindSlot(name);
+            slot.has_value()) {
+          if (const Value* bound = activation.FindVariableBySlot(*layout_,
+                                                                 *slot);
+              bound != nullptr) {
+            value = *bound;
+          }
+        }
+      }
+      if (!value.has_value()) {
+        CEL_ASSIGN_OR_RETURN(value,
+                             activation.FindVariable(value_factory, name));
+      }
+      if (!value.has_value()) {
+        key.push_back(0);
+        continue;
+      }
+      key.push_back(1);
+      if (!FunctionMemoizer::AppendKey(key, *value)) {
+        return absl::nullopt;
+      }
+    }
+    return key;
+  }
+
+  void Count(std::atomic<int64_t> ResultCacheStats::*counter) const {
+    if (stats_ != nullptr) {
+      (stats_.get()->*counter).fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::unique_ptr<Program> program_;
+  const ProgramReferences& references_;
+  std::shared_ptr<const VariableLayout> layout_;
+  std::shared_ptr<ResultCacheStats> stats_;
+  ResultCache cache_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<Program>> CreateResultCachingProgram(
+    std::unique_ptr<Program> program, ResultCacheOptions options) {
+  const ProgramReferences* references = program->GetReferences();
+  if (references == nullptr) {
+    return absl::FailedPreconditionError(
+        "result caching requires a program reporting its references");
+  }
+  if (!references->context_functions.empty()) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("result caching is unsupported for programs calling "
+                     "lazily bound function: ",
+                     *references->context_functions.begin()));
+  }
+  for (const std::string& function : options.impure_functions) {
+    if (references->functions.contains(function)) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "result caching is unsupported for programs calling impure "
+          "function: ",
+          function));
+    }
+  }
+  return std::make_unique<ResultCachingProgram>(std::move(program),
+                                                *references, options);
+}
+
+}  // namespace cel
@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_RESULT_CACHE_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_RESULT_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "runtime/runtime.h"
+
+namespace cel {
+
+// Counters for the evaluations of the programs sharing them. Updated without
+// locking during evaluation.
+struct ResultCacheStats {
+  // Evaluations answered with a cached result.
+  std::atomic<int64_t> hits{0};
+  // Evaluations which evaluated the program and may have cached the result.
+  std::atomic<int64_t> misses{0};
+  // Evaluations which bypassed the cache, because an input could not be part
+  // of a key or the activation declares unknown or missing attributes.
+  std::atomic<int64_t> bypasses{0};
+};
+
+struct ResultCacheOptions {
+  // Maximum number of results the cache holds. The least recently used
+  // results are evicted first.
+  size_t capacity = 1024;
+
+  // Maximum age of a cached result. Older results are evaluated again.
+  absl::Duration ttl = absl::InfiniteDuration();
+
+  // Functions whose results depend on more than their arguments, e.g. on the
+  // current time. Programs which may call them can't be cached.
+  std::vector<std::string> impure_functions;
+
+  // If set, counts the evaluations of the program.
+  std::shared_ptr<ResultCacheStats> stats;
+};
+
+// Wraps `program` so that evaluations with the same inputs are answered with
+// the result of an earlier evaluation.
+//
+// The key of an evaluation encodes the value of each variable the program may
+// read (see Program::GetReferences), or its absence, so that activations
+// binding other variables share results. Only variables of primitive kinds
+// (null, bool, int, uint, double, string, bytes, timestamp and duration) can
+// be part of a key; evaluations reading any other kind of value bypass the
+// cache, as do activations declaring unknown or missing attributes.
+//
+// Only results of primitive kinds are cached; errors, unknowns and non-ok
+// statuses never are. The cache is split across shards by key to reduce lock
+// contention, and is safe to use from multiple threads.
+//
+// Fails with a failed precondition error if the program doesn't report its
+// references, or may call an impure function or a function provided by the
+// activation (registered as a lazy function), whose results the cache can't
+// account for.
+absl::StatusOr<std::unique_ptr<Program>> CreateResultCachingProgram(
+    std::unique_ptr<Program> program, ResultCacheOptions options = {});
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_RESULT_CACHE_H_
@@ -0,0 +1,180 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/result_cache.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "base/ast.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/ast_converters.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/function_adapter.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel {
+namespace {
+
+using ::cel::test::ErrorValueIs;
+using ::cel::test::IntValueIs;
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
+using testing::_;
+using testing::HasSubstr;
+
+class ResultCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(auto builder,
+                         CreateStandardRuntimeBuilder(RuntimeOptions()));
+    // Counts its calls and returns its argument.
+    ASSERT_OK(
+        (UnaryFunctionAdapter<int64_t, int64_t>::RegisterGlobalOverload(
+            "count",
+            [this](ValueManager&, int64_t value) {
+              calls_.fetch_add(1);
+              return value;
+            },
+            builder.function_registry())));
+    ASSERT_OK(builder.function_registry().RegisterLazyFunction(
+        UnaryFunctionAdapter<int64_t, int64_t>::CreateDescriptor(
+            "lazy", /*receiver_style=*/false)));
+    ASSERT_OK_AND_ASSIGN(runtime_, std::move(builder).Build());
+  }
+
+  absl::StatusOr<std::unique_ptr<Program>> CreateProgram(
+      absl::string_view expression, ResultCacheOptions options) {
+    CEL_ASSIGN_OR_RETURN(ParsedExpr expr, Parse(expression));
+    CEL_ASSIGN_OR_RETURN(std::unique_ptr<Ast> ast,
+                         extensions::CreateAstFromParsedExpr(expr));
+    CEL_ASSIGN_OR_RETURN(std::unique_ptr<Program> program,
+                         runtime_->CreateProgram(std::move(ast)));
+    options.stats = stats_;
+    return CreateResultCachingProgram(std::move(program), std::move(options));
+  }
+
+  absl::StatusOr<Value> Evaluate(const Program& program,
+                                 const Activation& activation) {
+    ManagedValueFactory value_factory(program.GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    return program.Evaluate(activation, value_factory.get());
+  }
+
+  std::unique_ptr<const Runtime> runtime_;
+  std::shared_ptr<ResultCacheStats> stats_ =
+      std::make_shared<ResultCacheStats>();
+  std::atomic<int> calls_{0};
+};
+
+TEST_F(ResultCacheTest, ReusesResultsForSameInputs) {
+  ASSERT_OK_AND_ASSIGN(auto program, CreateProgram("count(x) + y.size()", {}));
+  Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(1));
+  activation.InsertOrAssignValue("y", StringValue("foo"));
+  // Not referenced by the program, so not part of the key.
+  activation.InsertOrAssignValue("z", IntValue(1));
+
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(4)));
+  activation.InsertOrAssignValue("z", IntValue(2));
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(4)));
+  EXPECT_EQ(calls_.load(), 1);
+
+  activation.InsertOrAssignValue("y", StringValue("foobar"));
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(7)));
+  activation.InsertOrAssignValue("x", IntValue(2));
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(8)));
+  EXPECT_EQ(calls_.load(), 3);
+
+  EXPECT_EQ(stats_->hits.load(), 1);
+  EXPECT_EQ(stats_->misses.load(), 3);
+  EXPECT_EQ(stats_->bypasses.load(), 0);
+}
+
+TEST_F(ResultCacheTest, BypassesUnsupportedInputs) {
+  ASSERT_OK_AND_ASSIGN(auto program, CreateProgram("count(x.size())", {}));
+  Activation activation;
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+  ASSERT_OK_AND_ASSIGN(auto builder, value_factory.get().NewListValueBuilder(
+                                         value_factory.get().GetDynListType()));
+  ASSERT_OK(builder->Add(IntValue(1)));
+  activation.InsertOrAssignValue("x", std::move(*builder).Build());
+
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(1)));
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(1)));
+  EXPECT_EQ(calls_.load(), 2);
+  EXPECT_EQ(stats_->bypasses.load(), 2);
+}
+
+TEST_F(ResultCacheTest, DoesNotCacheErrors) {
+  ASSERT_OK_AND_ASSIGN(auto program, CreateProgram("count(x) / 0", {}));
+  Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(1));
+  EXPECT_THAT(Evaluate(*program, activation),
+              IsOkAndHolds(ErrorValueIs(StatusIs(_, HasSubstr("divide")))));
+  EXPECT_THAT(Evaluate(*program, activation),
+              IsOkAndHolds(ErrorValueIs(StatusIs(_, HasSubstr("divide")))));
+  EXPECT_EQ(calls_.load(), 2);
+  EXPECT_EQ(stats_->misses.load(), 2);
+}
+
+TEST_F(ResultCacheTest, ExpiresResults) {
+  ResultCacheOptions options;
+  options.ttl = absl::ZeroDuration();
+  ASSERT_OK_AND_ASSIGN(auto program, CreateProgram("count(x)", options));
+  Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(1));
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(1)));
+  absl::SleepFor(absl::Milliseconds(1));
+  EXPECT_THAT(Evaluate(*program, activation), IsOkAndHolds(IntValueIs(1)));
+  EXPECT_EQ(calls_.load(), 2);
+}
+
+TEST_F(ResultCacheTest, RejectsImpureFunctions) {
+  ResultCacheOptions options;
+  options.impure_functions = {"count"};
+  EXPECT_THAT(CreateProgram("count(1)", options),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("impure function: count")));
+  EXPECT_OK(CreateProgram("1 + 1", options));
+}
+
+TEST_F(ResultCacheTest, RejectsLazyFunctions) {
+  EXPECT_THAT(CreateProgram("lazy(1)", {}),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("lazily bound function: lazy")));
+}
+
+}  // namespace
+}  // namespace cel
@@ -17,21 +17,32 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/attributes.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/ast.h"
 #include "base/type_provider.h"
 #include "common/native_type.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "runtime/activation_interface.h"
+#include "runtime/program_metrics.h"
+#include "runtime/program_references.h"
 #include "runtime/runtime_issue.h"
+#include "runtime/trace_buffer.h"
+#include "runtime/variable_layout.h"
 
 namespace cel {
 
@@ -75,7 +86,40 @@ class Program {
   virtual absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
                                          ValueManager& value_factory) const = 0;
 
+  // Evaluate the program, returning a view of the result instead of a copy.
+  //
+  // The view may refer to `scratch`, to memory owned by `value_factory` or to
+  // memory owned by the program, e.g. when the program was folded into a
+  // constant, so it must not be used beyond the lifetime of any of the three.
+  // Callers which only inspect the result can avoid copying it, and the
+  // reference counting that goes with it.
+  virtual absl::StatusOr<ValueView> EvaluateView(
+      const ActivationInterface& activation, ValueManager& value_factory,
+      Value& scratch ABSL_ATTRIBUTE_LIFETIME_BOUND) const {
+    absl::StatusOr<Value> result = Evaluate(activation, value_factory);
+    if (!result.ok()) {
+      return std::move(result).status();
+    }
+    scratch = *std::move(result);
+    return scratch;
+  }
+
   virtual const TypeProvider& GetTypeProvider() const = 0;
+
+  // Returns the slots assigned to the free variables referenced by the
+  // program, for binding variables with a SlotActivation.
+  //
+  // Returns nullptr if the implementation does not support binding variables
+  // by slot.
+  virtual std::shared_ptr<const VariableLayout> GetVariableLayout() const {
+    return nullptr;
+  }
+
+  // Returns the variables and functions the program may reference, or
+  // nullptr if the implementation does not track them.
+  //
+  // The returned pointer is valid for the lifetime of the program.
+  virtual const ProgramReferences* GetReferences() const { return nullptr; }
 };
 
 // Representation for a traceable CEL expression.
@@ -106,6 +150,179 @@ class TraceableProgram : public Program {
   virtual absl::StatusOr<Value> Trace(const ActivationInterface&,
                                       EvaluationListener evaluation_listener,
                                       ValueManager& value_factory) const = 0;
+
+  // Evaluate the Program plan, appending a record of the value of every
+  // program step that corresponds to an AST node to `trace_buffer`.
+  //
+  // Each step only writes a fixed-size record, so the records can be read
+  // after the evaluation or by another thread without slowing the evaluation
+  // down as an EvaluationListener doing the same work would. If the buffer is
+  // full the remaining records are dropped, see TraceBuffer.
+  absl::StatusOr<Value> TraceToBuffer(const ActivationInterface& activation,
+                                      TraceBuffer& trace_buffer,
+                                      ValueManager& value_factory) const {
+    return Trace(
+        activation,
+        [&trace_buffer](int64_t expr_id, const Value& value,
+                        ValueManager&) -> absl::Status {
+          trace_buffer.Append(expr_id, value);
+          return absl::OkStatus();
+        },
+        value_factory);
+  }
+
+  // Returns the metrics of the evaluations of the program, or nullptr unless
+  // enabled by `RuntimeOptions::enable_program_metrics`. Exporters read them
+  // with ProgramMetrics::Snapshot when scraped.
+  //
+  // The returned pointer is valid for the lifetime of the program. Programs
+  // shared through the program cache share their metrics.
+  virtual const ProgramMetrics* GetMetrics() const { return nullptr; }
+
+  // Executor used to split a batch evaluation across threads.
+  //
+  // The executor is called once with the number of shards and a callback that
+  // evaluates a single shard. It must invoke the callback exactly once for
+  // each shard index in [0, num_shards), possibly concurrently, and only return
+  // after all of the invocations have completed.
+  using BatchExecutor = absl::FunctionRef<void(
+      size_t num_shards, absl::FunctionRef<void(size_t shard)> run_shard)>;
+
+  // Evaluate the program once for each activation.
+  //
+  // Equivalent to calling Evaluate for each activation in order, but
+  // implementations may reuse evaluation state across the batch. Results are
+  // returned in the same order as the activations, a non-ok status for one
+  // activation does not stop evaluation of the rest of the batch.
+  virtual std::vector<absl::StatusOr<Value>> EvaluateBatch(
+      absl::Span<const ActivationInterface* const> activations,
+      ValueManager& value_factory) const {
+    std::vector<absl::StatusOr<Value>> results;
+    results.reserve(activations.size());
+    for (const ActivationInterface* activation : activations) {
+      results.push_back(Evaluate(*activation, value_factory));
+    }
+    return results;
+  }
+
+  // Evaluate the program once for each activation, splitting the batch into
+  // one contiguous shard per value manager and running the shards on the
+  // given executor.
+  //
+  // Each shard only uses its own value manager, so value managers do not need
+  // to be thread safe. `value_managers` must not be empty.
+  std::vector<absl::StatusOr<Value>> EvaluateBatch(
+      absl::Span<const ActivationInterface* const> activations,
+      absl::Span<ValueManager* const> value_managers,
+      BatchExecutor executor) const {
+    std::vector<absl::StatusOr<Value>> results(activations.size());
+    const size_t num_shards =
+        std::min(value_managers.size(), activations.size());
+    if (num_shards == 0) {
+      return results;
+    }
+    const size_t shard_size =
+        (activations.size() + num_shards - 1) / num_shards;
+    executor(num_shards, [&](size_t shard) {
+      const size_t begin = shard * shard_size;
+      if (begin >= activations.size()) {
+        return;
+      }
+      std::vector<absl::StatusOr<Value>> shard_results = EvaluateBatch(
+          activations.subspan(begin, shard_size), *value_managers[shard]);
+      std::move(shard_results.begin(), shard_results.end(),
+                results.begin() + begin);
+    });
+    return results;
+  }
+};
+
+// Representation of a set of CEL expressions, the rules, evaluated together
+// over the same activation.
+//
+// See Runtime::CreateRuleSetProgram for creating rule set programs.
+class RuleSetProgram {
+ public:
+  virtual ~RuleSetProgram() = default;
+
+  // Evaluate every rule, returning their results in the order of the rules.
+  //
+  // The results of the rules are independent: a rule evaluating to an error
+  // or an unknown doesn't change the results of the other rules. A non-ok
+  // status is only returned if the evaluation can't complete, as for
+  // Program::Evaluate.
+  virtual absl::StatusOr<std::vector<Value>> Evaluate(
+      const ActivationInterface& activation,
+      ValueManager& value_factory) const = 0;
+
+  // Returns the index of the first rule evaluating to true, or
+  // `absl::nullopt` if none does.
+  //
+  // Every rule is evaluated, in the same pass as Evaluate.
+  absl::StatusOr<absl::optional<size_t>> EvaluateFirstMatch(
+      const ActivationInterface& activation,
+      ValueManager& value_factory) const {
+    absl::StatusOr<std::vector<Value>> results =
+        Evaluate(activation, value_factory);
+    if (!results.ok()) {
+      return std::move(results).status();
+    }
+    for (size_t i = 0; i < results->size(); ++i) {
+      const Value& result = (*results)[i];
+      if (result.Is<BoolValue>() && result.As<BoolValue>().NativeValue()) {
+        return i;
+      }
+    }
+    return absl::nullopt;
+  }
+
+  // Number of rules in the set.
+  virtual size_t rule_count() const = 0;
+
+  virtual const TypeProvider& GetTypeProvider() const = 0;
+};
+
+// Representation of a CEL expression evaluated repeatedly over activations
+// which differ in a few variables, such as the latest values of a stream.
+//
+// The results of the subexpressions of the program are cached in a State
+// between evaluations. Each evaluation is told which variables changed since
+// the previous evaluation with the same state, and only recomputes the
+// subexpressions depending on them.
+//
+// The results of functions are assumed to only depend on their arguments.
+// Cached results may refer to memory of the value factory of the evaluation
+// which computed them and to the values bound for unchanged variables, which
+// must outlive the state.
+//
+// See Runtime::CreateIncrementalProgram for creating incremental programs.
+class IncrementalProgram {
+ public:
+  // The results cached by the evaluations of a program. Not thread safe.
+  class State {
+   public:
+    virtual ~State() = default;
+  };
+
+  virtual ~IncrementalProgram() = default;
+
+  // Returns a state with no results cached, for a new sequence of
+  // evaluations.
+  virtual std::unique_ptr<State> NewState() const = 0;
+
+  // Evaluate the program, reusing the results cached in `state` which don't
+  // depend on the variables or attribute paths (e.g. `request.user`) in
+  // `changed`. The first evaluation with a state computes every result.
+  //
+  // `state` must have been created by this program. Changes to the unknown or
+  // missing attribute patterns of the activation invalidate every result, and
+  // require a new state.
+  virtual absl::StatusOr<Value> Evaluate(const ActivationInterface& activation,
+                                         absl::Span<const std::string> changed,
+                                         State& state,
+                                         ValueManager& value_factory) const = 0;
+
+  virtual const TypeProvider& GetTypeProvider() const = 0;
 };
 
 // Interface for a CEL runtime.
@@ -142,6 +359,111 @@ class Runtime {
   CreateTraceableProgram(std::unique_ptr<cel::Ast> ast,
                          const CreateProgramOptions& options) const = 0;
 
+  // Executor used to create programs concurrently, with the same contract as
+  // TraceableProgram::BatchExecutor.
+  using BatchExecutor = TraceableProgram::BatchExecutor;
+
+  // Create one program for each AST, running one shard per AST on the given
+  // executor.
+  //
+  // Results are returned in the same order as the ASTs, failing to create one
+  // program does not stop creating the rest. Implementations may compute state
+  // shared by the whole batch once, so this is preferable to calling
+  // CreateProgram for each AST when creating many programs.
+  virtual std::vector<absl::StatusOr<std::unique_ptr<Program>>> CreatePrograms(
+      absl::Span<std::unique_ptr<cel::Ast>> asts,
+      BatchExecutor executor) const {
+    std::vector<absl::StatusOr<std::unique_ptr<Program>>> programs(
+        asts.size());
+    executor(asts.size(), [&](size_t shard) {
+      programs[shard] = CreateProgram(std::move(asts[shard]));
+    });
+    return programs;
+  }
+
+  absl::StatusOr<std::unique_ptr<RuleSetProgram>> CreateRuleSetProgram(
+      std::vector<std::unique_ptr<cel::Ast>> rules) const {
+    return CreateRuleSetProgram(std::move(rules), CreateProgramOptions{});
+  }
+
+  // Create a program evaluating all of `rules` over the same activation in a
+  // single pass.
+  //
+  // The rules are planned as one program, so that the attribute accesses
+  // shared by the rules (e.g. `request.user.id`) are evaluated at most once
+  // per evaluation rather than once per rule. Accesses are not shared if
+  // unknown processing or missing attribute errors are enabled. The rules must
+  // either all be checked or all be unchecked.
+  virtual absl::StatusOr<std::unique_ptr<RuleSetProgram>> CreateRuleSetProgram(
+      std::vector<std::unique_ptr<cel::Ast>> rules,
+      const CreateProgramOptions& options) const {
+    return absl::UnimplementedError(
+        "rule set programs are not supported by this runtime");
+  }
+
+  absl::StatusOr<std::unique_ptr<IncrementalProgram>> CreateIncrementalProgram(
+      std::unique_ptr<cel::Ast> ast) const {
+    return CreateIncrementalProgram(std::move(ast), CreateProgramOptions{});
+  }
+
+  // Create a program caching the results of its subexpressions between
+  // evaluations, for activations which change a few variables at a time.
+  virtual absl::StatusOr<std::unique_ptr<IncrementalProgram>>
+  CreateIncrementalProgram(std::unique_ptr<cel::Ast> ast,
+                           const CreateProgramOptions& options) const {
+    return absl::UnimplementedError(
+        "incremental programs are not supported by this runtime");
+  }
+
+  struct TieringOptions {
+    // The number of evaluations of the profiling plan after which the program
+    // is planned again using the collected profile. Must be positive.
+    int64_t profiled_evaluations = 1000;
+
+    // The number of times the second operand of a logical operator must have
+    // been evaluated during profiling for the operands to be reordered.
+    int64_t min_operand_evaluations = 100;
+
+    // Optional executor for planning the program again off the evaluating
+    // thread. It is called at most once, and must eventually invoke the given
+    // task. If empty, the evaluation reaching `profiled_evaluations` plans the
+    // program again before returning.
+    absl::AnyInvocable<void(absl::AnyInvocable<void()>)> executor;
+  };
+
+  absl::StatusOr<std::unique_ptr<Program>> CreateTieredProgram(
+      std::unique_ptr<cel::Ast> ast) const {
+    return CreateTieredProgram(std::move(ast), TieringOptions{},
+                               CreateProgramOptions{});
+  }
+
+  absl::StatusOr<std::unique_ptr<Program>> CreateTieredProgram(
+      std::unique_ptr<cel::Ast> ast, TieringOptions tiering_options) const {
+    return CreateTieredProgram(std::move(ast), std::move(tiering_options),
+                               CreateProgramOptions{});
+  }
+
+  // Create a program for expressions evaluated many times, which is planned
+  // again once it has been profiled.
+  //
+  // The first evaluations use a plan recording how often each operand of the
+  // logical operators (`&&` and `||`) decided the result. The program is then
+  // planned again with the operands reordered so that the operators
+  // short-circuit sooner for the profiled activations, and the new plan is
+  // used by the evaluations starting after it is ready. The operators are
+  // commutative, so only the error returned when both operands are errors may
+  // differ between the plans.
+  //
+  // The runtime must outlive the program. Destroying the program waits for a
+  // replan in progress and cancels a pending one, so a task handed to the
+  // executor may still run, doing nothing, after both are destroyed.
+  virtual absl::StatusOr<std::unique_ptr<Program>> CreateTieredProgram(
+      std::unique_ptr<cel::Ast> ast, TieringOptions tiering_options,
+      const CreateProgramOptions& options) const {
+    return absl::UnimplementedError(
+        "tiered programs are not supported by this runtime");
+  }
+
   virtual const TypeProvider& GetTypeProvider() const = 0;
 
  private:
@@ -34,6 +34,8 @@ class RuntimeFriendAccess;
 
 class RuntimeBuilder;
 RuntimeBuilder CreateRuntimeBuilder(const RuntimeOptions&);
+RuntimeBuilder CreateRuntimeBuilder(std::shared_ptr<const FunctionRegistry>,
+                                    const RuntimeOptions&);
 
 // RuntimeBuilder provides mutable accessors to configure a new runtime.
 //
@@ -61,6 +63,8 @@ class RuntimeBuilder {
  private:
   friend class runtime_internal::RuntimeFriendAccess;
   friend RuntimeBuilder CreateRuntimeBuilder(const RuntimeOptions&);
+  friend RuntimeBuilder CreateRuntimeBuilder(
+      std::shared_ptr<const FunctionRegistry>, const RuntimeOptions&);
 
   // Constructor for a new runtime builder.
   //
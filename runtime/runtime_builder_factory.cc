@@ -17,6 +17,7 @@
 #include <memory>
 #include <utility>
 
+#include "runtime/function_registry.h"
 #include "runtime/internal/runtime_impl.h"
 #include "runtime/runtime_builder.h"
 #include "runtime/runtime_options.h"
@@ -24,12 +25,19 @@
 namespace cel {
 
 RuntimeBuilder CreateRuntimeBuilder(const RuntimeOptions& options) {
+  return CreateRuntimeBuilder(nullptr, options);
+}
+
+RuntimeBuilder CreateRuntimeBuilder(
+    std::shared_ptr<const FunctionRegistry> base_functions,
+    const RuntimeOptions& options) {
   // TODO(uncreated-issue/57): and internal API for adding extensions that need to
   // downcast to the runtime impl.
   // TODO(uncreated-issue/56): add API for attaching an issue listener (replacing the
   // vector<status> overloads).
   auto mutable_runtime =
-      std::make_unique<runtime_internal::RuntimeImpl>(options);
+      std::make_unique<runtime_internal::RuntimeImpl>(
+          options, std::move(base_functions));
   mutable_runtime->expr_builder().set_container(options.container);
 
   auto& type_registry = mutable_runtime->type_registry();
@@ -15,6 +15,9 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_BUILDER_FACTORY_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_BUILDER_FACTORY_H_
 
+#include <memory>
+
+#include "runtime/function_registry.h"
 #include "runtime/runtime_builder.h"
 #include "runtime/runtime_options.h"
 
@@ -28,6 +31,13 @@ namespace cel {
 // Callers must register appropriate builtins.
 RuntimeBuilder CreateRuntimeBuilder(const RuntimeOptions& options);
 
+// Create an unconfigured builder whose function registry extends
+// `base_functions`, which is shared rather than copied and must not be
+// modified afterwards.
+RuntimeBuilder CreateRuntimeBuilder(
+    std::shared_ptr<const FunctionRegistry> base_functions,
+    const RuntimeOptions& options);
+
 }  // namespace cel
 
 #endif  // THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_BUILDER_FACTORY_H_
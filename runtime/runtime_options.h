@@ -17,9 +17,13 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_OPTIONS_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_RUNTIME_OPTIONS_H_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
 #include "absl/base/attributes.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 
 namespace cel {
 
@@ -34,6 +38,11 @@ enum class UnknownProcessingOptions {
   kAttributeAndFunction
 };
 
+// Runs each of the given tasks exactly once, possibly concurrently, and
+// returns once all of them completed.
+using ParallelTaskRunner =
+    std::function<void(absl::Span<const std::function<void()>> tasks)>;
+
 // Options for handling unset wrapper types on field access.
 enum class ProtoWrapperTypeOptions {
   // Default: legacy behavior following proto semantics (unset behaves as though
@@ -84,6 +93,9 @@ struct RuntimeOptions {
 
   // Enable list append within comprehensions. Note, this option is not safe
   // with hand-rolled ASTs.
+  //
+  // Comprehensions shaped like the map and filter macros, whose accumulator is
+  // only read to append to it, are appended to in place regardless.
   bool enable_comprehension_list_append = false;
 
   // Enable RE2 match() overload.
@@ -150,9 +162,149 @@ struct RuntimeOptions {
 
   // Enable tracing support for recursively planned programs.
   //
-  // Unlike the stack machine implementation, supporting tracing can affect
-  // performance whether or not tracing is requested for a given evaluation.
+  // A traced copy of each recursively planned program is kept and used for
+  // the evaluations which request tracing, so enabling this roughly doubles
+  // the cost of planning but not the cost of untraced evaluations.
   bool enable_recursive_tracing = false;
+
+  // Maximum number of idle evaluator states retained by each stack machine
+  // program for reuse across evaluations.
+  //
+  // Reusing states avoids allocating the value stack and comprehension slots
+  // for every evaluation. Idle states are kept until the program is destroyed.
+  //
+  // 0 disables pooling.
+  int evaluator_state_pool_size = 0;
+
+  // Capacity of the process-wide cache of compiled regular expressions used
+  // by `matches`, both for patterns precompiled at plan time and for patterns
+  // compiled during evaluation.
+  //
+  // The cache is shared by every runtime in the process and holds the largest
+  // capacity requested by any of them.
+  //
+  // 0 disables caching.
+  int regex_cache_capacity = 0;
+
+  // Minimum number of distinct constant patterns matched against the same
+  // operand, an identifier or a field selection on one, for regex
+  // precompilation to compile them into one multi-pattern RE2::Set. The
+  // operand is then scanned once per evaluation and each `matches` call
+  // answers from the set of matching patterns instead of running its own
+  // regex.
+  //
+  // Literal patterns, which are matched with string comparisons, don't count.
+  //
+  // 0 disables shared scans.
+  int regex_shared_scan_min_patterns = 0;
+
+  // Runner for splitting comprehensions evaluated as typed loops over a list
+  // of primitives (e.g. `xs.exists(x, x == 1)`) into tasks over chunks of the
+  // list, merged in order once all of them completed.
+  //
+  // Only comprehensions the planner can prove free of side effects are split,
+  // and the tasks neither allocate values nor access the activation. Results
+  // are the same as evaluating on the calling thread.
+  //
+  // Unset disables parallel evaluation.
+  ParallelTaskRunner comprehension_task_runner;
+
+  // Number of elements in each task given to `comprehension_task_runner`.
+  // Ranges of at most this size are evaluated on the calling thread.
+  int parallel_comprehension_chunk_size = 16384;
+
+  // Maximum number of bytes a single evaluation may allocate through its
+  // memory manager, counting both pooled and reference counted allocations
+  // made on the evaluating thread. Evaluation fails with a resource exhausted
+  // error once the budget is crossed. The check is made as comprehensions
+  // iterate and when the evaluation completes, so the budget may be exceeded
+  // by the allocations made in between.
+  //
+  // 0 disables the limit.
+  int64_t max_evaluation_bytes = 0;
+
+  // Hoist the values of cel.bind() out of the enclosing comprehension loops
+  // when their initializers don't reference any of the loops' variables.
+  //
+  // Such a value is computed at most once for each evaluation of the
+  // outermost loop it doesn't depend on, instead of once per iteration of the
+  // innermost loop. This assumes that functions return the same result when
+  // called again with the same arguments.
+  bool enable_bind_hoisting = false;
+
+  // Maximum cost of a single evaluation, counting 1 for each function call
+  // and 1 for each comprehension iteration. Evaluation fails with a resource
+  // exhausted error once the budget is crossed. cel::EstimateCost bounds the
+  // cost of an expression before it is planned.
+  //
+  // 0 disables the limit.
+  int64_t max_evaluation_cost = 0;
+
+  // Maximum number of programs cached by a runtime for reuse when it is asked
+  // to create a program for an AST it already planned, e.g. for expressions
+  // received repeatedly from clients.
+  //
+  // Programs are keyed by the expressions of the AST, including their ids, and
+  // by the references of checked ASTs. Cached programs are shared by the
+  // callers and least recently used programs are evicted first. Only applies
+  // to Runtime::CreateProgram and Runtime::CreateTraceableProgram.
+  //
+  // 0 disables caching.
+  int program_cache_size = 0;
+
+  // Maximum duration of a single evaluation. Evaluation fails with a deadline
+  // exceeded error once it runs for longer, or past the deadline of its
+  // activation (see ActivationInterface::GetDeadline) if that is earlier.
+  //
+  // The deadline is checked every ExecutionFrameBase::kInterruptCheckInterval
+  // evaluation steps and comprehension iterations, so evaluations may overrun
+  // it slightly, and function calls aren't interrupted.
+  absl::Duration evaluation_timeout = absl::InfiniteDuration();
+
+  // Make the string constants and field names of planned programs immortal:
+  // copying them during evaluation no longer adjusts a reference count that
+  // all the threads evaluating a program would contend on. They are deleted
+  // with the program instead.
+  //
+  // Requires that the values produced by an evaluation are not used once its
+  // program is destroyed, as is already the case for values allocated with an
+  // arena that doesn't outlive the program.
+  bool enable_immortal_constants = false;
+
+  // Share one copy of each string constant between all the programs created
+  // by the runtime, including the strings produced by constant folding,
+  // instead of each program holding its own. Takes precedence over
+  // `enable_immortal_constants` for string constants, which are then kept
+  // alive by reference counting.
+  //
+  // Regular expressions are shared separately, see `regex_cache_capacity`.
+  bool enable_shared_constant_pool = false;
+
+  // Declare that activations never bind a variable whose name resolves to an
+  // enum constant or, with `enable_qualified_type_identifiers`, to a type.
+  //
+  // Such identifiers are then planned as constants. Otherwise each evaluation
+  // first looks them up in the activation, in case a variable shadows them.
+  bool enable_closed_activation_schema = false;
+
+  // Record metrics of the evaluations of each program: outcomes, a latency
+  // histogram and the iterations and bytes counted against their budgets
+  // (see TraceableProgram::GetMetrics). Adds a clock read and a few relaxed
+  // atomic increments to each evaluation.
+  bool enable_program_metrics = false;
+
+  // Choose for each subexpression whether to plan it recursively or as stack
+  // machine steps from its shape, instead of planning recursively everything
+  // within `max_recursion_depth`, which must still be non-zero.
+  //
+  // Subexpressions are planned recursively up to a depth of 32 (or
+  // `max_recursion_depth` if lower) and nodes with more than 64 operands,
+  // e.g. large list literals, use the stack machine. Deeper or wider parts of
+  // the expression are planned as stack machine steps evaluating the
+  // recursively planned subexpressions below them. Comprehensions are planned
+  // recursively whenever `max_recursion_depth` allows, since their steps are
+  // evaluated for every iteration.
+  bool enable_adaptive_recursive_planning = false;
 };
 // LINT.ThenChange(//depot/google3/eval/public/cel_options.h)
 
@@ -0,0 +1,68 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/slot_activation.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/variable_layout.h"
+
+namespace cel {
+
+SlotActivation::SlotActivation(std::shared_ptr<const VariableLayout> layout)
+    : layout_(std::move(layout)), values_(layout_->size()) {}
+
+absl::StatusOr<absl::optional<ValueView>> SlotActivation::FindVariable(
+    ValueManager& factory, absl::string_view name, Value& scratch) const {
+  absl::optional<size_t> slot = layout_->FindSlot(name);
+  if (!slot.has_value() || !values_[*slot]) {
+    return absl::nullopt;
+  }
+  scratch = values_[*slot];
+  return scratch;
+}
+
+absl::Nullable<const Value*> SlotActivation::FindVariableBySlot(
+    const VariableLayout& layout, size_t slot) const {
+  if (&layout != layout_.get() || !values_[slot]) {
+    return nullptr;
+  }
+  return &values_[slot];
+}
+
+bool SlotActivation::InsertOrAssignValue(absl::string_view name,
+                                         Value value) {
+  absl::optional<size_t> slot = layout_->FindSlot(name);
+  if (!slot.has_value()) {
+    return false;
+  }
+  values_[*slot] = std::move(value);
+  return true;
+}
+
+void SlotActivation::Clear() {
+  for (Value& value : values_) {
+    value = Value();
+  }
+}
+
+}  // namespace cel
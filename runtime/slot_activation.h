@@ -0,0 +1,137 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_SLOT_ACTIVATION_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_SLOT_ACTIVATION_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/attribute.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/variable_layout.h"
+
+namespace cel {
+
+// Activation that binds variables by the slots assigned in a program's
+// VariableLayout.
+//
+// Identifiers in a program planned with the same layout are resolved by index
+// without hashing the variable name. Evaluating a different program with
+// this activation is supported, but falls back to resolving variables by
+// name.
+//
+// Usage:
+//
+//   SlotActivation activation(program->GetVariableLayout());
+//   activation.slots()[*activation.layout().FindSlot("x")] = IntValue(1);
+//   auto result = program->Evaluate(activation, value_manager);
+//
+// Slots that are left default constructed are unbound. The activation may be
+// reused across evaluations by rebinding the slots, but is not safe to modify
+// while an evaluation is in progress.
+class SlotActivation final : public ActivationInterface {
+ public:
+  // `layout` must not be null.
+  explicit SlotActivation(std::shared_ptr<const VariableLayout> layout);
+
+  // Implements ActivationInterface.
+  absl::StatusOr<absl::optional<ValueView>> FindVariable(
+      ValueManager& factory, absl::string_view name,
+      Value& scratch) const override;
+  using ActivationInterface::FindVariable;
+
+  absl::Nullable<const Value*> FindVariableBySlot(const VariableLayout& layout,
+                                                  size_t slot) const override;
+
+  // Context functions are not supported.
+  std::vector<FunctionOverloadReference> FindFunctionOverloads(
+      absl::string_view name) const override {
+    return {};
+  }
+
+  absl::Span<const cel::AttributePattern> GetUnknownAttributes()
+      const override {
+    return unknown_patterns_;
+  }
+
+  absl::Span<const cel::AttributePattern> GetMissingAttributes()
+      const override {
+    return missing_patterns_;
+  }
+
+  absl::Time GetDeadline() const override { return deadline_; }
+
+  absl::Nullable<const CancellationToken*> GetCancellationToken()
+      const override {
+    return cancellation_token_.get();
+  }
+
+  const VariableLayout& layout() const { return *layout_; }
+
+  // Values indexed by slot. Assign to a slot to bind the variable.
+  absl::Span<Value> slots() { return absl::MakeSpan(values_); }
+  absl::Span<const Value> slots() const { return values_; }
+
+  // Bind a value to a named variable.
+  //
+  // Returns false if the program does not reference the variable, in which
+  // case the value is dropped.
+  bool InsertOrAssignValue(absl::string_view name, Value value);
+
+  // Unbind all variables.
+  void Clear();
+
+  void SetUnknownPatterns(std::vector<cel::AttributePattern> patterns) {
+    unknown_patterns_ = std::move(patterns);
+  }
+
+  void SetMissingPatterns(std::vector<cel::AttributePattern> patterns) {
+    missing_patterns_ = std::move(patterns);
+  }
+
+  // See Activation::SetDeadline.
+  void SetDeadline(absl::Time deadline) { deadline_ = deadline; }
+
+  // See Activation::SetCancellationToken.
+  void SetCancellationToken(std::shared_ptr<const CancellationToken> token) {
+    cancellation_token_ = std::move(token);
+  }
+
+ private:
+  std::shared_ptr<const VariableLayout> layout_;
+  std::vector<Value> values_;
+
+  std::vector<cel::AttributePattern> unknown_patterns_;
+  std::vector<cel::AttributePattern> missing_patterns_;
+
+  absl::Time deadline_ = absl::InfiniteFuture();
+  std::shared_ptr<const CancellationToken> cancellation_token_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_SLOT_ACTIVATION_H_
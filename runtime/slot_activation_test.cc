@@ -0,0 +1,167 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/slot_activation.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/types/optional.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+#include "runtime/variable_layout.h"
+
+namespace cel {
+namespace {
+
+using ::cel::extensions::ProtobufRuntimeAdapter;
+using ::cel::test::BoolValueIs;
+using ::cel::test::ErrorValueIs;
+using ::cel::test::IntValueIs;
+using ::google::api::expr::parser::Parse;
+using testing::ElementsAre;
+using testing::Eq;
+using testing::Optional;
+using cel::internal::StatusIs;
+
+TEST(VariableLayout, AddVariable) {
+  VariableLayout layout;
+  EXPECT_EQ(layout.AddVariable("x"), 0);
+  EXPECT_EQ(layout.AddVariable("y"), 1);
+  EXPECT_EQ(layout.AddVariable("x"), 0);
+
+  EXPECT_EQ(layout.size(), 2);
+  EXPECT_THAT(layout.names(), ElementsAre("x", "y"));
+  EXPECT_THAT(layout.FindSlot("y"), Optional(Eq(1)));
+  EXPECT_EQ(layout.FindSlot("z"), absl::nullopt);
+}
+
+TEST(SlotActivation, FindVariable) {
+  auto layout = std::make_shared<VariableLayout>();
+  layout->AddVariable("x");
+  layout->AddVariable("y");
+  ManagedValueFactory value_factory(TypeProvider::Builtin(),
+                                    MemoryManagerRef::ReferenceCounting());
+
+  SlotActivation activation(layout);
+  EXPECT_TRUE(activation.InsertOrAssignValue("x", IntValue(1)));
+  EXPECT_FALSE(activation.InsertOrAssignValue("z", IntValue(3)));
+
+  ASSERT_OK_AND_ASSIGN(auto x,
+                       activation.FindVariable(value_factory.get(), "x"));
+  EXPECT_THAT(x, Optional(IntValueIs(1)));
+  ASSERT_OK_AND_ASSIGN(auto y,
+                       activation.FindVariable(value_factory.get(), "y"));
+  EXPECT_EQ(y, absl::nullopt);
+
+  ASSERT_NE(activation.FindVariableBySlot(*layout, 0), nullptr);
+  EXPECT_THAT(*activation.FindVariableBySlot(*layout, 0), IntValueIs(1));
+  EXPECT_EQ(activation.FindVariableBySlot(*layout, 1), nullptr);
+
+  // A different layout is never resolved by slot.
+  VariableLayout other;
+  other.AddVariable("x");
+  EXPECT_EQ(activation.FindVariableBySlot(other, 0), nullptr);
+
+  activation.Clear();
+  ASSERT_OK_AND_ASSIGN(x, activation.FindVariable(value_factory.get(), "x"));
+  EXPECT_EQ(x, absl::nullopt);
+}
+
+class SlotActivationProgramTest : public testing::TestWithParam<int> {};
+
+TEST_P(SlotActivationProgramTest, Evaluate) {
+  RuntimeOptions options;
+  options.max_recursion_depth = GetParam();
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(auto expr,
+                       Parse("x + y == z && [1, 2].all(e, e <= y)"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  std::shared_ptr<const VariableLayout> layout = program->GetVariableLayout();
+  ASSERT_NE(layout, nullptr);
+  // Comprehension variables are not part of the layout.
+  EXPECT_THAT(layout->names(), ElementsAre("x", "y", "z"));
+
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+
+  SlotActivation activation(layout);
+  activation.slots()[0] = IntValue(1);
+  activation.slots()[1] = IntValue(2);
+  activation.slots()[2] = IntValue(3);
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory.get()));
+  EXPECT_THAT(result, BoolValueIs(true));
+
+  activation.slots()[2] = IntValue(4);
+  ASSERT_OK_AND_ASSIGN(result,
+                       program->Evaluate(activation, value_factory.get()));
+  EXPECT_THAT(result, BoolValueIs(false));
+
+  activation.Clear();
+  ASSERT_OK_AND_ASSIGN(result,
+                       program->Evaluate(activation, value_factory.get()));
+  EXPECT_THAT(result, ErrorValueIs(StatusIs(absl::StatusCode::kUnknown,
+                                            testing::HasSubstr("\"x\""))));
+
+  // Name based activations still work.
+  Activation named;
+  named.InsertOrAssignValue("x", IntValue(1));
+  named.InsertOrAssignValue("y", IntValue(2));
+  named.InsertOrAssignValue("z", IntValue(3));
+  ASSERT_OK_AND_ASSIGN(result, program->Evaluate(named, value_factory.get()));
+  EXPECT_THAT(result, BoolValueIs(true));
+}
+
+TEST_P(SlotActivationProgramTest, MismatchedLayoutFallsBackToNames) {
+  RuntimeOptions options;
+  options.max_recursion_depth = GetParam();
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(auto expr, Parse("y - x"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  auto layout = std::make_shared<VariableLayout>();
+  layout->AddVariable("x");
+  layout->AddVariable("y");
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    MemoryManagerRef::ReferenceCounting());
+
+  SlotActivation activation(layout);
+  activation.slots()[0] = IntValue(1);
+  activation.slots()[1] = IntValue(3);
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       program->Evaluate(activation, value_factory.get()));
+  EXPECT_THAT(result, IntValueIs(2));
+}
+
+INSTANTIATE_TEST_SUITE_P(Planners, SlotActivationProgramTest,
+                         testing::Values(0, -1));
+
+}  // namespace
+}  // namespace cel
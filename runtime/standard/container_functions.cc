@@ -24,6 +24,7 @@
 #include "common/value_manager.h"
 #include "internal/status_macros.h"
 #include "runtime/function_registry.h"
+#include "runtime/internal/concat_list_value.h"
 #include "runtime/internal/mutable_list_impl.h"
 #include "runtime/runtime_options.h"
 
@@ -53,23 +54,10 @@ absl::StatusOr<ListValue> ConcatList(ValueManager& factory,
     return value1;
   }
 
-  // TODO(uncreated-issue/50): add option for checking lists have homogenous element
-  // types and use a more specialized list type when possible.
-  CEL_ASSIGN_OR_RETURN(auto list_builder,
-                       factory.NewListValueBuilder(factory.GetDynListType()));
-
-  list_builder->Reserve(size1 + size2);
-
-  for (int i = 0; i < size1; i++) {
-    CEL_ASSIGN_OR_RETURN(Value elem, value1.Get(factory, i));
-    CEL_RETURN_IF_ERROR(list_builder->Add(std::move(elem)));
-  }
-  for (int i = 0; i < size2; i++) {
-    CEL_ASSIGN_OR_RETURN(Value elem, value2.Get(factory, i));
-    CEL_RETURN_IF_ERROR(list_builder->Add(std::move(elem)));
-  }
-
-  return std::move(*list_builder).Build();
+  // The result views the elements of both lists in place, so that lists
+  // built like `defaults + extras` and only tested for membership are never
+  // copied.
+  return runtime_internal::ConcatListValues(factory, value1, value2);
 }
 
 // AppendList will append the elements in value2 to value1.
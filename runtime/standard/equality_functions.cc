@@ -31,6 +31,7 @@
 #include "base/kind.h"
 #include "common/casting.h"
 #include "common/value.h"
+#include "common/value_kind.h"
 #include "common/value_manager.h"
 #include "internal/number.h"
 #include "internal/status_macros.h"
@@ -119,20 +120,92 @@ absl::optional<bool> Equal(const TypeValue& lhs, const TypeValue& rhs) {
   return lhs.name() == rhs.name();
 }
 
+// Returns whether `lhs` and `rhs` are views of the same list.
+bool IsSameList(const ListValue& lhs, const ListValue& rhs) {
+  if (InstanceOf<ParsedListValue>(lhs) && InstanceOf<ParsedListValue>(rhs)) {
+    return Cast<ParsedListValue>(lhs).operator->() ==
+           Cast<ParsedListValue>(rhs).operator->();
+  }
+  if (InstanceOf<common_internal::LegacyListValue>(lhs) &&
+      InstanceOf<common_internal::LegacyListValue>(rhs)) {
+    return Cast<common_internal::LegacyListValue>(lhs).NativeValue() ==
+           Cast<common_internal::LegacyListValue>(rhs).NativeValue();
+  }
+  return false;
+}
+
+// Returns whether `lhs` and `rhs` are views of the same map.
+bool IsSameMap(const MapValue& lhs, const MapValue& rhs) {
+  if (InstanceOf<ParsedMapValue>(lhs) && InstanceOf<ParsedMapValue>(rhs)) {
+    return Cast<ParsedMapValue>(lhs).operator->() ==
+           Cast<ParsedMapValue>(rhs).operator->();
+  }
+  if (InstanceOf<common_internal::LegacyMapValue>(lhs) &&
+      InstanceOf<common_internal::LegacyMapValue>(rhs)) {
+    return Cast<common_internal::LegacyMapValue>(lhs).NativeValue() ==
+           Cast<common_internal::LegacyMapValue>(rhs).NativeValue();
+  }
+  return false;
+}
+
+// Returns whether `kind` is a kind whose values are always equal to
+// themselves. Doubles aren't (NaN), nor are containers which may hold them.
+bool IsReflexiveKind(ValueKind kind) {
+  switch (kind) {
+    case ValueKind::kBool:
+    case ValueKind::kNull:
+    case ValueKind::kInt:
+    case ValueKind::kUint:
+    case ValueKind::kDuration:
+    case ValueKind::kTimestamp:
+    case ValueKind::kString:
+    case ValueKind::kBytes:
+    case ValueKind::kCelType:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Compares a container's `element` with itself, as comparing the container
+// with another view of it would.
+template <typename EqualsProvider>
+absl::StatusOr<bool> SelfEqual(ValueManager& factory, ValueView element,
+                               absl::optional<bool>& result) {
+  if (IsReflexiveKind(element.kind())) {
+    return true;
+  }
+  Value value(element);
+  CEL_ASSIGN_OR_RETURN(result, EqualsProvider()(factory, value, value));
+  return result.has_value() && *result;
+}
+
+// Equality of a list with another view of itself, which only needs to read
+// each element once.
+template <typename EqualsProvider>
+absl::StatusOr<absl::optional<bool>> ListSelfEqual(ValueManager& factory,
+                                                   const ListValue& list) {
+  absl::optional<bool> result = true;
+  CEL_RETURN_IF_ERROR(list.ForEach(factory, [&](ValueView element) {
+    return SelfEqual<EqualsProvider>(factory, element, result);
+  }));
+  return result;
+}
+
 // Equality for lists. Template parameter provides either heterogeneous or
 // homogenous equality for comparing members.
 template <typename EqualsProvider>
 absl::StatusOr<absl::optional<bool>> ListEqual(ValueManager& factory,
                                                const ListValue& lhs,
                                                const ListValue& rhs) {
-  if (&lhs == &rhs) {
-    return true;
-  }
   CEL_ASSIGN_OR_RETURN(auto lhs_size, lhs.Size());
   CEL_ASSIGN_OR_RETURN(auto rhs_size, rhs.Size());
   if (lhs_size != rhs_size) {
     return false;
   }
+  if (IsSameList(lhs, rhs)) {
+    return ListSelfEqual<EqualsProvider>(factory, lhs);
+  }
 
   for (int i = 0; i < lhs_size; ++i) {
     CEL_ASSIGN_OR_RETURN(auto lhs_i, lhs.Get(factory, i));
@@ -211,46 +284,53 @@ template <typename EqualsProvider>
 absl::StatusOr<absl::optional<bool>> MapEqual(ValueManager& value_factory,
                                               const MapValue& lhs,
                                               const MapValue& rhs) {
-  if (&lhs == &rhs) {
-    return true;
-  }
-  if (lhs.Size() != rhs.Size()) {
+  CEL_ASSIGN_OR_RETURN(auto lhs_size, lhs.Size());
+  CEL_ASSIGN_OR_RETURN(auto rhs_size, rhs.Size());
+  if (lhs_size != rhs_size) {
     return false;
   }
 
-  CEL_ASSIGN_OR_RETURN(auto iter, lhs.NewIterator(value_factory));
-
-  while (iter->HasNext()) {
-    CEL_ASSIGN_OR_RETURN(auto lhs_key, iter->Next(value_factory));
-
-    Value rhs_value;
-    bool rhs_ok;
-    CEL_ASSIGN_OR_RETURN(std::tie(rhs_value, rhs_ok),
-                         rhs.Find(value_factory, lhs_key));
-
-    if (!rhs_ok && EqualsProvider::kIsHeterogeneous) {
-      CEL_ASSIGN_OR_RETURN(
-          auto maybe_rhs_value,
-          CheckAlternativeNumericType(value_factory, lhs_key, rhs));
-      rhs_ok = maybe_rhs_value.has_value();
-      if (rhs_ok) {
-        rhs_value = std::move(*maybe_rhs_value);
-      }
-    }
-    if (!rhs_ok) {
-      return false;
-    }
-
-    CEL_ASSIGN_OR_RETURN(auto lhs_value, lhs.Get(value_factory, lhs_key));
-    CEL_ASSIGN_OR_RETURN(absl::optional<bool> eq,
-                         EqualsProvider()(value_factory, lhs_value, rhs_value));
-
-    if (!eq.has_value() || !*eq) {
-      return eq;
-    }
+  absl::optional<bool> result = true;
+  if (IsSameMap(lhs, rhs)) {
+    // Keys are always equal to themselves, so only the values are compared.
+    CEL_RETURN_IF_ERROR(
+        lhs.ForEach(value_factory, [&](ValueView, ValueView lhs_value) {
+          return SelfEqual<EqualsProvider>(value_factory, lhs_value, result);
+        }));
+    return result;
   }
 
-  return true;
+  // Visiting the entries of `lhs` reads each of its values without looking
+  // their key up again, leaving one lookup in `rhs` per entry.
+  CEL_RETURN_IF_ERROR(lhs.ForEach(
+      value_factory,
+      [&](ValueView lhs_key,
+          ValueView lhs_value_view) -> absl::StatusOr<bool> {
+        Value rhs_value;
+        bool rhs_ok;
+        CEL_ASSIGN_OR_RETURN(std::tie(rhs_value, rhs_ok),
+                             rhs.Find(value_factory, lhs_key));
+
+        if (!rhs_ok && EqualsProvider::kIsHeterogeneous) {
+          CEL_ASSIGN_OR_RETURN(
+              auto maybe_rhs_value,
+              CheckAlternativeNumericType(value_factory, Value(lhs_key), rhs));
+          rhs_ok = maybe_rhs_value.has_value();
+          if (rhs_ok) {
+            rhs_value = std::move(*maybe_rhs_value);
+          }
+        }
+        if (!rhs_ok) {
+          result = false;
+          return false;
+        }
+
+        Value lhs_value(lhs_value_view);
+        CEL_ASSIGN_OR_RETURN(
+            result, EqualsProvider()(value_factory, lhs_value, rhs_value));
+        return result.has_value() && *result;
+      }));
+  return result;
 }
 
 // Helper for wrapping ==/!= implementations.
@@ -13,36 +13,56 @@
 // limitations under the License.
 #include "runtime/standard/regex_functions.h"
 
+#include <memory>
+
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "base/builtins.h"
 #include "base/function_adapter.h"
 #include "common/value.h"
 #include "common/value_manager.h"
+#include "internal/regex_cache.h"
 #include "internal/status_macros.h"
 #include "re2/re2.h"
 
 namespace cel {
-namespace {}  // namespace
+namespace {
+
+Value MatchRegex(ValueManager& value_factory, const StringValue& target,
+                 const RE2& re2, int max_size) {
+  if (max_size > 0 && re2.ProgramSize() > max_size) {
+    return value_factory.CreateErrorValue(
+        absl::InvalidArgumentError("exceeded RE2 max program size"));
+  }
+  if (!re2.ok()) {
+    return value_factory.CreateErrorValue(
+        absl::InvalidArgumentError("invalid regex for match"));
+  }
+  return value_factory.CreateBoolValue(
+      RE2::PartialMatch(target.ToString(), re2));
+}
+
+}  // namespace
 
 absl::Status RegisterRegexFunctions(FunctionRegistry& registry,
                                     const RuntimeOptions& options) {
   if (options.enable_regex) {
-    auto regex_matches = [max_size = options.regex_max_program_size](
-                             ValueManager& value_factory,
-                             const StringValue& target,
-                             const StringValue& regex) -> Value {
-      RE2 re2(regex.ToString());
-      if (max_size > 0 && re2.ProgramSize() > max_size) {
-        return value_factory.CreateErrorValue(
-            absl::InvalidArgumentError("exceeded RE2 max program size"));
-      }
-      if (!re2.ok()) {
-        return value_factory.CreateErrorValue(
-            absl::InvalidArgumentError("invalid regex for match"));
+    const bool use_cache = options.regex_cache_capacity > 0;
+    if (use_cache) {
+      internal::RegexCache::Global().EnsureCapacity(
+          options.regex_cache_capacity);
+    }
+    auto regex_matches = [max_size = options.regex_max_program_size,
+                          use_cache](ValueManager& value_factory,
+                                     const StringValue& target,
+                                     const StringValue& regex) -> Value {
+      if (use_cache) {
+        std::shared_ptr<const RE2> re2 =
+            internal::RegexCache::Global().GetOrCompile(regex.ToString());
+        return MatchRegex(value_factory, target, *re2, max_size);
       }
-      return value_factory.CreateBoolValue(
-          RE2::PartialMatch(target.ToString(), re2));
+      RE2 re2(regex.ToString());
+      return MatchRegex(value_factory, target, re2, max_size);
     };
 
     // bind str.matches(re) and matches(str, re)
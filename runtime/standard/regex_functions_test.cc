@@ -17,6 +17,7 @@
 
 #include "base/builtins.h"
 #include "base/function_descriptor.h"
+#include "internal/regex_cache.h"
 #include "internal/testing.h"
 
 namespace cel {
@@ -70,6 +71,16 @@ TEST(RegisterRegexFunctions, NotRegisteredIfDisabled) {
   EXPECT_THAT(overloads[builtin::kRegexMatch], IsEmpty());
 }
 
+TEST(RegisterRegexFunctions, EnablesProcessWideCache) {
+  FunctionRegistry registry;
+  RuntimeOptions options;
+  options.regex_cache_capacity = 32;
+
+  ASSERT_OK(RegisterRegexFunctions(registry, options));
+
+  EXPECT_GE(internal::RegexCache::Global().capacity(), 32);
+}
+
 // TODO(uncreated-issue/41): move functional parsed expr tests when modern APIs for
 // evaluator available.
 
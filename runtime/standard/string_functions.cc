@@ -14,53 +14,136 @@
 
 #include "runtime/standard/string_functions.h"
 
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "absl/functional/overload.h"
 #include "absl/status/status.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "base/builtins.h"
 #include "base/function_adapter.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "internal/status_macros.h"
+#include "internal/string_search.h"
 
 namespace cel {
 namespace {
 
+// Concatenations up to this size are copied into a flat string. Longer ones
+// are cords sharing the chunks of their operands, so that chains of `+` and
+// strings accumulated by comprehensions don't copy the prefix at every step.
+constexpr size_t kMaxFlatConcatSize = 256;
+
+// Returns the concatenation of two flat operands if it is small enough to be
+// flat, `absl::nullopt` otherwise.
+template <typename T>
+absl::optional<std::string> FlatConcat(const T& value1, const T& value2) {
+  auto not_flat = [](const absl::Cord&) -> absl::optional<std::string> {
+    return absl::nullopt;
+  };
+  return value1.NativeValue(absl::Overload(
+      [&](absl::string_view lhs) -> absl::optional<std::string> {
+        return value2.NativeValue(absl::Overload(
+            [&](absl::string_view rhs) -> absl::optional<std::string> {
+              if (lhs.size() + rhs.size() > kMaxFlatConcatSize) {
+                return absl::nullopt;
+              }
+              return absl::StrCat(lhs, rhs);
+            },
+            not_flat));
+      },
+      not_flat));
+}
+
 // Concatenation for string type.
 absl::StatusOr<StringValue> ConcatString(ValueManager& factory,
                                          const StringValue& value1,
                                          const StringValue& value2) {
-  // TODO(uncreated-issue/53): use StringValue::Concat when remaining interop usages
-  // removed. Modern concat implementation forces additional copies when
-  // converting to legacy string values.
-  return factory.CreateUncheckedStringValue(
-      absl::StrCat(value1.ToString(), value2.ToString()));
+  if (value2.IsEmpty()) {
+    return value1;
+  }
+  if (value1.IsEmpty()) {
+    return value2;
+  }
+  if (auto flat = FlatConcat(value1, value2); flat.has_value()) {
+    return factory.CreateUncheckedStringValue(*std::move(flat));
+  }
+  return StringValue::Concat(factory, value1, value2);
 }
 
 // Concatenation for bytes type.
 absl::StatusOr<BytesValue> ConcatBytes(ValueManager& factory,
                                        const BytesValue& value1,
                                        const BytesValue& value2) {
-  // TODO(uncreated-issue/53): use BytesValue::Concat when remaining interop usages
-  // removed. Modern concat implementation forces additional copies when
-  // converting to legacy string values.
-  return factory.CreateBytesValue(
-      absl::StrCat(value1.ToString(), value2.ToString()));
+  if (value2.IsEmpty()) {
+    return value1;
+  }
+  if (value1.IsEmpty()) {
+    return value2;
+  }
+  if (auto flat = FlatConcat(value1, value2); flat.has_value()) {
+    return factory.CreateBytesValue(*std::move(flat));
+  }
+  absl::Cord result = value1.ToCord();
+  result.Append(value2.ToCord());
+  return factory.CreateBytesValue(std::move(result));
+}
+
+// Returns a flat view of `value`, copying it into `scratch` only if it is a
+// fragmented cord.
+absl::string_view FlatString(const StringValue& value, std::string& scratch) {
+  return value.NativeValue(absl::Overload(
+      [](absl::string_view flat) { return flat; },
+      [&scratch](const absl::Cord& cord) -> absl::string_view {
+        if (auto flat = cord.TryFlat(); flat.has_value()) {
+          return *flat;
+        }
+        scratch = static_cast<std::string>(cord);
+        return scratch;
+      }));
 }
 
+// The searched strings are visited in place, only fragmented needles are
+// flattened.
 bool StringContains(ValueManager&, const StringValue& value,
                     const StringValue& substr) {
-  return absl::StrContains(value.ToString(), substr.ToString());
+  std::string scratch;
+  absl::string_view needle = FlatString(substr, scratch);
+  return value.NativeValue([needle](const auto& haystack) -> bool {
+    return internal::ContainsSubstring(haystack, needle);
+  });
 }
 
 bool StringEndsWith(ValueManager&, const StringValue& value,
                     const StringValue& suffix) {
-  return absl::EndsWith(value.ToString(), suffix.ToString());
+  std::string scratch;
+  absl::string_view needle = FlatString(suffix, scratch);
+  return value.NativeValue(absl::Overload(
+      [needle](absl::string_view haystack) {
+        return absl::EndsWith(haystack, needle);
+      },
+      [needle](const absl::Cord& haystack) {
+        return haystack.EndsWith(needle);
+      }));
 }
 
 bool StringStartsWith(ValueManager&, const StringValue& value,
                       const StringValue& prefix) {
-  return absl::StartsWith(value.ToString(), prefix.ToString());
+  std::string scratch;
+  absl::string_view needle = FlatString(prefix, scratch);
+  return value.NativeValue(absl::Overload(
+      [needle](absl::string_view haystack) {
+        return absl::StartsWith(haystack, needle);
+      },
+      [needle](const absl::Cord& haystack) {
+        return haystack.StartsWith(needle);
+      }));
 }
 
 absl::Status RegisterSizeFunctions(FunctionRegistry& registry) {
@@ -13,11 +13,24 @@
 // limitations under the License.
 #include "runtime/standard/string_functions.h"
 
+#include <string>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "base/builtins.h"
+#include "base/function.h"
 #include "base/function_descriptor.h"
+#include "base/type_provider.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "common/values/legacy_value_manager.h"
 #include "internal/testing.h"
+#include "runtime/function_overload_reference.h"
+#include "runtime/function_registry.h"
+#include "runtime/runtime_options.h"
 
 namespace cel {
 namespace {
@@ -107,6 +120,75 @@ TEST(RegisterStringFunctions, ConcatSkippedWhenDisabled) {
   EXPECT_THAT(overloads[builtin::kAdd], IsEmpty());
 }
 
+class ConcatTest : public testing::Test {
+ public:
+  ConcatTest()
+      : value_factory_(MemoryManagerRef::ReferenceCounting(),
+                       TypeProvider::Builtin()) {}
+
+  void SetUp() override {
+    ASSERT_OK(RegisterStringFunctions(registry_, RuntimeOptions()));
+  }
+
+ protected:
+  absl::StatusOr<Value> Concat(const Value& lhs, const Value& rhs) {
+    std::vector<FunctionOverloadReference> refs = registry_.FindStaticOverloads(
+        builtin::kAdd, /*receiver_style=*/false,
+        {ValueKindToKind(lhs->kind()), ValueKindToKind(rhs->kind())});
+    if (refs.size() != 1) {
+      return absl::InvalidArgumentError("ambiguous overloads");
+    }
+    Function::InvokeContext ctx(value_factory_);
+    return refs[0].implementation.Invoke(ctx, {lhs, rhs});
+  }
+
+  FunctionRegistry registry_;
+  common_internal::LegacyValueManager value_factory_;
+};
+
+TEST_F(ConcatTest, StringChain) {
+  // Crosses the size at which results stop being flattened, and mixes short
+  // and long operands on both sides.
+  Value result = StringValue("");
+  std::string expected;
+  for (int i = 0; i < 200; ++i) {
+    std::string part = i % 10 == 0 ? std::string(300, 'a' + i % 26)
+                                   : std::string(1, 'a' + i % 26);
+    if (i % 3 == 0) {
+      ASSERT_OK_AND_ASSIGN(result, Concat(StringValue(part), result));
+      expected = part + expected;
+    } else {
+      ASSERT_OK_AND_ASSIGN(result, Concat(result, StringValue(part)));
+      expected += part;
+    }
+  }
+  ASSERT_TRUE(result->Is<StringValue>());
+  EXPECT_EQ(result.As<StringValue>().ToString(), expected);
+  EXPECT_EQ(result.As<StringValue>().Size(), expected.size());
+}
+
+TEST_F(ConcatTest, BytesChain) {
+  Value result = BytesValue("");
+  std::string expected;
+  for (int i = 0; i < 200; ++i) {
+    std::string part(i % 10 == 0 ? 300 : 1, static_cast<char>(i));
+    ASSERT_OK_AND_ASSIGN(result, Concat(result, BytesValue(part)));
+    expected += part;
+  }
+  ASSERT_TRUE(result->Is<BytesValue>());
+  EXPECT_EQ(result.As<BytesValue>().ToString(), expected);
+}
+
+TEST_F(ConcatTest, EmptyOperands) {
+  ASSERT_OK_AND_ASSIGN(Value result,
+                       Concat(StringValue(""), StringValue("abc")));
+  EXPECT_EQ(result.As<StringValue>().ToString(), "abc");
+  ASSERT_OK_AND_ASSIGN(result, Concat(StringValue("abc"), StringValue("")));
+  EXPECT_EQ(result.As<StringValue>().ToString(), "abc");
+  ASSERT_OK_AND_ASSIGN(result, Concat(StringValue(""), StringValue("")));
+  EXPECT_TRUE(result.As<StringValue>().IsEmpty());
+}
+
 // TODO(uncreated-issue/41): move functional parsed expr tests when modern APIs for
 // evaluator available.
 
@@ -14,333 +14,197 @@
 
 #include "runtime/standard/time_functions.h"
 
-#include <functional>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
-#include "absl/strings/match.h"
-#include "absl/strings/str_replace.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/civil_time.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "base/builtins.h"
+#include "base/function.h"
 #include "base/function_adapter.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "internal/overflow.h"
 #include "internal/status_macros.h"
+#include "internal/time.h"
+#include "internal/time_zone_cache.h"
 
 namespace cel {
 namespace {
 
 // Timestamp
-absl::Status FindTimeBreakdown(absl::Time timestamp, absl::string_view tz,
-                               absl::TimeZone::CivilInfo* breakdown) {
-  absl::TimeZone time_zone;
+using TimeBreakdownExtractor = int64_t (*)(const absl::TimeZone::CivilInfo&);
 
-  // Early return if there is no timezone.
-  if (tz.empty()) {
-    *breakdown = time_zone.At(timestamp);
-    return absl::OkStatus();
-  }
-
-  // Check to see whether the timezone is an IANA timezone.
-  if (absl::LoadTimeZone(tz, &time_zone)) {
-    *breakdown = time_zone.At(timestamp);
-    return absl::OkStatus();
-  }
-
-  // Check for times of the format: [+-]HH:MM and convert them into durations
-  // specified as [+-]HHhMMm.
-  if (absl::StrContains(tz, ":")) {
-    std::string dur = absl::StrCat(tz, "m");
-    absl::StrReplaceAll({{":", "h"}}, &dur);
-    absl::Duration d;
-    if (absl::ParseDuration(dur, &d)) {
-      timestamp += d;
-      *breakdown = time_zone.At(timestamp);
-      return absl::OkStatus();
-    }
-  }
-
-  // Otherwise, error.
-  return absl::InvalidArgumentError("Invalid timezone");
+int64_t FullYear(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.year();
 }
 
-Value GetTimeBreakdownPart(
-    ValueManager& value_factory, absl::Time timestamp, absl::string_view tz,
-    const std::function<int64_t(const absl::TimeZone::CivilInfo&)>&
-        extractor_func) {
-  absl::TimeZone::CivilInfo breakdown;
-  auto status = FindTimeBreakdown(timestamp, tz, &breakdown);
-
-  if (!status.ok()) {
-    return value_factory.CreateErrorValue(status);
-  }
-
-  return value_factory.CreateIntValue(extractor_func(breakdown));
+int64_t Month(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.month() - 1;
 }
 
-Value GetFullYear(ValueManager& value_factory, absl::Time timestamp,
-                  absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.year();
-                              });
+int64_t DayOfYear(const absl::TimeZone::CivilInfo& breakdown) {
+  return absl::GetYearDay(absl::CivilDay(breakdown.cs)) - 1;
 }
 
-Value GetMonth(ValueManager& value_factory, absl::Time timestamp,
-               absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.month() - 1;
-                              });
+int64_t DayOfMonth(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.day() - 1;
 }
 
-Value GetDayOfYear(ValueManager& value_factory, absl::Time timestamp,
-                   absl::string_view tz) {
-  return GetTimeBreakdownPart(
-      value_factory, timestamp, tz,
-      [](const absl::TimeZone::CivilInfo& breakdown) {
-        return absl::GetYearDay(absl::CivilDay(breakdown.cs)) - 1;
-      });
+int64_t Date(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.day();
 }
 
-Value GetDayOfMonth(ValueManager& value_factory, absl::Time timestamp,
-                    absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.day() - 1;
-                              });
-}
+int64_t DayOfWeek(const absl::TimeZone::CivilInfo& breakdown) {
+  absl::Weekday weekday = absl::GetWeekday(breakdown.cs);
 
-Value GetDate(ValueManager& value_factory, absl::Time timestamp,
-              absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.day();
-                              });
+  // get day of week from the date in UTC, zero-based, zero for Sunday,
+  // based on GetDayOfWeek CEL function definition.
+  int weekday_num = static_cast<int>(weekday);
+  weekday_num = (weekday_num == 6) ? 0 : weekday_num + 1;
+  return weekday_num;
 }
 
-Value GetDayOfWeek(ValueManager& value_factory, absl::Time timestamp,
-                   absl::string_view tz) {
-  return GetTimeBreakdownPart(
-      value_factory, timestamp, tz,
-      [](const absl::TimeZone::CivilInfo& breakdown) {
-        absl::Weekday weekday = absl::GetWeekday(breakdown.cs);
-
-        // get day of week from the date in UTC, zero-based, zero for Sunday,
-        // based on GetDayOfWeek CEL function definition.
-        int weekday_num = static_cast<int>(weekday);
-        weekday_num = (weekday_num == 6) ? 0 : weekday_num + 1;
-        return weekday_num;
-      });
+int64_t Hours(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.hour();
 }
 
-Value GetHours(ValueManager& value_factory, absl::Time timestamp,
-               absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.hour();
-                              });
+int64_t Minutes(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.minute();
 }
 
-Value GetMinutes(ValueManager& value_factory, absl::Time timestamp,
-                 absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.minute();
-                              });
+int64_t Seconds(const absl::TimeZone::CivilInfo& breakdown) {
+  return breakdown.cs.second();
 }
 
-Value GetSeconds(ValueManager& value_factory, absl::Time timestamp,
-                 absl::string_view tz) {
-  return GetTimeBreakdownPart(value_factory, timestamp, tz,
-                              [](const absl::TimeZone::CivilInfo& breakdown) {
-                                return breakdown.cs.second();
-                              });
+int64_t Milliseconds(const absl::TimeZone::CivilInfo& breakdown) {
+  return absl::ToInt64Milliseconds(breakdown.subsecond);
 }
 
-Value GetMilliseconds(ValueManager& value_factory, absl::Time timestamp,
-                      absl::string_view tz) {
-  return GetTimeBreakdownPart(
-      value_factory, timestamp, tz,
-      [](const absl::TimeZone::CivilInfo& breakdown) {
-        return absl::ToInt64Milliseconds(breakdown.subsecond);
-      });
-}
-
-absl::Status RegisterTimestampFunctions(FunctionRegistry& registry,
-                                        const RuntimeOptions& options) {
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kFullYear, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetFullYear(value_factory, ts, tz.ToString());
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kFullYear, true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetFullYear(value_factory, ts, "");
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kMonth, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetMonth(value_factory, ts, tz.ToString());
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(builtin::kMonth,
-                                                                true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetMonth(value_factory, ts, "");
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kDayOfYear, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetDayOfYear(value_factory, ts, tz.ToString());
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kDayOfYear, true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetDayOfYear(value_factory, ts, "");
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kDayOfMonth, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetDayOfMonth(value_factory, ts, tz.ToString());
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kDayOfMonth, true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetDayOfMonth(value_factory, ts, "");
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kDate, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetDate(value_factory, ts, tz.ToString());
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(builtin::kDate,
-                                                                true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetDate(value_factory, ts, "");
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kDayOfWeek, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetDayOfWeek(value_factory, ts, tz.ToString());
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kDayOfWeek, true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetDayOfWeek(value_factory, ts, "");
-          })));
-
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kHours, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetHours(value_factory, ts, tz.ToString());
-          })));
+// Implements a timestamp accessor taking a time zone, such as
+// `getHours(string)`.
+//
+// Time zones are resolved through a process-wide cache. If the time zone of a
+// call is a constant, it is resolved once when the program is planned.
+class TimestampAccessorFunction : public Function {
+ public:
+  explicit TimestampAccessorFunction(TimeBreakdownExtractor extractor)
+      : extractor_(extractor) {}
+
+  absl::StatusOr<Value> Invoke(const InvokeContext& context,
+                               absl::Span<const Value> args) const override {
+    CEL_RETURN_IF_ERROR(CheckArgs(args));
+    std::string scratch;
+    absl::optional<internal::ResolvedTimeZone> time_zone =
+        internal::ResolveTimeZone(
+            args[1].As<StringValue>().NativeString(scratch));
+    if (!time_zone.has_value()) {
+      return context.value_factory().CreateErrorValue(
+          absl::InvalidArgumentError("Invalid timezone"));
+    }
+    return IntValue(
+        extractor_(time_zone->At(args[0].As<TimestampValue>().NativeValue())));
+  }
 
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(builtin::kHours,
-                                                                true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetHours(value_factory, ts, "");
-          })));
+  absl::StatusOr<std::unique_ptr<Function>> Specialize(
+      ValueManager& value_factory,
+      absl::Span<const absl::optional<Value>> constant_args) const override {
+    if (constant_args.size() != 2 || !constant_args[1].has_value() ||
+        !constant_args[1]->Is<StringValue>()) {
+      return nullptr;
+    }
+    std::string scratch;
+    absl::optional<internal::ResolvedTimeZone> time_zone =
+        internal::ResolveTimeZone(
+            constant_args[1]->As<StringValue>().NativeString(scratch));
+    if (!time_zone.has_value()) {
+      // Left to report the error on each call.
+      return nullptr;
+    }
+    return std::make_unique<BoundTimestampAccessorFunction>(extractor_,
+                                                            *time_zone);
+  }
 
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kMinutes, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetMinutes(value_factory, ts, tz.ToString());
-          })));
+ private:
+  // Specialization for a constant time zone.
+  class BoundTimestampAccessorFunction : public Function {
+   public:
+    BoundTimestampAccessorFunction(TimeBreakdownExtractor extractor,
+                                   internal::ResolvedTimeZone time_zone)
+        : extractor_(extractor), time_zone_(time_zone) {}
+
+    absl::StatusOr<Value> Invoke(const InvokeContext&,
+                                 absl::Span<const Value> args) const override {
+      CEL_RETURN_IF_ERROR(CheckArgs(args));
+      absl::Time timestamp = args[0].As<TimestampValue>().NativeValue();
+      return IntValue(extractor_(time_zone_.At(timestamp)));
+    }
 
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kMinutes, true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetMinutes(value_factory, ts, "");
-          })));
+   private:
+    TimeBreakdownExtractor extractor_;
+    internal::ResolvedTimeZone time_zone_;
+  };
 
-  CEL_RETURN_IF_ERROR(registry.Register(
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kSeconds, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetSeconds(value_factory, ts, tz.ToString());
-          })));
+  static absl::Status CheckArgs(absl::Span<const Value> args) {
+    if (args.size() != 2 || !args[0].Is<TimestampValue>() ||
+        !args[1].Is<StringValue>()) {
+      return absl::InvalidArgumentError(
+          "unexpected arguments for timestamp accessor");
+    }
+    return absl::OkStatus();
+  }
 
-  CEL_RETURN_IF_ERROR(registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kSeconds, true),
-      UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetSeconds(value_factory, ts, "");
-          })));
+  TimeBreakdownExtractor extractor_;
+};
 
+// Registers the overloads of a timestamp accessor, with and without a time
+// zone.
+absl::Status RegisterTimestampAccessor(FunctionRegistry& registry,
+                                       absl::string_view name,
+                                       TimeBreakdownExtractor extractor) {
   CEL_RETURN_IF_ERROR(registry.Register(
       BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          CreateDescriptor(builtin::kMilliseconds, true),
-      BinaryFunctionAdapter<Value, absl::Time, const StringValue&>::
-          WrapFunction([](ValueManager& value_factory, absl::Time ts,
-                          const StringValue& tz) -> Value {
-            return GetMilliseconds(value_factory, ts, tz.ToString());
-          })));
+          CreateDescriptor(name, true),
+      std::make_unique<TimestampAccessorFunction>(extractor)));
 
   return registry.Register(
-      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(
-          builtin::kMilliseconds, true),
+      UnaryFunctionAdapter<Value, absl::Time>::CreateDescriptor(name, true),
       UnaryFunctionAdapter<Value, absl::Time>::WrapFunction(
-          [](ValueManager& value_factory, absl::Time ts) -> Value {
-            return GetMilliseconds(value_factory, ts, "");
+          [extractor](ValueManager&, absl::Time ts) -> Value {
+            return IntValue(extractor(internal::UtcCivilInfo(ts)));
           }));
 }
 
+absl::Status RegisterTimestampFunctions(FunctionRegistry& registry,
+                                        const RuntimeOptions& options) {
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kFullYear, &FullYear));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kMonth, &Month));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kDayOfYear, &DayOfYear));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kDayOfMonth, &DayOfMonth));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kDate, &Date));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kDayOfWeek, &DayOfWeek));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kHours, &Hours));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kMinutes, &Minutes));
+  CEL_RETURN_IF_ERROR(
+      RegisterTimestampAccessor(registry, builtin::kSeconds, &Seconds));
+  return RegisterTimestampAccessor(registry, builtin::kMilliseconds,
+                                   &Milliseconds);
+}
+
 absl::Status RegisterCheckedTimeArithmeticFunctions(
     FunctionRegistry& registry) {
   CEL_RETURN_IF_ERROR(registry.Register(
@@ -15,20 +15,24 @@
 #include "runtime/standard/type_conversion_functions.h"
 
 #include <cstdint>
+#include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "base/builtins.h"
 #include "base/function_adapter.h"
+#include "common/internal/shared_byte_string.h"
 #include "common/value.h"
 #include "common/value_manager.h"
 #include "internal/overflow.h"
 #include "internal/status_macros.h"
 #include "internal/time.h"
+#include "internal/utf8.h"
 #include "runtime/function_registry.h"
 #include "runtime/runtime_options.h"
 
@@ -42,6 +46,14 @@ using ::cel::internal::MaxTimestamp;
 // Time representing `9999-12-31T23:59:59.999999999Z`.
 const absl::Time kMaxTime = MaxTimestamp();
 
+// Returns the formatted number as a string value. absl::AlphaNum formats into
+// a buffer of its own, and short results are stored inline in the string
+// value, so most numbers are converted without allocating.
+StringValue FormattedNumber(const absl::AlphaNum& formatted) {
+  return StringValue(
+      common_internal::SharedByteString::Copy(formatted.Piece()));
+}
+
 absl::Status RegisterIntConversionFunctions(FunctionRegistry& registry,
                                             const RuntimeOptions&) {
   // bool -> int
@@ -75,8 +87,9 @@ absl::Status RegisterIntConversionFunctions(FunctionRegistry& registry,
       UnaryFunctionAdapter<Value, const StringValue&>::RegisterGlobalOverload(
           cel::builtin::kInt,
           [](ValueManager& value_factory, const StringValue& s) -> Value {
+            std::string scratch;
             int64_t result;
-            if (!absl::SimpleAtoi(s.ToString(), &result)) {
+            if (!absl::SimpleAtoi(s.NativeString(scratch), &result)) {
               return value_factory.CreateErrorValue(
                   absl::InvalidArgumentError("cannot convert string to int"));
             }
@@ -117,11 +130,21 @@ absl::Status RegisterStringConversionFunctions(FunctionRegistry& registry,
           cel::builtin::kString,
 
           [](ValueManager& value_factory, const BytesValue& value) -> Value {
-            auto handle_or = value_factory.CreateStringValue(value.ToString());
-            if (!handle_or.ok()) {
-              return value_factory.CreateErrorValue(handle_or.status());
+            // Validate the bytes in place, chunk by chunk for cords, and share
+            // their storage with the resulting string instead of copying.
+            auto [count, valid] =
+                value.NativeValue([](const auto& bytes) {
+                  return internal::Utf8Validate(bytes);
+                });
+            if (!valid) {
+              return value_factory.CreateErrorValue(absl::InvalidArgumentError(
+                  "Illegal byte sequence in UTF-8 encoded string"));
+            }
+            StringValue result(common_internal::AsSharedByteString(value));
+            if (count == value.Size()) {
+              common_internal::MarkAsciiStringValue(result);
             }
-            return *handle_or;
+            return result;
           },
           registry);
   CEL_RETURN_IF_ERROR(status);
@@ -129,8 +152,8 @@ absl::Status RegisterStringConversionFunctions(FunctionRegistry& registry,
   // double -> string
   status = UnaryFunctionAdapter<StringValue, double>::RegisterGlobalOverload(
       cel::builtin::kString,
-      [](ValueManager& value_factory, double value) -> StringValue {
-        return value_factory.CreateUncheckedStringValue(absl::StrCat(value));
+      [](ValueManager&, double value) -> StringValue {
+        return FormattedNumber(value);
       },
       registry);
   CEL_RETURN_IF_ERROR(status);
@@ -138,8 +161,8 @@ absl::Status RegisterStringConversionFunctions(FunctionRegistry& registry,
   // int -> string
   status = UnaryFunctionAdapter<StringValue, int64_t>::RegisterGlobalOverload(
       cel::builtin::kString,
-      [](ValueManager& value_factory, int64_t value) -> StringValue {
-        return value_factory.CreateUncheckedStringValue(absl::StrCat(value));
+      [](ValueManager&, int64_t value) -> StringValue {
+        return FormattedNumber(value);
       },
       registry);
   CEL_RETURN_IF_ERROR(status);
@@ -155,8 +178,8 @@ absl::Status RegisterStringConversionFunctions(FunctionRegistry& registry,
   // uint -> string
   status = UnaryFunctionAdapter<StringValue, uint64_t>::RegisterGlobalOverload(
       cel::builtin::kString,
-      [](ValueManager& value_factory, uint64_t value) -> StringValue {
-        return value_factory.CreateUncheckedStringValue(absl::StrCat(value));
+      [](ValueManager&, uint64_t value) -> StringValue {
+        return FormattedNumber(value);
       },
       registry);
   CEL_RETURN_IF_ERROR(status);
@@ -165,11 +188,13 @@ absl::Status RegisterStringConversionFunctions(FunctionRegistry& registry,
   status = UnaryFunctionAdapter<Value, absl::Duration>::RegisterGlobalOverload(
       cel::builtin::kString,
       [](ValueManager& value_factory, absl::Duration value) -> Value {
-        auto encode = EncodeDurationToJson(value);
+        char buffer[internal::kJsonTimeBufferSize];
+        auto encode = EncodeDurationToJson(value, buffer);
         if (!encode.ok()) {
           return value_factory.CreateErrorValue(encode.status());
         }
-        return value_factory.CreateUncheckedStringValue(*encode);
+        // Short durations, such as "3600s", are stored inline.
+        return StringValue(common_internal::SharedByteString::Copy(*encode));
       },
       registry);
   CEL_RETURN_IF_ERROR(status);
@@ -178,11 +203,12 @@ absl::Status RegisterStringConversionFunctions(FunctionRegistry& registry,
   return UnaryFunctionAdapter<Value, absl::Time>::RegisterGlobalOverload(
       cel::builtin::kString,
       [](ValueManager& value_factory, absl::Time value) -> Value {
-        auto encode = EncodeTimestampToJson(value);
+        char buffer[internal::kJsonTimeBufferSize];
+        auto encode = EncodeTimestampToJson(value, buffer);
         if (!encode.ok()) {
           return value_factory.CreateErrorValue(encode.status());
         }
-        return value_factory.CreateUncheckedStringValue(*encode);
+        return StringValue(common_internal::SharedByteString::Copy(*encode));
       },
       registry);
 }
@@ -221,8 +247,9 @@ absl::Status RegisterUintConversionFunctions(FunctionRegistry& registry,
       UnaryFunctionAdapter<Value, const StringValue&>::RegisterGlobalOverload(
           cel::builtin::kUint,
           [](ValueManager& value_factory, const StringValue& s) -> Value {
+            std::string scratch;
             uint64_t result;
-            if (!absl::SimpleAtoi(s.ToString(), &result)) {
+            if (!absl::SimpleAtoi(s.NativeString(scratch), &result)) {
               return value_factory.CreateErrorValue(
                   absl::InvalidArgumentError("doesn't convert to a string"));
             }
@@ -249,11 +276,12 @@ absl::Status RegisterBytesConversionFunctions(FunctionRegistry& registry,
   CEL_RETURN_IF_ERROR(status);
 
   // string -> bytes
-  return UnaryFunctionAdapter<absl::StatusOr<BytesValue>, const StringValue&>::
+  return UnaryFunctionAdapter<BytesValue, const StringValue&>::
       RegisterGlobalOverload(
           cel::builtin::kBytes,
-          [](ValueManager& value_factory, const StringValue& value) {
-            return value_factory.CreateBytesValue(value.ToString());
+          [](ValueManager&, const StringValue& value) -> BytesValue {
+            // Shares the contents of the string rather than copying them.
+            return BytesValue(common_internal::AsSharedByteString(value));
           },
           registry);
 }
@@ -279,8 +307,9 @@ absl::Status RegisterDoubleConversionFunctions(FunctionRegistry& registry,
       UnaryFunctionAdapter<Value, const StringValue&>::RegisterGlobalOverload(
           cel::builtin::kDouble,
           [](ValueManager& value_factory, const StringValue& s) -> Value {
+            std::string scratch;
             double result;
-            if (absl::SimpleAtod(s.ToString(), &result)) {
+            if (absl::SimpleAtod(s.NativeString(scratch), &result)) {
               return value_factory.CreateDoubleValue(result);
             } else {
               return value_factory.CreateErrorValue(absl::InvalidArgumentError(
@@ -299,8 +328,9 @@ absl::Status RegisterDoubleConversionFunctions(FunctionRegistry& registry,
 
 Value CreateDurationFromString(ValueManager& value_factory,
                                const StringValue& dur_str) {
+  std::string scratch;
   absl::Duration d;
-  if (!absl::ParseDuration(dur_str.ToString(), &d)) {
+  if (!absl::ParseDuration(dur_str.NativeString(scratch), &d)) {
     return value_factory.CreateErrorValue(
         absl::InvalidArgumentError("String to Duration conversion failed"));
   }
@@ -341,9 +371,10 @@ absl::Status RegisterTimeConversionFunctions(FunctionRegistry& registry,
           cel::builtin::kTimestamp,
           [=](ValueManager& value_factory,
               const StringValue& time_str) -> Value {
+            std::string scratch;
             absl::Time ts;
-            if (!absl::ParseTime(absl::RFC3339_full, time_str.ToString(), &ts,
-                                 nullptr)) {
+            if (!cel::internal::ParseRfc3339Time(
+                    time_str.NativeString(scratch), &ts)) {
               return value_factory.CreateErrorValue(absl::InvalidArgumentError(
                   "String to Timestamp conversion failed"));
             }
@@ -387,7 +418,7 @@ absl::Status RegisterTypeConversionFunctions(FunctionRegistry& registry,
   return UnaryFunctionAdapter<Value, const Value&>::RegisterGlobalOverload(
       cel::builtin::kType,
       [](ValueManager& factory, const Value& value) {
-        return factory.CreateTypeValue(value.GetType(factory));
+        return factory.GetTypeValue(value);
       },
       registry);
 }
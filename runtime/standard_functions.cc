@@ -14,7 +14,16 @@
 
 #include "runtime/standard_functions.h"
 
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "absl/base/no_destructor.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "internal/status_macros.h"
 #include "runtime/function_registry.h"
 #include "runtime/runtime_options.h"
@@ -30,6 +39,47 @@
 #include "runtime/standard/type_conversion_functions.h"
 
 namespace cel {
+namespace {
+
+// The options read by the standard definitions. This must be kept in sync
+// with the registration functions below.
+using StandardFunctionsKey =
+    std::tuple<bool, bool, bool, bool, bool, bool, bool, int, int>;
+
+StandardFunctionsKey MakeStandardFunctionsKey(const RuntimeOptions& options) {
+  return StandardFunctionsKey(
+      options.enable_heterogeneous_equality, options.enable_list_concat,
+      options.enable_list_contains, options.enable_regex,
+      options.enable_string_concat, options.enable_string_conversion,
+      options.enable_timestamp_duration_overflow_errors,
+      options.regex_cache_capacity, options.regex_max_program_size);
+}
+
+class StandardFunctionRegistryCache {
+ public:
+  absl::StatusOr<std::shared_ptr<const FunctionRegistry>> Get(
+      const RuntimeOptions& options) {
+    StandardFunctionsKey key = MakeStandardFunctionsKey(options);
+    absl::MutexLock lock(&mutex_);
+    if (auto it = registries_.find(key); it != registries_.end()) {
+      return it->second;
+    }
+    FunctionRegistry registry;
+    CEL_RETURN_IF_ERROR(RegisterStandardFunctions(registry, options));
+    std::shared_ptr<const FunctionRegistry> frozen =
+        std::move(registry).Freeze();
+    registries_[key] = frozen;
+    return frozen;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<StandardFunctionsKey,
+                      std::shared_ptr<const FunctionRegistry>>
+      registries_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
 
 absl::Status RegisterStandardFunctions(FunctionRegistry& registry,
                                        const RuntimeOptions& options) {
@@ -46,4 +96,10 @@ absl::Status RegisterStandardFunctions(FunctionRegistry& registry,
   return RegisterTypeConversionFunctions(registry, options);
 }
 
+absl::StatusOr<std::shared_ptr<const FunctionRegistry>>
+GetStandardFunctionRegistry(const RuntimeOptions& options) {
+  static absl::NoDestructor<StandardFunctionRegistryCache> cache;
+  return cache->Get(options);
+}
+
 }  // namespace cel
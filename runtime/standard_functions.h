@@ -15,7 +15,10 @@
 #ifndef THIRD_PARTY_CEL_CPP_RUNTIME_STANDARD_FUNCTIONS_H_
 #define THIRD_PARTY_CEL_CPP_RUNTIME_STANDARD_FUNCTIONS_H_
 
+#include <memory>
+
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "runtime/function_registry.h"
 #include "runtime/runtime_options.h"
 
@@ -28,6 +31,15 @@ namespace cel {
 absl::Status RegisterStandardFunctions(FunctionRegistry& registry,
                                        const RuntimeOptions& options);
 
+// Returns an immutable registry of all CEL standard definitions for
+// `options`, to be shared as the base of other registries.
+//
+// The registry is built once per distinct configuration of the options which
+// affect the standard definitions, and lives until the process exits. This
+// avoids registering the standard overloads again for every runtime.
+absl::StatusOr<std::shared_ptr<const FunctionRegistry>>
+GetStandardFunctionRegistry(const RuntimeOptions& options);
+
 }  // namespace cel
 
 #endif  // THIRD_PARTY_CEL_CPP_RUNTIME_STANDARD_FUNCTIONS_H_
@@ -14,6 +14,8 @@
 
 #include "runtime/standard_runtime_builder_factory.h"
 
+#include <utility>
+
 #include "absl/status/statusor.h"
 #include "internal/status_macros.h"
 #include "runtime/runtime_builder.h"
@@ -25,12 +27,11 @@ namespace cel {
 
 absl::StatusOr<RuntimeBuilder> CreateStandardRuntimeBuilder(
     const RuntimeOptions& options) {
-  RuntimeBuilder result = CreateRuntimeBuilder(options);
-
-  CEL_RETURN_IF_ERROR(
-      RegisterStandardFunctions(result.function_registry(), options));
-
-  return result;
+  // The standard definitions are shared by every runtime with the same
+  // options, instead of being registered again for each of them.
+  CEL_ASSIGN_OR_RETURN(auto standard_functions,
+                       GetStandardFunctionRegistry(options));
+  return CreateRuntimeBuilder(std::move(standard_functions), options);
 }
 
 }  // namespace cel
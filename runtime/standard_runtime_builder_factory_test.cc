@@ -14,6 +14,7 @@
 
 #include "runtime/standard_runtime_builder_factory.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <ostream>
@@ -23,10 +24,20 @@
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
 #include "absl/base/no_destructor.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/ast.h"
+#include "base/attribute.h"
+#include "base/function_descriptor.h"
+#include "common/kind.h"
 #include "common/memory.h"
 #include "common/source.h"
 #include "common/value.h"
@@ -34,15 +45,24 @@
 #include "common/value_testing.h"
 #include "common/values/legacy_value_manager.h"
 #include "extensions/bindings_ext.h"
+#include "extensions/protobuf/ast_converters.h"
 #include "extensions/protobuf/memory_manager.h"
 #include "extensions/protobuf/runtime_adapter.h"
+#include "internal/status_macros.h"
 #include "internal/testing.h"
 #include "parser/macro_registry.h"
 #include "parser/parser.h"
 #include "parser/standard_macros.h"
 #include "runtime/activation.h"
+#include "runtime/activation_interface.h"
+#include "runtime/cancellation_token.h"
+#include "runtime/constant_folding.h"
+#include "runtime/function_adapter.h"
+#include "runtime/function_overload_reference.h"
 #include "runtime/internal/runtime_impl.h"
 #include "runtime/managed_value_factory.h"
+#include "runtime/program_metrics.h"
+#include "runtime/program_references.h"
 #include "runtime/runtime.h"
 #include "runtime/runtime_issue.h"
 #include "runtime/runtime_options.h"
@@ -54,10 +74,16 @@ namespace {
 using ::cel::extensions::ProtobufRuntimeAdapter;
 using ::cel::extensions::ProtoMemoryManagerRef;
 using ::cel::test::BoolValueIs;
+using ::cel::test::IntValueIs;
+using ::cel::test::StringValueIs;
 using ::google::api::expr::v1alpha1::ParsedExpr;
 using ::google::api::expr::parser::Parse;
 using testing::ElementsAre;
+using testing::HasSubstr;
+using testing::Pair;
 using testing::Truly;
+using cel::internal::IsOkAndHolds;
+using cel::internal::StatusIs;
 
 struct EvaluateResultTestCase {
   std::string name;
@@ -183,6 +209,11 @@ INSTANTIATE_TEST_SUITE_P(
             {"list_index", "['a', 'b', 'c', 'd'][1] == 'b'", true},
             {"map_index_bool", "{true: 1, false: 2}[false] == 2", true},
             {"map_index_string", "{'abc': 123}['abc'] == 123", true},
+            {"map_index_computed_string", "{'a' + 'bc': 123}['abc'] == 123",
+             true},
+            {"map_select_field", "{'abc': 123}.abc == 123", true},
+            {"map_select_computed_field", "{'a' + 'bc': 123}.abc == 123",
+             true},
             {"map_index_int", "{1: 2, 2: 4}[2] == 4", true},
             {"map_index_uint", "{1u: 1, 2u: 2}[1u] == 1", true},
             {"map_index_coerced_double", "{1: 2, 2: 4}[2.0] == 4", true},
@@ -224,6 +255,14 @@ INSTANTIATE_TEST_SUITE_P(
             {"eq_list_list_false", "[1, 2, 3] == [1, 2, 3, 4]", false},
             {"eq_map_map_true", "{1: 2, 2: 4} == {1: 2, 2: 4}", true},
             {"eq_map_map_false", "{1: 2, 2: 4} == {1: 2, 2: 5}", false},
+            {"eq_same_list_true",
+             "cel.bind(xs, [1, [2.0], {'a': 3}], xs == xs)", true},
+            {"eq_same_list_nan_false",
+             "cel.bind(xs, [1.0, 0.0 / 0.0], xs == xs)", false},
+            {"eq_same_map_true", "cel.bind(m, {'a': [1], 'b': 2}, m == m)",
+             true},
+            {"eq_same_map_nan_false", "cel.bind(m, {'a': 0.0 / 0.0}, m == m)",
+             false},
 
             {"neq_bool_bool_true", "false != false", false},
             {"neq_bool_bool_false", "false != true", true},
@@ -595,5 +634,644 @@ TEST(StandardRuntimeTest, RuntimeIssueSupport) {
   }
 }
 
+TEST(StandardRuntimeTest, EvaluateBatch) {
+  for (int max_recursion_depth : {0, -1}) {
+    RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    options.evaluator_state_pool_size = 1;
+
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                         ParseWithTestMacros("[1, 2, 3].exists(i, i == x)"));
+    ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<TraceableProgram> program,
+                         runtime->CreateTraceableProgram(std::move(ast)));
+
+    Activation activations[4];
+    std::vector<const ActivationInterface*> batch;
+    for (int i = 0; i < 4; ++i) {
+      activations[i].InsertOrAssignValue("x", IntValue(i));
+      batch.push_back(&activations[i]);
+    }
+
+    google::protobuf::Arena arena;
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    std::vector<absl::StatusOr<Value>> results =
+        program->EvaluateBatch(batch, value_factory.get());
+    ASSERT_THAT(results, testing::SizeIs(4));
+    EXPECT_THAT(*results[0], BoolValueIs(false));
+    EXPECT_THAT(*results[1], BoolValueIs(true));
+    EXPECT_THAT(*results[2], BoolValueIs(true));
+    EXPECT_THAT(*results[3], BoolValueIs(true));
+
+    ManagedValueFactory shard_factory(program->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    std::vector<ValueManager*> value_managers = {&value_factory.get(),
+                                                 &shard_factory.get()};
+    int shards_run = 0;
+    results = program->EvaluateBatch(
+        batch, value_managers,
+        [&](size_t num_shards, absl::FunctionRef<void(size_t)> run_shard) {
+          for (size_t shard = 0; shard < num_shards; ++shard) {
+            run_shard(shard);
+            ++shards_run;
+          }
+        });
+    EXPECT_EQ(shards_run, 2);
+    ASSERT_THAT(results, testing::SizeIs(4));
+    EXPECT_THAT(*results[0], BoolValueIs(false));
+    EXPECT_THAT(*results[1], BoolValueIs(true));
+    EXPECT_THAT(*results[2], BoolValueIs(true));
+    EXPECT_THAT(*results[3], BoolValueIs(true));
+  }
+}
+
+TEST(StandardRuntimeTest, CreatePrograms) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  std::vector<std::unique_ptr<Ast>> asts;
+  for (absl::string_view expression : {"1 + 2 == 3", "[1, 2].exists(i, i == x)",
+                                       "undefined_fn(1)", "x > 1"}) {
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros(expression));
+    ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+    asts.push_back(std::move(ast));
+  }
+
+  int shards_run = 0;
+  std::vector<absl::StatusOr<std::unique_ptr<Program>>> programs =
+      runtime->CreatePrograms(
+          absl::MakeSpan(asts),
+          [&](size_t num_shards, absl::FunctionRef<void(size_t)> run_shard) {
+            for (size_t shard = 0; shard < num_shards; ++shard) {
+              run_shard(shard);
+              ++shards_run;
+            }
+          });
+  EXPECT_EQ(shards_run, 4);
+  ASSERT_THAT(programs, testing::SizeIs(4));
+  // A planning error only fails its own program.
+  EXPECT_THAT(programs[2], StatusIs(absl::StatusCode::kInvalidArgument,
+                                    HasSubstr("No overloads provided")));
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(runtime->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  Activation activation;
+  activation.InsertOrAssignValue("x", IntValue(2));
+  for (int i : {0, 1, 3}) {
+    ASSERT_OK(programs[i]);
+    ASSERT_OK_AND_ASSIGN(Value result, (*programs[i])->Evaluate(
+                                           activation, value_factory.get()));
+    EXPECT_THAT(result, BoolValueIs(true)) << i;
+  }
+}
+
+// Counts the variable and context function lookups made by an evaluation.
+class CountingActivation final : public ActivationInterface {
+ public:
+  explicit CountingActivation(const Activation& activation)
+      : activation_(activation) {}
+
+  absl::StatusOr<absl::optional<ValueView>> FindVariable(
+      ValueManager& factory, absl::string_view name,
+      Value& scratch) const override {
+    ++lookups_;
+    return activation_.FindVariable(factory, name, scratch);
+  }
+  using ActivationInterface::FindVariable;
+
+  std::vector<FunctionOverloadReference> FindFunctionOverloads(
+      absl::string_view name) const override {
+    ++function_lookups_;
+    return activation_.FindFunctionOverloads(name);
+  }
+
+  absl::Span<const cel::AttributePattern> GetUnknownAttributes()
+      const override {
+    return activation_.GetUnknownAttributes();
+  }
+
+  absl::Span<const cel::AttributePattern> GetMissingAttributes()
+      const override {
+    return activation_.GetMissingAttributes();
+  }
+
+  int lookups() const { return lookups_; }
+
+  int function_lookups() const { return function_lookups_; }
+
+ private:
+  const Activation& activation_;
+  mutable int lookups_ = 0;
+  mutable int function_lookups_ = 0;
+};
+
+TEST(StandardRuntimeTest, CreateRuleSetProgram) {
+  for (int max_recursion_depth : {0, -1}) {
+    RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+    std::vector<std::unique_ptr<Ast>> rules;
+    for (absl::string_view expression :
+         {"request.user.id == 'b'", "request.user.id.size == 1",
+          "request.user.id == 'a'", "request.user.id.startsWith('a')"}) {
+      ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros(expression));
+      ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+      rules.push_back(std::move(ast));
+    }
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuleSetProgram> program,
+                         runtime->CreateRuleSetProgram(std::move(rules)));
+    EXPECT_EQ(program->rule_count(), 4);
+
+    google::protobuf::Arena arena;
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    ASSERT_OK_AND_ASSIGN(auto user,
+                         value_factory.get().NewMapValueBuilder(
+                             value_factory.get().GetStringDynMapType()));
+    ASSERT_OK(user->Put(StringValue("id"), StringValue("a")));
+    ASSERT_OK_AND_ASSIGN(auto request,
+                         value_factory.get().NewMapValueBuilder(
+                             value_factory.get().GetStringDynMapType()));
+    ASSERT_OK(request->Put(StringValue("user"), std::move(*user).Build()));
+    Activation activation;
+    activation.InsertOrAssignValue("request", std::move(*request).Build());
+    CountingActivation counting_activation(activation);
+
+    ASSERT_OK_AND_ASSIGN(
+        std::vector<Value> results,
+        program->Evaluate(counting_activation, value_factory.get()));
+    ASSERT_THAT(results, testing::SizeIs(4));
+    EXPECT_THAT(results[0], BoolValueIs(false));
+    // An error only affects the result of its own rule.
+    EXPECT_TRUE(results[1].Is<ErrorValue>()) << results[1].DebugString();
+    EXPECT_THAT(results[2], BoolValueIs(true));
+    EXPECT_THAT(results[3], BoolValueIs(true));
+    // The shared selection of `request.user.id` is evaluated once.
+    EXPECT_EQ(counting_activation.lookups(), 1);
+
+    EXPECT_THAT(program->EvaluateFirstMatch(activation, value_factory.get()),
+                IsOkAndHolds(testing::Optional(2)));
+  }
+}
+
+TEST(StandardRuntimeTest, CreateRuleSetProgramRejectsEmptyRuleSet) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  EXPECT_THAT(runtime->CreateRuleSetProgram({}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(StandardRuntimeTest, CreateIncrementalProgram) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr expr,
+      ParseWithTestMacros(
+          "(a + b) * (c + d) + [1, 2, 3].filter(x, x < m.limit).size()"));
+  ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<IncrementalProgram> program,
+                       runtime->CreateIncrementalProgram(std::move(ast)));
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  auto make_limit = [&](int64_t limit) -> absl::StatusOr<Value> {
+    CEL_ASSIGN_OR_RETURN(auto m,
+                         value_factory.get().NewMapValueBuilder(
+                             value_factory.get().GetStringDynMapType()));
+    CEL_RETURN_IF_ERROR(m->Put(StringValue("limit"), IntValue(limit)));
+    return std::move(*m).Build();
+  };
+  Activation activation;
+  activation.InsertOrAssignValue("a", IntValue(1));
+  activation.InsertOrAssignValue("b", IntValue(2));
+  activation.InsertOrAssignValue("c", IntValue(3));
+  activation.InsertOrAssignValue("d", IntValue(4));
+  ASSERT_OK_AND_ASSIGN(Value m, make_limit(3));
+  activation.InsertOrAssignValue("m", m);
+
+  std::unique_ptr<IncrementalProgram::State> state = program->NewState();
+  // Returns the result of an evaluation and the number of variable lookups
+  // it made.
+  auto evaluate = [&](std::vector<std::string> changed)
+      -> absl::StatusOr<std::pair<Value, int>> {
+    CountingActivation counting_activation(activation);
+    CEL_ASSIGN_OR_RETURN(Value result,
+                         program->Evaluate(counting_activation, changed,
+                                           *state, value_factory.get()));
+    return std::make_pair(result, counting_activation.lookups());
+  };
+
+  // `m.limit` is evaluated once for all the iterations of the filter.
+  EXPECT_THAT(evaluate({}), IsOkAndHolds(Pair(IntValueIs(23), 5)));
+  EXPECT_THAT(evaluate({}), IsOkAndHolds(Pair(IntValueIs(23), 0)));
+
+  activation.InsertOrAssignValue("a", IntValue(2));
+  EXPECT_THAT(evaluate({"a"}), IsOkAndHolds(Pair(IntValueIs(30), 2)));
+
+  ASSERT_OK_AND_ASSIGN(m, make_limit(4));
+  activation.InsertOrAssignValue("m", m);
+  EXPECT_THAT(evaluate({"m.limit", "e"}),
+              IsOkAndHolds(Pair(IntValueIs(31), 1)));
+
+  state = program->NewState();
+  EXPECT_THAT(evaluate({}), IsOkAndHolds(Pair(IntValueIs(31), 5)));
+}
+
+TEST(StandardRuntimeTest, IncrementalProgramRejectsForeignState) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  std::vector<std::unique_ptr<IncrementalProgram>> programs;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("a + 1"));
+    ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+    ASSERT_OK_AND_ASSIGN(auto program,
+                         runtime->CreateIncrementalProgram(std::move(ast)));
+    programs.push_back(std::move(program));
+  }
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(programs[0]->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  Activation activation;
+  activation.InsertOrAssignValue("a", IntValue(1));
+  std::unique_ptr<IncrementalProgram::State> state = programs[0]->NewState();
+  EXPECT_THAT(
+      programs[1]->Evaluate(activation, {}, *state, value_factory.get()),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      programs[0]->Evaluate(activation, {}, *state, value_factory.get()),
+      IsOkAndHolds(IntValueIs(2)));
+}
+
+TEST(StandardRuntimeTest, CreateTieredProgram) {
+  for (int max_recursion_depth : {0, -1}) {
+    RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("a || b"));
+    ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+
+    std::vector<absl::AnyInvocable<void()>> tasks;
+    Runtime::TieringOptions tiering_options;
+    tiering_options.profiled_evaluations = 3;
+    tiering_options.min_operand_evaluations = 2;
+    tiering_options.executor = [&tasks](absl::AnyInvocable<void()> task) {
+      tasks.push_back(std::move(task));
+    };
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                         runtime->CreateTieredProgram(
+                             std::move(ast), std::move(tiering_options)));
+
+    google::protobuf::Arena arena;
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    Activation activation;
+    activation.InsertOrAssignValue("a", BoolValue(false));
+    activation.InsertOrAssignValue("b", BoolValue(true));
+    // Returns the result of an evaluation and the number of variable lookups
+    // it made.
+    auto evaluate = [&]() -> absl::StatusOr<std::pair<Value, int>> {
+      CountingActivation counting_activation(activation);
+      CEL_ASSIGN_OR_RETURN(
+          Value result,
+          program->Evaluate(counting_activation, value_factory.get()));
+      return std::make_pair(result, counting_activation.lookups());
+    };
+
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_THAT(evaluate(), IsOkAndHolds(Pair(BoolValueIs(true), 2)));
+    }
+    // The profiling plan is used until the new plan is ready.
+    ASSERT_EQ(tasks.size(), 1);
+    EXPECT_THAT(evaluate(), IsOkAndHolds(Pair(BoolValueIs(true), 2)));
+    std::move(tasks[0])();
+
+    // `b` decided the result of every profiled evaluation, so it is evaluated
+    // first.
+    EXPECT_THAT(evaluate(), IsOkAndHolds(Pair(BoolValueIs(true), 1)));
+    activation.InsertOrAssignValue("a", BoolValue(true));
+    activation.InsertOrAssignValue("b", BoolValue(false));
+    EXPECT_THAT(evaluate(), IsOkAndHolds(Pair(BoolValueIs(true), 2)));
+    EXPECT_EQ(tasks.size(), 1);
+  }
+}
+
+TEST(StandardRuntimeTest, CreateTieredProgramTaskOutlivesRuntime) {
+  std::vector<absl::AnyInvocable<void()>> tasks;
+  {
+    RuntimeOptions options;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("a || b"));
+    ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+    Runtime::TieringOptions tiering_options;
+    tiering_options.profiled_evaluations = 1;
+    tiering_options.executor = [&tasks](absl::AnyInvocable<void()> task) {
+      tasks.push_back(std::move(task));
+    };
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                         runtime->CreateTieredProgram(
+                             std::move(ast), std::move(tiering_options)));
+
+    google::protobuf::Arena arena;
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    Activation activation;
+    activation.InsertOrAssignValue("a", BoolValue(false));
+    activation.InsertOrAssignValue("b", BoolValue(true));
+    EXPECT_THAT(program->Evaluate(activation, value_factory.get()),
+                IsOkAndHolds(BoolValueIs(true)));
+    // The program, then the runtime, are destroyed with the task pending.
+  }
+  ASSERT_EQ(tasks.size(), 1);
+  // Does nothing rather than planning with the destroyed runtime.
+  std::move(tasks[0])();
+}
+
+TEST(StandardRuntimeTest, CreateTieredProgramReplansInline) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("a && b"));
+  ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+  Runtime::TieringOptions tiering_options;
+  tiering_options.profiled_evaluations = 1;
+  tiering_options.min_operand_evaluations = 1;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       runtime->CreateTieredProgram(
+                           std::move(ast), std::move(tiering_options)));
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  Activation activation;
+  activation.InsertOrAssignValue("a", BoolValue(true));
+  activation.InsertOrAssignValue("b", BoolValue(false));
+  CountingActivation profiled(activation);
+  EXPECT_THAT(program->Evaluate(profiled, value_factory.get()),
+              IsOkAndHolds(BoolValueIs(false)));
+  EXPECT_EQ(profiled.lookups(), 2);
+
+  CountingActivation optimized(activation);
+  EXPECT_THAT(program->Evaluate(optimized, value_factory.get()),
+              IsOkAndHolds(BoolValueIs(false)));
+  EXPECT_EQ(optimized.lookups(), 1);
+}
+
+TEST(StandardRuntimeTest, CreateTieredProgramInvalidOptions) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("a && b"));
+  ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+  Runtime::TieringOptions tiering_options;
+  tiering_options.profiled_evaluations = 0;
+  EXPECT_THAT(
+      runtime->CreateTieredProgram(std::move(ast), std::move(tiering_options)),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(StandardRuntimeTest, ProgramCacheSharesPrograms) {
+  RuntimeOptions options;
+  options.program_cache_size = 8;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+  std::vector<std::unique_ptr<TraceableProgram>> programs;
+  for (absl::string_view source : {"a + 1", "a + 1", "a + 2"}) {
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros(source));
+    ASSERT_OK_AND_ASSIGN(auto ast, extensions::CreateAstFromParsedExpr(expr));
+    ASSERT_OK_AND_ASSIGN(auto program,
+                         runtime->CreateTraceableProgram(std::move(ast)));
+    programs.push_back(std::move(program));
+  }
+
+  // Programs for the same expression share their plan.
+  EXPECT_EQ(programs[0]->GetReferences(), programs[1]->GetReferences());
+  EXPECT_NE(programs[0]->GetReferences(), programs[2]->GetReferences());
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(programs[0]->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  Activation activation;
+  activation.InsertOrAssignValue("a", IntValue(1));
+  EXPECT_THAT(programs[0]->Evaluate(activation, value_factory.get()),
+              IsOkAndHolds(IntValueIs(2)));
+  EXPECT_THAT(programs[1]->Evaluate(activation, value_factory.get()),
+              IsOkAndHolds(IntValueIs(2)));
+  EXPECT_THAT(programs[2]->Evaluate(activation, value_factory.get()),
+              IsOkAndHolds(IntValueIs(3)));
+}
+
+TEST(StandardRuntimeTest, EvaluationInterrupts) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                       ParseWithTestMacros("[1, 2, 3].map(x, x * 2)[2] == 6"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  auto token = std::make_shared<CancellationToken>();
+  Activation activation;
+  activation.SetCancellationToken(token);
+  activation.SetDeadline(absl::Now() + absl::Hours(1));
+  EXPECT_THAT(program->Evaluate(activation, value_factory.get()),
+              IsOkAndHolds(BoolValueIs(true)));
+
+  token->Cancel();
+  EXPECT_THAT(program->Evaluate(activation, value_factory.get()),
+              StatusIs(absl::StatusCode::kCancelled));
+
+  Activation expired;
+  expired.SetDeadline(absl::Now() - absl::Seconds(1));
+  EXPECT_THAT(program->Evaluate(expired, value_factory.get()),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+TEST(StandardRuntimeTest, EvaluationTimeout) {
+  RuntimeOptions options;
+  options.evaluation_timeout = absl::ZeroDuration();
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("1 + 2"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  google::protobuf::Arena arena;
+  ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                    ProtoMemoryManagerRef(&arena));
+  Activation activation;
+  EXPECT_THAT(program->Evaluate(activation, value_factory.get()),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+TEST(StandardRuntimeTest, EvaluateView) {
+  for (int max_recursion_depth : {0, -1}) {
+    google::protobuf::Arena arena;
+    RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK(extensions::EnableConstantFolding(builder,
+                                                ProtoMemoryManagerRef(&arena)));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+
+    ManagedValueFactory value_factory(runtime->GetTypeProvider(),
+                                      ProtoMemoryManagerRef(&arena));
+    auto token = std::make_shared<CancellationToken>();
+    Activation activation;
+    activation.InsertOrAssignValue(
+        "x", value_factory.get().CreateUncheckedStringValue("a"));
+    activation.SetCancellationToken(token);
+
+    // Folded into a constant, the result is a view of the program's value.
+    ASSERT_OK_AND_ASSIGN(ParsedExpr constant_expr,
+                         ParseWithTestMacros("['a', 'b'].map(y, y + 'c')[1]"));
+    ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<Program> constant_program,
+        ProtobufRuntimeAdapter::CreateProgram(*runtime, constant_expr));
+    Value scratch = IntValue(0);
+    ASSERT_OK_AND_ASSIGN(
+        ValueView result,
+        constant_program->EvaluateView(activation, value_factory.get(),
+                                       scratch));
+    EXPECT_THAT(Value(result), StringValueIs("bc"));
+    EXPECT_THAT(scratch, IntValueIs(0));
+
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("x + 'c'"));
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                         ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+    ASSERT_OK_AND_ASSIGN(result, program->EvaluateView(
+                                     activation, value_factory.get(), scratch));
+    EXPECT_THAT(Value(result), StringValueIs("ac"));
+
+    token->Cancel();
+    EXPECT_THAT(constant_program->EvaluateView(activation, value_factory.get(),
+                                               scratch),
+                StatusIs(absl::StatusCode::kCancelled));
+    EXPECT_THAT(program->EvaluateView(activation, value_factory.get(), scratch),
+                StatusIs(absl::StatusCode::kCancelled));
+  }
+}
+
+TEST(StandardRuntimeTest, LazyFunctionResolvedOncePerEvaluation) {
+  for (int max_recursion_depth : {0, -1}) {
+    RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    FunctionDescriptor descriptor("twice", false, {Kind::kInt});
+    ASSERT_OK(builder.function_registry().RegisterLazyFunction(descriptor));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(
+        ParsedExpr expr,
+        ParseWithTestMacros("[1, 2, 3].all(e, twice(e) == e + e)"));
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                         ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+    Activation activation;
+    ASSERT_TRUE(activation.InsertFunction(
+        descriptor, UnaryFunctionAdapter<int64_t, int64_t>::WrapFunction(
+                        [](ValueManager&, int64_t x) { return 2 * x; })));
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+
+    for (int evaluation = 1; evaluation <= 2; ++evaluation) {
+      CountingActivation counting_activation(activation);
+      ASSERT_OK_AND_ASSIGN(
+          Value result,
+          program->Evaluate(counting_activation, value_factory.get()));
+      EXPECT_THAT(result, BoolValueIs(true));
+      // Resolved on the first call, then reused by the later iterations.
+      EXPECT_EQ(counting_activation.function_lookups(), 1);
+    }
+  }
+}
+
+TEST(StandardRuntimeTest, ProgramMetrics) {
+  for (int max_recursion_depth : {0, -1}) {
+    RuntimeOptions options;
+    options.max_recursion_depth = max_recursion_depth;
+    options.comprehension_max_iterations = 100;
+    options.enable_program_metrics = true;
+    ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+    ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+    ASSERT_OK_AND_ASSIGN(ParsedExpr expr,
+                         ParseWithTestMacros("[1, 2, 3].all(e, e < x)"));
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<TraceableProgram> program,
+                         ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+    const ProgramMetrics* metrics = program->GetMetrics();
+    ASSERT_NE(metrics, nullptr);
+
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    Activation activation;
+    ASSERT_OK_AND_ASSIGN(Value result,
+                         program->Evaluate(activation, value_factory.get()));
+    EXPECT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+    activation.InsertOrAssignValue("x", IntValue(10));
+    ASSERT_OK_AND_ASSIGN(result,
+                         program->Evaluate(activation, value_factory.get()));
+    EXPECT_THAT(result, BoolValueIs(true));
+
+    ProgramMetricsSnapshot snapshot = metrics->Snapshot();
+    EXPECT_EQ(snapshot.evaluations, 2);
+    EXPECT_EQ(snapshot.error_results, 1);
+    EXPECT_EQ(snapshot.failures, 0);
+    EXPECT_GT(snapshot.iterations, 0);
+    uint64_t bucketed = 0;
+    for (uint64_t count : snapshot.latency_bucket_counts) {
+      bucketed += count;
+    }
+    EXPECT_EQ(bucketed, 2);
+  }
+}
+
+TEST(StandardRuntimeTest, ProgramMetricsDisabled) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(ParsedExpr expr, ParseWithTestMacros("1 + 2"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TraceableProgram> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+  EXPECT_EQ(program->GetMetrics(), nullptr);
+}
+
+TEST(StandardRuntimeTest, GetReferences) {
+  RuntimeOptions options;
+  ASSERT_OK_AND_ASSIGN(auto builder, CreateStandardRuntimeBuilder(options));
+  ASSERT_OK(builder.function_registry().RegisterLazyFunction(
+      FunctionDescriptor("lazy_fn", false, {Kind::kAny})));
+  ASSERT_OK_AND_ASSIGN(auto runtime, std::move(builder).Build());
+  ASSERT_OK_AND_ASSIGN(
+      ParsedExpr expr,
+      ParseWithTestMacros("size(xs) > 0 && lazy_fn(y) && xs.all(e, e > 0)"));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Program> program,
+                       ProtobufRuntimeAdapter::CreateProgram(*runtime, expr));
+
+  const ProgramReferences* references = program->GetReferences();
+  ASSERT_NE(references, nullptr);
+  EXPECT_THAT(references->variables, ElementsAre("xs", "y"));
+  // The macro expansion also calls internal functions.
+  EXPECT_THAT(references->functions,
+              testing::IsSupersetOf({"_>_", "lazy_fn", "size"}));
+  EXPECT_THAT(references->context_functions, ElementsAre("lazy_fn"));
+  EXPECT_THAT(references->overload_ids, testing::IsEmpty());
+}
+
 }  // namespace
 }  // namespace cel
@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/trace_buffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/base/casts.h"
+#include "absl/functional/function_ref.h"
+#include "absl/numeric/bits.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+
+namespace cel {
+
+double TraceRecord::double_value() const {
+  return absl::bit_cast<double>(payload);
+}
+
+TraceBuffer::TraceBuffer(size_t capacity)
+    : mask_(absl::bit_ceil(capacity < 1 ? size_t{1} : capacity) - 1) {
+  records_ = std::make_unique<TraceRecord[]>(mask_ + 1);
+}
+
+bool TraceBuffer::Append(int64_t expr_id, const Value& value) {
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) > mask_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  TraceRecord& record = records_[head & mask_];
+  record.expr_id = expr_id;
+  record.kind = value.kind();
+  switch (record.kind) {
+    case ValueKind::kBool:
+      record.payload = Cast<BoolValue>(value).NativeValue() ? 1 : 0;
+      break;
+    case ValueKind::kInt:
+      record.payload =
+          static_cast<uint64_t>(Cast<IntValue>(value).NativeValue());
+      break;
+    case ValueKind::kUint:
+      record.payload = Cast<UintValue>(value).NativeValue();
+      break;
+    case ValueKind::kDouble:
+      record.payload =
+          absl::bit_cast<uint64_t>(Cast<DoubleValue>(value).NativeValue());
+      break;
+    default:
+      record.payload = 0;
+      break;
+  }
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+size_t TraceBuffer::Drain(
+    absl::FunctionRef<void(const TraceRecord&)> consumer) {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  for (uint64_t position = tail; position != head; ++position) {
+    consumer(records_[position & mask_]);
+  }
+  tail_.store(head, std::memory_order_release);
+  return static_cast<size_t>(head - tail);
+}
+
+}  // namespace cel
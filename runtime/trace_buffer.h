@@ -0,0 +1,89 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_TRACE_BUFFER_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_TRACE_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/functional/function_ref.h"
+#include "common/value.h"
+#include "common/value_kind.h"
+
+namespace cel {
+
+// Compact record of the value of an expression node, written to a
+// TraceBuffer.
+//
+// Only the payload of bool, int, uint and double values is kept. Other values
+// are recorded by kind alone, as the record outlives the evaluation.
+struct TraceRecord {
+  int64_t expr_id = 0;
+  ValueKind kind = ValueKind::kError;
+  uint64_t payload = 0;
+
+  bool bool_value() const { return payload != 0; }
+  int64_t int_value() const { return static_cast<int64_t>(payload); }
+  uint64_t uint_value() const { return payload; }
+  double double_value() const;
+};
+
+// Preallocated ring buffer of trace records, filled by
+// TraceableProgram::TraceToBuffer.
+//
+// Recording a node is a fixed-size write without allocation, so evaluations
+// don't do any work on behalf of the consumer. Records are read by Drain,
+// either after the evaluation or concurrently from another thread: a single
+// thread may append while a single other thread drains. If the buffer is full
+// further records are dropped, and counted, until it is drained.
+//
+// The buffer may be reused for many evaluations, for example to sample
+// evaluations in production.
+class TraceBuffer final {
+ public:
+  // `capacity` is rounded up to a power of two.
+  explicit TraceBuffer(size_t capacity);
+
+  TraceBuffer(const TraceBuffer&) = delete;
+  TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+  // Appends the record of `value` for `expr_id`. Returns false if the buffer
+  // is full and the record was dropped.
+  bool Append(int64_t expr_id, const Value& value);
+
+  // Invokes `consumer` with each record in the order they were appended and
+  // removes them from the buffer. Returns the number of records consumed.
+  size_t Drain(absl::FunctionRef<void(const TraceRecord&)> consumer);
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Number of records dropped since the buffer was created.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  std::unique_ptr<TraceRecord[]> records_;
+  size_t mask_;
+  // Positions of the next record to write and to read, increasing without
+  // wrapping; the slot is the position masked by `mask_`.
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_TRACE_BUFFER_H_
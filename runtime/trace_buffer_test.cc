@@ -0,0 +1,112 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/trace_buffer.h"
+
+#include <cstdint>
+#include <limits>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "common/value.h"
+#include "common/value_kind.h"
+#include "internal/testing.h"
+
+namespace cel {
+namespace {
+
+using testing::ElementsAre;
+
+std::vector<int64_t> DrainIds(TraceBuffer& buffer) {
+  std::vector<int64_t> ids;
+  buffer.Drain(
+      [&](const TraceRecord& record) { ids.push_back(record.expr_id); });
+  return ids;
+}
+
+TEST(TraceBufferTest, CapacityIsRoundedUp) {
+  EXPECT_EQ(TraceBuffer(0).capacity(), 1);
+  EXPECT_EQ(TraceBuffer(4).capacity(), 4);
+  EXPECT_EQ(TraceBuffer(5).capacity(), 8);
+}
+
+TEST(TraceBufferTest, RecordsPrimitivePayloads) {
+  TraceBuffer buffer(8);
+  ASSERT_TRUE(buffer.Append(1, BoolValue(true)));
+  ASSERT_TRUE(buffer.Append(2, IntValue(-42)));
+  ASSERT_TRUE(
+      buffer.Append(3, UintValue(std::numeric_limits<uint64_t>::max())));
+  ASSERT_TRUE(buffer.Append(4, DoubleValue(1.5)));
+  ASSERT_TRUE(buffer.Append(5, NullValue()));
+
+  std::vector<TraceRecord> records;
+  EXPECT_EQ(buffer.Drain(
+                [&](const TraceRecord& record) { records.push_back(record); }),
+            5);
+  ASSERT_EQ(records.size(), 5);
+  EXPECT_EQ(records[0].expr_id, 1);
+  EXPECT_EQ(records[0].kind, ValueKind::kBool);
+  EXPECT_TRUE(records[0].bool_value());
+  EXPECT_EQ(records[1].kind, ValueKind::kInt);
+  EXPECT_EQ(records[1].int_value(), -42);
+  EXPECT_EQ(records[2].kind, ValueKind::kUint);
+  EXPECT_EQ(records[2].uint_value(), std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(records[3].kind, ValueKind::kDouble);
+  EXPECT_EQ(records[3].double_value(), 1.5);
+  EXPECT_EQ(records[4].kind, ValueKind::kNull);
+}
+
+TEST(TraceBufferTest, DropsWhenFull) {
+  TraceBuffer buffer(2);
+  EXPECT_TRUE(buffer.Append(1, IntValue(1)));
+  EXPECT_TRUE(buffer.Append(2, IntValue(2)));
+  EXPECT_FALSE(buffer.Append(3, IntValue(3)));
+  EXPECT_EQ(buffer.dropped(), 1);
+  EXPECT_THAT(DrainIds(buffer), ElementsAre(1, 2));
+
+  // Slots are reused after draining.
+  EXPECT_TRUE(buffer.Append(4, IntValue(4)));
+  EXPECT_TRUE(buffer.Append(5, IntValue(5)));
+  EXPECT_THAT(DrainIds(buffer), ElementsAre(4, 5));
+  EXPECT_THAT(DrainIds(buffer), ElementsAre());
+  EXPECT_EQ(buffer.dropped(), 1);
+}
+
+TEST(TraceBufferTest, ConcurrentDrain) {
+  constexpr int64_t kRecords = 10000;
+  TraceBuffer buffer(64);
+  std::thread producer([&]() {
+    for (int64_t i = 0; i < kRecords; ++i) {
+      while (!buffer.Append(i, IntValue(i))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int64_t next = 0;
+  bool in_order = true;
+  while (next < kRecords) {
+    buffer.Drain([&](const TraceRecord& record) {
+      in_order = in_order && record.expr_id == next &&
+                 record.int_value() == next;
+      ++next;
+    });
+    std::this_thread::yield();
+  }
+  producer.join();
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(next, kRecords);
+}
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,37 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_TYPED_ARITHMETIC_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_TYPED_ARITHMETIC_H_
+
+#include "absl/status/status.h"
+#include "runtime/runtime_builder.h"
+
+namespace cel::extensions {
+
+// Enable typed arithmetic in the runtime being built.
+//
+// In checked expressions, arithmetic and ordering calls which the type checker
+// resolved to a standard int, uint, double, timestamp or duration overload are
+// evaluated inline instead of being dispatched through the function registry.
+// Arguments that are errors, unknowns or of an unexpected kind still use the
+// registered overloads, so results are unchanged.
+//
+// Only valid if the standard arithmetic functions are registered and not
+// replaced with custom implementations.
+absl::Status EnableTypedArithmetic(RuntimeBuilder& builder);
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_TYPED_ARITHMETIC_H_
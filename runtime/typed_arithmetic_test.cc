@@ -0,0 +1,170 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/typed_arithmetic.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/api/expr/v1alpha1/checked.pb.h"
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "extensions/protobuf/runtime_adapter.h"
+#include "internal/status_macros.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "runtime/activation.h"
+#include "runtime/managed_value_factory.h"
+#include "runtime/runtime.h"
+#include "runtime/runtime_builder.h"
+#include "runtime/runtime_options.h"
+#include "runtime/standard_runtime_builder_factory.h"
+
+namespace cel::extensions {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::CheckedExpr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::HasSubstr;
+
+// Plans `expression` as if checked, with the root call resolved to
+// `overload_id`.
+absl::StatusOr<std::unique_ptr<TraceableProgram>> CreateCheckedProgram(
+    const Runtime& runtime, absl::string_view expression,
+    absl::string_view overload_id) {
+  CEL_ASSIGN_OR_RETURN(ParsedExpr parsed_expr, Parse(expression));
+  CheckedExpr checked_expr;
+  checked_expr.mutable_expr()->Swap(parsed_expr.mutable_expr());
+  checked_expr.mutable_source_info()->Swap(parsed_expr.mutable_source_info());
+  (*checked_expr.mutable_reference_map())[checked_expr.expr().id()]
+      .add_overload_id(std::string(overload_id));
+  return ProtobufRuntimeAdapter::CreateProgram(runtime, checked_expr);
+}
+
+class TypedArithmeticTest : public testing::TestWithParam<bool> {
+ protected:
+  absl::StatusOr<Value> Evaluate(absl::string_view expression,
+                                 absl::string_view overload_id, Value x,
+                                 Value y) {
+    RuntimeOptions options;
+    if (GetParam()) {
+      options.max_recursion_depth = -1;
+    }
+    options.enable_timestamp_duration_overflow_errors =
+        enable_timestamp_duration_overflow_errors_;
+    CEL_ASSIGN_OR_RETURN(RuntimeBuilder builder,
+                         CreateStandardRuntimeBuilder(options));
+    CEL_RETURN_IF_ERROR(EnableTypedArithmetic(builder));
+    CEL_ASSIGN_OR_RETURN(auto runtime, std::move(builder).Build());
+    CEL_ASSIGN_OR_RETURN(
+        auto program, CreateCheckedProgram(*runtime, expression, overload_id));
+
+    ManagedValueFactory value_factory(program->GetTypeProvider(),
+                                      MemoryManagerRef::ReferenceCounting());
+    Activation activation;
+    activation.InsertOrAssignValue("x", std::move(x));
+    activation.InsertOrAssignValue("y", std::move(y));
+    return program->Evaluate(activation, value_factory.get());
+  }
+
+  bool enable_timestamp_duration_overflow_errors_ = false;
+};
+
+TEST_P(TypedArithmeticTest, IntArithmetic) {
+  ASSERT_OK_AND_ASSIGN(
+      Value result, Evaluate("x + y", "add_int64", IntValue(1), IntValue(2)));
+  ASSERT_TRUE(result.Is<IntValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<IntValue>().NativeValue(), 3);
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x < y", "less_int64", IntValue(1),
+                                        IntValue(2)));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_TRUE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(TypedArithmeticTest, Overflow) {
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("x + y", "add_int64",
+               IntValue(std::numeric_limits<int64_t>::max()), IntValue(1)));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue().message(),
+              HasSubstr("overflow"));
+}
+
+TEST_P(TypedArithmeticTest, UnexpectedKindsUseGenericDispatch) {
+  ASSERT_OK_AND_ASSIGN(Value result, Evaluate("x + y", "add_int64",
+                                              UintValue(1), UintValue(2)));
+  ASSERT_TRUE(result.Is<UintValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<UintValue>().NativeValue(), 3);
+}
+
+TEST_P(TypedArithmeticTest, TimestampArithmetic) {
+  const absl::Time epoch = absl::UnixEpoch();
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("x - y", "subtract_timestamp_timestamp",
+               TimestampValue(epoch + absl::Seconds(90)),
+               TimestampValue(epoch + absl::Milliseconds(500))));
+  ASSERT_TRUE(result.Is<DurationValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<DurationValue>().NativeValue(),
+            absl::Milliseconds(89500));
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x + y", "add_duration_timestamp",
+                                        DurationValue(absl::Seconds(-1)),
+                                        TimestampValue(epoch)));
+  ASSERT_TRUE(result.Is<TimestampValue>()) << result.DebugString();
+  EXPECT_EQ(result.As<TimestampValue>().NativeValue(),
+            epoch - absl::Seconds(1));
+
+  ASSERT_OK_AND_ASSIGN(result, Evaluate("x >= y", "greater_equals_duration",
+                                        DurationValue(absl::Seconds(1)),
+                                        DurationValue(absl::Seconds(2))));
+  ASSERT_TRUE(result.Is<BoolValue>()) << result.DebugString();
+  EXPECT_FALSE(result.As<BoolValue>().NativeValue());
+}
+
+TEST_P(TypedArithmeticTest, TimestampOverflow) {
+  enable_timestamp_duration_overflow_errors_ = true;
+  ASSERT_OK_AND_ASSIGN(
+      Value result,
+      Evaluate("x + y", "add_timestamp_duration",
+               TimestampValue(absl::FromUnixSeconds(253402300799)),
+               DurationValue(absl::Seconds(1))));
+  ASSERT_TRUE(result.Is<ErrorValue>()) << result.DebugString();
+  EXPECT_THAT(result.As<ErrorValue>().NativeValue().message(),
+              HasSubstr("overflow"));
+
+  enable_timestamp_duration_overflow_errors_ = false;
+  ASSERT_OK_AND_ASSIGN(
+      result, Evaluate("x + y", "add_timestamp_duration",
+                       TimestampValue(absl::FromUnixSeconds(253402300799)),
+                       DurationValue(absl::Seconds(1))));
+  ASSERT_TRUE(result.Is<TimestampValue>()) << result.DebugString();
+}
+
+INSTANTIATE_TEST_SUITE_P(TypedArithmeticTest, TypedArithmeticTest,
+                         testing::Bool());
+
+}  // namespace
+}  // namespace cel::extensions
@@ -0,0 +1,39 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_TYPED_KERNELS_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_TYPED_KERNELS_H_
+
+#include "absl/status/status.h"
+#include "runtime/runtime_builder.h"
+
+namespace cel::extensions {
+
+// Enable typed kernels in the runtime being built.
+//
+// In checked expressions, trees of arithmetic, ordering and logic operations
+// whose calls the type checker resolved to standard int, uint or double
+// overloads are evaluated in a single step on native scalars. Operands that
+// are errors, unknowns or of an unexpected kind and failing operations fall
+// back to the interpreted plan, so results are unchanged.
+//
+// Only applies to recursively planned programs (see
+// `RuntimeOptions::max_recursion_depth`), and is disabled for programs traced
+// for evaluation listeners. Only valid if the standard arithmetic functions
+// are registered and not replaced with custom implementations.
+absl::Status EnableTypedKernels(RuntimeBuilder& builder);
+
+}  // namespace cel::extensions
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_TYPED_KERNELS_H_
@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "runtime/variable_layout.h"
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace cel {
+
+absl::optional<size_t> VariableLayout::FindSlot(absl::string_view name) const {
+  auto iter = slots_.find(name);
+  if (iter == slots_.end()) {
+    return absl::nullopt;
+  }
+  return iter->second;
+}
+
+size_t VariableLayout::AddVariable(absl::string_view name) {
+  auto [iter, inserted] = slots_.try_emplace(name, names_.size());
+  if (inserted) {
+    names_.push_back(std::string(name));
+  }
+  return iter->second;
+}
+
+}  // namespace cel
@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_RUNTIME_VARIABLE_LAYOUT_H_
+#define THIRD_PARTY_CEL_CPP_RUNTIME_VARIABLE_LAYOUT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+
+namespace cel {
+
+// Assignment of the free variables referenced by a planned program to dense
+// integer slots.
+//
+// The planner assigns each distinct variable name a slot in the order the
+// identifiers are first planned. Callers can use the layout to bind variables
+// by index (see SlotActivation) instead of by name, which avoids hashing the
+// variable name on every lookup during evaluation.
+class VariableLayout final {
+ public:
+  VariableLayout() = default;
+
+  VariableLayout(const VariableLayout&) = delete;
+  VariableLayout& operator=(const VariableLayout&) = delete;
+
+  // Returns the slot assigned to the variable, or nullopt if the program does
+  // not reference it.
+  absl::optional<size_t> FindSlot(absl::string_view name) const;
+
+  // Number of slots.
+  size_t size() const { return names_.size(); }
+
+  // Variable names, indexed by slot.
+  absl::Span<const std::string> names() const { return names_; }
+
+  // Returns the slot for the variable, assigning the next free slot if the
+  // variable has not been seen yet.
+  //
+  // Used by the planner. The layout must not be modified once a program
+  // referencing it is evaluated.
+  size_t AddVariable(absl::string_view name);
+
+ private:
+  std::vector<std::string> names_;
+  absl::flat_hash_map<std::string, size_t> slots_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_RUNTIME_VARIABLE_LAYOUT_H_
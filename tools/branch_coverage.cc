@@ -14,8 +14,13 @@
 
 #include "tools/branch_coverage.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "google/api/expr/v1alpha1/checked.pb.h"
 #include "absl/base/no_destructor.h"
@@ -23,11 +28,15 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/base/optimization.h"
 #include "absl/functional/overload.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/variant.h"
+#include "base/ast_internal/ast_impl.h"
 #include "common/value.h"
+#include "eval/compiler/instrumentation.h"
 #include "eval/internal/interop.h"
 #include "eval/public/cel_value.h"
 #include "tools/navigable_ast.h"
@@ -39,6 +48,8 @@ namespace {
 using ::google::api::expr::v1alpha1::CheckedExpr;
 using ::google::api::expr::v1alpha1::Type;
 using ::google::api::expr::runtime::CelValue;
+using ::google::api::expr::runtime::Instrumentation;
+using ::google::api::expr::runtime::InstrumentationFactory;
 
 const absl::Status& UnsupportedConversionError() {
   static absl::NoDestructor<absl::Status> kErr(
@@ -82,6 +93,13 @@ absl::Nullable<const Type*> FindCheckerType(const CheckedExpr& expr,
   return nullptr;
 }
 
+// Whether the checker typed the node `expr_id` as a bool.
+bool InferredBoolType(const CheckedExpr& expr, int64_t expr_id) {
+  const auto* checker_type = FindCheckerType(expr, expr_id);
+  return checker_type != nullptr && checker_type->has_primitive() &&
+         checker_type->primitive() == Type::BOOL;
+}
+
 class BranchCoverageImpl : public BranchCoverage {
  public:
   explicit BranchCoverageImpl(const CheckedExpr& expr) : expr_(expr) {}
@@ -172,14 +190,7 @@ const NavigableAst& BranchCoverageImpl::ast() const { return ast_; }
 const CheckedExpr& BranchCoverageImpl::expr() const { return expr_; }
 
 bool BranchCoverageImpl::InferredBoolType(const AstNode& node) const {
-  int64_t expr_id = node.expr()->id();
-  const auto* checker_type = FindCheckerType(expr_, expr_id);
-  if (checker_type != nullptr) {
-    return checker_type->has_primitive() &&
-           checker_type->primitive() == Type::BOOL;
-  }
-
-  return false;
+  return cel::InferredBoolType(expr_, node.expr()->id());
 }
 
 void BranchCoverageImpl::Init() ABSL_NO_THREAD_SAFETY_ANALYSIS {
@@ -241,6 +252,180 @@ void BranchCoverageImpl::RecordImpl(int64_t expr_id, const CelValue& value) {
               coverage_node.kind);
 }
 
+class SampledBranchCoverageImpl : public SampledBranchCoverage {
+ public:
+  SampledBranchCoverageImpl(const CheckedExpr& expr, int sample_period)
+      : expr_(expr),
+        sample_period_(static_cast<uint64_t>(std::max(sample_period, 1))) {}
+
+  // Indexes the nodes of the expression and allocates their counters. This
+  // should be called by the factory function, before any other method.
+  void Init();
+
+  // Implement public interface.
+  bool ShouldSample() override {
+    return ThreadShard().sample_calls.fetch_add(1, std::memory_order_relaxed) %
+               sample_period_ ==
+           0;
+  }
+
+  InstrumentationFactory MakeInstrumentationFactory() override {
+    return [this](const cel::ast_internal::AstImpl&) -> Instrumentation {
+      return [this](int64_t expr_id, const Value& value) -> absl::Status {
+        Record(expr_id, value);
+        return absl::OkStatus();
+      };
+    };
+  }
+
+  void Record(int64_t expr_id, const Value& value) override {
+    if (value->Is<BoolValue>()) {
+      RecordImpl(expr_id, ValueClass::kBool,
+                 value.As<BoolValue>().NativeValue());
+    } else if (value->Is<ErrorValue>()) {
+      RecordImpl(expr_id, ValueClass::kError, false);
+    } else {
+      RecordImpl(expr_id, ValueClass::kOther, false);
+    }
+  }
+
+  void RecordLegacyValue(int64_t expr_id, const CelValue& value) override {
+    if (value.IsBool()) {
+      RecordImpl(expr_id, ValueClass::kBool, value.BoolOrDie());
+    } else if (value.IsError()) {
+      RecordImpl(expr_id, ValueClass::kError, false);
+    } else {
+      RecordImpl(expr_id, ValueClass::kOther, false);
+    }
+  }
+
+  BranchCoverage::NodeCoverageStats StatsForNode(
+      int64_t expr_id) const override;
+
+  const NavigableAst& ast() const override { return ast_; }
+  const CheckedExpr& expr() const override { return expr_; }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  enum class CoverageKind { kConstant, kBool, kOther };
+
+  enum class ValueClass { kBool, kError, kOther };
+
+  struct NodeCounters {
+    std::atomic<int64_t> evaluations{0};
+    std::atomic<int64_t> boolean_true{0};
+    std::atomic<int64_t> boolean_false{0};
+    std::atomic<int64_t> errors{0};
+  };
+
+  // Counters updated by the threads hashing to the shard.
+  struct alignas(ABSL_CACHELINE_SIZE) Shard {
+    std::atomic<uint64_t> sample_calls{0};
+    // Indexed like `node_kinds_`.
+    std::unique_ptr<NodeCounters[]> nodes;
+  };
+
+  Shard& ThreadShard() const {
+    thread_local const size_t thread_hash =
+        absl::Hash<std::thread::id>{}(std::this_thread::get_id());
+    return shards_[thread_hash % kNumShards];
+  }
+
+  void RecordImpl(int64_t expr_id, ValueClass value_class, bool bool_value);
+
+  CheckedExpr expr_;
+  NavigableAst ast_;
+  const uint64_t sample_period_;
+  // Immutable after Init.
+  absl::flat_hash_map<int64_t, size_t> node_indices_;
+  std::vector<CoverageKind> node_kinds_;
+  mutable Shard shards_[kNumShards];
+};
+
+void SampledBranchCoverageImpl::Init() {
+  ast_ = NavigableAst::Build(expr_.expr());
+  for (const AstNode& node : ast_.Root().DescendantsPreorder()) {
+    int64_t expr_id = node.expr()->id();
+    if (!node_indices_.insert({expr_id, node_kinds_.size()}).second) {
+      continue;
+    }
+    if (node.node_kind() == NodeKind::kConstant) {
+      node_kinds_.push_back(CoverageKind::kConstant);
+    } else if (InferredBoolType(expr_, expr_id)) {
+      node_kinds_.push_back(CoverageKind::kBool);
+    } else {
+      node_kinds_.push_back(CoverageKind::kOther);
+    }
+  }
+  for (Shard& shard : shards_) {
+    shard.nodes = std::make_unique<NodeCounters[]>(node_kinds_.size());
+  }
+}
+
+void SampledBranchCoverageImpl::RecordImpl(int64_t expr_id,
+                                           ValueClass value_class,
+                                           bool bool_value) {
+  auto it = node_indices_.find(expr_id);
+  if (it == node_indices_.end()) {
+    return;
+  }
+  NodeCounters& counters = ThreadShard().nodes[it->second];
+  counters.evaluations.fetch_add(1, std::memory_order_relaxed);
+  switch (value_class) {
+    case ValueClass::kBool:
+      (bool_value ? counters.boolean_true : counters.boolean_false)
+          .fetch_add(1, std::memory_order_relaxed);
+      break;
+    case ValueClass::kError:
+      counters.errors.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case ValueClass::kOther:
+      break;
+  }
+}
+
+BranchCoverage::NodeCoverageStats SampledBranchCoverageImpl::StatsForNode(
+    int64_t expr_id) const {
+  BranchCoverage::NodeCoverageStats stats{
+      /*is_boolean=*/false,
+      /*evaluation_count=*/0,
+      /*boolean_true_count=*/0,
+      /*boolean_false_count=*/0,
+      /*error_count=*/0,
+  };
+  auto it = node_indices_.find(expr_id);
+  if (it == node_indices_.end()) {
+    return stats;
+  }
+  int64_t evaluations = 0;
+  int64_t boolean_true = 0;
+  int64_t boolean_false = 0;
+  int64_t errors = 0;
+  for (const Shard& shard : shards_) {
+    const NodeCounters& counters = shard.nodes[it->second];
+    evaluations += counters.evaluations.load(std::memory_order_relaxed);
+    boolean_true += counters.boolean_true.load(std::memory_order_relaxed);
+    boolean_false += counters.boolean_false.load(std::memory_order_relaxed);
+    errors += counters.errors.load(std::memory_order_relaxed);
+  }
+  stats.evaluation_count = static_cast<int>(evaluations);
+  switch (node_kinds_[it->second]) {
+    case CoverageKind::kConstant:
+      break;
+    case CoverageKind::kBool:
+      stats.is_boolean = true;
+      stats.boolean_true_count = static_cast<int>(boolean_true);
+      stats.boolean_false_count = static_cast<int>(boolean_false);
+      stats.error_count = static_cast<int>(errors);
+      break;
+    case CoverageKind::kOther:
+      stats.error_count = static_cast<int>(errors);
+      break;
+  }
+  return stats;
+}
+
 }  // namespace
 
 std::unique_ptr<BranchCoverage> CreateBranchCoverage(const CheckedExpr& expr) {
@@ -249,4 +434,12 @@ std::unique_ptr<BranchCoverage> CreateBranchCoverage(const CheckedExpr& expr) {
   return result;
 }
 
+std::unique_ptr<SampledBranchCoverage> CreateSampledBranchCoverage(
+    const CheckedExpr& expr, int sample_period) {
+  auto result =
+      std::make_unique<SampledBranchCoverageImpl>(expr, sample_period);
+  result->Init();
+  return result;
+}
+
 }  // namespace cel
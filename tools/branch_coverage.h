@@ -21,6 +21,7 @@
 #include "google/api/expr/v1alpha1/checked.pb.h"
 #include "absl/base/attributes.h"
 #include "common/value.h"
+#include "eval/compiler/instrumentation.h"
 #include "eval/public/cel_value.h"
 #include "tools/navigable_ast.h"
 
@@ -62,6 +63,36 @@ class BranchCoverage {
 std::unique_ptr<BranchCoverage> CreateBranchCoverage(
     const google::api::expr::v1alpha1::CheckedExpr& expr);
 
+// BranchCoverage collected from a sample of the evaluations of an expression,
+// cheap enough to keep enabled in production.
+//
+// Values are recorded by the instrumentation of a second program for the
+// expression, planned with
+// `CreateInstrumentationExtension(coverage->MakeInstrumentationFactory())`.
+// Evaluations for which `ShouldSample()` returns true are run with the
+// instrumented program and the others with the plain one, so that unsampled
+// evaluations don't pay for coverage and none need tracing.
+//
+// Counters are kept in shards picked by thread, updated without locking and
+// merged when read by `StatsForNode`. Values recorded for ids which aren't in
+// the expression, such as the nodes added by optimizations, are ignored.
+class SampledBranchCoverage : public BranchCoverage {
+ public:
+  // Returns true for one in every `sample_period` calls. Thread safe.
+  virtual bool ShouldSample() = 0;
+
+  // Returns a factory of instrumentation recording into this coverage, which
+  // must outlive the programs planned with it.
+  virtual google::api::expr::runtime::InstrumentationFactory
+  MakeInstrumentationFactory() = 0;
+};
+
+// Creates a SampledBranchCoverage for `expr`, sampling one in every
+// `sample_period` evaluations. A `sample_period` of 1 or less samples every
+// evaluation.
+std::unique_ptr<SampledBranchCoverage> CreateSampledBranchCoverage(
+    const google::api::expr::v1alpha1::CheckedExpr& expr, int sample_period);
+
 }  // namespace cel
 
 #endif  // THIRD_PARTY_CEL_CPP_TOOLS_BRANCH_COVERAGE_H_
@@ -24,6 +24,8 @@
 #include "base/builtins.h"
 #include "base/type_provider.h"
 #include "common/memory.h"
+#include "eval/compiler/cel_expression_builder_flat_impl.h"
+#include "eval/compiler/instrumentation.h"
 #include "eval/public/activation.h"
 #include "eval/public/builtin_func_registrar.h"
 #include "eval/public/cel_expr_builder_factory.h"
@@ -41,8 +43,10 @@ namespace {
 using ::cel::internal::test::ReadTextProtoFromFile;
 using ::google::api::expr::v1alpha1::CheckedExpr;
 using ::google::api::expr::runtime::Activation;
+using ::google::api::expr::runtime::CelExpressionBuilderFlatImpl;
 using ::google::api::expr::runtime::CelValue;
 using ::google::api::expr::runtime::CreateCelExpressionBuilder;
+using ::google::api::expr::runtime::CreateInstrumentationExtension;
 using ::google::api::expr::runtime::RegisterBuiltinFunctions;
 
 // int1 < int2 &&
@@ -422,5 +426,81 @@ TEST(BranchCoverage, CountsErrors) {
                                                      /*error_count=*/1}));
 }
 
+TEST(SampledBranchCoverage, ShouldSample) {
+  auto coverage =
+      CreateSampledBranchCoverage(TestExpression(), /*sample_period=*/3);
+  int sampled = 0;
+  for (int i = 0; i < 9; ++i) {
+    sampled += coverage->ShouldSample() ? 1 : 0;
+  }
+  EXPECT_EQ(sampled, 3);
+
+  auto every_evaluation =
+      CreateSampledBranchCoverage(TestExpression(), /*sample_period=*/0);
+  EXPECT_TRUE(every_evaluation->ShouldSample());
+  EXPECT_TRUE(every_evaluation->ShouldSample());
+}
+
+TEST(SampledBranchCoverage, RecordsSampledEvaluations) {
+  auto coverage =
+      CreateSampledBranchCoverage(TestExpression(), /*sample_period=*/4);
+
+  CelExpressionBuilderFlatImpl builder;
+  ASSERT_OK(RegisterBuiltinFunctions(builder.GetRegistry()));
+  ASSERT_OK_AND_ASSIGN(auto plain_program,
+                       builder.CreateExpression(&TestExpression()));
+  builder.flat_expr_builder().AddProgramOptimizer(
+      CreateInstrumentationExtension(coverage->MakeInstrumentationFactory()));
+  ASSERT_OK_AND_ASSIGN(auto instrumented_program,
+                       builder.CreateExpression(&TestExpression()));
+
+  google::protobuf::Arena arena;
+  Activation activation;
+  activation.InsertValue("bool1", CelValue::CreateBool(false));
+  activation.InsertValue("bool2", CelValue::CreateBool(false));
+
+  activation.InsertValue("int1", CelValue::CreateInt64(42));
+  activation.InsertValue("int2", CelValue::CreateInt64(43));
+
+  activation.InsertValue("int_divisor", CelValue::CreateInt64(4));
+
+  activation.InsertValue("ternary_c", CelValue::CreateBool(true));
+  activation.InsertValue("ternary_t", CelValue::CreateBool(true));
+  activation.InsertValue("ternary_f", CelValue::CreateBool(false));
+
+  for (int i = 0; i < 10; ++i) {
+    const auto& program =
+        coverage->ShouldSample() ? instrumented_program : plain_program;
+    ASSERT_OK_AND_ASSIGN(auto result, program->Evaluate(activation, &arena));
+    EXPECT_TRUE(result.IsBool() && result.BoolOrDie() == true);
+  }
+
+  using Stats = BranchCoverage::NodeCoverageStats;
+  const NavigableAst& ast = coverage->ast();
+  // Evaluations 0, 4 and 8 are sampled.
+  EXPECT_THAT(coverage->StatsForNode(ast.Root().expr()->id()),
+              MatchesNodeStats(Stats{/*is_boolean=*/true,
+                                     /*evaluation_count=*/3,
+                                     /*boolean_true_count=*/3,
+                                     /*boolean_false_count=*/0,
+                                     /*error_count=*/0}));
+
+  const AstNode* not_arg_expr = nullptr;
+  for (const auto& node : ast.Root().DescendantsPreorder()) {
+    if (node.node_kind() == NodeKind::kCall &&
+        node.expr()->call_expr().function() == cel::builtin::kNot) {
+      not_arg_expr = node.children().at(0);
+      break;
+    }
+  }
+  ASSERT_NE(not_arg_expr, nullptr);
+  EXPECT_THAT(coverage->StatsForNode(not_arg_expr->expr()->id()),
+              MatchesNodeStats(Stats{/*is_boolean=*/true,
+                                     /*evaluation_count=*/3,
+                                     /*boolean_true_count=*/0,
+                                     /*boolean_false_count=*/3,
+                                     /*error_count=*/0}));
+}
+
 }  // namespace
 }  // namespace cel
@@ -0,0 +1,664 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/flatbuffers_backed_value.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/optimization.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/casting.h"
+#include "common/json.h"
+#include "common/memory.h"
+#include "common/native_type.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "internal/status_macros.h"
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/reflection.h"
+
+namespace cel {
+
+namespace {
+
+using FieldVector = flatbuffers::Vector<flatbuffers::Offset<reflection::Field>>;
+using StringVector =
+    flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>;
+using TableVector =
+    flatbuffers::Vector<flatbuffers::Offset<flatbuffers::Table>>;
+
+absl::string_view ToStringView(const flatbuffers::String* value) {
+  if (value == nullptr) {
+    return absl::string_view();
+  }
+  return absl::string_view(value->c_str(), value->size());
+}
+
+// Strings and bytes are cords referencing the buffer, so that they are not
+// copied when the evaluator keeps them.
+ValueView BufferString(ValueManager& value_manager, absl::string_view value,
+                       Value& scratch) {
+  scratch = value_manager.CreateUncheckedStringValue(value, [] {});
+  return scratch;
+}
+
+absl::StatusOr<ValueView> BufferBytes(ValueManager& value_manager,
+                                      absl::string_view value,
+                                      Value& scratch) {
+  CEL_ASSIGN_OR_RETURN(scratch, value_manager.CreateBytesValue(value, [] {}));
+  return scratch;
+}
+
+absl::Status JsonConversionError() {
+  return absl::UnimplementedError(
+      "flatbuffer tables are not convertible to JSON");
+}
+
+absl::StatusOr<ValueView> NewMapValue(ValueManager& value_manager,
+                                      const flatbuffers::Table& table,
+                                      const reflection::Schema& schema,
+                                      const reflection::Object& object,
+                                      Value& scratch);
+
+// A list over a vector of scalars of type `T`, whose elements are values of
+// type `V`.
+template <typename T, typename V>
+class FlatBuffersScalarListValue final : public ParsedListValueInterface {
+ public:
+  explicit FlatBuffersScalarListValue(const flatbuffers::Vector<T>* list)
+      : list_(list) {}
+
+  std::string DebugString() const override {
+    std::string out = "[";
+    for (size_t i = 0; i < Size(); ++i) {
+      if (i != 0) {
+        out.append(", ");
+      }
+      out.append(Element(i).DebugString());
+    }
+    out.push_back(']');
+    return out;
+  }
+
+  size_t Size() const override { return list_ ? list_->size() : 0; }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter& converter) const override {
+    JsonArrayBuilder builder;
+    builder.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+      CEL_ASSIGN_OR_RETURN(auto json, Element(i).ConvertToJson(converter));
+      builder.push_back(std::move(json));
+    }
+    return std::move(builder).Build();
+  }
+
+ private:
+  V Element(size_t index) const {
+    return V(list_->Get(index));
+  }
+
+  absl::StatusOr<ValueView> GetImpl(ValueManager&, size_t index,
+                                    Value&) const override {
+    return Element(index);
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FlatBuffersScalarListValue<T, V>>();
+  }
+
+  const flatbuffers::Vector<T>* const list_;
+};
+
+class FlatBuffersStringListValue final : public ParsedListValueInterface {
+ public:
+  explicit FlatBuffersStringListValue(const StringVector* list)
+      : list_(list) {}
+
+  std::string DebugString() const override {
+    std::string out = "[";
+    for (size_t i = 0; i < Size(); ++i) {
+      if (i != 0) {
+        out.append(", ");
+      }
+      out.append(StringValueView(Element(i)).DebugString());
+    }
+    out.push_back(']');
+    return out;
+  }
+
+  size_t Size() const override { return list_ ? list_->size() : 0; }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter&) const override {
+    JsonArrayBuilder builder;
+    builder.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+      builder.push_back(JsonString(Element(i)));
+    }
+    return std::move(builder).Build();
+  }
+
+ private:
+  absl::string_view Element(size_t index) const {
+    return ToStringView(list_->Get(index));
+  }
+
+  absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
+                                    Value& scratch) const override {
+    return BufferString(value_manager, Element(index), scratch);
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FlatBuffersStringListValue>();
+  }
+
+  const StringVector* const list_;
+};
+
+class FlatBuffersObjectListValue final : public ParsedListValueInterface {
+ public:
+  FlatBuffersObjectListValue(const TableVector* list,
+                             const reflection::Schema& schema,
+                             const reflection::Object& object)
+      : list_(list), schema_(schema), object_(object) {}
+
+  std::string DebugString() const override {
+    return absl::StrCat("list(", ToStringView(object_.name()), ")");
+  }
+
+  size_t Size() const override { return list_ ? list_->size() : 0; }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter&) const override {
+    return JsonConversionError();
+  }
+
+ private:
+  absl::StatusOr<ValueView> GetImpl(ValueManager& value_manager, size_t index,
+                                    Value& scratch) const override {
+    return NewMapValue(value_manager, *list_->Get(index), schema_, object_,
+                       scratch);
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FlatBuffersObjectListValue>();
+  }
+
+  const TableVector* const list_;
+  const reflection::Schema& schema_;
+  const reflection::Object& object_;
+};
+
+// The names of the fields of a table, which are the keys of its map.
+class FieldNameListValue final : public ParsedListValueInterface {
+ public:
+  explicit FieldNameListValue(const FieldVector& fields) : fields_(fields) {}
+
+  std::string DebugString() const override {
+    std::string out = "[";
+    for (size_t i = 0; i < Size(); ++i) {
+      if (i != 0) {
+        out.append(", ");
+      }
+      out.append(StringValueView(Element(i)).DebugString());
+    }
+    out.push_back(']');
+    return out;
+  }
+
+  size_t Size() const override { return fields_.size(); }
+
+  absl::StatusOr<JsonArray> ConvertToJsonArray(
+      AnyToJsonConverter&) const override {
+    JsonArrayBuilder builder;
+    builder.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+      builder.push_back(JsonString(Element(i)));
+    }
+    return std::move(builder).Build();
+  }
+
+ private:
+  absl::string_view Element(size_t index) const {
+    return ToStringView(fields_.Get(index)->name());
+  }
+
+  absl::StatusOr<ValueView> GetImpl(ValueManager&, size_t index,
+                                    Value&) const override {
+    // Names of the schema, which outlives the value, are viewed in place.
+    return StringValueView(Element(index));
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FieldNameListValue>();
+  }
+
+  const FieldVector& fields_;
+};
+
+class FieldNameIterator final : public ValueIterator {
+ public:
+  explicit FieldNameIterator(const FieldVector& fields) : fields_(fields) {}
+
+  bool HasNext() override { return index_ < fields_.size(); }
+
+  absl::StatusOr<ValueView> Next(ValueManager&, Value&) override {
+    if (ABSL_PREDICT_FALSE(index_ >= fields_.size())) {
+      return absl::FailedPreconditionError(
+          "ValueIterator::Next() called when "
+          "ValueIterator::HasNext() returns false");
+    }
+    return StringValueView(ToStringView(fields_.Get(index_++)->name()));
+  }
+
+ private:
+  const FieldVector& fields_;
+  size_t index_ = 0;
+};
+
+// Returns the field of `object` named `name`. The fields of reflection
+// objects are sorted by name.
+const reflection::Field* FindField(const reflection::Object& object,
+                                   absl::string_view name) {
+  const FieldVector& fields = *object.fields();
+  auto it = std::lower_bound(fields.begin(), fields.end(), name,
+                             [](const reflection::Field* field,
+                                absl::string_view target) {
+                               return ToStringView(field->name()) < target;
+                             });
+  if (it == fields.end() || ToStringView((*it)->name()) != name) {
+    return nullptr;
+  }
+  return *it;
+}
+
+// Detects a "key" field of the type string.
+const reflection::Field* FindStringKeyField(const reflection::Object& object) {
+  for (const auto* field : *object.fields()) {
+    if (field->key() && field->type()->base_type() == reflection::String) {
+      return field;
+    }
+  }
+  return nullptr;
+}
+
+// A map over a vector of tables with a string key, from the keys to the
+// tables. The vector is sorted by key.
+class FlatBuffersKeyedMapValue final : public ParsedMapValueInterface {
+ public:
+  FlatBuffersKeyedMapValue(const TableVector* list,
+                           const reflection::Schema& schema,
+                           const reflection::Object& object,
+                           const reflection::Field& key)
+      : list_(list), schema_(schema), object_(object), key_(key) {}
+
+  std::string DebugString() const override {
+    return absl::StrCat("map(string, ", ToStringView(object_.name()), ")");
+  }
+
+  size_t Size() const override { return list_ ? list_->size() : 0; }
+
+  absl::StatusOr<JsonObject> ConvertToJsonObject(
+      AnyToJsonConverter&) const override {
+    return JsonConversionError();
+  }
+
+  absl::StatusOr<ListValueView> ListKeys(
+      ValueManager& value_manager, ListValue& scratch) const override {
+    CEL_ASSIGN_OR_RETURN(auto keys, value_manager.NewListValueBuilder(
+                                        value_manager.GetDynListType()));
+    keys->Reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+      CEL_RETURN_IF_ERROR(keys->Add(StringValue(Key(*list_->Get(i)))));
+    }
+    scratch = std::move(*keys).Build();
+    return scratch;
+  }
+
+  absl::StatusOr<absl::Nonnull<ValueIteratorPtr>> NewIterator(
+      ValueManager& value_manager) const override {
+    ListValue keys;
+    CEL_RETURN_IF_ERROR(ListKeys(value_manager, keys).status());
+    return std::make_unique<KeyIterator>(std::move(keys));
+  }
+
+ private:
+  // Iterates over the keys of the map, which it owns.
+  class KeyIterator final : public ValueIterator {
+   public:
+    explicit KeyIterator(ListValue keys) : keys_(std::move(keys)) {}
+
+    bool HasNext() override {
+      auto size = keys_.Size();
+      return size.ok() && index_ < *size;
+    }
+
+    absl::StatusOr<ValueView> Next(ValueManager& value_manager,
+                                   Value& scratch) override {
+      if (ABSL_PREDICT_FALSE(!HasNext())) {
+        return absl::FailedPreconditionError(
+            "ValueIterator::Next() called when "
+            "ValueIterator::HasNext() returns false");
+      }
+      return keys_.Get(value_manager, index_++, scratch);
+    }
+
+   private:
+    const ListValue keys_;
+    size_t index_ = 0;
+  };
+
+  absl::string_view Key(const flatbuffers::Table& table) const {
+    return ToStringView(flatbuffers::GetFieldS(table, key_));
+  }
+
+  const flatbuffers::Table* FindTable(ValueView key) const {
+    auto string_key = As<StringValueView>(key);
+    if (!string_key.has_value() || list_ == nullptr) {
+      return nullptr;
+    }
+    std::string key_scratch;
+    absl::string_view name = string_key->NativeString(key_scratch);
+    auto it = std::lower_bound(
+        list_->begin(), list_->end(), name,
+        [this](const flatbuffers::Table* table, absl::string_view target) {
+          return Key(*table) < target;
+        });
+    if (it == list_->end() || Key(**it) != name) {
+      return nullptr;
+    }
+    return *it;
+  }
+
+  absl::StatusOr<absl::optional<ValueView>> FindImpl(
+      ValueManager& value_manager, ValueView key,
+      Value& scratch) const override {
+    const flatbuffers::Table* table = FindTable(key);
+    if (table == nullptr) {
+      return absl::nullopt;
+    }
+    CEL_ASSIGN_OR_RETURN(
+        auto value, NewMapValue(value_manager, *table, schema_, object_,
+                                scratch));
+    return value;
+  }
+
+  absl::StatusOr<bool> HasImpl(ValueManager&, ValueView key) const override {
+    return FindTable(key) != nullptr;
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FlatBuffersKeyedMapValue>();
+  }
+
+  const TableVector* const list_;
+  const reflection::Schema& schema_;
+  const reflection::Object& object_;
+  const reflection::Field& key_;
+};
+
+// A map over a table, from the names of the fields of its object to their
+// values.
+class FlatBuffersMapValue final : public ParsedMapValueInterface {
+ public:
+  FlatBuffersMapValue(const flatbuffers::Table& table,
+                      const reflection::Schema& schema,
+                      const reflection::Object& object)
+      : table_(table), schema_(schema), object_(object) {}
+
+  std::string DebugString() const override {
+    return std::string(ToStringView(object_.name()));
+  }
+
+  size_t Size() const override { return object_.fields()->size(); }
+
+  absl::StatusOr<JsonObject> ConvertToJsonObject(
+      AnyToJsonConverter&) const override {
+    return JsonConversionError();
+  }
+
+  absl::StatusOr<ListValueView> ListKeys(
+      ValueManager& value_manager, ListValue& scratch) const override {
+    scratch = ListValue(ParsedListValue(
+        value_manager.GetMemoryManager().MakeShared<FieldNameListValue>(
+            *object_.fields())));
+    return scratch;
+  }
+
+  absl::StatusOr<absl::Nonnull<ValueIteratorPtr>> NewIterator(
+      ValueManager&) const override {
+    return std::make_unique<FieldNameIterator>(*object_.fields());
+  }
+
+ private:
+  absl::StatusOr<absl::optional<ValueView>> FindImpl(
+      ValueManager& value_manager, ValueView key,
+      Value& scratch) const override {
+    auto string_key = As<StringValueView>(key);
+    if (!string_key.has_value()) {
+      return absl::nullopt;
+    }
+    std::string key_scratch;
+    const reflection::Field* field =
+        FindField(object_, string_key->NativeString(key_scratch));
+    if (field == nullptr) {
+      return absl::nullopt;
+    }
+    return GetField(value_manager, *field, scratch);
+  }
+
+  absl::StatusOr<bool> HasImpl(ValueManager& value_manager,
+                               ValueView key) const override {
+    Value scratch;
+    CEL_ASSIGN_OR_RETURN(auto value, FindImpl(value_manager, key, scratch));
+    return value.has_value();
+  }
+
+  // Returns the value of `field`, or `absl::nullopt` if its type isn't
+  // supported.
+  absl::StatusOr<absl::optional<ValueView>> GetField(
+      ValueManager& value_manager, const reflection::Field& field,
+      Value& scratch) const;
+
+  absl::StatusOr<absl::optional<ValueView>> GetVectorField(
+      ValueManager& value_manager, const reflection::Field& field,
+      Value& scratch) const;
+
+  template <typename T, typename V>
+  ValueView NewScalarList(ValueManager& value_manager,
+                          const reflection::Field& field,
+                          Value& scratch) const {
+    scratch = ListValue(ParsedListValue(
+        value_manager.GetMemoryManager()
+            .MakeShared<FlatBuffersScalarListValue<T, V>>(
+                table_.GetPointer<const flatbuffers::Vector<T>*>(
+                    field.offset()))));
+    return scratch;
+  }
+
+  NativeTypeId GetNativeTypeId() const noexcept override {
+    return NativeTypeId::For<FlatBuffersMapValue>();
+  }
+
+  const flatbuffers::Table& table_;
+  const reflection::Schema& schema_;
+  const reflection::Object& object_;
+};
+
+absl::StatusOr<absl::optional<ValueView>> FlatBuffersMapValue::GetField(
+    ValueManager& value_manager, const reflection::Field& field,
+    Value& scratch) const {
+  switch (field.type()->base_type()) {
+    case reflection::Byte:
+      return IntValueView(flatbuffers::GetFieldI<int8_t>(table_, field));
+    case reflection::Short:
+      return IntValueView(flatbuffers::GetFieldI<int16_t>(table_, field));
+    case reflection::Int:
+      return IntValueView(flatbuffers::GetFieldI<int32_t>(table_, field));
+    case reflection::Long:
+      return IntValueView(flatbuffers::GetFieldI<int64_t>(table_, field));
+    case reflection::UByte:
+      return UintValueView(flatbuffers::GetFieldI<uint8_t>(table_, field));
+    case reflection::UShort:
+      return UintValueView(flatbuffers::GetFieldI<uint16_t>(table_, field));
+    case reflection::UInt:
+      return UintValueView(flatbuffers::GetFieldI<uint32_t>(table_, field));
+    case reflection::ULong:
+      return UintValueView(flatbuffers::GetFieldI<uint64_t>(table_, field));
+    case reflection::Float:
+      return DoubleValueView(flatbuffers::GetFieldF<float>(table_, field));
+    case reflection::Double:
+      return DoubleValueView(flatbuffers::GetFieldF<double>(table_, field));
+    case reflection::Bool:
+      return BoolValueView(flatbuffers::GetFieldI<int8_t>(table_, field) != 0);
+    case reflection::String:
+      return BufferString(value_manager,
+                          ToStringView(flatbuffers::GetFieldS(table_, field)),
+                          scratch);
+    case reflection::Obj: {
+      const auto* field_object = schema_.objects()->Get(field.type()->index());
+      if (field_object == nullptr) {
+        return absl::nullopt;
+      }
+      const auto* field_table = flatbuffers::GetFieldT(table_, field);
+      if (field_table == nullptr) {
+        return NullValueView();
+      }
+      CEL_ASSIGN_OR_RETURN(auto value,
+                           NewMapValue(value_manager, *field_table, schema_,
+                                       *field_object, scratch));
+      return value;
+    }
+    case reflection::Vector:
+      return GetVectorField(value_manager, field, scratch);
+    default:
+      // Unsupported types: enums, unions, arrays
+      return absl::nullopt;
+  }
+}
+
+absl::StatusOr<absl::optional<ValueView>> FlatBuffersMapValue::GetVectorField(
+    ValueManager& value_manager, const reflection::Field& field,
+    Value& scratch) const {
+  switch (field.type()->element()) {
+    case reflection::Byte:
+    case reflection::UByte: {
+      const auto* bytes = flatbuffers::GetFieldAnyV(table_, field);
+      if (bytes == nullptr) {
+        return BytesValueView();
+      }
+      CEL_ASSIGN_OR_RETURN(
+          auto value,
+          BufferBytes(value_manager,
+                      absl::string_view(
+                          reinterpret_cast<const char*>(bytes->Data()),
+                          bytes->size()),
+                      scratch));
+      return value;
+    }
+    case reflection::Short:
+      return NewScalarList<int16_t, IntValueView>(value_manager, field,
+                                                  scratch);
+    case reflection::Int:
+      return NewScalarList<int32_t, IntValueView>(value_manager, field,
+                                                  scratch);
+    case reflection::Long:
+      return NewScalarList<int64_t, IntValueView>(value_manager, field,
+                                                  scratch);
+    case reflection::UShort:
+      return NewScalarList<uint16_t, UintValueView>(value_manager, field,
+                                                    scratch);
+    case reflection::UInt:
+      return NewScalarList<uint32_t, UintValueView>(value_manager, field,
+                                                    scratch);
+    case reflection::ULong:
+      return NewScalarList<uint64_t, UintValueView>(value_manager, field,
+                                                    scratch);
+    case reflection::Float:
+      return NewScalarList<float, DoubleValueView>(value_manager, field,
+                                                   scratch);
+    case reflection::Double:
+      return NewScalarList<double, DoubleValueView>(value_manager, field,
+                                                    scratch);
+    case reflection::Bool:
+      return NewScalarList<uint8_t, BoolValueView>(value_manager, field,
+                                                   scratch);
+    case reflection::String:
+      scratch = ListValue(ParsedListValue(
+          value_manager.GetMemoryManager()
+              .MakeShared<FlatBuffersStringListValue>(
+                  table_.GetPointer<const StringVector*>(field.offset()))));
+      return ValueView(scratch);
+    case reflection::Obj: {
+      const auto* field_object = schema_.objects()->Get(field.type()->index());
+      if (field_object == nullptr) {
+        return absl::nullopt;
+      }
+      const auto* list = table_.GetPointer<const TableVector*>(field.offset());
+      if (const auto* key = FindStringKeyField(*field_object); key != nullptr) {
+        scratch = MapValue(ParsedMapValue(
+            value_manager.GetMemoryManager()
+                .MakeShared<FlatBuffersKeyedMapValue>(list, schema_,
+                                                      *field_object, *key)));
+      } else {
+        scratch = ListValue(ParsedListValue(
+            value_manager.GetMemoryManager()
+                .MakeShared<FlatBuffersObjectListValue>(list, schema_,
+                                                        *field_object)));
+      }
+      return ValueView(scratch);
+    }
+    default:
+      // Unsupported vector base types
+      return absl::nullopt;
+  }
+}
+
+absl::StatusOr<ValueView> NewMapValue(ValueManager& value_manager,
+                                      const flatbuffers::Table& table,
+                                      const reflection::Schema& schema,
+                                      const reflection::Object& object,
+                                      Value& scratch) {
+  scratch = MapValue(
+      ParsedMapValue(value_manager.GetMemoryManager()
+                         .MakeShared<FlatBuffersMapValue>(table, schema,
+                                                          object)));
+  return scratch;
+}
+
+}  // namespace
+
+absl::StatusOr<MapValue> CreateFlatBuffersBackedMapValue(
+    ValueManager& value_manager, const uint8_t* flatbuf,
+    const reflection::Schema& schema) {
+  if (flatbuf == nullptr || schema.root_table() == nullptr) {
+    return absl::InvalidArgumentError(
+        "flatbuffer and schema with a root table are required");
+  }
+  return MapValue(ParsedMapValue(
+      value_manager.GetMemoryManager().MakeShared<FlatBuffersMapValue>(
+          *flatbuffers::GetAnyRoot(flatbuf), schema, *schema.root_table())));
+}
+
+}  // namespace cel
@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_TOOLS_FLATBUFFERS_BACKED_VALUE_H_
+#define THIRD_PARTY_CEL_CPP_TOOLS_FLATBUFFERS_BACKED_VALUE_H_
+
+#include <cstdint>
+
+#include "absl/status/statusor.h"
+#include "common/value.h"
+#include "common/value_manager.h"
+#include "flatbuffers/reflection.h"
+
+namespace cel {
+
+// Returns a map value over the root table of `flatbuf`, whose layout is
+// described by the reflection `schema`. This is the modern counterpart of
+// google::api::expr::runtime::CreateFlatBuffersBackedObject, with the same
+// mapping of fields to values.
+//
+// Fields are read from the buffer in place when they are accessed: they are
+// found by a binary search of the fields of the schema, which are sorted by
+// name, and strings, bytes and vectors refer to the memory of the buffer
+// rather than being copied. Both `flatbuf` and `schema` must outlive the
+// returned value and any value read from it.
+absl::StatusOr<MapValue> CreateFlatBuffersBackedMapValue(
+    ValueManager& value_manager, const uint8_t* flatbuf,
+    const reflection::Schema& schema);
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_TOOLS_FLATBUFFERS_BACKED_VALUE_H_
@@ -0,0 +1,207 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/flatbuffers_backed_value.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/type_provider.h"
+#include "common/casting.h"
+#include "common/memory.h"
+#include "common/value.h"
+#include "common/value_testing.h"
+#include "common/values/legacy_value_manager.h"
+#include "internal/testing.h"
+#include "flatbuffers/idl.h"
+#include "flatbuffers/reflection.h"
+
+namespace cel {
+namespace {
+
+using ::cel::internal::IsOkAndHolds;
+using ::cel::test::BoolValueIs;
+using ::testing::SizeIs;
+
+constexpr char kReflectionBufferPath[] =
+    "tools/testdata/"
+    "flatbuffers.bfbs";
+
+constexpr int64_t kNumFields = 27;
+
+class FlatBuffersValueTest : public testing::Test {
+ public:
+  FlatBuffersValueTest()
+      : value_manager_(MemoryManagerRef::ReferenceCounting(),
+                       TypeProvider::Builtin()) {
+    EXPECT_TRUE(
+        flatbuffers::LoadFile(kReflectionBufferPath, true, &schema_file_));
+    flatbuffers::Verifier verifier(
+        reinterpret_cast<const uint8_t*>(schema_file_.data()),
+        schema_file_.size());
+    EXPECT_TRUE(reflection::VerifySchemaBuffer(verifier));
+    EXPECT_TRUE(parser_.Deserialize(
+        reinterpret_cast<const uint8_t*>(schema_file_.data()),
+        schema_file_.size()));
+    schema_ = reflection::GetSchema(schema_file_.data());
+  }
+
+  MapValue LoadJson(const std::string& data) {
+    EXPECT_TRUE(parser_.Parse(data.data()));
+    auto value = CreateFlatBuffersBackedMapValue(
+        value_manager_, parser_.builder_.GetBufferPointer(), *schema_);
+    EXPECT_OK(value);
+    EXPECT_THAT(value->Size(), IsOkAndHolds(kNumFields));
+    return *value;
+  }
+
+  Value Get(const MapValue& map, absl::string_view key) {
+    auto value = map.Get(value_manager_, StringValue(key));
+    EXPECT_OK(value);
+    return value.ok() ? *value : Value();
+  }
+
+  Value Get(const ListValue& list, size_t index) {
+    auto value = list.Get(value_manager_, index);
+    EXPECT_OK(value);
+    return value.ok() ? *value : Value();
+  }
+
+ protected:
+  common_internal::LegacyValueManager value_manager_;
+  std::string schema_file_;
+  flatbuffers::Parser parser_;
+  const reflection::Schema* schema_;
+};
+
+TEST_F(FlatBuffersValueTest, PrimitiveFields) {
+  MapValue value = LoadJson(R"({
+              f_byte: -1,
+              f_ubyte: 1,
+              f_ulong: 4,
+              f_double: 6.0,
+              f_bool: false,
+              f_string: "test"
+              })");
+  EXPECT_EQ(Cast<IntValue>(Get(value, "f_byte")).NativeValue(), -1);
+  EXPECT_EQ(Cast<UintValue>(Get(value, "f_ubyte")).NativeValue(), 1);
+  EXPECT_EQ(Cast<UintValue>(Get(value, "f_ulong")).NativeValue(), 4);
+  EXPECT_EQ(Cast<DoubleValue>(Get(value, "f_double")).NativeValue(), 6.0);
+  EXPECT_FALSE(Cast<BoolValue>(Get(value, "f_bool")).NativeValue());
+  EXPECT_EQ(Cast<StringValue>(Get(value, "f_string")).ToString(), "test");
+  // Defaults of the schema.
+  EXPECT_EQ(Cast<IntValue>(Get(value, "f_short")).NativeValue(), 150);
+  EXPECT_TRUE(InstanceOf<NullValue>(Get(value, "f_obj")));
+
+  EXPECT_THAT(value.Has(value_manager_, StringValue("f_int")),
+              IsOkAndHolds(BoolValueIs(true)));
+  EXPECT_THAT(value.Has(value_manager_, StringValue("f_unknown")),
+              IsOkAndHolds(BoolValueIs(false)));
+  EXPECT_FALSE(value.Get(value_manager_, StringValue("f_unknown")).ok());
+}
+
+TEST_F(FlatBuffersValueTest, Keys) {
+  MapValue value = LoadJson("{}");
+  ASSERT_OK_AND_ASSIGN(ListValue keys, value.ListKeys(value_manager_));
+  EXPECT_THAT(keys.Size(), IsOkAndHolds(kNumFields));
+  std::vector<std::string> names;
+  ASSERT_OK(value.ForEach(
+      value_manager_,
+      [&](ValueView key, ValueView) -> absl::StatusOr<bool> {
+        names.push_back(Cast<StringValueView>(key).ToString());
+        return true;
+      }));
+  EXPECT_THAT(names, SizeIs(kNumFields));
+  EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+}
+
+TEST_F(FlatBuffersValueTest, ObjectField) {
+  MapValue value = LoadJson(R"({
+              f_obj: {
+                f_string: "entry",
+                f_int: 16
+              }
+              })");
+  MapValue object = Cast<MapValue>(Get(value, "f_obj"));
+  EXPECT_THAT(object.Size(), IsOkAndHolds(2));
+  EXPECT_EQ(Cast<StringValue>(Get(object, "f_string")).ToString(), "entry");
+  EXPECT_EQ(Cast<IntValue>(Get(object, "f_int")).NativeValue(), 16);
+}
+
+TEST_F(FlatBuffersValueTest, VectorFields) {
+  MapValue value = LoadJson(R"({
+              r_ubyte: [97, 98, 99],
+              r_short: [-2, 3],
+              r_uint: [3],
+              r_float: [5.0],
+              r_bool: [false, true],
+              r_string: ["a", "b"],
+              r_obj: [{f_int: 16}, {f_int: 32}]
+              })");
+  EXPECT_EQ(Cast<BytesValue>(Get(value, "r_ubyte")).ToString(), "abc");
+
+  ListValue shorts = Cast<ListValue>(Get(value, "r_short"));
+  EXPECT_THAT(shorts.Size(), IsOkAndHolds(2));
+  EXPECT_EQ(Cast<IntValue>(Get(shorts, 1)).NativeValue(), 3);
+  EXPECT_EQ(Cast<UintValue>(Get(Cast<ListValue>(Get(value, "r_uint")), 0))
+                .NativeValue(),
+            3);
+  EXPECT_EQ(Cast<DoubleValue>(Get(Cast<ListValue>(Get(value, "r_float")), 0))
+                .NativeValue(),
+            5.0);
+  EXPECT_TRUE(Cast<BoolValue>(Get(Cast<ListValue>(Get(value, "r_bool")), 1))
+                  .NativeValue());
+
+  ListValue strings = Cast<ListValue>(Get(value, "r_string"));
+  EXPECT_EQ(Cast<StringValue>(Get(strings, 1)).ToString(), "b");
+  EXPECT_THAT(strings.Contains(value_manager_, StringValue("a")),
+              IsOkAndHolds(BoolValueIs(true)));
+
+  ListValue objects = Cast<ListValue>(Get(value, "r_obj"));
+  EXPECT_THAT(objects.Size(), IsOkAndHolds(2));
+  EXPECT_EQ(
+      Cast<IntValue>(Get(Cast<MapValue>(Get(objects, 1)), "f_int"))
+          .NativeValue(),
+      32);
+
+  // Absent vectors are empty.
+  EXPECT_THAT(Cast<ListValue>(Get(value, "r_long")).IsEmpty(),
+              IsOkAndHolds(true));
+}
+
+TEST_F(FlatBuffersValueTest, IndexedVectorField) {
+  MapValue value = LoadJson(R"({
+              r_indexed: [
+                {f_string: "a", f_int: 16},
+                {f_string: "b", f_int: 32}
+              ]
+              })");
+  MapValue indexed = Cast<MapValue>(Get(value, "r_indexed"));
+  EXPECT_THAT(indexed.Size(), IsOkAndHolds(2));
+  EXPECT_EQ(Cast<IntValue>(Get(Cast<MapValue>(Get(indexed, "b")), "f_int"))
+                .NativeValue(),
+            32);
+  EXPECT_THAT(indexed.Has(value_manager_, StringValue("c")),
+              IsOkAndHolds(BoolValueIs(false)));
+  ASSERT_OK_AND_ASSIGN(ListValue keys, indexed.ListKeys(value_manager_));
+  EXPECT_EQ(Cast<StringValue>(Get(keys, 0)).ToString(), "a");
+}
+
+}  // namespace
+}  // namespace cel
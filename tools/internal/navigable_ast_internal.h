@@ -46,8 +46,10 @@ class SpanRange {
       return *this;
     }
 
+    // Compares the spans by identity: Span's operator== compares elements.
     bool operator==(const SpanForwardIter& other) const {
-      return i_ == other.i_ && span_ == other.span_;
+      return i_ == other.i_ && span_.data() == other.span_.data() &&
+             span_.size() == other.span_.size();
     }
 
     bool operator!=(const SpanForwardIter& other) const {
@@ -15,15 +15,17 @@
 #include "tools/navigable_ast.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "google/api/expr/v1alpha1/checked.pb.h"
+#include "absl/base/call_once.h"
+#include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
-#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "eval/public/ast_traverse.h"
@@ -35,15 +37,86 @@ namespace cel {
 
 namespace tools_internal {
 
+void AstMetadata::AllocateNodes(size_t count) {
+  nodes.reset(new AstNode[count]);
+  size = count;
+}
+
 AstNodeData& AstMetadata::NodeDataAt(size_t index) {
-  ABSL_CHECK(index < nodes.size());
-  return nodes[index]->data_;
+  ABSL_CHECK(index < size);
+  return nodes[index].data_;
+}
+
+absl::Span<const AstNode* const> AstMetadata::ChildrenOf(
+    const AstNodeData& node) const {
+  absl::call_once(children_once, [this]() {
+    // Every node but the root is the child of exactly one node, so the
+    // children of all nodes fit in one array, grouped by parent.
+    children.resize(size > 0 ? size - 1 : 0);
+    size_t offset = 0;
+    for (size_t i = 0; i < size; ++i) {
+      AstNodeData& data = nodes[i].data_;
+      data.children_offset = offset;
+      offset += data.child_count;
+      if (data.parent != nullptr) {
+        children[data.parent->data_.children_offset + data.child_index] =
+            &nodes[i];
+      }
+    }
+  });
+  return absl::MakeConstSpan(children).subspan(node.children_offset,
+                                               node.child_count);
+}
+
+absl::Span<const AstNode* const> AstMetadata::Postorder() const {
+  absl::call_once(postorder_once, [this]() {
+    postorder.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      postorder[nodes[i].data_.postorder_index] = &nodes[i];
+    }
+  });
+  return absl::MakeConstSpan(postorder);
 }
 
-size_t AstMetadata::AddNode() {
-  size_t index = nodes.size();
-  nodes.push_back(absl::WrapUnique(new AstNode()));
-  return index;
+namespace {
+
+void BuildLookup(const AstMetadata& metadata) {
+  absl::call_once(metadata.lookup_once, [&metadata]() {
+    metadata.id_to_node.reserve(metadata.size);
+    metadata.expr_to_node.reserve(metadata.size);
+    for (size_t i = 0; i < metadata.size; ++i) {
+      const google::api::expr::v1alpha1::Expr* expr =
+          metadata.nodes[i].expr();
+      metadata.id_to_node.insert({expr->id(), i});
+      metadata.expr_to_node.insert({expr, i});
+    }
+  });
+}
+
+}  // namespace
+
+absl::Nullable<const AstNode*> AstMetadata::FindId(int64_t id) const {
+  BuildLookup(*this);
+  auto it = id_to_node.find(id);
+  if (it == id_to_node.end()) {
+    return nullptr;
+  }
+  return &nodes[it->second];
+}
+
+absl::Nullable<const AstNode*> AstMetadata::FindExpr(
+    const google::api::expr::v1alpha1::Expr* expr) const {
+  BuildLookup(*this);
+  auto it = expr_to_node.find(expr);
+  if (it == expr_to_node.end()) {
+    return nullptr;
+  }
+  return &nodes[it->second];
+}
+
+size_t AstMetadata::UniqueIdCount() const {
+  BuildLookup(*this);
+  return id_to_node.size();
 }
 
 }  // namespace tools_internal
@@ -132,17 +205,32 @@ ChildKind GetChildKind(const tools_internal::AstNodeData& parent_node,
   }
 }
 
+// Counts the nodes of an AST, so that they can be allocated at once.
+class NodeCountingVisitor : public google::api::expr::runtime::AstVisitorBase {
+ public:
+  void PreVisitExpr(const Expr* expr, const SourcePosition* position) override {
+    ++count_;
+  }
+
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_ = 0;
+};
+
 class NavigableExprBuilderVisitor
     : public google::api::expr::runtime::AstVisitorBase {
  public:
-  NavigableExprBuilderVisitor()
-      : metadata_(std::make_unique<tools_internal::AstMetadata>()) {}
+  explicit NavigableExprBuilderVisitor(size_t node_count)
+      : metadata_(std::make_unique<tools_internal::AstMetadata>()) {
+    metadata_->AllocateNodes(node_count);
+  }
 
   void PreVisitExpr(const Expr* expr, const SourcePosition* position) override {
     AstNode* parent = parent_stack_.empty()
                           ? nullptr
-                          : metadata_->nodes[parent_stack_.back()].get();
-    size_t index = metadata_->AddNode();
+                          : &metadata_->nodes[parent_stack_.back()];
+    size_t index = next_index_++;
     tools_internal::AstNodeData& node_data = metadata_->NodeDataAt(index);
     node_data.parent = parent;
     node_data.expr = expr;
@@ -150,14 +238,16 @@ class NavigableExprBuilderVisitor
     node_data.node_kind = GetNodeKind(*expr);
     node_data.weight = 1;
     node_data.index = index;
+    node_data.postorder_index = 0;
+    node_data.child_index = -1;
+    node_data.child_count = 0;
+    node_data.children_offset = 0;
     node_data.metadata = metadata_.get();
 
-    metadata_->id_to_node.insert({expr->id(), index});
-    metadata_->expr_to_node.insert({expr, index});
     if (!parent_stack_.empty()) {
       auto& parent_node_data = metadata_->NodeDataAt(parent_stack_.back());
-      size_t child_index = parent_node_data.children.size();
-      parent_node_data.children.push_back(metadata_->nodes[index].get());
+      size_t child_index = parent_node_data.child_count++;
+      node_data.child_index = static_cast<int>(child_index);
       node_data.parent_relation = GetChildKind(parent_node_data, child_index);
     }
     parent_stack_.push_back(index);
@@ -167,8 +257,8 @@ class NavigableExprBuilderVisitor
                      const SourcePosition* position) override {
     size_t idx = parent_stack_.back();
     parent_stack_.pop_back();
-    metadata_->postorder.push_back(metadata_->nodes[idx].get());
     tools_internal::AstNodeData& node = metadata_->NodeDataAt(idx);
+    node.postorder_index = next_postorder_index_++;
     if (!parent_stack_.empty()) {
       tools_internal::AstNodeData& parent_node_data =
           metadata_->NodeDataAt(parent_stack_.back());
@@ -177,12 +267,15 @@ class NavigableExprBuilderVisitor
   }
 
   std::unique_ptr<tools_internal::AstMetadata> Consume() && {
+    ABSL_DCHECK_EQ(next_index_, metadata_->size);
     return std::move(metadata_);
   }
 
  private:
   std::unique_ptr<tools_internal::AstMetadata> metadata_;
   std::vector<size_t> parent_stack_;
+  size_t next_index_ = 0;
+  size_t next_postorder_index_ = 0;
 };
 
 }  // namespace
@@ -245,32 +338,28 @@ std::string NodeKindName(NodeKind kind) {
   }
 }
 
-int AstNode::child_index() const {
-  if (data_.parent == nullptr) {
-    return -1;
-  }
-  int i = 0;
-  for (const AstNode* ptr : data_.parent->children()) {
-    if (ptr->expr() == expr()) {
-      return i;
-    }
-    i++;
-  }
-  return -1;
+int AstNode::child_index() const { return data_.child_index; }
+
+absl::Span<const AstNode* const> AstNode::children() const {
+  return data_.metadata->ChildrenOf(data_);
 }
 
 AstNode::PreorderRange AstNode::DescendantsPreorder() const {
-  return AstNode::PreorderRange(absl::MakeConstSpan(data_.metadata->nodes)
-                                    .subspan(data_.index, data_.weight));
+  return AstNode::PreorderRange(
+      absl::MakeConstSpan(data_.metadata->nodes.get(), data_.metadata->size)
+          .subspan(data_.index, data_.weight));
 }
 
 AstNode::PostorderRange AstNode::DescendantsPostorder() const {
-  return AstNode::PostorderRange(absl::MakeConstSpan(data_.metadata->postorder)
-                                     .subspan(data_.index, data_.weight));
+  // A node is visited after its descendants, so its subtree ends at it.
+  return AstNode::PostorderRange(data_.metadata->Postorder().subspan(
+      data_.postorder_index + 1 - data_.weight, data_.weight));
 }
 
 NavigableAst NavigableAst::Build(const Expr& expr) {
-  NavigableExprBuilderVisitor visitor;
+  NodeCountingVisitor counter;
+  AstTraverse(&expr, /*source_info=*/nullptr, &counter);
+  NavigableExprBuilderVisitor visitor(counter.count());
   AstTraverse(&expr, /*source_info=*/nullptr, &visitor);
   return NavigableAst(std::move(visitor).Consume());
 }
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/base/call_once.h"
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/types/span.h"
@@ -92,19 +93,46 @@ struct AstNodeData {
   ChildKind parent_relation;
   NodeKind node_kind;
   const AstMetadata* metadata;
+  // Positions of the node in the preorder and postorder traversals.
   size_t index;
+  size_t postorder_index;
+  // Number of nodes in the subtree rooted at this node, including itself.
   size_t weight;
-  std::vector<AstNode*> children;
+  // Position in the parent's children, or -1 for the root.
+  int child_index;
+  size_t child_count;
+  // Start of the node's children in AstMetadata::children, assigned when the
+  // children index is built.
+  size_t children_offset;
 };
 
+// Flat layout of the nodes of an AST.
+//
+// Nodes are stored in preorder in a single array, so the descendants of a node
+// are the `weight` nodes starting at its index. The children, postorder and
+// lookup indexes are only built the first time they are used.
 struct AstMetadata {
-  std::vector<std::unique_ptr<AstNode>> nodes;
-  std::vector<const AstNode*> postorder;
-  absl::flat_hash_map<int64_t, size_t> id_to_node;
-  absl::flat_hash_map<const google::api::expr::v1alpha1::Expr*, size_t> expr_to_node;
-
+  std::unique_ptr<AstNode[]> nodes;
+  size_t size = 0;
+
+  mutable absl::once_flag children_once;
+  mutable std::vector<const AstNode*> children;
+  mutable absl::once_flag postorder_once;
+  mutable std::vector<const AstNode*> postorder;
+  mutable absl::once_flag lookup_once;
+  mutable absl::flat_hash_map<int64_t, size_t> id_to_node;
+  mutable absl::flat_hash_map<const google::api::expr::v1alpha1::Expr*, size_t>
+      expr_to_node;
+
+  void AllocateNodes(size_t count);
   AstNodeData& NodeDataAt(size_t index);
-  size_t AddNode();
+
+  absl::Span<const AstNode* const> ChildrenOf(const AstNodeData& node) const;
+  absl::Span<const AstNode* const> Postorder() const;
+  absl::Nullable<const AstNode*> FindId(int64_t id) const;
+  absl::Nullable<const AstNode*> FindExpr(
+      const google::api::expr::v1alpha1::Expr* expr) const;
+  size_t UniqueIdCount() const;
 };
 
 struct PostorderTraits {
@@ -113,10 +141,8 @@ struct PostorderTraits {
 };
 
 struct PreorderTraits {
-  using UnderlyingType = std::unique_ptr<AstNode>;
-  static const AstNode& Adapt(const std::unique_ptr<AstNode>& node) {
-    return *node;
-  }
+  using UnderlyingType = AstNode;
+  static const AstNode& Adapt(const AstNode& node) { return node; }
 };
 
 }  // namespace tools_internal
@@ -146,9 +172,7 @@ class AstNode {
   // The type of this node, analogous to Expr::ExprKindCase.
   NodeKind node_kind() const { return data_.node_kind; }
 
-  absl::Span<const AstNode* const> children() const {
-    return absl::MakeConstSpan(data_.children);
-  }
+  absl::Span<const AstNode* const> children() const;
 
   // Range over the descendants of this node (including self) using preorder
   // semantics. Each node is visited immediately before all of its descendants.
@@ -212,26 +236,20 @@ class NavigableAst {
   //
   // If ids are non-unique, the first pre-order node encountered with id is
   // returned.
+  //
+  // The id and Expr lookup tables are built on the first lookup.
   absl::Nullable<const AstNode*> FindId(int64_t id) const {
-    auto it = metadata_->id_to_node.find(id);
-    if (it == metadata_->id_to_node.end()) {
-      return nullptr;
-    }
-    return metadata_->nodes[it->second].get();
+    return metadata_->FindId(id);
   }
 
   // Return ptr to the AST node representing the given Expr protobuf node.
   absl::Nullable<const AstNode*> FindExpr(
       const google::api::expr::v1alpha1::Expr* expr) const {
-    auto it = metadata_->expr_to_node.find(expr);
-    if (it == metadata_->expr_to_node.end()) {
-      return nullptr;
-    }
-    return metadata_->nodes[it->second].get();
+    return metadata_->FindExpr(expr);
   }
 
   // The root of the AST.
-  const AstNode& Root() const { return *metadata_->nodes[0]; }
+  const AstNode& Root() const { return metadata_->nodes[0]; }
 
   // Check whether the source AST used unique IDs for each node.
   //
@@ -239,7 +257,7 @@ class NavigableAst {
   // guarantee uniqueness for nodes generated by some macros and ASTs modified
   // outside of CEL's parse/type check may not have unique IDs.
   bool IdsAreUnique() const {
-    return metadata_->id_to_node.size() == metadata_->nodes.size();
+    return metadata_->UniqueIdCount() == metadata_->size;
   }
 
   // Equality operators test for identity. They are intended to distinguish
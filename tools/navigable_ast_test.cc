@@ -284,6 +284,41 @@ TEST(NavigableAst, DescendantsPostorder) {
   EXPECT_THAT(constants, ElementsAre(1, 3));
 }
 
+TEST(NavigableAst, DescendantsOfSubtree) {
+  ASSERT_OK_AND_ASSIGN(auto parsed_expr, Parse("1 + (x * 3) + y"));
+
+  NavigableAst ast = NavigableAst::Build(parsed_expr.expr());
+  const AstNode& root = ast.Root();
+
+  // (1 + (x * 3)) + y
+  ASSERT_THAT(root.children(), SizeIs(2));
+  const AstNode* lhs = root.children()[0];
+  ASSERT_THAT(lhs->children(), SizeIs(2));
+  const AstNode* product = lhs->children()[1];
+  EXPECT_EQ(product->child_index(), 1);
+  EXPECT_EQ(product->parent(), lhs);
+
+  std::vector<NodeKind> preorder;
+  for (const AstNode& node : product->DescendantsPreorder()) {
+    preorder.push_back(node.node_kind());
+  }
+  EXPECT_THAT(preorder, ElementsAre(NodeKind::kCall, NodeKind::kIdent,
+                                    NodeKind::kConstant));
+
+  std::vector<NodeKind> postorder;
+  for (const AstNode& node : product->DescendantsPostorder()) {
+    postorder.push_back(node.node_kind());
+  }
+  EXPECT_THAT(postorder, ElementsAre(NodeKind::kIdent, NodeKind::kConstant,
+                                     NodeKind::kCall));
+
+  const AstNode* y = root.children()[1];
+  EXPECT_EQ(y->child_index(), 1);
+  EXPECT_EQ(y->node_kind(), NodeKind::kIdent);
+  EXPECT_THAT(y->children(), IsEmpty());
+  EXPECT_EQ(ast.FindExpr(y->expr()), y);
+}
+
 TEST(NavigableAst, DescendantsPreorder) {
   ASSERT_OK_AND_ASSIGN(auto parsed_expr, Parse("1 + (x * 3)"));
 
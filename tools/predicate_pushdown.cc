@@ -0,0 +1,244 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "tools/predicate_pushdown.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "base/builtins.h"
+#include "common/value.h"
+#include "internal/time.h"
+#include "tools/navigable_ast.h"
+
+namespace cel {
+
+namespace {
+
+using ::google::api::expr::v1alpha1::Constant;
+using ::google::api::expr::v1alpha1::Expr;
+
+using Op = PathPredicate::Op;
+
+absl::optional<Value> Literal(const Expr& expr) {
+  if (expr.expr_kind_case() == Expr::kCallExpr) {
+    // Conversions of constant strings, as written for timestamp literals.
+    const auto& call = expr.call_expr();
+    if (call.has_target() || call.args_size() != 1 ||
+        call.args(0).expr_kind_case() != Expr::kConstExpr ||
+        call.args(0).const_expr().constant_kind_case() !=
+            Constant::kStringValue) {
+      return absl::nullopt;
+    }
+    const std::string& input = call.args(0).const_expr().string_value();
+    if (call.function() == builtin::kTimestamp) {
+      absl::StatusOr<absl::Time> timestamp =
+          internal::ParseTimestamp(input);
+      if (!timestamp.ok()) {
+        return absl::nullopt;
+      }
+      return TimestampValue(*timestamp);
+    }
+    if (call.function() == builtin::kDuration) {
+      absl::StatusOr<absl::Duration> duration = internal::ParseDuration(input);
+      if (!duration.ok()) {
+        return absl::nullopt;
+      }
+      return DurationValue(*duration);
+    }
+    return absl::nullopt;
+  }
+  if (expr.expr_kind_case() != Expr::kConstExpr) {
+    return absl::nullopt;
+  }
+  const Constant& constant = expr.const_expr();
+  switch (constant.constant_kind_case()) {
+    case Constant::kNullValue:
+      return NullValue();
+    case Constant::kBoolValue:
+      return BoolValue(constant.bool_value());
+    case Constant::kInt64Value:
+      return IntValue(constant.int64_value());
+    case Constant::kUint64Value:
+      return UintValue(constant.uint64_value());
+    case Constant::kDoubleValue:
+      return DoubleValue(constant.double_value());
+    case Constant::kStringValue:
+      return StringValue(constant.string_value());
+    case Constant::kBytesValue:
+      return BytesValue(constant.bytes_value());
+    default:
+      return absl::nullopt;
+  }
+}
+
+// Returns the attribute path of a variable followed by field selections.
+absl::optional<std::string> AttributePath(const Expr& expr) {
+  switch (expr.expr_kind_case()) {
+    case Expr::kIdentExpr:
+      return expr.ident_expr().name();
+    case Expr::kSelectExpr: {
+      if (expr.select_expr().test_only()) {
+        return absl::nullopt;
+      }
+      absl::optional<std::string> operand =
+          AttributePath(expr.select_expr().operand());
+      if (!operand.has_value()) {
+        return absl::nullopt;
+      }
+      return absl::StrCat(*operand, ".", expr.select_expr().field());
+    }
+    default:
+      return absl::nullopt;
+  }
+}
+
+// Returns the comparison of `function`, and the one with its operands
+// swapped.
+absl::optional<std::pair<Op, Op>> ComparisonOp(absl::string_view function) {
+  if (function == builtin::kEqual) {
+    return std::make_pair(Op::kEqual, Op::kEqual);
+  }
+  if (function == builtin::kInequal) {
+    return std::make_pair(Op::kNotEqual, Op::kNotEqual);
+  }
+  if (function == builtin::kLess) {
+    return std::make_pair(Op::kLess, Op::kGreater);
+  }
+  if (function == builtin::kLessOrEqual) {
+    return std::make_pair(Op::kLessOrEqual, Op::kGreaterOrEqual);
+  }
+  if (function == builtin::kGreater) {
+    return std::make_pair(Op::kGreater, Op::kLess);
+  }
+  if (function == builtin::kGreaterOrEqual) {
+    return std::make_pair(Op::kGreaterOrEqual, Op::kLessOrEqual);
+  }
+  return absl::nullopt;
+}
+
+// Returns the predicate expressed by `expr`, if any.
+absl::optional<PathPredicate> AsPredicate(const Expr& expr) {
+  if (expr.expr_kind_case() != Expr::kCallExpr ||
+      expr.call_expr().has_target() || expr.call_expr().args_size() != 2) {
+    return absl::nullopt;
+  }
+  const auto& call = expr.call_expr();
+  if (absl::optional<std::pair<Op, Op>> ops = ComparisonOp(call.function());
+      ops.has_value()) {
+    for (int i = 0; i < 2; ++i) {
+      absl::optional<std::string> path = AttributePath(call.args(i));
+      absl::optional<Value> literal = Literal(call.args(1 - i));
+      if (path.has_value() && literal.has_value()) {
+        return PathPredicate{*std::move(path),
+                             i == 0 ? ops->first : ops->second,
+                             {*std::move(literal)},
+                             expr.id()};
+      }
+    }
+    return absl::nullopt;
+  }
+  if (call.function() == builtin::kIn &&
+      call.args(1).expr_kind_case() == Expr::kListExpr &&
+      call.args(1).list_expr().optional_indices_size() == 0) {
+    absl::optional<std::string> path = AttributePath(call.args(0));
+    if (!path.has_value()) {
+      return absl::nullopt;
+    }
+    PathPredicate predicate{*std::move(path), Op::kIn, {}, expr.id()};
+    for (const Expr& element : call.args(1).list_expr().elements()) {
+      absl::optional<Value> literal = Literal(element);
+      if (!literal.has_value()) {
+        return absl::nullopt;
+      }
+      predicate.operands.push_back(*std::move(literal));
+    }
+    if (predicate.operands.size() == 1) {
+      predicate.op = Op::kEqual;
+    }
+    return predicate;
+  }
+  return absl::nullopt;
+}
+
+void CollectConjuncts(const AstNode& node,
+                      std::vector<const AstNode*>& conjuncts) {
+  const Expr& expr = *node.expr();
+  if (expr.expr_kind_case() == Expr::kCallExpr &&
+      expr.call_expr().function() == builtin::kAnd &&
+      !expr.call_expr().has_target()) {
+    for (const AstNode* child : node.children()) {
+      CollectConjuncts(*child, conjuncts);
+    }
+    return;
+  }
+  conjuncts.push_back(&node);
+}
+
+}  // namespace
+
+PredicatePushdown ExtractPathPredicates(const NavigableAst& filter) {
+  PredicatePushdown pushdown;
+  pushdown.residual.mutable_const_expr()->set_bool_value(true);
+  if (!filter) {
+    return pushdown;
+  }
+
+  int64_t next_id = filter.Root().expr()->id() + 1;
+  for (const AstNode& node : filter.Root().DescendantsPreorder()) {
+    next_id = std::max(next_id, node.expr()->id() + 1);
+  }
+
+  std::vector<const AstNode*> conjuncts;
+  CollectConjuncts(filter.Root(), conjuncts);
+  bool has_residual = false;
+  for (const AstNode* conjunct : conjuncts) {
+    if (absl::optional<PathPredicate> predicate =
+            AsPredicate(*conjunct->expr());
+        predicate.has_value()) {
+      pushdown.predicates.push_back(*std::move(predicate));
+      continue;
+    }
+    if (!has_residual) {
+      pushdown.residual = *conjunct->expr();
+      has_residual = true;
+      continue;
+    }
+    Expr conjunction;
+    conjunction.set_id(next_id++);
+    auto* call = conjunction.mutable_call_expr();
+    call->set_function(builtin::kAnd);
+    *call->add_args() = std::move(pushdown.residual);
+    *call->add_args() = *conjunct->expr();
+    pushdown.residual = std::move(conjunction);
+  }
+  if (!has_residual) {
+    pushdown.residual.set_id(next_id);
+  }
+
+  std::stable_sort(pushdown.predicates.begin(), pushdown.predicates.end(),
+                   [](const PathPredicate& lhs, const PathPredicate& rhs) {
+                     return lhs.path < rhs.path;
+                   });
+  return pushdown;
+}
+
+}  // namespace cel
@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef THIRD_PARTY_CEL_CPP_TOOLS_PREDICATE_PUSHDOWN_H_
+#define THIRD_PARTY_CEL_CPP_TOOLS_PREDICATE_PUSHDOWN_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "common/value.h"
+#include "tools/navigable_ast.h"
+
+namespace cel {
+
+// A comparison of an attribute path to literals, which a storage index can
+// evaluate without the CEL runtime.
+struct PathPredicate {
+  enum class Op {
+    kEqual,
+    kNotEqual,
+    kLess,
+    kLessOrEqual,
+    kGreater,
+    kGreaterOrEqual,
+    // The attribute is equal to one of the operands.
+    kIn,
+  };
+
+  // A variable followed by field selections, e.g. `request.size`.
+  std::string path;
+  Op op;
+  // The literal the attribute is compared to, or the elements of the list
+  // for kIn. Literals are null, bool, int, uint, double, string or bytes
+  // constants, or `timestamp()` and `duration()` calls on a string constant.
+  std::vector<Value> operands;
+  // Id of the conjunct the predicate was extracted from.
+  int64_t expr_id;
+};
+
+// A filter split into predicates for a storage index and the residual to
+// evaluate for the rows satisfying them.
+struct PredicatePushdown {
+  // Top-level conjuncts of the filter comparing an attribute path to
+  // literals, normalized with the path on the left (`1 < x.a` becomes
+  // `x.a > 1`, `x.a in [1]` becomes `x.a == 1`) and ordered by path.
+  std::vector<PathPredicate> predicates;
+  // The conjunction of the other top-level conjuncts, in order, keeping the
+  // ids of the filter's subexpressions. The constant `true` if every conjunct
+  // is a predicate.
+  google::api::expr::v1alpha1::Expr residual;
+};
+
+// Splits `filter` into predicates on attribute paths and a residual.
+//
+// A row for which the filter evaluates to true satisfies every predicate and
+// the residual evaluates to true for it. Conversely, if a row satisfies every
+// predicate, the filter evaluates to the result of the residual. So only the
+// rows which the index finds for the predicates need to be evaluated, with
+// the residual instead of the whole filter.
+//
+// This holds provided that the index compares attributes to the operands as
+// CEL does (e.g. numbers of different types compare by value) and that rows
+// whose attribute is missing don't satisfy any predicate on it.
+PredicatePushdown ExtractPathPredicates(const NavigableAst& filter);
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_TOOLS_PREDICATE_PUSHDOWN_H_
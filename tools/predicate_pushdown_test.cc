@@ -0,0 +1,135 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "tools/predicate_pushdown.h"
+
+#include <string>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/value.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "tools/navigable_ast.h"
+
+namespace cel {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::Expr;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+using Op = PathPredicate::Op;
+
+std::vector<std::string> OperandStrings(const PathPredicate& predicate) {
+  std::vector<std::string> strings;
+  for (const Value& operand : predicate.operands) {
+    strings.push_back(operand.DebugString());
+  }
+  return strings;
+}
+
+class PredicatePushdownTest : public testing::Test {
+ protected:
+  PredicatePushdown Extract(absl::string_view filter) {
+    auto parsed = Parse(filter);
+    ABSL_CHECK_OK(parsed.status());
+    parsed_ = *std::move(parsed);
+    return ExtractPathPredicates(NavigableAst::Build(parsed_.expr()));
+  }
+
+  ParsedExpr parsed_;
+};
+
+TEST_F(PredicatePushdownTest, SplitsConjuncts) {
+  PredicatePushdown pushdown = Extract(
+      "x.a == 1 && x.name.startsWith('a') && 10 > x.b && x.b != 3 && "
+      "(x.c || x.d)");
+
+  ASSERT_THAT(pushdown.predicates, testing::SizeIs(3));
+  EXPECT_EQ(pushdown.predicates[0].path, "x.a");
+  EXPECT_EQ(pushdown.predicates[0].op, Op::kEqual);
+  EXPECT_THAT(OperandStrings(pushdown.predicates[0]), ElementsAre("1"));
+  // Operands of the comparison are swapped, keeping the order of conjuncts on
+  // the same path.
+  EXPECT_EQ(pushdown.predicates[1].path, "x.b");
+  EXPECT_EQ(pushdown.predicates[1].op, Op::kLess);
+  EXPECT_THAT(OperandStrings(pushdown.predicates[1]), ElementsAre("10"));
+  EXPECT_EQ(pushdown.predicates[2].path, "x.b");
+  EXPECT_EQ(pushdown.predicates[2].op, Op::kNotEqual);
+
+  // The residual is the conjunction of the other conjuncts, with a new id
+  // for the added call.
+  const Expr& residual = pushdown.residual;
+  ASSERT_EQ(residual.call_expr().function(), "_&&_");
+  EXPECT_EQ(residual.call_expr().args(0).call_expr().function(),
+            "startsWith");
+  EXPECT_EQ(residual.call_expr().args(1).call_expr().function(), "_||_");
+  NavigableAst filter = NavigableAst::Build(parsed_.expr());
+  EXPECT_EQ(filter.FindId(residual.id()), nullptr);
+  EXPECT_NE(filter.FindId(residual.call_expr().args(0).id()), nullptr);
+}
+
+TEST_F(PredicatePushdownTest, Literals) {
+  PredicatePushdown pushdown = Extract(
+      "x.ts > timestamp('2024-01-01T00:00:00Z') && "
+      "x.tag in ['a', 'b'] && x.ttl <= duration('1h') && x.id in [7u] && "
+      "x.ratio >= 0.5 && x.parent == null");
+
+  ASSERT_THAT(pushdown.predicates, testing::SizeIs(6));
+  EXPECT_EQ(pushdown.predicates[0].path, "x.id");
+  EXPECT_EQ(pushdown.predicates[0].op, Op::kEqual);
+  EXPECT_THAT(OperandStrings(pushdown.predicates[0]), ElementsAre("7u"));
+  EXPECT_EQ(pushdown.predicates[1].path, "x.parent");
+  EXPECT_EQ(pushdown.predicates[1].operands[0]->kind(), ValueKind::kNull);
+  EXPECT_EQ(pushdown.predicates[2].path, "x.ratio");
+  EXPECT_EQ(pushdown.predicates[2].op, Op::kGreaterOrEqual);
+  EXPECT_EQ(pushdown.predicates[3].path, "x.tag");
+  EXPECT_EQ(pushdown.predicates[3].op, Op::kIn);
+  EXPECT_THAT(OperandStrings(pushdown.predicates[3]),
+              ElementsAre("\"a\"", "\"b\""));
+  EXPECT_EQ(pushdown.predicates[4].path, "x.ts");
+  EXPECT_EQ(pushdown.predicates[4].operands[0].As<TimestampValue>()
+                .NativeValue(),
+            absl::FromUnixSeconds(1704067200));
+  EXPECT_EQ(pushdown.predicates[5].path, "x.ttl");
+  EXPECT_EQ(
+      pushdown.predicates[5].operands[0].As<DurationValue>().NativeValue(),
+      absl::Hours(1));
+
+  EXPECT_TRUE(pushdown.residual.const_expr().bool_value());
+}
+
+TEST_F(PredicatePushdownTest, KeepsNonLiteralComparisons) {
+  PredicatePushdown pushdown = Extract(
+      "x.a == y.b || x.c == 1 && x.d in [1, y.e] && "
+      "x.ts > timestamp('invalid') && has(x.f)");
+
+  EXPECT_THAT(pushdown.predicates, IsEmpty());
+  EXPECT_EQ(pushdown.residual.call_expr().function(), "_||_");
+}
+
+TEST_F(PredicatePushdownTest, SingleResidualConjunct) {
+  PredicatePushdown pushdown = Extract("x.a == 1 && x.b.exists(v, v > 1)");
+
+  ASSERT_THAT(pushdown.predicates, testing::SizeIs(1));
+  EXPECT_EQ(pushdown.residual.id(), parsed_.expr().call_expr().args(1).id());
+}
+
+}  // namespace
+}  // namespace cel
@@ -0,0 +1,297 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/rule_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "base/builtins.h"
+#include "common/value.h"
+#include "tools/navigable_ast.h"
+
+namespace cel {
+
+namespace {
+
+using ::google::api::expr::v1alpha1::Constant;
+using ::google::api::expr::v1alpha1::Expr;
+
+// Keys of values which compare equal under heterogeneous equality are equal,
+// so numbers are keyed by value regardless of their type.
+std::string IntKey(int64_t value) { return absl::StrCat("n", value); }
+
+std::string UintKey(uint64_t value) { return absl::StrCat("n", value); }
+
+absl::optional<std::string> DoubleKey(double value) {
+  if (std::isnan(value)) {
+    return absl::nullopt;
+  }
+  if (std::trunc(value) == value) {
+    if (value >= -0x1p63 && value < 0x1p63) {
+      return IntKey(static_cast<int64_t>(value));
+    }
+    if (value >= 0 && value < 0x1p64) {
+      return UintKey(static_cast<uint64_t>(value));
+    }
+  }
+  return absl::StrFormat("d%a", value);
+}
+
+absl::optional<std::string> LiteralKey(const Expr& expr) {
+  if (expr.expr_kind_case() != Expr::kConstExpr) {
+    return absl::nullopt;
+  }
+  const Constant& constant = expr.const_expr();
+  switch (constant.constant_kind_case()) {
+    case Constant::kNullValue:
+      return "z";
+    case Constant::kBoolValue:
+      return constant.bool_value() ? "b1" : "b0";
+    case Constant::kInt64Value:
+      return IntKey(constant.int64_value());
+    case Constant::kUint64Value:
+      return UintKey(constant.uint64_value());
+    case Constant::kDoubleValue:
+      return DoubleKey(constant.double_value());
+    case Constant::kStringValue:
+      return absl::StrCat("s", constant.string_value());
+    case Constant::kBytesValue:
+      return absl::StrCat("y", constant.bytes_value());
+    default:
+      return absl::nullopt;
+  }
+}
+
+absl::optional<std::string> ValueKey(const Value& value) {
+  std::string scratch;
+  switch (value->kind()) {
+    case ValueKind::kNull:
+      return "z";
+    case ValueKind::kBool:
+      return value.As<BoolValue>().NativeValue() ? "b1" : "b0";
+    case ValueKind::kInt:
+      return IntKey(value.As<IntValue>().NativeValue());
+    case ValueKind::kUint:
+      return UintKey(value.As<UintValue>().NativeValue());
+    case ValueKind::kDouble:
+      return DoubleKey(value.As<DoubleValue>().NativeValue());
+    case ValueKind::kString:
+      return absl::StrCat("s", value.As<StringValue>().NativeString(scratch));
+    case ValueKind::kBytes:
+      return absl::StrCat("y", value.As<BytesValue>().NativeString(scratch));
+    default:
+      return absl::nullopt;
+  }
+}
+
+// Returns the attribute path of a variable followed by field selections.
+absl::optional<std::string> AttributePath(const Expr& expr) {
+  switch (expr.expr_kind_case()) {
+    case Expr::kIdentExpr:
+      return expr.ident_expr().name();
+    case Expr::kSelectExpr: {
+      if (expr.select_expr().test_only()) {
+        return absl::nullopt;
+      }
+      absl::optional<std::string> operand =
+          AttributePath(expr.select_expr().operand());
+      if (!operand.has_value()) {
+        return absl::nullopt;
+      }
+      return absl::StrCat(*operand, ".", expr.select_expr().field());
+    }
+    default:
+      return absl::nullopt;
+  }
+}
+
+struct Discriminator {
+  std::string path;
+  absl::flat_hash_set<std::string> keys;
+};
+
+// Returns the discriminator expressed by `expr`, if any.
+absl::optional<Discriminator> AsDiscriminator(const Expr& expr) {
+  if (expr.expr_kind_case() != Expr::kCallExpr ||
+      expr.call_expr().has_target() || expr.call_expr().args_size() != 2) {
+    return absl::nullopt;
+  }
+  const auto& call = expr.call_expr();
+  if (call.function() == builtin::kEqual) {
+    for (int i = 0; i < 2; ++i) {
+      absl::optional<std::string> path = AttributePath(call.args(i));
+      absl::optional<std::string> key = LiteralKey(call.args(1 - i));
+      if (path.has_value() && key.has_value()) {
+        return Discriminator{*std::move(path), {*std::move(key)}};
+      }
+    }
+    return absl::nullopt;
+  }
+  if (call.function() == builtin::kIn &&
+      call.args(1).expr_kind_case() == Expr::kListExpr) {
+    absl::optional<std::string> path = AttributePath(call.args(0));
+    if (!path.has_value()) {
+      return absl::nullopt;
+    }
+    Discriminator discriminator{*std::move(path), {}};
+    for (const Expr& element : call.args(1).list_expr().elements()) {
+      absl::optional<std::string> key = LiteralKey(element);
+      if (!key.has_value()) {
+        return absl::nullopt;
+      }
+      discriminator.keys.insert(*std::move(key));
+    }
+    if (call.args(1).list_expr().optional_indices_size() > 0) {
+      return absl::nullopt;
+    }
+    return discriminator;
+  }
+  return absl::nullopt;
+}
+
+void CollectConjuncts(const AstNode& node,
+                      std::vector<const AstNode*>& conjuncts) {
+  const Expr& expr = *node.expr();
+  if (expr.expr_kind_case() == Expr::kCallExpr &&
+      expr.call_expr().function() == builtin::kAnd &&
+      !expr.call_expr().has_target()) {
+    for (const AstNode* child : node.children()) {
+      CollectConjuncts(*child, conjuncts);
+    }
+    return;
+  }
+  conjuncts.push_back(&node);
+}
+
+}  // namespace
+
+RuleIndex RuleIndex::Build(absl::Span<const NavigableAst> rules) {
+  RuleIndex index;
+  absl::flat_hash_map<std::string, size_t> path_ids;
+  std::vector<size_t> path_rule_counts;
+  index.rules_.resize(rules.size());
+  for (size_t rule = 0; rule < rules.size(); ++rule) {
+    if (!rules[rule]) {
+      continue;
+    }
+    std::vector<const AstNode*> conjuncts;
+    CollectConjuncts(rules[rule].Root(), conjuncts);
+    std::vector<Constraint>& constraints = index.rules_[rule];
+    for (const AstNode* conjunct : conjuncts) {
+      absl::optional<Discriminator> discriminator =
+          AsDiscriminator(*conjunct->expr());
+      if (!discriminator.has_value()) {
+        continue;
+      }
+      auto [it, inserted] =
+          path_ids.try_emplace(discriminator->path, index.paths_.size());
+      if (inserted) {
+        index.paths_.push_back(discriminator->path);
+        path_rule_counts.push_back(0);
+      }
+      size_t path = it->second;
+      auto constraint = std::find_if(
+          constraints.begin(), constraints.end(),
+          [path](const Constraint& c) { return c.path == path; });
+      if (constraint == constraints.end()) {
+        constraints.push_back({path, std::move(discriminator->keys)});
+        ++path_rule_counts[path];
+        continue;
+      }
+      // Conjuncts on the same path: the value must satisfy all of them.
+      absl::erase_if(constraint->keys, [&](const std::string& key) {
+        return !discriminator->keys.contains(key);
+      });
+    }
+  }
+
+  index.path_indexes_.resize(index.paths_.size());
+  for (size_t rule = 0; rule < index.rules_.size(); ++rule) {
+    std::vector<Constraint>& constraints = index.rules_[rule];
+    if (constraints.empty()) {
+      index.unindexed_rules_.push_back(rule);
+      continue;
+    }
+    // Index by the most frequently used path, so that the fewest paths are
+    // indexed.
+    auto primary = std::min_element(
+        constraints.begin(), constraints.end(),
+        [&](const Constraint& lhs, const Constraint& rhs) {
+          if (path_rule_counts[lhs.path] != path_rule_counts[rhs.path]) {
+            return path_rule_counts[lhs.path] > path_rule_counts[rhs.path];
+          }
+          return lhs.path < rhs.path;
+        });
+    std::iter_swap(constraints.begin(), primary);
+    PathIndex& path_index = index.path_indexes_[constraints.front().path];
+    path_index.rules.push_back(rule);
+    for (const std::string& key : constraints.front().keys) {
+      path_index.rules_by_key[key].push_back(rule);
+    }
+  }
+  return index;
+}
+
+std::vector<size_t> RuleIndex::FindCandidates(PathLookup lookup) const {
+  std::vector<absl::optional<std::string>> keys(paths_.size());
+  for (size_t path = 0; path < paths_.size(); ++path) {
+    if (absl::optional<Value> value = lookup(paths_[path]); value.has_value()) {
+      keys[path] = ValueKey(*value);
+    }
+  }
+
+  std::vector<size_t> candidates = unindexed_rules_;
+  for (size_t path = 0; path < path_indexes_.size(); ++path) {
+    const PathIndex& path_index = path_indexes_[path];
+    if (!keys[path].has_value()) {
+      candidates.insert(candidates.end(), path_index.rules.begin(),
+                        path_index.rules.end());
+      continue;
+    }
+    auto it = path_index.rules_by_key.find(*keys[path]);
+    if (it == path_index.rules_by_key.end()) {
+      continue;
+    }
+    for (size_t rule : it->second) {
+      // The other discriminators of the rule must match too.
+      bool matches = std::all_of(
+          rules_[rule].begin() + 1, rules_[rule].end(),
+          [&](const Constraint& constraint) {
+            return !keys[constraint.path].has_value() ||
+                   constraint.keys.contains(*keys[constraint.path]);
+          });
+      if (matches) {
+        candidates.push_back(rule);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  return candidates;
+}
+
+}  // namespace cel
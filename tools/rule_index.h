@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CEL_CPP_TOOLS_RULE_INDEX_H_
+#define THIRD_PARTY_CEL_CPP_TOOLS_RULE_INDEX_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "common/value.h"
+#include "tools/navigable_ast.h"
+
+namespace cel {
+
+// Index of a set of rules by their discriminators, used to select the rules
+// worth evaluating for a request.
+//
+// A discriminator is a top-level conjunct of a rule comparing an attribute
+// path to literals, either `path == literal` (in either order) or
+// `path in [literal, ...]`, where the path is a variable followed by field
+// selections (e.g. `request.service`) and the literals are null, bool, int,
+// uint, double, string or bytes constants.
+//
+// Each rule with discriminators is indexed in a hash table by the values of
+// its most frequently used discriminator path, so finding the candidates for
+// a request costs one lookup per discriminator path plus the number of
+// candidates, rather than the number of rules.
+//
+// The rules which are not candidates are guaranteed to evaluate to false, as
+// one of their conjuncts does, provided that heterogeneous equality is
+// enabled and that the values looked up for the paths are the ones the rules
+// would see.
+class RuleIndex {
+ public:
+  // Returns the value of the attribute at `path`, or `absl::nullopt` if it is
+  // not known (e.g. unset or unknown). Discriminators on unknown paths don't
+  // exclude any rule.
+  using PathLookup =
+      absl::FunctionRef<absl::optional<Value>(absl::string_view path)>;
+
+  static RuleIndex Build(absl::Span<const NavigableAst> rules);
+
+  RuleIndex() = default;
+
+  RuleIndex(RuleIndex&&) = default;
+  RuleIndex& operator=(RuleIndex&&) = default;
+
+  // Returns the indices of the rules which may evaluate to true, in order.
+  std::vector<size_t> FindCandidates(PathLookup lookup) const;
+
+  // Attribute paths used by discriminators, each looked up once by
+  // FindCandidates.
+  absl::Span<const std::string> discriminator_paths() const { return paths_; }
+
+  size_t rule_count() const { return rules_.size(); }
+
+ private:
+  // The values a path must have for a rule to match.
+  struct Constraint {
+    size_t path;
+    absl::flat_hash_set<std::string> keys;
+  };
+
+  // The rules indexed by the values of a path.
+  struct PathIndex {
+    absl::flat_hash_map<std::string, std::vector<size_t>> rules_by_key;
+    std::vector<size_t> rules;
+  };
+
+  std::vector<std::string> paths_;
+  // Constraints of each rule, the one on its indexed path first.
+  std::vector<std::vector<Constraint>> rules_;
+  // Indexed by path, empty for paths no rule is indexed by.
+  std::vector<PathIndex> path_indexes_;
+  // Rules without discriminators, which are always candidates.
+  std::vector<size_t> unindexed_rules_;
+};
+
+}  // namespace cel
+
+#endif  // THIRD_PARTY_CEL_CPP_TOOLS_RULE_INDEX_H_
@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/rule_index.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/api/expr/v1alpha1/syntax.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/value.h"
+#include "internal/testing.h"
+#include "parser/parser.h"
+#include "tools/navigable_ast.h"
+
+namespace cel {
+namespace {
+
+using ::google::api::expr::parser::Parse;
+using ::google::api::expr::v1alpha1::ParsedExpr;
+using testing::ElementsAre;
+using testing::UnorderedElementsAre;
+
+class RuleIndexTest : public testing::Test {
+ protected:
+  RuleIndex BuildIndex(const std::vector<std::string>& rules) {
+    parsed_.resize(rules.size());
+    std::vector<NavigableAst> asts;
+    for (size_t i = 0; i < rules.size(); ++i) {
+      auto parsed = Parse(rules[i]);
+      ABSL_CHECK_OK(parsed.status());
+      parsed_[i] = *std::move(parsed);
+      asts.push_back(NavigableAst::Build(parsed_[i].expr()));
+    }
+    return RuleIndex::Build(asts);
+  }
+
+  std::vector<size_t> FindCandidates(
+      const RuleIndex& index,
+      const absl::flat_hash_map<std::string, Value>& attributes) {
+    return index.FindCandidates(
+        [&](absl::string_view path) -> absl::optional<Value> {
+          if (auto it = attributes.find(path); it != attributes.end()) {
+            return it->second;
+          }
+          return absl::nullopt;
+        });
+  }
+
+ private:
+  std::vector<ParsedExpr> parsed_;
+};
+
+TEST_F(RuleIndexTest, SelectsRulesByEquality) {
+  RuleIndex index = BuildIndex({
+      "request.service == 'a' && request.size > 10",
+      "'b' == request.service",
+      "request.service == 'a'",
+      "request.size > 10",
+  });
+
+  EXPECT_THAT(index.discriminator_paths(), ElementsAre("request.service"));
+  EXPECT_EQ(index.rule_count(), 4);
+  EXPECT_THAT(FindCandidates(index, {{"request.service", StringValue("a")}}),
+              ElementsAre(0, 2, 3));
+  EXPECT_THAT(FindCandidates(index, {{"request.service", StringValue("b")}}),
+              ElementsAre(1, 3));
+  EXPECT_THAT(FindCandidates(index, {{"request.service", StringValue("c")}}),
+              ElementsAre(3));
+}
+
+TEST_F(RuleIndexTest, SelectsRulesByMembership) {
+  RuleIndex index = BuildIndex({
+      "request.method in ['GET', 'HEAD']",
+      "request.method in ['POST'] && request.method == 'POST'",
+      "request.method in ['PUT'] && request.method == 'GET'",
+  });
+
+  EXPECT_THAT(FindCandidates(index, {{"request.method", StringValue("HEAD")}}),
+              ElementsAre(0));
+  EXPECT_THAT(FindCandidates(index, {{"request.method", StringValue("POST")}}),
+              ElementsAre(1));
+  // The conjuncts of the last rule can't both hold.
+  EXPECT_THAT(FindCandidates(index, {{"request.method", StringValue("PUT")}}),
+              ElementsAre());
+  EXPECT_THAT(FindCandidates(index, {{"request.method", StringValue("GET")}}),
+              ElementsAre(0));
+}
+
+TEST_F(RuleIndexTest, UnknownPathsDontExcludeRules) {
+  RuleIndex index = BuildIndex({
+      "a == 1 && b == 'x'",
+      "a == 2",
+      "b == 'y'",
+  });
+
+  EXPECT_THAT(index.discriminator_paths(), UnorderedElementsAre("a", "b"));
+  EXPECT_THAT(FindCandidates(index, {}), ElementsAre(0, 1, 2));
+  EXPECT_THAT(FindCandidates(index, {{"a", IntValue(1)}}), ElementsAre(0, 2));
+  EXPECT_THAT(
+      FindCandidates(index, {{"a", IntValue(1)}, {"b", StringValue("y")}}),
+      ElementsAre(2));
+}
+
+TEST_F(RuleIndexTest, NumbersCompareAcrossTypes) {
+  RuleIndex index = BuildIndex({
+      "x == 1",
+      "x == 1u",
+      "x == 1.5",
+      "x == 2.0",
+  });
+
+  EXPECT_THAT(FindCandidates(index, {{"x", DoubleValue(1.0)}}),
+              ElementsAre(0, 1));
+  EXPECT_THAT(FindCandidates(index, {{"x", UintValue(2)}}), ElementsAre(3));
+  EXPECT_THAT(FindCandidates(index, {{"x", DoubleValue(1.5)}}),
+              ElementsAre(2));
+}
+
+TEST_F(RuleIndexTest, IgnoresNonDiscriminatingConjuncts) {
+  RuleIndex index = BuildIndex({
+      "x == 1 || y == 2",
+      "!(x == 1)",
+      "x == y",
+      "f(x) == 1",
+      "has(x.y) == true",
+      "x in [1, y]",
+  });
+
+  EXPECT_THAT(index.discriminator_paths(), ElementsAre());
+  EXPECT_THAT(FindCandidates(index, {{"x", IntValue(3)}}),
+              ElementsAre(0, 1, 2, 3, 4, 5));
+}
+
+}  // namespace
+}  // namespace cel